@@ -74,9 +74,12 @@ ONNX_MLIR_EXPORT int64_t omCompileFromFile(const char *inputFilename,
     const char *flags, const char **outputFilename, const char **errorMessage);
 
 /*!
- *  Compile an onnx model from an ONNX protobuf array. This method is not thread
- *  safe, and borrows the current compiler options currently defined in this
- *  process. When generating libraries or jar files, the compiler will link in
+ *  Compile an onnx model from an ONNX protobuf array. This method borrows the
+ *  compiler options currently defined in this process. Concurrent calls are
+ *  serialized on the process-wide option state, so they are safe but run one
+ *  at a time; use omCompileFromFile, which runs a separate compiler process
+ *  per call, to compile several models in parallel threads.
+ *  When generating libraries or jar files, the compiler will link in
  *  lightweight runtimes / jar files. If these libraries / jar files are not in
  *  the system wide directory (typically /usr/local/lib), the user can override
  *  the default location using the ONNX_MLIR_LIBRARY_PATH environment variable.
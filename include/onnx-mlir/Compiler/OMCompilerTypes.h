@@ -19,6 +19,7 @@ typedef enum {
   EmitObj,
   EmitLib,
   EmitJNI,
+  EmitStaticLib,
 } EmissionTargetType;
 
 /* Input IR can be at one of these levels */
@@ -52,8 +52,9 @@ OM_EXTERNAL_VISIBILITY void OMInstrumentInit();
 /**
  * Create an instrument point.
  * Measurement of runtime behavior will be measured and output
- * In current implementation, the elapsed time from previous instrument point,
- * and virtual memory size will be reported.
+ * In current implementation, the elapsed time from the previous instrument
+ * point on the calling thread, and virtual memory size will be reported,
+ * tagged with a dense per-thread id.
  *
  * @param id for this point. op name is used now.
  * @param tag can used to give extra control of output. Used for begin/end mark
@@ -65,6 +66,34 @@ OM_EXTERNAL_VISIBILITY void OMInstrumentInit();
 OM_EXTERNAL_VISIBILITY void OMInstrumentPoint(
     const char *opName, int64_t tag, const char *nodeName);
 
+/**
+ * Report an allocation or deallocation event.
+ * The event is attributed to the op delimited by the surrounding instrument
+ * points; the per-op allocation totals and the peak of live allocated bytes
+ * are reported at exit.
+ *
+ * @param delta size of the event in bytes, positive for an allocation and
+ * negative for a deallocation.
+ * @return void
+ *
+ */
+OM_EXTERNAL_VISIBILITY void OMInstrumentMemoryPoint(int64_t delta);
+
+/**
+ * Report an allocation or deallocation event to the scratch-memory budget
+ * checker. Aborts the process with a diagnostic on stderr as soon as the
+ * total of live scratch bytes exceeds the limit, instead of letting the
+ * process run into the operating system's out-of-memory killer. Active
+ * regardless of the instrumentation report settings.
+ *
+ * @param delta size of the event in bytes, positive for an allocation and
+ * negative for a deallocation.
+ * @param limit maximum number of live scratch bytes allowed.
+ * @return void
+ *
+ */
+OM_EXTERNAL_VISIBILITY void OMScratchMemoryCheck(int64_t delta, int64_t limit);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,126 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===-------------- OMRunStats.h - OM Run Stats Declaration ---------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file contains declaration of the run statistics API.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef ONNX_MLIR_OMRUNSTATS_H
+#define ONNX_MLIR_OMRUNSTATS_H
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
+#include <onnx-mlir/Compiler/OMCompilerMacros.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Counters describing the runtime behavior of a loaded model, for
+ * programmatic observability without parsing instrumentation output. All
+ * counters are cumulative since process start unless noted otherwise.
+ *
+ * The first group is maintained by the execution session wrapping the model
+ * library and is only filled by ExecutionSession::getRunStats; omGetRunStats
+ * leaves it zero. The second group is maintained by the runtime linked into
+ * the model library.
+ */
+typedef struct OMRunStats {
+  /* Completed entry point invocations on the session. */
+  int64_t numRuns;
+  /* Wall-clock time of the most recent invocation, in nanoseconds. */
+  int64_t lastRunTimeNs;
+  /* Wall-clock time summed over all invocations, in nanoseconds. */
+  int64_t totalRunTimeNs;
+  /* runDispatch() calls served by a shape-specialized entry point. */
+  int64_t shapeDispatchHits;
+  /* Allocations served through the small-tensor allocator. */
+  int64_t allocCalls;
+  /* Bytes requested through the small-tensor allocator. */
+  int64_t allocBytes;
+  /* Virtual memory held by the allocator's slabs and arena chunks. The
+   * pools never give addresses back, so this is also their high-water mark;
+   * trimming (see omMemoryTrim) releases physical pages underneath it
+   * without changing this number. */
+  int64_t poolReservedBytes;
+  /* Deepest arena usage seen on any thread, in bytes. */
+  int64_t arenaHighWaterBytes;
+  /* Bytes whose physical pages were released by arena trimming, cumulative
+   * over all threads and trims. */
+  int64_t poolTrimmedBytes;
+} OMRunStats;
+
+/**
+ * \brief Fill 'stats' with the runtime-maintained counters.
+ *
+ * The counters are maintained with relaxed atomic updates whose cost is
+ * negligible next to the events they count, and reading them does not
+ * disturb concurrent inferences. The session-maintained fields are zeroed;
+ * use ExecutionSession::getRunStats (or run_stats in PyRuntime) for the
+ * complete picture.
+ *
+ * @param stats struct to fill.
+ */
+OM_EXTERNAL_VISIBILITY void omGetRunStats(OMRunStats *stats);
+
+/**
+ * \brief Write the per-allocation-site heap profile to 'fileName'.
+ *
+ * While heap profiling is on (OM_HEAP_PROFILE=1 or the heap_profile runtime
+ * option), the small-tensor allocator attributes its traffic to the
+ * compile-time allocation sites baked into the generated code (the
+ * krnl.small_alloc_site attributes in the preserved IR). The dump writes one
+ * line per active site: its ID, cumulative allocation calls and bytes, and
+ * the live blocks and bytes currently held from slab storage, which is what
+ * distinguishes steady scratch traffic from a site whose buffers never come
+ * back. Pass NULL to write to stderr. Returns 0 on success, -1 when the
+ * file cannot be opened.
+ *
+ * @param fileName path of the file to (over)write, or NULL for stderr.
+ * @return 0 on success, -1 on failure.
+ */
+OM_EXTERNAL_VISIBILITY int64_t omHeapProfileDump(const char *fileName);
+
+/**
+ * \brief Clear the per-allocation-site heap profile counters.
+ *
+ * Starts a fresh measurement window, e.g. after warmup or after enabling
+ * profiling on a long-running service.
+ */
+OM_EXTERNAL_VISIBILITY void omHeapProfileReset(void);
+
+/**
+ * \brief Release the dead pages of the calling thread's small-tensor arena
+ * back to the OS.
+ *
+ * The arena never returns memory on its own, so after a deep burst the
+ * process RSS stays at the burst's high-water mark. omMemoryTrim releases
+ * the physical pages above the thread's current arena position with
+ * madvise(MADV_FREE); the arena's virtual ranges stay in place and later
+ * allocations reuse them transparently. The call is per thread and safe at
+ * any time, including between arenaSnapshot and arenaRestore. Services that
+ * prefer a policy over explicit calls set the memory_trim_period or
+ * memory_trim_idle_ms runtime options (see OMRuntimeOption.h).
+ *
+ * @return bytes whose pages were released; 0 on platforms without a
+ *         page-release primitive.
+ */
+OM_EXTERNAL_VISIBILITY int64_t omMemoryTrim(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ONNX_MLIR_OMRUNSTATS_H */
@@ -0,0 +1,107 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===--------- OMRuntimeOption.h - OM Runtime Option Declaration ----------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file contains declaration of the programmatic runtime configuration
+// API.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef ONNX_MLIR_OMRUNTIMEOPTION_H
+#define ONNX_MLIR_OMRUNTIMEOPTION_H
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
+#include <onnx-mlir/Compiler/OMCompilerMacros.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Override a runtime knob of the loaded model without restarting the
+ * process.
+ *
+ * The runtime knobs are otherwise environment variables read with getenv;
+ * each key below overrides one of them, taking precedence over the
+ * environment from the moment it is set. The runtime is linked into every
+ * compiled model library, so the override applies to the model (and the
+ * execution session) it was set through; use
+ * ExecutionSession::setRuntimeOption to address a specific session.
+ *
+ * Supported keys:
+ *  - "parallel_task_threads": task pool size (OM_PARALLEL_TASK_THREADS).
+ *    Read when the pool starts on the first parallel region; set before the
+ *    first inference.
+ *  - "parallel_pin_threads": pin pool workers to cores, "1" or "0"
+ *    (OM_PARALLEL_PIN_THREADS). Read at pool start as well.
+ *  - "parallel_schedule": "static", "dynamic" or "guided"
+ *    (OM_PARALLEL_SCHEDULE). Applies to the next parallel loop.
+ *  - "constant_path": directory of external constant files
+ *    (OM_CONSTANT_PATH). Read when a constant file is first mapped.
+ *  - "constant_numa_policy": "interleave" to spread constant pages over the
+ *    NUMA nodes (OM_CONSTANT_NUMA_POLICY). Read at mapping time as well.
+ *  - "constant_verify": "load" to checksum constant files eagerly
+ *    (OM_CONSTANT_VERIFY).
+ *  - "instrument", "instrument_time", "instrument_memory": "1" or "0"
+ *    (NOOMINSTRUMENT, NOOMINSTRUMENTTIME, NOOMINSTRUMENTMEMORY, inverted).
+ *    Applied to the live flags immediately, so instrumentation can be
+ *    toggled around a canary request.
+ *  - "memory_trim_period": release the dead arena pages of a thread on
+ *    every Nth outermost arena restore it performs, 0 to disable
+ *    (OM_MEMORY_TRIM_PERIOD). Applies from the thread's next restore.
+ *  - "memory_trim_idle_ms": task pool workers release their dead arena
+ *    pages after this many milliseconds without work, 0 to disable
+ *    (OM_MEMORY_TRIM_IDLE_MS). Applies the next time a worker goes idle.
+ *    See omMemoryTrim in OMRunStats.h for what a trim releases.
+ *
+ * @param key option key from the list above.
+ * @param value option value as a string.
+ * @return 0 on success, -1 for an unknown key or an invalid value.
+ */
+OM_EXTERNAL_VISIBILITY int64_t omSetRuntimeOption(
+    const char *key, const char *value);
+
+/**
+ * \brief Return the stored override for 'key', or NULL when none is set.
+ *
+ * @param key option key.
+ * @return the override value, or NULL.
+ */
+OM_EXTERNAL_VISIBILITY const char *omGetRuntimeOption(const char *key);
+
+/**
+ * \brief Return the stored override for 'key', falling back to the
+ * environment variable 'envVar'. Used by the runtime's own call sites.
+ *
+ * @param key option key.
+ * @param envVar environment variable the key overrides.
+ * @return the override value, the environment value, or NULL.
+ */
+OM_EXTERNAL_VISIBILITY const char *omGetRuntimeOptionOrEnv(
+    const char *key, const char *envVar);
+
+/**
+ * \brief Return a counter bumped on every successful omSetRuntimeOption
+ * call. Call sites caching a parsed option re-read it when the counter
+ * changed.
+ *
+ * @return the current option generation.
+ */
+OM_EXTERNAL_VISIBILITY int64_t omGetRuntimeOptionGeneration(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ONNX_MLIR_OMRUNTIMEOPTION_H */
@@ -12,6 +12,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <stdint.h>
+
 #include "onnx-mlir/Compiler/OMCompilerMacros.h"
 
 #ifdef __cplusplus
@@ -37,6 +39,24 @@ OM_EXTERNAL_VISIBILITY const char *omInputSignature(const char *entryPointName);
 OM_EXTERNAL_VISIBILITY const char *omOutputSignature(
     const char *entryPointName);
 
+/**
+ * \brief Return the signature of the given entry point as a binary table.
+ *
+ * The table is a flat array of int64_t values emitted at compile time with a
+ * fixed layout: the number of tensors first, then for each tensor its data
+ * type (an ONNX TensorProto data type), its rank and its dimension sizes
+ * (-1 for a dynamic dimension). Unlike the JSON signatures above, the table
+ * can be consumed without parsing, which matters when signatures are queried
+ * on a hot path, e.g. for per-request input validation.
+ *
+ * @param entry point name
+ * @param whichSig 0 for the input signature, 1 for the output signature
+ * @return pointer to the binary signature table, or NULL if the entry point
+ * is not found or its signature is not available in binary form
+ */
+OM_EXTERNAL_VISIBILITY const int64_t *omGetSignatureBinary(
+    const char *entryPointName, int64_t whichSig);
+
 #ifdef __cplusplus
 }
 #endif
@@ -123,6 +123,38 @@ OM_EXTERNAL_VISIBILITY OMTensor *omTensorCreate(
 OM_EXTERNAL_VISIBILITY OMTensor *omTensorCreateWithOwnership(void *data_ptr,
     int64_t *shape, int64_t rank, OM_DATA_TYPE dtype, int64_t owning);
 
+/**
+ * \brief Create an OMTensor that borrows a caller-owned buffer, with an
+ * explicit alignment guarantee, without copying any numerical data.
+ *
+ * This is the zero-copy construction path for large inputs whose storage is
+ * managed entirely outside the runtime, such as an mmap'd weight or embedding
+ * file or a network receive buffer. The tensor never owns the buffer: it holds
+ * on to data_ptr without copying, destruction leaves the buffer untouched, and
+ * the caller must keep the buffer alive and unchanged for the lifetime of the
+ * tensor. The compiled model reads directly from the borrowed buffer.
+ *
+ * The alignment argument records the caller's guarantee about data_ptr, in
+ * bytes; it must be a power of two, or 0 to promise nothing beyond natural
+ * element alignment. Creation fails (returning NULL with errno set to EINVAL)
+ * if data_ptr does not satisfy the stated alignment, so a misaligned mmap
+ * offset is caught at construction rather than as a fault or slowdown deep
+ * inside a SIMD kernel.
+ *
+ * @param data_ptr pointer to the caller-owned tensor numerical data. The
+ * buffer is borrowed, never freed, and never copied.
+ * @param shape list of integers indicating the tensor shape.
+ * @param rank tensor rank.
+ * @param dtype tensor element data type.
+ * @param alignment guaranteed alignment of data_ptr in bytes; a power of two,
+ * or 0 for no particular guarantee.
+ * @return pointer to OMTensor created, NULL if creation failed or data_ptr
+ * does not satisfy the stated alignment.
+ *
+ */
+OM_EXTERNAL_VISIBILITY OMTensor *omTensorCreateBorrowed(void *data_ptr,
+    int64_t *shape, int64_t rank, OM_DATA_TYPE dtype, int64_t alignment);
+
 /**
  * Create an OMTensor with the specified shape, rank and element type,
  * allocate uninitialized data for the specified shape.
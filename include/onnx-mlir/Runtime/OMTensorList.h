@@ -65,6 +65,52 @@ OM_EXTERNAL_VISIBILITY OMTensorList *omTensorListCreate(
 OM_EXTERNAL_VISIBILITY OMTensorList *omTensorListCreateWithOwnership(
     OMTensor **tensors, int64_t n, int64_t owning);
 
+/**
+ * \brief Reusable OMTensorList creator
+ *
+ * Create an empty OMTensorList with room for `capacity` tensor pointers,
+ * using a single allocation for both the list and the pointer array.
+ * Intended to be created once per session thread and rebound per inference
+ * with omTensorListRebind, so steady-state inference pays no allocations
+ * for list bookkeeping.
+ *
+ * A reusable list borrows the tensors bound into it and never destroys
+ * them, which supports zero-copy inputs whose buffers remain owned by the
+ * caller. omTensorListDestroy on such a list frees only the list itself.
+ *
+ * @param capacity maximum number of tensor pointers the list can hold
+ * @return pointer to the OMTensorList created, NULL if creation failed.
+ *
+ */
+OM_EXTERNAL_VISIBILITY OMTensorList *omTensorListCreateEmpty(int64_t capacity);
+
+/**
+ * \brief Reusable OMTensorList rebinder
+ *
+ * Replace the contents of a list created by omTensorListCreateEmpty with
+ * the given tensor pointers. The pointers are copied into the list's
+ * preallocated array; the `tensors` ptr stays owned by the caller and no
+ * heap allocation takes place.
+ *
+ * @param list pointer to a reusable OMTensorList
+ * @param tensors array of pointers to OMTensor
+ * @param n number of elements in tensors array
+ * @return true on success, false when list is NULL or n exceeds the
+ * capacity the list was created with.
+ *
+ */
+OM_EXTERNAL_VISIBILITY int64_t omTensorListRebind(
+    OMTensorList *list, OMTensor **tensors, int64_t n);
+
+/**
+ * \brief OMTensorList capacity getter
+ *
+ * @param list pointer to the OMTensorList
+ * @return number of tensor pointer slots preallocated by
+ * omTensorListCreateEmpty, 0 for lists made by the other creators.
+ */
+OM_EXTERNAL_VISIBILITY int64_t omTensorListGetCapacity(OMTensorList *list);
+
 /**
  * \brief OMTensorList destroyer
  *
@@ -16,6 +16,10 @@
 
 #include <map>
 
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
 #include "src/Accelerators/Accelerator.hpp"
 
 namespace onnx_mlir {
@@ -29,6 +33,11 @@ const llvm::SmallVectorImpl<Accelerator *> &Accelerator::getAccelerators() {
   return acceleratorTargets;
 }
 
+void Accelerator::addAccelerator(Accelerator *accelerator) {
+  if (!llvm::is_contained(acceleratorTargets, accelerator))
+    acceleratorTargets.push_back(accelerator);
+}
+
 // Help to print accelerator kinds.
 static std::map<Accelerator::Kind, std::string> mapKind2Strings;
 
@@ -36,6 +45,7 @@ std::ostream &operator<<(std::ostream &out, const Accelerator::Kind kind) {
   if (mapKind2Strings.empty()) {
     APPLY_TO_ACCELERATORS(ACCEL_CL_ENUM_TO_STRING, mapKind2Strings);
     mapKind2Strings[Accelerator::Kind::NONE] = "NONE";
+    mapKind2Strings[Accelerator::Kind::PLUGIN] = "PLUGIN";
   }
   return out << mapKind2Strings[kind];
 }
@@ -45,9 +55,58 @@ llvm::raw_ostream &operator<<(
   if (mapKind2Strings.empty()) {
     APPLY_TO_ACCELERATORS(ACCEL_CL_ENUM_TO_STRING, mapKind2Strings);
     mapKind2Strings[Accelerator::Kind::NONE] = "NONE";
+    mapKind2Strings[Accelerator::Kind::PLUGIN] = "PLUGIN";
   }
   return out << mapKind2Strings[kind];
 }
 
+bool loadAcceleratorPlugins(llvm::ArrayRef<std::string> libraryPaths) {
+  bool allLoaded = true;
+  for (const std::string &path : libraryPaths) {
+    std::string errorMessage;
+    llvm::sys::DynamicLibrary library =
+        llvm::sys::DynamicLibrary::getPermanentLibrary(
+            path.c_str(), &errorMessage);
+    if (!library.isValid()) {
+      llvm::errs() << "Cannot load accelerator plugin " << path << ": "
+                   << errorMessage << "\n";
+      allLoaded = false;
+      continue;
+    }
+    auto abiVersionFunc = reinterpret_cast<PluginABIVersionFunc>(
+        library.getAddressOfSymbol("onnxMlirAcceleratorPluginABIVersion"));
+    auto createFunc = reinterpret_cast<PluginCreateAcceleratorFunc>(
+        library.getAddressOfSymbol("onnxMlirCreateAccelerator"));
+    if (!abiVersionFunc || !createFunc) {
+      llvm::errs() << "Accelerator plugin " << path
+                   << " does not export the plugin entry points.\n";
+      allLoaded = false;
+      continue;
+    }
+    uint64_t abiVersion = abiVersionFunc();
+    if (abiVersion != ONNX_MLIR_ACCEL_PLUGIN_ABI_VERSION) {
+      llvm::errs() << "Accelerator plugin " << path
+                   << " was built against plugin ABI version " << abiVersion
+                   << ", expected " << ONNX_MLIR_ACCEL_PLUGIN_ABI_VERSION
+                   << ".\n";
+      allLoaded = false;
+      continue;
+    }
+    Accelerator *accelerator = createFunc();
+    if (!accelerator) {
+      llvm::errs() << "Accelerator plugin " << path
+                   << " failed to create its accelerator.\n";
+      allLoaded = false;
+      continue;
+    }
+    // Built-in accelerators register themselves in their constructor; do the
+    // same for plugins that did not.
+    Accelerator::addAccelerator(accelerator);
+    if (accelerator->getName().empty())
+      accelerator->setName(llvm::sys::path::stem(path).str());
+  }
+  return allLoaded;
+}
+
 } // namespace accel
 } // namespace onnx_mlir
@@ -52,6 +52,11 @@
 namespace onnx_mlir {
 namespace accel {
 
+// Version of the accelerator plugin interface below. A plugin library built
+// against a different version is rejected at load time. Bump this whenever
+// the Accelerator virtual interface or its types change.
+#define ONNX_MLIR_ACCEL_PLUGIN_ABI_VERSION 1
+
 class Accelerator {
 public:
   /// Kinds of accelerators.
@@ -59,6 +64,8 @@ public:
     // clang-format off
     NONE,
     APPLY_TO_ACCELERATORS(CREATE_ACCEL_ENUM)
+    // Accelerators loaded from a plugin shared library at runtime.
+    PLUGIN,
     // clang-format on
   };
 
@@ -71,6 +78,11 @@ public:
   /// Returns the set of accelerators available.
   static const llvm::SmallVectorImpl<Accelerator *> &getAccelerators();
 
+  /// Register an accelerator instance, ignoring duplicates. Built-in
+  /// accelerators register themselves in their constructor; plugin loading
+  /// registers the instances its libraries create.
+  static void addAccelerator(Accelerator *accelerator);
+
   /// Getter for the name of this accelerator.
   std::string getName() { return name; }
 
@@ -159,5 +171,32 @@ llvm::raw_ostream &operator<<(
 
 extern void initAccelerators(llvm::ArrayRef<Accelerator::Kind> kinds);
 
+//===----------------------------------------------------------------------===//
+// Accelerator plugins
+//===----------------------------------------------------------------------===//
+//
+// Out-of-tree backends can be maintained as plugin shared libraries instead
+// of forking the build-time accelerator list. A plugin is built against the
+// same onnx-mlir and LLVM headers as the compiler and must export, with C
+// linkage:
+//
+//   uint64_t onnxMlirAcceleratorPluginABIVersion();
+//       Returns ONNX_MLIR_ACCEL_PLUGIN_ABI_VERSION the plugin was built
+//       against; a mismatch rejects the plugin.
+//   onnx_mlir::accel::Accelerator *onnxMlirCreateAccelerator();
+//       Creates the plugin's Accelerator subclass (kind Kind::PLUGIN). The
+//       compiler takes ownership and drives it through the same hooks as
+//       built-in accelerators: dialect loading, pass wiring, and the
+//       ONNX-to-Krnl and Krnl-to-LLVM conversion extension points.
+
+/// Signatures of the entry points a plugin library exports.
+using PluginABIVersionFunc = uint64_t (*)();
+using PluginCreateAcceleratorFunc = Accelerator *(*)();
+
+/// Load the given accelerator plugin shared libraries and register their
+/// accelerators. Returns false if any library cannot be loaded, misses an
+/// entry point, or was built against a different plugin ABI version.
+bool loadAcceleratorPlugins(llvm::ArrayRef<std::string> libraryPaths);
+
 } // namespace accel
 } // namespace onnx_mlir
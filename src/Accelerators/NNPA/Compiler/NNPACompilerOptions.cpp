@@ -34,4 +34,19 @@ llvm::cl::list<std::string> execNodesOnCpu{"execNodesOnCpu",
     llvm::cl::CommaSeparated, llvm::cl::ZeroOrMore,
     llvm::cl::cat(OnnxMlirOptions)};
 
+llvm::cl::opt<bool> nnpaEnableCostModel("nnpa-cost-model",
+    llvm::cl::desc("Use a cost model when deciding whether to run an "
+                   "operation on the NNPA: operations estimated to run "
+                   "faster on the CPU, once the cost of converting their "
+                   "inputs and outputs to and from the NNPA data layout is "
+                   "charged, stay on the CPU (default=false)"),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<float> nnpaCostFactor("nnpa-cost-factor",
+    llvm::cl::desc("Scale the NNPA-side estimate of the cost model, for "
+                   "tuning from profiles. Values above 1.0 move borderline "
+                   "operations to the CPU, values below 1.0 to the NNPA "
+                   "(default=1.0)"),
+    llvm::cl::init(1.0), llvm::cl::cat(OnnxMlirOptions));
+
 } // namespace onnx_mlir
@@ -38,5 +38,7 @@ typedef enum {
   extern llvm::cl::OptionCategory OnnxMlirOptions;
   extern llvm::cl::opt<onnx_mlir::NNPAEmissionTargetType> nnpaEmissionTarget;
   extern llvm::cl::list<std::string> execNodesOnCpu;
+  extern llvm::cl::opt<bool> nnpaEnableCostModel;
+  extern llvm::cl::opt<float> nnpaCostFactor;
 
 } // namespace onnx_mlir
@@ -61,7 +61,8 @@ void addONNXToZHighPasses(
   if (instrumentStage == onnx_mlir::InstrumentStages::Onnx)
     pm.addNestedPass<func::FuncOp>(onnx_mlir::createInstrumentPass(
         instrumentOps, instrumentControlBits.getBits()));
-  pm.addPass(onnx_mlir::createONNXToZHighPass(execNodesOnCpu));
+  pm.addPass(onnx_mlir::createONNXToZHighPass(
+      execNodesOnCpu, nnpaEnableCostModel, nnpaCostFactor));
   pm.addPass(onnx_mlir::createShapeInferencePass());
   // There are more opportunities for const propagation once all zhigh ops were
   // generated.
@@ -101,8 +102,9 @@ void addPassesNNPA(mlir::OwningOpRef<mlir::ModuleOp> &module,
 
   // LLVM_DEBUG(llvm::dbgs() << "Adding NNPA passes" << std::endl;);
   if (emissionTarget >= EmitONNXIR)
-    addONNXToMLIRPasses(pm, onnxOpTransformReport, onnxOpTransformReport,
-        /*target CPU*/ maccel.empty(), enableSimdDataLayout);
+    addONNXToMLIRPasses(pm, OptimizationLevel, onnxOpTransformReport,
+        onnxOpTransformReport, /*target CPU*/ maccel.empty(),
+        enableSimdDataLayout);
 
   if (emissionTarget >= EmitMLIR) {
     // Lower zAIU-compatible ONNX ops to ZHigh dialect where possible.
@@ -270,6 +270,12 @@ struct ONNXToZHighLoweringPass
   ONNXToZHighLoweringPass(mlir::ArrayRef<std::string> execNodesOnCpu) {
     this->execNodesOnCpu = execNodesOnCpu;
   }
+  ONNXToZHighLoweringPass(mlir::ArrayRef<std::string> execNodesOnCpu,
+      bool enableCostModel, float costFactor) {
+    this->execNodesOnCpu = execNodesOnCpu;
+    this->enableCostModel = enableCostModel;
+    this->costFactor = costFactor;
+  }
   void runOnOperation() final;
 
 public:
@@ -279,6 +285,16 @@ public:
                      "using the zDNN. The node name is an optional attribute "
                      "in onnx graph, which is `onnx_node_name` in ONNX IR"),
       llvm::cl::ZeroOrMore};
+  Option<bool> enableCostModel{*this, "enable-cost-model",
+      llvm::cl::desc("Use the placement cost model: operations estimated to "
+                     "run faster on the CPU once the stick/unstick cost is "
+                     "charged are not moved to the NNPA"),
+      llvm::cl::init(false)};
+  Option<float> costFactor{*this, "cost-factor",
+      llvm::cl::desc("Scale the NNPA-side estimate of the placement cost "
+                     "model. Values above 1.0 move borderline operations to "
+                     "the CPU, values below 1.0 to the NNPA"),
+      llvm::cl::init(1.0)};
 };
 } // end anonymous namespace.
 
@@ -324,35 +340,57 @@ void ONNXToZHighLoweringPass::runOnOperation() {
   target.addIllegalOp<mlir::memref::AllocOp>();
   target.addIllegalOp<mlir::memref::DeallocOp>();
 
+  // Cost model for the placement decisions below. When disabled (the
+  // default), placement is decided on legality alone as before.
+  onnx_mlir::NNPAPlacementCostModel nnpaCostModel(costFactor);
+  const onnx_mlir::PlacementCostModel *costModel =
+      enableCostModel ? &nnpaCostModel : nullptr;
+
   // ONNX ops to ZHigh dialect under specific conditions.
   // When adding a new op, need to implement a method, i.e. isSuitableForZDNN,
   // for the op in ONNXLegalityCheck.cpp.
-  addDynamicallyLegalOpFor<ONNXAddOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXSubOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXMulOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXDivOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXSumOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXMinOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXMaxOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXReluOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXTanhOp>(&target, &dimAnalysis, execNodesOnCpu);
+  addDynamicallyLegalOpFor<ONNXAddOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXSubOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXMulOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXDivOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXSumOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXMinOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXMaxOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXReluOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXTanhOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
   addDynamicallyLegalOpFor<ONNXSigmoidOp>(
-      &target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXLogOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXExpOp>(&target, &dimAnalysis, execNodesOnCpu);
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXLogOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXExpOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
   addDynamicallyLegalOpFor<ONNXSoftmaxOp>(
-      &target, &dimAnalysis, execNodesOnCpu);
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
   addDynamicallyLegalOpFor<ONNXMaxPoolSingleOutOp>(
-      &target, &dimAnalysis, execNodesOnCpu);
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
   addDynamicallyLegalOpFor<ONNXAveragePoolOp>(
-      &target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXMatMulOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXGemmOp>(&target, &dimAnalysis, execNodesOnCpu);
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXMatMulOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXGemmOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
   addDynamicallyLegalOpFor<ONNXReduceMeanOp>(
-      &target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXLSTMOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXGRUOp>(&target, &dimAnalysis, execNodesOnCpu);
-  addDynamicallyLegalOpFor<ONNXConvOp>(&target, &dimAnalysis, execNodesOnCpu);
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXLSTMOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXGRUOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
+  addDynamicallyLegalOpFor<ONNXConvOp>(
+      &target, &dimAnalysis, execNodesOnCpu, costModel);
 
   // With the target and rewrite patterns defined, we can now attempt the
   // conversion. The conversion will signal failure if any of our `illegal`
@@ -370,4 +408,11 @@ std::unique_ptr<Pass> createONNXToZHighPass(
   return std::make_unique<ONNXToZHighLoweringPass>(execNodesOnCpu);
 }
 
+std::unique_ptr<Pass> createONNXToZHighPass(
+    mlir::ArrayRef<std::string> execNodesOnCpu, bool enableCostModel,
+    float costFactor) {
+  return std::make_unique<ONNXToZHighLoweringPass>(
+      execNodesOnCpu, enableCostModel, costFactor);
+}
+
 } // namespace onnx_mlir
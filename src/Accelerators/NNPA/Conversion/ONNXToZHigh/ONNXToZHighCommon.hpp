@@ -16,15 +16,17 @@
 
 #include "src/Accelerators/NNPA/Conversion/ONNXToZHigh/NNPALimit.h"
 #include "src/Accelerators/NNPA/Conversion/ONNXToZHigh/ONNXLegalityCheck.hpp"
+#include "src/Accelerators/NNPA/Conversion/ONNXToZHigh/PlacementCostModel.hpp"
 #include "src/Accelerators/NNPA/Support/LayoutHelper.hpp"
 #include "src/Transform/ONNX/ONNXDimAnalysis.hpp"
 
 template <typename OP_TYPE>
 void addDynamicallyLegalOpFor(mlir::ConversionTarget *target,
     const onnx_mlir::DimAnalysis *dimAnalysis,
-    mlir::ArrayRef<std::string> execNodesOnCpu) {
-  target->addDynamicallyLegalOp<OP_TYPE>([dimAnalysis, execNodesOnCpu](
-                                             OP_TYPE op) {
+    mlir::ArrayRef<std::string> execNodesOnCpu,
+    const onnx_mlir::PlacementCostModel *costModel = nullptr) {
+  target->addDynamicallyLegalOp<OP_TYPE>([dimAnalysis, execNodesOnCpu,
+                                             costModel](OP_TYPE op) {
     // Check operations to be forced to run on CPU.
     mlir::Operation *genericOp = op.getOperation();
     mlir::StringAttr nodeName =
@@ -56,6 +58,12 @@ void addDynamicallyLegalOpFor(mlir::ConversionTarget *target,
     if (exceedLimit)
       return true;
 
+    // Check the placement cost model, when one is in use: an operation that
+    // is estimated to run faster on the CPU once the stick/unstick cost of
+    // its operands and results is charged stays on the CPU.
+    if (costModel && !costModel->isProfitableOnAccelerator(genericOp))
+      return true;
+
     return !isSuitableForZDNN<OP_TYPE>(op, dimAnalysis);
   });
 }
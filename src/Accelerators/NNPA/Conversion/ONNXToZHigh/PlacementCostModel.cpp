@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===---------- PlacementCostModel.cpp - Cost model for placement ---------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements the cost model used to decide whether an ONNX
+// operation that is legal for the NNPA is also worth placing there.
+//
+// The estimates are deliberately coarse: they only have to separate
+// operations whose work dwarfs the stick/unstick conversion of their
+// operands and results from small operations where the conversion dominates.
+// The machine parameters below are order-of-magnitude figures for z16; the
+// pass-level cost factor is the knob to adjust them from profiles.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/TypeSwitch.h"
+
+#include "src/Accelerators/NNPA/Conversion/ONNXToZHigh/PlacementCostModel.hpp"
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+
+using namespace mlir;
+
+namespace {
+
+// FLOP per cycle sustained by the CPU SIMD units on fp32.
+static constexpr double CPU_FLOP_PER_CYCLE = 8.0;
+// FLOP per cycle sustained by the NNPA on dlfloat16.
+static constexpr double NNPA_FLOP_PER_CYCLE = 128.0;
+// Fixed cycles to set up and launch one NNPA operation.
+static constexpr double NNPA_CALL_OVERHEAD_CYCLES = 10000.0;
+// Cycles per element to stickify or unstickify one tensor.
+static constexpr double STICKIFY_CYCLES_PER_ELEMENT = 2.0;
+
+/// Number of elements of a value with a statically shaped tensor type, or -1
+/// when the shape is not static.
+int64_t getNumElements(Value value) {
+  auto shapedType = value.getType().dyn_cast<ShapedType>();
+  if (!shapedType || !shapedType.hasStaticShape())
+    return -1;
+  return shapedType.getNumElements();
+}
+
+/// Estimated FLOP to compute `op` once, or -1 when the shapes involved are
+/// not static. Operations without a dedicated case are treated as
+/// elementwise: one operation per element of their largest tensor.
+double getFlops(Operation *op) {
+  return llvm::TypeSwitch<Operation *, double>(op)
+      .Case<ONNXMatMulOp>([](ONNXMatMulOp matmulOp) -> double {
+        int64_t outputElements = getNumElements(matmulOp.Y());
+        auto aType = matmulOp.A().getType().dyn_cast<ShapedType>();
+        if (outputElements < 0 || !aType || !aType.hasStaticShape())
+          return -1;
+        // One multiply-add per output element per shared dimension.
+        int64_t sharedDim = aType.getShape().back();
+        return 2.0 * outputElements * sharedDim;
+      })
+      .Case<ONNXGemmOp>([](ONNXGemmOp gemmOp) -> double {
+        int64_t outputElements = getNumElements(gemmOp.Y());
+        auto aType = gemmOp.A().getType().dyn_cast<ShapedType>();
+        if (outputElements < 0 || !aType || !aType.hasStaticShape())
+          return -1;
+        int64_t sharedDim = aType.getShape()[gemmOp.transA() ? 0 : 1];
+        return 2.0 * outputElements * sharedDim;
+      })
+      .Case<ONNXConvOp>([](ONNXConvOp convOp) -> double {
+        int64_t outputElements = getNumElements(convOp.Y());
+        int64_t weightElements = getNumElements(convOp.W());
+        auto wType = convOp.W().getType().dyn_cast<ShapedType>();
+        if (outputElements < 0 || weightElements < 0)
+          return -1;
+        // One multiply-add per output element per weight element feeding it:
+        // the weight tensor is (M x C/group x kernel), M of which produce
+        // distinct output channels.
+        int64_t numOutputChannels = wType.getShape()[0];
+        return 2.0 * outputElements * (weightElements / numOutputChannels);
+      })
+      .Case<ONNXLSTMOp, ONNXGRUOp>([](auto rnnOp) -> double {
+        int64_t weightElements = getNumElements(rnnOp.W());
+        int64_t recurrenceElements = getNumElements(rnnOp.R());
+        auto xType = rnnOp.X().getType().template dyn_cast<ShapedType>();
+        if (weightElements < 0 || recurrenceElements < 0 || !xType ||
+            !xType.hasStaticShape())
+          return -1;
+        // The gate matmuls dominate: per step and batch element, one
+        // multiply-add per element of W and of R (the direction dimension is
+        // already part of both).
+        int64_t seqLength = xType.getShape()[0];
+        int64_t batchSize = xType.getShape()[1];
+        return 2.0 * seqLength * batchSize *
+               (weightElements + recurrenceElements);
+      })
+      .Default([](Operation *genericOp) -> double {
+        // Elementwise by default: one operation per element of the largest
+        // operand or result.
+        int64_t maxElements = 0;
+        for (Value value : genericOp->getOperands()) {
+          if (value.getType().isa<NoneType>())
+            continue;
+          int64_t elements = getNumElements(value);
+          if (elements < 0)
+            return -1;
+          maxElements = std::max(maxElements, elements);
+        }
+        for (Value value : genericOp->getResults()) {
+          int64_t elements = getNumElements(value);
+          if (elements < 0)
+            return -1;
+          maxElements = std::max(maxElements, elements);
+        }
+        return (double)maxElements;
+      });
+}
+
+} // namespace
+
+namespace onnx_mlir {
+
+bool PlacementCostModel::isProfitableOnAccelerator(Operation *op) const {
+  double cpuCost = getCPUCost(op);
+  double acceleratorCost = getAcceleratorCost(op);
+  double conversionCost = getConversionCost(op);
+  // Without static shapes there is no estimate; fall back to legality only.
+  if (cpuCost < 0 || acceleratorCost < 0 || conversionCost < 0)
+    return true;
+  return acceleratorCost + conversionCost < cpuCost;
+}
+
+double NNPAPlacementCostModel::getCPUCost(Operation *op) const {
+  double flops = getFlops(op);
+  if (flops < 0)
+    return -1;
+  return flops / CPU_FLOP_PER_CYCLE;
+}
+
+double NNPAPlacementCostModel::getAcceleratorCost(Operation *op) const {
+  double flops = getFlops(op);
+  if (flops < 0)
+    return -1;
+  return costFactor * (NNPA_CALL_OVERHEAD_CYCLES + flops / NNPA_FLOP_PER_CYCLE);
+}
+
+double NNPAPlacementCostModel::getConversionCost(Operation *op) const {
+  // Charge every operand and result as if it crossed the CPU/NNPA boundary.
+  // This is conservative: tensors flowing between two NNPA operations stay
+  // stickified and their conversions fold away after lowering.
+  int64_t boundaryElements = 0;
+  for (Value value : op->getOperands()) {
+    if (value.getType().isa<NoneType>())
+      continue;
+    int64_t elements = getNumElements(value);
+    if (elements < 0)
+      return -1;
+    boundaryElements += elements;
+  }
+  for (Value value : op->getResults()) {
+    int64_t elements = getNumElements(value);
+    if (elements < 0)
+      return -1;
+    boundaryElements += elements;
+  }
+  return costFactor * STICKIFY_CYCLES_PER_ELEMENT * boundaryElements;
+}
+
+} // namespace onnx_mlir
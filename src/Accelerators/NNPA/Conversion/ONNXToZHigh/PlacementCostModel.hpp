@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===---------- PlacementCostModel.hpp - Cost model for placement ---------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file declares a cost model used to decide whether an ONNX operation
+// that is legal for an accelerator is also worth placing there. Legality
+// alone is not enough: a small operation pays the cost of converting its
+// operands and results across the CPU/accelerator boundary and can end up
+// slower on the accelerator than on the CPU.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "mlir/IR/Operation.h"
+
+namespace onnx_mlir {
+
+/// Accelerator-neutral interface estimating, in abstract cycles, the cost of
+/// running one operation on the CPU or on an accelerator. The estimates only
+/// need to be comparable to each other, not accurate in absolute terms.
+class PlacementCostModel {
+public:
+  virtual ~PlacementCostModel() {}
+
+  /// Estimated cycles to run `op` on the CPU, or -1 if unknown (e.g. the
+  /// shapes involved are not static).
+  virtual double getCPUCost(mlir::Operation *op) const = 0;
+
+  /// Estimated cycles to run `op` on the accelerator, excluding data
+  /// conversion, or -1 if unknown.
+  virtual double getAcceleratorCost(mlir::Operation *op) const = 0;
+
+  /// Estimated cycles to convert the operands and results of `op` to and
+  /// from the accelerator's data layout, or -1 if unknown. This is an upper
+  /// bound: conversions shared between adjacent accelerator operations are
+  /// counted for each of them.
+  virtual double getConversionCost(mlir::Operation *op) const = 0;
+
+  /// Whether `op` is estimated to run faster on the accelerator than on the
+  /// CPU once the conversion cost is charged. Returns true when any of the
+  /// estimates is unknown, so that the decision falls back to legality only.
+  bool isProfitableOnAccelerator(mlir::Operation *op) const;
+};
+
+/// Cost model for the NNPA accelerator. The estimates are derived from the
+/// static element and FLOP counts of the operation; `costFactor` scales the
+/// accelerator-side estimate (computation plus stick/unstick conversion) and
+/// can be tuned from profiles: values above 1.0 move borderline operations
+/// to the CPU, values below 1.0 to the NNPA.
+class NNPAPlacementCostModel : public PlacementCostModel {
+public:
+  NNPAPlacementCostModel(double costFactor = 1.0) : costFactor(costFactor) {}
+
+  double getCPUCost(mlir::Operation *op) const override;
+  double getAcceleratorCost(mlir::Operation *op) const override;
+  double getConversionCost(mlir::Operation *op) const override;
+
+  double getCostFactor() const { return costFactor; }
+
+private:
+  double costFactor;
+};
+
+} // namespace onnx_mlir
@@ -1314,6 +1314,183 @@ struct ZHighToZLowBatchNormOpLowering : public ConversionPattern {
   }
 };
 
+//===----------------------------------------------------------------------===//
+// Lower ONNX element-wise ops that operate directly on stickified ztensors.
+//
+// ZHighLayoutPropagation pushes ONNX element-wise operations down onto
+// zTensors so that data stays in the stickified DLFLOAT16 layout across small
+// CPU computations instead of paying a stick/unstick round trip. The default
+// ONNX lowering would compute on the f16 elements directly, but DLFLOAT16 and
+// IEEE half precision have different exponent/fraction splits (6/9 versus
+// 5/10 bits). These patterns emit a scalar loop nest that widens each
+// DLFLOAT16 element to f32 by bit manipulation, computes in f32, and narrows
+// the result back, mirroring the scalar conversion in DLF16Conversion.hpp.
+//===----------------------------------------------------------------------===//
+
+/// Emit code to widen a DLFLOAT16 value (loaded as an f16 bit pattern) into
+/// an f32 value.
+static Value emitDLF16ToF32(
+    PatternRewriter &rewriter, Location loc, Value dlf16) {
+  MathBuilder createMath(rewriter, loc);
+  Type i32Ty = rewriter.getIntegerType(32);
+  auto cst = [&](int64_t value) { return createMath.constant(i32Ty, value); };
+  Value bits16 = rewriter.create<arith::BitcastOp>(
+      loc, rewriter.getIntegerType(16), dlf16);
+  Value bits = rewriter.create<arith::ExtUIOp>(loc, i32Ty, bits16);
+  Value sign = rewriter.create<arith::ShLIOp>(
+      loc, createMath.andi(bits, cst(0x8000)), cst(16));
+  Value magnitude = createMath.andi(bits, cst(0x7FFF));
+  // Shift the exponent and fraction fields into their f32 positions, then
+  // rebias the exponent from 31 to 127 by adding the difference to the
+  // exponent field.
+  Value f32Bits = createMath.add(
+      rewriter.create<arith::ShLIOp>(loc, magnitude, cst(14)), cst(96 << 23));
+  // +/-0 stays zero; NINF (all exponent and fraction bits set) becomes NaN.
+  f32Bits =
+      createMath.select(createMath.eq(magnitude, cst(0)), cst(0), f32Bits);
+  f32Bits = createMath.select(
+      createMath.eq(magnitude, cst(0x7FFF)), cst(0x7FC00000), f32Bits);
+  f32Bits = createMath.ori(f32Bits, sign);
+  return rewriter.create<arith::BitcastOp>(loc, rewriter.getF32Type(), f32Bits);
+}
+
+/// Emit code to narrow an f32 value into a DLFLOAT16 value (as an f16 bit
+/// pattern), rounding to nearest and saturating out-of-range values to NINF.
+static Value emitF32ToDLF16(
+    PatternRewriter &rewriter, Location loc, Value f32) {
+  MathBuilder createMath(rewriter, loc);
+  Type i32Ty = rewriter.getIntegerType(32);
+  auto cst = [&](int64_t value) { return createMath.constant(i32Ty, value); };
+  Value bits = rewriter.create<arith::BitcastOp>(loc, i32Ty, f32);
+  Value sign = createMath.andi(
+      rewriter.create<arith::ShRUIOp>(loc, bits, cst(16)), cst(0x8000));
+  Value magnitude = createMath.andi(bits, cst(0x7FFFFFFF));
+  // Round to nearest by adding half of the last fraction bit that is kept; a
+  // carry propagates naturally into the exponent field.
+  Value rounded = createMath.add(magnitude, cst(1 << 13));
+  // Rebias the exponent from 127 to 31 and drop the extra fraction bits.
+  Value dlf16Bits = rewriter.create<arith::ShRUIOp>(
+      loc, createMath.sub(rounded, cst(96 << 23)), cst(14));
+  // Exponents below the DLFLOAT16 range flush to zero; magnitudes above NMAX
+  // (0x4FFF9FFF is FP32::NNP1_NMAX, covering infinity and NaN) map to NINF.
+  dlf16Bits = createMath.select(
+      createMath.slt(rounded, cst(96 << 23)), cst(0), dlf16Bits);
+  dlf16Bits = createMath.select(
+      createMath.sgt(magnitude, cst(0x4FFF9FFF)), cst(0x7FFF), dlf16Bits);
+  dlf16Bits = createMath.ori(dlf16Bits, sign);
+  Value bits16 = rewriter.create<arith::TruncIOp>(
+      loc, rewriter.getIntegerType(16), dlf16Bits);
+  return rewriter.create<arith::BitcastOp>(loc, rewriter.getF16Type(), bits16);
+}
+
+/// Emit the f32 computation for a single element of an ONNX element-wise
+/// operation.
+template <typename ONNX_OP>
+static Value emitF32ElementwiseOp(
+    PatternRewriter &rewriter, Location loc, ArrayRef<Value> fp32Operands);
+
+template <>
+Value emitF32ElementwiseOp<ONNXAddOp>(
+    PatternRewriter &rewriter, Location loc, ArrayRef<Value> fp32Operands) {
+  MathBuilder createMath(rewriter, loc);
+  return createMath.add(fp32Operands[0], fp32Operands[1]);
+}
+
+template <>
+Value emitF32ElementwiseOp<ONNXSubOp>(
+    PatternRewriter &rewriter, Location loc, ArrayRef<Value> fp32Operands) {
+  MathBuilder createMath(rewriter, loc);
+  return createMath.sub(fp32Operands[0], fp32Operands[1]);
+}
+
+template <>
+Value emitF32ElementwiseOp<ONNXMulOp>(
+    PatternRewriter &rewriter, Location loc, ArrayRef<Value> fp32Operands) {
+  MathBuilder createMath(rewriter, loc);
+  return createMath.mul(fp32Operands[0], fp32Operands[1]);
+}
+
+template <>
+Value emitF32ElementwiseOp<ONNXDivOp>(
+    PatternRewriter &rewriter, Location loc, ArrayRef<Value> fp32Operands) {
+  MathBuilder createMath(rewriter, loc);
+  return createMath.div(fp32Operands[0], fp32Operands[1]);
+}
+
+template <>
+Value emitF32ElementwiseOp<ONNXSqrtOp>(
+    PatternRewriter &rewriter, Location loc, ArrayRef<Value> fp32Operands) {
+  MathBuilder createMath(rewriter, loc);
+  return createMath.sqrt(fp32Operands[0]);
+}
+
+template <>
+Value emitF32ElementwiseOp<ONNXReciprocalOp>(
+    PatternRewriter &rewriter, Location loc, ArrayRef<Value> fp32Operands) {
+  MathBuilder createMath(rewriter, loc);
+  Value one = createMath.constant(rewriter.getF32Type(), 1.0);
+  return createMath.div(one, fp32Operands[0]);
+}
+
+template <typename ONNX_OP>
+struct ONNXElementwiseOpOnZTensorLowering : public ConversionPattern {
+  ONNXElementwiseOpOnZTensorLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx)
+      : ConversionPattern(
+            typeConverter, ONNX_OP::getOperationName(), /*benefit=*/2, ctx) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    Location loc = op->getLoc();
+
+    // Only match element-wise operations computed directly on stickified
+    // ztensors. CPU tensors take the default ONNX lowering.
+    Type outputTensorType = op->getResult(0).getType();
+    if (!isZTensor(outputTensorType))
+      return failure();
+    // Layout propagation only creates these operations without broadcasting,
+    // so all operands have the same type as the output. Broadcasting cases
+    // fall back to the default ONNX lowering.
+    for (Value operand : op->getOperands())
+      if (operand.getType() != outputTensorType)
+        return failure();
+
+    // Helper builders.
+    MultiDialectBuilder<IndexExprBuilderForKrnl, KrnlBuilder> create(
+        rewriter, loc);
+
+    // Convert ZTensor type to MemRefType.
+    ZMemRefType zMemRefType = convertZTensorToMemRefType(outputTensorType);
+
+    // Allocate a buffer for the result MemRef.
+    SmallVector<IndexExpr, 4> dims;
+    create.krnlIE.getShapeAsDims(operands[0], dims);
+    Value alloc = insertAllocAndDeallocZMemRef(zMemRefType, dims, op, rewriter);
+
+    // Iterate over the logical dimensions only: the affine layout map takes
+    // care of addressing into the stickified buffer and pad elements are
+    // never touched.
+    int64_t rank = dims.size();
+    ValueRange loopDef = create.krnl.defineLoops(rank);
+    SmallVector<IndexExpr, 4> lbs(rank, LiteralIndexExpr(0));
+    create.krnl.iterateIE(loopDef, loopDef, lbs, dims,
+        [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+          SmallVector<Value, 2> fp32Operands;
+          for (Value operand : operands) {
+            Value dlf16 = createKrnl.load(operand, loopInd);
+            fp32Operands.emplace_back(emitDLF16ToF32(rewriter, loc, dlf16));
+          }
+          Value fp32Res =
+              emitF32ElementwiseOp<ONNX_OP>(rewriter, loc, fp32Operands);
+          createKrnl.store(emitF32ToDLF16(rewriter, loc, fp32Res), alloc,
+              loopInd);
+        });
+
+    rewriter.replaceOp(op, alloc);
+    return success();
+  }
+};
+
 void populateZHighToZLowConversionPattern(mlir::RewritePatternSet &patterns,
     mlir::TypeConverter &typeConverter, mlir::MLIRContext *ctx) {
   patterns.insert<ZHighToZLowStickifiedConstantOpLowering>(typeConverter, ctx);
@@ -1346,6 +1523,19 @@ void populateZHighToZLowConversionPattern(mlir::RewritePatternSet &patterns,
   patterns
       .insert<ZHighToZLowPool2DOpLowering<ZHighAvgPool2DOp, ZLowAvgPool2DOp>>(
           typeConverter, ctx);
+  // ONNX element-wise ops kept on stickified ztensors by layout propagation.
+  patterns.insert<ONNXElementwiseOpOnZTensorLowering<ONNXAddOp>>(
+      typeConverter, ctx);
+  patterns.insert<ONNXElementwiseOpOnZTensorLowering<ONNXSubOp>>(
+      typeConverter, ctx);
+  patterns.insert<ONNXElementwiseOpOnZTensorLowering<ONNXMulOp>>(
+      typeConverter, ctx);
+  patterns.insert<ONNXElementwiseOpOnZTensorLowering<ONNXDivOp>>(
+      typeConverter, ctx);
+  patterns.insert<ONNXElementwiseOpOnZTensorLowering<ONNXSqrtOp>>(
+      typeConverter, ctx);
+  patterns.insert<ONNXElementwiseOpOnZTensorLowering<ONNXReciprocalOp>>(
+      typeConverter, ctx);
 }
 
 } // namespace zhigh
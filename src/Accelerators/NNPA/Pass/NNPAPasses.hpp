@@ -23,6 +23,9 @@ namespace onnx_mlir {
 std::unique_ptr<mlir::Pass> createONNXToZHighPass();
 std::unique_ptr<mlir::Pass> createONNXToZHighPass(
     mlir::ArrayRef<std::string> execNodesOnCpu);
+std::unique_ptr<mlir::Pass> createONNXToZHighPass(
+    mlir::ArrayRef<std::string> execNodesOnCpu, bool enableCostModel,
+    float costFactor);
 
 /// Add pass for rewriting ONNX ops for ZHigh.
 std::unique_ptr<mlir::Pass> createRewriteONNXForZHighPass();
@@ -10,23 +10,127 @@
 //
 // This file contains conversions between floating point and ZDNN formats.
 //
+// The conversions are hot: every tensor crossing the CPU/NNPA boundary runs
+// through them once per element. On z16 the whole conversion is done eight
+// elements at a time in VX registers with the NNP conversion instructions;
+// elsewhere a branch-free formulation on the integer images lets the
+// compiler use its native SIMD. The scalar NNP1 class remains the reference
+// implementation and handles the loop remainder on z.
+//
 //===----------------------------------------------------------------------===//
 
 #include "src/Accelerators/NNPA/Transform/ZHigh/Stickify/Convert.hpp"
 #include "src/Accelerators/NNPA/Transform/ZHigh/Stickify/DLF16Conversion.hpp"
 
+#if defined(__s390x__) && defined(__VEC__) && defined(__ARCH__) &&             \
+    __ARCH__ >= 14
+#define DLF16_CONVERSION_VECTOR 1
+#include <vecintrin.h>
+#endif
+
+#ifdef DLF16_CONVERSION_VECTOR
+
+typedef __vector float vec_fp32;
+typedef __vector unsigned short vec_u16;
+
+/// Convert eight fp32 values held in two VX registers into eight dlf16
+/// values, with the rounding of the NNP conversion facility.
+static inline vec_u16 vec_fp32_to_dlf16(vec_fp32 hi, vec_fp32 lo) {
+  vec_u16 out;
+  // VECTOR CONVERT AND ROUND TO NNP from an fp32 pair.
+  asm("vcrnf %[out],%[hi],%[lo],0,2"
+      : [out] "=v"(out)
+      : [hi] "v"(hi), [lo] "v"(lo));
+  return out;
+}
+
+/// Convert eight dlf16 values held in one VX register into eight fp32
+/// values in two VX registers.
+static inline void vec_dlf16_to_fp32(vec_u16 in, vec_fp32 *hi, vec_fp32 *lo) {
+  // VECTOR CONVERT FROM NNP HIGH/LOW.
+  asm("vclfnh %[out],%[in],2,0" : [out] "=v"(*hi) : [in] "v"(in));
+  asm("vclfnl %[out],%[in],2,0" : [out] "=v"(*lo) : [in] "v"(in));
+}
+
+#else
+
+/// fp32 -> dlf16 on the integer images, mirroring NNP1::convert(float). The
+/// body is select-based rather than branchy so the conversion loops below
+/// vectorize.
+static inline uint16_t fp32_bits_to_dlf16_bits(uint32_t fp32) {
+  int32_t biasedExponent = (int32_t)((fp32 >> FP32::FRACTION_BITS) & 0xFF) -
+                           FP32::EXPONENT_BIAS + NNP1::EXPONENT_BIAS;
+  uint32_t fraction = (fp32 & FP32::FRACTION) + FP32::NNP1_ROUND;
+  if (fraction > FP32::FRACTION) {
+    fraction = 0;
+    biasedExponent++;
+  }
+  uint16_t sign = (uint16_t)((fp32 >> 31) << 15);
+  if (biasedExponent < 0)
+    return sign; // Underflow to signed zero.
+  if ((fp32 & ~FP32::SIGN) > FP32::NNP1_NMAX)
+    return sign | NNP1::NINF; // Overflow, inf and NaN all map to NINF.
+  return sign | ((uint16_t)biasedExponent << NNP1::FRACTION_BITS) |
+         (uint16_t)(fraction >> (FP32::FRACTION_BITS - NNP1::FRACTION_BITS));
+}
+
+/// dlf16 -> fp32 on the integer images, mirroring NNP1::convert().
+static inline uint32_t dlf16_bits_to_fp32_bits(uint16_t dlf16) {
+  uint32_t sign = (uint32_t)(dlf16 >> 15) << 31;
+  uint16_t magnitude = dlf16 & ~NNP1::SIGN;
+  if (magnitude == 0)
+    return sign; // Signed zero.
+  if (magnitude == NNP1::NINF)
+    return 0x7FC00000; // NINF reads back as (unsigned) NaN.
+  uint32_t exponent = (uint32_t)((dlf16 >> NNP1::FRACTION_BITS) & 0x3F) -
+                      NNP1::EXPONENT_BIAS + FP32::EXPONENT_BIAS;
+  uint32_t fraction = (uint32_t)(dlf16 & NNP1::FRACTION)
+                      << (FP32::FRACTION_BITS - NNP1::FRACTION_BITS);
+  return sign | (exponent << FP32::FRACTION_BITS) | fraction;
+}
+
+#endif // DLF16_CONVERSION_VECTOR
+
 /// fp32 -> dlf16 conversion.
 uint64_t fp32_to_dlf16(
     float *fp32_data, uint16_t *dflt16_data, uint64_t num_fields) {
-  for (uint64_t i = 0; i < num_fields; i++)
+#ifdef DLF16_CONVERSION_VECTOR
+  uint64_t i = 0;
+  for (; i + 8 <= num_fields; i += 8) {
+    vec_fp32 hi = vec_xl(0, fp32_data + i);
+    vec_fp32 lo = vec_xl(0, fp32_data + i + 4);
+    vec_xst(vec_fp32_to_dlf16(hi, lo), 0, dflt16_data + i);
+  }
+  for (; i < num_fields; i++)
     dflt16_data[i] = NNP1(fp32_data[i]).uint();
+#else
+  for (uint64_t i = 0; i < num_fields; i++) {
+    uint32_t fp32;
+    memcpy(&fp32, &fp32_data[i], sizeof(fp32));
+    dflt16_data[i] = fp32_bits_to_dlf16_bits(fp32);
+  }
+#endif
   return num_fields;
 }
 
 /// dlf16 -> fp32 conversion.
 uint64_t dlf16_to_fp32(
     uint16_t *dflt16_data, float *fp32_data, uint64_t num_fields) {
-  for (uint64_t i = 0; i < num_fields; i++)
+#ifdef DLF16_CONVERSION_VECTOR
+  uint64_t i = 0;
+  for (; i + 8 <= num_fields; i += 8) {
+    vec_fp32 hi, lo;
+    vec_dlf16_to_fp32(vec_xl(0, dflt16_data + i), &hi, &lo);
+    vec_xst(hi, 0, fp32_data + i);
+    vec_xst(lo, 0, fp32_data + i + 4);
+  }
+  for (; i < num_fields; i++)
     fp32_data[i] = NNP1(dflt16_data[i]).convert();
+#else
+  for (uint64_t i = 0; i < num_fields; i++) {
+    uint32_t fp32 = dlf16_bits_to_fp32_bits(dflt16_data[i]);
+    memcpy(&fp32_data[i], &fp32, sizeof(fp32));
+  }
+#endif
   return num_fields;
 }
@@ -42,6 +42,10 @@ zdnn_status allochelper_ztensor_alloc(zdnn_ztensor *ztensor);
 /// Deallocate ztensor buffer
 void allochelper_ztensor_free(zdnn_ztensor *ztensor);
 
+/// Free a buffer allocated with allochelper_ztensor_alloc, for callers that
+/// take ownership of the buffer away from the ztensor.
+void free_aligned_4k(void *aligned_ptr);
+
 /// Converts the input tensor to the supported stick format for execution by
 /// zDNN operations.
 ///
@@ -71,17 +71,21 @@ bool isFromDenseONNXConstantOp(Value result) {
   return true;
 }
 
-/// Get raw data from a dense attribute.
-static void getRawData(DenseElementsAttr denseAttr, std::vector<char> &data) {
-  if (!denseAttr.isSplat()) {
-    data = denseAttr.getRawData();
-  } else {
-    ShapedType denseShapeType = denseAttr.getType().cast<ShapedType>();
-    std::vector<char> rawData = denseAttr.getRawData();
-    int64_t numElements = denseShapeType.getNumElements();
-    for (int i = 0; i < numElements; i++)
-      data.insert(data.end(), rawData.begin(), rawData.end());
-  }
+/// Get raw data from a dense attribute without copying the underlying
+/// buffer: stickify streams directly out of the attribute's own storage.
+/// Only a splat needs to be expanded, into `splatData`, which keeps the
+/// expansion alive for as long as the returned reference is used.
+static ArrayRef<char> getRawData(
+    DenseElementsAttr denseAttr, std::vector<char> &splatData) {
+  if (!denseAttr.isSplat())
+    return denseAttr.getRawData();
+  ShapedType denseShapeType = denseAttr.getType().cast<ShapedType>();
+  ArrayRef<char> rawData = denseAttr.getRawData();
+  int64_t numElements = denseShapeType.getNumElements();
+  splatData.reserve(numElements * rawData.size());
+  for (int i = 0; i < numElements; i++)
+    splatData.insert(splatData.end(), rawData.begin(), rawData.end());
+  return llvm::makeArrayRef(splatData);
 }
 
 /// MLIR type to zDNN type.
@@ -110,15 +114,21 @@ ZHighStickifiedConstantOp emitZHighStickifiedConstant(PatternRewriter &rewriter,
 
   // Use an dense resource attribute to store stickified data.
   // Attribute type: tensor<sizeInBytes x i8>
+  // The ztensor buffer is already the final bytes, so hand it over to the
+  // blob instead of copying it; the blob frees it when released. This keeps
+  // the peak at one stickified copy per weight.
   int64_t sizeInBytes = ztensor->buffer_size;
+  AsmResourceBlob blob(
+      llvm::makeArrayRef((char *)ztensor->buffer, sizeInBytes),
+      /*dataAlignment=*/4096,
+      [](void *data, size_t, size_t) { free_aligned_4k(data); },
+      /*dataIsMutable=*/true);
   DenseResourceElementsAttr valueAttr = DenseUI8ResourceElementsAttr::get(
       RankedTensorType::get({sizeInBytes}, rewriter.getI8Type()),
       stickifiedConstant.getOperation()
           ->getDialect()
           ->getNamespace(), // use the dialect as the blob "hint"
-      HeapAsmResourceBlob::allocateAndCopy(
-          llvm::makeArrayRef((char *)ztensor->buffer, sizeInBytes),
-          alignof(char)));
+      std::move(blob));
 
   stickifiedConstant.valueAttr(valueAttr);
 
@@ -138,8 +148,8 @@ ZHighStickifiedConstantOp createConstantForStick(PatternRewriter &rewriter,
                                    .dyn_cast_or_null<mlir::DenseElementsAttr>();
   assert(dataAttr && "Attribute is null");
   // Read attributes's raw data.
-  std::vector<char> rawData;
-  getRawData(dataAttr, rawData);
+  std::vector<char> splatData;
+  ArrayRef<char> rawData = getRawData(dataAttr, splatData);
   // assert((rawData.size() == (uint64_t)getMemRefSizeInBytes(input)) &&
   //        "Data size mismatched");
 
@@ -161,7 +171,8 @@ ZHighStickifiedConstantOp createConstantForStick(PatternRewriter &rewriter,
   init_ztensor(&pre_tfrmd_desc, &tfrmd_desc, &ztensor);
   status = allochelper_ztensor_alloc(&ztensor);
   assert(status == ZDNN_OK);
-  status = stickify(&ztensor, rawData.data());
+  // stickify only reads the input buffer.
+  status = stickify(&ztensor, const_cast<char *>(rawData.data()));
   assert(status == ZDNN_OK);
   // Emit a constant global in ZHigh dialect.
   ZHighStickifiedConstantOp constantOp = emitZHighStickifiedConstant(
@@ -199,11 +210,11 @@ ZHighStickifiedConstantOp createConstantForStickForLSTM(
   assert((fDataAttr && iDataAttr && cDataAttr && oDataAttr) &&
          "Attribute is null");
   // Read attributes's raw data.
-  std::vector<char> rawFData, rawIData, rawCData, rawOData;
-  getRawData(fDataAttr, rawFData);
-  getRawData(iDataAttr, rawIData);
-  getRawData(cDataAttr, rawCData);
-  getRawData(oDataAttr, rawOData);
+  std::vector<char> fSplatData, iSplatData, cSplatData, oSplatData;
+  ArrayRef<char> rawFData = getRawData(fDataAttr, fSplatData);
+  ArrayRef<char> rawIData = getRawData(iDataAttr, iSplatData);
+  ArrayRef<char> rawCData = getRawData(cDataAttr, cSplatData);
+  ArrayRef<char> rawOData = getRawData(oDataAttr, oSplatData);
 
   // Call stickify.
   zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
@@ -224,8 +235,10 @@ ZHighStickifiedConstantOp createConstantForStickForLSTM(
   init_ztensor(&pre_tfrmd_desc, &tfrmd_desc, &ztensor);
   status = allochelper_ztensor_alloc(&ztensor);
   assert(status == ZDNN_OK);
-  status = stickify(&ztensor, rawFData.data(), rawIData.data(), rawCData.data(),
-      rawOData.data());
+  // stickify only reads the input buffers.
+  status = stickify(&ztensor, const_cast<char *>(rawFData.data()),
+      const_cast<char *>(rawIData.data()), const_cast<char *>(rawCData.data()),
+      const_cast<char *>(rawOData.data()));
   assert(status == ZDNN_OK);
 
   // Emit a constant global in ZHigh dialect.
@@ -259,10 +272,10 @@ ZHighStickifiedConstantOp createConstantForStickForGRU(
           .dyn_cast_or_null<mlir::DenseElementsAttr>();
   assert((zDataAttr && rDataAttr && hDataAttr) && "Attribute is null");
   // Read attributes's raw data.
-  std::vector<char> rawZData, rawHData, rawRData, rawOData;
-  getRawData(zDataAttr, rawZData);
-  getRawData(rDataAttr, rawRData);
-  getRawData(hDataAttr, rawHData);
+  std::vector<char> zSplatData, rSplatData, hSplatData;
+  ArrayRef<char> rawZData = getRawData(zDataAttr, zSplatData);
+  ArrayRef<char> rawRData = getRawData(rDataAttr, rSplatData);
+  ArrayRef<char> rawHData = getRawData(hDataAttr, hSplatData);
 
   // Call stickify.
   zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
@@ -283,8 +296,9 @@ ZHighStickifiedConstantOp createConstantForStickForGRU(
   init_ztensor(&pre_tfrmd_desc, &tfrmd_desc, &ztensor);
   status = allochelper_ztensor_alloc(&ztensor);
   assert(status == ZDNN_OK);
-  status =
-      stickify(&ztensor, rawZData.data(), rawRData.data(), rawHData.data());
+  // stickify only reads the input buffers.
+  status = stickify(&ztensor, const_cast<char *>(rawZData.data()),
+      const_cast<char *>(rawRData.data()), const_cast<char *>(rawHData.data()));
   assert(status == ZDNN_OK);
   // Emit a constant global in ZHigh dialect.
   ZHighStickifiedConstantOp constantOp = emitZHighStickifiedConstant(
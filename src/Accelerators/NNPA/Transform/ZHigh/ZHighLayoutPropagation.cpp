@@ -200,6 +200,12 @@ public:
         (ALayout != BLayout))
       return failure();
 
+    // The CPU lowering for element-wise ops on stickified data does not
+    // support broadcasting, so only propagate the layout when both inputs
+    // have the same shape.
+    if (zTensorAType != zTensorBType)
+      return failure();
+
     // Construct the zTensor type from the output CPU tensor.
     Type zOutputType = getZTensorType(rewriter, loc, output,
         convertZTensorDataLayoutToStringAttr(rewriter, ALayout));
@@ -339,23 +345,24 @@ struct ZHighLayoutPropagationPass
     // Layout propagation for ZHigh Ops.
     populateWithGenerated(patterns);
 
-    // Layout propagation for ONNX Ops. Since DLFLOAT16 is not supported in
-    // LLVM, we disable computation operators like Add, Div, etc. and enable
-    // only data movement operators like Concat.
+    // Layout propagation for ONNX Ops. Computation operators like Add, Div,
+    // etc. are kept in stickified layout thanks to the DLFLOAT16-aware CPU
+    // lowering of ONNX operations on zTensors (see ZHighToZLow), next to data
+    // movement operators like Concat.
 
     // Add
-    // patterns.insert<ONNXBinaryOpLayoutPropPattern<ONNXAddOp>>(&getContext());
+    patterns.insert<ONNXBinaryOpLayoutPropPattern<ONNXAddOp>>(&getContext());
     // Div
-    // patterns.insert<ONNXBinaryOpLayoutPropPattern<ONNXDivOp>>(&getContext());
+    patterns.insert<ONNXBinaryOpLayoutPropPattern<ONNXDivOp>>(&getContext());
     // Mul
-    // patterns.insert<ONNXBinaryOpLayoutPropPattern<ONNXMulOp>>(&getContext());
+    patterns.insert<ONNXBinaryOpLayoutPropPattern<ONNXMulOp>>(&getContext());
     // Sub
-    // patterns.insert<ONNXBinaryOpLayoutPropPattern<ONNXSubOp>>(&getContext());
+    patterns.insert<ONNXBinaryOpLayoutPropPattern<ONNXSubOp>>(&getContext());
     // Reciprocal
-    // patterns.insert<ONNXUnaryOpLayoutPropPattern<ONNXReciprocalOp>>(
-    //     &getContext());
+    patterns.insert<ONNXUnaryOpLayoutPropPattern<ONNXReciprocalOp>>(
+        &getContext());
     // Sqrt
-    // patterns.insert<ONNXUnaryOpLayoutPropPattern<ONNXSqrtOp>>(&getContext());
+    patterns.insert<ONNXUnaryOpLayoutPropPattern<ONNXSqrtOp>>(&getContext());
 
     // Concat
     patterns.insert<ONNXConcatLayoutPropagatePattern>(&getContext());
@@ -12,6 +12,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/IR/AsmState.h"
+#include "mlir/IR/DialectResourceBlobManager.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -200,6 +202,60 @@ mlir::DenseElementsAttr createDenseElmAttr(mlir::ShapedType tensorType,
   }
 }
 
+// Returns true if 'tp' stores its data in an external file in a layout that
+// can back a resource blob directly: raw little-endian bytes with the
+// element's natural width. BOOL and STRING data need per-element conversion,
+// and big-endian hosts must byte swap, so those cases take the copying path.
+bool canMmapExternalData(const onnx::TensorProto &tp) {
+  if (!(tp.has_data_location() &&
+          tp.data_location() == onnx::TensorProto::EXTERNAL))
+    return false;
+  if (llvm::support::endian::system_endianness() !=
+      llvm::support::endianness::little)
+    return false;
+  switch (tp.data_type()) {
+  case onnx::TensorProto::FLOAT16:
+  case onnx::TensorProto::BFLOAT16:
+  case onnx::TensorProto::FLOAT:
+  case onnx::TensorProto::DOUBLE:
+  case onnx::TensorProto::INT8:
+  case onnx::TensorProto::UINT8:
+  case onnx::TensorProto::INT16:
+  case onnx::TensorProto::UINT16:
+  case onnx::TensorProto::INT32:
+  case onnx::TensorProto::UINT32:
+  case onnx::TensorProto::INT64:
+  case onnx::TensorProto::UINT64:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Returns an ElementsAttr whose data is backed by the memory-mapped external
+// data file instead of a copy in the context. The blob's deleter keeps the
+// mapping alive for the lifetime of the attribute, so initializer pages are
+// only read from disk when the data is actually accessed. Returns nullptr if
+// the mapped slice is not suitably aligned for the element type.
+mlir::ElementsAttr createElmAttrFromMmapExternalData(
+    mlir::ShapedType tensorType, const onnx::TensorProto &tp,
+    const std::string &externalDataDir) {
+  std::unique_ptr<llvm::MemoryBuffer> externalData =
+      readExternalData(externalDataDir, tp);
+  llvm::StringRef buffer = externalData->getBuffer();
+  size_t align =
+      std::max<size_t>(tensorType.getElementType().getIntOrFloatBitWidth(), 8) /
+      8;
+  if (reinterpret_cast<uintptr_t>(buffer.data()) % align != 0)
+    return nullptr;
+  llvm::MemoryBuffer *mappedData = externalData.release();
+  mlir::AsmResourceBlob blob(llvm::makeArrayRef(buffer.data(), buffer.size()),
+      align, [mappedData](void *, size_t, size_t) { delete mappedData; },
+      /*dataIsMutable=*/false);
+  return mlir::DenseResourceElementsAttr::get(
+      tensorType, tp.name(), std::move(blob));
+}
+
 mlir::DenseElementsAttr createDenseStringElmAttr(
     mlir::ShapedType tensorType, const onnx::TensorProto &tp) {
   // The string type is different from other data types in that it cannot be
@@ -216,19 +272,41 @@ mlir::DenseElementsAttr createDenseStringElmAttr(
 
 namespace onnx_mlir {
 
-mlir::Value EmitInitializerForInputTensor(mlir::Location loc,
-    mlir::OpBuilder &builder, const std::string &externalDataDir,
+mlir::ElementsAttr onnxTensorProtoToElmAttr(mlir::MLIRContext *context,
+    const std::string &externalDataDir, bool mmapExternalData,
     const onnx::TensorProto &initializer) {
-  // Return none if the initializer is an empty tensor, e.g tensor<0xf32>.
+  // Return null if the initializer is an empty tensor, e.g tensor<0xf32>;
+  // the caller materializes it as a none value.
   llvm::ArrayRef<int64_t> tensorDims(
       initializer.dims().data(), initializer.dims().size());
   if (tensorDims.size() == 1 && tensorDims[0] == 0)
+    return nullptr;
+
+  mlir::OpBuilder builder(context);
+
+  // Stream external data directly from the memory-mapped data file when
+  // possible, instead of copying it into the context.
+  if (mmapExternalData && canMmapExternalData(initializer)) {
+    mlir::Type elmType = convertONNXTypeToMLIRType(
+        builder, (onnx::TensorProto_DataType)initializer.data_type());
+    auto tensorType = mlir::RankedTensorType::get(tensorDims, elmType);
+    if (mlir::ElementsAttr resourceElmAttr = createElmAttrFromMmapExternalData(
+            tensorType, initializer, externalDataDir))
+      return resourceElmAttr;
+  }
+
+  return onnxTensorProtoToDenseElmAttr(builder, externalDataDir, initializer);
+}
+
+mlir::Value EmitInitializerForInputTensor(mlir::Location loc,
+    mlir::OpBuilder &builder, const std::string &externalDataDir,
+    bool mmapExternalData, const onnx::TensorProto &initializer) {
+  mlir::ElementsAttr elmAttr = onnxTensorProtoToElmAttr(
+      builder.getContext(), externalDataDir, mmapExternalData, initializer);
+  if (!elmAttr)
     return builder.create<mlir::ONNXNoneOp>(
         loc, builder.getNoneType(), builder.getUnitAttr());
-
-  mlir::DenseElementsAttr denseElmAttr =
-      onnxTensorProtoToDenseElmAttr(builder, externalDataDir, initializer);
-  return builder.create<mlir::ONNXConstantOp>(loc, nullptr, denseElmAttr);
+  return builder.create<mlir::ONNXConstantOp>(loc, nullptr, elmAttr);
 }
 
 mlir::DenseElementsAttr onnxTensorProtoToDenseElmAttr(mlir::OpBuilder &builder,
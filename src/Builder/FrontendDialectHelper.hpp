@@ -23,6 +23,14 @@ namespace onnx_mlir {
 
 mlir::Value EmitInitializerForInputTensor(mlir::Location loc,
     mlir::OpBuilder &builder, const std::string &externalDataDir,
+    bool mmapExternalData, const onnx::TensorProto &initializer);
+
+// Convert an initializer into the elements attribute holding its payload,
+// or null for an empty tensor (imported as a none value). Only attributes
+// and types are created, through the context's thread-safe uniquer, so
+// distinct initializers may be converted concurrently.
+mlir::ElementsAttr onnxTensorProtoToElmAttr(mlir::MLIRContext *context,
+    const std::string &externalDataDir, bool mmapExternalData,
     const onnx::TensorProto &initializer);
 
 mlir::DenseElementsAttr onnxTensorProtoToDenseElmAttr(mlir::OpBuilder &builder,
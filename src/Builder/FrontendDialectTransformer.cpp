@@ -20,10 +20,14 @@
 
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/FileUtilities.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 
 #include "include/onnx-mlir/Compiler/OMCompilerTypes.h"
 #include "src/Builder/FrontendDialectTransformer.hpp"
@@ -77,6 +81,7 @@ public:
       const onnx::ModelProto &model, ImportOptions options) {
     options_ = options;
     modelInputShaper_.setShapeInformation(options_.shapeInformation);
+    modelInputShaper_.setShapeContracts(options_.shapeContracts);
     SetOpSetImport(model); // Determines which opsets to use.
     importGraph(model.graph());
     return module_;
@@ -101,7 +106,9 @@ private:
   using ImportHandlerType = void (onnx_mlir::detail::FrontendGenImpl::*)(
       const onnx::NodeProto &);
 
-  std::map<std::string, ImportHandlerType> import_handler_map_;
+  // Consulted once per node; a hash map keeps the per-node dispatch cost
+  // constant on large graphs.
+  std::unordered_map<std::string, ImportHandlerType> import_handler_map_;
 
   Location UnknownLoc() const { return UnknownLoc::get(&context_); }
 
@@ -136,11 +143,6 @@ private:
     return *valuePtr;
   }
 
-  Value ImportTensor(const onnx::TensorProto &tensor) {
-    return EmitInitializerForInputTensor(
-        UnknownLoc(), builder_, options_.externalDataDir, tensor);
-  }
-
   /*!
    * Import an onnx tensor type by determining and returning its type
    * @param type_proto onnx tensor TypeProto.
@@ -315,9 +317,30 @@ private:
     Block *entryBlock = &region.back();
 
     // Maintain a mapping between the parameter and its initializer.
+    // Converting an initializer hashes and uniques its whole payload, which
+    // for the weights of a large model dominates import time, and the
+    // conversions are independent of each other: run them on the context's
+    // thread pool and create the constant operations afterwards, in graph
+    // order, so the imported module is identical to that of a serial import.
+    const auto &initializers = graph.initializer();
+    std::vector<ElementsAttr> initializerAttrs(initializers.size());
+    mlir::parallelFor(&context_, 0, initializers.size(), [&](size_t i) {
+      initializerAttrs[i] = onnxTensorProtoToElmAttr(&context_,
+          options_.externalDataDir, options_.mmapExternalData,
+          initializers[i]);
+    });
     std::unordered_set<std::string> initializerNames;
-    for (const auto &initializer : graph.initializer()) {
-      BindOnnxName(initializer.name(), ImportTensor(initializer));
+    for (int i = 0, e = initializers.size(); i < e; ++i) {
+      const onnx::TensorProto &initializer = initializers[i];
+      Value initializerValue;
+      if (ElementsAttr elmAttr = initializerAttrs[i])
+        initializerValue =
+            builder_.create<ONNXConstantOp>(UnknownLoc(), nullptr, elmAttr);
+      else
+        // An empty tensor, e.g. tensor<0xf32>, is imported as a none value.
+        initializerValue = builder_.create<ONNXNoneOp>(
+            UnknownLoc(), builder_.getNoneType(), builder_.getUnitAttr());
+      BindOnnxName(initializer.name(), initializerValue);
       initializerNames.insert(initializer.name());
     }
 
@@ -1160,15 +1183,245 @@ private:
         /*op=*/mainFunc.getOperation(), /*useStdReturn=*/true);
     mainFunc.setType(funcType);
 
+    // Record the user shape contracts as argument attributes so that
+    // lowering can assume the promised bounds and divisibility for dynamic
+    // dimensions.
+    annotateShapeContracts(mainFunc);
+
+    // Drop the outputs not selected with --prune-outputs, so that the entry
+    // point below and all clones see the reduced signature.
+    pruneUnselectedOutputs(mainFunc);
+
     // Emit entry point op describing inference function signature.
     auto entryPoint = ONNXEntryPointOp::create(UnknownLoc(), mainFunc);
     module_.push_back(entryPoint);
 
+    // Emit shape-specialized clones of the main graph, each with its own
+    // entry point.
+    importSpecializedGraphs(mainFunc);
+
+    // Emit per-output clones of the main graph for lazy output execution.
+    importPerOutputGraphs(mainFunc);
+
     return mainFunc;
   }
+
+  /*!
+   * Attach the user shape contracts (ImportOptions::shapeContracts) to the
+   * main graph arguments as onnx.dim_ub and onnx.dim_mult I64ArrayAttr
+   * argument attributes, one entry per dimension (-1 resp. 1 where nothing
+   * is promised). Lowering reads them back through
+   * getContractDimUpperBound/getContractDimMultiple.
+   * @param mainFunc the generic main graph function.
+   */
+  void annotateShapeContracts(func::FuncOp mainFunc) {
+    for (unsigned int i = 0; i < mainFunc.getNumArguments(); ++i) {
+      const std::map<int64_t, DimContract> &contracts =
+          modelInputShaper_.getShapeContracts(i);
+      if (contracts.empty())
+        continue;
+      auto tensorTy =
+          mainFunc.getArgument(i).getType().dyn_cast<RankedTensorType>();
+      if (!tensorTy)
+        continue;
+      int64_t rank = tensorTy.getRank();
+      llvm::SmallVector<int64_t, 4> upperBounds(rank, -1);
+      llvm::SmallVector<int64_t, 4> multiples(rank, 1);
+      for (const auto &dimContract : contracts) {
+        int64_t dimIndex = dimContract.first;
+        assert(dimIndex < rank && "contract dim index exceeds input rank");
+        upperBounds[dimIndex] = dimContract.second.upperBound;
+        multiples[dimIndex] = dimContract.second.multiple;
+      }
+      mainFunc.setArgAttr(
+          i, "onnx.dim_ub", builder_.getI64ArrayAttr(upperBounds));
+      mainFunc.setArgAttr(
+          i, "onnx.dim_mult", builder_.getI64ArrayAttr(multiples));
+    }
+  }
+
+  /*!
+   * Keep only the graph outputs selected with --prune-outputs, dropping the
+   * other return values from the main graph and shrinking its function type
+   * and output_names accordingly. The ops feeding only dropped outputs
+   * become dead and are erased by the ONNX-level canonicalizer, since all
+   * ONNX operations are side-effect free. Unknown names and selections that
+   * would leave the model without outputs are diagnosed and ignored. Must
+   * run before the entry point op and the graph clones are created so that
+   * all of them see the reduced signature.
+   * @param mainFunc the generic main graph function.
+   */
+  void pruneUnselectedOutputs(func::FuncOp mainFunc) {
+    if (options_.pruneOutputs.empty())
+      return;
+    llvm::SmallVector<llvm::StringRef, 4> selected;
+    llvm::StringRef(options_.pruneOutputs)
+        .split(selected, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    auto outputNames = mainFunc->getAttrOfType<ArrayAttr>("output_names");
+    auto nameAt = [&outputNames](int64_t i) {
+      return outputNames[i].cast<StringAttr>().getValue();
+    };
+    // Keep the selected outputs in their original order.
+    llvm::SmallVector<int64_t, 4> keptIndices;
+    for (int64_t i = 0; i < (int64_t)outputNames.size(); ++i)
+      if (llvm::is_contained(selected, nameAt(i)))
+        keptIndices.push_back(i);
+    for (llvm::StringRef name : selected) {
+      bool known = false;
+      for (int64_t i = 0; i < (int64_t)outputNames.size(); ++i)
+        known |= (nameAt(i) == name);
+      if (!known)
+        llvm::errs() << "Warning: --prune-outputs selects unknown output '"
+                     << name << "'.\n";
+    }
+    if (keptIndices.empty()) {
+      llvm::errs() << "Warning: --prune-outputs selects none of the model "
+                      "outputs; keeping all outputs.\n";
+      return;
+    }
+    if (keptIndices.size() == outputNames.size())
+      return;
+    Operation *returnOp = mainFunc.getBody().back().getTerminator();
+    llvm::SmallVector<Value, 4> keptValues;
+    llvm::SmallVector<Type, 4> keptTypes;
+    llvm::SmallVector<Attribute, 4> keptNames;
+    for (int64_t i : keptIndices) {
+      keptValues.push_back(returnOp->getOperand(i));
+      keptTypes.push_back(returnOp->getOperand(i).getType());
+      keptNames.push_back(outputNames[i]);
+    }
+    returnOp->setOperands(keptValues);
+    mainFunc.setType(builder_.getFunctionType(
+        mainFunc.getFunctionType().getInputs(), keptTypes));
+    mainFunc->setAttr("output_names", builder_.getArrayAttr(keptNames));
+  }
+
+  /*!
+   * Emit one clone of the main graph per user-declared shape
+   * specialization. Each clone gets the specialized input types and its own
+   * entry point run_main_graph_s<N>; the shape inference pass then
+   * propagates the static shapes through the clone's body, so each clone is
+   * optimized as if the model had been compiled with those static shapes.
+   * @param mainFunc the generic main graph function.
+   */
+  void importSpecializedGraphs(func::FuncOp mainFunc) {
+    if (options_.specializedShapes.empty())
+      return;
+    std::stringstream specsString(options_.specializedShapes);
+    std::string spec;
+    int index = 0;
+    while (std::getline(specsString, spec, ';')) {
+      ModelInputShaper specShaper;
+      specShaper.setShapeInformation(spec);
+      func::FuncOp specFunc = mainFunc.clone();
+      specFunc.setName("main_graph_s" + std::to_string(index));
+      llvm::SmallVector<Type, 4> argTypes;
+      for (unsigned int i = 0; i < specFunc.getNumArguments(); ++i) {
+        Type argType = specShaper.reshape(i, specFunc.getArgument(i).getType());
+        specFunc.getArgument(i).setType(argType);
+        argTypes.emplace_back(argType);
+      }
+      specFunc.setType(builder_.getFunctionType(
+          argTypes, specFunc.getFunctionType().getResults()));
+      module_.push_back(specFunc);
+      auto specEntryPoint = ONNXEntryPointOp::create(UnknownLoc(), specFunc);
+      module_.push_back(specEntryPoint);
+      ++index;
+    }
+  }
+
+  /*!
+   * Emit one clone of the main graph per output, each returning only that
+   * output, with its own entry point run_main_graph_o<N>. The dead code
+   * elimination running during lowering prunes each clone down to the
+   * backward slice of its output, so a clone computes only what its output
+   * needs. The runtime's lazy execution mode (ExecutionSession::runLazy)
+   * invokes a clone on first access to its output and never runs the clones
+   * of outputs that are not accessed.
+   * @param mainFunc the generic main graph function.
+   */
+  void importPerOutputGraphs(func::FuncOp mainFunc) {
+    if (!options_.lazyOutputs)
+      return;
+    unsigned numResults = mainFunc.getFunctionType().getNumResults();
+    // With a single output the main graph is its own backward slice.
+    if (numResults <= 1)
+      return;
+    for (unsigned index = 0; index < numResults; ++index) {
+      func::FuncOp outFunc = mainFunc.clone();
+      outFunc.setName("main_graph_o" + std::to_string(index));
+      Operation *returnOp = outFunc.getBody().back().getTerminator();
+      Value kept = returnOp->getOperand(index);
+      returnOp->setOperands(kept);
+      outFunc.setType(builder_.getFunctionType(
+          outFunc.getFunctionType().getInputs(), {kept.getType()}));
+      module_.push_back(outFunc);
+      auto outEntryPoint = ONNXEntryPointOp::create(UnknownLoc(), outFunc);
+      module_.push_back(outEntryPoint);
+    }
+  }
 }; // class FrontendGenImpl
 } // namespace detail
 } // namespace onnx_mlir
+namespace {
+
+// Persistent cache of version-lifted models. Lifting a model to
+// CURRENT_ONNX_OPSET is a pure protobuf-to-protobuf transformation of the
+// input bytes, so the lifted model can be cached keyed on a hash of the
+// serialized input and the target opset and reused whenever the same model
+// is imported again. Entries are best effort: a missing or unreadable entry
+// simply means the converter runs.
+
+// Return the path of the cache entry for lifting the given serialized model.
+std::string versionLiftCachePath(
+    const std::string &cacheDir, const std::string &serializedModel) {
+  llvm::MD5 hasher;
+  hasher.update(serializedModel);
+  hasher.update(llvm::StringRef("\0", 1));
+  hasher.update(std::to_string(CURRENT_ONNX_OPSET));
+  llvm::MD5::MD5Result result;
+  hasher.final(result);
+  llvm::SmallString<128> path(cacheDir);
+  llvm::sys::path::append(path, result.digest() + ".verlift.onnx");
+  return std::string(path.str());
+}
+
+// Parse a cached lifted model. Return true on a hit; a stale or truncated
+// entry fails the protobuf parse and counts as a miss.
+bool lookupVersionLiftCache(
+    const std::string &cachePath, onnx::ModelProto &liftedModel) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(cachePath);
+  if (!buffer)
+    return false;
+  return liftedModel.ParseFromArray(
+      (*buffer)->getBufferStart(), (*buffer)->getBufferSize());
+}
+
+// Store a freshly lifted model into the cache. The write goes through a
+// unique temporary name and a rename so that concurrent imports never
+// observe a half-written entry; failures are silently ignored.
+void updateVersionLiftCache(const std::string &cacheDir,
+    const std::string &cachePath, const onnx::ModelProto &liftedModel) {
+  if (llvm::sys::fs::create_directories(cacheDir))
+    return;
+  llvm::SmallString<128> tmpPath;
+  if (llvm::sys::fs::createUniqueFile(cachePath + ".tmp.%%%%%%", tmpPath))
+    return;
+  {
+    std::ofstream output(std::string(tmpPath.str()),
+        std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!output.is_open() || !liftedModel.SerializeToOstream(&output)) {
+      llvm::sys::fs::remove(tmpPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(tmpPath, cachePath))
+    llvm::sys::fs::remove(tmpPath);
+}
+
+} // namespace
+
 namespace onnx_mlir {
 
 bool ImportFrontendModelInternal(onnx::ModelProto &model, MLIRContext &context,
@@ -1194,8 +1447,24 @@ bool ImportFrontendModelInternal(onnx::ModelProto &model, MLIRContext &context,
   // Did not do downward convert because support for BatchNorm is missing
   if (options.invokeOnnxVersionConverter &&
       originVersion < CURRENT_ONNX_OPSET) {
-    onnx::ModelProto convertModel =
-        onnx::version_conversion::ConvertVersion(model, CURRENT_ONNX_OPSET);
+    // The lifted model may be cached from an earlier import of the same
+    // model bytes; hash after the sort above so both entry paths key on the
+    // same serialization.
+    onnx::ModelProto convertModel;
+    std::string cachePath;
+    bool cacheHit = false;
+    if (!options.versionCacheDir.empty()) {
+      cachePath = versionLiftCachePath(
+          options.versionCacheDir, model.SerializeAsString());
+      cacheHit = lookupVersionLiftCache(cachePath, convertModel);
+    }
+    if (!cacheHit) {
+      convertModel =
+          onnx::version_conversion::ConvertVersion(model, CURRENT_ONNX_OPSET);
+      if (!cachePath.empty())
+        updateVersionLiftCache(
+            options.versionCacheDir, cachePath, convertModel);
+    }
     if (options.useOnnxModelTypes)
       onnx::shape_inference::InferShapes(convertModel);
     ImportFrontendModel(convertModel, context, module, options);
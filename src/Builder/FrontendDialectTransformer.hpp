@@ -53,9 +53,49 @@ struct ImportOptions {
   //   - (arg0: tensor<3x4x5xf32>, arg1: tensor<10x5xf32>)
   //
   std::string shapeInformation = "";
+  // Shape contracts for dynamic graph input dimensions, i.e. invariants the
+  // caller guarantees at runtime without making the dimensions static.
+  // Its format is 'input_id:dim<=N,input_id:dim%N,...' where 'dim<=N' bounds
+  // dimension dim by N and 'dim%N' promises it is a multiple of N. The
+  // contracts are recorded as onnx.dim_ub / onnx.dim_mult argument
+  // attributes on the main graph so that lowering can pick tiling and
+  // vectorization schedules that would otherwise require static shapes.
+  std::string shapeContracts = "";
+  // Shape-specialized clones of the main graph. Each semicolon-separated
+  // entry uses the shapeInformation format and produces an additional copy
+  // of the main graph whose inputs are reshaped accordingly, with its own
+  // entry point named run_main_graph_s<N>. E.g.
+  //   - specializedShapes = '0:1x3x224x224;0:8x3x224x224'
+  // adds two clones specialized for batch 1 and batch 8 next to the generic
+  // main graph. The runtime dispatches to a clone when the actual input
+  // shapes match its static shapes.
+  std::string specializedShapes = "";
+  // Emit one pruned clone of the main graph per output, with entry points
+  // named run_main_graph_o<N>. Each clone returns only its output and is
+  // reduced to that output's backward slice during lowering. Used by the
+  // runtime's lazy execution mode, which computes an output on first access
+  // and skips the outputs a request never reads.
+  bool lazyOutputs = false;
+  // Comma-separated names of the graph outputs to keep. When non-empty, the
+  // other outputs are dropped from the main graph and the entry signature,
+  // and the ops feeding only dropped outputs become dead and are removed by
+  // the ONNX-level canonicalizer. Lets models exported with training-only
+  // outputs or debug heads compile down to the inference subgraph.
+  std::string pruneOutputs = "";
   // Directory to look for external data if any tensor has external
   // data location. If empty then external data is disabled.
   std::string externalDataDir = "";
+  // Directory of the persistent cache for version-lifted models. When set
+  // and the version converter is invoked, the lifted ModelProto is stored
+  // keyed on a hash of the input model and reused on later imports of the
+  // same model, skipping the protobuf-to-protobuf opset conversion. Empty
+  // disables the cache.
+  std::string versionCacheDir = "";
+  // Import initializers with external data location as resource attributes
+  // backed by the memory-mapped data file, instead of copying their data into
+  // the model. Keeps importer memory usage proportional to the in-model
+  // tensors only.
+  bool mmapExternalData = false;
 };
 
 /*!
@@ -75,6 +75,46 @@ void ModelInputShaper::setShapeInformation(
   }
 }
 
+void ModelInputShaper::setShapeContracts(const std::string &shapeContracts) {
+  if (!shapeContracts.empty()) {
+    std::stringstream contractsString(shapeContracts);
+    std::string contractString;
+    while (std::getline(contractsString, contractString, ',')) {
+      size_t pos = contractString.find(':');
+      assert(pos != std::string::npos && "expected input_id:constraint");
+      int64_t inputID = std::stoi(contractString.substr(0, pos));
+      assert(inputID >= 0 && "input_id must be >= 0");
+      std::string constraint = contractString.substr(pos + 1);
+
+      // A constraint is either DIM<=N (upper bound) or DIM%N (divisibility).
+      size_t opPos;
+      bool isUpperBound = (opPos = constraint.find("<=")) != std::string::npos;
+      if (!isUpperBound) {
+        opPos = constraint.find('%');
+        assert(opPos != std::string::npos && "expected DIM<=N or DIM%N");
+      }
+      int64_t dimIndex = std::stoi(constraint.substr(0, opPos));
+      assert(dimIndex >= 0 && "dim index must be >= 0");
+      int64_t bound =
+          std::stoi(constraint.substr(opPos + (isUpperBound ? 2 : 1)));
+      assert(bound > 0 && "contract value must be > 0");
+
+      DimContract &contract = inputs_shape_contracts_[inputID][dimIndex];
+      if (isUpperBound)
+        contract.upperBound = bound;
+      else
+        contract.multiple = bound;
+    }
+  }
+}
+
+const std::map<int64_t, DimContract> &ModelInputShaper::getShapeContracts(
+    int inputIndex) const {
+  static const std::map<int64_t, DimContract> empty;
+  auto it = inputs_shape_contracts_.find(inputIndex);
+  return it == inputs_shape_contracts_.end() ? empty : it->second;
+}
+
 namespace {
 RankedTensorType forceShape(
     RankedTensorType tensorTy, const std::vector<int> &forcedDims) {
@@ -54,6 +54,15 @@ namespace onnx_mlir {
 //    and
 //    - change the first and second dimensions in the second input to unknown
 //    dimensions
+// Per-dimension constraints from a user shape contract. upperBound is the
+// largest value the dimension takes at runtime (-1 when unconstrained);
+// multiple is a value the dimension is always divisible by (1 when
+// unconstrained).
+struct DimContract {
+  int64_t upperBound = -1;
+  int64_t multiple = 1;
+};
+
 class ModelInputShaper {
 public:
   ModelInputShaper();
@@ -63,6 +72,15 @@ public:
   // See the documentation of the shapeInformation flag in CompilerOptions.cpp.
   void setShapeInformation(const std::string &shapeInformation);
 
+  // shapeContracts specifies invariants on dynamic input dimensions that the
+  // caller guarantees at runtime, without making the dimensions static.
+  // See the documentation of the shapeContracts flag in CompilerOptions.cpp.
+  void setShapeContracts(const std::string &shapeContracts);
+
+  // Returns the contracts of the given input, keyed by dimension index.
+  // Empty when the input has no contract.
+  const std::map<int64_t, DimContract> &getShapeContracts(int inputIndex) const;
+
   // Takes the input type at the given input index and
   // returns the input type with any changes to the shape specified by
   // the environment variable IMPORTER_FORCE_DYNAMIC
@@ -79,6 +97,10 @@ private:
 
   // Custom shape information for the graph inputs.
   std::map<int64_t, std::vector<int64_t>> inputs_shape_information_;
+
+  // Shape contracts for the graph inputs, keyed by input index and then by
+  // dimension index.
+  std::map<int64_t, std::map<int64_t, DimContract>> inputs_shape_contracts_;
 };
 
 } // namespace onnx_mlir
@@ -75,6 +75,77 @@ llvm::cl::opt<std::string> shapeInformation("shapeInformation",
         "unknown dimensions)"),
     llvm::cl::value_desc("value"), llvm::cl::cat(OnnxMlirOptions));
 
+llvm::cl::opt<std::string> shapeContracts("shapeContracts",
+    llvm::cl::desc(
+        "Invariants the caller guarantees for dynamic input dimensions, "
+        "without\nmaking them static.\n"
+        "\"value\" is in the format of "
+        "\"INPUT_ID:DIM<=N,INPUT_ID:DIM%N, ...\",\n"
+        "where \"INPUT_ID\" is an input index starting from 0, \"DIM\" a "
+        "dimension\nindex, \"DIM<=N\" bounds the dimension by N, and "
+        "\"DIM%N\" promises it is\na multiple of N. E.g. "
+        "\"0:0<=64,0:1%8\" for batch <= 64 and sequence\nlength a multiple "
+        "of 8. The compiler uses the contracts to pick tiling\nand "
+        "vectorization schedules that would otherwise require static "
+        "shapes;\ninputs violating a contract are undefined behavior."),
+    llvm::cl::value_desc("value"), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> specializedShapes("specialized-shapes",
+    llvm::cl::desc(
+        "Compile additional shape-specialized versions of the model next to "
+        "the generic one.\n"
+        "\"value\" is a list of shapeInformation strings separated by ';', "
+        "e.g.\n"
+        "\"0:1x3x224x224;0:8x3x224x224\" adds versions specialized for batch "
+        "1 and 8.\n"
+        "Each version gets its own entry point run_main_graph_s<N>, and the "
+        "runtime\n"
+        "dispatches to the version whose static shapes match the actual "
+        "inputs,\n"
+        "falling back to the generic model. Note that model constants are "
+        "duplicated\n"
+        "into every version."),
+    llvm::cl::value_desc("value"), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> shapeProfileFile("shape-profile",
+    llvm::cl::desc(
+        "Shape profile recorded at run time (see "
+        "ExecutionSession::shapeProfileDump),\n"
+        "one '<count> <shapeInformation string>' entry per line. The "
+        "dominant recorded\nshapes (at most 4, each covering at least 5% of "
+        "the recorded runs) are\ncompiled as shape-specialized versions next "
+        "to the generic model, exactly as\nif they had been listed in "
+        "--specialized-shapes: the runtime dispatches to a\nversion when the "
+        "actual shapes match, with the generic path as fallback.\nStatic-"
+        "shape speed for the shapes a deployment actually sees, without\n"
+        "per-model configuration."),
+    llvm::cl::init(""), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> lazyOutputs("lazy-outputs",
+    llvm::cl::desc(
+        "Compile one pruned version of the model per output next to the "
+        "generic one\n"
+        "(default=false). Each version (entry point run_main_graph_o<N>) "
+        "computes only\n"
+        "the backward slice of its output. The runtime's lazy execution mode "
+        "then\n"
+        "computes an output on first access and skips outputs a request never "
+        "reads.\n"
+        "Note that model constants are duplicated into every version."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> pruneOutputs("prune-outputs",
+    llvm::cl::desc(
+        "Comma-separated names of the model outputs to keep (default=keep "
+        "all).\n"
+        "The other outputs are dropped from the entry signature and the "
+        "subgraphs\n"
+        "feeding only them are dead-code-eliminated, so models exported with\n"
+        "training-only outputs or debug heads compile down to the inference\n"
+        "subgraph."),
+    llvm::cl::value_desc("value"), llvm::cl::init(""),
+    llvm::cl::cat(OnnxMlirOptions));
+
 llvm::cl::opt<std::string> customEnvFlags("customEnvFlags",
     llvm::cl::desc("Override default option env var OnnxMlirEnvOptionName: "
                    "ONNX_MLIR_FLAGS"),
@@ -95,6 +166,20 @@ llvm::cl::opt<std::string> march("march",
     llvm::cl::value_desc("Target a specific architecture type"),
     llvm::cl::cat(OnnxMlirOptions), llvm::cl::ValueRequired);
 
+llvm::cl::list<std::string> mcpuVariants("mcpu-variants",
+    llvm::cl::desc(
+        "Additionally compile the model for the listed cpus and pick the\n"
+        "first variant the machine supports when the compiled library is\n"
+        "loaded. Each entry is 'cpu' or 'cpu=feature' where 'cpu' is a value\n"
+        "accepted by -mcpu and 'feature' is the __builtin_cpu_supports()\n"
+        "feature that gates the variant (without it the cpu model must match\n"
+        "exactly). The code compiled for -mcpu (or the default cpu) is the\n"
+        "fallback. Load-time selection is only implemented for x86; other\n"
+        "machines use the fallback. Only applies when emitting a library or\n"
+        "a jar."),
+    llvm::cl::value_desc("cpu[=feature]"), llvm::cl::cat(OnnxMlirOptions),
+    llvm::cl::ValueRequired, llvm::cl::ZeroOrMore, llvm::cl::CommaSeparated);
+
 llvm::cl::list<accel::Accelerator::Kind> maccel("maccel",
     llvm::cl::desc("Specify an accelerator to generate code for"),
     // clang-format off
@@ -105,6 +190,17 @@ llvm::cl::list<accel::Accelerator::Kind> maccel("maccel",
     // clang-format on
     llvm::cl::cat(OnnxMlirCommonOptions), llvm::cl::ValueRequired);
 
+llvm::cl::list<std::string> acceleratorPlugins("accel-plugin",
+    llvm::cl::desc(
+        "Load an accelerator from the given plugin shared library instead "
+        "of\n"
+        "the build-time accelerator list. The library must export the "
+        "plugin\n"
+        "entry points described in src/Accelerators/Accelerator.hpp and be\n"
+        "built against the same onnx-mlir headers as this compiler."),
+    llvm::cl::value_desc("path"), llvm::cl::cat(OnnxMlirCommonOptions),
+    llvm::cl::ValueRequired, llvm::cl::ZeroOrMore, llvm::cl::CommaSeparated);
+
 llvm::cl::opt<bool> VerboseOutput("v", llvm::cl::desc("Use verbose output"),
     llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
 
@@ -163,6 +259,22 @@ llvm::cl::opt<bool> instrumentONNXSignature("instrument-onnx-signature",
     llvm::cl::desc("Instrument ONNX ops to print the type of their inputs"),
     llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
 
+llvm::cl::opt<std::string> profileDataFile("profile-data",
+    llvm::cl::desc(
+        "Profile file produced from an instrumentation trace (see\n"
+        "utils/OMInstrumentTraceReport.py --emit-profile). Measured hot\n"
+        "ops are given aggressive lowering strategies regardless of the\n"
+        "optimization level."),
+    llvm::cl::init(""), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> accumConfigFile("accum-config",
+    llvm::cl::desc(
+        "Config file mapping ops to accumulation types (f16, bf16, f32,\n"
+        "f64), one '<op name> <node name> <type>' entry per line. Matching\n"
+        "reductions and matrix products accumulate in the requested type\n"
+        "instead of the default policy."),
+    llvm::cl::init(""), llvm::cl::cat(OnnxMlirOptions));
+
 llvm::cl::opt<std::string> ONNXOpStats("onnx-op-stats",
     llvm::cl::desc(
         "Report the occurrence frequency of ONNX ops in JSON or TXT format:\n"
@@ -174,10 +286,42 @@ llvm::cl::opt<std::string> ONNXOpStats("onnx-op-stats",
 
 llvm::cl::opt<bool> enableMemoryBundling("enable-memory-bundling",
     llvm::cl::desc(
-        "Enable memory bundling related optimizations (default=false)\n"
+        "Enable memory bundling related optimizations (default=true)\n"
+        "Internal tensors are allocated from bundled memory pools instead\n"
+        "of per-tensor malloc/free calls; dynamically shaped tensors are\n"
+        "bundled into a runtime-sized pool.\n"
         "Set to 'false' if you experience significant compile time."),
+    llvm::cl::init(true), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> staticMemoryPlan("static-memory-plan",
+    llvm::cl::desc(
+        "Pack the buffers of each static memory pool into a single arena\n"
+        "using a whole-graph compile-time memory plan (default=false).\n"
+        "Buffers with disjoint live ranges share arena bytes, so the arena\n"
+        "size is the peak memory of the pool; combine with\n"
+        "--scratch-memory-report to print it and --scratch-memory-limit to\n"
+        "budget against it. Replaces the greedy memory pool optimization;\n"
+        "dynamically shaped pools are left to the runtime as before."),
     llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
 
+llvm::cl::opt<bool> scratchMemoryReport("scratch-memory-report",
+    llvm::cl::desc(
+        "Print a compile-time report of the worst-case scratch (transient)\n"
+        "memory per function (default=false): the total bytes of the\n"
+        "statically shaped allocation sites, plus one symbolic line per\n"
+        "dynamically shaped site giving its static byte factor and dynamic\n"
+        "dimensions."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<int64_t> scratchMemoryLimit("scratch-memory-limit",
+    llvm::cl::desc(
+        "Maximum number of live scratch bytes the compiled model may\n"
+        "allocate (default=0, no limit). Compilation fails when the static\n"
+        "worst case alone exceeds the limit; dynamically shaped allocations\n"
+        "are guarded at runtime and abort with a diagnostic instead of\n"
+        "running the process out of memory."),
+    llvm::cl::init(0), llvm::cl::cat(OnnxMlirOptions));
+
 llvm::cl::opt<int> onnxOpTransformThreshold("onnx-op-transform-threshold",
     llvm::cl::desc(
         "Max iteration for dynamic op transform passes (default=3).\n"
@@ -185,6 +329,13 @@ llvm::cl::opt<int> onnxOpTransformThreshold("onnx-op-transform-threshold",
         "static iteration will be used"),
     llvm::cl::init(3), llvm::cl::cat(OnnxMlirOptions));
 
+llvm::cl::opt<int64_t> onnxOpTransformMaxOps("onnx-op-transform-max-ops",
+    llvm::cl::desc(
+        "Stop the dynamic op transform iteration early when the module\n"
+        "grows beyond this many operations (default=0, no limit). Keeps\n"
+        "compile time bounded on models whose decomposition explodes."),
+    llvm::cl::init(0), llvm::cl::cat(OnnxMlirOptions));
+
 llvm::cl::opt<bool> onnxOpTransformReport("onnx-op-transform-report",
     llvm::cl::desc("Report diagnostic info for op transform passes."),
     llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
@@ -194,6 +345,282 @@ llvm::cl::opt<bool> enableParallel("parallel",
                    "Set to 'true' if you want to enable parallelization."),
     llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
 
+llvm::cl::opt<std::string> parallelSchedule("parallel-schedule",
+    llvm::cl::desc(
+        "Chunk schedule for parallelized loops (default=dynamic)\n"
+        "One of 'static' (one chunk per thread, lowest overhead),\n"
+        "'dynamic' (overpartitioned chunks balanced by work stealing) or\n"
+        "'guided' (decreasing chunks, best for ragged iteration costs).\n"
+        "Only relevant with --parallel; the OM_PARALLEL_SCHEDULE\n"
+        "environment variable overrides the choice at run time."),
+    llvm::cl::init("dynamic"), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> cooperativeYield("cooperative-yield",
+    llvm::cl::desc(
+        "Insert cooperative preemption points at outer loop chunk\n"
+        "boundaries (default=false)\n"
+        "Set to 'true' for a model co-located with a latency-critical one:\n"
+        "a cheap runtime check per chunk lets a higher-priority task run\n"
+        "between chunks instead of waiting for the whole inference."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> f16Weights("f16-weights",
+    llvm::cl::desc(
+        "Store tile-packed f32 weights in half precision (default=false)\n"
+        "Set to 'true' to halve the memory footprint and bandwidth of\n"
+        "constants read only through matmul/gemm tile packing; elements\n"
+        "are widened back to f32 during the pack copy, so compute stays\n"
+        "in f32."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> enableFastElementwise("fast-elementwise",
+    llvm::cl::desc(
+        "Enable vectorized and fused elementwise codegen (default=false)\n"
+        "Set to 'true' to emit SIMD loops over the innermost dimension for\n"
+        "elementwise operations and to fuse chains of elementwise operations\n"
+        "into a single loop nest."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> enableFastConv("fast-conv",
+    llvm::cl::desc(
+        "Enable the im2col+GEMM convolution path (default=false)\n"
+        "Set to 'true' to lower 2-D static-shape convolutions through an\n"
+        "im2col transform followed by the tiled krnl.matmul kernel instead\n"
+        "of the direct loop nest."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> enableFusedAttention("fused-attention",
+    llvm::cl::desc(
+        "Enable fused attention lowering (default=false)\n"
+        "Set to 'true' to lower static-shape MatMul-Softmax-MatMul attention\n"
+        "subgraphs to a single online-softmax kernel that never materializes\n"
+        "the score matrix."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<float> sparseWeightDensity("sparse-weights",
+    llvm::cl::desc(
+        "Density threshold for sparse constant matmul weights (default=0)\n"
+        "Constant 2-D MatMul weights whose fraction of nonzero elements is\n"
+        "below this threshold are stored in CSR form and multiplied with a\n"
+        "sparse-dense kernel. Set to 0 to disable; 0.2 is a good starting\n"
+        "point for heavily pruned models."),
+    llvm::cl::init(0.0f), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> mathLib("math-lib",
+    llvm::cl::desc(
+        "Vector math library for elementary functions (default=builtin)\n"
+        "One of 'builtin' (scalar libm calls), 'libmvec' (glibc's vector\n"
+        "math library), 'mkl' (Intel SVML) or 'accelerate' (Apple\n"
+        "Accelerate). With a vendor library selected, LLVM vectorizes the\n"
+        "loops around the scalar erf/tan/atan/... calls the krnl math\n"
+        "lowering emits against that library's SIMD entry points, and the\n"
+        "model library is linked so the dynamic loader resolves them at\n"
+        "load. The chosen library must be present on the deployment\n"
+        "machine."),
+    llvm::cl::init("builtin"), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<int64_t> l2ResidentCores("l2-resident-cores",
+    llvm::cl::desc(
+        "Partition matmul output columns across this many cores (default=0)\n"
+        "Each core computes its own column slice of the output, and the\n"
+        "schedule is only used when the per-core panel of the weight matrix\n"
+        "fits in half the L2 cache, so it stays resident for the whole\n"
+        "product. Set to the physical core count; 0 disables. Requires\n"
+        "-parallel."),
+    llvm::cl::init(0), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> outlineLoopBodies("outline-loop-bodies",
+    llvm::cl::desc(
+        "Outline structurally identical ONNX Loop/Scan bodies into shared\n"
+        "functions instead of lowering every body inline (default=false)\n"
+        "Set to 'true' for models with many identical loops (e.g. unrolled\n"
+        "decoder layers) to shrink the generated code and compile time."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> OzModel("Oz-model",
+    llvm::cl::desc(
+        "Optimize the generated library for binary size (default=false).\n"
+        "Implies --outline-loop-bodies and additionally merges lowered\n"
+        "functions that are structurally identical, so repetitive layer\n"
+        "stacks share one copy of their code."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<int64_t> tensorParallelRanks("tensor-parallel-ranks",
+    llvm::cl::desc(
+        "Number of ranks in the tensor-parallel device mesh (default=1)\n"
+        "When greater than 1, constant MatMul/Gemm weights are sharded\n"
+        "column-wise across the ranks and the outputs are reassembled with\n"
+        "runtime all-gather collectives. Compile the model once per rank\n"
+        "with -tensor-parallel-rank to emit the per-rank libraries; each\n"
+        "library only embeds its own fraction of the sharded weights."),
+    llvm::cl::init(1), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<int64_t> tensorParallelRank("tensor-parallel-rank",
+    llvm::cl::desc(
+        "Rank whose weight shards this compilation embeds (default=0)\n"
+        "Must be in [0, tensor-parallel-ranks)."),
+    llvm::cl::init(0), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> storeConstantsToFile("store-constants-to-file",
+    llvm::cl::desc(
+        "Write model constants to a separate binary file instead of\n"
+        "embedding them in the generated code (default=false)\n"
+        "Set to 'true' to keep the shared library small for large models;\n"
+        "the constants file is mapped lazily at run time so that weight\n"
+        "pages are read on first touch and shared across processes."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> constantsToFileName("constants-to-file-name",
+    llvm::cl::desc(
+        "Name of the binary file that stores model constants when\n"
+        "-store-constants-to-file is set (default=model.constants.bin)\n"
+        "At run time the file is looked up under the directory given by\n"
+        "the OM_CONSTANT_PATH environment variable when set, and in the\n"
+        "current working directory otherwise."),
+    llvm::cl::init("model.constants.bin"), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> sharedConstantsDir("shared-constants-dir",
+    llvm::cl::desc(
+        "Write model constants to per-constant files named by their\n"
+        "content hash under this directory instead of embedding them\n"
+        "(default=none). Identical weights across separately compiled\n"
+        "models hash to the same file, which is stored once and mapped\n"
+        "read-only at run time, so models sharing a common backbone share\n"
+        "one physical copy of it. Point OM_CONSTANT_PATH at this\n"
+        "directory when running the models."),
+    llvm::cl::init(""), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> approxTranscendentals("approx-transcendentals",
+    llvm::cl::desc(
+        "Lower transcendental functions (erf, exp, tanh, sin, cos) with\n"
+        "vectorizable polynomial approximations instead of scalar libm\n"
+        "calls (default=true). Disable to trade speed for libm-accurate\n"
+        "results."),
+    llvm::cl::init(true), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<int64_t> constantsToFileSingleThreshold(
+    "constants-to-file-single-threshold",
+    llvm::cl::desc(
+        "Minimum size in bytes for a constant to be written to the\n"
+        "constants file when -store-constants-to-file is set\n"
+        "(default=1024). Smaller constants stay embedded."),
+    llvm::cl::init(1024), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> mmapExternalData("mmap-external-data",
+    llvm::cl::desc(
+        "Import ONNX initializers that use external data by memory-mapping\n"
+        "the data file instead of copying their contents into the model\n"
+        "(default=false)\n"
+        "Set to 'true' to keep importer memory usage proportional to the\n"
+        "in-model tensors only; weight pages are then read lazily from the\n"
+        "data file when the compiler first touches them."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> compilationCacheDir("compilation-cache-dir",
+    llvm::cl::desc(
+        "Directory of the persistent compilation cache (default=none)\n"
+        "When set, final artifacts (.so, .o, .jar) are stored in this\n"
+        "directory under a key derived from the imported model, the\n"
+        "compilation options, and the compiler version. A later compile of\n"
+        "the same model with the same options copies the cached artifact\n"
+        "instead of rerunning lowering and codegen. The directory is\n"
+        "created if it does not exist and may be shared between builds.\n"
+        "Per-unit object files are cached as well, keyed on their content:\n"
+        "combined with -codegen-parallel-units, recompiling an edited model\n"
+        "reuses the objects of its unchanged functions and recompiles only\n"
+        "the changed units before relinking. Version-lifted models are also\n"
+        "cached here, keyed on the input model bytes, so reimporting an old\n"
+        "opset model skips the onnx version converter."),
+    llvm::cl::value_desc("path"), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<int> codegenParallelUnits("codegen-parallel-units",
+    llvm::cl::desc(
+        "Number of compilation units the generated LLVM module is split\n"
+        "into for codegen; the units are optimized and compiled to object\n"
+        "files in parallel and linked into the final library (default=1)\n"
+        "Set to 0 to use one unit per hardware thread. Only applies when\n"
+        "emitting a shared library or a jar."),
+    llvm::cl::init(1), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> deferVerification("defer-verification",
+    llvm::cl::desc(
+        "Verify the IR once after the full pass pipeline instead of after\n"
+        "every pass (default=false)\n"
+        "The per-pass verifier re-walks the whole module and becomes a\n"
+        "significant fraction of compile time on graphs with millions of\n"
+        "operations. Invalid IR is still rejected, but diagnostics point at\n"
+        "the end of the pipeline rather than at the offending pass."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> enableRuntimeLTO("runtime-lto",
+    llvm::cl::desc(
+        "Link the bitcode build of the runtime (libcruntime.bc) into the\n"
+        "model bitcode before optimization, so runtime helpers such as the\n"
+        "omTensor accessors are inlined and specialized into the model\n"
+        "library instead of being called across the libcruntime.a boundary\n"
+        "(default=false)\n"
+        "Requires libcruntime.bc next to libcruntime.a; it is built when\n"
+        "onnx-mlir itself is compiled with clang. When the bitcode library\n"
+        "is missing the model is compiled as usual, with a warning."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> smallTensorAllocator("small-tensor-allocator",
+    llvm::cl::desc(
+        "Serve the small function-local temporaries of the generated code\n"
+        "from a size-classed per-thread slab allocator in the runtime\n"
+        "instead of malloc (default=false)\n"
+        "Set to 'true' for models serving many concurrent inference\n"
+        "threads, where contention on the libc allocator locks shows up as\n"
+        "system time. Buffers escaping as model outputs keep using malloc\n"
+        "because they are released by the caller."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> compileStats("compile-stats",
+    llvm::cl::desc(
+        "Report compile-time statistics as JSON on stderr (default=false)\n"
+        "Set to 'true' to record wall time, peak RSS growth and IR size\n"
+        "growth for every pass and for the coarse compilation phases\n"
+        "(import, lowering, llvm-opt, codegen, link). The report is emitted\n"
+        "once at the end of the compilation."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> enablePrefetch("enable-prefetch",
+    llvm::cl::desc(
+        "Insert software prefetches in the innermost generated compute loops "
+        "(default=false)\n"
+        "The prefetch distance is derived from the affine access patterns, "
+        "with one\nprefetch targeting the L1 cache and one the L2 cache."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<bool> enableLoopInterchange("enable-loop-interchange",
+    llvm::cl::desc(
+        "Reorder generated loop nests so that the loop with the smallest\n"
+        "memory stride runs innermost (default=false)\n"
+        "Lowerings iterate in ONNX logical dimension order; when the data\n"
+        "layout disagrees with it (reductions over the axis that is\n"
+        "innermost in memory, transposed or non-canonically strided\n"
+        "operands), interchanging the loops restores unit-stride innermost\n"
+        "access. Nests are only reordered when the access strides say it\n"
+        "helps and the dependences allow it."),
+    llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> unrollFactors("unroll-factors",
+    llvm::cl::desc(
+        "Unroll-and-jam factors for generated kernel loops, as comma\n"
+        "separated category=factor pairs, e.g. 'matmul-i=8,matmul-k=2'.\n"
+        "Categories: matmul-i, matmul-j, matmul-k. A factor of 1 disables\n"
+        "unrolling for the category; unlisted categories keep the built-in\n"
+        "heuristic."),
+    llvm::cl::init(""), llvm::cl::cat(OnnxMlirOptions));
+
+llvm::cl::opt<std::string> unrollConfigFile("unroll-config-file",
+    llvm::cl::desc(
+        "File with per-node unroll-and-jam factors, one\n"
+        "'<onnx_node_name> <category>=<factor>' entry per line ('#' starts\n"
+        "a comment). Lines without a node name set category-wide factors as\n"
+        "with --unroll-factors; per-node entries take precedence."),
+    llvm::cl::init(""), llvm::cl::cat(OnnxMlirOptions));
+
 llvm::cl::opt<bool> enableSimdDataLayout("simd-data-layout",
     llvm::cl::desc("Enable SIMD optimization for convolution (default=false)\n"
                    "Set to 'true' if you want to enable SIMD optimizations."),
@@ -203,7 +630,9 @@ llvm::cl::opt<bool> verifyInputTensors("verifyInputTensors",
     llvm::cl::desc(
         "Verify input tensors whenever the entry point function is called.\n"
         "Data type and shape are verified. Enable this may introduce overhead "
-        "at runtime."),
+        "at runtime.\n"
+        "An unchecked twin entry point (run_main_graph_unchecked) is also "
+        "compiled so that callers can skip the checks on the hot path."),
     llvm::cl::init(false), llvm::cl::cat(OnnxMlirOptions));
 
 llvm::cl::opt<bool> allowSorting("allowSorting",
@@ -426,6 +855,29 @@ void setLLVMOption(const std::string &flag) { mllvm = flag; }
 void clearLLVMOption() { mllvm.clear(); }
 std::string getLLVMOption() { return (mllvm != "") ? mllvm : std::string(); }
 
+// Map the math-lib option onto LLVM's -vector-library flag for the opt and
+// llc invocations, which makes the vectorizer rewrite the scalar libm calls
+// of the krnl math lowering into the library's SIMD entry points. Returns
+// the empty string for 'builtin'; an unknown value is reported once and
+// treated as 'builtin'.
+std::string getVectorLibraryOption() {
+  if (mathLib == "libmvec")
+    return "-vector-library=LIBMVEC-X86";
+  if (mathLib == "mkl")
+    return "-vector-library=SVML";
+  if (mathLib == "accelerate")
+    return "-vector-library=Accelerate";
+  if (mathLib != "" && mathLib != "builtin") {
+    static bool warned = false;
+    if (!warned) {
+      llvm::errs() << "Warning: unknown --math-lib value '" << mathLib
+                   << "', using builtin scalar math.\n";
+      warned = true;
+    }
+  }
+  return "";
+}
+
 // Support for Verbose Option
 void setVerboseOption() { VerboseOutput = true; }
 void clearVerboseOption() { VerboseOutput = false; }
@@ -539,6 +991,11 @@ std::string getCompilerOption(const OptionKind kind) {
   return std::string();
 }
 
+std::recursive_mutex &getCompilerOptionsGuard() {
+  static std::recursive_mutex guard;
+  return guard;
+}
+
 int setCompilerOptions(const CompilerOptionList &list) {
   for (const auto &pair : list) {
     int rc = setCompilerOption(pair.first, pair.second);
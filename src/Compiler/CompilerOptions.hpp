@@ -17,6 +17,7 @@
 #include "src/Accelerators/Accelerator.hpp"
 #include "llvm/Support/CommandLine.h"
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -48,12 +49,19 @@ extern llvm::cl::opt<bool> preserveMLIR;
 extern llvm::cl::opt<bool> useOnnxModelTypes;
 extern llvm::cl::opt<int> repeatOnnxTransform;
 extern llvm::cl::opt<std::string> shapeInformation;
+extern llvm::cl::opt<std::string> shapeContracts;
+extern llvm::cl::opt<std::string> specializedShapes;
+extern llvm::cl::opt<std::string> shapeProfileFile;
+extern llvm::cl::opt<bool> lazyOutputs;
+extern llvm::cl::opt<std::string> pruneOutputs;
 extern llvm::cl::opt<onnx_mlir::OptLevel> OptimizationLevel;
 extern llvm::cl::opt<std::string> customEnvFlags;
 extern llvm::cl::opt<std::string> mtriple;
 extern llvm::cl::opt<std::string> mcpu;
 extern llvm::cl::opt<std::string> march;
+extern llvm::cl::list<std::string> mcpuVariants;
 extern llvm::cl::list<onnx_mlir::accel::Accelerator::Kind> maccel;
+extern llvm::cl::list<std::string> acceleratorPlugins;
 extern llvm::cl::opt<bool> VerboseOutput;
 extern llvm::cl::list<std::string> Xopt;
 extern llvm::cl::list<std::string> Xllc;
@@ -65,12 +73,47 @@ extern llvm::cl::opt<InstrumentStages> instrumentStage;
 extern llvm::cl::opt<std::string> instrumentOps;
 extern llvm::cl::bits<InstrumentActions> instrumentControlBits;
 extern llvm::cl::opt<bool> instrumentONNXSignature;
+extern llvm::cl::opt<std::string> profileDataFile;
+extern llvm::cl::opt<std::string> accumConfigFile;
 extern llvm::cl::opt<std::string> ONNXOpStats;
 extern llvm::cl::opt<bool> enableMemoryBundling;
+extern llvm::cl::opt<bool> staticMemoryPlan;
+extern llvm::cl::opt<bool> scratchMemoryReport;
+extern llvm::cl::opt<int64_t> scratchMemoryLimit;
 extern llvm::cl::opt<int> onnxOpTransformThreshold;
+extern llvm::cl::opt<int64_t> onnxOpTransformMaxOps;
 extern llvm::cl::opt<bool> onnxOpTransformReport;
 extern llvm::cl::opt<bool> enableParallel;
+extern llvm::cl::opt<std::string> parallelSchedule;
+extern llvm::cl::opt<bool> cooperativeYield;
+extern llvm::cl::opt<bool> f16Weights;
+extern llvm::cl::opt<bool> enableFastElementwise;
+extern llvm::cl::opt<bool> enableFastConv;
+extern llvm::cl::opt<bool> enableFusedAttention;
+extern llvm::cl::opt<float> sparseWeightDensity;
+extern llvm::cl::opt<std::string> mathLib;
+extern llvm::cl::opt<int64_t> l2ResidentCores;
+extern llvm::cl::opt<bool> outlineLoopBodies;
+extern llvm::cl::opt<bool> OzModel;
+extern llvm::cl::opt<int64_t> tensorParallelRanks;
+extern llvm::cl::opt<int64_t> tensorParallelRank;
+extern llvm::cl::opt<bool> storeConstantsToFile;
+extern llvm::cl::opt<std::string> constantsToFileName;
+extern llvm::cl::opt<std::string> sharedConstantsDir;
+extern llvm::cl::opt<bool> approxTranscendentals;
+extern llvm::cl::opt<int64_t> constantsToFileSingleThreshold;
+extern llvm::cl::opt<bool> mmapExternalData;
+extern llvm::cl::opt<std::string> compilationCacheDir;
+extern llvm::cl::opt<int> codegenParallelUnits;
+extern llvm::cl::opt<bool> deferVerification;
+extern llvm::cl::opt<bool> enableRuntimeLTO;
+extern llvm::cl::opt<bool> smallTensorAllocator;
+extern llvm::cl::opt<bool> compileStats;
+extern llvm::cl::opt<bool> enablePrefetch;
+extern llvm::cl::opt<bool> enableLoopInterchange;
 extern llvm::cl::opt<bool> enableSimdDataLayout;
+extern llvm::cl::opt<std::string> unrollFactors;
+extern llvm::cl::opt<std::string> unrollConfigFile;
 
 // The customEnvFlags must be scanned before the normal options.
 bool parseCustomEnvFlagsCommandLineOption(int argc, const char *const *argv,
@@ -113,6 +156,8 @@ void setLLVMOption(const std::string &flag);
 void clearLLVMOption();
 std::string getLLVMOption();
 
+std::string getVectorLibraryOption();
+
 // Options support for OMCompilerOptions.
 using CompilerOptionList =
     llvm::SmallVector<std::pair<onnx_mlir::OptionKind, std::string>, 4>;
@@ -120,8 +165,15 @@ using CompilerOptionList =
 #define CCM_SHARED_LIB_DEPS "sharedLibDeps"
 extern std::map<std::string, std::vector<std::string>> CompilerConfigMap;
 
+// Guard for the process-wide option state above. In-process API compilations
+// (omCompileFromArray) hold it for their whole duration so that concurrent
+// sessions do not race on the cl::opt globals. Callers that set options from
+// several threads should hold it around their set-options-then-compile
+// sequence as well; it is recursive so doing so does not deadlock.
+std::recursive_mutex &getCompilerOptionsGuard();
+
 // Return 0 on success. These functions are not thread-safe and should be called
-// by a single program thread.
+// by a single program thread, or with the compiler options guard held.
 int setCompilerOption(const onnx_mlir::OptionKind kind, const std::string &val);
 int setCompilerOptions(const CompilerOptionList &list);
 void clearCompilerOption(const onnx_mlir::OptionKind kind);
@@ -19,6 +19,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Conversion/Passes.h"
+#include "mlir/Dialect/Affine/Passes.h"
 #include "mlir/Conversion/SCFToControlFlow/SCFToControlFlow.h"
 #include "mlir/Conversion/VectorToLLVM/ConvertVectorToLLVM.h"
 #include "mlir/Conversion/VectorToSCF/VectorToSCF.h"
@@ -26,6 +27,7 @@
 #include "mlir/Pass/Pass.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -39,8 +41,18 @@ using namespace mlir;
 
 namespace onnx_mlir {
 
-void addONNXToMLIRPasses(mlir::PassManager &pm, int transformThreshold,
-    bool transformReport, bool targetCPU, bool enableSimdDataLayoutOpt) {
+// The optimization level differentiates the ONNX-level pipeline:
+//   -O0: correctness passes only (decompose, shape inference, cleanup).
+//   -O1: fast compile; one static round of canonicalization and constant
+//        propagation, no fixed-point op-transform iteration, no ONNX-level
+//        rewrites of convolutions.
+//   -O2: the fixed-point ONNXOpTransformPass iteration and the CPU rewrites
+//        (ConvOpt, activation fusion).
+//   -O3: -O2 plus the aggressive Krnl-level passes gated on the level
+//        elsewhere (loop fusion, affine cleanup, SIMD-friendly lowering).
+void addONNXToMLIRPasses(mlir::PassManager &pm, int optLevel,
+    int transformThreshold, bool transformReport, bool targetCPU,
+    bool enableSimdDataLayoutOpt) {
   // This is a transition from previous static passes to full dynamic passes
   // Static passes are kept and the dynamic pass is added as IF-THEN
   // with the static iteration.
@@ -54,23 +66,51 @@ void addONNXToMLIRPasses(mlir::PassManager &pm, int transformThreshold,
 
   pm.addNestedPass<func::FuncOp>(onnx_mlir::createDecomposeONNXToONNXPass());
   pm.addPass(onnx_mlir::createShapeInferencePass());
+  // Recompose composite ops (e.g. LayerNormalization) once shapes are known.
+  pm.addNestedPass<func::FuncOp>(onnx_mlir::createRecomposeONNXToONNXPass());
   pm.addPass(mlir::createCanonicalizerPass());
   pm.addPass(onnx_mlir::createShapeInferencePass());
+  // Deduplicate subgraphs repeated across model towers early, so every later
+  // pass sees each shared computation once. Generic CSE cannot do this: the
+  // copies differ in their onnx_node_name attributes and carry their own
+  // copies of the same constants.
+  pm.addNestedPass<func::FuncOp>(onnx_mlir::createStructuralCSEPass());
   // Convolution Optimization for CPU: enable when there are no accelerators.
-  if (targetCPU) {
+  // These rewrites pay for themselves at runtime but cost compile time, so
+  // they are reserved for -O2 and above.
+  if (targetCPU && optLevel >= 2) {
     pm.addNestedPass<func::FuncOp>(
         onnx_mlir::createConvOptONNXToONNXPass(enableSimdDataLayoutOpt));
     pm.addPass(onnx_mlir::createShapeInferencePass());
+    // Fuse trailing activations into their producers and sink transposes
+    // below elementwise ops. Runs after ConvOpt so that convolutions
+    // rewritten into matmuls do not carry a recorded activation they would
+    // no longer honor; the canonicalizer then cancels adjacent transposes.
+    pm.addNestedPass<func::FuncOp>(onnx_mlir::createFusionONNXToONNXPass());
+    pm.addPass(mlir::createCanonicalizerPass());
+    pm.addPass(onnx_mlir::createShapeInferencePass());
   }
+  // Shard MatMul/Gemm weights across tensor-parallel ranks. Runs before
+  // constant propagation so the weight slices fold into per-rank constants
+  // and the library only embeds this rank's fraction of the weights.
+  if (tensorParallelRanks > 1)
+    pm.addNestedPass<func::FuncOp>(onnx_mlir::createShardTensorParallelPass(
+        tensorParallelRanks, tensorParallelRank));
   // There are more opportunities for const propagation once all tensors have
   // inferred shapes.
-  pm.addNestedPass<func::FuncOp>(onnx_mlir::createConstPropONNXToONNXPass());
+  if (optLevel >= 1)
+    pm.addNestedPass<func::FuncOp>(onnx_mlir::createConstPropONNXToONNXPass());
 
-  if (transformThreshold > 0) {
+  // The fixed-point op-transform iteration reruns canonicalization, shape
+  // inference and constant propagation until the IR stops changing; it
+  // dominates compile time on large models. Run it only at -O2 and above;
+  // -O1 settles for the static rounds and -O0 skips them entirely.
+  if (optLevel >= 2 && transformThreshold > 0) {
     // Dynamic iterate in ONNXOpTransformPass
     pm.addPass(onnx_mlir::createONNXOpTransformPass(transformThreshold,
-        transformReport, targetCPU, enableSimdDataLayoutOpt));
-  } else {
+        transformReport, targetCPU, enableSimdDataLayoutOpt,
+        onnxOpTransformMaxOps));
+  } else if (optLevel >= 1) {
     // Statically add extra passes
     for (int i = 0; i < repeatOnnxTransform; i++) {
       pm.addPass(mlir::createCanonicalizerPass());
@@ -83,6 +123,13 @@ void addONNXToMLIRPasses(mlir::PassManager &pm, int transformThreshold,
   // Simplify shape-related ops.
   pm.addPass(onnx_mlir::createSimplifyShapeRelatedOpsPass());
 
+  // Let entry points that export the same graph under several names share
+  // one body: duplicates become wrappers calling the first copy, so the
+  // heavy kernels behind multi-signature exports are lowered once. Runs
+  // after the optimization rounds above so that identically exported graphs
+  // are still identical when compared.
+  pm.addPass(onnx_mlir::createShareEntryFunctionsPass());
+
   // Clean dead code.
   pm.addPass(mlir::createSymbolDCEPass());
 }
@@ -93,6 +140,13 @@ void addONNXToKrnlPasses(mlir::PassManager &pm, int optLevel, bool enableCSE,
     // Eliminate common sub-expressions before lowering to Krnl.
     // TODO: enable this by default when we make sure it works flawlessly.
     pm.addPass(mlir::createCSEPass());
+  // Outline duplicated Loop/Scan bodies into shared functions. This has to
+  // run before instrumentation, which tags the operations inside the bodies
+  // with per-instance attributes that would defeat the structural matching.
+  // Binary-size mode depends on shared functions existing, so it implies
+  // the outlining.
+  if (outlineLoopBodies || OzModel)
+    pm.addPass(onnx_mlir::createOutlineLoopBodiesPass());
   // Verify ONNX ops before lowering to Krnl.
   pm.addNestedPass<func::FuncOp>(onnx_mlir::createONNXPreKrnlVerifyPass());
   // Print statistics about ONNX ops if enabled.
@@ -121,19 +175,80 @@ void addONNXToKrnlPasses(mlir::PassManager &pm, int optLevel, bool enableCSE,
   if (enableInstrumentONNXSignature)
     pm.addNestedPass<func::FuncOp>(
         onnx_mlir::createInstrumentONNXSignaturePass());
-  pm.addPass(onnx_mlir::createLowerToKrnlPass(optLevel, enableParallel));
+  // Annotate ops with measured times before lowering so that lowering
+  // patterns can pick strategies per op from measured hot spots.
+  if (!profileDataFile.empty())
+    pm.addNestedPass<func::FuncOp>(
+        onnx_mlir::createProfileAnnotationPass(profileDataFile));
+  // Annotate ops with requested accumulation types so that the reduction and
+  // matmul lowerings pick their accumulation precision per op.
+  if (!accumConfigFile.empty())
+    pm.addNestedPass<func::FuncOp>(
+        onnx_mlir::createAccumAnnotationPass(accumConfigFile));
+  pm.addPass(onnx_mlir::createLowerToKrnlPass(optLevel, enableParallel,
+      enableFastElementwise, enableFastConv, enableFusedAttention,
+      sparseWeightDensity, l2ResidentCores));
   // An additional pass of canonicalization is helpful because lowering
   // from ONNX dialect to Standard dialect exposes additional canonicalization
   // opportunities.
   pm.addPass(mlir::createCanonicalizerPass());
+  // Store weights that are only read through matmul/gemm tile packing in
+  // half precision; the pack copy widens them back to f32, so only the
+  // weights' footprint and memory traffic change.
+  if (f16Weights)
+    pm.addNestedPass<func::FuncOp>(krnl::createF16WeightStoragePass());
+  // Fuse elementwise loop nests to remove intermediate buffers; the traffic
+  // on these buffers dominates memory bandwidth in elementwise-heavy models.
+  if (optLevel >= 3)
+    pm.addNestedPass<func::FuncOp>(krnl::createFuseKrnlLoopsPass());
+  // Hoist allocations with loop-invariant sizes out of the loops generated
+  // for ops like onnx.Loop, so one buffer is reused across iterations.
+  pm.addNestedPass<func::FuncOp>(krnl::createHoistKrnlAllocsPass());
+  // The lowering deallocates transient buffers at the end of the function;
+  // free each buffer right after its last use instead, so buffers with
+  // disjoint live ranges do not overlap at peak.
+  pm.addNestedPass<func::FuncOp>(krnl::createShrinkAllocLifetimesPass());
   pm.addNestedPass<func::FuncOp>(
       onnx_mlir::createDisconnectKrnlDimFromAllocPass());
   pm.addPass(mlir::createCanonicalizerPass());
+  // Run independent subgraphs (e.g. the parallel branches of a multi-tower
+  // model) concurrently on the runtime worker pool.
+  if (enableParallel)
+    pm.addPass(krnl::createPartitionParallelTasksPass());
+  // For a model co-located with a latency-critical one, insert cooperative
+  // preemption points at the chunk boundaries of the outer loops, so a
+  // higher-priority task waiting in the runtime pool runs between two chunks
+  // instead of behind the whole inference.
+  if (cooperativeYield)
+    pm.addPass(krnl::createInsertYieldPointsPass());
+  // When memory reporting is requested, tag every generated alloc site with
+  // its size so the runtime can attribute allocations to ops and report the
+  // per-op peak memory. Run after canonicalization so that only surviving
+  // allocations are instrumented.
+  if (maccel.empty() && instrumentStage == Onnx &&
+      instrumentControlBits.isSet(InstrumentReportMemory))
+    pm.addNestedPass<func::FuncOp>(krnl::createInstrumentMemoryPass());
+  // In binary-size mode, merge lowered functions that ended up structurally
+  // identical: outlined bodies whose ONNX-level differences vanished during
+  // lowering collapse into one copy shared by every call site.
+  if (OzModel)
+    pm.addPass(krnl::createDeduplicateFunctionsPass());
 } // namespace onnx_mlir
 
 void addKrnlToAffinePasses(mlir::PassManager &pm) {
-  pm.addNestedPass<func::FuncOp>(
-      onnx_mlir::krnl::createConvertKrnlToAffinePass());
+  pm.addNestedPass<func::FuncOp>(onnx_mlir::krnl::createConvertKrnlToAffinePass(
+      enablePrefetch, enableLoopInterchange, unrollFactors, unrollConfigFile));
+  // The lowering leaves repeated affine.apply index computations in the inner
+  // loops; once the memref descriptor lowering has obscured them, LLVM no
+  // longer cleans them all up. Hoist the loop-invariant part, forward stored
+  // values to subsequent loads, and fold the duplicated index math while it
+  // is still affine.
+  if (OptimizationLevel >= OptLevel::O3) {
+    pm.addNestedPass<func::FuncOp>(
+        mlir::createAffineLoopInvariantCodeMotionPass());
+    pm.addNestedPass<func::FuncOp>(mlir::createAffineScalarReplacementPass());
+    pm.addPass(mlir::createCSEPass());
+  }
 }
 
 void addKrnlToLLVMPasses(
@@ -148,6 +263,19 @@ void addKrnlToLLVMPasses(
   // After affine is lowered, KrnlRegion for affine scope can be removed.
   pm.addNestedPass<func::FuncOp>(krnl::createLowerKrnlRegionPass());
 
+  // Map the scf.parallel loops produced by krnl.parallel onto the runtime
+  // worker pool; without this the scf-to-cf conversion serializes them. The
+  // schedule decides how the iteration space is cut into chunks: 'dynamic'
+  // and 'guided' rebalance ragged workloads whose iterations have very
+  // different costs.
+  if (enableParallel) {
+    int64_t schedule = llvm::StringSwitch<int64_t>(parallelSchedule)
+                           .Case("static", 0)
+                           .Case("guided", 2)
+                           .Default(1);
+    pm.addPass(krnl::createChunkParallelLoopsPass(schedule));
+  }
+
   // Hoist allocations out of loop nests to avoid stack overflow.
   pm.addPass(bufferization::createBufferLoopHoistingPass());
 
@@ -161,13 +289,30 @@ void addKrnlToLLVMPasses(
     pm.addNestedPass<func::FuncOp>(krnl::createKrnlEnableMemoryPoolPass());
     pm.addNestedPass<func::FuncOp>(krnl::createKrnlBundleMemoryPoolsPass());
     pm.addPass(mlir::createCanonicalizerPass());
-    pm.addNestedPass<func::FuncOp>(krnl::createKrnlOptimizeMemoryPoolsPass());
+    // For static shapes the whole-graph plan subsumes the greedy pairwise
+    // slot reuse: it assigns liveness-colored offsets into a single arena
+    // whose size is the pool's compile-time peak memory.
+    if (staticMemoryPlan)
+      pm.addNestedPass<func::FuncOp>(
+          krnl::createKrnlStaticMemoryPlanPass(scratchMemoryReport));
+    else
+      pm.addNestedPass<func::FuncOp>(
+          krnl::createKrnlOptimizeMemoryPoolsPass());
   }
 
+  // Audit the allocation sites once the memory pools are in their final
+  // shape, so the budget reflects what the binary will actually request.
+  if (scratchMemoryReport || scratchMemoryLimit > 0)
+    pm.addNestedPass<func::FuncOp>(krnl::createScratchMemoryBudgetPass(
+        scratchMemoryReport, scratchMemoryLimit));
+
   pm.addNestedPass<func::FuncOp>(krnl::createConvertSeqToMemrefPass());
   pm.addNestedPass<func::FuncOp>(mlir::createConvertSCFToCFPass());
 
-  pm.addPass(krnl::createConvertKrnlToLLVMPass(verifyInputTensors));
+  pm.addPass(krnl::createConvertKrnlToLLVMPass(verifyInputTensors,
+      storeConstantsToFile, constantsToFileSingleThreshold,
+      constantsToFileName, sharedConstantsDir, approxTranscendentals,
+      smallTensorAllocator));
   pm.addPass(mlir::createReconcileUnrealizedCastsPass());
   pm.addPass(mlir::createCanonicalizerPass());
 }
@@ -202,8 +347,9 @@ void addPasses(mlir::OwningOpRef<ModuleOp> &module, mlir::PassManager &pm,
   InputIRLevelType inputIRLevel = determineInputIRLevel(module);
 
   if (inputIRLevel <= ONNXLevel && emissionTarget >= EmitONNXIR)
-    addONNXToMLIRPasses(pm, onnxOpTransformThreshold, onnxOpTransformReport,
-        /*target CPU*/ maccel.empty(), enableSimdDataLayout);
+    addONNXToMLIRPasses(pm, OptimizationLevel, onnxOpTransformThreshold,
+        onnxOpTransformReport, /*target CPU*/ maccel.empty(),
+        enableSimdDataLayout);
 
   if (emissionTarget >= EmitMLIR) {
     if (inputIRLevel <= ONNXLevel)
@@ -16,8 +16,9 @@
 #include "mlir/Pass/PassManager.h"
 
 namespace onnx_mlir {
-void addONNXToMLIRPasses(mlir::PassManager &pm, int transformThreshold,
-    bool transformReport, bool targetCPU, bool enableSimdDataLayoutOpt);
+void addONNXToMLIRPasses(mlir::PassManager &pm, int optLevel,
+    int transformThreshold, bool transformReport, bool targetCPU,
+    bool enableSimdDataLayoutOpt);
 void addONNXToKrnlPasses(mlir::PassManager &pm, int optLevel, bool enableCSE,
     bool enableInstrumentONNXSignature, std::string ONNXOpsStatFilename);
 void addKrnlToAffinePasses(mlir::PassManager &pm);
@@ -0,0 +1,236 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------------------------- CompilerStats.cpp --------------------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// Implementation of the -compile-stats report. Coarse phases are recorded by
+// CompileStatsPhase RAII timers placed around the import, lowering, llvm-opt,
+// codegen and link steps in CompilerUtils.cpp; per-pass figures come from a
+// PassInstrumentation attached to the pass manager. Everything is collected
+// into a process-wide registry and emitted as one JSON document so that
+// compile-time regressions can be filed with machine-readable evidence.
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>
+#include <mutex>
+
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassInstrumentation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "src/Compiler/CompilerOptions.hpp"
+#include "src/Compiler/CompilerStats.hpp"
+
+using namespace mlir;
+
+namespace {
+
+// Monotonic wall clock in milliseconds.
+static double getWallTimeMs() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration<double, std::milli>(now).count();
+}
+
+// Peak resident set size of the process in kilobytes, 0 where the query is
+// not supported. The reported per-pass/per-phase figure is the growth of
+// this high-water mark, so only steps that push the process to a new peak
+// show a nonzero delta.
+static int64_t getPeakRSSKb() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+#ifdef __APPLE__
+    // macOS reports ru_maxrss in bytes.
+    return (int64_t)usage.ru_maxrss / 1024;
+#else
+    return (int64_t)usage.ru_maxrss;
+#endif
+#endif
+  return 0;
+}
+
+// Number of operations in the IR rooted at op, op included.
+static int64_t countOps(Operation *op) {
+  int64_t numOps = 0;
+  op->walk([&](Operation *) { ++numOps; });
+  return numOps;
+}
+
+// One aggregated entry of the report; pass entries also track IR size.
+struct StatsEntry {
+  std::string name;
+  int64_t runs = 0;
+  double wallMs = 0.0;
+  int64_t peakRSSDeltaKb = 0;
+  int64_t opsBefore = 0;
+  int64_t opsAfter = 0;
+};
+
+// Process-wide registry of the collected statistics. Pass entries are keyed
+// by pass name and kept in first-seen order; a function pass that runs on
+// many functions (possibly concurrently) aggregates into a single entry.
+struct StatsRegistry {
+  std::mutex mutex;
+  std::vector<StatsEntry> phases;
+  std::vector<StatsEntry> passes;
+
+  StatsEntry &getEntry(std::vector<StatsEntry> &entries, StringRef name) {
+    for (StatsEntry &entry : entries)
+      if (entry.name == name)
+        return entry;
+    entries.emplace_back();
+    entries.back().name = name.str();
+    return entries.back();
+  }
+
+  void recordPhase(StringRef name, double wallMs, int64_t peakRSSDeltaKb) {
+    std::lock_guard<std::mutex> lock(mutex);
+    StatsEntry &entry = getEntry(phases, name);
+    entry.runs++;
+    entry.wallMs += wallMs;
+    entry.peakRSSDeltaKb += peakRSSDeltaKb;
+  }
+
+  void recordPass(StringRef name, double wallMs, int64_t peakRSSDeltaKb,
+      int64_t opsBefore, int64_t opsAfter) {
+    std::lock_guard<std::mutex> lock(mutex);
+    StatsEntry &entry = getEntry(passes, name);
+    entry.runs++;
+    entry.wallMs += wallMs;
+    entry.peakRSSDeltaKb += peakRSSDeltaKb;
+    entry.opsBefore += opsBefore;
+    entry.opsAfter += opsAfter;
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    phases.clear();
+    passes.clear();
+  }
+};
+
+static StatsRegistry &getStatsRegistry() {
+  static StatsRegistry registry;
+  return registry;
+}
+
+// Instrumentation recording wall time, peak RSS growth and IR size growth of
+// every pass run. Function passes may run concurrently, so the in-flight
+// measurements are keyed by the (pass, operation) pair of the run.
+class CompileStatsInstrumentation : public PassInstrumentation {
+public:
+  void runBeforePass(Pass *pass, Operation *op) override {
+    InFlight inFlight;
+    inFlight.startWallMs = getWallTimeMs();
+    inFlight.startPeakRSSKb = getPeakRSSKb();
+    inFlight.opsBefore = countOps(op);
+    std::lock_guard<std::mutex> lock(mutex);
+    inFlightRuns[{pass, op}] = inFlight;
+  }
+
+  void runAfterPass(Pass *pass, Operation *op) override {
+    double wallMs = getWallTimeMs();
+    int64_t peakRSSKb = getPeakRSSKb();
+    int64_t opsAfter = countOps(op);
+    InFlight inFlight;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = inFlightRuns.find({pass, op});
+      if (it == inFlightRuns.end())
+        return;
+      inFlight = it->second;
+      inFlightRuns.erase(it);
+    }
+    getStatsRegistry().recordPass(pass->getName(),
+        wallMs - inFlight.startWallMs, peakRSSKb - inFlight.startPeakRSSKb,
+        inFlight.opsBefore, opsAfter);
+  }
+
+  void runAfterPassFailed(Pass *pass, Operation *op) override {
+    runAfterPass(pass, op);
+  }
+
+private:
+  struct InFlight {
+    double startWallMs;
+    int64_t startPeakRSSKb;
+    int64_t opsBefore;
+  };
+  std::mutex mutex;
+  llvm::DenseMap<std::pair<Pass *, Operation *>, InFlight> inFlightRuns;
+};
+
+static llvm::json::Array entriesToJson(
+    const std::vector<StatsEntry> &entries, bool withOps) {
+  llvm::json::Array array;
+  for (const StatsEntry &entry : entries) {
+    llvm::json::Object object;
+    object["name"] = entry.name;
+    object["runs"] = entry.runs;
+    object["wallMs"] = entry.wallMs;
+    object["peakRSSDeltaKb"] = entry.peakRSSDeltaKb;
+    if (withOps) {
+      object["opsBefore"] = entry.opsBefore;
+      object["opsAfter"] = entry.opsAfter;
+    }
+    array.push_back(std::move(object));
+  }
+  return array;
+}
+
+} // namespace
+
+namespace onnx_mlir {
+
+CompileStatsPhase::CompileStatsPhase(llvm::StringRef phaseName)
+    : phaseName(phaseName.str()), enabled(compileStats) {
+  if (!enabled)
+    return;
+  startWallMs = getWallTimeMs();
+  startPeakRSSKb = getPeakRSSKb();
+}
+
+CompileStatsPhase::~CompileStatsPhase() {
+  if (!enabled)
+    return;
+  getStatsRegistry().recordPhase(phaseName, getWallTimeMs() - startWallMs,
+      getPeakRSSKb() - startPeakRSSKb);
+}
+
+void attachCompileStatsInstrumentation(mlir::PassManager &pm) {
+  if (!compileStats)
+    return;
+  pm.addInstrumentation(std::make_unique<CompileStatsInstrumentation>());
+}
+
+void emitCompileStatsReport() {
+  if (!compileStats)
+    return;
+  StatsRegistry &registry = getStatsRegistry();
+  llvm::json::Object report;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    report["peakRSSKb"] = getPeakRSSKb();
+    report["phases"] = entriesToJson(registry.phases, /*withOps=*/false);
+    report["passes"] = entriesToJson(registry.passes, /*withOps=*/true);
+  }
+  registry.reset();
+  llvm::errs() << llvm::formatv(
+                      "{0:2}", llvm::json::Value(std::move(report)))
+               << "\n";
+}
+
+} // namespace onnx_mlir
@@ -0,0 +1,48 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------------------------- CompilerStats.hpp --------------------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// Support for the -compile-stats report: wall time, peak RSS delta and IR
+// size growth per pass and per coarse compilation phase (import, lowering,
+// llvm-opt, codegen, link), emitted as one JSON document on stderr.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+
+#include "mlir/Pass/PassManager.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace onnx_mlir {
+
+// RAII timer for one coarse compilation phase. Phases with the same name are
+// aggregated in the report; when -compile-stats is off the timer is inert.
+class CompileStatsPhase {
+public:
+  CompileStatsPhase(llvm::StringRef phaseName);
+  ~CompileStatsPhase();
+
+private:
+  std::string phaseName;
+  double startWallMs;
+  int64_t startPeakRSSKb;
+  bool enabled;
+};
+
+// Attach the per-pass instrumentation to the pass manager when -compile-stats
+// is set; a no-op otherwise.
+void attachCompileStatsInstrumentation(mlir::PassManager &pm);
+
+// Emit the collected statistics as a JSON document on stderr and reset them.
+// A no-op when -compile-stats is off.
+void emitCompileStatsReport();
+
+} // namespace onnx_mlir
@@ -12,27 +12,43 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/IR/Verifier.h"
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include "mlir/Target/LLVMIR/Export.h"
+#include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/IPO/Internalize.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+
+#include <list>
+#include <thread>
 
 #include "ExternalUtil.hpp"
 
 #include "src/Accelerators/Accelerator.hpp"
 #include "src/Compiler/CompilerOptions.hpp"
 #include "src/Compiler/CompilerPasses.hpp"
+#include "src/Compiler/CompilerStats.hpp"
 #include "src/Compiler/CompilerUtils.hpp"
+#include "src/Dialect/Mlir/DialectBuilder.hpp"
 #include "src/Dialect/ONNX/ONNXDialect.hpp"
+#include "src/Support/TargetCacheGeometry.hpp"
 #include "src/Version/Version.hpp"
 
 #define DEBUG_TYPE "compiler_utils"
@@ -268,6 +284,34 @@ static void loadMLIR(std::string inputFilename, mlir::MLIRContext &context,
   }
 }
 
+// Collect the names of the entry point functions the model advertises, by
+// reading them back from the '_entry_point_arrays' table that the krnl entry
+// point lowering emitted into the module.
+static void collectEntryPointNames(
+    llvm::Module &llvmModule, SmallVectorImpl<std::string> &entryPointNames) {
+  llvm::GlobalVariable *GV =
+      llvmModule.getNamedGlobal(StringRef("_entry_point_arrays"));
+  if (!GV || !GV->isConstant() || !GV->hasDefinitiveInitializer())
+    return;
+  llvm::Constant *initializer = GV->getInitializer();
+  llvm::ArrayType *AT = dyn_cast<llvm::ArrayType>(initializer->getType());
+  // The last array element is the NULL terminator.
+  for (uint64_t i = 0; i < AT->getNumElements() - 1; ++i) {
+    llvm::GlobalVariable *entryGV = llvmModule.getNamedGlobal(
+        StringRef("_entry_point_" + std::to_string(i)));
+    if (entryGV->isConstant()) {
+      llvm::ConstantDataSequential *entry =
+          dyn_cast<llvm::ConstantDataSequential>(entryGV->getInitializer());
+      entryPointNames.emplace_back(entry->getAsCString().str());
+      // Each entry point has a raw variant taking memref descriptors, and,
+      // when input verification is enabled, an unchecked twin. Names without
+      // a matching symbol are skipped by the caller.
+      entryPointNames.emplace_back(entry->getAsCString().str() + "_raw");
+      entryPointNames.emplace_back(entry->getAsCString().str() + "_unchecked");
+    }
+  }
+}
+
 // Tailor LLVMIR to add features that cannot be done with MLIR LLVMIR.
 static void tailorLLVMIR(llvm::Module &llvmModule) {
   llvm::LLVMContext &ctx = llvmModule.getContext();
@@ -309,29 +353,15 @@ static void tailorLLVMIR(llvm::Module &llvmModule) {
 
   // Annotate functions to be accessible from DLL on Windows.
 #ifdef _WIN32
-  SmallVector<StringRef, 4> exportedFuncs;
+  SmallVector<std::string, 4> exportedFuncs;
   // Signature functions.
-  exportedFuncs.emplace_back(StringRef("omInputSignature"));
-  exportedFuncs.emplace_back(StringRef("omOutputSignature"));
-  exportedFuncs.emplace_back(StringRef("omQueryEntryPoints"));
+  exportedFuncs.emplace_back("omInputSignature");
+  exportedFuncs.emplace_back("omOutputSignature");
+  exportedFuncs.emplace_back("omGetSignatureBinary");
+  exportedFuncs.emplace_back("omQueryEntryPoints");
   // Entry point funtions.
-  if (llvm::GlobalVariable *GV =
-          llvmModule.getNamedGlobal(StringRef("_entry_point_arrays"))) {
-    if (GV->isConstant() && GV->hasDefinitiveInitializer()) {
-      llvm::Constant *initializer = GV->getInitializer();
-      llvm::ArrayType *AT = dyn_cast<llvm::ArrayType>(initializer->getType());
-      for (uint64_t i = 0; i < AT->getNumElements() - 1; ++i) {
-        llvm::GlobalVariable *entryGV = llvmModule.getNamedGlobal(
-            StringRef("_entry_point_" + std::to_string(i)));
-        if (entryGV->isConstant()) {
-          llvm::ConstantDataSequential *entry =
-              dyn_cast<llvm::ConstantDataSequential>(entryGV->getInitializer());
-          exportedFuncs.emplace_back(entry->getAsCString());
-        }
-      }
-    }
-  }
-  for (StringRef funcName : exportedFuncs)
+  collectEntryPointNames(llvmModule, exportedFuncs);
+  for (const std::string &funcName : exportedFuncs)
     if (llvm::GlobalValue *GV = llvmModule.getNamedValue(funcName)) {
       GV->setDSOLocal(true);
       GV->setDLLStorageClass(llvm::GlobalValue::DLLExportStorageClass);
@@ -351,11 +381,15 @@ std::string getTargetFilename(
     return filenameNoExt + ".obj";
   case EmitLib:
     return filenameNoExt + ".dll";
+  case EmitStaticLib:
+    return filenameNoExt + ".lib";
 #else
   case EmitObj:
     return filenameNoExt + ".o";
   case EmitLib:
     return filenameNoExt + ".so";
+  case EmitStaticLib:
+    return filenameNoExt + ".a";
 #endif
 
   case EmitJNI:
@@ -369,6 +403,108 @@ std::string getTargetFilename(
   llvm_unreachable("all cases should be handled in switch");
 }
 
+// Link the bitcode build of the runtime (libcruntime.bc) into the model
+// module so that the optimizer can inline and specialize runtime helpers,
+// the omTensor accessors in particular, into the model code. Only the
+// runtime functions the model references are pulled in, and they are
+// internalized so the model library keeps a private, freely optimizable
+// copy; symbols the model does not touch keep coming from libcruntime.a
+// when the shared library is linked. Best effort: when the bitcode library
+// is missing or unusable, a warning is emitted and the model is compiled
+// as usual.
+static void linkRuntimeBitcode(llvm::Module &llvmModule) {
+  std::string runtimeBitcodePath = getLibraryPath() + "/libcruntime.bc";
+  if (!llvm::sys::fs::exists(runtimeBitcodePath)) {
+    llvm::errs() << "Warning: -runtime-lto requested but "
+                 << runtimeBitcodePath
+                 << " was not found. The runtime is linked as usual; build "
+                    "onnx-mlir with clang to get the bitcode runtime.\n";
+    return;
+  }
+
+  llvm::SMDiagnostic err;
+  std::unique_ptr<llvm::Module> runtimeModule =
+      llvm::parseIRFile(runtimeBitcodePath, err, llvmModule.getContext());
+  if (!runtimeModule) {
+    llvm::errs() << "Warning: failed to parse " << runtimeBitcodePath << ": "
+                 << err.getMessage() << ". The runtime is linked as usual.\n";
+    return;
+  }
+
+  // The bitcode runtime was compiled for the host. Cross compiles must keep
+  // using the (cross compiled) static runtime.
+  llvm::Triple modelTriple(llvmModule.getTargetTriple());
+  llvm::Triple runtimeTriple(runtimeModule->getTargetTriple());
+  if (modelTriple.getArch() != runtimeTriple.getArch()) {
+    llvm::errs() << "Warning: " << runtimeBitcodePath << " targets "
+                 << runtimeTriple.str() << " but the model targets "
+                 << modelTriple.str()
+                 << ". The runtime is linked as usual.\n";
+    return;
+  }
+  // Remaining triple and data layout spelling differences (vendor, OS
+  // revision) are harmless; align them to silence linker diagnostics.
+  runtimeModule->setTargetTriple(llvmModule.getTargetTriple());
+  runtimeModule->setDataLayout(llvmModule.getDataLayout());
+
+  // Same linking policy as 'llvm-link -only-needed -internalize': take only
+  // definitions resolving a reference from the model and give them internal
+  // linkage, preserving everything that was already in the model module.
+  if (llvm::Linker::linkModules(llvmModule, std::move(runtimeModule),
+          llvm::Linker::Flags::LinkOnlyNeeded,
+          [](llvm::Module &m, const llvm::StringSet<> &gvs) {
+            llvm::internalizeModule(m, [&gvs](const llvm::GlobalValue &gv) {
+              return !gv.hasName() || (gvs.count(gv.getName()) == 0);
+            });
+          }))
+    llvm::errs() << "Warning: failed to link " << runtimeBitcodePath
+                 << ". The runtime is linked as usual.\n";
+}
+
+// Translate the MLIR module to an LLVM module and tailor the LLVMIR.
+// Returns nullptr on failure.
+static std::unique_ptr<llvm::Module> translateToLLVMIR(
+    const mlir::OwningOpRef<ModuleOp> &module, llvm::LLVMContext &llvmContext) {
+  mlir::registerLLVMDialectTranslation(*(module.get().getContext()));
+  std::unique_ptr<llvm::Module> llvmModule =
+      mlir::translateModuleToLLVMIR(*module, llvmContext);
+  if (!llvmModule) {
+    llvm::errs() << "Failed to translate module to LLVMIR.\n";
+    return nullptr;
+  }
+
+  // Tailor LLVMIR to add features that cannot be done with MLIR LLVMIR.
+  tailorLLVMIR(*llvmModule);
+
+  // Pull the runtime in as bitcode for cross-boundary inlining. Done before
+  // any module split so every codegen unit sees its runtime calls resolved.
+  if (enableRuntimeLTO)
+    linkRuntimeBitcode(*llvmModule);
+  return llvmModule;
+}
+
+// Optimize a bitcode file using the LLVM's 'opt' command. The cpu option
+// defaults to the one derived from -mcpu; the fat-binary path overrides it
+// per variant.
+// Returns 0 on success, error code on failure.
+static int optimizeBitcode(std::string unoptimizedBitcodeNameWithExt,
+    std::string optimizedBitcodeNameWithExt,
+    std::string targetCPUOption = getTargetCPUOption()) {
+  std::string optPath = getToolPath("opt", kOptPath);
+  Command optBitcode(/*exePath=*/optPath);
+  int rc = optBitcode.appendStr(getOptimizationLevelOption())
+               .appendStr(getTargetTripleOption())
+               .appendStr(getTargetArchOption())
+               .appendStr(targetCPUOption)
+               .appendStr(getVectorLibraryOption())
+               .appendList(getXoptOption())
+               .appendStr(getLLVMOption())
+               .appendList({"-o", optimizedBitcodeNameWithExt})
+               .appendStr(unoptimizedBitcodeNameWithExt)
+               .exec();
+  return rc != 0 ? CompilerFailureInLLVMOpt : CompilerSuccess;
+}
+
 // Write LLVM optimized bitcode.
 // Returns 0 on success, error code on failure.
 static int genLLVMBitcode(const mlir::OwningOpRef<ModuleOp> &module,
@@ -392,16 +528,10 @@ static int genLLVMBitcode(const mlir::OwningOpRef<ModuleOp> &module,
   }
 
   llvm::LLVMContext llvmContext;
-  mlir::registerLLVMDialectTranslation(*(module.get().getContext()));
   std::unique_ptr<llvm::Module> llvmModule =
-      mlir::translateModuleToLLVMIR(*module, llvmContext);
-  if (!llvmModule) {
-    llvm::errs() << "Failed to translate module to LLVMIR.\n";
+      translateToLLVMIR(module, llvmContext);
+  if (!llvmModule)
     return CompilerFailureInMLIRToLLVM;
-  }
-
-  // Tailor LLVMIR to add features that cannot be done with MLIR LLVMIR.
-  tailorLLVMIR(*llvmModule);
 
   // Write LLVMIR to a file.
   std::string llvmirNameWithExt = outputNameNoExt + ".ll";
@@ -421,31 +551,194 @@ static int genLLVMBitcode(const mlir::OwningOpRef<ModuleOp> &module,
   moduleBitcodeStream.flush();
 
   // Use the LLVM's 'opt' command to optimize the bitcode.
-  std::string optPath = getToolPath("opt", kOptPath);
-  Command optBitcode(/*exePath=*/optPath);
-  int rc = optBitcode.appendStr(getOptimizationLevelOption())
-               .appendStr(getTargetTripleOption())
-               .appendStr(getTargetArchOption())
-               .appendStr(getTargetCPUOption())
-               .appendList(getXoptOption())
-               .appendStr(getLLVMOption())
-               .appendList({"-o", optimizedBitcodeNameWithExt})
-               .appendStr(unoptimizedBitcodeNameWithExt)
-               .exec();
-  return rc != 0 ? CompilerFailureInLLVMOpt : CompilerSuccess;
+  return optimizeBitcode(
+      unoptimizedBitcodeNameWithExt, optimizedBitcodeNameWithExt);
+}
+
+//===----------------------------------------------------------------------===//
+// Persistent compilation cache.
+
+namespace {
+// Stream that folds everything written to it into an MD5 hasher, so the
+// module can be hashed without materializing its textual form.
+class HashingOutputStream : public llvm::raw_ostream {
+public:
+  HashingOutputStream(llvm::MD5 &hasher) : hasher(hasher) { SetUnbuffered(); }
+
+private:
+  void write_impl(const char *ptr, size_t size) override {
+    hasher.update(llvm::StringRef(ptr, size));
+    position += size;
+  }
+  uint64_t current_pos() const override { return position; }
+  llvm::MD5 &hasher;
+  uint64_t position = 0;
+};
+
+// Fold one cache key component into the hasher, followed by a separator so
+// that adjacent components cannot run into each other.
+void updateCacheKey(llvm::MD5 &hasher, const llvm::Twine &component) {
+  llvm::SmallString<64> buffer;
+  hasher.update(component.toStringRef(buffer));
+  hasher.update(llvm::StringRef("\0", 1));
+}
+} // namespace
+
+// Compute the cache key for compiling the given module: an MD5 over the
+// compiler version, every option that influences the emitted artifact, and
+// the module itself, rendered as a hex string. The module is hashed after
+// setupModule so the target triple, datalayout, and accelerator attributes
+// enter the key through the module text; the import options (custom shapes
+// and the like) are already reflected in the imported module and need no
+// separate mention.
+static std::string computeCompilationCacheKey(
+    const mlir::OwningOpRef<ModuleOp> &module,
+    EmissionTargetType emissionTarget) {
+  llvm::MD5 hasher;
+  // A compiler change invalidates all prior entries.
+  updateCacheKey(hasher, getOnnxMlirFullVersion());
+  // Options that steer the pass pipeline and codegen.
+  updateCacheKey(hasher, std::to_string(emissionTarget));
+  updateCacheKey(hasher, getOptimizationLevelOption());
+  updateCacheKey(hasher, getTargetTripleOption());
+  updateCacheKey(hasher, getTargetArchOption());
+  updateCacheKey(hasher, getTargetCPUOption());
+  updateCacheKey(hasher, getTargetAccel());
+  for (const std::string &flag : getXoptOption())
+    updateCacheKey(hasher, flag);
+  for (const std::string &flag : getXllcOption())
+    updateCacheKey(hasher, flag);
+  for (const std::string &variant : mcpuVariants)
+    updateCacheKey(hasher, variant);
+  updateCacheKey(hasher, getLLVMOption());
+  std::stringstream flags;
+  flags << enableParallel << enableMemoryBundling << staticMemoryPlan
+        << enableFastElementwise << enableFastConv << enableFusedAttention
+        << enableSimdDataLayout << enableLoopInterchange << enablePrefetch
+        << storeConstantsToFile << approxTranscendentals << enableRuntimeLTO
+        << outlineLoopBodies << OzModel << cooperativeYield << f16Weights
+        << smallTensorAllocator << instrumentONNXSignature << verifyInputTensors
+        << preserveLocations << "," << constantsToFileName.getValue() << ","
+        << sharedConstantsDir.getValue() << ","
+        << constantsToFileSingleThreshold << ","
+        << parallelSchedule.getValue() << "," << onnxOpTransformThreshold
+        << "," << onnxOpTransformMaxOps << "," << repeatOnnxTransform << ","
+        << instrumentStage << "," << instrumentOps.getValue() << ","
+        << instrumentControlBits.getBits() << "," << ONNXOpStats.getValue()
+        << "," << unrollFactors.getValue() << ","
+        << unrollConfigFile.getValue() << "," << scratchMemoryLimit << ","
+        << l2ResidentCores << "," << sparseWeightDensity << ","
+        << mathLib.getValue() << "," << profileDataFile.getValue() << ","
+        << tensorParallelRanks << "," << tensorParallelRank << ","
+        << accumConfigFile.getValue();
+  updateCacheKey(hasher, flags.str());
+  // The profile contents steer the pass pipeline as much as the file name
+  // does, so an updated profile under an unchanged name must miss the cache.
+  if (!profileDataFile.empty()) {
+    auto profileBuf = llvm::MemoryBuffer::getFile(profileDataFile);
+    if (profileBuf)
+      updateCacheKey(hasher, (*profileBuf)->getBuffer());
+  }
+  // The module, covering the model content and all import-time reshaping.
+  HashingOutputStream moduleStream(hasher);
+  mlir::OpPrintingFlags printFlags;
+  if (preserveLocations)
+    printFlags.enableDebugInfo();
+  module->print(moduleStream, printFlags);
+  llvm::MD5::MD5Result result;
+  hasher.final(result);
+  return result.digest().str().str();
+}
+
+// Return the path of the cache entry for the given key, preserving the
+// artifact extension so that .so, .o, and .jar entries can coexist.
+static std::string compilationCachePath(
+    const std::string &cacheKey, const std::string &artifactNameWithExt) {
+  llvm::SmallString<128> path(compilationCacheDir.getValue());
+  llvm::sys::path::append(
+      path, cacheKey + llvm::sys::path::extension(artifactNameWithExt).str());
+  return std::string(path.str());
+}
+
+// Copy a cached artifact to the requested output path on a hit. Return true
+// on a hit, false when the entry is absent or cannot be copied.
+static bool lookupCompilationCache(
+    const std::string &cacheKey, const std::string &artifactNameWithExt) {
+  std::string cachePath = compilationCachePath(cacheKey, artifactNameWithExt);
+  if (!llvm::sys::fs::exists(cachePath))
+    return false;
+  return !llvm::sys::fs::copy_file(cachePath, artifactNameWithExt);
+}
+
+// Store a freshly built artifact into the cache. The copy goes through a
+// unique temporary name and a rename so that concurrent compiles never
+// observe a half-written entry. Failures are silently ignored: caching is
+// best effort and must not fail an otherwise successful compilation.
+static void updateCompilationCache(
+    const std::string &cacheKey, const std::string &artifactNameWithExt) {
+  if (llvm::sys::fs::create_directories(compilationCacheDir.getValue()))
+    return;
+  std::string cachePath = compilationCachePath(cacheKey, artifactNameWithExt);
+  llvm::SmallString<128> tmpPath;
+  if (llvm::sys::fs::createUniqueFile(cachePath + ".tmp.%%%%%%", tmpPath))
+    return;
+  if (llvm::sys::fs::copy_file(artifactNameWithExt, tmpPath)) {
+    llvm::sys::fs::remove(tmpPath);
+    return;
+  }
+  if (llvm::sys::fs::rename(tmpPath, cachePath))
+    llvm::sys::fs::remove(tmpPath);
+}
+
+// Compute the cache key for one codegen unit: an MD5 over the compiler
+// version, the options that steer 'opt' and 'llc', and the unit's
+// unoptimized bitcode. Codegen units partition the module by function, so
+// when an edited model is recompiled the units covering its unchanged
+// functions hash to their previous key and reuse the cached object file;
+// only the changed units are recompiled before relinking. Returns the empty
+// string when the bitcode cannot be read, which disables caching for the
+// unit.
+static std::string computeCodegenUnitCacheKey(
+    const std::string &bitcodeNameWithExt,
+    const std::string &targetCPUOption) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(bitcodeNameWithExt);
+  if (!buffer)
+    return std::string();
+  llvm::MD5 hasher;
+  // A compiler change invalidates all prior entries.
+  updateCacheKey(hasher, getOnnxMlirFullVersion());
+  // Options that steer 'opt' and 'llc'.
+  updateCacheKey(hasher, getOptimizationLevelOption());
+  updateCacheKey(hasher, getTargetTripleOption());
+  updateCacheKey(hasher, getTargetArchOption());
+  updateCacheKey(hasher, targetCPUOption);
+  for (const std::string &flag : getXoptOption())
+    updateCacheKey(hasher, flag);
+  for (const std::string &flag : getXllcOption())
+    updateCacheKey(hasher, flag);
+  updateCacheKey(hasher, getLLVMOption());
+  // The unit's content.
+  hasher.update((*buffer)->getBuffer());
+  llvm::MD5::MD5Result result;
+  hasher.final(result);
+  return result.digest().str().str();
 }
 
-// Compile LLVM bitcode to object file.
+// Compile LLVM bitcode to object file. The cpu option defaults to the one
+// derived from -mcpu; the fat-binary path overrides it per variant.
 // Return 0 on success, error code on failure.
-static int genModelObject(
-    std::string bitcodeNameWithExt, std::string &modelObjNameWithExt) {
+static int genModelObject(std::string bitcodeNameWithExt,
+    std::string &modelObjNameWithExt,
+    std::string targetCPUOption = getTargetCPUOption()) {
 
   std::string llcPath = getToolPath("llc", kLlcPath);
   Command llvmToObj(/*exePath=*/llcPath);
   int rc = llvmToObj.appendStr(getOptimizationLevelOption())
                .appendStr(getTargetTripleOption())
                .appendStr(getTargetArchOption())
-               .appendStr(getTargetCPUOption())
+               .appendStr(targetCPUOption)
+               .appendStr(getVectorLibraryOption())
                .appendList(getXllcOption())
                .appendStr(getLLVMOption())
                .appendStr("-filetype=obj")
@@ -456,6 +749,344 @@ static int genModelObject(
   return rc != 0 ? CompilerFailureInLLVMToObj : CompilerSuccess;
 }
 
+// Number of compilation units LLVM codegen is split into, from the
+// -codegen-parallel-units option (0 means one unit per hardware thread).
+static int getNumCodegenUnits() {
+  int numUnits = codegenParallelUnits;
+  if (numUnits == 0)
+    numUnits = (int)std::thread::hardware_concurrency();
+  return std::max(numUnits, 1);
+}
+
+// Split the LLVM module into 'numUnits' partitions and optimize and compile
+// each partition to its own object file, running the per-partition 'opt' and
+// 'llc' processes in parallel. The object file names are appended to
+// 'objectNamesWithExt'.
+// Returns 0 on success, error code on failure.
+static int genModelObjectsInParallel(const mlir::OwningOpRef<ModuleOp> &module,
+    std::string outputNameNoExt, int numUnits,
+    std::vector<std::string> &objectNamesWithExt) {
+  llvm::LLVMContext llvmContext;
+  std::unique_ptr<llvm::Module> llvmModule =
+      translateToLLVMIR(module, llvmContext);
+  if (!llvmModule)
+    return CompilerFailureInMLIRToLLVM;
+
+  // Write each partition's unoptimized bitcode to its own file. Local
+  // symbols crossing partition boundaries are promoted by SplitModule so
+  // that the partitions link back together.
+  std::error_code error;
+  int rc = CompilerSuccess;
+  std::vector<std::string> unoptimizedBitcodeNames;
+  std::list<llvm::FileRemover> tempFileRemovers;
+  llvm::SplitModule(
+      *llvmModule, numUnits,
+      [&](std::unique_ptr<llvm::Module> modulePart) {
+        std::string unoptimizedBitcodeNameWithExt = outputNameNoExt +
+            ".unoptimized." +
+            std::to_string(unoptimizedBitcodeNames.size()) + ".bc";
+        tempFileRemovers.emplace_back(unoptimizedBitcodeNameWithExt,
+            !keepFiles(KeepFilesOfType::Bitcode));
+        llvm::raw_fd_ostream moduleBitcodeStream(
+            unoptimizedBitcodeNameWithExt, error, llvm::sys::fs::OF_None);
+        if (error) {
+          llvm::errs() << unoptimizedBitcodeNameWithExt << ": "
+                       << error.message() << "\n";
+          rc = InvalidTemporaryFileAccess;
+          return;
+        }
+        llvm::WriteBitcodeToFile(*modulePart, moduleBitcodeStream);
+        moduleBitcodeStream.flush();
+        unoptimizedBitcodeNames.emplace_back(unoptimizedBitcodeNameWithExt);
+      },
+      /*PreserveLocals=*/false);
+  if (rc != CompilerSuccess)
+    return rc;
+
+  // Optimize and compile the partitions in parallel, each with its own
+  // 'opt' and 'llc' processes.
+  int numPartitions = unoptimizedBitcodeNames.size();
+  std::vector<int> partitionRCs(numPartitions, CompilerSuccess);
+  objectNamesWithExt.resize(numPartitions);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < numPartitions; ++i) {
+    workers.emplace_back([&, i]() {
+      std::string partitionNameNoExt =
+          outputNameNoExt + "." + std::to_string(i);
+      std::string objectNameWithExt =
+          getTargetFilename(partitionNameNoExt, EmitObj);
+      // With a persistent compilation cache, a partition whose content and
+      // codegen options are unchanged reuses its cached object file and
+      // skips 'opt' and 'llc' entirely.
+      std::string unitCacheKey;
+      if (!compilationCacheDir.getValue().empty()) {
+        unitCacheKey = computeCodegenUnitCacheKey(
+            unoptimizedBitcodeNames[i], getTargetCPUOption());
+        if (!unitCacheKey.empty() &&
+            lookupCompilationCache(unitCacheKey, objectNameWithExt)) {
+          objectNamesWithExt[i] = objectNameWithExt;
+          return;
+        }
+      }
+      std::string bitcodeNameWithExt = partitionNameNoExt + ".bc";
+      int partitionRC =
+          optimizeBitcode(unoptimizedBitcodeNames[i], bitcodeNameWithExt);
+      if (partitionRC != CompilerSuccess) {
+        partitionRCs[i] = partitionRC;
+        return;
+      }
+      partitionRC = genModelObject(bitcodeNameWithExt, objectNameWithExt);
+      partitionRCs[i] = partitionRC;
+      objectNamesWithExt[i] = objectNameWithExt;
+      if (partitionRC == CompilerSuccess && !unitCacheKey.empty())
+        updateCompilationCache(unitCacheKey, objectNameWithExt);
+    });
+    tempFileRemovers.emplace_back(outputNameNoExt + "." + std::to_string(i) +
+            ".bc",
+        !keepFiles(KeepFilesOfType::Bitcode));
+  }
+  for (std::thread &worker : workers)
+    worker.join();
+  for (int partitionRC : partitionRCs)
+    if (partitionRC != CompilerSuccess)
+      return partitionRC;
+  return CompilerSuccess;
+}
+
+// A cpu the model is additionally compiled for when -mcpu-variants is given.
+// 'feature' names the __builtin_cpu_supports() feature gating the variant at
+// load time; when empty the cpu model itself must match exactly.
+struct CPUVariant {
+  std::string cpu;
+  std::string feature;
+};
+
+// Parse the -mcpu-variants entries, each of the form 'cpu' or 'cpu=feature'.
+static void parseCPUVariants(std::vector<CPUVariant> &variants) {
+  for (const std::string &entry : mcpuVariants) {
+    auto split = StringRef(entry).split('=');
+    variants.push_back({split.first.str(), split.second.str()});
+  }
+}
+
+// Rename the entry points of one cpu variant so that several variants can be
+// linked into the same library, and hide every other symbol of non-baseline
+// variants so that only the baseline copy exports the model metadata
+// (omQueryEntryPoints, signatures, ...).
+static void specializeModuleForCPUVariant(llvm::Module &llvmModule,
+    int variantIdx, bool isBaseline,
+    llvm::ArrayRef<std::string> entryPointNames) {
+  llvm::SmallPtrSet<llvm::GlobalValue *, 4> entryFuncs;
+  for (const std::string &name : entryPointNames)
+    if (llvm::Function *F = llvmModule.getFunction(name)) {
+      F->setName(name + "_omv" + std::to_string(variantIdx));
+      entryFuncs.insert(F);
+    }
+  if (isBaseline)
+    return;
+  for (llvm::GlobalValue &GV : llvmModule.global_values()) {
+    if (GV.isDeclaration() || GV.hasLocalLinkage() ||
+        GV.hasAppendingLinkage() || GV.getName().startswith("llvm.") ||
+        entryFuncs.count(&GV))
+      continue;
+    GV.setDSOLocal(true);
+    GV.setVisibility(llvm::GlobalValue::DefaultVisibility);
+    GV.setDLLStorageClass(llvm::GlobalValue::DefaultStorageClass);
+    GV.setLinkage(llvm::GlobalValue::InternalLinkage);
+  }
+}
+
+// Emit and compile the stub that picks a cpu variant when the library is
+// loaded. Each entry point becomes a forwarding function calling through a
+// pointer that a constructor sets from cpuid-based checks. Entry points all
+// share the uniform 'OMTensorList *(OMTensorList *)' signature, so
+// 'void *(void *)' stubs cover every entry.
+// Return 0 on success, error code on failure.
+static int genCPUDispatcherObject(llvm::ArrayRef<std::string> entryPointNames,
+    const std::vector<CPUVariant> &variants, int baselineIdx,
+    std::string outputNameNoExt, std::string &dispatcherObjNameWithExt) {
+  std::error_code error;
+  std::string dispatcherSrcNameWithExt = outputNameNoExt + ".dispatcher.cpp";
+  llvm::raw_fd_ostream src(
+      dispatcherSrcNameWithExt, error, llvm::sys::fs::OF_None);
+  if (error) {
+    llvm::errs() << dispatcherSrcNameWithExt << ": " << error.message()
+                 << "\n";
+    return InvalidTemporaryFileAccess;
+  }
+  int numVariants = variants.size();
+  src << "/* Load-time cpu dispatch stubs generated by onnx-mlir. */\n";
+  src << "extern \"C\" {\n";
+  for (const std::string &name : entryPointNames)
+    for (int i = 0; i < numVariants; ++i)
+      src << "void *" << name << "_omv" << i << "(void *);\n";
+  for (const std::string &name : entryPointNames)
+    src << "static void *(*" << name << "_ptr)(void *) = " << name << "_omv"
+        << baselineIdx << ";\n";
+  src << "__attribute__((constructor)) static void omSelectCPUVariant(void) "
+         "{\n";
+  src << "#if defined(__x86_64__) || defined(__i386__)\n";
+  src << "  __builtin_cpu_init();\n";
+  for (int i = 0; i < numVariants; ++i) {
+    if (i == baselineIdx)
+      continue;
+    if (variants[i].feature.empty())
+      src << "  if (__builtin_cpu_is(\"" << variants[i].cpu << "\")) {\n";
+    else
+      src << "  if (__builtin_cpu_supports(\"" << variants[i].feature
+          << "\")) {\n";
+    for (const std::string &name : entryPointNames)
+      src << "    " << name << "_ptr = " << name << "_omv" << i << ";\n";
+    src << "    return;\n";
+    src << "  }\n";
+  }
+  src << "#endif\n";
+  src << "}\n";
+  for (const std::string &name : entryPointNames)
+    src << "void *" << name << "(void *arg) { return " << name
+        << "_ptr(arg); }\n";
+  src << "}\n";
+  src.close();
+  llvm::FileRemover dispatcherSrcRemover(
+      dispatcherSrcNameWithExt, !keepFiles(KeepFilesOfType::Object));
+
+  dispatcherObjNameWithExt =
+      getTargetFilename(outputNameNoExt + ".dispatcher", EmitObj);
+  Command cxxToObj(kCxxPath);
+  int rc = cxxToObj.appendList({"-c", "-O2", "-fPIC"})
+               .appendList({"-o", dispatcherObjNameWithExt})
+               .appendStr(dispatcherSrcNameWithExt)
+               .exec();
+  return rc != 0 ? CompilerFailureInLLVMToObj : CompilerSuccess;
+}
+
+// Compile one copy of the model for the -mcpu (or default) baseline and one
+// for each cpu named in -mcpu-variants, plus a dispatcher stub routing the
+// entry points to the copy matching the cpu detected at load time. The
+// variants are optimized and compiled by parallel 'opt' and 'llc' processes.
+// The object file names are appended to 'objectNamesWithExt'.
+// Return 0 on success, error code on failure.
+static int genModelVariantObjects(const mlir::OwningOpRef<ModuleOp> &module,
+    std::string outputNameNoExt,
+    std::vector<std::string> &objectNamesWithExt) {
+  llvm::LLVMContext llvmContext;
+  std::unique_ptr<llvm::Module> llvmModule =
+      translateToLLVMIR(module, llvmContext);
+  if (!llvmModule)
+    return CompilerFailureInMLIRToLLVM;
+
+  SmallVector<std::string, 4> entryPointNames;
+  collectEntryPointNames(*llvmModule, entryPointNames);
+
+  // The code compiled for -mcpu (or the default cpu) always comes last and
+  // is the load-time fallback.
+  std::vector<CPUVariant> variants;
+  parseCPUVariants(variants);
+  variants.push_back({mcpu.getValue(), ""});
+  int baselineIdx = variants.size() - 1;
+  bool emitDispatcher = !entryPointNames.empty();
+  if (!emitDispatcher) {
+    // Without entry points there is nothing to dispatch; compile the
+    // baseline only.
+    llvm::errs() << "Warning: the model has no entry point; "
+                    "-mcpu-variants is ignored.\n";
+    variants.erase(variants.begin(), variants.begin() + baselineIdx);
+    baselineIdx = 0;
+  }
+
+  // Write each variant's specialized unoptimized bitcode to its own file.
+  std::error_code error;
+  int numVariants = variants.size();
+  std::vector<std::string> unoptimizedBitcodeNames;
+  std::list<llvm::FileRemover> tempFileRemovers;
+  for (int i = 0; i < numVariants; ++i) {
+    // The baseline reuses the translated module; the other variants get
+    // their own clone. The baseline being last, the module is not cloned
+    // again after it was moved from.
+    std::unique_ptr<llvm::Module> variantModule = (i == baselineIdx)
+                                                      ? std::move(llvmModule)
+                                                      : llvm::CloneModule(
+                                                            *llvmModule);
+    if (emitDispatcher)
+      specializeModuleForCPUVariant(
+          *variantModule, i, i == baselineIdx, entryPointNames);
+    std::string unoptimizedBitcodeNameWithExt =
+        outputNameNoExt + ".omv" + std::to_string(i) + ".unoptimized.bc";
+    tempFileRemovers.emplace_back(
+        unoptimizedBitcodeNameWithExt, !keepFiles(KeepFilesOfType::Bitcode));
+    llvm::raw_fd_ostream moduleBitcodeStream(
+        unoptimizedBitcodeNameWithExt, error, llvm::sys::fs::OF_None);
+    if (error) {
+      llvm::errs() << unoptimizedBitcodeNameWithExt << ": " << error.message()
+                   << "\n";
+      return InvalidTemporaryFileAccess;
+    }
+    llvm::WriteBitcodeToFile(*variantModule, moduleBitcodeStream);
+    moduleBitcodeStream.flush();
+    unoptimizedBitcodeNames.emplace_back(unoptimizedBitcodeNameWithExt);
+  }
+
+  // Optimize and compile the variants in parallel, each with its own 'opt'
+  // and 'llc' processes running with the variant's cpu.
+  std::vector<int> variantRCs(numVariants, CompilerSuccess);
+  objectNamesWithExt.resize(numVariants);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < numVariants; ++i) {
+    workers.emplace_back([&, i]() {
+      std::string variantNameNoExt =
+          outputNameNoExt + ".omv" + std::to_string(i);
+      std::string targetCPUOption = variants[i].cpu.empty()
+                                        ? getTargetCPUOption()
+                                        : "--mcpu=" + variants[i].cpu;
+      std::string objectNameWithExt =
+          getTargetFilename(variantNameNoExt, EmitObj);
+      // An unchanged variant reuses its cached object file, like the
+      // parallel codegen units above.
+      std::string unitCacheKey;
+      if (!compilationCacheDir.getValue().empty()) {
+        unitCacheKey = computeCodegenUnitCacheKey(
+            unoptimizedBitcodeNames[i], targetCPUOption);
+        if (!unitCacheKey.empty() &&
+            lookupCompilationCache(unitCacheKey, objectNameWithExt)) {
+          objectNamesWithExt[i] = objectNameWithExt;
+          return;
+        }
+      }
+      std::string bitcodeNameWithExt = variantNameNoExt + ".bc";
+      int variantRC = optimizeBitcode(
+          unoptimizedBitcodeNames[i], bitcodeNameWithExt, targetCPUOption);
+      if (variantRC != CompilerSuccess) {
+        variantRCs[i] = variantRC;
+        return;
+      }
+      variantRC = genModelObject(bitcodeNameWithExt, objectNameWithExt,
+          targetCPUOption);
+      variantRCs[i] = variantRC;
+      objectNamesWithExt[i] = objectNameWithExt;
+      if (variantRC == CompilerSuccess && !unitCacheKey.empty())
+        updateCompilationCache(unitCacheKey, objectNameWithExt);
+    });
+    tempFileRemovers.emplace_back(outputNameNoExt + ".omv" +
+            std::to_string(i) + ".bc",
+        !keepFiles(KeepFilesOfType::Bitcode));
+  }
+  for (std::thread &worker : workers)
+    worker.join();
+  for (int variantRC : variantRCs)
+    if (variantRC != CompilerSuccess)
+      return variantRC;
+
+  if (!emitDispatcher)
+    return CompilerSuccess;
+  std::string dispatcherObjNameWithExt;
+  int rc = genCPUDispatcherObject(entryPointNames, variants, baselineIdx,
+      outputNameNoExt, dispatcherObjNameWithExt);
+  if (rc != CompilerSuccess)
+    return rc;
+  objectNamesWithExt.emplace_back(dispatcherObjNameWithExt);
+  return CompilerSuccess;
+}
+
 // Return 0 on success, error code on failure.
 static int genJniObject(const mlir::OwningOpRef<ModuleOp> &module,
     std::string jniSharedLibPath, std::string jniObjPath) {
@@ -474,6 +1105,28 @@ static int genJniObject(const mlir::OwningOpRef<ModuleOp> &module,
 
 // Link everything into a shared object.
 // Return 0 on success, error code on failure.
+// Link-time library dependencies of the vector math library chosen with
+// --math-lib, so the dynamic loader resolves the SIMD math entry points the
+// vectorizer emitted when the model library is loaded. libmvec and MKL are
+// named libraries; Apple's Accelerate is a framework and goes through
+// getMathLibLinkOpts instead. Static libraries leave the vendor dependency
+// to the application's final link.
+static std::vector<std::string> getMathLibLinkDeps() {
+  if (mathLib == "libmvec")
+    return {"mvec"};
+  if (mathLib == "mkl")
+    return {"mkl_rt"};
+  return {};
+}
+
+static std::vector<std::string> getMathLibLinkOpts() {
+#if defined(__APPLE__)
+  if (mathLib == "accelerate")
+    return {"-framework", "Accelerate"};
+#endif
+  return {};
+}
+
 static int genSharedLib(std::string sharedLibNameWithExt,
     std::vector<std::string> opts, std::vector<std::string> objs,
     std::vector<std::string> libs, std::vector<std::string> libDirs) {
@@ -489,7 +1142,8 @@ static int genSharedLib(std::string sharedLibNameWithExt,
       [](std::string &libDir) { libDir = "/libpath:\"" + libDir + "\""; });
 #else
   std::vector<std::string> outputOpt = {"-o", sharedLibNameWithExt};
-  std::vector<std::string> sharedLibOpts = {"-shared", "-fPIC"};
+  // -pthread covers the task scheduler in cruntime (OMTaskPool).
+  std::vector<std::string> sharedLibOpts = {"-shared", "-fPIC", "-pthread"};
   llvm::for_each(libs, [](std::string &lib) { lib = "-l" + lib; });
   llvm::for_each(libDirs, [](std::string &libDir) { libDir = "-L" + libDir; });
 #endif
@@ -505,6 +1159,124 @@ static int genSharedLib(std::string sharedLibNameWithExt,
   return rc != 0 ? CompilerFailureInObjToLib : CompilerSuccess;
 }
 
+// Prelink the model objects and the whole compiler runtime into a single
+// relocatable object and archive it. The objects keep the position
+// independent code they were compiled with, so the archive links into
+// executables and shared libraries alike, and since the runtime helpers are
+// resolved here, the application links the model without naming any
+// onnx-mlir library. On Windows lib.exe combines objects and the runtime
+// archive directly instead of partial linking.
+// Return 0 on success, error code on failure.
+static int genStaticLib(std::string staticLibNameWithExt,
+    std::string outputNameNoExt, std::vector<std::string> objs,
+    std::vector<std::string> libs, std::vector<std::string> libDirs) {
+
+#ifdef _WIN32
+  Command lib(kArPath);
+  std::vector<std::string> outputOpt = {"/NOLOGO", "/OUT:" + staticLibNameWithExt};
+  llvm::for_each(libs, [](std::string &lib) { lib = lib + ".lib"; });
+  llvm::for_each(libDirs,
+      [](std::string &libDir) { libDir = "/libpath:\"" + libDir + "\""; });
+  int rc = lib.appendList(outputOpt)
+               .appendList(objs)
+               .appendList(libDirs)
+               .appendList(libs)
+               .exec();
+  return rc != 0 ? CompilerFailureInObjToLib : CompilerSuccess;
+#else
+  std::string prelinkedObjNameWithExt = outputNameNoExt + ".prelinked.o";
+  std::vector<std::string> partialLinkOpts = {
+      "-r", "-nostdlib", "-o", prelinkedObjNameWithExt};
+  llvm::for_each(libDirs, [](std::string &libDir) { libDir = "-L" + libDir; });
+  // The runtime archives are pulled in whole: the application calls helpers
+  // (the omTensor accessors in particular) that the model objects themselves
+  // never reference, so selective member inclusion would drop them.
+  std::vector<std::string> wholeArchiveLibs;
+#if defined(__APPLE__) && defined(__clang__)
+  wholeArchiveLibs.emplace_back("-Wl,-all_load");
+  for (const std::string &lib : libs)
+    wholeArchiveLibs.emplace_back("-l" + lib);
+#else
+  wholeArchiveLibs.emplace_back("-Wl,--whole-archive");
+  for (const std::string &lib : libs)
+    wholeArchiveLibs.emplace_back("-l" + lib);
+  wholeArchiveLibs.emplace_back("-Wl,--no-whole-archive");
+#endif
+
+  Command link(kCxxPath);
+  int rc = link.appendList(partialLinkOpts)
+               .appendList(objs)
+               .appendList(libDirs)
+               .appendList(wholeArchiveLibs)
+               .exec();
+  if (rc != 0)
+    return CompilerFailureInObjToLib;
+  llvm::FileRemover prelinkedObjRemover(
+      prelinkedObjNameWithExt, !keepFiles(KeepFilesOfType::Object));
+
+  Command ar(kArPath);
+  rc = ar.appendList({"rcs", staticLibNameWithExt, prelinkedObjNameWithExt})
+           .exec();
+  return rc != 0 ? CompilerFailureInObjToLib : CompilerSuccess;
+#endif
+}
+
+// Write the registration header that accompanies an EmitStaticLib archive.
+// It declares, with C linkage, every entry point of the model plus the query
+// and signature helpers, so an application calls the statically linked model
+// directly instead of going through dlopen/dlsym.
+// Return 0 on success, error code on failure.
+static int genRegistrationHeader(const mlir::OwningOpRef<ModuleOp> &module,
+    std::string outputNameNoExt, std::string staticLibNameWithExt) {
+  // Entry point names, read from the `_entry_point_<i>` string globals the
+  // krnl entry point lowering emitted (their values are null terminated).
+  SmallVector<std::string, 4> entryPointNames;
+  module->walk([&](LLVM::GlobalOp globalOp) {
+    StringRef name = globalOp.getSymName();
+    if (!name.startswith("_entry_point_") || name.endswith("_in_sig") ||
+        name.endswith("_out_sig") || name.endswith("_bin") ||
+        name == "_entry_point_arrays")
+      return;
+    auto valueAttr = globalOp.getValueAttr().dyn_cast_or_null<StringAttr>();
+    if (!valueAttr)
+      return;
+    entryPointNames.emplace_back(valueAttr.getValue().trim('\0').str());
+  });
+
+  std::string headerNameWithExt = outputNameNoExt + ".h";
+  std::string errorMessage;
+  auto header = openOutputFile(headerNameWithExt, &errorMessage);
+  if (!header) {
+    llvm::errs() << errorMessage << "\n";
+    return InvalidOutputFileAccess;
+  }
+  llvm::raw_ostream &os = header->os();
+  os << "// Interface to the model archived in "
+     << llvm::sys::path::filename(staticLibNameWithExt).str() << ".\n"
+     << "// Generated by onnx-mlir --EmitStaticLib; do not edit. Link the\n"
+     << "// archive into the application and call the functions below\n"
+     << "// directly; no dynamic loading is involved.\n\n"
+     << "#pragma once\n\n"
+     << "#include \"OnnxMlirRuntime.h\"\n\n"
+     << "#ifdef __cplusplus\n"
+     << "extern \"C\" {\n"
+     << "#endif\n\n"
+     << "// NULL-terminated array of entry point names; pass an int64_t\n"
+     << "// pointer to also receive their number.\n"
+     << "extern const char **omQueryEntryPoints(int64_t *numOfEntryPoints);\n\n"
+     << "// JSON signatures of an entry point's inputs and outputs.\n"
+     << "extern const char *omInputSignature(const char *entryPointName);\n"
+     << "extern const char *omOutputSignature(const char *entryPointName);\n\n"
+     << "// Model entry points.\n";
+  for (const std::string &name : entryPointNames)
+    os << "extern OMTensorList *" << name << "(OMTensorList *);\n";
+  os << "\n#ifdef __cplusplus\n"
+     << "}\n"
+     << "#endif\n";
+  header->keep();
+  return CompilerSuccess;
+}
+
 // Create jar containing java runtime and model shared library (which includes
 // jni runtime).
 // Return 0 on success, error code on failure.
@@ -533,39 +1305,105 @@ static int genJniJar(const mlir::OwningOpRef<ModuleOp> &module,
 static int compileModuleToObject(const mlir::OwningOpRef<ModuleOp> &module,
     std::string outputNameWithoutExt, std::string &objectNameWithExt) {
   std::string bitcodeNameWithExt = outputNameWithoutExt + ".bc";
-  int rc = genLLVMBitcode(module, outputNameWithoutExt, bitcodeNameWithExt);
+  int rc;
+  {
+    CompileStatsPhase statsPhase("llvm-opt");
+    rc = genLLVMBitcode(module, outputNameWithoutExt, bitcodeNameWithExt);
+  }
   if (rc != CompilerSuccess)
     return rc;
   llvm::FileRemover bitcodeRemover(
       bitcodeNameWithExt, !keepFiles(KeepFilesOfType::Bitcode));
   objectNameWithExt = getTargetFilename(outputNameWithoutExt, EmitObj);
+  CompileStatsPhase statsPhase("codegen");
   return genModelObject(bitcodeNameWithExt, objectNameWithExt);
 }
 
+// Compile the module to one or more object files, splitting LLVM codegen
+// into parallel compilation units when -codegen-parallel-units asks for more
+// than one.
+// Return 0 on success, error code on failure
+static int compileModuleToObjects(const mlir::OwningOpRef<ModuleOp> &module,
+    std::string outputNameNoExt,
+    std::vector<std::string> &objectNamesWithExt) {
+  // A fat binary compiles the whole model once per requested cpu and does not
+  // combine with splitting LLVM codegen into parallel units; the variants
+  // themselves are compiled in parallel instead.
+  if (!mcpuVariants.empty()) {
+    CompileStatsPhase statsPhase("codegen");
+    return genModelVariantObjects(module, outputNameNoExt, objectNamesWithExt);
+  }
+  int numUnits = getNumCodegenUnits();
+  if (numUnits > 1) {
+    // The parallel units interleave LLVM optimization and codegen, so the
+    // whole step is accounted to the codegen phase.
+    CompileStatsPhase statsPhase("codegen");
+    return genModelObjectsInParallel(
+        module, outputNameNoExt, numUnits, objectNamesWithExt);
+  }
+  std::string modelObjNameWithExt;
+  int rc = compileModuleToObject(module, outputNameNoExt, modelObjNameWithExt);
+  if (rc == CompilerSuccess)
+    objectNamesWithExt.emplace_back(modelObjNameWithExt);
+  return rc;
+}
+
 // Return 0 on success, error code on failure
 static int compileModuleToSharedLibrary(
     const mlir::OwningOpRef<ModuleOp> &module, std::string outputNameNoExt,
     std::string &libNameWithExt) {
-  std::string modelObjNameWithExt;
-  int rc = compileModuleToObject(module, outputNameNoExt, modelObjNameWithExt);
+  std::vector<std::string> modelObjNamesWithExt;
+  int rc =
+      compileModuleToObjects(module, outputNameNoExt, modelObjNamesWithExt);
   if (rc != CompilerSuccess)
     return rc;
-  llvm::FileRemover modelObjRemover(
-      modelObjNameWithExt, !keepFiles(KeepFilesOfType::Object));
+  std::list<llvm::FileRemover> modelObjRemovers;
+  for (const std::string &modelObjNameWithExt : modelObjNamesWithExt)
+    modelObjRemovers.emplace_back(
+        modelObjNameWithExt, !keepFiles(KeepFilesOfType::Object));
   libNameWithExt = getTargetFilename(outputNameNoExt, EmitLib);
-  return genSharedLib(libNameWithExt, {}, {modelObjNameWithExt},
-      getCompilerConfig(CCM_SHARED_LIB_DEPS), {getLibraryPath()});
+  CompileStatsPhase statsPhase("link");
+  return genSharedLib(libNameWithExt, getMathLibLinkOpts(),
+      modelObjNamesWithExt, getCompilerConfig(CCM_SHARED_LIB_DEPS),
+      {getLibraryPath()});
+}
+
+// Return 0 on success, error code on failure
+static int compileModuleToStaticLibrary(
+    const mlir::OwningOpRef<ModuleOp> &module, std::string outputNameNoExt,
+    std::string &libNameWithExt) {
+  std::vector<std::string> modelObjNamesWithExt;
+  int rc =
+      compileModuleToObjects(module, outputNameNoExt, modelObjNamesWithExt);
+  if (rc != CompilerSuccess)
+    return rc;
+  std::list<llvm::FileRemover> modelObjRemovers;
+  for (const std::string &modelObjNameWithExt : modelObjNamesWithExt)
+    modelObjRemovers.emplace_back(
+        modelObjNameWithExt, !keepFiles(KeepFilesOfType::Object));
+  libNameWithExt = getTargetFilename(outputNameNoExt, EmitStaticLib);
+  {
+    CompileStatsPhase statsPhase("link");
+    rc = genStaticLib(libNameWithExt, outputNameNoExt, modelObjNamesWithExt,
+        getCompilerConfig(CCM_SHARED_LIB_DEPS), {getLibraryPath()});
+  }
+  if (rc != CompilerSuccess)
+    return rc;
+  return genRegistrationHeader(module, outputNameNoExt, libNameWithExt);
 }
 
 // Return 0 on success, error code on failure
 static int compileModuleToJniJar(
     const mlir::OwningOpRef<ModuleOp> &module, std::string outputNameNoExt) {
-  std::string modelObjNameWithExt;
-  int rc = compileModuleToObject(module, outputNameNoExt, modelObjNameWithExt);
+  std::vector<std::string> modelObjNamesWithExt;
+  int rc =
+      compileModuleToObjects(module, outputNameNoExt, modelObjNamesWithExt);
   if (rc != CompilerSuccess)
     return rc;
-  llvm::FileRemover modelObjRemover(
-      modelObjNameWithExt, !keepFiles(KeepFilesOfType::Object));
+  std::list<llvm::FileRemover> modelObjRemovers;
+  for (const std::string &modelObjNameWithExt : modelObjNamesWithExt)
+    modelObjRemovers.emplace_back(
+        modelObjNameWithExt, !keepFiles(KeepFilesOfType::Object));
 
   StringRef outputDir = llvm::sys::path::parent_path(outputNameNoExt);
   if (outputDir.empty())
@@ -595,9 +1433,14 @@ static int compileModuleToJniJar(
   { "-z", "noexecstack" }
 #endif
   std::string modelSharedLibPath = getTargetFilename(jniLibBase, EmitLib);
-  rc = genSharedLib(modelSharedLibPath, NOEXECSTACK,
-      {modelObjNameWithExt, jniObjPath}, getCompilerConfig(CCM_SHARED_LIB_DEPS),
-      {getLibraryPath()});
+  std::vector<std::string> objNamesWithExt(modelObjNamesWithExt);
+  objNamesWithExt.emplace_back(jniObjPath);
+  CompileStatsPhase statsPhase("link");
+  std::vector<std::string> linkOpts = NOEXECSTACK;
+  for (const std::string &opt : getMathLibLinkOpts())
+    linkOpts.emplace_back(opt);
+  rc = genSharedLib(modelSharedLibPath, linkOpts, objNamesWithExt,
+      getCompilerConfig(CCM_SHARED_LIB_DEPS), {getLibraryPath()});
   if (rc != CompilerSuccess)
     return rc;
   llvm::FileRemover modelSharedLibRemover(
@@ -607,18 +1450,37 @@ static int compileModuleToJniJar(
   return genJniJar(module, modelSharedLibPath, modelJniJarPath);
 }
 
-void registerDialects(mlir::MLIRContext &context) {
-  // Load our Dialect in this MLIR Context.
-  context.getOrLoadDialect<mlir::AffineDialect>();
-  context.getOrLoadDialect<mlir::vector::VectorDialect>();
-  context.getOrLoadDialect<mlir::LLVM::LLVMDialect>();
-  context.getOrLoadDialect<mlir::scf::SCFDialect>();
+void registerDialects(
+    mlir::MLIRContext &context, EmissionTargetType emissionTarget) {
+  // Register every dialect we may encounter so that the parser can load any
+  // of them on demand when reading .mlir input.
+  mlir::DialectRegistry registry;
+  registry.insert<mlir::AffineDialect, mlir::vector::VectorDialect,
+      mlir::LLVM::LLVMDialect, mlir::scf::SCFDialect, mlir::func::FuncDialect,
+      mlir::shape::ShapeDialect, mlir::math::MathDialect,
+      mlir::memref::MemRefDialect, mlir::ONNXDialect, mlir::KrnlDialect>();
+  context.appendDialectRegistry(registry);
+
+  // Eagerly load only the dialects whose operations the pipeline for the
+  // requested emission target creates programmatically (the pass manager
+  // cannot load them on demand the way the parser does). Loading a dialect
+  // constructs all its operations, so ingestion-only targets skip the
+  // lowering dialects and every target below LLVM IR skips the LLVM
+  // dialect, the single largest contributor to driver startup time.
   context.getOrLoadDialect<mlir::func::FuncDialect>();
-  context.getOrLoadDialect<mlir::shape::ShapeDialect>();
-  context.getOrLoadDialect<mlir::math::MathDialect>();
-  context.getOrLoadDialect<mlir::memref::MemRefDialect>();
   context.getOrLoadDialect<mlir::ONNXDialect>();
+  // ONNX-level instrumentation and partitioning already create Krnl ops.
   context.getOrLoadDialect<mlir::KrnlDialect>();
+  if (emissionTarget >= EmitMLIR) {
+    context.getOrLoadDialect<mlir::AffineDialect>();
+    context.getOrLoadDialect<mlir::vector::VectorDialect>();
+    context.getOrLoadDialect<mlir::scf::SCFDialect>();
+    context.getOrLoadDialect<mlir::shape::ShapeDialect>();
+    context.getOrLoadDialect<mlir::math::MathDialect>();
+    context.getOrLoadDialect<mlir::memref::MemRefDialect>();
+  }
+  if (emissionTarget >= EmitLLVMIR)
+    context.getOrLoadDialect<mlir::LLVM::LLVMDialect>();
 }
 
 namespace {
@@ -629,9 +1491,68 @@ std::string dirName(StringRef inputFilename) {
 }
 } // namespace
 
+// Speculative shape specialization caps: at most this many automatic
+// versions (model constants are duplicated into each one), and only shapes
+// covering at least one in twenty recorded runs (anything rarer is noise,
+// not a shape worth a clone).
+static constexpr int64_t maxSpeculativeShapes = 4;
+static constexpr int64_t speculativeShareDivisor = 20;
+
+// Fold the dominant entries of a recorded shape profile (written by
+// ExecutionSession::shapeProfileDump, one "<count> <spec>" line per
+// signature) into the specialized-shapes list. The hot shapes then get
+// static-shape versions with the usual runtime dispatch guard and generic
+// fallback, without the user listing them by hand.
+static std::string specializedShapesWithProfile() {
+  if (shapeProfileFile.getValue().empty())
+    return specializedShapes;
+  auto bufferOrError = llvm::MemoryBuffer::getFile(shapeProfileFile);
+  if (!bufferOrError) {
+    llvm::errs() << "Warning: cannot open shape profile '" << shapeProfileFile
+                 << "'; no speculative specialization.\n";
+    return specializedShapes;
+  }
+  std::vector<std::pair<int64_t, std::string>> entries;
+  int64_t total = 0;
+  llvm::SmallVector<StringRef, 32> lines;
+  bufferOrError.get()->getBuffer().split(lines, '\n');
+  for (StringRef line : lines) {
+    line = line.trim();
+    if (line.empty() || line.startswith("#"))
+      continue;
+    StringRef countStr, spec;
+    std::tie(countStr, spec) = line.split(' ');
+    int64_t count = 0;
+    if (countStr.getAsInteger(10, count) || count <= 0 || spec.trim().empty())
+      continue;
+    entries.emplace_back(count, spec.trim().str());
+    total += count;
+  }
+  std::stable_sort(entries.begin(), entries.end(),
+      [](const std::pair<int64_t, std::string> &a,
+          const std::pair<int64_t, std::string> &b) {
+        return a.first > b.first;
+      });
+  // Manually listed specializations come first and keep their entry point
+  // indices; the speculative ones follow.
+  std::string combined = specializedShapes;
+  int64_t kept = 0;
+  for (const std::pair<int64_t, std::string> &entry : entries) {
+    if (kept >= maxSpeculativeShapes ||
+        entry.first < total / speculativeShareDivisor)
+      break;
+    if (!combined.empty())
+      combined += ";";
+    combined += entry.second;
+    ++kept;
+  }
+  return combined;
+}
+
 // Return 0 on success, error number on failure.
 int processInputFile(StringRef inputFilename, mlir::MLIRContext &context,
     mlir::OwningOpRef<ModuleOp> &module, std::string *errorMessage) {
+  CompileStatsPhase statsPhase("import");
   // Decide if the input file is an ONNX model (either ONNX protobuf or JSON) or
   // a model specified in MLIR. The extension of the file is the decider.
   bool inputIsONNX = inputFilename.endswith(".onnx");
@@ -651,8 +1572,16 @@ int processInputFile(StringRef inputFilename, mlir::MLIRContext &context,
     options.useOnnxModelTypes = useOnnxModelTypes;
     options.invokeOnnxVersionConverter = invokeOnnxVersionConverter;
     options.shapeInformation = shapeInformation;
+    options.shapeContracts = shapeContracts;
+    options.specializedShapes = specializedShapesWithProfile();
+    options.lazyOutputs = lazyOutputs;
+    options.pruneOutputs = pruneOutputs;
     options.allowSorting = allowSorting;
     options.externalDataDir = dirName(inputFilename);
+    options.mmapExternalData = mmapExternalData;
+    // Version-lifted models share the persistent compilation cache
+    // directory.
+    options.versionCacheDir = compilationCacheDir;
     return ImportFrontendModelFile(
         inputFilename, context, module, errorMessage, options);
   } else if (inputIsMLIR)
@@ -664,11 +1593,17 @@ int processInputFile(StringRef inputFilename, mlir::MLIRContext &context,
 int processInputArray(const void *onnxBuffer, int bufferSize,
     mlir::MLIRContext &context, mlir::OwningOpRef<ModuleOp> &module,
     std::string *errorMessage) {
+  CompileStatsPhase statsPhase("import");
   ImportOptions options;
   options.useOnnxModelTypes = useOnnxModelTypes;
   options.invokeOnnxVersionConverter = invokeOnnxVersionConverter;
   options.allowSorting = allowSorting;
   options.shapeInformation = shapeInformation;
+  options.shapeContracts = shapeContracts;
+  options.specializedShapes = specializedShapesWithProfile();
+  options.lazyOutputs = lazyOutputs;
+  options.pruneOutputs = pruneOutputs;
+  options.versionCacheDir = compilationCacheDir;
   return ImportFrontendModelArray(
       onnxBuffer, bufferSize, context, module, errorMessage, options);
 }
@@ -734,6 +1669,7 @@ static int emitOutputFiles(std::string outputNameNoExt,
   } break;
   case EmitLib: {
     addCompilerConfig(CCM_SHARED_LIB_DEPS, {"cruntime"});
+    addCompilerConfig(CCM_SHARED_LIB_DEPS, getMathLibLinkDeps());
     std::string sharedLibNameWithExt;
     int rc = compileModuleToSharedLibrary(
         module, outputNameNoExt, sharedLibNameWithExt);
@@ -750,6 +1686,7 @@ static int emitOutputFiles(std::string outputNameNoExt,
   } break;
   case EmitJNI: {
     addCompilerConfig(CCM_SHARED_LIB_DEPS, {"jniruntime", "cruntime"});
+    addCompilerConfig(CCM_SHARED_LIB_DEPS, getMathLibLinkDeps());
     int rc = compileModuleToJniJar(module, outputNameNoExt);
     if (rc != CompilerSuccess)
       return rc;
@@ -762,6 +1699,23 @@ static int emitOutputFiles(std::string outputNameNoExt,
       printf(
           "JNI archive %s.jar has been compiled.\n", outputNameNoExt.c_str());
   } break;
+  case EmitStaticLib: {
+    addCompilerConfig(CCM_SHARED_LIB_DEPS, {"cruntime"});
+    std::string staticLibNameWithExt;
+    int rc = compileModuleToStaticLibrary(
+        module, outputNameNoExt, staticLibNameWithExt);
+    if (rc != CompilerSuccess)
+      return rc;
+    if (keepFiles(KeepFilesOfType::MLIR)) {
+      rc = outputCode(module, outputNameNoExt + ".llvm.mlir");
+      if (rc != CompilerSuccess)
+        return rc;
+    }
+    if (VerboseOutput)
+      printf("Static library %s and registration header %s.h have been "
+             "compiled.\n",
+          staticLibNameWithExt.c_str(), outputNameNoExt.c_str());
+  } break;
   default: {
     // Emit the version with all constants included.
     std::string ouputNameWithExt =
@@ -834,6 +1788,40 @@ static std::string getDataLayout(const Location &loc) {
   return dataLayoutString;
 }
 
+// Derive the SIMD register width in bits from the requested target
+// (-march/-mcpu). The krnl-level simdization picks fixed vector lengths at
+// compile time, so the width must reflect the deployment target; for the
+// scalable-vector ISAs (SVE, RVV) the model is compiled for the register
+// width the target implements. Recognized hints: the avx/avx512 x86 feature
+// names, the RVV zvl<N>b minimum-vector-length extension in -march, and the
+// SVE cpu names known to implement 256-bit registers. Everything else uses
+// the 128-bit baseline (NEON, SSE, VXE, SVE/RVV minimum).
+static int64_t deriveMachineSimdBitWidth() {
+  llvm::StringRef arch(march);
+  llvm::StringRef cpu(mcpu);
+  // x86 AVX family.
+  if (arch.contains("avx512") || cpu.contains("avx512"))
+    return 512;
+  if (arch.contains("avx") || cpu.startswith("skylake") ||
+      cpu.startswith("haswell") || cpu.startswith("znver"))
+    return 256;
+  // RISC-V V: the zvl<N>b extension states the minimum vector length the
+  // target guarantees, e.g. -march=rv64gcv_zvl256b.
+  size_t zvlPos = arch.find("zvl");
+  if (zvlPos != llvm::StringRef::npos) {
+    int64_t bits = 0;
+    llvm::StringRef bitsStr = arch.drop_front(zvlPos + 3).take_while(
+        [](char c) { return c >= '0' && c <= '9'; });
+    if (!bitsStr.getAsInteger(10, bits) && bits >= 128)
+      return bits;
+  }
+  // AArch64 SVE: the architecture alone does not fix the register width, so
+  // rely on the cpu; neoverse-v1 (Graviton3) implements 256-bit SVE.
+  if (arch.contains("sve") && cpu == "neoverse-v1")
+    return 256;
+  return 128;
+}
+
 // Return 0 on success, error code on failure.
 static int setupModule(mlir::OwningOpRef<ModuleOp> &module,
     mlir::MLIRContext &context, std::string outputNameNoExt) {
@@ -851,6 +1839,15 @@ static int setupModule(mlir::OwningOpRef<ModuleOp> &module,
   moduleOp.setAttr(LLVM::LLVMDialect::getDataLayoutAttrName(),
       StringAttr::get(&context, getDataLayout(loc)));
 
+  // Fix the SIMD register width that all vector-length decisions during
+  // lowering assume, from the requested target.
+  VectorBuilder::setMachineSimdBitWidth(deriveMachineSimdBitWidth());
+
+  // Fix the cache geometry that the blocked matmul schedules derive their
+  // cache-level tile sizes from, from the requested target cpu (or the host
+  // when none is requested).
+  TargetCacheGeometry::setFromTargetCPU(mcpu);
+
   // Set the module target accelerators.
   SmallVector<Attribute, 2> accelsAttr;
   for (auto *accel : onnx_mlir::accel::Accelerator::getAccelerators()) {
@@ -893,11 +1890,32 @@ int compileModule(mlir::OwningOpRef<ModuleOp> &module,
   // Initialize accelerator(s) if required.
   if (!maccel.empty())
     onnx_mlir::accel::initAccelerators(maccel);
+  if (!acceleratorPlugins.empty() &&
+      !onnx_mlir::accel::loadAcceleratorPlugins(acceleratorPlugins))
+    return InvalidCompilerOption;
 
   int rc = setupModule(module, context, outputNameNoExt);
   if (rc != CompilerSuccess)
     return rc;
 
+  // With a persistent compilation cache, probe it before running the pass
+  // pipeline: on a hit the cached artifact is the output and both lowering
+  // and codegen are skipped.
+  std::string cacheKey;
+  std::string artifactNameWithExt;
+  if (!compilationCacheDir.getValue().empty() && !printIR &&
+      (emissionTarget == EmitObj || emissionTarget == EmitLib ||
+          emissionTarget == EmitJNI)) {
+    cacheKey = computeCompilationCacheKey(module, emissionTarget);
+    artifactNameWithExt = getTargetFilename(outputNameNoExt, emissionTarget);
+    if (lookupCompilationCache(cacheKey, artifactNameWithExt)) {
+      if (VerboseOutput)
+        printf("Reused cached artifact for %s (key %s).\n",
+            artifactNameWithExt.c_str(), cacheKey.c_str());
+      return CompilerSuccess;
+    }
+  }
+
   mlir::PassManager pm(&context, mlir::OpPassManager::Nesting::Implicit);
   // TODO(tung): Revise adding passes. The current mechanism does not work if
   // there are multiple accelerators enabled at the same time. It's because
@@ -913,9 +1931,29 @@ int compileModule(mlir::OwningOpRef<ModuleOp> &module,
     addPasses(module, pm, emissionTarget);
   mlir::applyPassManagerCLOptions(pm);
   mlir::applyDefaultTimingPassManagerCLOptions(pm);
-
-  if (mlir::failed(pm.run(*module)))
+  attachCompileStatsInstrumentation(pm);
+  // Deferring verification trades per-pass diagnostics for compile time: the
+  // module is checked once below instead of after each pass.
+  if (deferVerification)
+    pm.enableVerifier(false);
+
+  bool loweringFailed;
+  {
+    CompileStatsPhase statsPhase("lowering");
+    loweringFailed = mlir::failed(pm.run(*module));
+  }
+  if (loweringFailed) {
+    emitCompileStatsReport();
     return CompilerFailure;
-  return emitOutput(module, context, outputNameNoExt, pm, emissionTarget);
+  }
+  if (deferVerification && mlir::failed(mlir::verify(*module))) {
+    emitCompileStatsReport();
+    return CompilerFailure;
+  }
+  rc = emitOutput(module, context, outputNameNoExt, pm, emissionTarget);
+  if (rc == CompilerSuccess && !cacheKey.empty())
+    updateCompilationCache(cacheKey, artifactNameWithExt);
+  emitCompileStatsReport();
+  return rc;
 }
 } // namespace onnx_mlir
@@ -72,7 +72,15 @@ struct Command {
   int exec(std::string wdir = "") const;
 };
 
-void registerDialects(mlir::MLIRContext &context);
+// Register every dialect the compiler may encounter so the parser can load
+// any of them on demand, and eagerly load only those whose operations the
+// pipeline for the given emission target creates programmatically. Loading a
+// dialect constructs all its operations, which is a measurable share of the
+// driver's fixed startup cost, so short ingestion-only invocations
+// (EmitONNXBasic, EmitONNXIR) skip the lowering dialects entirely. The
+// default loads everything, for callers that do not know the target yet.
+void registerDialects(
+    mlir::MLIRContext &context, EmissionTargetType emissionTarget = EmitLib);
 
 // Get Tool path, see comments in CompilerUtils.cpp for more details.
 std::string getToolPath(
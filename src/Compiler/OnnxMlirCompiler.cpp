@@ -41,7 +41,9 @@ static std::string deriveOutputFileName(
   EmissionTargetType emissionTarget = EmissionTargetType::EmitLib;
   for (int i = 0; i < num; ++i) {
     if (flagVect[i].find("-Emit") == 0 || flagVect[i].find("--Emit") == 0) {
-      if (flagVect[i].find("Lib") <= 6)
+      if (flagVect[i].find("StaticLib") <= 6)
+        emissionTarget = EmissionTargetType::EmitStaticLib;
+      else if (flagVect[i].find("Lib") <= 6)
         emissionTarget = EmissionTargetType::EmitLib;
       else if (flagVect[i].find("JNI") <= 6)
         emissionTarget = EmissionTargetType::EmitJNI;
@@ -101,9 +103,15 @@ ONNX_MLIR_EXPORT int64_t omCompileFromArray(const void *inputBuffer,
     int64_t bufferSize, const char *outputBaseName,
     EmissionTargetType emissionTarget, const char **outputFilename,
     const char **errorMessage) {
+  // Compilation reads the process-wide option state (the CompilerOptions
+  // cl::opt globals) throughout, so serialize in-process compilations on the
+  // options guard; concurrent calls are then safe, just not parallel. For
+  // parallel compilation use omCompileFromFile, which runs a separate
+  // onnx-mlir process per call.
+  std::lock_guard<std::recursive_mutex> lock(getCompilerOptionsGuard());
   mlir::OwningOpRef<mlir::ModuleOp> module;
   mlir::MLIRContext context;
-  registerDialects(context);
+  registerDialects(context, emissionTarget);
 
   std::string internalErrorMessage;
   int rc = processInputArray(
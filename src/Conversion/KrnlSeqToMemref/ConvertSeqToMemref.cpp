@@ -54,11 +54,24 @@ void ConvertSeqToMemrefPass::runOnOperation() {
     return;
   MLIRContext *ctx = &getContext();
 
+  // KrnlSeqAppendOp takes ownership of its input sequence and moves the
+  // element pointers into its result, so a deallocation generated for the
+  // input (e.g. by the buffer deallocation pass) would free elements that
+  // are still alive in the result. Drop such deallocations; the append
+  // itself frees the old pointer array when it has to grow.
+  funcOp.walk([](KrnlSeqAppendOp appendOp) {
+    for (Operation *user :
+        llvm::make_early_inc_range(appendOp.input_sequence().getUsers()))
+      if (isa<KrnlSeqDeallocOp>(user))
+        user->erase();
+  });
+
   // The first thing to define is the conversion target. This will define the
   // final target for this lowering.
   ConversionTarget target(getContext());
 
   target.addIllegalOp<KrnlSeqAllocOp>();
+  target.addIllegalOp<KrnlSeqAppendOp>();
   target.addIllegalOp<KrnlSeqDeallocOp>();
   target.addIllegalOp<KrnlSeqExtractOp>();
   target.addIllegalOp<KrnlSeqStoreOp>();
@@ -73,6 +86,7 @@ void ConvertSeqToMemrefPass::runOnOperation() {
   // Define patterns.
   KrnlTypeConverter typeConverter;
   populateLoweringKrnlSeqAllocOpPattern(typeConverter, patterns, ctx);
+  populateLoweringKrnlSeqAppendOpPattern(typeConverter, patterns, ctx);
   populateLoweringKrnlSeqDeallocOpPattern(typeConverter, patterns, ctx);
   populateLoweringKrnlSeqExtractOpPattern(typeConverter, patterns, ctx);
   populateLoweringKrnlSeqStoreOpPattern(typeConverter, patterns, ctx);
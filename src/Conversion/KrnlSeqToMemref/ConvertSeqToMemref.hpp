@@ -21,9 +21,19 @@
 namespace onnx_mlir {
 namespace krnl {
 
+/// Emit code computing the storage capacity behind a sequence of 'length'
+/// elements: the next power of two >= length, and at least 4. KrnlSeqAllocOp
+/// allocates to this capacity and KrnlSeqAppendOp recomputes it from the
+/// length to decide whether a sequence can grow in place.
+mlir::Value emitSeqStorageCapacity(
+    mlir::OpBuilder &builder, mlir::Location loc, mlir::Value length);
+
 void populateLoweringKrnlSeqAllocOpPattern(mlir::TypeConverter &typeConverter,
     mlir::RewritePatternSet &patterns, mlir::MLIRContext *ctx);
 
+void populateLoweringKrnlSeqAppendOpPattern(mlir::TypeConverter &typeConverter,
+    mlir::RewritePatternSet &patterns, mlir::MLIRContext *ctx);
+
 void populateLoweringKrnlSeqDeallocOpPattern(mlir::TypeConverter &typeConverter,
     mlir::RewritePatternSet &patterns, mlir::MLIRContext *ctx);
 
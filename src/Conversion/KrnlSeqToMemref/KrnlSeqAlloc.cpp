@@ -14,9 +14,12 @@
 
 #include "mlir/Conversion/LLVMCommon/Pattern.h"
 #include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/Math/IR/Math.h"
 
+#include "src/Conversion/KrnlSeqToMemref/ConvertSeqToMemref.hpp"
 #include "src/Conversion/KrnlToLLVM/KrnlToLLVMHelper.hpp"
 #include "src/Dialect/Krnl/KrnlHelper.hpp"
 #include "src/Dialect/Krnl/KrnlOps.hpp"
@@ -31,6 +34,23 @@ using namespace onnx_mlir;
 namespace onnx_mlir {
 namespace krnl {
 
+Value emitSeqStorageCapacity(OpBuilder &builder, Location loc, Value length) {
+  MultiDialectBuilder<MathBuilder> create(builder, loc);
+  Type i64Ty = builder.getI64Type();
+  Value lenI64 = builder.create<arith::IndexCastOp>(loc, i64Ty, length);
+  Value one = create.math.constant(i64Ty, 1);
+  Value minCap = create.math.constant(i64Ty, 4);
+  // Next power of two >= max(length, 1) is 1 << (64 - ctlz(m - 1)), with
+  // ctlz(0) defined as 64.
+  Value m = builder.create<arith::MaxSIOp>(loc, lenI64, one);
+  Value lz = builder.create<math::CountLeadingZerosOp>(
+      loc, create.math.sub(m, one));
+  Value shift = create.math.sub(create.math.constant(i64Ty, 64), lz);
+  Value pow2 = builder.create<arith::ShLIOp>(loc, one, shift);
+  Value cap = builder.create<arith::MaxSIOp>(loc, pow2, minCap);
+  return create.math.castToIndex(cap);
+}
+
 class KrnlSeqAllocOpLowering : public ConversionPattern {
 public:
   explicit KrnlSeqAllocOpLowering(
@@ -48,9 +68,18 @@ public:
     Value outputSeq = thisOp.getResult();
     auto outputType = outputSeq.getType().cast<MemRefType>();
     Value alloc;
-    if (outputType.isDynamicDim(0))
-      alloc = create.mem.alloc(outputType, operandAdaptor.length());
-    else
+    if (outputType.isDynamicDim(0)) {
+      // Over-allocate the pointer array to the capacity invariant so that
+      // KrnlSeqAppendOp can grow this sequence in place; the memref
+      // descriptor keeps the logical length.
+      Value length = operandAdaptor.length()[0];
+      Value capacity = emitSeqStorageCapacity(rewriter, loc, length);
+      Value buffer = create.mem.alloc(outputType, ValueRange{capacity});
+      alloc = rewriter.create<memref::ReinterpretCastOp>(loc, outputType,
+          buffer, /*offset=*/rewriter.getIndexAttr(0),
+          ArrayRef<OpFoldResult>{length},
+          ArrayRef<OpFoldResult>{rewriter.getIndexAttr(1)});
+    } else
       alloc = create.mem.alloc(outputType);
     rewriter.replaceOp(op, alloc);
     return success();
@@ -0,0 +1,114 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ KrnlSeqAppend.cpp - Lower KrnlSeqAppendOp ----------------===//
+//
+// Copyright 2022 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the KrnlSeqAppendOp operator.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Conversion/LLVMCommon/Pattern.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+
+#include "src/Conversion/KrnlSeqToMemref/ConvertSeqToMemref.hpp"
+#include "src/Conversion/KrnlToLLVM/KrnlToLLVMHelper.hpp"
+#include "src/Dialect/Krnl/KrnlHelper.hpp"
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Dialect/Mlir/DialectBuilder.hpp"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "krnl_to_llvm"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace onnx_mlir {
+namespace krnl {
+
+class KrnlSeqAppendOpLowering : public ConversionPattern {
+public:
+  explicit KrnlSeqAppendOpLowering(
+      TypeConverter &typeConverter, MLIRContext *context)
+      : ConversionPattern(
+            typeConverter, KrnlSeqAppendOp::getOperationName(), 1, context) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    KrnlSeqAppendOpAdaptor operandAdaptor(operands);
+    Location loc = op->getLoc();
+    MultiDialectBuilder<MathBuilder, MemRefBuilder> create(rewriter, loc);
+
+    Value seq = operandAdaptor.input_sequence();
+    auto seqType = seq.getType().cast<MemRefType>();
+    assert(seqType.isDynamicDim(0) &&
+           "KrnlSeqAppendOp requires a sequence with dynamic length");
+
+    Value length = create.mem.dim(seq, 0);
+    Value capacity = emitSeqStorageCapacity(rewriter, loc, length);
+    Value newLength = create.math.add(length, create.math.constantIndex(1));
+    Value hasRoom = create.math.sle(newLength, capacity);
+
+    // When the storage has room for one more element, extend the descriptor
+    // over the same storage: no allocation and no copy. Otherwise allocate
+    // storage of twice the capacity, move the element pointers into it, and
+    // free the old pointer array (the elements themselves are not touched).
+    auto ifOp = rewriter.create<scf::IfOp>(loc, TypeRange{seqType}, hasRoom,
+        /*withElseRegion=*/true);
+    {
+      OpBuilder thenBuilder = ifOp.getThenBodyBuilder();
+      Value extended = thenBuilder.create<memref::ReinterpretCastOp>(loc,
+          seqType, seq, /*offset=*/thenBuilder.getIndexAttr(0),
+          ArrayRef<OpFoldResult>{newLength},
+          ArrayRef<OpFoldResult>{thenBuilder.getIndexAttr(1)});
+      thenBuilder.create<scf::YieldOp>(loc, extended);
+    }
+    {
+      OpBuilder elseBuilder = ifOp.getElseBodyBuilder();
+      MultiDialectBuilder<MathBuilder, MemRefBuilder> create(elseBuilder, loc);
+      Value newCapacity =
+          create.math.mul(capacity, create.math.constantIndex(2));
+      Value buffer = create.mem.alloc(seqType, ValueRange{newCapacity});
+      Value newSeq = elseBuilder.create<memref::ReinterpretCastOp>(loc,
+          seqType, buffer, /*offset=*/elseBuilder.getIndexAttr(0),
+          ArrayRef<OpFoldResult>{newLength},
+          ArrayRef<OpFoldResult>{elseBuilder.getIndexAttr(1)});
+      elseBuilder.create<scf::ForOp>(loc, create.math.constantIndex(0), length,
+          create.math.constantIndex(1), ValueRange(),
+          [&](OpBuilder &bodyBuilder, Location bodyLoc, Value forInduction,
+              ValueRange iterArgs) {
+            auto element = bodyBuilder.create<memref::LoadOp>(
+                bodyLoc, seq, forInduction);
+            bodyBuilder.create<memref::StoreOp>(
+                bodyLoc, element, newSeq, forInduction);
+            bodyBuilder.create<scf::YieldOp>(bodyLoc);
+          });
+      create.mem.dealloc(seq);
+      elseBuilder.create<scf::YieldOp>(loc, newSeq);
+    }
+
+    // Copy the appended element into the last slot. The KrnlSeqStoreOp is
+    // lowered by its own pattern in this conversion.
+    Value output = ifOp.getResult(0);
+    rewriter.create<KrnlSeqStoreOp>(
+        loc, operandAdaptor.input(), output, length);
+
+    rewriter.replaceOp(op, output);
+    return success();
+  }
+};
+
+void populateLoweringKrnlSeqAppendOpPattern(TypeConverter &typeConverter,
+    RewritePatternSet &patterns, MLIRContext *ctx) {
+  patterns.insert<KrnlSeqAppendOpLowering>(typeConverter, ctx);
+}
+
+} // namespace krnl
+} // namespace onnx_mlir
@@ -13,8 +13,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Analysis/DataLayoutAnalysis.h"
+#include "mlir/Dialect/Affine/Analysis/LoopAnalysis.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Affine/LoopUtils.h"
+#include "mlir/Dialect/Affine/Utils.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
 #include "mlir/IR/BuiltinTypes.h"
@@ -29,6 +31,7 @@
 #include "src/Support/Common.hpp"
 
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MemoryBuffer.h"
 
 #include <functional>
 #include <mutex>
@@ -43,6 +46,45 @@ namespace krnl {
 UnrollAndJamMap unrollAndJamMap;
 std::mutex unrollAndJamMutex;
 
+UnrollAndJamOverrides unrollAndJamOverrides;
+// The overrides are parsed once, by the first pass instance to run; all
+// instances are created from the same compiler options.
+static bool unrollAndJamOverridesParsed = false;
+
+int64_t UnrollAndJamOverrides::lookup(
+    Operation *op, llvm::StringRef category) const {
+  // Per-node overrides are matched against the names carried by the
+  // operation's location, where the lowering to krnl kept the onnx_node_name.
+  Location loc = op->getLoc();
+  while (auto nameLoc = loc.dyn_cast<NameLoc>()) {
+    auto nodeEntry = byNode.find(nameLoc.getName().str());
+    if (nodeEntry != byNode.end()) {
+      auto catEntry = nodeEntry->second.find(category.str());
+      if (catEntry != nodeEntry->second.end())
+        return catEntry->second;
+    }
+    loc = nameLoc.getChildLoc();
+  }
+  auto catEntry = byCategory.find(category.str());
+  return (catEntry != byCategory.end()) ? catEntry->second : 0;
+}
+
+// Parse comma separated "category=factor" pairs into dest. Malformed pairs
+// and non-positive factors are ignored.
+static void parseUnrollFactors(
+    llvm::StringRef spec, std::map<std::string, int64_t> &dest) {
+  llvm::SmallVector<llvm::StringRef, 4> pairs;
+  spec.split(pairs, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (llvm::StringRef pair : pairs) {
+    llvm::StringRef category, factorStr;
+    std::tie(category, factorStr) = pair.trim().split('=');
+    int64_t factor;
+    if (!category.empty() && !factorStr.trim().getAsInteger(10, factor) &&
+        factor > 0)
+      dest[category.trim().str()] = factor;
+  }
+}
+
 // Since Krnl Dialect allows optimizations to be specified in the form of
 // recipes without being applied, some IR block may exist under Krnl loops
 // corresponding to loops that will be materialized only after relevant
@@ -529,6 +571,20 @@ static LogicalResult interpretOperation(Operation *op, OpBuilder &builder,
 
     opsToErase.insert(op);
     return success();
+  } else if (auto parallelOp = dyn_cast_or_null<KrnlParallelOp>(op)) {
+    LLVM_DEBUG(llvm::dbgs()
+               << DEBUG_TYPE << " interpret parallel op " << parallelOp
+               << "\n");
+    // Tag the affine.for ops that materialized for the given loop references.
+    // They are rewritten into affine.parallel once all loop bodies are in
+    // their final position, after the mover has run, because parallelization
+    // replaces the affine.for op and would otherwise leave dangling entries
+    // in loopRefToOp.
+    for (Value loopRef : parallelOp.loops())
+      loopRefToOp[loopRef]->setAttr(
+          "krnl.parallelize", builder.getUnitAttr());
+    opsToErase.insert(op);
+    return success();
   } else if (auto unrollOp = dyn_cast_or_null<KrnlUnrollOp>(op)) {
     LLVM_DEBUG(llvm::dbgs()
                << DEBUG_TYPE << " interpret unroll op " << unrollOp << "\n");
@@ -592,6 +648,204 @@ AffineTypeConverter::AffineTypeConverter() {
   });
 }
 
+//===----------------------------------------------------------------------===//
+// Software prefetch insertion.
+//===----------------------------------------------------------------------===//
+
+// Prefetch distances, in iterations of the innermost loop, for the prefetches
+// targeting the first and second cache level. A handful of iterations covers
+// the latency of an L1 miss in the unrolled compute loops generated here; the
+// larger distance pulls the next tile into L2 while the current one is being
+// consumed.
+static constexpr int64_t prefetchDistanceL1 = 4;
+static constexpr int64_t prefetchDistanceL2 = 32;
+
+// Loops nested inside an operation carrying this unit attribute are left
+// alone. Lowerings can set it on the loops of an op whose accesses are known
+// not to benefit, e.g. because the data is already in a tile buffer.
+static constexpr const char *noPrefetchAttrName = "krnl.no_prefetch";
+
+// Insert software prefetches for the loads of the innermost affine loops.
+// The access maps are fully known at this point, so a prefetch is simply the
+// load's map with the loop induction variable advanced by the prefetch
+// distance. Loads whose address does not depend on the innermost induction
+// variable stay in cache across iterations and are not prefetched; loads
+// sharing one access function (as left by unroll-and-jam) are prefetched
+// once.
+static void insertPrefetches(func::FuncOp funcOp) {
+  MLIRContext *ctx = funcOp.getContext();
+  funcOp.walk([&](AffineForOp forOp) {
+    // Innermost loops only; a prefetch in an outer loop would be issued long
+    // before the data is used.
+    bool innermost = true;
+    forOp.getBody()->walk([&](Operation *op) {
+      if (isa<AffineForOp, AffineParallelOp>(op)) {
+        innermost = false;
+        return WalkResult::interrupt();
+      }
+      return WalkResult::advance();
+    });
+    if (!innermost)
+      return;
+    for (Operation *ancestor = forOp; ancestor;
+         ancestor = ancestor->getParentOp())
+      if (ancestor->hasAttr(noPrefetchAttrName))
+        return;
+    // A loop too short to reach the prefetch distance only adds overhead.
+    if (Optional<uint64_t> tripCount = getConstantTripCount(forOp))
+      if (*tripCount <= (uint64_t)prefetchDistanceL1)
+        return;
+
+    Value iv = forOp.getInductionVar();
+    int64_t step = forOp.getStep();
+    SmallVector<std::tuple<Value, AffineMap, SmallVector<Value, 4>>, 4> done;
+    forOp.getBody()->walk([&](AffineLoadOp loadOp) {
+      AffineMap map = loadOp.getAffineMap();
+      SmallVector<Value, 4> operands(loadOp.getMapOperands());
+      auto ivPosIt = llvm::find(operands, iv);
+      if (ivPosIt == operands.end())
+        return;
+      unsigned ivPos = std::distance(operands.begin(), ivPosIt);
+      if (ivPos >= map.getNumDims())
+        return;
+      for (auto &entry : done)
+        if (std::get<0>(entry) == loadOp.getMemRef() &&
+            std::get<1>(entry) == map && std::get<2>(entry) == operands)
+          return;
+      done.emplace_back(loadOp.getMemRef(), map, operands);
+
+      OpBuilder builder(loadOp);
+      Location loc = loadOp.getLoc();
+      AffineExpr ivDim = getAffineDimExpr(ivPos, ctx);
+      AffineMap l1Map = map.replace(ivDim, ivDim + prefetchDistanceL1 * step,
+          map.getNumDims(), map.getNumSymbols());
+      builder.create<AffinePrefetchOp>(loc, loadOp.getMemRef(), l1Map,
+          operands, /*isWrite=*/false, /*localityHint=*/3,
+          /*isDataCache=*/true);
+      AffineMap l2Map = map.replace(ivDim, ivDim + prefetchDistanceL2 * step,
+          map.getNumDims(), map.getNumSymbols());
+      builder.create<AffinePrefetchOp>(loc, loadOp.getMemRef(), l2Map,
+          operands, /*isWrite=*/false, /*localityHint=*/2,
+          /*isDataCache=*/true);
+    });
+  });
+}
+
+//===----------------------------------------------------------------------===//
+// Stride-driven loop interchange.
+//===----------------------------------------------------------------------===//
+
+// The lowerings iterate in ONNX logical dimension order, which can stride
+// badly over memory when the data layout disagrees with it: reducing over
+// the axis that is innermost in memory, or walking a transposed or
+// non-canonically strided operand, touches a new cache line on every
+// iteration. Interchange runs on the affine loops interpreted from
+// krnl.iterate while the loads and stores are still krnl ops indexing with
+// plain induction variables, so both the loop bands and the per-loop access
+// strides are directly visible; the hand-scheduled loops that krnl.matmul
+// expands into during the later pattern conversion are never seen.
+
+// Add, for every load and store under `root`, the distance in bytes between
+// the addresses touched on consecutive iterations of each of the band's
+// loops into `costs` (indexed like `ivs`). An access whose address depends
+// on a band induction variable through computed indices cannot be
+// attributed to one loop and is skipped. Return the number of accesses
+// analyzed.
+static int64_t accumulateAccessStrides(
+    AffineForOp root, ArrayRef<Value> ivs, MutableArrayRef<int64_t> costs) {
+  int64_t analyzed = 0;
+  root.getBody()->walk([&](Operation *op) {
+    Value memref;
+    ValueRange indices;
+    if (auto loadOp = dyn_cast<KrnlLoadOp>(op)) {
+      memref = loadOp.memref();
+      indices = loadOp.indices();
+    } else if (auto storeOp = dyn_cast<KrnlStoreOp>(op)) {
+      memref = storeOp.memref();
+      indices = storeOp.indices();
+    } else {
+      return;
+    }
+    MemRefType type = memref.getType().dyn_cast<MemRefType>();
+    if (!type || !type.getElementType().isIntOrFloat())
+      return;
+    SmallVector<int64_t, 4> strides;
+    int64_t offset;
+    if (failed(getStridesAndOffset(type, strides, offset)))
+      return;
+    int64_t elemBytes =
+        std::max<int64_t>(type.getElementTypeBitWidth() / 8, 1);
+    // Every index must be an induction variable or defined outside the band;
+    // anything computed inside it could hide a band variable.
+    for (Value index : indices) {
+      Operation *def = index.getDefiningOp();
+      if (def && root->isAncestor(def))
+        return;
+    }
+    SmallVector<int64_t, 6> contribution(ivs.size(), 0);
+    for (unsigned i = 0; i < indices.size(); ++i) {
+      const Value *it = llvm::find(ivs, indices[i]);
+      if (it == ivs.end())
+        continue;
+      if (strides[i] == ShapedType::kDynamicStrideOrOffset)
+        return;
+      contribution[std::distance(ivs.begin(), it)] +=
+          std::abs(strides[i]) * elemBytes;
+    }
+    for (size_t i = 0; i < costs.size(); ++i)
+      costs[i] += contribution[i];
+    ++analyzed;
+  });
+  return analyzed;
+}
+
+// Rotate, within each perfect loop nest, the loop whose iterations advance
+// the smallest total number of bytes into the innermost position, keeping
+// the relative order of the other loops, when the dependences allow it. A
+// nest is only touched when this strictly improves on the current innermost
+// loop, so canonically laid out code stays exactly as generated.
+static void interchangeLoopsForLocality(func::FuncOp funcOp) {
+  SmallVector<AffineForOp, 8> roots;
+  funcOp.walk([&](AffineForOp forOp) {
+    if (!isa_and_nonnull<AffineForOp>(forOp->getParentOp()))
+      roots.emplace_back(forOp);
+  });
+  for (AffineForOp root : roots) {
+    SmallVector<AffineForOp, 6> band;
+    getPerfectlyNestedLoops(band, root);
+    if (band.size() < 2)
+      continue;
+    if (llvm::any_of(band, [](AffineForOp forOp) {
+          return forOp.getNumIterOperands() > 0;
+        }))
+      continue;
+    SmallVector<Value, 6> ivs;
+    for (AffineForOp forOp : band)
+      ivs.emplace_back(forOp.getInductionVar());
+    SmallVector<int64_t, 6> costs(band.size(), 0);
+    if (accumulateAccessStrides(root, ivs, costs) == 0)
+      continue;
+    // Seeding with the current innermost loop makes the comparison strict:
+    // a candidate must beat it, and ties keep the generated order.
+    unsigned innermost = band.size() - 1;
+    unsigned best = innermost;
+    for (unsigned i = 0; i < band.size(); ++i)
+      if (costs[i] < costs[best])
+        best = i;
+    if (best == innermost)
+      continue;
+    // Sink the best loop to the innermost position; everything else keeps
+    // its order. permMap[i] is the destination depth of loop i.
+    SmallVector<unsigned, 6> permMap(band.size());
+    for (unsigned i = 0; i < band.size(); ++i)
+      permMap[i] = i < best ? i : i - 1;
+    permMap[best] = innermost;
+    if (!isValidLoopInterchangePermutation(band, permMap))
+      continue;
+    permuteLoops(band, permMap);
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // ConvertKrnlToAffinePass
 //===----------------------------------------------------------------------===//
@@ -603,18 +857,92 @@ struct ConvertKrnlToAffinePass
     : public PassWrapper<ConvertKrnlToAffinePass, OperationPass<func::FuncOp>> {
   MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(ConvertKrnlToAffinePass);
 
+  ConvertKrnlToAffinePass() = default;
+  ConvertKrnlToAffinePass(const ConvertKrnlToAffinePass &pass)
+      : PassWrapper<ConvertKrnlToAffinePass, OperationPass<func::FuncOp>>() {}
+  ConvertKrnlToAffinePass(bool enablePrefetch, bool enableInterchange,
+      std::string unrollFactors, std::string unrollConfigFile) {
+    this->enablePrefetch = enablePrefetch;
+    this->enableInterchange = enableInterchange;
+    this->unrollFactors = unrollFactors;
+    this->unrollConfigFile = unrollConfigFile;
+  }
+
   StringRef getArgument() const override { return "convert-krnl-to-affine"; }
 
   StringRef getDescription() const override { return "Lower Krnl dialect."; }
 
+  Option<bool> enablePrefetch{*this, "prefetch",
+      llvm::cl::desc("insert software prefetches in innermost affine loops"),
+      llvm::cl::init(false)};
+
+  Option<bool> enableInterchange{*this, "interchange",
+      llvm::cl::desc("reorder perfect loop nests so that the loop with the "
+                     "smallest memory stride runs innermost"),
+      llvm::cl::init(false)};
+
+  Option<std::string> unrollFactors{*this, "unroll-factors",
+      llvm::cl::desc("comma separated category=factor unroll-and-jam "
+                     "overrides, e.g. matmul-i=8,matmul-k=2"),
+      llvm::cl::init("")};
+
+  Option<std::string> unrollConfigFile{*this, "unroll-config-file",
+      llvm::cl::desc("file with per-node unroll-and-jam overrides, one "
+                     "'<node name> <category>=<factor>' entry per line"),
+      llvm::cl::init("")};
+
+  // Parse the unroll-factors option and the unroll config file into the
+  // global overrides consulted by the lowering patterns.
+  LogicalResult parseUnrollOverrides();
+
   void runOnOperation() final;
 };
 
+LogicalResult ConvertKrnlToAffinePass::parseUnrollOverrides() {
+  parseUnrollFactors(unrollFactors, unrollAndJamOverrides.byCategory);
+  if (unrollConfigFile == "")
+    return success();
+  auto bufferOrError = llvm::MemoryBuffer::getFile(unrollConfigFile);
+  if (!bufferOrError) {
+    emitError(UnknownLoc::get(&getContext()),
+        "cannot open unroll config file '" + unrollConfigFile + "'");
+    return failure();
+  }
+  llvm::SmallVector<StringRef, 32> lines;
+  bufferOrError.get()->getBuffer().split(lines, '\n');
+  for (StringRef line : lines) {
+    line = line.trim();
+    if (line.empty() || line.startswith("#"))
+      continue;
+    StringRef nodeName, factorSpec;
+    std::tie(nodeName, factorSpec) = line.split(' ');
+    // A line without a node name sets category-wide factors, same as the
+    // unroll-factors option.
+    if (factorSpec.empty())
+      parseUnrollFactors(nodeName, unrollAndJamOverrides.byCategory);
+    else
+      parseUnrollFactors(
+          factorSpec.trim(), unrollAndJamOverrides.byNode[nodeName.str()]);
+  }
+  return success();
+}
+
 void ConvertKrnlToAffinePass::runOnOperation() {
   func::FuncOp funcOp = getOperation();
   if (funcOp.getBody().empty()) // external function: nothing to do
     return;
 
+  {
+    const std::lock_guard<std::mutex> lock(unrollAndJamMutex);
+    if (!unrollAndJamOverridesParsed) {
+      unrollAndJamOverridesParsed = true;
+      if (failed(parseUnrollOverrides())) {
+        signalPassFailure();
+        return;
+      }
+    }
+  }
+
   MLIRContext *ctx = &getContext();
   OpBuilder builder(ctx);
 
@@ -670,6 +998,23 @@ void ConvertKrnlToAffinePass::runOnOperation() {
   // Move loop body under appropriate newly created affine loops.
   mover.moveAll(loopRefToOp);
 
+  // Now that loop bodies are in their final position, rewrite the affine.for
+  // ops tagged by krnl.parallel into affine.parallel ops. Loop references are
+  // dead at this point, so replacing the tagged op is safe.
+  funcOp.walk([&](AffineForOp forOp) {
+    if (!forOp->hasAttr("krnl.parallelize"))
+      return;
+    forOp->removeAttr("krnl.parallelize");
+    affineParallelize(forOp);
+  });
+
+  // With the loop bodies in final position and the parallel dimensions
+  // frozen, reorder the remaining sequential bands for unit-stride innermost
+  // access. Running before the pattern conversion below keeps the
+  // hand-scheduled loops that krnl.matmul expands into out of reach.
+  if (enableInterchange)
+    interchangeLoopsForLocality(funcOp);
+
   ConversionTarget target(*ctx);
   // Legal/illegal ops.
   target.addIllegalOp<KrnlTerminatorOp>();
@@ -725,10 +1070,17 @@ void ConvertKrnlToAffinePass::runOnOperation() {
   }
 
   delete currUnrollAndJamList;
+
+  // Loops are in their final shape now; insert prefetches when requested.
+  if (enablePrefetch)
+    insertPrefetches(funcOp);
 }
 
-std::unique_ptr<Pass> createConvertKrnlToAffinePass() {
-  return std::make_unique<ConvertKrnlToAffinePass>();
+std::unique_ptr<Pass> createConvertKrnlToAffinePass(bool enablePrefetch,
+    bool enableInterchange, std::string unrollFactors,
+    std::string unrollConfigFile) {
+  return std::make_unique<ConvertKrnlToAffinePass>(
+      enablePrefetch, enableInterchange, unrollFactors, unrollConfigFile);
 }
 
 void populateKrnlToAffineConversion(TypeConverter &typeConverter,
@@ -54,6 +54,23 @@ using UnrollAndJamRecord = std::pair<mlir::AffineForOp, int64_t>;
 using UnrollAndJamList = llvm::SmallVector<UnrollAndJamRecord, 4>;
 using UnrollAndJamMap = std::map<mlir::Operation *, UnrollAndJamList *>;
 
+// User-directed unroll-and-jam factors, parsed from the unroll-factors
+// option and the unroll config file. Factors are keyed by kernel category
+// (currently "matmul-i", "matmul-j" and "matmul-k"); per-node entries, keyed
+// by the onnx_node_name the lowering kept in the operation's location, take
+// precedence over the category-wide factor. A factor of 1 disables unrolling
+// for the match; no entry keeps the lowering's own heuristic.
+struct UnrollAndJamOverrides {
+  std::map<std::string, int64_t> byCategory;
+  // Keyed by node name, then by category.
+  std::map<std::string, std::map<std::string, int64_t>> byNode;
+  bool empty() const { return byCategory.empty() && byNode.empty(); }
+  // Return the override for the category on the operation, or 0 when none is
+  // set.
+  int64_t lookup(mlir::Operation *op, llvm::StringRef category) const;
+};
+extern UnrollAndJamOverrides unrollAndJamOverrides;
+
 void populateKrnlToAffineConversion(mlir::TypeConverter &typeConverter,
     mlir::RewritePatternSet &patterns, mlir::MLIRContext *ctx);
 
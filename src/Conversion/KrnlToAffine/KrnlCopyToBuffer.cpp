@@ -156,6 +156,14 @@ public:
           }
         }
         Value sourceVal = createKrnl.loadIE(sourceMemref, currLoadIndices);
+        // Sources stored in half precision are widened to the buffer element
+        // type as they are packed into the tile.
+        Type buffElementType =
+            buffMemref.getType().cast<MemRefType>().getElementType();
+        if (sourceVal.getType() != buffElementType) {
+          MathBuilder createMath(createKrnl);
+          sourceVal = createMath.cast(buffElementType, sourceVal);
+        }
         createKrnl.storeIE(sourceVal, buffMemref, currLoopIndices);
       } else {
         createKrnl.storeIE(padVal, buffMemref, currLoopIndices);
@@ -13,6 +13,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/IR/BuiltinTypes.h"
 
@@ -22,6 +23,7 @@
 #include "src/Dialect/Krnl/KrnlOps.hpp"
 #include "src/Support/KrnlSupport.hpp"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 
 #include <mutex>
 
@@ -38,6 +40,14 @@ static constexpr int BUFFER_ALIGN = 64;
 extern UnrollAndJamMap unrollAndJamMap;
 extern std::mutex unrollAndJamMutex;
 
+// Apply any user override for the given unroll category; no override keeps
+// the heuristic factor, and a factor of 1 disables unrolling.
+static int64_t adjustUnrollFactor(
+    Operation *op, StringRef category, int64_t heuristicFactor) {
+  int64_t userFactor = unrollAndJamOverrides.lookup(op, category);
+  return (userFactor > 0) ? userFactor : heuristicFactor;
+}
+
 // Affine expressions compared to >= 0.
 static IndexExpr isFullTile(IndexExpr UB, IndexExpr block, IndexExpr GI) {
   // Determine if the current tile is full. It is full if the beginning of
@@ -69,6 +79,63 @@ static IndexExpr partialTrip(IndexExpr UB, IndexExpr block, IndexExpr GI) {
   return UB - GI;
 }
 
+// f16/bf16 matrices keep their narrow element type in memory, halving the
+// bandwidth consumed by the packed tiles, but the register kernels widen
+// every value to f32 and accumulate in f32: narrow-float accumulation loses
+// precision over long K and is scalarized on most targets. The conversions
+// are plain arith.extf/arith.truncf so that the backend picks the
+// narrow-float vector instructions available for -mcpu/-march.
+// An "accum_type" annotation on the op (placed there by the accum annotation
+// pass via the ONNX matmul lowering) overrides the default policy per op,
+// e.g. to force f64 accumulation for a sensitive product or to keep an f16
+// product narrow. Requests that would narrow the accumulator below the
+// element type are ignored, since extf/truncf cannot express them.
+static Type getComputeType(KrnlMatMulOp op, Type elementType) {
+  if (FloatType elementFloat = elementType.dyn_cast<FloatType>())
+    if (StringAttr accum = op->getAttrOfType<StringAttr>("accum_type")) {
+      MLIRContext *ctx = op.getContext();
+      FloatType requested = nullptr;
+      if (accum.getValue().equals("f16"))
+        requested = FloatType::getF16(ctx);
+      else if (accum.getValue().equals("bf16"))
+        requested = FloatType::getBF16(ctx);
+      else if (accum.getValue().equals("f32"))
+        requested = FloatType::getF32(ctx);
+      else if (accum.getValue().equals("f64"))
+        requested = FloatType::getF64(ctx);
+      if (requested && (requested == elementFloat ||
+                           requested.getWidth() > elementFloat.getWidth()))
+        return requested;
+    }
+  if (elementType.isF16() || elementType.isBF16())
+    return FloatType::getF32(elementType.getContext());
+  return elementType;
+}
+
+// Widen a scalar or vector of the memory element type to the compute type.
+static Value widenToCompute(
+    const DialectBuilder &create, Value val, Type computeElementType) {
+  Type destType = computeElementType;
+  if (auto vecType = val.getType().dyn_cast<VectorType>())
+    destType = VectorType::get(vecType.getShape(), computeElementType);
+  if (destType == val.getType())
+    return val;
+  return create.getBuilder().create<arith::ExtFOp>(
+      create.getLoc(), destType, val);
+}
+
+// Truncate a compute-type scalar or vector back to the memory element type.
+static Value narrowToMemory(
+    const DialectBuilder &create, Value val, Type memoryElementType) {
+  Type destType = memoryElementType;
+  if (auto vecType = val.getType().dyn_cast<VectorType>())
+    destType = VectorType::get(vecType.getShape(), memoryElementType);
+  if (destType == val.getType())
+    return val;
+  return create.getBuilder().create<arith::TruncFOp>(
+      create.getLoc(), destType, val);
+}
+
 // KrnlMatmul will be lowered to vector and affine expressions
 class KrnlMatmulLowering : public ConversionPattern {
 public:
@@ -153,7 +220,11 @@ public:
           uint64_t i = iComputeTileSize.getLiteral();
           uint64_t k = kComputeTileSize.getLiteral();
           VectorBuilder createVect(createAffine);
-          uint64_t mVL = createVect.getMachineVectorLength(elementType);
+          // Vector length follows the compute type: 16-bit floats are
+          // widened to f32 before the multi-reduction, which only handles
+          // machine-sized vectors.
+          uint64_t mVL = createVect.getMachineVectorLength(
+              getComputeType(matmulOp, elementType));
           if (i % mVL == 0 && k % mVL == 0) {
             // Right now, vector length must be mVL.
             vectorLen = LiteralIndexExpr(mVL);
@@ -243,6 +314,40 @@ public:
     IndexExpr jPartialTrip =
         partialTrip(jGlobalUB, jComputeTileSize, jGlobalIndexComputeStart);
 
+    // When the SIMD (j) dimension has a partial tile, decompose the remainder
+    // into power-of-two chunks and dispatch on the actual extent at runtime.
+    // Each chunk keeps a statically sized vector kernel, so dynamic upper
+    // bounds only pay for the partial tiles themselves instead of scalarizing
+    // them entirely. Chunk of width w executes iff bit w is set in the
+    // remainder, at a column offset equal to the sum of the higher set bits;
+    // both the test and the offset are affine in the remainder, so the whole
+    // ladder folds away when the upper bound is a compile time literal.
+    SmallVector<int64_t, 4> remainderWidths;
+    SmallVector<SmallVector<IndexExpr, 1>, 4> remainderConds;
+    SmallVector<SmallVector<IndexExpr, 4>, 4> remainderBStarts, remainderCStarts;
+    bool hasVectorRemainder = false;
+    if (simdize && !matVectorProduct) {
+      int64_t VL = vectorLen.getLiteral();
+      // Power-of-two vector length needed for the bit decomposition; smaller
+      // lengths have no sub-chunk worth vectorizing.
+      if (llvm::isPowerOf2_64(VL) && VL >= 4) {
+        hasVectorRemainder = true;
+        for (int64_t w = VL / 2; w >= 1; w /= 2) {
+          IndexExpr bits = jPartialTrip % LiteralIndexExpr(2 * w);
+          remainderWidths.emplace_back(w);
+          remainderConds.emplace_back(
+              SmallVector<IndexExpr, 1>{bits - LiteralIndexExpr(w)});
+          IndexExpr offset = jPartialTrip - bits;
+          SmallVector<IndexExpr, 4> bOff(bStart.begin(), bStart.end()),
+              cOff(cStart.begin(), cStart.end());
+          bOff[bRank - 1] = bOff[bRank - 1] + offset;
+          cOff[cRank - 1] = cOff[cRank - 1] + offset;
+          remainderBStarts.emplace_back(bOff);
+          remainderCStarts.emplace_back(cOff);
+        }
+      }
+    }
+
     if (simdize) {
       // SIMD code generator.
       if (matVectorProduct) {
@@ -272,12 +377,23 @@ public:
             genSimdMatMat(createAffine, matmulOp, elementType, aStart, bStart,
                cStart, iTrip, jComputeTileSize, kTrip, vectorLen, /*unroll*/ false);
           }, /* else partial SIMD */ [&](AffineBuilderKrnlMem &createAffine) {
-            // TODO: evaluate if get performance from partial SIMD
-            if (false && jPartialTrip.isLiteral() && jPartialTrip.getLiteral() >=2) {
-              // has a known trip count along the simd dimension of at least 2
-              // elements, use simd again.
-              genSimdMatMat(createAffine, matmulOp, elementType, aStart, bStart,
-                cStart, iTrip, jPartialTrip, kTrip, vectorLen, /*unroll*/ false);
+            if (hasVectorRemainder) {
+              // Runtime dispatch over statically tiled remainder kernels.
+              for (unsigned r = 0; r < remainderWidths.size(); ++r) {
+                int64_t w = remainderWidths[r];
+                LiteralIndexExpr wIE(w);
+                createAffine.ifThenElse(indexScope, remainderConds[r],
+                  /* chunk taken */ [&](AffineBuilderKrnlMem &createAffine) {
+                  if (w >= 2)
+                    genSimdMatMat(createAffine, matmulOp, elementType, aStart,
+                      remainderBStarts[r], remainderCStarts[r], iTrip, wIE,
+                      kTrip, wIE, /*unroll*/ false);
+                  else
+                    genScalar(createAffine, matmulOp, elementType, aStart,
+                      remainderBStarts[r], remainderCStarts[r], iTrip, wIE,
+                      kTrip, /*unroll*/ false);
+                }, /* chunk skipped */ [&](AffineBuilderKrnlMem &createAffine) {});
+              }
             } else {
               genScalar(createAffine, matmulOp, elementType, aStart, bStart, cStart,
                 iTrip, jPartialTrip, kTrip, /*unroll*/ false);
@@ -314,9 +430,10 @@ private:
     MemRefBuilder createMemRef(createAffine);
 
     Value A(operandAdaptor.A()), B(operandAdaptor.B()), C(operandAdaptor.C());
+    Type computeType = getComputeType(op, elementType);
     int64_t unrollFactor = (unrollJam && J.isLiteral()) ? J.getLiteral() : 1;
     // Have to privatize CTmpType by unroll factor (1 if none).
-    MemRefType CTmpType = MemRefType::get({unrollFactor}, elementType);
+    MemRefType CTmpType = MemRefType::get({unrollFactor}, computeType);
     assert(BUFFER_ALIGN >= gDefaultAllocAlign);
     Value TmpC = createMemRef.alignedAlloc(CTmpType, BUFFER_ALIGN);
 
@@ -331,7 +448,8 @@ private:
                 // Defines induction variables, and possibly initialize C.
                 jSaved = j;
                 // Alloc and init temp c storage.
-                Value initVal = createAffine.loadIE(C, cStart, {i, j});
+                Value initVal = widenToCompute(createMath,
+                    createAffine.loadIE(C, cStart, {i, j}), computeType);
                 Value tmpCAccess = (unrollFactor > 1) ? j : zeroIE.getValue();
                 // TTmpC() = affine_load(C, cAccess);
                 createAffine.store(initVal, TmpC, tmpCAccess);
@@ -339,8 +457,10 @@ private:
                 createAffine.forIE(zeroIE, K, 1,
                     [&](AffineBuilderKrnlMem &createAffine, Value k) {
                       MathBuilder createMath(createAffine);
-                      Value a = createAffine.loadIE(A, aStart, {i, k});
-                      Value b = createAffine.loadIE(B, bStart, {k, j});
+                      Value a = widenToCompute(createMath,
+                          createAffine.loadIE(A, aStart, {i, k}), computeType);
+                      Value b = widenToCompute(createMath,
+                          createAffine.loadIE(B, bStart, {k, j}), computeType);
                       Value res = createMath.mul(a, b);
                       res = createMath.add(
                           res, createAffine.load(TmpC, tmpCAccess));
@@ -348,14 +468,17 @@ private:
                       createAffine.store(res, TmpC, tmpCAccess);
                     });
                 // Store temp result into C(i, j)
-                Value finalVal = createAffine.load(TmpC, tmpCAccess);
+                Value finalVal = narrowToMemory(createMath,
+                    createAffine.load(TmpC, tmpCAccess), elementType);
                 createAffine.storeIE(finalVal, C, cStart, {i, j});
               });
         });
     if (unrollJam && J.isLiteral()) {
-      UnrollAndJamRecord record(
-          getForInductionVarOwner(jSaved), J.getLiteral());
-      getUnrollAndJamList(op)->emplace_back(record);
+      int64_t jUnroll = adjustUnrollFactor(op.getOperation(), "matmul-j", J.getLiteral());
+      if (jUnroll > 1) {
+        UnrollAndJamRecord record(getForInductionVarOwner(jSaved), jUnroll);
+        getUnrollAndJamList(op)->emplace_back(record);
+      }
     }
   }
 
@@ -372,14 +495,17 @@ private:
         MemRefBuilder, KrnlBuilder>
         create(createAffine);
     int64_t iLit(I.getLiteral()), VL(vectorLen.getLiteral());
-    int64_t mVL = create.vec.getMachineVectorLength(elementType);
+    Type computeType = getComputeType(op, elementType);
+    int64_t mVL = create.vec.getMachineVectorLength(computeType);
     // Get operands.
     KrnlMatMulOpAdaptor operandAdaptor = KrnlMatMulOpAdaptor(op);
     Value A(operandAdaptor.A()), B(operandAdaptor.B()), C(operandAdaptor.C());
 
-    // Generate the vector type conversions.
+    // Generate the vector type conversions. Loads/stores use the memory
+    // element type; the accumulators use the compute type.
     assert(VL == mVL && "vector length and VL must be identical for now");
-    VectorType vecType = VectorType::get({VL}, elementType);
+    VectorType memVecType = VectorType::get({VL}, elementType);
+    VectorType vecType = VectorType::get({VL}, computeType);
     int64_t iUnrollFactor = iLit;
     assert(iUnrollFactor % VL == 0 && "i blocking should be a multiple of VL");
 
@@ -396,7 +522,7 @@ private:
     // load/stores.
     Value TmpProd = create.mem.alignedAlloca(CTmpType, BUFFER_ALIGN);
     // Init with zero.
-    Value fZero = create.math.constant(elementType, 0);
+    Value fZero = create.math.constant(computeType, 0);
     Value vFZero = create.vec.broadcast(vecType, fZero);
     create.krnl.memset(TmpProd, vFZero);
     LiteralIndexExpr zeroIE(0);
@@ -408,11 +534,15 @@ private:
           // Iterates over the I indices (K is SIMD dim).
           // First compute A[i,k]*B[k, 1] for i=0..iUnrollFactor explicitly.
           // We reuse B[k][0] vector for each iteration of i.
-          Value vb = create.vec.loadIE(vecType, B, bStart, {k, iZero});
+          Value vb = widenToCompute(create.vec,
+              create.vec.loadIE(memVecType, B, bStart, {k, iZero}),
+              computeType);
           // Generate computation for each i, manually unrolled for simplicity.
           for (int64_t i = 0; i < iUnrollFactor; ++i) {
             Value iVal = create.math.constantIndex(i);
-            Value va = create.vec.loadIE(vecType, A, aStart, {iVal, k});
+            Value va = widenToCompute(create.vec,
+                create.vec.loadIE(memVecType, A, aStart, {iVal, k}),
+                computeType);
             Value vTmpProd = create.vec.load(vecType, TmpProd, {iVal});
             Value vres = create.vec.fma(va, vb, vTmpProd);
             create.vec.store(vres, TmpProd, {iVal});
@@ -434,8 +564,11 @@ private:
     for (uint64_t i = 0; i < size; ++i) {
       // IndexExpr::getValues(cStart, cAccess);
       Value iVal = create.math.constantIndex(i * VL);
-      Value vc = create.vec.loadIE(vecType, C, cStart, {iVal, iZero});
+      Value vc = widenToCompute(create.vec,
+          create.vec.loadIE(memVecType, C, cStart, {iVal, iZero}),
+          computeType);
       vc = create.math.add(vc, vReductionList[i]);
+      vc = narrowToMemory(create.vec, vc, elementType);
       create.vec.storeIE(vc, C, cStart, {iVal, iZero});
     }
   }
@@ -454,9 +587,12 @@ private:
     KrnlMatMulOpAdaptor operandAdaptor = KrnlMatMulOpAdaptor(op);
     Value A(operandAdaptor.A()), B(operandAdaptor.B()), C(operandAdaptor.C());
 
-    // Generate the vector type conversions.
+    // Generate the vector type conversions. Loads/stores use the memory
+    // element type; the accumulators use the compute type.
+    Type computeType = getComputeType(op, elementType);
     int64_t VL = vectorLen.getLiteral();
-    VectorType vecType = VectorType::get({VL}, elementType);
+    VectorType memVecType = VectorType::get({VL}, elementType);
+    VectorType vecType = VectorType::get({VL}, computeType);
     int64_t unrollFactor = (unrollJam && I.isLiteral()) ? I.getLiteral() : 1;
     // Have to privatize CTmpType by unroll factor (1 if none).
     MemRefType CTmpType = MemRefType::get({unrollFactor}, vecType);
@@ -479,7 +615,9 @@ private:
           MultiDialectBuilder<MathBuilder, VectorBuilder> create(createAffine);
           iSaved = i; // Saved for unroll and jam.
           // Alloca temp vector TmpC and save C(i)/0.0 into it.
-          Value initVal = create.vec.loadIE(vecType, C, cStart, {i, iZero});
+          Value initVal = widenToCompute(create.vec,
+              create.vec.loadIE(memVecType, C, cStart, {i, iZero}),
+              computeType);
           Value tmpCAccess = (unrollFactor > 1) ? i : zeroIE.getValue();
           createAffine.store(initVal, TmpC, tmpCAccess);
           // Sum over k.
@@ -488,9 +626,12 @@ private:
                 MultiDialectBuilder<MathBuilder, VectorBuilder> create(
                     createAffine);
                 kSaved = k;
-                Value a = createAffine.loadIE(A, aStart, {i, k});
+                Value a = widenToCompute(create.math,
+                    createAffine.loadIE(A, aStart, {i, k}), computeType);
                 Value va = create.vec.broadcast(vecType, a);
-                Value vb = create.vec.loadIE(vecType, B, bStart, {k, iZero});
+                Value vb = widenToCompute(create.vec,
+                    create.vec.loadIE(memVecType, B, bStart, {k, iZero}),
+                    computeType);
                 // TTmpC() = vector_fma(va, vb, TTmpC());
                 Value tmpVal = createAffine.load(TmpC, tmpCAccess);
                 Value res = create.vec.fma(va, vb, tmpVal);
@@ -505,10 +646,12 @@ private:
             for (int64_t i = 0; i < VL; i++)
               mask.emplace_back((i < JLit) ? i : VL + i);
             // permute
-            Value originalCvec =
-                create.vec.loadIE(vecType, C, cStart, {i, iZero});
+            Value originalCvec = widenToCompute(create.vec,
+                create.vec.loadIE(memVecType, C, cStart, {i, iZero}),
+                computeType);
             tmpResults = create.vec.shuffle(tmpResults, originalCvec, mask);
           }
+          tmpResults = narrowToMemory(create.vec, tmpResults, elementType);
           create.vec.storeIE(tmpResults, C, cStart, {i, iZero});
         });
 
@@ -527,6 +670,7 @@ private:
             }
           }
         }
+        kUnroll = adjustUnrollFactor(op.getOperation(), "matmul-k", kUnroll);
         if (kUnroll > 1) {
           LLVM_DEBUG(
               llvm::dbgs() << "Matmul: unroll k by " << kUnroll << "\n";);
@@ -534,11 +678,12 @@ private:
           list->emplace_back(record);
         }
       }
-      if (I.isLiteral() && I.getLiteral() > 1) {
-        LLVM_DEBUG(llvm::dbgs()
-                   << "Matmul: unroll i by " << (int)I.getLiteral() << "\n");
-        UnrollAndJamRecord record(
-            getForInductionVarOwner(iSaved), I.getLiteral());
+      int64_t iUnroll =
+          I.isLiteral() ? adjustUnrollFactor(op.getOperation(), "matmul-i", I.getLiteral())
+                        : 1;
+      if (iUnroll > 1) {
+        LLVM_DEBUG(llvm::dbgs() << "Matmul: unroll i by " << iUnroll << "\n");
+        UnrollAndJamRecord record(getForInductionVarOwner(iSaved), iUnroll);
         list->emplace_back(record);
       }
     }
@@ -56,11 +56,38 @@ public:
     SmallVector<IndexExpr, 4> ubs;
     destBounds.getDimList(ubs);
     SmallVector<int64_t, 4> steps(rank, 1);
-    // Copy data,
-    createAffine.forIE(lbs, ubs, steps,
-        [&](AffineBuilderKrnlMem &createAffine, ValueRange indices) {
-          createAffine.store(destVal, destMemRef, indices);
-        });
+
+    // Fill contiguous buffers with wide vector stores along the innermost
+    // dimension: LLVM recognizes the resulting splat-store loops and emits a
+    // single memset call for large constant fills. Fall back to scalar stores
+    // when the innermost dimension is dynamic or not a multiple of the
+    // machine vector length.
+    MemRefType destType = destMemRef.getType().cast<MemRefType>();
+    Type elementType = destType.getElementType();
+    int64_t VL = 0;
+    if (rank > 0 && destType.getLayout().isIdentity() &&
+        elementType.isIntOrFloat()) {
+      VectorBuilder createVector(createAffine);
+      int64_t machineVL = createVector.getMachineVectorLength(elementType);
+      int64_t innermostSize = destType.getShape()[rank - 1];
+      if (machineVL > 1 && innermostSize > 0 && innermostSize % machineVL == 0)
+        VL = machineVL;
+    }
+    if (VL > 0) {
+      steps[rank - 1] = VL;
+      VectorType vecType = VectorType::get({VL}, elementType);
+      Value splatVal = VectorBuilder(createAffine).broadcast(vecType, destVal);
+      createAffine.forIE(lbs, ubs, steps,
+          [&](AffineBuilderKrnlMem &createAffine, ValueRange indices) {
+            VectorBuilder createVector(createAffine);
+            createVector.store(splatVal, destMemRef, indices);
+          });
+    } else {
+      createAffine.forIE(lbs, ubs, steps,
+          [&](AffineBuilderKrnlMem &createAffine, ValueRange indices) {
+            createAffine.store(destVal, destMemRef, indices);
+          });
+    }
     rewriter.eraseOp(op);
     return success();
   }
@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Analysis/DataLayoutAnalysis.h"
+#include "mlir/AsmParser/AsmParser.h"
 #include "mlir/Conversion/AffineToStandard/AffineToStandard.h"
 #include "mlir/Conversion/ArithToLLVM/ArithToLLVM.h"
 #include "mlir/Conversion/ControlFlowToLLVM/ControlFlowToLLVM.h"
@@ -21,6 +22,7 @@
 #include "mlir/Conversion/LLVMCommon/Pattern.h"
 #include "mlir/Conversion/LLVMCommon/TypeConverter.h"
 #include "mlir/Conversion/MathToLLVM/MathToLLVM.h"
+#include "mlir/Conversion/MathToLibm/MathToLibm.h"
 #include "mlir/Conversion/MemRefToLLVM/MemRefToLLVM.h"
 #include "mlir/Conversion/ReconcileUnrealizedCasts/ReconcileUnrealizedCasts.h"
 #include "mlir/Conversion/SCFToControlFlow/SCFToControlFlow.h"
@@ -40,8 +42,15 @@
 #include "mlir/Target/LLVMIR/ModuleTranslation.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Triple.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
 
 #include "onnx/onnx_pb.h"
 
@@ -146,7 +155,8 @@ void populateAffineAndKrnlToLLVMConversion(RewritePatternSet &patterns,
     ArrayRef<bool> constantOutputs, bool singleEntryPoint,
     SmallVectorImpl<LLVM::GlobalOp> &entryGlobalOps,
     SmallVectorImpl<LLVM::GlobalOp> &inSigGlobalOps,
-    SmallVectorImpl<LLVM::GlobalOp> &outSigGlobalOps, bool verifyInputTensors) {
+    SmallVectorImpl<LLVM::GlobalOp> &outSigGlobalOps, bool verifyInputTensors,
+    bool approxTranscendentals) {
   // TODO: look at what is done in
   // mlir/lib/Conversion/VectorToLLVM/ConvertVectorToLLVMPass.cpp in function
   // LowerVectorToLLVMPass::runOnOperation() and see what we should do about it.
@@ -165,9 +175,19 @@ void populateAffineAndKrnlToLLVMConversion(RewritePatternSet &patterns,
   populateVectorToLLVMConversionPatterns(typeConverter, patterns);
   populateVectorToLLVMMatrixConversionPatterns(typeConverter, patterns);
   memref::populateExpandOpsPatterns(patterns);
-  // Use polynomial approximation for math.{tanh, sin, cos and exp} for better
-  // performance.
-  populateMathPolynomialApproximationPatterns(patterns);
+  if (approxTranscendentals) {
+    // Use polynomial approximation for math.{tanh, sin, cos, exp and erf} for
+    // better performance: the expansions are plain arith/vector code, so they
+    // vectorize and stay in registers instead of calling libm per element.
+    // Cases the approximations do not cover (e.g. f64) fall back to libm
+    // calls via the lower-benefit patterns below.
+    populateMathPolynomialApproximationPatterns(patterns);
+    populateMathToLibmConversionPatterns(patterns, /*benefit=*/0);
+  } else {
+    // Precision was requested over speed: lower all transcendentals that have
+    // no LLVM intrinsic to libm calls.
+    populateMathToLibmConversionPatterns(patterns, /*benefit=*/1);
+  }
   arith::populateArithExpandOpsPatterns(patterns);
   populateMathToLLVMConversionPatterns(typeConverter, patterns);
   populateFuncToLLVMConversionPatterns(typeConverter, patterns);
@@ -181,6 +201,187 @@ void populateAffineAndKrnlToLLVMConversion(RewritePatternSet &patterns,
       outSigGlobalOps, verifyInputTensors);
 }
 
+/// Rewrite duplicate constants so that they share one LLVM global: exported
+/// models often repeat small constants (attention masks, scale scalars,
+/// position tables) once per layer. Constants with identical value, type and
+/// alignment get the symbol name of the first op with that content; the
+/// KrnlGlobalOp lowering then reuses the already emitted global instead of
+/// emitting a copy per occurrence.
+void deduplicateConstantGlobals(ModuleOp &module) {
+  // Attributes and types are uniqued in the context, so pointer-based keys
+  // compare the constant contents.
+  using DedupKey = std::pair<std::pair<Attribute, Attribute>, Type>;
+  llvm::DenseMap<DedupKey, StringAttr> canonicalNames;
+  module.walk([&](KrnlGlobalOp op) {
+    if (!op.value().has_value())
+      return;
+    DedupKey key{
+        {op.value().value(), op.alignmentAttr()}, op.getResult().getType()};
+    auto insertion = canonicalNames.try_emplace(key, op.nameAttr());
+    if (!insertion.second)
+      op->setAttr("name", insertion.first->second);
+  });
+}
+
+/// Return the flat raw data of a KrnlGlobalOp that qualifies for
+/// externalization, or false when the constant must stay embedded (absent or
+/// splat values, strings, or data below the size threshold).
+static bool getExternalizableRawData(
+    KrnlGlobalOp op, int64_t singleThreshold, ArrayRef<char> &rawData) {
+  if (!op.value().has_value())
+    return false;
+  Attribute value = op.value().value();
+  if (auto attr = value.dyn_cast<DenseResourceElementsAttr>()) {
+    auto blob = attr.getRawHandle().getBlob();
+    if (!blob)
+      return false;
+    rawData = blob->getData();
+  } else if (auto attr = value.dyn_cast<DenseElementsAttr>()) {
+    // Splats are cheap to embed and strings have no flat raw data.
+    if (attr.isSplat() || attr.getElementType().isa<krnl::StringType>())
+      return false;
+    rawData = attr.getRawData();
+  } else
+    return false;
+  return (int64_t)rawData.size() >= singleThreshold;
+}
+
+/// Append a per-block checksum trailer after the constant payload of an
+/// external constants file: the magic "OMCKSUM1", the block size, the block
+/// count and one 64-bit FNV-1a hash per 1 MiB block, all little-endian. The
+/// runtime reads the trailer when it maps the file and uses the hashes to
+/// detect weight corruption (see omVerifyConstants) without having to page
+/// the whole file in eagerly; runtimes predating the trailer simply never
+/// read past the payload.
+static void appendConstantChecksumTrailer(
+    llvm::raw_fd_ostream &os, ArrayRef<char> data) {
+  const int64_t blockSize = 1 << 20;
+  int64_t numBlocks = ((int64_t)data.size() + blockSize - 1) / blockSize;
+  auto writeLE = [&os](uint64_t value) {
+    char buf[8];
+    llvm::support::endian::write64le(buf, value);
+    os.write(buf, sizeof(buf));
+  };
+  os.write("OMCKSUM1", 8);
+  writeLE((uint64_t)blockSize);
+  writeLE((uint64_t)numBlocks);
+  for (int64_t b = 0; b < numBlocks; ++b) {
+    int64_t begin = b * blockSize;
+    int64_t end = std::min(begin + blockSize, (int64_t)data.size());
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int64_t i = begin; i < end; ++i) {
+      hash ^= (unsigned char)data[i];
+      hash *= 0x100000001b3ULL;
+    }
+    writeLE(hash);
+  }
+}
+
+/// Move the raw data of large KrnlGlobalOps into a single binary file and
+/// replace their value attribute by an offset into that file. The generated
+/// code maps the file lazily at run time (see omGetExternalConstantAddr), so
+/// the shared library stays small, constant pages are read on first touch
+/// only, and the OS can share them across processes mapping the same file.
+/// Returns true if at least one constant was externalized.
+bool extractConstantsToFile(
+    ModuleOp &module, std::string filename, int64_t singleThreshold) {
+  OpBuilder b(module.getContext());
+  // Align each constant on a page boundary so that the natural alignment of
+  // its elements is preserved by the page-aligned mapping.
+  const uint64_t pageSize = 4096;
+  std::vector<char> packedData;
+  // Constants with identical content share one region of the file.
+  llvm::StringMap<int64_t> offsetForContent;
+  module.walk([&](KrnlGlobalOp op) {
+    ArrayRef<char> rawData;
+    if (!getExternalizableRawData(op, singleThreshold, rawData))
+      return;
+    std::array<uint8_t, 32> hash = llvm::SHA256::hash(
+        llvm::makeArrayRef((const uint8_t *)rawData.data(), rawData.size()));
+    std::string key =
+        llvm::toHex(llvm::makeArrayRef(hash), /*LowerCase=*/true);
+    auto it = offsetForContent.find(key);
+    int64_t offset;
+    if (it != offsetForContent.end()) {
+      offset = it->second;
+    } else {
+      packedData.resize((packedData.size() + pageSize - 1) & ~(pageSize - 1));
+      offset = packedData.size();
+      packedData.insert(packedData.end(), rawData.begin(), rawData.end());
+      offsetForContent[key] = offset;
+    }
+    op->setAttr("offset", b.getI64IntegerAttr(offset));
+    op->removeAttr("value");
+  });
+
+  if (packedData.empty())
+    return false;
+
+  std::error_code error;
+  llvm::raw_fd_ostream os(filename, error, llvm::sys::fs::OF_None);
+  if (error) {
+    llvm::errs() << "Error while writing the constants file '" << filename
+                 << "': " << error.message() << "\n";
+    return false;
+  }
+  os.write(packedData.data(), packedData.size());
+  appendConstantChecksumTrailer(os, packedData);
+
+  // Record the file info on the module for the KrnlGlobalOp lowering.
+  module->setAttr("krnl.external_constants_file",
+      b.getStringAttr(llvm::sys::path::filename(filename)));
+  module->setAttr("krnl.external_constants_size",
+      b.getI64IntegerAttr(packedData.size()));
+  return true;
+}
+
+/// Move the raw data of large KrnlGlobalOps into per-constant files named by
+/// the SHA-256 hash of their content, created under 'dirname'. Identical
+/// constants - within one model or across separately compiled models - hash
+/// to the same file, which is written once and mapped read-only at run time,
+/// so models sharing weights (e.g. variants of a common backbone) share one
+/// physical copy through the page cache. Returns true if at least one
+/// constant was externalized.
+bool extractConstantsToSharedFiles(
+    ModuleOp &module, std::string dirname, int64_t singleThreshold) {
+  if (std::error_code error = llvm::sys::fs::create_directories(dirname)) {
+    llvm::errs() << "Error while creating the shared constants directory '"
+                 << dirname << "': " << error.message() << "\n";
+    return false;
+  }
+  OpBuilder b(module.getContext());
+  bool extracted = false;
+  module.walk([&](KrnlGlobalOp op) {
+    ArrayRef<char> rawData;
+    if (!getExternalizableRawData(op, singleThreshold, rawData))
+      return;
+    std::array<uint8_t, 32> hash = llvm::SHA256::hash(
+        llvm::makeArrayRef((const uint8_t *)rawData.data(), rawData.size()));
+    std::string fname =
+        "om." + llvm::toHex(llvm::makeArrayRef(hash), /*LowerCase=*/true) +
+        ".const";
+    llvm::SmallString<256> path(dirname);
+    llvm::sys::path::append(path, fname);
+    // An existing file already holds this content; share it as is.
+    if (!llvm::sys::fs::exists(path)) {
+      std::error_code error;
+      llvm::raw_fd_ostream os(path, error, llvm::sys::fs::OF_None);
+      if (error) {
+        llvm::errs() << "Error while writing the shared constant file '"
+                     << path << "': " << error.message() << "\n";
+        return;
+      }
+      os.write(rawData.data(), rawData.size());
+      appendConstantChecksumTrailer(os, rawData);
+    }
+    op->setAttr("external_file", b.getStringAttr(fname));
+    op->setAttr("external_size", b.getI64IntegerAttr(rawData.size()));
+    op->removeAttr("value");
+    extracted = true;
+  });
+  return extracted;
+}
+
 bool hasSingleEntryPoint(ModuleOp &module) {
   uint64_t i = 0;
   module->walk([&](KrnlEntryPointOp entryOp) -> WalkResult {
@@ -191,12 +392,19 @@ bool hasSingleEntryPoint(ModuleOp &module) {
   return (i == 1);
 }
 
-/// This function emits three functions: omQueryEntryPoints, omInputSignature
-/// and omOutputSignature.
+/// This function emits four functions: omQueryEntryPoints, omInputSignature,
+/// omOutputSignature and omGetSignatureBinary.
 /// - omQueryEntryPoints has type of `**i8 (*i64)` to query an array of entry
 /// point names.
 /// - omInputSignature and omOutputSignature have type of type `*i8 (*i8)` to
 /// return input and output signatures of the given entry point.
+/// - omGetSignatureBinary has type of `*i64 (*i8, i64)` to return the input
+/// (second argument 0) or output (second argument 1) signature of the given
+/// entry point as a fixed-layout binary table, so that callers validating
+/// tensors on a hot path do not have to parse JSON. Each table is a flat
+/// array of i64 values emitted at compile time: the number of tensors first,
+/// then for each tensor its data type (an ONNX TensorProto data type), its
+/// rank and its dimension sizes (-1 for a dynamic dimension).
 void genSignatureFunction(ModuleOp &module,
     const SmallVectorImpl<LLVM::GlobalOp> &entryGlobalOps,
     const SmallVectorImpl<LLVM::GlobalOp> &inSigGlobalOps,
@@ -347,6 +555,153 @@ void genSignatureFunction(ModuleOp &module,
     // Return NULL if not found.
     create.llvm._return(create.llvm.nullI8Ptr());
   }
+
+  bool zOS = false;
+  if (Attribute mtripleAttr =
+          module->getAttrOfType<::mlir::Attribute>("llvm.target_triple"))
+    zOS = llvm::Triple(mtripleAttr.cast<StringAttr>().getValue()).isOSzOS();
+
+  // Build the binary table for one JSON signature. Returns false when the
+  // signature cannot be parsed, in which case no table is emitted and
+  // omGetSignatureBinary returns NULL for the entry point.
+  auto buildSignatureTable = [&](StringAttr sigAttr,
+                                 SmallVectorImpl<int64_t> &table) -> bool {
+    std::string sigStr = (zOS) ? krnl::e2a_s(sigAttr.getValue().str())
+                               : sigAttr.getValue().str();
+    // The signature string is NULL-terminated; parse up to the terminator.
+    auto JSONInput = llvm::json::parse(StringRef(sigStr.c_str()));
+    if (!JSONInput) {
+      llvm::consumeError(JSONInput.takeError());
+      return false;
+    }
+    auto *JSONArray = JSONInput->getAsArray();
+    if (!JSONArray)
+      return false;
+    table.emplace_back((int64_t)JSONArray->size());
+    for (const llvm::json::Value &item : *JSONArray) {
+      auto *JSONItem = item.getAsObject();
+      if (!JSONItem)
+        return false;
+      auto JSONItemType = JSONItem->getString("type");
+      if (!JSONItemType)
+        return false;
+      Type elemTy = parseType(JSONItemType.value(), context);
+      if (!elemTy)
+        return false;
+      table.emplace_back(krnl::mlirTypeToOnnxType(elemTy));
+      auto *JSONDimArray = JSONItem->getArray("dims");
+      if (!JSONDimArray)
+        return false;
+      table.emplace_back((int64_t)JSONDimArray->size());
+      for (const llvm::json::Value &dimItem : *JSONDimArray) {
+        auto JSONDimValue = dimItem.getAsInteger();
+        if (!JSONDimValue)
+          return false;
+        int64_t dim = JSONDimValue.value();
+        table.emplace_back(ShapedType::isDynamic(dim) ? -1 : dim);
+      }
+    }
+    return true;
+  };
+
+  // Emit global constants storing the binary signature tables. Entry points
+  // whose signatures are not valid JSON get a null GlobalOp placeholder.
+  SmallVector<LLVM::GlobalOp, 2> inBinGlobalOps, outBinGlobalOps;
+  {
+    OpBuilder::InsertionGuard guard(b);
+    b.setInsertionPointToEnd(module.getBody());
+    for (uint64_t j = 0; j < numOfEntryPoints; ++j) {
+      for (bool isInput : {true, false}) {
+        LLVM::GlobalOp sigGlobalOp =
+            isInput ? inSigGlobalOps[j] : outSigGlobalOps[j];
+        SmallVectorImpl<LLVM::GlobalOp> &binGlobalOps =
+            isInput ? inBinGlobalOps : outBinGlobalOps;
+        SmallVector<int64_t, 16> table;
+        StringAttr sigAttr = sigGlobalOp.getValueAttr().cast<StringAttr>();
+        if (!buildSignatureTable(sigAttr, table)) {
+          binGlobalOps.emplace_back(LLVM::GlobalOp());
+          continue;
+        }
+        auto tableArrayType = LLVM::LLVMArrayType::get(i64Type, table.size());
+        auto tableTensorType =
+            RankedTensorType::get({(int64_t)table.size()}, i64Type);
+        LLVM::GlobalOp binGlobalOp = create.llvm.globalOp(tableArrayType,
+            /*isConstant=*/true, LLVM::Linkage::External,
+            sigGlobalOp.getSymName().str() + "_bin",
+            DenseElementsAttr::get(tableTensorType, llvm::makeArrayRef(table)));
+        binGlobalOps.emplace_back(binGlobalOp);
+      }
+    }
+  }
+
+  // Emit a function, omGetSignatureBinary, of type `*i64 (*i8, i64)` to
+  // return the binary signature table of the given entry point.
+  {
+    OpBuilder::InsertionGuard guard(b);
+    b.setInsertionPointToEnd(module.getBody());
+    Type llvmFnType =
+        LLVM::LLVMFunctionType::get(i64PtrTy, {i8PtrTy, i64Type}, false);
+    LLVM::LLVMFuncOp funcOp =
+        create.llvm.func("omGetSignatureBinary", llvmFnType);
+    Block *entryBlock = funcOp.addEntryBlock();
+    OpBuilder::InsertionGuard bodyGuard(b);
+    b.setInsertionPointToStart(entryBlock);
+
+    Value zeroI32 = create.llvm.constant(i32Type, (int64_t)0);
+    Value zeroI64 = create.llvm.constant(i64Type, (int64_t)0);
+    Value input = entryBlock->getArgument(0);
+    Value whichSig = entryBlock->getArgument(1);
+
+    // A helper function to return the binary table of a global, or NULL when
+    // the signature had no table.
+    auto returnTable = [&](LLVMBuilder &createLLVM, LLVM::GlobalOp globalOp) {
+      if (!globalOp) {
+        createLLVM._return(createLLVM.null(i64PtrTy));
+        return;
+      }
+      Value tableAddr = createLLVM.addressOf(globalOp);
+      Value tableI64Ptr = createLLVM.bitcast(i64PtrTy, tableAddr);
+      createLLVM._return(tableI64Ptr);
+    };
+
+    // Iterate over the list of the entry points and check string equality,
+    // the same way omInputSignature and omOutputSignature do.
+    for (uint64_t j = 0; j < numOfEntryPoints; ++j) {
+      LLVM::GlobalOp globalEntryPoint = entryGlobalOps[j];
+      StringAttr entryPointValueAttr =
+          globalEntryPoint.getValueAttr().cast<StringAttr>();
+      create.llvm.ifThenElse(/*cond=*/
+          [&](LLVMBuilder &createLLVM) {
+            // Read an entry point name.
+            Value address = createLLVM.addressOf(globalEntryPoint);
+            Value zeroI64 = createLLVM.constant(i64Type, (int64_t)0);
+            Value entryI8Ptr =
+                createLLVM.getElemPtr(i8PtrTy, address, {zeroI64, zeroI64});
+            // Compare it with the user's entry point name.
+            FlatSymbolRefAttr StrncmpRef = krnl::getOrInsertStrncmp(b, module);
+            Value length = createLLVM.constant(
+                i64Type, (int64_t)entryPointValueAttr.getValue().size());
+            Value strncmpResult = createLLVM.call(i32Type, StrncmpRef,
+                ArrayRef<Value>({input, entryI8Ptr, length}));
+            // Found if strncmp returns `0`.
+            return createLLVM.icmp(
+                LLVM::ICmpPredicate::eq, strncmpResult, zeroI32);
+          }, /*then=*/
+          [&](LLVMBuilder &createLLVM) {
+            // Return the input table when the second argument is 0.
+            createLLVM.ifThenElse(/*cond=*/
+                [&](LLVMBuilder &cl) {
+                  return cl.icmp(LLVM::ICmpPredicate::eq, whichSig, zeroI64);
+                }, /*then=*/
+                [&](LLVMBuilder &cl) { returnTable(cl, inBinGlobalOps[j]); });
+            // Otherwise return the output table.
+            returnTable(createLLVM, outBinGlobalOps[j]);
+          });
+    }
+
+    // Return NULL if not found.
+    create.llvm._return(create.llvm.null(i64PtrTy));
+  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -362,8 +717,17 @@ struct ConvertKrnlToLLVMPass
   ConvertKrnlToLLVMPass() = default;
   ConvertKrnlToLLVMPass(const ConvertKrnlToLLVMPass &pass)
       : PassWrapper<ConvertKrnlToLLVMPass, OperationPass<ModuleOp>>() {}
-  ConvertKrnlToLLVMPass(bool verifyInputTensors) {
+  ConvertKrnlToLLVMPass(bool verifyInputTensors, bool storeConstantsToFile,
+      int64_t constantsToFileSingleThreshold, std::string constantsToFileName,
+      std::string sharedConstantsDir, bool approxTranscendentals,
+      bool smallTensorAllocator) {
     this->verifyInputTensors = verifyInputTensors;
+    this->storeConstantsToFile = storeConstantsToFile;
+    this->constantsToFileSingleThreshold = constantsToFileSingleThreshold;
+    this->constantsToFileName = constantsToFileName;
+    this->sharedConstantsDir = sharedConstantsDir;
+    this->approxTranscendentals = approxTranscendentals;
+    this->smallTensorAllocator = smallTensorAllocator;
   }
 
   StringRef getArgument() const override { return "convert-krnl-to-llvm"; }
@@ -380,6 +744,38 @@ struct ConvertKrnlToLLVMPass
           "Data type and shape are verified. Enable this may introduce "
           "overhead in inferencing."),
       llvm::cl::init(false)};
+  Option<bool> storeConstantsToFile{*this, "store-constants-to-file",
+      llvm::cl::desc("Write model constants to a separate binary file that is "
+                     "mapped lazily at run time instead of embedding them."),
+      llvm::cl::init(false)};
+  Option<int64_t> constantsToFileSingleThreshold{*this,
+      "constants-to-file-single-threshold",
+      llvm::cl::desc("Minimum size in bytes for a constant to be written to "
+                     "the constants file. Smaller constants stay embedded."),
+      llvm::cl::init(1024)};
+  Option<std::string> constantsToFileName{*this, "constants-to-file-name",
+      llvm::cl::desc("Name of the binary file that stores model constants."),
+      llvm::cl::init("model.constants.bin")};
+  Option<std::string> sharedConstantsDir{*this, "shared-constants-dir",
+      llvm::cl::desc(
+          "Write model constants to per-constant files named by their "
+          "content hash under this directory, so that identical weights "
+          "are stored and mapped once across models. Takes precedence "
+          "over store-constants-to-file."),
+      llvm::cl::init("")};
+  Option<bool> approxTranscendentals{*this, "approx-transcendentals",
+      llvm::cl::desc(
+          "Lower transcendental functions (erf, exp, tanh, sin, cos) with "
+          "vectorizable polynomial approximations instead of libm calls. "
+          "Disable to trade speed for libm-accurate results."),
+      llvm::cl::init(true)};
+  Option<bool> smallTensorAllocator{*this, "small-tensor-allocator",
+      llvm::cl::desc(
+          "Route the allocations of function-local temporaries through the "
+          "runtime's size-classed per-thread slab allocator instead of "
+          "malloc, avoiding libc allocator contention across inference "
+          "threads. Buffers escaping as model outputs keep using malloc."),
+      llvm::cl::init(false)};
 };
 
 void ConvertKrnlToLLVMPass::runOnOperation() {
@@ -397,6 +793,22 @@ void ConvertKrnlToLLVMPass::runOnOperation() {
   // Determine the module has a single entry point or not.
   bool singleEntryPoint = hasSingleEntryPoint(module);
 
+  // Share one global between constants with identical content.
+  deduplicateConstantGlobals(module);
+
+  // Mark local temporaries so their allocations are routed to the runtime's
+  // per-thread small-tensor allocator.
+  if (smallTensorAllocator)
+    markSmallAllocTemporaries(module);
+
+  // Externalize large constants before they are turned into LLVM globals.
+  if (!sharedConstantsDir.getValue().empty())
+    extractConstantsToSharedFiles(
+        module, sharedConstantsDir, constantsToFileSingleThreshold);
+  else if (storeConstantsToFile)
+    extractConstantsToFile(
+        module, constantsToFileName, constantsToFileSingleThreshold);
+
   // Request C wrapper emission via attribute.
   for (auto func : module.getOps<func::FuncOp>()) {
     func->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
@@ -428,7 +840,8 @@ void ConvertKrnlToLLVMPass::runOnOperation() {
 
   populateAffineAndKrnlToLLVMConversion(patterns, typeConverter, ctx,
       outputOMTensorOwnerships, singleEntryPoint, entryGlobalOps,
-      inSigGlobalOps, outSigGlobalOps, verifyInputTensors);
+      inSigGlobalOps, outSigGlobalOps, verifyInputTensors,
+      approxTranscendentals);
 
   // Rewrite patterns for accelerators.
   for (auto *accel : onnx_mlir::accel::Accelerator::getAccelerators())
@@ -451,8 +864,14 @@ void ConvertKrnlToLLVMPass::runOnOperation() {
 std::unique_ptr<Pass> createConvertKrnlToLLVMPass() {
   return std::make_unique<ConvertKrnlToLLVMPass>();
 }
-std::unique_ptr<Pass> createConvertKrnlToLLVMPass(bool verifyInputTensors) {
-  return std::make_unique<ConvertKrnlToLLVMPass>(verifyInputTensors);
+std::unique_ptr<Pass> createConvertKrnlToLLVMPass(bool verifyInputTensors,
+    bool storeConstantsToFile, int64_t constantsToFileSingleThreshold,
+    std::string constantsToFileName, std::string sharedConstantsDir,
+    bool approxTranscendentals, bool smallTensorAllocator) {
+  return std::make_unique<ConvertKrnlToLLVMPass>(verifyInputTensors,
+      storeConstantsToFile, constantsToFileSingleThreshold,
+      constantsToFileName, sharedConstantsDir, approxTranscendentals,
+      smallTensorAllocator);
 }
 
 void populateKrnlToLLVMConversion(LLVMTypeConverter &typeConverter,
@@ -475,6 +894,9 @@ void populateKrnlToLLVMConversion(LLVMTypeConverter &typeConverter,
   krnl::populateLoweringKrnlVectorTypeCastOpPattern(
       typeConverter, patterns, ctx);
   krnl::populateLoweringKrnlRandomNormalOpPattern(typeConverter, patterns, ctx);
+  krnl::populateLoweringKrnlRunLoopOpPattern(typeConverter, patterns, ctx);
+  krnl::populateLoweringKrnlRunTasksOpPattern(typeConverter, patterns, ctx);
+  krnl::populateLoweringKrnlSmallAllocOpPattern(typeConverter, patterns, ctx);
   krnl::populateLoweringKrnlStrlenOpPattern(typeConverter, patterns, ctx);
   krnl::populateLoweringKrnlUnaryMathOpPattern(typeConverter, patterns, ctx);
   krnl::populateLoweringKrnlStrncmpOpPattern(typeConverter, patterns, ctx);
@@ -30,7 +30,7 @@ void populateAffineAndKrnlToLLVMConversion(mlir::RewritePatternSet &patterns,
     llvm::SmallVectorImpl<mlir::LLVM::GlobalOp> &entryGlobalOps,
     llvm::SmallVectorImpl<mlir::LLVM::GlobalOp> &inSigGlobalOps,
     llvm::SmallVectorImpl<mlir::LLVM::GlobalOp> &outSigGlobalOps,
-    bool verifyInputTensors);
+    bool verifyInputTensors, bool approxTranscendentals);
 
 void populateKrnlToLLVMConversion(mlir::LLVMTypeConverter &typeConverter,
     mlir::RewritePatternSet &patterns, mlir::MLIRContext *ctx,
@@ -77,6 +77,12 @@ void populateLoweringKrnlRandomNormalOpPattern(
     mlir::TypeConverter &typeConverter, mlir::RewritePatternSet &patterns,
     mlir::MLIRContext *ctx);
 
+void populateLoweringKrnlRunLoopOpPattern(mlir::TypeConverter &typeConverter,
+    mlir::RewritePatternSet &patterns, mlir::MLIRContext *ctx);
+
+void populateLoweringKrnlRunTasksOpPattern(mlir::TypeConverter &typeConverter,
+    mlir::RewritePatternSet &patterns, mlir::MLIRContext *ctx);
+
 void populateLoweringKrnlStrlenOpPattern(mlir::TypeConverter &typeConverter,
     mlir::RewritePatternSet &patterns, mlir::MLIRContext *ctx);
 
@@ -90,6 +96,20 @@ void populateLoweringKrnlVectorTypeCastOpPattern(
     mlir::LLVMTypeConverter &typeConverter, mlir::RewritePatternSet &patterns,
     mlir::MLIRContext *ctx);
 
+void populateLoweringKrnlSmallAllocOpPattern(
+    mlir::LLVMTypeConverter &typeConverter, mlir::RewritePatternSet &patterns,
+    mlir::MLIRContext *ctx);
+
+void markSmallAllocTemporaries(mlir::ModuleOp &module);
+
+void deduplicateConstantGlobals(mlir::ModuleOp &module);
+
+bool extractConstantsToFile(
+    mlir::ModuleOp &module, std::string filename, int64_t singleThreshold);
+
+bool extractConstantsToSharedFiles(
+    mlir::ModuleOp &module, std::string dirname, int64_t singleThreshold);
+
 void determineOwnershipForOutputOMTensors(mlir::ModuleOp &module,
     llvm::SmallVectorImpl<bool> &outputOMTensorOwnerships);
 
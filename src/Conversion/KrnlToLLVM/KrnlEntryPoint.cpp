@@ -64,6 +64,76 @@ public:
       KrnlEntryPointOp op, PatternRewriter &rewriter) const override {
     Location loc = op.getLoc();
 
+    MultiDialectBuilder<KrnlBuilder, LLVMBuilder> create(rewriter, loc);
+    auto module = op->getParentOfType<ModuleOp>();
+
+    auto staticEntryPointFuncName =
+        op->getAttrOfType<SymbolRefAttr>(
+              KrnlEntryPointOp::getEntryPointFuncAttrName())
+            .getLeafReference()
+            .getValue();
+
+    // When there is only a single entry point function in a model, use
+    // DEFAULT_DYN_ENTRY_POINT.
+    std::string dynEntryPointName = "run_" + staticEntryPointFuncName.str();
+    if (singleEntryPoint)
+      dynEntryPointName = DEFAULT_DYN_ENTRY_POINT;
+
+    // Record entry point name, input and output signatures in order to emit
+    // signature-related functions later.
+    recordEntryPointSignatures(module, dynEntryPointName, op, entryGlobalOps,
+        inSigGlobalOps, outSigGlobalOps);
+
+    // Emit the regular entry point. When input verification is requested,
+    // also compile an unchecked twin so that a single artifact can serve
+    // both canary deployments (checked) and the hot path (unchecked).
+    genEntryPointVariant(op, rewriter, dynEntryPointName, verifyInputTensors);
+    if (verifyInputTensors)
+      genEntryPointVariant(
+          op, rewriter, dynEntryPointName + "_unchecked", /*verify=*/false);
+
+    // Emit a "raw" variant of the entry point that forwards directly to the
+    // statically typed entry function. Callers that can guarantee the dense
+    // row-major layout of their buffers may call it with memref descriptors
+    // (pointer to the output descriptor first, then a pointer per input),
+    // skipping OMTensor marshalling, input verification and accelerator
+    // compatibility checks entirely.
+    {
+      auto wrappedStaticEntryPointFuncName =
+          "_mlir_ciface_" + staticEntryPointFuncName.lower();
+      auto *staticEntryPointFunc =
+          module.lookupSymbol(wrappedStaticEntryPointFuncName);
+      assert(staticEntryPointFunc &&
+             isa<LLVM::LLVMFuncOp>(staticEntryPointFunc) &&
+             "entry point func must exist and be an llvm func op");
+      auto staticEntryPointTy = dyn_cast<LLVM::LLVMFuncOp>(staticEntryPointFunc)
+                                    .getFunctionType()
+                                    .dyn_cast<LLVM::LLVMFunctionType>();
+      OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToEnd(module.getBody());
+      std::string rawEntryPointName = dynEntryPointName + "_raw";
+      Type rawEntryPointFuncTy = staticEntryPointTy;
+      LLVM::LLVMFuncOp rawEntryPointFunc =
+          create.llvm.func(rawEntryPointName, rawEntryPointFuncTy);
+      Block &rawEntryBlock =
+          createEntryBlock(rawEntryPointFuncTy, rawEntryPointFunc, loc);
+      rewriter.setInsertionPointToStart(&rawEntryBlock);
+      SmallVector<Value, 4> rawArgs(
+          rawEntryBlock.args_begin(), rawEntryBlock.args_end());
+      create.llvm.call({}, wrappedStaticEntryPointFuncName, rawArgs);
+      create.llvm._return();
+    }
+
+    rewriter.eraseOp(op);
+    return success();
+  }
+
+  // Emit one LLVM function for the entry point under the given name;
+  // `verify` controls whether the input verification code is included.
+  void genEntryPointVariant(KrnlEntryPointOp op, PatternRewriter &rewriter,
+      std::string dynEntryPointName, bool verify) const {
+    Location loc = op.getLoc();
+
     MultiDialectBuilder<KrnlBuilder, LLVMBuilder> create(rewriter, loc);
     auto module = op->getParentOfType<ModuleOp>();
     auto *context = module.getContext();
@@ -89,19 +159,8 @@ public:
             .getLeafReference()
             .getValue();
 
-    // When there is only a single entry point function in a model, use
-    // DEFAULT_DYN_ENTRY_POINT.
-    std::string dynEntryPointName = "run_" + staticEntryPointFuncName.str();
-    if (singleEntryPoint)
-      dynEntryPointName = DEFAULT_DYN_ENTRY_POINT;
-
-    // Record entry point name, input and output signatures in order to emit
-    // signature-related functions later.
-    recordEntryPointSignatures(module, dynEntryPointName, op, entryGlobalOps,
-        inSigGlobalOps, outSigGlobalOps);
-
-    // Start lowering the op.
-    rewriter.eraseOp(op);
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPointToEnd(module.getBody());
     auto dynEntryPointFuncTy =
         LLVM::LLVMFunctionType::get(opaquePtrTy, {opaquePtrTy}, false);
     LLVM::LLVMFuncOp dynamicEntryPointFunc =
@@ -168,7 +227,7 @@ public:
 
     // Emit code to verify every tensor in the wrapped input, e.g. verifying
     // shape and data type.
-    if (verifyInputTensors) {
+    if (verify) {
       StringAttr sigAttr = op->getAttrOfType<StringAttr>(
           KrnlEntryPointOp::getSignatureAttrName());
       llvm::StringRef inSigJSON;
@@ -281,7 +340,6 @@ public:
 
     // Return wrapped output.
     create.llvm._return(wrappedOutput);
-    return success();
   }
 
 private:
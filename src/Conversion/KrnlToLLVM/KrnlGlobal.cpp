@@ -17,6 +17,7 @@
 #include "mlir/IR/DialectResourceBlobManager.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Path.h"
 
 #include "src/Conversion/KrnlToLLVM/KrnlToLLVMHelper.hpp"
 #include "src/Dialect/Mlir/DialectBuilder.hpp"
@@ -59,28 +60,37 @@ public:
             globalType.cast<Type>(), ArrayAttrIntVal(shape, i));
     }
 
-    // Create the global at the entry of the module.
-    assert(krnlGlobalOp.value().has_value() &&
-           "Krnl Global must always have a value");
+    // Constants externalized to the constants file carry an offset instead of
+    // an embedded value; materialize them from the lazily mapped segment.
+    if (!krnlGlobalOp.value().has_value())
+      return lowerExternalConstant(krnlGlobalOp, memRefTy, rewriter);
+
     auto value = krnlGlobalOp.value().value();
-    LLVM::GlobalOp global;
-    TypeSwitch<Attribute>(value)
-        .Case<DenseResourceElementsAttr>([&](DenseResourceElementsAttr attr) {
-          global =
-              lowerDenseResourceConstant(krnlGlobalOp, globalType, rewriter);
-        })
-        .Case<DenseElementsAttr>([&](DenseElementsAttr attr) {
-          global = lowerDenseConstant(krnlGlobalOp, globalType, rewriter);
-        })
-        .Default([&](Attribute attr) {
-          llvm_unreachable("Unsupported attribute type");
-        });
-
-    // Set the global alignment based on the alignment attribute if it exists,
-    // otherwise use the module datalayout info.
-    krnl::setAlignment(global, krnlGlobalOp.alignmentAttr(),
-        krnlGlobalOp->getParentOfType<ModuleOp>(), rewriter,
-        *getTypeConverter());
+    // Duplicate constants were renamed to their canonical twin by
+    // deduplicateConstantGlobals; reuse the already emitted global when one
+    // exists under this name.
+    ModuleOp module = krnlGlobalOp->getParentOfType<ModuleOp>();
+    LLVM::GlobalOp global =
+        module.lookupSymbol<LLVM::GlobalOp>(krnlGlobalOp.name());
+    if (!global) {
+      TypeSwitch<Attribute>(value)
+          .Case<DenseResourceElementsAttr>(
+              [&](DenseResourceElementsAttr attr) {
+                global = lowerDenseResourceConstant(
+                    krnlGlobalOp, globalType, rewriter);
+              })
+          .Case<DenseElementsAttr>([&](DenseElementsAttr attr) {
+            global = lowerDenseConstant(krnlGlobalOp, globalType, rewriter);
+          })
+          .Default([&](Attribute attr) {
+            llvm_unreachable("Unsupported attribute type");
+          });
+
+      // Set the global alignment based on the alignment attribute if it
+      // exists, otherwise use the module datalayout info.
+      krnl::setAlignment(global, krnlGlobalOp.alignmentAttr(), module,
+          rewriter, *getTypeConverter());
+    }
 
     // Prepare data to be inserted into a MemRefDescriptor (a struct).
     Value globalOpAddr = create.llvm.addressOf(global);
@@ -97,6 +107,93 @@ private:
     return (a.getValue()[i]).cast<IntegerAttr>().getInt();
   }
 
+  // Lower a constant whose data lives in an external file (see
+  // extractConstantsToFile and extractConstantsToSharedFiles). The generated
+  // code obtains the base address of the mapped file from the runtime, which
+  // mmaps the file on first use so that constant pages are read lazily and
+  // shared across processes, and computes the constant's address as base +
+  // offset. Constants externalized into per-constant content-hashed files
+  // carry their own file name and map at offset zero.
+  LogicalResult lowerExternalConstant(KrnlGlobalOp &krnlGlobalOp,
+      MemRefType memRefTy, ConversionPatternRewriter &rewriter) const {
+    MLIRContext *context = krnlGlobalOp.getContext();
+    Location loc = krnlGlobalOp.getLoc();
+    ModuleOp module = krnlGlobalOp->getParentOfType<ModuleOp>();
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    Type i8Type = IntegerType::get(context, 8);
+    Type i8PtrType = LLVM::LLVMPointerType::get(i8Type);
+    Type i8PtrPtrType = LLVM::LLVMPointerType::get(i8PtrType);
+    Type i64Type = IntegerType::get(context, 64);
+
+    // Resolve the file holding this constant's data: either its own
+    // content-hashed file, or the single packed constants file recorded on
+    // the module by extractConstantsToFile.
+    auto fileNameAttr =
+        krnlGlobalOp->getAttrOfType<StringAttr>("external_file");
+    auto fileSizeAttr =
+        krnlGlobalOp->getAttrOfType<IntegerAttr>("external_size");
+    int64_t offsetInFile = 0;
+    if (!fileNameAttr) {
+      assert(krnlGlobalOp.offset().has_value() &&
+             "Expecting KrnlGlobalOp with an offset when value is absent");
+      offsetInFile = krnlGlobalOp.offset().value();
+      fileNameAttr =
+          module->getAttrOfType<StringAttr>("krnl.external_constants_file");
+      fileSizeAttr =
+          module->getAttrOfType<IntegerAttr>("krnl.external_constants_size");
+      assert(fileNameAttr && fileSizeAttr &&
+             "Expecting constants file info on the module");
+    }
+
+    // A single pointer per file, shared by all constants it holds, caching
+    // the base address of the mapping.
+    std::string baseSymbol = "om_external_constant_data";
+    if (krnlGlobalOp->hasAttr("external_file"))
+      baseSymbol += "_" + llvm::sys::path::stem(fileNameAttr.getValue())
+                              .drop_front(3) // Skip "om.".
+                              .str();
+    LLVM::GlobalOp baseGlobalOp = module.lookupSymbol<LLVM::GlobalOp>(
+        baseSymbol);
+    if (!baseGlobalOp) {
+      OpBuilder::InsertionGuard insertGuard(rewriter);
+      rewriter.setInsertionPointToStart(module.getBody());
+      baseGlobalOp = create.llvm.globalOp(i8PtrType,
+          /*isConstant=*/false, LLVM::Linkage::Internal, baseSymbol,
+          Attribute());
+      Region &region = baseGlobalOp.getInitializerRegion();
+      Block *block = rewriter.createBlock(&region);
+      rewriter.setInsertionPointToStart(block);
+      create.llvm._return(create.llvm.null(i8PtrType));
+    }
+
+    // The file name, null terminated, as a global string.
+    std::string fname = fileNameAttr.getValue().str();
+    fname.push_back('\0');
+    LLVM::GlobalOp fnameGlobalOp = krnl::getOrCreateGlobalString(fname, loc,
+        rewriter, module,
+        static_cast<LLVMTypeConverter *>(getTypeConverter()));
+
+    // Obtain the base address of the mapped file from the runtime.
+    FlatSymbolRefAttr funcRef =
+        create.llvm.getOrInsertSymbolRef(module, "omGetExternalConstantAddr",
+            i8PtrType, {i8PtrPtrType, i8PtrType, i64Type});
+    Value baseAddr = create.llvm.addressOf(baseGlobalOp);
+    Value fnamePtr = krnl::getPtrToGlobalString(fnameGlobalOp, loc, rewriter);
+    Value fileSize = create.llvm.constant(i64Type, fileSizeAttr.getInt());
+    Value basePtr = create.llvm.call(
+        i8PtrType, funcRef, ArrayRef<Value>({baseAddr, fnamePtr, fileSize}));
+
+    // Compute the constant's address: base + offset.
+    Value offset = create.llvm.constant(i64Type, offsetInFile);
+    Value dataPtr = create.llvm.getElemPtr(i8PtrType, basePtr, {offset});
+
+    MemRefDescriptor memRefDescr =
+        createMemRefDescriptor(dataPtr, memRefTy, loc, rewriter);
+    rewriter.replaceOp(krnlGlobalOp.getOperation(), {memRefDescr});
+    return success();
+  }
+
   LLVM::GlobalOp lowerDenseResourceConstant(KrnlGlobalOp &krnlGlobalOp,
       Type globalType, ConversionPatternRewriter &rewriter) const {
     assert(krnlGlobalOp.value().has_value() &&
@@ -210,8 +307,11 @@ private:
         builder, loc, typeConverter, memRefType, bitCastOp);
   }
 
-  // Generate a global string for each krnlGlobalOp string value, and store
-  // the address of the global strings into an array. Return the array address.
+  // Pack the krnlGlobalOp string values into a single NUL-separated byte
+  // arena global, and store the address of each string into an array. Return
+  // the array address. Keeping the strings in one contiguous global, rather
+  // than one global per string, keeps the dictionary cache friendly and
+  // guarantees every entry is NUL terminated.
   LLVM::GlobalOp lowerStringLiteral(
       KrnlGlobalOp &krnlGlobalOp, Type globalType, OpBuilder &builder) const {
     assert(krnlGlobalOp.value().value().isa<DenseElementsAttr>() &&
@@ -226,33 +326,56 @@ private:
 
     Type i8Type = IntegerType::get(builder.getContext(), 8);
     Type i8PtrType = LLVM::LLVMPointerType::get(i8Type);
+    Type i64Type = IntegerType::get(builder.getContext(), 64);
 
-    // Generate LLVM GlobalOps for each string in the KrnlGlobalOp dense
-    // attribute.
-    SmallVector<LLVM::GlobalOp> globalOps;
+    // Concatenate the strings into a NUL-separated arena, recording the
+    // offset of each entry.
+    std::string arena;
+    SmallVector<int64_t> offsets;
     for (StringRef str : denseAttr.getValues<StringRef>()) {
-      LLVM::GlobalOp globalOp = krnl::getOrCreateGlobalString(
-          str, loc, builder, module, getTypeConverter());
-      globalOps.push_back(globalOp);
+      offsets.push_back(arena.size());
+      arena.append(str.data(), str.size());
+      arena.push_back('\0');
+    }
+    if (arena.empty())
+      arena.push_back('\0');
+
+    // Generate an LLVM GlobalOp holding the arena, at the entry of the
+    // module.
+    LLVM::GlobalOp arenaGlobal;
+    {
+      OpBuilder::InsertionGuard insertGuard(builder);
+      builder.setInsertionPointToStart(module.getBody());
+      auto arenaType = LLVM::LLVMArrayType::get(i8Type, arena.size());
+      arenaGlobal = create.llvm.globalOp(arenaType,
+          /*isConstant=*/true, LLVM::Linkage::Internal,
+          krnlGlobalOp.name().str() + "_arena",
+          builder.getStringAttr(StringRef(arena.data(), arena.size())));
+      krnl::setAlignment(
+          arenaGlobal, nullptr, module, builder, *getTypeConverter());
     }
 
     // Generate an LLVM GlobalOps with an initializer region containing one
     // block.
-    auto arrayType = LLVM::LLVMArrayType::get(i8PtrType, globalOps.size());
+    auto arrayType = LLVM::LLVMArrayType::get(i8PtrType, offsets.size());
     auto global = create.llvm.globalOp(arrayType,
         /*isConstant=*/true, LLVM::Linkage::Internal, krnlGlobalOp.name(),
         Attribute());
     Region &region = global.getInitializerRegion();
     Block *block = builder.createBlock(&region);
 
-    // Initialize an array with the addresses of the global strings.
+    // Initialize an array with the address of each string in the arena.
     builder.setInsertionPoint(block, block->begin());
     Value array = builder.create<LLVM::UndefOp>(loc, arrayType);
+    Value arenaAddr = create.llvm.addressOf(arenaGlobal);
 
     int32_t index = 0;
     Value lastValue = array;
-    for (const LLVM::GlobalOp &globalOp : globalOps) {
-      Value strAddr = krnl::getPtrToGlobalString(globalOp, loc, builder);
+    for (int64_t offset : offsets) {
+      Value zero = create.llvm.constant(i64Type, (int64_t)0);
+      Value offsetVal = create.llvm.constant(i64Type, offset);
+      Value strAddr =
+          create.llvm.getElemPtr(i8PtrType, arenaAddr, {zero, offsetVal});
       lastValue =
           create.llvm.insertValue(arrayType, lastValue, strAddr, {index++});
     }
@@ -90,9 +90,85 @@ private:
   }
 };
 
+class KrnlInstrumentMemoryOpLowering : public ConversionPattern {
+public:
+  explicit KrnlInstrumentMemoryOpLowering(
+      TypeConverter &typeConverter, MLIRContext *context)
+      : ConversionPattern(typeConverter,
+            KrnlInstrumentMemoryOp::getOperationName(), 1, context) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    KrnlInstrumentMemoryOpAdaptor operandAdaptor(operands);
+    Location loc = op->getLoc();
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    ModuleOp parentModule = op->getParentOfType<ModuleOp>();
+    auto memoryPointRef = getOrInsertMemoryPoint(rewriter, parentModule);
+    create.llvm.call({}, memoryPointRef, {operandAdaptor.delta()});
+
+    rewriter.eraseOp(op);
+    return success();
+  }
+
+private:
+  // Create a function declaration for OMInstrumentMemoryPoint, the signature
+  // is:
+  //   `void (i64)`
+  FlatSymbolRefAttr getOrInsertMemoryPoint(
+      PatternRewriter &rewriter, ModuleOp module) const {
+    MLIRContext *context = module.getContext();
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, module.getLoc());
+    Type llvmVoidTy = LLVM::LLVMVoidType::get(context);
+    Type llvmI64Ty = IntegerType::get(context, 64);
+    return create.llvm.getOrInsertSymbolRef(module,
+        StringRef("OMInstrumentMemoryPoint"), llvmVoidTy, {llvmI64Ty});
+  }
+};
+
+class KrnlCheckScratchMemoryOpLowering : public ConversionPattern {
+public:
+  explicit KrnlCheckScratchMemoryOpLowering(
+      TypeConverter &typeConverter, MLIRContext *context)
+      : ConversionPattern(typeConverter,
+            KrnlCheckScratchMemoryOp::getOperationName(), 1, context) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    KrnlCheckScratchMemoryOpAdaptor operandAdaptor(operands);
+    Location loc = op->getLoc();
+    auto checkOp = llvm::cast<KrnlCheckScratchMemoryOp>(op);
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    ModuleOp parentModule = op->getParentOfType<ModuleOp>();
+    auto checkRef = getOrInsertScratchMemoryCheck(rewriter, parentModule);
+    Value limit = create.llvm.constant(
+        IntegerType::get(op->getContext(), 64), (int64_t)checkOp.limit());
+    create.llvm.call({}, checkRef, {operandAdaptor.delta(), limit});
+
+    rewriter.eraseOp(op);
+    return success();
+  }
+
+private:
+  // Create a function declaration for OMScratchMemoryCheck, the signature is:
+  //   `void (i64, i64)`
+  FlatSymbolRefAttr getOrInsertScratchMemoryCheck(
+      PatternRewriter &rewriter, ModuleOp module) const {
+    MLIRContext *context = module.getContext();
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, module.getLoc());
+    Type llvmVoidTy = LLVM::LLVMVoidType::get(context);
+    Type llvmI64Ty = IntegerType::get(context, 64);
+    return create.llvm.getOrInsertSymbolRef(module,
+        StringRef("OMScratchMemoryCheck"), llvmVoidTy, {llvmI64Ty, llvmI64Ty});
+  }
+};
+
 void populateLoweringKrnlInstrumentOpPattern(TypeConverter &typeConverter,
     RewritePatternSet &patterns, MLIRContext *ctx) {
   patterns.insert<KrnlInstrumentOpLowering>(typeConverter, ctx);
+  patterns.insert<KrnlInstrumentMemoryOpLowering>(typeConverter, ctx);
+  patterns.insert<KrnlCheckScratchMemoryOpLowering>(typeConverter, ctx);
 }
 
 } // namespace krnl
@@ -0,0 +1,152 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------------- KrnlRunLoop.cpp - Lowering KrnlRunLoopOp ---------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the KrnlRunLoopOp operator to a call to the
+// 'omRunParallelLoop' runtime function. A thunk with the uniform loop body
+// signature 'void(i64, i64, i8*)' is created for the callee; the thunk
+// forwards the chunk bounds and unpacks the remaining callee arguments from
+// a struct that the call site fills in and hands to the runtime.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Conversion/LLVMCommon/MemRefBuilder.h"
+#include "mlir/Conversion/LLVMCommon/Pattern.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+
+#include "src/Conversion/KrnlToLLVM/KrnlToLLVMHelper.hpp"
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Dialect/Mlir/DialectBuilder.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+namespace krnl {
+
+class KrnlRunLoopOpLowering : public ConversionPattern {
+public:
+  explicit KrnlRunLoopOpLowering(
+      TypeConverter &typeConverter, MLIRContext *context)
+      : ConversionPattern(
+            typeConverter, KrnlRunLoopOp::getOperationName(), 1, context) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto runLoopOp = cast<KrnlRunLoopOp>(op);
+    MLIRContext *ctx = op->getContext();
+    Location loc = op->getLoc();
+    ModuleOp module = op->getParentOfType<ModuleOp>();
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    Type i8Type = IntegerType::get(ctx, 8);
+    Type i64Type = IntegerType::get(ctx, 64);
+    Type i8PtrType = LLVM::LLVMPointerType::get(i8Type);
+    Type voidType = LLVM::LLVMVoidType::get(ctx);
+    Type bodyFnType =
+        LLVM::LLVMFunctionType::get(voidType, {i64Type, i64Type, i8PtrType});
+    Type bodyFnPtrType = LLVM::LLVMPointerType::get(bodyFnType);
+
+    FlatSymbolRefAttr callee = runLoopOp.calleeAttr();
+    Value tripCount = operands[0];
+    ArrayRef<Value> loopOperands = operands.drop_front();
+
+    // Pack the converted callee arguments (original lower bound, step and
+    // the captured values) into a struct on the stack and create the thunk
+    // that unpacks them.
+    SmallVector<Type> packedTypes;
+    for (Value operand : loopOperands)
+      packedTypes.emplace_back(operand.getType());
+    Type packedType = LLVM::LLVMStructType::getLiteral(ctx, packedTypes);
+    genBodyThunk(rewriter, loc, module, callee, packedType,
+        runLoopOp.loopOperands(), bodyFnType);
+
+    Value packed = rewriter.create<LLVM::UndefOp>(loc, packedType);
+    for (auto [j, operand] : llvm::enumerate(loopOperands))
+      packed =
+          create.llvm.insertValue(packedType, packed, operand, {(int64_t)j});
+    Value one = create.llvm.constant(i64Type, (int64_t)1);
+    Value packedPtr = create.llvm._alloca(
+        LLVM::LLVMPointerType::get(packedType), one, /*alignment=*/8);
+    create.llvm.store(packed, packedPtr);
+
+    Value fnAddr = rewriter.create<LLVM::AddressOfOp>(
+        loc, bodyFnPtrType, FlatSymbolRefAttr::get(ctx, thunkName(callee)));
+    Value schedule =
+        create.llvm.constant(i64Type, (int64_t)runLoopOp.schedule());
+
+    // void omRunParallelLoop(void (*body)(int64_t, int64_t, void *),
+    //                        void *env, int64_t tripCount, int64_t schedule);
+    FlatSymbolRefAttr runLoopRef =
+        create.llvm.getOrInsertSymbolRef(module, "omRunParallelLoop",
+            voidType, {bodyFnPtrType, i8PtrType, i64Type, i64Type});
+    create.llvm.call({}, runLoopRef,
+        {fnAddr, create.llvm.bitcastI8Ptr(packedPtr), tripCount, schedule});
+
+    rewriter.eraseOp(op);
+    return success();
+  }
+
+private:
+  static std::string thunkName(FlatSymbolRefAttr callee) {
+    return callee.getValue().str() + "_thunk";
+  }
+
+  /// Create the 'void(i64, i64, i8*)' thunk for `callee`: it forwards the
+  /// chunk bounds, loads the remaining callee arguments from the packed
+  /// struct behind the pointer, expands the memref descriptors into the
+  /// individual values the converted callee expects, and forwards the call.
+  void genBodyThunk(ConversionPatternRewriter &rewriter, Location loc,
+      ModuleOp module, FlatSymbolRefAttr callee, Type packedType,
+      ValueRange origOperands, Type bodyFnType) const {
+    std::string name = thunkName(callee);
+    if (module.lookupSymbol(name))
+      return;
+
+    MLIRContext *ctx = module.getContext();
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPointToEnd(module.getBody());
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    LLVM::LLVMFuncOp thunkFunc = create.llvm.func(name, bodyFnType);
+    Block *entryBlock = thunkFunc.addEntryBlock();
+    rewriter.setInsertionPointToStart(entryBlock);
+
+    Value packedPtr = create.llvm.bitcast(
+        LLVM::LLVMPointerType::get(packedType), thunkFunc.getArgument(2));
+    Value packed = create.llvm.load(packedPtr);
+
+    auto packedTypes = packedType.cast<LLVM::LLVMStructType>().getBody();
+    SmallVector<Value> callArgs = {
+        thunkFunc.getArgument(0), thunkFunc.getArgument(1)};
+    for (auto [j, origOperand] : llvm::enumerate(origOperands)) {
+      Value field =
+          create.llvm.extractValue(packedTypes[j], packed, {(int64_t)j});
+      // The converted callee takes the fields of a ranked memref descriptor
+      // as individual arguments; scalars are passed through unchanged.
+      if (auto memRefType = origOperand.getType().dyn_cast<MemRefType>())
+        MemRefDescriptor::unpack(rewriter, loc, field, memRefType, callArgs);
+      else
+        callArgs.emplace_back(field);
+    }
+
+    create.llvm.call(
+        {}, FlatSymbolRefAttr::get(ctx, callee.getValue()), callArgs);
+    create.llvm._return();
+  }
+};
+
+void populateLoweringKrnlRunLoopOpPattern(TypeConverter &typeConverter,
+    RewritePatternSet &patterns, MLIRContext *ctx) {
+  patterns.insert<KrnlRunLoopOpLowering>(typeConverter, ctx);
+}
+
+} // namespace krnl
+} // namespace onnx_mlir
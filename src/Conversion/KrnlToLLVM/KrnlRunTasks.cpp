@@ -0,0 +1,181 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------------ KrnlRunTasks.cpp - Lowering KrnlRunTasksOp --------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the KrnlRunTasksOp operator to a call to the
+// 'omRunParallelTasks' runtime function. For every callee a thunk with the
+// uniform task signature 'void(i8*)' is created; the thunk unpacks the
+// arguments of its callee from a struct that the call site fills in and
+// hands to the runtime.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Conversion/LLVMCommon/MemRefBuilder.h"
+#include "mlir/Conversion/LLVMCommon/Pattern.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+
+#include "src/Conversion/KrnlToLLVM/KrnlToLLVMHelper.hpp"
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Dialect/Mlir/DialectBuilder.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+namespace krnl {
+
+class KrnlRunTasksOpLowering : public ConversionPattern {
+public:
+  explicit KrnlRunTasksOpLowering(
+      TypeConverter &typeConverter, MLIRContext *context)
+      : ConversionPattern(
+            typeConverter, KrnlRunTasksOp::getOperationName(), 1, context) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto runTasksOp = cast<KrnlRunTasksOp>(op);
+    MLIRContext *ctx = op->getContext();
+    Location loc = op->getLoc();
+    ModuleOp module = op->getParentOfType<ModuleOp>();
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    Type i8Type = IntegerType::get(ctx, 8);
+    Type i64Type = IntegerType::get(ctx, 64);
+    Type i8PtrType = LLVM::LLVMPointerType::get(i8Type);
+    Type voidType = LLVM::LLVMVoidType::get(ctx);
+    Type taskFnType = LLVM::LLVMFunctionType::get(voidType, {i8PtrType});
+    Type taskFnPtrType = LLVM::LLVMPointerType::get(taskFnType);
+
+    ArrayAttr callees = runTasksOp.callees();
+    ArrayAttr segmentSizes = runTasksOp.segmentSizes();
+    int64_t numTasks = callees.size();
+
+    // Split the flat operand list into per-task segments. Both the original
+    // operands (for their memref types) and the converted ones (for the
+    // marshaled values) are needed.
+    SmallVector<ValueRange> taskOperands;
+    SmallVector<ValueRange> taskOrigOperands;
+    int64_t offset = 0;
+    for (Attribute sizeAttr : segmentSizes) {
+      int64_t size = sizeAttr.cast<IntegerAttr>().getInt();
+      taskOperands.emplace_back(operands.slice(offset, size));
+      taskOrigOperands.emplace_back(
+          runTasksOp.taskOperands().slice(offset, size));
+      offset += size;
+    }
+
+    // Allocate the parallel arrays of task functions and task arguments
+    // consumed by the runtime scheduler.
+    Value numTasksVal = create.llvm.constant(i64Type, numTasks);
+    Value one = create.llvm.constant(i64Type, (int64_t)1);
+    Value fnArray = create.llvm._alloca(
+        LLVM::LLVMPointerType::get(taskFnPtrType), numTasksVal,
+        /*alignment=*/8);
+    Value argArray = create.llvm._alloca(
+        LLVM::LLVMPointerType::get(i8PtrType), numTasksVal, /*alignment=*/8);
+
+    for (int64_t i = 0; i < numTasks; ++i) {
+      FlatSymbolRefAttr callee = callees[i].cast<FlatSymbolRefAttr>();
+
+      // Pack the converted arguments of the callee into a struct on the
+      // stack and create the thunk that unpacks them.
+      SmallVector<Type> packedTypes;
+      for (Value operand : taskOperands[i])
+        packedTypes.emplace_back(operand.getType());
+      Type packedType = LLVM::LLVMStructType::getLiteral(ctx, packedTypes);
+      genTaskThunk(rewriter, loc, module, callee, packedType,
+          taskOrigOperands[i], taskFnType);
+
+      Value packed = rewriter.create<LLVM::UndefOp>(loc, packedType);
+      for (auto [j, operand] : llvm::enumerate(taskOperands[i]))
+        packed = create.llvm.insertValue(
+            packedType, packed, operand, {(int64_t)j});
+      Value packedPtr = create.llvm._alloca(
+          LLVM::LLVMPointerType::get(packedType), one, /*alignment=*/8);
+      create.llvm.store(packed, packedPtr);
+
+      Value idx = create.llvm.constant(i64Type, i);
+      Value fnAddr = rewriter.create<LLVM::AddressOfOp>(loc, taskFnPtrType,
+          FlatSymbolRefAttr::get(ctx, thunkName(callee)));
+      Value fnSlot = create.llvm.getElemPtr(
+          LLVM::LLVMPointerType::get(taskFnPtrType), fnArray, {idx});
+      create.llvm.store(fnAddr, fnSlot);
+      Value argSlot = create.llvm.getElemPtr(
+          LLVM::LLVMPointerType::get(i8PtrType), argArray, {idx});
+      create.llvm.store(create.llvm.bitcastI8Ptr(packedPtr), argSlot);
+    }
+
+    // void omRunParallelTasks(void (**fns)(void *), void **args,
+    //                         int64_t numTasks);
+    FlatSymbolRefAttr runTasksRef =
+        create.llvm.getOrInsertSymbolRef(module, "omRunParallelTasks",
+            voidType, {LLVM::LLVMPointerType::get(taskFnPtrType),
+                          LLVM::LLVMPointerType::get(i8PtrType), i64Type});
+    create.llvm.call({}, runTasksRef, {fnArray, argArray, numTasksVal});
+
+    rewriter.eraseOp(op);
+    return success();
+  }
+
+private:
+  static std::string thunkName(FlatSymbolRefAttr callee) {
+    return callee.getValue().str() + "_thunk";
+  }
+
+  /// Create the 'void(i8*)' thunk for `callee`: it loads the callee arguments
+  /// from the packed struct behind the pointer, expands the memref
+  /// descriptors into the individual values the converted callee expects,
+  /// and forwards the call.
+  void genTaskThunk(ConversionPatternRewriter &rewriter, Location loc,
+      ModuleOp module, FlatSymbolRefAttr callee, Type packedType,
+      ValueRange origOperands, Type taskFnType) const {
+    std::string name = thunkName(callee);
+    if (module.lookupSymbol(name))
+      return;
+
+    MLIRContext *ctx = module.getContext();
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPointToEnd(module.getBody());
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    LLVM::LLVMFuncOp thunkFunc = create.llvm.func(name, taskFnType);
+    Block *entryBlock = thunkFunc.addEntryBlock();
+    rewriter.setInsertionPointToStart(entryBlock);
+
+    Value packedPtr = create.llvm.bitcast(
+        LLVM::LLVMPointerType::get(packedType), thunkFunc.getArgument(0));
+    Value packed = create.llvm.load(packedPtr);
+
+    auto packedTypes = packedType.cast<LLVM::LLVMStructType>().getBody();
+    SmallVector<Value> callArgs;
+    for (auto [j, origOperand] : llvm::enumerate(origOperands)) {
+      Value field = create.llvm.extractValue(
+          packedTypes[j], packed, {(int64_t)j});
+      // The converted callee takes the fields of a ranked memref descriptor
+      // as individual arguments; scalars are passed through unchanged.
+      if (auto memRefType = origOperand.getType().dyn_cast<MemRefType>())
+        MemRefDescriptor::unpack(rewriter, loc, field, memRefType, callArgs);
+      else
+        callArgs.emplace_back(field);
+    }
+
+    create.llvm.call({}, FlatSymbolRefAttr::get(ctx, callee.getValue()),
+        callArgs);
+    create.llvm._return();
+  }
+};
+
+void populateLoweringKrnlRunTasksOpPattern(TypeConverter &typeConverter,
+    RewritePatternSet &patterns, MLIRContext *ctx) {
+  patterns.insert<KrnlRunTasksOpLowering>(typeConverter, ctx);
+}
+
+} // namespace krnl
+} // namespace onnx_mlir
@@ -0,0 +1,179 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ KrnlSmallAlloc.cpp - Route temporaries to the slab allocator --===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file routes the allocations of function-local temporaries through the
+// runtime's size-classed, per-thread slab allocator (see
+// src/Runtime/OMSmallAlloc.inc) instead of plain malloc/free, so that
+// concurrent inference threads do not contend on the libc allocator locks.
+// Only alloc/dealloc pairs that both live in the generated code are routed:
+// buffers that escape as model outputs are released by the caller's runtime
+// with plain free and must keep coming from plain malloc.
+//
+// Each routed alloc also receives a module-unique allocation-site ID
+// (krnl.small_alloc_site), baked into the generated call as a constant. The
+// runtime attributes its heap profile counters to these IDs; compiling with
+// --preserveMLIR keeps the IR that maps an ID back to its alloc.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Conversion/LLVMCommon/Pattern.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+
+#include "src/Conversion/KrnlToLLVM/ConvertKrnlToLLVM.hpp"
+#include "src/Conversion/KrnlToLLVM/KrnlToLLVMHelper.hpp"
+#include "src/Dialect/Mlir/DialectBuilder.hpp"
+#include "src/Support/KrnlSupport.hpp"
+
+#define DEBUG_TYPE "krnl_to_llvm"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+namespace krnl {
+
+// Attribute marking the alloc/dealloc pairs routed to the slab allocator.
+static constexpr const char *smallAllocAttrName = "krnl.small_alloc";
+
+// Attribute holding the allocation-site ID of a routed alloc.
+static constexpr const char *smallAllocSiteAttrName = "krnl.small_alloc_site";
+
+// Statically larger allocations gain nothing from the slab routing; must
+// match OM_SMALL_ALLOC_MAX_SIZE in src/Runtime/OMSmallAlloc.inc.
+static constexpr int64_t smallAllocMaxSize = 4096;
+
+// Slab blocks are 16-byte aligned like malloc's results.
+static constexpr int64_t smallAllocAlignment = 16;
+
+void markSmallAllocTemporaries(ModuleOp &module) {
+  OpBuilder b(module.getContext());
+  // Site IDs number the routed allocs in module walk order, which is stable
+  // for a given compilation; the runtime's heap profile reports them back.
+  int64_t nextSiteId = 0;
+  module.walk([&](memref::DeallocOp deallocOp) {
+    // A deallocated buffer is a local temporary: an owned model output is
+    // released by the caller and never deallocated in the generated code.
+    auto allocOp = deallocOp.getMemref().getDefiningOp<memref::AllocOp>();
+    if (!allocOp)
+      return;
+    MemRefType type = allocOp.getType();
+    if (!type.getLayout().isIdentity())
+      return;
+    if (allocOp.getAlignment().has_value() &&
+        (int64_t)allocOp.getAlignment().value() > smallAllocAlignment)
+      return;
+    if (type.hasStaticShape()) {
+      int64_t sizeInBytes = getMemRefEltSizeInBytes(type);
+      for (int64_t dim : type.getShape())
+        sizeInBytes *= dim;
+      if (sizeInBytes > smallAllocMaxSize)
+        return;
+    }
+    allocOp->setAttr(smallAllocAttrName, b.getUnitAttr());
+    allocOp->setAttr(
+        smallAllocSiteAttrName, b.getI64IntegerAttr(nextSiteId++));
+    deallocOp->setAttr(smallAllocAttrName, b.getUnitAttr());
+  });
+}
+
+// Lower a marked memref.alloc to a call to 'omSmallAlloc'. The pattern has a
+// higher benefit than the default alloc lowering and only fires on marked
+// ops.
+class SmallAllocOpLowering : public ConvertToLLVMPattern {
+public:
+  explicit SmallAllocOpLowering(
+      LLVMTypeConverter &typeConverter, MLIRContext *context)
+      : ConvertToLLVMPattern(memref::AllocOp::getOperationName(), context,
+            typeConverter, /*benefit=*/2) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    if (!op->hasAttr(smallAllocAttrName))
+      return failure();
+    auto allocOp = cast<memref::AllocOp>(op);
+    MemRefType memRefType = allocOp.getType();
+    if (!isConvertibleAndHasIdentityMaps(memRefType))
+      return failure();
+
+    Location loc = op->getLoc();
+    MLIRContext *context = op->getContext();
+    ModuleOp module = op->getParentOfType<ModuleOp>();
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    SmallVector<Value, 4> sizes, strides;
+    Value sizeBytes;
+    getMemRefDescriptorSizes(
+        loc, memRefType, operands, rewriter, sizes, strides, sizeBytes);
+
+    // The allocation site is a compile-time constant baked into the call, so
+    // the runtime's heap profile can attribute the traffic to this alloc.
+    int64_t siteId = -1;
+    if (auto siteAttr = op->getAttrOfType<IntegerAttr>(smallAllocSiteAttrName))
+      siteId = siteAttr.getInt();
+    Value siteVal = create.llvm.constant(rewriter.getI64Type(), siteId);
+
+    Type i8PtrType =
+        LLVM::LLVMPointerType::get(IntegerType::get(context, 8));
+    FlatSymbolRefAttr funcRef =
+        create.llvm.getOrInsertSymbolRef(module, "omSmallAllocSite", i8PtrType,
+            {rewriter.getI64Type(), rewriter.getI64Type()});
+    Value allocatedPtr = create.llvm.call(
+        i8PtrType, funcRef, ArrayRef<Value>({sizeBytes, siteVal}));
+
+    Type elementPtrType = LLVM::LLVMPointerType::get(
+        typeConverter->convertType(memRefType.getElementType()));
+    Value typedPtr = create.llvm.bitcast(elementPtrType, allocatedPtr);
+    MemRefDescriptor memRefDescr = createMemRefDescriptor(
+        loc, memRefType, typedPtr, typedPtr, sizes, strides, rewriter);
+    rewriter.replaceOp(op, {memRefDescr});
+    return success();
+  }
+};
+
+// Lower a marked memref.dealloc to a call to 'omSmallFree'.
+class SmallDeallocOpLowering : public ConvertToLLVMPattern {
+public:
+  explicit SmallDeallocOpLowering(
+      LLVMTypeConverter &typeConverter, MLIRContext *context)
+      : ConvertToLLVMPattern(memref::DeallocOp::getOperationName(), context,
+            typeConverter, /*benefit=*/2) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    if (!op->hasAttr(smallAllocAttrName))
+      return failure();
+
+    Location loc = op->getLoc();
+    MLIRContext *context = op->getContext();
+    ModuleOp module = op->getParentOfType<ModuleOp>();
+    MultiDialectBuilder<LLVMBuilder> create(rewriter, loc);
+
+    MemRefDescriptor memRefDescr(operands[0]);
+    Value allocatedPtr = memRefDescr.allocatedPtr(rewriter, loc);
+    Type i8PtrType =
+        LLVM::LLVMPointerType::get(IntegerType::get(context, 8));
+    Value casted = create.llvm.bitcast(i8PtrType, allocatedPtr);
+    FlatSymbolRefAttr funcRef = create.llvm.getOrInsertSymbolRef(module,
+        "omSmallFree", LLVM::LLVMVoidType::get(context), {i8PtrType});
+    create.llvm.call({}, funcRef, ArrayRef<Value>({casted}));
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+void populateLoweringKrnlSmallAllocOpPattern(LLVMTypeConverter &typeConverter,
+    RewritePatternSet &patterns, MLIRContext *ctx) {
+  patterns.insert<SmallAllocOpLowering, SmallDeallocOpLowering>(
+      typeConverter, ctx);
+}
+
+} // namespace krnl
+} // namespace onnx_mlir
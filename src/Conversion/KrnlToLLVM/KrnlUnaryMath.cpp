@@ -10,6 +10,13 @@
 //
 // This file lowers the KrnlUnaryMath operators.
 //
+// Each operator becomes a call to the corresponding scalar libm function
+// (erff, tanf, ...). With --math-lib set to a vendor library, the LLVM
+// vectorizer later rewrites the loops around these calls against that
+// library's SIMD entry points (libmvec, SVML, Accelerate) and the model
+// library is linked so the dynamic loader resolves them at load; the calls
+// emitted here stay the same either way.
+//
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Conversion/LLVMCommon/Pattern.h"
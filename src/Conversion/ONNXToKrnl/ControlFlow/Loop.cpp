@@ -22,10 +22,76 @@ using namespace mlir;
 
 namespace onnx_mlir {
 
+// Look through the cast wrapped around each loop body output to recover the
+// value the body actually returned.
+static Value lookThroughCast(Value v) {
+  if (auto castOp = v.getDefiningOp<UnrealizedConversionCastOp>())
+    if (castOp.getNumOperands() == 1)
+      return castOp.getOperand(0);
+  return v;
+}
+
 struct ONNXLoopOpLowering : public ConversionPattern {
-  explicit ONNXLoopOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+  ONNXLoopOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel)
       : ConversionPattern(
-            typeConverter, mlir::ONNXLoopOp::getOperationName(), 1, ctx) {}
+            typeConverter, mlir::ONNXLoopOp::getOperationName(), 1, ctx),
+        enableParallel(enableParallel) {}
+
+  bool enableParallel;
+
+  // Return true when the iterations of the loop are independent, so that
+  // they may run concurrently. That is the case when every loop-carried
+  // dependence is forwarded through the body unchanged (the body returns the
+  // very block argument it received): each iteration then only reads the
+  // carried state, and its remaining work - typically a chunk of the input
+  // selected by the iteration variable - touches nothing another iteration
+  // touches, except for the disjoint scan output slice it writes. Chunked
+  // models often carry a small constant state (or none at all) while the
+  // bulk of the body is per-iteration work; those loops run 1-wide today
+  // for no reason.
+  //
+  // A carried dependence that is actually updated each iteration (e.g. an
+  // accumulator) serializes the loop: iteration i reads what i-1 wrote.
+  // Extracting the independent portion of such bodies would need krnl-level
+  // dependence analysis; we take the all-or-nothing case here.
+  bool hasParallelIterations(ONNXLoopOp loopOp) const {
+    // Only the trip-counted form maps onto krnl.iterate; while-form loops
+    // are inherently sequential in their condition.
+    Block &bodyBlock = loopOp.body().front();
+    Operation *returnOp = bodyBlock.getTerminator();
+    if (!isa<ONNXReturnOp>(returnOp))
+      return false;
+
+    unsigned numCarried = loopOp.v_initial().size();
+    for (unsigned i = 0; i < numCarried; ++i) {
+      // Sequences are threaded through a shared scratch cell (see the seq
+      // load/store on 'outputs' below); iterations would race on it.
+      if (loopOp.v_initial()[i].getType().isa<SeqType>())
+        return false;
+      // Body arguments are (iter_num, cond, v...); returned values are
+      // (cond, v..., scan...).
+      Value carriedOut = returnOp->getOperand(1 + i);
+      auto blockArg = carriedOut.dyn_cast<BlockArgument>();
+      if (!blockArg || blockArg.getOwner() != &bodyBlock ||
+          blockArg.getArgNumber() != 2 + i)
+        return false;
+    }
+
+    // Scan outputs with a dynamic non-leading dimension are accumulated
+    // through a sequence (see allocateMemoryForScanOutput), which again is
+    // shared state. Otherwise each iteration writes its own slice, indexed
+    // by the iteration variable, of a buffer allocated before the loop.
+    for (Value scanOutput : loopOp.scan_outputs()) {
+      auto shapedType = scanOutput.getType().dyn_cast<ShapedType>();
+      if (!shapedType || !shapedType.hasRank())
+        return false;
+      for (int64_t i = 1; i < shapedType.getRank(); ++i)
+        if (shapedType.isDynamicDim(i))
+          return false;
+    }
+    return true;
+  }
 
   LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
       ConversionPatternRewriter &rewriter) const final {
@@ -99,6 +165,11 @@ struct ONNXLoopOpLowering : public ConversionPattern {
     maxTripCount = rewriter.create<arith::IndexCastOp>(
         loc, rewriter.getIndexType(), maxTripCount);
     ValueRange loopDef = createKrnl.defineLoops(1);
+    // Iterations proven independent may run concurrently over the worker
+    // pool; each one reads the (then constant) carried state and writes its
+    // own scan output slice.
+    if (enableParallel && hasParallelIterations(loopOp))
+      createKrnl.parallel(loopDef);
     Value zero = create.math.constantIndex(0);
     createKrnl.iterate(loopDef, loopDef, {zero}, {maxTripCount},
         [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
@@ -207,7 +278,12 @@ struct ONNXLoopOpLowering : public ConversionPattern {
           }
 
           // Copy the newly computed loop condition to pre-allocated buffer.
-          emitCopy(rewriter, loc, bodyOutputs[0], cond);
+          // When the body returns the condition block argument untouched
+          // (the common case; see isWhileLoop), the remapped output is the
+          // loop-invariant value that already seeded cond before the loop,
+          // so refreshing cond every iteration would be wasted work.
+          if (lookThroughCast(bodyOutputs[0]) != loopOpAdaptor.cond())
+            emitCopy(rewriter, loc, bodyOutputs[0], cond);
 
           // Copy intermediate values of scan outputs to their corresponding
           // slice in the loop scan output tensor.
@@ -244,7 +320,13 @@ struct ONNXLoopOpLowering : public ConversionPattern {
             if (loopOp.v_initial()[i].getType().isa<SeqType>()) {
               create.krnl.store(bodyOutputs[i + 1], outputs[i], zero);
             } else {
-              emitCopy(rewriter, loc, bodyOutputs[i + 1], outputs[i]);
+              // A body that forwards a carried dependence unchanged returns,
+              // after block argument remapping, the very buffer the value
+              // already lives in. Skip the copy in that case: copying the
+              // buffer onto itself once per iteration is pure overhead for
+              // models that thread a large state through the loop untouched.
+              if (lookThroughCast(bodyOutputs[i + 1]) != outputs[i])
+                emitCopy(rewriter, loc, bodyOutputs[i + 1], outputs[i]);
             }
           }
 
@@ -455,6 +537,16 @@ struct ONNXLoopOpLowering : public ConversionPattern {
     auto srcTy = src.getType().cast<MemRefType>();
     SmallVector<Value, 4> readIV;
     KrnlBuilder createKrnl(rewriter, loc);
+    // A whole-buffer transfer between memrefs of the same type is a single
+    // memcpy rather than a scalar loop nest. The loop-carried state of a
+    // model can be megabytes and is copied once per iteration, so the
+    // difference matters.
+    if (writePrefix.empty() && srcTy.getRank() > 0 &&
+        src.getType() == dest.getType()) {
+      Value sizeInBytes = getDynamicMemRefSizeInBytes(rewriter, loc, src);
+      createKrnl.memcpy(dest, src, sizeInBytes);
+      return;
+    }
     if (srcTy.getRank() > 0) {
       IndexExprScope childScope(&rewriter, loc);
       ValueRange loopDef = createKrnl.defineLoops(srcTy.getRank());
@@ -790,8 +882,8 @@ struct ONNXLoopOpLowering : public ConversionPattern {
 };
 
 void populateLoweringONNXLoopOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx) {
-  patterns.insert<ONNXLoopOpLowering>(typeConverter, ctx);
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel) {
+  patterns.insert<ONNXLoopOpLowering>(typeConverter, ctx, enableParallel);
 }
 
 } // namespace onnx_mlir
@@ -167,7 +167,9 @@ std::map<std::string, std::string> ONNXEntryPointLowering::typeMap = {
 
 void populateONNXToKrnlConversionPattern(RewritePatternSet &patterns,
     TypeConverter &typeConverter, MLIRContext *ctx, bool enableTiling,
-    bool enableParallel) {
+    bool enableParallel, bool enableFastElementwise, bool enableFastConv,
+    bool enableFusedAttention, float sparseWeightDensity,
+    int64_t l2ResidentCores) {
   // Type conversion for function signatures.
   // Call MLIR FuncOp signature conversion when result type is
   // a ranked tensor.
@@ -179,46 +181,62 @@ void populateONNXToKrnlConversionPattern(RewritePatternSet &patterns,
   // Frontend operation lowering.
   // ControlFlow
   populateLoweringONNXIfOpPattern(patterns, typeConverter, ctx);
-  populateLoweringONNXLoopOpPattern(patterns, typeConverter, ctx);
+  populateLoweringONNXLoopOpPattern(
+      patterns, typeConverter, ctx, enableParallel);
   populateLoweringONNXScanOpPattern(patterns, typeConverter, ctx);
   // Math
+  if (enableFusedAttention)
+    populateLoweringONNXAttentionOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXClipOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXCumSumOpPattern(patterns, typeConverter, ctx);
-  populateLoweringONNXElementwiseOpPattern(patterns, typeConverter, ctx);
+  populateLoweringONNXElementwiseOpPattern(
+      patterns, typeConverter, ctx, enableFastElementwise);
   populateLoweringONNXGemmOpPattern(patterns, typeConverter, ctx, enableTiling);
   populateLoweringONNXHardmaxOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXReductionOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXSoftmaxOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXTopKOpPattern(patterns, typeConverter, ctx);
-  populateLoweringONNXMatMulOpPattern(
-      patterns, typeConverter, ctx, enableTiling);
+  populateLoweringONNXMatMulOpPattern(patterns, typeConverter, ctx,
+      enableTiling, sparseWeightDensity, enableParallel, l2ResidentCores);
   populateLoweringONNXRandomNormalOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXRandomNormalLikeOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXLRNOpPattern(patterns, typeConverter, ctx);
   // ML
   populateLoweringONNXCategoryMapperOpPattern(patterns, typeConverter, ctx);
+  // Quantization
+  populateLoweringONNXDynamicQuantizeLinearOpPattern(
+      patterns, typeConverter, ctx);
+  populateLoweringONNXQLinearConvOpPattern(patterns, typeConverter, ctx);
+  populateLoweringONNXQLinearMatMulOpPattern(
+      patterns, typeConverter, ctx, enableTiling);
   // ObjectDetection
-  populateLoweringONNXNonMaxSuppressionOpPattern(patterns, typeConverter, ctx);
+  populateLoweringONNXNonMaxSuppressionOpPattern(
+      patterns, typeConverter, ctx, enableParallel);
   // Tensor
-  populateLoweringONNXArgMinMaxOpPattern(patterns, typeConverter, ctx);
+  populateLoweringONNXArgMinMaxOpPattern(
+      patterns, typeConverter, ctx, enableParallel);
   populateLoweringONNXDimOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXReshapeOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXPadOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXUnsqueezeOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXUnsqueezeV11OpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXTransposeOpPattern(patterns, typeConverter, ctx);
-  populateLoweringONNXGatherOpPattern(patterns, typeConverter, ctx);
+  populateLoweringONNXGatherOpPattern(
+      patterns, typeConverter, ctx, enableParallel);
   populateLoweringONNXGatherElementsOpPattern(patterns, typeConverter, ctx);
-  populateLoweringONNXGatherNDOpPattern(patterns, typeConverter, ctx);
+  populateLoweringONNXGatherNDOpPattern(
+      patterns, typeConverter, ctx, enableParallel);
   populateLoweringONNXIdentityOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXConstantOfShapeOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXConstantOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXConcatOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXConcatShapeTransposeOpPattern(
       patterns, typeConverter, ctx);
+  populateLoweringONNXCustomOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXDepthToSpaceOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXScatterElementsOpPattern(patterns, typeConverter, ctx);
-  populateLoweringONNXScatterNDOpPattern(patterns, typeConverter, ctx);
+  populateLoweringONNXScatterNDOpPattern(
+      patterns, typeConverter, ctx, enableParallel);
   populateLoweringONNXSpaceToDepthOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXShapeOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXSliceOpPattern(patterns, typeConverter, ctx);
@@ -241,7 +259,8 @@ void populateONNXToKrnlConversionPattern(RewritePatternSet &patterns,
 
   // Neural network
   populateLoweringONNXConvOpPattern(
-      patterns, typeConverter, ctx, enableParallel);
+      patterns, typeConverter, ctx, enableParallel, enableFastConv);
+  populateLoweringONNXConvTransposeOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXNormalizationOpPattern(patterns, typeConverter, ctx);
   populateLoweringONNXPoolingOpPattern(patterns, typeConverter, ctx);
   // Recurrent neural network
@@ -279,18 +298,29 @@ struct FrontendToKrnlLoweringPass
   FrontendToKrnlLoweringPass() = default;
   FrontendToKrnlLoweringPass(const FrontendToKrnlLoweringPass &pass)
       : PassWrapper<FrontendToKrnlLoweringPass, OperationPass<ModuleOp>>() {}
-  FrontendToKrnlLoweringPass(
-      bool emitDealloc, bool enableTiling, bool enableParallel) {
+  FrontendToKrnlLoweringPass(bool emitDealloc, bool enableTiling,
+      bool enableParallel, bool enableFastElementwise, bool enableFastConv,
+      bool enableFusedAttention, float sparseWeightDensity = 0.0f,
+      int64_t l2ResidentCores = 0) {
     // Below, need explicit assignment to enable implicit conversion of bool to
     // Option<bool>.
     this->emitDealloc = emitDealloc;
     this->enableTiling = enableTiling;
     this->enableParallel = enableParallel;
+    this->enableFastElementwise = enableFastElementwise;
+    this->enableFastConv = enableFastConv;
+    this->enableFusedAttention = enableFusedAttention;
+    this->sparseWeightDensity = sparseWeightDensity;
+    this->l2ResidentCores = l2ResidentCores;
   }
-  FrontendToKrnlLoweringPass(int optLevel, bool enableParallel)
+  FrontendToKrnlLoweringPass(int optLevel, bool enableParallel,
+      bool enableFastElementwise, bool enableFastConv,
+      bool enableFusedAttention, float sparseWeightDensity = 0.0f,
+      int64_t l2ResidentCores = 0)
       : FrontendToKrnlLoweringPass(
             /*emitDealloc=*/false, /*enableTiling=*/optLevel >= 3,
-            enableParallel) {}
+            enableParallel, enableFastElementwise, enableFastConv,
+            enableFusedAttention, sparseWeightDensity, l2ResidentCores) {}
 
   void runOnOperation() final;
 
@@ -318,6 +348,26 @@ public:
       llvm::cl::init(false)};
   Option<bool> enableParallel{*this, "enable-parallel",
       llvm::cl::desc("Enable parallelization"), llvm::cl::init(false)};
+  Option<bool> enableFastElementwise{*this, "enable-fast-elementwise",
+      llvm::cl::desc("Enable vectorized and fused elementwise codegen"),
+      llvm::cl::init(false)};
+  Option<bool> enableFastConv{*this, "enable-fast-conv",
+      llvm::cl::desc("Enable the im2col+GEMM convolution path"),
+      llvm::cl::init(false)};
+  Option<bool> enableFusedAttention{*this, "enable-fused-attention",
+      llvm::cl::desc("Enable the fused attention (MatMul-Softmax-MatMul) "
+                     "lowering"),
+      llvm::cl::init(false)};
+  Option<float> sparseWeightDensity{*this, "sparse-weight-density",
+      llvm::cl::desc("Store constant matmul weights whose fraction of "
+                     "nonzeros is below this threshold in CSR form and "
+                     "multiply them with a sparse-dense kernel (0 disables)"),
+      llvm::cl::init(0.0f)};
+  Option<int64_t> l2ResidentCores{*this, "l2-resident-cores",
+      llvm::cl::desc("Partition matmul output columns across this many cores "
+                     "when each core's weight panel fits in the L2 cache "
+                     "(0 disables); requires enable-parallel"),
+      llvm::cl::init(0)};
 };
 
 void FrontendToKrnlLoweringPass::runOnOperation() {
@@ -405,8 +455,10 @@ void FrontendToKrnlLoweringPass::runOnOperation() {
   });
 
   // Define patterns.
-  populateONNXToKrnlConversionPattern(
-      patterns, krnlTypeConverter, &getContext(), enableTiling, enableParallel);
+  populateONNXToKrnlConversionPattern(patterns, krnlTypeConverter,
+      &getContext(), enableTiling, enableParallel, enableFastElementwise,
+      enableFastConv, enableFusedAttention, sparseWeightDensity,
+      l2ResidentCores);
 
   // Rewrite patterns for accelerators.
   for (auto *accel : onnx_mlir::accel::Accelerator::getAccelerators())
@@ -424,14 +476,21 @@ std::unique_ptr<Pass> createLowerToKrnlPass() {
   return std::make_unique<FrontendToKrnlLoweringPass>();
 }
 
-std::unique_ptr<Pass> createLowerToKrnlPass(int optLevel, bool enableParallel) {
-  return std::make_unique<FrontendToKrnlLoweringPass>(optLevel, enableParallel);
+std::unique_ptr<Pass> createLowerToKrnlPass(int optLevel, bool enableParallel,
+    bool enableFastElementwise, bool enableFastConv, bool enableFusedAttention,
+    float sparseWeightDensity, int64_t l2ResidentCores) {
+  return std::make_unique<FrontendToKrnlLoweringPass>(optLevel, enableParallel,
+      enableFastElementwise, enableFastConv, enableFusedAttention,
+      sparseWeightDensity, l2ResidentCores);
 }
 
-std::unique_ptr<Pass> createLowerToKrnlPass(
-    bool emitDealloc, bool enableTiling, bool enableParallel) {
-  return std::make_unique<FrontendToKrnlLoweringPass>(
-      emitDealloc, enableTiling, enableParallel);
+std::unique_ptr<Pass> createLowerToKrnlPass(bool emitDealloc,
+    bool enableTiling, bool enableParallel, bool enableFastElementwise,
+    bool enableFastConv, bool enableFusedAttention, float sparseWeightDensity,
+    int64_t l2ResidentCores) {
+  return std::make_unique<FrontendToKrnlLoweringPass>(emitDealloc,
+      enableTiling, enableParallel, enableFastElementwise, enableFastConv,
+      enableFusedAttention, sparseWeightDensity, l2ResidentCores);
 }
 
 } // namespace onnx_mlir
@@ -118,6 +118,20 @@ struct ONNXCategoryMapperOpLowering : public ConversionPattern {
     Value constantForCatsStrings = create.krnl.constant(
         catsStringsInMemRefType, "cats_strings", cats_strings);
 
+    // The length of each category string is known at compile time. Keep the
+    // lengths in a constant table so that the validity check in emitFindIndex
+    // does not need to call strlen on every input element.
+    Value constantForCatsStringsLen = nullptr;
+    if (elementType.isa<krnl::StringType>()) {
+      SmallVector<int64_t> lengths;
+      for (Attribute elemAttr : cats_stringsAttr.getValue())
+        lengths.push_back(elemAttr.cast<StringAttr>().getValue().size());
+      MemRefType lenMemRefType = MemRefType::get(
+          {static_cast<int64_t>(lengths.size())}, rewriter.getIntegerType(64));
+      constantForCatsStringsLen = create.krnl.constant(lenMemRefType,
+          "cats_strings_len", rewriter.getI64TensorAttr(lengths));
+    }
+
     Value defaultInt64 = (default_int64)
                              ? create.math.constant(rewriter.getIntegerType(64),
                                    default_int64.getSInt())
@@ -154,7 +168,8 @@ struct ONNXCategoryMapperOpLowering : public ConversionPattern {
           Value index, isIndexValid;
           std::tie(index, isIndexValid) =
               emitFindIndex(inputElem, elementType, perfectHashTable,
-                  constantForCatsInt64s, constantForCatsStrings, create);
+                  constantForCatsInt64s, constantForCatsStrings,
+                  constantForCatsStringsLen, create);
 
           if (emitPrintStmts)
             create.krnl.printf("index: ", index, index.getType());
@@ -276,7 +291,8 @@ private:
   // valid or not.
   std::tuple<Value, Value> emitFindIndex(Value inputElem, Type elementType,
       const PerfectHashTable &pHash, Value constantForCatsInt64s,
-      Value constantForCatsStrings, const LocalDialectBuilder &create) const {
+      Value constantForCatsStrings, Value constantForCatsStringsLen,
+      const LocalDialectBuilder &create) const {
     OpBuilder builder = create.krnl.getBuilder();
     Value index = create.krnl.findIndex(inputElem, pHash.G, pHash.V, pHash.len);
 
@@ -295,7 +311,8 @@ private:
           // The index is valid if 'inputElem' compares equal to the string in
           // 'constantForCatsStrings'.
           Value compareVal = create.krnl.load(constantForCatsStrings, {index});
-          Value strlenRes = create.krnl.strlen(compareVal);
+          Value strlenRes =
+              create.krnl.load(constantForCatsStringsLen, {index});
           Value strncmpRes =
               create.krnl.strncmp(inputElem, compareVal, strlenRes);
           Value zeroVal = create.math.constant(builder.getIntegerType(32), 0);
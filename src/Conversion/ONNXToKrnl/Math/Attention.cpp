@@ -0,0 +1,296 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===--------------- Attention.cpp - Fused Attention ----------------------===//
+//
+// Copyright 2022 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the attention subgraph MatMul-(Div/Mul)-Softmax-MatMul to
+// a single fused Krnl kernel. The kernel uses an online softmax: for each
+// query row, it streams over the keys once, maintaining a running maximum,
+// running sum, and rescaled partial output. The S x S score matrix is never
+// materialized, so memory traffic no longer grows with the square of the
+// sequence length.
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/Conversion/ONNXToKrnl/ONNXToKrnlCommon.hpp"
+#include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+// Return true when the value holds exactly one element: a scalar tensor or a
+// tensor whose dimensions are all statically one.
+static bool isScalarValue(Value value) {
+  ShapedType type = value.getType().dyn_cast<ShapedType>();
+  if (!type || !type.hasStaticShape())
+    return false;
+  return type.getNumElements() == 1;
+}
+
+// Recognize the attention subgraph rooted at the score MatMul:
+//   S = MatMul(Q, K)            (root, Q:[B..,Sq,D], K:[B..,D,Sk])
+//   S' = Div(S, c) | Mul(S, c)  (optional scaling by a scalar)
+//   P = Softmax(S', axis=-1)
+//   O = MatMul(P, V)            (V:[B..,Sk,Dv])
+// The pattern must be rooted at the score MatMul: ops are legalized in
+// program order, so rooting at the final MatMul would fire only after the
+// score matrix and softmax have already been lowered and materialized.
+//
+// Only fully static shapes without batch broadcasting are fused; anything
+// else (including the masked variant, which has an Add between the scaling
+// and the softmax) takes the default per-op lowering.
+struct ONNXFusedAttentionOpLowering : public ConversionPattern {
+  ONNXFusedAttentionOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+      : ConversionPattern(typeConverter,
+            mlir::ONNXMatMulOp::getOperationName(), /*benefit=*/2, ctx) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    // Match the subgraph on the original (un-converted) ONNX values.
+    Value score = op->getResult(0);
+    if (!score.hasOneUse())
+      return failure();
+
+    // Optional scaling of the scores by a scalar constant.
+    Operation *scaleOp = nullptr;
+    Value scaleVal = nullptr;
+    bool scaleIsDiv = false;
+    Value softmaxInput = score;
+    Operation *user = *score.getUsers().begin();
+    if (auto divOp = dyn_cast<ONNXDivOp>(user)) {
+      if (divOp.A() != score || !isScalarValue(divOp.B()))
+        return failure();
+      scaleOp = divOp;
+      scaleVal = divOp.B();
+      scaleIsDiv = true;
+    } else if (auto mulOp = dyn_cast<ONNXMulOp>(user)) {
+      Value other = mulOp.A() == score ? mulOp.B() : mulOp.A();
+      if (!isScalarValue(other))
+        return failure();
+      scaleOp = mulOp;
+      scaleVal = other;
+    }
+    if (scaleOp) {
+      softmaxInput = scaleOp->getResult(0);
+      if (!softmaxInput.hasOneUse())
+        return failure();
+      user = *softmaxInput.getUsers().begin();
+    }
+
+    // Softmax over the last axis, feeding the A side of the final MatMul.
+    auto softmaxOp = dyn_cast<ONNXSoftmaxOp>(user);
+    if (!softmaxOp || softmaxOp.input() != softmaxInput)
+      return failure();
+    Value probs = softmaxOp.getResult();
+    if (!probs.hasOneUse())
+      return failure();
+    auto finalMatMulOp = dyn_cast<ONNXMatMulOp>(*probs.getUsers().begin());
+    if (!finalMatMulOp || finalMatMulOp.A() != probs)
+      return failure();
+
+    // Check ranks and shapes. All inputs must have the same static rank and
+    // matching batch dimensions; dynamic shapes, batch broadcasting, and the
+    // 1-D special cases take the default lowering.
+    ONNXMatMulOpAdaptor operandAdaptor(operands);
+    Value Q = operandAdaptor.A();
+    Value K = operandAdaptor.B();
+    Value vTensor = finalMatMulOp.B();
+    ShapedType qType = Q.getType().cast<ShapedType>();
+    ShapedType kType = K.getType().cast<ShapedType>();
+    ShapedType vType = vTensor.getType().dyn_cast<ShapedType>();
+    if (!vType || !qType.hasStaticShape() || !kType.hasStaticShape() ||
+        !vType.hasStaticShape())
+      return failure();
+    int64_t rank = qType.getRank();
+    if (rank < 2 || kType.getRank() != rank || vType.getRank() != rank)
+      return failure();
+    for (int64_t i = 0; i < rank - 2; ++i) {
+      int64_t dim = qType.getShape()[i];
+      if (kType.getShape()[i] != dim || vType.getShape()[i] != dim)
+        return failure();
+    }
+    int64_t seqKLen = vType.getShape()[rank - 2];
+    int64_t headQKLen = qType.getShape()[rank - 1];
+    int64_t headVLen = vType.getShape()[rank - 1];
+    Type elementType = qType.getElementType();
+    if (!elementType.isa<FloatType>())
+      return failure();
+    int64_t softmaxAxis = softmaxOp.axis();
+    if (softmaxAxis < 0)
+      softmaxAxis += rank;
+    if (softmaxAxis != rank - 1)
+      return failure();
+
+    // Subgraph matched: emit the fused kernel.
+    Location loc = ONNXLoc<ONNXMatMulOp>(op);
+    MultiDialectBuilder<KrnlBuilder, MemRefBuilder, MathBuilder> create(
+        rewriter, loc);
+
+    // V and the scale constant belong to ops that are not converted yet;
+    // bridge their tensor values with unrealized casts, which fold away
+    // once their defining ops are converted.
+    Type vMemRefType = typeConverter->convertType(vTensor.getType());
+    Value V = rewriter
+                  .create<UnrealizedConversionCastOp>(loc, vMemRefType, vTensor)
+                  .getResult(0);
+    Value zero = create.math.constantIndex(0);
+    Value scale = nullptr;
+    if (scaleOp) {
+      Type scaleMemRefType = typeConverter->convertType(scaleVal.getType());
+      Value scaleMemRef = rewriter
+                              .create<UnrealizedConversionCastOp>(
+                                  loc, scaleMemRefType, scaleVal)
+                              .getResult(0);
+      int64_t scaleRank = scaleMemRefType.cast<MemRefType>().getRank();
+      SmallVector<Value, 4> scaleIndices(scaleRank, zero);
+      scale = create.krnl.load(scaleMemRef, scaleIndices);
+    }
+
+    // Convert the final output type to MemRefType.
+    Type convertedType =
+        typeConverter->convertType(finalMatMulOp.getResult().getType());
+    assert(convertedType && convertedType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType outputMemRefType = convertedType.cast<MemRefType>();
+
+    // Insert an allocation and deallocation for the final output.
+    bool insertDealloc = checkInsertDealloc(finalMatMulOp.getOperation());
+    Value alloc =
+        insertAllocAndDealloc(outputMemRefType, loc, rewriter, insertDealloc);
+
+    // Running state for the online softmax: maximum, sum, current score,
+    // and the rescaled partial output row.
+    MemRefType scalarType = MemRefType::get({}, elementType);
+    Value maxVal = create.mem.alignedAlloca(scalarType);
+    Value sumVal = create.mem.alignedAlloca(scalarType);
+    Value scoreVal = create.mem.alignedAlloca(scalarType);
+    Value accVal =
+        create.mem.alignedAlloca(MemRefType::get({headVLen}, elementType));
+
+    // Constants and loop bounds.
+    Value fZero = create.math.constant(elementType, 0);
+    Value negInf = create.math.negativeInf(elementType);
+    Value seqKUb = create.math.constantIndex(seqKLen);
+    Value headQKUb = create.math.constantIndex(headQKLen);
+    Value headVUb = create.math.constantIndex(headVLen);
+
+    // Iterate over all batch dimensions and the query rows.
+    ValueRange outerLoops = create.krnl.defineLoops(rank - 1);
+    SmallVector<Value, 4> outerLbs(rank - 1, zero);
+    SmallVector<Value, 4> outerUbs;
+    for (int64_t i = 0; i < rank - 1; ++i)
+      outerUbs.emplace_back(
+          create.math.constantIndex(outputMemRefType.getShape()[i]));
+    create.krnl.iterate(outerLoops, outerLoops, outerLbs, outerUbs,
+        [&](KrnlBuilder &createKrnl, ValueRange outerIndices) {
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          // Reset the running state for this query row.
+          create.krnl.store(negInf, maxVal);
+          create.krnl.store(fZero, sumVal);
+          ValueRange initLoop = create.krnl.defineLoops(1);
+          create.krnl.iterate(initLoop, initLoop, {zero}, {headVUb},
+              [&](KrnlBuilder &createKrnl, ValueRange initIndex) {
+                createKrnl.store(fZero, accVal, initIndex[0]);
+              });
+
+          // Stream over the keys once.
+          ValueRange keyLoop = create.krnl.defineLoops(1);
+          create.krnl.iterate(keyLoop, keyLoop, {zero}, {seqKUb},
+              [&](KrnlBuilder &createKrnl, ValueRange keyIndex) {
+                MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                    createKrnl);
+                Value k = keyIndex[0];
+                // Score: dot product of the query row and the key column.
+                create.krnl.store(fZero, scoreVal);
+                ValueRange dotLoop = create.krnl.defineLoops(1);
+                create.krnl.iterate(dotLoop, dotLoop, {zero}, {headQKUb},
+                    [&](KrnlBuilder &createKrnl, ValueRange dotIndex) {
+                      MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                          createKrnl);
+                      Value d = dotIndex[0];
+                      SmallVector<Value, 4> qAccess, kAccess;
+                      for (int64_t i = 0; i < rank - 2; ++i) {
+                        qAccess.emplace_back(outerIndices[i]);
+                        kAccess.emplace_back(outerIndices[i]);
+                      }
+                      qAccess.emplace_back(outerIndices[rank - 2]);
+                      qAccess.emplace_back(d);
+                      kAccess.emplace_back(d);
+                      kAccess.emplace_back(k);
+                      Value q = create.krnl.load(Q, qAccess);
+                      Value key = create.krnl.load(K, kAccess);
+                      Value prod = create.math.mul(q, key);
+                      Value acc = create.krnl.load(scoreVal);
+                      create.krnl.store(create.math.add(acc, prod), scoreVal);
+                    });
+                Value score = create.krnl.load(scoreVal);
+                if (scale)
+                  score = scaleIsDiv ? create.math.div(score, scale)
+                                     : create.math.mul(score, scale);
+                // Online softmax update: rescale the running sum and the
+                // partial output by exp(oldMax - newMax).
+                Value oldMax = create.krnl.load(maxVal);
+                Value newMax = create.math.max(oldMax, score);
+                Value corr = create.math.exp(create.math.sub(oldMax, newMax));
+                Value prob = create.math.exp(create.math.sub(score, newMax));
+                Value sum = create.krnl.load(sumVal);
+                sum = create.math.add(create.math.mul(sum, corr), prob);
+                create.krnl.store(sum, sumVal);
+                create.krnl.store(newMax, maxVal);
+                ValueRange accLoop = create.krnl.defineLoops(1);
+                create.krnl.iterate(accLoop, accLoop, {zero}, {headVUb},
+                    [&](KrnlBuilder &createKrnl, ValueRange accIndex) {
+                      MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                          createKrnl);
+                      Value d = accIndex[0];
+                      SmallVector<Value, 4> vAccess;
+                      for (int64_t i = 0; i < rank - 2; ++i)
+                        vAccess.emplace_back(outerIndices[i]);
+                      vAccess.emplace_back(k);
+                      vAccess.emplace_back(d);
+                      Value v = create.krnl.load(V, vAccess);
+                      Value acc = create.krnl.load(accVal, d);
+                      acc = create.math.add(create.math.mul(acc, corr),
+                          create.math.mul(prob, v));
+                      create.krnl.store(acc, accVal, d);
+                    });
+              });
+
+          // Normalize the accumulated row by the softmax sum.
+          Value sum = create.krnl.load(sumVal);
+          ValueRange outLoop = create.krnl.defineLoops(1);
+          create.krnl.iterate(outLoop, outLoop, {zero}, {headVUb},
+              [&](KrnlBuilder &createKrnl, ValueRange outIndex) {
+                MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                    createKrnl);
+                Value d = outIndex[0];
+                Value acc = create.krnl.load(accVal, d);
+                SmallVector<Value, 4> outAccess(outerIndices);
+                outAccess.emplace_back(d);
+                create.krnl.store(create.math.div(acc, sum), alloc, outAccess);
+              });
+        });
+
+    // Replace the whole subgraph. The intermediate ops are erased before
+    // they get a chance to be lowered on their own.
+    rewriter.replaceOp(finalMatMulOp, alloc);
+    rewriter.eraseOp(softmaxOp);
+    if (scaleOp)
+      rewriter.eraseOp(scaleOp);
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+void populateLoweringONNXAttentionOpPattern(RewritePatternSet &patterns,
+    TypeConverter &typeConverter, MLIRContext *ctx) {
+  patterns.insert<ONNXFusedAttentionOpLowering>(typeConverter, ctx);
+}
+
+} // namespace onnx_mlir
@@ -12,6 +12,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/IR/TypeUtilities.h"
+
 #include "src/Conversion/ONNXToKrnl/ONNXToKrnlCommon.hpp"
 #include "src/Dialect/Krnl/DialectBuilder.hpp"
 #include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
@@ -143,8 +145,11 @@ struct ScalarOp<ONNXPowOp> {
 
 template <>
 struct ScalarOp<ONNXErfOp> {
-  using FOp = KrnlErfOp;
-  using IOp = KrnlErfOp; // Not used.
+  // Use math.erf rather than krnl.erf so that erf is expanded into a
+  // vectorizable polynomial approximation during lowering to LLVM instead of
+  // a scalar libm call per element (see --approx-transcendentals).
+  using FOp = math::ErfOp;
+  using IOp = math::ErfOp; // Not used.
 };
 
 template <>
@@ -605,7 +610,7 @@ Value emitScalarOpFor<ONNXLessOp>(ConversionPatternRewriter &rewriter,
   Value lhs = scalarOperands[0];
   Value rhs = scalarOperands[1];
 
-  Type inputType = lhs.getType();
+  Type inputType = getElementTypeOrSelf(lhs.getType());
   if (inputType.isa<FloatType>()) {
     return rewriter.create<arith::CmpFOp>(
         loc, arith::CmpFPredicate::OLT, lhs, rhs);
@@ -627,7 +632,7 @@ Value emitScalarOpFor<ONNXLessOrEqualOp>(ConversionPatternRewriter &rewriter,
   Value lhs = scalarOperands[0];
   Value rhs = scalarOperands[1];
 
-  Type inputType = lhs.getType();
+  Type inputType = getElementTypeOrSelf(lhs.getType());
   if (inputType.isa<FloatType>()) {
     return rewriter.create<arith::CmpFOp>(
         loc, arith::CmpFPredicate::OLE, lhs, rhs);
@@ -649,7 +654,7 @@ Value emitScalarOpFor<ONNXGreaterOp>(ConversionPatternRewriter &rewriter,
   Value lhs = scalarOperands[0];
   Value rhs = scalarOperands[1];
 
-  Type inputType = lhs.getType();
+  Type inputType = getElementTypeOrSelf(lhs.getType());
   if (inputType.isa<FloatType>()) {
     return rewriter.create<arith::CmpFOp>(
         loc, arith::CmpFPredicate::OGT, lhs, rhs);
@@ -671,7 +676,7 @@ Value emitScalarOpFor<ONNXGreaterOrEqualOp>(ConversionPatternRewriter &rewriter,
   Value lhs = scalarOperands[0];
   Value rhs = scalarOperands[1];
 
-  Type inputType = lhs.getType();
+  Type inputType = getElementTypeOrSelf(lhs.getType());
   if (inputType.isa<FloatType>()) {
     return rewriter.create<arith::CmpFOp>(
         loc, arith::CmpFPredicate::OGE, lhs, rhs);
@@ -693,7 +698,7 @@ Value emitScalarOpFor<ONNXEqualOp>(ConversionPatternRewriter &rewriter,
   Value lhs = scalarOperands[0];
   Value rhs = scalarOperands[1];
 
-  Type inputType = lhs.getType();
+  Type inputType = getElementTypeOrSelf(lhs.getType());
   if (inputType.isa<FloatType>()) {
     return rewriter.create<arith::CmpFOp>(
         loc, arith::CmpFPredicate::OEQ, lhs, rhs);
@@ -770,61 +775,190 @@ Value emitScalarOpFor<ONNXRoundOp>(ConversionPatternRewriter &rewriter,
     Location loc, Operation *op, Type elementType,
     ArrayRef<Value> scalarOperands) {
   Value x = scalarOperands[0];
-  if (elementType.isa<FloatType>()) {
-    // Use numpy algorithm for rint as follows.
-    // ```
-    // double y, r;
-    // y = npy_floor(x);
-    // r = x - y;
-    //
-    // if (r > 0.5) {
-    //     y += 1.0;
-    // }
-    //
-    // /* Round to nearest even */
-    // if (r == 0.5) {
-    //     r = y - 2.0*npy_floor(0.5*y);
-    //     if (r == 1.0) {
-    //         y += 1.0;
-    //     }
-    // }
-    // return y;
-    // ```
-    MathBuilder createMath(rewriter, loc);
-    Value one = createMath.constant(elementType, 1.0);
-    Value two = createMath.constant(elementType, 2.0);
-    Value half = createMath.constant(elementType, 0.5);
-    Value y = rewriter.create<math::FloorOp>(loc, x);
-    Value r = createMath.sub(x, y);
-
-    // r > 0.5
-    Value rGreaterThanHalf =
-        rewriter.create<arith::CmpFOp>(loc, arith::CmpFPredicate::OGT, r, half);
-    Value y1 = createMath.select(rGreaterThanHalf, createMath.add(y, one), y);
-
-    // r == 0.5: round to nearest even.
-    Value y2 = createMath.mul(half, y);
-    y2 = rewriter.create<math::FloorOp>(loc, y2);
-    y2 = createMath.mul(y2, two);
-    Value rr = createMath.sub(y, y2);
-    Value rrEqualOne =
-        rewriter.create<arith::CmpFOp>(loc, arith::CmpFPredicate::OEQ, rr, one);
-    y2 = createMath.select(rrEqualOne, createMath.add(y, one), y);
-
-    Value rEqualHalf =
-        rewriter.create<arith::CmpFOp>(loc, arith::CmpFPredicate::OEQ, r, half);
-    return createMath.select(rEqualHalf, y2, y1);
-  } else {
-    llvm_unreachable("unsupported element type");
+  if (elementType.isa<FloatType>())
+    return emitRoundHalfToEven(rewriter, loc, x);
+  llvm_unreachable("unsupported element type");
+}
+//===----------------------------------------------------------------------===//
+// Support for fusing a chain of element-wise ops into a single loop nest.
+//===----------------------------------------------------------------------===//
+
+// Emit the computation for a unary element-wise op selected at runtime rather
+// than through a template parameter. Only the ops listed here may be folded
+// into the loop nest of their producer; all of them work on both scalar and
+// vector element types. Returns nullptr when the op is not supported.
+static Value emitFusableScalarOpFor(ConversionPatternRewriter &rewriter,
+    Location loc, Operation *op, Type elementType, Value operand) {
+  if (isa<ONNXAbsOp>(op))
+    return emitScalarOpFor<ONNXAbsOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXEluOp>(op))
+    return emitScalarOpFor<ONNXEluOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXErfOp>(op))
+    return emitScalarOpFor<ONNXErfOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXExpOp>(op))
+    return emitScalarOpFor<ONNXExpOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXHardSigmoidOp>(op))
+    return emitScalarOpFor<ONNXHardSigmoidOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXLeakyReluOp>(op))
+    return emitScalarOpFor<ONNXLeakyReluOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXLogOp>(op))
+    return emitScalarOpFor<ONNXLogOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXNegOp>(op))
+    return emitScalarOpFor<ONNXNegOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXReluOp>(op))
+    return emitScalarOpFor<ONNXReluOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXSigmoidOp>(op))
+    return emitScalarOpFor<ONNXSigmoidOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXSoftplusOp>(op))
+    return emitScalarOpFor<ONNXSoftplusOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXSqrtOp>(op))
+    return emitScalarOpFor<ONNXSqrtOp>(
+        rewriter, loc, op, elementType, {operand});
+  if (isa<ONNXTanhOp>(op))
+    return emitScalarOpFor<ONNXTanhOp>(
+        rewriter, loc, op, elementType, {operand});
+  return nullptr;
+}
+
+static bool isFusableElementwiseOp(Operation *op) {
+  return isa<ONNXAbsOp, ONNXEluOp, ONNXErfOp, ONNXExpOp, ONNXHardSigmoidOp,
+      ONNXLeakyReluOp, ONNXLogOp, ONNXNegOp, ONNXReluOp, ONNXSigmoidOp,
+      ONNXSoftplusOp, ONNXSqrtOp, ONNXTanhOp>(op);
+}
+
+// Collect the chain of unary element-wise consumers that can be folded into
+// the loop nest computing op's result. Each link must be the unique user of
+// the previous result and must preserve its type, so that the result buffer
+// allocated for the head of the chain can be reused unchanged for the tail.
+static void getFusableConsumerChain(
+    Operation *op, SmallVectorImpl<Operation *> &fusedOps) {
+  Operation *tail = op;
+  while (tail->getNumResults() == 1 && tail->getResult(0).hasOneUse()) {
+    Operation *user = *tail->getResult(0).getUsers().begin();
+    if (!isFusableElementwiseOp(user))
+      break;
+    if (user->getResult(0).getType() != tail->getResult(0).getType())
+      break;
+    fusedOps.emplace_back(user);
+    tail = user;
   }
 }
+
+//===----------------------------------------------------------------------===//
+// Support for vectorizing element-wise loops over the innermost dimension.
+//===----------------------------------------------------------------------===//
+
+// Element types the vectorized loop can compute on: floats always; signless
+// integers (other than i1) only when the caller knows the op's scalar
+// emission is vector-safe, as is the case for Cast.
+static bool isVectorizableElementType(Type type, bool allowIntElements) {
+  if (type.isa<FloatType>())
+    return true;
+  return allowIntElements && type.isSignlessInteger() && !type.isInteger(1);
+}
+
+// Return the SIMD vector length to use for the given output type, or 0 when
+// vectorization does not apply. Vectorization is used when all operands and
+// the result share one static shape with the default contiguous layout, so no
+// broadcast is involved and the iteration space can be collapsed into a
+// single flat loop, and the total number of elements is a multiple of the
+// machine vector length for the element type.
+static int64_t getVectorizationLength(const DialectBuilder &db,
+    MemRefType outputMemRefType, ArrayRef<Value> operands,
+    bool allowIntElements = false) {
+  Type elementType = outputMemRefType.getElementType();
+  if (!isVectorizableElementType(elementType, allowIntElements))
+    return 0;
+  if (!outputMemRefType.hasStaticShape() || outputMemRefType.getRank() == 0 ||
+      !outputMemRefType.getLayout().isIdentity())
+    return 0;
+  VectorBuilder createVec(db);
+  int64_t VL = createVec.getMachineVectorLength(elementType);
+  if (VL <= 1)
+    return 0;
+  // The loops being collapsed, divisibility is required of the whole
+  // iteration space, not of the innermost dimension alone.
+  int64_t totalSize = outputMemRefType.getNumElements();
+  if (totalSize < VL || totalSize % VL != 0)
+    return 0;
+  for (Value operand : operands) {
+    MemRefType operandType = operand.getType().dyn_cast<MemRefType>();
+    if (!operandType ||
+        operandType.getShape() != outputMemRefType.getShape() ||
+        !isVectorizableElementType(
+            operandType.getElementType(), allowIntElements) ||
+        !operandType.getLayout().isIdentity())
+      return 0;
+  }
+  return VL;
+}
+
+// Emit the vectorized loop for an element-wise op. All buffers being
+// contiguous and of one same static shape (checked by
+// getVectorizationLength), the whole iteration space is collapsed into a
+// single flat loop over linearized views of the buffers: the per-dimension
+// index arithmetic disappears from the innermost loop, and short innermost
+// dimensions vectorize across the outer ones. The flat loop is blocked by
+// the vector length, and each block is processed with vector loads of all
+// the operands, one vector compute emitted by emitCompute, and one vector
+// store. emitCompute receives the vector compute type and the loaded operand
+// vectors.
+static void emitVectorizedElementwiseLoop(ConversionPatternRewriter &rewriter,
+    Location loc, MemRefType outputMemRefType, ArrayRef<Value> inputs,
+    Value alloc, int64_t VL,
+    function_ref<Value(Type, ArrayRef<Value>)> emitCompute) {
+  MultiDialectBuilder<KrnlBuilder, MemRefBuilder> create(rewriter, loc);
+  VectorType outputVecType =
+      VectorType::get({VL}, outputMemRefType.getElementType());
+  int64_t totalSize = outputMemRefType.getNumElements();
+  SmallVector<IndexExpr, 1> flatDims = {LiteralIndexExpr(totalSize)};
+  SmallVector<Value, 4> flatInputs;
+  for (Value input : inputs)
+    flatInputs.emplace_back(create.mem.reinterpretCast(input, flatDims));
+  Value flatAlloc = create.mem.reinterpretCast(alloc, flatDims);
+  ValueRange loopDef = create.krnl.defineLoops(1);
+  ValueRange blockedLoopDef = create.krnl.block(loopDef[0], VL);
+  // Iterate over the blocks only; each block is covered by vector ops.
+  SmallVector<IndexExpr, 1> lbs(1, LiteralIndexExpr(0));
+  SmallVector<IndexExpr, 1> ubs(1, LiteralIndexExpr(totalSize));
+  create.krnl.iterateIE(loopDef, {blockedLoopDef[0]}, lbs, ubs,
+      [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+        VectorBuilder createVec(createKrnl);
+        SmallVector<Value, 4> loadedVals;
+        for (Value flatInput : flatInputs) {
+          MemRefType inputType = flatInput.getType().cast<MemRefType>();
+          VectorType inputVecType =
+              VectorType::get({VL}, inputType.getElementType());
+          loadedVals.emplace_back(
+              createVec.load(inputVecType, flatInput, loopInd));
+        }
+        Value result = emitCompute(outputVecType, loadedVals);
+        createVec.store(result, flatAlloc, loopInd);
+      });
+}
+
 // Element-wise unary ops lowering to Krnl dialect.
 //===----------------------------------------------------------------------===//
 template <typename ElementwiseUnaryOp>
 struct ONNXElementwiseUnaryOpLowering : public ConversionPattern {
-  ONNXElementwiseUnaryOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+  bool enableSIMDAndFusion = false;
+
+  ONNXElementwiseUnaryOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableSIMDAndFusion)
       : ConversionPattern(
-            typeConverter, ElementwiseUnaryOp::getOperationName(), 1, ctx) {}
+            typeConverter, ElementwiseUnaryOp::getOperationName(), 1, ctx),
+        enableSIMDAndFusion(enableSIMDAndFusion) {}
   LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
       ConversionPatternRewriter &rewriter) const final {
     Location loc = ONNXLoc<ElementwiseUnaryOp>(op);
@@ -859,29 +993,64 @@ struct ONNXElementwiseUnaryOpLowering : public ConversionPattern {
     Value alloc = insertAllocAndDeallocSimple(
         rewriter, op, memRefType, loc, shapeHelper.getOutputDims(), alignment);
 
+    // Fold any chain of supported unary element-wise consumers into this loop
+    // nest so the chain makes a single pass over memory.
+    SmallVector<Operation *, 4> fusedOps;
+    // Fusing would confuse the static dealloc placement, which is keyed to
+    // the op whose buffer is reused; leave chains alone in that mode.
+    if (enableSIMDAndFusion && !ONNXToKrnl_gEmitDealloc)
+      getFusableConsumerChain(op, fusedOps);
+    auto emitCompute = [&](Type computeType, ArrayRef<Value> args) -> Value {
+      Value result = emitScalarOpFor<ElementwiseUnaryOp>(
+          rewriter, loc, op, computeType, {args[0]});
+      for (Operation *fusedOp : fusedOps)
+        result =
+            emitFusableScalarOpFor(rewriter, loc, fusedOp, computeType, result);
+      return result;
+    };
+
     // Only create krnl.iterate if one of the operands is not scalar tensor.
     if (!hasAllScalarValues(operands)) {
-      ValueRange loopDef = create.krnl.defineLoops(memRefType.getRank());
-      SmallVector<IndexExpr, 4> lbs(memRefType.getRank(), LiteralIndexExpr(0));
-      SmallVector<IndexExpr, 4> ubs;
-      create.krnlIE.getShapeAsDims(X, ubs);
-      create.krnl.iterateIE(loopDef, loopDef, lbs, ubs,
-          [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
-            Value loadedVal = createKrnl.load(X, loopInd);
-            auto loweredOpResult = emitScalarOpFor<ElementwiseUnaryOp>(
-                rewriter, loc, op, memRefType.getElementType(), {loadedVal});
-            // Store result in the resulting array.
-            createKrnl.store(loweredOpResult, alloc, loopInd);
-          });
+      // Cast converts element-wise with a single arith cast operation, which
+      // is vector-safe for integer element types as well.
+      bool allowIntElements =
+          std::is_same<ElementwiseUnaryOp, ONNXCastOp>::value;
+      int64_t VL =
+          enableSIMDAndFusion
+              ? getVectorizationLength(
+                    create.krnl, memRefType, {X}, allowIntElements)
+              : 0;
+      if (VL > 0) {
+        emitVectorizedElementwiseLoop(
+            rewriter, loc, memRefType, {X}, alloc, VL, emitCompute);
+      } else {
+        ValueRange loopDef = create.krnl.defineLoops(memRefType.getRank());
+        SmallVector<IndexExpr, 4> lbs(
+            memRefType.getRank(), LiteralIndexExpr(0));
+        SmallVector<IndexExpr, 4> ubs;
+        create.krnlIE.getShapeAsDims(X, ubs);
+        create.krnl.iterateIE(loopDef, loopDef, lbs, ubs,
+            [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+              Value loadedVal = createKrnl.load(X, loopInd);
+              Value loweredOpResult =
+                  emitCompute(memRefType.getElementType(), {loadedVal});
+              // Store result in the resulting array.
+              createKrnl.store(loweredOpResult, alloc, loopInd);
+            });
+      }
     } else {
       Value loadedVal = create.krnl.load(X);
-      auto loweredOpResult = emitScalarOpFor<ElementwiseUnaryOp>(
-          rewriter, loc, op, memRefType.getElementType(), {loadedVal});
+      Value loweredOpResult =
+          emitCompute(memRefType.getElementType(), {loadedVal});
       // Store result in the resulting array.
       create.krnl.store(loweredOpResult, alloc);
     }
 
     rewriter.replaceOp(op, alloc);
+    // The fused consumers produce the same buffer; rewire their uses to it
+    // and let the conversion framework retire them.
+    for (Operation *fusedOp : fusedOps)
+      rewriter.replaceOp(fusedOp, alloc);
     return success();
   }
 };
@@ -892,12 +1061,15 @@ struct ONNXElementwiseUnaryOpLowering : public ConversionPattern {
 //===----------------------------------------------------------------------===//
 template <typename ElementwiseBinaryOp>
 struct ONNXElementwiseBinaryOpLowering : public ConversionPattern {
+  bool enableSIMDAndFusion = false;
   bool isUniBroadcasting = false;
 
   ONNXElementwiseBinaryOpLowering(TypeConverter &typeConverter,
-      MLIRContext *ctx, bool isUniBroadcasting = false)
+      MLIRContext *ctx, bool enableSIMDAndFusion,
+      bool isUniBroadcasting = false)
       : ConversionPattern(
             typeConverter, ElementwiseBinaryOp::getOperationName(), 1, ctx) {
+    this->enableSIMDAndFusion = enableSIMDAndFusion;
     this->isUniBroadcasting = isUniBroadcasting;
   }
 
@@ -929,6 +1101,34 @@ struct ONNXElementwiseBinaryOpLowering : public ConversionPattern {
     Value alloc = insertAllocAndDeallocSimple(rewriter, op, outputMemRefType,
         loc, shapeHelper.getOutputDims(), alignment);
 
+    // Fold any chain of supported unary element-wise consumers into this loop
+    // nest so the chain makes a single pass over memory.
+    SmallVector<Operation *, 4> fusedOps;
+    if (enableSIMDAndFusion && !ONNXToKrnl_gEmitDealloc)
+      getFusableConsumerChain(op, fusedOps);
+    auto emitCompute = [&](Type computeType, ArrayRef<Value> args) -> Value {
+      Value result = emitScalarOpFor<ElementwiseBinaryOp>(
+          rewriter, loc, op, computeType, {args[0], args[1]});
+      for (Operation *fusedOp : fusedOps)
+        result =
+            emitFusableScalarOpFor(rewriter, loc, fusedOp, computeType, result);
+      return result;
+    };
+
+    // Vectorize over the innermost dimension when no broadcast is involved.
+    int64_t VL =
+        enableSIMDAndFusion
+            ? getVectorizationLength(create.krnl, outputMemRefType, operands)
+            : 0;
+    if (VL > 0) {
+      emitVectorizedElementwiseLoop(
+          rewriter, loc, outputMemRefType, operands, alloc, VL, emitCompute);
+      rewriter.replaceOp(op, alloc);
+      for (Operation *fusedOp : fusedOps)
+        rewriter.replaceOp(fusedOp, alloc);
+      return success();
+    }
+
     // Only create krnl.iterate if one of the operands is not scalar tensor.
     if (!hasAllScalarValues(operands)) {
       ValueRange loopDef = create.krnl.defineLoops(outputRank);
@@ -955,9 +1155,8 @@ struct ONNXElementwiseBinaryOpLowering : public ConversionPattern {
             assert(succeeded(res) && "Could not compute access indices");
             Value rhs = createKrnl.loadIE(operands[1], rhsAccessExprs);
 
-            // Apply the element-wise function.
-            Value result = emitScalarOpFor<ElementwiseBinaryOp>(
-                rewriter, loc, op, outputElementType, {lhs, rhs});
+            // Apply the element-wise function and any fused consumers.
+            Value result = emitCompute(outputElementType, {lhs, rhs});
 
             // Store result in the resulting array.
             createKrnl.store(result, alloc, loopInd);
@@ -966,15 +1165,16 @@ struct ONNXElementwiseBinaryOpLowering : public ConversionPattern {
       Value lhs = create.krnl.load(operands[0]);
       Value rhs = create.krnl.load(operands[1]);
 
-      // Apply the element-wise function.
-      Value result = emitScalarOpFor<ElementwiseBinaryOp>(
-          rewriter, loc, op, outputElementType, {lhs, rhs});
+      // Apply the element-wise function and any fused consumers.
+      Value result = emitCompute(outputElementType, {lhs, rhs});
 
       // Store result in the resulting array.
       create.krnl.store(result, alloc);
     }
 
     rewriter.replaceOp(op, alloc);
+    for (Operation *fusedOp : fusedOps)
+      rewriter.replaceOp(fusedOp, alloc);
 
     return success();
   }
@@ -984,10 +1184,13 @@ struct ONNXElementwiseBinaryOpLowering : public ConversionPattern {
 //===----------------------------------------------------------------------===//
 template <typename ElementwiseVariadicOp>
 struct ONNXElementwiseVariadicOpLowering : public ConversionPattern {
+  bool enableSIMDAndFusion = false;
+
   ONNXElementwiseVariadicOpLowering(
-      TypeConverter &typeConverter, MLIRContext *ctx)
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableSIMDAndFusion)
       : ConversionPattern(
-            typeConverter, ElementwiseVariadicOp::getOperationName(), 1, ctx) {}
+            typeConverter, ElementwiseVariadicOp::getOperationName(), 1, ctx),
+        enableSIMDAndFusion(enableSIMDAndFusion) {}
   LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
       ConversionPatternRewriter &rewriter) const final {
     Location loc = NameLoc::get(StringAttr::get(op->getContext(),
@@ -1016,6 +1219,38 @@ struct ONNXElementwiseVariadicOpLowering : public ConversionPattern {
     Value alloc = insertAllocAndDeallocSimple(rewriter, op, outputMemRefType,
         loc, shapeHelper.getOutputDims(), alignment);
 
+    // Fold any chain of supported unary element-wise consumers into this loop
+    // nest so the chain makes a single pass over memory.
+    SmallVector<Operation *, 4> fusedOps;
+    if (enableSIMDAndFusion && !ONNXToKrnl_gEmitDealloc)
+      getFusableConsumerChain(op, fusedOps);
+    auto emitCompute = [&](Type computeType, ArrayRef<Value> args) -> Value {
+      Value accumulated = args[0];
+      for (unsigned i = 1; i < numArgs; i++)
+        accumulated = emitScalarOpFor<ElementwiseVariadicOp>(
+            rewriter, loc, op, computeType, {accumulated, args[i]});
+      Value result = emitPostProcessingFor<ElementwiseVariadicOp>(
+          rewriter, loc, op, computeType, accumulated);
+      for (Operation *fusedOp : fusedOps)
+        result =
+            emitFusableScalarOpFor(rewriter, loc, fusedOp, computeType, result);
+      return result;
+    };
+
+    // Vectorize over the innermost dimension when no broadcast is involved.
+    int64_t VL =
+        enableSIMDAndFusion
+            ? getVectorizationLength(create.krnl, outputMemRefType, operands)
+            : 0;
+    if (VL > 0) {
+      emitVectorizedElementwiseLoop(
+          rewriter, loc, outputMemRefType, operands, alloc, VL, emitCompute);
+      rewriter.replaceOp(op, alloc);
+      for (Operation *fusedOp : fusedOps)
+        rewriter.replaceOp(fusedOp, alloc);
+      return success();
+    }
+
     // Only create krnl.iterate if one of the operands is not scalar tensor.
     if (!hasAllScalarValues(operands)) {
       ValueRange loopDef = create.krnl.defineLoops(outputRank);
@@ -1037,42 +1272,37 @@ struct ONNXElementwiseVariadicOpLowering : public ConversionPattern {
             assert(succeeded(res) && "Could not compute access indices");
             Value accumulated = createKrnl.loadIE(operands[0], oprdAccessExprs);
 
-            // Iterate over the remaining operands.
+            // Load the remaining operands.
+            SmallVector<Value, 4> loadedVals = {accumulated};
             for (unsigned i = 1; i < numArgs; i++) {
               // Obtain the next operand.
               SmallVector<IndexExpr, 4> oprdAccessExprs;
               LogicalResult res = shapeHelper.getAccessExprs(
                   operands[i], i, outputAccessExprs, oprdAccessExprs);
               assert(succeeded(res) && "Could not compute access indices");
-              Value next = createKrnl.loadIE(operands[i], oprdAccessExprs);
-              // Fold.
-              accumulated = emitScalarOpFor<ElementwiseVariadicOp>(
-                  rewriter, loc, op, outputElementType, {accumulated, next});
+              loadedVals.emplace_back(
+                  createKrnl.loadIE(operands[i], oprdAccessExprs));
             }
 
-            Value finalResult = emitPostProcessingFor<ElementwiseVariadicOp>(
-                rewriter, loc, op, outputElementType, accumulated);
+            // Fold over the operands and apply any fused consumers.
+            Value finalResult = emitCompute(outputElementType, loadedVals);
 
             // Store result in the resulting array.
             createKrnl.storeIE(finalResult, alloc, outputAccessExprs);
           });
     } else {
-      Value accumulated = create.krnl.load(operands[0]);
+      SmallVector<Value, 4> loadedVals;
+      for (unsigned i = 0; i < numArgs; i++)
+        loadedVals.emplace_back(create.krnl.load(operands[i]));
 
-      // Iterate over the remaining operands.
-      for (unsigned i = 1; i < numArgs; i++) {
-        // Obtain the next operand.
-        Value next = create.krnl.load(operands[i]);
-        // Fold.
-        accumulated = emitScalarOpFor<ElementwiseVariadicOp>(
-            rewriter, loc, op, outputElementType, {accumulated, next});
-      }
-      Value finalResult = emitPostProcessingFor<ElementwiseVariadicOp>(
-          rewriter, loc, op, outputElementType, accumulated);
+      // Fold over the operands and apply any fused consumers.
+      Value finalResult = emitCompute(outputElementType, loadedVals);
       // Store result in the resulting array.
       create.krnl.store(finalResult, alloc);
     }
     rewriter.replaceOp(op, alloc);
+    for (Operation *fusedOp : fusedOps)
+      rewriter.replaceOp(fusedOp, alloc);
     return success();
   }
 };
@@ -1174,8 +1404,292 @@ struct ONNXWhereOpLowering : public ConversionPattern {
   }
 };
 
+//===----------------------------------------------------------------------===//
+// Fused comparison + where lowering to Krnl dialect.
+//===----------------------------------------------------------------------===//
+
+/// Lower a comparison whose only use is the condition of an ONNXWhereOp as a
+/// single compare+select loop nest. The mask then stays in registers instead
+/// of being stored to and reloaded from an i1 buffer, which defeats
+/// vectorization of both loops; when the shapes allow it, the loop is
+/// vectorized and the compare produces a vector mask feeding a vector select,
+/// which maps onto the mask registers of wide SIMD targets. The pattern is
+/// rooted at the comparison because that is the first operation of the pair
+/// in program order, so the fusion fires before the individual operations are
+/// converted. Broadcast is not handled: the comparison operands and both
+/// branch values must share the output shape.
+template <typename CompareOp>
+struct ONNXCompareWhereOpLowering : public ConversionPattern {
+  bool enableSIMDAndFusion = false;
+
+  ONNXCompareWhereOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableSIMDAndFusion)
+      : ConversionPattern(typeConverter, CompareOp::getOperationName(), 2, ctx),
+        enableSIMDAndFusion(enableSIMDAndFusion) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    if (!enableSIMDAndFusion)
+      return failure();
+
+    // The comparison must feed only the condition of a where.
+    if (!op->getResult(0).hasOneUse())
+      return failure();
+    auto whereOp = dyn_cast<ONNXWhereOp>(*op->getResult(0).getUsers().begin());
+    if (!whereOp || whereOp.condition() != op->getResult(0))
+      return failure();
+
+    // All operands must share one static output shape, so no broadcast is
+    // involved and one loop index serves every access.
+    auto outputTensorType =
+        whereOp.getResult().getType().dyn_cast<RankedTensorType>();
+    if (!outputTensorType || !outputTensorType.hasStaticShape())
+      return failure();
+    if (whereOp.X().getType() != outputTensorType ||
+        whereOp.Y().getType() != outputTensorType)
+      return failure();
+    auto inputTensorType =
+        op->getOperand(0).getType().dyn_cast<RankedTensorType>();
+    if (!inputTensorType ||
+        inputTensorType.getShape() != outputTensorType.getShape() ||
+        op->getOperand(1).getType() != inputTensorType)
+      return failure();
+
+    // The branch values are not operands of the matched op, so the conversion
+    // has not remapped them for us; they are only usable when their buffers
+    // exist already.
+    Value lhs = rewriter.getRemappedValue(whereOp.X());
+    Value rhs = rewriter.getRemappedValue(whereOp.Y());
+    if (!lhs || !rhs || !lhs.getType().isa<MemRefType>() ||
+        !rhs.getType().isa<MemRefType>())
+      return failure();
+    SmallVector<Value, 4> inputs = {operands[0], operands[1], lhs, rhs};
+
+    Location loc = NameLoc::get(
+        StringAttr::get(op->getContext(), ONNXWhereOp::getOperationName()),
+        op->getLoc());
+
+    // Convert the output type to MemRefType.
+    Type convertedType = typeConverter->convertType(outputTensorType);
+    assert(convertedType && convertedType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType outputMemRefType = convertedType.cast<MemRefType>();
+    Type outputElementType = outputMemRefType.getElementType();
+    uint64_t outputRank = outputMemRefType.getRank();
+
+    MultiDialectBuilder<IndexExprBuilderForKrnl, KrnlBuilder> create(
+        rewriter, loc);
+    IndexExprScope outerScope(&rewriter, loc);
+
+    // Insert an allocation and deallocation for the result of this operation.
+    SmallVector<IndexExpr, 4> outputDims;
+    for (int64_t dim : outputMemRefType.getShape())
+      outputDims.emplace_back(LiteralIndexExpr(dim));
+    Value alloc = insertAllocAndDeallocSimple(
+        rewriter, whereOp.getOperation(), outputMemRefType, loc, outputDims);
+
+    // Fold any chain of supported unary element-wise consumers into this loop
+    // nest so the chain makes a single pass over memory.
+    SmallVector<Operation *, 4> fusedOps;
+    if (!ONNXToKrnl_gEmitDealloc)
+      getFusableConsumerChain(whereOp, fusedOps);
+    auto emitCompute = [&](Type computeType, ArrayRef<Value> args) -> Value {
+      Value cond = emitScalarOpFor<CompareOp>(
+          rewriter, loc, op, computeType, {args[0], args[1]});
+      MathBuilder createMath(rewriter, loc);
+      Value result = createMath.select(cond, args[2], args[3]);
+      for (Operation *fusedOp : fusedOps)
+        result =
+            emitFusableScalarOpFor(rewriter, loc, fusedOp, computeType, result);
+      return result;
+    };
+
+    // Vectorize over the innermost dimension when the element types allow it.
+    int64_t VL = getVectorizationLength(create.krnl, outputMemRefType, inputs);
+    if (VL > 0) {
+      emitVectorizedElementwiseLoop(
+          rewriter, loc, outputMemRefType, inputs, alloc, VL, emitCompute);
+    } else if (outputRank > 0) {
+      ValueRange loopDef = create.krnl.defineLoops(outputRank);
+      SmallVector<IndexExpr, 4> lbs(outputRank, LiteralIndexExpr(0));
+      SmallVector<IndexExpr, 4> ubs;
+      create.krnlIE.getShapeAsDims(alloc, ubs);
+      create.krnl.iterateIE(loopDef, loopDef, lbs, ubs,
+          [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+            SmallVector<Value, 4> loadedVals;
+            for (Value input : inputs)
+              loadedVals.emplace_back(createKrnl.load(input, loopInd));
+            Value result = emitCompute(outputElementType, loadedVals);
+            createKrnl.store(result, alloc, loopInd);
+          });
+    } else {
+      SmallVector<Value, 4> loadedVals;
+      for (Value input : inputs)
+        loadedVals.emplace_back(create.krnl.load(input));
+      Value result = emitCompute(outputElementType, loadedVals);
+      create.krnl.store(result, alloc);
+    }
+
+    rewriter.replaceOp(whereOp, alloc);
+    for (Operation *fusedOp : fusedOps)
+      rewriter.replaceOp(fusedOp, alloc);
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// Return true and set value when v is produced by an ONNXConstantOp holding a
+// single float scalar.
+static bool getScalarFloatConstant(Value v, double &value) {
+  auto constOp = v.getDefiningOp<ONNXConstantOp>();
+  if (!constOp)
+    return false;
+  DenseElementsAttr dense =
+      constOp.valueAttr().dyn_cast_or_null<DenseElementsAttr>();
+  if (!dense || dense.getNumElements() != 1 ||
+      !dense.getElementType().isa<FloatType>())
+    return false;
+  value = (*dense.getValues<APFloat>().begin()).convertToDouble();
+  return true;
+}
+
+/// Recognize the erf-based GELU subgraph emitted by exporters,
+///   y = 0.5 * x * (1 + erf(x / sqrt(2))),
+/// and lower the whole chain as a single loop nest instead of five. The
+/// pattern is rooted at the leading Div because that is the first operation
+/// of the chain in program order, so the fusion fires before the individual
+/// operations are converted. Both placements of the 0.5 factor are handled:
+/// a trailing Mul by 0.5, or a pre-multiplied Mul(x, 0.5) feeding the last
+/// Mul. The matched constants are used as is, so the emitted code computes
+/// exactly the same expression as the original chain.
+struct ONNXGeluOpLowering : public ConversionPattern {
+  ONNXGeluOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+      : ConversionPattern(
+            typeConverter, mlir::ONNXDivOp::getOperationName(), 2, ctx) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    auto divOp = cast<ONNXDivOp>(op);
+    Location loc = op->getLoc();
+
+    // x / sqrt(2).
+    Value x = divOp.A();
+    double sqrt2;
+    if (!getScalarFloatConstant(divOp.B(), sqrt2) ||
+        !divOp.getResult().hasOneUse())
+      return failure();
+
+    // erf(x / sqrt(2)).
+    auto erfOp = dyn_cast<ONNXErfOp>(*divOp.getResult().getUsers().begin());
+    if (!erfOp || !erfOp.getResult().hasOneUse())
+      return failure();
+
+    // 1 + erf(x / sqrt(2)).
+    auto addOp = dyn_cast<ONNXAddOp>(*erfOp.getResult().getUsers().begin());
+    if (!addOp || !addOp.getResult().hasOneUse())
+      return failure();
+    Value addOther = (addOp.A() == erfOp.getResult()) ? addOp.B() : addOp.A();
+    double one;
+    if (!getScalarFloatConstant(addOther, one))
+      return failure();
+
+    // Multiply by x and by 0.5.
+    auto mulOp = dyn_cast<ONNXMulOp>(*addOp.getResult().getUsers().begin());
+    if (!mulOp)
+      return failure();
+    Value mulOther = (mulOp.A() == addOp.getResult()) ? mulOp.B() : mulOp.A();
+    Operation *lastOp;
+    double half;
+    SmallVector<Operation *, 3> deadOps;
+    if (mulOther == x) {
+      // Trailing multiply by 0.5.
+      if (!mulOp.getResult().hasOneUse())
+        return failure();
+      auto halfMulOp =
+          dyn_cast<ONNXMulOp>(*mulOp.getResult().getUsers().begin());
+      if (!halfMulOp)
+        return failure();
+      Value halfVal = (halfMulOp.A() == mulOp.getResult()) ? halfMulOp.B()
+                                                           : halfMulOp.A();
+      if (!getScalarFloatConstant(halfVal, half))
+        return failure();
+      lastOp = halfMulOp.getOperation();
+      deadOps = {mulOp, addOp, erfOp};
+    } else if (auto halfXOp = mulOther.getDefiningOp<ONNXMulOp>()) {
+      // Pre-multiplied Mul(x, 0.5).
+      Value halfVal;
+      if (halfXOp.A() == x)
+        halfVal = halfXOp.B();
+      else if (halfXOp.B() == x)
+        halfVal = halfXOp.A();
+      else
+        return failure();
+      if (!getScalarFloatConstant(halfVal, half) ||
+          !halfXOp.getResult().hasOneUse())
+        return failure();
+      lastOp = mulOp.getOperation();
+      deadOps = {halfXOp, addOp, erfOp};
+    } else
+      return failure();
+
+    // Convert the output type to MemRefType.
+    Type convertedType =
+        typeConverter->convertType(lastOp->getResult(0).getType());
+    assert(convertedType && convertedType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType outputMemRefType = convertedType.cast<MemRefType>();
+    Type elementType = outputMemRefType.getElementType();
+    uint64_t outputRank = outputMemRefType.getRank();
+
+    ONNXDivOpAdaptor operandAdaptor(operands);
+    Value xMemRef = operandAdaptor.A();
+
+    MultiDialectBuilder<IndexExprBuilderForKrnl, KrnlBuilder, MathBuilder>
+        create(rewriter, loc);
+    Value cSqrt2 = create.math.constant(elementType, sqrt2);
+    Value cOne = create.math.constant(elementType, one);
+    Value cHalf = create.math.constant(elementType, half);
+
+    // Insert an allocation and deallocation for the result of this operation.
+    bool insertDealloc = checkInsertDealloc(lastOp);
+    Value alloc =
+        (hasAllConstantDimensions(outputMemRefType))
+            ? insertAllocAndDealloc(
+                  outputMemRefType, loc, rewriter, insertDealloc)
+            : insertAllocAndDealloc(
+                  outputMemRefType, loc, rewriter, insertDealloc, {xMemRef});
+
+    auto emitGelu = [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+      MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+      Value xVal = create.krnl.load(xMemRef, loopInd);
+      Value scaled = create.math.div(xVal, cSqrt2);
+      Value erfVal =
+          emitScalarOpFor<ONNXErfOp>(rewriter, loc, op, elementType, {scaled});
+      Value sum = create.math.add(erfVal, cOne);
+      Value y = create.math.mul(create.math.mul(xVal, sum), cHalf);
+      create.krnl.store(y, alloc, loopInd);
+    };
+
+    if (outputRank > 0) {
+      ValueRange loopDef = create.krnl.defineLoops(outputRank);
+      SmallVector<IndexExpr, 4> lbs(outputRank, LiteralIndexExpr(0));
+      SmallVector<IndexExpr, 4> ubs;
+      create.krnlIE.getShapeAsDims(xMemRef, ubs);
+      create.krnl.iterateIE(loopDef, loopDef, lbs, ubs, emitGelu);
+    } else
+      emitGelu(create.krnl, ValueRange());
+
+    rewriter.replaceOp(lastOp, alloc);
+    for (Operation *deadOp : deadOps)
+      rewriter.eraseOp(deadOp);
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
 void populateLoweringONNXElementwiseOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx) {
+    TypeConverter &typeConverter, MLIRContext *ctx,
+    bool enableFastElementwise) {
   patterns.insert<ONNXElementwiseUnaryOpLowering<mlir::ONNXAbsOp>,
       ONNXElementwiseVariadicOpLowering<mlir::ONNXAddOp>,
       ONNXElementwiseVariadicOpLowering<mlir::ONNXAndOp>,
@@ -1226,10 +1740,19 @@ void populateLoweringONNXElementwiseOpPattern(RewritePatternSet &patterns,
       ONNXElementwiseVariadicOpLowering<mlir::ONNXSubOp>,
       ONNXElementwiseVariadicOpLowering<mlir::ONNXSumOp>,
       ONNXElementwiseUnaryOpLowering<mlir::ONNXTanOp>,
-      ONNXElementwiseUnaryOpLowering<mlir::ONNXTanhOp>, ONNXWhereOpLowering,
-      ONNXElementwiseVariadicOpLowering<mlir::ONNXXorOp>>(typeConverter, ctx);
+      ONNXElementwiseUnaryOpLowering<mlir::ONNXTanhOp>,
+      ONNXElementwiseVariadicOpLowering<mlir::ONNXXorOp>>(
+      typeConverter, ctx, enableFastElementwise);
+  patterns.insert<ONNXWhereOpLowering>(typeConverter, ctx);
+  patterns.insert<ONNXCompareWhereOpLowering<mlir::ONNXEqualOp>,
+      ONNXCompareWhereOpLowering<mlir::ONNXGreaterOp>,
+      ONNXCompareWhereOpLowering<mlir::ONNXGreaterOrEqualOp>,
+      ONNXCompareWhereOpLowering<mlir::ONNXLessOp>,
+      ONNXCompareWhereOpLowering<mlir::ONNXLessOrEqualOp>>(
+      typeConverter, ctx, enableFastElementwise);
+  patterns.insert<ONNXGeluOpLowering>(typeConverter, ctx);
   patterns.insert<ONNXElementwiseBinaryOpLowering<mlir::ONNXPReluOp>>(
-      typeConverter, ctx, /*isUniBroadcasting=*/true);
+      typeConverter, ctx, enableFastElementwise, /*isUniBroadcasting=*/true);
 }
 
 } // namespace onnx_mlir
@@ -18,6 +18,7 @@
 #include "src/Dialect/Krnl/DialectBuilder.hpp"
 #include "src/Dialect/Krnl/KrnlHelper.hpp"
 #include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
+#include "src/Support/TargetCacheGeometry.hpp"
 
 // Used to trace which op are used, good for profiling apps.
 #define DEBUG_TYPE "gemm"
@@ -40,6 +41,19 @@ struct ONNXGemmOpLowering : public ConversionPattern {
 
   bool enableTiling;
 
+  // Compute the access indices for the (possibly broadcasted) bias C at the
+  // given output indices. Requires an active IndexExprScope.
+  void getBiasAccess(ONNXGemmOpShapeHelper &shapeHelper,
+      ValueRange outerIndices, SmallVectorImpl<Value> &cAccess) const {
+    for (int x = 2 - shapeHelper.cRank; x < 2; ++x) {
+      // If dim > 1, use loop index, otherwise broadcast on 0's element.
+      DimIndexExpr dim(shapeHelper.cDims[x]);
+      cAccess.emplace_back(
+          IndexExpr::select(dim > 1, DimIndexExpr(outerIndices[x]), 0)
+              .getValue());
+    }
+  }
+
   void genericGemm(ONNXGemmOp &gemmOp, ONNXGemmOpAdaptor &operandAdaptor,
       Type elementType, ONNXGemmOpShapeHelper &shapeHelper, Value alloc,
       Value zeroVal, Value alphaVal, Value betaVal,
@@ -94,16 +108,11 @@ struct ONNXGemmOpLowering : public ConversionPattern {
           Value res = create.math.mul(alphaVal, create.krnl.load(red));
           if (shapeHelper.hasBias) {
             SmallVector<Value, 2> cAccess;
-            for (int x = 2 - shapeHelper.cRank; x < 2; ++x) {
-              // If dim > 1, use loop index, otherwise broadcast on 0's element.
-              DimIndexExpr dim(shapeHelper.cDims[x]);
-              cAccess.emplace_back(
-                  IndexExpr::select(dim > 1, DimIndexExpr(outerIndices[x]), 0)
-                      .getValue());
-            }
+            getBiasAccess(shapeHelper, outerIndices, cAccess);
             Value c = create.krnl.load(operandAdaptor.C(), cAccess);
             res = create.math.add(res, create.math.mul(betaVal, c));
           }
+          res = applyFusedActivation(rewriter, loc, gemmOp.getOperation(), res);
           create.krnl.store(res, R, outerIndices);
         });
   }
@@ -124,13 +133,41 @@ struct ONNXGemmOpLowering : public ConversionPattern {
     LiteralIndexExpr zeroIE(0);
     Value z = zeroIE.getValue();
 
-    // Initialize alloc/R to zero.
+    // Initialize alloc/R. When alpha == 1 and there is a bias, seed the
+    // accumulator with beta*C so that the matmul below directly produces the
+    // final result and no separate pass over R is needed afterwards.
+    // Otherwise start from zero.
+    float alphaLit = gemmOp.alpha().convertToFloat();
+    float betaLit = gemmOp.beta().convertToFloat();
+    bool fuseBiasInit =
+        alphaLit == 1.0 && shapeHelper.hasBias && betaLit != 0.0;
     KrnlBuilder createKrnl(rewriter, loc);
-    createKrnl.memset(R, zeroVal);
+    if (fuseBiasInit) {
+      ValueRange initLoops = createKrnl.defineLoops(2);
+      createKrnl.iterateIE(initLoops, initLoops, {zeroIE, zeroIE}, {I, J},
+          [&](KrnlBuilder &createKrnl, ValueRange outerIndices) {
+            IndexExprScope innerScope(createKrnl, shapeHelper.getScope());
+            SmallVector<Value, 2> cAccess;
+            getBiasAccess(shapeHelper, outerIndices, cAccess);
+            Value c = createKrnl.load(operandAdaptor.C(), cAccess);
+            if (betaLit != 1.0) {
+              MathBuilder createMath(createKrnl);
+              c = createMath.mul(betaVal, c);
+            }
+            createKrnl.store(c, R, outerIndices);
+          });
+    } else {
+      createKrnl.memset(R, zeroVal);
+    }
 
     // Prepare for the computations.
-    // 1) Define blocking, with simdization along the j axis.
-    const int64_t iCacheTile(32), jCacheTile(64), kCacheTile(256);
+    // 1) Define blocking, with simdization along the j axis. The cache-level
+    // tile sizes are derived from the target cache geometry (-mcpu) so that
+    // one A tile fills L1d and one B tile a quarter of the private L2.
+    int64_t iCacheTile, jCacheTile, kCacheTile;
+    TargetCacheGeometry::get().getMatMulCacheTiles(
+        elementType.getIntOrFloatBitWidth() / 8, iCacheTile, jCacheTile,
+        kCacheTile);
     const int64_t iRegTile(4), jRegTile(16);
 
     bool unrollAndJam = DEBUG_UNROLL_OFF ? false : true;
@@ -166,8 +203,18 @@ struct ONNXGemmOpLowering : public ConversionPattern {
     SmallVector<IndexExpr, 1> empty;
     Value aBuff = insertAllocAndDeallocSimple(
         rewriter, gemmOp, aTileType, loc, empty, true, BUFFER_ALIGN);
-    Value bBuff = insertAllocAndDeallocSimple(
-        rewriter, gemmOp, bTileType, loc, empty, true, BUFFER_ALIGN);
+    // When B is a compile-time constant (typically weights), emit it in the
+    // pre-tiled layout directly in the constant segment and skip the runtime
+    // B copies; a transposed B is untransposed in the packed layout, so its
+    // runtime transpose disappears as well.
+    Value packedB;
+    if (J.isLiteral() && K.isLiteral())
+      packedB = emitPrepackedMatMulWeight(rewriter, loc, B, bTrans,
+          K.getLiteral(), J.getLiteral(), kCacheTile, jCacheTile);
+    Value bBuff;
+    if (!packedB)
+      bBuff = insertAllocAndDeallocSimple(
+          rewriter, gemmOp, bTileType, loc, empty, true, BUFFER_ALIGN);
     Value rBuff;
     if (mustTileR)
       rBuff = insertAllocAndDeallocSimple(
@@ -208,7 +255,13 @@ struct ONNXGemmOpLowering : public ConversionPattern {
                     createKrnl.copyToBuffer(aBuff, A, {k1, i1}, zeroVal, true);
                   else
                     createKrnl.copyToBuffer(aBuff, A, {i1, k1}, zeroVal, false);
-                  if (bTrans)
+                  Value bMat(bBuff);
+                  SmallVector<Value, 4> bStart{k1, j1};
+                  if (packedB) {
+                    bMat = packedB;
+                    bStart = getPrepackedMatMulWeightStarts(
+                        createKrnl, k1, j1, kCacheTile, jCacheTile);
+                  } else if (bTrans)
                     createKrnl.copyToBuffer(bBuff, B, {j1, k1}, zeroVal, true);
                   else
                     createKrnl.copyToBuffer(bBuff, B, {k1, j1}, zeroVal, false);
@@ -216,8 +269,8 @@ struct ONNXGemmOpLowering : public ConversionPattern {
                       [&](KrnlBuilder &createKrnl, ValueRange j2_i2_indices) {
                         Value j2(j2_i2_indices[0]), i2(j2_i2_indices[1]);
                         ArrayRef<int64_t> empty;
-                        createKrnl.matmul(aBuff, {i1, k1}, bBuff, {k1, j1},
-                            rBuff, {i1, j1},
+                        createKrnl.matmul(aBuff, {i1, k1}, bMat, bStart, rBuff,
+                            {i1, j1},
                             /*loops*/ {ii3, jj3, kk2},
                             /*compute start*/ {i2, j2, k1},
                             /*ubs*/ {I.getValue(), J.getValue(), K.getValue()},
@@ -246,7 +299,13 @@ struct ONNXGemmOpLowering : public ConversionPattern {
       createKrnl.iterateIE({jj, kk, ii}, {jj1, kk1}, {zeroIE, zeroIE, zeroIE},
           {J, K, I}, [&](KrnlBuilder &createKrnl, ValueRange j1_k1_indices) {
             Value j1(j1_k1_indices[0]), k1(j1_k1_indices[1]);
-            if (bTrans)
+            Value bMat(bBuff);
+            SmallVector<Value, 4> bStart{k1, j1};
+            if (packedB) {
+              bMat = packedB;
+              bStart = getPrepackedMatMulWeightStarts(
+                  createKrnl, k1, j1, kCacheTile, jCacheTile);
+            } else if (bTrans)
               createKrnl.copyToBuffer(bBuff, B, {j1, k1}, zeroVal, true);
             else
               createKrnl.copyToBuffer(bBuff, B, {k1, j1}, zeroVal, false);
@@ -260,7 +319,7 @@ struct ONNXGemmOpLowering : public ConversionPattern {
                   createKrnl.iterate({}, {jj2, ii2}, {}, {},
                       [&](KrnlBuilder &createKrnl, ValueRange j2_i2_indices) {
                         Value j2(j2_i2_indices[0]), i2(j2_i2_indices[1]);
-                        createKrnl.matmul(aBuff, {i1, k1}, bBuff, {k1, j1}, R,
+                        createKrnl.matmul(aBuff, {i1, k1}, bMat, bStart, R,
                             {z, z},
                             /*loops*/ {ii3, jj3, kk2},
                             /*compute start*/ {i2, j2, k1},
@@ -273,11 +332,21 @@ struct ONNXGemmOpLowering : public ConversionPattern {
           });
     }
 
-    // Perform the alpha/beta computations.
-    float alphaLit = gemmOp.alpha().convertToFloat();
-    float betaLit = gemmOp.beta().convertToFloat();
-    if (alphaLit == 1.0 && (betaLit == 0.0 || !shapeHelper.hasBias)) {
-      // No need for the multiply/add.
+    // Perform the alpha/beta computations. When alpha == 1, beta*C was either
+    // folded into the accumulator initialization above or there is nothing to
+    // add; only a fused activation, if any, still needs an in-place pass, as
+    // the matmul above already wrote the final values into R.
+    if (alphaLit == 1.0) {
+      if (hasFusedActivation(gemmOp.getOperation())) {
+        ValueRange actLoops = createKrnl.defineLoops(2);
+        createKrnl.iterateIE(actLoops, actLoops, {zeroIE, zeroIE}, {I, J},
+            [&](KrnlBuilder &createKrnl, ValueRange outerIndices) {
+              Value res = createKrnl.load(R, outerIndices);
+              res = applyFusedActivation(
+                  rewriter, loc, gemmOp.getOperation(), res);
+              createKrnl.store(res, R, outerIndices);
+            });
+      }
       return;
     }
     ValueRange outerLoops = createKrnl.defineLoops(2);
@@ -286,23 +355,17 @@ struct ONNXGemmOpLowering : public ConversionPattern {
           // Handle alpha/beta coefficients.
           Value res = createKrnl.load(R, outerIndices);
           MathBuilder createMath(createKrnl);
-          if (alphaLit != 1.0)
-            res = createMath.mul(alphaVal, res);
+          res = createMath.mul(alphaVal, res);
           if (shapeHelper.hasBias) {
             IndexExprScope innerScope(createKrnl, shapeHelper.getScope());
             SmallVector<Value, 2> cAccess;
-            for (int x = 2 - shapeHelper.cRank; x < 2; ++x) {
-              // If dim > 1, use loop index, otherwise broadcast on 0's element.
-              DimIndexExpr dim(shapeHelper.cDims[x]);
-              cAccess.emplace_back(
-                  IndexExpr::select(dim > 1, DimIndexExpr(outerIndices[x]), 0)
-                      .getValue());
-            }
+            getBiasAccess(shapeHelper, outerIndices, cAccess);
             Value c = createKrnl.load(operandAdaptor.C(), cAccess);
             if (betaLit != 1.0)
               c = createMath.mul(betaVal, c);
             res = createMath.add(res, c);
           }
+          res = applyFusedActivation(rewriter, loc, gemmOp.getOperation(), res);
           createKrnl.store(res, R, outerIndices);
         });
   }
@@ -314,6 +377,10 @@ struct ONNXGemmOpLowering : public ConversionPattern {
     ONNXGemmOpAdaptor operandAdaptor(operands);
     ONNXGemmOp gemmOp = llvm::cast<ONNXGemmOp>(op);
     Location loc = op->getLoc();
+    // Keep the node name in the location so that the krnl.matmul lowering can
+    // look up per-node unroll overrides from the unroll config file.
+    if (auto nodeName = op->getAttrOfType<StringAttr>("onnx_node_name"))
+      loc = NameLoc::get(nodeName, loc);
     IndexExprBuilderForKrnl createKrnlIE(rewriter, loc);
     ONNXGemmOpShapeHelper shapeHelper(op, operands, &createKrnlIE);
     shapeHelper.computeShapeAndAssertOnFailure();
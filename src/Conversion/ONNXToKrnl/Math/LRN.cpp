@@ -62,6 +62,17 @@ struct ONNXLRNOpLowering : public ConversionPattern {
     Value alloc = insertAllocAndDeallocSimple(
         rewriter, op, outputMemRefType, loc, shapeHelper.getOutputDims());
 
+    // With a static contiguous f32 shape whose innermost dimension is a
+    // multiple of the machine vector length, vectorize across the innermost
+    // dimension: the channel window reduction accumulates whole vectors and
+    // the power and division are computed on vectors. The scalar loop below
+    // covers the remaining cases.
+    if (emitVectorizedLRN(rewriter, loc, input, alloc, outputMemRefType,
+            biasLit, alphaLit, betaLit, sizeLit)) {
+      rewriter.replaceOp(op, alloc);
+      return success();
+    }
+
     ValueRange outputLoopDef = create.krnl.defineLoops(outputRank);
     SmallVector<IndexExpr, 4> lbs(outputRank, LiteralIndexExpr(0));
     create.krnl.iterateIE(outputLoopDef, outputLoopDef, lbs,
@@ -146,6 +157,123 @@ struct ONNXLRNOpLowering : public ConversionPattern {
     rewriter.replaceOp(op, alloc);
     return success();
   }
+
+private:
+  // Emit the vectorized LRN loop nest when the shapes allow it: static
+  // contiguous f32 buffers of rank >= 3 whose innermost dimension is a
+  // multiple of the machine vector length. The innermost loop is blocked by
+  // the vector length; each block loads vectors of the channel window,
+  // accumulates the squares with vector fused multiply-adds into a scratch
+  // accumulator hoisted out of the loop nest, and computes the power and the
+  // division on whole vectors. Returns false when the shapes do not allow
+  // it.
+  bool emitVectorizedLRN(ConversionPatternRewriter &rewriter, Location loc,
+      Value input, Value alloc, MemRefType outputMemRefType, float biasLit,
+      float alphaLit, float betaLit, int sizeLit) const {
+    int64_t rank = outputMemRefType.getRank();
+    Type elementType = outputMemRefType.getElementType();
+    MemRefType inputType = input.getType().cast<MemRefType>();
+    if (rank < 3 || !elementType.isF32() ||
+        !outputMemRefType.hasStaticShape() ||
+        !outputMemRefType.getLayout().isIdentity() ||
+        inputType.getShape() != outputMemRefType.getShape() ||
+        !inputType.getLayout().isIdentity())
+      return false;
+
+    MultiDialectBuilder<KrnlBuilder, MathBuilder, MemRefBuilder,
+        VectorBuilder>
+        create(rewriter, loc);
+    int64_t VL = create.vec.getMachineVectorLength(elementType);
+    ArrayRef<int64_t> shape = outputMemRefType.getShape();
+    int64_t innermostSize = shape[rank - 1];
+    if (VL <= 1 || innermostSize < VL || innermostSize % VL != 0)
+      return false;
+
+    VectorType vecType = VectorType::get({VL}, elementType);
+    Value biasVec = create.vec.broadcast(
+        vecType, create.math.constant(elementType, biasLit));
+    Value alphaDivSizeVec = create.vec.broadcast(
+        vecType, create.math.constant(elementType, alphaLit / (float)sizeLit));
+    Value betaVec = create.vec.broadcast(
+        vecType, create.math.constant(elementType, betaLit));
+    Value zeroVec = create.vec.broadcast(
+        vecType, create.math.constant(elementType, 0));
+
+    // Vector-wide square-sum accumulator, hoisted out of the loop nest.
+    Value sumAlloc = create.mem.alloca(MemRefType::get({}, vecType));
+
+    IndexExprScope outerScope(&rewriter, loc);
+    ValueRange loopDef = create.krnl.defineLoops(rank);
+    ValueRange blockedLoopDef = create.krnl.block(loopDef[rank - 1], VL);
+    SmallVector<Value, 4> optimizedDef;
+    for (int64_t i = 0; i < rank - 1; ++i)
+      optimizedDef.emplace_back(loopDef[i]);
+    optimizedDef.emplace_back(blockedLoopDef[0]);
+    SmallVector<IndexExpr, 4> lbs(rank, LiteralIndexExpr(0));
+    SmallVector<IndexExpr, 4> ubs;
+    for (int64_t i = 0; i < rank; ++i)
+      ubs.emplace_back(LiteralIndexExpr(shape[i]));
+    create.krnl.iterateIE(loopDef, optimizedDef, lbs, ubs,
+        [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+          IndexExprScope childScope(createKrnl);
+          MultiDialectBuilder<KrnlBuilder, MathBuilder, VectorBuilder> create(
+              createKrnl);
+
+          // Channel window
+          //   max(0, c - floor((size-1)/2)) <= i
+          //   i < min(C, c + 1 + ceil((size-1)/2)).
+          constexpr int loopIndexForC = 1;
+          DimIndexExpr cIE(loopInd[loopIndexForC]);
+          SymbolIndexExpr sizeIE = LiteralIndexExpr(sizeLit);
+          SmallVector<IndexExpr, 2> lbMaxList;
+          lbMaxList.emplace_back(LiteralIndexExpr(0));
+          lbMaxList.emplace_back(
+              cIE - (sizeIE - 1).floorDiv(LiteralIndexExpr(2)));
+          SmallVector<IndexExpr, 2> ubMinList;
+          ubMinList.emplace_back(LiteralIndexExpr(shape[loopIndexForC]));
+          ubMinList.emplace_back(
+              cIE + 1 + (sizeIE - 1).ceilDiv(LiteralIndexExpr(2)));
+
+          create.krnl.store(zeroVec, sumAlloc);
+
+          // Square-sum reduction over the channel window.
+          // Old style Krnl Loop definition: do not reuse pattern.
+          std::vector<Value> loop;
+          defineLoops(rewriter, loc, loop, 1);
+          krnl::KrnlIterateOperandPack pack(rewriter, loop);
+          pack.pushIndexExprsBound(lbMaxList);
+          pack.pushIndexExprsBound(ubMinList);
+          KrnlIterateOp iterateOp = create.krnl.iterate(pack);
+          Block &iterationBlock = iterateOp.bodyRegion().front();
+          Value sumLoopInd = iterationBlock.getArguments()[0];
+          auto outputLoopBody = rewriter.saveInsertionPoint();
+          rewriter.setInsertionPointToStart(&iterationBlock);
+          {
+            MultiDialectBuilder<KrnlBuilder, VectorBuilder> create(
+                rewriter, loc);
+            SmallVector<Value, 4> loadIndices;
+            for (int64_t i = 0; i < rank; ++i)
+              loadIndices.emplace_back(
+                  (i == loopIndexForC) ? sumLoopInd : loopInd[i]);
+            Value xVec = create.vec.load(vecType, input, loadIndices);
+            Value sumVec = create.krnl.load(sumAlloc);
+            create.krnl.store(create.vec.fma(xVec, xVec, sumVec), sumAlloc);
+          }
+          rewriter.restoreInsertionPoint(outputLoopBody);
+
+          // y = x / ((bias + (alpha / size) * square_sum) ** beta)
+          SmallVector<Value, 4> storeIndices(loopInd.begin(), loopInd.end());
+          Value xVec = create.vec.load(vecType, input, storeIndices);
+          Value sumVec = create.krnl.load(sumAlloc);
+          Value denomVec = create.math.pow(
+              create.math.add(
+                  biasVec, create.math.mul(alphaDivSizeVec, sumVec)),
+              betaVec);
+          create.vec.store(
+              create.math.div(xVec, denomVec), alloc, storeIndices);
+        });
+    return true;
+  }
 };
 
 void populateLoweringONNXLRNOpPattern(RewritePatternSet &patterns,
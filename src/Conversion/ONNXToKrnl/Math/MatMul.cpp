@@ -20,21 +20,45 @@
 #include "src/Dialect/Mlir/DialectBuilder.hpp"
 #include "src/Dialect/Mlir/IndexExpr.hpp"
 #include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
+#include "src/Support/TargetCacheGeometry.hpp"
 
 #define DEBUG_TYPE "matmul"
 static constexpr int32_t DISABLE_MAT_VEC_PRODUCT = 0;
+// Thresholds for the split-K parallel schedule: it only pays off for
+// tall-skinny products, where the parallel dimension I is too small to occupy
+// the cores and the reduction dimension K is long enough to give every chunk
+// a meaningful amount of work.
+static constexpr int64_t SPLIT_K_MAX_I = 32;
+static constexpr int64_t SPLIT_K_MIN_K = 2048;
+static constexpr int64_t SPLIT_K_MIN_CHUNK = 512;
+static constexpr int64_t SPLIT_K_MAX_CHUNKS = 8;
 
 using namespace mlir;
 
 namespace onnx_mlir {
 
+// Copy a requested accumulation type annotation from the ONNX matmul onto the
+// krnl.matmul that implements it, so the register-tile lowering can honor it.
+static void tagAccumType(ONNXMatMulOp &matMulOp, KrnlMatMulOp mmOp) {
+  if (auto accum = matMulOp->getAttrOfType<StringAttr>("accum_type"))
+    mmOp->setAttr("accum_type", accum);
+}
+
 struct ONNXMatMulOpLowering : public ConversionPattern {
-  ONNXMatMulOpLowering(
-      TypeConverter &typeConverter, MLIRContext *ctx, bool enableTiling)
+  ONNXMatMulOpLowering(TypeConverter &typeConverter, MLIRContext *ctx,
+      bool enableTiling, float sparseWeightDensity, bool enableParallel,
+      int64_t l2ResidentCores)
       : ConversionPattern(
             typeConverter, mlir::ONNXMatMulOp::getOperationName(), 1, ctx),
-        enableTiling(enableTiling) {}
+        enableTiling(enableTiling), sparseWeightDensity(sparseWeightDensity),
+        enableParallel(enableParallel), l2ResidentCores(l2ResidentCores) {}
   bool enableTiling;
+  // Density threshold below which constant 2D weights are stored in CSR form
+  // and multiplied with the sparse-dense kernel; 0 disables the sparse path.
+  float sparseWeightDensity;
+  bool enableParallel;
+  // Fixed core count of the L2-resident partitioning mode; 0 disables it.
+  int64_t l2ResidentCores;
   // Handle the generic cases, including when there are broadcasts.
   void replaceGenericMatmul(ONNXMatMulOp &matMulOp,
       ONNXMatMulOpAdaptor &operandAdaptor, Type elementType,
@@ -58,16 +82,25 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
     IndexExpr innerUb = shapeHelper.aDims[aRank - 1];
     loopUbs.emplace_back(innerUb);
     SmallVector<Value, 1> innerLoop{loopDef[totLoopNum - 1]}; // Last loop def.
+    // 16-bit float inputs stay narrow in memory but accumulate in f32, like
+    // the register tiles in the krnl.matmul lowering. An annotated
+    // accumulation type overrides that default either way.
+    Type accumType = elementType;
+    if (elementType.isF16() || elementType.isBF16())
+      accumType = rewriter.getF32Type();
+    if (Type requested =
+            getRequestedAccumType(matMulOp.getOperation(), elementType))
+      accumType = requested;
     // Single scalar, no need for default alignment.
     Value reductionVal =
-        create.mem.alignedAlloca(MemRefType::get({}, elementType));
+        create.mem.alignedAlloca(MemRefType::get({}, accumType));
 
     // Non-reduction loop iterations: output-rank.
     create.krnl.iterateIE(loopDef, outerLoops, loopLbs, loopUbs,
         [&](KrnlBuilder &createKrnl, ValueRange outerIndices) {
           MultiDialectBuilder<KrnlBuilder, MemRefBuilder, MathBuilder> create(
               createKrnl);
-          create.krnl.store(fZero, reductionVal);
+          create.krnl.store(create.math.cast(accumType, fZero), reductionVal);
           // Inner loop for reduction.
           create.krnl.iterate({}, innerLoop, {}, {},
               [&](KrnlBuilder &createKrnl, ValueRange innerIndex) {
@@ -104,17 +137,18 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
                   }
                 }
                 // Add mat mul operation.
-                Value loadedA =
-                    create.krnl.load(operandAdaptor.A(), aAccessFct);
-                Value loadedB =
-                    create.krnl.load(operandAdaptor.B(), bAccessFct);
+                Value loadedA = create.math.cast(accumType,
+                    create.krnl.load(operandAdaptor.A(), aAccessFct));
+                Value loadedB = create.math.cast(accumType,
+                    create.krnl.load(operandAdaptor.B(), bAccessFct));
                 Value loadedY = create.krnl.load(reductionVal);
                 Value AB = create.math.mul(loadedA, loadedB);
                 Value accumulated = create.math.add(loadedY, AB);
                 create.krnl.store(accumulated, reductionVal);
               });
           Value accumulated = create.krnl.load(reductionVal);
-          create.krnl.store(accumulated, alloc, outerIndices);
+          create.krnl.store(
+              create.math.cast(elementType, accumulated), alloc, outerIndices);
         });
   }
 
@@ -226,6 +260,431 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
     });
   }
 
+  // Cache blocking pays for its packing overhead only when the matrices no
+  // longer fit in cache. Use the blocked schedule when every dimension is
+  // either unknown at compile time (assume large) or reaches its cache tile.
+  // A user shape contract (--shapeContracts) bounding a dynamic dimension
+  // below its cache tile counts like a small static dimension.
+  bool isCacheTilingProfitable(DimIndexExpr dimI, DimIndexExpr dimJ,
+      DimIndexExpr dimK, Value A, Value B, Type elementType) const {
+    int64_t iCacheTile, jCacheTile, kCacheTile;
+    TargetCacheGeometry::get().getMatMulCacheTiles(
+        elementType.getIntOrFloatBitWidth() / 8, iCacheTile, jCacheTile,
+        kCacheTile);
+    int64_t iSize =
+        dimI.isLiteral() ? dimI.getLiteral() : getContractDimUpperBound(A, 0);
+    int64_t jSize =
+        dimJ.isLiteral() ? dimJ.getLiteral() : getContractDimUpperBound(B, 1);
+    int64_t kSize =
+        dimK.isLiteral() ? dimK.getLiteral() : getContractDimUpperBound(A, 1);
+    if (iSize >= 0 && iSize < iCacheTile)
+      return false;
+    if (jSize >= 0 && jSize < jCacheTile)
+      return false;
+    if (kSize >= 0 && kSize < kCacheTile)
+      return false;
+    return true;
+  }
+
+  // Cache-blocked variant of the 2D mat-mat product, mirroring the tiled
+  // Gemm schedule: A and B tiles are packed into contiguous cache-resident
+  // buffers with the copy-to-buffer ops, and the register-level kernel runs
+  // over the packed tiles. A constant B (weights) is instead packed once at
+  // compile time and read directly from the constant segment. When J is dynamic or not a multiple of the
+  // register tile, C is buffered as well so that the simdized dimension of
+  // the kernel has known, vector-friendly bounds.
+  void replaceTiledMatmul2d(ONNXMatMulOp &matMulOp,
+      ONNXMatMulOpAdaptor &operandAdaptor, Type elementType,
+      ONNXMatMulOpShapeHelper &shapeHelper, Value alloc, Value zeroVal,
+      ConversionPatternRewriter &rewriter, Location loc) const {
+    Value A(operandAdaptor.A()), B(operandAdaptor.B()), C(alloc);
+    IndexExpr I = shapeHelper.getOutputDims()[0];
+    IndexExpr J = shapeHelper.getOutputDims()[1];
+    IndexExpr K = shapeHelper.aDims[1];
+    LiteralIndexExpr zeroIE(0);
+    Value z = zeroIE.getValue();
+
+    // Initialize alloc/C to zero.
+    KrnlBuilder createKrnl(rewriter, loc);
+    createKrnl.memset(C, zeroVal);
+
+    // 1) Define blocking, with simdization along the j axis. The cache-level
+    // tile sizes are derived from the target cache geometry (-mcpu) so that
+    // one A tile fills L1d and one B tile a quarter of the private L2.
+    int64_t iCacheTile, jCacheTile, kCacheTile;
+    TargetCacheGeometry::get().getMatMulCacheTiles(
+        elementType.getIntOrFloatBitWidth() / 8, iCacheTile, jCacheTile,
+        kCacheTile);
+    const int64_t iRegTile(4), jRegTile(16);
+
+    bool unrollAndJam = true;
+    // Simdize with jRegTile as the vector length.
+    bool simdize = true;
+
+    bool mustTileC = false;
+    if (!J.isLiteral()) {
+      // Assume large J, will simdize, but since the simdized dimension must
+      // be a multiple of the vector length, we must tile C into a smaller
+      // block of known dimensions that are compatible with SIMD. A user
+      // shape contract promising that J is a multiple of the vector length
+      // makes the buffering unnecessary.
+      mustTileC = getContractDimMultiple(B, 1) % jRegTile != 0;
+    } else {
+      int64_t jVal = J.getLiteral();
+      if (jVal < jRegTile) {
+        // Very small computation, give up on SIMD.
+        simdize = false;
+      } else if (jVal % jRegTile != 0) {
+        // J is not divisible by the vector length; go to buffering.
+        mustTileC = true;
+      }
+    }
+
+    // 2) Alloc data for tiles.
+    MemRefType aTileType =
+        MemRefType::get({iCacheTile, kCacheTile}, elementType);
+    MemRefType bTileType =
+        MemRefType::get({kCacheTile, jCacheTile}, elementType);
+    MemRefType cTileType =
+        MemRefType::get({iCacheTile, jCacheTile}, elementType);
+    SmallVector<IndexExpr, 1> empty;
+    Value aBuff = insertAllocAndDeallocSimple(
+        rewriter, matMulOp, aTileType, loc, empty, true, BUFFER_ALIGN);
+    // When B is a compile-time constant (typically weights), emit it in the
+    // pre-tiled layout directly in the constant segment and skip the runtime
+    // B copies: repacking the same weights on every inference is pure
+    // overhead.
+    Value packedB;
+    if (J.isLiteral() && K.isLiteral())
+      packedB = emitPrepackedMatMulWeight(rewriter, loc, B,
+          /*transposed=*/false, K.getLiteral(), J.getLiteral(), kCacheTile,
+          jCacheTile);
+    Value bBuff;
+    if (!packedB)
+      bBuff = insertAllocAndDeallocSimple(
+          rewriter, matMulOp, bTileType, loc, empty, true, BUFFER_ALIGN);
+    Value cBuff;
+    if (mustTileC)
+      cBuff = insertAllocAndDeallocSimple(
+          rewriter, matMulOp, cTileType, loc, empty, true, BUFFER_ALIGN);
+
+    // 3) Introduce the loops and permute them.
+    // I, J, K loop.
+    ValueRange origLoop = createKrnl.defineLoops(3);
+    Value ii(origLoop[0]), jj(origLoop[1]), kk(origLoop[2]);
+    // Tile I.
+    ValueRange iCacheBlock = createKrnl.block(ii, iCacheTile);
+    ValueRange iRegBlock = createKrnl.block(iCacheBlock[1], iRegTile);
+    Value ii1(iCacheBlock[0]), ii2(iRegBlock[0]), ii3(iRegBlock[1]);
+    // Tile J.
+    ValueRange jCacheBlock = createKrnl.block(jj, jCacheTile);
+    ValueRange jRegBlock = createKrnl.block(jCacheBlock[1], jRegTile);
+    Value jj1(jCacheBlock[0]), jj2(jRegBlock[0]), jj3(jRegBlock[1]);
+    // Tile K.
+    ValueRange kCacheBlock = createKrnl.block(kk, kCacheTile);
+    Value kk1(kCacheBlock[0]), kk2(kCacheBlock[1]);
+
+    // If we must tile the result C, then we put I & J in the outermost.
+    // Otherwise, we follow the more traditional scheme of having J & K in
+    // the outermost.
+    if (mustTileC) {
+      // (cache) ii1 jj1 kk1,    (reg) jj2, ii2,    (matmul) ii3, jj3, kk2.
+      createKrnl.permute({ii1, ii2, ii3, jj1, jj2, jj3, kk1, kk2},
+          {/*i*/ 0, 4, 5, /*j*/ 1, 3, 6, /*k*/ 2, 7});
+      // Compute: A[i, k] * B[k, j] -> C[i, j].
+      createKrnl.iterateIE({ii, jj, kk}, {ii1, jj1}, {zeroIE, zeroIE, zeroIE},
+          {I, J, K}, [&](KrnlBuilder &createKrnl, ValueRange i1_j1_indices) {
+            Value i1(i1_j1_indices[0]), j1(i1_j1_indices[1]);
+            createKrnl.copyToBuffer(cBuff, C, {i1, j1}, zeroVal, false);
+            createKrnl.iterateIE({}, {kk1}, {}, {},
+                [&](KrnlBuilder &createKrnl, ValueRange k1_index) {
+                  Value k1(k1_index[0]);
+                  createKrnl.copyToBuffer(aBuff, A, {i1, k1}, zeroVal, false);
+                  Value bMat(bBuff);
+                  SmallVector<Value, 4> bStart{k1, j1};
+                  if (packedB) {
+                    bMat = packedB;
+                    bStart = getPrepackedMatMulWeightStarts(
+                        createKrnl, k1, j1, kCacheTile, jCacheTile);
+                  } else
+                    createKrnl.copyToBuffer(bBuff, B, {k1, j1}, zeroVal, false);
+                  createKrnl.iterate({}, {jj2, ii2}, {}, {},
+                      [&](KrnlBuilder &createKrnl, ValueRange j2_i2_indices) {
+                        Value j2(j2_i2_indices[0]), i2(j2_i2_indices[1]);
+                        tagAccumType(matMulOp,
+                            createKrnl.matmul(aBuff, {i1, k1}, bMat, bStart,
+                                cBuff, {i1, j1},
+                                /*loops*/ {ii3, jj3, kk2},
+                                /*compute start*/ {i2, j2, k1},
+                                /*ubs*/
+                                {I.getValue(), J.getValue(), K.getValue()},
+                                /*compute tile*/
+                                {iRegTile, jRegTile, kCacheTile},
+                                /* a/b/c tiles*/ {}, {}, {}, simdize,
+                                unrollAndJam, false));
+                      });
+                });
+            createKrnl.copyFromBuffer(cBuff, C, {i1, j1});
+          });
+    } else {
+      // Does not have to tile the result.
+      // (cache) jj1 kk1, ii1, (reg) jj2, ii2, (matmul) ii3, jj3, kk2.
+      // Krnl Rule: put all the values in the permute, including the ones
+      // that are not iterated over explicitly. All of the same derived
+      // (tiled) variable must be consecutive, and different original
+      // variables must be ordered in the same permute order. Js must be
+      // first as the outermost level is a j, then all the Ks, then all the
+      // Is.
+      createKrnl.permute({jj1, jj2, jj3, kk1, kk2, ii1, ii2, ii3},
+          {/*j*/ 0, 3, 5, /*k*/ 1, 6, /*i*/ 2, 4, 7});
+      // Compute: A[i, k] * B[k, j] -> C[i, j].
+      createKrnl.iterateIE({jj, kk, ii}, {jj1, kk1}, {zeroIE, zeroIE, zeroIE},
+          {J, K, I}, [&](KrnlBuilder &createKrnl, ValueRange j1_k1_indices) {
+            Value j1(j1_k1_indices[0]), k1(j1_k1_indices[1]);
+            Value bMat(bBuff);
+            SmallVector<Value, 4> bStart{k1, j1};
+            if (packedB) {
+              bMat = packedB;
+              bStart = getPrepackedMatMulWeightStarts(
+                  createKrnl, k1, j1, kCacheTile, jCacheTile);
+            } else
+              createKrnl.copyToBuffer(bBuff, B, {k1, j1}, zeroVal, false);
+            createKrnl.iterateIE({}, {ii1}, {}, {},
+                [&](KrnlBuilder &createKrnl, ValueRange i1_index) {
+                  Value i1(i1_index[0]);
+                  createKrnl.copyToBuffer(aBuff, A, {i1, k1}, zeroVal, false);
+                  createKrnl.iterate({}, {jj2, ii2}, {}, {},
+                      [&](KrnlBuilder &createKrnl, ValueRange j2_i2_indices) {
+                        Value j2(j2_i2_indices[0]), i2(j2_i2_indices[1]);
+                        tagAccumType(matMulOp,
+                            createKrnl.matmul(aBuff, {i1, k1}, bMat, bStart, C,
+                                {z, z},
+                                /*loops*/ {ii3, jj3, kk2},
+                                /*compute start*/ {i2, j2, k1},
+                                /*ubs*/
+                                {I.getValue(), J.getValue(), K.getValue()},
+                                /*compute tile*/
+                                {iRegTile, jRegTile, kCacheTile},
+                                /* a/b/c tiles*/ {}, {}, {}, simdize,
+                                unrollAndJam, false));
+                      });
+                });
+          });
+    }
+  }
+
+  // Split-K schedule for tall-skinny 2D products. When I is small, tiling I
+  // and J cannot occupy more than a couple of cores, so the reduction
+  // dimension K is split into chunks instead: each chunk runs the
+  // register-tiled kernel over its own K range in parallel and accumulates
+  // into a private IxJ slab of a partial buffer (no synchronization on C),
+  // and a sequential epilogue sums the slabs into C. Requires static shapes
+  // with I small and K long enough to amortize the partial-buffer traffic;
+  // returns false when the shape does not qualify.
+  bool replaceSplitKMatmul2d(ONNXMatMulOp &matMulOp,
+      ONNXMatMulOpAdaptor &operandAdaptor, Type elementType,
+      ONNXMatMulOpShapeHelper &shapeHelper, Value alloc, Value zeroVal,
+      ConversionPatternRewriter &rewriter, Location loc) const {
+    IndexExpr I = shapeHelper.getOutputDims()[0];
+    IndexExpr J = shapeHelper.getOutputDims()[1];
+    IndexExpr K = shapeHelper.aDims[1];
+    if (!I.isLiteral() || !J.isLiteral() || !K.isLiteral())
+      return false;
+    int64_t iVal = I.getLiteral(), jVal = J.getLiteral(), kVal = K.getLiteral();
+    // Tall-skinny only; J==1 belongs to the mat-vec kernel.
+    if (iVal > SPLIT_K_MAX_I || jVal < 2 || kVal < SPLIT_K_MIN_K)
+      return false;
+
+    // Use the same register tiles as the sequential schedule.
+    int64_t iRegTile, jRegTile, kRegTile;
+    bool simdize = true;
+    DimIndexExpr dimI(I), dimJ(J), dimK(K);
+    computeTileSizeForMatMatProduct(
+        dimI, dimJ, dimK, iRegTile, jRegTile, kRegTile, simdize);
+
+    // Chunk the reduction dimension. Chunk sizes are multiples of the K
+    // register tile so that chunk boundaries never cut a register tile; only
+    // the very last tile of the last chunk may be partial.
+    int64_t numChunks = std::min(SPLIT_K_MAX_CHUNKS, kVal / SPLIT_K_MIN_CHUNK);
+    if (numChunks < 2)
+      return false;
+    int64_t chunkSize = (kVal + numChunks - 1) / numChunks;
+    chunkSize = ((chunkSize + kRegTile - 1) / kRegTile) * kRegTile;
+    numChunks = (kVal + chunkSize - 1) / chunkSize;
+    if (numChunks < 2)
+      return false;
+    LLVM_DEBUG({
+      llvm::dbgs() << "MatMul: split-K with " << numChunks << " chunks of "
+                   << chunkSize << "\n";
+    });
+
+    Value A(operandAdaptor.A()), B(operandAdaptor.B()), C(alloc);
+    MultiDialectBuilder<KrnlBuilder, MathBuilder> create(rewriter, loc);
+    Value zero = create.math.constantIndex(0);
+    Value iUb = create.math.constantIndex(iVal);
+    Value jUb = create.math.constantIndex(jVal);
+    Value numChunksUb = create.math.constantIndex(numChunks);
+
+    // Privatized partial accumulators, one IxJ slab per chunk.
+    MemRefType partialType =
+        MemRefType::get({numChunks, iVal, jVal}, elementType);
+    SmallVector<IndexExpr, 1> empty;
+    Value partials = insertAllocAndDeallocSimple(
+        rewriter, matMulOp, partialType, loc, empty, true, BUFFER_ALIGN);
+    create.krnl.memset(partials, zeroVal);
+
+    // Parallel loop over the K chunks.
+    LiteralIndexExpr zeroIE(0), numChunksIE(numChunks);
+    ValueRange chunkLoop = create.krnl.defineLoops(1);
+    create.krnl.parallel(chunkLoop);
+    create.krnl.iterateIE(chunkLoop, chunkLoop, {zeroIE}, {numChunksIE},
+        [&](KrnlBuilder &createKrnl, ValueRange chunkIndices) {
+          MultiDialectBuilder<KrnlBuilder> create(createKrnl);
+          IndexExprScope chunkScope(createKrnl);
+          Value chunk = chunkIndices[0];
+          IndexExpr kChunkLb = DimIndexExpr(chunk) * chunkSize;
+          IndexExpr kChunkUb = IndexExpr::min(kChunkLb + chunkSize, kVal);
+          IndexExpr chunkZeroIE = LiteralIndexExpr(0);
+          IndexExpr iIE = LiteralIndexExpr(iVal);
+          IndexExpr jIE = LiteralIndexExpr(jVal);
+          // I, J, K loop over the chunk's K range, blocked and permuted as in
+          // the sequential schedule.
+          ValueRange origLoop = create.krnl.defineLoops(3);
+          Value ii(origLoop[0]), jj(origLoop[1]), kk(origLoop[2]);
+          ValueRange iRegBlock = create.krnl.block(ii, iRegTile);
+          Value ii1(iRegBlock[0]), ii2(iRegBlock[1]);
+          ValueRange jRegBlock = create.krnl.block(jj, jRegTile);
+          Value jj1(jRegBlock[0]), jj2(jRegBlock[1]);
+          ValueRange kRegBlock = create.krnl.block(kk, kRegTile);
+          Value kk1(kRegBlock[0]), kk2(kRegBlock[1]);
+          create.krnl.permute(
+              {ii1, ii2, jj1, jj2, kk1, kk2}, {0, 3, 1, 4, 2, 5});
+          Value kChunkUbVal = kChunkUb.getValue();
+          create.krnl.iterateIE({ii, jj, kk}, {ii1, jj1, kk1},
+              {chunkZeroIE, chunkZeroIE, kChunkLb}, {iIE, jIE, kChunkUb},
+              [&](KrnlBuilder &createKrnl, ValueRange indices) {
+                Value i1(indices[0]), j1(indices[1]), k1(indices[2]);
+                // The chunk's slab of the partial buffer plays the role of C;
+                // clamp K at the chunk boundary so tiles never read past it.
+                tagAccumType(matMulOp,
+                    createKrnl.matmul(A, {zero, zero}, B, {zero, zero},
+                        partials, {chunk, zero, zero}, {ii2, jj2, kk2},
+                        {i1, j1, k1}, {iUb, jUb, kChunkUbVal},
+                        {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
+                        /*unroll*/ true, /*overcompute*/ false));
+              });
+        });
+
+    // Sequential reduction epilogue: C = sum of the per-chunk slabs.
+    create.krnl.memset(C, zeroVal);
+    ValueRange redLoop = create.krnl.defineLoops(3);
+    create.krnl.iterate(redLoop, redLoop, {zero, zero, zero},
+        {numChunksUb, iUb, jUb},
+        [&](KrnlBuilder &createKrnl, ValueRange indices) {
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          Value c(indices[0]), i(indices[1]), j(indices[2]);
+          Value partial = create.krnl.load(partials, {c, i, j});
+          Value accumulated = create.krnl.load(C, {i, j});
+          create.krnl.store(create.math.add(accumulated, partial), C, {i, j});
+        });
+    return true;
+  }
+
+  // L2-resident partitioning schedule for small 2D products. The J (output
+  // column) dimension is split into one slice per core so that each core
+  // repeatedly streams A against its own KxJslice panel of B; when that panel
+  // fits in half the L2 cache it stays resident across the whole product and
+  // B is read from memory exactly once per core. Slices write to disjoint
+  // columns of C, so no partial buffers or epilogue are needed. Requires
+  // static shapes and a B panel small enough to be L2-resident; returns false
+  // when the shape does not qualify.
+  bool replaceL2PartitionedMatmul2d(ONNXMatMulOp &matMulOp,
+      ONNXMatMulOpAdaptor &operandAdaptor, Type elementType,
+      ONNXMatMulOpShapeHelper &shapeHelper, Value alloc, Value zeroVal,
+      ConversionPatternRewriter &rewriter, Location loc) const {
+    IndexExpr I = shapeHelper.getOutputDims()[0];
+    IndexExpr J = shapeHelper.getOutputDims()[1];
+    IndexExpr K = shapeHelper.aDims[1];
+    if (!I.isLiteral() || !J.isLiteral() || !K.isLiteral())
+      return false;
+    int64_t iVal = I.getLiteral(), jVal = J.getLiteral(), kVal = K.getLiteral();
+
+    // Use the same register tiles as the sequential schedule.
+    int64_t iRegTile, jRegTile, kRegTile;
+    bool simdize = true;
+    DimIndexExpr dimI(I), dimJ(J), dimK(K);
+    computeTileSizeForMatMatProduct(
+        dimI, dimJ, dimK, iRegTile, jRegTile, kRegTile, simdize);
+
+    // One J slice per core, rounded up to a multiple of the J register tile
+    // so that slice boundaries never cut a register tile.
+    int64_t jSlice = (jVal + l2ResidentCores - 1) / l2ResidentCores;
+    jSlice = ((jSlice + jRegTile - 1) / jRegTile) * jRegTile;
+    int64_t numSlices = (jVal + jSlice - 1) / jSlice;
+    if (numSlices < 2)
+      return false;
+    // Each core's panel of B must fit in half the L2, leaving the other half
+    // for the A and C traffic that streams through it.
+    int64_t panelBytes =
+        kVal * jSlice * (elementType.getIntOrFloatBitWidth() / 8);
+    if (panelBytes > TargetCacheGeometry::get().l2Size / 2)
+      return false;
+    LLVM_DEBUG({
+      llvm::dbgs() << "MatMul: L2 partitioning with " << numSlices
+                   << " slices of " << jSlice << " columns\n";
+    });
+
+    Value A(operandAdaptor.A()), B(operandAdaptor.B()), C(alloc);
+    MultiDialectBuilder<KrnlBuilder, MathBuilder> create(rewriter, loc);
+    Value zero = create.math.constantIndex(0);
+    Value iUb = create.math.constantIndex(iVal);
+    Value kUb = create.math.constantIndex(kVal);
+    create.krnl.memset(C, zeroVal);
+
+    // Parallel loop over the J slices.
+    LiteralIndexExpr zeroIE(0), numSlicesIE(numSlices);
+    ValueRange sliceLoop = create.krnl.defineLoops(1);
+    create.krnl.parallel(sliceLoop);
+    create.krnl.iterateIE(sliceLoop, sliceLoop, {zeroIE}, {numSlicesIE},
+        [&](KrnlBuilder &createKrnl, ValueRange sliceIndices) {
+          MultiDialectBuilder<KrnlBuilder> create(createKrnl);
+          IndexExprScope sliceScope(createKrnl);
+          Value slice = sliceIndices[0];
+          IndexExpr jSliceLb = DimIndexExpr(slice) * jSlice;
+          IndexExpr jSliceUb = IndexExpr::min(jSliceLb + jSlice, jVal);
+          IndexExpr sliceZeroIE = LiteralIndexExpr(0);
+          IndexExpr iIE = LiteralIndexExpr(iVal);
+          IndexExpr kIE = LiteralIndexExpr(kVal);
+          // I, J, K loop over the slice's columns, blocked and permuted as in
+          // the sequential schedule.
+          ValueRange origLoop = create.krnl.defineLoops(3);
+          Value ii(origLoop[0]), jj(origLoop[1]), kk(origLoop[2]);
+          ValueRange iRegBlock = create.krnl.block(ii, iRegTile);
+          Value ii1(iRegBlock[0]), ii2(iRegBlock[1]);
+          ValueRange jRegBlock = create.krnl.block(jj, jRegTile);
+          Value jj1(jRegBlock[0]), jj2(jRegBlock[1]);
+          ValueRange kRegBlock = create.krnl.block(kk, kRegTile);
+          Value kk1(kRegBlock[0]), kk2(kRegBlock[1]);
+          create.krnl.permute(
+              {ii1, ii2, jj1, jj2, kk1, kk2}, {0, 3, 1, 4, 2, 5});
+          Value jSliceUbVal = jSliceUb.getValue();
+          create.krnl.iterateIE({ii, jj, kk}, {ii1, jj1, kk1},
+              {sliceZeroIE, jSliceLb, sliceZeroIE}, {iIE, jSliceUb, kIE},
+              [&](KrnlBuilder &createKrnl, ValueRange indices) {
+                Value i1(indices[0]), j1(indices[1]), k1(indices[2]);
+                // Clamp J at the slice boundary so tiles never write into the
+                // next core's columns.
+                tagAccumType(matMulOp,
+                    createKrnl.matmul(A, {zero, zero}, B, {zero, zero}, C,
+                        {zero, zero}, {ii2, jj2, kk2}, {i1, j1, k1},
+                        {iUb, jSliceUbVal, kUb},
+                        {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
+                        /*unroll*/ true, /*overcompute*/ false));
+              });
+        });
+    return true;
+  }
+
   // Handle the cases with 2x2 matrices both for A, B, and C without
   // broadcast. Implementation here uses the efficient 1d tiling plus kernel
   // substitution.
@@ -233,6 +692,22 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
       ONNXMatMulOpAdaptor &operandAdaptor, Type elementType,
       ONNXMatMulOpShapeHelper &shapeHelper, Value alloc, Value zeroVal,
       ConversionPatternRewriter &rewriter, Location loc) const {
+    // Tall-skinny products parallelize poorly over I and J; when parallel
+    // execution is enabled, split the reduction dimension across threads
+    // instead.
+    if (enableParallel &&
+        replaceSplitKMatmul2d(matMulOp, operandAdaptor, elementType,
+            shapeHelper, alloc, zeroVal, rewriter, loc))
+      return;
+    // When a core count is given, partition the output columns across cores
+    // so that each core's panel of B stays L2-resident; overrides the packed
+    // cache-tiled schedule, whose shared packing buffers cannot be
+    // parallelized.
+    if (enableParallel && l2ResidentCores > 0 &&
+        replaceL2PartitionedMatmul2d(matMulOp, operandAdaptor, elementType,
+            shapeHelper, alloc, zeroVal, rewriter, loc))
+      return;
+
     // Prepare: loop bounds and zero
     Value A(operandAdaptor.A()), B(operandAdaptor.B()), C(alloc);
     MultiDialectBuilder<KrnlBuilder, MemRefBuilder, MathBuilder, VectorBuilder>
@@ -242,15 +717,24 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
     Value J = create.mem.dim(C, 1);
     Value K = create.mem.dim(A, 1);
 
-    // Initialize alloc/C to zero.
-    create.krnl.memset(alloc, zeroVal);
-    bool simdize = true;
-
     // Define blocking, with simdization along the j axis.
     DimIndexExpr dimI(I), dimJ(J), dimK(K);
     int64_t iRegTile, jRegTile, kRegTile;
     bool isMatVectorProduct =
         !DISABLE_MAT_VEC_PRODUCT && dimJ.isLiteral() && dimJ.getLiteral() == 1;
+    if (!isMatVectorProduct &&
+        isCacheTilingProfitable(dimI, dimJ, dimK, A, B, elementType)) {
+      // Large product: add cache-level blocking with packed tiles on top of
+      // the register tiling below.
+      replaceTiledMatmul2d(matMulOp, operandAdaptor, elementType, shapeHelper,
+          alloc, zeroVal, rewriter, loc);
+      return;
+    }
+
+    // Initialize alloc/C to zero.
+    create.krnl.memset(alloc, zeroVal);
+    bool simdize = true;
+
     if (isMatVectorProduct) {
       int64_t mVL = create.vec.getMachineVectorLength(elementType);
       computeTileSizeForMatVectProduct(
@@ -274,10 +758,11 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
     create.krnl.iterate({ii, jj, kk}, {ii1, jj1, kk1}, {zero, zero, zero},
         {I, J, K}, [&](KrnlBuilder &createKrnl, ValueRange indices) {
           Value i1(indices[0]), j1(indices[1]), k1(indices[2]);
-          createKrnl.matmul(A, {zero, zero}, B, {zero, zero}, C, {zero, zero},
-              {ii2, jj2, kk2}, {i1, j1, k1}, {I, J, K},
-              {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
-              /*unroll*/ true, /*overcompute*/ false);
+          tagAccumType(matMulOp,
+              createKrnl.matmul(A, {zero, zero}, B, {zero, zero}, C,
+                  {zero, zero}, {ii2, jj2, kk2}, {i1, j1, k1}, {I, J, K},
+                  {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
+                  /*unroll*/ true, /*overcompute*/ false));
         });
   }
 
@@ -363,28 +848,157 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
                 broadcastGlobalStart.emplace_back(zero);
                 if (sameStaticBroadcast) {
                   // Each of A, B, & C starts at broadcastGlobalStart.
-                  createKrnl.matmul(A, broadcastGlobalStart, B,
-                      broadcastGlobalStart, C, broadcastGlobalStart,
-                      {ii2, jj2, kk2}, {i1, j1, k1}, {I, J, K},
-                      {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
-                      /*unroll*/ true, /*overcompute*/ false);
+                  tagAccumType(matMulOp,
+                      createKrnl.matmul(A, broadcastGlobalStart, B,
+                          broadcastGlobalStart, C, broadcastGlobalStart,
+                          {ii2, jj2, kk2}, {i1, j1, k1}, {I, J, K},
+                          {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
+                          /*unroll*/ true, /*overcompute*/ false));
                 } else if (broadcastingB) {
                   // B & C start at broadcastGlobalStart, A starts at {0,0}.
-                  createKrnl.matmul(A, {zero, zero}, B, broadcastGlobalStart, C,
-                      broadcastGlobalStart, {ii2, jj2, kk2}, {i1, j1, k1},
-                      {I, J, K}, {iRegTile, jRegTile, kRegTile}, {}, {}, {},
-                      simdize, /*unroll*/ true, /*overcompute*/ false);
+                  tagAccumType(matMulOp,
+                      createKrnl.matmul(A, {zero, zero}, B,
+                          broadcastGlobalStart, C, broadcastGlobalStart,
+                          {ii2, jj2, kk2}, {i1, j1, k1}, {I, J, K},
+                          {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
+                          /*unroll*/ true, /*overcompute*/ false));
                 } else {
                   // A & C start at broadcastGlobalStart, B starts at {0,0}.
-                  createKrnl.matmul(A, broadcastGlobalStart, B, {zero, zero}, C,
-                      broadcastGlobalStart, {ii2, jj2, kk2}, {i1, j1, k1},
-                      {I, J, K}, {iRegTile, jRegTile, kRegTile}, {}, {}, {},
-                      simdize, /*unroll*/ true, /*overcompute*/ false);
+                  tagAccumType(matMulOp,
+                      createKrnl.matmul(A, broadcastGlobalStart, B,
+                          {zero, zero}, C, broadcastGlobalStart,
+                          {ii2, jj2, kk2}, {i1, j1, k1}, {I, J, K},
+                          {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
+                          /*unroll*/ true, /*overcompute*/ false));
                 }
               });
         });
   }
 
+  // Handle the 2D case where B is a compile-time constant whose density
+  // (fraction of nonzero elements) is below the sparse weight threshold,
+  // typically the weights of a pruned model. B is converted once at compile
+  // time into CSR form (values, column indices, and row pointers over the K
+  // rows), stored in the constant segment, and multiplied with a sparse-dense
+  // kernel that only visits the nonzeros:
+  //   for i, for k: C[i, colidx[p]] += A[i, k] * values[p]
+  //                 for p in rowptr[k] .. rowptr[k+1].
+  // A[i, k] is read once per row of B, and each nonzero contributes exactly
+  // one multiply-add, so work scales with nnz instead of K*J. The scattered
+  // column accesses rule out simdization, which is why the path only pays off
+  // below the density threshold. Returns false without emitting any code when
+  // the sparse path does not apply.
+  bool replaceSparseMatmul2d(ONNXMatMulOp &matMulOp,
+      ONNXMatMulOpAdaptor &operandAdaptor, Type elementType,
+      ONNXMatMulOpShapeHelper &shapeHelper, Value alloc, Value zeroVal,
+      ConversionPatternRewriter &rewriter, Location loc) const {
+    if (sparseWeightDensity <= 0.0f)
+      return false;
+    // Only float weights are pruned in practice; CSR values are stored in the
+    // element type of B.
+    if (!elementType.isa<FloatType>())
+      return false;
+    Value A(operandAdaptor.A()), B(operandAdaptor.B()), C(alloc);
+    DenseElementsAttr dense = getDenseElementAttributeFromConstantValue(B);
+    if (!dense)
+      return false;
+    auto denseType = dense.getType().dyn_cast<RankedTensorType>();
+    if (!denseType || denseType.getRank() != 2 || !denseType.hasStaticShape())
+      return false;
+    int64_t K = denseType.getShape()[0];
+    int64_t J = denseType.getShape()[1];
+
+    // Scan B once to count the nonzeros and decide whether the sparse path
+    // pays off.
+    int64_t nnz = 0;
+    for (llvm::APFloat v : dense.getValues<llvm::APFloat>())
+      if (!v.isZero())
+        ++nnz;
+    if (nnz == 0)
+      return false; // Degenerate all-zero weight; memset alone would do.
+    float density = (float)nnz / (float)(K * J);
+    if (density >= sparseWeightDensity)
+      return false;
+    LLVM_DEBUG({
+      llvm::dbgs() << "MatMul: sparse CSR path, nnz " << nnz << " of " << K * J
+                   << " (density " << density << ")\n";
+    });
+
+    // Build the CSR triple from the row-major dense attribute.
+    SmallVector<llvm::APFloat> csrValues;
+    SmallVector<int64_t> csrColIdx, csrRowPtr;
+    csrValues.reserve(nnz);
+    csrColIdx.reserve(nnz);
+    csrRowPtr.reserve(K + 1);
+    auto values = dense.value_begin<llvm::APFloat>();
+    for (int64_t k = 0; k < K; ++k) {
+      csrRowPtr.emplace_back(csrColIdx.size());
+      for (int64_t j = 0; j < J; ++j) {
+        llvm::APFloat v = *(values + (k * J + j));
+        if (v.isZero())
+          continue;
+        csrValues.emplace_back(v);
+        csrColIdx.emplace_back(j);
+      }
+    }
+    csrRowPtr.emplace_back(csrColIdx.size());
+
+    // Emit the CSR arrays into the constant segment.
+    MultiDialectBuilder<KrnlBuilder, MathBuilder> create(rewriter, loc);
+    Type i64Type = rewriter.getI64Type();
+    Value valuesGlobal =
+        create.krnl.constant(MemRefType::get({nnz}, elementType),
+            "sparse_matmul_values",
+            DenseElementsAttr::get(
+                RankedTensorType::get({nnz}, elementType), csrValues));
+    Value colIdxGlobal = create.krnl.constant(MemRefType::get({nnz}, i64Type),
+        "sparse_matmul_colidx",
+        DenseElementsAttr::get(
+            RankedTensorType::get({nnz}, i64Type), ArrayRef<int64_t>(csrColIdx)));
+    Value rowPtrGlobal =
+        create.krnl.constant(MemRefType::get({K + 1}, i64Type),
+            "sparse_matmul_rowptr",
+            DenseElementsAttr::get(RankedTensorType::get({K + 1}, i64Type),
+                ArrayRef<int64_t>(csrRowPtr)));
+
+    // Initialize alloc/C to zero; the kernel only touches rows with nonzeros.
+    create.krnl.memset(alloc, zeroVal);
+
+    // for i, for k: scale row k of the CSR nonzeros by A[i, k].
+    IndexExpr I = shapeHelper.getOutputDims()[0];
+    ValueRange ikLoops = create.krnl.defineLoops(2);
+    SmallVector<IndexExpr, 2> ikLbs(2, LiteralIndexExpr(0));
+    SmallVector<IndexExpr, 2> ikUbs{I, LiteralIndexExpr(K)};
+    create.krnl.iterateIE(ikLoops, ikLoops, ikLbs, ikUbs,
+        [&](KrnlBuilder &createKrnl, ValueRange ikIndices) {
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          IndexExprScope ikScope(createKrnl);
+          Value i(ikIndices[0]), k(ikIndices[1]);
+          Value a = create.krnl.load(A, {i, k});
+          // Nonzeros of row k live in [rowptr[k], rowptr[k+1]).
+          Value rowStart =
+              create.math.castToIndex(create.krnl.load(rowPtrGlobal, {k}));
+          Value kNext = (DimIndexExpr(k) + 1).getValue();
+          Value rowEnd =
+              create.math.castToIndex(create.krnl.load(rowPtrGlobal, {kNext}));
+          ValueRange pLoop = create.krnl.defineLoops(1);
+          create.krnl.iterateIE(pLoop, pLoop, {DimIndexExpr(rowStart)},
+              {DimIndexExpr(rowEnd)},
+              [&](KrnlBuilder &createKrnl, ValueRange pIndex) {
+                MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                    createKrnl);
+                Value p(pIndex[0]);
+                Value j = create.math.castToIndex(
+                    create.krnl.load(colIdxGlobal, {p}));
+                Value b = create.krnl.load(valuesGlobal, {p});
+                Value c = create.krnl.load(C, {i, j});
+                create.krnl.store(
+                    create.math.add(c, create.math.mul(a, b)), C, {i, j});
+              });
+        });
+    return true;
+  }
+
   // Handle the cases with 2x2 matrices both for A, B, and C without
   // broadcast, broadcast of A to rank 2 B,  broadcast of B to rank 2 A, or
   // static, identical shaped broadcasting size A & B.
@@ -395,6 +1009,10 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
     ONNXMatMulOpAdaptor operandAdaptor(operands);
     ONNXMatMulOp matMulOp = llvm::cast<ONNXMatMulOp>(op);
     Location loc = ONNXLoc<ONNXMatMulOp>(op);
+    // Keep the node name in the location so that the krnl.matmul lowering can
+    // look up per-node unroll overrides from the unroll config file.
+    if (auto nodeName = op->getAttrOfType<StringAttr>("onnx_node_name"))
+      loc = NameLoc::get(nodeName, loc);
     MultiDialectBuilder<IndexExprBuilderForKrnl, MathBuilder> create(
         rewriter, loc);
 
@@ -420,18 +1038,27 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
     int aRank = A.getType().cast<MemRefType>().getShape().size();
     int bRank = B.getType().cast<MemRefType>().getShape().size();
     int cRank = alloc.getType().cast<MemRefType>().getShape().size();
-    if (enableTiling && aRank == 2 && bRank == 2) {
+    // Ops measured as hot spots are tiled even when the optimization level
+    // alone would not enable tiling.
+    bool tile = enableTiling || opIsProfileHot(op);
+    if (aRank == 2 && bRank == 2 &&
+        replaceSparseMatmul2d(matMulOp, operandAdaptor, elementType,
+            shapeHelper, alloc, zero, rewriter, loc)) {
+      // Pruned constant weights below the density threshold: CSR storage and
+      // the sparse-dense kernel were emitted above.
+      assert(cRank == 2 && "expected IxK * KxJ = IxJ 2D result");
+    } else if (tile && aRank == 2 && bRank == 2) {
       // Optimized Matmul only when 2D and allowed to tile and unroll.
       assert(cRank == 2 && "expected IxK * KxJ = IxJ 2D result");
       replace2x2Matmul2d(matMulOp, operandAdaptor, elementType, shapeHelper,
           alloc, zero, rewriter, loc);
-    } else if (enableTiling && aRank == 2 && bRank > 2) {
+    } else if (tile && aRank == 2 && bRank > 2) {
       // Broadcasting B.
       assert(cRank == bRank && "expected IxK * *xKxJ = *xIxJ result");
       replace2x2Matmul2dBroadcasting(matMulOp, operandAdaptor, elementType,
           shapeHelper, /*broadcasting B*/ true,
           /*same static broadcast*/ false, alloc, zero, rewriter, loc);
-    } else if (enableTiling && aRank > 2 && bRank == 2) {
+    } else if (tile && aRank > 2 && bRank == 2) {
       // Broadcasting A.
       assert(cRank == aRank && "expected IxK * *xKxJ = *xIxJ result");
       replace2x2Matmul2dBroadcasting(matMulOp, operandAdaptor, elementType,
@@ -439,7 +1066,7 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
           /*same static broadcast*/ false, alloc, zero, rewriter, loc);
     } else {
       // Test if have A and B have identical static broadcast shapes.
-      bool sameStaticBroadcast = (enableTiling && aRank > 2 && aRank == bRank);
+      bool sameStaticBroadcast = (tile && aRank > 2 && aRank == bRank);
       if (sameStaticBroadcast) {
         auto aShape = A.getType().cast<MemRefType>().getShape();
         auto bShape = B.getType().cast<MemRefType>().getShape();
@@ -468,8 +1095,10 @@ struct ONNXMatMulOpLowering : public ConversionPattern {
 }; // namespace onnx_mlir
 
 void populateLoweringONNXMatMulOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx, bool enableTiling) {
-  patterns.insert<ONNXMatMulOpLowering>(typeConverter, ctx, enableTiling);
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableTiling,
+    float sparseWeightDensity, bool enableParallel, int64_t l2ResidentCores) {
+  patterns.insert<ONNXMatMulOpLowering>(typeConverter, ctx, enableTiling,
+      sparseWeightDensity, enableParallel, l2ResidentCores);
 }
 
 } // namespace onnx_mlir
@@ -116,6 +116,217 @@ Value emitScalarOpFor<ONNXReduceMinOp>(ConversionPatternRewriter &rewriter,
   return createMath.select(min, lhs, rhs);
 }
 
+//===----------------------------------------------------------------------===//
+// Elementwise epilogue fusion.
+//===----------------------------------------------------------------------===//
+
+// Return the trailing elementwise operation to fuse into the reduction
+// epilogue, or nullptr when there is none. A candidate is the only user of
+// the reduction result, lives in the same block, and produces the same shape
+// and element type, so the fused operation can be applied in place when the
+// reduction writes its result back. Supported epilogues are the unary Sqrt,
+// Exp and Abs on floating point results, and Add, Sub, Mul and Div against a
+// scalar constant. This covers the reduction tails in normalization
+// patterns, e.g. a ReduceSum whose result is divided into a mean, without a
+// round-trip of the reduced tensor through a second buffer.
+static Operation *getEpilogueOpToFuse(Operation *reduceOp) {
+  Value result = reduceOp->getResult(0);
+  if (!result.hasOneUse())
+    return nullptr;
+  Operation *user = *result.getUsers().begin();
+  if (user->getBlock() != reduceOp->getBlock())
+    return nullptr;
+  if (user->getNumResults() != 1 ||
+      user->getResult(0).getType() != result.getType())
+    return nullptr;
+  Type elementType = result.getType().cast<ShapedType>().getElementType();
+  if (isa<ONNXSqrtOp, ONNXExpOp, ONNXAbsOp>(user))
+    return elementType.isa<FloatType>() ? user : nullptr;
+  if (!isa<ONNXAddOp, ONNXSubOp, ONNXMulOp, ONNXDivOp>(user))
+    return nullptr;
+  Value other = (user->getOperand(0) == result) ? user->getOperand(1)
+                                                : user->getOperand(0);
+  DenseElementsAttr dense = getDenseElementAttributeFromONNXValue(other);
+  if (!dense || dense.getNumElements() != 1)
+    return nullptr;
+  return user;
+}
+
+// Materialize the scalar constant operand of a fused binary epilogue as an
+// arithmetic constant of the reduction element type, and report on which
+// side of the epilogue the reduction result sits. Returns nullptr for the
+// unary epilogues, which take no constant.
+static Value getEpilogueScalarConstant(ConversionPatternRewriter &rewriter,
+    Location loc, Operation *epilogueOp, Value reduceResult, Type elementType,
+    bool &reduceIsLhs) {
+  reduceIsLhs = true;
+  if (epilogueOp->getNumOperands() != 2)
+    return nullptr;
+  MathBuilder createMath(rewriter, loc);
+  reduceIsLhs = (epilogueOp->getOperand(0) == reduceResult);
+  Value other =
+      reduceIsLhs ? epilogueOp->getOperand(1) : epilogueOp->getOperand(0);
+  DenseElementsAttr dense = getDenseElementAttributeFromONNXValue(other);
+  double val;
+  if (dense.getElementType().isa<FloatType>())
+    val = (*dense.getValues<APFloat>().begin()).convertToDouble();
+  else
+    val = (*dense.getValues<APInt>().begin()).getSExtValue();
+  return createMath.constant(elementType, val);
+}
+
+// Apply the fused epilogue operation to one scalar reduction result.
+static Value emitEpilogueScalarOp(ConversionPatternRewriter &rewriter,
+    Location loc, Operation *epilogueOp, Value reduced, Value scalar,
+    bool reduceIsLhs) {
+  MathBuilder createMath(rewriter, loc);
+  if (isa<ONNXSqrtOp>(epilogueOp))
+    return createMath.sqrt(reduced);
+  if (isa<ONNXExpOp>(epilogueOp))
+    return createMath.exp(reduced);
+  if (isa<ONNXAbsOp>(epilogueOp))
+    return createMath.abs(reduced);
+  Value lhs = reduceIsLhs ? reduced : scalar;
+  Value rhs = reduceIsLhs ? scalar : reduced;
+  if (isa<ONNXAddOp>(epilogueOp))
+    return createMath.add(lhs, rhs);
+  if (isa<ONNXSubOp>(epilogueOp))
+    return createMath.sub(lhs, rhs);
+  if (isa<ONNXMulOp>(epilogueOp))
+    return createMath.mul(lhs, rhs);
+  assert(isa<ONNXDivOp>(epilogueOp) && "unexpected fused epilogue op");
+  return createMath.div(lhs, rhs);
+}
+
+//===----------------------------------------------------------------------===//
+// Tree reduction along the innermost axis.
+//===----------------------------------------------------------------------===//
+
+// Number of independent partial accumulators used by the tree-reduction
+// schedule below.
+static constexpr int64_t REDUCTION_NUM_PARTIALS = 8;
+
+// Return true when the reduction is taken over exactly the innermost axis and
+// that axis has a literal extent large enough to fill every partial
+// accumulator at least twice. Such reductions get a schedule that breaks the
+// serial dependence on a single accumulator.
+static bool isInnermostTreeReduction(
+    ArrayRef<int64_t> inShape, const std::vector<int64_t> &axes) {
+  int64_t inRank = inShape.size();
+  if (axes.size() != 1 || axes[0] != inRank - 1)
+    return false;
+  return inShape[inRank - 1] >= 2 * REDUCTION_NUM_PARTIALS;
+}
+
+// Emit a reduction over the innermost axis using REDUCTION_NUM_PARTIALS
+// independent partial accumulators: the reduced axis is walked in blocks,
+// each block lane updating its own accumulator, so the loop body carries no
+// dependence between lanes and is amenable to vectorization. At the end the
+// partial accumulators are combined pairwise until lane 0 holds the final
+// value. Replaces the init and reduction loops of the default lowering; the
+// optional mean loop still runs on the result afterwards. When a fused
+// epilogue is given, it is applied to the final value right before the
+// write-back. The partial accumulators are kept in accumType, which the
+// accum annotation pass may have widened (or narrowed) away from the
+// element type; the final value is cast back before the write-back.
+template <typename ONNXReductionOp>
+static void emitInnermostTreeReduction(ConversionPatternRewriter &rewriter,
+    Location loc, Operation *op, Value input, Value alloc, Type accumType,
+    const std::map<int64_t, int64_t> &outInDimMap,
+    Operation *epilogueOp = nullptr, Value epilogueScalar = nullptr,
+    bool epilogueReduceIsLhs = true) {
+  MultiDialectBuilder<KrnlBuilder, MathBuilder, MemRefBuilder> create(
+      rewriter, loc);
+  MemRefType memRefInType = input.getType().cast<MemRefType>();
+  MemRefType memRefOutType = alloc.getType().cast<MemRefType>();
+  Type elementType = memRefOutType.getElementType();
+  int64_t inRank = memRefInType.getRank();
+  int64_t outRank = memRefOutType.getRank();
+  constexpr int64_t numPartials = REDUCTION_NUM_PARTIALS;
+  int64_t reducedSize = memRefInType.getShape()[inRank - 1];
+  int64_t numBlocks = reducedSize / numPartials;
+  int64_t remainderStart = numBlocks * numPartials;
+
+  Value identity =
+      getIdentityValue<ONNXReductionOp>(rewriter, loc, accumType);
+  Value zeroIndex = create.math.constantIndex(0);
+  Value blockSizeVal = create.math.constantIndex(numPartials);
+  // One buffer of partial accumulators, reused across output elements.
+  Value partials =
+      create.mem.alignedAlloca(MemRefType::get({numPartials}, accumType));
+
+  // Loop over the non-reduced input dimensions, one output element each.
+  ValueRange outerDef = create.krnl.defineLoops(inRank - 1);
+  SmallVector<Value, 4> outerLbs(inRank - 1, zeroIndex);
+  SmallVector<Value, 4> outerUbs;
+  for (int64_t i = 0; i < inRank - 1; ++i)
+    outerUbs.emplace_back(create.mem.dim(input, i));
+  create.krnl.iterate(outerDef, outerDef, outerLbs, outerUbs,
+      [&](KrnlBuilder &createKrnl, ValueRange outerIVs) {
+        // Reset the partial accumulators to the identity.
+        for (int64_t u = 0; u < numPartials; ++u)
+          createKrnl.store(identity, partials, {create.math.constantIndex(u)});
+        // Walk the reduced axis in blocks of independent lanes.
+        ValueRange blockDef = createKrnl.defineLoops(1);
+        createKrnl.iterate(blockDef, blockDef, {zeroIndex},
+            {create.math.constantIndex(numBlocks)},
+            [&](KrnlBuilder &createKrnl, ValueRange blockIV) {
+              Value base = create.math.mul(blockIV[0], blockSizeVal);
+              for (int64_t u = 0; u < numPartials; ++u) {
+                Value lane = create.math.constantIndex(u);
+                Value idx = create.math.add(base, lane);
+                SmallVector<Value, 4> inIVs(outerIVs.begin(), outerIVs.end());
+                inIVs.emplace_back(idx);
+                Value next =
+                    create.math.cast(accumType, createKrnl.load(input, inIVs));
+                Value acc = createKrnl.load(partials, {lane});
+                acc = emitScalarOpFor<ONNXReductionOp>(
+                    rewriter, loc, op, accumType, {acc, next});
+                createKrnl.store(acc, partials, {lane});
+              }
+            });
+        // Fold any remainder iterations into the first lane.
+        for (int64_t i = remainderStart; i < reducedSize; ++i) {
+          SmallVector<Value, 4> inIVs(outerIVs.begin(), outerIVs.end());
+          inIVs.emplace_back(create.math.constantIndex(i));
+          Value next =
+              create.math.cast(accumType, createKrnl.load(input, inIVs));
+          Value acc = createKrnl.load(partials, {zeroIndex});
+          acc = emitScalarOpFor<ONNXReductionOp>(
+              rewriter, loc, op, accumType, {acc, next});
+          createKrnl.store(acc, partials, {zeroIndex});
+        }
+        // Combine the partial accumulators pairwise, halving the number of
+        // live lanes until lane 0 holds the final value.
+        for (int64_t stride = numPartials / 2; stride >= 1; stride /= 2)
+          for (int64_t u = 0; u < stride; ++u) {
+            Value lane = create.math.constantIndex(u);
+            Value other = create.math.constantIndex(u + stride);
+            Value lhs = createKrnl.load(partials, {lane});
+            Value rhs = createKrnl.load(partials, {other});
+            Value combined = emitScalarOpFor<ONNXReductionOp>(
+                rewriter, loc, op, accumType, {lhs, rhs});
+            createKrnl.store(combined, partials, {lane});
+          }
+        Value result = create.math.cast(
+            elementType, createKrnl.load(partials, {zeroIndex}));
+        if (epilogueOp)
+          result = emitEpilogueScalarOp(rewriter, loc, epilogueOp, result,
+              epilogueScalar, epilogueReduceIsLhs);
+        // The reduced axis is innermost, so the output indices come straight
+        // from the outer induction variables.
+        SmallVector<Value, 4> outIVs;
+        for (int64_t i = 0; i < outRank; ++i) {
+          auto mapEntry = outInDimMap.find(i);
+          if (mapEntry != outInDimMap.end())
+            outIVs.emplace_back(outerIVs[mapEntry->second]);
+          else
+            outIVs.emplace_back(zeroIndex);
+        }
+        createKrnl.store(result, alloc, outIVs);
+      });
+}
+
 template <typename ONNXReductionOp>
 struct ONNXReductionOpLowering : public ConversionPattern {
   bool computeMean = false;
@@ -219,114 +430,167 @@ struct ONNXReductionOpLowering : public ConversionPattern {
       }
     }
 
-    // There are two required and one optional Krnl loops:
-    // - One to initialize the result memref,
-    // - One to do reduction, and
-    // - One to compute mean (optional).
-
-    // 1. Define loops to initialize the result.
-    std::vector<Value> originalLoopsInit;
-    defineLoops(rewriter, loc, originalLoopsInit, outRank);
-
-    // Iteration information
-    // TODO use new KrnlDialectBuilder.
-    krnl::KrnlIterateOperandPack packInit(rewriter, originalLoopsInit);
-    for (decltype(outRank) i = 0; i < outRank; ++i)
-      addDimensionToPack(rewriter, loc, packInit, alloc, i);
-
-    KrnlIterateOp iterateOpInit = create.krnl.iterate(packInit);
-    Block &iterationBlockInit = iterateOpInit.bodyRegion().front();
-
-    // Perform the insertions into the body of the initialization loop.
-
-    // Insert instructions inside the KernelIterateOp body.
-    rewriter.setInsertionPointToStart(&iterationBlockInit);
-
-    // Handle the operation:
-    SmallVector<Value, 4> loopIVs;
-    for (auto arg : iterationBlockInit.getArguments())
-      loopIVs.push_back(arg);
-
-    Value identity =
-        getIdentityValue<ONNXReductionOp>(rewriter, loc, elementOutType);
-    create.krnl.store(identity, alloc, loopIVs);
-
-    // 2. Define an Krnl loop to do reduction.
-    rewriter.setInsertionPointAfter(iterateOpInit);
-    auto ipMainRegion = rewriter.saveInsertionPoint();
-    std::vector<Value> originalLoops;
-    defineLoops(rewriter, loc, originalLoops, inRank);
-    // Iteration information
-    // TODO use new KrnlDialectBuilder.
-    krnl::KrnlIterateOperandPack pack(rewriter, originalLoops);
-    for (decltype(inRank) i = 0; i < inRank; ++i)
-      addDimensionToPack(rewriter, loc, pack, input, i);
-
-    KrnlIterateOp iterateOp = create.krnl.iterate(pack);
-    Block &iterationBlock = iterateOp.bodyRegion().front();
-
-    // Perform the insertions into the body of the reduction loop.
-    // Insert instructions inside the KernelIterateOp body.
-    rewriter.setInsertionPointToStart(&iterationBlock);
-
-    // Handle the operation:
-    SmallVector<Value, 4> inLoopIVs, outLoopIVs;
-    auto args = iterationBlock.getArguments();
-    for (unsigned int i = 0; i < args.size(); ++i) {
-      inLoopIVs.push_back(args[i]);
-    }
-    Value zeroIndex = nullptr;
-    for (decltype(inRank) i = 0; i < outRank; ++i) {
-      if (outInDimMap.find(i) != outInDimMap.end()) {
-        outLoopIVs.push_back(inLoopIVs[outInDimMap[i]]);
-      } else {
-        if (zeroIndex) {
-          outLoopIVs.push_back(zeroIndex);
+    // A trailing elementwise operation with a matching shape is applied as
+    // part of the reduction write-back, see getEpilogueOpToFuse.
+    Operation *epilogueOp = getEpilogueOpToFuse(op);
+    bool epilogueReduceIsLhs = true;
+    Value epilogueScalar = nullptr;
+    if (epilogueOp)
+      epilogueScalar = getEpilogueScalarConstant(rewriter, loc, epilogueOp,
+          op->getResult(0), elementOutType, epilogueReduceIsLhs);
+    bool epilogueDone = false;
+
+    // Accumulation type requested by the accum annotation pass, if any; the
+    // reduction then accumulates in that type and casts on load and
+    // write-back.
+    Type accumType = elementOutType;
+    if (Type requested = getRequestedAccumType(op, elementOutType))
+      accumType = requested;
+    Value redBuff = alloc;
+    bool wideAccum = false;
+
+    // When only the innermost axis is reduced and its extent is a large
+    // literal, use the tree-reduction schedule; otherwise fall back to the
+    // accumulate-in-place loops below.
+    if (isInnermostTreeReduction(memRefInType.getShape(), axes)) {
+      // With a mean to compute, the epilogue must wait for the loop below.
+      emitInnermostTreeReduction<ONNXReductionOp>(rewriter, loc, op, input,
+          alloc, accumType, outInDimMap, computeMean ? nullptr : epilogueOp,
+          epilogueScalar, epilogueReduceIsLhs);
+      epilogueDone = epilogueOp && !computeMean;
+    } else {
+      // The in-place schedule accumulates directly into the output buffer;
+      // with an annotated accumulation type, a separate buffer in that type
+      // takes its place and the loop after this one casts it back. Such a
+      // buffer is only emitted for static output shapes.
+      if (accumType != elementOutType &&
+          hasAllConstantDimensions(memRefOutType)) {
+        SmallVector<IndexExpr, 1> empty;
+        redBuff = insertAllocAndDeallocSimple(rewriter, op,
+            MemRefType::get(memRefOutShape, accumType), loc, empty,
+            /*insertDealloc=*/true);
+        wideAccum = true;
+      } else
+        accumType = elementOutType;
+      // There are two required and one optional Krnl loops:
+      // - One to initialize the result memref,
+      // - One to do reduction, and
+      // - One to compute mean (optional).
+
+      // 1. Define loops to initialize the result.
+      std::vector<Value> originalLoopsInit;
+      defineLoops(rewriter, loc, originalLoopsInit, outRank);
+
+      // Iteration information
+      // TODO use new KrnlDialectBuilder.
+      krnl::KrnlIterateOperandPack packInit(rewriter, originalLoopsInit);
+      for (decltype(outRank) i = 0; i < outRank; ++i)
+        addDimensionToPack(rewriter, loc, packInit, alloc, i);
+
+      KrnlIterateOp iterateOpInit = create.krnl.iterate(packInit);
+      Block &iterationBlockInit = iterateOpInit.bodyRegion().front();
+
+      // Perform the insertions into the body of the initialization loop.
+
+      // Insert instructions inside the KernelIterateOp body.
+      rewriter.setInsertionPointToStart(&iterationBlockInit);
+
+      // Handle the operation:
+      SmallVector<Value, 4> loopIVs;
+      for (auto arg : iterationBlockInit.getArguments())
+        loopIVs.push_back(arg);
+
+      Value identity =
+          getIdentityValue<ONNXReductionOp>(rewriter, loc, accumType);
+      create.krnl.store(identity, redBuff, loopIVs);
+
+      // 2. Define an Krnl loop to do reduction.
+      rewriter.setInsertionPointAfter(iterateOpInit);
+      auto ipMainRegion = rewriter.saveInsertionPoint();
+      std::vector<Value> originalLoops;
+      defineLoops(rewriter, loc, originalLoops, inRank);
+      // Iteration information
+      // TODO use new KrnlDialectBuilder.
+      krnl::KrnlIterateOperandPack pack(rewriter, originalLoops);
+      for (decltype(inRank) i = 0; i < inRank; ++i)
+        addDimensionToPack(rewriter, loc, pack, input, i);
+
+      KrnlIterateOp iterateOp = create.krnl.iterate(pack);
+      Block &iterationBlock = iterateOp.bodyRegion().front();
+
+      // Perform the insertions into the body of the reduction loop.
+      // Insert instructions inside the KernelIterateOp body.
+      rewriter.setInsertionPointToStart(&iterationBlock);
+
+      // Handle the operation:
+      SmallVector<Value, 4> inLoopIVs, outLoopIVs;
+      auto args = iterationBlock.getArguments();
+      for (unsigned int i = 0; i < args.size(); ++i) {
+        inLoopIVs.push_back(args[i]);
+      }
+      Value zeroIndex = nullptr;
+      for (decltype(inRank) i = 0; i < outRank; ++i) {
+        if (outInDimMap.find(i) != outInDimMap.end()) {
+          outLoopIVs.push_back(inLoopIVs[outInDimMap[i]]);
         } else {
-          zeroIndex = create.math.constantIndex(0);
-          outLoopIVs.push_back(zeroIndex);
+          if (zeroIndex) {
+            outLoopIVs.push_back(zeroIndex);
+          } else {
+            zeroIndex = create.math.constantIndex(0);
+            outLoopIVs.push_back(zeroIndex);
+          }
         }
       }
-    }
 
-    Value next = create.krnl.load(input, inLoopIVs);
-    Value accumulated = create.krnl.load(alloc, outLoopIVs);
-    accumulated = emitScalarOpFor<ONNXReductionOp>(
-        rewriter, loc, op, memRefOutType.getElementType(), {accumulated, next});
-    create.krnl.store(accumulated, alloc, outLoopIVs);
+      Value next =
+          create.math.cast(accumType, create.krnl.load(input, inLoopIVs));
+      Value accumulated = create.krnl.load(redBuff, outLoopIVs);
+      accumulated = emitScalarOpFor<ONNXReductionOp>(
+          rewriter, loc, op, accumType, {accumulated, next});
+      create.krnl.store(accumulated, redBuff, outLoopIVs);
 
-    // 3. Define an Krnl loop to compute mean (optional).
-    rewriter.restoreInsertionPoint(ipMainRegion);
+      // 3. Define an Krnl loop to compute mean (optional).
+      rewriter.restoreInsertionPoint(ipMainRegion);
+    }
     MemRefBoundsIndexCapture inputBounds(input);
     MemRefBoundsIndexCapture allocBounds(alloc);
-    if (computeMean) {
+    bool applyEpilogueInLoop = epilogueOp && !epilogueDone;
+    if (computeMean || applyEpilogueInLoop || wideAccum) {
       Type elementType = memRefOutType.getElementType();
-      // Compute the divisor that is the number of elements participated in
-      // reduction, i.e., 'divisor = size of input / size of output'.
+      // The mean division runs in the accumulation type; the cast back to
+      // the element type follows it.
+      Type divType = wideAccum ? accumType : elementType;
       IndexExprScope scope(&rewriter, loc);
-      IndexExpr inputSizeExpr = LiteralIndexExpr(1);
-      for (unsigned i = 0; i < inRank; i++) {
-        DimIndexExpr dimExpr(inputBounds.getDim(i));
-        inputSizeExpr = inputSizeExpr * dimExpr;
-      }
-      IndexExpr outputSizeExpr = LiteralIndexExpr(1);
-      for (unsigned i = 0; i < outRank; i++) {
-        DimIndexExpr dimExpr(allocBounds.getDim(i));
-        outputSizeExpr = outputSizeExpr * dimExpr;
+      Value divisor = nullptr;
+      if (computeMean) {
+        // Compute the divisor that is the number of elements participated in
+        // reduction, i.e., 'divisor = size of input / size of output'.
+        IndexExpr inputSizeExpr = LiteralIndexExpr(1);
+        for (unsigned i = 0; i < inRank; i++) {
+          DimIndexExpr dimExpr(inputBounds.getDim(i));
+          inputSizeExpr = inputSizeExpr * dimExpr;
+        }
+        IndexExpr outputSizeExpr = LiteralIndexExpr(1);
+        for (unsigned i = 0; i < outRank; i++) {
+          DimIndexExpr dimExpr(allocBounds.getDim(i));
+          outputSizeExpr = outputSizeExpr * dimExpr;
+        }
+        IndexExpr divisorExpr = inputSizeExpr.floorDiv(outputSizeExpr);
+        divisor = divisorExpr.getValue();
+        if (divType.isa<FloatType>()) {
+          divisor = rewriter.create<arith::IndexCastOp>(
+              loc, rewriter.getIntegerType(64), divisor);
+          divisor = rewriter.create<arith::UIToFPOp>(loc, divType, divisor);
+        } else if (divType.isa<IntegerType>()) {
+          divisor =
+              rewriter.create<arith::IndexCastOp>(loc, divType, divisor);
+        } else
+          llvm_unreachable("unsupported element type");
       }
-      IndexExpr divisorExpr = inputSizeExpr.floorDiv(outputSizeExpr);
-      Value divisor = divisorExpr.getValue();
-      if (elementType.isa<FloatType>()) {
-        divisor = rewriter.create<arith::IndexCastOp>(
-            loc, rewriter.getIntegerType(64), divisor);
-        divisor = rewriter.create<arith::UIToFPOp>(loc, elementType, divisor);
-      } else if (elementType.isa<IntegerType>()) {
-        divisor =
-            rewriter.create<arith::IndexCastOp>(loc, elementType, divisor);
-      } else
-        llvm_unreachable("unsupported element type");
 
-      // Compute mean
+      // Compute mean and/or apply the fused epilogue, in place; with an
+      // annotated accumulation type, also cast the accumulation buffer back
+      // into the output.
       KrnlBuilder createKrnl(rewriter, loc);
       ValueRange loopDef = createKrnl.defineLoops(outRank);
       SmallVector<IndexExpr, 4> lbs(outRank, LiteralIndexExpr(0));
@@ -335,13 +599,23 @@ struct ONNXReductionOpLowering : public ConversionPattern {
       allocBounds.getDimList(ubs);
       createKrnl.iterateIE(loopDef, loopDef, lbs, ubs,
           [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
-            Value loadData = createKrnl.load(alloc, loopInd);
-            Value meanVal = create.math.div(loadData, divisor);
-            createKrnl.store(meanVal, alloc, loopInd);
+            Value val = createKrnl.load(redBuff, loopInd);
+            if (computeMean)
+              val = create.math.div(val, divisor);
+            if (wideAccum)
+              val = create.math.cast(elementType, val);
+            if (applyEpilogueInLoop)
+              val = emitEpilogueScalarOp(rewriter, loc, epilogueOp, val,
+                  epilogueScalar, epilogueReduceIsLhs);
+            createKrnl.store(val, alloc, loopInd);
           });
     }
 
-    rewriter.replaceOp(op, alloc);
+    if (epilogueOp) {
+      rewriter.replaceOp(epilogueOp, alloc);
+      rewriter.eraseOp(op);
+    } else
+      rewriter.replaceOp(op, alloc);
     return success();
   }
 };
@@ -412,6 +686,7 @@ struct ONNXReduceSumOpLowering : public ConversionPattern {
     Value falseVal = nullptr;
     Value trueVal = nullptr;
     Value valueOne = nullptr;
+    std::vector<int64_t> axes;
     std::map<int64_t, int64_t> outInDimMap;
 
     MultiDialectBuilder<KrnlBuilder, MathBuilder, MemRefBuilder> create(
@@ -509,7 +784,6 @@ struct ONNXReduceSumOpLowering : public ConversionPattern {
           definedAxes.push_back(element.getInt());
       }
 
-      std::vector<int64_t> axes;
       if (definedAxes.size()) {
         for (auto axis : definedAxes) {
           if (axis < -inRank || axis > inRank - 1) {
@@ -559,116 +833,170 @@ struct ONNXReduceSumOpLowering : public ConversionPattern {
       }
     }
 
-    // There are two required and one optional Krnl loops:
-    // - One to initialize the result memref,
-    // - One to do reduction, and
-    // - One to compute mean (optional).
-
-    // 1. Define loops to initialize the result.
-    std::vector<Value> originalLoopsInit;
-    defineLoops(rewriter, loc, originalLoopsInit, outRank);
+    // A trailing elementwise operation with a matching shape is applied as
+    // part of the reduction write-back, see getEpilogueOpToFuse.
+    Operation *epilogueOp = getEpilogueOpToFuse(op);
+    bool epilogueReduceIsLhs = true;
+    Value epilogueScalar = nullptr;
+    if (epilogueOp)
+      epilogueScalar = getEpilogueScalarConstant(rewriter, loc, epilogueOp,
+          op->getResult(0), elementOutType, epilogueReduceIsLhs);
+    bool epilogueDone = false;
+
+    // Accumulation type requested by the accum annotation pass, if any; the
+    // reduction then accumulates in that type and casts on load and
+    // write-back.
+    Type accumType = elementOutType;
+    if (Type requested = getRequestedAccumType(op, elementOutType))
+      accumType = requested;
+    Value redBuff = alloc;
+    bool wideAccum = false;
+
+    // When the axes are static, only the innermost axis is reduced, and its
+    // extent is a large literal, use the tree-reduction schedule; otherwise
+    // fall back to the accumulate-in-place loops below.
+    if (!dynamicAxes &&
+        isInnermostTreeReduction(memRefInType.getShape(), axes)) {
+      // With a mean to compute, the epilogue must wait for the loop below.
+      emitInnermostTreeReduction<ONNXReduceSumOp>(rewriter, loc, op, input,
+          alloc, accumType, outInDimMap, computeMean ? nullptr : epilogueOp,
+          epilogueScalar, epilogueReduceIsLhs);
+      epilogueDone = epilogueOp && !computeMean;
+    } else {
+      // The in-place schedule accumulates directly into the output buffer;
+      // with an annotated accumulation type, a separate buffer in that type
+      // takes its place and the loop after this one casts it back. Such a
+      // buffer is only emitted for static output shapes.
+      if (accumType != elementOutType &&
+          hasAllConstantDimensions(memRefOutType)) {
+        SmallVector<IndexExpr, 1> empty;
+        redBuff = insertAllocAndDeallocSimple(rewriter, op,
+            MemRefType::get(memRefOutShape, accumType), loc, empty,
+            /*insertDealloc=*/true);
+        wideAccum = true;
+      } else
+        accumType = elementOutType;
+      // There are two required and one optional Krnl loops:
+      // - One to initialize the result memref,
+      // - One to do reduction, and
+      // - One to compute mean (optional).
+
+      // 1. Define loops to initialize the result.
+      std::vector<Value> originalLoopsInit;
+      defineLoops(rewriter, loc, originalLoopsInit, outRank);
+
+      // Iteration information
+      // TODO use new KrnlDialectBuilder.
+      krnl::KrnlIterateOperandPack packInit(rewriter, originalLoopsInit);
+      for (decltype(outRank) i = 0; i < outRank; ++i)
+        addDimensionToPack(rewriter, loc, packInit, alloc, i);
+
+      KrnlIterateOp iterateOpInit = create.krnl.iterate(packInit);
+      Block &iterationBlockInit = iterateOpInit.bodyRegion().front();
+
+      // Perform the insertions into the body of the initialization loop.
+
+      // Insert instructions inside the KernelIterateOp body.
+      rewriter.setInsertionPointToStart(&iterationBlockInit);
+
+      // Handle the operation:
+      SmallVector<Value, 4> loopIVs;
+      for (auto arg : iterationBlockInit.getArguments()) {
+        loopIVs.push_back(arg);
+      }
 
-    // Iteration information
-    // TODO use new KrnlDialectBuilder.
-    krnl::KrnlIterateOperandPack packInit(rewriter, originalLoopsInit);
-    for (decltype(outRank) i = 0; i < outRank; ++i)
-      addDimensionToPack(rewriter, loc, packInit, alloc, i);
+      Value identity =
+          getIdentityValue<ONNXReduceSumOp>(rewriter, loc, accumType);
+      create.krnl.store(identity, redBuff, loopIVs);
+
+      // 2. Define an Krnl loop to do reduction.
+      rewriter.setInsertionPointAfter(iterateOpInit);
+      auto ipMainRegion = rewriter.saveInsertionPoint();
+      std::vector<Value> originalLoops;
+      defineLoops(rewriter, loc, originalLoops, inRank);
+      // Iteration information
+      // TODO use new KrnlDialectBuilder.
+      krnl::KrnlIterateOperandPack pack(rewriter, originalLoops);
+      for (decltype(inRank) i = 0; i < inRank; ++i)
+        addDimensionToPack(rewriter, loc, pack, input, i);
 
-    KrnlIterateOp iterateOpInit = create.krnl.iterate(packInit);
-    Block &iterationBlockInit = iterateOpInit.bodyRegion().front();
+      KrnlIterateOp iterateOp = create.krnl.iterate(pack);
+      Block &iterationBlock = iterateOp.bodyRegion().front();
 
-    // Perform the insertions into the body of the initialization loop.
+      // Perform the insertions into the body of the reduction loop.
+      // Insert instructions inside the KernelIterateOp body.
+      rewriter.setInsertionPointToStart(&iterationBlock);
 
-    // Insert instructions inside the KernelIterateOp body.
-    rewriter.setInsertionPointToStart(&iterationBlockInit);
+      // Handle the operation:
+      SmallVector<Value, 4> inLoopIVs, outLoopIVs;
+      auto args = iterationBlock.getArguments();
+      for (unsigned int i = 0; i < args.size(); ++i) {
+        inLoopIVs.push_back(args[i]);
+      }
+      // Value zeroIndex = nullptr;
+      Value zeroIndex = create.math.constantIndex(0);
+      for (decltype(inRank) i = 0; i < outRank; ++i) {
+        if (dynamicAxes) {
+          // For the reduced dim, the output index is always 0
+          Value indexVal = create.math.constantIndex(i);
+          Value mask = create.krnl.load(maskVal, indexVal);
+          Value cond = create.math.eq(mask, trueVal);
+          Value dim = create.math.select(cond, zeroIndex, inLoopIVs[i]);
+          outLoopIVs.push_back(dim);
+        } else if (outInDimMap.find(i) != outInDimMap.end())
+          outLoopIVs.push_back(inLoopIVs[outInDimMap[i]]);
+        else
+          outLoopIVs.push_back(zeroIndex);
+      }
 
-    // Handle the operation:
-    SmallVector<Value, 4> loopIVs;
-    for (auto arg : iterationBlockInit.getArguments()) {
-      loopIVs.push_back(arg);
-    }
+      Value next =
+          create.math.cast(accumType, create.krnl.load(input, inLoopIVs));
+      Value accumulated = create.krnl.load(redBuff, outLoopIVs);
+      accumulated = emitScalarOpFor<ONNXReduceSumOp>(
+          rewriter, loc, op, accumType, {accumulated, next});
+      create.krnl.store(accumulated, redBuff, outLoopIVs);
 
-    Value identity =
-        getIdentityValue<ONNXReduceSumOp>(rewriter, loc, elementOutType);
-    create.krnl.store(identity, alloc, loopIVs);
-
-    // 2. Define an Krnl loop to do reduction.
-    rewriter.setInsertionPointAfter(iterateOpInit);
-    auto ipMainRegion = rewriter.saveInsertionPoint();
-    std::vector<Value> originalLoops;
-    defineLoops(rewriter, loc, originalLoops, inRank);
-    // Iteration information
-    // TODO use new KrnlDialectBuilder.
-    krnl::KrnlIterateOperandPack pack(rewriter, originalLoops);
-    for (decltype(inRank) i = 0; i < inRank; ++i)
-      addDimensionToPack(rewriter, loc, pack, input, i);
-
-    KrnlIterateOp iterateOp = create.krnl.iterate(pack);
-    Block &iterationBlock = iterateOp.bodyRegion().front();
-
-    // Perform the insertions into the body of the reduction loop.
-    // Insert instructions inside the KernelIterateOp body.
-    rewriter.setInsertionPointToStart(&iterationBlock);
-
-    // Handle the operation:
-    SmallVector<Value, 4> inLoopIVs, outLoopIVs;
-    auto args = iterationBlock.getArguments();
-    for (unsigned int i = 0; i < args.size(); ++i) {
-      inLoopIVs.push_back(args[i]);
-    }
-    // Value zeroIndex = nullptr;
-    Value zeroIndex = create.math.constantIndex(0);
-    for (decltype(inRank) i = 0; i < outRank; ++i) {
-      if (dynamicAxes) {
-        // For the reduced dim, the output index is always 0
-        Value indexVal = create.math.constantIndex(i);
-        Value mask = create.krnl.load(maskVal, indexVal);
-        Value cond = create.math.eq(mask, trueVal);
-        Value dim = create.math.select(cond, zeroIndex, inLoopIVs[i]);
-        outLoopIVs.push_back(dim);
-      } else if (outInDimMap.find(i) != outInDimMap.end())
-        outLoopIVs.push_back(inLoopIVs[outInDimMap[i]]);
-      else
-        outLoopIVs.push_back(zeroIndex);
+      // 3. Define an Krnl loop to compute mean (optional).
+      rewriter.restoreInsertionPoint(ipMainRegion);
     }
-
-    Value next = create.krnl.load(input, inLoopIVs);
-    Value accumulated = create.krnl.load(alloc, outLoopIVs);
-    accumulated = emitScalarOpFor<ONNXReduceSumOp>(
-        rewriter, loc, op, memRefOutType.getElementType(), {accumulated, next});
-    create.krnl.store(accumulated, alloc, outLoopIVs);
-
-    // 3. Define an Krnl loop to compute mean (optional).
-    rewriter.restoreInsertionPoint(ipMainRegion);
     MemRefBoundsIndexCapture inputBounds(input);
     MemRefBoundsIndexCapture allocBounds(alloc);
-    if (computeMean) {
+    bool applyEpilogueInLoop = epilogueOp && !epilogueDone;
+    if (computeMean || applyEpilogueInLoop || wideAccum) {
       Type elementType = memRefOutType.getElementType();
-      // Compute the divisor that is the number of elements participated in
-      // reduction, i.e., 'divisor = size of input / size of output'.
+      // The mean division runs in the accumulation type; the cast back to
+      // the element type follows it.
+      Type divType = wideAccum ? accumType : elementType;
       IndexExprScope scope(&rewriter, loc);
-      IndexExpr inputSizeExpr = LiteralIndexExpr(1);
-      for (unsigned i = 0; i < inRank; i++) {
-        DimIndexExpr dimExpr(inputBounds.getDim(i));
-        inputSizeExpr = inputSizeExpr * dimExpr;
-      }
-      IndexExpr outputSizeExpr = LiteralIndexExpr(1);
-      for (unsigned i = 0; i < outRank; i++) {
-        DimIndexExpr dimExpr(allocBounds.getDim(i));
-        outputSizeExpr = outputSizeExpr * dimExpr;
+      Value divisor = nullptr;
+      if (computeMean) {
+        // Compute the divisor that is the number of elements participated in
+        // reduction, i.e., 'divisor = size of input / size of output'.
+        IndexExpr inputSizeExpr = LiteralIndexExpr(1);
+        for (unsigned i = 0; i < inRank; i++) {
+          DimIndexExpr dimExpr(inputBounds.getDim(i));
+          inputSizeExpr = inputSizeExpr * dimExpr;
+        }
+        IndexExpr outputSizeExpr = LiteralIndexExpr(1);
+        for (unsigned i = 0; i < outRank; i++) {
+          DimIndexExpr dimExpr(allocBounds.getDim(i));
+          outputSizeExpr = outputSizeExpr * dimExpr;
+        }
+        IndexExpr divisorExpr = inputSizeExpr.floorDiv(outputSizeExpr);
+        divisor = divisorExpr.getValue();
+        if (divType.isa<FloatType>()) {
+          divisor = rewriter.create<arith::IndexCastOp>(
+              loc, rewriter.getIntegerType(64), divisor);
+          divisor = rewriter.create<arith::UIToFPOp>(loc, divType, divisor);
+        } else if (divType.isa<IntegerType>())
+          divisor = create.math.cast(divType, divisor);
+        else
+          llvm_unreachable("unsupported element type");
       }
-      IndexExpr divisorExpr = inputSizeExpr.floorDiv(outputSizeExpr);
-      Value divisor = divisorExpr.getValue();
-      if (elementType.isa<FloatType>()) {
-        divisor = rewriter.create<arith::IndexCastOp>(
-            loc, rewriter.getIntegerType(64), divisor);
-        divisor = rewriter.create<arith::UIToFPOp>(loc, elementType, divisor);
-      } else if (elementType.isa<IntegerType>())
-        divisor = create.math.cast(elementType, divisor);
-      else
-        llvm_unreachable("unsupported element type");
-
-      // Compute mean
+
+      // Compute mean and/or apply the fused epilogue, in place; with an
+      // annotated accumulation type, also cast the accumulation buffer back
+      // into the output.
       KrnlBuilder createKrnl(rewriter, loc);
       ValueRange loopDef = createKrnl.defineLoops(outRank);
       SmallVector<IndexExpr, 4> lbs(outRank, LiteralIndexExpr(0));
@@ -677,13 +1005,23 @@ struct ONNXReduceSumOpLowering : public ConversionPattern {
       allocBounds.getDimList(ubs);
       createKrnl.iterateIE(loopDef, loopDef, lbs, ubs,
           [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
-            Value loadData = createKrnl.load(alloc, loopInd);
-            Value meanVal = create.math.div(loadData, divisor);
-            createKrnl.store(meanVal, alloc, loopInd);
+            Value val = createKrnl.load(redBuff, loopInd);
+            if (computeMean)
+              val = create.math.div(val, divisor);
+            if (wideAccum)
+              val = create.math.cast(elementType, val);
+            if (applyEpilogueInLoop)
+              val = emitEpilogueScalarOp(rewriter, loc, epilogueOp, val,
+                  epilogueScalar, epilogueReduceIsLhs);
+            createKrnl.store(val, alloc, loopInd);
           });
     }
 
-    rewriter.replaceOp(op, alloc);
+    if (epilogueOp) {
+      rewriter.replaceOp(epilogueOp, alloc);
+      rewriter.eraseOp(op);
+    } else
+      rewriter.replaceOp(op, alloc);
     return success();
   }
 };
@@ -26,71 +26,48 @@ static void emitInnerLoops(KrnlBuilder &createKrnl, int64_t numberOfLoops,
     int64_t axis, bool coerced = true) {
   int64_t rank = alloc.getType().cast<MemRefType>().getRank();
 
-  // Compute the maximum value along axis.
-  ValueRange maxLoops = createKrnl.defineLoops(numberOfLoops);
-  createKrnl.iterateIE(maxLoops, maxLoops, Lbs, Ubs,
-      [&](KrnlBuilder &createKrnl, ValueRange maxIndices) {
+  // Get the induction variables for an access along axis.
+  auto getLoopIVs = [&](ValueRange innerIndices) {
+    SmallVector<Value, 4> loopIVs;
+    if (coerced) {
+      for (auto iv : outerIndices)
+        loopIVs.push_back(iv);
+      for (auto iv : innerIndices)
+        loopIVs.push_back(iv);
+    } else {
+      for (int64_t i = 0; i < axis; i++)
+        loopIVs.push_back(outerIndices[i]);
+      loopIVs.push_back(innerIndices[0]);
+      for (int64_t i = axis + 1; i < rank; i++)
+        loopIVs.push_back(outerIndices[i - 1]);
+    }
+    return loopIVs;
+  };
+
+  // Compute the maximum and the sum of exponentials along axis in a single
+  // pass over the input (online softmax). Whenever a larger maximum is found,
+  // the sum accumulated with the previous maximum is rescaled by
+  // exp(oldMax - newMax); for all other elements the rescale factor is one.
+  ValueRange reductionLoops = createKrnl.defineLoops(numberOfLoops);
+  createKrnl.iterateIE(reductionLoops, reductionLoops, Lbs, Ubs,
+      [&](KrnlBuilder &createKrnl, ValueRange reductionIndices) {
         MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
         IndexExprScope ieScope(createKrnl);
+        SmallVector<Value, 4> reductionLoopIVs = getLoopIVs(reductionIndices);
 
-        // Get induction variables.
-        SmallVector<Value, 4> maxLoopIVs;
-        if (coerced) {
-          for (auto iv : outerIndices)
-            maxLoopIVs.push_back(iv);
-          for (auto iv : maxIndices)
-            maxLoopIVs.push_back(iv);
-        } else {
-          for (int64_t i = 0; i < axis; i++)
-            maxLoopIVs.push_back(outerIndices[i]);
-          maxLoopIVs.push_back(maxIndices[0]);
-          for (int64_t i = axis + 1; i < rank; i++)
-            maxLoopIVs.push_back(outerIndices[i - 1]);
-        }
-
-        Value max = create.krnl.load(maxOp, {});
-        Value nextMax = create.krnl.load(input, maxLoopIVs);
-        auto maxCond = create.math.sgt(max, nextMax);
-        max = create.math.select(maxCond, max, nextMax);
-        create.krnl.store(max, maxOp, ArrayRef<Value>{});
-      });
-  // Load the maximum value.
-  Value max = createKrnl.load(maxOp, {});
-
-  // Compute the sum of all values along axis.
-  ValueRange sumLoops = createKrnl.defineLoops(numberOfLoops);
-  createKrnl.iterateIE(sumLoops, sumLoops, Lbs, Ubs,
-      [&](KrnlBuilder &createKrnl, ValueRange sumIndices) {
-        MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
-        IndexExprScope ieScope(createKrnl);
-
-        // Get induction variables.
-        SmallVector<Value, 4> sumLoopIVs;
-        if (coerced) {
-          for (auto iv : outerIndices)
-            sumLoopIVs.push_back(iv);
-          for (auto iv : sumIndices)
-            sumLoopIVs.push_back(iv);
-        } else {
-          for (int64_t i = 0; i < axis; i++)
-            sumLoopIVs.push_back(outerIndices[i]);
-          sumLoopIVs.push_back(sumIndices[0]);
-          for (int64_t i = axis + 1; i < rank; i++)
-            sumLoopIVs.push_back(outerIndices[i - 1]);
-        }
-
+        Value oldMax = create.krnl.load(maxOp, {});
+        Value next = create.krnl.load(input, reductionLoopIVs);
+        Value newMax = create.math.max(oldMax, next);
+        Value corr = create.math.exp(create.math.sub(oldMax, newMax));
+        Value exp = create.math.exp(create.math.sub(next, newMax));
         Value sum = create.krnl.load(sumOp, {});
-        Value next = create.krnl.load(input, sumLoopIVs);
-        Value sub = create.math.sub(next, max);
-        Value exp = create.math.exp(sub);
-        sum = create.math.add(sum, exp);
+        sum = create.math.add(create.math.mul(sum, corr), exp);
+        create.krnl.store(newMax, maxOp, ArrayRef<Value>{});
         create.krnl.store(sum, sumOp, ArrayRef<Value>{});
-        // Store intermediate values in the result to avoid
-        // recomputation.
-        create.krnl.store(exp, alloc, sumLoopIVs);
       });
 
-  // Load the sum value.
+  // Load the maximum and sum values.
+  Value max = createKrnl.load(maxOp, {});
   Value sum = createKrnl.load(sumOp, {});
 
   // Compute the softmax.
@@ -99,24 +76,11 @@ static void emitInnerLoops(KrnlBuilder &createKrnl, int64_t numberOfLoops,
       [&](KrnlBuilder &createKrnl, ValueRange softmaxIndices) {
         MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
         IndexExprScope ieScope(createKrnl);
+        SmallVector<Value, 4> softmaxLoopIVs = getLoopIVs(softmaxIndices);
 
-        // Get induction variables.
-        SmallVector<Value, 4> softmaxLoopIVs;
-        if (coerced) {
-          for (auto iv : outerIndices)
-            softmaxLoopIVs.push_back(iv);
-          for (auto iv : softmaxIndices)
-            softmaxLoopIVs.push_back(iv);
-        } else {
-          for (int64_t i = 0; i < axis; i++)
-            softmaxLoopIVs.push_back(outerIndices[i]);
-          softmaxLoopIVs.push_back(softmaxIndices[0]);
-          for (int64_t i = axis + 1; i < rank; i++)
-            softmaxLoopIVs.push_back(outerIndices[i - 1]);
-        }
-
-        Value expLoadedVal = create.krnl.load(alloc, softmaxLoopIVs);
-        Value result = create.math.div(expLoadedVal, sum);
+        Value next = create.krnl.load(input, softmaxLoopIVs);
+        Value exp = create.math.exp(create.math.sub(next, max));
+        Value result = create.math.div(exp, sum);
         create.krnl.store(result, alloc, softmaxLoopIVs);
       });
 }
@@ -68,9 +68,14 @@ struct ONNXTopKOpLowering : public ConversionPattern {
         MemRefType::get(resMemRefType.getShape(), i64Type), loc, resDims,
         insertDealloc);
 
-    // Compute argSort of X along axis.
-    Value argSort = emitArgSort(rewriter, loc, X, axis,
-        /*ascending=*/ascendingMode);
+    // Compute the top-k indices of X along axis. The runtime top-k performs a
+    // partial selection, avoiding a full sort of the axis when k is small;
+    // when it does not apply, fall back to a full argsort.
+    Value argSort = emitArgTopK(rewriter, loc, X, operandAdaptor.K(), resDims,
+        axis, /*ascending=*/ascendingMode);
+    if (!argSort)
+      argSort = emitArgSort(rewriter, loc, X, axis,
+          /*ascending=*/ascendingMode);
 
     // Produce the final result.
     SmallVector<IndexExpr> zeroDims(rank, LiteralIndexExpr(0));
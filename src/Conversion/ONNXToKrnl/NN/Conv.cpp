@@ -21,12 +21,13 @@ using namespace mlir;
 namespace onnx_mlir {
 
 struct ONNXConvOpLowering : public ConversionPattern {
-  ONNXConvOpLowering(
-      TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel)
+  ONNXConvOpLowering(TypeConverter &typeConverter, MLIRContext *ctx,
+      bool enableParallel, bool enableFastConv)
       : ConversionPattern(
             typeConverter, mlir::ONNXConvOp::getOperationName(), 1, ctx),
-        enableParallel(enableParallel) {}
+        enableParallel(enableParallel), enableFastConv(enableFastConv) {}
   bool enableParallel;
+  bool enableFastConv;
 
   void convUnoptimized(ConversionPatternRewriter &rewriter, ONNXConvOp &convOp,
       ONNXConvOpAdaptor &operandAdaptor, ONNXConvOpShapeHelper &shapeHelper,
@@ -210,6 +211,8 @@ struct ONNXConvOpLowering : public ConversionPattern {
             resAccessFunc.emplace_back(coInOutputSpacial);
             for (Value o : outputSpatialIndices)
               resAccessFunc.emplace_back(DimIndexExpr(o));
+            result = applyFusedActivation(
+                rewriter, loc, convOp.getOperation(), result);
             create.krnl.storeIE(result, alloc, resAccessFunc);
           }); // Output spacial loops.
     };
@@ -228,6 +231,475 @@ struct ONNXConvOpLowering : public ConversionPattern {
     }
   }
 
+  // The im2col+GEMM path is restricted to the shapes it can handle well:
+  // 2-D spatial convolutions over floats where every shape and pad is known
+  // at compile time. Everything else falls back to convUnoptimized.
+  static bool canUseIm2ColGemm(ONNXConvOpAdaptor &operandAdaptor,
+      ONNXConvOpShapeHelper &shapeHelper, MemRefType memRefType) {
+    if (memRefType.getRank() != 4 || !memRefType.hasStaticShape())
+      return false;
+    if (!memRefType.getElementType().isa<FloatType>())
+      return false;
+    auto inputType = operandAdaptor.X().getType().dyn_cast<MemRefType>();
+    auto filterType = operandAdaptor.W().getType().dyn_cast<MemRefType>();
+    if (!inputType || !inputType.hasStaticShape())
+      return false;
+    if (!filterType || !filterType.hasStaticShape())
+      return false;
+    // Begin pads must be known to generate the im2col access pattern.
+    for (int i = 0; i < 2; ++i)
+      if (!shapeHelper.pads[i].isLiteral())
+        return false;
+    return true;
+  }
+
+  // A depthwise convolution (group == channels in == channels out) reduces
+  // the im2col GEMM to single-row matrices and leaves the unoptimized path
+  // doing per-element group and dilation arithmetic; both are poor fits for
+  // MobileNet-class models. Those convolutions take the dedicated kernel
+  // below instead, under the same restrictions as the im2col path.
+  static bool canUseDepthwise(ONNXConvOp &convOp,
+      ONNXConvOpAdaptor &operandAdaptor, ONNXConvOpShapeHelper &shapeHelper,
+      MemRefType memRefType) {
+    if (!canUseIm2ColGemm(operandAdaptor, shapeHelper, memRefType))
+      return false;
+    int64_t G = convOp.group();
+    if (G <= 1)
+      return false;
+    auto filterShape =
+        operandAdaptor.W().getType().cast<MemRefType>().getShape();
+    // One input and one output channel per group.
+    return filterShape[1] == 1 && memRefType.getShape()[1] == G;
+  }
+
+  // Dedicated depthwise kernel. Each (channel, batch) pair is an
+  // independent 2-D single-channel convolution:
+  //
+  //   Y[n, c, ho, wo] =
+  //       sum_{kh, kw} X[n, c, ho*sh + kh*dh - ph, wo*sw + kw*dw - pw]
+  //                    * W[c, 0, kh, kw]  (+ bias).
+  //
+  // When padding is in play, the touched window of the input channel is
+  // first staged into a zero-padded scratch buffer, so the accumulation
+  // runs without bounds checks. The kernel offsets, strides and dilations
+  // are all compile-time literals, so the KH x KW reduction is emitted as
+  // straight-line code with the dilation folded into the subscripts, and
+  // the unit-stride output width dimension is simdized: consecutive wo
+  // read consecutive input columns, giving contiguous vector loads.
+  void convDepthwise(ConversionPatternRewriter &rewriter, ONNXConvOp &convOp,
+      ONNXConvOpAdaptor &operandAdaptor, ONNXConvOpShapeHelper &shapeHelper,
+      MemRefType &memRefType, Value alloc) const {
+    Location loc = convOp.getLoc();
+    MultiDialectBuilder<KrnlBuilder, MathBuilder, MemRefBuilder, VectorBuilder>
+        create(rewriter, loc);
+
+    Value inputOperand = operandAdaptor.X();
+    Value filterOperand = operandAdaptor.W();
+    Value biasOperand = operandAdaptor.B();
+    bool hasBias = !biasOperand.getType().isa<NoneType>();
+    Type elementType = memRefType.getElementType();
+    Value fZero = create.math.constant(elementType, 0);
+
+    // All shapes are static here (checked by canUseDepthwise).
+    ArrayRef<int64_t> outShape = memRefType.getShape();
+    ArrayRef<int64_t> inShape =
+        inputOperand.getType().cast<MemRefType>().getShape();
+    ArrayRef<int64_t> filterShape =
+        filterOperand.getType().cast<MemRefType>().getShape();
+    int64_t N = outShape[0], C = outShape[1], OH = outShape[2],
+            OW = outShape[3];
+    int64_t HI = inShape[2], WI = inShape[3];
+    int64_t KH = filterShape[2], KW = filterShape[3];
+    int64_t ph = shapeHelper.pads[0].getLiteral();
+    int64_t pw = shapeHelper.pads[1].getLiteral();
+    int64_t sh = shapeHelper.strides[0], sw = shapeHelper.strides[1];
+    int64_t dh = shapeHelper.dilations[0], dw = shapeHelper.dilations[1];
+    // Extent of the input window the kernel touches, borders included.
+    int64_t HIP = (OH - 1) * sh + (KH - 1) * dh + 1;
+    int64_t WIP = (OW - 1) * sw + (KW - 1) * dw + 1;
+    bool needsPad = ph != 0 || pw != 0 || HIP > HI || WIP > WI;
+
+    // Simdize along wo for unit horizontal stride; consecutive wo then read
+    // consecutive input columns. Same divisibility scheme as the
+    // element-wise lowering.
+    int64_t VL = create.vec.getMachineVectorLength(elementType);
+    bool simdize = sw == 1 && VL > 1 && OW >= VL && OW % VL == 0;
+    VectorType vecType =
+        simdize ? VectorType::get({VL}, elementType) : VectorType();
+
+    // Scratch buffer for the zero-padded input window, reused for every
+    // (c, n) pair.
+    Value padBuff;
+    if (needsPad)
+      padBuff =
+          create.mem.alignedAlloc(MemRefType::get({HIP, WIP}, elementType));
+
+    IndexExpr iZero = LiteralIndexExpr(0);
+    ValueRange cLoop = create.krnl.defineLoops(1);
+    create.krnl.iterateIE(cLoop, cLoop, {iZero}, {LiteralIndexExpr(C)},
+        [&](KrnlBuilder &createKrnl, ValueRange cIndices) {
+          IndexExprScope cScope(createKrnl);
+          MultiDialectBuilder<KrnlBuilder, MathBuilder, VectorBuilder> create(
+              createKrnl);
+          Value cVal = cIndices[0];
+
+          // Load the KH x KW filter of this channel once.
+          SmallVector<Value, 9> filterVals;
+          for (int64_t kh = 0; kh < KH; ++kh)
+            for (int64_t kw = 0; kw < KW; ++kw)
+              filterVals.emplace_back(create.krnl.loadIE(filterOperand,
+                  {DimIndexExpr(cVal), LiteralIndexExpr(0),
+                      LiteralIndexExpr(kh), LiteralIndexExpr(kw)}));
+          Value biasVal;
+          if (hasBias)
+            biasVal =
+                create.krnl.loadIE(biasOperand, {DimIndexExpr(cVal)});
+
+          ValueRange nLoop = create.krnl.defineLoops(1);
+          create.krnl.iterateIE(nLoop, nLoop, {iZero}, {LiteralIndexExpr(N)},
+              [&](KrnlBuilder &createKrnl, ValueRange nIndices) {
+                IndexExprScope nScope(createKrnl);
+                MultiDialectBuilder<KrnlBuilder, MathBuilder, VectorBuilder>
+                    create(createKrnl);
+                Value nVal = nIndices[0];
+
+                // Stage the input channel into the zero-padded scratch
+                // buffer: padBuff[hp, wp] = X[n, c, hp - ph, wp - pw], with
+                // out-of-image positions reading as zero (same select
+                // scheme as the im2col fill).
+                if (needsPad) {
+                  ValueRange padLoops = create.krnl.defineLoops(2);
+                  create.krnl.iterateIE(padLoops, padLoops, {iZero, iZero},
+                      {LiteralIndexExpr(HIP), LiteralIndexExpr(WIP)},
+                      [&](KrnlBuilder &createKrnl, ValueRange padIndices) {
+                        IndexExprScope padScope(createKrnl);
+                        MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                            createKrnl);
+                        DimIndexExpr hp(padIndices[0]), wp(padIndices[1]);
+                        IndexExpr hi = hp - ph;
+                        IndexExpr wi = wp - pw;
+                        IndexExpr hiClamp =
+                            IndexExpr::min(IndexExpr::max(hi, 0), HI - 1);
+                        IndexExpr wiClamp =
+                            IndexExpr::min(IndexExpr::max(wi, 0), WI - 1);
+                        Value zeroIdx = create.math.constantIndex(0);
+                        Value hiVal = hi.getValue(), wiVal = wi.getValue();
+                        Value inH = create.math.andi(
+                            create.math.sge(hiVal, zeroIdx),
+                            create.math.slt(
+                                hiVal, create.math.constantIndex(HI)));
+                        Value inW = create.math.andi(
+                            create.math.sge(wiVal, zeroIdx),
+                            create.math.slt(
+                                wiVal, create.math.constantIndex(WI)));
+                        Value inBound = create.math.andi(inH, inW);
+                        Value element = create.krnl.loadIE(inputOperand,
+                            {DimIndexExpr(nVal), DimIndexExpr(cVal), hiClamp,
+                                wiClamp});
+                        element = create.math.select(inBound, element, fZero);
+                        createKrnl.storeIE(element, padBuff, {hp, wp});
+                      });
+                }
+
+                // Accumulate, reading from the staged buffer when padding
+                // is in play and straight from the image otherwise.
+                auto loadInput = [&](MultiDialectBuilder<KrnlBuilder,
+                                         MathBuilder, VectorBuilder> &create,
+                                     IndexExpr hi, IndexExpr wi,
+                                     bool vector) -> Value {
+                  if (needsPad) {
+                    if (vector)
+                      return create.vec.loadIE(vecType, padBuff, {hi, wi}, {});
+                    return create.krnl.loadIE(padBuff, {hi, wi});
+                  }
+                  SmallVector<IndexExpr, 4> access = {
+                      DimIndexExpr(nVal), DimIndexExpr(cVal), hi, wi};
+                  if (vector)
+                    return create.vec.loadIE(
+                        vecType, inputOperand, access, {});
+                  return create.krnl.loadIE(inputOperand, access);
+                };
+
+                // One output value (or one vector of VL values along wo) is
+                // fully reduced in registers before it is stored: the KH x
+                // KW loop is a compile-time C++ loop, so the reduction is
+                // straight-line code with literal subscript offsets. When
+                // !needsPad the begin pads are zero, so the subscripts are
+                // valid for the staged buffer and the raw image alike.
+                auto emitReduction = [&](MultiDialectBuilder<KrnlBuilder,
+                                             MathBuilder, VectorBuilder>
+                                             &create,
+                                         IndexExpr ho, IndexExpr wo,
+                                         bool vector) {
+                  Value acc = vector ? create.vec.broadcast(vecType, fZero)
+                                     : fZero;
+                  for (int64_t kh = 0; kh < KH; ++kh)
+                    for (int64_t kw = 0; kw < KW; ++kw) {
+                      IndexExpr hi = ho * sh + kh * dh;
+                      IndexExpr wi = wo * sw + kw * dw;
+                      Value element = loadInput(create, hi, wi, vector);
+                      Value filter = filterVals[kh * KW + kw];
+                      if (vector)
+                        acc = create.vec.fma(element,
+                            create.vec.broadcast(vecType, filter), acc);
+                      else
+                        acc = create.math.add(
+                            create.math.mul(element, filter), acc);
+                    }
+                  if (hasBias)
+                    acc = create.math.add(acc,
+                        vector ? create.vec.broadcast(vecType, biasVal)
+                               : biasVal);
+                  acc = applyFusedActivation(
+                      rewriter, loc, convOp.getOperation(), acc);
+                  return acc;
+                };
+
+                ValueRange outLoops = create.krnl.defineLoops(2);
+                SmallVector<Value, 2> optimizedLoops = {
+                    outLoops[0], outLoops[1]};
+                if (simdize) {
+                  ValueRange woBlock = create.krnl.block(outLoops[1], VL);
+                  optimizedLoops[1] = woBlock[0];
+                }
+                create.krnl.iterateIE(outLoops, optimizedLoops, {iZero, iZero},
+                    {LiteralIndexExpr(OH), LiteralIndexExpr(OW)},
+                    [&](KrnlBuilder &createKrnl, ValueRange outIndices) {
+                      IndexExprScope outScope(createKrnl);
+                      MultiDialectBuilder<KrnlBuilder, MathBuilder,
+                          VectorBuilder>
+                          create(createKrnl);
+                      DimIndexExpr ho(outIndices[0]), wo(outIndices[1]);
+                      Value acc = emitReduction(create, ho, wo, simdize);
+                      SmallVector<IndexExpr, 4> outAccess = {
+                          DimIndexExpr(nVal), DimIndexExpr(cVal), ho, wo};
+                      if (simdize)
+                        create.vec.storeIE(acc, alloc, outAccess, {});
+                      else
+                        createKrnl.storeIE(acc, alloc, outAccess);
+                    });
+              });
+        });
+  }
+
+  // Lower Conv as an explicit im2col transform followed by the tiled
+  // krnl.matmul kernel, for each (group, batch) pair:
+  //
+  //   filterBuff[COPerGroup x (CIPerGroup*KH*KW)] = W[g] flattened,
+  //   colBuff[(CIPerGroup*KH*KW) x (OH*OW)]       = patches of X[n, g],
+  //   gemmOut = filterBuff * colBuff (cache-blocked, register-tiled GEMM),
+  //   Y[n, co, ho, wo] = gemmOut[coPerGroup, ho * OW + wo] (+ bias).
+  //
+  // The scratch buffers are allocated once and reused across all (g, n)
+  // iterations; the filter is packed once per group.
+  void convIm2ColGemm(ConversionPatternRewriter &rewriter, ONNXConvOp &convOp,
+      ONNXConvOpAdaptor &operandAdaptor, ONNXConvOpShapeHelper &shapeHelper,
+      MemRefType &memRefType, Value alloc) const {
+    Location loc = convOp.getLoc();
+    MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl, MathBuilder,
+        MemRefBuilder>
+        create(rewriter, loc);
+
+    Value inputOperand = operandAdaptor.X();
+    Value filterOperand = operandAdaptor.W();
+    Value biasOperand = operandAdaptor.B();
+    bool hasBias = !biasOperand.getType().isa<NoneType>();
+    Type elementType = memRefType.getElementType();
+    Value fZero = create.math.constant(elementType, 0);
+
+    // All shapes are static here (checked by canUseIm2ColGemm).
+    ArrayRef<int64_t> outShape = memRefType.getShape();
+    ArrayRef<int64_t> inShape =
+        inputOperand.getType().cast<MemRefType>().getShape();
+    ArrayRef<int64_t> filterShape =
+        filterOperand.getType().cast<MemRefType>().getShape();
+    int64_t N = outShape[0], CO = outShape[1], OH = outShape[2],
+            OW = outShape[3];
+    int64_t HI = inShape[2], WI = inShape[3];
+    int64_t CIPerGroup = filterShape[1], KH = filterShape[2],
+            KW = filterShape[3];
+    int64_t G = convOp.group();
+    int64_t COPerGroup = CO / G;
+    int64_t ph = shapeHelper.pads[0].getLiteral();
+    int64_t pw = shapeHelper.pads[1].getLiteral();
+    int64_t sh = shapeHelper.strides[0], sw = shapeHelper.strides[1];
+    int64_t dh = shapeHelper.dilations[0], dw = shapeHelper.dilations[1];
+    // GEMM dimensions: (COPerGroup x KDim) * (KDim x OHOW).
+    int64_t KDim = CIPerGroup * KH * KW;
+    int64_t OHOW = OH * OW;
+    // When no padding is in play and the filter footprint stays inside the
+    // image, the bounds checks in the im2col fill can be skipped entirely.
+    bool needBoundsCheck = ph != 0 || pw != 0 ||
+                           (OH - 1) * sh + (KH - 1) * dh > HI - 1 ||
+                           (OW - 1) * sw + (KW - 1) * dw > WI - 1;
+
+    // Scratch buffers, allocated once and reused for every (g, n) pair.
+    Value colBuff =
+        create.mem.alignedAlloc(MemRefType::get({KDim, OHOW}, elementType));
+    Value filterBuff = create.mem.alignedAlloc(
+        MemRefType::get({COPerGroup, KDim}, elementType));
+    Value gemmOut = create.mem.alignedAlloc(
+        MemRefType::get({COPerGroup, OHOW}, elementType));
+
+    // Register tiles for the GEMM, with simdization along the OHOW axis.
+    // Same heuristic as the MatMul lowering.
+    int64_t iRegTile = 4, jRegTile = 8, kRegTile = 8;
+    bool simdize = true;
+    if (COPerGroup < iRegTile)
+      iRegTile = COPerGroup;
+    if (OHOW % jRegTile != 0 && OHOW % 4 == 0 && OHOW <= 32)
+      jRegTile = 4;
+    if (OHOW < jRegTile)
+      simdize = false;
+    if (KDim < kRegTile)
+      kRegTile = KDim;
+
+    IndexExpr iZero = LiteralIndexExpr(0);
+    ValueRange gLoop = create.krnl.defineLoops(1);
+    create.krnl.iterateIE(gLoop, gLoop, {iZero}, {LiteralIndexExpr(G)},
+        [&](KrnlBuilder &createKrnl, ValueRange gIndices) {
+          IndexExprScope gScope(createKrnl);
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          Value gVal = gIndices[0];
+
+          // Pack the filter of this group as a COPerGroup x KDim matrix:
+          // filterBuff[coPerG, (ciPerG * KH + kh) * KW + kw] =
+          //     W[g * COPerGroup + coPerG, ciPerG, kh, kw].
+          ValueRange packLoops = create.krnl.defineLoops(4);
+          create.krnl.iterateIE(packLoops, packLoops,
+              {iZero, iZero, iZero, iZero},
+              {LiteralIndexExpr(COPerGroup), LiteralIndexExpr(CIPerGroup),
+                  LiteralIndexExpr(KH), LiteralIndexExpr(KW)},
+              [&](KrnlBuilder &createKrnl, ValueRange packIndices) {
+                IndexExprScope packScope(createKrnl);
+                DimIndexExpr coPerG(packIndices[0]), ciPerG(packIndices[1]),
+                    kh(packIndices[2]), kw(packIndices[3]);
+                IndexExpr co = DimIndexExpr(gVal) * COPerGroup + coPerG;
+                IndexExpr row = (ciPerG * KH + kh) * KW + kw;
+                Value filter =
+                    createKrnl.loadIE(filterOperand, {co, ciPerG, kh, kw});
+                createKrnl.storeIE(filter, filterBuff, {coPerG, row});
+              });
+
+          // Process every image of the batch with the packed filter.
+          ValueRange nLoop = create.krnl.defineLoops(1);
+          create.krnl.iterateIE(nLoop, nLoop, {iZero}, {LiteralIndexExpr(N)},
+              [&](KrnlBuilder &createKrnl, ValueRange nIndices) {
+                IndexExprScope nScope(createKrnl);
+                MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                    createKrnl);
+                Value nVal = nIndices[0];
+
+                // im2col: colBuff[(ciPerG * KH + kh) * KW + kw, ho * OW + wo]
+                //     = X[n, g * CIPerGroup + ciPerG,
+                //         ho * sh + kh * dh - ph, wo * sw + kw * dw - pw],
+                // with out-of-image accesses reading as zero.
+                ValueRange colLoops = create.krnl.defineLoops(5);
+                create.krnl.iterateIE(colLoops, colLoops,
+                    {iZero, iZero, iZero, iZero, iZero},
+                    {LiteralIndexExpr(CIPerGroup), LiteralIndexExpr(KH),
+                        LiteralIndexExpr(KW), LiteralIndexExpr(OH),
+                        LiteralIndexExpr(OW)},
+                    [&](KrnlBuilder &createKrnl, ValueRange colIndices) {
+                      IndexExprScope colScope(createKrnl);
+                      MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                          createKrnl);
+                      DimIndexExpr ciPerG(colIndices[0]), kh(colIndices[1]),
+                          kw(colIndices[2]), ho(colIndices[3]),
+                          wo(colIndices[4]);
+                      IndexExpr row = (ciPerG * KH + kh) * KW + kw;
+                      IndexExpr col = ho * OW + wo;
+                      IndexExpr ci = DimIndexExpr(gVal) * CIPerGroup + ciPerG;
+                      IndexExpr hi = ho * sh + kh * dh - ph;
+                      IndexExpr wi = wo * sw + kw * dw - pw;
+                      Value element;
+                      if (needBoundsCheck) {
+                        // Load from a clamped position and select zero when
+                        // the unclamped position falls outside the image.
+                        // Cheaper than control flow inside the fill loop.
+                        IndexExpr hiClamp =
+                            IndexExpr::min(IndexExpr::max(hi, 0), HI - 1);
+                        IndexExpr wiClamp =
+                            IndexExpr::min(IndexExpr::max(wi, 0), WI - 1);
+                        Value zeroIdx = create.math.constantIndex(0);
+                        Value hiVal = hi.getValue(), wiVal = wi.getValue();
+                        Value inH = create.math.andi(
+                            create.math.sge(hiVal, zeroIdx),
+                            create.math.slt(
+                                hiVal, create.math.constantIndex(HI)));
+                        Value inW = create.math.andi(
+                            create.math.sge(wiVal, zeroIdx),
+                            create.math.slt(
+                                wiVal, create.math.constantIndex(WI)));
+                        Value inBound = create.math.andi(inH, inW);
+                        element = create.krnl.loadIE(inputOperand,
+                            {DimIndexExpr(nVal), ci, hiClamp, wiClamp});
+                        element = create.math.select(inBound, element, fZero);
+                      } else {
+                        element = create.krnl.loadIE(
+                            inputOperand, {DimIndexExpr(nVal), ci, hi, wi});
+                      }
+                      createKrnl.storeIE(element, colBuff, {row, col});
+                    });
+
+                // Cache-blocked, register-tiled GEMM:
+                // gemmOut = filterBuff * colBuff.
+                create.krnl.memset(gemmOut, fZero);
+                Value zero = create.math.constantIndex(0);
+                Value iBound = create.math.constantIndex(COPerGroup);
+                Value jBound = create.math.constantIndex(OHOW);
+                Value kBound = create.math.constantIndex(KDim);
+                ValueRange mmLoops = create.krnl.defineLoops(3);
+                Value ii(mmLoops[0]), jj(mmLoops[1]), kk(mmLoops[2]);
+                ValueRange iRegBlock = create.krnl.block(ii, iRegTile);
+                Value ii1(iRegBlock[0]), ii2(iRegBlock[1]);
+                ValueRange jRegBlock = create.krnl.block(jj, jRegTile);
+                Value jj1(jRegBlock[0]), jj2(jRegBlock[1]);
+                ValueRange kRegBlock = create.krnl.block(kk, kRegTile);
+                Value kk1(kRegBlock[0]), kk2(kRegBlock[1]);
+                create.krnl.permute(
+                    {ii1, ii2, jj1, jj2, kk1, kk2}, {0, 3, 1, 4, 2, 5});
+                create.krnl.iterate({ii, jj, kk}, {ii1, jj1, kk1},
+                    {zero, zero, zero}, {iBound, jBound, kBound},
+                    [&](KrnlBuilder &createKrnl, ValueRange mmIndices) {
+                      Value i1(mmIndices[0]), j1(mmIndices[1]),
+                          k1(mmIndices[2]);
+                      createKrnl.matmul(filterBuff, {zero, zero}, colBuff,
+                          {zero, zero}, gemmOut, {zero, zero}, {ii2, jj2, kk2},
+                          {i1, j1, k1}, {iBound, jBound, kBound},
+                          {iRegTile, jRegTile, kRegTile}, {}, {}, {}, simdize,
+                          /*unroll*/ true, /*overcompute*/ false);
+                    });
+
+                // Scatter the GEMM result back into NCHW layout, adding the
+                // bias on the way out.
+                ValueRange outLoops = create.krnl.defineLoops(3);
+                create.krnl.iterateIE(outLoops, outLoops, {iZero, iZero, iZero},
+                    {LiteralIndexExpr(COPerGroup), LiteralIndexExpr(OH),
+                        LiteralIndexExpr(OW)},
+                    [&](KrnlBuilder &createKrnl, ValueRange outIndices) {
+                      IndexExprScope outScope(createKrnl);
+                      MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                          createKrnl);
+                      DimIndexExpr coPerG(outIndices[0]), ho(outIndices[1]),
+                          wo(outIndices[2]);
+                      IndexExpr col = ho * OW + wo;
+                      IndexExpr co =
+                          DimIndexExpr(gVal) * COPerGroup + coPerG;
+                      Value result = createKrnl.loadIE(gemmOut, {coPerG, col});
+                      if (hasBias) {
+                        Value bias = createKrnl.loadIE(biasOperand, {co});
+                        result = create.math.add(result, bias);
+                      }
+                      result = applyFusedActivation(
+                          rewriter, loc, convOp.getOperation(), result);
+                      createKrnl.storeIE(result, alloc,
+                          {DimIndexExpr(nVal), co, ho, wo});
+                    });
+              });
+        });
+  }
+
   LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
       ConversionPatternRewriter &rewriter) const final {
     Location loc = op->getLoc();
@@ -249,8 +721,23 @@ struct ONNXConvOpLowering : public ConversionPattern {
     Value alloc = insertAllocAndDeallocSimple(
         rewriter, op, memRefType, loc, shapeHelper.getOutputDims());
 
-    convUnoptimized(
-        rewriter, convOp, operandAdaptor, shapeHelper, memRefType, alloc);
+    // The depthwise and im2col+GEMM paths keep scratch buffers alive across
+    // the whole computation, which the static dealloc placement scheme does
+    // not handle; only use them when the buffer-deallocation pass runs
+    // later. Convs measured as hot spots take these paths even when the
+    // fast-conv option is off.
+    if ((enableFastConv || opIsProfileHot(op)) && !ONNXToKrnl_gEmitDealloc &&
+        canUseDepthwise(convOp, operandAdaptor, shapeHelper, memRefType))
+      convDepthwise(
+          rewriter, convOp, operandAdaptor, shapeHelper, memRefType, alloc);
+    else if ((enableFastConv || opIsProfileHot(op)) &&
+             !ONNXToKrnl_gEmitDealloc &&
+             canUseIm2ColGemm(operandAdaptor, shapeHelper, memRefType))
+      convIm2ColGemm(
+          rewriter, convOp, operandAdaptor, shapeHelper, memRefType, alloc);
+    else
+      convUnoptimized(
+          rewriter, convOp, operandAdaptor, shapeHelper, memRefType, alloc);
 
     rewriter.replaceOp(op, alloc);
     return success();
@@ -258,8 +745,10 @@ struct ONNXConvOpLowering : public ConversionPattern {
 };
 
 void populateLoweringONNXConvOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel) {
-  patterns.insert<ONNXConvOpLowering>(typeConverter, ctx, enableParallel);
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel,
+    bool enableFastConv) {
+  patterns.insert<ONNXConvOpLowering>(
+      typeConverter, ctx, enableParallel, enableFastConv);
 }
 
 } // namespace onnx_mlir
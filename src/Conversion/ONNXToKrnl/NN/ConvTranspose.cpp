@@ -0,0 +1,279 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===--------- ConvTranspose.cpp - Lowering ConvTranspose Op --------------===//
+//
+// Copyright 2019-2022 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the ONNX ConvTranspose Operator to Krnl dialect.
+//
+// The kernel uses the output-gather formulation: every output element pulls
+// in the input elements that contribute to it,
+//
+//   Y[n, co, ho, wo] = sum_{ciPerG, kh, kw}
+//       X[n, ci, (ho + ph - kh*dh) / sh, (wo + pw - kw*dw) / sw]
+//       * W[ci, coPerG, kh, kw]  (+ bias),
+//
+// where a term only exists when the division is exact and the quotient falls
+// inside the input. For stride > 1 that divisibility condition is structural:
+// it depends only on (ho + ph) mod sh, not on the data. The equivalent
+// pad-and-stretch formulation materializes the stride-1 convolution over an
+// input with zeros inserted between elements and multiplies those zeros like
+// any other value. Here the output space is instead split per residue class
+// of (ho + ph) mod sh (resp. wo), and each class only visits the kernel taps
+// whose kh*dh has the matching residue, so for stride-2 upsampling every
+// output reads KH*KW/4 taps instead of KH*KW.
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/Conversion/ONNXToKrnl/ONNXToKrnlCommon.hpp"
+#include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+struct ONNXConvTransposeOpLowering : public ConversionPattern {
+  ONNXConvTransposeOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+      : ConversionPattern(typeConverter,
+            mlir::ONNXConvTransposeOp::getOperationName(), 1, ctx) {}
+
+  // Read an integer array attribute that shape inference has normalized,
+  // falling back to the given default when it is absent.
+  static int64_t attrVal(
+      Optional<ArrayAttr> attr, int64_t i, int64_t defaultVal) {
+    if (!attr.has_value() || i >= (int64_t)ArrayAttrSize(attr))
+      return defaultVal;
+    return ArrayAttrIntVal(attr, i);
+  }
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    Location loc = op->getLoc();
+    ONNXConvTransposeOpAdaptor operandAdaptor(operands);
+    ONNXConvTransposeOp convTransposeOp =
+        llvm::dyn_cast<ONNXConvTransposeOp>(op);
+    MultiDialectBuilder<KrnlBuilder, MathBuilder, MemRefBuilder> create(
+        rewriter, loc);
+
+    Value inputOperand = operandAdaptor.X();
+    Value filterOperand = operandAdaptor.W();
+    Value biasOperand = operandAdaptor.B();
+    bool hasBias = !biasOperand.getType().isa<NoneType>();
+
+    // Convert the output type to MemRefType.
+    Type convertedType = typeConverter->convertType(*op->result_type_begin());
+    assert(convertedType && convertedType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType memRefType = convertedType.cast<MemRefType>();
+    Type elementType = memRefType.getElementType();
+
+    // The kernel is restricted to 2-D spatial transposed convolutions over
+    // floats with all shapes known at compile time: shape inference computes
+    // a static output shape whenever the input is static, and the residue
+    // decomposition below relies on literal strides and pads.
+    auto inputType = inputOperand.getType().dyn_cast<MemRefType>();
+    auto filterType = filterOperand.getType().dyn_cast<MemRefType>();
+    if (memRefType.getRank() != 4 || !memRefType.hasStaticShape() ||
+        !inputType || !inputType.hasStaticShape() || !filterType ||
+        !filterType.hasStaticShape() || !elementType.isa<FloatType>())
+      return failure();
+
+    // Output Y: [N x CO x HO x WO], input X: [N x CI x HI x WI],
+    // filter W: [CI x COPerGroup x KH x KW] (channel dims swapped wrt Conv).
+    ArrayRef<int64_t> outShape = memRefType.getShape();
+    ArrayRef<int64_t> inShape = inputType.getShape();
+    ArrayRef<int64_t> filterShape = filterType.getShape();
+    int64_t N = outShape[0], HO = outShape[2], WO = outShape[3];
+    int64_t CI = inShape[1], HI = inShape[2], WI = inShape[3];
+    int64_t COPerGroup = filterShape[1], KH = filterShape[2],
+            KW = filterShape[3];
+    int64_t G = convTransposeOp.group();
+    int64_t CIPerGroup = CI / G;
+
+    // Shape inference sets strides, dilations and pads to their proper
+    // values (including the output_shape attribute case).
+    int64_t sh = attrVal(convTransposeOp.strides(), 0, 1);
+    int64_t sw = attrVal(convTransposeOp.strides(), 1, 1);
+    int64_t dh = attrVal(convTransposeOp.dilations(), 0, 1);
+    int64_t dw = attrVal(convTransposeOp.dilations(), 1, 1);
+    int64_t ph = attrVal(convTransposeOp.pads(), 0, 0);
+    int64_t pw = attrVal(convTransposeOp.pads(), 1, 0);
+
+    // Insert an allocation and deallocation for the result of this operation.
+    SmallVector<IndexExpr, 4> outputDims;
+    for (int64_t d : outShape)
+      outputDims.emplace_back(LiteralIndexExpr(d));
+    Value alloc = insertAllocAndDeallocSimple(
+        rewriter, op, memRefType, loc, outputDims);
+
+    Value fZero = create.math.constant(elementType, 0);
+    // Create a local reduction value.
+    MemRefType tmpType = MemRefType::get({}, elementType);
+    // Single scalar, no need for default alignment.
+    Value reductionVal = create.mem.alloca(tmpType);
+
+    IndexExpr iZero = LiteralIndexExpr(0);
+    // Iterate over the outer loops:
+    // for n = 0 .. N:
+    //   for g = 0 .. G:
+    //     for coPerGroup = 0 .. COPerGroup:
+    //       co = g * COPerGroup + coPerGroup;
+    ValueRange outerLoops = create.krnl.defineLoops(3);
+    create.krnl.iterateIE(outerLoops, outerLoops, {iZero, iZero, iZero},
+        {LiteralIndexExpr(N), LiteralIndexExpr(G),
+            LiteralIndexExpr(COPerGroup)},
+        [&](KrnlBuilder &createKrnl, ValueRange outerIndices) {
+          IndexExprScope outerScope(createKrnl);
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          Value nVal = outerIndices[0], gVal = outerIndices[1],
+                coPerGVal = outerIndices[2];
+          IndexExpr coIE =
+              DimIndexExpr(gVal) * COPerGroup + DimIndexExpr(coPerGVal);
+          Value coVal = coIE.getValue();
+          Value biasVal;
+          if (hasBias)
+            biasVal = create.krnl.loadIE(biasOperand, {DimIndexExpr(coVal)});
+
+          // Split the output space per residue class (rh, rw) of
+          // (ho + ph) mod sh and (wo + pw) mod sw. Within one class the
+          // outputs are ho = ho0 + qh * sh, and only the kernel taps with
+          // kh * dh = rh (mod sh) contribute; for those the input row is
+          // hi = qh + offH with a compile-time offset offH, so the whole
+          // divisibility test vanishes from the generated code.
+          for (int64_t rh = 0; rh < sh; ++rh) {
+            int64_t ho0 = ((rh - ph) % sh + sh) % sh;
+            if (ho0 >= HO)
+              continue;
+            int64_t QH = (HO - ho0 + sh - 1) / sh;
+            SmallVector<std::pair<int64_t, int64_t>, 4> tapsH;
+            for (int64_t kh = 0; kh < KH; ++kh)
+              if ((kh * dh) % sh == (ho0 + ph) % sh)
+                tapsH.emplace_back(kh, (ho0 + ph - kh * dh) / sh);
+            for (int64_t rw = 0; rw < sw; ++rw) {
+              int64_t wo0 = ((rw - pw) % sw + sw) % sw;
+              if (wo0 >= WO)
+                continue;
+              int64_t QW = (WO - wo0 + sw - 1) / sw;
+              SmallVector<std::pair<int64_t, int64_t>, 4> tapsW;
+              for (int64_t kw = 0; kw < KW; ++kw)
+                if ((kw * dw) % sw == (wo0 + pw) % sw)
+                  tapsW.emplace_back(kw, (wo0 + pw - kw * dw) / sw);
+
+              // A class without contributing taps still owns output
+              // elements; they get bias (or zero) below.
+              bool hasTaps = !tapsH.empty() && !tapsW.empty();
+
+              ValueRange qLoops = create.krnl.defineLoops(2);
+              create.krnl.iterateIE(qLoops, qLoops, {iZero, iZero},
+                  {LiteralIndexExpr(QH), LiteralIndexExpr(QW)},
+                  [&](KrnlBuilder &createKrnl, ValueRange qIndices) {
+                    IndexExprScope qScope(createKrnl);
+                    MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                        createKrnl);
+                    Value qhVal = qIndices[0], qwVal = qIndices[1];
+                    // Reset reduction value to zero.
+                    create.krnl.store(fZero, reductionVal);
+
+                    if (hasTaps) {
+                      // for ciPerGroup = 0 .. CIPerGroup:
+                      ValueRange ciLoop = create.krnl.defineLoops(1);
+                      create.krnl.iterateIE(ciLoop, ciLoop, {iZero},
+                          {LiteralIndexExpr(CIPerGroup)},
+                          [&](KrnlBuilder &createKrnl, ValueRange ciIndices) {
+                            IndexExprScope ciScope(createKrnl);
+                            MultiDialectBuilder<KrnlBuilder, MathBuilder>
+                                create(createKrnl);
+                            DimIndexExpr ciPerG(ciIndices[0]);
+                            // ci = g * CIPerGroup + ciPerG.
+                            IndexExpr ci =
+                                DimIndexExpr(gVal) * CIPerGroup + ciPerG;
+                            // The taps of this class are a compile-time
+                            // list, so the reduction over them is emitted
+                            // as straight-line code.
+                            Value acc = fZero;
+                            for (auto [kh, offH] : tapsH) {
+                              // hi = qh + offH; the offset is a literal, so
+                              // whether a bound can be violated is known
+                              // here: only boundary taps pay for a check.
+                              IndexExpr hi = DimIndexExpr(qhVal) + offH;
+                              bool checkH =
+                                  offH < 0 || QH - 1 + offH >= HI;
+                              for (auto [kw, offW] : tapsW) {
+                                IndexExpr wi = DimIndexExpr(qwVal) + offW;
+                                bool checkW =
+                                    offW < 0 || QW - 1 + offW >= WI;
+                                IndexExpr hiAcc = hi, wiAcc = wi;
+                                Value inBound;
+                                if (checkH) {
+                                  hiAcc = IndexExpr::min(
+                                      IndexExpr::max(hi, 0), HI - 1);
+                                  Value hiVal = hi.getValue();
+                                  inBound = create.math.andi(
+                                      create.math.sge(hiVal,
+                                          create.math.constantIndex(0)),
+                                      create.math.slt(hiVal,
+                                          create.math.constantIndex(HI)));
+                                }
+                                if (checkW) {
+                                  wiAcc = IndexExpr::min(
+                                      IndexExpr::max(wi, 0), WI - 1);
+                                  Value wiVal = wi.getValue();
+                                  Value inW = create.math.andi(
+                                      create.math.sge(wiVal,
+                                          create.math.constantIndex(0)),
+                                      create.math.slt(wiVal,
+                                          create.math.constantIndex(WI)));
+                                  inBound = checkH
+                                                ? create.math.andi(
+                                                      inBound, inW)
+                                                : inW;
+                                }
+                                Value element = create.krnl.loadIE(
+                                    inputOperand, {DimIndexExpr(nVal), ci,
+                                                      hiAcc, wiAcc});
+                                if (checkH || checkW)
+                                  element = create.math.select(
+                                      inBound, element, fZero);
+                                // Filter access: [ci, coPerG, kh, kw].
+                                Value filter = create.krnl.loadIE(
+                                    filterOperand,
+                                    {ci, DimIndexExpr(coPerGVal),
+                                        LiteralIndexExpr(kh),
+                                        LiteralIndexExpr(kw)});
+                                acc = create.math.add(
+                                    create.math.mul(element, filter), acc);
+                              }
+                            }
+                            Value oldRed = create.krnl.load(reductionVal);
+                            create.krnl.store(
+                                create.math.add(oldRed, acc), reductionVal);
+                          }); // Channel-in loop.
+                    }
+                    // Finish the reduction and store in result array.
+                    Value result = create.krnl.load(reductionVal);
+                    if (hasBias)
+                      result = create.math.add(result, biasVal);
+                    IndexExpr ho = DimIndexExpr(qhVal) * sh + ho0;
+                    IndexExpr wo = DimIndexExpr(qwVal) * sw + wo0;
+                    create.krnl.storeIE(result, alloc,
+                        {DimIndexExpr(nVal), DimIndexExpr(coVal), ho, wo});
+                  }); // Output class loops.
+            }
+          }
+        }); // Outer loops.
+
+    rewriter.replaceOp(op, alloc);
+    return success();
+  }
+};
+
+void populateLoweringONNXConvTransposeOpPattern(RewritePatternSet &patterns,
+    TypeConverter &typeConverter, MLIRContext *ctx) {
+  patterns.insert<ONNXConvTransposeOpLowering>(typeConverter, ctx);
+}
+
+} // namespace onnx_mlir
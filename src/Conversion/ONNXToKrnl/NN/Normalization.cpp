@@ -30,10 +30,16 @@ struct ONNXBatchNormalizationInferenceModeOpLowering
       ConversionPatternRewriter &rewriter) const final {
     // batchnorm{epsilon}(x, scale, bias, mean, variance) =
     //      scale * (x - mean) / sqrt(variance + epsilon) + bias
+    // The per-channel multiplier and shift
+    //      a = scale / sqrt(variance + epsilon), b = bias - mean * a
+    // are precomputed once per channel so the element loop is the single
+    // fused multiply-add y = x * a + b, with the square root and the
+    // division lifted out of the hot loop.
     ONNXBatchNormalizationInferenceModeOpAdaptor operandAdaptor(operands);
     Location loc = op->getLoc();
 
-    MultiDialectBuilder<KrnlBuilder, MathBuilder> create(rewriter, loc);
+    MultiDialectBuilder<KrnlBuilder, MathBuilder, MemRefBuilder> create(
+        rewriter, loc);
 
     // Convert the output type to MemRefType.
     Type convertedType = typeConverter->convertType(*op->result_type_begin());
@@ -69,6 +75,15 @@ struct ONNXBatchNormalizationInferenceModeOpLowering
     // rank
     int64_t rank = memRefType.getRank();
 
+    // With a static contiguous shape over floats, collapse the spatial
+    // dimensions and vectorize the fused multiply-add loop. The general
+    // scalar loop below covers the remaining cases.
+    if (emitVectorizedBatchNorm(rewriter, loc, operand, scale, bias, mean,
+            variance, epsilon, alloc, memRefType)) {
+      rewriter.replaceOp(op, alloc);
+      return success();
+    }
+
     std::vector<Value> originalLoops;
     defineLoops(rewriter, loc, originalLoops, rank);
 
@@ -94,6 +109,11 @@ struct ONNXBatchNormalizationInferenceModeOpLowering
     Value meanVal = create.krnl.load(mean, loopCIVs);
     Value varianceVal = create.krnl.load(variance, loopCIVs);
 
+    // Per-channel multiplier and shift.
+    Value adjustedVarianceVal = create.math.add(varianceVal, epsilon);
+    Value aVal = create.math.div(scaleVal, create.math.sqrt(adjustedVarianceVal));
+    Value bVal = create.math.sub(biasVal, create.math.mul(meanVal, aVal));
+
     // Create a KrnlIterateOp along the other dimensions.
     SmallVector<int64_t, 4> axes;
     axes.emplace_back(0);
@@ -126,20 +146,92 @@ struct ONNXBatchNormalizationInferenceModeOpLowering
       loopIVs.emplace_back(args[0]);
 
     Value xVal = create.krnl.load(operand, loopIVs);
-    // normalize
-    Value dividend = create.math.sub(xVal, meanVal);
-    Value adjustedVarianceVal = create.math.add(varianceVal, epsilon);
-    Value divisor = create.math.sqrt(adjustedVarianceVal);
-    Value normVal = create.math.div(dividend, divisor);
-    // scale and shift
-    Value scaleNormVal = create.math.mul(scaleVal, normVal);
-    Value shiftScaleNormVal = create.math.add(scaleNormVal, biasVal);
-    create.krnl.store(shiftScaleNormVal, alloc, loopIVs);
+    // y = x * a + b
+    Value resVal = create.math.add(create.math.mul(xVal, aVal), bVal);
+    create.krnl.store(resVal, alloc, loopIVs);
 
     rewriter.replaceOp(op, alloc);
 
     return success();
   }
+
+private:
+  // Emit the vectorized batchnorm loop nest when the shapes allow it:
+  // static contiguous float buffers of rank > 2 whose collapsed spatial size
+  // is a multiple of the machine vector length. The input and the result are
+  // viewed as [N, C, spatial]; for each channel the scalar multiplier and
+  // shift are computed once and broadcast, and the loop over the batch and
+  // the blocked spatial dimension is covered by vector loads, one vector
+  // fused multiply-add and one vector store. Returns false when the shapes
+  // do not allow it.
+  bool emitVectorizedBatchNorm(ConversionPatternRewriter &rewriter,
+      Location loc, Value operand, Value scale, Value bias, Value mean,
+      Value variance, Value epsilon, Value alloc,
+      MemRefType memRefType) const {
+    int64_t rank = memRefType.getRank();
+    Type elementType = memRefType.getElementType();
+    MemRefType inputType = operand.getType().cast<MemRefType>();
+    if (rank <= 2 || !elementType.isa<FloatType>() ||
+        !memRefType.hasStaticShape() || !memRefType.getLayout().isIdentity() ||
+        inputType.getShape() != memRefType.getShape() ||
+        !inputType.getLayout().isIdentity())
+      return false;
+
+    MultiDialectBuilder<KrnlBuilder, MemRefBuilder, VectorBuilder> create(
+        rewriter, loc);
+    int64_t VL = create.vec.getMachineVectorLength(elementType);
+    ArrayRef<int64_t> shape = memRefType.getShape();
+    int64_t spatialSize = 1;
+    for (int64_t i = 2; i < rank; ++i)
+      spatialSize *= shape[i];
+    if (VL <= 1 || spatialSize < VL || spatialSize % VL != 0)
+      return false;
+
+    // View the input and the result as [N, C, spatial].
+    IndexExprScope outerScope(&rewriter, loc);
+    SmallVector<IndexExpr, 3> flatDims = {LiteralIndexExpr(shape[0]),
+        LiteralIndexExpr(shape[1]), LiteralIndexExpr(spatialSize)};
+    Value flatInput = create.mem.reinterpretCast(operand, flatDims);
+    Value flatAlloc = create.mem.reinterpretCast(alloc, flatDims);
+    VectorType vecType = VectorType::get({VL}, elementType);
+
+    IndexExpr iZero = LiteralIndexExpr(0);
+    ValueRange cLoop = create.krnl.defineLoops(1);
+    create.krnl.iterateIE(cLoop, cLoop, {iZero},
+        {LiteralIndexExpr(shape[1])},
+        [&](KrnlBuilder &createKrnl, ValueRange cIndices) {
+          IndexExprScope cScope(createKrnl);
+          MultiDialectBuilder<KrnlBuilder, MathBuilder, VectorBuilder> create(
+              createKrnl);
+          Value cVal = cIndices[0];
+
+          // Per-channel multiplier and shift, broadcast once.
+          Value scaleVal = create.krnl.load(scale, {cVal});
+          Value biasVal = create.krnl.load(bias, {cVal});
+          Value meanVal = create.krnl.load(mean, {cVal});
+          Value varianceVal = create.krnl.load(variance, {cVal});
+          Value aVal = create.math.div(
+              scaleVal, create.math.sqrt(create.math.add(varianceVal, epsilon)));
+          Value bVal = create.math.sub(biasVal, create.math.mul(meanVal, aVal));
+          Value aVec = create.vec.broadcast(vecType, aVal);
+          Value bVec = create.vec.broadcast(vecType, bVal);
+
+          ValueRange nsLoops = create.krnl.defineLoops(2);
+          ValueRange blockedLoop = create.krnl.block(nsLoops[1], VL);
+          SmallVector<IndexExpr, 2> lbs(2, LiteralIndexExpr(0));
+          SmallVector<IndexExpr, 2> ubs = {LiteralIndexExpr(shape[0]),
+              LiteralIndexExpr(spatialSize)};
+          create.krnl.iterateIE(nsLoops, {nsLoops[0], blockedLoop[0]}, lbs,
+              ubs, [&](KrnlBuilder &createKrnl, ValueRange nsIndices) {
+                VectorBuilder createVec(createKrnl);
+                Value xVec = createVec.load(
+                    vecType, flatInput, {nsIndices[0], cVal, nsIndices[1]});
+                createVec.store(createVec.fma(xVec, aVec, bVec), flatAlloc,
+                    {nsIndices[0], cVal, nsIndices[1]});
+              });
+        });
+    return true;
+  }
 };
 
 struct ONNXInstanceNormalizationOpLowering : public ConversionPattern {
@@ -293,11 +385,195 @@ struct ONNXInstanceNormalizationOpLowering : public ConversionPattern {
   }
 };
 
+struct ONNXLayerNormalizationOpLowering : public ConversionPattern {
+  ONNXLayerNormalizationOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx)
+      : ConversionPattern(typeConverter,
+            mlir::ONNXLayerNormalizationOp::getOperationName(), 1, ctx) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    // layer_normalization{axis,epsilon}(x, scale, bias) =
+    //      scale * (x - mean) / sqrt(variance + epsilon) + bias
+    // where mean and variance are taken over the dimensions [axis, rank).
+    // Mean and variance are computed in a single pass with Welford's
+    // algorithm so each normalization group reads the input only twice
+    // (once for the statistics, once for the scale and shift) instead of
+    // the four passes of the decomposed form.
+    ONNXLayerNormalizationOpAdaptor operandAdaptor(operands);
+    auto lnOp = cast<ONNXLayerNormalizationOp>(op);
+    Location loc = op->getLoc();
+    MultiDialectBuilder<KrnlBuilder, MemRefBuilder, MathBuilder> create(
+        rewriter, loc);
+
+    // The decomposed-form recognizer only produces the Y output; computing
+    // the optional Mean and InvStdDev outputs is not supported here.
+    if (!isNoneType(lnOp.Mean()) || !isNoneType(lnOp.InvStdDev()))
+      return failure();
+
+    // Convert the output type to MemRefType.
+    Type convertedType = typeConverter->convertType(*op->result_type_begin());
+    assert(convertedType && convertedType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType memRefType = convertedType.cast<MemRefType>();
+    Type elementType = memRefType.getElementType();
+    int64_t rank = memRefType.getRank();
+    int64_t axis = lnOp.axis();
+    if (axis < 0)
+      axis += rank;
+    int64_t numNormalizedDims = rank - axis;
+
+    Value inputMemRef = operandAdaptor.X();
+    Value scaleMemRef = operandAdaptor.scale();
+    Value biasMemRef = operandAdaptor.B();
+    bool hasBias = !isNoneType(biasMemRef);
+
+    // Scale and bias are indexed with the inner loop indices; support a
+    // scalar, or a rank that matches the normalized dimensions with
+    // broadcast (dim of 1) allowed per dimension.
+    auto isIndexableByInnerLoops = [&](Value v) {
+      int64_t r = v.getType().cast<MemRefType>().getRank();
+      return r == 0 || r == numNormalizedDims;
+    };
+    if (!isIndexableByInnerLoops(scaleMemRef) ||
+        (hasBias && !isIndexableByInnerLoops(biasMemRef)))
+      return failure();
+
+    Value epsilon =
+        create.math.constant(elementType, lnOp.epsilon().convertToDouble());
+    Value fZero = create.math.constant(elementType, 0);
+    Value fOne = create.math.constant(elementType, 1);
+    Value iZeroIndex = create.math.constantIndex(0);
+
+    // Insert an allocation and deallocation for the result of this operation.
+    bool insertDealloc = checkInsertDealloc(op);
+    Value resMemRef =
+        (hasAllConstantDimensions(memRefType))
+            ? insertAllocAndDealloc(memRefType, loc, rewriter, insertDealloc)
+            : insertAllocAndDealloc(
+                  memRefType, loc, rewriter, insertDealloc, {inputMemRef});
+
+    // Single-element buffers carrying the Welford state across the inner
+    // loop: running count, running mean, and running sum of squared
+    // differences from the current mean.
+    MemRefType cellType = MemRefType::get({}, elementType);
+    Value countMemRef = create.mem.alloca(cellType);
+    Value meanMemRef = create.mem.alloca(cellType);
+    Value m2MemRef = create.mem.alloca(cellType);
+
+    IndexExprScope outerScope(&rewriter, loc);
+    MemRefBoundsIndexCapture inputBounds(inputMemRef);
+    LiteralIndexExpr iZero(0);
+
+    // Build the access function for scale or bias from the inner indices,
+    // mapping broadcast dimensions to index zero.
+    auto broadcastAccessFct = [&](Value memRef, ValueRange innerIVs) {
+      MemRefType type = memRef.getType().cast<MemRefType>();
+      SmallVector<Value, 4> accessFct;
+      for (int64_t d = 0; d < type.getRank(); ++d)
+        accessFct.emplace_back(
+            (type.getShape()[d] == 1) ? iZeroIndex : innerIVs[d]);
+      return accessFct;
+    };
+
+    auto emitNormalization = [&](KrnlBuilder &createKrnl,
+                                 ValueRange outerIVs) {
+      MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+      IndexExprScope groupScope(createKrnl);
+      MemRefBoundsIndexCapture bounds(inputMemRef);
+
+      // Set bounds for iterating over the normalized dimensions.
+      SmallVector<IndexExpr, 4> lbs(numNormalizedDims, iZero);
+      SmallVector<IndexExpr, 4> ubs;
+      for (int64_t d = axis; d < rank; ++d)
+        ubs.emplace_back(bounds.getSymbol(d));
+
+      // First pass: Welford update of count, mean, and m2 per element.
+      create.krnl.store(fZero, countMemRef, {});
+      create.krnl.store(fZero, meanMemRef, {});
+      create.krnl.store(fZero, m2MemRef, {});
+      ValueRange stats_loopDef = create.krnl.defineLoops(numNormalizedDims);
+      create.krnl.iterateIE(stats_loopDef, stats_loopDef, lbs, ubs,
+          [&](KrnlBuilder &createKrnl, ValueRange innerIVs) {
+            MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+            SmallVector<Value, 6> accessFct(
+                outerIVs.begin(), outerIVs.end());
+            for (int64_t d = 0; d < numNormalizedDims; ++d)
+              accessFct.emplace_back(innerIVs[d]);
+            Value x = create.krnl.load(inputMemRef, accessFct);
+            Value count = create.krnl.load(countMemRef, {});
+            count = create.math.add(count, fOne);
+            create.krnl.store(count, countMemRef);
+            Value oldMean = create.krnl.load(meanMemRef, {});
+            Value delta = create.math.sub(x, oldMean);
+            Value newMean =
+                create.math.add(oldMean, create.math.div(delta, count));
+            create.krnl.store(newMean, meanMemRef);
+            Value delta2 = create.math.sub(x, newMean);
+            Value oldM2 = create.krnl.load(m2MemRef, {});
+            Value newM2 =
+                create.math.add(oldM2, create.math.mul(delta, delta2));
+            create.krnl.store(newM2, m2MemRef);
+          });
+      Value count = create.krnl.load(countMemRef, {});
+      Value mean = create.krnl.load(meanMemRef, {});
+      Value variance =
+          create.math.div(create.krnl.load(m2MemRef, {}), count);
+      Value invStdDev = create.math.div(
+          fOne, create.math.sqrt(create.math.add(variance, epsilon)));
+
+      // Second pass: y = (x - mean) * invStdDev * scale + bias.
+      ValueRange norm_loopDef = create.krnl.defineLoops(numNormalizedDims);
+      create.krnl.iterateIE(norm_loopDef, norm_loopDef, lbs, ubs,
+          [&](KrnlBuilder &createKrnl, ValueRange innerIVs) {
+            MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+            SmallVector<Value, 6> accessFct(
+                outerIVs.begin(), outerIVs.end());
+            for (int64_t d = 0; d < numNormalizedDims; ++d)
+              accessFct.emplace_back(innerIVs[d]);
+            Value x = create.krnl.load(inputMemRef, accessFct);
+            Value norm =
+                create.math.mul(create.math.sub(x, mean), invStdDev);
+            Value scale = create.krnl.load(
+                scaleMemRef, broadcastAccessFct(scaleMemRef, innerIVs));
+            Value y = create.math.mul(norm, scale);
+            if (hasBias) {
+              Value bias = create.krnl.load(
+                  biasMemRef, broadcastAccessFct(biasMemRef, innerIVs));
+              y = create.math.add(y, bias);
+            }
+            create.krnl.store(y, resMemRef, accessFct);
+          });
+    };
+
+    if (axis > 0) {
+      // Iterate over the dimensions that are not normalized.
+      ValueRange outer_loopDef = create.krnl.defineLoops(axis);
+      SmallVector<IndexExpr, 4> outerLbs(axis, iZero);
+      SmallVector<IndexExpr, 4> outerUbs;
+      for (int64_t d = 0; d < axis; ++d)
+        outerUbs.emplace_back(inputBounds.getSymbol(d));
+      create.krnl.iterateIE(
+          outer_loopDef, outer_loopDef, outerLbs, outerUbs, emitNormalization);
+    } else {
+      // The whole tensor is one normalization group.
+      emitNormalization(create.krnl, ValueRange());
+    }
+
+    // The Mean and InvStdDev results are checked above to be NoneType and
+    // are replaced with a null value, as done for the optional RNN results.
+    Value noneValue;
+    rewriter.replaceOp(op, {resMemRef, noneValue, noneValue});
+    return success();
+  }
+};
+
 void populateLoweringONNXNormalizationOpPattern(RewritePatternSet &patterns,
     TypeConverter &typeConverter, MLIRContext *ctx) {
   patterns.insert<ONNXBatchNormalizationInferenceModeOpLowering>(
       typeConverter, ctx);
   patterns.insert<ONNXInstanceNormalizationOpLowering>(typeConverter, ctx);
+  patterns.insert<ONNXLayerNormalizationOpLowering>(typeConverter, ctx);
 }
 
 } // namespace onnx_mlir
@@ -12,6 +12,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+
 #include "src/Conversion/ONNXToKrnl/ONNXToKrnlCommon.hpp"
 #include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
 
@@ -192,6 +194,180 @@ void postProcessPoolingWindow<ONNXAveragePoolOp>(
   create.krnl.store(average, alloc, resultIndices);
 }
 
+//===----------------------------------------------------------------------===//
+// Fast path for full-window pooling.
+//
+// Without padding, dilation and ceil rounding, every pooling window is a full
+// kernel window whose bounds are compile-time constants: the per-pixel affine
+// maps that clip the window over the border edges and the runtime window-size
+// division for AveragePool are unnecessary. The window loops then have
+// constant trip counts and the innermost kernel dimension, which reads
+// contiguous input pixels, is vectorized when it is a multiple of the machine
+// vector length, with a single horizontal reduction per output pixel.
+//===----------------------------------------------------------------------===//
+
+// Combining kind for the horizontal reduction of the vector accumulator.
+template <typename PoolOp>
+vector::CombiningKind getCombiningKind() {
+  return vector::CombiningKind::ADD;
+}
+
+template <>
+vector::CombiningKind getCombiningKind<ONNXMaxPoolSingleOutOp>() {
+  return vector::CombiningKind::MAXF;
+}
+
+// Scale the reduced window value: divide the window sum by the constant
+// window size for AveragePool, identity for MaxPool. The fast path requires
+// zero padding, so every window is full and count_include_pad has no effect.
+template <typename PoolOp>
+Value scaleReducedWindowValue(ConversionPatternRewriter &rewriter, Location loc,
+    Value reduced, int64_t kernelSize) {
+  return reduced;
+}
+
+template <>
+Value scaleReducedWindowValue<ONNXAveragePoolOp>(
+    ConversionPatternRewriter &rewriter, Location loc, Value reduced,
+    int64_t kernelSize) {
+  MathBuilder createMath(rewriter, loc);
+  Value denominator = createMath.constant(reduced.getType(), kernelSize);
+  return createMath.div(reduced, denominator);
+}
+
+template <typename PoolOp>
+static bool tryFullWindowPooling(ConversionPatternRewriter &rewriter,
+    Location loc, Operation *op, Value inputOperand, Value alloc,
+    ArrayRef<IndexExpr> kernelShape, ArrayRef<IndexExpr> pads,
+    ArrayRef<int64_t> strides, int64_t kernelOffset, bool isDilated,
+    int64_t ceilMode) {
+  // Only windows that never slice over the border edges qualify.
+  if (isDilated || ceilMode != 0)
+    return false;
+  for (IndexExpr pad : pads)
+    if (!pad.isLiteral() || pad.getLiteral() != 0)
+      return false;
+  SmallVector<int64_t, 2> kernelLits;
+  for (IndexExpr kernelDim : kernelShape) {
+    if (!kernelDim.isLiteral())
+      return false;
+    kernelLits.emplace_back(kernelDim.getLiteral());
+  }
+  int64_t kernelRank = kernelLits.size();
+  int64_t kernelSize = 1;
+  for (int64_t kernelDim : kernelLits)
+    kernelSize *= kernelDim;
+
+  MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl, MemRefBuilder,
+      MathBuilder, VectorBuilder>
+      create(rewriter, loc);
+  MemRefType inputMemRefType = inputOperand.getType().cast<MemRefType>();
+  MemRefType outputMemRefType = alloc.getType().cast<MemRefType>();
+  Type elementType = outputMemRefType.getElementType();
+  int64_t outputRank = outputMemRefType.getRank();
+
+  // Vectorize the innermost kernel dimension when the window rows read
+  // contiguous input pixels and are a whole number of vectors long.
+  int64_t VL = 0;
+  if (elementType.isa<FloatType>() &&
+      inputMemRefType.getLayout().isIdentity()) {
+    int64_t machineVL = create.vec.getMachineVectorLength(elementType);
+    if (machineVL > 1 && kernelLits[kernelRank - 1] % machineVL == 0)
+      VL = machineVL;
+  }
+  VectorType accVecType =
+      (VL > 0) ? VectorType::get({VL}, elementType) : VectorType();
+
+  // Identity value of the operation and a local reduction buffer, a vector
+  // of partial reductions when vectorizing and a single scalar otherwise.
+  Value identity = getIdentityValue<PoolOp>(rewriter, loc, elementType);
+  MemRefType accType = (VL > 0) ? MemRefType::get({VL}, elementType)
+                                : MemRefType::get({}, elementType);
+  Value reductionVal = create.mem.alloca(accType);
+  Value zeroIndex = (VL > 0) ? create.math.constantIndex(0) : Value();
+
+  // 1. Define output loops to compute one output pixel.
+  ValueRange calcLoopDef = create.krnl.defineLoops(outputRank);
+  SmallVector<IndexExpr, 4> lbs(outputRank, LiteralIndexExpr(0));
+  SmallVector<IndexExpr, 4> ubs;
+  create.krnlIE.getShapeAsDims(alloc, ubs);
+  create.krnl.iterateIE(calcLoopDef, calcLoopDef, lbs, ubs,
+      [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+        MultiDialectBuilder<KrnlBuilder, MathBuilder, VectorBuilder> create(
+            createKrnl);
+        SmallVector<IndexExpr, 4> outputIndices;
+        for (int64_t i = 0; i < outputRank; ++i)
+          outputIndices.emplace_back(DimIndexExpr(loopInd[i]));
+
+        // 2. Seed the reduction buffer with the identity value.
+        if (VL > 0)
+          create.vec.store(create.vec.broadcast(accVecType, identity),
+              reductionVal, {zeroIndex});
+        else
+          create.krnl.store(identity, reductionVal);
+
+        // 3. Window loops with constant trip counts; the innermost one is
+        // blocked by the vector length when vectorizing.
+        ValueRange windowLoopDef = create.krnl.defineLoops(kernelRank);
+        SmallVector<IndexExpr, 2> windowLbs(kernelRank, LiteralIndexExpr(0));
+        SmallVector<IndexExpr, 2> windowUbs;
+        for (int64_t kernelDim : kernelLits)
+          windowUbs.emplace_back(LiteralIndexExpr(kernelDim));
+        SmallVector<Value, 2> optimizedWindowLoopDef(
+            windowLoopDef.begin(), windowLoopDef.end());
+        if (VL > 0) {
+          ValueRange blockedLoopDef =
+              create.krnl.block(windowLoopDef[kernelRank - 1], VL);
+          optimizedWindowLoopDef[kernelRank - 1] = blockedLoopDef[0];
+        }
+        create.krnl.iterateIE(windowLoopDef, optimizedWindowLoopDef, windowLbs,
+            windowUbs, [&](KrnlBuilder &createKrnl, ValueRange windowLoopInd) {
+              MultiDialectBuilder<KrnlBuilder, VectorBuilder> create(
+                  createKrnl);
+              // input[n, c, ho * sH + hw, wo * sW + ww]
+              SmallVector<IndexExpr, 4> inputIndices;
+              for (int64_t i = 0; i < kernelOffset; ++i)
+                inputIndices.emplace_back(outputIndices[i]);
+              for (int64_t i = 0; i < kernelRank; ++i)
+                inputIndices.emplace_back(outputIndices[kernelOffset + i] *
+                                              LiteralIndexExpr(strides[i]) +
+                                          DimIndexExpr(windowLoopInd[i]));
+              if (VL > 0) {
+                Value loadInput =
+                    create.vec.loadIE(accVecType, inputOperand, inputIndices,
+                        /*offsets=*/{});
+                Value loadAcc =
+                    create.vec.load(accVecType, reductionVal, {zeroIndex});
+                Value accumulated = emitScalarOpFor<PoolOp>(
+                    rewriter, loc, op, accVecType, {loadAcc, loadInput});
+                create.vec.store(accumulated, reductionVal, {zeroIndex});
+              } else {
+                Value loadInput =
+                    create.krnl.loadIE(inputOperand, inputIndices);
+                Value loadAcc = create.krnl.load(reductionVal);
+                Value accumulated = emitScalarOpFor<PoolOp>(
+                    rewriter, loc, op, elementType, {loadAcc, loadInput});
+                create.krnl.store(accumulated, reductionVal);
+              }
+            });
+
+        // 4. Fold the partial reductions and post-process the window value.
+        Value reduced;
+        if (VL > 0) {
+          Value accVec =
+              create.vec.load(accVecType, reductionVal, {zeroIndex});
+          reduced = rewriter.create<vector::ReductionOp>(
+              loc, getCombiningKind<PoolOp>(), accVec);
+        } else {
+          reduced = create.krnl.load(reductionVal);
+        }
+        reduced = scaleReducedWindowValue<PoolOp>(
+            rewriter, loc, reduced, kernelSize);
+        create.krnl.storeIE(reduced, alloc, outputIndices);
+      });
+  return true;
+}
+
 //===----------------------------------------------------------------------===//
 // Template function that does pooling.
 //
@@ -243,6 +419,15 @@ struct ONNXPoolOpLowering : public ConversionPattern {
     Value alloc = insertAllocAndDeallocSimple(
         rewriter, op, memRefType, loc, shapeHelper.getOutputDims());
 
+    // Fast path: with no padding, dilation or ceil rounding, every pooling
+    // window is a full kernel window with constant bounds.
+    if (tryFullWindowPooling<PoolOp>(rewriter, loc, op, inputOperand, alloc,
+            shapeHelper.kernelShape, shapeHelper.pads, shapeHelper.strides,
+            kernelOffset, isDilated, ceilMode)) {
+      rewriter.replaceOp(op, alloc);
+      return success();
+    }
+
     // input = Pool(output)
     //
     // The input/output shapes will look like this:
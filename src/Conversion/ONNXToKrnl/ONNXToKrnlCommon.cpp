@@ -397,12 +397,18 @@ std::vector<Value> foldOrEmitONNXSplitOp(ConversionPatternRewriter &rewriter,
   auto inputShape = inputType.getShape();
   Type elementType = inputType.getElementType();
 
-  // Compute split offsets.
+  // Compute split sizes from the result types, and split offsets from the
+  // sizes. Sizes need not be even.
+  SmallVector<int64_t, 4> splitSizes;
   SmallVector<int64_t, 4> splitOffsets;
+  bool isEvenSplit = true;
   int64_t offset = 0;
   for (int i = 0; i < outputNum; ++i) {
+    int64_t size = resultTypes[i].cast<ShapedType>().getShape()[axis];
+    splitSizes.emplace_back(size);
     splitOffsets.emplace_back(offset);
-    offset += inputShape[axis] / outputNum;
+    offset += size;
+    isEvenSplit &= (size == inputShape[axis] / outputNum);
   }
 
   if (krnl::isKrnlGlobalConstant(input) || isDenseONNXConstant(input)) {
@@ -412,9 +418,9 @@ std::vector<Value> foldOrEmitONNXSplitOp(ConversionPatternRewriter &rewriter,
             .dyn_cast_or_null<mlir::DenseElementsAttr>());
 
     std::vector<char *> resBuffers;
-    ConstPropSplitImpl(elementType, inputBuffer, inputShape,
-        /*splitAxis=*/axis, /*splitOffsets=*/splitOffsets, resultTypes,
-        resBuffers);
+    ConstPropSplitImpl(rewriter.getContext(), elementType, inputBuffer,
+        inputShape, /*splitAxis=*/axis, /*splitOffsets=*/splitOffsets,
+        resultTypes, resBuffers);
 
     for (int i = 0; i < outputNum; ++i) {
       char *outputBuffer =
@@ -429,9 +435,13 @@ std::vector<Value> foldOrEmitONNXSplitOp(ConversionPatternRewriter &rewriter,
     }
     free(inputBuffer);
   } else {
+    // Only emit the split attribute when sizes are uneven to keep the even
+    // case's output unchanged.
+    ArrayAttr splitAttr =
+        isEvenSplit ? nullptr : rewriter.getI64ArrayAttr(splitSizes);
     ONNXSplitV11Op split = rewriter.create<ONNXSplitV11Op>(loc, convertedTypes,
         create.onnx.toTensor(input),
-        /*axis=*/axis, nullptr);
+        /*axis=*/axis, splitAttr);
     for (int i = 0; i < outputNum; ++i)
       resVals.emplace_back(create.onnx.toMemref(split.outputs()[i]));
   }
@@ -460,8 +470,8 @@ Value foldOrEmitONNXTransposeOp(ConversionPatternRewriter &rewriter,
             .dyn_cast_or_null<mlir::DenseElementsAttr>());
 
     char *resBuffer = allocateBufferFor(resultType, /*useMaxSize=*/true);
-    ConstPropTransposeImpl(
-        elementType, inputBuffer, inputShape, perm, resultShape, resBuffer);
+    ConstPropTransposeImpl(rewriter.getContext(), elementType, inputBuffer,
+        inputShape, perm, resultShape, resBuffer);
     char *outputBuffer = allocateBufferFor(resultType, /*useMaxSize=*/false);
     convertDoubleInt64ToExactType(resultType, resBuffer, outputBuffer);
     Value constVal =
@@ -579,9 +589,205 @@ Value emitArgSort(ConversionPatternRewriter &rewriter, Location loc,
   return order;
 }
 
+/// Emit krnl.call to the omTensorTopK runtime to compute only the top-k
+/// indices of a given MemRef along a given axis. Returns nullptr when the
+/// runtime path does not apply; callers then fall back to emitArgSort.
+Value emitArgTopK(ConversionPatternRewriter &rewriter, Location loc,
+    Value input, Value kTensor, DimsExpr &topkDims, int64_t axis,
+    bool ascending) {
+  MemRefType inputMemRefType = input.getType().cast<MemRefType>();
+  int64_t rank = inputMemRefType.getRank();
+  assert(axis >= 0 && axis < rank && "axis is out of bound");
+  // Same layout restrictions as the omTensorSort path in emitArgSort.
+  if ((rank > 6) || (axis != rank - 1))
+    return nullptr;
+
+  MultiDialectBuilder<KrnlBuilder, MathBuilder> create(rewriter, loc);
+  Type indexType = rewriter.getIndexType();
+
+  // The result has the input's shape except that the axis dimension is k.
+  SmallVector<int64_t, 6> orderShape(
+      inputMemRefType.getShape().begin(), inputMemRefType.getShape().end());
+  orderShape[axis] =
+      topkDims[axis].isLiteral() ? topkDims[axis].getLiteral() : -1;
+  Value order = insertAllocAndDeallocSimple(rewriter, nullptr,
+      MemRefType::get(orderShape, indexType), loc, topkDims,
+      /*insertDealloc=*/true);
+
+  // Emit krnl.Call to call omTensorTopK API.
+  Type intType = rewriter.getIntegerType(64);
+  Value valAxis = create.math.constant(intType, axis);
+  Value valAscending = create.math.constant(intType, (int64_t)ascending);
+  Value zero = create.math.constantIndex(0);
+  Value valK = create.krnl.load(kTensor, {zero});
+  SmallVector<Value, 4> operands = {input, valAxis, valAscending, valK};
+  rewriter.create<KrnlCallOp>(loc, "omTensorTopK", order, operands);
+  return order;
+}
+
 /// Return a DenseElementAttr of a KrnlGlobalOp or ONNXConstantOp.
 /// This function satisfies the ArrayValueIndexCapture::DenseElementsAttr
 /// lambda type, using ONNX and Krnl operations.
+/// Emit a float round-to-nearest, ties-to-even, the rounding mode mandated by
+/// the ONNX quantization operators and by ONNXRoundOp.
+/// Use numpy algorithm for rint as follows.
+/// ```
+/// double y, r;
+/// y = npy_floor(x);
+/// r = x - y;
+///
+/// if (r > 0.5) {
+///     y += 1.0;
+/// }
+///
+/// /* Round to nearest even */
+/// if (r == 0.5) {
+///     r = y - 2.0*npy_floor(0.5*y);
+///     if (r == 1.0) {
+///         y += 1.0;
+///     }
+/// }
+/// return y;
+/// ```
+/// Check whether the profile annotation pass marked this op as a measured
+/// hot spot.
+bool opIsProfileHot(Operation *op) { return op->hasAttr("profile_hot"); }
+
+/// Accumulation type requested by the accum annotation pass, or null.
+Type getRequestedAccumType(Operation *op, Type elementType) {
+  if (!elementType.isa<FloatType>())
+    return nullptr;
+  StringAttr accum = op->getAttrOfType<StringAttr>("accum_type");
+  if (!accum)
+    return nullptr;
+  MLIRContext *ctx = op->getContext();
+  if (accum.getValue().equals("f16"))
+    return FloatType::getF16(ctx);
+  if (accum.getValue().equals("bf16"))
+    return FloatType::getBF16(ctx);
+  if (accum.getValue().equals("f32"))
+    return FloatType::getF32(ctx);
+  if (accum.getValue().equals("f64"))
+    return FloatType::getF64(ctx);
+  return nullptr;
+}
+
+Value applyFusedActivation(ConversionPatternRewriter &rewriter, Location loc,
+    Operation *op, Value value) {
+  StringAttr activation = op->getAttrOfType<StringAttr>(FUSED_ACTIVATION_ATTR);
+  if (!activation)
+    return value;
+  // `value` may be a scalar or, in simdized lowerings, a vector; the compare
+  // and select below are elementwise either way, only the constants need to
+  // be splatted.
+  Type valueType = value.getType();
+  auto vecType = valueType.dyn_cast<VectorType>();
+  Type elementType = vecType ? vecType.getElementType() : valueType;
+  MathBuilder createMath(rewriter, loc);
+  VectorBuilder createVec(rewriter, loc);
+  auto getConstant = [&](double val) -> Value {
+    Value cst = createMath.constant(elementType, val);
+    return vecType ? createVec.broadcast(vecType, cst) : cst;
+  };
+  Value zero = getConstant(0);
+  if (activation.getValue().equals("Relu")) {
+    Value geZero = createMath.sge(value, zero);
+    return createMath.select(geZero, value, zero);
+  }
+  if (activation.getValue().equals("LeakyRelu")) {
+    auto alphaAttr = op->getAttrOfType<FloatAttr>(FUSED_ACTIVATION_ALPHA_ATTR);
+    // 0.01 is the ONNX default when LeakyRelu carries no alpha attribute.
+    double alphaLit = alphaAttr ? alphaAttr.getValueAsDouble() : 0.01;
+    Value alpha = getConstant(alphaLit);
+    Value geZero = createMath.sge(value, zero);
+    return createMath.select(geZero, value, createMath.mul(alpha, value));
+  }
+  if (activation.getValue().equals("Clip")) {
+    // Either bound may be absent; the fusion pass records only the ones the
+    // original Clip carried.
+    Value res = value;
+    if (auto minAttr = op->getAttrOfType<FloatAttr>(FUSED_ACTIVATION_MIN_ATTR))
+      res = createMath.max(res, getConstant(minAttr.getValueAsDouble()));
+    if (auto maxAttr = op->getAttrOfType<FloatAttr>(FUSED_ACTIVATION_MAX_ATTR))
+      res = createMath.min(res, getConstant(maxAttr.getValueAsDouble()));
+    return res;
+  }
+  llvm_unreachable("unexpected fused activation");
+}
+
+Value emitRoundHalfToEven(
+    ConversionPatternRewriter &rewriter, Location loc, Value input) {
+  Type elementType = input.getType();
+  assert(elementType.isa<FloatType>() && "expected float input");
+  MathBuilder createMath(rewriter, loc);
+  Value one = createMath.constant(elementType, 1.0);
+  Value two = createMath.constant(elementType, 2.0);
+  Value half = createMath.constant(elementType, 0.5);
+  Value y = rewriter.create<math::FloorOp>(loc, input);
+  Value r = createMath.sub(input, y);
+
+  // r > 0.5
+  Value rGreaterThanHalf =
+      rewriter.create<arith::CmpFOp>(loc, arith::CmpFPredicate::OGT, r, half);
+  Value y1 = createMath.select(rGreaterThanHalf, createMath.add(y, one), y);
+
+  // r == 0.5: round to nearest even.
+  Value y2 = createMath.mul(half, y);
+  y2 = rewriter.create<math::FloorOp>(loc, y2);
+  y2 = createMath.mul(y2, two);
+  Value rr = createMath.sub(y, y2);
+  Value rrEqualOne =
+      rewriter.create<arith::CmpFOp>(loc, arith::CmpFPredicate::OEQ, rr, one);
+  y2 = createMath.select(rrEqualOne, createMath.add(y, one), y);
+
+  Value rEqualHalf =
+      rewriter.create<arith::CmpFOp>(loc, arith::CmpFPredicate::OEQ, r, half);
+  return createMath.select(rEqualHalf, y2, y1);
+}
+
+/// Clamp an i32 value to the representable range of the given quantized
+/// element type (i8 or ui8) and cast it into that type.
+Value emitSaturatedCast(ConversionPatternRewriter &rewriter, Location loc,
+    Value input, Type quantizedType) {
+  MathBuilder createMath(rewriter, loc);
+  Type i32Type = rewriter.getI32Type();
+  assert(input.getType() == i32Type && "expected i32 input");
+  IntegerType intType = quantizedType.cast<IntegerType>();
+  int64_t width = intType.getWidth();
+  int64_t qMin = intType.isUnsignedInteger() ? 0 : -(1 << (width - 1));
+  int64_t qMax =
+      intType.isUnsignedInteger() ? (1 << width) - 1 : (1 << (width - 1)) - 1;
+  Value clamped = createMath.min(
+      createMath.max(input, createMath.constant(i32Type, qMin)),
+      createMath.constant(i32Type, qMax));
+  return createMath.cast(quantizedType, clamped);
+}
+
+/// Load a per-tensor quantization parameter (scale or zero point) held in a
+/// rank-0 or single-element rank-1 tensor.
+Value loadScalarQuantParameter(
+    ConversionPatternRewriter &rewriter, Location loc, Value param) {
+  MultiDialectBuilder<KrnlBuilder, MathBuilder> create(rewriter, loc);
+  if (param.getType().cast<MemRefType>().getRank() == 0)
+    return create.krnl.load(param);
+  return create.krnl.load(param, {create.math.constantIndex(0)});
+}
+
+/// Requantize an i32 accumulator: scale it by the combined float scale, round
+/// to nearest even, add the output zero point, and saturate into the
+/// quantized element type. This is the common epilogue of the QLinear ops.
+Value emitRequantize(ConversionPatternRewriter &rewriter, Location loc,
+    Value accumulator, Value combinedScale, Value zeroPoint,
+    Type quantizedType) {
+  MathBuilder createMath(rewriter, loc);
+  Value accFloat = createMath.cast(combinedScale.getType(), accumulator);
+  Value scaled = createMath.mul(accFloat, combinedScale);
+  Value rounded = emitRoundHalfToEven(rewriter, loc, scaled);
+  Value shifted = createMath.add(
+      createMath.cast(rewriter.getI32Type(), rounded), zeroPoint);
+  return emitSaturatedCast(rewriter, loc, shifted, quantizedType);
+}
+
 DenseElementsAttr getDenseElementAttributeFromConstantValue(Value value) {
   auto definingOp = value.getDefiningOp();
   if (auto globalOp = dyn_cast_or_null<mlir::KrnlGlobalOp>(definingOp)) {
@@ -595,6 +801,98 @@ DenseElementsAttr getDenseElementAttributeFromConstantValue(Value value) {
   return nullptr;
 }
 
+Value emitPrepackedMatMulWeight(ConversionPatternRewriter &rewriter,
+    Location loc, Value B, bool transposed, int64_t K, int64_t J,
+    int64_t kTile, int64_t jTile) {
+  DenseElementsAttr dense = getDenseElementAttributeFromConstantValue(B);
+  if (!dense)
+    return nullptr;
+  auto denseType = dense.getType().dyn_cast<RankedTensorType>();
+  if (!denseType || denseType.getRank() != 2)
+    return nullptr;
+  int64_t rows = transposed ? J : K;
+  int64_t cols = transposed ? K : J;
+  if (denseType.getShape()[0] != rows || denseType.getShape()[1] != cols)
+    return nullptr;
+  Type elementType = denseType.getElementType();
+  int64_t kTiles = (K + kTile - 1) / kTile;
+  int64_t jTiles = (J + jTile - 1) / jTile;
+  int64_t numElements = kTiles * jTiles * kTile * jTile;
+  // Position of element (k, j) of the untransposed B in the packed layout
+  // and in the linearized source attribute.
+  auto packedPos = [&](int64_t k, int64_t j) {
+    return (((k / kTile) * jTiles + j / jTile) * kTile + k % kTile) * jTile +
+           j % jTile;
+  };
+  auto sourcePos = [&](int64_t k, int64_t j) {
+    return transposed ? j * K + k : k * J + j;
+  };
+  RankedTensorType packedType =
+      RankedTensorType::get({kTiles, jTiles, kTile, jTile}, elementType);
+  DenseElementsAttr packedAttr;
+  if (auto floatType = elementType.dyn_cast<FloatType>()) {
+    SmallVector<llvm::APFloat> packed(
+        numElements, llvm::APFloat::getZero(floatType.getFloatSemantics()));
+    auto values = dense.value_begin<llvm::APFloat>();
+    for (int64_t k = 0; k < K; ++k)
+      for (int64_t j = 0; j < J; ++j)
+        packed[packedPos(k, j)] = *(values + sourcePos(k, j));
+    packedAttr = DenseElementsAttr::get(packedType, packed);
+  } else if (auto intType = elementType.dyn_cast<IntegerType>()) {
+    SmallVector<llvm::APInt> packed(
+        numElements, llvm::APInt(intType.getWidth(), 0));
+    auto values = dense.value_begin<llvm::APInt>();
+    for (int64_t k = 0; k < K; ++k)
+      for (int64_t j = 0; j < J; ++j)
+        packed[packedPos(k, j)] = *(values + sourcePos(k, j));
+    packedAttr = DenseElementsAttr::get(packedType, packed);
+  } else
+    return nullptr;
+  MemRefType packedMemRefType =
+      MemRefType::get({kTiles, jTiles, kTile, jTile}, elementType);
+  KrnlBuilder createKrnl(rewriter, loc);
+  return createKrnl.constant(packedMemRefType, "prepacked_weight", packedAttr);
+}
+
+// Read one entry of an onnx.dim_ub / onnx.dim_mult argument attribute
+// recorded by the importer from the user shape contracts. Returns the given
+// default when value is not an entry function argument or carries no
+// contract.
+static int64_t getContractDimValue(
+    Value value, int64_t dimIndex, StringRef attrName, int64_t defaultValue) {
+  auto blockArg = value.dyn_cast<BlockArgument>();
+  if (!blockArg)
+    return defaultValue;
+  auto funcOp =
+      dyn_cast_or_null<func::FuncOp>(blockArg.getOwner()->getParentOp());
+  if (!funcOp || blockArg.getOwner() != &funcOp.getBody().front())
+    return defaultValue;
+  auto arrayAttr =
+      funcOp.getArgAttrOfType<ArrayAttr>(blockArg.getArgNumber(), attrName);
+  if (!arrayAttr || dimIndex < 0 || dimIndex >= (int64_t)arrayAttr.size())
+    return defaultValue;
+  auto intAttr = arrayAttr[dimIndex].dyn_cast<IntegerAttr>();
+  return intAttr ? intAttr.getInt() : defaultValue;
+}
+
+int64_t getContractDimUpperBound(Value value, int64_t dimIndex) {
+  return getContractDimValue(value, dimIndex, "onnx.dim_ub", -1);
+}
+
+int64_t getContractDimMultiple(Value value, int64_t dimIndex) {
+  int64_t multiple = getContractDimValue(value, dimIndex, "onnx.dim_mult", 1);
+  return multiple > 0 ? multiple : 1;
+}
+
+SmallVector<Value, 4> getPrepackedMatMulWeightStarts(KrnlBuilder &createKrnl,
+    Value k1, Value j1, int64_t kTile, int64_t jTile) {
+  IndexExprScope scope(createKrnl);
+  DimIndexExpr kIdx(k1), jIdx(j1);
+  Value kTileIdx = kIdx.floorDiv(LiteralIndexExpr(kTile)).getValue();
+  Value jTileIdx = jIdx.floorDiv(LiteralIndexExpr(jTile)).getValue();
+  return {kTileIdx, jTileIdx, k1, j1};
+}
+
 /// This function returns a scalar of type 'dtype' from an optional value.
 /// Optional value must be: NoneType, memref<1xdtype> or memref<dtype>. Default
 /// value is used in case of NoneType.
@@ -159,7 +159,7 @@ mlir::Value foldOrEmitONNXUnsqueezeV11Op(
 
 /// Emit an ONNXSplitOp. If the input is constant, do const propagation, and
 /// return constants.
-/// Only support evenly splitting.
+/// Split sizes are derived from the result types and need not be even.
 std::vector<mlir::Value> foldOrEmitONNXSplitOp(
     mlir::ConversionPatternRewriter &rewriter, mlir::Location loc,
     llvm::ArrayRef<mlir::Type> resultTypes, mlir::Value input, int64_t axis);
@@ -183,12 +183,92 @@ mlir::Value emitArgSort(mlir::ConversionPatternRewriter &rewriter,
     mlir::Location loc, mlir::Value input, int64_t axis,
     bool ascending = false);
 
+/// Emit krnl.call to the omTensorTopK runtime to compute only the top-k
+/// indices of a given MemRef along a given axis, avoiding a full argsort
+/// when k is small. 'kTensor' is the TopK K input (a one-element i64 MemRef)
+/// and 'topkDims' the output dims, whose axis entry is k. The result MemRef
+/// has the input's shape with k along the axis and is of IndexType. Returns
+/// nullptr when the runtime path does not apply (rank > 6 or the axis is not
+/// the innermost dimension); callers then fall back to emitArgSort.
+mlir::Value emitArgTopK(mlir::ConversionPatternRewriter &rewriter,
+    mlir::Location loc, mlir::Value input, mlir::Value kTensor,
+    DimsExpr &topkDims, int64_t axis, bool ascending);
+
+/// Check whether the profile annotation pass marked this op as a measured
+/// hot spot; such ops get aggressive lowering strategies regardless of the
+/// optimization level.
+bool opIsProfileHot(mlir::Operation *op);
+
+/// Accumulation type the accum annotation pass requested for this op (the
+/// accum_type attribute), or null when none was requested or the request
+/// does not apply: only float accumulation over float data is supported.
+mlir::Type getRequestedAccumType(mlir::Operation *op, mlir::Type elementType);
+
+/// Apply the activation that the ONNX fusion pass recorded on this op (the
+/// fused_activation attribute) to one output scalar, right before its final
+/// write-back. Returns the value unchanged when no activation was recorded.
+mlir::Value applyFusedActivation(mlir::ConversionPatternRewriter &rewriter,
+    mlir::Location loc, mlir::Operation *op, mlir::Value value);
+
+/// Emit a float round-to-nearest, ties-to-even, the rounding mode mandated by
+/// the ONNX quantization operators and by ONNXRoundOp.
+mlir::Value emitRoundHalfToEven(mlir::ConversionPatternRewriter &rewriter,
+    mlir::Location loc, mlir::Value input);
+
+/// Clamp an i32 value to the representable range of the given quantized
+/// element type (i8 or ui8) and cast it into that type.
+mlir::Value emitSaturatedCast(mlir::ConversionPatternRewriter &rewriter,
+    mlir::Location loc, mlir::Value input, mlir::Type quantizedType);
+
+/// Load a per-tensor quantization parameter (scale or zero point) held in a
+/// rank-0 or single-element rank-1 tensor.
+mlir::Value loadScalarQuantParameter(mlir::ConversionPatternRewriter &rewriter,
+    mlir::Location loc, mlir::Value param);
+
+/// Requantize an i32 accumulator: scale it by the combined float scale, round
+/// to nearest even, add the output zero point, and saturate into the
+/// quantized element type. This is the common epilogue of the QLinear ops.
+mlir::Value emitRequantize(mlir::ConversionPatternRewriter &rewriter,
+    mlir::Location loc, mlir::Value accumulator, mlir::Value combinedScale,
+    mlir::Value zeroPoint, mlir::Type quantizedType);
+
 /// Return a DenseElementAttr of a KrnlGlobalOp or ONNXConstantOp.
 /// This function satisfies the ArrayValueIndexCapture::DenseElementsAttr
 /// lambda type, using ONNX and Krnl operations.
 mlir::DenseElementsAttr getDenseElementAttributeFromConstantValue(
     mlir::Value value);
 
+/// When `B` is a compile-time constant 2-D matrix of KxJ (a KrnlGlobalOp or
+/// ONNXConstantOp, typically weights), emit a krnl.global that holds B
+/// pre-packed into the [K tiles][J tiles][kTile][jTile] layout that the
+/// cache-blocked matmul schedules otherwise rebuild with copy-to-buffer
+/// operations on every inference. `transposed` indicates that B is stored
+/// as JxK (Gemm transB); the packed layout is always untransposed, so the
+/// runtime transpose disappears as well. Partial boundary tiles are zero
+/// padded, matching the zero pad value of the runtime copy. Returns nullptr
+/// when B is not a foldable constant.
+mlir::Value emitPrepackedMatMulWeight(
+    mlir::ConversionPatternRewriter &rewriter, mlir::Location loc,
+    mlir::Value B, bool transposed, int64_t K, int64_t J, int64_t kTile,
+    int64_t jTile);
+
+/// Global-index memory starts for a weight created by
+/// emitPrepackedMatMulWeight, for use as the B operand of krnl.matmul: the
+/// leading indices select the packed tile whose origin in the original
+/// matrix is (k1, j1).
+llvm::SmallVector<mlir::Value, 4> getPrepackedMatMulWeightStarts(
+    KrnlBuilder &createKrnl, mlir::Value k1, mlir::Value j1, int64_t kTile,
+    int64_t jTile);
+
+/// Shape contracts (--shapeContracts) are invariants the caller guarantees
+/// for dynamic input dimensions; the importer records them as onnx.dim_ub
+/// and onnx.dim_mult argument attributes on the entry function. When `value`
+/// is (a view of) such an argument, these return the promised upper bound
+/// (-1 when nothing is promised) resp. a value the dimension is always
+/// divisible by (1 when nothing is promised) for dimension `dimIndex`.
+int64_t getContractDimUpperBound(mlir::Value value, int64_t dimIndex);
+int64_t getContractDimMultiple(mlir::Value value, int64_t dimIndex);
+
 //===----------------------------------------------------------------------===//
 // This is to get a scalar operation of a given type for a specific operation.
 //===----------------------------------------------------------------------===//
@@ -221,10 +301,15 @@ template <typename Op>
 mlir::Value emitScalarOpFor(mlir::ConversionPatternRewriter &rewriter,
     mlir::Location loc, mlir::Operation *op, mlir::Type elementType,
     llvm::ArrayRef<mlir::Value> scalarOperands) {
-  if (elementType.isa<mlir::IntegerType>()) {
+  // Dispatch on the elementary type so that the vector compute types passed
+  // by the SIMD paths pick the same arith op as their scalar counterpart.
+  mlir::Type scalarType = elementType;
+  if (auto vectorType = elementType.dyn_cast<mlir::VectorType>())
+    scalarType = vectorType.getElementType();
+  if (scalarType.isa<mlir::IntegerType>()) {
     return rewriter.create<ScalarIOp<Op>>(
         loc, elementType, scalarOperands, mlir::None);
-  } else if (elementType.isa<mlir::FloatType>()) {
+  } else if (scalarType.isa<mlir::FloatType>()) {
     return rewriter.create<ScalarFOp<Op>>(
         loc, elementType, scalarOperands, mlir::None);
   } else {
@@ -271,23 +356,28 @@ public:
 
 // For all ONNX operations.
 void populateONNXToKrnlConversionPattern(mlir::RewritePatternSet &,
-    mlir::TypeConverter &, mlir::MLIRContext *, bool enableTiling);
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableTiling,
+    bool enableParallel, bool enableFastElementwise, bool enableFastConv,
+    bool enableFusedAttention, float sparseWeightDensity,
+    int64_t l2ResidentCores);
 
 // `ControlFlow` directory methods:
 void populateLoweringONNXIfOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
-void populateLoweringONNXLoopOpPattern(
-    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXLoopOpPattern(mlir::RewritePatternSet &,
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableParallel);
 void populateLoweringONNXScanOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 
 // `Math` directory methods:
+void populateLoweringONNXAttentionOpPattern(
+    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXClipOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXCumSumOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
-void populateLoweringONNXElementwiseOpPattern(
-    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXElementwiseOpPattern(mlir::RewritePatternSet &,
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableFastElementwise);
 void populateLoweringONNXGemmOpPattern(mlir::RewritePatternSet &,
     mlir::TypeConverter &, mlir::MLIRContext *, bool enableTiling);
 void populateLoweringONNXHardmaxOpPattern(
@@ -295,7 +385,9 @@ void populateLoweringONNXHardmaxOpPattern(
 void populateLoweringONNXLRNOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXMatMulOpPattern(mlir::RewritePatternSet &,
-    mlir::TypeConverter &, mlir::MLIRContext *, bool enableTiling);
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableTiling,
+    float sparseWeightDensity = 0.0f, bool enableParallel = false,
+    int64_t l2ResidentCores = 0);
 void populateLoweringONNXRandomNormalOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXRandomNormalLikeOpPattern(
@@ -313,15 +405,26 @@ void populateLoweringONNXCategoryMapperOpPattern(
 
 // `NN` directory methods:
 void populateLoweringONNXConvOpPattern(mlir::RewritePatternSet &,
-    mlir::TypeConverter &, mlir::MLIRContext *, bool enableTiling);
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableParallel,
+    bool enableFastConv);
+void populateLoweringONNXConvTransposeOpPattern(
+    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXNormalizationOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXPoolingOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 
 // `ObjectDetection` directory methods:
-void populateLoweringONNXNonMaxSuppressionOpPattern(
+void populateLoweringONNXNonMaxSuppressionOpPattern(mlir::RewritePatternSet &,
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableParallel);
+
+// `Quantization` directory methods:
+void populateLoweringONNXDynamicQuantizeLinearOpPattern(
+    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXQLinearConvOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXQLinearMatMulOpPattern(mlir::RewritePatternSet &,
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableTiling);
 
 // `RNN` directory methods:
 void populateLoweringONNXGRUOpPattern(
@@ -344,8 +447,8 @@ void populateLoweringONNXSequenceLengthOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 
 // `Tensor` directory methods:
-void populateLoweringONNXArgMinMaxOpPattern(
-    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXArgMinMaxOpPattern(mlir::RewritePatternSet &,
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableParallel);
 void populateLoweringONNXDimOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXUnsqueezeOpPattern(
@@ -354,12 +457,12 @@ void populateLoweringONNXUnsqueezeV11OpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXTransposeOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
-void populateLoweringONNXGatherOpPattern(
-    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXGatherOpPattern(mlir::RewritePatternSet &,
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableParallel);
 void populateLoweringONNXGatherElementsOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
-void populateLoweringONNXGatherNDOpPattern(
-    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXGatherNDOpPattern(mlir::RewritePatternSet &,
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableParallel);
 void populateLoweringONNXPadConstantValuePadOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXPadOpPattern(
@@ -378,14 +481,16 @@ void populateLoweringONNXConcatOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXConcatShapeTransposeOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXCustomOpPattern(
+    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXDepthToSpaceOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXSpaceToDepthOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXScatterElementsOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
-void populateLoweringONNXScatterNDOpPattern(
-    mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
+void populateLoweringONNXScatterNDOpPattern(mlir::RewritePatternSet &,
+    mlir::TypeConverter &, mlir::MLIRContext *, bool enableParallel);
 void populateLoweringONNXShapeOpPattern(
     mlir::RewritePatternSet &, mlir::TypeConverter &, mlir::MLIRContext *);
 void populateLoweringONNXSliceOpPattern(
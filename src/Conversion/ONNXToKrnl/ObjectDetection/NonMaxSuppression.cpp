@@ -206,9 +206,11 @@ static Value tryToUnflip(
 
 struct ONNXNonMaxSuppressionOpLowering : public ConversionPattern {
   ONNXNonMaxSuppressionOpLowering(
-      TypeConverter &typeConverter, MLIRContext *ctx)
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel)
       : ConversionPattern(typeConverter,
-            ONNXNonMaxSuppressionOp::getOperationName(), 1, ctx) {}
+            ONNXNonMaxSuppressionOp::getOperationName(), 1, ctx),
+        enableParallel(enableParallel) {}
+  bool enableParallel;
 
   /// To understand how code is generated for NonMaxSuppression, look at the
   /// python implementation at the end of this file.
@@ -268,7 +270,6 @@ struct ONNXNonMaxSuppressionOpLowering : public ConversionPattern {
     Value zero = create.math.constantIndex(0);
     Value one = create.math.constantIndex(1);
     Value two = create.math.constantIndex(2);
-    Value three = create.math.constantIndex(3);
     Value falseVal = create.math.constant(boolType, 0);
     Value trueVal = create.math.constant(boolType, 1);
 
@@ -312,26 +313,23 @@ struct ONNXNonMaxSuppressionOpLowering : public ConversionPattern {
     // Initialize with value -1.
     create.krnl.memset(selectedMemRef, create.math.constantIndex(-1));
 
-    // Effective number of selected indices. This is the final value for the 1st
-    // dim of the output, which is suppressed by IOU during computation and
-    // cannot be computed in advance.
-    // Final output shape : [effective_num_selected_indices, 3]
-    Value effectiveNumSelectedIndices =
-        create.mem.alloca(MemRefType::get({}, indexType));
-    create.krnl.store(zero, effectiveNumSelectedIndices, {});
-
     // Suppress by using IOU.
-    // Iterate over all bounding boxes in the descending order of scores.
-    Value effectiveMaxOutputPerClass =
-        create.mem.alloca(MemRefType::get({}, indexType));
+    // Each (batch, class) pair works on a private slice of selectedMemRef and
+    // on private scratch buffers, so the loop nest can be parallelized over
+    // batches and classes.
     ValueRange bcLoopDef = create.krnl.defineLoops(2);
+    if (enableParallel)
+      create.krnl.parallel(bcLoopDef);
     create.krnl.iterate(bcLoopDef, bcLoopDef, {zero, zero}, {bs, cs},
         [&](KrnlBuilder &createKrnl, ValueRange bcLoopInd) {
           MultiDialectBuilder<KrnlBuilder, MathBuilder, MemRefBuilder> create(
               createKrnl);
+          Value b(bcLoopInd[0]), c(bcLoopInd[1]);
           // Keep trace of the number of output boxes per class.
+          Value effectiveMaxOutputPerClass =
+              create.mem.alloca(MemRefType::get({}, indexType));
           create.krnl.store(zero, effectiveMaxOutputPerClass, {});
-          // Keep trace of removed indices per class.
+          // Keep trace of removed candidates per class.
           DimIndexExpr ssIE(ss);
           SmallVector<IndexExpr, 1> dims = {ssIE};
           SmallVector<int64_t, 1> shapes = {-1};
@@ -342,38 +340,71 @@ struct ONNXNonMaxSuppressionOpLowering : public ConversionPattern {
               /*insertDealloc=*/true);
           create.krnl.memset(removedIndices, falseVal);
 
-          // Iterate in the descending order of scores.
+          // Compact the sorted order into the list of candidate boxes whose
+          // score exceeds the score threshold. The suppression loops below
+          // then only iterate over candidates, which is much cheaper than the
+          // spatial size when a score threshold filters most boxes out.
+          Value candidates = insertAllocAndDeallocSimple(rewriter, nullptr,
+              MemRefType::get(shapes, indexType), loc, dims,
+              /*insertDealloc=*/true);
+          Value numCandidates =
+              create.mem.alloca(MemRefType::get({}, indexType));
+          create.krnl.store(zero, numCandidates, {});
+          ValueRange fLoopDef = create.krnl.defineLoops(1);
+          create.krnl.iterate(fLoopDef, fLoopDef, {zero}, {ss},
+              [&](KrnlBuilder &createKrnl, ValueRange fLoopInd) {
+                Value s(fLoopInd[0]);
+                MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                    createKrnl);
+
+                Value bi = create.krnl.load(order, {b, c, s});
+                Value score = create.krnl.load(scores, {b, c, bi});
+                // Only keep bounding boxes whose score > score_threshold.
+                Value checkScore = create.math.sgt(score, scoreTH);
+                auto ifOp = rewriter.create<scf::IfOp>(
+                    loc, checkScore, /*withElseRegion=*/false);
+                rewriter.setInsertionPointToStart(
+                    &ifOp.getThenRegion().front());
+
+                Value k = create.krnl.load(numCandidates, {});
+                create.krnl.store(bi, candidates, {k});
+                create.krnl.store(create.math.add(k, one), numCandidates, {});
+              });
+          Value nc = create.krnl.load(numCandidates, {});
+
+          // Where this class's outputs go in the over-allocated output.
+          // out_base = (b * class_size + c) * max_output_per_class
+          Value outBase = create.math.mul(
+              create.math.add(create.math.mul(b, cs), c), MOPC);
+
+          // Iterate over candidates in the descending order of scores.
           ValueRange sLoopDef = create.krnl.defineLoops(1);
-          create.krnl.iterate(sLoopDef, sLoopDef, {zero}, {ss},
+          create.krnl.iterate(sLoopDef, sLoopDef, {zero}, {nc},
               [&](KrnlBuilder &createKrnl, ValueRange sLoopInd) {
-                Value b(bcLoopInd[0]), c(bcLoopInd[1]), s(sLoopInd[0]);
+                Value s(sLoopInd[0]);
                 MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
                     createKrnl);
 
-                // Index of the bounding box with the largest score.
-                Value selectedBI = create.krnl.load(order, {b, c, s});
-
-                // Check conditions to select a bounding box.
-                // 1. Only bounding boxes whose score > score_threshold.
-                Value score = create.krnl.load(scores, {b, c, selectedBI});
-                Value checkScore = create.math.sgt(score, scoreTH);
-                // 2. Have not yet got enough outputs.
+                // Check conditions to select a bounding box. Candidate scores
+                // are above the score threshold by construction.
+                // 1. Have not yet got enough outputs.
                 Value currentMOPC =
                     create.krnl.load(effectiveMaxOutputPerClass, {});
                 Value checkMOPC = create.math.slt(currentMOPC, MOPC);
-                // 3. Bounding box has not yet been removed.
-                Value isRemoved =
-                    create.krnl.load(removedIndices, {selectedBI});
+                // 2. Candidate has not been suppressed by a selected box.
+                Value isRemoved = create.krnl.load(removedIndices, {s});
                 Value isNotRemoved = create.math.eq(isRemoved, falseVal);
 
                 // Only proceed if the box satisfies the above conditions.
-                Value canSelectBox = create.math.andi(
-                    create.math.andi(checkScore, checkMOPC), isNotRemoved);
+                Value canSelectBox = create.math.andi(checkMOPC, isNotRemoved);
                 auto ifOp = rewriter.create<scf::IfOp>(
                     loc, canSelectBox, /*withElseRegion=*/false);
                 rewriter.setInsertionPointToStart(
                     &ifOp.getThenRegion().front());
 
+                // Index of the bounding box with the largest score.
+                Value selectedBI = create.krnl.load(candidates, {s});
+
                 // Select the bounding box with the largest score.
                 SmallVector<Value, 4> selectedBox;
                 for (int i = 0; i < 4; ++i) {
@@ -383,9 +414,9 @@ struct ONNXNonMaxSuppressionOpLowering : public ConversionPattern {
                 }
 
                 // Store the index of the selected box to the output.
-                // out_index = effective_num_selected_indices
+                // out_index = out_base + effective_max_output_per_class
                 // selected_indices[out_index] = [b, c, selected_box_index]
-                Value soVal = create.krnl.load(effectiveNumSelectedIndices, {});
+                Value soVal = create.math.add(outBase, currentMOPC);
                 create.krnl.store(b, selectedMemRef, {soVal, zero});
                 create.krnl.store(c, selectedMemRef, {soVal, one});
                 create.krnl.store(selectedBI, selectedMemRef, {soVal, two});
@@ -395,52 +426,74 @@ struct ONNXNonMaxSuppressionOpLowering : public ConversionPattern {
                 create.krnl.store(create.math.add(currentMOPC, one),
                     effectiveMaxOutputPerClass, {});
 
-                // Update the effective number of selected indices.
-                // effective_num_selected_indices += 1
-                create.krnl.store(create.math.add(soVal, one),
-                    effectiveNumSelectedIndices, {});
-
-                // Remove boxes overlapped too much with the selected box,
-                // using IOU.
+                // Remove the remaining candidates overlapped too much with
+                // the selected box, using IOU. Candidates before this one
+                // have already been either selected or removed.
+                Value sPlusOne = create.math.add(s, one);
                 ValueRange oLoopDef = create.krnl.defineLoops(1);
-                create.krnl.iterate(oLoopDef, oLoopDef, {zero}, {ss},
+                create.krnl.iterate(oLoopDef, oLoopDef, {sPlusOne}, {nc},
                     [&](KrnlBuilder &createKrnl, ValueRange oLoopInd) {
                       Value o(oLoopInd[0]);
-                      MathBuilder createMath(createKrnl);
+                      MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                          createKrnl);
 
-                      // Only proceed if a box has not yet been removed.
-                      Value isRemoved = createKrnl.load(removedIndices, {o});
-                      Value isNotRemoved = createMath.eq(isRemoved, falseVal);
+                      // Only proceed if a candidate has not yet been removed.
+                      Value isRemoved = create.krnl.load(removedIndices, {o});
+                      Value isNotRemoved = create.math.eq(isRemoved, falseVal);
                       auto if1Op = rewriter.create<scf::IfOp>(
                           loc, isNotRemoved, /*withElseRegion=*/false);
                       rewriter.setInsertionPointToStart(
                           &if1Op.getThenRegion().front());
 
                       // Pick the current box.
+                      Value otherBI = create.krnl.load(candidates, {o});
                       SmallVector<Value, 4> otherBox;
                       for (int i = 0; i < 4; ++i) {
-                        Value iVal = createMath.constantIndex(i);
-                        Value x = createKrnl.load(boxes, {b, o, iVal});
+                        Value iVal = create.math.constantIndex(i);
+                        Value x = create.krnl.load(boxes, {b, otherBI, iVal});
                         otherBox.emplace_back(x);
                       }
 
                       // Compute IOU between the selected and current boxes.
                       Value iou = emitIOU(
-                          createMath, selectedBox, otherBox, centerPointBox);
+                          create.math, selectedBox, otherBox, centerPointBox);
 
                       // Only proceed if IOU >= iou_threshold.
-                      Value checkIOU = createMath.sge(iou, iouTH);
+                      Value checkIOU = create.math.sge(iou, iouTH);
                       auto if2Op = rewriter.create<scf::IfOp>(
                           loc, checkIOU, /*withElseRegion=*/false);
                       rewriter.setInsertionPointToStart(
                           &if2Op.getThenRegion().front());
 
-                      // If IOU is satisfied, mark the current box as removed.
-                      createKrnl.store(trueVal, removedIndices, {o});
+                      // If IOU is satisfied, mark the candidate as removed.
+                      create.krnl.store(trueVal, removedIndices, {o});
                     });
               });
         });
 
+    // Effective number of selected indices. This is the final value for the 1st
+    // dim of the output, which is suppressed by IOU during computation and
+    // cannot be computed in advance. Unused slots in selectedMemRef keep the
+    // initial value -1.
+    Value minusOne = create.math.constantIndex(-1);
+    Value numSelectedIndices = numSelectedIndicesIE.getValue();
+    Value effectiveNumSelectedIndices =
+        create.mem.alloca(MemRefType::get({}, indexType));
+    create.krnl.store(zero, effectiveNumSelectedIndices, {});
+    ValueRange countLoopDef = create.krnl.defineLoops(1);
+    create.krnl.iterate(countLoopDef, countLoopDef, {zero},
+        {numSelectedIndices},
+        [&](KrnlBuilder &createKrnl, ValueRange countLoopInd) {
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          Value i(countLoopInd[0]);
+          Value bVal = create.krnl.load(selectedMemRef, {i, zero});
+          Value isFilled = create.math.neq(bVal, minusOne);
+          Value count = create.krnl.load(effectiveNumSelectedIndices, {});
+          Value countPlusOne = create.math.add(count, one);
+          count = create.math.select(isFilled, countPlusOne, count);
+          create.krnl.store(count, effectiveNumSelectedIndices, {});
+        });
+
     // Insert allocation and deallocation for the final output.
     Value effectiveNSI = create.krnl.load(effectiveNumSelectedIndices, {});
     SmallVector<IndexExpr, 2> resDims = {
@@ -450,15 +503,27 @@ struct ONNXNonMaxSuppressionOpLowering : public ConversionPattern {
         MemRefType::get({-1, 3}, elementType), loc, resDims,
         /*insertDealloc=*/insertDealloc);
 
-    // Copy data to the final ouput.
-    ValueRange resLoopDef = create.krnl.defineLoops(2);
-    create.krnl.iterate(resLoopDef, resLoopDef, {zero, zero},
-        {effectiveNSI, three},
+    // Copy data to the final ouput, packing the used slots densely.
+    Value outIndex = create.mem.alloca(MemRefType::get({}, indexType));
+    create.krnl.store(zero, outIndex, {});
+    ValueRange resLoopDef = create.krnl.defineLoops(1);
+    create.krnl.iterate(resLoopDef, resLoopDef, {zero}, {numSelectedIndices},
         [&](KrnlBuilder &createKrnl, ValueRange resLoopInd) {
-          MathBuilder createMath(createKrnl);
-          Value load = createKrnl.load(selectedMemRef, resLoopInd);
-          Value res = createMath.cast(elementType, load);
-          createKrnl.store(res, resMemRef, resLoopInd);
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          Value i(resLoopInd[0]);
+          Value bVal = create.krnl.load(selectedMemRef, {i, zero});
+          Value isFilled = create.math.neq(bVal, minusOne);
+          auto ifOp = rewriter.create<scf::IfOp>(
+              loc, isFilled, /*withElseRegion=*/false);
+          rewriter.setInsertionPointToStart(&ifOp.getThenRegion().front());
+
+          Value outI = create.krnl.load(outIndex, {});
+          for (Value col : {zero, one, two}) {
+            Value load = create.krnl.load(selectedMemRef, {i, col});
+            Value res = create.math.cast(elementType, load);
+            create.krnl.store(res, resMemRef, {outI, col});
+          }
+          create.krnl.store(create.math.add(outI, one), outIndex, {});
         });
 
     rewriter.replaceOp(op, resMemRef);
@@ -467,8 +532,9 @@ struct ONNXNonMaxSuppressionOpLowering : public ConversionPattern {
 };
 
 void populateLoweringONNXNonMaxSuppressionOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx) {
-  patterns.insert<ONNXNonMaxSuppressionOpLowering>(typeConverter, ctx);
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel) {
+  patterns.insert<ONNXNonMaxSuppressionOpLowering>(
+      typeConverter, ctx, enableParallel);
 }
 
 // clang-format off
@@ -582,55 +648,67 @@ void populateLoweringONNXNonMaxSuppressionOpPattern(RewritePatternSet &patterns,
 // 
 //     # Output: [num_selected_indices, 3]
 //     # The selected index format is [batch_index, class_index, box_index].
+//     # Each (batch, class) pair writes to its own slice of selected_indices,
+//     # so the loop below can run in parallel over batches and classes.
 //     num_selected_indices = batch_size * max_output_per_class * class_size
 //     selected_indices_shape = (num_selected_indices, 3)
 //     selected_indices = np.full(selected_indices_shape, -1).astype(np.int64)
-//     effective_num_selected_indices = 0
 //     for b in range(batch_size):
 //         for c in range(class_size):
 //             effective_max_output_per_class = 0
 //             removed_indices = np.full((spatial_size), False)
+//
+//             # Compact the sorted order into the list of candidate boxes
+//             # whose score exceeds the score threshold. The suppression
+//             # loops below only iterate over candidates.
+//             candidates = np.full((spatial_size), -1)
+//             num_candidates = 0
 //             for s in range(spatial_size):
-//                 # Index of the bounding box with the largest score.
-//                 selected_box_index = order[b, c, s]
+//                 if scores[b, c, order[b, c, s]] > score_threshold:
+//                     candidates[num_candidates] = order[b, c, s]
+//                     num_candidates += 1
 //
-//                 # Discard bounding boxes using score threshold.
-//                 if (scores[b, c, selected_box_index] <= score_threshold):
-//                     continue
+//             out_base = (b * class_size + c) * max_output_per_class
+//             for s in range(num_candidates):
 //                 # Have enough the number of outputs.
 //                 if (effective_max_output_per_class >= max_output_per_class):
 //                     continue
 //                 # Removed, ignore.
-//                 if removed_indices[selected_box_index]:
+//                 if removed_indices[s]:
 //                     continue
-// 
+//
 //                 # Pick the bounding box with the largest score.
+//                 selected_box_index = candidates[s]
 //                 selected_box = boxes[b, selected_box_index, :]
-// 
+//
 //                 # Store the index of the picked box to the output.
-//                 selected_indices[effective_num_selected_indices] = [b, c, selected_box_index]
+//                 out_index = out_base + effective_max_output_per_class
+//                 selected_indices[out_index] = [b, c, selected_box_index]
 //
 //                 # Update counters.
 //                 effective_max_output_per_class += 1
-//                 effective_num_selected_indices += 1
-// 
-//                 # Remove boxes overlapped too much with the selected box, using
-//                 # IOU.
-//                 for o in range(spatial_size):
-//                     other_box = boxes[b, o, :]
+//
+//                 # Remove the remaining candidates overlapped too much with
+//                 # the selected box, using IOU.
+//                 for o in range(s + 1, num_candidates):
+//                     other_box = boxes[b, candidates[o], :]
 //                     iou = IOU(selected_box, other_box, center_point_box)
 //                     if (not removed_indices[o]) and (iou >= iou_threshold):
 //                         removed_indices[o] = True
-//                     else:
-//                         removed_indices[o] = removed_indices[o]
-// 
-//     # Since we cannot suppress by IOU in advance, so remove redundant score
-//     # now.
+//
+//     # Since we cannot suppress by IOU in advance, pack the used output
+//     # slots densely now.
+//     effective_num_selected_indices = \
+//         sum(1 for i in range(num_selected_indices)
+//             if selected_indices[i, 0] != -1)
 //     res = np.empty((effective_num_selected_indices, 3))
-//     for i in range(effective_num_selected_indices):
-//         res[i] = selected_indices[i]
-//     return res 
-// 
+//     out_index = 0
+//     for i in range(num_selected_indices):
+//         if selected_indices[i, 0] != -1:
+//             res[out_index] = selected_indices[i]
+//             out_index += 1
+//     return res
+//
 // 
 // print("testing nonmaxsuppression_center_point_box_format")
 // center_point_box = 1
@@ -30,20 +30,32 @@ namespace onnx_mlir {
 class Utilities {
 public:
   // Perform a 32-bit FNV (Fowler-Noll-Vo) hash on the given string.
+  // Note: must be kept in sync with hash_string in
+  // src/Runtime/OMIndexLookup.inc, which probes the tables at runtime.
   static inline uint32_t hash(uint32_t hval, llvm::StringRef str) {
     constexpr uint32_t prime = 0x01000193;
     hval = (hval == 0) ? prime : hval;
 
     for (const char c : str) {
       hval *= prime;
-      hval ^= c;
+      hval ^= (uint32_t)(unsigned char)c;
     }
     return hval;
   }
 
-  // Adaptation of 32-bit FNV for int64_t values.
+  // Adaptation of 32-bit FNV for int64_t values: hash the eight value bytes
+  // directly (low byte first).
+  // Note: must be kept in sync with hash_int64 in
+  // src/Runtime/OMIndexLookup.inc.
   static inline uint32_t hash(uint32_t hval, int64_t val) {
-    return hash(hval, std::to_string(val));
+    constexpr uint32_t prime = 0x01000193;
+    hval = (hval == 0) ? prime : hval;
+
+    for (int32_t i = 0; i < 8; ++i) {
+      hval *= prime;
+      hval ^= (uint32_t)(((uint64_t)val >> (i * 8)) & 0xFFu);
+    }
+    return hval;
   }
 
   // Extracts the keys of the given map.
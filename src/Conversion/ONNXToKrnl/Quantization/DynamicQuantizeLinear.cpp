@@ -0,0 +1,134 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===---- DynamicQuantizeLinear.cpp - Lowering DynamicQuantizeLinear Op ---===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the ONNX DynamicQuantizeLinear Operator to Krnl dialect.
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/Conversion/ONNXToKrnl/ONNXToKrnlCommon.hpp"
+#include "src/Dialect/Krnl/DialectBuilder.hpp"
+#include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+struct ONNXDynamicQuantizeLinearOpLowering : public ConversionPattern {
+  ONNXDynamicQuantizeLinearOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx)
+      : ConversionPattern(typeConverter,
+            mlir::ONNXDynamicQuantizeLinearOp::getOperationName(), 1, ctx) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    ONNXDynamicQuantizeLinearOpAdaptor operandAdaptor(operands);
+    Location loc = ONNXLoc<ONNXDynamicQuantizeLinearOp>(op);
+    MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl, MathBuilder,
+        MemRefBuilder>
+        create(rewriter, loc);
+
+    Value input = operandAdaptor.x();
+    Type f32Type = rewriter.getF32Type();
+    Type i32Type = rewriter.getI32Type();
+
+    // Convert the output types to MemRefType.
+    Type yType = typeConverter->convertType(op->getResultTypes()[0]);
+    Type yScaleType = typeConverter->convertType(op->getResultTypes()[1]);
+    Type yZeroPointType = typeConverter->convertType(op->getResultTypes()[2]);
+    assert(yType && yType.isa<MemRefType>() && yScaleType &&
+           yScaleType.isa<MemRefType>() && yZeroPointType &&
+           yZeroPointType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType yMemRefType = yType.cast<MemRefType>();
+    MemRefType yScaleMemRefType = yScaleType.cast<MemRefType>();
+    MemRefType yZeroPointMemRefType = yZeroPointType.cast<MemRefType>();
+    Type quantizedType = yMemRefType.getElementType();
+
+    // The quantized output has the same shape as the input; scale and zero
+    // point are scalars.
+    SmallVector<IndexExpr, 4> inputDims, scalarDims;
+    create.krnlIE.getShapeAsDims(input, inputDims);
+    Value yAlloc = insertAllocAndDeallocSimple(
+        rewriter, op, yMemRefType, loc, inputDims);
+    Value yScaleAlloc = insertAllocAndDeallocSimple(
+        rewriter, op, yScaleMemRefType, loc, scalarDims);
+    Value yZeroPointAlloc = insertAllocAndDeallocSimple(
+        rewriter, op, yZeroPointMemRefType, loc, scalarDims);
+
+    // Compute the data range over the input, adjusted to include zero so
+    // that zero is always exactly representable (per the ONNX spec, the
+    // running min/max start from zero).
+    Value fZero = create.math.constant(f32Type, 0.0);
+    // Single scalars, no need for default alignment.
+    Value minVal = create.mem.alloca(MemRefType::get({}, f32Type));
+    Value maxVal = create.mem.alloca(MemRefType::get({}, f32Type));
+    create.krnl.store(fZero, minVal);
+    create.krnl.store(fZero, maxVal);
+
+    int64_t rank = inputDims.size();
+    SmallVector<IndexExpr, 4> lbs(rank, LiteralIndexExpr(0));
+    ValueRange rangeLoops = create.krnl.defineLoops(rank);
+    create.krnl.iterateIE(rangeLoops, rangeLoops, lbs, inputDims,
+        [&](KrnlBuilder &createKrnl, ValueRange indices) {
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          Value x = create.krnl.load(input, indices);
+          Value curMin = create.krnl.load(minVal);
+          Value curMax = create.krnl.load(maxVal);
+          create.krnl.store(create.math.min(curMin, x), minVal);
+          create.krnl.store(create.math.max(curMax, x), maxVal);
+        });
+
+    // y_scale = (max - min) / (qmax - qmin); only uint8 is supported, so the
+    // quantization range is [0, 255].
+    Value range = create.math.constant(f32Type, 255.0);
+    Value minLoad = create.krnl.load(minVal);
+    Value maxLoad = create.krnl.load(maxVal);
+    Value scale = create.math.div(create.math.sub(maxLoad, minLoad), range);
+    create.krnl.store(scale, yScaleAlloc);
+
+    // y_zero_point = saturate(round(qmin - min / y_scale)), qmin = 0.
+    Value interZeroPoint =
+        create.math.div(create.math.sub(fZero, minLoad), scale);
+    Value roundedZeroPoint = emitRoundHalfToEven(rewriter, loc, interZeroPoint);
+    Value zeroPointI32 = create.math.cast(i32Type, roundedZeroPoint);
+    Value zeroPoint =
+        emitSaturatedCast(rewriter, loc, zeroPointI32, quantizedType);
+    create.krnl.store(zeroPoint, yZeroPointAlloc);
+    // Use the saturated zero point in the quantization loop below.
+    Value satZeroPointI32 = create.math.cast(i32Type, zeroPoint);
+
+    // y = saturate(round(x / y_scale) + y_zero_point).
+    ValueRange quantLoops = create.krnl.defineLoops(rank);
+    create.krnl.iterateIE(quantLoops, quantLoops, lbs, inputDims,
+        [&](KrnlBuilder &createKrnl, ValueRange indices) {
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          Value x = create.krnl.load(input, indices);
+          Value scaled = create.math.div(x, scale);
+          Value rounded = emitRoundHalfToEven(rewriter, loc, scaled);
+          Value shifted =
+              create.math.add(
+                  create.math.cast(i32Type, rounded), satZeroPointI32);
+          Value quantized =
+              emitSaturatedCast(rewriter, loc, shifted, quantizedType);
+          create.krnl.store(quantized, yAlloc, indices);
+        });
+
+    rewriter.replaceOp(op, {yAlloc, yScaleAlloc, yZeroPointAlloc});
+    return success();
+  }
+};
+
+void populateLoweringONNXDynamicQuantizeLinearOpPattern(
+    RewritePatternSet &patterns, TypeConverter &typeConverter,
+    MLIRContext *ctx) {
+  patterns.insert<ONNXDynamicQuantizeLinearOpLowering>(typeConverter, ctx);
+}
+
+} // namespace onnx_mlir
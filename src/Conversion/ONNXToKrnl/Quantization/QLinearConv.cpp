@@ -0,0 +1,277 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===-------------- QLinearConv.cpp - Lowering QLinearConv Op -------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the ONNX QLinearConv Operator to Krnl dialect: an int8
+// convolution with i32 accumulation and a requantization of each output
+// element. Supports per-tensor and per-output-channel weight quantization.
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/Conversion/ONNXToKrnl/ONNXToKrnlCommon.hpp"
+#include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+struct ONNXQLinearConvOpLowering : public ConversionPattern {
+  ONNXQLinearConvOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+      : ConversionPattern(
+            typeConverter, mlir::ONNXQLinearConvOp::getOperationName(), 1,
+            ctx) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    Location loc = op->getLoc();
+    ONNXQLinearConvOpAdaptor operandAdaptor(operands);
+    ONNXQLinearConvOp qlConvOp = llvm::cast<ONNXQLinearConvOp>(op);
+    MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl, MathBuilder,
+        MemRefBuilder>
+        create(rewriter, loc);
+
+    // Get shape.
+    ONNXQLinearConvOpShapeHelper shapeHelper(op, operands, &create.krnlIE);
+    shapeHelper.computeShapeAndAssertOnFailure();
+
+    // Convert the output type to MemRefType.
+    Type convertedType = typeConverter->convertType(*op->result_type_begin());
+    assert(convertedType && convertedType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType memRefType = convertedType.cast<MemRefType>();
+    Type quantizedType = memRefType.getElementType();
+
+    // Insert an allocation and deallocation for the result of this operation.
+    Value alloc = insertAllocAndDeallocSimple(
+        rewriter, op, memRefType, loc, shapeHelper.getOutputDims());
+
+    // Spatial data starts from the second dimension.
+    int spatialStartIndex = 2;
+
+    Value inputOperand = operandAdaptor.x();
+    Value filterOperand = operandAdaptor.w();
+    Value biasOperand = operandAdaptor.B();
+    bool hasBias = !biasOperand.getType().isa<NoneType>();
+    int64_t groupNum = qlConvOp.group();
+    IndexExpr G = LiteralIndexExpr(groupNum);
+    Type i32Type = rewriter.getI32Type();
+    Value iZero = create.math.constant(i32Type, 0);
+
+    // Quantization parameters. The input and output ones are per tensor;
+    // the weight ones may be per tensor (scalar or single-element 1-D) or
+    // per output channel (1-D of size CO), in which case they are loaded
+    // inside the loop over channels out.
+    Value xScale =
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.x_scale());
+    Value yScale =
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.y_scale());
+    Value xZeroPoint = create.math.cast(i32Type,
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.x_zero_point()));
+    Value yZeroPoint = create.math.cast(i32Type,
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.y_zero_point()));
+
+    // Per-channel when the weight scale is a 1-D tensor of more than one
+    // element.
+    Value wScaleOperand = operandAdaptor.w_scale();
+    Value wZeroPointOperand = operandAdaptor.w_zero_point();
+    MemRefType wScaleType = wScaleOperand.getType().cast<MemRefType>();
+    bool perChannel =
+        wScaleType.getRank() == 1 && wScaleType.getShape()[0] != 1;
+    Value wZeroPoint, combinedScale;
+    if (!perChannel) {
+      Value wScale =
+          loadScalarQuantParameter(rewriter, loc, wScaleOperand);
+      wZeroPoint = create.math.cast(
+          i32Type, loadScalarQuantParameter(rewriter, loc, wZeroPointOperand));
+      combinedScale =
+          create.math.div(create.math.mul(xScale, wScale), yScale);
+    }
+
+    // Bounds for output sizes: [N x CO x HO x WO], as in the Conv lowering.
+    int outputRank = shapeHelper.getOutputDims().size();
+    IndexExpr N = shapeHelper.getOutputDims()[0];
+    IndexExpr CO = shapeHelper.getOutputDims()[1];
+    IndexExpr COPerGroup = CO.ceilDiv(G);
+    IndexExpr CIPerGroup = create.krnlIE.getShapeAsSymbol(filterOperand, 1);
+
+    IndexExpr iZeroIE = LiteralIndexExpr(0);
+    SmallVector<IndexExpr, 3> outerLbs = {iZeroIE, iZeroIE, iZeroIE};
+    SmallVector<IndexExpr, 3> outerUbs = {N, G, COPerGroup};
+
+    // Create a local reduction value in i32.
+    // Single scalar, no need for default alignment.
+    Value reductionVal = create.mem.alloca(MemRefType::get({}, i32Type));
+
+    // Iterate over the outer loops
+    // for n = 0 .. N:
+    //   for g = 0 .. G:
+    //     for coPerGroup = 0 .. COPerGroup:
+    //       co = g * COPerGroup + coPerGroup;
+    ValueRange outerLoops = create.krnl.defineLoops(3);
+    create.krnl.iterateIE(outerLoops, outerLoops, outerLbs, outerUbs,
+        [&](KrnlBuilder &createKrnl, ValueRange outerIndices) {
+          IndexExprScope outerScope(createKrnl);
+          MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl,
+              MathBuilder>
+              create(createKrnl);
+          // Compute the channel out index "co".
+          DimIndexExpr g(outerIndices[1]);
+          DimIndexExpr coPerGroup(outerIndices[2]);
+          IndexExpr co = g * SymbolIndexExpr(COPerGroup) + coPerGroup;
+          // Compute g * CIPerGroup for later use.
+          IndexExpr gTimesCIPerGroup = g * SymbolIndexExpr(CIPerGroup);
+
+          // Resolve the per-channel weight quantization parameters for this
+          // output channel.
+          Value wZeroPointVal = wZeroPoint;
+          Value combinedScaleVal = combinedScale;
+          if (perChannel) {
+            Value wScaleC = create.krnl.loadIE(wScaleOperand, {co});
+            wZeroPointVal = create.math.cast(
+                i32Type, create.krnl.loadIE(wZeroPointOperand, {co}));
+            combinedScaleVal =
+                create.math.div(create.math.mul(xScale, wScaleC), yScale);
+          }
+
+          // Determine the bounds for the output spacial dimensions.
+          int spacialRank = outputRank - spatialStartIndex;
+          ValueRange outputSpacialLoops = create.krnl.defineLoops(spacialRank);
+          SmallVector<IndexExpr, 3> outputSpacialLbs, outputSpacialUbs;
+          for (int i = spatialStartIndex; i < outputRank; ++i) {
+            outputSpacialLbs.emplace_back(iZeroIE);
+            outputSpacialUbs.emplace_back(
+                SymbolIndexExpr(shapeHelper.getOutputDims()[i]));
+          }
+          // Spacial loops.
+          // for ho = 0 .. HO:
+          //    for wo = 0 .. WO:
+          create.krnl.iterateIE(outputSpacialLoops, outputSpacialLoops,
+              outputSpacialLbs, outputSpacialUbs,
+              [&](KrnlBuilder &createKrnl, ValueRange outputSpatialIndices) {
+                IndexExprScope outputSpacialScope(createKrnl);
+                MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl,
+                    MathBuilder>
+                    create(createKrnl);
+                // Reset reduction value to zero.
+                create.krnl.store(iZero, reductionVal);
+
+                // Bounds for reduction loops.
+                ValueRange redLoops = create.krnl.defineLoops(spacialRank + 1);
+                SmallVector<IndexExpr, 4> redLbs, redUbs, pMinOS;
+                // First: loop over channel in per group.
+                redLbs.emplace_back(iZeroIE);
+                redUbs.emplace_back(SymbolIndexExpr(CIPerGroup));
+                // For each spacial dim, do the following.
+                for (int i = 0; i < spacialRank; ++i) {
+                  // Get data for dis spacial dimension.
+                  DimIndexExpr o(outputSpatialIndices[i]);
+                  SymbolIndexExpr I(create.krnlIE.getShapeAsSymbol(
+                      inputOperand, spatialStartIndex + i));
+                  SymbolIndexExpr K(create.krnlIE.getShapeAsSymbol(
+                      filterOperand, spatialStartIndex + i));
+                  SymbolIndexExpr p(shapeHelper.pads[i]);
+                  LiteralIndexExpr s(shapeHelper.strides[i]);
+                  LiteralIndexExpr d(shapeHelper.dilations[i]);
+                  // lb = ceil((p - o * s) / d)
+                  IndexExpr pos = p - (o * s);
+                  IndexExpr lb = pos.ceilDiv(d);
+                  lb = IndexExpr::max(lb, 0);
+                  redLbs.emplace_back(lb);
+                  // ub = ceil((I + p - o * s) / d)
+                  IndexExpr ipos = I + pos;
+                  IndexExpr ub = ipos.ceilDiv(d);
+                  ub = IndexExpr::min(ub, K);
+                  redUbs.emplace_back(ub);
+                  // Save p - o * s for later use.
+                  pMinOS.emplace_back(pos);
+                }
+                // for ciPerGroup = 0 .. CIPerGroup:
+                //   for kh in lb .. ub:
+                //     for kw in lb .. ub:
+                create.krnl.iterateIE(redLoops, redLoops, redLbs, redUbs,
+                    [&](KrnlBuilder &createKrnl, ValueRange redIndices) {
+                      IndexExprScope redScope(createKrnl);
+                      MultiDialectBuilder<KrnlBuilder,
+                          IndexExprBuilderForKrnl, MathBuilder>
+                          create(createKrnl);
+                      // Create access function for input image:
+                      // [n, ci, ho * sh + kh * dh - ph, ...].
+                      SmallVector<IndexExpr, 4> inputAccessFct;
+                      DimIndexExpr n(outerIndices[0]);
+                      inputAccessFct.emplace_back(n);
+                      // ci = g * CIPerG + ciPerG
+                      DimIndexExpr ciPerG(redIndices[0]);
+                      IndexExpr ci =
+                          SymbolIndexExpr(gTimesCIPerGroup) + ciPerG;
+                      inputAccessFct.emplace_back(ci);
+                      for (int i = 0; i < spacialRank; ++i) {
+                        // for each spacial dims: access is o * s + k * d - p.
+                        DimIndexExpr k(redIndices[1 + i]);
+                        SymbolIndexExpr pos(pMinOS[i]);
+                        LiteralIndexExpr d(shapeHelper.dilations[i]);
+                        // k*d - (p - o*s) = k*d + o*s - p
+                        IndexExpr t = (k * d) - pos;
+                        inputAccessFct.emplace_back(t);
+                      }
+                      Value image =
+                          create.krnl.loadIE(inputOperand, inputAccessFct);
+                      // Create access fct for filter: [co, ciPerG, kh, kw].
+                      SmallVector<IndexExpr, 4> filterAccessFct;
+                      filterAccessFct.emplace_back(DimIndexExpr(co));
+                      filterAccessFct.emplace_back(DimIndexExpr(ciPerG));
+                      for (int i = 0; i < spacialRank; ++i) {
+                        DimIndexExpr k(redIndices[1 + i]);
+                        filterAccessFct.emplace_back(k);
+                      }
+                      Value filter =
+                          create.krnl.loadIE(filterOperand, filterAccessFct);
+                      // Widen to i32 and subtract the zero points before the
+                      // multiply so the product cannot overflow.
+                      Value imageI32 = create.math.sub(
+                          create.math.cast(i32Type, image), xZeroPoint);
+                      Value filterI32 = create.math.sub(
+                          create.math.cast(i32Type, filter), wZeroPointVal);
+                      Value oldRed = create.krnl.load(reductionVal);
+                      Value mul = create.math.mul(imageI32, filterI32);
+                      Value newRed = create.math.add(oldRed, mul);
+                      create.krnl.store(newRed, reductionVal);
+                    }); // Reduction loops.
+                // Finish the reduction, requantize, and store.
+                Value result = create.krnl.load(reductionVal);
+                SymbolIndexExpr coInOutputSpacial(co);
+                if (hasBias) {
+                  // Bias is pre-quantized in i32 with scale
+                  // x_scale * w_scale and zero point 0; add it directly to
+                  // the accumulator.
+                  Value bias =
+                      create.krnl.loadIE(biasOperand, {coInOutputSpacial});
+                  result = create.math.add(result, bias);
+                }
+                Value quantized = emitRequantize(rewriter, loc, result,
+                    combinedScaleVal, yZeroPoint, quantizedType);
+                SmallVector<IndexExpr, 4> resAccessFunc;
+                resAccessFunc.emplace_back(SymbolIndexExpr(outerIndices[0]));
+                resAccessFunc.emplace_back(coInOutputSpacial);
+                for (Value o : outputSpatialIndices)
+                  resAccessFunc.emplace_back(DimIndexExpr(o));
+                create.krnl.storeIE(quantized, alloc, resAccessFunc);
+              }); // Output spacial loops.
+        });
+
+    rewriter.replaceOp(op, alloc);
+    return success();
+  }
+};
+
+void populateLoweringONNXQLinearConvOpPattern(RewritePatternSet &patterns,
+    TypeConverter &typeConverter, MLIRContext *ctx) {
+  patterns.insert<ONNXQLinearConvOpLowering>(typeConverter, ctx);
+}
+
+} // namespace onnx_mlir
@@ -0,0 +1,258 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------------ QLinearMatMul.cpp - Lowering QLinearMatMul Op -----------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the ONNX QLinearMatMul Operator to Krnl dialect: an int8
+// matrix product with i32 accumulation followed by a requantization epilogue.
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/Conversion/ONNXToKrnl/ONNXToKrnlCommon.hpp"
+#include "src/Dialect/Krnl/DialectBuilder.hpp"
+#include "src/Dialect/Mlir/IndexExpr.hpp"
+#include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
+
+// Cache tile sizes (in elements) for the blocked 2D schedule below. The int8
+// operands are four times denser than f32, so larger K tiles than the f32
+// MatMul lowering still fit the same cache footprint.
+static constexpr int64_t QMATMUL_J_CACHE_TILE = 64;
+static constexpr int64_t QMATMUL_K_CACHE_TILE = 512;
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+struct ONNXQLinearMatMulOpLowering : public ConversionPattern {
+  ONNXQLinearMatMulOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableTiling)
+      : ConversionPattern(typeConverter,
+            mlir::ONNXQLinearMatMulOp::getOperationName(), 1, ctx),
+        enableTiling(enableTiling) {}
+  bool enableTiling;
+
+  // Generic case, any rank with broadcasts: one i32 scalar accumulator per
+  // output element, requantized on the way to the output store.
+  void replaceGenericQMatmul(ONNXQLinearMatMulOpAdaptor &operandAdaptor,
+      ONNXQLinearMatMulOpShapeHelper &shapeHelper, Value alloc,
+      Value aZeroPoint, Value bZeroPoint, Value combinedScale,
+      Value yZeroPoint, Type quantizedType,
+      ConversionPatternRewriter &rewriter, Location loc) const {
+    MultiDialectBuilder<KrnlBuilder, MemRefBuilder, MathBuilder> create(
+        rewriter, loc);
+    Type i32Type = rewriter.getI32Type();
+    Value iZero = create.math.constant(i32Type, 0);
+
+    // Define loops and bounds, same schedule as the generic MatMul lowering.
+    int outerLoopNum = shapeHelper.getOutputDims().size();
+    int totLoopNum = outerLoopNum + 1; // Add reduction inner loop.
+    ValueRange loopDef = create.krnl.defineLoops(totLoopNum);
+    SmallVector<IndexExpr, 4> loopLbs(totLoopNum, LiteralIndexExpr(0));
+    SmallVector<IndexExpr, 4> loopUbs;
+    SmallVector<Value, 4> outerLoops;
+    for (int i = 0; i < outerLoopNum; ++i) {
+      loopUbs.emplace_back(shapeHelper.getOutputDims()[i]);
+      outerLoops.emplace_back(loopDef[i]);
+    }
+    int aRank = shapeHelper.aDims.size();
+    int bRank = aRank;
+    loopUbs.emplace_back(shapeHelper.aDims[aRank - 1]);
+    SmallVector<Value, 1> innerLoop{loopDef[totLoopNum - 1]};
+    // Single scalar, no need for default alignment.
+    Value reductionVal = create.mem.alloca(MemRefType::get({}, i32Type));
+
+    create.krnl.iterateIE(loopDef, outerLoops, loopLbs, loopUbs,
+        [&](KrnlBuilder &createKrnl, ValueRange outerIndices) {
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          create.krnl.store(iZero, reductionVal);
+          // Inner loop for the i32 reduction.
+          create.krnl.iterate({}, innerLoop, {}, {},
+              [&](KrnlBuilder &createKrnl, ValueRange innerIndex) {
+                MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                    createKrnl);
+                Value k = innerIndex[0];
+                SmallVector<Value, 4> aAccessFct, bAccessFct;
+                for (int i = 0; i < aRank; ++i) {
+                  // Add index if dim is not a padded dimension.
+                  if (!shapeHelper.aPadDims[i]) {
+                    if (i == aRank - 1)
+                      aAccessFct.emplace_back(k);
+                    else
+                      aAccessFct.emplace_back(outerIndices[i]);
+                  }
+                  if (!shapeHelper.bPadDims[i]) {
+                    if (i == bRank - 2)
+                      bAccessFct.emplace_back(k);
+                    else if (i == outerLoopNum)
+                      bAccessFct.emplace_back(outerIndices[i - 1]);
+                    else
+                      bAccessFct.emplace_back(outerIndices[i]);
+                  }
+                }
+                // Widen to i32 and subtract the zero points before the
+                // multiply so the product cannot overflow.
+                Value loadedA =
+                    create.krnl.load(operandAdaptor.a(), aAccessFct);
+                Value loadedB =
+                    create.krnl.load(operandAdaptor.b(), bAccessFct);
+                Value aI32 = create.math.sub(
+                    create.math.cast(i32Type, loadedA), aZeroPoint);
+                Value bI32 = create.math.sub(
+                    create.math.cast(i32Type, loadedB), bZeroPoint);
+                Value acc = create.krnl.load(reductionVal);
+                Value accumulated =
+                    create.math.add(acc, create.math.mul(aI32, bI32));
+                create.krnl.store(accumulated, reductionVal);
+              });
+          Value accumulated = create.krnl.load(reductionVal);
+          Value quantized = emitRequantize(rewriter, loc, accumulated,
+              combinedScale, yZeroPoint, quantizedType);
+          create.krnl.store(quantized, alloc, outerIndices);
+        });
+  }
+
+  // 2-D case: cache-blocked schedule with a full i32 accumulation buffer.
+  // The j and k loops are tiled so that the accessed slices of B stay cache
+  // resident, the innermost k loop accumulates into an i32 scalar, and a
+  // separate elementwise epilogue requantizes the whole accumulation buffer
+  // (a form the vectorizer handles well).
+  void replaceTiledQMatmul2d(Operation *op,
+      ONNXQLinearMatMulOpAdaptor &operandAdaptor,
+      ONNXQLinearMatMulOpShapeHelper &shapeHelper, Value alloc,
+      Value aZeroPoint, Value bZeroPoint, Value combinedScale,
+      Value yZeroPoint, Type quantizedType,
+      ConversionPatternRewriter &rewriter, Location loc) const {
+    MultiDialectBuilder<KrnlBuilder, MemRefBuilder, MathBuilder> create(
+        rewriter, loc);
+    Value A(operandAdaptor.a()), B(operandAdaptor.b());
+    Type i32Type = rewriter.getI32Type();
+    Value iZero = create.math.constant(i32Type, 0);
+    IndexExpr I = shapeHelper.getOutputDims()[0];
+    IndexExpr J = shapeHelper.getOutputDims()[1];
+    IndexExpr K = shapeHelper.aDims[1];
+    LiteralIndexExpr zeroIE(0);
+
+    // i32 accumulation buffer of the output shape, zero initialized.
+    MemRefType outputMemRefType = alloc.getType().cast<MemRefType>();
+    MemRefType accMemRefType =
+        MemRefType::get(outputMemRefType.getShape(), i32Type);
+    Value accBuff = insertAllocAndDeallocSimple(rewriter, op, accMemRefType,
+        loc, shapeHelper.getOutputDims(), true, BUFFER_ALIGN);
+    create.krnl.memset(accBuff, iZero);
+
+    // Tile j and k; loop order (j1, k1, i, j2) keeps the B tile in cache
+    // across all rows of A.
+    ValueRange origLoop = create.krnl.defineLoops(3);
+    Value ii(origLoop[0]), jj(origLoop[1]), kk(origLoop[2]);
+    ValueRange jCacheBlock = create.krnl.block(jj, QMATMUL_J_CACHE_TILE);
+    Value jj1(jCacheBlock[0]), jj2(jCacheBlock[1]);
+    ValueRange kCacheBlock = create.krnl.block(kk, QMATMUL_K_CACHE_TILE);
+    Value kk1(kCacheBlock[0]), kk2(kCacheBlock[1]);
+    create.krnl.permute({jj1, jj2, kk1, kk2, ii}, {0, 3, 1, 4, 2});
+    // Single scalar, no need for default alignment.
+    Value reductionVal = create.mem.alloca(MemRefType::get({}, i32Type));
+    create.krnl.iterateIE({ii, jj, kk}, {jj1, kk1, ii, jj2},
+        {zeroIE, zeroIE, zeroIE}, {I, J, K},
+        [&](KrnlBuilder &createKrnl, ValueRange indices) {
+          MultiDialectBuilder<KrnlBuilder, MathBuilder> create(createKrnl);
+          Value i(indices[2]), j(indices[3]);
+          Value acc = create.krnl.load(accBuff, {i, j});
+          create.krnl.store(acc, reductionVal);
+          create.krnl.iterate({}, {kk2}, {}, {},
+              [&](KrnlBuilder &createKrnl, ValueRange kIndex) {
+                MultiDialectBuilder<KrnlBuilder, MathBuilder> create(
+                    createKrnl);
+                Value k = kIndex[0];
+                Value aI32 = create.math.sub(
+                    create.math.cast(i32Type, create.krnl.load(A, {i, k})),
+                    aZeroPoint);
+                Value bI32 = create.math.sub(
+                    create.math.cast(i32Type, create.krnl.load(B, {k, j})),
+                    bZeroPoint);
+                Value cur = create.krnl.load(reductionVal);
+                create.krnl.store(
+                    create.math.add(cur, create.math.mul(aI32, bI32)),
+                    reductionVal);
+              });
+          create.krnl.store(create.krnl.load(reductionVal), accBuff, {i, j});
+        });
+
+    // Requantization epilogue over the accumulation buffer.
+    ValueRange outLoops = create.krnl.defineLoops(2);
+    create.krnl.iterateIE(outLoops, outLoops, {zeroIE, zeroIE}, {I, J},
+        [&](KrnlBuilder &createKrnl, ValueRange indices) {
+          MultiDialectBuilder<KrnlBuilder> create(createKrnl);
+          Value acc = create.krnl.load(accBuff, indices);
+          Value quantized = emitRequantize(rewriter, loc, acc, combinedScale,
+              yZeroPoint, quantizedType);
+          create.krnl.store(quantized, alloc, indices);
+        });
+  }
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    ONNXQLinearMatMulOpAdaptor operandAdaptor(operands);
+    Location loc = ONNXLoc<ONNXQLinearMatMulOp>(op);
+    MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl, MathBuilder>
+        create(rewriter, loc);
+
+    // Get shape.
+    ONNXQLinearMatMulOpShapeHelper shapeHelper(op, operands, &create.krnlIE);
+    shapeHelper.computeShapeAndAssertOnFailure();
+
+    // Convert the output type to MemRefType.
+    Type convertedType = typeConverter->convertType(*op->result_type_begin());
+    assert(convertedType && convertedType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType outputMemRefType = convertedType.cast<MemRefType>();
+    Type quantizedType = outputMemRefType.getElementType();
+
+    // Insert an allocation and deallocation for the output of this operation.
+    Value alloc = insertAllocAndDeallocSimple(
+        rewriter, op, outputMemRefType, loc, shapeHelper.getOutputDims());
+
+    // Per-tensor quantization parameters. The zero points are widened to
+    // i32 once, outside of the loop nests; the three scales collapse into a
+    // single float multiplier for the epilogue.
+    Type i32Type = rewriter.getI32Type();
+    Value aZeroPoint = create.math.cast(i32Type,
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.a_zero_point()));
+    Value bZeroPoint = create.math.cast(i32Type,
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.b_zero_point()));
+    Value yZeroPoint = create.math.cast(i32Type,
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.y_zero_point()));
+    Value aScale =
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.a_scale());
+    Value bScale =
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.b_scale());
+    Value yScale =
+        loadScalarQuantParameter(rewriter, loc, operandAdaptor.y_scale());
+    Value combinedScale =
+        create.math.div(create.math.mul(aScale, bScale), yScale);
+
+    int aRank = operandAdaptor.a().getType().cast<MemRefType>().getRank();
+    int bRank = operandAdaptor.b().getType().cast<MemRefType>().getRank();
+    if (enableTiling && aRank == 2 && bRank == 2)
+      replaceTiledQMatmul2d(op, operandAdaptor, shapeHelper, alloc, aZeroPoint,
+          bZeroPoint, combinedScale, yZeroPoint, quantizedType, rewriter, loc);
+    else
+      replaceGenericQMatmul(operandAdaptor, shapeHelper, alloc, aZeroPoint,
+          bZeroPoint, combinedScale, yZeroPoint, quantizedType, rewriter, loc);
+
+    rewriter.replaceOp(op, alloc);
+    return success();
+  }
+};
+
+void populateLoweringONNXQLinearMatMulOpPattern(RewritePatternSet &patterns,
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableTiling) {
+  patterns.insert<ONNXQLinearMatMulOpLowering>(
+      typeConverter, ctx, enableTiling);
+}
+
+} // namespace onnx_mlir
@@ -36,9 +36,8 @@ struct GruActivationPack {
 
 struct GruWeightPack {
   Value WT;
-  Value RT; // (Rz ++ Rr ++ Rh) if linearBeforeReset
-  Value Rz;
-  Value Rr;
+  Value RT;   // (Rz ++ Rr ++ Rh) if linearBeforeReset
+  Value RzrT; // (Rz ++ Rr) otherwise, so zt and rt share one wide GEMM
   Value Rh;
 };
 
@@ -199,8 +198,11 @@ getWeightPack<ONNXGRUOp, GruWeightPack>(
       MemRefType::get({hiddenSize, 3 * hiddenSize}, elementType);
   auto rSplit2DTy = MemRefType::get({hiddenSize, hiddenSize}, elementType);
   auto rTranspose2DTy = MemRefType::get({hiddenSize, hiddenSize}, elementType);
+  auto rzr2DTy = MemRefType::get({2 * hiddenSize, hiddenSize}, elementType);
+  auto rzrTransposeTy =
+      MemRefType::get({hiddenSize, 2 * hiddenSize}, elementType);
   SmallVector<Type, 2> r3D2Ty(2, r3DTy);
-  SmallVector<Type, 3> rSplit2D3Ty(3, rSplit2DTy);
+  SmallVector<Type, 2> rSplitZR2Ty = {rzr2DTy, rSplit2DTy};
 
   ArrayAttr permAttr = rewriter.getI64ArrayAttr({1, 0});
 
@@ -235,14 +237,14 @@ getWeightPack<ONNXGRUOp, GruWeightPack>(
       weightForward.RT =
           foldOrEmitONNXTransposeOp(rewriter, loc, rTransposeTy, fR, permAttr);
     } else {
+      // Split R into (Rz ++ Rr) and Rh so the zt and rt matmuls are computed
+      // by a single wide GEMM per timestep.
       std::vector<Value> vals =
-          foldOrEmitONNXSplitOp(rewriter, loc, rSplit2D3Ty, fR, 0);
-      weightForward.Rz = foldOrEmitONNXTransposeOp(
-          rewriter, loc, rTranspose2DTy, vals[0], permAttr);
-      weightForward.Rr = foldOrEmitONNXTransposeOp(
-          rewriter, loc, rTranspose2DTy, vals[1], permAttr);
+          foldOrEmitONNXSplitOp(rewriter, loc, rSplitZR2Ty, fR, 0);
+      weightForward.RzrT = foldOrEmitONNXTransposeOp(
+          rewriter, loc, rzrTransposeTy, vals[0], permAttr);
       weightForward.Rh = foldOrEmitONNXTransposeOp(
-          rewriter, loc, rTranspose2DTy, vals[2], permAttr);
+          rewriter, loc, rTranspose2DTy, vals[1], permAttr);
     }
   }
   if (direction == REVERSE || direction == BIDIRECTIONAL) {
@@ -255,13 +257,11 @@ getWeightPack<ONNXGRUOp, GruWeightPack>(
           foldOrEmitONNXTransposeOp(rewriter, loc, rTransposeTy, bR, permAttr);
     } else {
       std::vector<Value> vals =
-          foldOrEmitONNXSplitOp(rewriter, loc, rSplit2D3Ty, bR, 0);
-      weightReverse.Rz = foldOrEmitONNXTransposeOp(
-          rewriter, loc, rTranspose2DTy, vals[0], permAttr);
-      weightReverse.Rr = foldOrEmitONNXTransposeOp(
-          rewriter, loc, rTranspose2DTy, vals[1], permAttr);
+          foldOrEmitONNXSplitOp(rewriter, loc, rSplitZR2Ty, bR, 0);
+      weightReverse.RzrT = foldOrEmitONNXTransposeOp(
+          rewriter, loc, rzrTransposeTy, vals[0], permAttr);
       weightReverse.Rh = foldOrEmitONNXTransposeOp(
-          rewriter, loc, rTranspose2DTy, vals[2], permAttr);
+          rewriter, loc, rTranspose2DTy, vals[1], permAttr);
     }
   }
   return std::make_tuple(weightForward, weightReverse);
@@ -511,10 +511,12 @@ void calculateState<GruState, GruActivationPack, GruWeightPack, GruBiasPack>(
     // In this case, besides computing matrix multiplications, we need to
     // compute rt and (rt (.) Ht-1) first, then fuse the remaining element-wise
     // computations into a single nested loop.
-    Value HtRz =
-        create.onnx.toMemref(create.onnx.matmul(matrixType, Ht, weightPack.Rz));
-    Value HtRr =
-        create.onnx.toMemref(create.onnx.matmul(matrixType, Ht, weightPack.Rr));
+    // One wide GEMM computes the zt and rt recurrence contributions:
+    // Ht * (Rz^T ++ Rr^T), laid out as [batchSize, 2*hiddenSize].
+    MemRefType matrixZRGatesType =
+        MemRefType::get({batchSize, 2 * hiddenSize}, elementType);
+    Value HtRzr = create.onnx.toMemref(
+        create.onnx.matmul(matrixZRGatesType, Ht, weightPack.RzrT));
     Value rt, rtHt;
     if (hasAllConstantDimensions(matrixType)) {
       rt = insertAllocAndDealloc(matrixType, loc, rewriter, false);
@@ -540,7 +542,7 @@ void calculateState<GruState, GruActivationPack, GruWeightPack, GruBiasPack>(
           Value HtVal = createKrnl.load(Ht, indices);
           // rt = f(Xt*(Wr^T) + Ht-1*(Rr^T) + Wbr + Rbr)"
           Value XtWrVal = createKrnl.loadIE(XtWT, {bsie, hsie + hsieLit});
-          Value HtRrVal = createKrnl.load(HtRr, indices);
+          Value HtRrVal = createKrnl.loadIE(HtRzr, {bsie, hsie + hsieLit});
           Value rtVal = createMath.add(XtWrVal, HtRrVal);
           if (biasPack.hasBias) {
             Value WbrVal = createKrnl.load(biasPack.Wbr, {hs});
@@ -573,7 +575,7 @@ void calculateState<GruState, GruActivationPack, GruWeightPack, GruBiasPack>(
           Value HtVal = createKrnl.load(Ht, indices);
           // zt = f(Xt*(Wz^T) + Ht-1*(Rz^T) + Wbz + Rbz)
           Value XtWzVal = createKrnl.loadIE(XtWT, {bsie, hsie});
-          Value HtRzVal = createKrnl.load(HtRz, indices);
+          Value HtRzVal = createKrnl.loadIE(HtRzr, {bsie, hsie});
           Value zt = createMath.add(XtWzVal, HtRzVal);
           if (biasPack.hasBias) {
             Value WbzVal = createKrnl.load(biasPack.Wbz, {hs});
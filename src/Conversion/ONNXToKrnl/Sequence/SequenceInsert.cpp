@@ -41,6 +41,25 @@ struct ONNXSequenceInsertOpLowering : public ConversionPattern {
     MemRefType outputMemRefType = convertedType.cast<MemRefType>();
 
     auto input_sequence = operandAdaptor.input_sequence();
+
+    // Append at the end of a sequence that dies here: grow the sequence in
+    // place with KrnlSeqAppendOp, which moves the element pointers instead
+    // of deep-copying every element, so a chain of appends is amortized
+    // O(1) per element. The capacity invariant behind KrnlSeqAppendOp only
+    // holds for sequences built by our own allocations, so the sequence
+    // must be produced by another op (not a block argument) and this
+    // insert must be its only user.
+    Value seqAtONNXLevel = thisOp.input_sequence();
+    if (isFromNone(operandAdaptor.position()) &&
+        !seqAtONNXLevel.isa<BlockArgument>() && seqAtONNXLevel.hasOneUse() &&
+        outputMemRefType.isDynamicDim(0) &&
+        input_sequence.getType() == outputMemRefType) {
+      Value appended = rewriter.create<KrnlSeqAppendOp>(
+          loc, outputMemRefType, operandAdaptor.tensor(), input_sequence);
+      rewriter.replaceOp(op, appended);
+      return success();
+    }
+
     auto dimSize = create.mem.dim(input_sequence, 0);
     SymbolIndexExpr boundIE(dimSize);
     auto outputBound = boundIE + 1;
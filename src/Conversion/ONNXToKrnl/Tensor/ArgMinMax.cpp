@@ -35,10 +35,160 @@ inline Value getCondition<ONNXArgMaxOp>(
   return createMath.sgt(next, dstVal);
 }
 
+//===----------------------------------------------------------------------===//
+// Lane-parallel reduction along the innermost axis.
+//===----------------------------------------------------------------------===//
+
+// Number of independent (best value, best index) lanes used by the
+// lane-parallel schedule below.
+static constexpr int64_t ARG_REDUCTION_NUM_LANES = 8;
+
+// Return true when the arg reduction is taken over exactly the innermost axis
+// and that axis has a literal extent large enough to fill every lane at least
+// twice. Such reductions get a schedule that breaks the serial dependence on
+// a single compare-and-update cell.
+static bool isInnermostArgReduction(MemRefType dataType, int64_t axis) {
+  int64_t dataRank = dataType.getRank();
+  if (axis != dataRank - 1 || !dataType.getLayout().isIdentity())
+    return false;
+  return dataType.getShape()[dataRank - 1] >= 2 * ARG_REDUCTION_NUM_LANES;
+}
+
+// Emit an arg reduction over the innermost axis using
+// ARG_REDUCTION_NUM_LANES independent (best value, best index) pairs: the
+// reduced axis is walked in blocks, each block lane comparing against and
+// updating its own pair, so the loop body carries no dependence between lanes
+// and is amenable to vectorization (packed compares with value and index
+// blends). At the end the lanes are combined pairwise (a log2 tree) into the
+// final index; ties between lanes resolve to the smaller index, preserving
+// the first-occurrence semantics of the scalar lowering. The outer loops over
+// the non-reduced dimensions are independent and marked parallel on request;
+// each outer iteration carries its own lane buffers for that reason.
+template <typename ARG_OP>
+static void emitInnermostArgReduction(ConversionPatternRewriter &rewriter,
+    Location loc, Value data, Value alloc, Type reducedElementType,
+    const std::map<int64_t, int64_t> &outInDimMap, bool enableParallel) {
+  MultiDialectBuilder<KrnlBuilder, MathBuilder, MemRefBuilder> create(
+      rewriter, loc);
+  MemRefType dataType = data.getType().cast<MemRefType>();
+  MemRefType reducedType = alloc.getType().cast<MemRefType>();
+  Type dataElementType = dataType.getElementType();
+  int64_t dataRank = dataType.getRank();
+  int64_t reducedRank = reducedType.getRank();
+  constexpr int64_t numLanes = ARG_REDUCTION_NUM_LANES;
+  int64_t reducedSize = dataType.getShape()[dataRank - 1];
+  int64_t numBlocks = reducedSize / numLanes;
+  int64_t remainderStart = numBlocks * numLanes;
+
+  Value zeroIndex = create.math.constantIndex(0);
+  Value numLanesVal = create.math.constantIndex(numLanes);
+
+  // Loop over the non-reduced input dimensions, one output element each.
+  ValueRange outerDef = create.krnl.defineLoops(dataRank - 1);
+  if (enableParallel && dataRank > 1)
+    create.krnl.parallel(outerDef);
+  SmallVector<Value, 4> outerLbs(dataRank - 1, zeroIndex);
+  SmallVector<Value, 4> outerUbs;
+  for (int64_t i = 0; i < dataRank - 1; ++i)
+    outerUbs.emplace_back(create.mem.dim(data, i));
+  create.krnl.iterate(outerDef, outerDef, outerLbs, outerUbs,
+      [&](KrnlBuilder &createKrnl, ValueRange outerIVs) {
+        MemRefBuilder createMem(createKrnl);
+        Value bestVals = createMem.alignedAlloca(
+            MemRefType::get({numLanes}, dataElementType));
+        Value bestIdxs = createMem.alignedAlloca(
+            MemRefType::get({numLanes}, reducedElementType));
+        // Seed each lane from the first block.
+        for (int64_t u = 0; u < numLanes; ++u) {
+          Value lane = create.math.constantIndex(u);
+          SmallVector<Value, 4> inIVs(outerIVs.begin(), outerIVs.end());
+          inIVs.emplace_back(lane);
+          createKrnl.store(createKrnl.load(data, inIVs), bestVals, {lane});
+          createKrnl.store(
+              create.math.constant(reducedElementType, u), bestIdxs, {lane});
+        }
+        // Walk the reduced axis in blocks of independent lanes; within a
+        // lane the strict compare keeps the first occurrence since indices
+        // only grow.
+        ValueRange blockDef = createKrnl.defineLoops(1);
+        createKrnl.iterate(blockDef, blockDef,
+            {create.math.constantIndex(1)},
+            {create.math.constantIndex(numBlocks)},
+            [&](KrnlBuilder &createKrnl, ValueRange blockIV) {
+              Value base = create.math.mul(blockIV[0], numLanesVal);
+              for (int64_t u = 0; u < numLanes; ++u) {
+                Value lane = create.math.constantIndex(u);
+                Value idx = create.math.add(base, lane);
+                SmallVector<Value, 4> inIVs(outerIVs.begin(), outerIVs.end());
+                inIVs.emplace_back(idx);
+                Value next = createKrnl.load(data, inIVs);
+                Value best = createKrnl.load(bestVals, {lane});
+                Value cond = getCondition<ARG_OP>(create.math, next, best);
+                Value pos = create.math.cast(reducedElementType, idx);
+                Value bestIdx = createKrnl.load(bestIdxs, {lane});
+                createKrnl.store(
+                    create.math.select(cond, next, best), bestVals, {lane});
+                createKrnl.store(
+                    create.math.select(cond, pos, bestIdx), bestIdxs, {lane});
+              }
+            });
+        // Fold any remainder iterations into the first lane.
+        for (int64_t i = remainderStart; i < reducedSize; ++i) {
+          SmallVector<Value, 4> inIVs(outerIVs.begin(), outerIVs.end());
+          inIVs.emplace_back(create.math.constantIndex(i));
+          Value next = createKrnl.load(data, inIVs);
+          Value best = createKrnl.load(bestVals, {zeroIndex});
+          Value cond = getCondition<ARG_OP>(create.math, next, best);
+          Value pos = create.math.constant(reducedElementType, i);
+          Value bestIdx = createKrnl.load(bestIdxs, {zeroIndex});
+          createKrnl.store(
+              create.math.select(cond, next, best), bestVals, {zeroIndex});
+          createKrnl.store(
+              create.math.select(cond, pos, bestIdx), bestIdxs, {zeroIndex});
+        }
+        // Combine the lanes pairwise, halving the number of live lanes until
+        // lane 0 holds the final index. On equal values the smaller index
+        // wins, so the result is the first occurrence over the whole axis.
+        for (int64_t stride = numLanes / 2; stride >= 1; stride /= 2)
+          for (int64_t u = 0; u < stride; ++u) {
+            Value lane = create.math.constantIndex(u);
+            Value other = create.math.constantIndex(u + stride);
+            Value lhsVal = createKrnl.load(bestVals, {lane});
+            Value rhsVal = createKrnl.load(bestVals, {other});
+            Value lhsIdx = createKrnl.load(bestIdxs, {lane});
+            Value rhsIdx = createKrnl.load(bestIdxs, {other});
+            Value takeRhs = create.math.ori(
+                getCondition<ARG_OP>(create.math, rhsVal, lhsVal),
+                create.math.andi(create.math.eq(rhsVal, lhsVal),
+                    create.math.slt(rhsIdx, lhsIdx)));
+            createKrnl.store(
+                create.math.select(takeRhs, rhsVal, lhsVal), bestVals, {lane});
+            createKrnl.store(
+                create.math.select(takeRhs, rhsIdx, lhsIdx), bestIdxs, {lane});
+          }
+        Value result = createKrnl.load(bestIdxs, {zeroIndex});
+        // The reduced axis is innermost, so the output indices come straight
+        // from the outer induction variables.
+        SmallVector<Value, 4> outIVs;
+        for (int64_t i = 0; i < reducedRank; ++i) {
+          auto mapEntry = outInDimMap.find(i);
+          if (mapEntry != outInDimMap.end())
+            outIVs.emplace_back(outerIVs[mapEntry->second]);
+          else
+            outIVs.emplace_back(zeroIndex);
+        }
+        createKrnl.store(result, alloc, outIVs);
+      });
+}
+
 template <typename ARG_OP>
 struct ONNXArgMinMaxOpLowering : public ConversionPattern {
-  ONNXArgMinMaxOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
-      : ConversionPattern(typeConverter, ARG_OP::getOperationName(), 1, ctx) {}
+  bool enableParallel = false;
+
+  ONNXArgMinMaxOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel)
+      : ConversionPattern(typeConverter, ARG_OP::getOperationName(), 1, ctx),
+        enableParallel(enableParallel) {}
 
   LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
       ConversionPatternRewriter &rewriter) const final {
@@ -87,6 +237,15 @@ struct ONNXArgMinMaxOpLowering : public ConversionPattern {
     Value alloc = insertAllocAndDeallocSimple(
         rewriter, op, reducedMemRefType, loc, outputDims);
 
+    // With a large static innermost axis, use the lane-parallel schedule
+    // instead of the single compare-and-update cell below.
+    if (isInnermostArgReduction(dataType, axis)) {
+      emitInnermostArgReduction<ARG_OP>(rewriter, loc, data, alloc,
+          reducedElementType, outInDimMap, enableParallel);
+      rewriter.replaceOp(op, alloc);
+      return success();
+    }
+
     // Constant Value
     Value minusOne = create.math.constant(reducedElementType, -1);
     Value zero = create.math.constant(reducedElementType, 0);
@@ -151,11 +310,11 @@ struct ONNXArgMinMaxOpLowering : public ConversionPattern {
 };
 
 void populateLoweringONNXArgMinMaxOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx) {
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel) {
   patterns.insert<ONNXArgMinMaxOpLowering<mlir::ONNXArgMinOp>>(
-      typeConverter, ctx);
+      typeConverter, ctx, enableParallel);
   patterns.insert<ONNXArgMinMaxOpLowering<mlir::ONNXArgMaxOp>>(
-      typeConverter, ctx);
+      typeConverter, ctx, enableParallel);
 }
 
 } // namespace onnx_mlir
@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------------- Custom.cpp - Custom Op -----------------------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file lowers the ONNX Custom Operator to a Krnl call. Only the custom
+// operations that name a function provided by the onnx-mlir runtime are
+// lowered; today these are the tensor-parallel collectives emitted by the
+// shard-tensor-parallel pass.
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/Conversion/ONNXToKrnl/ONNXToKrnlCommon.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+struct ONNXCustomOpLowering : public ConversionPattern {
+  ONNXCustomOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+      : ConversionPattern(
+            typeConverter, ONNXCustomOp::getOperationName(), 1, ctx) {}
+
+  LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const final {
+    auto customOp = cast<ONNXCustomOp>(op);
+    StringRef funcName = customOp.function_name();
+    // Only runtime-provided functions have a known implementation to call.
+    if (!funcName.startswith("omTensorParallel"))
+      return failure();
+    if (op->getNumResults() != 1)
+      return failure();
+
+    // Convert the output type to MemRefType.
+    Type convertedType = typeConverter->convertType(*op->result_type_begin());
+    assert(convertedType && convertedType.isa<MemRefType>() &&
+           "Failed to convert type to MemRefType");
+    MemRefType memRefType = convertedType.cast<MemRefType>();
+    if (!hasAllConstantDimensions(memRefType))
+      return failure();
+
+    Location loc = op->getLoc();
+    bool insertDealloc = checkInsertDealloc(op);
+    Value alloc =
+        insertAllocAndDealloc(memRefType, loc, rewriter, insertDealloc);
+
+    // The runtime function receives the output, the inputs, and the integer
+    // attributes of the custom operation in attribute-name order. The
+    // function_name attribute itself is not forwarded.
+    auto callOp = rewriter.create<KrnlCallOp>(
+        loc, funcName.str(), alloc, op, operands, /*copyAttrs=*/false);
+    for (NamedAttribute namedAttr : op->getAttrs())
+      if (namedAttr.getValue().isa<IntegerAttr>())
+        callOp->setAttr(namedAttr.getName(), namedAttr.getValue());
+
+    rewriter.replaceOp(op, alloc);
+    return success();
+  }
+};
+
+void populateLoweringONNXCustomOpPattern(RewritePatternSet &patterns,
+    TypeConverter &typeConverter, MLIRContext *ctx) {
+  patterns.insert<ONNXCustomOpLowering>(typeConverter, ctx);
+}
+
+} // namespace onnx_mlir
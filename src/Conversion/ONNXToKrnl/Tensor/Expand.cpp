@@ -46,6 +46,20 @@ struct ONNXExpandOpLowering : public ConversionPattern {
     Value alloc = insertAllocAndDeallocSimple(
         rewriter, op, outputMemRefType, loc, shapeHelper.getOutputDims());
 
+    // When both shapes are static, the expansion only replicates contiguous
+    // blocks of the input, so it can be lowered as block copies that read
+    // each input element once instead of one load and store per output
+    // element. Require identity layouts so contiguity reasoning holds.
+    MemRefType inputMemRefType = input.getType().cast<MemRefType>();
+    if (inputMemRefType.hasStaticShape() && outputMemRefType.hasStaticShape() &&
+        inputMemRefType.getLayout().isIdentity() &&
+        outputMemRefType.getLayout().isIdentity()) {
+      expandByBlockCopies(
+          rewriter, loc, input, alloc, inputMemRefType, outputMemRefType);
+      rewriter.replaceOp(op, alloc);
+      return success();
+    }
+
     // Iterate over the output values.
     KrnlBuilder createKrnl(rewriter, loc);
     ValueRange outputLoopDef = createKrnl.defineLoops(outputRank);
@@ -67,6 +81,130 @@ struct ONNXExpandOpLowering : public ConversionPattern {
     rewriter.replaceOp(op, alloc);
     return success();
   }
+
+private:
+  // Lower a static-shape expand with block copies. Right-aligned, the
+  // trailing dimensions the input and output share form a contiguous block,
+  // and the innermost dimension where the shapes differ — necessarily of
+  // input extent 1 — replicates that block. That dimension becomes the
+  // innermost loop, so each block element is read once and stored to all of
+  // its replicas; reads and stores are vectorized along the last output
+  // dimension when its extent is a multiple of the machine vector length.
+  // An expand whose dimensions all match degenerates to a single memcpy.
+  void expandByBlockCopies(ConversionPatternRewriter &rewriter, Location loc,
+      Value input, Value alloc, MemRefType inputMemRefType,
+      MemRefType outputMemRefType) const {
+    MultiDialectBuilder<KrnlBuilder, VectorBuilder> create(rewriter, loc);
+    Type elementType = outputMemRefType.getElementType();
+    int64_t outputRank = outputMemRefType.getRank();
+    int64_t inputRank = inputMemRefType.getRank();
+    ArrayRef<int64_t> outputShape = outputMemRefType.getShape();
+    // Right-align the input shape to the output rank.
+    SmallVector<int64_t, 4> inputShape(outputRank, 1);
+    for (int64_t i = 0; i < inputRank; ++i)
+      inputShape[outputRank - inputRank + i] = inputMemRefType.getShape()[i];
+
+    // Innermost dimension that actually expands. Every dimension to its
+    // right matches the input, so the replicated block is contiguous.
+    int64_t expandDim = -1;
+    for (int64_t i = outputRank - 1; i >= 0 && expandDim == -1; --i)
+      if (inputShape[i] != outputShape[i])
+        expandDim = i;
+    if (expandDim == -1) {
+      // Collapse a no-op expand into one copy of the whole buffer.
+      Value sizeInBytes = getDynamicMemRefSizeInBytes(rewriter, loc, input);
+      create.krnl.memcpy(alloc, input, sizeInBytes);
+      return;
+    }
+    int64_t repetitions = outputShape[expandDim];
+
+    // Vectorize along the last output dimension: wide loads of the block
+    // when the expanded dimension lies further out, wide replicated stores
+    // of a splat when the last dimension is the expanded one itself.
+    int64_t VL = create.vec.getMachineVectorLength(elementType);
+    int64_t lastDimSize = outputShape[outputRank - 1];
+    bool simdize = VL > 1 && lastDimSize >= VL && lastDimSize % VL == 0;
+    bool simdBlock = simdize && expandDim != outputRank - 1;
+    bool simdSplat = simdize && expandDim == outputRank - 1;
+    VectorType vecType =
+        simdize ? VectorType::get({VL}, elementType) : VectorType();
+
+    // Loops over every output dimension except the expanded one, the last
+    // one blocked by the vector length when the block loads are vectorized.
+    int64_t numOuterLoops = outputRank - 1;
+    SmallVector<int64_t, 4> outerDims;
+    SmallVector<IndexExpr, 4> lbs, ubs;
+    for (int64_t i = 0; i < outputRank; ++i)
+      if (i != expandDim) {
+        outerDims.push_back(i);
+        lbs.emplace_back(LiteralIndexExpr(0));
+        ubs.emplace_back(LiteralIndexExpr(outputShape[i]));
+      }
+
+    // Emitted once per block element (per vector of them when vectorized):
+    // read the input once, then store it along the expanded dimension.
+    auto emitReplication = [&](KrnlBuilder &createKrnl,
+                               ValueRange outerInd) {
+      MultiDialectBuilder<KrnlBuilder, VectorBuilder> create(createKrnl);
+      IndexExprScope blockScope(createKrnl);
+      SmallVector<IndexExpr, 4> inputAccess;
+      for (int64_t j = 0; j < inputRank; ++j) {
+        int64_t i = outputRank - inputRank + j;
+        if (inputShape[i] == 1)
+          inputAccess.emplace_back(LiteralIndexExpr(0));
+        else
+          inputAccess.emplace_back(
+              DimIndexExpr(outerInd[i < expandDim ? i : i - 1]));
+      }
+      Value val;
+      if (simdBlock)
+        val = create.vec.loadIE(vecType, input, inputAccess, {});
+      else
+        val = create.krnl.loadIE(input, inputAccess);
+      if (simdSplat)
+        val = create.vec.broadcast(vecType, val);
+
+      ValueRange repLoopDef = create.krnl.defineLoops(1);
+      SmallVector<Value, 1> optimizedRepLoop(
+          repLoopDef.begin(), repLoopDef.end());
+      if (simdSplat) {
+        ValueRange blockedRepLoop = create.krnl.block(repLoopDef[0], VL);
+        optimizedRepLoop[0] = blockedRepLoop[0];
+      }
+      create.krnl.iterateIE(repLoopDef, optimizedRepLoop, {LiteralIndexExpr(0)},
+          {LiteralIndexExpr(repetitions)},
+          [&](KrnlBuilder &createKrnl, ValueRange repInd) {
+            MultiDialectBuilder<KrnlBuilder, VectorBuilder> create(createKrnl);
+            IndexExprScope repScope(createKrnl);
+            SmallVector<IndexExpr, 4> outputAccess(
+                outputRank, LiteralIndexExpr(0));
+            for (int64_t p = 0; p < numOuterLoops; ++p)
+              outputAccess[outerDims[p]] = DimIndexExpr(outerInd[p]);
+            outputAccess[expandDim] = DimIndexExpr(repInd[0]);
+            if (simdize)
+              create.vec.storeIE(val, alloc, outputAccess, {});
+            else
+              create.krnl.storeIE(val, alloc, outputAccess);
+          });
+    };
+
+    if (numOuterLoops == 0) {
+      emitReplication(create.krnl, {});
+      return;
+    }
+    ValueRange outerLoopDef = create.krnl.defineLoops(numOuterLoops);
+    SmallVector<Value, 4> optimizedLoops(
+        outerLoopDef.begin(), outerLoopDef.end());
+    if (simdBlock) {
+      ValueRange blockedLastLoop =
+          create.krnl.block(outerLoopDef[numOuterLoops - 1], VL);
+      optimizedLoops[numOuterLoops - 1] = blockedLastLoop[0];
+    }
+    create.krnl.iterateIE(outerLoopDef, optimizedLoops, lbs, ubs,
+        [&](KrnlBuilder &createKrnl, ValueRange outerInd) {
+          emitReplication(createKrnl, outerInd);
+        });
+  }
 };
 
 void populateLoweringONNXExpandOpPattern(RewritePatternSet &patterns,
@@ -83,6 +83,27 @@ struct ONNXFlattenOpLowering : public ConversionPattern {
            "Failed to convert type to MemRefType");
     MemRefType outputMemRefType = convertedType.cast<MemRefType>();
 
+    // Flatten only regroups dimensions: on a contiguous (identity layout)
+    // input the result is the same buffer viewed through a different shape,
+    // exactly like Reshape, so emit a zero-copy view. The copy loop below
+    // only remains for inputs with a non-identity layout.
+    if (inputTy.getLayout().isIdentity()) {
+      IndexExprScope outerScope(&rewriter, loc);
+      IndexExprBuilderForKrnl createIE(rewriter, loc);
+      // Output is 2-D: the product of the dims before the axis times the
+      // product of the remaining dims. Materialize both as index exprs so
+      // dynamic dims become memref.dim values.
+      DimsExpr outputDims = {LiteralIndexExpr(1), LiteralIndexExpr(1)};
+      for (int64_t i = 0; i < axisValue; ++i)
+        outputDims[0] = outputDims[0] * createIE.getShapeAsDim(input, i);
+      for (int64_t i = axisValue; i < (int64_t)inputRank; ++i)
+        outputDims[1] = outputDims[1] * createIE.getShapeAsDim(input, i);
+      Value newView = emitMemRefReinterpretCastOp(
+          rewriter, loc, input, outputDims, convertedType);
+      rewriter.replaceOp(op, newView);
+      return success();
+    }
+
     // Insert alloc and dealloc
     bool insertDealloc = checkInsertDealloc(op);
     Value alloc = (hasAllConstantDimensions(outputMemRefType))
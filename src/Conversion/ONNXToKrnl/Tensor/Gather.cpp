@@ -20,17 +20,20 @@ using namespace mlir;
 namespace onnx_mlir {
 
 struct ONNXGatherOpLowering : public ConversionPattern {
-  ONNXGatherOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+  ONNXGatherOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel)
       : ConversionPattern(
-            typeConverter, mlir::ONNXGatherOp::getOperationName(), 1, ctx) {}
+            typeConverter, mlir::ONNXGatherOp::getOperationName(), 1, ctx),
+        enableParallel(enableParallel) {}
+  bool enableParallel;
 
   LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
       ConversionPatternRewriter &rewriter) const final {
     ONNXGatherOpAdaptor operandAdaptor(operands);
     ONNXGatherOp gatherOp = cast<ONNXGatherOp>(op);
     Location loc = op->getLoc();
-    MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl> create(
-        rewriter, loc);
+    MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl, VectorBuilder>
+        create(rewriter, loc);
 
     // Get shape.
     ONNXGatherOpShapeHelper shapeHelper(op, operands, &create.krnlIE);
@@ -50,8 +53,10 @@ struct ONNXGatherOpLowering : public ConversionPattern {
     Value data = operandAdaptor.data();
     Value indices = operandAdaptor.indices();
     int64_t axisLit = gatherOp.axis();
-    int64_t dataRank = data.getType().cast<MemRefType>().getRank();
+    MemRefType dataMemRefType = data.getType().cast<MemRefType>();
+    int64_t dataRank = dataMemRefType.getRank();
     int64_t indicesRank = indices.getType().cast<MemRefType>().getRank();
+    Type elementType = outputMemRefType.getElementType();
 
     // Determine whether indices may be negative.
     bool indicesMayBeNegative = !indicesAreNonNegativeConstants(indices);
@@ -68,6 +73,24 @@ struct ONNXGatherOpLowering : public ConversionPattern {
     DimsExpr dataDims;
     create.krnlIE.getShapeAsDims(data, dataDims);
 
+    // When the gather axis is not the last data dimension, each gathered
+    // slice is a contiguous run over the innermost data dimension and can be
+    // copied with wide vector loads/stores instead of scalar element moves.
+    // Require identity layouts and a static innermost dimension that is a
+    // whole number of vectors long.
+    int64_t VL = 0;
+    if (axisLit < dataRank - 1 && elementType.isa<FloatType>() &&
+        dataMemRefType.getLayout().isIdentity() &&
+        outputMemRefType.getLayout().isIdentity()) {
+      int64_t innermostDim = dataMemRefType.getShape()[dataRank - 1];
+      int64_t machineVL = create.vec.getMachineVectorLength(elementType);
+      if (innermostDim != ShapedType::kDynamicSize && machineVL > 1 &&
+          innermostDim % machineVL == 0)
+        VL = machineVL;
+    }
+    VectorType vecType =
+        (VL > 0) ? VectorType::get({VL}, elementType) : VectorType();
+
     /*
       The pattern that we are using is that of numpy.take.
 
@@ -78,11 +101,24 @@ struct ONNXGatherOpLowering : public ConversionPattern {
           for kk in ndindex(Nk):
             out[ii + jj + kk] = data[ii + (indices[jj],) + kk]
     */
-    // Define loops and iteration trip counts (equivalent to size of output)
+    // Define loops and iteration trip counts (equivalent to size of output).
+    // The innermost loop is blocked by the vector length when vectorizing;
+    // the outermost one iterates over independent slices and may run in
+    // parallel.
     ValueRange loopDef = create.krnl.defineLoops(outputRank);
     DimsExpr lbs(outputRank, zeroIE);
-    create.krnl.iterateIE(loopDef, loopDef, lbs, shapeHelper.getOutputDims(),
+    SmallVector<Value, 4> optimizedLoopDef(loopDef.begin(), loopDef.end());
+    if (VL > 0) {
+      ValueRange blockedLoopDef =
+          create.krnl.block(loopDef[outputRank - 1], VL);
+      optimizedLoopDef[outputRank - 1] = blockedLoopDef[0];
+    }
+    if (enableParallel && (VL == 0 || outputRank > 1))
+      create.krnl.parallel(loopDef[0]);
+    create.krnl.iterateIE(loopDef, optimizedLoopDef, lbs,
+        shapeHelper.getOutputDims(),
         [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+          MultiDialectBuilder<KrnlBuilder, VectorBuilder> create(createKrnl);
           // Insert code inside the loop.
           IndexExprScope innerLoopScope(createKrnl);
           SymbolIndexExpr axisDim(dataDims[axisLit]);
@@ -112,10 +148,17 @@ struct ONNXGatherOpLowering : public ConversionPattern {
           // Then add kks.
           for (int k = axisLit + 1; k < dataRank; ++k)
             dataAccessFct.emplace_back(outputAccessFct[kIndexStart + k]);
-          Value dataVal = createKrnl.loadIE(data, dataAccessFct);
 
-          // Save data into output
-          createKrnl.storeIE(dataVal, alloc, outputAccessFct);
+          if (VL > 0) {
+            // Copy one vector of the gathered slice per iteration.
+            Value dataVec =
+                create.vec.loadIE(vecType, data, dataAccessFct, /*offsets=*/{});
+            create.vec.storeIE(dataVec, alloc, outputAccessFct, /*offsets=*/{});
+          } else {
+            Value dataVal = createKrnl.loadIE(data, dataAccessFct);
+            // Save data into output
+            createKrnl.storeIE(dataVal, alloc, outputAccessFct);
+          }
         });
     rewriter.replaceOp(op, alloc);
     return success();
@@ -123,8 +166,8 @@ struct ONNXGatherOpLowering : public ConversionPattern {
 };
 
 void populateLoweringONNXGatherOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx) {
-  patterns.insert<ONNXGatherOpLowering>(typeConverter, ctx);
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel) {
+  patterns.insert<ONNXGatherOpLowering>(typeConverter, ctx, enableParallel);
 }
 
 } // namespace onnx_mlir
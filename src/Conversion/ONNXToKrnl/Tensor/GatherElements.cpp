@@ -19,6 +19,29 @@ using namespace mlir;
 
 namespace onnx_mlir {
 
+// Test whether the index value is provably invariant in the dimensions after
+// the gather axis. This holds when the ONNX-level indices tensor is an Expand
+// of a tensor with extent 1 in all of those dimensions: beam-search KV-cache
+// reordering expands a per-beam index vector over the cached inner slices.
+// Expand broadcasts numpy-style, so the input shape is aligned to the right.
+static bool indicesInvariantInInnerDims(Value indices, int64_t axis) {
+  auto expandOp = indices.getDefiningOp<ONNXExpandOp>();
+  if (!expandOp)
+    return false;
+  Value expandInput = expandOp.input();
+  auto inputType = expandInput.getType().dyn_cast<RankedTensorType>();
+  auto indicesType = indices.getType().dyn_cast<RankedTensorType>();
+  if (!inputType || !indicesType)
+    return false;
+  int64_t rankDiff = indicesType.getRank() - inputType.getRank();
+  for (int64_t d = axis + 1; d < indicesType.getRank(); ++d) {
+    int64_t inputDim = d - rankDiff;
+    if (inputDim >= 0 && inputType.getShape()[inputDim] != 1)
+      return false;
+  }
+  return true;
+}
+
 struct ONNXGatherElementsOpLowering : public ConversionPattern {
   ONNXGatherElementsOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
       : ConversionPattern(
@@ -66,6 +89,70 @@ struct ONNXGatherElementsOpLowering : public ConversionPattern {
     create.krnlIE.getShapeAsDims(data, dataDims);
     create.krnlIE.getShapeAsDims(indices, indicesDims);
 
+    // Blocked specialization: when the index value is invariant in the
+    // dimensions after the gather axis, load and normalize it once per outer
+    // iteration and copy the whole inner slice with a perfectly nested loop,
+    // instead of re-reading the index per element. The inner loops carry no
+    // data-dependent accesses, so the later affine and SIMD passes treat
+    // them as a plain block copy.
+    if (axis < dataRank - 1 &&
+        indicesInvariantInInnerDims(gatherElementsOp.indices(), axis)) {
+      int64_t outerRank = axis + 1;
+      int64_t innerRank = indicesRank - outerRank;
+      ValueRange outerLoopDef = create.krnl.defineLoops(outerRank);
+      DimsExpr outerLbs(outerRank, LiteralIndexExpr(0));
+      DimsExpr outerUbs(indicesDims.begin(), indicesDims.begin() + outerRank);
+      create.krnl.iterateIE(outerLoopDef, outerLoopDef, outerLbs, outerUbs,
+          [&](KrnlBuilder &createKrnl, ValueRange outerInd) {
+            IndexExprScope outerScope(createKrnl);
+
+            // Compute index = indices[i]...[k][0]...[0]; the trailing
+            // dimensions are invariant, so any inner coordinate would do.
+            DimsExpr idxAccessFct;
+            getIndexExprList<DimIndexExpr>(outerInd, idxAccessFct);
+            for (int64_t i = 0; i < innerRank; ++i)
+              idxAccessFct.emplace_back(LiteralIndexExpr(0));
+            Value indexVal = createKrnl.loadIE(indices, idxAccessFct);
+            IndexExpr index = NonAffineIndexExpr(indexVal);
+
+            if (indicesMayBeNegative) {
+              LiteralIndexExpr zero(0);
+              SymbolIndexExpr axisDim(dataDims[axis]);
+              index = index.selectOrSelf(index < zero, index + axisDim);
+            }
+            Value gatherIndex = index.getValue();
+
+            // Copy the inner slice selected by the index.
+            ValueRange innerLoopDef = createKrnl.defineLoops(innerRank);
+            DimsExpr innerLbs(innerRank, LiteralIndexExpr(0));
+            DimsExpr innerUbs;
+            for (int64_t i = outerRank; i < indicesRank; ++i)
+              innerUbs.emplace_back(SymbolIndexExpr(indicesDims[i]));
+            createKrnl.iterateIE(innerLoopDef, innerLoopDef, innerLbs,
+                innerUbs, [&](KrnlBuilder &innerKrnl, ValueRange innerInd) {
+                  IndexExprScope innerScope(innerKrnl);
+                  DimsExpr accessFct, dataAccessFct;
+                  for (int64_t i = 0; i < outerRank; ++i) {
+                    DimIndexExpr outerIV(outerInd[i]);
+                    accessFct.emplace_back(outerIV);
+                    dataAccessFct.emplace_back(
+                        (i == axis) ? NonAffineIndexExpr(gatherIndex)
+                                    : outerIV);
+                  }
+                  for (int64_t i = 0; i < innerRank; ++i) {
+                    DimIndexExpr innerIV(innerInd[i]);
+                    accessFct.emplace_back(innerIV);
+                    dataAccessFct.emplace_back(innerIV);
+                  }
+                  Value dataVal = innerKrnl.loadIE(data, dataAccessFct);
+                  innerKrnl.storeIE(dataVal, output, accessFct);
+                });
+          });
+
+      rewriter.replaceOp(op, output);
+      return success();
+    }
+
     // Gather elements from the 'data' tensor, store them into the output.
     //   index = indices[i][j]...[n]
     //   output[i][j]...[n] = data[i][j]..[index]..[n] (index used at axis dim.)
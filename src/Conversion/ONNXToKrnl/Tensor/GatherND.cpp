@@ -24,9 +24,12 @@ using namespace mlir;
 namespace onnx_mlir {
 
 struct ONNXGatherNDOpLowering : public ConversionPattern {
-  ONNXGatherNDOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+  ONNXGatherNDOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel)
       : ConversionPattern(
-            typeConverter, ONNXGatherNDOp::getOperationName(), 1, ctx) {}
+            typeConverter, ONNXGatherNDOp::getOperationName(), 1, ctx),
+        enableParallel(enableParallel) {}
+  bool enableParallel;
 
   // When true causes injection of print stmts in the generated code.
   static constexpr bool emitPrintStmts = false;
@@ -49,8 +52,8 @@ struct ONNXGatherNDOpLowering : public ConversionPattern {
     ONNXGatherNDOpAdaptor operandAdaptor(operands);
     ONNXGatherNDOp gatherNDOp = cast<ONNXGatherNDOp>(op);
     Location loc = op->getLoc();
-    MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl, MathBuilder,
-        MemRefBuilder>
+    MultiDialectBuilder<KrnlBuilder, IndexExprBuilderForKrnl, MemRefBuilder,
+        VectorBuilder>
         create(rewriter, loc);
     IndexExprScope outerScope(&rewriter, loc);
 
@@ -124,22 +127,43 @@ struct ONNXGatherNDOpLowering : public ConversionPattern {
     Value outputDataBuffer = create.mem.alloc(
         MemRefType::get({outputDimsSize}, outputMemRefType.getElementType()));
 
-    // Initialize the index used to store the result values.
-    Value iZero = create.math.constantIndex(0);
-    Value iOne = create.math.constantIndex(1);
-    Value storeIndex =
-        create.mem.alloca(MemRefType::get({}, rewriter.getIndexType()));
-    create.krnl.store(iZero, storeIndex);
+    // Each index tuple contributes 'sliceLen' consecutive elements to the
+    // output buffer: a single element when indices.shape[-1] addresses
+    // individual elements of 'data', a full innermost slice otherwise. Since
+    // the tuples are visited in row-major order, the flat output position of
+    // each tuple is a pure function of the loop indices, which keeps the
+    // iterations independent of each other.
+    const int64_t numTuplesPerBatch =
+        indicesDimsSize / (batchDimsSize * indicesLastDim);
+    const int64_t sliceLen =
+        (indicesLastDim == dataRank - b) ? 1 : dataShape[dataRank - 1];
+
+    // Slices that are a whole number of vectors long are copied with wide
+    // vector loads/stores instead of scalar element moves. Both the reshaped
+    // data and the output buffer are contiguous by construction.
+    Type elementType = outputMemRefType.getElementType();
+    int64_t VL = 0;
+    if (sliceLen > 1 && elementType.isa<FloatType>()) {
+      int64_t machineVL = create.vec.getMachineVectorLength(elementType);
+      if (machineVL > 1 && sliceLen % machineVL == 0)
+        VL = machineVL;
+    }
+    VectorType vecType =
+        (VL > 0) ? VectorType::get({VL}, elementType) : VectorType();
 
     // for (i,j) in (0..reshapedIndices.shape[0]), 0..reshapedIndices.shape[1])
     // {
     //   idx = tuple(reshapedIndices[i][j])
-    //   output.append(reshapedData[(i,) + idx])
+    //   output[(i * IDS + j) * sliceLen ...] = reshapedData[(i,) + idx]
     // }
     // output.reshape(outputShape)
     ValueRange loopDef = create.krnl.defineLoops(2);
     DimsExpr lbs(2, LiteralIndexExpr(0)),
         ubs = {newIndicesShape[0], newIndicesShape[1]};
+    // Index tuples write to disjoint ranges of the output buffer, so the loop
+    // over the tuples may run in parallel.
+    if (enableParallel)
+      create.krnl.parallel(loopDef[1]);
 
     if (emitPrintStmts) {
       create.krnl.printTensor("reshapedIndices: ", reshapedIndices);
@@ -186,6 +210,13 @@ struct ONNXGatherNDOpLowering : public ConversionPattern {
             reshapedDataAccessFct.emplace_back(index);
           }
 
+          // Flat position in 'outputDataBuffer' of the result for the
+          // current index tuple.
+          IndexExpr flatBase =
+              (DimIndexExpr(loopInd[0]) * LiteralIndexExpr(numTuplesPerBatch) +
+                  DimIndexExpr(loopInd[1])) *
+              LiteralIndexExpr(sliceLen);
+
           if (indicesLastDim == dataRank - b) {
             // When indices.shape[-1] is equal to (rank(data) - b) the
             // `reshapedDataAccessFct` computed so far has the same number of
@@ -199,21 +230,20 @@ struct ONNXGatherNDOpLowering : public ConversionPattern {
             // Gather value from the 'data' tensor and store it into
             // 'outputDataBuffer'.
             Value val = createKrnl.loadIE(reshapedData, reshapedDataAccessFct);
-            Value storeIndexVal = createKrnl.load(storeIndex);
-            createKrnl.store(val, outputDataBuffer, storeIndexVal);
-
-            // Bump up the storeIndex.
-            createKrnl.store(create.math.add(storeIndexVal, iOne), storeIndex);
+            createKrnl.storeIE(val, outputDataBuffer, {flatBase});
           } else {
             assert((indicesLastDim < dataRank - b) &&
                    "Expecting indices.shape[-1] to be smaller than "
                    "rank(indices) - b");
 
             // When indices.shape[-1] is less than (rank(data) - b) the
-            // `reshapedDataAccessFct` computed so far yields a slice which
-            // needs to be inserted into the output buffer.
+            // `reshapedDataAccessFct` computed so far yields a contiguous
+            // slice which needs to be inserted into the output buffer. Copy
+            // it one vector at a time when the slice length permits,
+            // otherwise one element at a time.
             int64_t reshapedDataLastDim = dataShape[dataRank - 1];
-            for (int64_t i = 0; i < reshapedDataLastDim; ++i) {
+            int64_t step = (VL > 0) ? VL : 1;
+            for (int64_t i = 0; i < reshapedDataLastDim; i += step) {
               IndexExpr ind = LiteralIndexExpr(i);
               reshapedDataAccessFct.emplace_back(ind);
               assert(
@@ -223,6 +253,17 @@ struct ONNXGatherNDOpLowering : public ConversionPattern {
               if (emitPrintStmts)
                 printIndices("data indices", reshapedDataAccessFct, createKrnl);
 
+              if (VL > 0) {
+                // Gather one vector of the slice from the 'data' tensor and
+                // store it into 'outputDataBuffer'.
+                Value vec = create.vec.loadIE(
+                    vecType, reshapedData, reshapedDataAccessFct, {});
+                reshapedDataAccessFct.pop_back();
+                create.vec.storeIE(vec, outputDataBuffer,
+                    {flatBase + LiteralIndexExpr(i)}, {});
+                continue;
+              }
+
               // Gather value from the 'data' tensor and store it into
               // 'outputDataBuffer'.
               Value val =
@@ -234,12 +275,8 @@ struct ONNXGatherNDOpLowering : public ConversionPattern {
                 createKrnl.printf("\n");
               }
 
-              Value storeIndexVal = createKrnl.load(storeIndex);
-              createKrnl.store(val, outputDataBuffer, storeIndexVal);
-
-              // Bump up the storeIndex.
-              createKrnl.store(
-                  create.math.add(storeIndexVal, iOne), storeIndex);
+              createKrnl.storeIE(
+                  val, outputDataBuffer, {flatBase + LiteralIndexExpr(i)});
             }
           }
         });
@@ -262,8 +299,8 @@ struct ONNXGatherNDOpLowering : public ConversionPattern {
 };
 
 void populateLoweringONNXGatherNDOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx) {
-  patterns.insert<ONNXGatherNDOpLowering>(typeConverter, ctx);
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel) {
+  patterns.insert<ONNXGatherNDOpLowering>(typeConverter, ctx, enableParallel);
 }
 
 } // namespace onnx_mlir
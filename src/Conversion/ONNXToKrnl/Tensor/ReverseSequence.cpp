@@ -52,6 +52,65 @@ struct ONNXReverseSequenceOpLowering : public ConversionPattern {
 
     int64_t outputRank = shapeHelper.getOutputDims().size();
     LiteralIndexExpr oneIE(1);
+    DimsExpr outputDims = shapeHelper.getOutputDims();
+
+    // Blocked specialization: the reversed index only depends on the batch
+    // and time coordinates, so when dimensions follow them (the hidden size
+    // of an RNN input, typically large), split the nest there: the sequence
+    // length load and the select run once per (batch, time) pair, and the
+    // inner loops copy the whole feature block with plain stride-1 accesses
+    // that the later affine and SIMD passes vectorize like any block copy.
+    int64_t splitRank = std::max(batchAxis, timeAxis) + 1;
+    if (splitRank < outputRank) {
+      int64_t innerRank = outputRank - splitRank;
+      ValueRange outerLoopDef = create.krnl.defineLoops(splitRank);
+      DimsExpr outerLbs(splitRank, LiteralIndexExpr(0));
+      DimsExpr outerUbs(outputDims.begin(), outputDims.begin() + splitRank);
+      create.krnl.iterateIE(outerLoopDef, outerLoopDef, outerLbs, outerUbs,
+          [&](KrnlBuilder &createKrnl, ValueRange outerInd) {
+            IndexExprScope outerScope(createKrnl);
+
+            // Reversed time index for this (batch, time) pair.
+            IndexExpr batchIdx = DimIndexExpr(outerInd[batchAxis]);
+            Value lensVal =
+                createKrnl.loadIE(operandAdaptor.sequence_lens(), batchIdx);
+            IndexExpr lens = NonAffineIndexExpr(lensVal);
+            DimIndexExpr timeDim(outerInd[timeAxis]);
+            IndexExpr inputIndex = IndexExpr::select(
+                timeDim < lens, lens - timeDim - oneIE, timeDim);
+            Value inputIndexVal = inputIndex.getValue();
+
+            // Copy the feature block from the reversed position.
+            ValueRange innerLoopDef = createKrnl.defineLoops(innerRank);
+            DimsExpr innerLbs(innerRank, LiteralIndexExpr(0));
+            DimsExpr innerUbs;
+            for (int64_t i = splitRank; i < outputRank; ++i)
+              innerUbs.emplace_back(SymbolIndexExpr(outputDims[i]));
+            createKrnl.iterateIE(innerLoopDef, innerLoopDef, innerLbs,
+                innerUbs, [&](KrnlBuilder &innerKrnl, ValueRange innerInd) {
+                  IndexExprScope innerScope(innerKrnl);
+                  DimsExpr outputAccessFct, inputAccessFct;
+                  for (int64_t i = 0; i < splitRank; ++i) {
+                    DimIndexExpr outerIV(outerInd[i]);
+                    outputAccessFct.emplace_back(outerIV);
+                    inputAccessFct.emplace_back(
+                        (i == timeAxis) ? NonAffineIndexExpr(inputIndexVal)
+                                        : outerIV);
+                  }
+                  for (int64_t i = 0; i < innerRank; ++i) {
+                    DimIndexExpr innerIV(innerInd[i]);
+                    outputAccessFct.emplace_back(innerIV);
+                    inputAccessFct.emplace_back(innerIV);
+                  }
+                  Value inputVal =
+                      innerKrnl.loadIE(operandAdaptor.input(), inputAccessFct);
+                  innerKrnl.storeIE(inputVal, alloc, outputAccessFct);
+                });
+          });
+
+      rewriter.replaceOp(op, alloc);
+      return success();
+    }
 
     /*
       The semantic of ReverseSequence can be expressed in loop as:
@@ -20,9 +20,12 @@ using namespace mlir;
 namespace onnx_mlir {
 
 struct ONNXScatterNDOpLowering : public ConversionPattern {
-  ONNXScatterNDOpLowering(TypeConverter &typeConverter, MLIRContext *ctx)
+  ONNXScatterNDOpLowering(
+      TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel)
       : ConversionPattern(
-            typeConverter, ONNXScatterNDOp::getOperationName(), 1, ctx) {}
+            typeConverter, ONNXScatterNDOp::getOperationName(), 1, ctx),
+        enableParallel(enableParallel) {}
+  bool enableParallel;
 
   LogicalResult matchAndRewrite(Operation *op, ArrayRef<Value> operands,
       ConversionPatternRewriter &rewriter) const final {
@@ -69,13 +72,49 @@ struct ONNXScatterNDOpLowering : public ConversionPattern {
     //   for idx in np.ndindex(update_indices):
     //     output[indices[idx]] = updates[idx]
     //
+    // When the index tuples address only leading dimensions of 'data', each
+    // update slice is a contiguous run over the innermost dimension of both
+    // 'updates' and 'output' and can be copied with wide vector loads/stores
+    // instead of scalar element moves. Require identity layouts and a static
+    // innermost dimension that is a whole number of vectors long.
+    Type elementType = outputMemRefType.getElementType();
+    MemRefType updatesMemRefType = updates.getType().cast<MemRefType>();
+    VectorBuilder createVec(createKrnl);
+    int64_t VL = 0;
+    if (updatesRank == dataRank && dataRank >= indicesRank &&
+        elementType.isa<FloatType>() &&
+        updatesMemRefType.getLayout().isIdentity() &&
+        outputMemRefType.getLayout().isIdentity()) {
+      int64_t innermostDim = updatesMemRefType.getShape()[updatesRank - 1];
+      int64_t machineVL = createVec.getMachineVectorLength(elementType);
+      if (innermostDim != ShapedType::kDynamicSize && machineVL > 1 &&
+          innermostDim == outputMemRefType.getShape()[outputRank - 1] &&
+          innermostDim % machineVL == 0)
+        VL = machineVL;
+    }
+    VectorType vecType =
+        (VL > 0) ? VectorType::get({VL}, elementType) : VectorType();
+
     ValueRange loopDef = createKrnl.defineLoops(updatesRank);
     DimsExpr lbs(updatesRank, LiteralIndexExpr(0)), ubs;
     MemRefBoundsIndexCapture updatesBounds(updates);
     updatesBounds.getDimList(ubs);
-
-    createKrnl.iterateIE(loopDef, loopDef, lbs, ubs,
+    // The innermost loop is blocked by the vector length when vectorizing.
+    SmallVector<Value, 4> optimizedLoopDef(loopDef.begin(), loopDef.end());
+    if (VL > 0) {
+      ValueRange blockedLoopDef =
+          createKrnl.block(loopDef[updatesRank - 1], VL);
+      optimizedLoopDef[updatesRank - 1] = blockedLoopDef[0];
+    }
+    // The ONNX specification requires the index tuples to be unique, so the
+    // iterations write to disjoint elements of the output and the outermost
+    // loop may run in parallel.
+    if (enableParallel && (VL == 0 || updatesRank > 1))
+      createKrnl.parallel(loopDef[0]);
+
+    createKrnl.iterateIE(loopDef, optimizedLoopDef, lbs, ubs,
         [&](KrnlBuilder &createKrnl, ValueRange loopInd) {
+          MultiDialectBuilder<KrnlBuilder, VectorBuilder> create(createKrnl);
           // Insert code inside the loop.
           IndexExprScope innerLoopScope(createKrnl);
 
@@ -85,7 +124,6 @@ struct ONNXScatterNDOpLowering : public ConversionPattern {
           // variable in the loop iteration space.
           DimsExpr indicesAccessFct;
           getIndexExprList<DimIndexExpr>(loopInd, indicesAccessFct);
-          indicesAccessFct.truncate(indicesRank - 1);
 
           // Access function for the output. Let r=rank(data), q=rank(indices).
           // The first indices.shape[-1] indexes are given by looking up the
@@ -94,6 +132,7 @@ struct ONNXScatterNDOpLowering : public ConversionPattern {
           DimsExpr outputAccessFct;
           for (unsigned i = 0; i < dataRank; ++i) {
             if (i < indicesRank - 1) {
+              indicesAccessFct.truncate(indicesRank - 1);
               IndexExpr ind = LiteralIndexExpr(i);
               indicesAccessFct.emplace_back(ind);
               Value indexVal = createKrnl.loadIE(indices, indicesAccessFct);
@@ -106,8 +145,18 @@ struct ONNXScatterNDOpLowering : public ConversionPattern {
           }
 
           // Scatter 'update' values into the output tensor.
-          Value updateVal = createKrnl.load(updates, loopInd);
-          createKrnl.storeIE(updateVal, output, outputAccessFct);
+          if (VL > 0) {
+            // Copy one vector of the update slice per iteration.
+            DimsExpr updatesAccessFct;
+            getIndexExprList<DimIndexExpr>(loopInd, updatesAccessFct);
+            Value updateVec = create.vec.loadIE(
+                vecType, updates, updatesAccessFct, /*offsets=*/{});
+            create.vec.storeIE(updateVec, output, outputAccessFct,
+                /*offsets=*/{});
+          } else {
+            Value updateVal = createKrnl.load(updates, loopInd);
+            createKrnl.storeIE(updateVal, output, outputAccessFct);
+          }
         });
 
     rewriter.replaceOp(op, output);
@@ -117,8 +166,8 @@ struct ONNXScatterNDOpLowering : public ConversionPattern {
 };
 
 void populateLoweringONNXScatterNDOpPattern(RewritePatternSet &patterns,
-    TypeConverter &typeConverter, MLIRContext *ctx) {
-  patterns.insert<ONNXScatterNDOpLowering>(typeConverter, ctx);
+    TypeConverter &typeConverter, MLIRContext *ctx, bool enableParallel) {
+  patterns.insert<ONNXScatterNDOpLowering>(typeConverter, ctx, enableParallel);
 }
 
 } // namespace onnx_mlir
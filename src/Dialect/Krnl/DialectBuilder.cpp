@@ -120,6 +120,10 @@ void KrnlBuilder::permute(ValueRange loops, ArrayRef<int64_t> map) const {
   b().create<KrnlPermuteOp>(loc(), loops, map);
 }
 
+void KrnlBuilder::parallel(ValueRange loops) const {
+  b().template create<KrnlParallelOp>(loc(), loops);
+}
+
 ValueRange KrnlBuilder::getInductionVarValue(ValueRange loops) const {
   return b()
       .template create<KrnlGetInductionVariableValueOp>(loc(), loops)
@@ -187,24 +191,25 @@ void KrnlBuilder::copyFromBuffer(
   b().create<KrnlCopyFromBufferOp>(loc(), bufferMemref, memref, starts);
 }
 
-void KrnlBuilder::matmul(Value A, ValueRange aStart, Value B, ValueRange bStart,
-    Value C, ValueRange cStart, ValueRange loops, ValueRange computeStarts,
-    ValueRange globalUBs, ArrayRef<int64_t> computeTileSize,
-    ArrayRef<int64_t> aTileSize, ArrayRef<int64_t> bTileSize,
-    ArrayRef<int64_t> cTileSize, bool simdize, bool unroll,
+KrnlMatMulOp KrnlBuilder::matmul(Value A, ValueRange aStart, Value B,
+    ValueRange bStart, Value C, ValueRange cStart, ValueRange loops,
+    ValueRange computeStarts, ValueRange globalUBs,
+    ArrayRef<int64_t> computeTileSize, ArrayRef<int64_t> aTileSize,
+    ArrayRef<int64_t> bTileSize, ArrayRef<int64_t> cTileSize, bool simdize,
+    bool unroll, bool overCompute) const {
+  return b().create<KrnlMatMulOp>(loc(), A, aStart, B, bStart, C, cStart,
+      loops, computeStarts[0], computeStarts[1], computeStarts[2],
+      globalUBs[0], globalUBs[1], globalUBs[2], computeTileSize, aTileSize,
+      bTileSize, cTileSize, simdize, unroll, overCompute);
+}
+
+KrnlMatMulOp KrnlBuilder::matmul(Value A, ValueRange aStart, Value B,
+    ValueRange bStart, Value C, ValueRange cStart, ValueRange loops,
+    ValueRange computeStarts, ValueRange globalUBs, bool simdize, bool unroll,
     bool overCompute) const {
-  b().create<KrnlMatMulOp>(loc(), A, aStart, B, bStart, C, cStart, loops,
-      computeStarts[0], computeStarts[1], computeStarts[2], globalUBs[0],
-      globalUBs[1], globalUBs[2], computeTileSize, aTileSize, bTileSize,
-      cTileSize, simdize, unroll, overCompute);
-}
-
-void KrnlBuilder::matmul(Value A, ValueRange aStart, Value B, ValueRange bStart,
-    Value C, ValueRange cStart, ValueRange loops, ValueRange computeStarts,
-    ValueRange globalUBs, bool simdize, bool unroll, bool overCompute) const {
-  b().create<KrnlMatMulOp>(loc(), A, aStart, B, bStart, C, cStart, loops,
-      computeStarts[0], computeStarts[1], computeStarts[2], globalUBs[0],
-      globalUBs[1], globalUBs[2], simdize, unroll, overCompute);
+  return b().create<KrnlMatMulOp>(loc(), A, aStart, B, bStart, C, cStart,
+      loops, computeStarts[0], computeStarts[1], computeStarts[2],
+      globalUBs[0], globalUBs[1], globalUBs[2], simdize, unroll, overCompute);
 }
 
 Value KrnlBuilder::dim(Type type, Value alloc, Value index) const {
@@ -51,6 +51,7 @@ struct KrnlBuilder : public DialectBuilder {
   mlir::ValueRange defineLoops(int64_t originalLoopNum) const;
   mlir::ValueRange block(mlir::Value loop, int64_t blockSize) const;
   void permute(mlir::ValueRange loops, mlir::ArrayRef<int64_t> map) const;
+  void parallel(mlir::ValueRange loops) const;
   mlir::ValueRange getInductionVarValue(mlir::ValueRange loops) const;
 
   // Lambda passes loop indices as 2nd parameter.
@@ -93,7 +94,9 @@ struct KrnlBuilder : public DialectBuilder {
   void copyFromBuffer(mlir::Value bufferMemref, mlir::Value memref,
       mlir::ValueRange starts) const;
 
-  void matmul(
+  // Returns the created krnl.matmul so that callers can attach additional
+  // attributes (e.g. a requested accumulation type) to it.
+  mlir::KrnlMatMulOp matmul(
       // The a/b/cStart are the indices at the beginning of the buffer/mem
       // A/B/C.
       mlir::Value A, mlir::ValueRange aStart, mlir::Value B,
@@ -121,8 +124,9 @@ struct KrnlBuilder : public DialectBuilder {
       mlir::ArrayRef<int64_t> cTileSize,
       // Optimizations for code gen.
       bool simdize, bool unroll, bool overCompute) const;
-  void matmul(mlir::Value A, mlir::ValueRange aStart, mlir::Value B,
-      mlir::ValueRange bStart, mlir::Value C, mlir::ValueRange cStart,
+  mlir::KrnlMatMulOp matmul(mlir::Value A, mlir::ValueRange aStart,
+      mlir::Value B, mlir::ValueRange bStart, mlir::Value C,
+      mlir::ValueRange cStart,
       mlir::ValueRange loops, mlir::ValueRange computeStarts,
       mlir::ValueRange globalUBs, bool simdize, bool unroll,
       bool overCompute) const;
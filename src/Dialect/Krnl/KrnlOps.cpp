@@ -796,6 +796,14 @@ LogicalResult KrnlCopyToBufferOp::verify() {
   int64_t bufferRank = buffCapture.getRank();
   int64_t srcRank = srcCapture.getRank();
   int64_t startRank = opAdaptor.starts().size();
+  Type buffElementType =
+      opAdaptor.buffer().getType().cast<MemRefType>().getElementType();
+  Type srcElementType =
+      opAdaptor.source().getType().cast<MemRefType>().getElementType();
+  if (srcElementType != buffElementType &&
+      !(srcElementType.isF16() && buffElementType.isF32()))
+    return emitOpError(
+        "Element types must match, or source f16 with buffer f32");
   if (!buffCapture.areAllLiteral())
     return emitOpError("buffer expect constant dimensions");
   if (srcRank < bufferRank)
@@ -913,6 +921,30 @@ Optional<Value> KrnlSeqAllocOp::buildClone(OpBuilder &builder, Value alloc) {
       .getResult();
 }
 
+void KrnlSeqAppendOp::getEffects(
+    SmallVectorImpl<SideEffects::EffectInstance<MemoryEffects::Effect>>
+        &effects) {
+  effects.emplace_back(MemoryEffects::Read::get(), input_sequence(),
+      SideEffects::DefaultResource::get());
+  effects.emplace_back(MemoryEffects::Free::get(), input_sequence(),
+      SideEffects::DefaultResource::get());
+  effects.emplace_back(MemoryEffects::Write::get(), output(),
+      SideEffects::DefaultResource::get());
+  effects.emplace_back(MemoryEffects::Allocate::get(), output(),
+      SideEffects::DefaultResource::get());
+}
+
+Optional<Operation *> KrnlSeqAppendOp::buildDealloc(
+    OpBuilder &builder, Value alloc) {
+  Location loc = alloc.getLoc();
+  return builder.create<KrnlSeqDeallocOp>(loc, alloc).getOperation();
+}
+
+Optional<Value> KrnlSeqAppendOp::buildClone(OpBuilder &builder, Value alloc) {
+  return builder.create<bufferization::CloneOp>(alloc.getLoc(), alloc)
+      .getResult();
+}
+
 } // namespace mlir
 
 #define GET_OP_CLASSES
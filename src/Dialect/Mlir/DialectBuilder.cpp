@@ -22,6 +22,7 @@
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 
 // Please do not add dependences on ONNX or KRNL dialects.
 #include "src/Dialect/Mlir/DialectBuilder.hpp"
@@ -217,6 +218,13 @@ Value MathBuilder::constant(Type type, double val) const {
         constant =
             b().create<arith::ConstantOp>(loc(), b().getIntegerAttr(type, val));
       })
+      .Case<VectorType>([&](VectorType vectorType) {
+        // Splat the scalar constant along the vector shape so that scalar
+        // code emitters work transparently when handed a vector type.
+        Value scalarConstant = this->constant(vectorType.getElementType(), val);
+        constant =
+            b().create<vector::SplatOp>(loc(), vectorType, scalarConstant);
+      })
       .Default([](Type) { llvm_unreachable("unsupported element type"); });
 
   assert(constant != nullptr && "Expecting valid constant value");
@@ -370,6 +378,39 @@ Value MathBuilder::cast(Type destType, Value src) const {
   if (srcType == destType)
     return src;
 
+  // Vector-to-vector casts convert element-wise: derive the conversion from
+  // the element types and emit a single operation over the whole vector, as
+  // the arith cast operations all accept vector operands. Only the float and
+  // signless integer cases reachable from the SIMD loops are supported here;
+  // booleans, unsigned, and index types take the scalar path below.
+  if (VectorType srcVecType = srcType.dyn_cast<VectorType>()) {
+    VectorType destVecType = destType.dyn_cast<VectorType>();
+    assert(destVecType && srcVecType.getShape() == destVecType.getShape() &&
+           "expected a vector destination of the same shape");
+    Type srcElemType = srcVecType.getElementType();
+    Type destElemType = destVecType.getElementType();
+    if (srcElemType.isa<FloatType>() && destElemType.isa<FloatType>()) {
+      if (srcElemType.getIntOrFloatBitWidth() <
+          destElemType.getIntOrFloatBitWidth())
+        return b().create<arith::ExtFOp>(loc(), destType, src);
+      return b().create<arith::TruncFOp>(loc(), destType, src);
+    }
+    if (srcElemType.isa<FloatType>() && destElemType.isSignlessInteger() &&
+        !destElemType.isInteger(1))
+      return b().create<arith::FPToSIOp>(loc(), destType, src);
+    if (srcElemType.isSignlessInteger() && !srcElemType.isInteger(1) &&
+        destElemType.isa<FloatType>())
+      return b().create<arith::SIToFPOp>(loc(), destType, src);
+    if (srcElemType.isSignlessInteger() && !srcElemType.isInteger(1) &&
+        destElemType.isSignlessInteger() && !destElemType.isInteger(1)) {
+      if (srcElemType.getIntOrFloatBitWidth() <
+          destElemType.getIntOrFloatBitWidth())
+        return b().create<arith::ExtSIOp>(loc(), destType, src);
+      return b().create<arith::TruncIOp>(loc(), destType, src);
+    }
+    llvm_unreachable("unsupported vector element types");
+  }
+
   // Process index types first.
   if (srcType.isa<IndexType>()) {
     // If our source is an index type, first convert it into a signless int of
@@ -692,12 +733,22 @@ void SCFBuilder::yield() const { b().create<scf::YieldOp>(loc()); }
 // Vector Builder
 //===----------------------------------------------------------------------===//
 
+// SIMD register width in bits assumed by all vector length computations,
+// set once by the compiler driver from the target before lowering. Default
+// to the 128-bit baseline that every supported target provides.
+static int64_t machineSimdBitWidth = 128;
+
+void VectorBuilder::setMachineSimdBitWidth(int64_t bits) {
+  assert(bits >= 8 && llvm::isPowerOf2_64(bits) &&
+         "SIMD width must be a power of 2 of at least 8 bits");
+  machineSimdBitWidth = bits;
+}
+
+int64_t VectorBuilder::getMachineSimdBitWidth() { return machineSimdBitWidth; }
+
 int64_t VectorBuilder::getMachineVectorLength(const Type &elementType) const {
   unsigned typeBitSize = elementType.getIntOrFloatBitWidth();
-  unsigned simdBitSize;
-  // TODO: use march and mcpu to determine the right size, right now assume
-  // 4*32=128 bits.
-  simdBitSize = 128;
+  unsigned simdBitSize = machineSimdBitWidth;
   assert(simdBitSize >= typeBitSize && simdBitSize % typeBitSize == 0 &&
          "bad machine vector length");
   return (simdBitSize / typeBitSize);
@@ -1032,6 +1083,10 @@ Value LLVMBuilder::nullI8Ptr() const {
   return b().create<LLVM::NullOp>(loc(), I8PtrTy);
 }
 
+void LLVMBuilder::_return() const {
+  b().create<LLVM::ReturnOp>(loc(), ArrayRef<Value>({}));
+}
+
 void LLVMBuilder::_return(Value val) const {
   b().create<LLVM::ReturnOp>(loc(), ArrayRef<Value>({val}));
 }
@@ -234,6 +234,13 @@ struct VectorBuilder final : DialectBuilder {
   VectorBuilder(const DialectBuilder &db) : DialectBuilder(db) {}
   virtual ~VectorBuilder() {}
 
+  // Set/get the machine SIMD register width in bits that all vector length
+  // computations assume. The compiler driver derives it once from the target
+  // (-march/-mcpu) before lowering; the default is the 128-bit baseline
+  // (NEON, SSE, VXE, RVV zvl128b).
+  static void setMachineSimdBitWidth(int64_t bits);
+  static int64_t getMachineSimdBitWidth();
+
   // Get the machine SIMD vector length for the given elementary type.
   // This can help guide certain optimizations.
   int64_t getMachineVectorLength(const mlir::Type &elementType) const;
@@ -415,6 +422,7 @@ struct LLVMBuilder final : DialectBuilder {
   mlir::Value nullI8Ptr() const;
 
   // ReturnOp
+  void _return() const;
   void _return(mlir::Value val) const;
 
   // StoreOp
@@ -41,7 +41,7 @@ namespace onnx_mlir {
 // Initial scope.
 IndexExprScope::IndexExprScope(OpBuilder *rewriter, Location loc)
     : dims(), symbols(), rewriter(rewriter), parentScope(getCurrentScopePtr()),
-      loc(loc), container() {
+      loc(loc), arena() {
   getCurrentScopePtr() = this;
 }
 
@@ -53,7 +53,7 @@ IndexExprScope::IndexExprScope(
     OpBuilder *innerRewriter, IndexExprScope *enclosingScope)
     : dims(), symbols(), rewriter(innerRewriter),
       parentScope(enclosingScope ? enclosingScope : getCurrentScopePtr()),
-      loc(parentScope->loc), container() {
+      loc(parentScope->loc), arena() {
   // if (!parentScope)
   //  // Enclosing scope not provided, fetch from environment.
   //  parentScope = getCurrentScopePtr();
@@ -73,11 +73,9 @@ IndexExprScope::IndexExprScope(
     : IndexExprScope(&innerDb.getBuilder(), enclosingScope) {}
 
 IndexExprScope::~IndexExprScope() {
-  // Free the memory of each IndexExprImpl in scope's container.
-  for (IndexExprImpl *obj : container)
-    delete obj;
-  container.clear();
-  // no need to clear the cached copies as they are also in the container.
+  // The memory of each IndexExprImpl lives in the scope's arena, which is
+  // freed in bulk here. Impls are trivially destructible, so there is no
+  // need to visit them individually.
   getCurrentScopePtr() = parentScope;
 }
 
@@ -91,8 +89,8 @@ IndexExprScope::~IndexExprScope() {
 // IndexExprScope builder for IndexExpr.
 //===----------------------------------------------------------------------===//
 
-void IndexExprScope::addIndexExprImpl(IndexExprImpl *obj) {
-  container.emplace_back(obj);
+void *IndexExprScope::allocateIndexExprImpl(size_t size) {
+  return arena.Allocate(size, alignof(IndexExprImpl));
 }
 
 //===----------------------------------------------------------------------===//
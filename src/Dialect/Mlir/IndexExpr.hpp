@@ -274,6 +274,7 @@ inference part as no code may be generated during such phases.
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Transforms/DialectConversion.h"
+#include "llvm/Support/Allocator.h"
 
 #include <cstdint>
 #include <functional>
@@ -368,8 +369,10 @@ private:
     return scope;
   }
 
-  // Add a new IndexExprImpl in the scope's container.
-  void addIndexExprImpl(IndexExprImpl *obj);
+  // Allocate memory for a new IndexExprImpl in the scope's arena. The
+  // allocation is freed in bulk when the scope is destructed; impls are
+  // trivially destructible so no destructor call is needed.
+  void *allocateIndexExprImpl(size_t size);
 
   // Support functions for AffineExpr.
   int indexInList(llvm::SmallVectorImpl<mlir::Value> const &list,
@@ -386,9 +389,11 @@ private:
   IndexExprScope *parentScope;
   // Location for ops rewriting.
   mlir::Location loc;
-  // Container of all index expr implementation records, to simplify
-  // live range analysis. ALl will be deleted upon scope destruction.
-  llvm::SmallVector<IndexExprImpl *, 20> container;
+  // Arena backing all index expr implementation records, to simplify
+  // live range analysis. All memory is released upon scope destruction.
+  // Shape-heavy models create millions of impls, so bump allocation is
+  // noticeably cheaper than individual new/delete pairs.
+  llvm::BumpPtrAllocator arena;
 };
 
 //===----------------------------------------------------------------------===//
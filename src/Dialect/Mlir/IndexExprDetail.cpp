@@ -34,14 +34,20 @@ namespace onnx_mlir {
 // IndexExprImpl constructors, initializers
 //===----------------------------------------------------------------------===//
 
+void *IndexExprImpl::operator new(size_t size) {
+  // Bump-allocate in the current scope's arena; the scope reclaims the
+  // memory of all of its impls at once upon destruction.
+  IndexExprScope *scope = IndexExprScope::getCurrentScopePtr();
+  assert(scope && "expected IndexExpr Scope to be defined");
+  return scope->allocateIndexExprImpl(size);
+}
+
 IndexExprImpl::IndexExprImpl()
     : defined(false), literal(false), kind(IndexExprKind::NonAffine), intLit(0),
       affineExpr(nullptr), value(nullptr) {
   // Set scope from thread private global.
   scope = IndexExprScope::getCurrentScopePtr();
   assert(scope && "expected IndexExpr Scope to be defined");
-  // Record the new index expr implementation.
-  scope->addIndexExprImpl(this);
 }
 
 void IndexExprImpl::initAsUndefined() {
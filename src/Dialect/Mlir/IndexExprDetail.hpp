@@ -18,6 +18,8 @@
 
 #include "src/Dialect/Mlir/IndexExpr.hpp"
 
+#include <type_traits>
+
 namespace onnx_mlir {
 
 // Implementation of the IndexExpr. In nearly all cases, the value described by
@@ -31,6 +33,11 @@ public:
   // Public constructor.
   IndexExprImpl();
 
+  // Impls are bump-allocated in the current scope's arena; memory is
+  // reclaimed in bulk when the scope is destructed, so delete is a no-op.
+  void *operator new(size_t size);
+  void operator delete(void *ptr) noexcept {}
+
   // Basic initialization calls.
   void initAsUndefined();
   // Initialize a question mark with the default value of -1.
@@ -105,4 +112,8 @@ private:
       mlir::Value const value);
 };
 
+// The scope's arena frees impls without running destructors.
+static_assert(std::is_trivially_destructible<IndexExprImpl>::value,
+    "IndexExprImpl must remain trivially destructible for arena allocation");
+
 } // namespace onnx_mlir
@@ -61,7 +61,6 @@ NOT_IMPLEMENTED_INFER_SHAPES(ONNXHannWindowOp)
 NOT_IMPLEMENTED_INFER_SHAPES(ONNXImputerOp)
 NOT_IMPLEMENTED_INFER_SHAPES(ONNXIsInfOp)
 NOT_IMPLEMENTED_INFER_SHAPES(ONNXLabelEncoderOp)
-NOT_IMPLEMENTED_INFER_SHAPES(ONNXLayerNormalizationOp)
 NOT_IMPLEMENTED_INFER_SHAPES(ONNXLinearClassifierOp)
 NOT_IMPLEMENTED_INFER_SHAPES(ONNXLinearRegressorOp)
 NOT_IMPLEMENTED_INFER_SHAPES(ONNXLpPoolOp)
@@ -71,6 +71,41 @@ LogicalResult ONNXBatchNormalizationInferenceModeOp::inferShapes(
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// LayerNormalization
+//===----------------------------------------------------------------------===//
+
+LogicalResult ONNXLayerNormalizationOp::inferShapes(
+    std::function<void(Region &)> doShapeInference) {
+  // Cannot infer shape if no shape exists.
+  if (!X().getType().isa<RankedTensorType>())
+    return success();
+
+  auto inputTensorTy = X().getType().cast<RankedTensorType>();
+  int64_t rank = inputTensorTy.getRank();
+  int64_t axisValue = axis();
+  if (axisValue < 0)
+    axisValue += rank;
+  if (axisValue < 0 || axisValue >= rank)
+    return emitError("Axis is out of the input rank range");
+
+  // Y has the same shape as the input.
+  Y().setType(inputTensorTy);
+
+  // Mean and InvStdDev, when requested, have the input shape with the
+  // normalized dimensions set to 1.
+  SmallVector<int64_t, 4> statsShape(inputTensorTy.getShape());
+  for (int64_t i = axisValue; i < rank; ++i)
+    statsShape[i] = 1;
+  Type statsType =
+      RankedTensorType::get(statsShape, inputTensorTy.getElementType());
+  if (!Mean().getType().isa<NoneType>())
+    Mean().setType(statsType);
+  if (!InvStdDev().getType().isa<NoneType>())
+    InvStdDev().setType(statsType);
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // InstanceNormalization
 //===----------------------------------------------------------------------===//
@@ -301,6 +301,15 @@ ONNXConstantOp getONNXConstantOp(Value value) {
   return dyn_cast_or_null<ONNXConstantOp>(value.getDefiningOp());
 }
 
+bool isScalarConstantTensor(Value value) {
+  DenseElementsAttr dense = getDenseElementAttributeFromONNXValue(value);
+  return dense && dense.getNumElements() == 1;
+}
+
+bool hasFusedActivation(Operation *op) {
+  return op->hasAttr(FUSED_ACTIVATION_ATTR);
+}
+
 Value createONNXConstantOpWithDenseAttr(
     OpBuilder &builder, Location loc, Attribute dense) {
   return builder.create<ONNXConstantOp>(loc, Attribute(), dense);
@@ -378,6 +387,15 @@ bool IsIdentityPermuteVector(ArrayAttr permAttr) {
   return true;
 }
 
+/// Test if the permute pattern swaps the two dimensions of a 2-D tensor,
+/// i.e. is {1, 0}.
+bool IsSwapPermuteVectorOf2D(ArrayAttr permAttr) {
+  if (!permAttr || permAttr.size() != 2)
+    return false;
+  return (permAttr.getValue()[0].cast<IntegerAttr>().getInt() == 1) &&
+         (permAttr.getValue()[1].cast<IntegerAttr>().getInt() == 0);
+}
+
 /// Test if the value has the specified constant shape
 bool HasSpecifiedConstantShape(Value value, Value shape) {
   if (!hasShapeAndRank(value) || !hasShapeAndRank(shape))
@@ -164,6 +164,21 @@ mlir::DenseElementsAttr getDenseElementAttributeFromONNXValue(
     mlir::Value value);
 
 mlir::ONNXConstantOp getONNXConstantOp(mlir::Value value);
+
+// Check if a value is a dense constant tensor holding exactly one element,
+// whatever its rank. Such a constant broadcasts over any shape.
+bool isScalarConstantTensor(mlir::Value value);
+
+// Names of the attributes with which the ONNX fusion pass records a trailing
+// activation on its producer. The ONNXToKrnl lowering of the producer applies
+// the activation on each output scalar right before the final write-back.
+constexpr const char *FUSED_ACTIVATION_ATTR = "fused_activation";
+constexpr const char *FUSED_ACTIVATION_ALPHA_ATTR = "fused_activation_alpha";
+constexpr const char *FUSED_ACTIVATION_MIN_ATTR = "fused_activation_min";
+constexpr const char *FUSED_ACTIVATION_MAX_ATTR = "fused_activation_max";
+
+// Check whether the ONNX fusion pass recorded an activation on this op.
+bool hasFusedActivation(mlir::Operation *op);
 mlir::Value createONNXConstantOpWithDenseAttr(
     mlir::OpBuilder &builder, mlir::Location loc, mlir::Attribute dense);
 mlir::Value createNoneIntegerConstant(
@@ -185,6 +200,10 @@ mlir::ArrayAttr CombinedTransposePattern(mlir::PatternRewriter &rewriter,
 /// Identity patterns are {0, 1, 2, ... , rank -1}.
 bool IsIdentityPermuteVector(mlir::ArrayAttr permAttr);
 
+/// Test if the permute pattern swaps the two dimensions of a 2-D tensor,
+/// i.e. is {1, 0}.
+bool IsSwapPermuteVectorOf2D(mlir::ArrayAttr permAttr);
+
 /// Test if two axis arrays contain the same values or not.
 bool AreTheSameAxisArray(
     int64_t rank, mlir::ArrayAttr lhsAttr, mlir::ArrayAttr rhsAttr);
@@ -549,6 +549,259 @@ public:
   }
 };
 
+// =============================================================================
+// Composition of data-movement operations (Pad, Slice).
+//
+// Chains of pure data-movement operations each lower to an allocation plus a
+// copy, so a Pad -> Slice -> ... preprocessing pipeline touches the same data
+// once per link. The patterns below collapse such chains at the ONNX level so
+// that at most one copy of the data is materialized.
+// =============================================================================
+
+namespace {
+
+// Read the elements of a 1-D integer ONNXConstantOp into 'values'. Return
+// false when the value is not such a constant.
+bool getI64ValuesFromONNXConstant(
+    Value value, SmallVectorImpl<int64_t> &values) {
+  DenseElementsAttr attr = getDenseElementAttributeFromONNXValue(value);
+  if (!attr || !attr.getElementType().isa<IntegerType>())
+    return false;
+  for (APInt val : attr.getValues<APInt>())
+    values.emplace_back(val.getSExtValue());
+  return true;
+}
+
+// Create a 1-D i64 ONNXConstantOp holding 'values'.
+Value createI64ConstantOp(
+    PatternRewriter &rewriter, Location loc, ArrayRef<int64_t> values) {
+  return createONNXConstantOpWithDenseAttr(
+      rewriter, loc, rewriter.getI64TensorAttr(values));
+}
+
+// Resolve the starts/ends/axes/steps operands of a slice over a tensor of
+// the given static shape into full-rank arrays of normalized values,
+// following the ONNX Slice rules: axes, starts and ends may be negative and
+// ends may exceed the dimension size. Return false when an operand is not a
+// compile-time constant, the shape is not fully static, or a step is not
+// positive (reversing slices do not compose with the rewrites below).
+bool getNormalizedSliceParams(ONNXSliceOp sliceOp, ArrayRef<int64_t> dataShape,
+    SmallVectorImpl<int64_t> &starts, SmallVectorImpl<int64_t> &ends,
+    SmallVectorImpl<int64_t> &steps) {
+  int64_t rank = dataShape.size();
+  if (llvm::any_of(dataShape, [](int64_t dim) { return dim < 0; }))
+    return false;
+
+  SmallVector<int64_t, 4> startVals, endVals, axisVals, stepVals;
+  if (!getI64ValuesFromONNXConstant(sliceOp.starts(), startVals) ||
+      !getI64ValuesFromONNXConstant(sliceOp.ends(), endVals))
+    return false;
+  if (isFromNone(sliceOp.axes())) {
+    for (int64_t i = 0; i < (int64_t)startVals.size(); ++i)
+      axisVals.emplace_back(i);
+  } else if (!getI64ValuesFromONNXConstant(sliceOp.axes(), axisVals))
+    return false;
+  if (isFromNone(sliceOp.steps()))
+    stepVals.assign(startVals.size(), 1);
+  else if (!getI64ValuesFromONNXConstant(sliceOp.steps(), stepVals))
+    return false;
+  if (endVals.size() != startVals.size() ||
+      axisVals.size() != startVals.size() ||
+      stepVals.size() != startVals.size())
+    return false;
+
+  starts.assign(rank, 0);
+  ends.assign(dataShape.begin(), dataShape.end());
+  steps.assign(rank, 1);
+  for (uint64_t i = 0; i < axisVals.size(); ++i) {
+    int64_t axis = axisVals[i];
+    if (axis < 0)
+      axis += rank;
+    if (axis < 0 || axis >= rank)
+      return false;
+    if (stepVals[i] <= 0)
+      return false;
+    int64_t dim = dataShape[axis];
+    int64_t start = startVals[i];
+    if (start < 0)
+      start += dim;
+    starts[axis] = start < 0 ? 0 : (start > dim ? dim : start);
+    int64_t end = endVals[i];
+    if (end < 0)
+      end += dim;
+    ends[axis] = end < 0 ? 0 : (end > dim ? dim : end);
+    steps[axis] = stepVals[i];
+  }
+  return true;
+}
+} // namespace
+
+// Compose two consecutive slices into a single one:
+//   onnx.Slice(onnx.Slice(%X)) = onnx.Slice(%X)
+// so that the intermediate sub-tensor is never materialized.
+class FuseTwoSlicesPattern : public OpRewritePattern<ONNXSliceOp> {
+public:
+  using OpRewritePattern<ONNXSliceOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXSliceOp sliceOp, PatternRewriter &rewriter) const override {
+    auto innerOp = sliceOp.data().getDefiningOp<ONNXSliceOp>();
+    if (!innerOp)
+      return failure();
+    auto dataType = innerOp.data().getType().dyn_cast<RankedTensorType>();
+    auto innerType = innerOp.output().getType().dyn_cast<RankedTensorType>();
+    if (!dataType || !innerType)
+      return failure();
+
+    int64_t rank = dataType.getRank();
+    SmallVector<int64_t, 4> innerStarts, innerEnds, innerSteps;
+    SmallVector<int64_t, 4> outerStarts, outerEnds, outerSteps;
+    if (!getNormalizedSliceParams(
+            innerOp, dataType.getShape(), innerStarts, innerEnds, innerSteps))
+      return failure();
+    if (!getNormalizedSliceParams(
+            sliceOp, innerType.getShape(), outerStarts, outerEnds, outerSteps))
+      return failure();
+
+    // Element i of the composed slice along an axis is element
+    // innerStart + (outerStart + i * outerStep) * innerStep of the data; the
+    // composed end bound is derived from the number of elements the outer
+    // slice takes.
+    SmallVector<int64_t, 4> starts(rank), ends(rank), axes(rank), steps(rank);
+    for (int64_t r = 0; r < rank; ++r) {
+      int64_t start = innerStarts[r] + outerStarts[r] * innerSteps[r];
+      int64_t step = innerSteps[r] * outerSteps[r];
+      int64_t numElements =
+          outerEnds[r] > outerStarts[r]
+              ? (outerEnds[r] - outerStarts[r] + outerSteps[r] - 1) /
+                    outerSteps[r]
+              : 0;
+      starts[r] = start;
+      ends[r] = numElements == 0 ? start : start + (numElements - 1) * step + 1;
+      axes[r] = r;
+      steps[r] = step;
+    }
+
+    Location loc = sliceOp.getLoc();
+    rewriter.replaceOpWithNewOp<ONNXSliceOp>(sliceOp,
+        sliceOp.output().getType(), innerOp.data(),
+        createI64ConstantOp(rewriter, loc, starts),
+        createI64ConstantOp(rewriter, loc, ends),
+        createI64ConstantOp(rewriter, loc, axes),
+        createI64ConstantOp(rewriter, loc, steps));
+    return success();
+  }
+};
+
+// Drop a pad whose padding is entirely sliced away again:
+//   onnx.Slice(onnx.Pad(%X)) = onnx.Slice(%X)
+// when the slice window lies within the un-padded region along every axis.
+// This is the common case of window-style preprocessing that pads a tensor
+// and then carves aligned tiles out of its interior.
+class RemoveSliceOfPadPattern : public OpRewritePattern<ONNXSliceOp> {
+public:
+  using OpRewritePattern<ONNXSliceOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXSliceOp sliceOp, PatternRewriter &rewriter) const override {
+    auto padOp = sliceOp.data().getDefiningOp<ONNXPadOp>();
+    if (!padOp || padOp.mode() != "constant")
+      return failure();
+    auto dataType = padOp.data().getType().dyn_cast<RankedTensorType>();
+    auto paddedType = padOp.output().getType().dyn_cast<RankedTensorType>();
+    if (!dataType || !paddedType || !dataType.hasStaticShape())
+      return failure();
+
+    int64_t rank = dataType.getRank();
+    SmallVector<int64_t, 4> padVals;
+    if (!getI64ValuesFromONNXConstant(padOp.pads(), padVals) ||
+        (int64_t)padVals.size() != 2 * rank)
+      return failure();
+    SmallVector<int64_t, 4> starts, ends, steps;
+    if (!getNormalizedSliceParams(
+            sliceOp, paddedType.getShape(), starts, ends, steps))
+      return failure();
+
+    // The window must not touch the padded border: it has to begin after the
+    // pads at the start of each axis and end before the pads at its end.
+    // Shifting it by the start pads then expresses it on the data directly.
+    SmallVector<int64_t, 4> axes(rank);
+    for (int64_t r = 0; r < rank; ++r) {
+      if (starts[r] < padVals[r] ||
+          ends[r] > padVals[r] + dataType.getShape()[r])
+        return failure();
+      starts[r] -= padVals[r];
+      ends[r] -= padVals[r];
+      axes[r] = r;
+    }
+
+    Location loc = sliceOp.getLoc();
+    rewriter.replaceOpWithNewOp<ONNXSliceOp>(sliceOp,
+        sliceOp.output().getType(), padOp.data(),
+        createI64ConstantOp(rewriter, loc, starts),
+        createI64ConstantOp(rewriter, loc, ends),
+        createI64ConstantOp(rewriter, loc, axes),
+        createI64ConstantOp(rewriter, loc, steps));
+    return success();
+  }
+};
+
+// Merge two consecutive constant-mode pads into a single one:
+//   onnx.Pad(onnx.Pad(%X)) = onnx.Pad(%X)
+// when both pad with the same value and no pad is negative (negative pads
+// crop, which does not commute with the padding added by the other op).
+class FuseTwoPadsPattern : public OpRewritePattern<ONNXPadOp> {
+public:
+  using OpRewritePattern<ONNXPadOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXPadOp padOp, PatternRewriter &rewriter) const override {
+    auto innerOp = padOp.data().getDefiningOp<ONNXPadOp>();
+    if (!innerOp || padOp.mode() != "constant" ||
+        innerOp.mode() != "constant")
+      return failure();
+
+    // The padding values must match. Attributes are uniqued, so comparing
+    // the attributes compares the values; an absent value defaults to zero.
+    Value padValue = padOp.constant_value();
+    Value innerPadValue = innerOp.constant_value();
+    if (isFromNone(padValue) != isFromNone(innerPadValue))
+      return failure();
+    if (!isFromNone(padValue)) {
+      DenseElementsAttr padAttr =
+          getDenseElementAttributeFromONNXValue(padValue);
+      DenseElementsAttr innerPadAttr =
+          getDenseElementAttributeFromONNXValue(innerPadValue);
+      if (!padAttr || !innerPadAttr || padAttr != innerPadAttr)
+        return failure();
+    }
+
+    auto dataType = innerOp.data().getType().dyn_cast<RankedTensorType>();
+    if (!dataType)
+      return failure();
+    int64_t rank = dataType.getRank();
+    SmallVector<int64_t, 4> padVals, innerPadVals;
+    if (!getI64ValuesFromONNXConstant(padOp.pads(), padVals) ||
+        !getI64ValuesFromONNXConstant(innerOp.pads(), innerPadVals) ||
+        (int64_t)padVals.size() != 2 * rank ||
+        (int64_t)innerPadVals.size() != 2 * rank)
+      return failure();
+    if (llvm::any_of(padVals, [](int64_t pad) { return pad < 0; }) ||
+        llvm::any_of(innerPadVals, [](int64_t pad) { return pad < 0; }))
+      return failure();
+
+    SmallVector<int64_t, 4> sumVals(2 * rank);
+    for (int64_t i = 0; i < 2 * rank; ++i)
+      sumVals[i] = padVals[i] + innerPadVals[i];
+
+    rewriter.replaceOpWithNewOp<ONNXPadOp>(padOp, padOp.output().getType(),
+        innerOp.data(),
+        createI64ConstantOp(rewriter, padOp.getLoc(), sumVals), padValue,
+        padOp.modeAttr());
+    return success();
+  }
+};
+
 // =============================================================================
 /// Register optimization patterns as "canonicalization" patterns.
 /// Add op to OpsWithCanonicalizer in gen_onnx_mlir.py to activate.
@@ -636,7 +889,8 @@ void ONNXIdentityOp::getCanonicalizationPatterns(
 /// on the ONNXLayoutTransformOp.
 void ONNXLayoutTransformOp::getCanonicalizationPatterns(
     RewritePatternSet &result, MLIRContext *context) {
-  result.insert<ONNXLayoutTransformEliminationPattern>(context);
+  result.insert<ONNXLayoutTransformEliminationPattern,
+      ONNXLayoutTransformFusionPattern>(context);
 }
 
 /// on the ONNXLessOp.
@@ -657,6 +911,13 @@ void ONNXLSTMOp::getCanonicalizationPatterns(
   results.insert<RNNOpRewriteLayoutPattern<ONNXLSTMOp>>(context);
 }
 
+/// on the ONNXMatMulOp.
+void ONNXMatMulOp::getCanonicalizationPatterns(
+    RewritePatternSet &results, MLIRContext *context) {
+  results.insert<TransposedMatMulToGemmAPattern>(context);
+  results.insert<TransposedMatMulToGemmBPattern>(context);
+}
+
 /// on the ONNXMulOp.
 void ONNXMulOp::getCanonicalizationPatterns(
     RewritePatternSet &results, MLIRContext *context) {
@@ -664,6 +925,12 @@ void ONNXMulOp::getCanonicalizationPatterns(
   results.insert<FuseMulConvNullBiasPattern>(context);
 }
 
+/// on the ONNXPadOp.
+void ONNXPadOp::getCanonicalizationPatterns(
+    RewritePatternSet &results, MLIRContext *context) {
+  results.insert<FuseTwoPadsPattern>(context);
+}
+
 /// on the ONNXReshapeOp.
 void ONNXReshapeOp::getCanonicalizationPatterns(
     RewritePatternSet &result, MLIRContext *context) {
@@ -690,6 +957,13 @@ void ONNXSizeOp::getCanonicalizationPatterns(
   results.insert<SizeToConstantPattern>(context);
 }
 
+/// on the ONNXSliceOp.
+void ONNXSliceOp::getCanonicalizationPatterns(
+    RewritePatternSet &results, MLIRContext *context) {
+  results.insert<FuseTwoSlicesPattern>(context);
+  results.insert<RemoveSliceOfPadPattern>(context);
+}
+
 /// on the ONNXSoftmaxV11Op.
 void ONNXSoftmaxV11Op::getCanonicalizationPatterns(
     RewritePatternSet &results, MLIRContext *context) {
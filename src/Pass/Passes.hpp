@@ -24,16 +24,23 @@ namespace onnx_mlir {
 
 /// Pass for ONNX graph level optimization
 std::unique_ptr<mlir::Pass> createONNXOpTransformPass();
-std::unique_ptr<mlir::Pass> createONNXOpTransformPass(
-    int threshold, bool report, bool targetCPU, bool enableSimdDataLayoutOpt);
+std::unique_ptr<mlir::Pass> createONNXOpTransformPass(int threshold,
+    bool report, bool targetCPU, bool enableSimdDataLayoutOpt,
+    int64_t maxModuleOps);
 
 /// Pass for rewriting inside frontend dialect.
 std::unique_ptr<mlir::Pass> createDecomposeONNXToONNXPass(
-    const std::string &target = "");
+    const std::string &target = "", int einsumOpBudget = 0);
+
+/// Pass for recomposing composite ops from primitive ops.
+std::unique_ptr<mlir::Pass> createRecomposeONNXToONNXPass();
 
 std::unique_ptr<mlir::Pass> createConvOptONNXToONNXPass(
     bool enableSimdDataLayoutOpt = false);
 
+/// Pass for fusing ONNX operations so they lower to combined kernels.
+std::unique_ptr<mlir::Pass> createFusionONNXToONNXPass();
+
 std::unique_ptr<mlir::Pass> createShapeInferencePass(
     bool analyzeAllFunctions = false);
 
@@ -48,9 +55,39 @@ std::unique_ptr<mlir::Pass> createInstrumentPass(
 /// signatures at runtime.
 std::unique_ptr<mlir::Pass> createInstrumentONNXSignaturePass();
 
+/// Pass for annotating ONNX ops with measured times from a profile file.
+std::unique_ptr<mlir::Pass> createProfileAnnotationPass();
+std::unique_ptr<mlir::Pass> createProfileAnnotationPass(
+    std::string profileFile);
+
+/// Pass for annotating ONNX ops with accumulation types from a config file.
+std::unique_ptr<mlir::Pass> createAccumAnnotationPass();
+std::unique_ptr<mlir::Pass> createAccumAnnotationPass(std::string configFile);
+
 /// Pass for simplifying shape-related ONNX operations.
 std::unique_ptr<mlir::Pass> createSimplifyShapeRelatedOpsPass();
 
+/// Pass for outlining structurally identical ONNX Loop/Scan bodies into
+/// shared functions.
+std::unique_ptr<mlir::Pass> createOutlineLoopBodiesPass();
+
+/// Pass for eliminating semantically identical ONNX operations that differ
+/// only in instance naming or constant identity.
+std::unique_ptr<mlir::Pass> createStructuralCSEPass();
+
+/// Pass for rewriting structurally identical entry point functions into
+/// wrappers sharing one body.
+std::unique_ptr<mlir::Pass> createShareEntryFunctionsPass();
+
+/// Pass for outlining maximal backend-convertible ONNX subgraphs into
+/// functions tagged with a backend attribute.
+std::unique_ptr<mlir::Pass> createPartitionBackendSubgraphsPass();
+
+/// Pass for sharding MatMul/Gemm weights across tensor-parallel ranks.
+std::unique_ptr<mlir::Pass> createShardTensorParallelPass();
+std::unique_ptr<mlir::Pass> createShardTensorParallelPass(
+    int64_t numRanks, int64_t rank);
+
 /// Pass for analysing unknown dimension in ONNX operations.
 std::unique_ptr<mlir::Pass> createONNXDimAnalysisPass();
 
@@ -59,10 +96,14 @@ std::unique_ptr<mlir::Pass> createONNXPreKrnlVerifyPass();
 
 /// Add pass for lowering to Krnl IR.
 std::unique_ptr<mlir::Pass> createLowerToKrnlPass();
-std::unique_ptr<mlir::Pass> createLowerToKrnlPass(
-    int optLevel, bool enableParallel);
-std::unique_ptr<mlir::Pass> createLowerToKrnlPass(
-    bool emitDealloc, bool enableTiling, bool enableParallel);
+std::unique_ptr<mlir::Pass> createLowerToKrnlPass(int optLevel,
+    bool enableParallel, bool enableFastElementwise = false,
+    bool enableFastConv = false, bool enableFusedAttention = false,
+    float sparseWeightDensity = 0.0f, int64_t l2ResidentCores = 0);
+std::unique_ptr<mlir::Pass> createLowerToKrnlPass(bool emitDealloc,
+    bool enableTiling, bool enableParallel, bool enableFastElementwise,
+    bool enableFastConv, bool enableFusedAttention,
+    float sparseWeightDensity = 0.0f, int64_t l2ResidentCores = 0);
 
 #ifdef ONNX_MLIR_ENABLE_MHLO
 /// Add pass for lowering to Mhlo IR.
@@ -80,7 +121,9 @@ std::unique_ptr<mlir::Pass> createElideConstGlobalValuePass();
 
 namespace krnl {
 /// Pass for lowering frontend dialects to Krnl IR dialect.
-std::unique_ptr<mlir::Pass> createConvertKrnlToAffinePass();
+std::unique_ptr<mlir::Pass> createConvertKrnlToAffinePass(
+    bool enablePrefetch = false, bool enableInterchange = false,
+    std::string unrollFactors = "", std::string unrollConfigFile = "");
 
 /// Pass for enabling a memory pool for MemRefs.
 std::unique_ptr<mlir::Pass> createKrnlEnableMemoryPoolPass();
@@ -91,6 +134,43 @@ std::unique_ptr<mlir::Pass> createKrnlBundleMemoryPoolsPass();
 /// Pass for optimizing memory pools.
 std::unique_ptr<mlir::Pass> createKrnlOptimizeMemoryPoolsPass();
 
+/// Pass for packing static memory pools with liveness-colored offsets.
+std::unique_ptr<mlir::Pass> createKrnlStaticMemoryPlanPass();
+std::unique_ptr<mlir::Pass> createKrnlStaticMemoryPlanPass(bool report);
+
+/// Pass for fusing elementwise Krnl loop nests.
+std::unique_ptr<mlir::Pass> createFuseKrnlLoopsPass();
+
+/// Pass for hoisting loop-invariant allocations out of Krnl loops.
+std::unique_ptr<mlir::Pass> createHoistKrnlAllocsPass();
+
+/// Pass for freeing buffers immediately after their last use.
+std::unique_ptr<mlir::Pass> createShrinkAllocLifetimesPass();
+
+/// Pass for running independent subgraphs on the runtime worker pool.
+std::unique_ptr<mlir::Pass> createPartitionParallelTasksPass();
+
+/// Pass for running parallel loops in scheduled chunks on the worker pool.
+std::unique_ptr<mlir::Pass> createChunkParallelLoopsPass();
+std::unique_ptr<mlir::Pass> createChunkParallelLoopsPass(int64_t schedule);
+
+/// Pass for merging structurally identical private functions.
+std::unique_ptr<mlir::Pass> createDeduplicateFunctionsPass();
+
+/// Pass for inserting cooperative yield checks in outer loops.
+std::unique_ptr<mlir::Pass> createInsertYieldPointsPass();
+
+/// Pass for storing tile-packed weights in half precision.
+std::unique_ptr<mlir::Pass> createF16WeightStoragePass();
+
+/// Pass for instrumenting memory allocation sites.
+std::unique_ptr<mlir::Pass> createInstrumentMemoryPass();
+
+/// Pass for reporting and enforcing the worst-case scratch memory budget.
+std::unique_ptr<mlir::Pass> createScratchMemoryBudgetPass();
+std::unique_ptr<mlir::Pass> createScratchMemoryBudgetPass(
+    bool report, int64_t limitBytes);
+
 /// Pass for lowering Seq in Krnl dialect.
 std::unique_ptr<mlir::Pass> createConvertSeqToMemrefPass();
 
@@ -100,7 +180,11 @@ std::unique_ptr<mlir::Pass> createLowerKrnlRegionPass();
 /// Pass for lowering Krnl dialect to LLVM dialect.
 std::unique_ptr<mlir::Pass> createConvertKrnlToLLVMPass();
 std::unique_ptr<mlir::Pass> createConvertKrnlToLLVMPass(
-    bool verifyInputTensors);
+    bool verifyInputTensors, bool storeConstantsToFile = false,
+    int64_t constantsToFileSingleThreshold = 1024,
+    std::string constantsToFileName = "model.constants.bin",
+    std::string sharedConstantsDir = "", bool approxTranscendentals = true,
+    bool smallTensorAllocator = false);
 
 } // namespace krnl
 
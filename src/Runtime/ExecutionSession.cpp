@@ -14,8 +14,13 @@
 //===----------------------------------------------------------------------===//
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -67,14 +72,350 @@ const std::string *ExecutionSession::queryEntryPoints(
 }
 
 void ExecutionSession::setEntryPoint(const std::string &entryPointName) {
-  _entryPointFunc = reinterpret_cast<entryPointFuncType>(
-      _sharedLibraryHandle.getAddressOfSymbol(entryPointName.c_str()));
-  if (!_entryPointFunc)
-    throw std::runtime_error(reportSymbolLoadingError(entryPointName));
+  entryPointFuncType entryPointFunc = resolveEntryPoint(entryPointName);
+  const std::lock_guard<std::mutex> lock(_entryPointMutex);
+  _entryPointFunc = entryPointFunc;
   _entryPointName = entryPointName;
   errno = 0; // No errors.
 }
 
+entryPointFuncType ExecutionSession::resolveEntryPoint(
+    const std::string &entryPointName) {
+  // DynamicLibrary symbol lookup is a read-only hash table probe and is safe
+  // to perform from multiple threads at once.
+  auto entryPointFunc = reinterpret_cast<entryPointFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol(entryPointName.c_str()));
+  if (!entryPointFunc)
+    throw std::runtime_error(reportSymbolLoadingError(entryPointName));
+  return entryPointFunc;
+}
+
+void ExecutionSession::recordRunTime(int64_t elapsedNs) const {
+  _numRuns.fetch_add(1, std::memory_order_relaxed);
+  _lastRunTimeNs.store(elapsedNs, std::memory_order_relaxed);
+  _totalRunTimeNs.fetch_add(elapsedNs, std::memory_order_relaxed);
+}
+
+OMTensorList *ExecutionSession::invokeEntryPoint(
+    entryPointFuncType entryPointFunc, OMTensorList *input) const {
+  if (_shapeProfiling.load(std::memory_order_relaxed))
+    recordInputShapes(input);
+  auto start = std::chrono::steady_clock::now();
+  OMTensorList *output = entryPointFunc(input);
+  recordRunTime(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start)
+                    .count());
+  if (!output)
+    throw std::runtime_error(reportErrnoError());
+  return output;
+}
+
+OMTensorList *ExecutionSession::runConcurrent(OMTensorList *input) {
+  entryPointFuncType entryPointFunc = nullptr;
+  {
+    const std::lock_guard<std::mutex> lock(_entryPointMutex);
+    entryPointFunc = _entryPointFunc;
+  }
+  if (!entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runConcurrent"));
+  // Deliberately do not reset errno on success: errno is process-global and
+  // clearing it here would race with other in-flight calls.
+  return invokeEntryPoint(entryPointFunc, input);
+}
+
+OMTensorList *ExecutionSession::runConcurrent(
+    const std::string &entryPointName, OMTensorList *input) {
+  // The resolved entry point lives only in per-call state, so concurrent
+  // callers may target different entry points without synchronization.
+  return invokeEntryPoint(resolveEntryPoint(entryPointName), input);
+}
+
+void ExecutionSession::runAsync(
+    OMTensorList *input, runAsyncCallbackType callback) {
+  // Capture the entry point at submission time so that a later
+  // setEntryPoint() does not affect requests already queued.
+  entryPointFuncType entryPointFunc = nullptr;
+  {
+    const std::lock_guard<std::mutex> lock(_entryPointMutex);
+    entryPointFunc = _entryPointFunc;
+  }
+  if (!entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runAsync"));
+
+  const std::lock_guard<std::mutex> lock(_asyncMutex);
+  if (_asyncWorkers.empty())
+    initAsyncWorkers();
+  _asyncQueue.push_back({entryPointFunc, input, std::move(callback)});
+  _asyncCond.notify_one();
+}
+
+void ExecutionSession::initAsyncWorkers() {
+  // A few workers suffice: they only pipeline requests into the compiled
+  // model, which does its own parallelization internally.
+  unsigned numWorkers = std::thread::hardware_concurrency();
+  if (numWorkers == 0)
+    numWorkers = 2;
+  if (numWorkers > 4)
+    numWorkers = 4;
+  for (unsigned i = 0; i < numWorkers; ++i)
+    _asyncWorkers.emplace_back(&ExecutionSession::asyncWorkerLoop, this);
+}
+
+void ExecutionSession::asyncWorkerLoop() {
+  for (;;) {
+    AsyncRequest request;
+    {
+      std::unique_lock<std::mutex> lock(_asyncMutex);
+      _asyncCond.wait(
+          lock, [this] { return _asyncShutdown || !_asyncQueue.empty(); });
+      if (_asyncQueue.empty())
+        return; // Shutting down and fully drained.
+      request = std::move(_asyncQueue.front());
+      _asyncQueue.pop_front();
+    }
+    OMTensorList *results = nullptr;
+    try {
+      results = invokeEntryPoint(request.func, request.input);
+    } catch (const std::runtime_error &) {
+      // Report the failure through the callback; errno carries the error.
+      results = nullptr;
+    }
+    request.callback(results);
+  }
+}
+
+void ExecutionSession::setMicroBatchPolicy(
+    int64_t maxBatchSize, int64_t maxDelayMicroseconds) {
+  if (maxBatchSize < 1 || maxDelayMicroseconds < 0)
+    throw std::runtime_error(reportBatchingError(
+        "the batch size bound must be positive and the delay non-negative"));
+  const std::lock_guard<std::mutex> lock(_batchMutex);
+  _maxBatchSize = maxBatchSize;
+  _maxBatchDelayMicroseconds = maxDelayMicroseconds;
+  // A tightened size bound may make the pending queue dispatchable at once.
+  _batchCond.notify_all();
+}
+
+void ExecutionSession::runMicroBatched(
+    OMTensorList *input, runAsyncCallbackType callback) {
+  if (!_entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runMicroBatched"));
+
+  const std::lock_guard<std::mutex> lock(_batchMutex);
+  if (!_microBatcher.joinable())
+    initMicroBatcher();
+  // The request's deadline bounds how long the batcher may hold its batch
+  // open waiting for company.
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::microseconds(_maxBatchDelayMicroseconds);
+  _batchQueue.push_back({input, std::move(callback), deadline});
+  _batchCond.notify_one();
+}
+
+void ExecutionSession::initMicroBatcher() {
+  // A single batcher thread keeps requests in arrival order and dispatches
+  // each coalesced batch inline; the compiled model parallelizes internally,
+  // so additional dispatchers would only contend with it for cores.
+  _microBatcher = std::thread(&ExecutionSession::microBatcherLoop, this);
+}
+
+void ExecutionSession::microBatcherLoop() {
+  for (;;) {
+    std::vector<MicroBatchRequest> batch;
+    {
+      std::unique_lock<std::mutex> lock(_batchMutex);
+      _batchCond.wait(
+          lock, [this] { return _batchShutdown || !_batchQueue.empty(); });
+      if (_batchQueue.empty())
+        return; // Shutting down and fully drained.
+      // Hold the batch open until it fills up or the oldest pending request
+      // reaches its deadline. A notification re-checks both bounds, so a
+      // burst of arrivals or a tightened policy dispatches immediately; at
+      // shutdown, whatever is pending goes out as the final batches.
+      while (!_batchShutdown && (int64_t)_batchQueue.size() < _maxBatchSize &&
+             _batchCond.wait_until(lock, _batchQueue.front().deadline) !=
+                 std::cv_status::timeout)
+        ;
+      int64_t count = std::min((int64_t)_batchQueue.size(), _maxBatchSize);
+      for (int64_t r = 0; r < count; ++r) {
+        batch.push_back(std::move(_batchQueue.front()));
+        _batchQueue.pop_front();
+      }
+    }
+    std::vector<OMTensorList *> inputs;
+    inputs.reserve(batch.size());
+    for (const MicroBatchRequest &request : batch)
+      inputs.push_back(request.input);
+    std::vector<OMTensorList *> results;
+    try {
+      results = runBatch(inputs);
+    } catch (const std::runtime_error &) {
+      // Report the failure to every request of the batch through its
+      // callback; errno carries the error, as for runAsync().
+      results.assign(batch.size(), nullptr);
+    }
+    for (size_t r = 0; r < batch.size(); ++r)
+      batch[r].callback(results[r]);
+  }
+}
+
+void ExecutionSession::initSpecializedEntryPoints() {
+  const std::lock_guard<std::mutex> lock(_entryPointMutex);
+  if (_specializedEntryPointsInitialized)
+    return;
+  // Specialized clones are emitted as <entry point>_s0, <entry point>_s1, ...
+  // with no gaps, so probe until the first missing symbol. Probe directly
+  // rather than through resolveEntryPoint, which throws on a missing symbol.
+  for (int64_t index = 0;; ++index) {
+    std::string name = _entryPointName + "_s" + std::to_string(index);
+    auto func = reinterpret_cast<entryPointFuncType>(
+        _sharedLibraryHandle.getAddressOfSymbol(name.c_str()));
+    if (!func)
+      break;
+    SpecializedEntryPoint entry;
+    entry.func = func;
+    // Extract the per-input "dims" : [d0 , d1 , ...] arrays from the clone's
+    // input signature (see inputSignature() for the full format).
+    std::string signature = _inputSignatureFunc(name.c_str());
+    size_t pos = 0;
+    while ((pos = signature.find("\"dims\"", pos)) != std::string::npos) {
+      pos = signature.find('[', pos);
+      if (pos == std::string::npos)
+        break;
+      size_t end = signature.find(']', pos);
+      if (end == std::string::npos)
+        break;
+      std::vector<int64_t> dims;
+      std::stringstream dimsString(signature.substr(pos + 1, end - pos - 1));
+      std::string dim;
+      while (std::getline(dimsString, dim, ','))
+        dims.emplace_back(std::stoll(dim));
+      entry.inputDims.emplace_back(dims);
+      pos = end;
+    }
+    _specializedEntryPoints.emplace_back(entry);
+  }
+  _specializedEntryPointsInitialized = true;
+}
+
+bool ExecutionSession::matchesDeclaredShapes(
+    const SpecializedEntryPoint &entry, OMTensorList *input) {
+  if ((int64_t)entry.inputDims.size() != omTensorListGetSize(input))
+    return false;
+  for (int64_t i = 0; i < omTensorListGetSize(input); ++i) {
+    OMTensor *omt = omTensorListGetOmtByIndex(input, i);
+    const std::vector<int64_t> &dims = entry.inputDims[i];
+    if ((int64_t)dims.size() != omTensorGetRank(omt))
+      return false;
+    for (size_t d = 0; d < dims.size(); ++d)
+      // A declared dynamic dimension matches any actual size.
+      if (dims[d] != -1 && dims[d] != omTensorGetShape(omt)[d])
+        return false;
+  }
+  return true;
+}
+
+OMTensorList *ExecutionSession::runDispatch(OMTensorList *input) {
+  entryPointFuncType entryPointFunc = nullptr;
+  {
+    const std::lock_guard<std::mutex> lock(_entryPointMutex);
+    entryPointFunc = _entryPointFunc;
+  }
+  if (!entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runDispatch"));
+  if (!_specializedEntryPointsInitialized)
+    initSpecializedEntryPoints();
+  for (const SpecializedEntryPoint &entry : _specializedEntryPoints)
+    if (matchesDeclaredShapes(entry, input)) {
+      _shapeDispatchHits.fetch_add(1, std::memory_order_relaxed);
+      return invokeEntryPoint(entry.func, input);
+    }
+  // No specialized version matches; run the generic entry point. As in
+  // runConcurrent, deliberately do not reset errno on success.
+  return invokeEntryPoint(entryPointFunc, input);
+}
+
+void ExecutionSession::initPerOutputEntryPoints() {
+  const std::lock_guard<std::mutex> lock(_entryPointMutex);
+  if (_perOutputEntryPointsInitialized)
+    return;
+  // Per-output clones are emitted as <entry point>_o0, <entry point>_o1, ...
+  // with no gaps, so probe until the first missing symbol. Probe directly
+  // rather than through resolveEntryPoint, which throws on a missing symbol.
+  for (int64_t index = 0;; ++index) {
+    std::string name = _entryPointName + "_o" + std::to_string(index);
+    auto func = reinterpret_cast<entryPointFuncType>(
+        _sharedLibraryHandle.getAddressOfSymbol(name.c_str()));
+    if (!func)
+      break;
+    _perOutputEntryPoints.emplace_back(func);
+  }
+  _perOutputEntryPointsInitialized = true;
+}
+
+std::vector<ExecutionSession::LazyOutput> ExecutionSession::runLazy(
+    OMTensorList *input) {
+  entryPointFuncType entryPointFunc = nullptr;
+  {
+    const std::lock_guard<std::mutex> lock(_entryPointMutex);
+    entryPointFunc = _entryPointFunc;
+  }
+  if (!entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runLazy"));
+  if (!_perOutputEntryPointsInitialized)
+    initPerOutputEntryPoints();
+
+  std::vector<LazyOutput> outputs;
+  if (!_perOutputEntryPoints.empty()) {
+    // One pending handle per per-output clone; nothing runs until a handle
+    // is materialized.
+    for (entryPointFuncType func : _perOutputEntryPoints)
+      outputs.emplace_back(LazyOutput(this, func, input, nullptr));
+    return outputs;
+  }
+  // Model compiled without --lazy-outputs: run the full model eagerly and
+  // hand each handle its already computed tensor. The result list is
+  // released shallowly; each tensor's ownership moves to its handle.
+  OMTensorList *results = invokeEntryPoint(entryPointFunc, input);
+  for (int64_t i = 0; i < omTensorListGetSize(results); ++i)
+    outputs.emplace_back(LazyOutput(
+        this, nullptr, input, omTensorListGetOmtByIndex(results, i)));
+  omTensorListDestroyShallow(results);
+  return outputs;
+}
+
+ExecutionSession::LazyOutput::LazyOutput(ExecutionSession *session,
+    entryPointFuncType func, OMTensorList *input, OMTensor *tensor)
+    : _session(session), _func(func), _input(input), _tensor(tensor) {}
+
+ExecutionSession::LazyOutput::LazyOutput(LazyOutput &&other)
+    : _session(other._session), _func(other._func), _input(other._input),
+      _tensor(other._tensor) {
+  other._func = nullptr;
+  other._tensor = nullptr;
+}
+
+OMTensor *ExecutionSession::LazyOutput::get() {
+  if (_tensor)
+    return _tensor;
+  if (!_func)
+    throw std::runtime_error(
+        _session->reportUndefinedEntryPointIn("LazyOutput::get"));
+  // Run this output's backward slice. The clone returns a single-tensor
+  // list; the tensor's ownership moves to the handle and the list is
+  // released shallowly.
+  OMTensorList *results = _session->invokeEntryPoint(_func, _input);
+  _tensor = omTensorListGetOmtByIndex(results, 0);
+  omTensorListDestroyShallow(results);
+  _func = nullptr;
+  return _tensor;
+}
+
+ExecutionSession::LazyOutput::~LazyOutput() {
+  if (_tensor)
+    omTensorDestroy(_tensor);
+}
+
 std::vector<OMTensorUniquePtr> ExecutionSession::run(
     std::vector<OMTensorUniquePtr> ins) {
   if (!_entryPointFunc)
@@ -85,7 +426,11 @@ std::vector<OMTensorUniquePtr> ExecutionSession::run(
     omts.emplace_back(inOmt.get());
   auto *wrappedInput = omTensorListCreate(&omts[0], (int64_t)omts.size());
 
+  auto start = std::chrono::steady_clock::now();
   auto *wrappedOutput = _entryPointFunc(wrappedInput);
+  recordRunTime(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start)
+                    .count());
 
   // We created a wrapper for the input list, but the input list does not really
   // own the tensor in the list, as they are coming as OMTensorUniquePtr. So we
@@ -121,7 +466,11 @@ OMTensorList *ExecutionSession::run(OMTensorList *input) {
     errno = EINVAL;
     throw std::runtime_error(errStr.str());
   }
+  auto start = std::chrono::steady_clock::now();
   OMTensorList *output = _entryPointFunc(input);
+  recordRunTime(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start)
+                    .count());
   if (!output) {
     std::stringstream errStr;
     std::string errMessageStr = std::string(strerror(errno));
@@ -133,6 +482,839 @@ OMTensorList *ExecutionSession::run(OMTensorList *input) {
   return output;
 }
 
+void ExecutionSession::setOutputBuffers(OMTensorList *outputs) {
+  _outputBuffers = outputs;
+  errno = 0; // No errors.
+}
+
+OMTensorList *ExecutionSession::runInto(OMTensorList *input) {
+  if (!_outputBuffers)
+    throw std::runtime_error(reportOutputBufferError(
+        "no output buffers registered; call setOutputBuffers first"));
+  return runInto(input, _outputBuffers);
+}
+
+OMTensorList *ExecutionSession::runInto(
+    OMTensorList *input, OMTensorList *outputs) {
+  if (!_entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runInto"));
+  OMTensorList *results = _entryPointFunc(input);
+  if (!results)
+    throw std::runtime_error(reportErrnoError());
+  // The generated entry point owns its result allocations; recycle them here
+  // so that the caller only ever sees its own long-lived buffers.
+  try {
+    copyResultsInto(results, outputs);
+  } catch (...) {
+    omTensorListDestroy(results);
+    throw;
+  }
+  omTensorListDestroy(results);
+  errno = 0; // No errors.
+  return outputs;
+}
+
+void ExecutionSession::copyResultsInto(
+    OMTensorList *results, OMTensorList *outputs) const {
+  if (omTensorListGetSize(results) != omTensorListGetSize(outputs))
+    throw std::runtime_error(reportOutputBufferError(
+        "the model produced a different number of outputs than registered"));
+  int64_t numOutputs = omTensorListGetSize(results);
+  // Validate every output before touching any caller buffer so that a failed
+  // call leaves the registered buffers untouched.
+  for (int64_t i = 0; i < numOutputs; ++i) {
+    OMTensor *res = omTensorListGetOmtByIndex(results, i);
+    OMTensor *out = omTensorListGetOmtByIndex(outputs, i);
+    if (omTensorGetDataType(res) != omTensorGetDataType(out))
+      throw std::runtime_error(reportOutputBufferError(
+          "a registered buffer disagrees with its result on element type"));
+    if (omTensorGetRank(res) != omTensorGetRank(out))
+      throw std::runtime_error(reportOutputBufferError(
+          "a registered buffer disagrees with its result on rank"));
+    if (omTensorGetBufferSize(res) > omTensorGetBufferSize(out))
+      throw std::runtime_error(
+          reportOutputBufferError("a registered buffer is too small to hold "
+                                  "its result"));
+  }
+  for (int64_t i = 0; i < numOutputs; ++i) {
+    OMTensor *res = omTensorListGetOmtByIndex(results, i);
+    OMTensor *out = omTensorListGetOmtByIndex(outputs, i);
+    memcpy(omTensorGetDataPtr(out), omTensorGetDataPtr(res),
+        omTensorGetBufferSize(res));
+    // Propagate dynamic result dimensions into the caller's buffer.
+    omTensorSetShape(out, omTensorGetShape(res));
+  }
+}
+
+std::vector<OMTensorList *> ExecutionSession::runBatch(
+    const std::vector<OMTensorList *> &inputs) {
+  if (!_entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runBatch"));
+  if (inputs.empty())
+    return {};
+  // A single request needs no coalescing.
+  if (inputs.size() == 1)
+    return {run(inputs[0])};
+
+  int64_t numRequests = (int64_t)inputs.size();
+  int64_t numInputs = omTensorListGetSize(inputs[0]);
+
+  // Validate that requests are compatible and record, per request, how many
+  // leading-dimension samples it contributes (taken from its first input).
+  std::vector<int64_t> requestBatchSizes(numRequests);
+  for (int64_t r = 0; r < numRequests; ++r) {
+    if (omTensorListGetSize(inputs[r]) != numInputs)
+      throw std::runtime_error(reportBatchingError(
+          "requests disagree on the number of input tensors"));
+    for (int64_t i = 0; i < numInputs; ++i) {
+      OMTensor *omt = omTensorListGetOmtByIndex(inputs[r], i);
+      OMTensor *ref = omTensorListGetOmtByIndex(inputs[0], i);
+      if (omTensorGetRank(omt) < 1)
+        throw std::runtime_error(reportBatchingError(
+            "scalar inputs have no leading dimension to batch along"));
+      if (omTensorGetRank(omt) != omTensorGetRank(ref) ||
+          omTensorGetDataType(omt) != omTensorGetDataType(ref))
+        throw std::runtime_error(reportBatchingError(
+            "requests disagree on input rank or element type"));
+      for (int64_t d = 1; d < omTensorGetRank(omt); ++d)
+        if (omTensorGetShape(omt)[d] != omTensorGetShape(ref)[d])
+          throw std::runtime_error(reportBatchingError(
+              "requests disagree on a non-leading input dimension"));
+    }
+    requestBatchSizes[r] =
+        omTensorGetShape(omTensorListGetOmtByIndex(inputs[r], 0))[0];
+  }
+  int64_t totalBatchSize = 0;
+  for (int64_t r = 0; r < numRequests; ++r)
+    totalBatchSize += requestBatchSizes[r];
+
+  // Coalesce each input across requests along the leading dimension. Per
+  // request, samples are stored contiguously, so a single memcpy per request
+  // suffices.
+  std::vector<OMTensor *> batchedInputs(numInputs);
+  for (int64_t i = 0; i < numInputs; ++i) {
+    OMTensor *ref = omTensorListGetOmtByIndex(inputs[0], i);
+    int64_t rank = omTensorGetRank(ref);
+    std::vector<int64_t> shape(
+        omTensorGetShape(ref), omTensorGetShape(ref) + rank);
+    shape[0] = totalBatchSize;
+    OMTensor *batched =
+        omTensorCreateEmpty(shape.data(), rank, omTensorGetDataType(ref));
+    char *dst = (char *)omTensorGetDataPtr(batched);
+    for (int64_t r = 0; r < numRequests; ++r) {
+      OMTensor *omt = omTensorListGetOmtByIndex(inputs[r], i);
+      int64_t bytes = omTensorGetBufferSize(omt);
+      memcpy(dst, omTensorGetDataPtr(omt), bytes);
+      dst += bytes;
+    }
+    batchedInputs[i] = batched;
+  }
+  OMTensorList *batchedInputList =
+      omTensorListCreate(batchedInputs.data(), numInputs);
+
+  OMTensorList *batchedOutputList = _entryPointFunc(batchedInputList);
+  // Destroys the coalesced input tensors; the pointer array belongs to the
+  // local vector and is left alone.
+  omTensorListDestroy(batchedInputList);
+  if (!batchedOutputList)
+    throw std::runtime_error(reportErrnoError());
+
+  // Scatter each output back to its originating request, splitting the
+  // leading dimension proportionally to each request's contribution.
+  int64_t numOutputs = omTensorListGetSize(batchedOutputList);
+  for (int64_t o = 0; o < numOutputs; ++o) {
+    OMTensor *batched = omTensorListGetOmtByIndex(batchedOutputList, o);
+    if (omTensorGetRank(batched) < 1 ||
+        omTensorGetShape(batched)[0] != totalBatchSize) {
+      omTensorListDestroy(batchedOutputList);
+      throw std::runtime_error(reportBatchingError(
+          "output leading dimension does not match the coalesced batch"));
+    }
+  }
+  std::vector<OMTensorList *> results(numRequests);
+  for (int64_t r = 0; r < numRequests; ++r) {
+    // The pointer array is handed over to the result list, which frees it on
+    // omTensorListDestroy, so it must come from malloc.
+    OMTensor **requestOutputs =
+        (OMTensor **)malloc(numOutputs * sizeof(OMTensor *));
+    for (int64_t o = 0; o < numOutputs; ++o) {
+      OMTensor *batched = omTensorListGetOmtByIndex(batchedOutputList, o);
+      int64_t rank = omTensorGetRank(batched);
+      std::vector<int64_t> shape(
+          omTensorGetShape(batched), omTensorGetShape(batched) + rank);
+      int64_t sampleBytes = omTensorGetBufferSize(batched) / totalBatchSize;
+      int64_t offset = 0;
+      for (int64_t p = 0; p < r; ++p)
+        offset += requestBatchSizes[p];
+      shape[0] = requestBatchSizes[r];
+      OMTensor *split =
+          omTensorCreateEmpty(shape.data(), rank, omTensorGetDataType(batched));
+      memcpy(omTensorGetDataPtr(split),
+          (char *)omTensorGetDataPtr(batched) + offset * sampleBytes,
+          requestBatchSizes[r] * sampleBytes);
+      requestOutputs[o] = split;
+    }
+    results[r] =
+        omTensorListCreateWithOwnership(requestOutputs, numOutputs, true);
+  }
+  omTensorListDestroy(batchedOutputList);
+  errno = 0; // No errors.
+  return results;
+}
+
+void ExecutionSession::runStream(OMTensorList *input, int64_t streamAxis,
+    int64_t chunkSize, runStreamCallbackType callback) {
+  if (!_entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runStream"));
+  int64_t numInputs = omTensorListGetSize(input);
+  if (numInputs < 1 || chunkSize < 1)
+    throw std::runtime_error(reportStreamingError(
+        "need at least one input and a positive chunk size"));
+
+  // Every input must carry the streamed dimension with the same extent.
+  OMTensor *first = omTensorListGetOmtByIndex(input, 0);
+  if (streamAxis < 0 || streamAxis >= omTensorGetRank(first))
+    throw std::runtime_error(reportStreamingError(
+        "the streamed dimension is out of range for the first input"));
+  int64_t streamExtent = omTensorGetShape(first)[streamAxis];
+  for (int64_t i = 1; i < numInputs; ++i) {
+    OMTensor *omt = omTensorListGetOmtByIndex(input, i);
+    if (streamAxis >= omTensorGetRank(omt) ||
+        omTensorGetShape(omt)[streamAxis] != streamExtent)
+      throw std::runtime_error(reportStreamingError(
+          "inputs disagree on the extent of the streamed dimension"));
+  }
+
+  for (int64_t start = 0, chunkIndex = 0; start < streamExtent;
+       start += chunkSize, ++chunkIndex) {
+    int64_t len = std::min(chunkSize, streamExtent - start);
+    std::vector<OMTensor *> chunkInputs(numInputs);
+    for (int64_t i = 0; i < numInputs; ++i) {
+      OMTensor *omt = omTensorListGetOmtByIndex(input, i);
+      int64_t rank = omTensorGetRank(omt);
+      std::vector<int64_t> shape(
+          omTensorGetShape(omt), omTensorGetShape(omt) + rank);
+      int64_t outerCount = 1;
+      for (int64_t d = 0; d < streamAxis; ++d)
+        outerCount *= shape[d];
+      // Bytes of one index step along the streamed dimension within one
+      // outer block.
+      int64_t innerBytes =
+          omTensorGetBufferSize(omt) / (outerCount * streamExtent);
+      shape[streamAxis] = len;
+      char *src = (char *)omTensorGetDataPtr(omt);
+      if (streamAxis == 0) {
+        // A leading-dimension chunk is a contiguous slab; hand the model a
+        // non-owning view instead of a copy.
+        chunkInputs[i] = omTensorCreateWithOwnership(src + start * innerBytes,
+            shape.data(), rank, omTensorGetDataType(omt), /*owning=*/0);
+      } else {
+        OMTensor *chunk = omTensorCreateEmpty(
+            shape.data(), rank, omTensorGetDataType(omt));
+        char *dst = (char *)omTensorGetDataPtr(chunk);
+        for (int64_t outer = 0; outer < outerCount; ++outer)
+          memcpy(dst + outer * len * innerBytes,
+              src + (outer * streamExtent + start) * innerBytes,
+              len * innerBytes);
+        chunkInputs[i] = chunk;
+      }
+    }
+    OMTensorList *chunkInputList =
+        omTensorListCreate(chunkInputs.data(), numInputs);
+    OMTensorList *chunkOutput = _entryPointFunc(chunkInputList);
+    // Destroys the chunk input tensors; the pointer array belongs to the
+    // local vector and is left alone.
+    omTensorListDestroy(chunkInputList);
+    if (!chunkOutput)
+      throw std::runtime_error(reportErrnoError());
+    callback(chunkIndex, chunkOutput);
+  }
+  errno = 0; // No errors.
+}
+
+OMTensorList *ExecutionSession::runStream(
+    OMTensorList *input, int64_t streamAxis, int64_t chunkSize) {
+  std::vector<OMTensorList *> chunkOutputs;
+  runStream(input, streamAxis, chunkSize,
+      [&chunkOutputs](int64_t, OMTensorList *chunkOutput) {
+        chunkOutputs.push_back(chunkOutput);
+      });
+  auto destroyChunkOutputs = [&chunkOutputs]() {
+    for (OMTensorList *list : chunkOutputs)
+      omTensorListDestroy(list);
+  };
+  if (chunkOutputs.empty())
+    throw std::runtime_error(
+        reportStreamingError("the streamed dimension is empty"));
+  if (chunkOutputs.size() == 1)
+    return chunkOutputs[0];
+
+  // Validate that the chunk outputs can be concatenated along the streamed
+  // dimension: same tensor count, rank, and element type, and agreeing on
+  // every other dimension.
+  int64_t numChunks = (int64_t)chunkOutputs.size();
+  int64_t numOutputs = omTensorListGetSize(chunkOutputs[0]);
+  for (int64_t c = 0; c < numChunks; ++c) {
+    if (omTensorListGetSize(chunkOutputs[c]) != numOutputs) {
+      destroyChunkOutputs();
+      throw std::runtime_error(reportStreamingError(
+          "chunks disagree on the number of output tensors"));
+    }
+    for (int64_t o = 0; o < numOutputs; ++o) {
+      OMTensor *omt = omTensorListGetOmtByIndex(chunkOutputs[c], o);
+      OMTensor *ref = omTensorListGetOmtByIndex(chunkOutputs[0], o);
+      if (omTensorGetRank(omt) != omTensorGetRank(ref) ||
+          omTensorGetDataType(omt) != omTensorGetDataType(ref) ||
+          streamAxis >= omTensorGetRank(omt)) {
+        destroyChunkOutputs();
+        throw std::runtime_error(reportStreamingError(
+            "chunks disagree on output rank or element type, or an output "
+            "does not carry the streamed dimension"));
+      }
+      for (int64_t d = 0; d < omTensorGetRank(omt); ++d)
+        if (d != streamAxis &&
+            omTensorGetShape(omt)[d] != omTensorGetShape(ref)[d]) {
+          destroyChunkOutputs();
+          throw std::runtime_error(reportStreamingError(
+              "chunks disagree on a non-streamed output dimension"));
+        }
+    }
+  }
+
+  // Concatenate each output across chunks along the streamed dimension.
+  // The pointer array is handed over to the result list, which frees it on
+  // omTensorListDestroy, so it must come from malloc.
+  OMTensor **outputs = (OMTensor **)malloc(numOutputs * sizeof(OMTensor *));
+  for (int64_t o = 0; o < numOutputs; ++o) {
+    OMTensor *ref = omTensorListGetOmtByIndex(chunkOutputs[0], o);
+    int64_t rank = omTensorGetRank(ref);
+    int64_t totalExtent = 0;
+    for (int64_t c = 0; c < numChunks; ++c)
+      totalExtent +=
+          omTensorGetShape(omTensorListGetOmtByIndex(chunkOutputs[c], o))
+              [streamAxis];
+    std::vector<int64_t> shape(
+        omTensorGetShape(ref), omTensorGetShape(ref) + rank);
+    shape[streamAxis] = totalExtent;
+    int64_t outerCount = 1;
+    for (int64_t d = 0; d < streamAxis; ++d)
+      outerCount *= shape[d];
+    OMTensor *merged =
+        omTensorCreateEmpty(shape.data(), rank, omTensorGetDataType(ref));
+    char *dst = (char *)omTensorGetDataPtr(merged);
+    int64_t mergedOffset = 0;
+    for (int64_t c = 0; c < numChunks; ++c) {
+      OMTensor *omt = omTensorListGetOmtByIndex(chunkOutputs[c], o);
+      int64_t chunkExtent = omTensorGetShape(omt)[streamAxis];
+      int64_t innerBytes =
+          omTensorGetBufferSize(omt) / (outerCount * chunkExtent);
+      char *src = (char *)omTensorGetDataPtr(omt);
+      for (int64_t outer = 0; outer < outerCount; ++outer)
+        memcpy(dst + (outer * totalExtent + mergedOffset) * innerBytes,
+            src + outer * chunkExtent * innerBytes, chunkExtent * innerBytes);
+      mergedOffset += chunkExtent;
+    }
+    outputs[o] = merged;
+  }
+  OMTensorList *result =
+      omTensorListCreateWithOwnership(outputs, numOutputs, true);
+  destroyChunkOutputs();
+  errno = 0; // No errors.
+  return result;
+}
+
+// Map an element type string of the input signature (see concatTypeString in
+// ConvertONNXToKrnl.cpp for the full list) to the OMTensor data type.
+static OM_DATA_TYPE dataTypeFromSignatureType(const std::string &type) {
+  if (type == "f32")
+    return ONNX_TYPE_FLOAT;
+  if (type == "f64")
+    return ONNX_TYPE_DOUBLE;
+  if (type == "i1")
+    return ONNX_TYPE_BOOL;
+  if (type == "i8")
+    return ONNX_TYPE_INT8;
+  if (type == "i16")
+    return ONNX_TYPE_INT16;
+  if (type == "i32")
+    return ONNX_TYPE_INT32;
+  if (type == "i64")
+    return ONNX_TYPE_INT64;
+  if (type == "ui8")
+    return ONNX_TYPE_UINT8;
+  if (type == "ui16")
+    return ONNX_TYPE_UINT16;
+  if (type == "ui32")
+    return ONNX_TYPE_UINT32;
+  if (type == "ui64")
+    return ONNX_TYPE_UINT64;
+  return ONNX_TYPE_UNDEFINED;
+}
+
+OMTensorList *ExecutionSession::createWarmupInputs() const {
+  // Parse the per-input "type" and "dims" entries from the input signature
+  // (see inputSignature() for the format). Declared dynamic dimensions run
+  // as 1, the smallest extent every model accepts.
+  std::string signature = _inputSignatureFunc(_entryPointName.c_str());
+  if (signature.find("\"seq\"") != std::string::npos)
+    throw std::runtime_error(
+        reportWarmupError("sequence-typed inputs are not supported"));
+  std::vector<OMTensor *> inputs;
+  size_t pos = 0;
+  while ((pos = signature.find("\"type\"", pos)) != std::string::npos) {
+    // The element type is printed unquoted between the colon and the comma.
+    size_t colon = signature.find(':', pos);
+    size_t comma = signature.find(',', pos);
+    size_t open = signature.find('[', pos);
+    size_t close = signature.find(']', pos);
+    if (colon == std::string::npos || comma == std::string::npos ||
+        open == std::string::npos || close == std::string::npos)
+      throw std::runtime_error(
+          reportWarmupError("the input signature is malformed"));
+    std::string typeStr = signature.substr(colon + 1, comma - colon - 1);
+    typeStr.erase(std::remove(typeStr.begin(), typeStr.end(), ' '),
+        typeStr.end());
+    OM_DATA_TYPE dataType = dataTypeFromSignatureType(typeStr);
+    if (dataType == ONNX_TYPE_UNDEFINED)
+      throw std::runtime_error(reportWarmupError(
+          "an input has the unsupported element type '" + typeStr + "'"));
+    std::vector<int64_t> dims;
+    std::stringstream dimsString(signature.substr(open + 1, close - open - 1));
+    std::string dim;
+    while (std::getline(dimsString, dim, ','))
+      dims.emplace_back(std::stoll(dim));
+    for (int64_t &d : dims)
+      if (d < 0)
+        d = 1;
+    OMTensor *omt =
+        omTensorCreateEmpty(dims.data(), (int64_t)dims.size(), dataType);
+    if (!omt) {
+      for (OMTensor *prev : inputs)
+        omTensorDestroy(prev);
+      throw std::runtime_error(
+          reportWarmupError("an input tensor could not be allocated"));
+    }
+    memset(omTensorGetDataPtr(omt), 0, omTensorGetBufferSize(omt));
+    inputs.emplace_back(omt);
+    pos = close;
+  }
+  return omTensorListCreate(inputs.data(), (int64_t)inputs.size());
+}
+
+void ExecutionSession::warmup(bool runDummyInference) {
+  if (!_entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("warmup"));
+
+  // Resolve every entry point up front so that no real request pays for the
+  // lazy symbol binding of a first call.
+  int64_t numEntryPoints = 0;
+  const char **entryPointNames = _queryEntryPointsFunc(&numEntryPoints);
+  for (int64_t i = 0; i < numEntryPoints; ++i)
+    (void)resolveEntryPoint(entryPointNames[i]);
+
+  // Enumerate the shape-specialized and per-output clones so neither the
+  // first runDispatch() nor the first runLazy() call does it on the request
+  // path.
+  initSpecializedEntryPoints();
+  initPerOutputEntryPoints();
+
+  if (runDummyInference) {
+    OMTensorList *input = createWarmupInputs();
+    // A failed dummy inference (e.g. a model that rejects all-zero inputs)
+    // still warmed code and weight pages, so it is not reported as an error.
+    OMTensorList *output = _entryPointFunc(input);
+    if (output)
+      omTensorListDestroy(output);
+    omTensorListDestroy(input);
+  }
+
+  // Touch every page of an external constants file. The dummy inference maps
+  // the file but only faults the pages its computation happens to read; this
+  // completes the job. The symbol lives in the runtime linked into the model
+  // library and is absent from libraries built before it existed, in which
+  // case there is nothing we can fault in eagerly.
+  typedef void (*prefaultFuncType)();
+  auto prefaultFunc = reinterpret_cast<prefaultFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol("omPrefaultExternalConstants"));
+  if (prefaultFunc)
+    prefaultFunc();
+  errno = 0; // No errors.
+}
+
+int64_t ExecutionSession::arenaSnapshot() {
+  // The symbol lives in the runtime linked into the model library; resolving
+  // per call keeps the pair valid across reload(). Libraries built before
+  // the arena existed have nothing to snapshot.
+  typedef int64_t (*arenaSnapshotFuncType)();
+  auto snapshotFunc = reinterpret_cast<arenaSnapshotFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol("omArenaSnapshot"));
+  if (!snapshotFunc)
+    return 0;
+  return snapshotFunc();
+}
+
+void ExecutionSession::arenaRestore(int64_t watermark) {
+  typedef void (*arenaRestoreFuncType)(int64_t);
+  auto restoreFunc = reinterpret_cast<arenaRestoreFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol("omArenaRestore"));
+  if (restoreFunc)
+    restoreFunc(watermark);
+}
+
+int64_t ExecutionSession::memoryTrim() {
+  // The arena lives in the runtime linked into the model library; resolving
+  // per call keeps the trim valid across reload(). Libraries predating the
+  // trimming API hold no releasable pages.
+  typedef int64_t (*memoryTrimFuncType)();
+  auto trimFunc = reinterpret_cast<memoryTrimFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol("omMemoryTrim"));
+  if (!trimFunc)
+    return 0;
+  return trimFunc();
+}
+
+void ExecutionSession::setPriority(int64_t priority) {
+  // The priority lives in the task pool of the runtime linked into the model
+  // library; resolving per call keeps it valid across reload(). Libraries
+  // predating pool priorities have no scheduling to influence.
+  typedef void (*setPriorityFuncType)(int64_t);
+  auto setPriorityFunc = reinterpret_cast<setPriorityFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol("omSetParallelPriority"));
+  if (setPriorityFunc)
+    setPriorityFunc(priority);
+}
+
+void ExecutionSession::setRuntimeOption(
+    const std::string &key, const std::string &value) {
+  // The option store lives in the runtime linked into the model library;
+  // resolving per call keeps it valid across reload(). Libraries predating
+  // the option API have no programmatic knobs to set.
+  typedef int64_t (*setRuntimeOptionFuncType)(const char *, const char *);
+  auto setOptionFunc = reinterpret_cast<setRuntimeOptionFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol("omSetRuntimeOption"));
+  if (!setOptionFunc)
+    return;
+  if (setOptionFunc(key.c_str(), value.c_str()) != 0)
+    throw std::runtime_error(reportRuntimeOptionError(key));
+}
+
+OMRunStats ExecutionSession::getRunStats() {
+  OMRunStats stats;
+  // The allocator counters live in the runtime linked into the model
+  // library; resolving per call keeps them valid across reload(). Libraries
+  // predating the API report zero for those fields.
+  typedef void (*getRunStatsFuncType)(OMRunStats *);
+  auto statsFunc = reinterpret_cast<getRunStatsFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol("omGetRunStats"));
+  if (statsFunc)
+    statsFunc(&stats);
+  else
+    memset(&stats, 0, sizeof(OMRunStats));
+  stats.numRuns = _numRuns.load(std::memory_order_relaxed);
+  stats.lastRunTimeNs = _lastRunTimeNs.load(std::memory_order_relaxed);
+  stats.totalRunTimeNs = _totalRunTimeNs.load(std::memory_order_relaxed);
+  stats.shapeDispatchHits =
+      _shapeDispatchHits.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool ExecutionSession::heapProfileDump(const std::string &fileName) {
+  // Like the run stats, the counters live in the runtime linked into the
+  // model library; resolving per call keeps the dump valid across reload().
+  typedef int64_t (*heapProfileDumpFuncType)(const char *);
+  auto dumpFunc = reinterpret_cast<heapProfileDumpFuncType>(
+      _sharedLibraryHandle.getAddressOfSymbol("omHeapProfileDump"));
+  if (!dumpFunc)
+    return false;
+  return dumpFunc(fileName.empty() ? nullptr : fileName.c_str()) == 0;
+}
+
+void ExecutionSession::setShapeProfiling(bool enable) {
+  _shapeProfiling.store(enable, std::memory_order_relaxed);
+  errno = 0; // No errors.
+}
+
+void ExecutionSession::recordInputShapes(OMTensorList *input) const {
+  // Serialize the shapes in the shape-information syntax the compiler takes
+  // back through --shape-profile, e.g. "0:1x3x224x224,1:1x5".
+  std::stringstream spec;
+  for (int64_t i = 0; i < omTensorListGetSize(input); ++i) {
+    OMTensor *omt = omTensorListGetOmtByIndex(input, i);
+    if (i > 0)
+      spec << ",";
+    spec << i << ":";
+    for (int64_t d = 0; d < omTensorGetRank(omt); ++d) {
+      if (d > 0)
+        spec << "x";
+      spec << omTensorGetShape(omt)[d];
+    }
+  }
+  const std::lock_guard<std::mutex> lock(_shapeProfileMutex);
+  ++_shapeProfileCounts[spec.str()];
+}
+
+bool ExecutionSession::shapeProfileDump(const std::string &fileName) {
+  std::vector<std::pair<int64_t, std::string>> entries;
+  {
+    const std::lock_guard<std::mutex> lock(_shapeProfileMutex);
+    for (const auto &entry : _shapeProfileCounts)
+      entries.emplace_back(entry.second, entry.first);
+  }
+  // Most frequent first; the lexicographic tie-break keeps the output
+  // stable across dumps.
+  std::sort(entries.rbegin(), entries.rend());
+  std::ofstream file;
+  std::ostream *out = &std::cerr;
+  if (!fileName.empty()) {
+    file.open(fileName);
+    if (!file.is_open())
+      return false;
+    out = &file;
+  }
+  for (const auto &entry : entries)
+    *out << entry.first << " " << entry.second << "\n";
+  errno = 0; // No errors.
+  return true;
+}
+
+void ExecutionSession::reload(const std::string &sharedLibPath) {
+  // Load and fully validate the new library before touching any session
+  // state, so that a failed reload leaves the session serving the old model.
+  llvm::sys::DynamicLibrary newHandle =
+      llvm::sys::DynamicLibrary::getLibrary(sharedLibPath.c_str());
+  if (!newHandle.isValid())
+    throw std::runtime_error(reportLibraryOpeningError(sharedLibPath));
+
+  auto queryEntryPointsFunc = reinterpret_cast<queryEntryPointsFuncType>(
+      newHandle.getAddressOfSymbol(_queryEntryPointsName.c_str()));
+  auto inputSignatureFunc = reinterpret_cast<signatureFuncType>(
+      newHandle.getAddressOfSymbol(_inputSignatureName.c_str()));
+  auto outputSignatureFunc = reinterpret_cast<signatureFuncType>(
+      newHandle.getAddressOfSymbol(_outputSignatureName.c_str()));
+  entryPointFuncType entryPointFunc = nullptr;
+  if (!_entryPointName.empty())
+    entryPointFunc = reinterpret_cast<entryPointFuncType>(
+        newHandle.getAddressOfSymbol(_entryPointName.c_str()));
+  if (!queryEntryPointsFunc || !inputSignatureFunc || !outputSignatureFunc ||
+      (!_entryPointName.empty() && !entryPointFunc)) {
+    std::string missing = !queryEntryPointsFunc ? _queryEntryPointsName
+                          : !inputSignatureFunc ? _inputSignatureName
+                          : !outputSignatureFunc
+                              ? _outputSignatureName
+                              : _entryPointName;
+    llvm::sys::DynamicLibrary::closeLibrary(newHandle);
+    throw std::runtime_error(reportSymbolLoadingError(missing));
+  }
+
+  // Swap atomically with respect to the entry point lock: requests arriving
+  // after this block run the new model.
+  llvm::sys::DynamicLibrary oldHandle;
+  {
+    const std::lock_guard<std::mutex> lock(_entryPointMutex);
+    oldHandle = _sharedLibraryHandle;
+    _sharedLibraryHandle = newHandle;
+    _entryPointFunc = entryPointFunc;
+    _queryEntryPointsFunc = queryEntryPointsFunc;
+    _inputSignatureFunc = inputSignatureFunc;
+    _outputSignatureFunc = outputSignatureFunc;
+    // The cached clone enumerations describe the old library; re-enumerate
+    // them lazily (or via warmup()) against the new one.
+    _specializedEntryPointsInitialized = false;
+    _specializedEntryPoints.clear();
+    _perOutputEntryPointsInitialized = false;
+    _perOutputEntryPoints.clear();
+    // Held state tensors were produced by the old model; the next
+    // runStateful() call starts a fresh sequence against the new one.
+    if (_heldStateOutputs) {
+      omTensorListDestroy(_heldStateOutputs);
+      _heldStateOutputs = nullptr;
+    }
+    _heldQuantState.clear();
+  }
+
+  // Unload the old library only after the swap. Weight segments shared with
+  // the new version through content-hashed constants files stay mapped and
+  // keep their pages; everything exclusive to the old version is released
+  // here, so the reload never holds two full weight sets.
+  if (oldHandle.isValid())
+    llvm::sys::DynamicLibrary::closeLibrary(oldHandle);
+  errno = 0; // No errors.
+}
+
+void ExecutionSession::bindState(int64_t inputIndex, int64_t outputIndex) {
+  if (inputIndex < 0 || outputIndex < 0)
+    throw std::runtime_error(
+        reportStateError("state indices must be non-negative"));
+  for (const std::pair<int64_t, int64_t> &pair : _statePairs)
+    if (pair.first == inputIndex)
+      throw std::runtime_error(
+          reportStateError("input " + std::to_string(inputIndex) +
+                           " is already bound to an output"));
+  _statePairs.emplace_back(inputIndex, outputIndex);
+  errno = 0; // No errors.
+}
+
+// Block size of the per-block state quantization: each run of 64 consecutive
+// float elements shares one scale. Small enough to track the local dynamic
+// range within a cache row, large enough that the scales add well under 2%
+// to the compact copy.
+static constexpr int64_t kStateQuantBlockSize = 64;
+
+void ExecutionSession::setStateQuantization(bool enable) {
+  if (_heldStateOutputs || !_heldQuantState.empty())
+    throw std::runtime_error(
+        reportStateError("state quantization cannot be toggled while a "
+                         "sequence is in flight; call resetState first"));
+  _quantizeState = enable;
+  errno = 0; // No errors.
+}
+
+ExecutionSession::QuantizedState ExecutionSession::quantizeStateTensor(
+    const OMTensor *omt) const {
+  QuantizedState state;
+  const int64_t *shape = omTensorGetShape(omt);
+  state.shape.assign(shape, shape + omTensorGetRank(omt));
+  state.dataType = omTensorGetDataType(omt);
+  if (state.dataType != ONNX_TYPE_FLOAT) {
+    // Only float caches have the headroom for lossy storage; anything else
+    // is held as an exact copy.
+    const int8_t *src = (const int8_t *)omTensorGetDataPtr(omt);
+    state.data.assign(src, src + omTensorGetBufferSize(omt));
+    return state;
+  }
+  int64_t numElems = omTensorGetNumElems(omt);
+  const float *src = (const float *)omTensorGetDataPtr(omt);
+  int64_t numBlocks =
+      (numElems + kStateQuantBlockSize - 1) / kStateQuantBlockSize;
+  state.data.resize(numElems);
+  state.scales.resize(numBlocks);
+  for (int64_t b = 0; b < numBlocks; ++b) {
+    int64_t begin = b * kStateQuantBlockSize;
+    int64_t end = std::min(begin + kStateQuantBlockSize, numElems);
+    float maxAbs = 0.0f;
+    for (int64_t i = begin; i < end; ++i)
+      maxAbs = std::max(maxAbs, std::fabs(src[i]));
+    // An all-zero block keeps scale zero and dequantizes back to zeros.
+    float scale = maxAbs / 127.0f;
+    state.scales[b] = scale;
+    float inv = scale > 0.0f ? 1.0f / scale : 0.0f;
+    for (int64_t i = begin; i < end; ++i)
+      state.data[i] = (int8_t)std::lrintf(src[i] * inv);
+  }
+  return state;
+}
+
+OMTensor *ExecutionSession::dequantizeStateTensor(
+    const QuantizedState &state) const {
+  OMTensor *omt =
+      omTensorCreateEmpty(const_cast<int64_t *>(state.shape.data()),
+          (int64_t)state.shape.size(), state.dataType);
+  if (!omt)
+    throw std::runtime_error(
+        reportStateError("failed to allocate a state tensor"));
+  if (state.dataType != ONNX_TYPE_FLOAT) {
+    memcpy(omTensorGetDataPtr(omt), state.data.data(), state.data.size());
+    return omt;
+  }
+  float *dst = (float *)omTensorGetDataPtr(omt);
+  int64_t numElems = (int64_t)state.data.size();
+  for (int64_t i = 0; i < numElems; ++i)
+    dst[i] = (float)state.data[i] * state.scales[i / kStateQuantBlockSize];
+  return omt;
+}
+
+void ExecutionSession::resetState() {
+  if (_heldStateOutputs) {
+    omTensorListDestroy(_heldStateOutputs);
+    _heldStateOutputs = nullptr;
+  }
+  _heldQuantState.clear();
+  errno = 0; // No errors.
+}
+
+OMTensorList *ExecutionSession::runStateful(OMTensorList *input) {
+  if (!_entryPointFunc)
+    throw std::runtime_error(reportUndefinedEntryPointIn("runStateful"));
+  if (_statePairs.empty())
+    throw std::runtime_error(
+        reportStateError("no state pairs are bound; call bindState first"));
+  int64_t numInputs = omTensorListGetSize(input);
+  for (const std::pair<int64_t, int64_t> &pair : _statePairs)
+    if (pair.first >= numInputs ||
+        (_heldStateOutputs &&
+            pair.second >= omTensorListGetSize(_heldStateOutputs)))
+      throw std::runtime_error(
+          reportStateError("a bound state index is out of range"));
+
+  // After the first step, splice the held state tensors into their input
+  // slots by pointer; the caller's entries in those slots are ignored. The
+  // wrapper list does not own the tensors and is released shallowly. Under
+  // state quantization the compact copies are re-materialized first into
+  // transient full-precision tensors that live only for this call.
+  OMTensorList *effectiveInput = input;
+  OMTensorList *splicedInput = nullptr;
+  std::vector<OMTensor *> omts(numInputs);
+  std::vector<OMTensor *> dequantized;
+  if (_heldStateOutputs) {
+    for (int64_t i = 0; i < numInputs; ++i)
+      omts[i] = omTensorListGetOmtByIndex(input, i);
+    for (const std::pair<int64_t, int64_t> &pair : _statePairs)
+      omts[pair.first] = omTensorListGetOmtByIndex(_heldStateOutputs,
+          pair.second);
+    splicedInput = omTensorListCreate(omts.data(), numInputs);
+    effectiveInput = splicedInput;
+  } else if (!_heldQuantState.empty()) {
+    for (int64_t i = 0; i < numInputs; ++i)
+      omts[i] = omTensorListGetOmtByIndex(input, i);
+    for (size_t i = 0; i < _statePairs.size(); ++i) {
+      OMTensor *state = dequantizeStateTensor(_heldQuantState[i]);
+      dequantized.emplace_back(state);
+      omts[_statePairs[i].first] = state;
+    }
+    splicedInput = omTensorListCreate(omts.data(), numInputs);
+    effectiveInput = splicedInput;
+  }
+
+  OMTensorList *results = nullptr;
+  try {
+    results = invokeEntryPoint(_entryPointFunc, effectiveInput);
+  } catch (...) {
+    omTensorListDestroyShallow(splicedInput);
+    for (OMTensor *omt : dequantized)
+      omTensorDestroy(omt);
+    throw;
+  }
+  omTensorListDestroyShallow(splicedInput);
+  for (OMTensor *omt : dequantized)
+    omTensorDestroy(omt);
+
+  for (const std::pair<int64_t, int64_t> &pair : _statePairs)
+    if (pair.second >= omTensorListGetSize(results)) {
+      omTensorListDestroy(results);
+      throw std::runtime_error(reportStateError(
+          "a bound state output index is out of range for the entry point"));
+    }
+
+  // Hold only the compact copies of the new state; the full-precision output
+  // list belongs to the caller (see setStateQuantization).
+  if (_quantizeState) {
+    _heldQuantState.clear();
+    for (const std::pair<int64_t, int64_t> &pair : _statePairs)
+      _heldQuantState.emplace_back(quantizeStateTensor(
+          omTensorListGetOmtByIndex(results, pair.second)));
+    errno = 0; // No errors.
+    return results;
+  }
+
+  // The previous outputs seeded this step and the new state supersedes them;
+  // release them and hold the fresh outputs for the next step.
+  if (_heldStateOutputs)
+    omTensorListDestroy(_heldStateOutputs);
+  _heldStateOutputs = results;
+  errno = 0; // No errors.
+  return results;
+}
+
 const std::string ExecutionSession::inputSignature() const {
   if (!_entryPointFunc)
     throw std::runtime_error(reportUndefinedEntryPointIn("signature"));
@@ -148,6 +1330,26 @@ const std::string ExecutionSession::outputSignature() const {
 }
 
 ExecutionSession::~ExecutionSession() {
+  // Drain and join the asynchronous workers before unloading the library so
+  // that queued callbacks still run against valid code.
+  {
+    const std::lock_guard<std::mutex> lock(_asyncMutex);
+    _asyncShutdown = true;
+    _asyncCond.notify_all();
+  }
+  for (std::thread &worker : _asyncWorkers)
+    worker.join();
+  // Likewise flush and join the micro-batcher: requests still held open for
+  // their deadline go out as final batches before the library disappears.
+  {
+    const std::lock_guard<std::mutex> lock(_batchMutex);
+    _batchShutdown = true;
+    _batchCond.notify_all();
+  }
+  if (_microBatcher.joinable())
+    _microBatcher.join();
+  if (_heldStateOutputs)
+    omTensorListDestroy(_heldStateOutputs);
   if (_sharedLibraryHandle.isValid())
     llvm::sys::DynamicLibrary::closeLibrary(_sharedLibraryHandle);
 }
@@ -177,6 +1379,58 @@ std::string ExecutionSession::reportUndefinedEntryPointIn(
   return errStr.str();
 }
 
+std::string ExecutionSession::reportBatchingError(
+    const std::string &why) const {
+  errno = EINVAL; // Invalid argument.
+  std::stringstream errStr;
+  errStr << "Cannot coalesce requests into a batch: " << why << "."
+         << std::endl;
+  return errStr.str();
+}
+
+std::string ExecutionSession::reportStreamingError(
+    const std::string &why) const {
+  errno = EINVAL; // Invalid argument.
+  std::stringstream errStr;
+  errStr << "Cannot stream the request chunk by chunk: " << why << "."
+         << std::endl;
+  return errStr.str();
+}
+
+std::string ExecutionSession::reportOutputBufferError(
+    const std::string &why) const {
+  errno = EINVAL; // Invalid argument.
+  std::stringstream errStr;
+  errStr << "Cannot place results into pre-registered output buffers: " << why
+         << "." << std::endl;
+  return errStr.str();
+}
+
+std::string ExecutionSession::reportRuntimeOptionError(
+    const std::string &key) const {
+  errno = EINVAL; // Invalid argument.
+  std::stringstream errStr;
+  errStr << "Cannot set runtime option '" << key
+         << "': unknown key or invalid value." << std::endl;
+  return errStr.str();
+}
+
+std::string ExecutionSession::reportWarmupError(const std::string &why) const {
+  errno = EINVAL; // Invalid argument.
+  std::stringstream errStr;
+  errStr << "Cannot build warmup inputs from the input signature: " << why
+         << "." << std::endl;
+  return errStr.str();
+}
+
+std::string ExecutionSession::reportStateError(const std::string &why) const {
+  errno = EINVAL; // Invalid argument.
+  std::stringstream errStr;
+  errStr << "Cannot run with session-persistent state: " << why << "."
+         << std::endl;
+  return errStr.str();
+}
+
 std::string ExecutionSession::reportErrnoError() const {
   std::string errMessageStr = std::string(strerror(errno));
   std::stringstream errStr;
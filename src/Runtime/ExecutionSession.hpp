@@ -15,9 +15,19 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "OnnxMlirRuntime.h"
 #include "llvm/Support/DynamicLibrary.h"
@@ -41,6 +51,16 @@ using OMTensorUniquePtr = std::unique_ptr<OMTensor, decltype(&omTensorDestroy)>;
  * function.
  * EPERM when the model executed on a machine without a compatible
  * hardware/specialized accelerator.
+ *
+ * Thread safety: the compiled entry point functions are reentrant, so once a
+ * session is constructed and its entry point is set, any number of threads may
+ * call run()/runConcurrent() on the same session simultaneously. Each call
+ * operates exclusively on per-call state (its own input and output tensor
+ * lists). setEntryPoint() mutates shared session state and must therefore not
+ * race with in-flight run() calls; runConcurrent(entryPointName, input) avoids
+ * this restriction by resolving the entry point locally for the duration of
+ * the call, allowing threads to drive different entry points of the same
+ * loaded library concurrently.
  */
 class ExecutionSession {
 public:
@@ -70,6 +90,342 @@ public:
   // tensor lists.
   OMTensorList *run(OMTensorList *input);
 
+  // Pre-register caller-owned output buffers for this session. Subsequent
+  // runInto(input) calls place their results into these buffers instead of
+  // handing back freshly allocated tensors, so a service can allocate its
+  // response buffers once and reuse them for every inference. The session
+  // does not take ownership; the caller keeps the list alive and frees it
+  // after the session is done with it. Pass nullptr to deregister.
+  void setOutputBuffers(OMTensorList *outputs);
+
+  // Run using the output buffers registered with setOutputBuffers(). The
+  // returned list is the registered list itself; nothing is allocated on
+  // behalf of the caller and nothing needs to be freed per call.
+  OMTensorList *runInto(OMTensorList *input);
+
+  // Run and place results directly into the given pre-allocated output
+  // buffers, returning that same list. Each output tensor must match the
+  // corresponding result in element type and rank and its buffer must be
+  // large enough to hold the result; its shape is updated in place to the
+  // result's shape, so for models with dynamic output dimensions the buffers
+  // should be sized for the largest expected shape. Because all per-call
+  // state is provided by the caller, concurrent calls with distinct output
+  // lists are safe.
+  OMTensorList *runInto(OMTensorList *input, OMTensorList *outputs);
+
+  // Thread-safe run using the entry point currently set for this session.
+  // Unlike run(), this call never updates errno (a process-global) on success,
+  // making it safe to invoke from many threads at once.
+  OMTensorList *runConcurrent(OMTensorList *input);
+
+  // Run a batch of requests through a single entry point invocation.
+  // All requests must agree in tensor count, element types, and shapes except
+  // for the leading dimension; their inputs are coalesced along that leading
+  // dimension, the entry point is invoked once on the coalesced batch, and the
+  // outputs are scattered back into one OMTensorList per request, split along
+  // the leading dimension proportionally to each request's contribution. This
+  // assumes the model maps sample i of its inputs to sample i of its outputs,
+  // which holds for the leading (batch) dynamic dimension of typical models.
+  // Results are freshly allocated; callers free them with omTensorListDestroy.
+  std::vector<OMTensorList *> runBatch(
+      const std::vector<OMTensorList *> &inputs);
+
+  // Callback invoked for each processed chunk of a streaming run, with the
+  // chunk's index and its freshly allocated outputs. The callback owns the
+  // list and frees it with omTensorListDestroy; freeing it before returning
+  // keeps the streaming run's memory bounded.
+  using runStreamCallbackType =
+      std::function<void(int64_t chunkIndex, OMTensorList *chunkOutput)>;
+
+  // Process an arbitrarily long input with bounded memory by slicing every
+  // input tensor along a caller-declared streamable dimension and invoking
+  // the model chunk by chunk. All inputs must carry the streamed dimension
+  // at streamAxis with the same extent; each invocation sees a slice of at
+  // most chunkSize along it (the final chunk may be shorter), so the model
+  // must have been compiled with that dimension dynamic. Scratch memory is
+  // bounded by one chunk's inputs and outputs instead of the full-length
+  // intermediates. Streamability is the caller's declaration: results match
+  // a full-length run only if the model maps slice i of its inputs to slice
+  // i of its outputs along that dimension, which holds for per-frame audio
+  // frontends and other graphs without cross-chunk receptive fields
+  // (full-length attention or non-causal convolution along the streamed
+  // dimension will not match).
+  void runStream(OMTensorList *input, int64_t streamAxis, int64_t chunkSize,
+      runStreamCallbackType callback);
+
+  // Convenience overload that concatenates the chunk outputs along the
+  // streamed dimension and returns a single freshly allocated list; memory
+  // then grows with the full output, like run(), but the intermediates still
+  // stay chunk-sized. The caller frees the list with omTensorListDestroy.
+  OMTensorList *runStream(
+      OMTensorList *input, int64_t streamAxis, int64_t chunkSize);
+
+  // Thread-safe run through an explicitly named entry point. The entry point
+  // is resolved into per-call state, so concurrent callers may use different
+  // entry points of the same loaded library without synchronization and
+  // without disturbing the session-wide entry point set by setEntryPoint().
+  OMTensorList *runConcurrent(
+      const std::string &entryPointName, OMTensorList *input);
+
+  // Callback invoked when an asynchronous run completes. It receives the
+  // freshly allocated results, or nullptr when the run failed (errno then
+  // carries the error, as for run()).
+  using runAsyncCallbackType = std::function<void(OMTensorList *)>;
+
+  // Submit an inference without blocking the calling thread. The entry point
+  // currently set for the session is captured at submission time and invoked
+  // on an internal worker pool; the callback runs on a worker thread once the
+  // inference completes, so an event-loop-based caller can pipeline pre- and
+  // post-processing with model execution instead of parking a thread per
+  // in-flight request. Requests are executed in submission order per worker.
+  // Workers are started lazily on the first call and joined in the
+  // destructor after the queue is drained; as with run(), the caller owns
+  // the input list and the result list handed to the callback.
+  void runAsync(OMTensorList *input, runAsyncCallbackType callback);
+
+  // Configure the micro-batching scheduler behind runMicroBatched(). A held
+  // batch is dispatched as soon as maxBatchSize requests are pending or the
+  // oldest pending request has waited maxDelayMicroseconds, whichever comes
+  // first: the size bound caps the latency cost of batching under load, the
+  // deadline caps it when traffic is sparse. The defaults (8 requests, 2000
+  // microseconds) suit typical per-sample service traffic; changes apply to
+  // batches formed after the call, including one already being held open.
+  void setMicroBatchPolicy(int64_t maxBatchSize, int64_t maxDelayMicroseconds);
+
+  // Submit a single request to the in-session micro-batching scheduler.
+  // Pending requests are coalesced into one entry point invocation through
+  // runBatch() under the policy set with setMicroBatchPolicy(), so a service
+  // whose callers send one sample at a time still gets batched execution
+  // without a serving layer in front of the session. The callback receives
+  // the request's own scattered results (or nullptr on failure, with errno
+  // carrying the error) on the scheduler thread, in arrival order within a
+  // batch. Requests must be batch-compatible in the runBatch() sense; as with
+  // runAsync(), the caller owns the input list and the result list handed to
+  // the callback. The scheduler thread is started lazily on the first call
+  // and joined in the destructor after pending requests are flushed.
+  void runMicroBatched(OMTensorList *input, runAsyncCallbackType callback);
+
+  // Run through the shape-specialized version of the model that matches the
+  // actual input shapes. Models compiled with --specialized-shapes contain,
+  // next to the generic entry point, clones specialized for declared hot
+  // shapes (entry points <name>_s0, <name>_s1, ...). This call picks the
+  // first specialized version whose static input dimensions all match the
+  // given inputs and falls back to the session's entry point when none
+  // matches. The specialized entry points are enumerated once on first use;
+  // after that, dispatch only reads per-call state and is safe to invoke
+  // from many threads at once.
+  OMTensorList *runDispatch(OMTensorList *input);
+
+  // Warm the session up so that the first real request already runs at
+  // steady-state latency. Resolves every entry point ahead of time (avoiding
+  // lazy symbol binding on the first call), enumerates the shape-specialized
+  // clones used by runDispatch(), and, unless runDummyInference is false,
+  // runs one inference on zero-filled inputs built from the input signature
+  // (declared dynamic dimensions are taken as 1). The dummy inference faults
+  // in the weight pages its computation reads; when the model stores its
+  // constants in an external file, every remaining page of that file is
+  // additionally touched so later requests never wait on disk. Typical use
+  // is one warmup() call right after construction, before a service starts
+  // accepting traffic.
+  void warmup(bool runDummyInference = true);
+
+  // Take a snapshot of the runtime's small-tensor arena on the calling
+  // thread. A service that speculatively executes a model (or a prefix entry
+  // point) and may abandon the result calls arenaSnapshot() before the run
+  // and, on rollback, arenaRestore() with the returned token: between the
+  // two, the temporaries of run calls made by this thread are bump-allocated
+  // from the arena, so abandoning the execution reclaims all of them with a
+  // single O(1) watermark rewind instead of one free() per buffer. Restoring
+  // is equally correct when the speculation pays off, since model outputs
+  // are allocated outside the arena; either way each snapshot should be
+  // restored once the run is over. Snapshots nest and are per-thread:
+  // restore on the thread that took the snapshot, innermost token first.
+  // Effective for models compiled with -small-tensor-allocator; for other
+  // libraries (including ones predating the arena) snapshot returns 0 and
+  // restore does nothing.
+  int64_t arenaSnapshot();
+  void arenaRestore(int64_t watermark);
+
+  // Release the dead pages of the runtime's small-tensor arena on the
+  // calling thread back to the OS, so the process RSS tracks the current
+  // load instead of the worst burst ever seen. The arena keeps its virtual
+  // ranges and reuses the released pages transparently on later runs. Like
+  // the arena itself this is per thread: a service calls memoryTrim() from
+  // each serving thread it idles, typically from its own idle or drain
+  // handler; the memory_trim_period and memory_trim_idle_ms runtime options
+  // (see setRuntimeOption) cover the periodic and task-pool-worker cases
+  // without explicit calls. Returns the number of bytes whose pages were
+  // released; 0 for libraries predating the trimming API or platforms
+  // without a page-release primitive.
+  int64_t memoryTrim();
+
+  // Set the scheduling priority of the calling thread for the runtime task
+  // pool linked into this session's model. When two models share a process,
+  // the threads serving the latency-critical one call setPriority with a
+  // value > 0: the pool workers then prefer its tasks over ordinary work,
+  // and a co-located model compiled with --cooperative-yield hands over its
+  // core at the next loop chunk boundary instead of running to completion
+  // first. The priority is per thread, so a service calls this once on each
+  // of its serving threads; 0 restores ordinary scheduling. A no-op for
+  // libraries built before the task pool had priorities.
+  void setPriority(int64_t priority);
+
+  // Override a runtime knob of the model linked into this session, without
+  // restarting the process. The keys mirror the environment variables the
+  // runtime otherwise reads (see OMRuntimeOption.h for the full list):
+  // "parallel_task_threads", "parallel_pin_threads", "parallel_schedule",
+  // "constant_path", "constant_numa_policy", "constant_verify", the
+  // instrument toggles "instrument", "instrument_time", "instrument_memory",
+  // and the arena trim policies "memory_trim_period", "memory_trim_idle_ms".
+  // Overrides take precedence over the environment from the moment they are
+  // set; knobs read at a lazy initialization point (pool size, constant
+  // directory) must be set before the first inference that touches them,
+  // while the schedule and the instrument toggles apply to the next
+  // inference. Throws for an unknown key or an invalid value; a no-op for
+  // libraries predating the runtime option API.
+  void setRuntimeOption(const std::string &key, const std::string &value);
+
+  // Replace the model served by this session with the library at
+  // sharedLibPath, in place. The new library is loaded and validated first
+  // and the swap happens atomically under the entry point lock: a request
+  // arriving before the swap runs the old model, one arriving after runs the
+  // new one, and a failed reload (unloadable library, missing entry point)
+  // throws and leaves the session serving the old model untouched. The
+  // session's entry point name is re-resolved in the new library and the
+  // cached shape-specialized and per-output clone enumerations are reset.
+  //
+  // When both versions were compiled with --store-constants-to-file and
+  // --shared-constants-dir, their weights live in per-constant files named by
+  // content hash and mapped read-only, so every weight segment unchanged
+  // between the versions resolves to the same file and the two models share
+  // one physical copy of it; the reload then only pages in the changed
+  // segments instead of a full second weight set. Follow with warmup() to
+  // absorb the page-in of those segments before real traffic hits them.
+  //
+  // Like setEntryPoint(), this mutates shared session state: the caller must
+  // ensure no run calls are in flight and the async queue is drained when
+  // reload() is invoked, since the old library is unloaded before returning.
+  void reload(const std::string &sharedLibPath);
+
+  // Declare a session-persistent state pair: the tensor the model returns as
+  // output outputIndex of one runStateful() call is fed back as input
+  // inputIndex of the next one, without leaving session memory. This is the
+  // natural fit for autoregressive decoding, where the past-key-value inputs
+  // of step t+1 are the present-key-value outputs of step t: bound as state,
+  // the cache tensors hop from output slot to input slot by pointer instead
+  // of being copied through the caller once per token. Each input may be
+  // bound at most once; bind all pairs before the first runStateful() call.
+  void bindState(int64_t inputIndex, int64_t outputIndex);
+
+  // Hold the bound state tensors between runStateful() calls as int8 copies,
+  // quantized symmetrically with one float scale per 64-element block,
+  // instead of keeping the full-precision output tensors alive. For an f32
+  // KV cache this shrinks the per-sequence state a session holds between
+  // steps close to 4x, which at long context lengths is what bounds how many
+  // sequences fit on a node. The state is re-materialized in full precision
+  // just before each step and released right after it, so the model library
+  // runs unchanged. The round trip is lossy (under 1% per element for
+  // attention caches, whose values a per-block scale tracks well), so leave
+  // this off for state whose exact bits matter; non-float state tensors are
+  // copied verbatim. Toggle only while no sequence is in flight, i.e. before
+  // the first runStateful() call or right after resetState().
+  //
+  // Ownership caveat: with quantization enabled the session keeps only the
+  // compact copies, so runStateful() transfers ownership of its returned
+  // output list to the caller, who destroys it once read.
+  void setStateQuantization(bool enable);
+
+  // Drop the held state tensors so that the next runStateful() call starts a
+  // fresh sequence from the caller-provided initial state.
+  void resetState();
+
+  // Run using the state pairs declared with bindState(). On the first call
+  // (and after resetState()) every input comes from the given list,
+  // including the initial state tensors. On subsequent calls the bound input
+  // slots are taken from the previous call's outputs and the corresponding
+  // entries of the given list are ignored, so the caller only refreshes the
+  // genuinely new inputs (e.g. the last generated token) between steps.
+  //
+  // The returned list is owned by the session, which keeps it alive until
+  // the next runStateful(), resetState(), reload(), or destruction: do not
+  // destroy it and do not read it past that point. (With state quantization
+  // enabled the session holds compact copies instead and the returned list
+  // belongs to the caller; see setStateQuantization().) Since the held
+  // state is per-session mutable data, concurrent runStateful() calls on one
+  // session are not supported; use separate sessions per sequence.
+  OMTensorList *runStateful(OMTensorList *input);
+
+  // A promise-like handle to one output of a lazy run; see runLazy(). The
+  // handle owns the tensor it materializes and destroys it when the handle
+  // itself is destroyed. Handles are movable but not copyable.
+  class LazyOutput {
+  public:
+    // Materialize and return the output tensor, computing it on the first
+    // call. Later calls return the cached tensor. The tensor remains owned
+    // by the handle.
+    OMTensor *get();
+
+    LazyOutput(LazyOutput &&other);
+    LazyOutput(const LazyOutput &) = delete;
+    LazyOutput &operator=(const LazyOutput &) = delete;
+    ~LazyOutput();
+
+  private:
+    friend class ExecutionSession;
+    LazyOutput(ExecutionSession *session, entryPointFuncType func,
+        OMTensorList *input, OMTensor *tensor);
+
+    ExecutionSession *_session;
+    // Entry point computing this output's backward slice; null once the
+    // tensor is materialized (or when it was materialized eagerly).
+    entryPointFuncType _func;
+    OMTensorList *_input;
+    OMTensor *_tensor;
+  };
+
+  // Run lazily: instead of computing every model output, return one
+  // promise-like handle per output whose value is only computed on the first
+  // get() call. Models compiled with --lazy-outputs contain, next to the
+  // main entry point, one pruned clone per output (entry points <name>_o0,
+  // <name>_o1, ...) holding only the backward slice of that output; get()
+  // invokes the clone, so outputs a request never reads cost nothing. When
+  // the model was compiled without --lazy-outputs (or has a single output),
+  // the full model runs eagerly and the handles come back already
+  // materialized. The caller keeps the input list alive until every handle
+  // it intends to read has been materialized, and may materialize different
+  // handles from different threads.
+  std::vector<LazyOutput> runLazy(OMTensorList *input);
+
+  // Return the session's run statistics: invocation counts and latencies
+  // maintained by the session itself, merged with the allocator counters
+  // maintained by the runtime linked into the model library (see
+  // OMRunStats.h for the fields). The counters are kept with relaxed atomic
+  // updates, so reading them is cheap and safe while runs are in flight;
+  // libraries predating the runtime-side API report zero for its fields.
+  OMRunStats getRunStats();
+
+  // Write the model runtime's per-allocation-site heap profile to a file
+  // (see omHeapProfileDump in OMRunStats.h for the format and the
+  // heap_profile option or OM_HEAP_PROFILE to enable the counters). An empty
+  // fileName writes to stderr. Returns false when the model library predates
+  // the API or the file cannot be opened.
+  bool heapProfileDump(const std::string &fileName);
+
+  // Count the distinct input-shape signatures of the runs while enabled.
+  // Recording is one map increment per run, cheap next to an inference but
+  // not free, so it is off by default.
+  void setShapeProfiling(bool enable);
+
+  // Write the recorded shape profile: one "<count> <spec>" line per
+  // distinct signature, most frequent first, where <spec> uses the
+  // shape-information syntax ("0:1x3x224x224,1:1x5"). Fed back to the
+  // compiler through --shape-profile, the dominant recorded shapes are
+  // compiled as speculative static-shape versions of the model, guarded by
+  // the runtime shape dispatch with the generic path as fallback (see
+  // runDispatch). An empty fileName writes to stderr. Returns false when
+  // the file cannot be opened.
+  bool shapeProfileDump(const std::string &fileName);
+
   // Get input and output signature as a Json string. For example for nminst:
   // `[ { "type" : "f32" , "dims" : [1 , 1 , 28 , 28] , "name" : "image" } ]`
   const std::string inputSignature() const;
@@ -85,15 +441,170 @@ protected:
   std::string reportUndefinedEntryPointIn(
       const std::string &functionName) const;
   std::string reportErrnoError() const;
+  std::string reportBatchingError(const std::string &why) const;
+  std::string reportStreamingError(const std::string &why) const;
+  std::string reportOutputBufferError(const std::string &why) const;
+  std::string reportWarmupError(const std::string &why) const;
+  std::string reportStateError(const std::string &why) const;
+  std::string reportRuntimeOptionError(const std::string &key) const;
+
+  // Build zero-filled input tensors from the input signature for the dummy
+  // inference of warmup(). The caller destroys the returned list.
+  OMTensorList *createWarmupInputs() const;
+
+  // Copy entry point results into the caller-provided buffers, validating
+  // element type, rank, and capacity. Does not free the results.
+  void copyResultsInto(OMTensorList *results, OMTensorList *outputs) const;
+
+  // Resolve an entry point name to its function pointer without mutating any
+  // session state. Used by the concurrent run paths.
+  entryPointFuncType resolveEntryPoint(const std::string &entryPointName);
+
+  // Invoke an already resolved entry point on the given inputs. Shared by the
+  // concurrent run paths; takes only per-call state.
+  OMTensorList *invokeEntryPoint(
+      entryPointFuncType entryPointFunc, OMTensorList *input) const;
+
+  // Append one run's input shapes to the shape profile.
+  void recordInputShapes(OMTensorList *input) const;
+
+  // A shape-specialized entry point: its resolved function and, per input,
+  // the declared dimensions (-1 for dynamic ones, which match any size).
+  struct SpecializedEntryPoint {
+    entryPointFuncType func;
+    std::vector<std::vector<int64_t>> inputDims;
+  };
+
+  // Enumerate the specialized entry points derived from the session's entry
+  // point on first use. Guarded by _entryPointMutex.
+  void initSpecializedEntryPoints();
+
+  // Enumerate the per-output entry points derived from the session's entry
+  // point on first use. Guarded by _entryPointMutex.
+  void initPerOutputEntryPoints();
+
+  // Return true when every input tensor matches the declared dimensions.
+  static bool matchesDeclaredShapes(
+      const SpecializedEntryPoint &entry, OMTensorList *input);
+
+  // A submitted asynchronous request: the entry point captured at submission
+  // time, the input list, and the completion callback.
+  struct AsyncRequest {
+    entryPointFuncType func;
+    OMTensorList *input;
+    runAsyncCallbackType callback;
+  };
+
+  // Account one completed entry point invocation of the given duration.
+  void recordRunTime(int64_t elapsedNs) const;
+
+  // Start the worker pool. Called with _asyncMutex held.
+  void initAsyncWorkers();
+
+  // Worker body: pop requests from _asyncQueue until shutdown and the queue
+  // is drained, invoking the entry point and then the callback for each.
+  void asyncWorkerLoop();
+
+  // A request pending in the micro-batch queue: the input list, the
+  // completion callback, and the deadline by which the request's batch must
+  // be dispatched.
+  struct MicroBatchRequest {
+    OMTensorList *input;
+    runAsyncCallbackType callback;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  // Start the batcher thread. Called with _batchMutex held.
+  void initMicroBatcher();
+
+  // Batcher body: hold pending requests until the batch fills up or the
+  // oldest request's deadline arrives, then dispatch the batch through
+  // runBatch() and hand each request its scattered results.
+  void microBatcherLoop();
 
 protected:
   // Handler to the shared library file being loaded.
   llvm::sys::DynamicLibrary _sharedLibraryHandle;
 
+  // Guards updates to the entry point members below so that setEntryPoint()
+  // may be called while runConcurrent() calls are in flight.
+  std::mutex _entryPointMutex;
+
   // Entry point function.
   std::string _entryPointName;
   entryPointFuncType _entryPointFunc = nullptr;
 
+  // Output buffers registered with setOutputBuffers(); caller owned.
+  OMTensorList *_outputBuffers = nullptr;
+
+  // State pairs declared with bindState() and, between runStateful() calls,
+  // the previous call's output list whose bound tensors seed the next call.
+  std::vector<std::pair<int64_t, int64_t>> _statePairs;
+  OMTensorList *_heldStateOutputs = nullptr;
+
+  // Compact held state used instead of _heldStateOutputs when state
+  // quantization is enabled: one entry per state pair, in _statePairs order.
+  // Float tensors are stored as int8 with one scale per block; other types
+  // keep their raw bytes in data with scales empty.
+  struct QuantizedState {
+    std::vector<int64_t> shape;
+    OM_DATA_TYPE dataType;
+    std::vector<int8_t> data;
+    std::vector<float> scales;
+  };
+  bool _quantizeState = false;
+  std::vector<QuantizedState> _heldQuantState;
+
+  // Compact one bound state tensor / re-materialize it in full precision for
+  // the next step. See setStateQuantization() for the encoding.
+  QuantizedState quantizeStateTensor(const OMTensor *omt) const;
+  OMTensor *dequantizeStateTensor(const QuantizedState &state) const;
+
+  // Shape-specialized entry points, enumerated on first runDispatch() call.
+  bool _specializedEntryPointsInitialized = false;
+  std::vector<SpecializedEntryPoint> _specializedEntryPoints;
+
+  // Per-output entry points, enumerated on first runLazy() call. Empty when
+  // the model was compiled without --lazy-outputs.
+  bool _perOutputEntryPointsInitialized = false;
+  std::vector<entryPointFuncType> _perOutputEntryPoints;
+
+  // Asynchronous execution state: pending requests and the worker threads
+  // consuming them. _asyncMutex guards the queue, the worker vector, and the
+  // shutdown flag.
+  std::mutex _asyncMutex;
+  std::condition_variable _asyncCond;
+  std::deque<AsyncRequest> _asyncQueue;
+  std::vector<std::thread> _asyncWorkers;
+  bool _asyncShutdown = false;
+
+  // Micro-batching state: the pending requests, the batcher thread forming
+  // batches out of them, and the dispatch policy. _batchMutex guards all of
+  // them.
+  std::mutex _batchMutex;
+  std::condition_variable _batchCond;
+  std::deque<MicroBatchRequest> _batchQueue;
+  std::thread _microBatcher;
+  bool _batchShutdown = false;
+  int64_t _maxBatchSize = 8;
+  int64_t _maxBatchDelayMicroseconds = 2000;
+
+  // Run statistics, updated with relaxed atomics so that the concurrent run
+  // paths (which are const) can account their invocations. Mutable for the
+  // same reason.
+  mutable std::atomic<int64_t> _numRuns{0};
+  mutable std::atomic<int64_t> _lastRunTimeNs{0};
+  mutable std::atomic<int64_t> _totalRunTimeNs{0};
+  mutable std::atomic<int64_t> _shapeDispatchHits{0};
+
+  // Shape profile: run counts per input-shape signature, collected while
+  // setShapeProfiling(true) is in effect. Guarded by its own mutex so that
+  // recording does not contend with the statistics atomics; mutable for the
+  // const concurrent run paths, like the statistics.
+  std::atomic<bool> _shapeProfiling{false};
+  mutable std::mutex _shapeProfileMutex;
+  mutable std::map<std::string, int64_t> _shapeProfileCounts;
+
   // Query entry point function.
   static const std::string _queryEntryPointsName;
   queryEntryPointsFuncType _queryEntryPointsFunc = nullptr;
@@ -0,0 +1,15 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===- OMExternalConstant.c - OMExternalConstant C Implementation ---------===//
+//
+// Copyright 2022 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file contains the C implementation of the external constant functions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "OMExternalConstant.inc"
@@ -21,6 +21,8 @@ SUPPRESS_WARNINGS_POP
 
 #include "PyExecutionSession.hpp"
 
+#include "OMTensorListHelper.hpp"
+
 namespace onnx_mlir {
 
 PyExecutionSession::PyExecutionSession(
@@ -137,7 +139,7 @@ std::vector<py::array> PyExecutionSession::pyRun(
       dtype = py::dtype("bool_");
       break;
     case (OM_DATA_TYPE)onnx::TensorProto::FLOAT16:
-      dtype = py::dtype("float32");
+      dtype = py::dtype("float16");
       break;
     case (OM_DATA_TYPE)onnx::TensorProto::DOUBLE:
       dtype = py::dtype("float64");
@@ -160,10 +162,18 @@ std::vector<py::array> PyExecutionSession::pyRun(
       exit(1);
     }
 
+    // Hand the output buffer to NumPy without copying: constructing the
+    // array with a base object makes it a view over the OMTensor data, and
+    // the capsule destroys the OMTensor (freeing the buffer iff the tensor
+    // owns it) when the last array referencing it is collected.
+    py::capsule base(
+        omt, [](void *tensor) { omTensorDestroy((OMTensor *)tensor); });
     outputPyArrays.emplace_back(
-        py::array(dtype, shape, omTensorGetDataPtr(omt)));
+        py::array(dtype, shape, omTensorGetDataPtr(omt), base));
   }
-  omTensorListDestroy(wrappedOutput);
+  // The output tensors now belong to their NumPy arrays; release the list
+  // shell only.
+  omTensorListDestroyShallow(wrappedOutput);
   omTensorListDestroy(wrappedInput);
 
   return outputPyArrays;
@@ -196,4 +206,19 @@ std::string PyExecutionSession::pyOutputSignature() {
   return outputSignature();
 }
 
+py::dict PyExecutionSession::pyGetRunStats() {
+  OMRunStats stats = getRunStats();
+  py::dict statsDict;
+  statsDict["num_runs"] = stats.numRuns;
+  statsDict["last_run_time_ns"] = stats.lastRunTimeNs;
+  statsDict["total_run_time_ns"] = stats.totalRunTimeNs;
+  statsDict["shape_dispatch_hits"] = stats.shapeDispatchHits;
+  statsDict["alloc_calls"] = stats.allocCalls;
+  statsDict["alloc_bytes"] = stats.allocBytes;
+  statsDict["pool_reserved_bytes"] = stats.poolReservedBytes;
+  statsDict["arena_high_water_bytes"] = stats.arenaHighWaterBytes;
+  statsDict["pool_trimmed_bytes"] = stats.poolTrimmedBytes;
+  return statsDict;
+}
+
 } // namespace onnx_mlir
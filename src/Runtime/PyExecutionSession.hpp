@@ -33,6 +33,7 @@ public:
   std::vector<py::array> pyRun(const std::vector<py::array> &inputsPyArray);
   std::string pyInputSignature();
   std::string pyOutputSignature();
+  py::dict pyGetRunStats();
 };
 } // namespace onnx_mlir
 
@@ -45,7 +46,23 @@ PYBIND11_MODULE(PyRuntime, m) {
       .def("set_entry_point", &onnx_mlir::PyExecutionSession::pySetEntryPoint,
           py::arg("name"))
       .def("run", &onnx_mlir::PyExecutionSession::pyRun, py::arg("input"))
+      .def("set_runtime_option",
+          &onnx_mlir::PyExecutionSession::setRuntimeOption, py::arg("key"),
+          py::arg("value"))
+      .def("warmup", &onnx_mlir::PyExecutionSession::warmup,
+          py::arg("run_dummy_inference") = true)
       .def("input_signature", &onnx_mlir::PyExecutionSession::pyInputSignature)
       .def("output_signature",
-          &onnx_mlir::PyExecutionSession::pyOutputSignature);
+          &onnx_mlir::PyExecutionSession::pyOutputSignature)
+      .def("run_stats", &onnx_mlir::PyExecutionSession::pyGetRunStats)
+      .def("memory_trim", &onnx_mlir::PyExecutionSession::memoryTrim)
+      .def("heap_profile_dump",
+          &onnx_mlir::PyExecutionSession::heapProfileDump,
+          py::arg("file_name") = std::string())
+      .def("set_shape_profiling",
+          &onnx_mlir::PyExecutionSession::setShapeProfiling,
+          py::arg("enable"))
+      .def("shape_profile_dump",
+          &onnx_mlir::PyExecutionSession::shapeProfileDump,
+          py::arg("file_name") = std::string());
 }
\ No newline at end of file
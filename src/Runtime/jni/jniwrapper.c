@@ -115,7 +115,11 @@ extern OMTensorList *run_main_graph(OMTensorList *);
     i, n, data, shape, strides, dataType, bufferSize, rank, owning)            \
   do {                                                                         \
     char tmp[1024];                                                            \
-    LOG_BUF(dataType, tmp, data, n);                                           \
+    /* data is NULL for an array-backed tensor not yet pinned */               \
+    if (data)                                                                  \
+      LOG_BUF(dataType, tmp, data, n);                                         \
+    else                                                                       \
+      strcpy(tmp, "<pinned later>");                                           \
     LOG_PRINTF(LOG_DEBUG, "omt[%d]:data=[%s]", i, tmp);                        \
     tmp[0] = '\0';                                                             \
     LOG_LONG_BUF(tmp, shape, rank);                                            \
@@ -148,6 +152,7 @@ typedef struct {
   jmethodID jomt_constructor;   /* OMTensor constructor           */
   jmethodID jomt_getData;       /* OMTensor getData method        */
   jmethodID jomt_setData;       /* OMTensor setData method        */
+  jmethodID jomt_getDataArray;  /* OMTensor getDataArray method   */
   jmethodID jomt_getShape;      /* OMTensor getShape method       */
   jmethodID jomt_setShape;      /* OMTensor setShape method       */
   jmethodID jomt_getStrides;    /* OMTensor getStrides method     */
@@ -200,6 +205,8 @@ const char *jnistr[] = {
     "getOmtArray",                     /* 27 FUNC_GET_OMT_ARRAY               */
     "JNI call error",                  /* 28 MSG_JNI_CALL_ERROR               */
     "native code error",               /* 29 MSG_NATIVE_CODE_ERROR            */
+    "()Ljava/lang/Object;",            /* 30 SIG_GET_DATA_ARRAY               */
+    "getDataArray",                    /* 31 FUNC_GET_DATA_ARRAY              */
 };
 #ifdef __MVS__
 #pragma convert(pop)
@@ -241,6 +248,8 @@ enum {
   FUNC_GET_OMT_ARRAY                = 27, /* getOmtArray                     */
   MSG_JNI_CALL_ERROR                = 28, /* JNI call error                  */
   MSG_NATIVE_CODE_ERROR             = 29, /* native code error               */
+  SIG_GET_DATA_ARRAY                = 30, /* ()Ljava/lang/Object;            */
+  FUNC_GET_DATA_ARRAY               = 31, /* getDataArray                    */
 };
 /* clang-format on */
 
@@ -285,6 +294,11 @@ jniapi_t *fill_jniapi(JNIEnv *env, jniapi_t *japi) {
           env, japi->jomt_cls, jnistr[FUNC_SET_DATA], jnistr[SIG_SET_DATA]),
       japi->jomt_setData != NULL, japi->jecpt_cls,
       "Method OMTensor.setData not found");
+  JNI_VAR_CALL(env, japi->jomt_getDataArray,
+      (*env)->GetMethodID(env, japi->jomt_cls, jnistr[FUNC_GET_DATA_ARRAY],
+          jnistr[SIG_GET_DATA_ARRAY]),
+      japi->jomt_getDataArray != NULL, japi->jecpt_cls,
+      "Method OMTensor.getDataArray not found");
   JNI_VAR_CALL(env, japi->jomt_getShape,
       (*env)->GetMethodID(
           env, japi->jomt_cls, jnistr[FUNC_GET_SHAPE], jnistr[SIG_GET_SHAPE]),
@@ -346,6 +360,25 @@ jniapi_t *fill_jniapi(JNIEnv *env, jniapi_t *japi) {
   return japi;
 }
 
+/* Release the Java primitive arrays pinned in place for the native call.
+ * The input buffers are read-only for the model so JNI_ABORT is used: no
+ * write-back, and no copy on JVMs that could not pin. Entries are cleared
+ * so the release is idempotent.
+ */
+void omtl_release_pinned(
+    JNIEnv *env, jarray *jobj_pinned, OMTensor **jni_omts, int64_t n) {
+  if (jobj_pinned == NULL)
+    return;
+  for (int64_t i = 0; i < n; i++) {
+    if (jobj_pinned[i] == NULL)
+      continue;
+    (*env)->ReleasePrimitiveArrayCritical(
+        env, jobj_pinned[i], omTensorGetDataPtr(jni_omts[i]), JNI_ABORT);
+    LOG_PRINTF(LOG_DEBUG, "omt[%ld]:array %p unpinned", i, jobj_pinned[i]);
+    jobj_pinned[i] = NULL;
+  }
+}
+
 /* Convert Java object to native data structure
  *
  *          +---------------------------+
@@ -379,8 +412,8 @@ jniapi_t *fill_jniapi(JNIEnv *env, jniapi_t *japi) {
  *        | omTensorList                | (constructed by jniwrapper)
  *        +-----------------------------+
  */
-OMTensorList *omtl_java_to_native(
-    JNIEnv *env, jclass cls, jobject java_omtl, jniapi_t *japi) {
+OMTensorList *omtl_java_to_native(JNIEnv *env, jclass cls, jobject java_omtl,
+    jniapi_t *japi, jarray **jobj_pinned_out) {
 
   /* Get OMTensor array Java object in OMTensorList */
   JNI_TYPE_VAR_CALL(env, jobjectArray, jomtl_omts,
@@ -410,6 +443,16 @@ OMTensorList *omtl_java_to_native(
       malloc(jomtl_omtn * sizeof(OMTensor *)), jni_omts != NULL, env,
       japi->jecpt_cls, "jni_omts=%p", jni_omts);
 
+  /* jobj_pinned are the Java primitive arrays backing the OMTensors that
+   * were constructed from one, pinned in place with
+   * GetPrimitiveArrayCritical so the model reads the Java heap memory
+   * directly instead of a copy. Returned to the caller, who releases
+   * them right after run_main_graph returns.
+   */
+  LIB_TYPE_VAR_CALL(jarray *, jobj_pinned,
+      calloc(jomtl_omtn, sizeof(jarray)), jobj_pinned != NULL, env,
+      japi->jecpt_cls, "jobj_pinned=%p", jobj_pinned);
+
   /* Loop through all the jomtl_omts  */
   for (int i = 0; i < jomtl_omtn; i++) {
     JNI_VAR_CALL(env, jobj_omts[i],
@@ -417,11 +460,15 @@ OMTensorList *omtl_java_to_native(
         japi->jecpt_cls, "jobj_omts[%d]=%p", i, jobj_omts[i]);
 
     /* Get data, shape, strides, dataType, rank, and bufferSize by calling
-     * corresponding methods
+     * corresponding methods.
+     *
+     * First ask for the primitive array backing the data. A null return
+     * (with no exception) means the tensor was constructed from a direct
+     * byte buffer instead and getData is used as before.
      */
-    JNI_TYPE_VAR_CALL(env, jobject, jomt_data,
-        (*env)->CallObjectMethod(env, jobj_omts[i], japi->jomt_getData),
-        jomt_data != NULL, japi->jecpt_cls, "omt[%d]:data=%p", i, jomt_data);
+    JNI_TYPE_VAR_CALL(env, jobject, jomt_dataArray,
+        (*env)->CallObjectMethod(env, jobj_omts[i], japi->jomt_getDataArray),
+        1, japi->jecpt_cls, "omt[%d]:dataArray=%p", i, jomt_dataArray);
     JNI_TYPE_VAR_CALL(env, jobject, jomt_shape,
         (*env)->CallObjectMethod(env, jobj_omts[i], japi->jomt_getShape),
         jomt_shape != NULL, japi->jecpt_cls, "omt[%d]:shape=%p", i, jomt_shape);
@@ -445,10 +492,21 @@ OMTensorList *omtl_java_to_native(
         jomt_numElems >= 0, japi->jecpt_cls, "omt[%d]:numElems=%ld", i,
         jomt_numElems);
 
-    /* Get direct buffer associated with data */
-    JNI_TYPE_VAR_CALL(env, void *, jni_data,
-        (*env)->GetDirectBufferAddress(env, jomt_data), jni_data != NULL,
-        japi->jecpt_cls, "omt[%d]:jni_data=%p", i, jni_data);
+    /* Get direct buffer associated with data. In the array-backed case
+     * just remember the array: it is pinned after this loop, once no
+     * more JNI calls need to be made, and the data pointer is filled in
+     * then. */
+    void *jni_data = NULL;
+    if (jomt_dataArray != NULL) {
+      jobj_pinned[i] = (jarray)jomt_dataArray;
+    } else {
+      JNI_TYPE_VAR_CALL(env, jobject, jomt_data,
+          (*env)->CallObjectMethod(env, jobj_omts[i], japi->jomt_getData),
+          jomt_data != NULL, japi->jecpt_cls, "omt[%d]:data=%p", i, jomt_data);
+      JNI_VAR_CALL(env, jni_data,
+          (*env)->GetDirectBufferAddress(env, jomt_data), jni_data != NULL,
+          japi->jecpt_cls, "omt[%d]:jni_data=%p", i, jni_data);
+    }
 
     /* Get long array associated with data shape and strides */
     JNI_TYPE_VAR_CALL(env, jlong *, jni_shape,
@@ -496,6 +554,35 @@ OMTensorList *omtl_java_to_native(
    */
   free(jobj_omts);
 
+  /* Pin the backing primitive arrays in place and point the native
+   * OMTensors at them. Critical regions may nest, but no other JNI call
+   * is allowed until they are released, so pinning is done only now that
+   * all JNI introspection is finished, and undone right after
+   * run_main_graph returns, before any Java object is constructed for
+   * the outputs. The OMTensors keep owning=false so omTensorListDestroy
+   * never frees the pinned buffers; their lifetime belongs to the Java
+   * arrays.
+   */
+  for (int i = 0; i < jomtl_omtn; i++) {
+    if (jobj_pinned[i] == NULL)
+      continue;
+    void *jni_data =
+        (*env)->GetPrimitiveArrayCritical(env, jobj_pinned[i], NULL);
+    if (jni_data == NULL) {
+      LOG_PRINTF(LOG_ERROR, "omt[%d]:pin failed", i);
+      jobj_pinned[i] = NULL;
+      omtl_release_pinned(env, jobj_pinned, jni_omts, jomtl_omtn);
+      free(jobj_pinned);
+      if (!(*env)->ExceptionCheck(env))
+        (*env)->ThrowNew(env, japi->jecpt_cls, jnistr[MSG_JNI_CALL_ERROR]);
+      return NULL;
+    }
+    LOG_PRINTF(LOG_DEBUG, "omt[%d]:array %p pinned at %p", i,
+        jobj_pinned[i], jni_data);
+    omTensorSetDataPtr(jni_omts[i], (int64_t)0, jni_data, jni_data);
+  }
+  *jobj_pinned_out = jobj_pinned;
+
   /* Create OMTensorList to be constructed and passed to the model
    * shared library. Note that we do own the pointers to the native
    * OMTensor structs, jni_omts.
@@ -686,13 +773,29 @@ JNIEXPORT jobject JNICALL Java_com_ibm_onnxmlir_OMModel_main_1graph_1jni(
       "japi=%p", japi);
 
   /* Convert Java object to native data structure */
+  jarray *jobj_pinned = NULL;
   CHECK_CALL(OMTensorList *, jni_iomtl,
-      omtl_java_to_native(env, cls, java_iomtl, japi), jni_iomtl != NULL,
-      "jni_iomtl=%p", jni_iomtl);
+      omtl_java_to_native(env, cls, java_iomtl, japi, &jobj_pinned),
+      jni_iomtl != NULL, "jni_iomtl=%p", jni_iomtl);
+
+  /* Call model inference entry point. The input arrays pinned by
+   * omtl_java_to_native stay pinned for the duration of the call; no JNI
+   * call may be made until they are released just below.
+   */
+  OMTensorList *jni_oomtl = run_main_graph(jni_iomtl);
+
+  /* The model is done with the inputs; unpin the Java arrays backing
+   * them before making any further JNI call.
+   */
+  omtl_release_pinned(env, jobj_pinned, omTensorListGetOmtArray(jni_iomtl),
+      omTensorListGetSize(jni_iomtl));
+  free(jobj_pinned);
 
-  /* Call model inference entry point */
-  CHECK_CALL(OMTensorList *, jni_oomtl, run_main_graph(jni_iomtl),
-      jni_oomtl != NULL, "jni_oomtl=%p", jni_oomtl);
+  if (jni_oomtl == NULL) {
+    LOG_PRINTF(LOG_ERROR, "jni_oomtl=%p", jni_oomtl);
+    omTensorListDestroy(jni_iomtl);
+    return NULL;
+  }
 
   /* Convert native data structure to Java object */
   CHECK_CALL(jobject, java_oomtl,
@@ -84,6 +84,15 @@ public class OMTensor {
     private final ByteOrder nativeEndian = ByteOrder.nativeOrder();
 
     private ByteBuffer _data;
+    /* Primitive array backing the tensor when constructed from one. The
+     * array is kept as is, without copying it into a direct byte buffer:
+     * the JNI wrapper pins it in place with GetPrimitiveArrayCritical for
+     * the duration of the native call. _data stays null until a direct
+     * byte buffer is actually asked for (getData), which only happens on
+     * JVMs where pinning is not available.
+     */
+    private Object _dataArray;
+    private long _dataArraySize;
     private long[] _shape;
     private long[] _strides;
     private int _dataType;
@@ -200,7 +209,8 @@ public class OMTensor {
 	if (_dataType != ONNX_TYPE_BOOL)
 	    throw new NumberFormatException("Data type is " +
 					    ONNX_TYPE_NAME[_dataType]);
-	if (_data == null) return null;
+	if (_data == null)
+	    return _dataArray == null ? null : ((byte[])_dataArray).clone();
 
         /* asReadOnlyBuffer() creates a new view so the position of the
          * original data will stay at 0 for subsequent getByteData()
@@ -217,11 +227,14 @@ public class OMTensor {
      * @param data bool array to be set
      */
     public void setBoolData(byte[] data) {
-        /* slice() creates a new view so the position of the
-         * original data will stay at 0 for getByteData() after put(data).
+        /* Keep a reference to the array instead of copying it into a
+         * direct byte buffer; the JNI wrapper pins the array in place
+         * for the duration of the native call. The array must not be
+         * modified while an inference using it is running.
          */
-        _data = ByteBuffer.allocateDirect(data.length);
-        _data.slice().put(data);
+        _data = null;
+        _dataArray = data;
+        _dataArraySize = data.length;
         _dataType = ONNX_TYPE_INT8;
     }
 
@@ -236,7 +249,8 @@ public class OMTensor {
 	if (_dataType != ONNX_TYPE_INT8 && _dataType != ONNX_TYPE_UINT8)
 	    throw new NumberFormatException("Data type is " +
 					    ONNX_TYPE_NAME[_dataType]);
-	if (_data == null) return null;
+	if (_data == null)
+	    return _dataArray == null ? null : ((byte[])_dataArray).clone();
 
         /* asReadOnlyBuffer() creates a new view so the position of the
          * original data will stay at 0 for subsequent getByteData()
@@ -253,11 +267,14 @@ public class OMTensor {
      * @param data byte array to be set
      */
     public void setByteData(byte[] data) {
-        /* slice() creates a new view so the position of the
-         * original data will stay at 0 for getByteData() after put(data).
+        /* Keep a reference to the array instead of copying it into a
+         * direct byte buffer; the JNI wrapper pins the array in place
+         * for the duration of the native call. The array must not be
+         * modified while an inference using it is running.
          */
-        _data = ByteBuffer.allocateDirect(data.length);
-        _data.slice().put(data);
+        _data = null;
+        _dataArray = data;
+        _dataArraySize = data.length;
         _dataType = ONNX_TYPE_INT8;
     }
 
@@ -272,7 +289,8 @@ public class OMTensor {
 	if (_dataType != ONNX_TYPE_INT16 && _dataType != ONNX_TYPE_UINT16)
 	    throw new NumberFormatException("Data type is " +
 					    ONNX_TYPE_NAME[_dataType]);
-        if (_data == null) return null;
+        if (_data == null)
+            return _dataArray == null ? null : ((short[])_dataArray).clone();
 
         /* asShortBuffer() creates a new view so the position of the
          * original data will stay at 0 for subsequent getShortData()
@@ -290,11 +308,14 @@ public class OMTensor {
      * @param data short array to be set
      */
     public void setShortData(short[] data) {
-        /* asShortBuffer() creates a new view so the position of the
-         * original data will stay at 0 for getShortData() after put(data).
+        /* Keep a reference to the array instead of copying it into a
+         * direct byte buffer; the JNI wrapper pins the array in place
+         * for the duration of the native call. The array must not be
+         * modified while an inference using it is running.
          */
-        _data = ByteBuffer.allocateDirect(data.length*2).order(nativeEndian);
-        _data.asShortBuffer().put(data);
+        _data = null;
+        _dataArray = data;
+        _dataArraySize = (long)data.length*2;
         _dataType = ONNX_TYPE_INT16;
     }
 
@@ -309,7 +330,8 @@ public class OMTensor {
 	if (_dataType != ONNX_TYPE_INT32 && _dataType != ONNX_TYPE_UINT32)
 	    throw new NumberFormatException("Data type is " +
 					    ONNX_TYPE_NAME[_dataType]);
-        if (_data == null) return null;
+        if (_data == null)
+            return _dataArray == null ? null : ((int[])_dataArray).clone();
 
         /* asIntBuffer() creates a new view so the position of the
          * original data will stay at 0 for subsequent getIntData()
@@ -327,11 +349,14 @@ public class OMTensor {
      * @param data int array to be set
      */
     public void setIntData(int[] data) {
-        /* asIntBuffer() creates a new view so the position of the
-         * original data will stay at 0 for getIntData() after put(data).
+        /* Keep a reference to the array instead of copying it into a
+         * direct byte buffer; the JNI wrapper pins the array in place
+         * for the duration of the native call. The array must not be
+         * modified while an inference using it is running.
          */
-        _data = ByteBuffer.allocateDirect(data.length*4).order(nativeEndian);
-        _data.asIntBuffer().put(data);
+        _data = null;
+        _dataArray = data;
+        _dataArraySize = (long)data.length*4;
         _dataType = ONNX_TYPE_INT32;
     }
 
@@ -346,7 +371,8 @@ public class OMTensor {
 	if (_dataType != ONNX_TYPE_INT64 && _dataType != ONNX_TYPE_UINT64)
 	    throw new NumberFormatException("Data type is " +
 					    ONNX_TYPE_NAME[_dataType]);
-        if (_data == null) return null;
+        if (_data == null)
+            return _dataArray == null ? null : ((long[])_dataArray).clone();
 
         /* asLongBuffer() creates a new view so the position of the
          * original data will stay at 0 for subsequent getLongData()
@@ -364,11 +390,14 @@ public class OMTensor {
      * @param data long array to be set
      */
     public void setLongData(long[] data) {
-        /* asLongBuffer() creates a new view so the position of the
-         * original data will stay at 0 for getLongData() after put(data).
+        /* Keep a reference to the array instead of copying it into a
+         * direct byte buffer; the JNI wrapper pins the array in place
+         * for the duration of the native call. The array must not be
+         * modified while an inference using it is running.
          */
-        _data = ByteBuffer.allocateDirect(data.length*8).order(nativeEndian);
-        _data.asLongBuffer().put(data);
+        _data = null;
+        _dataArray = data;
+        _dataArraySize = (long)data.length*8;
         _dataType = ONNX_TYPE_INT64;
     }
 
@@ -383,7 +412,8 @@ public class OMTensor {
 	if (_dataType != ONNX_TYPE_FLOAT)
 	    throw new NumberFormatException("Data type is " +
 					    ONNX_TYPE_NAME[_dataType]);
-        if (_data == null) return null;
+        if (_data == null)
+            return _dataArray == null ? null : ((float[])_dataArray).clone();
 
         /* asFloatBuffer() creates a new view so the position of the
          * original data will stay at 0 for subsequent getFloatData()
@@ -401,11 +431,14 @@ public class OMTensor {
      * @param data float array to be set
      */
     public void setFloatData(float[] data) {
-        /* asFloatBuffer() creates a new view so the position of the
-         * original data will stay at 0 for getFloatData() after put(data).
+        /* Keep a reference to the array instead of copying it into a
+         * direct byte buffer; the JNI wrapper pins the array in place
+         * for the duration of the native call. The array must not be
+         * modified while an inference using it is running.
          */
-        _data = ByteBuffer.allocateDirect(data.length*4).order(nativeEndian);
-        _data.asFloatBuffer().put(data);
+        _data = null;
+        _dataArray = data;
+        _dataArraySize = (long)data.length*4;
         _dataType = ONNX_TYPE_FLOAT;
     }
 
@@ -420,7 +453,8 @@ public class OMTensor {
 	if (_dataType != ONNX_TYPE_DOUBLE)
 	    throw new NumberFormatException("Data type is " +
 					    ONNX_TYPE_NAME[_dataType]);
-        if (_data == null) return null;
+        if (_data == null)
+            return _dataArray == null ? null : ((double[])_dataArray).clone();
 
         /* asDoubleBuffer() creates a new view so the position of the
          * original data will stay at 0 for subsequent getDoubleData()
@@ -438,11 +472,14 @@ public class OMTensor {
      * @param data double array to be set
      */
     public void setDoubleData(double[] data) {
-        /* asDoubleBuffer() creates a new view so the position of the
-         * original data will stay at 0 for getDoubleData() after put(data).
+        /* Keep a reference to the array instead of copying it into a
+         * direct byte buffer; the JNI wrapper pins the array in place
+         * for the duration of the native call. The array must not be
+         * modified while an inference using it is running.
          */
-        _data = ByteBuffer.allocateDirect(data.length*8).order(nativeEndian);
-        _data.asDoubleBuffer().put(data);
+        _data = null;
+        _dataArray = data;
+        _dataArraySize = (long)data.length*8;
         _dataType = ONNX_TYPE_DOUBLE;
     }
 
@@ -523,7 +560,8 @@ public class OMTensor {
      * @return total size of the data buffer in bytes
      */
     public long getBufferSize() {
-        return _data == null ? 0 : _data.limit();
+        if (_data != null) return _data.limit();
+        return _dataArray == null ? 0 : _dataArraySize;
     }
 
     /* ---------- Rank getter ---------- */
@@ -615,9 +653,17 @@ public class OMTensor {
     /**
      * Raw data getter (For JNI wrapper only. Not intended for end user)
      *
+     * The JNI wrapper only calls this when getDataArray returns null,
+     * i.e., the tensor was constructed from a direct byte buffer. When a
+     * backing primitive array exists but cannot be pinned, a direct byte
+     * buffer is materialized from it here, which is the copy the pinned
+     * path avoids.
+     *
      * @return raw data
      */
     protected ByteBuffer getData() {
+        if (_data == null && _dataArray != null)
+            materializeData();
         return _data;
     }
 
@@ -628,5 +674,48 @@ public class OMTensor {
      */
     protected void setData(ByteBuffer data) {
         _data = data.order(nativeEndian);
+        _dataArray = null;
+    }
+
+    /**
+     * Backing primitive array getter (For JNI wrapper only. Not intended
+     * for end user)
+     *
+     * @return primitive array backing the tensor, or null if the tensor
+     *         is backed by a direct byte buffer
+     */
+    protected Object getDataArray() {
+        return _dataArray;
+    }
+
+    /* Copy the backing primitive array into a direct byte buffer, for the
+     * paths that need one (non-pinning JVMs).
+     */
+    private void materializeData() {
+        if (_dataArray instanceof byte[]) {
+            byte[] d = (byte[])_dataArray;
+            _data = ByteBuffer.allocateDirect(d.length);
+            _data.slice().put(d);
+        } else if (_dataArray instanceof short[]) {
+            short[] d = (short[])_dataArray;
+            _data = ByteBuffer.allocateDirect(d.length*2).order(nativeEndian);
+            _data.asShortBuffer().put(d);
+        } else if (_dataArray instanceof int[]) {
+            int[] d = (int[])_dataArray;
+            _data = ByteBuffer.allocateDirect(d.length*4).order(nativeEndian);
+            _data.asIntBuffer().put(d);
+        } else if (_dataArray instanceof long[]) {
+            long[] d = (long[])_dataArray;
+            _data = ByteBuffer.allocateDirect(d.length*8).order(nativeEndian);
+            _data.asLongBuffer().put(d);
+        } else if (_dataArray instanceof float[]) {
+            float[] d = (float[])_dataArray;
+            _data = ByteBuffer.allocateDirect(d.length*4).order(nativeEndian);
+            _data.asFloatBuffer().put(d);
+        } else if (_dataArray instanceof double[]) {
+            double[] d = (double[])_dataArray;
+            _data = ByteBuffer.allocateDirect(d.length*8).order(nativeEndian);
+            _data.asDoubleBuffer().put(d);
+        }
     }
 }
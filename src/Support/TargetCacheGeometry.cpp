@@ -0,0 +1,113 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------------------- TargetCacheGeometry.cpp --------------------------===//
+//
+// Per-core cache geometry of the compilation target, feeding the cache-level
+// tile size computation of the blocked matmul schedules.
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/Support/TargetCacheGeometry.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace onnx_mlir {
+
+namespace {
+
+// Geometry of the cpus accepted by -mcpu that differ from the generic
+// defaults. Entries are matched as prefixes so that suffixed variants
+// (e.g. icelake-server, znver3 steppings) share their family entry.
+struct CacheTableEntry {
+  const char *cpuPrefix;
+  int64_t l1DataSize;
+  int64_t l1Associativity;
+  int64_t l2Size;
+};
+
+constexpr int64_t KiB = 1024;
+
+const CacheTableEntry cacheTable[] = {
+    // x86.
+    {"icelake", 48 * KiB, 12, 1280 * KiB},
+    {"sapphirerapids", 48 * KiB, 12, 2048 * KiB},
+    {"skylake-avx512", 32 * KiB, 8, 1024 * KiB},
+    {"cascadelake", 32 * KiB, 8, 1024 * KiB},
+    {"znver3", 32 * KiB, 8, 512 * KiB},
+    {"znver4", 32 * KiB, 8, 1024 * KiB},
+    // AArch64.
+    {"neoverse-n1", 64 * KiB, 4, 1024 * KiB},
+    {"neoverse-v1", 64 * KiB, 4, 1024 * KiB},
+    {"neoverse-v2", 64 * KiB, 4, 2048 * KiB},
+};
+
+// The geometry all tile computations read; set once by the driver.
+TargetCacheGeometry targetCacheGeometry;
+
+// Query the host caches, keeping the defaults for anything the platform
+// does not report.
+void queryHostCaches(TargetCacheGeometry &geometry) {
+#ifdef __linux__
+  long l1Size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  if (l1Size > 0)
+    geometry.l1DataSize = l1Size;
+  long l1Assoc = sysconf(_SC_LEVEL1_DCACHE_ASSOC);
+  if (l1Assoc > 0)
+    geometry.l1Associativity = l1Assoc;
+  long l2Size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (l2Size > 0)
+    geometry.l2Size = l2Size;
+#endif
+}
+
+} // namespace
+
+void TargetCacheGeometry::setFromTargetCPU(const std::string &cpu) {
+  TargetCacheGeometry geometry; // Generic defaults.
+  if (cpu.empty()) {
+    // No explicit target: the model runs on this class of machine.
+    queryHostCaches(geometry);
+  } else {
+    for (const CacheTableEntry &entry : cacheTable) {
+      if (cpu.compare(0, std::strlen(entry.cpuPrefix), entry.cpuPrefix) == 0) {
+        geometry.l1DataSize = entry.l1DataSize;
+        geometry.l1Associativity = entry.l1Associativity;
+        geometry.l2Size = entry.l2Size;
+        break;
+      }
+    }
+  }
+  targetCacheGeometry = geometry;
+}
+
+const TargetCacheGeometry &TargetCacheGeometry::get() {
+  return targetCacheGeometry;
+}
+
+void TargetCacheGeometry::getMatMulCacheTiles(int64_t elementByteSize,
+    int64_t &iCacheTile, int64_t &jCacheTile, int64_t &kCacheTile) const {
+  // 32 rows of A keeps the packing loop short and the register tiling (4
+  // rows) evenly divided on every geometry.
+  iCacheTile = 32;
+  // One iCacheTile x kCacheTile A tile fills L1d. Round down to a multiple
+  // of 64 so the register-level K tiles divide it, and keep it within
+  // [64, 1024] so degenerate geometries still get a usable schedule.
+  kCacheTile = l1DataSize / (iCacheTile * elementByteSize);
+  kCacheTile = (kCacheTile / 64) * 64;
+  kCacheTile = std::max<int64_t>(64, std::min<int64_t>(1024, kCacheTile));
+  // One kCacheTile x jCacheTile B tile takes a quarter of the private L2,
+  // leaving room for the streamed A tiles and the output rows. Round down
+  // to a multiple of 16, the widest register tile along J.
+  jCacheTile = l2Size / (4 * kCacheTile * elementByteSize);
+  jCacheTile = (jCacheTile / 16) * 16;
+  jCacheTile = std::max<int64_t>(16, std::min<int64_t>(256, jCacheTile));
+}
+
+} // namespace onnx_mlir
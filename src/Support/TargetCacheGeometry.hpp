@@ -0,0 +1,48 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------------------- TargetCacheGeometry.hpp --------------------------===//
+//
+// Per-core cache geometry of the compilation target, feeding the cache-level
+// tile size computation of the blocked matmul schedules.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace onnx_mlir {
+
+// Per-core data cache geometry of the compilation target. The defaults are a
+// conservative generic machine (32KB 8-way L1d, 256KB private L2) that every
+// supported target at least provides. Associativity is recorded for
+// completeness but does not enter the tile computation: the blocked schedules
+// copy their tiles into contiguous buffers, so conflict misses are not a
+// concern and the full capacity is usable.
+struct TargetCacheGeometry {
+  int64_t l1DataSize = 32 * 1024;
+  int64_t l1Associativity = 8;
+  int64_t l2Size = 256 * 1024;
+
+  // Fix the geometry used by all subsequent tile computations from the
+  // requested -mcpu. An empty cpu means the host is the target; then the
+  // host caches are queried when the platform supports it. Unknown cpus keep
+  // the generic defaults. Called once by the compiler driver before
+  // lowering.
+  static void setFromTargetCPU(const std::string &cpu);
+  static const TargetCacheGeometry &get();
+
+  // Cache-level tile sizes for the blocked matmul schedules: one
+  // iCacheTile x kCacheTile A tile fills the L1 data cache, and one
+  // kCacheTile x jCacheTile B tile takes a quarter of the private L2,
+  // leaving room for the A tile stream and the output rows. For the generic
+  // geometry and f32 this yields the 32 x 64 x 256 tiling the schedules
+  // historically hardcoded.
+  void getMatMulCacheTiles(int64_t elementByteSize, int64_t &iCacheTile,
+      int64_t &jCacheTile, int64_t &kCacheTile) const;
+};
+
+} // namespace onnx_mlir
@@ -138,6 +138,9 @@ int main(int argc, char **argv) {
 
   // Initialize accelerators if they exist.
   onnx_mlir::accel::initAccelerators(maccel);
+  if (!acceleratorPlugins.empty() &&
+      !onnx_mlir::accel::loadAcceleratorPlugins(acceleratorPlugins))
+    return 1;
 
   // Register dialects for accelerators.
   for (auto *accel : onnx_mlir::accel::Accelerator::getAccelerators())
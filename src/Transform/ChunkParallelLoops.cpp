@@ -0,0 +1,209 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ ChunkParallelLoops.cpp - Schedule Parallel Loops in Chunks ------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// Without this pass the scf.parallel loops produced by krnl.parallel are
+// serialized by the scf-to-cf conversion: nothing in the default pipeline
+// maps them onto threads. This pass outlines the body of each outermost
+// scf.parallel loop into a private function that executes one contiguous
+// chunk of the normalized iteration space and replaces the loop with a
+// krnl.run_loop operation. The krnl-to-llvm conversion lowers krnl.run_loop
+// to a call to 'omRunParallelLoop', which cuts the space into chunks
+// according to the selected schedule: one static chunk per thread,
+// overpartitioned chunks balanced by work stealing, or guided chunks of
+// decreasing size for ragged workloads whose iterations have very different
+// costs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+struct ChunkParallelLoopsPass
+    : public PassWrapper<ChunkParallelLoopsPass, OperationPass<ModuleOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(ChunkParallelLoopsPass)
+
+  ChunkParallelLoopsPass() = default;
+  ChunkParallelLoopsPass(const ChunkParallelLoopsPass &pass)
+      : PassWrapper<ChunkParallelLoopsPass, OperationPass<ModuleOp>>() {}
+  ChunkParallelLoopsPass(int64_t schedule) { this->schedule = schedule; }
+
+  StringRef getArgument() const override { return "chunk-parallel-loops"; }
+
+  StringRef getDescription() const override {
+    return "Outline scf.parallel loops into chunked functions executed on "
+           "the runtime worker pool.";
+  }
+
+  Option<int64_t> schedule{*this, "schedule",
+      llvm::cl::desc("Chunk schedule: 0 static, 1 dynamic (work stealing), "
+                     "2 guided (decreasing chunks)."),
+      llvm::cl::init(1)};
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithDialect, func::FuncDialect, scf::SCFDialect,
+        KrnlDialect>();
+  }
+
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    // Snapshot the functions first: the chunk functions created below must
+    // not be revisited, or the parallel loops nested inside them would be
+    // outlined a second time.
+    SmallVector<func::FuncOp> funcs(module.getOps<func::FuncOp>());
+    for (func::FuncOp funcOp : funcs)
+      chunkFunction(module, funcOp);
+  }
+
+private:
+  void chunkFunction(ModuleOp module, func::FuncOp funcOp) {
+    if (funcOp.isExternal())
+      return;
+
+    // Gather the outermost single-dimensional parallel loops. Nested
+    // parallel loops run sequentially inside the chunk of their parent;
+    // oversubscribing the worker pool with nested chunks would only add
+    // scheduling overhead.
+    SmallVector<scf::ParallelOp> candidates;
+    funcOp.walk([&](scf::ParallelOp parallelOp) {
+      if (parallelOp->getParentOfType<scf::ParallelOp>())
+        return;
+      if (parallelOp.getNumLoops() != 1 || parallelOp.getNumResults() != 0)
+        return;
+      candidates.emplace_back(parallelOp);
+    });
+
+    OpBuilder moduleBuilder(module.getContext());
+    moduleBuilder.setInsertionPointAfter(funcOp);
+
+    int64_t loopIdx = 0;
+    for (scf::ParallelOp parallelOp : candidates)
+      outlineLoop(module, moduleBuilder, funcOp, parallelOp, loopIdx);
+  }
+
+  void outlineLoop(ModuleOp module, OpBuilder &moduleBuilder,
+      func::FuncOp funcOp, scf::ParallelOp parallelOp, int64_t &loopIdx) {
+    Location loc = parallelOp.getLoc();
+    Value lowerBound = parallelOp.getLowerBound()[0];
+    Value upperBound = parallelOp.getUpperBound()[0];
+    Value step = parallelOp.getStep()[0];
+
+    // Collect the values the loop body uses from the surrounding function.
+    // Constants are cheaper to rematerialize in the outlined function than
+    // to marshal through the runtime.
+    SmallVector<Value> externalValues;
+    SmallVector<Operation *> constantsToClone;
+    SmallPtrSet<Value, 8> seenValues;
+    SmallPtrSet<Operation *, 8> seenConstants;
+    // Walk the body only: the loop bounds themselves are rematerialized from
+    // the normalized chunk bounds and do not need to be captured.
+    Region &loopBody = parallelOp.getLoopBody();
+    loopBody.walk([&](Operation *op) {
+      for (Value operand : op->getOperands()) {
+        if (loopBody.isAncestor(operand.getParentRegion()))
+          continue;
+        Operation *defOp = operand.getDefiningOp();
+        if (defOp && matchPattern(defOp, m_Constant())) {
+          if (seenConstants.insert(defOp).second)
+            constantsToClone.emplace_back(defOp);
+          continue;
+        }
+        if (seenValues.insert(operand).second)
+          externalValues.emplace_back(operand);
+      }
+    });
+
+    // Create the chunk function. It receives the chunk bounds in the
+    // normalized space [0, tripCount), the original lower bound and step to
+    // reconstruct the induction variable, and the captured values.
+    std::string chunkName =
+        (funcOp.getName() + "_ploop" + Twine(loopIdx++)).str();
+    while (module.lookupSymbol(chunkName))
+      chunkName += "_";
+    MLIRContext *ctx = module.getContext();
+    Type indexType = IndexType::get(ctx);
+    SmallVector<Type> argTypes = {indexType, indexType, indexType, indexType};
+    for (Value value : externalValues)
+      argTypes.emplace_back(value.getType());
+    auto chunkType = FunctionType::get(ctx, argTypes, /*results=*/{});
+    auto chunkFunc =
+        moduleBuilder.create<func::FuncOp>(loc, chunkName, chunkType);
+    chunkFunc.setPrivate();
+    Block *chunkBlock = chunkFunc.addEntryBlock();
+    OpBuilder chunkBuilder = OpBuilder::atBlockBegin(chunkBlock);
+    Value chunkLb = chunkBlock->getArgument(0);
+    Value chunkUb = chunkBlock->getArgument(1);
+    Value origLb = chunkBlock->getArgument(2);
+    Value origStep = chunkBlock->getArgument(3);
+
+    BlockAndValueMapping mapping;
+    for (auto [value, arg] : llvm::zip(
+             externalValues, chunkBlock->getArguments().drop_front(4)))
+      mapping.map(value, arg);
+    for (Operation *constantOp : constantsToClone)
+      chunkBuilder.clone(*constantOp, mapping);
+
+    // for (idx = chunkLb; idx < chunkUb; ++idx) body(origLb + idx * origStep)
+    Value one = chunkBuilder.create<arith::ConstantIndexOp>(loc, 1);
+    auto forOp =
+        chunkBuilder.create<scf::ForOp>(loc, chunkLb, chunkUb, one);
+    chunkBuilder.setInsertionPointToStart(forOp.getBody());
+    Value scaled = chunkBuilder.create<arith::MulIOp>(
+        loc, forOp.getInductionVar(), origStep);
+    Value iv = chunkBuilder.create<arith::AddIOp>(loc, origLb, scaled);
+    mapping.map(parallelOp.getInductionVars()[0], iv);
+    for (Operation &bodyOp : loopBody.front().without_terminator())
+      chunkBuilder.clone(bodyOp, mapping);
+    chunkBuilder.setInsertionPointToEnd(chunkBlock);
+    chunkBuilder.create<func::ReturnOp>(loc);
+
+    // Replace the loop with the runtime rendezvous. The trip count is
+    // ceil((ub - lb) / step); bounds and step of scf.parallel are known to
+    // describe a non-empty, positively-stepped range only at runtime, so the
+    // division stays in the IR.
+    OpBuilder builder(parallelOp);
+    Value range = builder.create<arith::SubIOp>(loc, upperBound, lowerBound);
+    Value tripCount = builder.create<arith::CeilDivSIOp>(loc, range, step);
+    SmallVector<Value> loopOperands = {lowerBound, step};
+    loopOperands.append(externalValues.begin(), externalValues.end());
+    builder.create<KrnlRunLoopOp>(loc,
+        FlatSymbolRefAttr::get(ctx, chunkName),
+        builder.getI64IntegerAttr(schedule), tripCount, loopOperands);
+    parallelOp.erase();
+  }
+};
+
+} // namespace
+
+namespace onnx_mlir {
+namespace krnl {
+
+/// Create a pass that runs parallel loops in chunks on the worker pool.
+std::unique_ptr<mlir::Pass> createChunkParallelLoopsPass() {
+  return std::make_unique<ChunkParallelLoopsPass>();
+}
+
+std::unique_ptr<mlir::Pass> createChunkParallelLoopsPass(int64_t schedule) {
+  return std::make_unique<ChunkParallelLoopsPass>(schedule);
+}
+
+} // namespace krnl
+} // namespace onnx_mlir
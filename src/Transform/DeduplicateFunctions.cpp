@@ -0,0 +1,96 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ DeduplicateFunctions.cpp - Merge identical functions ----------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This pass merges private functions that are structurally identical after
+// lowering into a single copy, redirecting every symbol use to the survivor.
+// Repetitive layer stacks produce many outlined bodies whose ONNX-level
+// differences (instance names, attributes the lowering folds away) vanish
+// during lowering; keeping one lowered copy shrinks the text segment of the
+// generated library and keeps the shared body hot in the instruction cache.
+// Public functions are part of the binary interface and always keep their
+// own symbol.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace {
+
+// Structural fingerprint of a function: its printed form with the symbol
+// name blanked out, so two candidates print identically exactly when their
+// types, attributes, and bodies match. The printer numbers values locally,
+// which makes the text position independent, and constant payloads print in
+// full, so functions differing only in their weights stay distinct.
+std::string getFunctionFingerprint(func::FuncOp funcOp) {
+  std::string fingerprint;
+  llvm::raw_string_ostream os(fingerprint);
+  StringAttr name = funcOp.getSymNameAttr();
+  funcOp.setSymNameAttr(StringAttr::get(funcOp.getContext(), ""));
+  funcOp.print(os);
+  funcOp.setSymNameAttr(name);
+  return os.str();
+}
+
+struct DeduplicateFunctionsPass
+    : public PassWrapper<DeduplicateFunctionsPass, OperationPass<ModuleOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(DeduplicateFunctionsPass)
+
+  StringRef getArgument() const override { return "dedup-funcs"; }
+
+  StringRef getDescription() const override {
+    return "Merge structurally identical private functions into one copy.";
+  }
+
+  void runOnOperation() final;
+};
+
+void DeduplicateFunctionsPass::runOnOperation() {
+  ModuleOp module = getOperation();
+
+  // First function seen with each fingerprint, and the duplicates to fold
+  // into it. Duplicates are collected first so the module iteration never
+  // observes erasures.
+  llvm::StringMap<func::FuncOp> keptFuncs;
+  SmallVector<std::pair<func::FuncOp, func::FuncOp>, 4> duplicates;
+  for (auto funcOp : module.getOps<func::FuncOp>()) {
+    if (!funcOp.isPrivate() || funcOp.isExternal())
+      continue;
+    std::string fingerprint = getFunctionFingerprint(funcOp);
+    auto insertion = keptFuncs.try_emplace(fingerprint, funcOp);
+    if (!insertion.second)
+      duplicates.emplace_back(funcOp, insertion.first->second);
+  }
+
+  for (auto &dupAndKept : duplicates) {
+    func::FuncOp duplicate = dupAndKept.first;
+    func::FuncOp kept = dupAndKept.second;
+    if (failed(SymbolTable::replaceAllSymbolUses(
+            duplicate, kept.getSymNameAttr(), module)))
+      return signalPassFailure();
+    duplicate.erase();
+  }
+}
+
+} // namespace
+
+/*!
+ * Create a function deduplication pass.
+ */
+std::unique_ptr<mlir::Pass> onnx_mlir::krnl::createDeduplicateFunctionsPass() {
+  return std::make_unique<DeduplicateFunctionsPass>();
+}
@@ -116,10 +116,6 @@ public:
     if (!llvm::dyn_cast_or_null<func::FuncOp>(parentBlock->getParentOp()))
       return failure();
 
-    // For now only handle constant MemRefs.
-    if (!hasAllConstantDimensions(memRefType))
-      return failure();
-
     MultiDialectBuilder<KrnlBuilder, MemRefBuilder, MathBuilder> create(
         rewriter, loc);
 
@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------- F16WeightStorage.cpp - Store Packed Weights in Half ----------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// Small-batch inference is bound by the bandwidth spent streaming weights,
+// not by compute. This pass narrows f32 constants to f16 storage when every
+// use is the source of a krnl.copy_to_tile_buffer, i.e. when the constant is
+// only ever read through the tile-packing step of a matmul or gemm. The pack
+// copy widens each element back to f32 (see KrnlCopyToBuffer lowering), so
+// the compute tiles and the results stay in f32; only the memory footprint
+// and traffic of the weights are halved. Constants read directly by compute
+// loops are left alone, as widening there would sit on the critical path.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// Return true when every use of the global is the source operand of a
+/// krnl.copy_to_tile_buffer, so narrowing its storage only affects the pack
+/// copies.
+static bool onlyUsedAsPackSource(KrnlGlobalOp globalOp) {
+  Value output = globalOp.output();
+  if (output.use_empty())
+    return false;
+  for (OpOperand &use : output.getUses()) {
+    auto copyOp = dyn_cast<KrnlCopyToBufferOp>(use.getOwner());
+    if (!copyOp || copyOp.source() != output)
+      return false;
+  }
+  return true;
+}
+
+/// Narrow one f32 global to f16 storage and retype its pack copies.
+static void narrowGlobal(KrnlGlobalOp globalOp, DenseElementsAttr value) {
+  OpBuilder builder(globalOp);
+  Type f16Type = builder.getF16Type();
+  DenseElementsAttr f16Value =
+      value.mapValues(f16Type, [&](const APFloat &element) {
+        bool losesInfo;
+        APFloat converted(element);
+        converted.convert(
+            APFloat::IEEEhalf(), APFloat::rmNearestTiesToEven, &losesInfo);
+        return converted.bitcastToAPInt();
+      });
+  MemRefType oldType = globalOp.output().getType().cast<MemRefType>();
+  MemRefType newType = MemRefType::get(oldType.getShape(), f16Type);
+  KrnlGlobalOp newGlobal = builder.create<KrnlGlobalOp>(globalOp.getLoc(),
+      newType, globalOp.shapeAttr(), globalOp.nameAttr(), f16Value,
+      globalOp.offsetAttr(), globalOp.alignmentAttr());
+  globalOp.output().replaceAllUsesWith(newGlobal.output());
+  globalOp.erase();
+}
+
+class F16WeightStoragePass
+    : public PassWrapper<F16WeightStoragePass, OperationPass<func::FuncOp>> {
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(F16WeightStoragePass)
+
+  StringRef getArgument() const override { return "f16-weight-storage"; }
+
+  StringRef getDescription() const override {
+    return "Store f32 constants that are only read through tile packing in "
+           "half precision, widening to f32 during the pack copy.";
+  }
+
+  void runOnOperation() override {
+    // Collect first: narrowing erases the op under the walk.
+    SmallVector<std::pair<KrnlGlobalOp, DenseElementsAttr>, 8> candidates;
+    getOperation().walk([&](KrnlGlobalOp globalOp) {
+      auto memRefType = globalOp.output().getType().dyn_cast<MemRefType>();
+      if (!memRefType || !memRefType.getElementType().isF32())
+        return;
+      if (!globalOp.value().has_value())
+        return;
+      auto value = globalOp.value().value().dyn_cast<DenseElementsAttr>();
+      if (!value || !onlyUsedAsPackSource(globalOp))
+        return;
+      candidates.emplace_back(globalOp, value);
+    });
+    for (auto &[globalOp, value] : candidates)
+      narrowGlobal(globalOp, value);
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass> onnx_mlir::krnl::createF16WeightStoragePass() {
+  return std::make_unique<F16WeightStoragePass>();
+}
@@ -0,0 +1,271 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------- FuseKrnlLoops.cpp - Fuse Krnl Loop Nests -----------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// Every ONNX operation is lowered to its own loop nest writing its own
+// buffer, even when the consumer reads that buffer elementwise. For
+// elementwise-heavy models the traffic on these intermediate buffers is the
+// dominant memory-bandwidth cost. This pass fuses a producer krnl.iterate
+// nest into a consumer nest when the producer performs a single elementwise
+// store into an allocated buffer that is only read back, at the same
+// indices and under the same bounds, inside the consumer; the intermediate
+// buffer and its allocation are then removed.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Pass/Passes.hpp"
+#include "src/Support/KrnlSupport.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// Return true if `op` is guaranteed not to write to memory. Used to make
+/// sure no operation between a producer and its consumer can redefine the
+/// values the producer body reads.
+static bool doesNotWriteToMemory(Operation *op) {
+  if (op->getNumRegions() > 0)
+    return false;
+  auto effectInterface = dyn_cast<MemoryEffectOpInterface>(op);
+  if (!effectInterface)
+    return false;
+  SmallVector<MemoryEffects::EffectInstance, 4> effects;
+  effectInterface.getEffects(effects);
+  for (auto &effect : effects)
+    if (isa<MemoryEffects::Write>(effect.getEffect()))
+      return false;
+  return true;
+}
+
+/// Separate the operands of a krnl.iterate into its krnl.loop handles and
+/// the remaining (bound) operands, preserving order.
+static void splitIterateOperands(KrnlIterateOp iterateOp,
+    SmallVectorImpl<Value> &loopOperands,
+    SmallVectorImpl<Value> &boundOperands) {
+  for (Value operand : iterateOp.getOperands()) {
+    if (operand.getType().isa<krnl::LoopType>())
+      loopOperands.emplace_back(operand);
+    else
+      boundOperands.emplace_back(operand);
+  }
+}
+
+/// Check that a krnl.iterate uses the identity schedule: its optimized loops
+/// are exactly its input loops, all defined by krnl.define_loops, and it has
+/// one induction variable per loop. Blocked or permuted nests are not fused.
+static bool hasIdentitySchedule(KrnlIterateOp iterateOp) {
+  if (iterateOp.getNumResults() > 0)
+    return false;
+  int64_t numLoops = iterateOp.getNumOptimizedLoops();
+  SmallVector<Value, 4> loopOperands, boundOperands;
+  splitIterateOperands(iterateOp, loopOperands, boundOperands);
+  if ((int64_t)loopOperands.size() != 2 * numLoops)
+    return false;
+  for (int64_t i = 0; i < numLoops; ++i) {
+    if (loopOperands[i] != loopOperands[numLoops + i])
+      return false;
+    if (!loopOperands[i].getDefiningOp<KrnlDefineLoopsOp>())
+      return false;
+  }
+  Block &body = iterateOp.bodyRegion().front();
+  if ((int64_t)body.getNumArguments() != numLoops)
+    return false;
+  return true;
+}
+
+/// Check that two krnl.iterate nests cover the same iteration space: same
+/// number of loops, same bound maps, and same dynamic bound operands.
+static bool haveSameIterationSpace(
+    KrnlIterateOp firstOp, KrnlIterateOp secondOp) {
+  if (firstOp.getNumOptimizedLoops() != secondOp.getNumOptimizedLoops())
+    return false;
+  if (firstOp->getAttr(KrnlIterateOp::getBoundsAttrName()) !=
+      secondOp->getAttr(KrnlIterateOp::getBoundsAttrName()))
+    return false;
+  SmallVector<Value, 4> firstLoops, firstBounds, secondLoops, secondBounds;
+  splitIterateOperands(firstOp, firstLoops, firstBounds);
+  splitIterateOperands(secondOp, secondLoops, secondBounds);
+  return firstBounds == secondBounds;
+}
+
+/// Check that the access indices are exactly the induction variables of the
+/// surrounding nest, in order, i.e. the access is a plain elementwise one.
+static bool accessesAtInductionVars(OperandRange indices, Block &iterateBody) {
+  if (indices.size() != iterateBody.getNumArguments())
+    return false;
+  for (unsigned i = 0; i < iterateBody.getNumArguments(); ++i)
+    if (*(indices.begin() + i) != iterateBody.getArgument(i))
+      return false;
+  return true;
+}
+
+/*!
+ *  RewritePattern that fuses:
+ *    %t = memref.alloc(...)
+ *    krnl.iterate(...) with (...) {   // producer
+ *      <pure ops and krnl.load>
+ *      krnl.store %v, %t[ivs]
+ *    }
+ *    krnl.iterate(...) with (...) {   // consumer, same bounds
+ *      %x = krnl.load %t[ivs]
+ *      ...
+ *    }
+ *  into a single consumer nest where the producer body is recomputed in
+ *  place of the load, after which %t and its alloc/dealloc are removed.
+ */
+class FuseElementwiseKrnlLoops : public OpRewritePattern<KrnlIterateOp> {
+public:
+  using OpRewritePattern<KrnlIterateOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      KrnlIterateOp producerOp, PatternRewriter &rewriter) const override {
+    // Only fuse simple, unscheduled nests at function level.
+    if (!opInTopLevelBlock(producerOp) || !hasIdentitySchedule(producerOp))
+      return failure();
+
+    // The producer body must contain exactly one store, writing the buffer
+    // elementwise, and otherwise only loads and pure operations.
+    Block &producerBody = producerOp.bodyRegion().front();
+    KrnlStoreOp storeOp = nullptr;
+    for (Operation &op : producerBody) {
+      if (auto currentStore = dyn_cast<KrnlStoreOp>(op)) {
+        if (storeOp)
+          return failure();
+        storeOp = currentStore;
+        continue;
+      }
+      if (isa<KrnlLoadOp, KrnlTerminatorOp>(op))
+        continue;
+      if (!doesNotWriteToMemory(&op))
+        return failure();
+    }
+    if (!storeOp || !accessesAtInductionVars(storeOp.getIndices(),
+                        producerBody))
+      return failure();
+
+    // The buffer must be a local allocation whose only other uses are
+    // elementwise loads inside a single fusable consumer nest, plus an
+    // optional dealloc.
+    Value buffer = storeOp.getMemRef();
+    auto allocOp = buffer.getDefiningOp<memref::AllocOp>();
+    if (!allocOp)
+      return failure();
+
+    KrnlIterateOp consumerOp = nullptr;
+    memref::DeallocOp deallocOp = nullptr;
+    SmallVector<KrnlLoadOp, 4> bufferLoads;
+    for (Operation *user : buffer.getUsers()) {
+      if (user == storeOp.getOperation())
+        continue;
+      if (auto currentDealloc = dyn_cast<memref::DeallocOp>(user)) {
+        if (deallocOp)
+          return failure();
+        deallocOp = currentDealloc;
+        continue;
+      }
+      auto loadOp = dyn_cast<KrnlLoadOp>(user);
+      if (!loadOp)
+        return failure();
+      auto parentIterate = loadOp->getParentOfType<KrnlIterateOp>();
+      if (!parentIterate ||
+          parentIterate->getBlock() != producerOp->getBlock())
+        return failure();
+      if (consumerOp && parentIterate != consumerOp)
+        return failure();
+      consumerOp = parentIterate;
+      bufferLoads.emplace_back(loadOp);
+    }
+    if (!consumerOp || !hasIdentitySchedule(consumerOp) ||
+        !haveSameIterationSpace(producerOp, consumerOp))
+      return failure();
+    if (!opBeforeOp(producerOp->getBlock(), producerOp, consumerOp))
+      return failure();
+
+    // Every load must read the element the consumer iteration writes.
+    Block &consumerBody = consumerOp.bodyRegion().front();
+    for (KrnlLoadOp loadOp : bufferLoads)
+      if (loadOp->getParentOp() != consumerOp.getOperation() ||
+          !accessesAtInductionVars(loadOp.getIndices(), consumerBody))
+        return failure();
+
+    // Recomputing the producer body inside the consumer is only legal when
+    // no operation in between can overwrite the values it reads.
+    for (Operation *op = producerOp->getNextNode();
+         op != consumerOp.getOperation(); op = op->getNextNode())
+      if (!isa<memref::AllocOp, memref::DeallocOp, KrnlDefineLoopsOp,
+              KrnlGlobalOp>(op) &&
+          !doesNotWriteToMemory(op))
+        return failure();
+
+    // Clone the producer body at the top of the consumer, mapping the
+    // producer induction variables onto the consumer ones, and replace the
+    // loads of the buffer with the recomputed value.
+    rewriter.setInsertionPointToStart(&consumerBody);
+    BlockAndValueMapping mapper;
+    for (unsigned i = 0; i < producerBody.getNumArguments(); ++i)
+      mapper.map(producerBody.getArgument(i), consumerBody.getArgument(i));
+    for (Operation &op : producerBody) {
+      if (isa<KrnlStoreOp, KrnlTerminatorOp>(op))
+        continue;
+      rewriter.clone(op, mapper);
+    }
+    Value fusedValue = mapper.lookup(storeOp.getValueToStore());
+    for (KrnlLoadOp loadOp : bufferLoads)
+      rewriter.replaceOp(loadOp, fusedValue);
+
+    // The intermediate buffer is now dead.
+    rewriter.eraseOp(producerOp);
+    if (deallocOp)
+      rewriter.eraseOp(deallocOp);
+    rewriter.eraseOp(allocOp);
+    return success();
+  }
+};
+
+/*!
+ *  Function pass that fuses elementwise Krnl loop nests and removes the
+ *  intermediate buffers between them.
+ */
+class FuseKrnlLoopsPass
+    : public PassWrapper<FuseKrnlLoopsPass, OperationPass<func::FuncOp>> {
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(FuseKrnlLoopsPass)
+
+  StringRef getArgument() const override { return "fuse-krnl-loops"; }
+
+  StringRef getDescription() const override {
+    return "Fuse elementwise Krnl loop nests and eliminate the intermediate "
+           "buffers between them.";
+  }
+
+  void runOnOperation() override {
+    auto function = getOperation();
+
+    RewritePatternSet patterns(&getContext());
+    patterns.insert<FuseElementwiseKrnlLoops>(&getContext());
+
+    // No need to test, its ok to fail the apply.
+    LogicalResult res =
+        applyPatternsAndFoldGreedily(function, std::move(patterns));
+    assert((succeeded(res) || failed(res)) && "remove unused var warning");
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass> onnx_mlir::krnl::createFuseKrnlLoopsPass() {
+  return std::make_unique<FuseKrnlLoopsPass>();
+}
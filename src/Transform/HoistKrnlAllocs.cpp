@@ -0,0 +1,169 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===--------- HoistKrnlAllocs.cpp - Hoist Allocations out of Loops -------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// Scratch buffers sized by dynamic dimensions are allocated inside the loop
+// nests generated for ops like onnx.Loop, even when the sizes are the same
+// for every iteration; sequence models then pay one large allocation and
+// deallocation per iteration. This pass hoists a memref.alloc out of a
+// krnl.iterate when its sizes are loop invariant and the buffer provably
+// dies within the iteration, so a single buffer is reused across all
+// iterations. The corresponding memref.dealloc moves after the loop.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// Return true if `op` is free of memory effects and regions, so that it can
+/// be recomputed before the loop.
+static bool isHoistableComputation(Operation *op) {
+  if (op->getNumRegions() > 0)
+    return false;
+  auto effectInterface = dyn_cast<MemoryEffectOpInterface>(op);
+  if (!effectInterface)
+    return false;
+  SmallVector<MemoryEffects::EffectInstance, 4> effects;
+  effectInterface.getEffects(effects);
+  return effects.empty();
+}
+
+/// Check that `value` is invariant with respect to `loopOp`: either defined
+/// outside the loop body, or computed inside by a chain of effect-free
+/// operations whose leaves are defined outside. Operations of such a chain
+/// are appended to `toHoist` in a def-before-use order.
+static bool isLoopInvariant(Value value, KrnlIterateOp loopOp,
+    SmallVectorImpl<Operation *> &toHoist,
+    SmallPtrSetImpl<Operation *> &visited) {
+  if (!loopOp.bodyRegion().isAncestor(value.getParentRegion()))
+    return true;
+  // Block arguments inside the loop are induction variables.
+  Operation *definingOp = value.getDefiningOp();
+  if (!definingOp)
+    return false;
+  if (visited.count(definingOp))
+    return true;
+  if (!isHoistableComputation(definingOp))
+    return false;
+  for (Value operand : definingOp->getOperands())
+    if (!isLoopInvariant(operand, loopOp, toHoist, visited))
+      return false;
+  visited.insert(definingOp);
+  toHoist.emplace_back(definingOp);
+  return true;
+}
+
+/// Hoist `allocOp` out of its innermost enclosing krnl.iterate when its
+/// dynamic sizes are loop invariant and the buffer is local to one
+/// iteration. Return true when the allocation was moved.
+static bool tryHoistAlloc(memref::AllocOp allocOp) {
+  auto loopOp = allocOp->getParentOfType<KrnlIterateOp>();
+  if (!loopOp)
+    return false;
+
+  // All size operands must be invariant; collect any invariant computation
+  // feeding them that has to move along.
+  SmallVector<Operation *, 4> toHoist;
+  SmallPtrSet<Operation *, 4> visited;
+  for (Value operand : allocOp.getOperands())
+    if (!isLoopInvariant(operand, loopOp, toHoist, visited))
+      return false;
+
+  // The buffer may only be read, written and deallocated inside the loop;
+  // any other use could let the pointer outlive the iteration, in which case
+  // reusing one buffer for all iterations would be wrong. The dealloc is
+  // required as the proof that the buffer dies every iteration.
+  memref::DeallocOp deallocOp = nullptr;
+  Value buffer = allocOp.getResult();
+  for (Operation *user : buffer.getUsers()) {
+    if (!loopOp.bodyRegion().isAncestor(user->getParentRegion()))
+      return false;
+    if (auto currentDealloc = dyn_cast<memref::DeallocOp>(user)) {
+      if (deallocOp)
+        return false;
+      deallocOp = currentDealloc;
+      continue;
+    }
+    if (auto storeOp = dyn_cast<KrnlStoreOp>(user)) {
+      if (storeOp.getValueToStore() == buffer)
+        return false;
+      continue;
+    }
+    if (auto storeOp = dyn_cast<memref::StoreOp>(user)) {
+      if (storeOp.getValueToStore() == buffer)
+        return false;
+      continue;
+    }
+    if (!isa<KrnlLoadOp, memref::LoadOp, vector::LoadOp, vector::StoreOp,
+            KrnlMemcpyOp, KrnlMemsetOp>(user))
+      return false;
+  }
+  if (!deallocOp)
+    return false;
+  // The dealloc must be at the same nesting level as the alloc, so that
+  // moving it after the loop keeps every use of the buffer between the
+  // allocation and the deallocation.
+  if (deallocOp->getParentRegion() != allocOp->getParentRegion())
+    return false;
+
+  // Move the invariant size computation, the allocation and the
+  // deallocation out of the loop.
+  for (Operation *op : toHoist)
+    op->moveBefore(loopOp);
+  allocOp->moveBefore(loopOp);
+  deallocOp->moveAfter(loopOp);
+  return true;
+}
+
+/*!
+ *  Function pass that hoists loop-invariant allocations out of Krnl loops
+ *  and reuses the buffer across iterations.
+ */
+class HoistKrnlAllocsPass
+    : public PassWrapper<HoistKrnlAllocsPass, OperationPass<func::FuncOp>> {
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(HoistKrnlAllocsPass)
+
+  StringRef getArgument() const override { return "hoist-krnl-allocs"; }
+
+  StringRef getDescription() const override {
+    return "Hoist loop-invariant allocations out of Krnl loops and reuse "
+           "the buffer across iterations.";
+  }
+
+  void runOnOperation() override {
+    func::FuncOp function = getOperation();
+
+    // Iterate to a fixed point: hoisting out of an inner loop may expose
+    // hoisting out of an enclosing loop.
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      function.walk([&](memref::AllocOp allocOp) {
+        if (tryHoistAlloc(allocOp))
+          changed = true;
+      });
+    }
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass> onnx_mlir::krnl::createHoistKrnlAllocsPass() {
+  return std::make_unique<HoistKrnlAllocsPass>();
+}
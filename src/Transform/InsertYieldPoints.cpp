@@ -0,0 +1,93 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ InsertYieldPoints.cpp - Cooperative preemption points ---------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This pass inserts calls to the 'omTaskPoolYield' runtime function at the
+// top of every outermost krnl.iterate loop body. A thread cannot be
+// preempted in the middle of a loop nest, so when a latency-critical model
+// shares the process with a long-running one, its requests would sit behind
+// whole inferences of the big model. The inserted call is a cheap flag check
+// once per chunk of the outer loop; when a higher-priority task is pending
+// (see OMTaskPool), the calling thread runs that task before resuming with
+// its next chunk, which bounds the head-of-line blocking to one chunk
+// instead of one inference.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace {
+
+struct InsertYieldPointsPass
+    : public PassWrapper<InsertYieldPointsPass, OperationPass<ModuleOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(InsertYieldPointsPass)
+
+  StringRef getArgument() const override { return "insert-yield-points"; }
+
+  StringRef getDescription() const override {
+    return "Insert cooperative yield checks at outer loop chunk boundaries.";
+  }
+
+  void runOnOperation() final;
+};
+
+void InsertYieldPointsPass::runOnOperation() {
+  ModuleOp module = getOperation();
+  static constexpr const char *yieldFnName = "omTaskPoolYield";
+
+  // Collect the outermost krnl.iterate of every loop nest; yielding inside
+  // inner loops would put the check on the hot path.
+  SmallVector<KrnlIterateOp> outerLoops;
+  for (auto funcOp : module.getOps<func::FuncOp>()) {
+    if (funcOp.isExternal())
+      continue;
+    funcOp.walk([&](KrnlIterateOp iterateOp) {
+      if (!iterateOp->getParentOfType<KrnlIterateOp>())
+        outerLoops.emplace_back(iterateOp);
+    });
+  }
+  if (outerLoops.empty())
+    return;
+
+  // Declare the runtime function once; it resolves against the runtime
+  // library linked into the generated model.
+  auto yieldFunc = module.lookupSymbol<func::FuncOp>(yieldFnName);
+  if (!yieldFunc) {
+    OpBuilder moduleBuilder = OpBuilder::atBlockEnd(module.getBody());
+    yieldFunc = moduleBuilder.create<func::FuncOp>(module.getLoc(),
+        yieldFnName,
+        FunctionType::get(module.getContext(), /*inputs=*/{}, /*results=*/{}));
+    yieldFunc.setPrivate();
+  }
+
+  for (KrnlIterateOp iterateOp : outerLoops) {
+    Block &body = iterateOp.bodyRegion().front();
+    OpBuilder builder = OpBuilder::atBlockBegin(&body);
+    builder.create<func::CallOp>(iterateOp.getLoc(), yieldFunc);
+  }
+}
+
+} // namespace
+
+namespace onnx_mlir {
+namespace krnl {
+
+/// Create a pass that inserts cooperative preemption points in outer loops.
+std::unique_ptr<mlir::Pass> createInsertYieldPointsPass() {
+  return std::make_unique<InsertYieldPointsPass>();
+}
+
+} // namespace krnl
+} // namespace onnx_mlir
@@ -0,0 +1,111 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ InstrumentMemoryPass.cpp - Memory Instrumentation -------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This pass reports every generated allocation site to the instrumentation
+// runtime. Each memref.alloc gets a krnl.runtime_instrument_memory op carrying
+// the allocated size in bytes, and each matching memref.dealloc gets one with
+// the negated size. Combined with the regular instrumentation points, the
+// runtime can then attribute allocations to the op being executed and derive
+// a per-op peak-memory report.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Dialect/Mlir/DialectBuilder.hpp"
+#include "src/Pass/Passes.hpp"
+#include "src/Support/KrnlSupport.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// Emit the size in bytes of the buffer created by `allocOp`, folding the
+/// static dimensions into a constant and multiplying in the dynamic ones
+/// directly from the alloc operands.
+static Value emitAllocSizeInBytes(
+    OpBuilder &builder, Location loc, memref::AllocOp allocOp) {
+  MultiDialectBuilder<MathBuilder> create(builder, loc);
+  MemRefType memRefType = allocOp.getResult().getType().cast<MemRefType>();
+  int64_t staticSizeInBytes = getMemRefEltSizeInBytes(memRefType);
+  for (int64_t dim : memRefType.getShape())
+    if (!ShapedType::isDynamic(dim))
+      staticSizeInBytes *= dim;
+  Value sizeInBytes =
+      create.math.constant(builder.getI64Type(), staticSizeInBytes);
+  for (Value dynamicSize : allocOp.getDynamicSizes()) {
+    Value dim = builder.create<arith::IndexCastOp>(
+        loc, builder.getI64Type(), dynamicSize);
+    sizeInBytes = create.math.mul(sizeInBytes, dim);
+  }
+  return sizeInBytes;
+}
+
+/*!
+ * This pass inserts KrnlInstrumentMemoryOp after each memref.alloc and
+ * before each memref.dealloc.
+ */
+class InstrumentMemoryPass : public mlir::PassWrapper<InstrumentMemoryPass,
+                                 OperationPass<func::FuncOp>> {
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(InstrumentMemoryPass)
+
+  StringRef getArgument() const override { return "instrument-memory"; }
+
+  StringRef getDescription() const override {
+    return "instrument memory allocation sites.";
+  }
+
+  void runOnOperation() override {
+    func::FuncOp funcOp = getOperation();
+
+    // Record the size emitted for each alloc so the matching dealloc reports
+    // the same number of bytes, including for dynamic shapes.
+    DenseMap<Value, Value> sizeForBuffer;
+
+    funcOp.walk([&](memref::AllocOp allocOp) {
+      Location loc = allocOp.getLoc();
+      OpBuilder builder(allocOp.getOperation());
+      Value sizeInBytes = emitAllocSizeInBytes(builder, loc, allocOp);
+      builder.setInsertionPointAfter(allocOp);
+      builder.create<KrnlInstrumentMemoryOp>(loc, sizeInBytes);
+      sizeForBuffer[allocOp.getResult()] = sizeInBytes;
+    });
+
+    funcOp.walk([&](memref::DeallocOp deallocOp) {
+      // Look through casts to find the original allocation.
+      Value buffer = deallocOp.getMemref();
+      while (auto castOp = buffer.getDefiningOp<memref::CastOp>())
+        buffer = castOp.getSource();
+      auto entry = sizeForBuffer.find(buffer);
+      if (entry == sizeForBuffer.end())
+        return;
+      Location loc = deallocOp.getLoc();
+      OpBuilder builder(deallocOp.getOperation());
+      MultiDialectBuilder<MathBuilder> create(builder, loc);
+      Value zero = create.math.constant(builder.getI64Type(), 0);
+      Value negatedSize = create.math.sub(zero, entry->second);
+      builder.create<KrnlInstrumentMemoryOp>(loc, negatedSize);
+    });
+  }
+};
+
+} // namespace
+
+/*!
+ * Create a memory instrumentation pass.
+ */
+std::unique_ptr<mlir::Pass> onnx_mlir::krnl::createInstrumentMemoryPass() {
+  return std::make_unique<InstrumentMemoryPass>();
+}
@@ -0,0 +1,157 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===-------- AccumAnnotationPass.cpp - Accumulation Annotation -----------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements a Function level pass that annotates ONNX ops with a
+// requested accumulation type from an optimization config, so that later
+// lowering passes can accumulate individual reductions and matrix products
+// in a wider type for accuracy or a narrower one for speed, instead of one
+// global policy.
+//
+// The config is a text file with one entry per line:
+//
+//   <op name> <node name> <accum type>
+//
+// where <node name> is the onnx_node_name attribute (or NOTSET to match every
+// op with the given op name) and <accum type> is one of f16, bf16, f32 or
+// f64. Matching ops get an `accum_type` string attribute; entries keyed by
+// node name take precedence over entries keyed by op name.
+//
+//===----------------------------------------------------------------------===//
+
+#include <map>
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+/*!
+ * This pass annotates ONNX ops with a requested accumulation type from a
+ * config file.
+ */
+
+class AccumAnnotationPass : public mlir::PassWrapper<AccumAnnotationPass,
+                                OperationPass<func::FuncOp>> {
+
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(AccumAnnotationPass)
+
+  Option<std::string> configFile{*this, "config-file",
+      llvm::cl::desc("Config file mapping ops to accumulation types."),
+      llvm::cl::init("")};
+
+  AccumAnnotationPass() = default;
+  AccumAnnotationPass(const AccumAnnotationPass &pass)
+      : mlir::PassWrapper<AccumAnnotationPass, OperationPass<func::FuncOp>>() {
+  }
+  AccumAnnotationPass(std::string configFile) {
+    this->configFile = configFile;
+  }
+
+private:
+  // Accumulation types keyed by onnx_node_name, and by op name for entries
+  // whose node name is NOTSET.
+  std::map<std::string, std::string> typeByNodeName;
+  std::map<std::string, std::string> typeByOpName;
+
+public:
+  StringRef getArgument() const override { return "accum-annotation"; }
+
+  StringRef getDescription() const override {
+    return "annotate onnx ops with accumulation types from a config file.";
+  }
+
+  static bool isKnownAccumType(StringRef type) {
+    return type.equals("f16") || type.equals("bf16") || type.equals("f32") ||
+           type.equals("f64");
+  }
+
+  bool readConfig() {
+    auto bufferOrError = llvm::MemoryBuffer::getFile(configFile);
+    if (!bufferOrError) {
+      emitError(UnknownLoc::get(&getContext()),
+          "cannot open accumulation config file '" + configFile + "'");
+      return false;
+    }
+    llvm::SmallVector<StringRef, 64> lines;
+    bufferOrError.get()->getBuffer().split(lines, '\n');
+    for (StringRef line : lines) {
+      line = line.trim();
+      if (line.empty() || line.startswith("#"))
+        continue;
+      StringRef opName, nodeName, typeStr, rest;
+      std::tie(opName, rest) = line.split(' ');
+      std::tie(nodeName, typeStr) = rest.trim().split(' ');
+      typeStr = typeStr.trim();
+      if (!isKnownAccumType(typeStr)) {
+        emitError(UnknownLoc::get(&getContext()),
+            "unknown accumulation type '" + typeStr + "' in config file '" +
+                configFile + "'");
+        return false;
+      }
+      if (nodeName.equals("NOTSET"))
+        typeByOpName[opName.str()] = typeStr.str();
+      else
+        typeByNodeName[nodeName.str()] = typeStr.str();
+    }
+    return true;
+  }
+
+  void runOnOperation() override {
+    if (configFile == "")
+      return;
+    if (!readConfig()) {
+      signalPassFailure();
+      return;
+    }
+
+    OpBuilder builder(&getContext());
+    getOperation().walk([&](mlir::Operation *op) {
+      if (!isa<ONNXDialect>(op->getDialect()))
+        return;
+      std::string type;
+      if (auto nodeNameAttr =
+              op->getAttrOfType<StringAttr>("onnx_node_name")) {
+        auto entry = typeByNodeName.find(nodeNameAttr.getValue().str());
+        if (entry != typeByNodeName.end())
+          type = entry->second;
+      }
+      if (type.empty()) {
+        auto entry = typeByOpName.find(op->getName().getStringRef().str());
+        if (entry != typeByOpName.end())
+          type = entry->second;
+      }
+      if (type.empty())
+        return;
+      op->setAttr("accum_type", builder.getStringAttr(type));
+    });
+  }
+};
+
+} // namespace onnx_mlir
+
+/*!
+ * Create an accumulation annotation pass.
+ */
+std::unique_ptr<mlir::Pass> onnx_mlir::createAccumAnnotationPass() {
+  return std::make_unique<AccumAnnotationPass>();
+}
+
+std::unique_ptr<mlir::Pass> onnx_mlir::createAccumAnnotationPass(
+    std::string configFile) {
+  return std::make_unique<AccumAnnotationPass>(configFile);
+}
@@ -72,14 +72,12 @@ const StringRef BUFFER_ID_ATTR = "buffer_id";
 /// 3) allocateBufferFor(Value value, bool useMaxSize = false)
 ///    - create a new buffer whose size is obtained from the type of 'value'.
 ///
-/// Note that:
-///   - The buffers in the buffer pool will be automatically freed. Users don't
-///     need to take care about that.
-///   - If we create a buffer and do not put it on the buffer pool, please
-///     make sure that it is correctly freed.
-///
-/// Buffer pool to store buffer pointers.
-SmallVector<char *, 4> bufferPtrs;
+/// Buffers live in the shared reference-counted ConstantBufferPool: every
+/// constant op carrying a buffer id holds one reference. A constant whose
+/// only use is the operation being folded is marked consumed when its array
+/// is fetched, and its reference is dropped as soon as the rewrite stores its
+/// result, so the buffers of a folding chain are reclaimed as the chain is
+/// folded instead of accumulating until the end of the pass.
 
 /// A helper function to get a value of a given type from an attribute.
 template <typename T>
@@ -118,23 +116,29 @@ char *getArrayFromAttributeOrBuffer(PatternRewriter &rewriter, Operation *op) {
   assert(constOp && "Not a constant operation");
   char *res = nullptr;
 
+  ConstantBufferPool &pool = getConstantBufferPool();
+  unsigned bufferId;
   Attribute bufferIDAttr = op->getAttrOfType<::mlir::Attribute>(BUFFER_ID_ATTR);
   if (bufferIDAttr) {
-    unsigned bufferId = bufferIDAttr.cast<IntegerAttr>().getUInt();
-    res = bufferPtrs[bufferId];
+    bufferId = bufferIDAttr.cast<IntegerAttr>().getUInt();
+    res = pool.get(bufferId);
   } else {
     DenseElementsAttr dataAttr =
         op->getAttrOfType<::mlir::Attribute>("value")
             .dyn_cast_or_null<mlir::DenseElementsAttr>();
     res = createArrayFromDenseElementsAttr(dataAttr);
-    bufferPtrs.emplace_back(res);
-    unsigned bufferId = bufferPtrs.size() - 1;
+    bufferId = pool.retain(res);
     // Add an attribute to store the buffer id.
     op->setAttr(BUFFER_ID_ATTR,
         IntegerAttr::get(
             rewriter.getIntegerType(/*width=*/64, /*isSigned=*/false),
             bufferId));
   }
+  // A constant whose only use is the operation being folded dies with the
+  // fold; schedule its buffer reference to be dropped once the rewrite has
+  // stored its result.
+  if (op->getResult(0).hasOneUse())
+    pool.markConsumed(bufferId);
   return res;
 }
 
@@ -146,7 +150,7 @@ void getArrayForFinalOutput(Operation *op, char *res) {
   Attribute bufferIDAttr = op->getAttrOfType<::mlir::Attribute>(BUFFER_ID_ATTR);
   if (bufferIDAttr) {
     unsigned bufferId = bufferIDAttr.cast<IntegerAttr>().getUInt();
-    char *resArr = bufferPtrs[bufferId];
+    char *resArr = getConstantBufferPool().get(bufferId);
     convertDoubleInt64ToExactType(constOp.getResult().getType(), resArr, res);
   } else {
     llvm_unreachable("Could not find the input buffer");
@@ -214,24 +218,19 @@ ONNXConstantOp createConstantOpAndStoreBufferPtr(
       replacingValue.getType(), Attribute(), Attribute(), FloatAttr(),
       ArrayAttr(), IntegerAttr(), ArrayAttr(), StringAttr(), ArrayAttr());
 
-  // Store the buffer pointer.
-  unsigned bufferId = (unsigned)-1;
-  for (unsigned i = 0; i < bufferPtrs.size(); ++i) {
-    if (bufferPtrs[i] == vt) {
-      bufferId = i;
-      break;
-    }
-  }
-
-  if (bufferId == (unsigned)-1) {
-    bufferPtrs.emplace_back(vt);
-    bufferId = bufferPtrs.size() - 1;
-  }
+  // Store the buffer pointer. This adds a reference when the new op shares
+  // the buffer of an existing op (e.g. reshape).
+  ConstantBufferPool &pool = getConstantBufferPool();
+  unsigned bufferId = pool.retain(vt);
   // Store the buffer id.
   constOp.getOperation()->setAttr(BUFFER_ID_ATTR,
       IntegerAttr::get(
           rewriter.getIntegerType(/*width=*/64, /*isSigned=*/false), bufferId));
 
+  // The rewrite has finished reading its inputs once its result constant
+  // exists; drop the references of the inputs it consumed.
+  pool.flushConsumed();
+
   return constOp;
 }
 
@@ -274,78 +273,49 @@ T ComputeConstPropElementwiseBinary(T lhs, T rhs) {
 }
 
 template <typename ElementwiseBinaryOp, typename T>
-void IterateConstPropElementwiseBinary(char *lhs, char *rhs,
+void IterateConstPropElementwiseBinary(MLIRContext *ctx, char *lhs, char *rhs,
     ArrayRef<int64_t> lhsShape, ArrayRef<int64_t> rhsShape, char *res,
     ArrayRef<int64_t> outputShape) {
   // Rank info.
-  int lhsRank = lhsShape.size();
-  int rhsRank = rhsShape.size();
   int outputRank = outputShape.size();
-  // Strides info.
-  std::vector<int64_t> outputStrides = getStrides(outputShape);
-  std::vector<int64_t> lhsStrides = getStrides(lhsShape);
-  std::vector<int64_t> rhsStrides = getStrides(rhsShape);
   // Data pointers.
   T *lhsArray = reinterpret_cast<T *>(lhs);
   T *rhsArray = reinterpret_cast<T *>(rhs);
   T *resArray = reinterpret_cast<T *>(res);
 
-  // Check broadcasting.
-  bool broadcasting = false;
-  if (lhsRank != rhsRank)
-    broadcasting = true;
-  else
-    for (int i = 0; i < outputRank; ++i)
-      if (lhsShape[i] != rhsShape[i]) {
-        broadcasting = true;
-        break;
-      }
-
-  // Do computation.
-  for (int64_t i = 0; i < ShapedType::getNumElements(outputShape); ++i) {
-    // Compute indices to access the output.
-    std::vector<int64_t> outputIndices = getAccessIndex(i, outputStrides);
+  int64_t numElements = ShapedType::getNumElements(outputShape);
+
+  // Fast path without broadcasting: all three buffers are scanned linearly,
+  // so the loop vectorizes.
+  if (lhsShape == rhsShape) {
+    IterateConstPropChunks(ctx, numElements, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i)
+        resArray[i] = ComputeConstPropElementwiseBinary<ElementwiseBinaryOp, T>(
+            lhsArray[i], rhsArray[i]);
+    });
+    return;
+  }
 
-    // Compute indices to access inputs.
-    SmallVector<int64_t, 4> lhsIndices(lhsRank, 0);
-    SmallVector<int64_t, 4> rhsIndices(rhsRank, 0);
-    if (!broadcasting) {
-      for (int k = 0; k < outputRank; ++k) {
-        lhsIndices[k] = outputIndices[k];
-        rhsIndices[k] = outputIndices[k];
-      }
-    } else {
+  // Broadcasting: decompose the output's linear index dimension by dimension,
+  // reading each input at its broadcast stride (zero for broadcast
+  // dimensions).
+  std::vector<int64_t> outputStrides = getStrides(outputShape);
+  std::vector<int64_t> lhsStrides = getBroadcastStrides(lhsShape, outputShape);
+  std::vector<int64_t> rhsStrides = getBroadcastStrides(rhsShape, outputShape);
+  IterateConstPropChunks(ctx, numElements, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int64_t lhsOffset = 0, rhsOffset = 0;
+      int64_t remainder = i;
       for (int k = 0; k < outputRank; ++k) {
-        // in the lhs index range.
-        if (k >= outputRank - lhsRank) {
-          int lhsIndex = k - outputRank + lhsRank;
-          if (lhsShape[lhsIndex] == 1)
-            // broadcast
-            lhsIndices[lhsIndex] = 0;
-          else
-            lhsIndices[lhsIndex] = outputIndices[k];
-        }
-        // in the rhs index range.
-        if (k >= outputRank - rhsRank) {
-          int rhsIndex = k - outputRank + rhsRank;
-          if (rhsShape[rhsIndex] == 1)
-            // broadcast
-            rhsIndices[rhsIndex] = 0;
-          else
-            rhsIndices[rhsIndex] = outputIndices[k];
-        }
+        int64_t index = remainder / outputStrides[k];
+        remainder %= outputStrides[k];
+        lhsOffset += index * lhsStrides[k];
+        rhsOffset += index * rhsStrides[k];
       }
+      resArray[i] = ComputeConstPropElementwiseBinary<ElementwiseBinaryOp, T>(
+          lhsArray[lhsOffset], rhsArray[rhsOffset]);
     }
-
-    // Calculate element-wise binary result.
-    int64_t lhsOffset = getLinearAccessIndex(lhsIndices, lhsStrides);
-    int64_t rhsOffset = getLinearAccessIndex(rhsIndices, rhsStrides);
-
-    T lhsValue = *(lhsArray + lhsOffset);
-    T rhsValue = *(rhsArray + rhsOffset);
-    *(resArray + i) = ComputeConstPropElementwiseBinary<ElementwiseBinaryOp, T>(
-        lhsValue, rhsValue);
-  }
+  });
 }
 
 /// Do element-wise binary calculation of 'lhs' and 'rhs' values and create an
@@ -371,11 +341,13 @@ Value ConstPropElementwiseBinary(
   if (elementType.isa<FloatType>()) {
     // Use double to avoid the precision loss during computation.
     IterateConstPropElementwiseBinary<ElementwiseBinaryOp, double>(
-        lhsArray, rhsArray, lhsShape, rhsShape, resArray, outputShape);
+        rewriter.getContext(), lhsArray, rhsArray, lhsShape, rhsShape, resArray,
+        outputShape);
   } else if (elementType.isa<IntegerType>()) {
     // Use int64_t to avoid the precision loss during computation.
     IterateConstPropElementwiseBinary<ElementwiseBinaryOp, int64_t>(
-        lhsArray, rhsArray, lhsShape, rhsShape, resArray, outputShape);
+        rewriter.getContext(), lhsArray, rhsArray, lhsShape, rhsShape, resArray,
+        outputShape);
   } else
     llvm_unreachable("Unknown data type");
 
@@ -421,16 +393,19 @@ T ComputeConstPropElementwiseUnary(T val) {
 
 template <typename ElementwiseUnaryOp, typename T>
 void IterateConstPropElementwiseUnary(
-    char *input, char *res, ArrayRef<int64_t> outputShape) {
+    MLIRContext *ctx, char *input, char *res, ArrayRef<int64_t> outputShape) {
   // Data pointers.
   T *inputArray = reinterpret_cast<T *>(input);
   T *resArray = reinterpret_cast<T *>(res);
 
-  // Calculate element-wise unary result.
-  for (int64_t i = 0; i < ShapedType::getNumElements(outputShape); ++i) {
-    *(resArray + i) = ComputeConstPropElementwiseUnary<ElementwiseUnaryOp, T>(
-        *(inputArray + i));
-  }
+  // Calculate element-wise unary result with a flat loop so that it
+  // vectorizes.
+  int64_t numElements = ShapedType::getNumElements(outputShape);
+  IterateConstPropChunks(ctx, numElements, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i)
+      resArray[i] = ComputeConstPropElementwiseUnary<ElementwiseUnaryOp, T>(
+          inputArray[i]);
+  });
 }
 
 /// Do element-wise unary calculation of 'input' value and create an
@@ -453,11 +428,11 @@ Value ConstPropElementwiseUnary(
   if (elementType.isa<FloatType>()) {
     // Use double to avoid the precision loss during computation.
     IterateConstPropElementwiseUnary<ElementwiseUnaryOp, double>(
-        constArray, resArray, replacingShape);
+        rewriter.getContext(), constArray, resArray, replacingShape);
   } else if (elementType.isa<IntegerType>()) {
     // Use int64_t to avoid the precision loss during computation.
     IterateConstPropElementwiseUnary<ElementwiseUnaryOp, int64_t>(
-        constArray, resArray, replacingShape);
+        rewriter.getContext(), constArray, resArray, replacingShape);
   } else
     llvm_unreachable("Unknown data type");
 
@@ -497,8 +472,8 @@ Value ConstPropTranspose(
   // Use maximum size (double or int64_t) to avoid the precision loss.
   char *resArray =
       allocateBufferFor(replacingValue.getType(), /*useMaxSize=*/true);
-  ConstPropTransposeImpl(
-      elementType, constArray, constShape, perm, replacingShape, resArray);
+  ConstPropTransposeImpl(rewriter.getContext(), elementType, constArray,
+      constShape, perm, replacingShape, resArray);
 
   // Construct a new ONNXConstantOp.
   ONNXConstantOp res =
@@ -590,8 +565,8 @@ LogicalResult ConstPropSplitPatternCommon(Op splitOp, PatternRewriter &rewriter,
 
   // Do splitting.
   std::vector<char *> resBuffers;
-  ConstPropSplitImpl(elementType, inputArray, inputShape, splitAxis,
-      splitOffsets, replacingTypes, resBuffers);
+  ConstPropSplitImpl(rewriter.getContext(), elementType, inputArray,
+      inputShape, splitAxis, splitOffsets, replacingTypes, resBuffers);
 
   // Construct result values.
   std::vector<Value> resValues;
@@ -1097,23 +1072,28 @@ void ConstPropONNXToONNXPass::runOnOperation() {
   // Create DenseElementsAttr and clean up helper attributes.
   function.walk([&](ONNXConstantOp constOp) {
     Operation *op = constOp.getOperation();
-    if (op->getAttrOfType<::mlir::Attribute>(BUFFER_ID_ATTR)) {
+    Attribute bufferIDAttr =
+        op->getAttrOfType<::mlir::Attribute>(BUFFER_ID_ATTR);
+    if (bufferIDAttr) {
+      unsigned bufferId = bufferIDAttr.cast<IntegerAttr>().getUInt();
       ShapedType type = constOp.getResult().getType().cast<ShapedType>();
       char *arr = allocateBufferFor(type, /*useMaxSize=*/false);
       getArrayForFinalOutput(op, arr);
+      // Drop the widened buffer before materializing the dense attribute so
+      // that the two copies of the weight never coexist.
+      op->removeAttr(BUFFER_ID_ATTR);
+      getConstantBufferPool().release(bufferId);
       DenseElementsAttr denseAttr =
           createDenseElementsAttrFromRawBuffer(type, arr);
       op->setAttr("value", denseAttr);
-      op->removeAttr(BUFFER_ID_ATTR);
       free(arr);
     }
   });
 
-  // Remove temporary buffers.
-  for (char *ptr : bufferPtrs) {
-    free(ptr);
-  }
-  bufferPtrs.clear();
+  // Safety net: free the buffers of constants that were erased without being
+  // consumed by a rewrite (e.g. constants whose users were removed as dead
+  // code).
+  getConstantBufferPool().freeAll();
 
 } // end anonymous namespace
 
@@ -17,6 +17,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/IR/Threading.h"
+
 #include "src/Transform/ONNX/ConstPropHelper.hpp"
 #include "src/Dialect/ONNX/ONNXOps/OpHelper.hpp"
 #include "src/Support/TypeUtilities.hpp"
@@ -25,6 +27,26 @@ using namespace mlir;
 
 namespace onnx_mlir {
 
+/// Run 'work(begin, end)' over the range [0, numElements). Large ranges are
+/// split into chunks executed on the context's thread pool when
+/// multi-threading is enabled.
+void IterateConstPropChunks(MLIRContext *ctx, int64_t numElements,
+    llvm::function_ref<void(int64_t, int64_t)> work) {
+  if (!ctx || !ctx->isMultithreadingEnabled() ||
+      numElements < constPropParallelThreshold) {
+    work(0, numElements);
+    return;
+  }
+  int64_t numChunks = ctx->getThreadPool().getThreadCount();
+  int64_t chunkSize = (numElements + numChunks - 1) / numChunks;
+  parallelFor(ctx, 0, numChunks, [&](size_t chunk) {
+    int64_t begin = chunk * chunkSize;
+    int64_t end = std::min(begin + chunkSize, numElements);
+    if (begin < end)
+      work(begin, end);
+  });
+}
+
 /// Get the size of a tensor from its ranked type in bytes, using the largest
 /// precision.
 int64_t getMaxSizeInBytes(Type ty) { return getNumberOfElements(ty) * 8; }
@@ -66,6 +88,22 @@ std::vector<int64_t> getAccessIndex(
   return res;
 }
 
+/// Compute, for each output dimension, the stride at which a (possibly
+/// broadcast) input of shape 'inShape' is read while scanning an output of
+/// shape 'outShape' linearly. Broadcast (size-1 or missing) input dimensions
+/// get a zero stride.
+std::vector<int64_t> getBroadcastStrides(
+    ArrayRef<int64_t> inShape, ArrayRef<int64_t> outShape) {
+  int inRank = inShape.size();
+  int outRank = outShape.size();
+  std::vector<int64_t> inStrides = getStrides(inShape);
+  std::vector<int64_t> res(outRank, 0);
+  for (int k = 0; k < inRank; ++k)
+    if (inShape[k] != 1)
+      res[k + outRank - inRank] = inStrides[k];
+  return res;
+}
+
 /// Allocate a buffer whose size is getting from a given Value's type.
 char *allocateBufferFor(Type type, bool useMaxSize) {
   assert(type.isa<ShapedType>() && "Not a shaped type");
@@ -79,11 +117,98 @@ char *allocateBufferFor(Type type, bool useMaxSize) {
   return res;
 }
 
+char *ConstantBufferPool::get(unsigned bufferId) const {
+  assert(bufferId < slots.size() && "buffer id out of range");
+  assert(slots[bufferId].data && "buffer was already freed");
+  return slots[bufferId].data;
+}
+
+unsigned ConstantBufferPool::retain(char *data) {
+  for (unsigned i = 0; i < slots.size(); ++i) {
+    if (slots[i].data == data) {
+      ++slots[i].refCount;
+      return i;
+    }
+  }
+  slots.emplace_back(Slot{data, 1});
+  return slots.size() - 1;
+}
+
+void ConstantBufferPool::release(unsigned bufferId) {
+  assert(bufferId < slots.size() && "buffer id out of range");
+  Slot &slot = slots[bufferId];
+  assert(slot.refCount > 0 && "releasing a freed buffer");
+  if (--slot.refCount == 0) {
+    free(slot.data);
+    slot.data = nullptr;
+  }
+}
+
+void ConstantBufferPool::markConsumed(unsigned bufferId) {
+  if (!llvm::is_contained(consumed, bufferId))
+    consumed.emplace_back(bufferId);
+}
+
+void ConstantBufferPool::flushConsumed() {
+  for (unsigned bufferId : consumed)
+    release(bufferId);
+  consumed.clear();
+}
+
+void ConstantBufferPool::freeAll() {
+  for (Slot &slot : slots) {
+    if (slot.data)
+      free(slot.data);
+  }
+  slots.clear();
+  consumed.clear();
+}
+
+ConstantBufferPool &getConstantBufferPool() {
+  static ConstantBufferPool pool;
+  return pool;
+}
+
 /// Get a data array from a given ONNXConstantOp.
 char *createArrayFromDenseElementsAttr(DenseElementsAttr dataAttr) {
   Type elementType = getElementType(dataAttr.getType());
   int64_t numElements = getNumberOfElements(dataAttr.getType());
   char *res = allocateBufferFor(dataAttr.getType(), /*useMaxSize=*/true);
+
+  // Fast path: widen directly from the attribute's raw data instead of going
+  // through APFloat/APInt element by element. Not applicable to splat
+  // attributes (a single raw element) and to i1 (bit-packed raw data).
+  if (!dataAttr.isSplat()) {
+    char *rawData = const_cast<char *>(dataAttr.getRawData().data());
+    if (elementType.isF32()) {
+      copyAndCastArr<float, double>(rawData, res, numElements);
+      return res;
+    }
+    if (elementType.isF64()) {
+      copyAndCastArr<double, double>(rawData, res, numElements);
+      return res;
+    }
+    if (IntegerType intType = elementType.dyn_cast<IntegerType>()) {
+      // Sign-extend from the storage width, matching APInt::getSExtValue.
+      switch (intType.getWidth()) {
+      case 8:
+        copyAndCastArr<int8_t, int64_t>(rawData, res, numElements);
+        return res;
+      case 16:
+        copyAndCastArr<int16_t, int64_t>(rawData, res, numElements);
+        return res;
+      case 32:
+        copyAndCastArr<int32_t, int64_t>(rawData, res, numElements);
+        return res;
+      case 64:
+        copyAndCastArr<int64_t, int64_t>(rawData, res, numElements);
+        return res;
+      default:
+        break;
+      }
+    }
+  }
+
   if (elementType.isa<FloatType>()) {
     // Use double to avoid the precision loss during computation.
     double *resArr = (double *)res;
@@ -158,9 +283,10 @@ RankedTensorType constructRankedTensorType(ShapedType type) {
 //===----------------------------------------------------------------------===//
 
 template <typename T>
-void IterateConstPropSplit(char *constArray, ArrayRef<int64_t> constShape,
-    uint64_t splitAxis, ArrayRef<int64_t> splitOffsets,
-    ArrayRef<Type> replacingTypes, std::vector<char *> &resBuffers) {
+void IterateConstPropSplit(MLIRContext *ctx, char *constArray,
+    ArrayRef<int64_t> constShape, uint64_t splitAxis,
+    ArrayRef<int64_t> splitOffsets, ArrayRef<Type> replacingTypes,
+    std::vector<char *> &resBuffers) {
   // Basic info.
   unsigned int rank = constShape.size();
   unsigned int numOfResults = replacingTypes.size();
@@ -170,56 +296,45 @@ void IterateConstPropSplit(char *constArray, ArrayRef<int64_t> constShape,
   // Strides info.
   std::vector<int64_t> constStrides = getStrides(constShape);
 
-  // Allocate temporary buffers.
-  for (unsigned int i = 0; i < numOfResults; ++i) {
+  // Do splitting: gather each result from the input with a flat loop over the
+  // result's elements.
+  for (unsigned int r = 0; r < numOfResults; ++r) {
     // Use maximum size (double or int64_t) to avoid the precision loss.
-    char *resArray = allocateBufferFor(replacingTypes[i], /*useMaxSize=*/true);
+    char *resArray = allocateBufferFor(replacingTypes[r], /*useMaxSize=*/true);
     resBuffers.emplace_back(resArray);
-  }
-
-  // Do splitting
-  for (int64_t i = 0; i < ShapedType::getNumElements(constShape); ++i) {
-    // Input indices.
-    std::vector<int64_t> constIndices = getAccessIndex(i, constStrides);
-
-    // Find the corresponding output and compute access indices.
-    int toResult = numOfResults - 1;
-    SmallVector<int64_t, 4> resIndices(rank, 0);
-    for (unsigned int r = 0; r < rank; ++r) {
-      if (r == splitAxis) {
-        for (int k = 0; k < (int)numOfResults - 1; ++k)
-          if (constIndices[r] >= splitOffsets[k] &&
-              constIndices[r] < splitOffsets[k + 1]) {
-            toResult = k;
-            break;
-          }
-        resIndices[r] = constIndices[r] - splitOffsets[toResult];
-      } else {
-        resIndices[r] = constIndices[r];
+    T *resArrayT = reinterpret_cast<T *>(resArray);
+
+    ArrayRef<int64_t> resShape =
+        replacingTypes[r].cast<ShapedType>().getShape();
+    std::vector<int64_t> resStrides = getStrides(resShape);
+    // A result element maps to the input element whose index along the split
+    // axis is shifted by this result's split offset.
+    int64_t axisShift = splitOffsets[r] * constStrides[splitAxis];
+    int64_t numElements = ShapedType::getNumElements(resShape);
+    IterateConstPropChunks(ctx, numElements, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        int64_t constOffset = axisShift;
+        int64_t remainder = i;
+        for (unsigned int k = 0; k < rank; ++k) {
+          constOffset += (remainder / resStrides[k]) * constStrides[k];
+          remainder %= resStrides[k];
+        }
+        resArrayT[i] = constArrayT[constOffset];
       }
-    }
-
-    // Get linear access indices.
-    std::vector<int64_t> resStrides =
-        getStrides(replacingTypes[toResult].cast<ShapedType>().getShape());
-    int64_t resOffset = getLinearAccessIndex(resIndices, resStrides);
-
-    // Copy data.
-    T *resArrayT = reinterpret_cast<T *>(resBuffers[toResult]);
-    *(resArrayT + resOffset) = *(constArrayT + i);
+    });
   }
 }
 
-void ConstPropSplitImpl(Type elementType, char *constArray,
+void ConstPropSplitImpl(MLIRContext *ctx, Type elementType, char *constArray,
     llvm::ArrayRef<int64_t> constShape, uint64_t splitAxis,
     llvm::ArrayRef<int64_t> splitOffsets,
     llvm::ArrayRef<mlir::Type> replacingTypes,
     std::vector<char *> &resBuffers) {
   if (elementType.isa<FloatType>()) {
-    IterateConstPropSplit<double>(constArray, constShape, splitAxis,
+    IterateConstPropSplit<double>(ctx, constArray, constShape, splitAxis,
         splitOffsets, replacingTypes, resBuffers);
   } else if (elementType.isa<IntegerType>()) {
-    IterateConstPropSplit<int64_t>(constArray, constShape, splitAxis,
+    IterateConstPropSplit<int64_t>(ctx, constArray, constShape, splitAxis,
         splitOffsets, replacingTypes, resBuffers);
   } else
     llvm_unreachable("Unknown data type");
@@ -230,46 +345,52 @@ void ConstPropSplitImpl(Type elementType, char *constArray,
 //===----------------------------------------------------------------------===//
 
 template <typename T>
-void IterateConstPropTranspose(char *constArray, ArrayRef<int64_t> constShape,
-    ArrayRef<uint64_t> perm, ArrayRef<int64_t> resShape, char *resArray) {
+void IterateConstPropTranspose(MLIRContext *ctx, char *constArray,
+    ArrayRef<int64_t> constShape, ArrayRef<uint64_t> perm,
+    ArrayRef<int64_t> resShape, char *resArray) {
   // Data pointers.
   T *constArrayT = reinterpret_cast<T *>(constArray);
   T *resArrayT = reinterpret_cast<T *>(resArray);
 
-  // Get a reversed perm.
-  SmallVector<uint64_t, 4> reversedPerm(perm.size(), 0);
-  for (unsigned int i = 0; i < perm.size(); ++i)
-    reversedPerm[perm[i]] = i;
+  // Basic info.
+  unsigned int rank = perm.size();
 
-  // Strides info.
+  // Strides info. Output dimension k reads input dimension perm[k], so
+  // permuting the input strides lets each output element's input offset be
+  // accumulated directly while decomposing the output's linear index.
   std::vector<int64_t> constStrides = getStrides(constShape);
   std::vector<int64_t> resStrides = getStrides(resShape);
+  SmallVector<int64_t, 4> permConstStrides(rank, 0);
+  for (unsigned int k = 0; k < rank; ++k)
+    permConstStrides[k] = constStrides[perm[k]];
 
   // Calculate transpose result.
-  for (int64_t i = 0; i < ShapedType::getNumElements(resShape); ++i) {
-    // Indices.
-    std::vector<int64_t> resIndices = getAccessIndex(i, resStrides);
-    SmallVector<int64_t, 4> constIndices(perm.size(), 0);
-    for (unsigned int j = 0; j < constIndices.size(); ++j)
-      constIndices[j] = resIndices[reversedPerm[j]];
-    // Transpose.
-    int64_t constOffset = getLinearAccessIndex(constIndices, constStrides);
-    int64_t resOffset = getLinearAccessIndex(resIndices, resStrides);
-    *(resArrayT + resOffset) = *(constArrayT + constOffset);
-  }
+  int64_t numElements = ShapedType::getNumElements(resShape);
+  IterateConstPropChunks(ctx, numElements, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int64_t constOffset = 0;
+      int64_t remainder = i;
+      for (unsigned int k = 0; k < rank; ++k) {
+        constOffset += (remainder / resStrides[k]) * permConstStrides[k];
+        remainder %= resStrides[k];
+      }
+      resArrayT[i] = constArrayT[constOffset];
+    }
+  });
 }
 
-void ConstPropTransposeImpl(Type elementType, char *constArray,
-    llvm::ArrayRef<int64_t> constShape, llvm::ArrayRef<uint64_t> perm,
-    llvm::ArrayRef<int64_t> resShape, char *resArray) {
+void ConstPropTransposeImpl(MLIRContext *ctx, Type elementType,
+    char *constArray, llvm::ArrayRef<int64_t> constShape,
+    llvm::ArrayRef<uint64_t> perm, llvm::ArrayRef<int64_t> resShape,
+    char *resArray) {
   if (elementType.isa<FloatType>()) {
     // Use double to avoid the precision loss during computation.
     IterateConstPropTranspose<double>(
-        constArray, constShape, perm, resShape, resArray);
+        ctx, constArray, constShape, perm, resShape, resArray);
   } else if (elementType.isa<IntegerType>()) {
     // Use int64_t to avoid the precision loss during computation.
     IterateConstPropTranspose<int64_t>(
-        constArray, constShape, perm, resShape, resArray);
+        ctx, constArray, constShape, perm, resShape, resArray);
   } else
     llvm_unreachable("Unknown data type");
 }
@@ -301,4 +422,13 @@ template void copyAndCastArr<int64_t, float>(
 template void copyAndCastArr<int64_t, double>(
     char *srcRawArr, char *destRawArr, int64_t size);
 
+template void copyAndCastArr<float, double>(
+    char *srcRawArr, char *destRawArr, int64_t size);
+template void copyAndCastArr<int8_t, int64_t>(
+    char *srcRawArr, char *destRawArr, int64_t size);
+template void copyAndCastArr<int16_t, int64_t>(
+    char *srcRawArr, char *destRawArr, int64_t size);
+template void copyAndCastArr<int32_t, int64_t>(
+    char *srcRawArr, char *destRawArr, int64_t size);
+
 } // namespace onnx_mlir
\ No newline at end of file
@@ -20,14 +20,27 @@
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 
 #include "src/Dialect/ONNX/ONNXOps.hpp"
 #include "src/Pass/Passes.hpp"
 
 #include <math.h>
+#include <vector>
 
 namespace onnx_mlir {
 
+/// Tensors with at least this many elements have their constant folding loop
+/// split across the context's thread pool.
+constexpr int64_t constPropParallelThreshold = 1 << 16;
+
+/// Run 'work(begin, end)' over the range [0, numElements). Large ranges are
+/// split into chunks executed on the context's thread pool when
+/// multi-threading is enabled; 'work' must thus be safe to run concurrently
+/// on disjoint chunks.
+void IterateConstPropChunks(mlir::MLIRContext *ctx, int64_t numElements,
+    llvm::function_ref<void(int64_t, int64_t)> work);
+
 /// Get the size of a tensor from its ranked type in bytes, using the largest
 /// precision.
 int64_t getMaxSizeInBytes(mlir::Type ty);
@@ -43,6 +56,13 @@ int64_t getLinearAccessIndex(
 std::vector<int64_t> getAccessIndex(
     int64_t linearIndex, llvm::ArrayRef<int64_t> strides);
 
+/// Compute, for each output dimension, the stride at which a (possibly
+/// broadcast) input of shape 'inShape' is read while scanning an output of
+/// shape 'outShape' linearly. Broadcast (size-1 or missing) input dimensions
+/// get a zero stride.
+std::vector<int64_t> getBroadcastStrides(
+    llvm::ArrayRef<int64_t> inShape, llvm::ArrayRef<int64_t> outShape);
+
 /// A helper function to contruct a RankedTensorType from a ShapedType.
 mlir::RankedTensorType constructRankedTensorType(mlir::ShapedType type);
 
@@ -52,6 +72,47 @@ char *allocateBufferFor(mlir::Type type, bool useMaxSize = false);
 /// Get a data array from a given ONNXConstantOp.
 char *createArrayFromDenseElementsAttr(mlir::DenseElementsAttr dataAttr);
 
+/// Reference-counted pool of the raw buffers that back intermediate folded
+/// constants. Each operation that records a buffer id holds one reference on
+/// the corresponding slot; a buffer is freed as soon as its last reference is
+/// dropped instead of living until the end of the pass, so the peak stays at
+/// one live copy per weight even through long folding chains. The pool is
+/// shared infrastructure: any constant transform that materializes raw
+/// buffers can pool them here.
+class ConstantBufferPool {
+public:
+  /// Return the buffer stored under 'bufferId'.
+  char *get(unsigned bufferId) const;
+  /// Record 'data' under a new buffer id with one reference, or add a
+  /// reference to the existing slot when 'data' is already pooled (an
+  /// operation sharing another operation's buffer, e.g. through a reshape).
+  /// Returns the buffer id.
+  unsigned retain(char *data);
+  /// Drop one reference from 'bufferId'; frees the buffer when it was the
+  /// last one.
+  void release(unsigned bufferId);
+  /// Mark 'bufferId' as consumed by the rewrite in progress. Its reference is
+  /// dropped by the next flushConsumed() call, once the rewrite has finished
+  /// reading the buffer.
+  void markConsumed(unsigned bufferId);
+  /// Drop the references of all buffers marked consumed since the last flush.
+  void flushConsumed();
+  /// Free every buffer still alive. Called at the end of a pass as a safety
+  /// net for constants that were erased without being consumed by a rewrite.
+  void freeAll();
+
+private:
+  struct Slot {
+    char *data = nullptr;
+    unsigned refCount = 0;
+  };
+  std::vector<Slot> slots;
+  llvm::SmallVector<unsigned, 4> consumed;
+};
+
+/// The buffer pool shared by the constant transforms of this compilation.
+ConstantBufferPool &getConstantBufferPool();
+
 /// Copy and cast an array of a type to another array of another type.
 /// It simply uses C++ type casting. Users must take care about precision loss.
 template <typename SRC_TYPE, typename DEST_TYPE>
@@ -64,14 +125,15 @@ void convertDoubleInt64ToExactType(
     mlir::Type destType, char *srcRawArr, char *destRawArr);
 
 /// Constant propagation for split.
-void ConstPropSplitImpl(mlir::Type elementType, char *constArray,
-    llvm::ArrayRef<int64_t> constShape, uint64_t splitAxis,
+void ConstPropSplitImpl(mlir::MLIRContext *ctx, mlir::Type elementType,
+    char *constArray, llvm::ArrayRef<int64_t> constShape, uint64_t splitAxis,
     llvm::ArrayRef<int64_t> splitOffsets,
     llvm::ArrayRef<mlir::Type> replacingTypes, std::vector<char *> &resBuffers);
 
 /// Constant propagation for transpose.
-void ConstPropTransposeImpl(mlir::Type elementType, char *constArray,
-    llvm::ArrayRef<int64_t> constShape, llvm::ArrayRef<uint64_t> perm,
-    llvm::ArrayRef<int64_t> resShape, char *resArray);
+void ConstPropTransposeImpl(mlir::MLIRContext *ctx, mlir::Type elementType,
+    char *constArray, llvm::ArrayRef<int64_t> constShape,
+    llvm::ArrayRef<uint64_t> perm, llvm::ArrayRef<int64_t> resShape,
+    char *resArray);
 
 } // namespace onnx_mlir
\ No newline at end of file
@@ -40,6 +40,10 @@ bool ExpressONNXConvOpAsMatmul(ONNXConvOp convOp, bool verbose = 0) {
   Value W = convOp.W();
   Value B = convOp.B();
   bool hasBias = !isFromNone(B);
+  // A recorded fused activation is applied by the Conv lowering; rewriting
+  // the conv into a matmul would silently drop it.
+  if (hasFusedActivation(convOp.getOperation()))
+    return false;
   if (!hasShapeAndRank(X) || !hasShapeAndRank(W))
     return false;
   if (hasBias && !hasShapeAndRank(B))
@@ -244,6 +248,10 @@ void ConvOptONNXToONNXPass::runOnOperation() {
   // These ops will be decomposed into other ONNX ops. Hence, they will not be
   // available after this pass.
   target.addDynamicallyLegalOp<ONNXConvOp>([&](ONNXConvOp op) {
+    // A conv carrying a fused activation must remain a conv; the rewrites
+    // here would drop the recorded activation.
+    if (onnx_mlir::hasFusedActivation(op.getOperation()))
+      return true;
     // Conv op can be converted to a matmul
     bool canBeAMatmul = onnx_mlir::ExpressONNXConvOpAsMatmul(op);
     // Conv op has optimized layout
@@ -257,11 +257,15 @@ struct DecomposeONNXToONNXPass
     : public PassWrapper<DecomposeONNXToONNXPass, OperationPass<func::FuncOp>> {
   MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(DecomposeONNXToONNXPass)
 
-  DecomposeONNXToONNXPass(const std::string &target) { this->target = target; }
+  DecomposeONNXToONNXPass(const std::string &target, int einsumOpBudget) {
+    this->target = target;
+    this->einsumOpBudget = einsumOpBudget;
+  }
   DecomposeONNXToONNXPass(const DecomposeONNXToONNXPass &pass)
       : mlir::PassWrapper<DecomposeONNXToONNXPass,
             OperationPass<func::FuncOp>>() {
     this->target = pass.target;
+    this->einsumOpBudget = pass.einsumOpBudget;
   }
 
   StringRef getArgument() const override { return "decompose-onnx"; }
@@ -274,6 +278,12 @@ struct DecomposeONNXToONNXPass
   Option<std::string> target{*this, "target",
       llvm::cl::desc("Target Dialect to decompose into"), ::llvm::cl::init("")};
 
+  Option<int> einsumOpBudget{*this, "einsum-op-budget",
+      llvm::cl::desc("Keep an Einsum undecomposed when its decomposition is "
+                     "estimated to create more than this many ops "
+                     "(default=0, no limit)."),
+      ::llvm::cl::init(0)};
+
   void runOnOperation() final;
 
   typedef PassWrapper<DecomposeONNXToONNXPass, OperationPass<func::FuncOp>>
@@ -292,7 +302,6 @@ void DecomposeONNXToONNXPass::runOnOperation() {
   target.addIllegalOp<ONNXClipV6Op>();
   target.addIllegalOp<ONNXClipV11Op>();
   target.addIllegalOp<ONNXClipV12Op>();
-  target.addIllegalOp<ONNXEinsumOp>();
   target.addIllegalOp<ONNXLogSoftmaxOp>();
   target.addIllegalOp<ONNXPadV2Op>();
   target.addIllegalOp<ONNXPadV11Op>();
@@ -311,6 +320,23 @@ void DecomposeONNXToONNXPass::runOnOperation() {
   target.addIllegalOp<ONNXUpsampleOp>();
   target.addIllegalOp<ONNXUpsampleV7Op>();
   target.addIllegalOp<ONNXUnsqueezeV11Op>();
+  // An Einsum on high-rank inputs can decompose into thousands of ops. Under
+  // an einsum-op-budget it stays legal (kept unfused) when the estimated
+  // expansion exceeds the budget; by default the expansion is unbounded.
+  int64_t einsumBudget = einsumOpBudget;
+  target.addDynamicallyLegalOp<ONNXEinsumOp>([einsumBudget](ONNXEinsumOp op) {
+    return einsumBudget > 0 &&
+           onnx_mlir::estimateDecomposedEinsumOps(op) > einsumBudget;
+  });
+  if (einsumBudget > 0)
+    function.walk([einsumBudget](ONNXEinsumOp op) {
+      int64_t estimate = onnx_mlir::estimateDecomposedEinsumOps(op);
+      if (estimate > einsumBudget)
+        op.emitWarning()
+            << "decomposition estimated at " << estimate
+            << " ops exceeds einsum-op-budget=" << einsumBudget
+            << "; keeping the op undecomposed";
+    });
   target.addDynamicallyLegalOp<ONNXConcatOp>([](ONNXConcatOp op) {
     ONNXShapeOp shapeOp = NULL;
     ONNXTransposeOp transposeOp = NULL;
@@ -319,7 +345,8 @@ void DecomposeONNXToONNXPass::runOnOperation() {
 
   RewritePatternSet patterns(context);
   populateWithGenerated(patterns);
-  patterns.insert<onnx_mlir::DecomposeEinsumPattern>(&getContext());
+  patterns.insert<onnx_mlir::DecomposeEinsumPattern>(
+      &getContext(), einsumOpBudget);
   patterns.insert<ConcatFusePattern>(&getContext());
 
 #ifdef ONNX_MLIR_ENABLE_MHLO
@@ -341,8 +368,8 @@ namespace onnx_mlir {
  * Create a DecomposeONNX pass.
  */
 std::unique_ptr<mlir::Pass> createDecomposeONNXToONNXPass(
-    const std::string &target) {
-  return std::make_unique<DecomposeONNXToONNXPass>(target);
+    const std::string &target, int einsumOpBudget) {
+  return std::make_unique<DecomposeONNXToONNXPass>(target, einsumOpBudget);
 }
 
 } // namespace onnx_mlir
@@ -14,6 +14,10 @@
 #include "src/Dialect/ONNX/ONNXOps/Math/EinsumHelper.hpp"
 #include "src/Dialect/ONNX/ONNXOps/OpHelper.hpp"
 
+#include "llvm/Support/MathExtras.h"
+
+#include <functional>
+#include <limits>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -455,6 +459,98 @@ public:
     }
   }
 
+  // Picks the sequence of pairwise contractions that minimizes the total
+  // size of the intermediate tensors, with a dynamic program over the
+  // subsets of outputs. All dims are known here (decomposition requires
+  // static shapes), so the size of the tensor contracted from any subset
+  // can be computed without emitting ops: it carries the subscripts of the
+  // subset that still appear outside of it (in another output or in the
+  // result). Returns pairs of positions into the initial outputs vector,
+  // first < second; the contraction of a pair is left in the first
+  // position. Falls back to the left-to-right order when there are too many
+  // outputs for the subset enumeration; contraction order only matters from
+  // 3 outputs onwards.
+  SmallVector<std::pair<unsigned, unsigned>, 4> contractionOrder() const {
+    unsigned n = outputs.size();
+    SmallVector<std::pair<unsigned, unsigned>, 4> order;
+    if (n <= 2 || n > 10) {
+      for (unsigned i = 1; i < n; ++i)
+        order.emplace_back(0, i);
+      return order;
+    }
+    // Dim of each subscript, taking broadcast (dim 1 vs d) into account.
+    std::unordered_map<char, int64_t> dims;
+    for (const Output &output : outputs) {
+      for (size_t a = 0; a < output.size(); ++a) {
+        int64_t &d = dims[output.subscripts[a]];
+        d = std::max(d, output.shape[a]);
+      }
+    }
+    // Sizes in elements are multiplied as doubles to sidestep overflow; the
+    // sizes only steer the choice of order so rounding is harmless.
+    auto size = [&dims](const SubscriptsSet &subscriptsSet) {
+      double numElements = 1;
+      for (char x : subscriptsSet)
+        numElements *= dims.at(x);
+      return numElements;
+    };
+    // Subscripts carried by the tensor contracted from each subset.
+    unsigned full = (1u << n) - 1;
+    std::vector<double> carriedSize(full + 1);
+    for (unsigned mask = 1; mask <= full; ++mask) {
+      SubscriptsSet inside;
+      SubscriptsSet outside(
+          result.subscripts.begin(), result.subscripts.end());
+      for (unsigned i = 0; i < n; ++i) {
+        const Subscripts &subscripts = outputs[i].subscripts;
+        SubscriptsSet &side = (mask & (1u << i)) ? inside : outside;
+        side.insert(subscripts.begin(), subscripts.end());
+      }
+      SubscriptsSet carried;
+      for (char x : inside) {
+        if (outside.count(x) != 0)
+          carried.insert(x);
+      }
+      carriedSize[mask] = size(carried);
+    }
+    // best[mask]: cheapest total intermediate size to contract the subset
+    // into one tensor, with the submask that is contracted first.
+    std::vector<std::pair<double, unsigned>> best(
+        full + 1, {std::numeric_limits<double>::infinity(), 0});
+    for (unsigned i = 0; i < n; ++i)
+      best[1u << i] = {0, 0}; // single output, nothing to contract
+    for (unsigned mask = 1; mask <= full; ++mask) {
+      if ((mask & (mask - 1)) == 0)
+        continue;
+      // Enumerate each unordered split of mask once: sub decreases while its
+      // complement increases, so stop when they cross. On equal costs the
+      // last examined split wins (<=), which recursively reproduces the
+      // plain left-to-right order when the order does not matter.
+      for (unsigned sub = (mask - 1) & mask; sub > (mask ^ sub);
+           sub = (sub - 1) & mask) {
+        double cost =
+            best[sub].first + best[mask ^ sub].first + carriedSize[mask];
+        if (cost <= best[mask].first)
+          best[mask] = {cost, sub};
+      }
+    }
+    // Flatten the contraction tree into pairwise contractions, children
+    // before parents. Each subtree's tensor ends up in its lowest position.
+    std::function<unsigned(unsigned)> flatten =
+        [&](unsigned mask) -> unsigned {
+      if ((mask & (mask - 1)) == 0)
+        return llvm::countTrailingZeros(mask);
+      unsigned fst = flatten(best[mask].second);
+      unsigned snd = flatten(mask ^ best[mask].second);
+      if (fst > snd)
+        std::swap(fst, snd);
+      order.emplace_back(fst, snd);
+      return fst;
+    };
+    flatten(full);
+    return order;
+  }
+
   void finalize() {
     assert(outputs.size() == 1 && "only finalize after all contractions");
     Output &output = outputs[0];
@@ -485,8 +581,18 @@ public:
       reduce(output, keep);
     }
 
-    while (outputs.size() > 1) {
-      contract(outputs[0], outputs[1]);
+    // Positions shift as contracted outputs are removed, so track the
+    // current position of each initial output while walking the order.
+    SmallVector<unsigned, 4> position;
+    for (unsigned i = 0; i < outputs.size(); ++i)
+      position.push_back(i);
+    for (const auto &pair : contractionOrder()) {
+      unsigned pos2 = position[pair.second];
+      contract(outputs[position[pair.first]], outputs[pos2]);
+      for (unsigned &pos : position) {
+        if (pos > pos2)
+          --pos;
+      }
     }
 
     finalize();
@@ -540,6 +646,31 @@ bool isDecomposableElementType(Type elementType) {
 
 } // namespace
 
+int64_t estimateDecomposedEinsumOps(ONNXEinsumOp einsumOp) {
+  ONNXEinsumOpAdaptor operandAdaptor(einsumOp);
+  auto errorFn = [&einsumOp]() { return einsumOp.emitOpError(); };
+  FailureOr<einsum::Signature> signature =
+      einsum::inferSignature(operandAdaptor, errorFn);
+  if (failed(signature))
+    return 0; // invalid equations are rejected by verify(), not by a budget
+  // The counts below overestimate what Decomposer materializes: diagonal()
+  // costs a handful of ops per repeated subscript, reduce() a ReduceSum and
+  // Squeeze (with their constant arguments) per input, and each pairwise
+  // contraction a fixed number of Transpose/Unsqueeze/Reshape ops around one
+  // MatMul or Mul.
+  int64_t estimate = 4; // final Transpose/Reshape into the output layout
+  for (const einsum::Parameter &input : signature->inputs) {
+    std::unordered_set<char> seen;
+    int64_t duplicates = 0;
+    for (char subscript : input.subscripts)
+      if (!seen.insert(subscript).second)
+        duplicates += 1;
+    estimate += 6 * duplicates + 4;
+  }
+  estimate += 16 * ((int64_t)signature->inputs.size() - 1);
+  return estimate;
+}
+
 LogicalResult DecomposeEinsumPattern::matchAndRewrite(
     ONNXEinsumOp einsumOp, PatternRewriter &rewriter) const {
   // verify() checked #inputs > 0 and all have same element type, here we check
@@ -557,6 +688,11 @@ LogicalResult DecomposeEinsumPattern::matchAndRewrite(
           [](Type t) { return t.cast<ShapedType>().hasStaticShape(); }))
     return einsumOp.emitOpError("unknown shapes prevent Einsum decomposition");
 
+  // Under an op budget, leave expensive decompositions unfused; the caller is
+  // responsible for marking such ops legal so partial conversion succeeds.
+  if (opBudget > 0 && estimateDecomposedEinsumOps(einsumOp) > opBudget)
+    return failure();
+
   Location loc = einsumOp.getLoc();
   ONNXEinsumOpAdaptor operandAdaptor(einsumOp);
   auto errorFn = [&einsumOp]() {
@@ -16,13 +16,26 @@
 
 namespace onnx_mlir {
 
+// Coarse upper bound on the number of ops (including the constant tensors
+// feeding Squeeze/Unsqueeze/Reshape) that decomposing einsumOp would create.
+// Lets callers keep an Einsum undecomposed when the expansion would blow an
+// IR-size budget, without materializing the decomposition first.
+int64_t estimateDecomposedEinsumOps(mlir::ONNXEinsumOp einsumOp);
+
 class DecomposeEinsumPattern
     : public mlir::OpRewritePattern<mlir::ONNXEinsumOp> {
 public:
-  using mlir::OpRewritePattern<mlir::ONNXEinsumOp>::OpRewritePattern;
+  // opBudget == 0 means no limit; otherwise matchAndRewrite fails (keeping
+  // the op intact) when estimateDecomposedEinsumOps exceeds the budget.
+  DecomposeEinsumPattern(mlir::MLIRContext *context, int64_t opBudget = 0)
+      : mlir::OpRewritePattern<mlir::ONNXEinsumOp>(context),
+        opBudget(opBudget) {}
 
   mlir::LogicalResult matchAndRewrite(mlir::ONNXEinsumOp einsumOp,
       mlir::PatternRewriter &rewriter) const override;
+
+private:
+  int64_t opBudget;
 };
 
 } // namespace onnx_mlir
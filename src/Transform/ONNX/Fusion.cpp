@@ -0,0 +1,472 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===---------------- Fusion.cpp - ONNX Operator Fusion -------------------===//
+//
+// Copyright 2022 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements the ONNX operator fusion pass. Rewrites that only
+// reorder operations (transpose sinking) are declared in Fusion.td; sinkings
+// that must also rewrite attributes, and fusions that merge a trailing
+// activation or bias Add into the kernel of its producer, are implemented
+// here. An activation is fused by recording it as an attribute
+// (fused_activation, plus fused_activation_alpha or the Clip bounds when
+// applicable) on the producer; the ONNXToKrnl lowering of the producer then
+// applies it on each output scalar right before the final write-back, saving
+// one full pass over the output tensor. A bias Add is fused by moving the
+// bias into the producer's own bias operand (Conv B, Gemm C), which those
+// lowerings likewise add before the final store. A ReduceSum over one result
+// dimension of a MatMul is folded into the MatMul by pre-reducing the
+// matching operand, so the full matmul output is never materialized.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Dialect/ONNX/ONNXOps/OpHelper.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// Include the patterns defined in the Declarative Rewrite framework.
+#include "src/Transform/ONNX/ONNXFusion.inc"
+
+// Map an axis of a transposed tensor back to the corresponding axis of the
+// pre-transpose tensor: dimension i of Transpose(x, perm) is dimension
+// perm[i] of x. A negative axis is first normalized against rank.
+int64_t remapAxisThroughPerm(ArrayAttr permAttr, int64_t axis, int64_t rank) {
+  if (axis < 0)
+    axis += rank;
+  assert(axis >= 0 && axis < rank && "axis out of range");
+  return ArrayAttrIntVal(permAttr, axis);
+}
+
+// Sink a Transpose below a Softmax by remapping the softmax axis through the
+// permutation: Softmax(Transpose(x, p), axis) = Transpose(Softmax(x, p[axis]),
+// p). Unlike the purely elementwise cases in Fusion.td, the axis attribute
+// must be rewritten, so this pattern lives in C++.
+struct SinkTransposeThroughSoftmaxPattern
+    : public OpRewritePattern<ONNXSoftmaxOp> {
+  using OpRewritePattern<ONNXSoftmaxOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXSoftmaxOp softmaxOp, PatternRewriter &rewriter) const final {
+    auto transposeOp = softmaxOp.input().getDefiningOp<ONNXTransposeOp>();
+    if (!transposeOp || !transposeOp.transposed().hasOneUse())
+      return failure();
+    ArrayAttr permAttr = transposeOp.permAttr();
+    Value data = transposeOp.data();
+    if (!permAttr || !hasShapeAndRank(data))
+      return failure();
+    int64_t rank = data.getType().cast<ShapedType>().getRank();
+    int64_t newAxis = remapAxisThroughPerm(permAttr, softmaxOp.axis(), rank);
+    Value newSoftmax = rewriter.create<ONNXSoftmaxOp>(softmaxOp.getLoc(),
+        data.getType(), data,
+        IntegerAttr::get(
+            rewriter.getIntegerType(64, /*isSigned=*/true), newAxis));
+    rewriter.replaceOpWithNewOp<ONNXTransposeOp>(
+        softmaxOp, softmaxOp.output().getType(), newSoftmax, permAttr);
+    return success();
+  }
+};
+
+// Sink transposes below a Concat when every input is transposed with the same
+// permutation: concatenating first and transposing once replaces one
+// transpose per input. The concat axis is remapped through the permutation
+// and the intermediate result type is the permuted output type.
+struct SinkTransposeThroughConcatPattern
+    : public OpRewritePattern<ONNXConcatOp> {
+  using OpRewritePattern<ONNXConcatOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXConcatOp concatOp, PatternRewriter &rewriter) const final {
+    ArrayAttr permAttr = nullptr;
+    SmallVector<Value, 4> newInputs;
+    for (Value input : concatOp.inputs()) {
+      auto transposeOp = input.getDefiningOp<ONNXTransposeOp>();
+      if (!transposeOp || !input.hasOneUse() || !transposeOp.permAttr())
+        return failure();
+      // Permutation attributes are uniqued, so pointer equality suffices.
+      if (!permAttr)
+        permAttr = transposeOp.permAttr();
+      else if (permAttr != transposeOp.permAttr())
+        return failure();
+      newInputs.emplace_back(transposeOp.data());
+    }
+    auto outputType =
+        concatOp.concat_result().getType().dyn_cast<RankedTensorType>();
+    if (!permAttr || !outputType)
+      return failure();
+    int64_t rank = outputType.getRank();
+    int64_t newAxis = remapAxisThroughPerm(permAttr, concatOp.axis(), rank);
+    // Dimension i of the transposed output is dimension perm[i] of the
+    // pre-transpose concatenation.
+    SmallVector<int64_t, 4> newShape(rank);
+    for (int64_t i = 0; i < rank; ++i)
+      newShape[ArrayAttrIntVal(permAttr, i)] = outputType.getShape()[i];
+    Value newConcat = rewriter.create<ONNXConcatOp>(concatOp.getLoc(),
+        RankedTensorType::get(newShape, outputType.getElementType()),
+        newInputs,
+        IntegerAttr::get(
+            rewriter.getIntegerType(64, /*isSigned=*/true), newAxis));
+    rewriter.replaceOpWithNewOp<ONNXTransposeOp>(
+        concatOp, outputType, newConcat, permAttr);
+    return success();
+  }
+};
+
+// Producers whose ONNXToKrnl lowerings honor a recorded activation in their
+// final write-back. Extending activation fusion to another producer means
+// listing it here and calling applyFusedActivation in every write-back of its
+// lowering; a producer that silently ignores the attribute would compute
+// wrong results.
+bool canFuseActivation(Operation *producer) {
+  return isa<ONNXConvOp, ONNXGemmOp>(producer);
+}
+
+// Fold an activation whose sole input is a fusible producer into the producer
+// by recording it as a fused_activation attribute. The isProfitable hook lets
+// a derived pattern veto a structurally valid fusion; the default accepts
+// always, as applying the activation during the producer's write-back is
+// never slower than a separate pass over the output tensor.
+template <typename ActivationOp>
+struct FuseActivationPattern : public OpRewritePattern<ActivationOp> {
+  using OpRewritePattern<ActivationOp>::OpRewritePattern;
+
+  virtual bool isProfitable(ActivationOp actOp, Operation *producer) const {
+    return true;
+  }
+
+  LogicalResult matchAndRewrite(
+      ActivationOp actOp, PatternRewriter &rewriter) const final {
+    Value input = actOp.getOperation()->getOperand(0);
+    Operation *producer = input.getDefiningOp();
+    if (!producer || !canFuseActivation(producer))
+      return failure();
+    // The producer result must feed the activation exclusively, and at most
+    // one activation can be recorded.
+    if (!input.hasOneUse() || hasFusedActivation(producer))
+      return failure();
+    // Elementwise activations preserve the type; bail on a mismatch (e.g.
+    // when shape inference has not yet propagated through the activation).
+    if (actOp.getOperation()->getResult(0).getType() != input.getType())
+      return failure();
+    if (!isProfitable(actOp, producer))
+      return failure();
+    // Record the activation under its ONNX name, e.g. onnx.Relu as "Relu".
+    StringRef opName = ActivationOp::getOperationName();
+    opName.consume_front("onnx.");
+    producer->setAttr(FUSED_ACTIVATION_ATTR, rewriter.getStringAttr(opName));
+    if (auto alphaAttr =
+            actOp.getOperation()->getAttrOfType<FloatAttr>("alpha"))
+      producer->setAttr(FUSED_ACTIVATION_ALPHA_ATTR, alphaAttr);
+    rewriter.replaceOp(actOp, input);
+    return success();
+  }
+};
+
+// Return true and set value when v is a constant holding a single float
+// scalar, the only shape of bound a producer epilogue can bake in.
+bool getScalarFloatConstant(Value v, double &value) {
+  ONNXConstantOp constOp = getONNXConstantOp(v);
+  if (!constOp)
+    return false;
+  ElementsAttr elements =
+      constOp.valueAttr().dyn_cast_or_null<DenseElementsAttr>();
+  if (!elements || elements.getNumElements() != 1 ||
+      !(elements.getElementType().isF32() || elements.getElementType().isF64()))
+    return false;
+  value = getScalarValue<double>(constOp, constOp.getResult().getType());
+  return true;
+}
+
+// A Clip is a clipped activation: record its bounds on the producer so the
+// lowering clamps in the register tile before the final store. Clip carries
+// its bounds as operands, so this cannot reuse FuseActivationPattern: each
+// bound must be absent or a scalar float constant to become an attribute.
+struct FuseClipPattern : public OpRewritePattern<ONNXClipOp> {
+  using OpRewritePattern<ONNXClipOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXClipOp clipOp, PatternRewriter &rewriter) const final {
+    Value input = clipOp.input();
+    Operation *producer = input.getDefiningOp();
+    if (!producer || !canFuseActivation(producer))
+      return failure();
+    if (!input.hasOneUse() || hasFusedActivation(producer))
+      return failure();
+    if (clipOp.getOperation()->getResult(0).getType() != input.getType())
+      return failure();
+    double minVal = 0, maxVal = 0;
+    bool hasMin = !isFromNone(clipOp.min());
+    bool hasMax = !isFromNone(clipOp.max());
+    if ((hasMin && !getScalarFloatConstant(clipOp.min(), minVal)) ||
+        (hasMax && !getScalarFloatConstant(clipOp.max(), maxVal)))
+      return failure();
+    producer->setAttr(FUSED_ACTIVATION_ATTR, rewriter.getStringAttr("Clip"));
+    if (hasMin)
+      producer->setAttr(
+          FUSED_ACTIVATION_MIN_ATTR, rewriter.getF32FloatAttr(minVal));
+    if (hasMax)
+      producer->setAttr(
+          FUSED_ACTIVATION_MAX_ATTR, rewriter.getF32FloatAttr(maxVal));
+    rewriter.replaceOp(clipOp, input);
+    return success();
+  }
+};
+
+// Fold Add(Conv(x, w), bias) into the Conv bias operand when bias is a
+// per-channel constant. The Conv lowering already adds its B operand right
+// before the final store, so the trailing Add's full round trip over the
+// output tensor disappears. A Conv that already carries a recorded
+// activation is skipped: the bias must apply before the activation, and the
+// lowering adds B first only when the activation is recorded afterwards.
+struct FuseConvBiasPattern : public OpRewritePattern<ONNXAddOp> {
+  using OpRewritePattern<ONNXAddOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXAddOp addOp, PatternRewriter &rewriter) const final {
+    // Add is commutative; look for the Conv on either side.
+    for (int convIdx = 0; convIdx < 2; ++convIdx) {
+      Value convVal = addOp.getOperation()->getOperand(convIdx);
+      Value biasVal = addOp.getOperation()->getOperand(1 - convIdx);
+      auto convOp = convVal.getDefiningOp<ONNXConvOp>();
+      if (!convOp || !convVal.hasOneUse() || !isFromNone(convOp.B()) ||
+          hasFusedActivation(convOp))
+        continue;
+      // The Add must not broadcast the Conv output up to a larger shape.
+      if (addOp.getOperation()->getResult(0).getType() != convVal.getType())
+        continue;
+      auto outputType = convVal.getType().dyn_cast<RankedTensorType>();
+      if (!outputType || outputType.getRank() < 2 ||
+          outputType.isDynamicDim(1))
+        continue;
+      int64_t channels = outputType.getDimSize(1);
+      auto biasType = biasVal.getType().dyn_cast<RankedTensorType>();
+      if (!biasType || !biasType.hasStaticShape() ||
+          biasType.getNumElements() != channels ||
+          biasType.getRank() > outputType.getRank())
+        continue;
+      // Right-aligned broadcast of the bias may only expand along the
+      // channel axis (axis 1 of the Conv output).
+      int64_t outRank = outputType.getRank();
+      int64_t biasRank = biasType.getRank();
+      bool perChannel = true;
+      for (int64_t i = 0; i < biasRank; ++i)
+        if (biasType.getDimSize(i) != 1 && outRank - biasRank + i != 1)
+          perChannel = false;
+      if (!perChannel || !isDenseONNXConstant(biasVal))
+        continue;
+      // Conv expects a 1-D bias of one element per output channel.
+      ONNXConstantOp constOp = getONNXConstantOp(biasVal);
+      DenseElementsAttr reshaped =
+          constOp.valueAttr().cast<DenseElementsAttr>().reshape(
+              RankedTensorType::get({channels}, biasType.getElementType()));
+      Value newBias = createONNXConstantOpWithDenseAttr(
+          rewriter, addOp.getLoc(), reshaped);
+      Operation *newConv = rewriter.clone(*convOp.getOperation());
+      newConv->setOperand(2, newBias);
+      rewriter.replaceOp(addOp, newConv->getResult(0));
+      return success();
+    }
+    return failure();
+  }
+};
+
+// Fold Add(Gemm(a, b), bias) into the Gemm C operand when Gemm carries none.
+// Gemm's unidirectional broadcast of C covers exactly the biases a trailing
+// Add can apply without changing the result shape, and the lowering adds
+// beta*C in the register tile, so unlike the Conv case the bias needs no
+// reshape and may even be a runtime value. beta is forced to 1 since the
+// folded bias replaces an absent C.
+struct FuseGemmBiasPattern : public OpRewritePattern<ONNXAddOp> {
+  using OpRewritePattern<ONNXAddOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXAddOp addOp, PatternRewriter &rewriter) const final {
+    for (int gemmIdx = 0; gemmIdx < 2; ++gemmIdx) {
+      Value gemmVal = addOp.getOperation()->getOperand(gemmIdx);
+      Value biasVal = addOp.getOperation()->getOperand(1 - gemmIdx);
+      auto gemmOp = gemmVal.getDefiningOp<ONNXGemmOp>();
+      if (!gemmOp || !gemmVal.hasOneUse() || !isFromNone(gemmOp.C()) ||
+          hasFusedActivation(gemmOp))
+        continue;
+      if (addOp.getOperation()->getResult(0).getType() != gemmVal.getType())
+        continue;
+      auto outputType = gemmVal.getType().dyn_cast<RankedTensorType>();
+      auto biasType = biasVal.getType().dyn_cast<RankedTensorType>();
+      if (!outputType || !biasType || !biasType.hasStaticShape() ||
+          biasType.getRank() > outputType.getRank())
+        continue;
+      // Unidirectional broadcast to (M, N): every right-aligned bias dim is
+      // 1 or matches the (static) output dim.
+      int64_t outRank = outputType.getRank();
+      int64_t biasRank = biasType.getRank();
+      bool broadcastable = true;
+      for (int64_t i = 0; i < biasRank; ++i) {
+        int64_t dim = biasType.getDimSize(i);
+        if (dim != 1 && dim != outputType.getDimSize(outRank - biasRank + i))
+          broadcastable = false;
+      }
+      if (!broadcastable)
+        continue;
+      Operation *newGemm = rewriter.clone(*gemmOp.getOperation());
+      newGemm->setOperand(2, biasVal);
+      newGemm->setAttr("beta", rewriter.getF32FloatAttr(1.0));
+      rewriter.replaceOp(addOp, newGemm->getResult(0));
+      return success();
+    }
+    return failure();
+  }
+};
+
+// Rewrite ReduceSum(MatMul(A, B)) over one result dimension by reducing the
+// matching operand before the MatMul: summing the columns of A x B gives
+// A x rowsum(B) and summing the rows gives colsum(A) x B. The full M x N
+// matmul output, which exists only to be reduced away, is never
+// materialized; in its place the reduced operand is a single row or column.
+// Summation order changes, as it does for every reassociating rewrite here.
+LogicalResult fuseMatMulReduceSum(Operation *reduceOp, ONNXMatMulOp matMulOp,
+    int64_t axis, bool keepDims, PatternRewriter &rewriter) {
+  Value A = matMulOp.A();
+  Value B = matMulOp.B();
+  // Restrict to plain 2-D matmuls; the batched forms would need the reduce
+  // axis disentangled from broadcast batch dimensions.
+  if (!hasShapeAndRank(A) || !hasShapeAndRank(B))
+    return failure();
+  auto aType = A.getType().cast<RankedTensorType>();
+  auto bType = B.getType().cast<RankedTensorType>();
+  if (aType.getRank() != 2 || bType.getRank() != 2)
+    return failure();
+  if (axis < 0)
+    axis += 2;
+  if (axis != 0 && axis != 1)
+    return failure();
+
+  Location loc = reduceOp->getLoc();
+  Type elementType = aType.getElementType();
+  IntegerAttr keepDimsAttr =
+      IntegerAttr::get(rewriter.getIntegerType(64, /*isSigned=*/true), 1);
+
+  // Reduce the operand whose free dimension is summed away, keeping the
+  // reduced dimension so the operand stays rank 2 for the MatMul.
+  Value newA = A, newB = B;
+  SmallVector<int64_t, 2> matMulShape;
+  if (axis == 1) {
+    // sum_n (A x B)[m, n] = (A x rowsum(B))[m, 0].
+    auto reducedBType = RankedTensorType::get(
+        {bType.getShape()[0], 1}, elementType);
+    newB = rewriter.create<ONNXReduceSumV11Op>(
+        loc, reducedBType, B, rewriter.getI64ArrayAttr({1}), keepDimsAttr);
+    matMulShape = {aType.getShape()[0], 1};
+  } else {
+    // sum_m (A x B)[m, n] = (colsum(A) x B)[0, n].
+    auto reducedAType = RankedTensorType::get(
+        {1, aType.getShape()[1]}, elementType);
+    newA = rewriter.create<ONNXReduceSumV11Op>(
+        loc, reducedAType, A, rewriter.getI64ArrayAttr({0}), keepDimsAttr);
+    matMulShape = {1, bType.getShape()[1]};
+  }
+  Value newMatMul = rewriter.create<ONNXMatMulOp>(
+      loc, RankedTensorType::get(matMulShape, elementType), newA, newB);
+
+  // With keepdims the new matmul already has the reduced shape; without it
+  // the kept unit dimension must be squeezed away.
+  Value result = newMatMul;
+  if (!keepDims)
+    result = rewriter.create<ONNXSqueezeV11Op>(loc,
+        reduceOp->getResult(0).getType(), newMatMul,
+        rewriter.getI64ArrayAttr({axis}));
+  rewriter.replaceOp(reduceOp, result);
+  return success();
+}
+
+// ReduceSum up to opset 11 carries its axes as an attribute.
+struct FuseMatMulReduceSumV11Pattern
+    : public OpRewritePattern<ONNXReduceSumV11Op> {
+  using OpRewritePattern<ONNXReduceSumV11Op>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXReduceSumV11Op reduceOp, PatternRewriter &rewriter) const final {
+    auto matMulOp = reduceOp.data().getDefiningOp<ONNXMatMulOp>();
+    if (!matMulOp || !reduceOp.data().hasOneUse())
+      return failure();
+    ArrayAttr axesAttr = reduceOp.axesAttr();
+    if (!axesAttr || axesAttr.size() != 1)
+      return failure();
+    return fuseMatMulReduceSum(reduceOp, matMulOp,
+        ArrayAttrIntVal(axesAttr, 0), reduceOp.keepdims() != 0, rewriter);
+  }
+};
+
+// ReduceSum from opset 13 carries its axes as an operand, which must be a
+// constant holding a single axis for the rewrite to apply.
+struct FuseMatMulReduceSumPattern : public OpRewritePattern<ONNXReduceSumOp> {
+  using OpRewritePattern<ONNXReduceSumOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXReduceSumOp reduceOp, PatternRewriter &rewriter) const final {
+    auto matMulOp = reduceOp.data().getDefiningOp<ONNXMatMulOp>();
+    if (!matMulOp || !reduceOp.data().hasOneUse())
+      return failure();
+    DenseElementsAttr axesAttr =
+        getDenseElementAttributeFromONNXValue(reduceOp.axes());
+    if (!axesAttr || axesAttr.getNumElements() != 1)
+      return failure();
+    int64_t axis = (*axesAttr.getValues<APInt>().begin()).getSExtValue();
+    return fuseMatMulReduceSum(
+        reduceOp, matMulOp, axis, reduceOp.keepdims() != 0, rewriter);
+  }
+};
+
+struct FusionONNXToONNXPass
+    : public PassWrapper<FusionONNXToONNXPass, OperationPass<func::FuncOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(FusionONNXToONNXPass)
+
+  StringRef getArgument() const override { return "fusion-onnx"; }
+
+  StringRef getDescription() const override {
+    return "Fuse ONNX operations so they lower to combined kernels.";
+  }
+
+  void runOnOperation() final;
+};
+
+void FusionONNXToONNXPass::runOnOperation() {
+  func::FuncOp function = getOperation();
+  MLIRContext *context = &getContext();
+
+  RewritePatternSet patterns(context);
+  populateWithGenerated(patterns);
+  patterns.insert<FuseActivationPattern<ONNXReluOp>,
+      FuseActivationPattern<ONNXLeakyReluOp>, FuseClipPattern,
+      FuseConvBiasPattern, FuseGemmBiasPattern, FuseMatMulReduceSumPattern,
+      FuseMatMulReduceSumV11Pattern, SinkTransposeThroughSoftmaxPattern,
+      SinkTransposeThroughConcatPattern>(context);
+
+  if (failed(applyPatternsAndFoldGreedily(function, std::move(patterns))))
+    signalPassFailure();
+}
+
+} // namespace
+
+namespace onnx_mlir {
+
+/*!
+ * Create an ONNX operator fusion pass.
+ */
+std::unique_ptr<mlir::Pass> createFusionONNXToONNXPass() {
+  return std::make_unique<FusionONNXToONNXPass>();
+}
+
+} // namespace onnx_mlir
@@ -13,9 +13,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/IR/OperationSupport.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/Passes.h"
-#include "llvm/Support/raw_sha1_ostream.h"
 
 #include "src/Dialect/ONNX/ONNXOps.hpp"
 #include "src/Pass/Passes.hpp"
@@ -46,64 +46,144 @@ struct ONNXOpTransformPass : public mlir::PassWrapper<ONNXOpTransformPass,
       "onnx-op-transform-simd-data-layout",
       llvm::cl::desc("Enable SIMD data layout opt in op transform passes."),
       llvm::cl::init(false)};
+  Option<int64_t> onnxOpTransformMaxOps{*this, "onnx-op-transform-max-ops",
+      llvm::cl::desc("Stop iterating when the module grows beyond this many "
+                     "operations (default=0, no limit)."),
+      llvm::cl::init(0)};
 
   ONNXOpTransformPass() = default;
   ONNXOpTransformPass(const ONNXOpTransformPass &pass)
       : mlir::PassWrapper<ONNXOpTransformPass,
             OperationPass<mlir::ModuleOp>>() {}
   ONNXOpTransformPass(int threshold, bool report, bool targetCPU,
-      bool enableSimdDataLayoutOpt) {
+      bool enableSimdDataLayoutOpt, int64_t maxModuleOps) {
     this->onnxOpTransformThreshold = threshold;
     this->onnxOpTransformReport = report;
     this->onnxOpTransformTargetCPU = targetCPU;
     this->onnxOpTransformEnableSimdDataLayout = enableSimdDataLayoutOpt;
+    this->onnxOpTransformMaxOps = maxModuleOps;
   }
 
   void runOnOperation() final;
 
 private:
-  uint64_t createTagForIR(mlir::ModuleOp module) {
-    // NOTE: This is slow for real models because they contain large
-    // constant tensors that are expensive to print. A workaround is to
-    // elide them from printing with --mlir-elide-elementsattrs-if-larger=1
-    //
-    // TODO: Hash without printing to speed this up, e.g. along the lines of
-    // how blocks are hashed in mlir/lib/Transforms/Utils/RegionUtils.cpp
-    llvm::raw_sha1_ostream sha1_ostream;
-    module->print(sha1_ostream, mlir::OpPrintingFlags());
-    std::array<uint8_t, 20> sha1 = sha1_ostream.sha1();
-    return *reinterpret_cast<uint64_t *>(sha1.data());
+  // One fingerprint per function of the module, keyed by the function
+  // operation.
+  using ModuleTags = llvm::DenseMap<Operation *, std::array<uint8_t, 20>>;
+
+  // Fingerprint every function structurally, from the uniqued pointers of
+  // each operation's name, attributes, types, and operands. Unlike printing
+  // the module into a hashing stream, this never materializes the large
+  // constant tensors, so a tag is cheap even on big models, and per-function
+  // tags additionally tell which functions an iteration left untouched.
+  static ModuleTags createTagsForIR(mlir::ModuleOp module) {
+    ModuleTags tags;
+    for (auto funcOp : module.getOps<func::FuncOp>())
+      tags.try_emplace(
+          funcOp.getOperation(), OperationFingerprint(funcOp).hash);
+    return tags;
+  }
+
+  // Run a function-anchored pipeline on each of the given functions.
+  LogicalResult runOnFunctions(
+      OpPassManager &pipeline, llvm::ArrayRef<func::FuncOp> funcs) {
+    for (func::FuncOp funcOp : funcs)
+      if (failed(runPipeline(pipeline, funcOp)))
+        return failure();
+    return success();
   }
 };
 
 void ONNXOpTransformPass::runOnOperation() {
   auto module = getOperation();
 
-  uint64_t currentTag = createTagForIR(module);
-  uint64_t previousTag;
+  ModuleTags previousTags = createTagsForIR(module);
+  // Functions visited by the function-scoped passes of the next iteration:
+  // everything qualifies for the first one, afterwards only the functions
+  // whose fingerprint the previous iteration changed.
+  llvm::SmallPtrSet<Operation *, 8> changedFuncs;
+  for (const auto &entry : previousTags)
+    changedFuncs.insert(entry.first);
+
+  // Budget watchdog: stop iterating as soon as a stage has grown the module
+  // past onnx-op-transform-max-ops, naming the offending stage. Decomposition
+  // in particular can explode on some models (e.g. Einsum on high-rank
+  // inputs), and without a bound the fixed-point iteration keeps feeding the
+  // blown-up IR back through every stage.
+  auto exceedsOpBudget = [&](llvm::StringRef stage) {
+    if (onnxOpTransformMaxOps <= 0)
+      return false;
+    int64_t numOps = 0;
+    module->walk([&numOps](Operation *) { numOps++; });
+    if (numOps <= onnxOpTransformMaxOps)
+      return false;
+    module->emitWarning()
+        << "stopping onnx-op-transform early: " << numOps << " ops after "
+        << stage << " exceed onnx-op-transform-max-ops="
+        << onnxOpTransformMaxOps.getValue();
+    return true;
+  };
+
   int n = onnxOpTransformThreshold;
+  bool converged = false;
+  bool budgetExceeded = false;
   do {
-    previousTag = currentTag;
-    OpPassManager dynamicPM("builtin.module");
-    dynamicPM.addNestedPass<func::FuncOp>(
-        onnx_mlir::createDecomposeONNXToONNXPass());
-    dynamicPM.addPass(onnx_mlir::createShapeInferencePass());
-    dynamicPM.addPass(mlir::createCanonicalizerPass());
-    dynamicPM.addPass(onnx_mlir::createShapeInferencePass());
+    llvm::SmallVector<func::FuncOp, 4> funcs;
+    for (auto funcOp : module.getOps<func::FuncOp>())
+      if (changedFuncs.count(funcOp.getOperation()))
+        funcs.push_back(funcOp);
+
+    OpPassManager decomposePM("func.func");
+    decomposePM.addPass(onnx_mlir::createDecomposeONNXToONNXPass());
+    OpPassManager canonicalizePM("func.func");
+    canonicalizePM.addPass(mlir::createCanonicalizerPass());
+    OpPassManager constPropPM("func.func");
+    constPropPM.addPass(onnx_mlir::createConstPropONNXToONNXPass());
+    OpPassManager shapeInferencePM("builtin.module");
+    shapeInferencePM.addPass(onnx_mlir::createShapeInferencePass());
+
+    // Same sequence as the former combined pipeline, with the function
+    // passes narrowed to the changed functions. Shape inference stays
+    // module-wide because a changed function can refine the shapes flowing
+    // into its callers; a function it touches as a result joins the next
+    // iteration's changed set through its fingerprint.
+    if (failed(runOnFunctions(decomposePM, funcs)) ||
+        failed(runPipeline(shapeInferencePM, module)))
+      return signalPassFailure();
+    if ((budgetExceeded = exceedsOpBudget("decompose-onnx")))
+      break;
+    if (failed(runOnFunctions(canonicalizePM, funcs)) ||
+        failed(runPipeline(shapeInferencePM, module)))
+      return signalPassFailure();
+    if ((budgetExceeded = exceedsOpBudget("canonicalize")))
+      break;
     // Convolution Optimization currently only for CPU.
     if (onnxOpTransformTargetCPU) {
-      dynamicPM.addNestedPass<func::FuncOp>(
-          onnx_mlir::createConvOptONNXToONNXPass(
-              onnxOpTransformEnableSimdDataLayout));
-      dynamicPM.addPass(onnx_mlir::createShapeInferencePass());
+      OpPassManager convOptPM("func.func");
+      convOptPM.addPass(onnx_mlir::createConvOptONNXToONNXPass(
+          onnxOpTransformEnableSimdDataLayout));
+      if (failed(runOnFunctions(convOptPM, funcs)) ||
+          failed(runPipeline(shapeInferencePM, module)))
+        return signalPassFailure();
+      if ((budgetExceeded = exceedsOpBudget("conv-opt-onnx")))
+        break;
     }
-    dynamicPM.addNestedPass<func::FuncOp>(
-        onnx_mlir::createConstPropONNXToONNXPass());
-    if (failed(runPipeline(dynamicPM, module)))
+    if (failed(runOnFunctions(constPropPM, funcs)))
       return signalPassFailure();
-    currentTag = createTagForIR(module);
-  } while (currentTag != previousTag && --n > 0);
-  if (currentTag != previousTag) {
+    if ((budgetExceeded = exceedsOpBudget("constprop-onnx")))
+      break;
+
+    ModuleTags currentTags = createTagsForIR(module);
+    changedFuncs.clear();
+    for (const auto &entry : currentTags) {
+      auto previous = previousTags.find(entry.first);
+      if (previous == previousTags.end() || previous->second != entry.second)
+        changedFuncs.insert(entry.first);
+    }
+    converged = changedFuncs.empty();
+    previousTags = std::move(currentTags);
+  } while (!converged && --n > 0);
+  if (!converged && !budgetExceeded) {
     module->emitWarning()
         << "ONNXOpTransform did not converge after " << onnxOpTransformThreshold
         << "iterations. "
@@ -111,8 +191,8 @@ void ONNXOpTransformPass::runOnOperation() {
   }
   if (onnxOpTransformReport) {
     llvm::outs() << "ONNXOpTransform iterated " << onnxOpTransformThreshold - n
-                 << " times, converged "
-                 << ((currentTag == previousTag) ? "true" : "false") << "\n";
+                 << " times, converged " << (converged ? "true" : "false")
+                 << "\n";
   }
 }
 
@@ -125,8 +205,9 @@ std::unique_ptr<mlir::Pass> onnx_mlir::createONNXOpTransformPass() {
   return std::make_unique<ONNXOpTransformPass>();
 }
 
-std::unique_ptr<mlir::Pass> onnx_mlir::createONNXOpTransformPass(
-    int threshold, bool report, bool targetCPU, bool enableSimdDataLayoutOpt) {
+std::unique_ptr<mlir::Pass> onnx_mlir::createONNXOpTransformPass(int threshold,
+    bool report, bool targetCPU, bool enableSimdDataLayoutOpt,
+    int64_t maxModuleOps) {
   return std::make_unique<ONNXOpTransformPass>(
-      threshold, report, targetCPU, enableSimdDataLayoutOpt);
+      threshold, report, targetCPU, enableSimdDataLayoutOpt, maxModuleOps);
 }
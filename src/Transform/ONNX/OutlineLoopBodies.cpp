@@ -0,0 +1,240 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===---- OutlineLoopBodies.cpp - Outline ONNX Loop/Scan bodies -----------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements a pass that outlines the bodies of ONNX Loop and Scan
+// operations into module-level functions shared between structurally
+// identical bodies. Graphs exported with repeated layer stacks contain the
+// same body many times; lowering each copy inline duplicates the generated
+// code, which inflates compile time and pushes hot loop bodies out of the
+// instruction cache. A shared function is only created when at least two
+// operations can use it, and body outputs that are block-argument
+// pass-throughs stay in place so the Loop lowering can still recognize a
+// loop-invariant condition and elide copies of unchanged carried values.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/RegionUtils.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace {
+
+// A Loop or Scan operation whose body is worth outlining, together with the
+// values its body uses from enclosing scopes.
+struct OutlineCandidate {
+  Operation *op;
+  SmallVector<Value, 4> captures;
+  // Structural fingerprint of the body; bodies with the same fingerprint can
+  // share one outlined function.
+  std::string fingerprint;
+  // Normalized clone of the body. The clone of the first candidate with a
+  // given fingerprint becomes the shared function; the others are discarded.
+  func::FuncOp clonedFunc;
+  // Set when the candidate belongs to a group that is actually outlined.
+  func::FuncOp sharedFunc;
+};
+
+// Decide whether a value returned by the body is a pass-through of one of
+// the body's own block arguments.
+bool isBodyArgument(Value v, Block &bodyBlock) {
+  return v.isa<BlockArgument>() &&
+         v.cast<BlockArgument>().getOwner() == &bodyBlock;
+}
+
+// Clone the body of `op` into a private module-level function. The body
+// block arguments and the captured values become function arguments, in
+// that order; the function returns the body outputs that are not
+// block-argument pass-throughs.
+func::FuncOp cloneBodyIntoFunction(
+    ModuleOp module, Operation *op, ArrayRef<Value> captures) {
+  Block &bodyBlock = op->getRegion(0).front();
+  Operation *terminator = bodyBlock.getTerminator();
+  Location loc = op->getLoc();
+
+  SmallVector<Type, 4> argTypes(bodyBlock.getArgumentTypes().begin(),
+      bodyBlock.getArgumentTypes().end());
+  for (Value capture : captures)
+    argTypes.emplace_back(capture.getType());
+  SmallVector<Type, 4> resultTypes;
+  for (Value output : terminator->getOperands())
+    if (!isBodyArgument(output, bodyBlock))
+      resultTypes.emplace_back(output.getType());
+
+  OpBuilder builder = OpBuilder::atBlockEnd(module.getBody());
+  auto funcOp = builder.create<func::FuncOp>(loc, "outlined_body",
+      builder.getFunctionType(argTypes, resultTypes));
+  funcOp.setPrivate();
+
+  Block *entryBlock = funcOp.addEntryBlock();
+  BlockAndValueMapping mapper;
+  unsigned numBodyArgs = bodyBlock.getNumArguments();
+  for (unsigned i = 0; i < numBodyArgs; ++i)
+    mapper.map(bodyBlock.getArgument(i), entryBlock->getArgument(i));
+  for (unsigned i = 0; i < captures.size(); ++i)
+    mapper.map(captures[i], entryBlock->getArgument(numBodyArgs + i));
+
+  OpBuilder bodyBuilder = OpBuilder::atBlockBegin(entryBlock);
+  for (Operation &bodyOp : bodyBlock.without_terminator())
+    bodyBuilder.clone(bodyOp, mapper);
+  SmallVector<Value, 4> results;
+  for (Value output : terminator->getOperands())
+    if (!isBodyArgument(output, bodyBlock))
+      results.emplace_back(mapper.lookupOrDefault(output));
+  bodyBuilder.create<func::ReturnOp>(loc, results);
+  return funcOp;
+}
+
+// Replace the body of `op` with a call to `funcOp`: the new body forwards
+// its block arguments and the captured values to the call and returns the
+// call results, keeping block-argument pass-throughs in place.
+void rewriteBodyAsCall(
+    Operation *op, func::FuncOp funcOp, ArrayRef<Value> captures) {
+  Block &bodyBlock = op->getRegion(0).front();
+  Operation *terminator = bodyBlock.getTerminator();
+  Location loc = op->getLoc();
+
+  SmallVector<Operation *, 16> oldOps;
+  for (Operation &bodyOp : bodyBlock.without_terminator())
+    oldOps.emplace_back(&bodyOp);
+
+  OpBuilder builder(terminator);
+  SmallVector<Value, 4> callOperands(
+      bodyBlock.getArguments().begin(), bodyBlock.getArguments().end());
+  callOperands.append(captures.begin(), captures.end());
+  auto callOp = builder.create<func::CallOp>(loc, funcOp, callOperands);
+
+  unsigned resultIdx = 0;
+  SmallVector<Value, 4> outputs;
+  for (Value output : terminator->getOperands())
+    outputs.emplace_back(isBodyArgument(output, bodyBlock)
+                             ? output
+                             : callOp.getResult(resultIdx++));
+  builder.create<ONNXReturnOp>(loc, outputs);
+
+  // The remaining old operations are only used among themselves; erase them
+  // from the last to the first so no use outlives its definition.
+  terminator->erase();
+  for (Operation *oldOp : llvm::reverse(oldOps))
+    oldOp->erase();
+}
+
+struct OutlineLoopBodiesPass
+    : public PassWrapper<OutlineLoopBodiesPass, OperationPass<ModuleOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(OutlineLoopBodiesPass)
+
+  StringRef getArgument() const override { return "onnx-outline-loop-bodies"; }
+
+  StringRef getDescription() const override {
+    return "Outline structurally identical ONNX Loop/Scan bodies into "
+           "functions shared between them";
+  }
+
+  void runOnOperation() final;
+};
+
+void OutlineLoopBodiesPass::runOnOperation() {
+  ModuleOp module = getOperation();
+
+  // Collect the outlinable bodies. The post-order walk visits nested Loop
+  // and Scan operations before the operations containing them, so rewriting
+  // the candidates in collection order never touches an already erased body.
+  SmallVector<OutlineCandidate, 8> candidates;
+  module.walk([&](Operation *op) {
+    if (!isa<ONNXLoopOp, ONNXScanOp>(op))
+      return;
+    Region &body = op->getRegion(0);
+    if (!body.hasOneBlock())
+      return;
+    Block &bodyBlock = body.front();
+    Operation *terminator = bodyBlock.getTerminator();
+    if (!isa<ONNXReturnOp>(terminator))
+      return;
+    // A body without operations, or one that only forwards its arguments,
+    // has nothing to outline.
+    if (bodyBlock.without_terminator().empty())
+      return;
+    if (llvm::all_of(terminator->getOperands(),
+            [&](Value v) { return isBodyArgument(v, bodyBlock); }))
+      return;
+    OutlineCandidate candidate;
+    candidate.op = op;
+    llvm::SetVector<Value> captures;
+    getUsedValuesDefinedAbove(body, body, captures);
+    candidate.captures.assign(captures.begin(), captures.end());
+    candidates.emplace_back(std::move(candidate));
+  });
+
+  // Normalize each body into a candidate function and fingerprint it. The
+  // printed form numbers values locally, so two bodies print identically
+  // exactly when they agree in structure, operand types and capture usage.
+  for (OutlineCandidate &candidate : candidates) {
+    candidate.clonedFunc =
+        cloneBodyIntoFunction(module, candidate.op, candidate.captures);
+    llvm::raw_string_ostream os(candidate.fingerprint);
+    os << candidate.op->getName();
+    candidate.clonedFunc.getBody().front().print(os);
+    os.flush();
+  }
+
+  // Keep one clone per group of at least two identical bodies; unique bodies
+  // stay inline to avoid pure call overhead.
+  llvm::MapVector<StringRef, SmallVector<OutlineCandidate *, 4>> groups;
+  for (OutlineCandidate &candidate : candidates)
+    groups[candidate.fingerprint].emplace_back(&candidate);
+
+  unsigned numOutlined = 0;
+  for (auto &group : groups) {
+    SmallVector<OutlineCandidate *, 4> &members = group.second;
+    if (members.size() < 2) {
+      for (OutlineCandidate *member : members)
+        member->clonedFunc.erase();
+      continue;
+    }
+    func::FuncOp sharedFunc = members.front()->clonedFunc;
+    std::string name;
+    do {
+      name = (isa<ONNXLoopOp>(members.front()->op) ? "outlined_loop_body_"
+                                                   : "outlined_scan_body_") +
+             std::to_string(numOutlined++);
+    } while (module.lookupSymbol(name));
+    SymbolTable::setSymbolName(sharedFunc, name);
+    for (OutlineCandidate *member : members) {
+      if (member != members.front())
+        member->clonedFunc.erase();
+      member->sharedFunc = sharedFunc;
+    }
+  }
+
+  // Rewrite the bodies in collection order (inner before outer).
+  for (OutlineCandidate &candidate : candidates)
+    if (candidate.sharedFunc)
+      rewriteBodyAsCall(candidate.op, candidate.sharedFunc, candidate.captures);
+}
+
+} // namespace
+
+namespace onnx_mlir {
+
+/*!
+ * Create an OutlineLoopBodies pass.
+ */
+std::unique_ptr<mlir::Pass> createOutlineLoopBodiesPass() {
+  return std::make_unique<OutlineLoopBodiesPass>();
+}
+
+} // namespace onnx_mlir
@@ -0,0 +1,231 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===---- PartitionBackendSubgraphs.cpp - Partition for a backend ---------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements a pass that partitions an ONNX function for a
+// conversion backend that only covers part of the opset, currently the MHLO
+// and TOSA lowerings. Maximal contiguous runs of operations the backend can
+// convert are outlined into private functions tagged with a `backend`
+// attribute; the dedicated conversion pass can then be run on those functions
+// alone while everything that stays inline follows the default Krnl CPU path.
+// Subgraph boundaries are plain ranked-tensor function arguments and results,
+// so no copies are introduced at the transitions. Runs below a minimum
+// operation count stay inline: handing a couple of cheap elementwise
+// operations to another backend costs more in boundary crossings than the
+// conversion can win back.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace {
+
+// Operations with an ONNX-to-MHLO lowering pattern; this list mirrors the
+// patterns populated in src/Conversion/ONNXToMhlo/ConvertONNXToMhlo.cpp.
+bool hasMhloLowering(Operation *op) {
+  return isa<ONNXAbsOp, ONNXAddOp, ONNXAndOp, ONNXArgMaxOp,
+      ONNXBatchNormalizationInferenceModeOp, ONNXCastOp, ONNXCeilOp,
+      ONNXConcatOp, ONNXConstantOp, ONNXConvOp, ONNXCosOp, ONNXDivOp,
+      ONNXEqualOp, ONNXExpOp, ONNXExpandOp, ONNXFlattenOp, ONNXGatherOp,
+      ONNXGemmOp, ONNXGreaterOp, ONNXGreaterOrEqualOp, ONNXIdentityOp,
+      ONNXLessOp, ONNXLessOrEqualOp, ONNXMatMulOp, ONNXMaxPoolSingleOutOp,
+      ONNXMulOp, ONNXPowOp, ONNXReduceMaxOp, ONNXReduceMeanOp, ONNXReduceMinOp,
+      ONNXReduceSumOp, ONNXReluOp, ONNXReshapeOp, ONNXShapeOp, ONNXSigmoidOp,
+      ONNXSliceOp, ONNXSoftmaxOp, ONNXSplitOp, ONNXSqrtOp, ONNXSqueezeOp,
+      ONNXSubOp, ONNXTileOp, ONNXTransposeOp, ONNXUnsqueezeOp>(op);
+}
+
+// Operations with an ONNX-to-TOSA lowering pattern; this list mirrors the
+// patterns populated in src/Conversion/ONNXToTOSA/ConvertONNXToTOSA.cpp.
+bool hasTosaLowering(Operation *op) {
+  return isa<ONNXAddOp, ONNXFloorOp, ONNXNegOp, ONNXReluOp, ONNXSoftmaxOp,
+      ONNXSubOp>(op);
+}
+
+// A maximal contiguous run of backend-convertible operations within a block.
+// Contiguous runs can always be outlined: the block is in topological order,
+// so every value flowing into the run is defined before its first operation
+// and every value flowing out is only used after its last one.
+struct PartitionCandidate {
+  SmallVector<Operation *, 8> ops;
+  // Operations the backend actually has to compute; constants only feed them.
+  unsigned numComputeOps = 0;
+};
+
+// Outline the operations of `candidate` into a private module-level function
+// named `name` and tagged with the backend attribute, and replace them with a
+// call. Values defined outside the run become function arguments; results
+// used outside the run become function results.
+void outlineCandidate(ModuleOp module, const PartitionCandidate &candidate,
+    StringRef name, StringRef backendName) {
+  Operation *firstOp = candidate.ops.front();
+  Location loc = firstOp->getLoc();
+  llvm::SmallPtrSet<Operation *, 16> opSet(
+      candidate.ops.begin(), candidate.ops.end());
+
+  // Values computed outside the run but used inside become arguments, in
+  // first-use order.
+  SmallVector<Value, 4> inputs;
+  llvm::SmallPtrSet<Value, 16> inputSet;
+  for (Operation *op : candidate.ops)
+    for (Value operand : op->getOperands()) {
+      Operation *def = operand.getDefiningOp();
+      if (def && opSet.count(def))
+        continue;
+      if (inputSet.insert(operand).second)
+        inputs.emplace_back(operand);
+    }
+
+  // Results with a consumer outside the run become function results.
+  SmallVector<Value, 4> outputs;
+  for (Operation *op : candidate.ops)
+    for (Value result : op->getResults())
+      if (llvm::any_of(result.getUsers(),
+              [&](Operation *user) { return !opSet.count(user); }))
+        outputs.emplace_back(result);
+
+  SmallVector<Type, 4> argTypes;
+  for (Value input : inputs)
+    argTypes.emplace_back(input.getType());
+  SmallVector<Type, 4> resultTypes;
+  for (Value output : outputs)
+    resultTypes.emplace_back(output.getType());
+
+  OpBuilder builder = OpBuilder::atBlockEnd(module.getBody());
+  auto funcOp = builder.create<func::FuncOp>(
+      loc, name, builder.getFunctionType(argTypes, resultTypes));
+  funcOp.setPrivate();
+  funcOp->setAttr("backend", builder.getStringAttr(backendName));
+
+  Block *entryBlock = funcOp.addEntryBlock();
+  BlockAndValueMapping mapper;
+  for (unsigned i = 0; i < inputs.size(); ++i)
+    mapper.map(inputs[i], entryBlock->getArgument(i));
+  OpBuilder bodyBuilder = OpBuilder::atBlockBegin(entryBlock);
+  for (Operation *op : candidate.ops)
+    bodyBuilder.clone(*op, mapper);
+  SmallVector<Value, 4> returnValues;
+  for (Value output : outputs)
+    returnValues.emplace_back(mapper.lookup(output));
+  bodyBuilder.create<func::ReturnOp>(loc, returnValues);
+
+  // Call the outlined function at the site of the run and erase the original
+  // operations from the last to the first so no use outlives its definition.
+  OpBuilder callBuilder(firstOp);
+  auto callOp = callBuilder.create<func::CallOp>(loc, funcOp, inputs);
+  for (unsigned i = 0; i < outputs.size(); ++i)
+    outputs[i].replaceAllUsesWith(callOp.getResult(i));
+  for (Operation *op : llvm::reverse(candidate.ops))
+    op->erase();
+}
+
+struct PartitionBackendSubgraphsPass
+    : public PassWrapper<PartitionBackendSubgraphsPass,
+          OperationPass<ModuleOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(PartitionBackendSubgraphsPass)
+
+  PartitionBackendSubgraphsPass() = default;
+  PartitionBackendSubgraphsPass(const PartitionBackendSubgraphsPass &pass)
+      : mlir::PassWrapper<PartitionBackendSubgraphsPass,
+            OperationPass<ModuleOp>>() {}
+
+  StringRef getArgument() const override {
+    return "onnx-partition-for-backend";
+  }
+
+  StringRef getDescription() const override {
+    return "Outline maximal subgraphs convertible by a conversion backend "
+           "into functions tagged with a backend attribute, leaving the "
+           "remainder on the default CPU path.";
+  }
+
+  Option<std::string> backend{*this, "target-backend",
+      llvm::cl::desc("Conversion backend to partition for: mhlo or tosa."),
+      llvm::cl::init("mhlo")};
+  Option<int> minOps{*this, "min-ops",
+      llvm::cl::desc("Minimum number of non-constant operations a subgraph "
+                     "must contain to be outlined."),
+      llvm::cl::init(4)};
+
+  void runOnOperation() final {
+    ModuleOp module = getOperation();
+    bool (*isConvertible)(Operation *) = nullptr;
+    if (backend == "mhlo")
+      isConvertible = hasMhloLowering;
+    else if (backend == "tosa")
+      isConvertible = hasTosaLowering;
+    else {
+      module.emitError() << "onnx-partition-for-backend does not know backend "
+                         << "'" << backend.getValue() << "'";
+      signalPassFailure();
+      return;
+    }
+
+    // Snapshot the functions first: outlining appends to the module.
+    SmallVector<func::FuncOp, 4> functions;
+    for (func::FuncOp funcOp : module.getOps<func::FuncOp>())
+      if (!funcOp->hasAttr("backend") && !funcOp.getBody().empty() &&
+          funcOp.getBody().hasOneBlock())
+        functions.emplace_back(funcOp);
+
+    unsigned numPartitions = 0;
+    for (func::FuncOp funcOp : functions) {
+      // Collect the maximal contiguous convertible runs. Operations with
+      // regions stay inline even when the backend knows them: their bodies
+      // may contain anything.
+      SmallVector<PartitionCandidate, 4> candidates;
+      PartitionCandidate current;
+      auto flushCurrent = [&]() {
+        if (current.numComputeOps >= (unsigned)minOps.getValue())
+          candidates.emplace_back(std::move(current));
+        current = PartitionCandidate();
+      };
+      for (Operation &op : funcOp.getBody().front().without_terminator()) {
+        if (isConvertible(&op) && op.getNumRegions() == 0) {
+          current.ops.emplace_back(&op);
+          if (!isa<ONNXConstantOp>(op))
+            ++current.numComputeOps;
+        } else {
+          flushCurrent();
+        }
+      }
+      flushCurrent();
+
+      for (const PartitionCandidate &candidate : candidates) {
+        std::string name;
+        do {
+          name = (funcOp.getName() + "_" + backend.getValue() + "_" +
+                  std::to_string(numPartitions++))
+                     .str();
+        } while (module.lookupSymbol(name));
+        outlineCandidate(module, candidate, name, backend.getValue());
+      }
+    }
+  }
+};
+
+} // namespace
+
+namespace onnx_mlir {
+
+/*!
+ * Create a PartitionBackendSubgraphs pass.
+ */
+std::unique_ptr<mlir::Pass> createPartitionBackendSubgraphsPass() {
+  return std::make_unique<PartitionBackendSubgraphsPass>();
+}
+
+} // namespace onnx_mlir
@@ -0,0 +1,161 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------- ProfileAnnotationPass.cpp - Profile Annotation ---------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements a Function level pass that annotates ONNX ops with
+// measured execution times from an instrumentation profile, so that later
+// lowering passes can pick optimization strategies per op from measured hot
+// spots rather than static heuristics.
+//
+// The profile is a text file with one entry per line:
+//
+//   <op name> <node name> <time>
+//
+// where <node name> is the onnx_node_name attribute (or NOTSET) and <time> is
+// the measured total time in arbitrary but consistent units. Such a file is
+// produced from a binary instrumentation trace by
+// utils/OMInstrumentTraceReport.py --emit-profile.
+//
+// Ops found in the profile get a `profile_time` attribute with their measured
+// time, and ops whose share of the total measured time reaches the hot
+// threshold also get a `profile_hot` unit attribute.
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdlib>
+#include <map>
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+/*!
+ * This pass annotates ONNX ops with measured times from a profile file.
+ */
+
+class ProfileAnnotationPass
+    : public mlir::PassWrapper<ProfileAnnotationPass,
+          OperationPass<func::FuncOp>> {
+
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(ProfileAnnotationPass)
+
+  Option<std::string> profileFile{*this, "profile-file",
+      llvm::cl::desc("Profile file produced from an instrumentation trace."),
+      llvm::cl::init("")};
+
+  Option<double> hotThreshold{*this, "hot-threshold",
+      llvm::cl::desc("Fraction of the total measured time at which an op is "
+                     "considered hot (default 0.05)."),
+      llvm::cl::init(0.05)};
+
+  ProfileAnnotationPass() = default;
+  ProfileAnnotationPass(const ProfileAnnotationPass &pass)
+      : mlir::PassWrapper<ProfileAnnotationPass,
+            OperationPass<func::FuncOp>>() {}
+  ProfileAnnotationPass(std::string profileFile) {
+    this->profileFile = profileFile;
+  }
+
+private:
+  // Times keyed by onnx_node_name, and by op name for entries whose node
+  // name is NOTSET.
+  std::map<std::string, double> timeByNodeName;
+  std::map<std::string, double> timeByOpName;
+  double totalTime = 0.0;
+
+public:
+  StringRef getArgument() const override { return "profile-annotation"; }
+
+  StringRef getDescription() const override {
+    return "annotate onnx ops with measured times from a profile file.";
+  }
+
+  bool readProfile() {
+    auto bufferOrError = llvm::MemoryBuffer::getFile(profileFile);
+    if (!bufferOrError) {
+      emitError(UnknownLoc::get(&getContext()),
+          "cannot open profile file '" + profileFile + "'");
+      return false;
+    }
+    llvm::SmallVector<StringRef, 64> lines;
+    bufferOrError.get()->getBuffer().split(lines, '\n');
+    for (StringRef line : lines) {
+      line = line.trim();
+      if (line.empty() || line.startswith("#"))
+        continue;
+      StringRef opName, nodeName, timeStr, rest;
+      std::tie(opName, rest) = line.split(' ');
+      std::tie(nodeName, timeStr) = rest.trim().split(' ');
+      double time = std::strtod(timeStr.trim().str().c_str(), nullptr);
+      if (time <= 0.0)
+        continue;
+      if (nodeName.equals("NOTSET"))
+        timeByOpName[opName.str()] += time;
+      else
+        timeByNodeName[nodeName.str()] += time;
+      totalTime += time;
+    }
+    return totalTime > 0.0;
+  }
+
+  void runOnOperation() override {
+    if (profileFile == "")
+      return;
+    if (!readProfile()) {
+      signalPassFailure();
+      return;
+    }
+
+    OpBuilder builder(&getContext());
+    getOperation().walk([&](mlir::Operation *op) {
+      if (!isa<ONNXDialect>(op->getDialect()))
+        return;
+      double time = 0.0;
+      if (auto nodeNameAttr =
+              op->getAttrOfType<StringAttr>("onnx_node_name")) {
+        auto entry = timeByNodeName.find(nodeNameAttr.getValue().str());
+        if (entry != timeByNodeName.end())
+          time = entry->second;
+      }
+      if (time == 0.0) {
+        auto entry = timeByOpName.find(op->getName().getStringRef().str());
+        if (entry != timeByOpName.end())
+          time = entry->second;
+      }
+      if (time == 0.0)
+        return;
+      op->setAttr("profile_time", builder.getF64FloatAttr(time));
+      if (time >= hotThreshold * totalTime)
+        op->setAttr("profile_hot", builder.getUnitAttr());
+    });
+  }
+};
+
+} // namespace onnx_mlir
+
+/*!
+ * Create a profile annotation pass.
+ */
+std::unique_ptr<mlir::Pass> onnx_mlir::createProfileAnnotationPass() {
+  return std::make_unique<ProfileAnnotationPass>();
+}
+
+std::unique_ptr<mlir::Pass> onnx_mlir::createProfileAnnotationPass(
+    std::string profileFile) {
+  return std::make_unique<ProfileAnnotationPass>(profileFile);
+}
@@ -0,0 +1,230 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===----------- ONNXRecompose.cpp - ONNX High Level Rewriting ------------===//
+//
+// Copyright 2019-2022 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements a set of rewriters to recompose an ONNX operation from
+// a composition of other ONNX operations. This is the dual of Decompose: some
+// exporters emit composite operations such as LayerNormalization as a chain
+// of primitive operations, and recognizing the chain lets us use a dedicated
+// fused lowering instead of several separate loop nests.
+//
+// This pass is applied after shape inference so that reduction axes can be
+// normalized against the known rank of the input.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Dialect/ONNX/ONNXOps/OpHelper.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace onnx_mlir {
+
+namespace {
+
+// Return true and set value when v is produced by an ONNXConstantOp holding a
+// single float scalar.
+bool getScalarFloatConstant(Value v, double &value) {
+  ONNXConstantOp constOp = getONNXConstantOp(v);
+  if (!constOp)
+    return false;
+  ElementsAttr elements =
+      constOp.valueAttr().dyn_cast_or_null<DenseElementsAttr>();
+  if (!elements || elements.getNumElements() != 1 ||
+      !(elements.getElementType().isF32() || elements.getElementType().isF64()))
+    return false;
+  value = getScalarValue<double>(constOp, constOp.getResult().getType());
+  return true;
+}
+
+// Return true and set axis when reduceOp keeps dims and reduces a contiguous
+// set of trailing axes [axis, rank) of its ranked input.
+bool matchTrailingReduceMean(ONNXReduceMeanOp reduceOp, int64_t &axis) {
+  if (reduceOp.keepdims() != 1)
+    return false;
+  ShapedType inputType = reduceOp.data().getType().dyn_cast<RankedTensorType>();
+  if (!inputType)
+    return false;
+  int64_t rank = inputType.getRank();
+  ArrayAttr axesAttr = reduceOp.axesAttr();
+  if (!axesAttr || axesAttr.empty())
+    return false;
+  SmallVector<int64_t, 4> axes;
+  for (Attribute axisAttr : axesAttr.getValue()) {
+    int64_t a = axisAttr.cast<IntegerAttr>().getInt();
+    if (a < 0)
+      a += rank;
+    if (a < 0 || a >= rank)
+      return false;
+    axes.push_back(a);
+  }
+  std::sort(axes.begin(), axes.end());
+  // Axes must be contiguous and end at the last dimension.
+  if (axes.back() != rank - 1)
+    return false;
+  for (unsigned i = 1; i < axes.size(); ++i)
+    if (axes[i] != axes[i - 1] + 1)
+      return false;
+  axis = axes.front();
+  return true;
+}
+
+/// Recognize the LayerNormalization chain emitted by exporters:
+///   mean = ReduceMean(X, trailing axes, keepdims=1)
+///   D = Sub(X, mean)
+///   var = ReduceMean(Mul(D, D), same axes, keepdims=1)
+///   Y = Mul(Div(D, Sqrt(Add(var, eps))), scale) [+ bias]
+/// The pattern is rooted at the Mul by scale; a single-use Add that follows
+/// it is absorbed as the bias.
+struct RecomposeLayerNormPattern : public OpRewritePattern<ONNXMulOp> {
+  using OpRewritePattern<ONNXMulOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(
+      ONNXMulOp mulOp, PatternRewriter &rewriter) const final {
+    Location loc = mulOp.getLoc();
+    // Match Mul(Div(...), scale), either operand order.
+    Value scale;
+    ONNXDivOp divOp;
+    if ((divOp = mulOp.A().getDefiningOp<ONNXDivOp>()) &&
+        divOp.getResult().hasOneUse())
+      scale = mulOp.B();
+    else if ((divOp = mulOp.B().getDefiningOp<ONNXDivOp>()) &&
+             divOp.getResult().hasOneUse())
+      scale = mulOp.A();
+    else
+      return failure();
+
+    // Numerator: D = Sub(X, ReduceMean(X)).
+    ONNXSubOp subOp = divOp.A().getDefiningOp<ONNXSubOp>();
+    if (!subOp)
+      return failure();
+    Value D = subOp.getResult();
+    Value X = subOp.A();
+    ONNXReduceMeanOp meanOp = subOp.B().getDefiningOp<ONNXReduceMeanOp>();
+    if (!meanOp || meanOp.data() != X || !meanOp.getResult().hasOneUse())
+      return failure();
+    // D must only feed the variance Mul (twice) and the Div.
+    if (std::distance(D.use_begin(), D.use_end()) != 3)
+      return failure();
+
+    // Denominator: Sqrt(Add(ReduceMean(Mul(D, D)), eps)).
+    ONNXSqrtOp sqrtOp = divOp.B().getDefiningOp<ONNXSqrtOp>();
+    if (!sqrtOp || !sqrtOp.getResult().hasOneUse())
+      return failure();
+    ONNXAddOp epsAddOp = sqrtOp.X().getDefiningOp<ONNXAddOp>();
+    if (!epsAddOp || !epsAddOp.getResult().hasOneUse())
+      return failure();
+    Value epsVal;
+    ONNXReduceMeanOp varOp;
+    if ((varOp = epsAddOp.A().getDefiningOp<ONNXReduceMeanOp>()))
+      epsVal = epsAddOp.B();
+    else if ((varOp = epsAddOp.B().getDefiningOp<ONNXReduceMeanOp>()))
+      epsVal = epsAddOp.A();
+    else
+      return failure();
+    if (!varOp.getResult().hasOneUse())
+      return failure();
+    double epsilon;
+    if (!getScalarFloatConstant(epsVal, epsilon))
+      return failure();
+    ONNXMulOp ddOp = varOp.data().getDefiningOp<ONNXMulOp>();
+    if (!ddOp || ddOp.A() != D || ddOp.B() != D ||
+        !ddOp.getResult().hasOneUse())
+      return failure();
+
+    // Both reductions must keep dims and reduce the same trailing axes.
+    int64_t axis, varAxis;
+    if (!matchTrailingReduceMean(meanOp, axis) ||
+        !matchTrailingReduceMean(varOp, varAxis) || axis != varAxis)
+      return failure();
+    int64_t rank = X.getType().cast<RankedTensorType>().getRank();
+    int64_t numNormalizedDims = rank - axis;
+
+    // Scale (and bias, if present) must cover exactly the normalized dims so
+    // that the fused lowering can index them with the inner loop indices.
+    auto coversNormalizedDims = [&](Value v) {
+      ShapedType type = v.getType().dyn_cast<RankedTensorType>();
+      return type && type.getRank() == numNormalizedDims;
+    };
+    if (!coversNormalizedDims(scale))
+      return failure();
+
+    // Absorb a single-use bias Add that directly follows.
+    Value Y = mulOp.getResult();
+    ONNXAddOp biasAddOp;
+    Value bias;
+    if (Y.hasOneUse()) {
+      if ((biasAddOp = dyn_cast<ONNXAddOp>(*Y.getUsers().begin()))) {
+        Value other = (biasAddOp.A() == Y) ? biasAddOp.B() : biasAddOp.A();
+        if (coversNormalizedDims(other)) {
+          bias = other;
+          Y = biasAddOp.getResult();
+        } else
+          biasAddOp = nullptr;
+      }
+    }
+    if (!bias)
+      bias = rewriter.create<ONNXNoneOp>(loc).getResult();
+
+    Type noneType = rewriter.getNoneType();
+    IntegerType si64Type = rewriter.getIntegerType(64, /*isSigned=*/true);
+    auto layerNormOp = rewriter.create<ONNXLayerNormalizationOp>(loc,
+        /*Y=*/Y.getType(), /*Mean=*/noneType, /*InvStdDev=*/noneType, X, scale,
+        bias, rewriter.getIntegerAttr(si64Type, axis),
+        rewriter.getF32FloatAttr((float)epsilon),
+        rewriter.getIntegerAttr(si64Type, 1));
+    if (biasAddOp) {
+      rewriter.replaceOp(biasAddOp, layerNormOp.Y());
+      rewriter.eraseOp(mulOp);
+    } else
+      rewriter.replaceOp(mulOp, layerNormOp.Y());
+    return success();
+  }
+};
+
+struct RecomposeONNXToONNXPass
+    : public PassWrapper<RecomposeONNXToONNXPass, OperationPass<func::FuncOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(RecomposeONNXToONNXPass)
+
+  StringRef getArgument() const override { return "recompose-onnx"; }
+
+  StringRef getDescription() const override {
+    return "Recompose ONNX operations from compositions of "
+           "other ONNX operations.";
+  }
+
+  void runOnOperation() final;
+};
+
+} // namespace
+
+void RecomposeONNXToONNXPass::runOnOperation() {
+  func::FuncOp function = getOperation();
+  MLIRContext *context = &getContext();
+
+  RewritePatternSet patterns(context);
+  patterns.insert<RecomposeLayerNormPattern>(context);
+  if (failed(applyPatternsAndFoldGreedily(function, std::move(patterns))))
+    signalPassFailure();
+}
+
+/*!
+ * Create a RecomposeONNX pass.
+ */
+std::unique_ptr<mlir::Pass> createRecomposeONNXToONNXPass() {
+  return std::make_unique<RecomposeONNXToONNXPass>();
+}
+
+} // namespace onnx_mlir
@@ -13,6 +13,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <deque>
 #include <regex>
 
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -101,31 +102,63 @@ public:
       (void)ShapeInferencePass::runShapeInferenceOnRegion(region);
     };
 
-    // Iterate on the operations that need shape inference i.e the operations
-    // that return a dynamic shape or followed by a return op.
+    // Worklist of the operations that need shape inference. Processing in
+    // program order (FIFO) visits most producers before their consumers; an
+    // operation is revisited only when the result type of one of its
+    // producers changed after it was processed, so one invocation refines
+    // shapes to a fixpoint without sweeping the whole region repeatedly.
+    std::deque<Operation *> worklist;
+    llvm::SmallPtrSet<Operation *, 16> inWorklist;
+    auto enqueue = [&](Operation *op) {
+      if (inWorklist.insert(op).second)
+        worklist.push_back(op);
+    };
+
+    // Seed the worklist with the operations that return a dynamic shape or
+    // are followed by a return op. The shape of graph output has been
+    // imported from onnx protobuf model, so the ops followed by a return op
+    // may not have dynamic shape output. However, shape inference is still
+    // needed on these ops to infer optional attributes.
     for (Operation &op : r.getOps()) {
-      // The shape of graph output has been imported from onnx protobuf model,
-      // so the ops followed by a return op may not have dynamic shape output.
-      // However, shape inference is still needed on these ops to infer optional
-      // attributes.
       if (!containSubgraph(op) && !isUsedByReturnOp(op) &&
           !returnsDynamicOrUnknownShape(op))
         continue;
+      enqueue(&op);
+    }
+
+    while (!worklist.empty()) {
+      Operation *op = worklist.front();
+      worklist.pop_front();
+      inWorklist.erase(op);
 
-      if (auto shape_op = llvm::dyn_cast<ShapeInference>(op)) {
+      if (auto shape_op = llvm::dyn_cast<ShapeInference>(*op)) {
         // Verify the operation before attempting to infer the shape of the
         // produced output(s).
         Optional<RegisteredOperationName> registeredInfo =
-            op.getName().getRegisteredInfo();
-        if (registeredInfo && failed(registeredInfo->verifyInvariants(&op)))
-          return op.emitError("verification failed");
-
-        // Attempt to infer the shape of the produced output(s).
+            op->getName().getRegisteredInfo();
+        if (registeredInfo && failed(registeredInfo->verifyInvariants(op)))
+          return op->emitError("verification failed");
+
+        // Attempt to infer the shape of the produced output(s), remembering
+        // the previous result types to detect changes.
+        SmallVector<Type, 4> oldTypes(
+            op->result_type_begin(), op->result_type_end());
         if (failed(shape_op.inferShapes(doShapeInference)))
-          return op.emitError("shape inference failed");
-      } else if (!llvm::dyn_cast<CallOpInterface>(op))
-        return op.emitError("unable to infer shape of operation without shape "
-                            "inference interface");
+          return op->emitError("shape inference failed");
+
+        // Revisit the users whose input shapes just changed. Inference only
+        // refines types (dynamic dimensions become static), so the chain of
+        // changes is finite. A user nested in a subgraph is revisited
+        // through its ancestor operation in this region.
+        if (!std::equal(oldTypes.begin(), oldTypes.end(),
+                op->result_type_begin(), op->result_type_end()))
+          for (Operation *user : op->getUsers())
+            if (Operation *ancestor = r.findAncestorOpInRegion(*user))
+              if (isa<ShapeInference>(ancestor))
+                enqueue(ancestor);
+      } else if (!llvm::dyn_cast<CallOpInterface>(*op))
+        return op->emitError("unable to infer shape of operation without "
+                             "shape inference interface");
     }
     return success();
   }
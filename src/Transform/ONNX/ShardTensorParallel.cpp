@@ -0,0 +1,249 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===---- ShardTensorParallel.cpp - Shard MatMul/Gemm across ranks --------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements a pass that shards the weights of MatMul and Gemm
+// operations across the ranks of a tensor-parallel device mesh. Models whose
+// weights do not fit on one node are compiled once per rank: each invocation
+// slices the constant weight columns owned by its rank, computes the local
+// output shard, and reassembles the full output with an all-gather collective
+// expressed as an onnx.Custom call-out into the runtime. The weight slices
+// feed constant propagation, so every per-rank library only embeds its own
+// fraction of the weights. The collective backend is pluggable at runtime
+// (see OMTensorParallel.inc); the default single-rank backend makes the
+// sharded and unsharded compilations bit-identical for num-ranks == 1.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+#include "src/Dialect/ONNX/DialectBuilder.hpp"
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace {
+
+// Name of the runtime all-gather collective, see src/Runtime/OMTensorParallel.
+static constexpr const char *allGatherFuncName = "omTensorParallelAllGather";
+
+// Return the 2-D constant weight tensor type when `weight` can be sharded,
+// nullptr otherwise.
+static RankedTensorType getShardableWeightType(Value weight, int64_t numRanks,
+    int64_t shardedDim) {
+  if (!weight.getDefiningOp<ONNXConstantOp>())
+    return nullptr;
+  auto weightType = weight.getType().dyn_cast<RankedTensorType>();
+  if (!weightType || weightType.getRank() != 2 || !weightType.hasStaticShape())
+    return nullptr;
+  int64_t size = weightType.getShape()[shardedDim];
+  if (size < numRanks || size % numRanks != 0)
+    return nullptr;
+  return weightType;
+}
+
+// Create the all-gather that reassembles the full `resultType` output from
+// this rank's `localResult` shard along the last dimension.
+static Value emitAllGather(PatternRewriter &rewriter, Location loc,
+    Type resultType, Value localResult, int64_t numRanks, int64_t rank) {
+  int64_t axis = resultType.cast<RankedTensorType>().getRank() - 1;
+  auto customOp = rewriter.create<ONNXCustomOp>(loc, TypeRange(resultType),
+      ValueRange(localResult), rewriter.getStringAttr(allGatherFuncName));
+  customOp->setAttr("axis", rewriter.getI64IntegerAttr(axis));
+  customOp->setAttr("numRanks", rewriter.getI64IntegerAttr(numRanks));
+  customOp->setAttr("rank", rewriter.getI64IntegerAttr(rank));
+  return customOp.outputs()[0];
+}
+
+// Slice the columns of the 2-D weight owned by `rank` along `axis`.
+static Value sliceWeightForRank(PatternRewriter &rewriter, Location loc,
+    Value weight, RankedTensorType weightType, int64_t axis, int64_t numRanks,
+    int64_t rank) {
+  MultiDialectBuilder<OnnxBuilder> create(rewriter, loc);
+  int64_t shardSize = weightType.getShape()[axis] / numRanks;
+  SmallVector<int64_t, 2> localShape(weightType.getShape());
+  localShape[axis] = shardSize;
+  Type localType =
+      RankedTensorType::get(localShape, weightType.getElementType());
+  Value starts = create.onnx.constantInt64({rank * shardSize});
+  Value ends = create.onnx.constantInt64({(rank + 1) * shardSize});
+  Value axes = create.onnx.constantInt64({axis});
+  Value steps = create.onnx.constantInt64({1});
+  return create.onnx.slice(localType, weight, starts, ends, axes, steps);
+}
+
+// Column-shard a MatMul with a 2-D constant weight: each rank computes the
+// output columns of its weight shard and the all-gather interleaves the
+// shards back into the full output.
+struct ShardMatMulPattern : public OpRewritePattern<ONNXMatMulOp> {
+  ShardMatMulPattern(MLIRContext *context, int64_t numRanks, int64_t rank)
+      : OpRewritePattern<ONNXMatMulOp>(context), numRanks(numRanks),
+        rank(rank) {}
+
+  LogicalResult matchAndRewrite(
+      ONNXMatMulOp matMulOp, PatternRewriter &rewriter) const final {
+    Value A = matMulOp.A();
+    Value B = matMulOp.B();
+    RankedTensorType bType =
+        getShardableWeightType(B, numRanks, /*shardedDim=*/1);
+    if (!bType)
+      return failure();
+    auto yType = matMulOp.getResult().getType().dyn_cast<RankedTensorType>();
+    if (!yType || !yType.hasRank() ||
+        yType.getShape().back() != bType.getShape()[1])
+      return failure();
+
+    Location loc = matMulOp.getLoc();
+    MultiDialectBuilder<OnnxBuilder> create(rewriter, loc);
+    Value localB =
+        sliceWeightForRank(rewriter, loc, B, bType, /*axis=*/1, numRanks, rank);
+    SmallVector<int64_t, 4> localShape(yType.getShape());
+    localShape.back() = bType.getShape()[1] / numRanks;
+    Type localYType =
+        RankedTensorType::get(localShape, yType.getElementType());
+    Value localY = create.onnx.matmul(localYType, A, localB);
+    Value fullY = emitAllGather(rewriter, loc, yType, localY, numRanks, rank);
+    rewriter.replaceOp(matMulOp, fullY);
+    return success();
+  }
+
+private:
+  int64_t numRanks, rank;
+};
+
+// Column-shard a Gemm along its N dimension. The weight shard is taken from
+// the columns (or rows when transB is set) of the constant B, and a 1-D bias
+// is sliced the same way. Scalar biases broadcast unchanged to every shard.
+struct ShardGemmPattern : public OpRewritePattern<ONNXGemmOp> {
+  ShardGemmPattern(MLIRContext *context, int64_t numRanks, int64_t rank)
+      : OpRewritePattern<ONNXGemmOp>(context), numRanks(numRanks), rank(rank) {
+  }
+
+  LogicalResult matchAndRewrite(
+      ONNXGemmOp gemmOp, PatternRewriter &rewriter) const final {
+    Value A = gemmOp.A();
+    Value B = gemmOp.B();
+    Value C = gemmOp.C();
+    int64_t nAxis = gemmOp.transB() ? 0 : 1;
+    RankedTensorType bType = getShardableWeightType(B, numRanks, nAxis);
+    if (!bType)
+      return failure();
+    int64_t n = bType.getShape()[nAxis];
+    auto yType = gemmOp.getResult().getType().dyn_cast<RankedTensorType>();
+    if (!yType || !yType.hasRank() || yType.getShape().back() != n)
+      return failure();
+    // The bias must be absent, scalar, or a 1-D tensor over N.
+    RankedTensorType cType;
+    if (!C.getType().isa<NoneType>()) {
+      cType = C.getType().dyn_cast<RankedTensorType>();
+      if (!cType || cType.getRank() > 1)
+        return failure();
+      if (cType.getRank() == 1 && cType.getShape()[0] != n)
+        return failure();
+    }
+
+    Location loc = gemmOp.getLoc();
+    MultiDialectBuilder<OnnxBuilder> create(rewriter, loc);
+    int64_t shardSize = n / numRanks;
+    Value localB =
+        sliceWeightForRank(rewriter, loc, B, bType, nAxis, numRanks, rank);
+    Value localC = C;
+    if (cType && cType.getRank() == 1) {
+      Type localCType =
+          RankedTensorType::get({shardSize}, cType.getElementType());
+      localC = create.onnx.slice(localCType, C, rank * shardSize,
+          (rank + 1) * shardSize);
+    }
+    SmallVector<int64_t, 2> localShape(yType.getShape());
+    localShape.back() = shardSize;
+    Type localYType =
+        RankedTensorType::get(localShape, yType.getElementType());
+    // Clone the Gemm so alpha/beta/trans attributes carry over unchanged.
+    Operation *localGemm = rewriter.clone(*gemmOp.getOperation());
+    localGemm->setOperands({A, localB, localC});
+    localGemm->getResult(0).setType(localYType);
+    Value localY = localGemm->getResult(0);
+    Value fullY = emitAllGather(rewriter, loc, yType, localY, numRanks, rank);
+    rewriter.replaceOp(gemmOp, fullY);
+    return success();
+  }
+
+private:
+  int64_t numRanks, rank;
+};
+
+struct ShardTensorParallelPass
+    : public PassWrapper<ShardTensorParallelPass, OperationPass<func::FuncOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(ShardTensorParallelPass)
+
+  ShardTensorParallelPass() = default;
+  ShardTensorParallelPass(const ShardTensorParallelPass &pass)
+      : mlir::PassWrapper<ShardTensorParallelPass,
+            OperationPass<func::FuncOp>>() {}
+  ShardTensorParallelPass(int64_t numRanks, int64_t rank) {
+    this->numRanks = numRanks;
+    this->rank = rank;
+  }
+
+  StringRef getArgument() const override { return "shard-tensor-parallel"; }
+
+  StringRef getDescription() const override {
+    return "Shard MatMul/Gemm constant weights across the ranks of a "
+           "tensor-parallel device mesh and reassemble the outputs with "
+           "runtime all-gather collectives.";
+  }
+
+  Option<int64_t> numRanks{*this, "num-ranks",
+      llvm::cl::desc("Number of ranks in the tensor-parallel device mesh."),
+      llvm::cl::init(1)};
+  Option<int64_t> rank{*this, "rank",
+      llvm::cl::desc("Rank whose weight shards this compilation embeds."),
+      llvm::cl::init(0)};
+
+  void runOnOperation() final {
+    func::FuncOp function = getOperation();
+    MLIRContext *context = &getContext();
+    if (numRanks <= 1)
+      return;
+    if (rank < 0 || rank >= numRanks) {
+      function.emitError()
+          << "shard-tensor-parallel rank " << rank.getValue()
+          << " is out of range for " << numRanks.getValue() << " ranks";
+      signalPassFailure();
+      return;
+    }
+
+    RewritePatternSet patterns(context);
+    patterns.insert<ShardMatMulPattern>(context, numRanks, rank);
+    patterns.insert<ShardGemmPattern>(context, numRanks, rank);
+    if (failed(applyPatternsAndFoldGreedily(function, std::move(patterns))))
+      signalPassFailure();
+  }
+};
+
+} // namespace
+
+namespace onnx_mlir {
+
+/*!
+ * Create a ShardTensorParallel pass.
+ */
+std::unique_ptr<mlir::Pass> createShardTensorParallelPass() {
+  return std::make_unique<ShardTensorParallelPass>();
+}
+
+std::unique_ptr<mlir::Pass> createShardTensorParallelPass(
+    int64_t numRanks, int64_t rank) {
+  return std::make_unique<ShardTensorParallelPass>(numRanks, rank);
+}
+
+} // namespace onnx_mlir
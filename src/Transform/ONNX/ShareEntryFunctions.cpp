@@ -0,0 +1,252 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===---- ShareEntryFunctions.cpp - Share entry point function bodies -----===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements a pass that lets structurally identical entry point
+// functions share one body. Models exported with several entry points (for
+// example one per serving configuration) repeat the whole graph once per
+// entry signature; lowering every copy separately multiplies compile time
+// and binary size for near-identical code. The pass compares the entry
+// point functions of the module, ignoring instance-naming attributes and
+// comparing constant payloads by content, and rewrites each duplicate into
+// a thin wrapper that calls the first function of its group. Every entry
+// point keeps its exported name, signature, and calling convention; only
+// the heavy body behind it is lowered once.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/DialectResourceBlobManager.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace {
+
+// Attributes that name an operation instance rather than define its
+// semantics; per-entry exports repeat the graph under fresh node names.
+bool isInstanceAttr(StringRef name) { return name == "onnx_node_name"; }
+
+// Return the raw payload bytes of an elements attribute, or None when there
+// is no directly accessible raw form. Covering resource attributes matters
+// here: each exported entry point carries its own copy of the weights, and
+// when those are memory-mapped external data the copies hold distinct
+// resource handles over identical bytes.
+Optional<ArrayRef<char>> getElementsPayload(Attribute value) {
+  if (auto dense = value.dyn_cast<DenseElementsAttr>())
+    return dense.getRawData();
+  if (auto resource = value.dyn_cast<DenseResourceElementsAttr>())
+    if (AsmResourceBlob *blob = resource.getRawHandle().getBlob())
+      return blob->getData();
+  return llvm::None;
+}
+
+// Two attributes are semantically equal when they are the same uniqued
+// attribute or elements attributes of the same type over the same bytes.
+bool attrsEqual(Attribute attr, Attribute otherAttr) {
+  if (attr == otherAttr)
+    return true;
+  auto typed = attr.dyn_cast<TypedAttr>();
+  auto otherTyped = otherAttr.dyn_cast<TypedAttr>();
+  if (!typed || !otherTyped || typed.getType() != otherTyped.getType())
+    return false;
+  Optional<ArrayRef<char>> payload = getElementsPayload(attr);
+  Optional<ArrayRef<char>> otherPayload = getElementsPayload(otherAttr);
+  return payload && otherPayload && *payload == *otherPayload;
+}
+
+// Structural fingerprint of a function: opcodes, result types, and semantic
+// attributes in program order. Functions that may share a body hash equal;
+// equality is then established by areFunctionsEquivalent.
+llvm::hash_code fingerprint(func::FuncOp funcOp) {
+  llvm::hash_code hash =
+      llvm::hash_value(funcOp.getFunctionType().getAsOpaquePointer());
+  funcOp.getBody().walk([&](Operation *op) {
+    hash = llvm::hash_combine(hash, op->getName().getAsOpaquePointer(),
+        op->getNumOperands(), op->getNumRegions());
+    for (Type type : op->getResultTypes())
+      hash = llvm::hash_combine(hash, type.getAsOpaquePointer());
+    for (NamedAttribute attr : op->getAttrs()) {
+      if (isInstanceAttr(attr.getName().getValue()))
+        continue;
+      hash = llvm::hash_combine(hash, attr.getName().getValue());
+      if (Optional<ArrayRef<char>> payload =
+              getElementsPayload(attr.getValue()))
+        hash = llvm::hash_combine(hash,
+            llvm::hash_value(StringRef(payload->data(), payload->size())));
+      else
+        hash = llvm::hash_combine(hash, attr.getValue().getAsOpaquePointer());
+    }
+  });
+  return hash;
+}
+
+bool areBlocksEquivalent(
+    Block &block, Block &otherBlock, DenseMap<Value, Value> &valueMap);
+
+// Lockstep comparison of two regions: blocks pair up in order and their
+// arguments extend the running value correspondence.
+bool areRegionsEquivalent(
+    Region &region, Region &otherRegion, DenseMap<Value, Value> &valueMap) {
+  if (std::distance(region.begin(), region.end()) !=
+      std::distance(otherRegion.begin(), otherRegion.end()))
+    return false;
+  for (auto blocks : llvm::zip(region.getBlocks(), otherRegion.getBlocks()))
+    if (!areBlocksEquivalent(
+            std::get<0>(blocks), std::get<1>(blocks), valueMap))
+      return false;
+  return true;
+}
+
+// Lockstep comparison of two blocks under the value correspondence built so
+// far: operations must agree in opcode, mapped operands, result types, and
+// semantic attributes, and region-carrying operations (Loop, Scan, If) must
+// agree recursively.
+bool areBlocksEquivalent(
+    Block &block, Block &otherBlock, DenseMap<Value, Value> &valueMap) {
+  if (block.getNumArguments() != otherBlock.getNumArguments() ||
+      block.getArgumentTypes() != otherBlock.getArgumentTypes())
+    return false;
+  for (unsigned i = 0; i < block.getNumArguments(); ++i)
+    valueMap[block.getArgument(i)] = otherBlock.getArgument(i);
+
+  auto it = block.begin(), otherIt = otherBlock.begin();
+  for (; it != block.end() && otherIt != otherBlock.end(); ++it, ++otherIt) {
+    Operation *op = &*it, *otherOp = &*otherIt;
+    if (op->getName() != otherOp->getName() ||
+        op->getNumOperands() != otherOp->getNumOperands() ||
+        op->getResultTypes() != otherOp->getResultTypes() ||
+        op->getNumRegions() != otherOp->getNumRegions())
+      return false;
+    for (unsigned i = 0; i < op->getNumOperands(); ++i)
+      if (valueMap.lookup(op->getOperand(i)) != otherOp->getOperand(i))
+        return false;
+    SmallVector<NamedAttribute, 4> attrs, otherAttrs;
+    for (NamedAttribute attr : op->getAttrs())
+      if (!isInstanceAttr(attr.getName().getValue()))
+        attrs.emplace_back(attr);
+    for (NamedAttribute attr : otherOp->getAttrs())
+      if (!isInstanceAttr(attr.getName().getValue()))
+        otherAttrs.emplace_back(attr);
+    if (attrs.size() != otherAttrs.size())
+      return false;
+    for (unsigned i = 0; i < attrs.size(); ++i)
+      if (attrs[i].getName() != otherAttrs[i].getName() ||
+          !attrsEqual(attrs[i].getValue(), otherAttrs[i].getValue()))
+        return false;
+    for (unsigned i = 0; i < op->getNumRegions(); ++i)
+      if (!areRegionsEquivalent(
+              op->getRegion(i), otherOp->getRegion(i), valueMap))
+        return false;
+    for (unsigned i = 0; i < op->getNumResults(); ++i)
+      valueMap[op->getResult(i)] = otherOp->getResult(i);
+  }
+  return it == block.end() && otherIt == otherBlock.end();
+}
+
+// Two functions may share a body when they agree in signature and their
+// bodies are equivalent operation by operation.
+bool areFunctionsEquivalent(func::FuncOp funcOp, func::FuncOp otherFuncOp) {
+  if (funcOp.getFunctionType() != otherFuncOp.getFunctionType())
+    return false;
+  DenseMap<Value, Value> valueMap;
+  return areRegionsEquivalent(
+      funcOp.getBody(), otherFuncOp.getBody(), valueMap);
+}
+
+// Replace the body of `dup` with a forwarding call to `shared`. The wrapper
+// is all that remains of the duplicate: its entry point still resolves to
+// its own exported name and signature, while the computation behind it is
+// lowered once for the whole group.
+void rewriteAsWrapper(func::FuncOp dup, func::FuncOp shared) {
+  Location loc = dup.getLoc();
+  Block &oldBlock = dup.getBody().front();
+  Block *wrapper = new Block();
+  SmallVector<Location, 4> argLocs(dup.getNumArguments(), loc);
+  wrapper->addArguments(dup.getArgumentTypes(), argLocs);
+  OpBuilder builder(dup.getContext());
+  builder.setInsertionPointToStart(wrapper);
+  auto callOp =
+      builder.create<func::CallOp>(loc, shared, wrapper->getArguments());
+  builder.create<func::ReturnOp>(loc, callOp.getResults());
+  dup.getBody().push_back(wrapper);
+  oldBlock.erase();
+}
+
+struct ShareEntryFunctionsPass
+    : public PassWrapper<ShareEntryFunctionsPass, OperationPass<ModuleOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(ShareEntryFunctionsPass)
+
+  StringRef getArgument() const override {
+    return "onnx-share-entry-functions";
+  }
+
+  StringRef getDescription() const override {
+    return "Rewrite structurally identical entry point functions into "
+           "wrappers sharing one body";
+  }
+
+  void runOnOperation() final;
+};
+
+void ShareEntryFunctionsPass::runOnOperation() {
+  ModuleOp module = getOperation();
+
+  // Collect the entry point functions in module order; sharing only applies
+  // to them because only they are duplicated per exported signature.
+  SmallVector<func::FuncOp, 4> entryFuncs;
+  module.walk([&](ONNXEntryPointOp entryOp) {
+    SymbolRefAttr funcRefAttr = entryOp->getAttrOfType<SymbolRefAttr>(
+        ONNXEntryPointOp::getEntryPointFuncAttrName());
+    auto funcOp = module.lookupSymbol<func::FuncOp>(
+        funcRefAttr.getLeafReference().getValue());
+    if (funcOp && !funcOp.getBody().empty() &&
+        !llvm::is_contained(entryFuncs, funcOp))
+      entryFuncs.emplace_back(funcOp);
+  });
+  if (entryFuncs.size() < 2)
+    return;
+
+  // Bucket by fingerprint, then establish equality pairwise within each
+  // bucket. The first function of a group keeps its body; the others become
+  // wrappers calling it.
+  llvm::MapVector<llvm::hash_code, SmallVector<func::FuncOp, 2>> groups;
+  for (func::FuncOp funcOp : entryFuncs) {
+    SmallVector<func::FuncOp, 2> &bucket = groups[fingerprint(funcOp)];
+    bool shared = false;
+    for (func::FuncOp earlier : bucket) {
+      if (areFunctionsEquivalent(earlier, funcOp)) {
+        rewriteAsWrapper(funcOp, earlier);
+        shared = true;
+        break;
+      }
+    }
+    if (!shared)
+      bucket.emplace_back(funcOp);
+  }
+}
+
+} // namespace
+
+namespace onnx_mlir {
+
+/*!
+ * Create a ShareEntryFunctions pass.
+ */
+std::unique_ptr<mlir::Pass> createShareEntryFunctionsPass() {
+  return std::make_unique<ShareEntryFunctionsPass>();
+}
+
+} // namespace onnx_mlir
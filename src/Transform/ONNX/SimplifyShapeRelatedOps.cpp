@@ -66,6 +66,7 @@ Now, it's straightforward to update the output shape of Reshape from
 #include "src/Dialect/ONNX/ONNXOps/ShapeHelper.hpp"
 #include "src/Pass/Passes.hpp"
 #include "src/Support/TypeUtilities.hpp"
+#include "src/Transform/ONNX/ONNXDimAnalysis.hpp"
 
 #define DEBUG_TYPE "simplify_shape_related_ops"
 
@@ -489,6 +490,7 @@ struct SimplifyShapeRelatedOpsPass
 
 private:
   void topDownShapeSimplification(MLIRContext *context, ModuleOp moduleOp);
+  void normalizeDimOpsToInputs(ModuleOp moduleOp);
 };
 
 void SimplifyShapeRelatedOpsPass::topDownShapeSimplification(
@@ -529,6 +531,52 @@ void SimplifyShapeRelatedOpsPass::topDownShapeSimplification(
     signalPassFailure();
 }
 
+/// Rewrite onnx.Dim to query a function input whenever the dimension analysis
+/// proves that the queried dimension equals a dimension of an input. Shape
+/// expressions derived from intermediate tensors then become expressions over
+/// the input dimensions only, so CSE shares a single computation per distinct
+/// extent instead of re-deriving it at every level of the model at run time.
+void SimplifyShapeRelatedOpsPass::normalizeDimOpsToInputs(ModuleOp moduleOp) {
+  onnx_mlir::DimAnalysis dimAnalysis(moduleOp);
+  dimAnalysis.analyze();
+
+  SmallVector<ONNXDimOp, 4> dimOps;
+  moduleOp.walk([&](ONNXDimOp dimOp) {
+    if (!dimOp.data().isa<BlockArgument>())
+      dimOps.emplace_back(dimOp);
+  });
+
+  for (ONNXDimOp dimOp : dimOps) {
+    Value data = dimOp.data();
+    uint64_t axis = dimOp.axis();
+    func::FuncOp funcOp = dimOp->getParentOfType<func::FuncOp>();
+    if (!funcOp)
+      continue;
+    // Look for an input dimension known to be the same unknown dimension.
+    for (Value arg : funcOp.getArguments()) {
+      ShapedType argType = arg.getType().dyn_cast<ShapedType>();
+      if (!argType || !argType.hasRank())
+        continue;
+      bool replaced = false;
+      for (int64_t i = 0; i < argType.getRank(); ++i) {
+        if (!argType.isDynamicDim(i))
+          continue;
+        if (!dimAnalysis.sameUnknownDim(data, axis, arg, i))
+          continue;
+        OpBuilder b(dimOp);
+        onnx_mlir::MultiDialectBuilder<onnx_mlir::OnnxBuilder> create(
+            b, dimOp.getLoc());
+        dimOp.getResult().replaceAllUsesWith(create.onnx.dim(arg, i));
+        dimOp.erase();
+        replaced = true;
+        break;
+      }
+      if (replaced)
+        break;
+    }
+  }
+}
+
 void SimplifyShapeRelatedOpsPass::runOnOperation() {
   ModuleOp moduleOp = getOperation();
   MLIRContext *context = &getContext();
@@ -544,6 +592,14 @@ void SimplifyShapeRelatedOpsPass::runOnOperation() {
     if (failed(runPipeline(pm, moduleOp)))
       return signalPassFailure();
   }
+
+  // With shapes propagated as far as possible, anchor the remaining onnx.Dim
+  // ops at the function inputs and clean up the duplicates this exposes.
+  normalizeDimOpsToInputs(moduleOp);
+  OpPassManager pm("builtin.module");
+  pm.addPass(mlir::createCSEPass());
+  if (failed(runPipeline(pm, moduleOp)))
+    signalPassFailure();
 }
 
 } // namespace
@@ -0,0 +1,190 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ StructuralCSE.cpp - ONNX structural CSE -----------------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file implements a function level pass that eliminates semantically
+// identical ONNX operations that MLIR's generic CSE misses. Multi-tower
+// models exported per tower repeat the same preprocessing subgraph several
+// times; the copies differ only in their onnx_node_name attributes and in
+// each carrying its own copy of the same constants, so generic CSE does not
+// recognize them as duplicates. The pass sweeps every block once in order,
+// fingerprinting each ONNX operation by opcode, operands, result types, and
+// attributes, where instance-naming attributes are ignored and constant
+// payloads are compared by content rather than by attribute identity, and
+// replaces an operation with the first equivalent one seen. Deduplicating an
+// operation makes its users equivalent in turn, so one in-order sweep
+// collapses whole duplicated subgraphs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/DialectResourceBlobManager.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include "src/Dialect/ONNX/ONNXOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+
+namespace {
+
+// Attributes that identify an operation instance rather than its semantics.
+bool isInstanceAttr(StringRef name) { return name == "onnx_node_name"; }
+
+// Return the raw payload bytes of an elements attribute, or None when the
+// attribute has no directly accessible raw form. Dense attributes expose
+// their uniqued storage; resource attributes (used for memory-mapped
+// external data) expose the bytes of their backing blob, which lets two
+// initializers imported from identical file regions compare equal even
+// though their resource handles differ.
+Optional<ArrayRef<char>> getElementsPayload(Attribute value) {
+  if (auto dense = value.dyn_cast<DenseElementsAttr>())
+    return dense.getRawData();
+  if (auto resource = value.dyn_cast<DenseResourceElementsAttr>())
+    if (AsmResourceBlob *blob = resource.getRawHandle().getBlob())
+      return blob->getData();
+  return llvm::None;
+}
+
+// Return true when two attributes are semantically equal: either the same
+// uniqued attribute, or elements attributes of the same type with the same
+// payload bytes.
+bool attrsEqual(Attribute attr, Attribute otherAttr) {
+  if (attr == otherAttr)
+    return true;
+  auto elements = attr.dyn_cast<TypedAttr>();
+  auto otherElements = otherAttr.dyn_cast<TypedAttr>();
+  if (!elements || !otherElements ||
+      elements.getType() != otherElements.getType())
+    return false;
+  Optional<ArrayRef<char>> payload = getElementsPayload(attr);
+  Optional<ArrayRef<char>> otherPayload = getElementsPayload(otherAttr);
+  return payload && otherPayload && *payload == *otherPayload;
+}
+
+// Structural fingerprint of an operation. Operations that may be equivalent
+// hash equal; equality is then established by areEquivalent.
+llvm::hash_code fingerprint(Operation *op) {
+  llvm::hash_code hash =
+      llvm::hash_value(op->getName().getAsOpaquePointer());
+  for (Value operand : op->getOperands())
+    hash = llvm::hash_combine(hash, operand.getAsOpaquePointer());
+  for (Type type : op->getResultTypes())
+    hash = llvm::hash_combine(hash, type.getAsOpaquePointer());
+  for (NamedAttribute attr : op->getAttrs()) {
+    if (isInstanceAttr(attr.getName().getValue()))
+      continue;
+    hash = llvm::hash_combine(hash, attr.getName().getValue());
+    // Hash elements attributes by content so that resource-backed copies of
+    // one payload land in the same bucket as their dense twins.
+    if (Optional<ArrayRef<char>> payload =
+            getElementsPayload(attr.getValue()))
+      hash = llvm::hash_combine(
+          hash, llvm::hash_value(StringRef(payload->data(), payload->size())));
+    else
+      hash = llvm::hash_combine(hash, attr.getValue().getAsOpaquePointer());
+  }
+  return hash;
+}
+
+// Return true when the two operations compute the same results: same
+// opcode, operands, and result types, and the same attributes up to
+// instance naming and constant payload identity.
+bool areEquivalent(Operation *op, Operation *other) {
+  if (op->getName() != other->getName() ||
+      op->getNumOperands() != other->getNumOperands() ||
+      op->getResultTypes() != other->getResultTypes())
+    return false;
+  for (unsigned i = 0; i < op->getNumOperands(); ++i)
+    if (op->getOperand(i) != other->getOperand(i))
+      return false;
+  // Attribute dictionaries are sorted by name, so a filtered element-wise
+  // comparison suffices.
+  SmallVector<NamedAttribute, 4> attrs, otherAttrs;
+  for (NamedAttribute attr : op->getAttrs())
+    if (!isInstanceAttr(attr.getName().getValue()))
+      attrs.emplace_back(attr);
+  for (NamedAttribute attr : other->getAttrs())
+    if (!isInstanceAttr(attr.getName().getValue()))
+      otherAttrs.emplace_back(attr);
+  if (attrs.size() != otherAttrs.size())
+    return false;
+  for (unsigned i = 0; i < attrs.size(); ++i) {
+    if (attrs[i].getName() != otherAttrs[i].getName())
+      return false;
+    if (!attrsEqual(attrs[i].getValue(), otherAttrs[i].getValue()))
+      return false;
+  }
+  return true;
+}
+
+// Candidates are pure ONNX operations without regions. Region-carrying
+// operations (Loop, Scan, If) are not deduplicated themselves, but the
+// blocks they contain are swept like any other.
+bool isCSECandidate(Operation *op) {
+  return isa<ONNXDialect>(op->getDialect()) && op->getNumRegions() == 0 &&
+         op->getNumResults() > 0 && !isa<ONNXCustomOp>(op);
+}
+
+// Sweep one block in order, replacing each candidate equivalent to an
+// earlier one with that earlier operation. In-block order guarantees the
+// surviving operation dominates every rewritten use.
+void cseBlock(Block &block) {
+  llvm::DenseMap<llvm::hash_code, SmallVector<Operation *, 2>> seen;
+  for (Operation &op : llvm::make_early_inc_range(block)) {
+    for (Region &region : op.getRegions())
+      for (Block &nested : region.getBlocks())
+        cseBlock(nested);
+    if (!isCSECandidate(&op))
+      continue;
+    SmallVector<Operation *, 2> &bucket = seen[fingerprint(&op)];
+    bool replaced = false;
+    for (Operation *earlier : bucket) {
+      if (areEquivalent(&op, earlier)) {
+        op.replaceAllUsesWith(earlier);
+        op.erase();
+        replaced = true;
+        break;
+      }
+    }
+    if (!replaced)
+      bucket.emplace_back(&op);
+  }
+}
+
+struct StructuralCSEPass
+    : public PassWrapper<StructuralCSEPass, OperationPass<func::FuncOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(StructuralCSEPass)
+
+  StringRef getArgument() const override { return "onnx-structural-cse"; }
+
+  StringRef getDescription() const override {
+    return "Eliminate semantically identical ONNX operations that differ "
+           "only in instance naming or constant identity";
+  }
+
+  void runOnOperation() final {
+    func::FuncOp funcOp = getOperation();
+    if (funcOp.getBody().empty())
+      return;
+    for (Block &block : funcOp.getBody().getBlocks())
+      cseBlock(block);
+  }
+};
+
+} // namespace
+
+/*!
+ * Create an ONNX structural CSE pass.
+ */
+std::unique_ptr<mlir::Pass> onnx_mlir::createStructuralCSEPass() {
+  return std::make_unique<StructuralCSEPass>();
+}
@@ -0,0 +1,386 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===--- PartitionParallelTasks.cpp - Run Independent Subgraphs in Parallel --===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// Loop-level parallelism does not help models whose critical path is a set of
+// independent branches (e.g. the towers of a multi-branch ranking model) that
+// are executed one after the other. This pass partitions the top-level
+// operations of a lowered function into groups that do not depend on each
+// other, outlines each group into a private function, and replaces them with
+// a single krnl.run_tasks operation that executes the outlined functions
+// concurrently on the runtime worker pool.
+//
+// Two operations end up in the same group when one uses an SSA value produced
+// by the other, or when they access the same buffer and at least one of them
+// writes to it. Buffers that are only ever read (function arguments and
+// constant globals) can be shared freely between groups.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/MapVector.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// Return true if `op` stays in the parent function: allocations, constant
+/// globals, effect-free computations and the terminator. Everything else is
+/// work that can be assigned to a task.
+static bool staysInMain(Operation *op) {
+  if (isa<memref::AllocOp, memref::AllocaOp, memref::DeallocOp, KrnlGlobalOp,
+          func::ReturnOp>(op))
+    return true;
+  // The krnl loop bookkeeping operations must travel with their loop nest.
+  if (isa<KrnlDefineLoopsOp, KrnlBlockOp, KrnlPermuteOp, KrnlParallelOp,
+          KrnlUnrollOp>(op))
+    return false;
+  if (op->getNumRegions() > 0)
+    return false;
+  auto effectInterface = dyn_cast<MemoryEffectOpInterface>(op);
+  if (!effectInterface)
+    return false;
+  SmallVector<MemoryEffects::EffectInstance, 4> effects;
+  effectInterface.getEffects(effects);
+  return effects.empty();
+}
+
+/// Return true if `op` and everything nested under it only performs memory
+/// accesses whose ordering is captured by the dependence analysis below.
+/// Operations with observable side effects (prints, instrumentation) keep
+/// their function sequential.
+static bool isSchedulableWork(Operation *root) {
+  WalkResult result = root->walk([&](Operation *op) {
+    if (isa<KrnlPrintOp, KrnlPrintTensorOp, KrnlInstrumentOp,
+            KrnlInstrumentMemoryOp, KrnlRunTasksOp>(op))
+      return WalkResult::interrupt();
+    Dialect *dialect = op->getDialect();
+    if (isa<KrnlDialect, arith::ArithDialect, math::MathDialect,
+            AffineDialect, memref::MemRefDialect, scf::SCFDialect,
+            vector::VectorDialect>(dialect))
+      return WalkResult::advance();
+    // The zlow operations (NNPA) are synchronous library calls whose buffer
+    // accesses are fully described by their declared effects. Scheduling
+    // independent zlow chains as separate tasks lets the stickification of
+    // one branch run on the CPU while another branch occupies the
+    // accelerator. Matched by name so that this pass does not depend on the
+    // optionally built accelerator libraries.
+    if (dialect->getNamespace() == "zlow")
+      return WalkResult::advance();
+    return WalkResult::interrupt();
+  });
+  return !result.wasInterrupted();
+}
+
+/// Walk up view-like operations (memref.cast, subviews, ...) to the value the
+/// views are carved out of.
+static Value getBaseBuffer(Value value) {
+  while (Operation *defOp = value.getDefiningOp()) {
+    auto viewLike = dyn_cast<ViewLikeOpInterface>(defOp);
+    if (!viewLike)
+      break;
+    value = viewLike.getViewSource();
+  }
+  return value;
+}
+
+/// Record in `reads` and `writes` the base buffers accessed by `root` and the
+/// operations nested under it. Only buffers visible at function level matter
+/// for the dependence analysis; accesses to buffers created inside `root`
+/// stay local to the task. Unknown operations conservatively count as writes
+/// to all their memref operands.
+static void collectBufferAccesses(Operation *root, Region &funcBody,
+    SmallPtrSetImpl<Value> &reads, SmallPtrSetImpl<Value> &writes) {
+  auto record = [&](Value buffer, bool isWrite) {
+    Value base = getBaseBuffer(buffer);
+    if (base.getParentRegion() != &funcBody)
+      return;
+    if (isWrite)
+      writes.insert(base);
+    else
+      reads.insert(base);
+  };
+
+  root->walk([&](Operation *op) {
+    if (auto effectInterface = dyn_cast<MemoryEffectOpInterface>(op)) {
+      SmallVector<MemoryEffects::EffectInstance, 4> effects;
+      effectInterface.getEffects(effects);
+      for (MemoryEffects::EffectInstance &effect : effects) {
+        Value value = effect.getValue();
+        if (!value || !value.getType().isa<BaseMemRefType>())
+          continue;
+        record(value, !isa<MemoryEffects::Read>(effect.getEffect()));
+      }
+      return;
+    }
+    // Operations without effect information: the structured krnl operations
+    // only read their memref operands through nested loads/stores, which the
+    // walk visits separately; anything else is treated as a write.
+    if (isa<KrnlIterateOp, KrnlRegionOp, scf::ForOp, scf::IfOp,
+            scf::ParallelOp, scf::YieldOp, KrnlTerminatorOp>(op))
+      return;
+    if (auto memcpyOp = dyn_cast<KrnlMemcpyOp>(op)) {
+      record(memcpyOp.dest(), /*isWrite=*/true);
+      record(memcpyOp.src(), /*isWrite=*/false);
+      return;
+    }
+    for (Value operand : op->getOperands())
+      if (operand.getType().isa<BaseMemRefType>())
+        record(operand, /*isWrite=*/true);
+  });
+}
+
+/// Simple union-find over the indices of the top-level task candidates.
+static int64_t findRoot(SmallVectorImpl<int64_t> &parent, int64_t i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+static void unionSets(SmallVectorImpl<int64_t> &parent, int64_t a, int64_t b) {
+  parent[findRoot(parent, a)] = findRoot(parent, b);
+}
+
+struct PartitionParallelTasksPass
+    : public PassWrapper<PartitionParallelTasksPass, OperationPass<ModuleOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(PartitionParallelTasksPass)
+
+  StringRef getArgument() const override { return "partition-parallel-tasks"; }
+
+  StringRef getDescription() const override {
+    return "Outline independent subgraphs into functions executed "
+           "concurrently on the runtime worker pool.";
+  }
+
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    for (auto funcOp :
+        llvm::make_early_inc_range(module.getOps<func::FuncOp>()))
+      partitionFunction(module, funcOp);
+  }
+
+private:
+  void partitionFunction(ModuleOp module, func::FuncOp funcOp) {
+    if (funcOp.getBody().getBlocks().size() != 1)
+      return;
+    Region &funcBody = funcOp.getBody();
+    Block &entryBlock = funcBody.front();
+
+    // Gather the task candidates: every top-level operation that represents
+    // work. Give up on the whole function when an operation whose ordering
+    // cannot be analyzed is found.
+    SmallVector<Operation *> candidates;
+    DenseMap<Operation *, int64_t> candidateIdx;
+    for (Operation &op : entryBlock) {
+      if (staysInMain(&op))
+        continue;
+      if (!isSchedulableWork(&op))
+        return;
+      candidateIdx[&op] = candidates.size();
+      candidates.emplace_back(&op);
+    }
+    if (candidates.size() < 2)
+      return;
+
+    // Union the candidates connected by SSA def-use chains.
+    SmallVector<int64_t> parent(candidates.size());
+    for (int64_t i = 0, e = candidates.size(); i < e; ++i)
+      parent[i] = i;
+    for (int64_t i = 0, e = candidates.size(); i < e; ++i) {
+      candidates[i]->walk([&](Operation *op) {
+        for (Value operand : op->getOperands()) {
+          Operation *defOp = operand.getDefiningOp();
+          if (defOp && candidateIdx.count(defOp))
+            unionSets(parent, i, candidateIdx[defOp]);
+        }
+      });
+      // Results used by an operation that stays in the main function (e.g.
+      // the terminator) pin the candidate there; give up in that case.
+      for (Value result : candidates[i]->getResults()) {
+        for (Operation *user : result.getUsers()) {
+          while (user->getBlock() != &entryBlock)
+            user = user->getParentOp();
+          if (!candidateIdx.count(user))
+            return;
+        }
+      }
+    }
+
+    // Union the candidates that access the same buffer when at least one of
+    // them writes to it. A write to a function argument would invalidate the
+    // assumption that arguments are read-only; give up when one is found.
+    SmallVector<SmallPtrSet<Value, 8>> reads(candidates.size());
+    SmallVector<SmallPtrSet<Value, 8>> writes(candidates.size());
+    for (int64_t i = 0, e = candidates.size(); i < e; ++i) {
+      collectBufferAccesses(candidates[i], funcBody, reads[i], writes[i]);
+      for (Value buffer : writes[i])
+        if (buffer.isa<BlockArgument>())
+          return;
+    }
+
+    // The krnl.run_tasks lowering marshals ranked memrefs and scalars only.
+    for (Operation *candidate : candidates) {
+      bool hasUnrankedOperand = false;
+      candidate->walk([&](Operation *op) {
+        for (Value operand : op->getOperands())
+          if (operand.getParentRegion() == &funcBody &&
+              operand.getType().isa<UnrankedMemRefType>())
+            hasUnrankedOperand = true;
+      });
+      if (hasUnrankedOperand)
+        return;
+    }
+    for (int64_t i = 0, e = candidates.size(); i < e; ++i)
+      for (Value buffer : writes[i])
+        for (int64_t j = 0; j < e; ++j)
+          if (j != i && (writes[j].count(buffer) || reads[j].count(buffer)))
+            unionSets(parent, i, j);
+
+    // Collect the groups, keeping the operations in program order, and
+    // require at least two groups with substantial work (a loop nest or an
+    // accelerator call) for the partitioning to be worthwhile.
+    llvm::MapVector<int64_t, SmallVector<Operation *>> groups;
+    for (int64_t i = 0, e = candidates.size(); i < e; ++i)
+      groups[findRoot(parent, i)].emplace_back(candidates[i]);
+    int64_t numGroupsWithLoops = 0;
+    for (auto &group : groups)
+      if (llvm::any_of(group.second, [](Operation *op) {
+            return op->walk([](Operation *innerOp) {
+                       if (isa<KrnlIterateOp>(innerOp) ||
+                           innerOp->getDialect()->getNamespace() == "zlow")
+                         return WalkResult::interrupt();
+                       return WalkResult::advance();
+                     }).wasInterrupted();
+          }))
+        numGroupsWithLoops++;
+    if (numGroupsWithLoops < 2)
+      return;
+
+    // Outline every group into a private function taking the values the
+    // group uses but does not define. Constants are cloned into the outlined
+    // function instead of being passed around.
+    OpBuilder moduleBuilder(module.getContext());
+    moduleBuilder.setInsertionPointAfter(funcOp);
+    SmallVector<FlatSymbolRefAttr> callees;
+    SmallVector<int64_t> segmentSizes;
+    SmallVector<Value> taskOperands;
+    int64_t taskIdx = 0;
+    for (auto &group : groups) {
+      ArrayRef<Operation *> groupOps = group.second;
+      DenseSet<Operation *> groupSet(groupOps.begin(), groupOps.end());
+
+      // External values used by the group, in first-use order. Values
+      // defined below the top level belong to the group itself.
+      SmallVector<Value> externalValues;
+      SmallVector<Operation *> constantsToClone;
+      llvm::SmallPtrSet<Value, 16> seenValues;
+      llvm::SmallPtrSet<Operation *, 8> seenConstants;
+      for (Operation *groupOp : groupOps) {
+        groupOp->walk([&](Operation *op) {
+          for (Value operand : op->getOperands()) {
+            if (operand.getParentRegion() != &funcBody)
+              continue;
+            Operation *defOp = operand.getDefiningOp();
+            if (defOp && groupSet.count(defOp))
+              continue;
+            if (defOp && matchPattern(defOp, m_Constant())) {
+              if (seenConstants.insert(defOp).second)
+                constantsToClone.emplace_back(defOp);
+              continue;
+            }
+            if (seenValues.insert(operand).second)
+              externalValues.emplace_back(operand);
+          }
+        });
+      }
+
+      // Create the task function and clone the group into it.
+      std::string taskName =
+          (funcOp.getName() + "_task" + Twine(taskIdx++)).str();
+      while (module.lookupSymbol(taskName))
+        taskName += "_";
+      SmallVector<Type> argTypes;
+      for (Value value : externalValues)
+        argTypes.emplace_back(value.getType());
+      auto taskType =
+          FunctionType::get(module.getContext(), argTypes, /*results=*/{});
+      auto taskFunc = moduleBuilder.create<func::FuncOp>(
+          funcOp.getLoc(), taskName, taskType);
+      taskFunc.setPrivate();
+      Block *taskBlock = taskFunc.addEntryBlock();
+      OpBuilder taskBuilder = OpBuilder::atBlockBegin(taskBlock);
+      BlockAndValueMapping mapping;
+      for (auto [value, arg] :
+          llvm::zip(externalValues, taskBlock->getArguments()))
+        mapping.map(value, arg);
+      for (Operation *constantOp : constantsToClone)
+        taskBuilder.clone(*constantOp, mapping);
+      for (Operation *groupOp : groupOps)
+        taskBuilder.clone(*groupOp, mapping);
+      taskBuilder.create<func::ReturnOp>(funcOp.getLoc());
+
+      callees.emplace_back(
+          FlatSymbolRefAttr::get(module.getContext(), taskName));
+      segmentSizes.emplace_back(externalValues.size());
+      taskOperands.append(externalValues.begin(), externalValues.end());
+    }
+
+    // Replace the groups with a single rendezvous. It is inserted after the
+    // last outlined operation so that every operand is already defined;
+    // deallocations of buffers the tasks use are moved below it.
+    Operation *lastOp = candidates.back();
+    OpBuilder builder(funcOp.getContext());
+    builder.setInsertionPointAfter(lastOp);
+    auto runTasksOp = builder.create<KrnlRunTasksOp>(funcOp.getLoc(),
+        builder.getArrayAttr(SmallVector<Attribute>(
+            callees.begin(), callees.end())),
+        builder.getI64ArrayAttr(segmentSizes), taskOperands);
+
+    for (Operation *candidate : llvm::reverse(candidates))
+      candidate->erase();
+
+    SmallVector<Operation *> deallocsToMove;
+    for (Operation &op : entryBlock) {
+      if (&op == runTasksOp.getOperation())
+        break;
+      if (isa<memref::DeallocOp>(&op))
+        deallocsToMove.emplace_back(&op);
+    }
+    for (Operation *deallocOp : deallocsToMove)
+      deallocOp->moveAfter(runTasksOp);
+  }
+};
+
+} // namespace
+
+namespace onnx_mlir {
+namespace krnl {
+
+/// Create a pass that runs independent subgraphs on the runtime worker pool.
+std::unique_ptr<mlir::Pass> createPartitionParallelTasksPass() {
+  return std::make_unique<PartitionParallelTasksPass>();
+}
+
+} // namespace krnl
+} // namespace onnx_mlir
@@ -0,0 +1,207 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ ScratchMemoryBudget.cpp - Scratch Memory Budget ---------------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This pass computes the worst-case transient (scratch) memory of a compiled
+// function by summing the sizes of its allocation sites after the memory
+// pools have been bundled. Sites with static shapes contribute an exact byte
+// count; sites with dynamic dimensions are reported symbolically as a static
+// byte factor times their dynamic extents. The pass can print a compile-time
+// budget report, and with a byte limit it rejects models whose static
+// worst case alone exceeds the limit and guards the remaining dynamic
+// allocations at runtime so an oversized request fails fast instead of
+// running the process into the operating system's out-of-memory killer.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Dialect/Mlir/DialectBuilder.hpp"
+#include "src/Pass/Passes.hpp"
+#include "src/Support/KrnlSupport.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// Return the number of bytes covered by the static dimensions of the buffer
+/// created by `allocOp`: the element size times every non-dynamic dimension.
+/// For a fully static buffer this is the exact allocation size.
+static int64_t getStaticAllocBytes(memref::AllocOp allocOp) {
+  MemRefType memRefType = allocOp.getResult().getType().cast<MemRefType>();
+  int64_t staticSizeInBytes = getMemRefEltSizeInBytes(memRefType);
+  for (int64_t dim : memRefType.getShape())
+    if (!ShapedType::isDynamic(dim))
+      staticSizeInBytes *= dim;
+  return staticSizeInBytes;
+}
+
+/// Emit the full size in bytes of the buffer created by `allocOp`, folding
+/// the static dimensions into a constant and multiplying in the dynamic ones
+/// directly from the alloc operands.
+static Value emitAllocSizeInBytes(
+    OpBuilder &builder, Location loc, memref::AllocOp allocOp) {
+  MultiDialectBuilder<MathBuilder> create(builder, loc);
+  Value sizeInBytes = create.math.constant(
+      builder.getI64Type(), getStaticAllocBytes(allocOp));
+  for (Value dynamicSize : allocOp.getDynamicSizes()) {
+    Value dim = builder.create<arith::IndexCastOp>(
+        loc, builder.getI64Type(), dynamicSize);
+    sizeInBytes = create.math.mul(sizeInBytes, dim);
+  }
+  return sizeInBytes;
+}
+
+/*!
+ * This pass reports and optionally enforces the worst-case scratch memory of
+ * a function. It runs after memory bundling, where the static pools already
+ * aggregate most intermediate buffers, so summing the remaining allocation
+ * sites gives a deterministic upper bound for static shapes.
+ */
+class ScratchMemoryBudgetPass : public mlir::PassWrapper<
+                                    ScratchMemoryBudgetPass,
+                                    OperationPass<func::FuncOp>> {
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(ScratchMemoryBudgetPass)
+
+  ScratchMemoryBudgetPass() = default;
+  ScratchMemoryBudgetPass(const ScratchMemoryBudgetPass &pass)
+      : mlir::PassWrapper<ScratchMemoryBudgetPass,
+            OperationPass<func::FuncOp>>() {}
+  ScratchMemoryBudgetPass(bool report, int64_t limitBytes) {
+    this->report = report;
+    this->limitBytes = limitBytes;
+  }
+
+  StringRef getArgument() const override { return "scratch-memory-budget"; }
+
+  StringRef getDescription() const override {
+    return "report and optionally enforce the worst-case scratch memory of a "
+           "function.";
+  }
+
+  Option<bool> report{*this, "report",
+      llvm::cl::desc("Print the scratch memory budget report."),
+      llvm::cl::init(false)};
+
+  Option<int64_t> limitBytes{*this, "limit",
+      llvm::cl::desc("Maximum number of live scratch bytes allowed, 0 means "
+                     "no limit."),
+      llvm::cl::init(0)};
+
+  void runOnOperation() override {
+    func::FuncOp funcOp = getOperation();
+
+    SmallVector<memref::AllocOp, 16> allocs;
+    funcOp.walk([&](memref::AllocOp allocOp) { allocs.emplace_back(allocOp); });
+    if (allocs.empty())
+      return;
+
+    int64_t staticWorstCaseBytes = 0;
+    SmallVector<memref::AllocOp, 4> dynamicAllocs;
+    for (memref::AllocOp allocOp : allocs) {
+      if (allocOp.getDynamicSizes().empty())
+        staticWorstCaseBytes += getStaticAllocBytes(allocOp);
+      else
+        dynamicAllocs.emplace_back(allocOp);
+    }
+
+    if (report)
+      printReport(funcOp, allocs.size(), staticWorstCaseBytes, dynamicAllocs);
+
+    if (limitBytes <= 0)
+      return;
+
+    // The static worst case is known now; reject the model at compile time
+    // when it cannot fit, rather than shipping a binary that is guaranteed
+    // to trip the runtime guard.
+    if (staticWorstCaseBytes > limitBytes) {
+      funcOp.emitError()
+          << "worst-case static scratch memory (" << staticWorstCaseBytes
+          << " bytes) exceeds the scratch memory limit (" << limitBytes.getValue()
+          << " bytes)";
+      signalPassFailure();
+      return;
+    }
+
+    // Dynamic dimensions are only known at runtime; guard every allocation
+    // site so an oversized request fails fast with a diagnostic. Fully
+    // static functions have already been checked above and carry no guards.
+    if (!dynamicAllocs.empty())
+      insertRuntimeGuards(funcOp, allocs);
+  }
+
+private:
+  void printReport(func::FuncOp funcOp, size_t numAllocs,
+      int64_t staticWorstCaseBytes,
+      ArrayRef<memref::AllocOp> dynamicAllocs) const {
+    llvm::outs() << "Scratch memory report for function '" << funcOp.getName()
+                 << "':\n";
+    llvm::outs() << "  allocation sites: " << numAllocs
+                 << ", static worst case: " << staticWorstCaseBytes
+                 << " bytes\n";
+    for (memref::AllocOp allocOp : dynamicAllocs) {
+      llvm::outs() << "  dynamic site: " << getStaticAllocBytes(allocOp)
+                   << " bytes x dynamic dims of "
+                   << allocOp.getResult().getType() << " at "
+                   << allocOp.getLoc() << "\n";
+    }
+  }
+
+  void insertRuntimeGuards(
+      func::FuncOp funcOp, ArrayRef<memref::AllocOp> allocs) {
+    // Record the size emitted for each alloc so the matching dealloc releases
+    // the same number of bytes, including for dynamic shapes.
+    DenseMap<Value, Value> sizeForBuffer;
+
+    for (memref::AllocOp allocOp : allocs) {
+      Location loc = allocOp.getLoc();
+      OpBuilder builder(allocOp.getOperation());
+      Value sizeInBytes = emitAllocSizeInBytes(builder, loc, allocOp);
+      builder.create<KrnlCheckScratchMemoryOp>(loc, sizeInBytes,
+          builder.getI64IntegerAttr(limitBytes));
+      sizeForBuffer[allocOp.getResult()] = sizeInBytes;
+    }
+
+    funcOp.walk([&](memref::DeallocOp deallocOp) {
+      // Look through casts to find the original allocation.
+      Value buffer = deallocOp.getMemref();
+      while (auto castOp = buffer.getDefiningOp<memref::CastOp>())
+        buffer = castOp.getSource();
+      auto entry = sizeForBuffer.find(buffer);
+      if (entry == sizeForBuffer.end())
+        return;
+      Location loc = deallocOp.getLoc();
+      OpBuilder builder(deallocOp.getOperation());
+      MultiDialectBuilder<MathBuilder> create(builder, loc);
+      Value zero = create.math.constant(builder.getI64Type(), 0);
+      Value negatedSize = create.math.sub(zero, entry->second);
+      builder.create<KrnlCheckScratchMemoryOp>(
+          loc, negatedSize, builder.getI64IntegerAttr(limitBytes));
+    });
+  }
+};
+
+} // namespace
+
+/*!
+ * Create a scratch memory budget pass.
+ */
+std::unique_ptr<mlir::Pass> onnx_mlir::krnl::createScratchMemoryBudgetPass() {
+  return std::make_unique<ScratchMemoryBudgetPass>();
+}
+
+std::unique_ptr<mlir::Pass> onnx_mlir::krnl::createScratchMemoryBudgetPass(
+    bool report, int64_t limitBytes) {
+  return std::make_unique<ScratchMemoryBudgetPass>(report, limitBytes);
+}
@@ -0,0 +1,118 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ ShrinkAllocLifetimes.cpp - Free Buffers After Last Use --------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// The lowering places most deallocations conservatively at the end of the
+// function (see insertDealloc in ONNXToKrnlCommon.cpp), so every transient
+// buffer stays live until the model returns and the peak resident memory is
+// close to the sum of all intermediates. This pass computes the last use of
+// each deallocated buffer, following view-producing operations so aliases
+// count as uses, and moves the deallocation immediately after it; buffers
+// with disjoint live ranges then no longer overlap at peak. Along the way it
+// verifies the dataflow: a use ordered after the deallocation is reported as
+// an error instead of being silently reordered.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Interfaces/ViewLikeInterface.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Pass/Passes.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// Collect every operation that uses `value` or a view derived from it.
+/// Return false when the buffer may be referenced past the collected uses:
+/// returned from the function or aliased through a krnl.getref, whose
+/// lifetime belongs to the memory pool passes.
+static bool collectTransitiveUsers(
+    Value value, Operation *deallocOp, SmallVectorImpl<Operation *> &users) {
+  for (OpOperand &use : value.getUses()) {
+    Operation *user = use.getOwner();
+    if (user == deallocOp)
+      continue;
+    if (isa<func::ReturnOp, KrnlGetRefOp>(user))
+      return false;
+    users.emplace_back(user);
+    if (auto viewOp = dyn_cast<ViewLikeOpInterface>(user))
+      if (viewOp.getViewSource() == value &&
+          !collectTransitiveUsers(user->getResult(0), deallocOp, users))
+        return false;
+  }
+  return true;
+}
+
+/// Move `deallocOp` immediately after the last use of its buffer. Return
+/// failure on a use ordered after the deallocation.
+static LogicalResult shrinkLifetime(memref::DeallocOp deallocOp) {
+  Value buffer = deallocOp.getMemref();
+  Operation *allocOp = buffer.getDefiningOp();
+  if (!allocOp || !isa<memref::AllocOp, memref::AllocaOp>(allocOp))
+    return success();
+  SmallVector<Operation *, 16> users;
+  if (!collectTransitiveUsers(buffer, deallocOp.getOperation(), users))
+    return success();
+
+  // Order uses by their ancestor in the deallocation's block, so a use
+  // buried in a loop body keeps the buffer live until the whole loop is
+  // done. A use with no such ancestor is on another control path; leave
+  // the deallocation where the lowering put it.
+  Block *deallocBlock = deallocOp->getBlock();
+  Operation *lastUse = deallocBlock->findAncestorOpInBlock(*allocOp);
+  for (Operation *user : users) {
+    Operation *ancestor = deallocBlock->findAncestorOpInBlock(*user);
+    if (!ancestor)
+      return success();
+    if (!lastUse || lastUse->isBeforeInBlock(ancestor))
+      lastUse = ancestor;
+  }
+  if (!lastUse)
+    return success();
+  if (deallocOp->isBeforeInBlock(lastUse))
+    return lastUse->emitError(
+        "buffer is used after its memref.dealloc; the deallocation was "
+        "misplaced by an earlier pass");
+  deallocOp->moveAfter(lastUse);
+  return success();
+}
+
+class ShrinkAllocLifetimesPass
+    : public PassWrapper<ShrinkAllocLifetimesPass,
+          OperationPass<func::FuncOp>> {
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(ShrinkAllocLifetimesPass)
+
+  StringRef getArgument() const override { return "shrink-alloc-lifetimes"; }
+
+  StringRef getDescription() const override {
+    return "Move each memref.dealloc immediately after the last use of its "
+           "buffer to reduce peak memory.";
+  }
+
+  void runOnOperation() override {
+    // Collect first: shrinking moves operations under the walk.
+    SmallVector<memref::DeallocOp, 16> deallocs;
+    getOperation().walk(
+        [&](memref::DeallocOp deallocOp) { deallocs.emplace_back(deallocOp); });
+    for (memref::DeallocOp deallocOp : deallocs)
+      if (failed(shrinkLifetime(deallocOp)))
+        return signalPassFailure();
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass> onnx_mlir::krnl::createShrinkAllocLifetimesPass() {
+  return std::make_unique<ShrinkAllocLifetimesPass>();
+}
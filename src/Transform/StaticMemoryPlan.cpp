@@ -0,0 +1,330 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//===------ StaticMemoryPlan.cpp - Whole-graph static memory plan ---------===//
+//
+// Copyright 2023 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This pass computes one compile-time memory plan per static memory pool
+// emitted by the BundleMemoryPool pass. Instead of the pairwise slot reuse
+// performed by KrnlOptimizeMemoryPools, every buffer in the pool is given a
+// live interval over the function's top-level operations and the buffers are
+// packed into a single arena with first-fit-decreasing placement: two buffers
+// may overlap in the arena only when their live intervals are disjoint. The
+// arena size is the plan's peak memory, a compile-time constant that can be
+// printed here and audited against a limit by the scratch memory budget pass
+// that runs next.
+//
+// Live intervals are deliberately coarse: a use nested inside a loop extends
+// the interval over the whole top-level loop nest, and aliasing views extend
+// it over the users of the view. Coarse intervals can only make the plan
+// larger, never incorrect.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Pass/Pass.h"
+
+#include "src/Dialect/Krnl/DialectBuilder.hpp"
+#include "src/Dialect/Krnl/KrnlOps.hpp"
+#include "src/Pass/Passes.hpp"
+#include "src/Support/KrnlSupport.hpp"
+
+using namespace mlir;
+using namespace onnx_mlir;
+
+namespace {
+
+/// One buffer of the plan: all krnl.getref operations that currently share a
+/// pool offset, the bytes they occupy, and the live interval of the slot
+/// expressed as positions of the function's top-level operations.
+struct PlannedBuffer {
+  SmallVector<KrnlGetRefOp, 4> getRefs;
+  int64_t sizeInBytes = 0;
+  size_t firstUse = 0;
+  size_t lastUse = 0;
+  bool hasUses = false;
+  int64_t plannedOffset = 0;
+};
+
+/// Return the numeric offset of a krnl.getref, or None when the offset is not
+/// a compile-time constant (dynamic pools are not planned).
+Optional<int64_t> getConstantOffset(KrnlGetRefOp getRefOp) {
+  auto constOp = getRefOp.offset().getDefiningOp<arith::ConstantOp>();
+  if (!constOp)
+    return llvm::None;
+  auto intAttr = constOp.getValue().dyn_cast<IntegerAttr>();
+  if (!intAttr)
+    return llvm::None;
+  return intAttr.getInt();
+}
+
+/// Round up `value` to the next multiple of `alignment` (no-op when the
+/// alignment is not positive).
+int64_t alignUp(int64_t value, int64_t alignment) {
+  if (alignment <= 0)
+    return value;
+  int64_t misalignment = value % alignment;
+  if (misalignment > 0)
+    value += alignment - misalignment;
+  return value;
+}
+
+/// Compute the live interval of `buffer` over the top-level operations of
+/// `block`, whose positions are given by `position`. Uses nested inside a
+/// loop are attributed to the enclosing top-level operation and views derived
+/// from the buffer (casts, reinterpret casts) extend the interval over their
+/// own users. Returns false when a use cannot be attributed to a top-level
+/// operation, in which case the pool must not be planned.
+bool computeLiveInterval(Block *block,
+    const DenseMap<Operation *, size_t> &position, PlannedBuffer &buffer) {
+  SmallVector<Value, 4> worklist;
+  DenseSet<Value> visited;
+  for (KrnlGetRefOp getRefOp : buffer.getRefs)
+    worklist.emplace_back(getRefOp.getResult());
+
+  while (!worklist.empty()) {
+    Value alias = worklist.pop_back_val();
+    if (!visited.insert(alias).second)
+      continue;
+    for (Operation *user : alias.getUsers()) {
+      Operation *topLevelOp = block->findAncestorOpInBlock(*user);
+      if (!topLevelOp)
+        return false;
+      size_t pos = position.lookup(topLevelOp);
+      if (!buffer.hasUses) {
+        buffer.firstUse = buffer.lastUse = pos;
+        buffer.hasUses = true;
+      } else {
+        buffer.firstUse = std::min(buffer.firstUse, pos);
+        buffer.lastUse = std::max(buffer.lastUse, pos);
+      }
+      // Any memref result of a user is treated as a view of the buffer and
+      // its users extend the live interval as well.
+      for (Value result : user->getResults())
+        if (result.getType().isa<MemRefType>())
+          worklist.emplace_back(result);
+    }
+  }
+  return true;
+}
+
+/// Returns true if the live intervals of the two buffers overlap. A buffer
+/// without uses is live nowhere and never overlaps.
+bool liveIntervalsOverlap(const PlannedBuffer &a, const PlannedBuffer &b) {
+  if (!a.hasUses || !b.hasUses)
+    return false;
+  return a.firstUse <= b.lastUse && b.firstUse <= a.lastUse;
+}
+
+/*!
+ * Function pass that replaces the offsets of each static memory pool with a
+ * whole-graph memory plan and shrinks the pool to the plan's peak size.
+ */
+class KrnlStaticMemoryPlanPass
+    : public PassWrapper<KrnlStaticMemoryPlanPass,
+          OperationPass<func::FuncOp>> {
+public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(KrnlStaticMemoryPlanPass)
+
+  KrnlStaticMemoryPlanPass() = default;
+  KrnlStaticMemoryPlanPass(const KrnlStaticMemoryPlanPass &pass)
+      : PassWrapper<KrnlStaticMemoryPlanPass, OperationPass<func::FuncOp>>() {}
+  KrnlStaticMemoryPlanPass(bool report) { this->report = report; }
+
+  StringRef getArgument() const override { return "static-memory-plan"; }
+
+  StringRef getDescription() const override {
+    return "Pack the buffers of each static memory pool into a single arena "
+           "using liveness-colored compile-time offsets.";
+  }
+
+  Option<bool> report{*this, "report",
+      llvm::cl::desc("Print the memory plan of each planned pool."),
+      llvm::cl::init(false)};
+
+  void runOnOperation() override {
+    func::FuncOp funcOp = getOperation();
+    if (funcOp.getBody().empty())
+      return;
+    Block *entryBlock = &funcOp.getBody().front();
+
+    // Number the top-level operations once; the positions order the live
+    // intervals of every pool in the function.
+    DenseMap<Operation *, size_t> position;
+    size_t index = 0;
+    for (Operation &op : *entryBlock)
+      position[&op] = index++;
+
+    // Plan each static memory pool of the top-level block.
+    SmallVector<memref::AllocOp, 4> pools;
+    for (Operation &op : *entryBlock)
+      if (auto allocOp = dyn_cast<memref::AllocOp>(&op))
+        if (isStaticPool(allocOp))
+          pools.emplace_back(allocOp);
+
+    for (memref::AllocOp pool : pools)
+      planPool(funcOp, entryBlock, position, pool);
+  }
+
+private:
+  /// Returns true if the alloc is a static memory pool produced by the bundle
+  /// pass: a statically shaped rank-1 byte buffer used by krnl.getref.
+  bool isStaticPool(memref::AllocOp allocOp) {
+    auto memPoolType = allocOp.getResult().getType().dyn_cast<MemRefType>();
+    if (!memPoolType || !hasAllConstantDimensions(memPoolType))
+      return false;
+    if (getMemRefEltSizeInBytes(memPoolType) != 1)
+      return false;
+    if (memPoolType.getShape().size() != 1)
+      return false;
+    return getAllocGetRefNum(&allocOp) >= 1;
+  }
+
+  /// Plan one static memory pool: compute the live interval of every buffer,
+  /// pack the buffers into the smallest arena the intervals allow, and
+  /// re-emit the pool and its getrefs with the planned offsets.
+  void planPool(func::FuncOp funcOp, Block *entryBlock,
+      const DenseMap<Operation *, size_t> &position, memref::AllocOp pool) {
+    int64_t alignment = getAllocAlignment(pool);
+
+    // Group the getrefs of this pool by their current offset; getrefs with
+    // the same offset already share a slot and must keep doing so.
+    std::map<int64_t, PlannedBuffer> bufferByOffset;
+    bool planable = true;
+    entryBlock->walk([&](KrnlGetRefOp getRefOp) {
+      if (getRefOp.mempool() != pool.getResult())
+        return;
+      Optional<int64_t> offset = getConstantOffset(getRefOp);
+      auto memRefType = getRefOp.getResult().getType().dyn_cast<MemRefType>();
+      if (!offset.has_value() || !memRefType ||
+          !hasAllConstantDimensions(memRefType)) {
+        planable = false;
+        return;
+      }
+      PlannedBuffer &buffer = bufferByOffset[offset.value()];
+      buffer.getRefs.emplace_back(getRefOp);
+      buffer.sizeInBytes = std::max(buffer.sizeInBytes,
+          alignUp(getMemRefSizeInBytes(getRefOp.getResult()), alignment));
+    });
+    if (!planable || bufferByOffset.empty())
+      return;
+
+    SmallVector<PlannedBuffer, 16> buffers;
+    for (auto &entry : bufferByOffset) {
+      PlannedBuffer &buffer = entry.second;
+      if (!computeLiveInterval(entryBlock, position, buffer))
+        return;
+      buffers.emplace_back(buffer);
+    }
+
+    // First-fit-decreasing placement: largest buffers first, ties broken by
+    // first use so the plan is deterministic. Each buffer takes the lowest
+    // aligned offset that is free for its whole live interval.
+    SmallVector<size_t, 16> order;
+    for (size_t i = 0; i < buffers.size(); ++i)
+      order.emplace_back(i);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      if (buffers[a].sizeInBytes != buffers[b].sizeInBytes)
+        return buffers[a].sizeInBytes > buffers[b].sizeInBytes;
+      return buffers[a].firstUse < buffers[b].firstUse;
+    });
+
+    int64_t arenaSize = 0;
+    SmallVector<size_t, 16> placed;
+    for (size_t bufferIdx : order) {
+      PlannedBuffer &buffer = buffers[bufferIdx];
+
+      // Collect the arena ranges occupied by already placed buffers whose
+      // live intervals overlap this one, in increasing offset order.
+      SmallVector<std::pair<int64_t, int64_t>, 16> occupied;
+      for (size_t placedIdx : placed)
+        if (liveIntervalsOverlap(buffer, buffers[placedIdx]))
+          occupied.emplace_back(buffers[placedIdx].plannedOffset,
+              buffers[placedIdx].plannedOffset +
+                  buffers[placedIdx].sizeInBytes);
+      std::sort(occupied.begin(), occupied.end());
+
+      int64_t offset = 0;
+      for (auto &range : occupied) {
+        if (offset + buffer.sizeInBytes <= range.first)
+          break;
+        offset = std::max(offset, alignUp(range.second, alignment));
+      }
+      buffer.plannedOffset = offset;
+      arenaSize = std::max(arenaSize, offset + buffer.sizeInBytes);
+      placed.emplace_back(bufferIdx);
+    }
+
+    auto memPoolType = pool.getResult().getType().cast<MemRefType>();
+    int64_t poolSize = memPoolType.getShape()[0];
+    int64_t requestedBytes = 0;
+    for (PlannedBuffer &buffer : buffers)
+      requestedBytes += buffer.sizeInBytes;
+
+    if (report)
+      printReport(funcOp, buffers.size(), requestedBytes, arenaSize);
+
+    // The plan's peak is the compile-time footprint of the pool; when it
+    // matches the current pool size there is no reuse to materialize.
+    if (arenaSize >= poolSize)
+      return;
+
+    // Re-emit the pool at its planned size and every getref at its planned
+    // offset.
+    Location loc = pool.getLoc();
+    OpBuilder builder(pool.getOperation());
+    MultiDialectBuilder<KrnlBuilder, MemRefBuilder> create(builder, loc);
+
+    auto arenaType =
+        MemRefType::get({arenaSize}, builder.getIntegerType(8));
+    memref::AllocOp arena =
+        (pool.getAlignment().has_value())
+            ? create.mem.alignedAlloc(arenaType, pool.getAlignment().value())
+            : create.mem.alloc(arenaType);
+
+    for (PlannedBuffer &buffer : buffers) {
+      for (KrnlGetRefOp oldGetRef : buffer.getRefs) {
+        OpBuilder getRefBuilder(oldGetRef.getOperation());
+        MultiDialectBuilder<KrnlBuilder> createGetRef(
+            getRefBuilder, oldGetRef.getLoc());
+        auto newOffset = getRefBuilder.create<arith::ConstantOp>(
+            oldGetRef.getLoc(), getRefBuilder.getIntegerAttr(
+                                    getRefBuilder.getIntegerType(64),
+                                    buffer.plannedOffset));
+        auto newGetRef = createGetRef.krnl.getRef(
+            oldGetRef.getResult().getType(), arena, newOffset);
+        oldGetRef.getResult().replaceAllUsesWith(newGetRef.getResult());
+        oldGetRef.erase();
+      }
+    }
+
+    pool.getResult().replaceAllUsesWith(arena.getResult());
+    pool.erase();
+  }
+
+  void printReport(func::FuncOp funcOp, size_t numBuffers,
+      int64_t requestedBytes, int64_t arenaSize) const {
+    llvm::outs() << "Static memory plan for function '" << funcOp.getName()
+                 << "':\n";
+    llvm::outs() << "  buffers: " << numBuffers
+                 << ", requested: " << requestedBytes
+                 << " bytes, arena: " << arenaSize << " bytes\n";
+  }
+};
+
+} // namespace
+
+std::unique_ptr<mlir::Pass> onnx_mlir::krnl::createKrnlStaticMemoryPlanPass() {
+  return std::make_unique<KrnlStaticMemoryPlanPass>();
+}
+
+std::unique_ptr<mlir::Pass> onnx_mlir::krnl::createKrnlStaticMemoryPlanPass(
+    bool report) {
+  return std::make_unique<KrnlStaticMemoryPlanPass>(report);
+}
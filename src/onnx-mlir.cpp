@@ -14,16 +14,88 @@
 #include "src/Compiler/CompilerOptions.hpp"
 #include "src/Compiler/CompilerUtils.hpp"
 #include "src/Version/Version.hpp"
+#include <fstream>
 #include <iostream>
 #include <regex>
+#include <sstream>
 
 using namespace onnx_mlir;
 
 extern llvm::cl::OptionCategory onnx_mlir::OnnxMlirOptions;
 
+// Derive the output base name from the input file name when none was given
+// or the given one does not name a file (".", "..", "./", "/.", etc.).
+static std::string deriveOutputBaseName(
+    const std::string &inputFilename, std::string outputBaseName) {
+  bool b = false;
+  if (outputBaseName == "" ||
+      (b = std::regex_match(
+           outputBaseName.substr(outputBaseName.find_last_of("/\\") + 1),
+           std::regex("[\\.]*$")))) {
+    if (b)
+      llvm::errs() << "Invalid -o option value " << outputBaseName
+                   << " ignored.\n";
+    outputBaseName = inputFilename.substr(0, inputFilename.find_last_of("."));
+  }
+  return outputBaseName;
+}
+
+// Import and compile one model. Returns 0 on success.
+static int compileOneModel(mlir::MLIRContext &context,
+    const std::string &inputFilename, const std::string &outputBaseName,
+    EmissionTargetType emissionTarget) {
+  mlir::OwningOpRef<mlir::ModuleOp> module;
+  std::string errorMessage;
+  int rc = processInputFile(inputFilename, context, module, &errorMessage);
+  if (rc != 0) {
+    if (!errorMessage.empty())
+      llvm::errs() << errorMessage << "\n";
+    return 1;
+  }
+  return compileModule(module, context, outputBaseName, emissionTarget);
+}
+
+// Compile every model listed in the batch file within this process, sharing
+// the MLIR context (and thus dialect setup), the LLVM target machinery, and
+// the compilation cache across models, so the per-invocation fixed costs are
+// paid once instead of once per model. Each non-empty line names one model
+// with an optional output base name; '#' starts a comment. Failing models do
+// not stop the batch; the return value is the number of failures.
+static int compileBatch(mlir::MLIRContext &context,
+    const std::string &batchFilename, EmissionTargetType emissionTarget) {
+  std::ifstream batchFile(batchFilename);
+  if (!batchFile.is_open()) {
+    llvm::errs() << "Cannot open batch file " << batchFilename << ".\n";
+    return 1;
+  }
+  int numModels = 0;
+  int numFailures = 0;
+  std::string line;
+  while (std::getline(batchFile, line)) {
+    std::istringstream lineStream(line);
+    std::string inputFilename, outputBaseName;
+    lineStream >> inputFilename >> outputBaseName;
+    if (inputFilename.empty() || inputFilename[0] == '#')
+      continue;
+    ++numModels;
+    outputBaseName = deriveOutputBaseName(inputFilename, outputBaseName);
+    int rc =
+        compileOneModel(context, inputFilename, outputBaseName, emissionTarget);
+    if (rc != 0) {
+      llvm::errs() << "Batch entry " << inputFilename
+                   << " failed to compile (code " << rc << ").\n";
+      ++numFailures;
+    } else if (VerboseOutput)
+      llvm::outs() << "Compiled batch entry " << inputFilename << ".\n";
+  }
+  if (numFailures != 0)
+    llvm::errs() << numFailures << " of " << numModels
+                 << " batch entries failed to compile.\n";
+  return numFailures;
+}
+
 int main(int argc, char *argv[]) {
   mlir::MLIRContext context;
-  registerDialects(context);
 
   llvm::cl::opt<std::string> inputFilename(llvm::cl::Positional,
       llvm::cl::desc("<input file>"), llvm::cl::init("-"),
@@ -34,6 +106,23 @@ int main(int argc, char *argv[]) {
       llvm::cl::value_desc("path"), llvm::cl::cat(OnnxMlirOptions),
       llvm::cl::ValueRequired);
 
+  llvm::cl::opt<std::string> batchFilename("batch",
+      llvm::cl::desc(
+          "Compile every model listed in the given file in this process,\n"
+          "sharing dialect and target setup and the compilation cache, so "
+          "the\n"
+          "per-invocation fixed costs are paid once per batch. Each "
+          "non-empty\n"
+          "line is '<input model> [<output base name>]'; '#' starts a "
+          "comment.\n"
+          "All other options apply to every model; -o and the positional "
+          "input\n"
+          "are ignored. Failing models do not stop the batch; the exit code "
+          "is\n"
+          "the number of failures."),
+      llvm::cl::value_desc("path"), llvm::cl::init(""),
+      llvm::cl::cat(OnnxMlirOptions));
+
   llvm::cl::opt<EmissionTargetType> emissionTarget(
       llvm::cl::desc("Choose target to emit:"),
       llvm::cl::values(
@@ -49,7 +138,11 @@ int main(int argc, char *argv[]) {
           clEnumVal(EmitObj, "Compile the input into a object file."),
           clEnumVal(
               EmitLib, "Compile the input into a shared library (default)."),
-          clEnumVal(EmitJNI, "Compile the input into a jar file.")),
+          clEnumVal(EmitJNI, "Compile the input into a jar file."),
+          clEnumVal(EmitStaticLib,
+              "Compile the input into a static archive with the runtime "
+              "prelinked, plus a registration header, for deployments that "
+              "link the model directly instead of loading it with dlopen.")),
       llvm::cl::init(EmitLib), llvm::cl::cat(OnnxMlirOptions));
 
   // Register MLIR command line options.
@@ -67,34 +160,21 @@ int main(int argc, char *argv[]) {
     llvm::errs() << "Failed to parse options\n";
     return 1;
   }
+
+  // Register dialects only after option parsing succeeded: --help, --version,
+  // and flag errors then exit without paying for dialect construction, and
+  // the emission target is known so only the dialects its pipeline needs are
+  // loaded eagerly.
+  registerDialects(context, emissionTarget);
   // Test option requirements.
   if (!ONNXOpStats.empty() && emissionTarget <= EmitONNXIR)
     llvm::errs()
         << "Warning: --onnx-op-stats requires targets like --EmitMLIR, "
            "--EmitLLVMIR, or binary-generating emit commands.\n";
 
-  mlir::OwningOpRef<mlir::ModuleOp> module;
-  std::string errorMessage;
-  int rc = processInputFile(inputFilename, context, module, &errorMessage);
-  if (rc != 0) {
-    if (!errorMessage.empty())
-      llvm::errs() << errorMessage << "\n";
-    return 1;
-  }
-
-  // Input file base name, replace path if required.
-  // outputBaseName must specify a file, so ignore invalid values
-  // such as ".", "..", "./", "/.", etc.
-  bool b = false;
-  if (outputBaseName == "" ||
-      (b = std::regex_match(
-           outputBaseName.substr(outputBaseName.find_last_of("/\\") + 1),
-           std::regex("[\\.]*$")))) {
-    if (b)
-      llvm::errs() << "Invalid -o option value " << outputBaseName
-                   << " ignored.\n";
-    outputBaseName = inputFilename.substr(0, inputFilename.find_last_of("."));
-  }
+  if (!batchFilename.empty())
+    return compileBatch(context, batchFilename, emissionTarget);
 
-  return compileModule(module, context, outputBaseName, emissionTarget);
-}
\ No newline at end of file
+  return compileOneModel(context, inputFilename,
+      deriveOutputBaseName(inputFilename, outputBaseName), emissionTarget);
+}
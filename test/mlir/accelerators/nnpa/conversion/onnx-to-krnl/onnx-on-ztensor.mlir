@@ -2,7 +2,8 @@
 
 // Test doing unary element-wise computation directly on zTensor.
 // Taking ONNXSqrtOp as the example.
-// Need to check that the buffer is correctly aligned to 4K.
+// Each DLFLOAT16 element is widened to f32 by bit manipulation, computed in
+// f32, and narrowed back; the buffer must be correctly aligned to 4K.
 func.func @test_onnx_sqrt_ztensor(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
   %0 = "onnx.Sqrt"(%arg0) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
   return %0 : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
@@ -17,12 +18,17 @@ func.func @test_onnx_sqrt_ztensor(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{data
 // CHECK-DAG:       [[RES_:%.+]] = memref.alloc([[VAR_dim_]]) {alignment = 4096 : i64} : memref<?x3x5x7xf16, #map>
 
 // CHECK-DAG:       [[LOOP_0_:%.+]]:4 = krnl.define_loops 4
-// CHECK-DAG:       [[VAR_dim_0_:%.+]] = memref.dim [[PARAM_0_]], [[VAR_c0_]] : memref<?x3x5x7xf16, #map>
-// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to #map1([[VAR_dim_0_]]), [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 3, [[LOOP_0_]]#2 -> [[I_2_:%.+]] = 0 to 5, [[LOOP_0_]]#3 -> [[I_3_:%.+]] = 0 to 7){
+// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to #map1([[VAR_dim_]]), [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 3, [[LOOP_0_]]#2 -> [[I_2_:%.+]] = 0 to 5, [[LOOP_0_]]#3 -> [[I_3_:%.+]] = 0 to 7){
 // CHECK:             [[VAR_1_:%.+]]:4 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) : (!krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index, index)
 // CHECK:             [[LOAD_PARAM_0_MEM_:%.+]] = krnl.load [[PARAM_0_]]{{.}}[[VAR_1_]]#0, [[VAR_1_]]#1, [[VAR_1_]]#2, [[VAR_1_]]#3] : memref<?x3x5x7xf16, #map>
-// CHECK:             [[VAR_3_:%.+]] = math.sqrt [[LOAD_PARAM_0_MEM_]] : f16
-// CHECK:             krnl.store [[VAR_3_]], [[RES_]]{{.}}[[VAR_1_]]#0, [[VAR_1_]]#1, [[VAR_1_]]#2, [[VAR_1_]]#3] : memref<?x3x5x7xf16, #map>
+// CHECK:             [[VAR_3_:%.+]] = arith.bitcast [[LOAD_PARAM_0_MEM_]] : f16 to i16
+// CHECK:             arith.extui [[VAR_3_]] : i16 to i32
+// CHECK:             [[F32_IN_:%.+]] = arith.bitcast {{.*}} : i32 to f32
+// CHECK:             [[SQRT_:%.+]] = math.sqrt [[F32_IN_]] : f32
+// CHECK:             arith.bitcast [[SQRT_]] : f32 to i32
+// CHECK:             arith.trunci {{.*}} : i32 to i16
+// CHECK:             [[DLF16_OUT_:%.+]] = arith.bitcast {{.*}} : i16 to f16
+// CHECK:             krnl.store [[DLF16_OUT_]], [[RES_]]{{.}}[[VAR_1_]]#0, [[VAR_1_]]#1, [[VAR_1_]]#2, [[VAR_1_]]#3] : memref<?x3x5x7xf16, #map>
 // CHECK:           }
 // CHECK:           return [[RES_]] : memref<?x3x5x7xf16, #map>
 // CHECK:         }
@@ -30,8 +36,39 @@ func.func @test_onnx_sqrt_ztensor(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{data
 
 // -----
 
-// Test doing broadcasting binary element-wise computation directly on zTensor.
+// Test doing binary element-wise computation directly on zTensor.
 // Taking ONNXAddOp as the example.
+// Both inputs have the same shape, so the computation goes through the
+// DLFLOAT16-aware path: widen to f32, add, narrow back.
+func.func @test_onnx_add_ztensor_same_shape(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, %arg1: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
+  %0 = "onnx.Add"(%arg0, %arg1) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+  return %0 : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+
+// CHECK-DAG: #map = affine_map<(d0, d1, d2, d3) -> (d0, d3 floordiv 64, d1, d2 floordiv 32, d2 mod 32, d3 mod 64)>
+// CHECK-LABEL:  func.func @test_onnx_add_ztensor_same_shape
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<?x3x5x7xf16, #map>, [[PARAM_1_:%.+]]: memref<?x3x5x7xf16, #map>) -> memref<?x3x5x7xf16, #map> {
+// CHECK:           [[RES_:%.+]] = memref.alloc({{.*}}) {alignment = 4096 : i64} : memref<?x3x5x7xf16, #map>
+// CHECK:           krnl.iterate
+// CHECK:             [[LOAD_PARAM_0_MEM_:%.+]] = krnl.load [[PARAM_0_]]
+// CHECK:             arith.bitcast [[LOAD_PARAM_0_MEM_]] : f16 to i16
+// CHECK:             [[LHS_F32_:%.+]] = arith.bitcast {{.*}} : i32 to f32
+// CHECK:             [[LOAD_PARAM_1_MEM_:%.+]] = krnl.load [[PARAM_1_]]
+// CHECK:             arith.bitcast [[LOAD_PARAM_1_MEM_]] : f16 to i16
+// CHECK:             [[RHS_F32_:%.+]] = arith.bitcast {{.*}} : i32 to f32
+// CHECK:             [[ADD_:%.+]] = arith.addf [[LHS_F32_]], [[RHS_F32_]] : f32
+// CHECK:             arith.bitcast [[ADD_]] : f32 to i32
+// CHECK:             [[DLF16_OUT_:%.+]] = arith.bitcast {{.*}} : i16 to f16
+// CHECK:             krnl.store [[DLF16_OUT_]], [[RES_]]
+// CHECK:           }
+// CHECK:           return [[RES_]] : memref<?x3x5x7xf16, #map>
+// CHECK:         }
+}
+
+// -----
+
+// Test doing broadcasting binary element-wise computation directly on zTensor.
+// Taking ONNXAddOp as the example. Broadcasting falls back to the default
+// ONNX lowering that computes on the f16 elements directly.
 // Need to check that the buffer is correctly aligned to 4K.
 func.func @test_onnx_add_ztensor(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, %arg1: tensor<?x3x5x1xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
   %0 = "onnx.Add"(%arg0, %arg1) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, tensor<?x3x5x1xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
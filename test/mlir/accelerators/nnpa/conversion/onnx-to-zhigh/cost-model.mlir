@@ -0,0 +1,42 @@
+// RUN: onnx-mlir-opt --maccel=NNPA --shape-inference --convert-onnx-to-zhigh=enable-cost-model %s -split-input-file | FileCheck %s
+// RUN: onnx-mlir-opt --maccel=NNPA --shape-inference --convert-onnx-to-zhigh='enable-cost-model cost-factor=0.1' %s -split-input-file | FileCheck --check-prefix=TUNED %s
+
+// With the cost model enabled, a small elementwise operation stays on the
+// CPU: the NNPA launch and stick/unstick costs dwarf its work.
+func.func @test_small_add_stays_on_cpu(%arg0 : tensor<10x10xf32>, %arg1 : tensor<10x10xf32>) -> tensor<*xf32> {
+  %0 = "onnx.Add"(%arg0, %arg1) : (tensor<10x10xf32>, tensor<10x10xf32>) -> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+
+// CHECK-LABEL:  func @test_small_add_stays_on_cpu
+// CHECK:        "onnx.Add"
+// CHECK-NOT:    "zhigh.Add"
+}
+
+// -----
+
+// A large matmul amortizes the conversion cost and still goes to the NNPA.
+func.func @test_large_matmul_on_nnpa(%arg0 : tensor<512x512xf32>, %arg1 : tensor<512x512xf32>) -> tensor<*xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<512x512xf32>, tensor<512x512xf32>) -> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+
+// CHECK-LABEL:  func @test_large_matmul_on_nnpa
+// CHECK:        "zhigh.MatMul"
+// CHECK-NOT:    "onnx.MatMul"
+}
+
+// -----
+
+// A borderline matmul stays on the CPU with the default cost factor but
+// moves to the NNPA when the factor is lowered from profiles.
+func.func @test_borderline_matmul_tunable(%arg0 : tensor<32x32xf32>, %arg1 : tensor<32x32xf32>) -> tensor<*xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<32x32xf32>, tensor<32x32xf32>) -> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+
+// CHECK-LABEL:  func @test_borderline_matmul_tunable
+// CHECK:        "onnx.MatMul"
+// CHECK-NOT:    "zhigh.MatMul"
+
+// TUNED-LABEL:  func @test_borderline_matmul_tunable
+// TUNED:        "zhigh.MatMul"
+// TUNED-NOT:    "onnx.MatMul"
+}
@@ -201,30 +201,55 @@ func.func @onnx_concat_layout_propagation_4d(%arg0: tensor<?x4x4x192xf32, #zhigh
 
 // -----
 
-// TODO: enable this once DLFLOAT16-based calculation is supported.
 // Data layout propagation for ONNX operations.
 // Take ONNXSqrtOp as the representative of unary element-wise ops.
-// COM: func.func @test_onnx_sqrt_ztensor(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
-// COM:   %0 = "zhigh.Unstick"(%arg0) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32>
-// COM:   %1 = "onnx.Sqrt"(%0) : (tensor<?x3x5x7xf32>) -> tensor<?x3x5x7xf32>
-// COM:   %2 = "zhigh.Stick"(%1) {layout = "4D"} : (tensor<?x3x5x7xf32>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
-// COM:   return %2 : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
-// COM: 
-// COM: // CHECK-LABEL:  func.func @test_onnx_sqrt_ztensor
-// COM: // CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
-// COM: // CHECK:           [[VAR_0_:%.+]] = "onnx.Sqrt"([[PARAM_0_]]) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
-// COM: // CHECK:           return [[VAR_0_]] : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
-// COM: // CHECK:         }
-// COM: }
-// COM: 
-// COM: // -----
-// COM: 
-// COM: // Data layout propagation for ONNX operations.
-// COM: // Take ONNXAddOp as the representative of binary element-wise ops.
-// COM: func.func @test_onnx_add_ztensor(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, %arg1: tensor<?x3x5x1xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
-// COM:   %0 = "zhigh.Unstick"(%arg0) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32>
-// COM:   %1 = "zhigh.Unstick"(%arg1) : (tensor<?x3x5x1xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x1xf32>
-// COM:   %2 = "onnx.Add"(%0, %1) : (tensor<?x3x5x7xf32>, tensor<?x3x5x1xf32>) -> tensor<?x3x5x7xf32>
-// COM:   %3 = "zhigh.Stick"(%2) {layout = "4D"} : (tensor<?x3x5x7xf32>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
-// COM:   return %3 : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
-// COM: }
+func.func @test_onnx_sqrt_ztensor(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
+  %0 = "zhigh.Unstick"(%arg0) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32>
+  %1 = "onnx.Sqrt"(%0) : (tensor<?x3x5x7xf32>) -> tensor<?x3x5x7xf32>
+  %2 = "zhigh.Stick"(%1) {layout = "4D"} : (tensor<?x3x5x7xf32>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+  return %2 : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+
+// CHECK-LABEL:  func.func @test_onnx_sqrt_ztensor
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
+// CHECK:           [[VAR_0_:%.+]] = "onnx.Sqrt"([[PARAM_0_]]) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+// CHECK:           return [[VAR_0_]] : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+// CHECK:         }
+}
+
+// -----
+
+// Data layout propagation for ONNX operations.
+// Take ONNXAddOp as the representative of binary element-wise ops.
+func.func @test_onnx_add_ztensor(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, %arg1: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
+  %0 = "zhigh.Unstick"(%arg0) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32>
+  %1 = "zhigh.Unstick"(%arg1) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32>
+  %2 = "onnx.Add"(%0, %1) : (tensor<?x3x5x7xf32>, tensor<?x3x5x7xf32>) -> tensor<?x3x5x7xf32>
+  %3 = "zhigh.Stick"(%2) {layout = "4D"} : (tensor<?x3x5x7xf32>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+  return %3 : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+
+// CHECK-LABEL:  func.func @test_onnx_add_ztensor
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, [[PARAM_1_:%.+]]: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
+// CHECK:           [[VAR_0_:%.+]] = "onnx.Add"([[PARAM_0_]], [[PARAM_1_]]) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+// CHECK:           return [[VAR_0_]] : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+// CHECK:         }
+}
+
+// -----
+
+// Do not propagate the layout for binary element-wise ops that broadcast:
+// the CPU lowering on stickified data does not support broadcasting.
+func.func @test_onnx_add_ztensor_broadcast(%arg0: tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>, %arg1: tensor<?x3x5x1xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>> {
+  %0 = "zhigh.Unstick"(%arg0) : (tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x7xf32>
+  %1 = "zhigh.Unstick"(%arg1) : (tensor<?x3x5x1xf32, #zhigh.layout<{dataLayout = "4D"}>>) -> tensor<?x3x5x1xf32>
+  %2 = "onnx.Add"(%0, %1) : (tensor<?x3x5x7xf32>, tensor<?x3x5x1xf32>) -> tensor<?x3x5x7xf32>
+  %3 = "zhigh.Stick"(%2) {layout = "4D"} : (tensor<?x3x5x7xf32>) -> tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+  return %3 : tensor<?x3x5x7xf32, #zhigh.layout<{dataLayout = "4D"}>>
+
+// CHECK-LABEL:  func.func @test_onnx_add_ztensor_broadcast
+// CHECK:           [[VAR_0_:%.+]] = "zhigh.Unstick"
+// CHECK:           [[VAR_1_:%.+]] = "zhigh.Unstick"
+// CHECK:           [[VAR_2_:%.+]] = "onnx.Add"([[VAR_0_]], [[VAR_1_]]) : (tensor<?x3x5x7xf32>, tensor<?x3x5x1xf32>) -> tensor<?x3x5x7xf32>
+// CHECK:           [[VAR_3_:%.+]] = "zhigh.Stick"([[VAR_2_]])
+// CHECK:           return [[VAR_3_]]
+// CHECK:         }
+}
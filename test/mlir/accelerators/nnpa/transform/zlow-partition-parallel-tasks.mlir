@@ -0,0 +1,46 @@
+// RUN: onnx-mlir-opt --maccel=NNPA --partition-parallel-tasks %s -split-input-file | FileCheck %s
+
+// The zlow operations declare their buffer accesses, so the two independent
+// stick/unstick chains are outlined into tasks: the CPU stickification of one
+// branch can overlap the accelerator work of the other.
+func.func @two_zlow_branches(%arg0: memref<1x1x32x64xf32>, %arg1: memref<1x1x32x64xf32>) -> (memref<1x1x32x64xf32>, memref<1x1x32x64xf32>) {
+  %s0 = memref.alloc() : memref<1x1x1x1x32x64xf16>
+  %s1 = memref.alloc() : memref<1x1x1x1x32x64xf16>
+  %r0 = memref.alloc() : memref<1x1x32x64xf32>
+  %r1 = memref.alloc() : memref<1x1x32x64xf32>
+  "zlow.stick"(%arg0, %s0) {layout = "4D"} : (memref<1x1x32x64xf32>, memref<1x1x1x1x32x64xf16>) -> ()
+  "zlow.unstick"(%s0, %r0) {layout = "4D"} : (memref<1x1x1x1x32x64xf16>, memref<1x1x32x64xf32>) -> ()
+  "zlow.stick"(%arg1, %s1) {layout = "4D"} : (memref<1x1x32x64xf32>, memref<1x1x1x1x32x64xf16>) -> ()
+  "zlow.unstick"(%s1, %r1) {layout = "4D"} : (memref<1x1x1x1x32x64xf16>, memref<1x1x32x64xf32>) -> ()
+  return %r0, %r1 : memref<1x1x32x64xf32>, memref<1x1x32x64xf32>
+
+  // CHECK-LABEL: func.func @two_zlow_branches
+  // CHECK-NOT:   "zlow.stick"
+  // CHECK:       "krnl.run_tasks"({{.*}}) {callees = [@two_zlow_branches_task0, @two_zlow_branches_task1], segmentSizes = [3, 3]}
+}
+// CHECK:       func.func private @two_zlow_branches_task0
+// CHECK:       "zlow.stick"
+// CHECK:       "zlow.unstick"
+// CHECK:       func.func private @two_zlow_branches_task1
+// CHECK:       "zlow.stick"
+// CHECK:       "zlow.unstick"
+
+// -----
+
+// The second chain reads the stickified buffer written by the first one, so
+// there is only one group and the function is left alone.
+func.func @dependent_zlow_chain(%arg0: memref<1x1x32x64xf32>) -> (memref<1x1x32x64xf32>, memref<1x1x32x64xf32>) {
+  %s0 = memref.alloc() : memref<1x1x1x1x32x64xf16>
+  %r0 = memref.alloc() : memref<1x1x32x64xf32>
+  %r1 = memref.alloc() : memref<1x1x32x64xf32>
+  "zlow.stick"(%arg0, %s0) {layout = "4D"} : (memref<1x1x32x64xf32>, memref<1x1x1x1x32x64xf16>) -> ()
+  "zlow.unstick"(%s0, %r0) {layout = "4D"} : (memref<1x1x1x1x32x64xf16>, memref<1x1x32x64xf32>) -> ()
+  "zlow.unstick"(%s0, %r1) {layout = "4D"} : (memref<1x1x1x1x32x64xf16>, memref<1x1x32x64xf32>) -> ()
+  return %r0, %r1 : memref<1x1x32x64xf32>, memref<1x1x32x64xf32>
+
+  // CHECK-LABEL: func.func @dependent_zlow_chain
+  // CHECK-NOT:   "krnl.run_tasks"
+  // CHECK:       "zlow.stick"
+  // CHECK:       "zlow.unstick"
+  // CHECK:       "zlow.unstick"
+}
@@ -659,3 +659,33 @@ func.func private @copy_from_partial_runtime(%p0 : index, %p1 : index) -> () {
 // CHECK:           return
 // CHECK:         }
 }
+
+// -----
+
+// An f16 source feeding an f32 buffer: each element is widened as it is
+// packed into the tile. This is the compute side of half-precision weight
+// storage (see --f16-weights).
+func.func private @copy_to_widen_f16() -> () {
+  //A source, B buffer
+  %A = memref.alloca() : memref<40x60xf16>
+  %B = memref.alloca() : memref<4x6xf32>
+  %f0 = arith.constant 0.0 : f32
+
+  %i10 = arith.constant 10 : index
+  %i12 = arith.constant 12 : index
+  krnl.copy_to_tile_buffer %B, %A [%i10, %i12], %f0 : memref<4x6xf32>, memref<40x60xf16>
+  return
+
+// CHECK-LABEL:  func private @copy_to_widen_f16
+// CHECK-DAG:       [[ORGINAL_:%.+]] = memref.alloca() : memref<40x60xf16>
+// CHECK-DAG:       [[BUFFER_:%.+]] = memref.alloca() : memref<4x6xf32>
+// CHECK:           affine.for [[I_0_:%.+]] = 0 to 4 {
+// CHECK:             affine.for [[I_1_:%.+]] = 0 to 6 {
+// CHECK:               [[LOAD_ORGINAL_MEM_:%.+]] = affine.load [[ORGINAL_]]{{.}}[[I_0_]] + 10, [[I_1_]] + 12] : memref<40x60xf16>
+// CHECK:               [[VAR_1_:%.+]] = arith.extf [[LOAD_ORGINAL_MEM_]] : f16 to f32
+// CHECK:               affine.store [[VAR_1_]], [[BUFFER_]]{{.}}[[I_0_]], [[I_1_]]{{.}} : memref<4x6xf32>
+// CHECK:             }
+// CHECK:           }
+// CHECK:           return
+// CHECK:         }
+}
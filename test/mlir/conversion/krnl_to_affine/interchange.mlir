@@ -0,0 +1,60 @@
+// RUN: onnx-mlir-opt -O3 --convert-krnl-to-affine='interchange' %s -split-input-file | FileCheck %s
+
+// The nest walks the output column by column; every access moves a full row
+// per iteration of the inner loop. The row loop is sunk innermost, restoring
+// unit-stride access for both operands.
+func.func @interchange_column_major(%arg0: memref<64x256xf32>, %arg1: memref<64x256xf32>) {
+  %loops:2 = krnl.define_loops 2
+  krnl.iterate(%loops#0, %loops#1) with (%loops#0 -> %j = 0 to 256, %loops#1 -> %i = 0 to 64) {
+    %0 = krnl.load %arg0[%i, %j] : memref<64x256xf32>
+    krnl.store %0, %arg1[%i, %j] : memref<64x256xf32>
+  }
+  return
+
+  // CHECK-LABEL: interchange_column_major
+  // CHECK:       affine.for [[IV0:%.+]] = 0 to 64 {
+  // CHECK:         affine.for [[IV1:%.+]] = 0 to 256 {
+  // CHECK:           [[LOAD:%.+]] = affine.load %arg0{{\[}}[[IV0]], [[IV1]]] : memref<64x256xf32>
+  // CHECK:           affine.store [[LOAD]], %arg1{{\[}}[[IV0]], [[IV1]]] : memref<64x256xf32>
+}
+
+// -----
+
+// Reduction emitted with the contiguous axis outermost: the input is walked
+// with a row-sized stride while the accumulator is re-read per iteration.
+// The reduction loop moves innermost; the loop-carried accumulation is still
+// legal there because the dependence stays forward.
+func.func @interchange_reduction(%arg0: memref<64x256xf32>, %arg1: memref<64xf32>) {
+  %loops:2 = krnl.define_loops 2
+  krnl.iterate(%loops#0, %loops#1) with (%loops#0 -> %k = 0 to 256, %loops#1 -> %i = 0 to 64) {
+    %0 = krnl.load %arg0[%i, %k] : memref<64x256xf32>
+    %1 = krnl.load %arg1[%i] : memref<64xf32>
+    %2 = arith.addf %1, %0 : f32
+    krnl.store %2, %arg1[%i] : memref<64xf32>
+  }
+  return
+
+  // CHECK-LABEL: interchange_reduction
+  // CHECK:       affine.for [[IV0:%.+]] = 0 to 64 {
+  // CHECK:         affine.for [[IV1:%.+]] = 0 to 256 {
+  // CHECK:           affine.load %arg0{{\[}}[[IV0]], [[IV1]]] : memref<64x256xf32>
+  // CHECK:           affine.load %arg1{{\[}}[[IV0]]] : memref<64xf32>
+  // CHECK:           affine.store {{.*}}, %arg1{{\[}}[[IV0]]] : memref<64xf32>
+}
+
+// -----
+
+// Already unit-stride innermost: the nest is left exactly as generated.
+func.func @no_interchange_canonical(%arg0: memref<64x256xf32>, %arg1: memref<64x256xf32>) {
+  %loops:2 = krnl.define_loops 2
+  krnl.iterate(%loops#0, %loops#1) with (%loops#0 -> %i = 0 to 64, %loops#1 -> %j = 0 to 256) {
+    %0 = krnl.load %arg0[%i, %j] : memref<64x256xf32>
+    krnl.store %0, %arg1[%i, %j] : memref<64x256xf32>
+  }
+  return
+
+  // CHECK-LABEL: no_interchange_canonical
+  // CHECK:       affine.for [[IV0:%.+]] = 0 to 64 {
+  // CHECK:         affine.for [[IV1:%.+]] = 0 to 256 {
+  // CHECK:           affine.load %arg0{{\[}}[[IV0]], [[IV1]]] : memref<64x256xf32>
+}
@@ -52,6 +52,30 @@ func.func private @memset_dyn(%p0 : index, %p1 : index) -> () {
 
 // -----
 
+// An innermost dimension that is a multiple of the machine vector length is
+// filled with wide vector stores of the splatted value.
+func.func private @memset_vectorized() -> () {
+  %A = memref.alloca() : memref<8x4x32xf32>
+  %f0 = arith.constant 0.0 : f32
+
+  krnl.memset %A, %f0 : memref<8x4x32xf32>
+  return
+// CHECK-LABEL:  func private @memset_vectorized
+// CHECK-DAG:       [[CST_SPLAT_:%.+]] = arith.constant dense<0.000000e+00> : vector<4xf32>
+// CHECK-DAG:       [[RES_:%.+]] = memref.alloca() : memref<8x4x32xf32>
+// CHECK:           affine.for [[I_0_:%.+]] = 0 to 8 {
+// CHECK:             affine.for [[I_1_:%.+]] = 0 to 4 {
+// CHECK:               affine.for [[I_2_:%.+]] = 0 to 32 step 4 {
+// CHECK:                 vector.store [[CST_SPLAT_]], [[RES_]]{{.}}[[I_0_]], [[I_1_]], [[I_2_]]{{.}} : memref<8x4x32xf32>, vector<4xf32>
+// CHECK:               }
+// CHECK:             }
+// CHECK:           }
+// CHECK:           return
+// CHECK:         }
+}
+
+// -----
+
 #map = affine_map<(d0) -> (d0 floordiv 64, d0 mod 64)>
 func.func private @memref_with_affine(%arg0: memref<3xf32, #map>) -> memref<3xf32, #map> {
   %0 = memref.alloc() : memref<3xf32, #map>
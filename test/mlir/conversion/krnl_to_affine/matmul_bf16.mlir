@@ -0,0 +1,38 @@
+// RUN: onnx-mlir-opt -O3 --convert-krnl-to-affine --canonicalize %s -split-input-file | FileCheck %s
+
+// -----
+
+// 16-bit float matrices stay bf16 in memory but the register kernel widens
+// the loaded values to f32 and accumulates in f32, truncating back to bf16
+// only on the final store.
+func.func private @matmul_bf16_full_tiles(%A: memref<4x6xbf16>, %B: memref<6x8xbf16>, %C: memref<4x8xbf16>) {
+    %c0 = arith.constant 0: index
+    %c4 = arith.constant 4: index // N
+    %c6 = arith.constant 6: index // K
+    %c8 = arith.constant 8: index // M
+    %ii, %jj, %kk = krnl.define_loops 3
+    %ib, %il = krnl.block %ii 4 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+    %jb, %jl = krnl.block %jj 8 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+    %kb, %kl = krnl.block %kk 6 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+    krnl.permute(%ib, %il, %jb, %jl, %kb, %kl) [0, 3, 1, 4, 2, 5] : !krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop
+    krnl.iterate(%ib, %jb, %kb) with (%ii -> %i = 0 to 4, %jj -> %j = 0 to 8, %kk -> %k = 0 to 6) {
+        krnl.matmul %A [%c0, %c0], %B[%c0, %c0], %C[%c0, %c0], (%il, %jl, %kl), (%c0, %c0, %c0), (%c4, %c8, %c6)
+            {unroll=false, simdize=true} :
+            memref<4x6xbf16>, memref<6x8xbf16>, memref<4x8xbf16>, (!krnl.loop, !krnl.loop, !krnl.loop)
+    }
+    return
+// CHECK-LABEL:  func.func private @matmul_bf16_full_tiles
+// CHECK:           [[LOAD_C_:%.+]] = vector.load {{.*}} : memref<4x8xbf16>, vector<8xbf16>
+// CHECK:           [[INIT_:%.+]] = arith.extf [[LOAD_C_]] : vector<8xbf16> to vector<8xf32>
+// CHECK:           affine.store [[INIT_]],
+// CHECK:           affine.for
+// CHECK:             [[LOAD_A_:%.+]] = affine.load {{.*}} : memref<4x6xbf16>
+// CHECK:             [[A_F32_:%.+]] = arith.extf [[LOAD_A_]] : bf16 to f32
+// CHECK:             [[VA_:%.+]] = vector.broadcast [[A_F32_]] : f32 to vector<8xf32>
+// CHECK:             [[LOAD_B_:%.+]] = vector.load {{.*}} : memref<6x8xbf16>, vector<8xbf16>
+// CHECK:             [[VB_:%.+]] = arith.extf [[LOAD_B_]] : vector<8xbf16> to vector<8xf32>
+// CHECK:             vector.fma [[VA_]], [[VB_]], {{.*}} : vector<8xf32>
+// CHECK:           }
+// CHECK:           [[RES_:%.+]] = arith.truncf {{.*}} : vector<8xf32> to vector<8xbf16>
+// CHECK:           vector.store [[RES_]], {{.*}} : memref<4x8xbf16>, vector<8xbf16>
+}
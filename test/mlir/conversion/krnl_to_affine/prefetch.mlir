@@ -0,0 +1,60 @@
+// RUN: onnx-mlir-opt -O3 --convert-krnl-to-affine='prefetch' %s -split-input-file | FileCheck %s
+
+// Each streaming load in the innermost loop gets an L1 and an L2 prefetch
+// ahead of it; the store is not prefetched.
+func.func @prefetch_streaming_loads(%arg0: memref<256xf32>, %arg1: memref<256xf32>, %arg2: memref<256xf32>) {
+  %ii = krnl.define_loops 1
+  krnl.iterate(%ii) with (%ii -> %i = 0 to 256) {
+    %0 = krnl.load %arg0[%i] : memref<256xf32>
+    %1 = krnl.load %arg1[%i] : memref<256xf32>
+    %2 = arith.addf %0, %1 : f32
+    krnl.store %2, %arg2[%i] : memref<256xf32>
+  }
+  return
+
+  // CHECK-LABEL: prefetch_streaming_loads
+  // CHECK:       affine.for [[IV:%.+]] = 0 to 256 {
+  // CHECK:         affine.prefetch %arg0{{.}}[[IV]] + 4], read, locality<3>, data : memref<256xf32>
+  // CHECK-NEXT:    affine.prefetch %arg0{{.}}[[IV]] + 32], read, locality<2>, data : memref<256xf32>
+  // CHECK-NEXT:    affine.load %arg0
+  // CHECK:         affine.prefetch %arg1{{.}}[[IV]] + 4], read, locality<3>, data : memref<256xf32>
+  // CHECK-NEXT:    affine.prefetch %arg1{{.}}[[IV]] + 32], read, locality<2>, data : memref<256xf32>
+  // CHECK-NEXT:    affine.load %arg1
+  // CHECK-NOT:     affine.prefetch %arg2
+}
+
+// -----
+
+// Only the innermost loop is prefetched, with the full access map advanced
+// along its induction variable.
+func.func @prefetch_innermost_only(%arg0: memref<64x256xf32>, %arg1: memref<64x256xf32>) {
+  %loops:2 = krnl.define_loops 2
+  krnl.iterate(%loops#0, %loops#1) with (%loops#0 -> %i = 0 to 64, %loops#1 -> %j = 0 to 256) {
+    %0 = krnl.load %arg0[%i, %j] : memref<64x256xf32>
+    krnl.store %0, %arg1[%i, %j] : memref<64x256xf32>
+  }
+  return
+
+  // CHECK-LABEL: prefetch_innermost_only
+  // CHECK:       affine.for [[IV0:%.+]] = 0 to 64 {
+  // CHECK-NOT:     affine.prefetch
+  // CHECK:         affine.for [[IV1:%.+]] = 0 to 256 {
+  // CHECK:           affine.prefetch %arg0{{.}}[[IV0]], [[IV1]] + 4], read, locality<3>, data : memref<64x256xf32>
+  // CHECK-NEXT:      affine.prefetch %arg0{{.}}[[IV0]], [[IV1]] + 32], read, locality<2>, data : memref<64x256xf32>
+  // CHECK-NEXT:      affine.load %arg0
+}
+
+// -----
+
+// A loop too short to reach the prefetch distance is left alone.
+func.func @no_prefetch_short_loop(%arg0: memref<4xf32>, %arg1: memref<4xf32>) {
+  %ii = krnl.define_loops 1
+  krnl.iterate(%ii) with (%ii -> %i = 0 to 4) {
+    %0 = krnl.load %arg0[%i] : memref<4xf32>
+    krnl.store %0, %arg1[%i] : memref<4xf32>
+  }
+  return
+
+  // CHECK-LABEL: no_prefetch_short_loop
+  // CHECK-NOT:   affine.prefetch
+}
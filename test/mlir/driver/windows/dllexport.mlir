@@ -2,11 +2,14 @@
 // RUN: cat %t.ll | FileCheck %s
 
 // REQUIRES: system-windows
-// CHECK: define dso_local dllexport ptr @run_main_graph_1
-// CHECK: define dso_local dllexport ptr @run_main_graph_2
+// CHECK-DAG: define dso_local dllexport ptr @run_main_graph_1
+// CHECK-DAG: define dso_local dllexport void @run_main_graph_1_raw
+// CHECK-DAG: define dso_local dllexport ptr @run_main_graph_2
+// CHECK-DAG: define dso_local dllexport void @run_main_graph_2_raw
 // CHECK: define dso_local dllexport ptr @omQueryEntryPoints
 // CHECK: define dso_local dllexport ptr @omInputSignature
 // CHECK: define dso_local dllexport ptr @omOutputSignature
+// CHECK: define dso_local dllexport ptr @omGetSignatureBinary
 module  {
   func.func @main_graph_1(%arg0: tensor<1x1xf32>) -> tensor<1x1xf32> {
     %0 = "onnx.Relu"(%arg0) : (tensor<1x1xf32>) -> tensor<1x1xf32>
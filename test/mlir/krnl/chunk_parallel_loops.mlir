@@ -0,0 +1,84 @@
+// RUN: onnx-mlir-opt --chunk-parallel-loops %s -split-input-file | FileCheck %s
+
+// The parallel loop is outlined into a chunk function over the normalized
+// iteration space and replaced by krnl.run_loop; the constant is cloned into
+// the outlined body instead of being passed through the runtime.
+func.func @axpy(%arg0: memref<?xf32>, %arg1: memref<?xf32>, %lb: index, %ub: index, %step: index) {
+  %cst = arith.constant 2.000000e+00 : f32
+  scf.parallel (%i) = (%lb) to (%ub) step (%step) {
+    %v = memref.load %arg0[%i] : memref<?xf32>
+    %m = arith.mulf %v, %cst : f32
+    memref.store %m, %arg1[%i] : memref<?xf32>
+    scf.yield
+  }
+  return
+
+  // CHECK-LABEL: func.func @axpy
+  // CHECK-SAME:  ([[ARG0_:%.+]]: memref<?xf32>, [[ARG1_:%.+]]: memref<?xf32>, [[LB_:%.+]]: index, [[UB_:%.+]]: index, [[STEP_:%.+]]: index)
+  // CHECK-NOT:   scf.parallel
+  // CHECK:       [[RANGE_:%.+]] = arith.subi [[UB_]], [[LB_]] : index
+  // CHECK:       [[TRIP_:%.+]] = arith.ceildivsi [[RANGE_]], [[STEP_]] : index
+  // CHECK:       "krnl.run_loop"([[TRIP_]], [[LB_]], [[STEP_]], [[ARG0_]], [[ARG1_]]) {callee = @axpy_ploop0, schedule = 1 : i64} : (index, index, index, memref<?xf32>, memref<?xf32>) -> ()
+  // CHECK:       return
+}
+
+// CHECK:       func.func private @axpy_ploop0
+// CHECK-SAME:  ([[CLB_:%.+]]: index, [[CUB_:%.+]]: index, [[OLB_:%.+]]: index, [[OSTEP_:%.+]]: index, [[BUF0_:%.+]]: memref<?xf32>, [[BUF1_:%.+]]: memref<?xf32>)
+// CHECK-DAG:   [[CST_:%.+]] = arith.constant 2.000000e+00 : f32
+// CHECK-DAG:   [[ONE_:%.+]] = arith.constant 1 : index
+// CHECK:       scf.for [[IDX_:%.+]] = [[CLB_]] to [[CUB_]] step [[ONE_]] {
+// CHECK:         [[SCALED_:%.+]] = arith.muli [[IDX_]], [[OSTEP_]] : index
+// CHECK:         [[IV_:%.+]] = arith.addi [[OLB_]], [[SCALED_]] : index
+// CHECK:         [[V_:%.+]] = memref.load [[BUF0_]]{{.}}[[IV_]]{{.}} : memref<?xf32>
+// CHECK:         arith.mulf [[V_]], [[CST_]] : f32
+// CHECK:         memref.store {{.*}}, [[BUF1_]]{{.}}[[IV_]]{{.}} : memref<?xf32>
+// CHECK:       }
+// CHECK:       return
+
+// -----
+
+// Only the outermost parallel loop is chunked; the nested one runs
+// sequentially inside the chunk of its parent.
+func.func @nested(%arg0: memref<8x8xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  scf.parallel (%i) = (%c0) to (%c8) step (%c1) {
+    scf.parallel (%j) = (%c0) to (%c8) step (%c1) {
+      memref.store %cst, %arg0[%i, %j] : memref<8x8xf32>
+      scf.yield
+    }
+    scf.yield
+  }
+  return
+
+  // CHECK-LABEL: func.func @nested
+  // CHECK-NOT:   scf.parallel
+  // CHECK:       "krnl.run_loop"({{.*}}) {callee = @nested_ploop0, schedule = 1 : i64}
+}
+
+// CHECK:       func.func private @nested_ploop0
+// CHECK:       scf.for
+// CHECK:       scf.parallel
+// CHECK-NOT:   krnl.run_loop
+
+// -----
+
+// Multi-dimensional parallel loops are not produced by the krnl lowering and
+// are left untouched.
+func.func @multi_dim(%arg0: memref<8x8xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  scf.parallel (%i, %j) = (%c0, %c0) to (%c8, %c8) step (%c1, %c1) {
+    memref.store %cst, %arg0[%i, %j] : memref<8x8xf32>
+    scf.yield
+  }
+  return
+
+  // CHECK-LABEL: func.func @multi_dim
+  // CHECK:       scf.parallel
+  // CHECK-NOT:   krnl.run_loop
+}
@@ -0,0 +1,37 @@
+// RUN: onnx-mlir-opt --dedup-funcs %s | FileCheck %s
+
+// Two private functions with identical bodies collapse into one, and every
+// call site is redirected to the surviving symbol. The function differing
+// only in its constant stays separate, and the public entry keeps its own
+// symbol even though it matches nothing.
+module {
+  func.func private @layer_0(%arg0: memref<4xf32>) -> memref<4xf32> {
+    %c = arith.constant 1.000000e+00 : f32
+    %alloc = memref.alloc() : memref<4xf32>
+    return %alloc : memref<4xf32>
+  }
+  func.func private @layer_1(%arg0: memref<4xf32>) -> memref<4xf32> {
+    %c = arith.constant 1.000000e+00 : f32
+    %alloc = memref.alloc() : memref<4xf32>
+    return %alloc : memref<4xf32>
+  }
+  func.func private @layer_other(%arg0: memref<4xf32>) -> memref<4xf32> {
+    %c = arith.constant 2.000000e+00 : f32
+    %alloc = memref.alloc() : memref<4xf32>
+    return %alloc : memref<4xf32>
+  }
+  func.func @main_graph(%arg0: memref<4xf32>) -> memref<4xf32> {
+    %0 = call @layer_0(%arg0) : (memref<4xf32>) -> memref<4xf32>
+    %1 = call @layer_1(%0) : (memref<4xf32>) -> memref<4xf32>
+    %2 = call @layer_other(%1) : (memref<4xf32>) -> memref<4xf32>
+    return %2 : memref<4xf32>
+  }
+}
+
+// CHECK-LABEL: func.func private @layer_0
+// CHECK-NOT: func.func private @layer_1
+// CHECK: func.func private @layer_other
+// CHECK: func.func @main_graph
+// CHECK: call @layer_0
+// CHECK: call @layer_0
+// CHECK: call @layer_other
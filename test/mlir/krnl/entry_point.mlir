@@ -17,6 +17,13 @@ module {
 // CHECK:             ([[ARG0:%.+]]: !llvm.ptr<i8>) -> !llvm.ptr<i8>
 // CHECK:           {{.*}} = llvm.call @omTensorListGetOmtArray([[ARG0]]) : (!llvm.ptr<i8>) -> !llvm.ptr<ptr<i8>>
 
+// COM: The raw entry point takes memref descriptors directly and skips all
+// COM: OMTensor marshalling.
+// CHECK:         llvm.func @run_main_graph_raw([[RAW_ARG0:%.+]]: !llvm.ptr<struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>>, [[RAW_ARG1:%.+]]: !llvm.ptr<struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>>) {
+// CHECK:           llvm.call @_mlir_ciface_first_entry([[RAW_ARG0]], [[RAW_ARG1]]) : (!llvm.ptr<struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>>, !llvm.ptr<struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>>) -> ()
+// CHECK:           llvm.return
+// CHECK:         }
+
 // CHECK:         llvm.mlir.global internal constant @_entry_point_arrays() {addr_space = 0 : i32} : !llvm.array<2 x ptr<i8>> {
 // CHECK-DAG:       [[VAR_0_:%.+]] = llvm.mlir.undef : !llvm.array<2 x ptr<i8>>
 // CHECK-DAG:       [[VAR_2_:%.+]] = llvm.mlir.addressof @_entry_point_0 : !llvm.ptr<array<15 x i8>>
@@ -75,6 +82,13 @@ module {
 // CHECK:           llvm.return [[VAR_11_2_]] : !llvm.ptr<i8>
 // CHECK:         }
 
+// COM: The fake signatures are not valid JSON, so no binary table is emitted
+// COM: and omGetSignatureBinary returns NULL.
+// CHECK:         llvm.func @omGetSignatureBinary([[arg0_:%.+]]: !llvm.ptr<i8>, [[arg1_:%.+]]: i64) -> !llvm.ptr<i64> {
+// CHECK:           [[BIN_NULL_:%.+]] = llvm.mlir.null : !llvm.ptr<i64>
+// CHECK:           llvm.return [[BIN_NULL_]] : !llvm.ptr<i64>
+// CHECK:         }
+
 }
 
 // -----
@@ -192,6 +206,37 @@ module {
 
 // -----
 
+// COM: Generate binary signature tables when the signatures are valid JSON,
+// COM: and return them from omGetSignatureBinary.
+module {
+  func.func private @main_graph(%arg0: memref<1x2xf32>) -> memref<1x2xf32> {
+    return %arg0 : memref<1x2xf32>
+  }
+  "krnl.entry_point"() {func = @main_graph, numInputs = 1 : i32, numOutputs = 1 : i32, signature = "[ { \22type\22 : \22f32\22 , \22dims\22 : [-1 , 2] , \22name\22 : \22x\22 } ]\00@[ { \22type\22 : \22f32\22 , \22dims\22 : [1 , 2] , \22name\22 : \22y\22 } ]\00"} : () -> ()
+
+// COM: Table layout: number of tensors, then per tensor the ONNX data type
+// COM: (f32 = 1), the rank and the dimensions (-1 for a dynamic dimension).
+// CHECK-DAG:     llvm.mlir.global external constant @_entry_point_0_in_sig_bin(dense<[1, 1, 2, -1, 2]> : tensor<5xi64>)
+// CHECK-DAG:     llvm.mlir.global external constant @_entry_point_0_out_sig_bin(dense<[1, 1, 2, 1, 2]> : tensor<5xi64>)
+
+// CHECK:         llvm.func @omGetSignatureBinary([[arg0_:%.+]]: !llvm.ptr<i8>, [[arg1_:%.+]]: i64) -> !llvm.ptr<i64> {
+// CHECK:           [[STRNCMP_:%.+]] = llvm.call @strncmp
+// CHECK:           llvm.cond_br
+// CHECK:           [[IS_INPUT_:%.+]] = llvm.icmp "eq" [[arg1_]], {{.*}} : i64
+// CHECK:           llvm.cond_br [[IS_INPUT_]]
+// CHECK:           [[IN_ADDR_:%.+]] = llvm.mlir.addressof @_entry_point_0_in_sig_bin : !llvm.ptr<array<5 x i64>>
+// CHECK:           [[IN_PTR_:%.+]] = llvm.bitcast [[IN_ADDR_]] : !llvm.ptr<array<5 x i64>> to !llvm.ptr<i64>
+// CHECK:           llvm.return [[IN_PTR_]] : !llvm.ptr<i64>
+// CHECK:           [[OUT_ADDR_:%.+]] = llvm.mlir.addressof @_entry_point_0_out_sig_bin : !llvm.ptr<array<5 x i64>>
+// CHECK:           [[OUT_PTR_:%.+]] = llvm.bitcast [[OUT_ADDR_]] : !llvm.ptr<array<5 x i64>> to !llvm.ptr<i64>
+// CHECK:           llvm.return [[OUT_PTR_]] : !llvm.ptr<i64>
+// CHECK:           [[NOT_FOUND_:%.+]] = llvm.mlir.null : !llvm.ptr<i64>
+// CHECK:           llvm.return [[NOT_FOUND_]] : !llvm.ptr<i64>
+// CHECK:         }
+}
+
+// -----
+
 // COM: Generate calls that initialize accelerators.
 module attributes {"onnx-mlir.accels" = ["Pseudo-0x10001", "NNPA-0x10000"]} {
   func.func private @main_graph(%arg0: memref<10xf32>) -> memref<10xf32> {
@@ -0,0 +1,31 @@
+// RUN: onnx-mlir-opt --f16-weight-storage %s -split-input-file | FileCheck %s
+
+// A constant that is only read through tile packing: its storage narrows to
+// f16 and the pack copy now reads the f16 memref (the copy lowering widens
+// each element back to f32).
+func.func @pack_only_weight(%buff: memref<4x6xf32>) -> () {
+  %w = "krnl.global"() {name = "w", shape = [4, 6], value = dense<1.0> : tensor<4x6xf32>} : () -> memref<4x6xf32>
+  %f0 = arith.constant 0.0 : f32
+  %c0 = arith.constant 0 : index
+  krnl.copy_to_tile_buffer %buff, %w [%c0, %c0], %f0 : memref<4x6xf32>, memref<4x6xf32>
+  return
+}
+// CHECK-LABEL:  func.func @pack_only_weight
+// CHECK:          [[W_:%.+]] = "krnl.global"() {name = "w", shape = [4, 6], value = dense<1.000000e+00> : tensor<4x6xf16>} : () -> memref<4x6xf16>
+// CHECK:          krnl.copy_to_tile_buffer {{.*}}, [[W_]] {{.}}{{.*}}] : memref<4x6xf32>, memref<4x6xf16>
+
+// -----
+
+// A constant that is also read directly by a compute loop keeps f32 storage:
+// widening on every load would sit on the critical path.
+func.func @directly_read_weight(%buff: memref<4x6xf32>) -> f32 {
+  %w = "krnl.global"() {name = "w", shape = [4, 6], value = dense<1.0> : tensor<4x6xf32>} : () -> memref<4x6xf32>
+  %f0 = arith.constant 0.0 : f32
+  %c0 = arith.constant 0 : index
+  krnl.copy_to_tile_buffer %buff, %w [%c0, %c0], %f0 : memref<4x6xf32>, memref<4x6xf32>
+  %v = krnl.load %w[%c0, %c0] : memref<4x6xf32>
+  return %v : f32
+}
+// CHECK-LABEL:  func.func @directly_read_weight
+// CHECK:          "krnl.global"() {name = "w", shape = [4, 6], value = dense<1.000000e+00> : tensor<4x6xf32>} : () -> memref<4x6xf32>
+// CHECK-NOT:      tensor<4x6xf16>
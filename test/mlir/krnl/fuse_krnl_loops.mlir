@@ -0,0 +1,134 @@
+// RUN: onnx-mlir-opt --fuse-krnl-loops %s -split-input-file | FileCheck %s
+
+// Producer and consumer iterate over the same bounds and access the
+// intermediate buffer elementwise: the nests are fused and the buffer with
+// its alloc/dealloc is removed.
+func.func @fuse_elementwise(%arg0: memref<10x20xf32>, %arg1: memref<10x20xf32>) -> memref<10x20xf32> {
+  %0 = memref.alloc() {alignment = 16 : i64} : memref<10x20xf32>
+  %1 = memref.alloc() {alignment = 16 : i64} : memref<10x20xf32>
+  %2:2 = krnl.define_loops 2
+  krnl.iterate(%2#0, %2#1) with (%2#0 -> %arg2 = 0 to 10, %2#1 -> %arg3 = 0 to 20){
+    %4 = krnl.load %arg0[%arg2, %arg3] : memref<10x20xf32>
+    %5 = krnl.load %arg1[%arg2, %arg3] : memref<10x20xf32>
+    %6 = arith.addf %4, %5 : f32
+    krnl.store %6, %0[%arg2, %arg3] : memref<10x20xf32>
+  }
+  %3:2 = krnl.define_loops 2
+  krnl.iterate(%3#0, %3#1) with (%3#0 -> %arg2 = 0 to 10, %3#1 -> %arg3 = 0 to 20){
+    %4 = krnl.load %0[%arg2, %arg3] : memref<10x20xf32>
+    %5 = math.sqrt %4 : f32
+    krnl.store %5, %1[%arg2, %arg3] : memref<10x20xf32>
+  }
+  memref.dealloc %0 : memref<10x20xf32>
+  return %1 : memref<10x20xf32>
+
+  // CHECK-LABEL: func.func @fuse_elementwise
+  // CHECK-SAME:  ([[PARAM_0_:%.+]]: memref<10x20xf32>, [[PARAM_1_:%.+]]: memref<10x20xf32>) -> memref<10x20xf32>
+  // CHECK:       [[RES_:%.+]] = memref.alloc() {alignment = 16 : i64} : memref<10x20xf32>
+  // CHECK-NOT:   memref.alloc
+  // CHECK:       krnl.iterate
+  // CHECK-DAG:   [[LOAD_PARAM_0_:%.+]] = krnl.load [[PARAM_0_]]
+  // CHECK-DAG:   [[LOAD_PARAM_1_:%.+]] = krnl.load [[PARAM_1_]]
+  // CHECK:       [[ADD_:%.+]] = arith.addf [[LOAD_PARAM_0_]], [[LOAD_PARAM_1_]] : f32
+  // CHECK:       [[SQRT_:%.+]] = math.sqrt [[ADD_]] : f32
+  // CHECK:       krnl.store [[SQRT_]], [[RES_]]
+  // CHECK-NOT:   krnl.iterate
+  // CHECK-NOT:   memref.dealloc
+  // CHECK:       return [[RES_]] : memref<10x20xf32>
+}
+
+// -----
+
+// A chain of three elementwise nests collapses into a single nest.
+func.func @fuse_chain(%arg0: memref<32xf32>) -> memref<32xf32> {
+  %0 = memref.alloc() : memref<32xf32>
+  %1 = memref.alloc() : memref<32xf32>
+  %2 = memref.alloc() : memref<32xf32>
+  %3 = krnl.define_loops 1
+  krnl.iterate(%3) with (%3 -> %arg1 = 0 to 32){
+    %6 = krnl.load %arg0[%arg1] : memref<32xf32>
+    %7 = math.exp %6 : f32
+    krnl.store %7, %0[%arg1] : memref<32xf32>
+  }
+  %4 = krnl.define_loops 1
+  krnl.iterate(%4) with (%4 -> %arg1 = 0 to 32){
+    %6 = krnl.load %0[%arg1] : memref<32xf32>
+    %7 = arith.negf %6 : f32
+    krnl.store %7, %1[%arg1] : memref<32xf32>
+  }
+  %5 = krnl.define_loops 1
+  krnl.iterate(%5) with (%5 -> %arg1 = 0 to 32){
+    %6 = krnl.load %1[%arg1] : memref<32xf32>
+    %7 = math.tanh %6 : f32
+    krnl.store %7, %2[%arg1] : memref<32xf32>
+  }
+  memref.dealloc %0 : memref<32xf32>
+  memref.dealloc %1 : memref<32xf32>
+  return %2 : memref<32xf32>
+
+  // CHECK-LABEL: func.func @fuse_chain
+  // CHECK-SAME:  ([[PARAM_0_:%.+]]: memref<32xf32>) -> memref<32xf32>
+  // CHECK:       [[RES_:%.+]] = memref.alloc() : memref<32xf32>
+  // CHECK-NOT:   memref.alloc
+  // CHECK:       krnl.iterate
+  // CHECK:       [[LOAD_PARAM_0_:%.+]] = krnl.load [[PARAM_0_]]
+  // CHECK:       [[EXP_:%.+]] = math.exp [[LOAD_PARAM_0_]] : f32
+  // CHECK:       [[NEG_:%.+]] = arith.negf [[EXP_]] : f32
+  // CHECK:       [[TANH_:%.+]] = math.tanh [[NEG_]] : f32
+  // CHECK:       krnl.store [[TANH_]], [[RES_]]
+  // CHECK-NOT:   krnl.iterate
+  // CHECK:       return [[RES_]] : memref<32xf32>
+}
+
+// -----
+
+// The nests cover different iteration spaces: nothing is fused.
+func.func @no_fuse_different_bounds(%arg0: memref<10x20xf32>) -> memref<10x19xf32> {
+  %0 = memref.alloc() : memref<10x20xf32>
+  %1 = memref.alloc() : memref<10x19xf32>
+  %2:2 = krnl.define_loops 2
+  krnl.iterate(%2#0, %2#1) with (%2#0 -> %arg1 = 0 to 10, %2#1 -> %arg2 = 0 to 20){
+    %4 = krnl.load %arg0[%arg1, %arg2] : memref<10x20xf32>
+    %5 = math.sqrt %4 : f32
+    krnl.store %5, %0[%arg1, %arg2] : memref<10x20xf32>
+  }
+  %3:2 = krnl.define_loops 2
+  krnl.iterate(%3#0, %3#1) with (%3#0 -> %arg1 = 0 to 10, %3#1 -> %arg2 = 0 to 19){
+    %4 = krnl.load %0[%arg1, %arg2] : memref<10x20xf32>
+    krnl.store %4, %1[%arg1, %arg2] : memref<10x19xf32>
+  }
+  memref.dealloc %0 : memref<10x20xf32>
+  return %1 : memref<10x19xf32>
+
+  // CHECK-LABEL: func.func @no_fuse_different_bounds
+  // CHECK:       memref.alloc() : memref<10x20xf32>
+  // CHECK:       memref.alloc() : memref<10x19xf32>
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.iterate
+  // CHECK:       memref.dealloc
+}
+
+// -----
+
+// The intermediate buffer escapes through the return: nothing is fused.
+func.func @no_fuse_buffer_escapes(%arg0: memref<32xf32>) -> (memref<32xf32>, memref<32xf32>) {
+  %0 = memref.alloc() : memref<32xf32>
+  %1 = memref.alloc() : memref<32xf32>
+  %2 = krnl.define_loops 1
+  krnl.iterate(%2) with (%2 -> %arg1 = 0 to 32){
+    %4 = krnl.load %arg0[%arg1] : memref<32xf32>
+    %5 = math.exp %4 : f32
+    krnl.store %5, %0[%arg1] : memref<32xf32>
+  }
+  %3 = krnl.define_loops 1
+  krnl.iterate(%3) with (%3 -> %arg1 = 0 to 32){
+    %4 = krnl.load %0[%arg1] : memref<32xf32>
+    %5 = arith.negf %4 : f32
+    krnl.store %5, %1[%arg1] : memref<32xf32>
+  }
+  return %0, %1 : memref<32xf32>, memref<32xf32>
+
+  // CHECK-LABEL: func.func @no_fuse_buffer_escapes
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.iterate
+}
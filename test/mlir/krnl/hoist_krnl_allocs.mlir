@@ -0,0 +1,98 @@
+// RUN: onnx-mlir-opt --hoist-krnl-allocs %s -split-input-file | FileCheck %s
+
+// The scratch buffer has a loop-invariant dynamic size and dies in every
+// iteration: it is allocated once before the loop and freed after it.
+func.func @hoist_invariant_alloc(%arg0: memref<?xf32>) -> memref<?xf32> {
+  %c0 = arith.constant 0 : index
+  %d = memref.dim %arg0, %c0 : memref<?xf32>
+  %res = memref.alloc(%d) : memref<?xf32>
+  %l = krnl.define_loops 1
+  krnl.iterate(%l) with (%l -> %i = 0 to 10){
+    %buf = memref.alloc(%d) : memref<?xf32>
+    %v = krnl.load %arg0[%i] : memref<?xf32>
+    krnl.store %v, %buf[%i] : memref<?xf32>
+    %w = krnl.load %buf[%i] : memref<?xf32>
+    krnl.store %w, %res[%i] : memref<?xf32>
+    memref.dealloc %buf : memref<?xf32>
+  }
+  return %res : memref<?xf32>
+
+  // CHECK-LABEL: func.func @hoist_invariant_alloc
+  // CHECK:       [[RES_:%.+]] = memref.alloc({{.*}}) : memref<?xf32>
+  // CHECK:       [[BUF_:%.+]] = memref.alloc({{.*}}) : memref<?xf32>
+  // CHECK:       krnl.iterate
+  // CHECK-NOT:   memref.alloc
+  // CHECK-NOT:   memref.dealloc
+  // CHECK:       }
+  // CHECK:       memref.dealloc [[BUF_]] : memref<?xf32>
+  // CHECK:       return [[RES_]] : memref<?xf32>
+}
+
+// -----
+
+// The size is computed inside the loop but only from values defined outside:
+// the size computation is hoisted together with the allocation.
+func.func @hoist_alloc_with_size_computation(%arg0: memref<?xf32>) -> memref<?xf32> {
+  %c0 = arith.constant 0 : index
+  %res = memref.alloc() : memref<10xf32>
+  %rescast = memref.cast %res : memref<10xf32> to memref<?xf32>
+  %l = krnl.define_loops 1
+  krnl.iterate(%l) with (%l -> %i = 0 to 10){
+    %d = memref.dim %arg0, %c0 : memref<?xf32>
+    %buf = memref.alloc(%d) : memref<?xf32>
+    %v = krnl.load %arg0[%i] : memref<?xf32>
+    krnl.store %v, %buf[%i] : memref<?xf32>
+    %w = krnl.load %buf[%i] : memref<?xf32>
+    krnl.store %w, %rescast[%i] : memref<?xf32>
+    memref.dealloc %buf : memref<?xf32>
+  }
+  return %rescast : memref<?xf32>
+
+  // CHECK-LABEL: func.func @hoist_alloc_with_size_computation
+  // CHECK:       [[DIM_:%.+]] = memref.dim
+  // CHECK:       [[BUF_:%.+]] = memref.alloc([[DIM_]]) : memref<?xf32>
+  // CHECK:       krnl.iterate
+  // CHECK-NOT:   memref.alloc
+  // CHECK-NOT:   memref.dealloc
+  // CHECK:       }
+  // CHECK:       memref.dealloc [[BUF_]] : memref<?xf32>
+}
+
+// -----
+
+// The size depends on the induction variable: the allocation stays put.
+func.func @no_hoist_variant_size(%arg0: memref<?xf32>) {
+  %l = krnl.define_loops 1
+  krnl.iterate(%l) with (%l -> %i = 0 to 10){
+    %buf = memref.alloc(%i) : memref<?xf32>
+    %v = krnl.load %arg0[%i] : memref<?xf32>
+    krnl.store %v, %buf[%i] : memref<?xf32>
+    memref.dealloc %buf : memref<?xf32>
+  }
+  return
+
+  // CHECK-LABEL: func.func @no_hoist_variant_size
+  // CHECK:       krnl.iterate
+  // CHECK:       memref.alloc
+  // CHECK:       memref.dealloc
+  // CHECK:       }
+}
+
+// -----
+
+// Without a dealloc in the loop there is no proof the buffer dies each
+// iteration, so the allocation is not reused.
+func.func @no_hoist_without_dealloc(%arg0: memref<?xf32>, %arg1: index) {
+  %l = krnl.define_loops 1
+  krnl.iterate(%l) with (%l -> %i = 0 to 10){
+    %buf = memref.alloc(%arg1) : memref<?xf32>
+    %v = krnl.load %arg0[%i] : memref<?xf32>
+    krnl.store %v, %buf[%i] : memref<?xf32>
+  }
+  return
+
+  // CHECK-LABEL: func.func @no_hoist_without_dealloc
+  // CHECK:       krnl.iterate
+  // CHECK:       memref.alloc
+  // CHECK:       }
+}
@@ -170,4 +170,12 @@ module {
 //
 // CHECK:         ^bb22:
 // CHECK:           %[[VAL_115:.*]] = llvm.call @omTensorListGetOmtArray(%[[VAL_0]]) : (!llvm.ptr<i8>) -> !llvm.ptr<ptr<i8>>
+
+// COM: The unchecked twin entry point skips all input verification, so the
+// COM: first runtime call is the unpacking of the OMTensor list.
+// CHECK:         llvm.func @run_main_graph_unchecked(
+// CHECK-SAME:                              %[[UVAL_0:.*]]: !llvm.ptr<i8>) -> !llvm.ptr<i8> {
+// CHECK-NOT:       llvm.call @omTensorListGetSize
+// CHECK-NOT:       llvm.call @printf
+// CHECK:           {{.*}} = llvm.call @omTensorListGetOmtArray(%[[UVAL_0]]) : (!llvm.ptr<i8>) -> !llvm.ptr<ptr<i8>>
 }
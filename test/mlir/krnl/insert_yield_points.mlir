@@ -0,0 +1,29 @@
+// RUN: onnx-mlir-opt --insert-yield-points %s | FileCheck %s
+
+// The yield check lands once at the top of every outermost loop body; inner
+// loops stay untouched so the check is off the hot path. The runtime
+// function is declared once in the module.
+func.func @loop_nest(%arg0: memref<10x20xf32>) {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = krnl.define_loops 1
+  krnl.iterate(%0) with (%0 -> %arg1 = 0 to 10){
+    %1 = krnl.define_loops 1
+    krnl.iterate(%1) with (%1 -> %arg2 = 0 to 20){
+      krnl.store %cst, %arg0[%arg1, %arg2] : memref<10x20xf32>
+    }
+  }
+  %2:2 = krnl.define_loops 2
+  krnl.iterate(%2#0, %2#1) with (%2#0 -> %arg1 = 0 to 10, %2#1 -> %arg2 = 0 to 20){
+    krnl.store %cst, %arg0[%arg1, %arg2] : memref<10x20xf32>
+  }
+  return
+}
+
+// CHECK-LABEL: func.func @loop_nest
+// CHECK:         krnl.iterate(%{{.*}}) with (%{{.*}} -> %{{.*}} = 0 to 10){
+// CHECK-NEXT:      call @omTaskPoolYield() : () -> ()
+// CHECK:           krnl.iterate(%{{.*}}) with (%{{.*}} -> %{{.*}} = 0 to 20){
+// CHECK-NEXT:        krnl.store
+// CHECK:         krnl.iterate(%{{.*}}, %{{.*}}) with
+// CHECK-NEXT:      call @omTaskPoolYield() : () -> ()
+// CHECK:         func.func private @omTaskPoolYield()
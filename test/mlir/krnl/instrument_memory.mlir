@@ -0,0 +1,32 @@
+// RUN: onnx-mlir-opt --instrument-memory %s -split-input-file | FileCheck %s
+
+// Static allocation: the size folds into a single constant.
+func.func @static_alloc() -> memref<10x10xf32> {
+  %0 = memref.alloc() : memref<10x10xf32>
+  return %0 : memref<10x10xf32>
+}
+// CHECK-LABEL: func.func @static_alloc
+// CHECK:         [[SIZE_:%.+]] = arith.constant 400 : i64
+// CHECK:         [[RES_:%.+]] = memref.alloc() : memref<10x10xf32>
+// CHECK:         krnl.runtime_instrument_memory [[SIZE_]]
+// CHECK:         return [[RES_]] : memref<10x10xf32>
+
+// -----
+
+// Dynamic allocation: the dynamic dimension is multiplied in at runtime, and
+// the matching dealloc reports the negated size.
+func.func @dynamic_alloc_dealloc(%arg0: index) {
+  %0 = memref.alloc(%arg0) : memref<?x10xf32>
+  memref.dealloc %0 : memref<?x10xf32>
+  return
+}
+// CHECK-LABEL: func.func @dynamic_alloc_dealloc
+// CHECK:         [[STATIC_:%.+]] = arith.constant 40 : i64
+// CHECK:         [[DIM_:%.+]] = arith.index_cast %arg0 : index to i64
+// CHECK:         [[SIZE_:%.+]] = arith.muli [[STATIC_]], [[DIM_]] : i64
+// CHECK:         [[RES_:%.+]] = memref.alloc(%arg0) : memref<?x10xf32>
+// CHECK:         krnl.runtime_instrument_memory [[SIZE_]]
+// CHECK:         [[ZERO_:%.+]] = arith.constant 0 : i64
+// CHECK:         [[NEG_SIZE_:%.+]] = arith.subi [[ZERO_]], [[SIZE_]] : i64
+// CHECK:         krnl.runtime_instrument_memory [[NEG_SIZE_]]
+// CHECK:         memref.dealloc [[RES_]] : memref<?x10xf32>
@@ -0,0 +1,42 @@
+// RUN: onnx-mlir-opt -O3 --bundle-memory-pools --canonicalize %s -split-input-file | FileCheck %s
+
+func.func @test_dynamic_pool_bundling(%arg0: memref<?x10xf32>) -> memref<?x10xf32> {
+  %c0_i64 = arith.constant 0 : i64
+  %c0 = arith.constant 0 : index
+  %c4 = arith.constant 4 : index
+  %c10 = arith.constant 10 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  %dim = memref.dim %arg0, %c0 : memref<?x10xf32>
+  %sz0 = arith.muli %c4, %dim : index
+  %sz1 = arith.muli %sz0, %c10 : index
+  %0 = memref.alloc(%dim) : memref<?x10xf32>
+  %1 = memref.alloc(%sz1) : memref<?xi8>
+  %2 = "krnl.getref"(%1, %c0_i64, %dim) : (memref<?xi8>, i64, index) -> memref<?x10xf32>
+  %3 = memref.alloc(%sz1) : memref<?xi8>
+  %4 = "krnl.getref"(%3, %c0_i64, %dim) : (memref<?xi8>, i64, index) -> memref<?x10xf32>
+  krnl.store %cst, %4[%c0, %c0] : memref<?x10xf32>
+  krnl.store %cst, %2[%c0, %c0] : memref<?x10xf32>
+  krnl.store %cst, %0[%c0, %c0] : memref<?x10xf32>
+  memref.dealloc %3 : memref<?xi8>
+  memref.dealloc %1 : memref<?xi8>
+  return %0 : memref<?x10xf32>
+
+  // CHECK-LABEL: test_dynamic_pool_bundling
+  // CHECK-DAG: [[C0_I64:%.+]] = arith.constant 0 : i64
+  // CHECK-DAG: [[CST:%.+]] = arith.constant 0.000000e+00 : f32
+  // CHECK: [[DIM:%.+]] = memref.dim %arg0
+  // CHECK: [[SIZE0:%.+]] = arith.muli
+  // CHECK: [[SIZE:%.+]] = arith.muli
+  /// The two dynamic pools are merged into a single runtime-sized pool.
+  // CHECK-DAG: [[OFFSET:%.+]] = arith.index_cast [[SIZE]] : index to i64
+  // CHECK-DAG: [[TOTAL_SIZE:%.+]] = arith.addi [[SIZE]], [[SIZE]] : index
+  // CHECK: [[POOL:%.+]] = memref.alloc([[TOTAL_SIZE]]) : memref<?xi8>
+  // CHECK-DAG: [[GETREF1:%.+]] = "krnl.getref"([[POOL]], [[OFFSET]], [[DIM]]) : (memref<?xi8>, i64, index) -> memref<?x10xf32>
+  // CHECK-DAG: [[GETREF0:%.+]] = "krnl.getref"([[POOL]], [[C0_I64]], [[DIM]]) : (memref<?xi8>, i64, index) -> memref<?x10xf32>
+  // CHECK: [[RES:%.+]] = memref.alloc([[DIM]]) : memref<?x10xf32>
+  // CHECK: krnl.store [[CST]], [[GETREF1]]{{.*}} : memref<?x10xf32>
+  // CHECK: krnl.store [[CST]], [[GETREF0]]{{.*}} : memref<?x10xf32>
+  // CHECK: krnl.store [[CST]], [[RES]]{{.*}} : memref<?x10xf32>
+  // CHECK: memref.dealloc [[POOL]] : memref<?xi8>
+  // CHECK: return [[RES]] : memref<?x10xf32>
+}
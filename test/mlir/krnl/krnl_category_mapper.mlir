@@ -78,22 +78,21 @@ func.func private @test_category_mapper_string_to_int64(%arg0: memref<2x2x!krnl.
   // CHECK-DAG: llvm.func @strncmp(!llvm.ptr<i8>, !llvm.ptr<i8>, i64) -> i32
   // CHECK-DAG: llvm.func @strlen(!llvm.ptr<i8>) -> i64
   // CHECK-DAG: llvm.func @find_index_str(!llvm.ptr<i8>, !llvm.ptr<i32>, !llvm.ptr<i32>, i32) -> i64
-  // CHECK-DAG: llvm.mlir.global internal constant @cat("cat")
-  // CHECK-DAG: llvm.mlir.global internal constant @dog("dog")
-  // CHECK-DAG: llvm.mlir.global internal constant @cow("cow")    
-  // CHECK:     llvm.mlir.global internal constant @cats_strings{{.*}}() {addr_space = 0 : i32, alignment = 16 : i64} : !llvm.array<3 x ptr<i8>> { 
+  // CHECK-DAG: llvm.mlir.global internal constant @cats_strings_arena("cat\00dog\00cow\00")
+  // CHECK:     llvm.mlir.global internal constant @cats_strings{{.*}}() {addr_space = 0 : i32, alignment = 16 : i64} : !llvm.array<3 x ptr<i8>> {
   // CHECK:       [[ARRAY:%.+]] = llvm.mlir.undef : !llvm.array<3 x ptr<i8>>
-  // CHECK:       [[CAT_ADDR:%.+]] = llvm.mlir.addressof @cat : !llvm.ptr<array<3 x i8>>
+  // CHECK:       [[ARENA_ADDR:%.+]] = llvm.mlir.addressof @cats_strings_arena : !llvm.ptr<array<12 x i8>>
   // CHECK:       [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64
-  // CHECK:       [[CAT_GEP:%.+]] = llvm.getelementptr [[CAT_ADDR]]{{.*}}[[ZERO]], [[ZERO]]{{.*}} : (!llvm.ptr<array<3 x i8>>, i64, i64) -> !llvm.ptr<i8>
+  // CHECK:       [[CAT_OFF:%.+]] = llvm.mlir.constant(0 : i64) : i64
+  // CHECK:       [[CAT_GEP:%.+]] = llvm.getelementptr [[ARENA_ADDR]]{{.*}}[[ZERO]], [[CAT_OFF]]{{.*}} : (!llvm.ptr<array<12 x i8>>, i64, i64) -> !llvm.ptr<i8>
   // CHECK:       [[CAT_INS_VAL:%.+]] = llvm.insertvalue [[CAT_GEP]], [[ARRAY]][0] : !llvm.array<3 x ptr<i8>>
-  // CHECK:       [[DOG_ADDR:%.+]] = llvm.mlir.addressof @dog : !llvm.ptr<array<3 x i8>>
-  // CHECK:       [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64  
-  // CHECK:       [[DOG_GEP:%.+]] = llvm.getelementptr [[DOG_ADDR]]{{.*}}[[ZERO]], [[ZERO]]{{.*}} : (!llvm.ptr<array<3 x i8>>, i64, i64) -> !llvm.ptr<i8>
+  // CHECK:       [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64
+  // CHECK:       [[DOG_OFF:%.+]] = llvm.mlir.constant(4 : i64) : i64
+  // CHECK:       [[DOG_GEP:%.+]] = llvm.getelementptr [[ARENA_ADDR]]{{.*}}[[ZERO]], [[DOG_OFF]]{{.*}} : (!llvm.ptr<array<12 x i8>>, i64, i64) -> !llvm.ptr<i8>
   // CHECK:       [[DOG_INS_VAL:%.+]] = llvm.insertvalue [[DOG_GEP]], [[CAT_INS_VAL]][1] : !llvm.array<3 x ptr<i8>>
-  // CHECK:       [[COW_ADDR:%.+]] = llvm.mlir.addressof @cow : !llvm.ptr<array<3 x i8>>
-  // CHECK:       [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64    
-  // CHECK:       [[COW_GEP:%.+]] = llvm.getelementptr [[COW_ADDR]]{{.*}}[[ZERO]], [[ZERO]]{{.*}} : (!llvm.ptr<array<3 x i8>>, i64, i64) -> !llvm.ptr<i8>
+  // CHECK:       [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64
+  // CHECK:       [[COW_OFF:%.+]] = llvm.mlir.constant(8 : i64) : i64
+  // CHECK:       [[COW_GEP:%.+]] = llvm.getelementptr [[ARENA_ADDR]]{{.*}}[[ZERO]], [[COW_OFF]]{{.*}} : (!llvm.ptr<array<12 x i8>>, i64, i64) -> !llvm.ptr<i8>
   // CHECK:       [[COW_INS_VAL:%.+]] = llvm.insertvalue [[COW_GEP]], [[DOG_INS_VAL]][2] : !llvm.array<3 x ptr<i8>>
   // CHECK:       llvm.return [[COW_INS_VAL]] : !llvm.array<3 x ptr<i8>>
   // CHECK:     }
@@ -162,23 +161,22 @@ func.func private @test_category_mapper_int64_to_string(%arg0: memref<2x2xi64>)
   return %0 : memref<2x2x!krnl.string>
 
   // CHECK-DAG:  llvm.func @find_index_i64(i64, !llvm.ptr<i32>, !llvm.ptr<i32>, i32) -> i64
-  // CHECK-DAG:  llvm.mlir.global internal constant @none("none")
-  // CHECK-DAG:  llvm.mlir.global internal constant @cat("cat")
-  // CHECK-DAG:  llvm.mlir.global internal constant @dog("dog")
-  // CHECK-DAG:  llvm.mlir.global internal constant @cow("cow")    
-  // CHECK:      llvm.mlir.global internal constant @cats_strings{{.*}}() {addr_space = 0 : i32, alignment = 16 : i64} : !llvm.array<3 x ptr<i8>> { 
+  // CHECK-DAG:  llvm.mlir.global internal constant @default_string_arena("none\00")
+  // CHECK-DAG:  llvm.mlir.global internal constant @cats_strings_arena("cat\00dog\00cow\00")
+  // CHECK:      llvm.mlir.global internal constant @cats_strings{{.*}}() {addr_space = 0 : i32, alignment = 16 : i64} : !llvm.array<3 x ptr<i8>> {
   // CHECK:        [[ARRAY:%.+]] = llvm.mlir.undef : !llvm.array<3 x ptr<i8>>
-  // CHECK:        [[CAT_ADDR:%.+]] = llvm.mlir.addressof @cat : !llvm.ptr<array<3 x i8>>
+  // CHECK:        [[ARENA_ADDR:%.+]] = llvm.mlir.addressof @cats_strings_arena : !llvm.ptr<array<12 x i8>>
   // CHECK:        [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64
-  // CHECK:        [[CAT_GEP:%.+]] = llvm.getelementptr [[CAT_ADDR]]{{.*}}[[ZERO]], [[ZERO]]{{.*}} : (!llvm.ptr<array<3 x i8>>, i64, i64) -> !llvm.ptr<i8>
+  // CHECK:        [[CAT_OFF:%.+]] = llvm.mlir.constant(0 : i64) : i64
+  // CHECK:        [[CAT_GEP:%.+]] = llvm.getelementptr [[ARENA_ADDR]]{{.*}}[[ZERO]], [[CAT_OFF]]{{.*}} : (!llvm.ptr<array<12 x i8>>, i64, i64) -> !llvm.ptr<i8>
   // CHECK:        [[CAT_INS_VAL:%.+]] = llvm.insertvalue [[CAT_GEP]], [[ARRAY]][0] : !llvm.array<3 x ptr<i8>>
-  // CHECK:        [[DOG_ADDR:%.+]] = llvm.mlir.addressof @dog : !llvm.ptr<array<3 x i8>>
-  // CHECK:        [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64  
-  // CHECK:        [[DOG_GEP:%.+]] = llvm.getelementptr [[DOG_ADDR]]{{.*}}[[ZERO]], [[ZERO]]{{.*}} : (!llvm.ptr<array<3 x i8>>, i64, i64) -> !llvm.ptr<i8>
+  // CHECK:        [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64
+  // CHECK:        [[DOG_OFF:%.+]] = llvm.mlir.constant(4 : i64) : i64
+  // CHECK:        [[DOG_GEP:%.+]] = llvm.getelementptr [[ARENA_ADDR]]{{.*}}[[ZERO]], [[DOG_OFF]]{{.*}} : (!llvm.ptr<array<12 x i8>>, i64, i64) -> !llvm.ptr<i8>
   // CHECK:        [[DOG_INS_VAL:%.+]] = llvm.insertvalue [[DOG_GEP]], [[CAT_INS_VAL]][1] : !llvm.array<3 x ptr<i8>>
-  // CHECK:        [[COW_ADDR:%.+]] = llvm.mlir.addressof @cow : !llvm.ptr<array<3 x i8>>
-  // CHECK:        [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64    
-  // CHECK:        [[COW_GEP:%.+]] = llvm.getelementptr [[COW_ADDR]]{{.*}}[[ZERO]], [[ZERO]]{{.*}} : (!llvm.ptr<array<3 x i8>>, i64, i64) -> !llvm.ptr<i8>
+  // CHECK:        [[ZERO:%.+]] = llvm.mlir.constant(0 : i64) : i64
+  // CHECK:        [[COW_OFF:%.+]] = llvm.mlir.constant(8 : i64) : i64
+  // CHECK:        [[COW_GEP:%.+]] = llvm.getelementptr [[ARENA_ADDR]]{{.*}}[[ZERO]], [[COW_OFF]]{{.*}} : (!llvm.ptr<array<12 x i8>>, i64, i64) -> !llvm.ptr<i8>
   // CHECK:        [[COW_INS_VAL:%.+]] = llvm.insertvalue [[COW_GEP]], [[DOG_INS_VAL]][2] : !llvm.array<3 x ptr<i8>>
   // CHECK:        llvm.return [[COW_INS_VAL]] : !llvm.array<3 x ptr<i8>>
   // CHECK:      }
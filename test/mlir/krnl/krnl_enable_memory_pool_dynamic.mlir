@@ -0,0 +1,28 @@
+// RUN: onnx-mlir-opt -O3 --enable-memory-pool %s -split-input-file | FileCheck %s
+
+/// Dynamically shaped intermediate MemRefs get a runtime-sized memory pool.
+func.func @test_enable_dynamic_pool(%arg0: memref<?x10xf32>) -> memref<?x10xf32> {
+  %c0 = arith.constant 0 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  %dim = memref.dim %arg0, %c0 : memref<?x10xf32>
+  %0 = memref.alloc(%dim) : memref<?x10xf32>
+  %1 = memref.alloc(%dim) : memref<?x10xf32>
+  krnl.store %cst, %1[%c0, %c0] : memref<?x10xf32>
+  krnl.store %cst, %0[%c0, %c0] : memref<?x10xf32>
+  memref.dealloc %1 : memref<?x10xf32>
+  return %0 : memref<?x10xf32>
+
+  // CHECK-LABEL: test_enable_dynamic_pool
+  // CHECK: [[DIM:%.+]] = memref.dim %arg0
+  /// The returned alloc is not pooled.
+  // CHECK: [[RES:%.+]] = memref.alloc([[DIM]]) : memref<?x10xf32>
+  /// The pool size is computed at run time from the dynamic dimension.
+  // CHECK: [[SIZE0:%.+]] = arith.muli
+  // CHECK: [[SIZE:%.+]] = arith.muli
+  // CHECK: [[POOL:%.+]] = memref.alloc([[SIZE]]) : memref<?xi8>
+  // CHECK: [[GETREF:%.+]] = "krnl.getref"([[POOL]], {{.*}}, [[DIM]]) : (memref<?xi8>, i64, index) -> memref<?x10xf32>
+  // CHECK: krnl.store %cst, [[GETREF]]{{.*}} : memref<?x10xf32>
+  // CHECK: krnl.store %cst, [[RES]]{{.*}} : memref<?x10xf32>
+  // CHECK: memref.dealloc [[POOL]] : memref<?xi8>
+  // CHECK: return [[RES]] : memref<?x10xf32>
+}
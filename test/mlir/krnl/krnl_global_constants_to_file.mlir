@@ -0,0 +1,43 @@
+// RUN: onnx-mlir-opt -O3 --convert-krnl-to-llvm='store-constants-to-file constants-to-file-single-threshold=16 constants-to-file-name=%t.constants.bin' %s -split-input-file | FileCheck %s
+
+// A constant above the threshold is externalized: its data is written to the
+// constants file and the generated code materializes it from the lazily
+// mapped segment instead of an embedded LLVM global.
+func.func @test_constant_to_file() -> memref<10xf32> {
+  %0 = "krnl.global"() {name = "constant_external", shape = [10], value = dense<[0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0]> : tensor<10xf32>} : () -> memref<10xf32>
+  return %0 : memref<10xf32>
+}
+// CHECK:         llvm.mlir.global internal @om_external_constant_data()
+// CHECK-NOT:     llvm.mlir.global internal constant @constant_external
+// CHECK-LABEL:   llvm.func @test_constant_to_file
+// CHECK:           [[BASE:%.+]] = llvm.call @omGetExternalConstantAddr({{.*}}) : (!llvm.ptr<ptr<i8>>, !llvm.ptr<i8>, i64) -> !llvm.ptr<i8>
+// CHECK:           [[OFFSET:%.+]] = llvm.mlir.constant(0 : i64) : i64
+// CHECK:           [[ADDR:%.+]] = llvm.getelementptr [[BASE]]{{\[}}[[OFFSET]]]
+// CHECK:           llvm.bitcast [[ADDR]] : !llvm.ptr<i8> to !llvm.ptr<f32>
+
+// -----
+
+// A constant below the threshold stays embedded in the generated code.
+func.func @test_small_constant_stays_embedded() -> memref<3xf32> {
+  %0 = "krnl.global"() {name = "constant_small", shape = [3], value = dense<[0.0, 0.1, 0.2]> : tensor<3xf32>} : () -> memref<3xf32>
+  return %0 : memref<3xf32>
+}
+// CHECK:         llvm.mlir.global internal constant @constant_small(dense<[0.000000e+00, 1.000000e-01, 2.000000e-01]> : tensor<3xf32>)
+// CHECK-NOT:     llvm.call @omGetExternalConstantAddr
+
+// -----
+
+// Externalized constants with identical content share one region of the
+// constants file: both loads compute their address from offset 0.
+func.func @test_identical_constants_share_offset() -> (memref<10xf32>, memref<10xf32>) {
+  %0 = "krnl.global"() {name = "packed_a", shape = [10], value = dense<[0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0]> : tensor<10xf32>} : () -> memref<10xf32>
+  %1 = "krnl.global"() {name = "packed_b", shape = [10], value = dense<[0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0]> : tensor<10xf32>} : () -> memref<10xf32>
+  return %0, %1 : memref<10xf32>, memref<10xf32>
+}
+// CHECK-LABEL:   llvm.func @test_identical_constants_share_offset
+// CHECK:           llvm.call @omGetExternalConstantAddr
+// CHECK:           [[OFFSET_A:%.+]] = llvm.mlir.constant(0 : i64) : i64
+// CHECK:           llvm.getelementptr {{.*}}{{\[}}[[OFFSET_A]]]
+// CHECK:           llvm.call @omGetExternalConstantAddr
+// CHECK:           [[OFFSET_B:%.+]] = llvm.mlir.constant(0 : i64) : i64
+// CHECK:           llvm.getelementptr {{.*}}{{\[}}[[OFFSET_B]]]
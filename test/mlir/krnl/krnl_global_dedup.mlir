@@ -0,0 +1,40 @@
+// RUN: onnx-mlir-opt -O3 --convert-krnl-to-llvm %s -split-input-file | FileCheck %s
+
+// Constants with identical content, type and alignment share one LLVM
+// global: the duplicate is renamed to the canonical symbol and no second
+// copy of the data is emitted.
+func.func @test_dedup_identical_constants() -> (memref<3xf32>, memref<3xf32>) {
+  %0 = "krnl.global"() {name = "dup_a", shape = [3], value = dense<[0.0, 0.1, 0.2]> : tensor<3xf32>} : () -> memref<3xf32>
+  %1 = "krnl.global"() {name = "dup_b", shape = [3], value = dense<[0.0, 0.1, 0.2]> : tensor<3xf32>} : () -> memref<3xf32>
+  return %0, %1 : memref<3xf32>, memref<3xf32>
+}
+// CHECK:         llvm.mlir.global internal constant @dup_a(dense<[0.000000e+00, 1.000000e-01, 2.000000e-01]> : tensor<3xf32>)
+// CHECK-NOT:     llvm.mlir.global internal constant @dup_b
+// CHECK-LABEL:   llvm.func @test_dedup_identical_constants
+// CHECK:           llvm.mlir.addressof @dup_a
+// CHECK:           llvm.mlir.addressof @dup_a
+
+// -----
+
+// Constants with the same content but different alignment requirements keep
+// their own globals.
+func.func @test_no_dedup_different_alignment() -> (memref<3xf32>, memref<3xf32>) {
+  %0 = "krnl.global"() {name = "aligned_a", alignment = 1024 : i64, shape = [3], value = dense<[0.0, 0.1, 0.2]> : tensor<3xf32>} : () -> memref<3xf32>
+  %1 = "krnl.global"() {name = "aligned_b", shape = [3], value = dense<[0.0, 0.1, 0.2]> : tensor<3xf32>} : () -> memref<3xf32>
+  return %0, %1 : memref<3xf32>, memref<3xf32>
+}
+// CHECK-DAG:     llvm.mlir.global internal constant @aligned_a({{.*}}alignment = 1024
+// CHECK-DAG:     llvm.mlir.global internal constant @aligned_b
+// CHECK-LABEL:   llvm.func @test_no_dedup_different_alignment
+
+// -----
+
+// Constants with the same content but different element types are distinct.
+func.func @test_no_dedup_different_type() -> (memref<2xi32>, memref<2xf32>) {
+  %0 = "krnl.global"() {name = "typed_a", shape = [2], value = dense<[0, 0]> : tensor<2xi32>} : () -> memref<2xi32>
+  %1 = "krnl.global"() {name = "typed_b", shape = [2], value = dense<[0.0, 0.0]> : tensor<2xf32>} : () -> memref<2xf32>
+  return %0, %1 : memref<2xi32>, memref<2xf32>
+}
+// CHECK-DAG:     llvm.mlir.global internal constant @typed_a
+// CHECK-DAG:     llvm.mlir.global internal constant @typed_b
+// CHECK-LABEL:   llvm.func @test_no_dedup_different_type
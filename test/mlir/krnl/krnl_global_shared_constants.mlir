@@ -0,0 +1,26 @@
+// RUN: onnx-mlir-opt -O3 --convert-krnl-to-llvm='shared-constants-dir=%t.dir constants-to-file-single-threshold=16' %s -split-input-file | FileCheck %s
+
+// Two constants with identical content hash to the same file: a single
+// cached base pointer is emitted and both loads go through it.
+func.func @test_shared_constants() -> (memref<10xf32>, memref<10xf32>) {
+  %0 = "krnl.global"() {name = "constant_a", shape = [10], value = dense<[0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0]> : tensor<10xf32>} : () -> memref<10xf32>
+  %1 = "krnl.global"() {name = "constant_b", shape = [10], value = dense<[0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0]> : tensor<10xf32>} : () -> memref<10xf32>
+  return %0, %1 : memref<10xf32>, memref<10xf32>
+}
+// CHECK:         llvm.mlir.global internal @om_external_constant_data_{{[0-9a-f]+}}()
+// CHECK-NOT:     llvm.mlir.global internal @om_external_constant_data_
+// CHECK-NOT:     llvm.mlir.global internal constant @constant_a
+// CHECK-NOT:     llvm.mlir.global internal constant @constant_b
+// CHECK-LABEL:   llvm.func @test_shared_constants
+// CHECK:           llvm.call @omGetExternalConstantAddr({{.*}}) : (!llvm.ptr<ptr<i8>>, !llvm.ptr<i8>, i64) -> !llvm.ptr<i8>
+// CHECK:           llvm.call @omGetExternalConstantAddr({{.*}}) : (!llvm.ptr<ptr<i8>>, !llvm.ptr<i8>, i64) -> !llvm.ptr<i8>
+
+// -----
+
+// A constant below the threshold stays embedded in the generated code.
+func.func @test_small_constant_stays_embedded() -> memref<3xf32> {
+  %0 = "krnl.global"() {name = "constant_small", shape = [3], value = dense<[0.0, 0.1, 0.2]> : tensor<3xf32>} : () -> memref<3xf32>
+  return %0 : memref<3xf32>
+}
+// CHECK:         llvm.mlir.global internal constant @constant_small(dense<[0.000000e+00, 1.000000e-01, 2.000000e-01]> : tensor<3xf32>)
+// CHECK-NOT:     llvm.call @omGetExternalConstantAddr
@@ -0,0 +1,30 @@
+// RUN: onnx-mlir-opt --convert-krnl-to-llvm %s -split-input-file | FileCheck %s --check-prefix=APPROX
+// RUN: onnx-mlir-opt --convert-krnl-to-llvm='approx-transcendentals=false' %s -split-input-file | FileCheck %s --check-prefix=LIBM
+
+/// By default f32 transcendentals are expanded into inline polynomial
+/// approximations; with approx-transcendentals=false they call libm.
+func.func @test_erf_f32(%arg0: f32) -> f32 {
+  %0 = math.erf %arg0 : f32
+  return %0 : f32
+}
+// APPROX-LABEL: test_erf_f32
+// APPROX-NOT: llvm.call @erff
+
+// LIBM: llvm.func @erff(f32) -> f32
+// LIBM-LABEL: test_erf_f32
+// LIBM: llvm.call @erff({{.*}}) : (f32) -> f32
+
+// -----
+
+/// f64 has no polynomial approximation and falls back to libm either way.
+func.func @test_erf_f64(%arg0: f64) -> f64 {
+  %0 = math.erf %arg0 : f64
+  return %0 : f64
+}
+// APPROX: llvm.func @erf(f64) -> f64
+// APPROX-LABEL: test_erf_f64
+// APPROX: llvm.call @erf({{.*}}) : (f64) -> f64
+
+// LIBM: llvm.func @erf(f64) -> f64
+// LIBM-LABEL: test_erf_f64
+// LIBM: llvm.call @erf({{.*}}) : (f64) -> f64
@@ -0,0 +1,27 @@
+// RUN: onnx-mlir-opt --convert-krnl-to-llvm %s | FileCheck %s
+
+// Test that 'krnl.run_loop' creates a chunk thunk for the callee and hands
+// it together with the packed arguments, the trip count and the schedule to
+// the runtime scheduler.
+func.func private @axpy_ploop0(%arg0: index, %arg1: index, %arg2: index, %arg3: index, %arg4: memref<2xf32>) {
+  return
+}
+
+func.func @axpy(%arg0: memref<2xf32>, %lb: index, %step: index, %trip: index) {
+  "krnl.run_loop"(%trip, %lb, %step, %arg0) {callee = @axpy_ploop0, schedule = 2 : i64} : (index, index, index, memref<2xf32>) -> ()
+  return
+}
+
+// CHECK-DAG: llvm.func @omRunParallelLoop(!llvm.ptr<func<void (i64, i64, ptr<i8>)>>, !llvm.ptr<i8>, i64, i64)
+
+// CHECK-LABEL: llvm.func @axpy
+// CHECK:       [[PACKED_PTR:%.+]] = llvm.alloca {{.*}} x !llvm.struct<(i64, i64, struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>)>
+// CHECK:       llvm.store {{.*}}, [[PACKED_PTR]]
+// CHECK:       [[FN_ADDR:%.+]] = llvm.mlir.addressof @axpy_ploop0_thunk : !llvm.ptr<func<void (i64, i64, ptr<i8>)>>
+// CHECK:       [[SCHEDULE:%.+]] = llvm.mlir.constant(2 : i64) : i64
+// CHECK:       llvm.call @omRunParallelLoop([[FN_ADDR]], {{.*}}, {{.*}}, [[SCHEDULE]]) : (!llvm.ptr<func<void (i64, i64, ptr<i8>)>>, !llvm.ptr<i8>, i64, i64) -> ()
+
+// CHECK-LABEL: llvm.func @axpy_ploop0_thunk([[CHUNK_LB:%.+]]: i64, [[CHUNK_UB:%.+]]: i64, [[ENV:%.+]]: !llvm.ptr<i8>)
+// CHECK:       [[PACKED:%.+]] = llvm.load {{.*}} : !llvm.ptr<struct<(i64, i64, struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>)>>
+// CHECK:       llvm.call @axpy_ploop0([[CHUNK_LB]], [[CHUNK_UB]], {{.*}}, {{.*}}, {{.*}}, {{.*}}, {{.*}}, {{.*}}, {{.*}}) : (i64, i64, i64, i64, !llvm.ptr<f32>, !llvm.ptr<f32>, i64, i64, i64) -> ()
+// CHECK:       llvm.return
@@ -0,0 +1,27 @@
+// RUN: onnx-mlir-opt --convert-krnl-to-llvm %s | FileCheck %s
+
+// Test that 'krnl.run_tasks' creates one thunk per callee and hands the
+// thunks together with the packed arguments to the runtime scheduler.
+func.func private @branch_task0(%arg0: memref<2xf32>, %arg1: i64) {
+  return
+}
+
+func.func @branches(%arg0: memref<2xf32>, %arg1: i64) {
+  "krnl.run_tasks"(%arg0, %arg1) {callees = [@branch_task0], segmentSizes = [2]} : (memref<2xf32>, i64) -> ()
+  return
+}
+
+// CHECK-DAG: llvm.func @omRunParallelTasks(!llvm.ptr<ptr<func<void (ptr<i8>)>>>, !llvm.ptr<ptr<i8>>, i64)
+
+// CHECK-LABEL: llvm.func @branches
+// CHECK:       [[FN_ARRAY:%.+]] = llvm.alloca {{.*}} x !llvm.ptr<func<void (ptr<i8>)>>
+// CHECK:       [[ARG_ARRAY:%.+]] = llvm.alloca {{.*}} x !llvm.ptr<i8>
+// CHECK:       [[PACKED_PTR:%.+]] = llvm.alloca {{.*}} x !llvm.struct<(struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>, i64)>
+// CHECK:       llvm.store {{.*}}, [[PACKED_PTR]]
+// CHECK:       [[FN_ADDR:%.+]] = llvm.mlir.addressof @branch_task0_thunk : !llvm.ptr<func<void (ptr<i8>)>>
+// CHECK:       llvm.call @omRunParallelTasks([[FN_ARRAY]], [[ARG_ARRAY]], {{.*}}) : (!llvm.ptr<ptr<func<void (ptr<i8>)>>>, !llvm.ptr<ptr<i8>>, i64) -> ()
+
+// CHECK-LABEL: llvm.func @branch_task0_thunk([[THUNK_ARG:%.+]]: !llvm.ptr<i8>)
+// CHECK:       [[PACKED:%.+]] = llvm.load {{.*}} : !llvm.ptr<struct<(struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>, i64)>>
+// CHECK:       llvm.call @branch_task0({{.*}}, {{.*}}, {{.*}}, {{.*}}, {{.*}}, {{.*}}) : (!llvm.ptr<f32>, !llvm.ptr<f32>, i64, i64, i64, i64) -> ()
+// CHECK:       llvm.return
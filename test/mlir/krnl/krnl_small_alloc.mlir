@@ -0,0 +1,84 @@
+// RUN: onnx-mlir-opt -O3 --convert-krnl-to-llvm='small-tensor-allocator' %s -split-input-file | FileCheck %s
+
+// A small temporary that is deallocated in the function is served by the
+// runtime's per-thread slab allocator.
+func.func @small_temporary(%arg0: f32) -> f32 {
+  %c0 = arith.constant 0 : index
+  %0 = memref.alloc() : memref<10xf32>
+  memref.store %arg0, %0[%c0] : memref<10xf32>
+  %1 = memref.load %0[%c0] : memref<10xf32>
+  memref.dealloc %0 : memref<10xf32>
+  return %1 : f32
+}
+// CHECK-LABEL:   llvm.func @small_temporary
+// CHECK-DAG:       [[SITE:%.+]] = llvm.mlir.constant(0 : i64) : i64
+// CHECK:           llvm.call @omSmallAllocSite({{.*}}, [[SITE]]) : (i64, i64) -> !llvm.ptr<i8>
+// CHECK:           llvm.call @omSmallFree({{.*}}) : (!llvm.ptr<i8>) -> ()
+// CHECK-NOT:       llvm.call @malloc
+
+// -----
+
+// A dynamically shaped temporary is routed as well; the runtime falls back
+// to malloc at run time when the size exceeds the slab threshold.
+func.func @dynamic_temporary(%arg0: f32, %arg1: index) -> f32 {
+  %c0 = arith.constant 0 : index
+  %0 = memref.alloc(%arg1) : memref<?xf32>
+  memref.store %arg0, %0[%c0] : memref<?xf32>
+  %1 = memref.load %0[%c0] : memref<?xf32>
+  memref.dealloc %0 : memref<?xf32>
+  return %1 : f32
+}
+// CHECK-LABEL:   llvm.func @dynamic_temporary
+// CHECK:           llvm.call @omSmallAllocSite
+// CHECK:           llvm.call @omSmallFree
+
+// -----
+
+// A buffer that escapes as a result is released by the caller with plain
+// free and must keep coming from plain malloc.
+func.func @escaping_alloc() -> memref<10xf32> {
+  %0 = memref.alloc() : memref<10xf32>
+  return %0 : memref<10xf32>
+}
+// CHECK-LABEL:   llvm.func @escaping_alloc
+// CHECK:           llvm.call @malloc
+// CHECK-NOT:       llvm.call @omSmallAllocSite
+
+// -----
+
+// A temporary statically above the slab threshold gains nothing from the
+// routing and stays on malloc/free.
+func.func @large_temporary(%arg0: f32) -> f32 {
+  %c0 = arith.constant 0 : index
+  %0 = memref.alloc() : memref<4096xf32>
+  memref.store %arg0, %0[%c0] : memref<4096xf32>
+  %1 = memref.load %0[%c0] : memref<4096xf32>
+  memref.dealloc %0 : memref<4096xf32>
+  return %1 : f32
+}
+// CHECK-LABEL:   llvm.func @large_temporary
+// CHECK:           llvm.call @malloc
+// CHECK:           llvm.call @free
+// CHECK-NOT:       llvm.call @omSmallAllocSite
+
+// -----
+
+// Every routed alloc gets its own allocation-site ID, baked into the
+// generated call for the runtime's heap profile.
+func.func @two_sites(%arg0: f32) -> f32 {
+  %c0 = arith.constant 0 : index
+  %0 = memref.alloc() : memref<10xf32>
+  memref.store %arg0, %0[%c0] : memref<10xf32>
+  %1 = memref.load %0[%c0] : memref<10xf32>
+  memref.dealloc %0 : memref<10xf32>
+  %2 = memref.alloc() : memref<20xf32>
+  memref.store %1, %2[%c0] : memref<20xf32>
+  %3 = memref.load %2[%c0] : memref<20xf32>
+  memref.dealloc %2 : memref<20xf32>
+  return %3 : f32
+}
+// CHECK-LABEL:   llvm.func @two_sites
+// CHECK-DAG:       llvm.mlir.constant(0 : i64) : i64
+// CHECK-DAG:       llvm.mlir.constant(1 : i64) : i64
+// CHECK-COUNT-2:   llvm.call @omSmallAllocSite
+// CHECK-NOT:       llvm.call @omSmallAllocSite
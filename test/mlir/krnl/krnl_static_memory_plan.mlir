@@ -0,0 +1,129 @@
+// RUN: onnx-mlir-opt -O3 --static-memory-plan --canonicalize %s -split-input-file | FileCheck %s
+
+/// 1. A chain of three buffers where the first and last have disjoint live
+/// ranges: the plan lets them share arena bytes and shrinks the pool from
+/// 1200 to 800 bytes.
+func.func @reuse_across_chain(%arg0: memref<10x10xf32>) -> memref<10x10xf32> {
+  %c0_i64 = arith.constant 0 : i64
+  %c400_i64 = arith.constant 400 : i64
+  %c800_i64 = arith.constant 800 : i64
+  %0 = memref.alloc() : memref<10x10xf32>
+  %1 = memref.alloc() : memref<1200xi8>
+  %2 = "krnl.getref"(%1, %c800_i64) : (memref<1200xi8>, i64) -> memref<10x10xf32>
+  %3 = "krnl.getref"(%1, %c400_i64) : (memref<1200xi8>, i64) -> memref<10x10xf32>
+  %4 = "krnl.getref"(%1, %c0_i64) : (memref<1200xi8>, i64) -> memref<10x10xf32>
+  %5:2 = krnl.define_loops 2
+  krnl.iterate(%5#0, %5#1) with (%5#0 -> %arg1 = 0 to 10, %5#1 -> %arg2 = 0 to 10) {
+    %9 = krnl.load %arg0[%arg1, %arg2] : memref<10x10xf32>
+    krnl.store %9, %2[%arg1, %arg2] : memref<10x10xf32>
+  }
+  %6:2 = krnl.define_loops 2
+  krnl.iterate(%6#0, %6#1) with (%6#0 -> %arg1 = 0 to 10, %6#1 -> %arg2 = 0 to 10) {
+    %9 = krnl.load %2[%arg1, %arg2] : memref<10x10xf32>
+    %10 = arith.addf %9, %9 : f32
+    krnl.store %10, %3[%arg1, %arg2] : memref<10x10xf32>
+  }
+  %7:2 = krnl.define_loops 2
+  krnl.iterate(%7#0, %7#1) with (%7#0 -> %arg1 = 0 to 10, %7#1 -> %arg2 = 0 to 10) {
+    %9 = krnl.load %3[%arg1, %arg2] : memref<10x10xf32>
+    %10 = arith.mulf %9, %9 : f32
+    krnl.store %10, %4[%arg1, %arg2] : memref<10x10xf32>
+  }
+  %8:2 = krnl.define_loops 2
+  krnl.iterate(%8#0, %8#1) with (%8#0 -> %arg1 = 0 to 10, %8#1 -> %arg2 = 0 to 10) {
+    %9 = krnl.load %4[%arg1, %arg2] : memref<10x10xf32>
+    krnl.store %9, %0[%arg1, %arg2] : memref<10x10xf32>
+  }
+  return %0 : memref<10x10xf32>
+
+  // CHECK-LABEL: func.func @reuse_across_chain
+  // CHECK-DAG: [[C0:%.+]] = arith.constant 0 : i64
+  // CHECK-DAG: [[C400:%.+]] = arith.constant 400 : i64
+  // CHECK: [[ARENA:%.+]] = memref.alloc() : memref<800xi8>
+  // CHECK: "krnl.getref"([[ARENA]], [[C0]]) : (memref<800xi8>, i64) -> memref<10x10xf32>
+  // CHECK: "krnl.getref"([[ARENA]], [[C400]]) : (memref<800xi8>, i64) -> memref<10x10xf32>
+  // CHECK: "krnl.getref"([[ARENA]], [[C0]]) : (memref<800xi8>, i64) -> memref<10x10xf32>
+  // CHECK-NOT: memref.alloc() : memref<1200xi8>
+}
+
+// -----
+
+/// 2. Both buffers are read back in the final loop so their live ranges
+/// overlap: the plan finds no reuse and the pool is left untouched.
+func.func @no_reuse_when_live_ranges_overlap(%arg0: memref<10x10xf32>) -> memref<10x10xf32> {
+  %c0_i64 = arith.constant 0 : i64
+  %c400_i64 = arith.constant 400 : i64
+  %0 = memref.alloc() : memref<10x10xf32>
+  %1 = memref.alloc() : memref<800xi8>
+  %2 = "krnl.getref"(%1, %c400_i64) : (memref<800xi8>, i64) -> memref<10x10xf32>
+  %3 = "krnl.getref"(%1, %c0_i64) : (memref<800xi8>, i64) -> memref<10x10xf32>
+  %4:2 = krnl.define_loops 2
+  krnl.iterate(%4#0, %4#1) with (%4#0 -> %arg1 = 0 to 10, %4#1 -> %arg2 = 0 to 10) {
+    %7 = krnl.load %arg0[%arg1, %arg2] : memref<10x10xf32>
+    krnl.store %7, %2[%arg1, %arg2] : memref<10x10xf32>
+  }
+  %5:2 = krnl.define_loops 2
+  krnl.iterate(%5#0, %5#1) with (%5#0 -> %arg1 = 0 to 10, %5#1 -> %arg2 = 0 to 10) {
+    %7 = krnl.load %arg0[%arg1, %arg2] : memref<10x10xf32>
+    %8 = arith.addf %7, %7 : f32
+    krnl.store %8, %3[%arg1, %arg2] : memref<10x10xf32>
+  }
+  %6:2 = krnl.define_loops 2
+  krnl.iterate(%6#0, %6#1) with (%6#0 -> %arg1 = 0 to 10, %6#1 -> %arg2 = 0 to 10) {
+    %7 = krnl.load %2[%arg1, %arg2] : memref<10x10xf32>
+    %8 = krnl.load %3[%arg1, %arg2] : memref<10x10xf32>
+    %9 = arith.addf %7, %8 : f32
+    krnl.store %9, %0[%arg1, %arg2] : memref<10x10xf32>
+  }
+  return %0 : memref<10x10xf32>
+
+  // CHECK-LABEL: func.func @no_reuse_when_live_ranges_overlap
+  // CHECK-DAG: [[C0:%.+]] = arith.constant 0 : i64
+  // CHECK-DAG: [[C400:%.+]] = arith.constant 400 : i64
+  // CHECK: [[POOL:%.+]] = memref.alloc() : memref<800xi8>
+  // CHECK: "krnl.getref"([[POOL]], [[C400]])
+  // CHECK: "krnl.getref"([[POOL]], [[C0]])
+}
+
+// -----
+
+/// 3. A smaller buffer whose live range starts after a larger one has died
+/// fits inside the larger buffer's footprint: the arena is sized by the
+/// largest buffer alone.
+func.func @small_buffer_nests_in_large(%arg0: memref<10x20xf32>) -> memref<10x10xf32> {
+  %c0_i64 = arith.constant 0 : i64
+  %c800_i64 = arith.constant 800 : i64
+  %0 = memref.alloc() : memref<10x10xf32>
+  %1 = memref.alloc() : memref<1200xi8>
+  %2 = "krnl.getref"(%1, %c800_i64) : (memref<1200xi8>, i64) -> memref<10x20xf32>
+  %3 = "krnl.getref"(%1, %c0_i64) : (memref<1200xi8>, i64) -> memref<10x10xf32>
+  %4:2 = krnl.define_loops 2
+  krnl.iterate(%4#0, %4#1) with (%4#0 -> %arg1 = 0 to 10, %4#1 -> %arg2 = 0 to 20) {
+    %8 = krnl.load %arg0[%arg1, %arg2] : memref<10x20xf32>
+    krnl.store %8, %2[%arg1, %arg2] : memref<10x20xf32>
+  }
+  %5:2 = krnl.define_loops 2
+  krnl.iterate(%5#0, %5#1) with (%5#0 -> %arg1 = 0 to 10, %5#1 -> %arg2 = 0 to 10) {
+    %8 = krnl.load %2[%arg1, %arg2] : memref<10x20xf32>
+    krnl.store %8, %0[%arg1, %arg2] : memref<10x10xf32>
+  }
+  %6:2 = krnl.define_loops 2
+  krnl.iterate(%6#0, %6#1) with (%6#0 -> %arg1 = 0 to 10, %6#1 -> %arg2 = 0 to 10) {
+    %8 = krnl.load %0[%arg1, %arg2] : memref<10x10xf32>
+    %9 = arith.addf %8, %8 : f32
+    krnl.store %9, %3[%arg1, %arg2] : memref<10x10xf32>
+  }
+  %7:2 = krnl.define_loops 2
+  krnl.iterate(%7#0, %7#1) with (%7#0 -> %arg1 = 0 to 10, %7#1 -> %arg2 = 0 to 10) {
+    %8 = krnl.load %3[%arg1, %arg2] : memref<10x10xf32>
+    krnl.store %8, %0[%arg1, %arg2] : memref<10x10xf32>
+  }
+  return %0 : memref<10x10xf32>
+
+  // CHECK-LABEL: func.func @small_buffer_nests_in_large
+  // CHECK-DAG: [[C0:%.+]] = arith.constant 0 : i64
+  // CHECK: [[ARENA:%.+]] = memref.alloc() : memref<800xi8>
+  // CHECK: "krnl.getref"([[ARENA]], [[C0]]) : (memref<800xi8>, i64) -> memref<10x20xf32>
+  // CHECK: "krnl.getref"([[ARENA]], [[C0]]) : (memref<800xi8>, i64) -> memref<10x10xf32>
+  // CHECK-NOT: memref.alloc() : memref<1200xi8>
+}
@@ -0,0 +1,41 @@
+// RUN: onnx-mlir-opt -O3 --convert-krnl-to-affine %s -split-input-file | FileCheck %s
+
+func.func @simple_parallel(%arg0: memref<64xf32>, %arg1: memref<64xf32>) {
+  %ii = krnl.define_loops 1
+  krnl.parallel(%ii) : !krnl.loop
+  krnl.iterate(%ii) with (%ii -> %i = 0 to 64) {
+    %v = krnl.load %arg0[%i] : memref<64xf32>
+    krnl.store %v, %arg1[%i] : memref<64xf32>
+  }
+  return
+
+  // CHECK-LABEL: simple_parallel
+  // CHECK:       affine.parallel ([[IV:%.+]]) = (0) to (64) {
+  // CHECK-NEXT:    [[LOAD:%.+]] = affine.load %arg0{{.}}[[IV]]{{.}} : memref<64xf32>
+  // CHECK-NEXT:    affine.store [[LOAD]], %arg1{{.}}[[IV]]{{.}} : memref<64xf32>
+  // CHECK:       }
+}
+
+// -----
+
+func.func @parallel_outer_with_block(%arg0: memref<64xf32>, %arg1: memref<64xf32>) {
+  %ii = krnl.define_loops 1
+  %ib, %il = krnl.block %ii 8 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+  krnl.parallel(%ib) : !krnl.loop
+  krnl.iterate(%ib, %il) with (%ii -> %i = 0 to 64) {
+    %i0 = krnl.get_induction_var_value(%il) : (!krnl.loop) -> index
+    %v = krnl.load %arg0[%i0] : memref<64xf32>
+    krnl.store %v, %arg1[%i0] : memref<64xf32>
+  }
+  return
+
+  // Only the blocked outer loop runs in parallel; the intra-tile loop stays
+  // sequential.
+  // CHECK-LABEL: parallel_outer_with_block
+  // CHECK:       affine.parallel ([[TILE:%.+]]) = (0) to (64) step (8) {
+  // CHECK:         affine.for [[IV:%.+]] = {{.*}} {
+  // CHECK:           [[LOAD:%.+]] = affine.load %arg0{{.}}[[IV]]{{.}} : memref<64xf32>
+  // CHECK:           affine.store [[LOAD]], %arg1{{.}}[[IV]]{{.}} : memref<64xf32>
+  // CHECK:         }
+  // CHECK:       }
+}
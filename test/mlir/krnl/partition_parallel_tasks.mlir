@@ -0,0 +1,81 @@
+// RUN: onnx-mlir-opt --partition-parallel-tasks %s -split-input-file | FileCheck %s
+
+// The two loop nests only share the read-only input: each one is outlined
+// into a task function and both run concurrently.
+func.func @two_branches(%arg0: memref<10xf32>) -> (memref<10xf32>, memref<10xf32>) {
+  %a = memref.alloc() : memref<10xf32>
+  %b = memref.alloc() : memref<10xf32>
+  %l0 = krnl.define_loops 1
+  krnl.iterate(%l0) with (%l0 -> %i = 0 to 10){
+    %v = krnl.load %arg0[%i] : memref<10xf32>
+    krnl.store %v, %a[%i] : memref<10xf32>
+  }
+  %l1 = krnl.define_loops 1
+  krnl.iterate(%l1) with (%l1 -> %i = 0 to 10){
+    %v = krnl.load %arg0[%i] : memref<10xf32>
+    krnl.store %v, %b[%i] : memref<10xf32>
+  }
+  return %a, %b : memref<10xf32>, memref<10xf32>
+
+  // CHECK-LABEL: func.func @two_branches
+  // CHECK-DAG:   [[A_:%.+]] = memref.alloc() : memref<10xf32>
+  // CHECK-DAG:   [[B_:%.+]] = memref.alloc() : memref<10xf32>
+  // CHECK-NOT:   krnl.iterate
+  // CHECK:       "krnl.run_tasks"(%arg0, [[A_]], %arg0, [[B_]]) {callees = [@two_branches_task0, @two_branches_task1], segmentSizes = [2, 2]} : (memref<10xf32>, memref<10xf32>, memref<10xf32>, memref<10xf32>) -> ()
+  // CHECK:       return [[A_]], [[B_]]
+}
+// CHECK:       func.func private @two_branches_task0(%arg0: memref<10xf32>, %arg1: memref<10xf32>)
+// CHECK:       krnl.iterate
+// CHECK:       krnl.load %arg0
+// CHECK:       krnl.store {{.*}}, %arg1
+// CHECK:       func.func private @two_branches_task1(%arg0: memref<10xf32>, %arg1: memref<10xf32>)
+// CHECK:       krnl.iterate
+
+// -----
+
+// The second loop nest reads the buffer written by the first one, so there is
+// only one group and the function is left alone.
+func.func @dependent_branches(%arg0: memref<10xf32>) -> memref<10xf32> {
+  %tmp = memref.alloc() : memref<10xf32>
+  %res = memref.alloc() : memref<10xf32>
+  %l0 = krnl.define_loops 1
+  krnl.iterate(%l0) with (%l0 -> %i = 0 to 10){
+    %v = krnl.load %arg0[%i] : memref<10xf32>
+    krnl.store %v, %tmp[%i] : memref<10xf32>
+  }
+  %l1 = krnl.define_loops 1
+  krnl.iterate(%l1) with (%l1 -> %i = 0 to 10){
+    %v = krnl.load %tmp[%i] : memref<10xf32>
+    krnl.store %v, %res[%i] : memref<10xf32>
+  }
+  memref.dealloc %tmp : memref<10xf32>
+  return %res : memref<10xf32>
+
+  // CHECK-LABEL: func.func @dependent_branches
+  // CHECK-NOT:   "krnl.run_tasks"
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.iterate
+}
+
+// -----
+
+// A write to a function argument invalidates the assumption that arguments
+// are read-only: the function is left alone.
+func.func @writes_argument(%arg0: memref<10xf32>, %arg1: memref<10xf32>) {
+  %l0 = krnl.define_loops 1
+  krnl.iterate(%l0) with (%l0 -> %i = 0 to 10){
+    %v = krnl.load %arg0[%i] : memref<10xf32>
+    krnl.store %v, %arg1[%i] : memref<10xf32>
+  }
+  %l1 = krnl.define_loops 1
+  krnl.iterate(%l1) with (%l1 -> %i = 0 to 10){
+    %v = krnl.load %arg1[%i] : memref<10xf32>
+    krnl.store %v, %arg0[%i] : memref<10xf32>
+  }
+  return
+
+  // CHECK-LABEL: func.func @writes_argument
+  // CHECK-NOT:   "krnl.run_tasks"
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.iterate
+}
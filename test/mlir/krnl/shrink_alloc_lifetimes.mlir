@@ -0,0 +1,98 @@
+// RUN: onnx-mlir-opt --shrink-alloc-lifetimes %s -split-input-file | FileCheck %s
+
+// Both transient buffers are deallocated at the end of the function; after
+// shrinking, each is freed right after the loop containing its last use, so
+// their live ranges no longer overlap.
+func.func @sequential_buffers(%arg0: memref<10xf32>, %res: memref<10xf32>) -> () {
+  %a = memref.alloc() : memref<10xf32>
+  %b = memref.alloc() : memref<10xf32>
+  %l0 = krnl.define_loops 1
+  krnl.iterate(%l0) with (%l0 -> %i = 0 to 10){
+    %v = krnl.load %arg0[%i] : memref<10xf32>
+    krnl.store %v, %a[%i] : memref<10xf32>
+  }
+  %l1 = krnl.define_loops 1
+  krnl.iterate(%l1) with (%l1 -> %i = 0 to 10){
+    %v = krnl.load %a[%i] : memref<10xf32>
+    krnl.store %v, %b[%i] : memref<10xf32>
+  }
+  %l2 = krnl.define_loops 1
+  krnl.iterate(%l2) with (%l2 -> %i = 0 to 10){
+    %v = krnl.load %b[%i] : memref<10xf32>
+    krnl.store %v, %res[%i] : memref<10xf32>
+  }
+  memref.dealloc %a : memref<10xf32>
+  memref.dealloc %b : memref<10xf32>
+  return
+
+  // CHECK-LABEL: func.func @sequential_buffers
+  // CHECK:       [[A_:%.+]] = memref.alloc() : memref<10xf32>
+  // CHECK:       [[B_:%.+]] = memref.alloc() : memref<10xf32>
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.iterate
+  // CHECK:       }
+  // CHECK-NEXT:  memref.dealloc [[A_]] : memref<10xf32>
+  // CHECK:       krnl.iterate
+  // CHECK:       }
+  // CHECK-NEXT:  memref.dealloc [[B_]] : memref<10xf32>
+  // CHECK-NEXT:  return
+}
+
+// -----
+
+// A use through a view keeps the buffer live: the deallocation moves after
+// the loop reading the reinterpret_cast, not after the cast itself.
+func.func @use_through_view(%res: memref<10xf32>) -> () {
+  %a = memref.alloc() : memref<2x5xf32>
+  %view = memref.reinterpret_cast %a to offset: [0], sizes: [10], strides: [1] : memref<2x5xf32> to memref<10xf32>
+  %l0 = krnl.define_loops 1
+  krnl.iterate(%l0) with (%l0 -> %i = 0 to 10){
+    %v = krnl.load %view[%i] : memref<10xf32>
+    krnl.store %v, %res[%i] : memref<10xf32>
+  }
+  %l1 = krnl.define_loops 1
+  krnl.iterate(%l1) with (%l1 -> %i = 0 to 10){
+    %v = krnl.load %res[%i] : memref<10xf32>
+    krnl.store %v, %res[%i] : memref<10xf32>
+  }
+  memref.dealloc %a : memref<2x5xf32>
+  return
+
+  // CHECK-LABEL: func.func @use_through_view
+  // CHECK:       [[A_:%.+]] = memref.alloc() : memref<2x5xf32>
+  // CHECK:       memref.reinterpret_cast
+  // CHECK:       krnl.iterate
+  // CHECK:       }
+  // CHECK-NEXT:  memref.dealloc [[A_]] : memref<2x5xf32>
+  // CHECK:       krnl.iterate
+  // CHECK:       return
+}
+
+// -----
+
+// A buffer referenced by krnl.getref belongs to the memory pool passes; its
+// deallocation stays where the lowering put it.
+func.func @pool_buffer_untouched(%res: memref<10xf32>) -> () {
+  %c0 = arith.constant 0 : i64
+  %pool = memref.alloc() : memref<40xi8>
+  %ref = "krnl.getref"(%pool, %c0) : (memref<40xi8>, i64) -> memref<10xf32>
+  %l0 = krnl.define_loops 1
+  krnl.iterate(%l0) with (%l0 -> %i = 0 to 10){
+    %v = krnl.load %ref[%i] : memref<10xf32>
+    krnl.store %v, %res[%i] : memref<10xf32>
+  }
+  %l1 = krnl.define_loops 1
+  krnl.iterate(%l1) with (%l1 -> %i = 0 to 10){
+    %v = krnl.load %res[%i] : memref<10xf32>
+    krnl.store %v, %res[%i] : memref<10xf32>
+  }
+  memref.dealloc %pool : memref<40xi8>
+  return
+
+  // CHECK-LABEL: func.func @pool_buffer_untouched
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.iterate
+  // CHECK:       }
+  // CHECK-NEXT:  memref.dealloc {{.*}} : memref<40xi8>
+  // CHECK-NEXT:  return
+}
@@ -0,0 +1,28 @@
+// RUN: echo "onnx.MatMul mm1 f64" > %t.accum
+// RUN: echo "onnx.ReduceSumV11 NOTSET f32" >> %t.accum
+// RUN: echo "onnx.ReduceSumV11 rsum2 f64" >> %t.accum
+// RUN: onnx-mlir-opt --accum-annotation="config-file=%t.accum" %s | FileCheck %s
+
+// The matmul is matched by node name; the first reduction is matched by the
+// op-name (NOTSET) entry and the second by its node name, which takes
+// precedence over the op-name entry. The mean has no entry and stays
+// unannotated, hence the CHECK-NOT.
+func.func @test_accum_annotation(%arg0: tensor<16x32xf16>, %arg1: tensor<32x64xf16>) -> tensor<16xf16> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) {onnx_node_name = "mm1"} : (tensor<16x32xf16>, tensor<32x64xf16>) -> tensor<16x64xf16>
+  %1 = "onnx.ReduceSumV11"(%0) {axes = [1], keepdims = 0 : si64, onnx_node_name = "rsum1"} : (tensor<16x64xf16>) -> tensor<16xf16>
+  %2 = "onnx.ReduceSumV11"(%0) {axes = [1], keepdims = 0 : si64, onnx_node_name = "rsum2"} : (tensor<16x64xf16>) -> tensor<16xf16>
+  %3 = "onnx.ReduceMean"(%0) {axes = [1], keepdims = 0 : si64} : (tensor<16x64xf16>) -> tensor<16xf16>
+  %4 = "onnx.Add"(%1, %2) : (tensor<16xf16>, tensor<16xf16>) -> tensor<16xf16>
+  %5 = "onnx.Add"(%4, %3) : (tensor<16xf16>, tensor<16xf16>) -> tensor<16xf16>
+  return %5 : tensor<16xf16>
+}
+// CHECK-LABEL: func.func @test_accum_annotation
+// CHECK:         "onnx.MatMul"
+// CHECK-SAME:      accum_type = "f64"
+// CHECK:         "onnx.ReduceSumV11"
+// CHECK-SAME:      accum_type = "f32", axes = [1], keepdims = 0 : si64, onnx_node_name = "rsum1"
+// CHECK:         "onnx.ReduceSumV11"
+// CHECK-SAME:      accum_type = "f64", axes = [1], keepdims = 0 : si64, onnx_node_name = "rsum2"
+// CHECK:         "onnx.ReduceMean"
+// CHECK-NOT:       accum_type
+// CHECK:         return
@@ -36,6 +36,45 @@ func.func @test_sigmoid_add(%a0: tensor<10x10xf32>, %a1: tensor<10x10xf32>, %a2:
 
 // -----
 
+// A 2-D transpose feeding a MatMul folds into a Gemm trans flag.
+// CHECK-LABEL: func @test_transposed_matmul_to_gemm_transA(%{{.*}}: tensor<20x10xf32>, %{{.*}}: tensor<20x30xf32>) -> tensor<10x30xf32> {
+func.func @test_transposed_matmul_to_gemm_transA(%a0: tensor<20x10xf32>, %a1: tensor<20x30xf32>) -> tensor<10x30xf32> {
+  // CHECK: [[NONE:%.+]] = "onnx.NoValue"() {value} : () -> none
+  // CHECK-NEXT: %{{[0-9]+}} = "onnx.Gemm"(%{{.*}}, %{{.*}}, [[NONE]]) {alpha = 1.000000e+00 : f32, beta = 1.000000e+00 : f32, transA = 1 : si64, transB = 0 : si64} : (tensor<20x10xf32>, tensor<20x30xf32>, none) -> tensor<10x30xf32>
+  // CHECK-NOT: "onnx.Transpose"
+  %0 = "onnx.Transpose"(%a0) {perm = [1, 0]} : (tensor<20x10xf32>) -> tensor<10x20xf32>
+  %1 = "onnx.MatMul"(%0, %a1) : (tensor<10x20xf32>, tensor<20x30xf32>) -> tensor<10x30xf32>
+  "func.return"(%1) : (tensor<10x30xf32>) -> ()
+}
+
+// -----
+
+// CHECK-LABEL: func @test_transposed_matmul_to_gemm_transB(%{{.*}}: tensor<10x20xf32>, %{{.*}}: tensor<30x20xf32>) -> tensor<10x30xf32> {
+func.func @test_transposed_matmul_to_gemm_transB(%a0: tensor<10x20xf32>, %a1: tensor<30x20xf32>) -> tensor<10x30xf32> {
+  // CHECK: [[NONE:%.+]] = "onnx.NoValue"() {value} : () -> none
+  // CHECK-NEXT: %{{[0-9]+}} = "onnx.Gemm"(%{{.*}}, %{{.*}}, [[NONE]]) {alpha = 1.000000e+00 : f32, beta = 1.000000e+00 : f32, transA = 0 : si64, transB = 1 : si64} : (tensor<10x20xf32>, tensor<30x20xf32>, none) -> tensor<10x30xf32>
+  // CHECK-NOT: "onnx.Transpose"
+  %0 = "onnx.Transpose"(%a1) {perm = [1, 0]} : (tensor<30x20xf32>) -> tensor<20x30xf32>
+  %1 = "onnx.MatMul"(%a0, %0) : (tensor<10x20xf32>, tensor<20x30xf32>) -> tensor<10x30xf32>
+  "func.return"(%1) : (tensor<10x30xf32>) -> ()
+}
+
+// -----
+
+// The transpose has another use, so it must stay materialized and the
+// MatMul is left alone.
+// CHECK-LABEL: func @test_transposed_matmul_not_folded(%{{.*}}: tensor<20x10xf32>, %{{.*}}: tensor<20x30xf32>) -> (tensor<10x30xf32>, tensor<10x20xf32>) {
+func.func @test_transposed_matmul_not_folded(%a0: tensor<20x10xf32>, %a1: tensor<20x30xf32>) -> (tensor<10x30xf32>, tensor<10x20xf32>) {
+  // CHECK: "onnx.Transpose"
+  // CHECK: "onnx.MatMul"
+  // CHECK-NOT: "onnx.Gemm"
+  %0 = "onnx.Transpose"(%a0) {perm = [1, 0]} : (tensor<20x10xf32>) -> tensor<10x20xf32>
+  %1 = "onnx.MatMul"(%0, %a1) : (tensor<10x20xf32>, tensor<20x30xf32>) -> tensor<10x30xf32>
+  "func.return"(%1, %0) : (tensor<10x30xf32>, tensor<10x20xf32>) -> ()
+}
+
+// -----
+
 // CHECK-LABEL: @test_identity_identity(%{{.*}}: tensor<10x10xf32>, %{{.*}}: tensor<10x10xf32>) -> tensor<10x10xf32>
 func.func @test_identity_identity(%a0: tensor<10x10xf32>, %a1: tensor<10x10xf32>) -> tensor<10x10xf32> {
   // CHECK-NEXT: %{{[0-9]+}} = "onnx.Add"(%{{.*}}, %{{.*}}) : (tensor<10x10xf32>, tensor<10x10xf32>) -> tensor<10x10xf32>
@@ -937,13 +976,27 @@ func.func @test_layout_transform(%arg0: tensor<5x3x32x32xf32, #onnx.layout<{data
     %0 = "onnx.LayoutTransform"(%arg0) {target_layout = #onnx.layout<{dataLayout = "NCHW4C"}>} : (tensor<5x3x32x32xf32,#onnx.layout<{dataLayout = "NCHW4C"}>>) -> tensor<5x3x32x32xf32, #onnx.layout<{dataLayout = "NCHW4C"}>>
     return %0 : tensor<5x3x32x32xf32, #onnx.layout<{dataLayout = "NCHW4C"}>>
 
-// CHECK-LABEL: test_layout_transform 
+// CHECK-LABEL: test_layout_transform
 // CHECK-NOT: "onnx.LayoutTransform"
 // CHECK: return
 }
 
 // -----
 
+// Back-to-back layout transforms fold into one; here the round trip through
+// the standard layout between two custom-layout consumers disappears.
+func.func @test_layout_transform_fusion(%arg0: tensor<5x3x32x32xf32, #onnx.layout<{dataLayout = "NCHW4C"}>>) -> tensor<5x3x32x32xf32, #onnx.layout<{dataLayout = "NCHW4C"}>> {
+    %0 = "onnx.LayoutTransform"(%arg0) {target_layout = "STANDARD"} : (tensor<5x3x32x32xf32, #onnx.layout<{dataLayout = "NCHW4C"}>>) -> tensor<5x3x32x32xf32>
+    %1 = "onnx.LayoutTransform"(%0) {target_layout = #onnx.layout<{dataLayout = "NCHW4C"}>} : (tensor<5x3x32x32xf32>) -> tensor<5x3x32x32xf32, #onnx.layout<{dataLayout = "NCHW4C"}>>
+    return %1 : tensor<5x3x32x32xf32, #onnx.layout<{dataLayout = "NCHW4C"}>>
+
+// CHECK-LABEL: test_layout_transform_fusion
+// CHECK-NOT: "onnx.LayoutTransform"
+// CHECK: return %arg0
+}
+
+// -----
+
 func.func @test_softmax_v11_ranked(%arg0 : tensor<10x20x30xf32>) -> tensor<10x20x30xf32> {
   %0 = "onnx.SoftmaxV11"(%arg0) {axis = 2 : si64} : (tensor<10x20x30xf32>) -> tensor<10x20x30xf32>
   return %0 : tensor<10x20x30xf32>
@@ -977,3 +1030,87 @@ func.func @test_softmax_v11_unranked(%arg0 : tensor<*xf32>) -> tensor<*xf32> {
 // CHECK:           return [[VAR_0_]] : tensor<*xf32>
 // CHECK:         }
 }
+
+// -----
+
+// Two consecutive slices with constant parameters compose into one.
+func.func @test_fuse_two_slices(%arg0 : tensor<20x30xf32>) -> tensor<6x9xf32> {
+  %starts0 = onnx.Constant dense<[2, 4]> : tensor<2xi64>
+  %ends0 = onnx.Constant dense<[18, 28]> : tensor<2xi64>
+  %axes0 = onnx.Constant dense<[0, 1]> : tensor<2xi64>
+  %steps0 = onnx.Constant dense<[2, 1]> : tensor<2xi64>
+  %0 = "onnx.Slice"(%arg0, %starts0, %ends0, %axes0, %steps0) : (tensor<20x30xf32>, tensor<2xi64>, tensor<2xi64>, tensor<2xi64>, tensor<2xi64>) -> tensor<8x24xf32>
+  %starts1 = onnx.Constant dense<[1, 2]> : tensor<2xi64>
+  %ends1 = onnx.Constant dense<[7, 20]> : tensor<2xi64>
+  %axes1 = onnx.Constant dense<[0, 1]> : tensor<2xi64>
+  %steps1 = onnx.Constant dense<[1, 2]> : tensor<2xi64>
+  %1 = "onnx.Slice"(%0, %starts1, %ends1, %axes1, %steps1) : (tensor<8x24xf32>, tensor<2xi64>, tensor<2xi64>, tensor<2xi64>, tensor<2xi64>) -> tensor<6x9xf32>
+  return %1 : tensor<6x9xf32>
+
+// CHECK-LABEL:  func.func @test_fuse_two_slices
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<20x30xf32>) -> tensor<6x9xf32> {
+// CHECK-DAG:       [[STARTS_:%.+]] = onnx.Constant dense<[4, 6]> : tensor<2xi64>
+// CHECK-DAG:       [[ENDS_:%.+]] = onnx.Constant dense<[15, 23]> : tensor<2xi64>
+// CHECK-DAG:       [[AXES_:%.+]] = onnx.Constant dense<[0, 1]> : tensor<2xi64>
+// CHECK-DAG:       [[STEPS_:%.+]] = onnx.Constant dense<2> : tensor<2xi64>
+// CHECK:           [[VAR_0_:%.+]] = "onnx.Slice"([[PARAM_0_]], [[STARTS_]], [[ENDS_]], [[AXES_]], [[STEPS_]])
+// CHECK-NOT:       "onnx.Slice"
+// CHECK:           return [[VAR_0_]] : tensor<6x9xf32>
+}
+
+// -----
+
+// A slice window that stays inside the un-padded region removes the pad.
+func.func @test_slice_of_pad_interior(%arg0 : tensor<10x10xf32>) -> tensor<10x8xf32> {
+  %cst = "onnx.NoValue"() {value} : () -> none
+  %pads = onnx.Constant dense<2> : tensor<4xi64>
+  %0 = "onnx.Pad"(%arg0, %pads, %cst) {mode = "constant"} : (tensor<10x10xf32>, tensor<4xi64>, none) -> tensor<14x14xf32>
+  %starts = onnx.Constant dense<[2, 3]> : tensor<2xi64>
+  %ends = onnx.Constant dense<[12, 11]> : tensor<2xi64>
+  %1 = "onnx.Slice"(%0, %starts, %ends, %cst, %cst) : (tensor<14x14xf32>, tensor<2xi64>, tensor<2xi64>, none, none) -> tensor<10x8xf32>
+  return %1 : tensor<10x8xf32>
+
+// CHECK-LABEL:  func.func @test_slice_of_pad_interior
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<10x10xf32>) -> tensor<10x8xf32> {
+// CHECK-NOT:       "onnx.Pad"
+// CHECK-DAG:       [[STARTS_:%.+]] = onnx.Constant dense<[0, 1]> : tensor<2xi64>
+// CHECK-DAG:       [[ENDS_:%.+]] = onnx.Constant dense<[10, 9]> : tensor<2xi64>
+// CHECK:           [[VAR_0_:%.+]] = "onnx.Slice"([[PARAM_0_]], [[STARTS_]], [[ENDS_]], {{.*}})
+// CHECK:           return [[VAR_0_]] : tensor<10x8xf32>
+}
+
+// -----
+
+// A slice window that includes padded values must keep the pad.
+func.func @test_slice_of_pad_overlap_unchanged(%arg0 : tensor<10x10xf32>) -> tensor<11x14xf32> {
+  %cst = "onnx.NoValue"() {value} : () -> none
+  %pads = onnx.Constant dense<2> : tensor<4xi64>
+  %0 = "onnx.Pad"(%arg0, %pads, %cst) {mode = "constant"} : (tensor<10x10xf32>, tensor<4xi64>, none) -> tensor<14x14xf32>
+  %starts = onnx.Constant dense<[1, 0]> : tensor<2xi64>
+  %ends = onnx.Constant dense<[12, 14]> : tensor<2xi64>
+  %1 = "onnx.Slice"(%0, %starts, %ends, %cst, %cst) : (tensor<14x14xf32>, tensor<2xi64>, tensor<2xi64>, none, none) -> tensor<11x14xf32>
+  return %1 : tensor<11x14xf32>
+
+// CHECK-LABEL:  func.func @test_slice_of_pad_overlap_unchanged
+// CHECK:           "onnx.Pad"
+// CHECK:           "onnx.Slice"
+}
+
+// -----
+
+// Two consecutive constant-mode pads with the same value merge into one.
+func.func @test_fuse_two_pads(%arg0 : tensor<5x5xf32>) -> tensor<9x9xf32> {
+  %cst = "onnx.NoValue"() {value} : () -> none
+  %pads0 = onnx.Constant dense<1> : tensor<4xi64>
+  %0 = "onnx.Pad"(%arg0, %pads0, %cst) {mode = "constant"} : (tensor<5x5xf32>, tensor<4xi64>, none) -> tensor<7x7xf32>
+  %pads1 = onnx.Constant dense<[2, 0, 0, 2]> : tensor<4xi64>
+  %1 = "onnx.Pad"(%0, %pads1, %cst) {mode = "constant"} : (tensor<7x7xf32>, tensor<4xi64>, none) -> tensor<9x9xf32>
+  return %1 : tensor<9x9xf32>
+
+// CHECK-LABEL:  func.func @test_fuse_two_pads
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<5x5xf32>) -> tensor<9x9xf32> {
+// CHECK:           [[PADS_:%.+]] = onnx.Constant dense<[3, 1, 1, 3]> : tensor<4xi64>
+// CHECK:           [[VAR_0_:%.+]] = "onnx.Pad"([[PARAM_0_]], [[PADS_]], {{.*}}) {mode = "constant"}
+// CHECK-NOT:       "onnx.Pad"
+// CHECK:           return [[VAR_0_]] : tensor<9x9xf32>
+}
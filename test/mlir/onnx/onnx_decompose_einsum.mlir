@@ -102,6 +102,19 @@ func.func @test_einsum_trace(%arg0: tensor<3x3xf32>) -> tensor<f32> {
 // CHECK:           return [[VAR_6_]] : tensor<f32>
 }
 
+// The contraction order is chosen by total intermediate size, not
+// left-to-right: contracting "bc,cd" first produces a 2x2 intermediate,
+// whereas "ab,bc" first would produce a 2x1024 one.
+func.func @test_einsum_contraction_order(%arg0: tensor<2x2xf32>, %arg1: tensor<2x1024xf32>, %arg2: tensor<1024x2xf32>) -> tensor<2x2xf32> {
+  %0 = "onnx.Einsum"(%arg0, %arg1, %arg2) {equation = "ab,bc,cd->ad"} : (tensor<2x2xf32>, tensor<2x1024xf32>, tensor<1024x2xf32>) -> tensor<2x2xf32>
+  return %0 : tensor<2x2xf32>
+// CHECK-LABEL:  func.func @test_einsum_contraction_order
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<2x2xf32>, [[PARAM_1_:%.+]]: tensor<2x1024xf32>, [[PARAM_2_:%.+]]: tensor<1024x2xf32>) -> tensor<2x2xf32> {
+// CHECK:           [[VAR_0_:%.+]] = "onnx.MatMul"([[PARAM_1_]], [[PARAM_2_]]) : (tensor<2x1024xf32>, tensor<1024x2xf32>) -> tensor<2x2xf32>
+// CHECK:           [[VAR_1_:%.+]] = "onnx.MatMul"([[PARAM_0_]], [[VAR_0_]]) : (tensor<2x2xf32>, tensor<2x2xf32>) -> tensor<2x2xf32>
+// CHECK:           return [[VAR_1_]] : tensor<2x2xf32>
+}
+
 func.func @test_einsum_ibh_hnd(%arg0: tensor<128x1x1024xf16>, %arg1: tensor<1024x16x64xf16>) -> tensor<128x1x16x64xf16> {
   %0 = "onnx.Einsum"(%arg0, %arg1) {equation = "ibh,hnd->ibnd"} : (tensor<128x1x1024xf16>, tensor<1024x16x64xf16>) -> tensor<128x1x16x64xf16>
   return %0 : tensor<128x1x16x64xf16>
@@ -0,0 +1,22 @@
+// RUN: onnx-mlir-opt --decompose-onnx="einsum-op-budget=30" %s -split-input-file | FileCheck %s
+
+// With an op budget, a cheap Einsum still decomposes...
+func.func @test_einsum_under_budget(%arg0: tensor<2x3x4xf32>, %arg1: tensor<2x4x5xf32>) -> tensor<2x3x5xf32> {
+  %0 = "onnx.Einsum"(%arg0, %arg1) {equation = "...ij,...jk"} : (tensor<2x3x4xf32>, tensor<2x4x5xf32>) -> tensor<2x3x5xf32>
+  return %0 : tensor<2x3x5xf32>
+// CHECK-LABEL:  func @test_einsum_under_budget
+// CHECK-NOT:       "onnx.Einsum"
+// CHECK:           "onnx.MatMul"
+}
+
+// -----
+
+// ...but one whose estimated expansion exceeds the budget (here the repeated
+// subscripts make the decomposition extract diagonals first) is kept intact.
+func.func @test_einsum_over_budget(%arg0: tensor<2x2x3x3xf32>, %arg1: tensor<3x5xf32>) -> tensor<2x5xf32> {
+  %0 = "onnx.Einsum"(%arg0, %arg1) {equation = "iijj,jk->ik"} : (tensor<2x2x3x3xf32>, tensor<3x5xf32>) -> tensor<2x5xf32>
+  return %0 : tensor<2x5xf32>
+// CHECK-LABEL:  func @test_einsum_over_budget
+// CHECK:           "onnx.Einsum"({{.*}}) {equation = "iijj,jk->ik"}
+// CHECK-NOT:       "onnx.MatMul"
+}
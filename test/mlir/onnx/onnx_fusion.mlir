@@ -0,0 +1,273 @@
+// RUN: onnx-mlir-opt --shape-inference --fusion-onnx %s -split-input-file | FileCheck %s
+
+// -----
+
+// A Relu solely fed by a Conv is recorded on the Conv as a fused activation;
+// the Conv lowering applies it during its final write-back.
+func.func @test_fuse_conv_relu(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<8x3x3x3xf32>) -> tensor<1x8x30x30xf32> {
+  %none = "onnx.NoValue"() {value} : () -> none
+  %0 = "onnx.Conv"(%arg0, %arg1, %none) {auto_pad = "NOTSET"} : (tensor<1x3x32x32xf32>, tensor<8x3x3x3xf32>, none) -> tensor<1x8x30x30xf32>
+  %1 = "onnx.Relu"(%0) : (tensor<1x8x30x30xf32>) -> tensor<1x8x30x30xf32>
+  return %1 : tensor<1x8x30x30xf32>
+  // CHECK-LABEL: func @test_fuse_conv_relu
+  // CHECK: [[CONV:%.+]] = "onnx.Conv"(%arg0, %arg1, %{{.*}})
+  // CHECK-SAME: fused_activation = "Relu"
+  // CHECK-NOT: "onnx.Relu"
+  // CHECK: return [[CONV]] : tensor<1x8x30x30xf32>
+}
+
+// -----
+
+// LeakyRelu also records its alpha so the lowering can reproduce it.
+func.func @test_fuse_gemm_leakyrelu(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>, %arg2: tensor<16xf32>) -> tensor<4x16xf32> {
+  %0 = "onnx.Gemm"(%arg0, %arg1, %arg2) : (tensor<4x8xf32>, tensor<8x16xf32>, tensor<16xf32>) -> tensor<4x16xf32>
+  %1 = "onnx.LeakyRelu"(%0) {alpha = 2.000000e-01 : f32} : (tensor<4x16xf32>) -> tensor<4x16xf32>
+  return %1 : tensor<4x16xf32>
+  // CHECK-LABEL: func @test_fuse_gemm_leakyrelu
+  // CHECK: [[GEMM:%.+]] = "onnx.Gemm"(%arg0, %arg1, %arg2)
+  // CHECK-SAME: fused_activation = "LeakyRelu"
+  // CHECK-SAME: fused_activation_alpha = 2.000000e-01 : f32
+  // CHECK-NOT: "onnx.LeakyRelu"
+  // CHECK: return [[GEMM]] : tensor<4x16xf32>
+}
+
+// -----
+
+// No fusion when the producer result has other users: the intermediate
+// value must stay observable.
+func.func @test_no_fuse_conv_relu_two_uses(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<8x3x3x3xf32>) -> (tensor<1x8x30x30xf32>, tensor<1x8x30x30xf32>) {
+  %none = "onnx.NoValue"() {value} : () -> none
+  %0 = "onnx.Conv"(%arg0, %arg1, %none) {auto_pad = "NOTSET"} : (tensor<1x3x32x32xf32>, tensor<8x3x3x3xf32>, none) -> tensor<1x8x30x30xf32>
+  %1 = "onnx.Relu"(%0) : (tensor<1x8x30x30xf32>) -> tensor<1x8x30x30xf32>
+  return %0, %1 : tensor<1x8x30x30xf32>, tensor<1x8x30x30xf32>
+  // CHECK-LABEL: func @test_no_fuse_conv_relu_two_uses
+  // CHECK: "onnx.Conv"
+  // CHECK-NOT: fused_activation
+  // CHECK: "onnx.Relu"
+}
+
+// -----
+
+// Transpose sinks below unary elementwise ops, moving it towards other
+// transposes where canonicalization can cancel it.
+func.func @test_sink_transpose_relu(%arg0: tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32> {
+  %0 = "onnx.Transpose"(%arg0) {perm = [0, 2, 3, 1]} : (tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32>
+  %1 = "onnx.Relu"(%0) : (tensor<1x32x32x3xf32>) -> tensor<1x32x32x3xf32>
+  return %1 : tensor<1x32x32x3xf32>
+  // CHECK-LABEL: func @test_sink_transpose_relu
+  // CHECK: [[RELU:%.+]] = "onnx.Relu"(%arg0) : (tensor<1x3x32x32xf32>) -> tensor<1x3x32x32xf32>
+  // CHECK: [[TRANS:%.+]] = "onnx.Transpose"([[RELU]]) {perm = [0, 2, 3, 1]}
+  // CHECK: return [[TRANS]] : tensor<1x32x32x3xf32>
+}
+
+// -----
+
+// A single-element constant broadcasts identically under any permutation, so
+// binary elementwise ops with such a constant let the transpose through.
+func.func @test_sink_transpose_mul_scalar(%arg0: tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32> {
+  %c = onnx.Constant dense<2.000000e+00> : tensor<f32>
+  %0 = "onnx.Transpose"(%arg0) {perm = [0, 2, 3, 1]} : (tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32>
+  %1 = "onnx.Mul"(%0, %c) : (tensor<1x32x32x3xf32>, tensor<f32>) -> tensor<1x32x32x3xf32>
+  return %1 : tensor<1x32x32x3xf32>
+  // CHECK-LABEL: func @test_sink_transpose_mul_scalar
+  // CHECK: [[MUL:%.+]] = "onnx.Mul"(%arg0, %{{.*}}) : (tensor<1x3x32x32xf32>, tensor<f32>) -> tensor<1x3x32x32xf32>
+  // CHECK: [[TRANS:%.+]] = "onnx.Transpose"([[MUL]]) {perm = [0, 2, 3, 1]}
+  // CHECK: return [[TRANS]] : tensor<1x32x32x3xf32>
+}
+
+// -----
+
+// Both operands transposed with the same permutation: the binary op runs in
+// the original layout and two transposes collapse into one.
+func.func @test_sink_transpose_add_both(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32> {
+  %0 = "onnx.Transpose"(%arg0) {perm = [0, 2, 3, 1]} : (tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32>
+  %1 = "onnx.Transpose"(%arg1) {perm = [0, 2, 3, 1]} : (tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32>
+  %2 = "onnx.Add"(%0, %1) : (tensor<1x32x32x3xf32>, tensor<1x32x32x3xf32>) -> tensor<1x32x32x3xf32>
+  return %2 : tensor<1x32x32x3xf32>
+  // CHECK-LABEL: func @test_sink_transpose_add_both
+  // CHECK: [[ADD:%.+]] = "onnx.Add"(%arg0, %arg1) : (tensor<1x3x32x32xf32>, tensor<1x3x32x32xf32>) -> tensor<1x3x32x32xf32>
+  // CHECK: [[TRANS:%.+]] = "onnx.Transpose"([[ADD]]) {perm = [0, 2, 3, 1]}
+  // CHECK-NOT: "onnx.Transpose"
+  // CHECK: return [[TRANS]] : tensor<1x32x32x3xf32>
+}
+
+// -----
+
+// No sinking when the two transposes use different permutations.
+func.func @test_no_sink_transpose_add_mixed_perms(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<1x32x32x3xf32>) -> tensor<1x32x32x3xf32> {
+  %0 = "onnx.Transpose"(%arg0) {perm = [0, 2, 3, 1]} : (tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32>
+  %1 = "onnx.Transpose"(%arg1) {perm = [0, 1, 2, 3]} : (tensor<1x32x32x3xf32>) -> tensor<1x32x32x3xf32>
+  %2 = "onnx.Add"(%0, %1) : (tensor<1x32x32x3xf32>, tensor<1x32x32x3xf32>) -> tensor<1x32x32x3xf32>
+  return %2 : tensor<1x32x32x3xf32>
+  // CHECK-LABEL: func @test_no_sink_transpose_add_mixed_perms
+  // CHECK: "onnx.Transpose"(%arg0)
+  // CHECK: "onnx.Transpose"(%arg1)
+  // CHECK: "onnx.Add"
+}
+
+// -----
+
+// Softmax sinks the transpose by remapping its axis through the permutation:
+// axis 3 of the NHWC view is axis 1 of the NCHW input.
+func.func @test_sink_transpose_softmax(%arg0: tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32> {
+  %0 = "onnx.Transpose"(%arg0) {perm = [0, 2, 3, 1]} : (tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32>
+  %1 = "onnx.Softmax"(%0) {axis = 3 : si64} : (tensor<1x32x32x3xf32>) -> tensor<1x32x32x3xf32>
+  return %1 : tensor<1x32x32x3xf32>
+  // CHECK-LABEL: func @test_sink_transpose_softmax
+  // CHECK: [[SOFTMAX:%.+]] = "onnx.Softmax"(%arg0) {axis = 1 : si64} : (tensor<1x3x32x32xf32>) -> tensor<1x3x32x32xf32>
+  // CHECK: [[TRANS:%.+]] = "onnx.Transpose"([[SOFTMAX]]) {perm = [0, 2, 3, 1]}
+  // CHECK: return [[TRANS]] : tensor<1x32x32x3xf32>
+}
+
+// -----
+
+// Concat of inputs transposed with the same permutation concatenates first
+// along the remapped axis and transposes once.
+func.func @test_sink_transpose_concat(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<1x5x32x32xf32>) -> tensor<1x32x32x8xf32> {
+  %0 = "onnx.Transpose"(%arg0) {perm = [0, 2, 3, 1]} : (tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32>
+  %1 = "onnx.Transpose"(%arg1) {perm = [0, 2, 3, 1]} : (tensor<1x5x32x32xf32>) -> tensor<1x32x32x5xf32>
+  %2 = "onnx.Concat"(%0, %1) {axis = 3 : si64} : (tensor<1x32x32x3xf32>, tensor<1x32x32x5xf32>) -> tensor<1x32x32x8xf32>
+  return %2 : tensor<1x32x32x8xf32>
+  // CHECK-LABEL: func @test_sink_transpose_concat
+  // CHECK: [[CONCAT:%.+]] = "onnx.Concat"(%arg0, %arg1) {axis = 1 : si64} : (tensor<1x3x32x32xf32>, tensor<1x5x32x32xf32>) -> tensor<1x8x32x32xf32>
+  // CHECK: [[TRANS:%.+]] = "onnx.Transpose"([[CONCAT]]) {perm = [0, 2, 3, 1]}
+  // CHECK: return [[TRANS]] : tensor<1x32x32x8xf32>
+}
+
+// -----
+
+// No sinking with a non-scalar constant: its broadcast depends on the layout.
+func.func @test_no_sink_transpose_add_vector(%arg0: tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32> {
+  %c = onnx.Constant dense<[1.000000e+00, 2.000000e+00, 3.000000e+00]> : tensor<3xf32>
+  %0 = "onnx.Transpose"(%arg0) {perm = [0, 2, 3, 1]} : (tensor<1x3x32x32xf32>) -> tensor<1x32x32x3xf32>
+  %1 = "onnx.Add"(%0, %c) : (tensor<1x32x32x3xf32>, tensor<3xf32>) -> tensor<1x32x32x3xf32>
+  return %1 : tensor<1x32x32x3xf32>
+  // CHECK-LABEL: func @test_no_sink_transpose_add_vector
+  // CHECK: [[TRANS:%.+]] = "onnx.Transpose"(%arg0)
+  // CHECK: "onnx.Add"([[TRANS]], %{{.*}})
+}
+
+// -----
+
+// A per-channel constant Add after a bias-less Conv moves into the Conv B
+// operand, reshaped to one element per output channel.
+func.func @test_fuse_conv_bias(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<8x3x3x3xf32>) -> tensor<1x8x30x30xf32> {
+  %none = "onnx.NoValue"() {value} : () -> none
+  %bias = onnx.Constant dense<5.000000e-01> : tensor<1x8x1x1xf32>
+  %0 = "onnx.Conv"(%arg0, %arg1, %none) {auto_pad = "NOTSET"} : (tensor<1x3x32x32xf32>, tensor<8x3x3x3xf32>, none) -> tensor<1x8x30x30xf32>
+  %1 = "onnx.Add"(%0, %bias) : (tensor<1x8x30x30xf32>, tensor<1x8x1x1xf32>) -> tensor<1x8x30x30xf32>
+  return %1 : tensor<1x8x30x30xf32>
+  // CHECK-LABEL: func @test_fuse_conv_bias
+  // CHECK: [[B:%.+]] = onnx.Constant dense<5.000000e-01> : tensor<8xf32>
+  // CHECK: [[CONV:%.+]] = "onnx.Conv"(%arg0, %arg1, [[B]])
+  // CHECK-NOT: "onnx.Add"
+  // CHECK: return [[CONV]] : tensor<1x8x30x30xf32>
+}
+
+// -----
+
+// A bias Add whose broadcast is not per-channel cannot become the Conv bias.
+func.func @test_no_fuse_conv_bias_spatial(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<8x3x3x3xf32>) -> tensor<1x8x30x30xf32> {
+  %none = "onnx.NoValue"() {value} : () -> none
+  %bias = onnx.Constant dense<5.000000e-01> : tensor<1x1x30x30xf32>
+  %0 = "onnx.Conv"(%arg0, %arg1, %none) {auto_pad = "NOTSET"} : (tensor<1x3x32x32xf32>, tensor<8x3x3x3xf32>, none) -> tensor<1x8x30x30xf32>
+  %1 = "onnx.Add"(%0, %bias) : (tensor<1x8x30x30xf32>, tensor<1x1x30x30xf32>) -> tensor<1x8x30x30xf32>
+  return %1 : tensor<1x8x30x30xf32>
+  // CHECK-LABEL: func @test_no_fuse_conv_bias_spatial
+  // CHECK: "onnx.Conv"
+  // CHECK: "onnx.Add"
+}
+
+// -----
+
+// A bias-less Gemm absorbs a trailing Add through its C operand; the bias
+// may be a runtime value since Gemm broadcasts C itself.
+func.func @test_fuse_gemm_bias(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>, %arg2: tensor<16xf32>) -> tensor<4x16xf32> {
+  %none = "onnx.NoValue"() {value} : () -> none
+  %0 = "onnx.Gemm"(%arg0, %arg1, %none) : (tensor<4x8xf32>, tensor<8x16xf32>, none) -> tensor<4x16xf32>
+  %1 = "onnx.Add"(%0, %arg2) : (tensor<4x16xf32>, tensor<16xf32>) -> tensor<4x16xf32>
+  return %1 : tensor<4x16xf32>
+  // CHECK-LABEL: func @test_fuse_gemm_bias
+  // CHECK: [[GEMM:%.+]] = "onnx.Gemm"(%arg0, %arg1, %arg2)
+  // CHECK-SAME: beta = 1.000000e+00
+  // CHECK-NOT: "onnx.Add"
+  // CHECK: return [[GEMM]] : tensor<4x16xf32>
+}
+
+// -----
+
+// A Clip with scalar-constant bounds records them as a fused activation; the
+// producer's lowering then clamps before its final store. Bias fuses first,
+// so both end up on the same Gemm.
+func.func @test_fuse_gemm_bias_clip(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>, %arg2: tensor<16xf32>) -> tensor<4x16xf32> {
+  %none = "onnx.NoValue"() {value} : () -> none
+  %min = onnx.Constant dense<0.000000e+00> : tensor<f32>
+  %max = onnx.Constant dense<6.000000e+00> : tensor<f32>
+  %0 = "onnx.Gemm"(%arg0, %arg1, %none) : (tensor<4x8xf32>, tensor<8x16xf32>, none) -> tensor<4x16xf32>
+  %1 = "onnx.Add"(%0, %arg2) : (tensor<4x16xf32>, tensor<16xf32>) -> tensor<4x16xf32>
+  %2 = "onnx.Clip"(%1, %min, %max) : (tensor<4x16xf32>, tensor<f32>, tensor<f32>) -> tensor<4x16xf32>
+  return %2 : tensor<4x16xf32>
+  // CHECK-LABEL: func @test_fuse_gemm_bias_clip
+  // CHECK: [[GEMM:%.+]] = "onnx.Gemm"(%arg0, %arg1, %arg2)
+  // CHECK-SAME: fused_activation = "Clip"
+  // CHECK-SAME: fused_activation_max = 6.000000e+00 : f32
+  // CHECK-SAME: fused_activation_min = 0.000000e+00 : f32
+  // CHECK-NOT: "onnx.Clip"
+  // CHECK: return [[GEMM]] : tensor<4x16xf32>
+}
+
+// -----
+
+// A ReduceSum over the columns of a MatMul result folds into the MatMul by
+// row-summing B first: the full 4x16 intermediate is never materialized.
+func.func @test_fuse_matmul_reducesum_cols(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>) -> tensor<4x1xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+  %1 = "onnx.ReduceSumV11"(%0) {axes = [1], keepdims = 1 : si64} : (tensor<4x16xf32>) -> tensor<4x1xf32>
+  return %1 : tensor<4x1xf32>
+  // CHECK-LABEL: func @test_fuse_matmul_reducesum_cols
+  // CHECK: [[RSUM:%.+]] = "onnx.ReduceSumV11"(%arg1) {axes = [1], keepdims = 1 : si64} : (tensor<8x16xf32>) -> tensor<8x1xf32>
+  // CHECK: [[MM:%.+]] = "onnx.MatMul"(%arg0, [[RSUM]]) : (tensor<4x8xf32>, tensor<8x1xf32>) -> tensor<4x1xf32>
+  // CHECK: return [[MM]] : tensor<4x1xf32>
+}
+
+// -----
+
+// Reducing the rows instead column-sums A; without keepdims the kept unit
+// dimension is squeezed back out.
+func.func @test_fuse_matmul_reducesum_rows(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>) -> tensor<16xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+  %1 = "onnx.ReduceSumV11"(%0) {axes = [0], keepdims = 0 : si64} : (tensor<4x16xf32>) -> tensor<16xf32>
+  return %1 : tensor<16xf32>
+  // CHECK-LABEL: func @test_fuse_matmul_reducesum_rows
+  // CHECK: [[RSUM:%.+]] = "onnx.ReduceSumV11"(%arg0) {axes = [0], keepdims = 1 : si64} : (tensor<4x8xf32>) -> tensor<1x8xf32>
+  // CHECK: [[MM:%.+]] = "onnx.MatMul"([[RSUM]], %arg1) : (tensor<1x8xf32>, tensor<8x16xf32>) -> tensor<1x16xf32>
+  // CHECK: [[SQ:%.+]] = "onnx.SqueezeV11"([[MM]]) {axes = [0]} : (tensor<1x16xf32>) -> tensor<16xf32>
+  // CHECK: return [[SQ]] : tensor<16xf32>
+}
+
+// -----
+
+// The opset-13 ReduceSum carries its axes as an operand; a constant single
+// axis fuses the same way.
+func.func @test_fuse_matmul_reducesum_axes_operand(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>) -> tensor<4x1xf32> {
+  %axes = onnx.Constant dense<1> : tensor<1xi64>
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+  %1 = "onnx.ReduceSum"(%0, %axes) {keepdims = 1 : si64} : (tensor<4x16xf32>, tensor<1xi64>) -> tensor<4x1xf32>
+  return %1 : tensor<4x1xf32>
+  // CHECK-LABEL: func @test_fuse_matmul_reducesum_axes_operand
+  // CHECK: [[RSUM:%.+]] = "onnx.ReduceSumV11"(%arg1) {axes = [1], keepdims = 1 : si64} : (tensor<8x16xf32>) -> tensor<8x1xf32>
+  // CHECK: [[MM:%.+]] = "onnx.MatMul"(%arg0, [[RSUM]]) : (tensor<4x8xf32>, tensor<8x1xf32>) -> tensor<4x1xf32>
+  // CHECK: return [[MM]] : tensor<4x1xf32>
+}
+
+// -----
+
+// A matmul result with a second consumer must stay materialized.
+func.func @test_no_fuse_matmul_reducesum_two_uses(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>) -> (tensor<4x1xf32>, tensor<4x16xf32>) {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+  %1 = "onnx.ReduceSumV11"(%0) {axes = [1], keepdims = 1 : si64} : (tensor<4x16xf32>) -> tensor<4x1xf32>
+  return %1, %0 : tensor<4x1xf32>, tensor<4x16xf32>
+  // CHECK-LABEL: func @test_no_fuse_matmul_reducesum_two_uses
+  // CHECK: "onnx.MatMul"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+  // CHECK: "onnx.ReduceSumV11"
+}
@@ -1038,6 +1038,98 @@ func.func private @test_reducesumV11(%arg0 : tensor<3x2x2xf32>) -> tensor<*xf32>
 
 // -----
 
+// With a large static innermost reduction axis, the lowering uses the
+// tree-reduction schedule: partial accumulators in a small buffer, a blocked
+// loop over the reduced axis, and a pairwise combine at the end.
+func.func private @test_reducesumV11_tree(%arg0 : tensor<3x64xf32>) -> tensor<*xf32> {
+  %0 ="onnx.ReduceSumV11"(%arg0) {axes=[1], keepdims = 0 : si64} : (tensor<3x64xf32>)-> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+
+  // CHECK-LABEL: test_reducesumV11_tree
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<3xf32>
+  // CHECK: [[PARTIALS:%.+]] = memref.alloca() {{.*}}: memref<8xf32>
+  // CHECK: [[OUTER:%.+]] = krnl.define_loops 1
+  // CHECK: krnl.iterate([[OUTER]]) with ([[OUTER]] -> %arg1 = {{.*}}){
+  // CHECK: [[BLOCK:%.+]] = krnl.define_loops 1
+  // CHECK: krnl.iterate([[BLOCK]]) with ([[BLOCK]] -> %arg2 = {{.*}}){
+  // CHECK: krnl.load %arg0[%arg1, {{.*}}] : memref<3x64xf32>
+  // CHECK: arith.addf
+  // CHECK: krnl.store {{.*}}, [[PARTIALS]][{{.*}}] : memref<8xf32>
+  // CHECK: }
+  // CHECK: krnl.store {{.*}}, [[RES]][%arg1] : memref<3xf32>
+  // CHECK: }
+  // CHECK: return [[RES]] : memref<3xf32>
+}
+
+// -----
+
+// With a large static innermost reduction axis, ArgMax uses the
+// lane-parallel schedule: per-lane (best value, best index) buffers, a
+// blocked loop over the reduced axis whose lanes update their own pair, and
+// a pairwise combine at the end.
+func.func private @test_argmax_lanes(%arg0 : tensor<3x64xf32>) -> tensor<*xi64> {
+  %0 = "onnx.ArgMax"(%arg0) {axis = 1 : si64, keepdims = 0 : si64} : (tensor<3x64xf32>) -> tensor<*xi64>
+  "func.return"(%0) : (tensor<*xi64>) -> ()
+
+  // CHECK-LABEL: test_argmax_lanes
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<3xi64>
+  // CHECK: [[OUTER:%.+]] = krnl.define_loops 1
+  // CHECK: krnl.iterate([[OUTER]]) with ([[OUTER]] -> %arg1 = {{.*}}){
+  // CHECK-DAG: [[VALS:%.+]] = memref.alloca() {{.*}}: memref<8xf32>
+  // CHECK-DAG: [[IDXS:%.+]] = memref.alloca() {{.*}}: memref<8xi64>
+  // CHECK: [[BLOCK:%.+]] = krnl.define_loops 1
+  // CHECK: krnl.iterate([[BLOCK]]) with ([[BLOCK]] -> %arg2 = {{.*}}){
+  // CHECK: krnl.load %arg0[%arg1, {{.*}}] : memref<3x64xf32>
+  // CHECK: arith.cmpf ogt
+  // CHECK: krnl.store {{.*}}, [[VALS]][{{.*}}] : memref<8xf32>
+  // CHECK: krnl.store {{.*}}, [[IDXS]][{{.*}}] : memref<8xi64>
+  // CHECK: }
+  // CHECK: krnl.store {{.*}}, [[RES]][%arg1] : memref<3xi64>
+  // CHECK: }
+  // CHECK: return [[RES]] : memref<3xi64>
+}
+
+// -----
+
+// A trailing division by a scalar constant is fused into the reduction
+// epilogue: the quotient is written in place into the reduction buffer, and
+// no second result buffer is allocated.
+func.func private @test_reducesum_div_epilogue(%arg0 : tensor<3x2x2xf32>) -> tensor<*xf32> {
+  %0 = "onnx.ReduceSumV11"(%arg0) {axes=[1], keepdims = 0 : si64} : (tensor<3x2x2xf32>)-> tensor<*xf32>
+  %1 = "onnx.Constant"() {value = dense<4.0> : tensor<f32>} : () -> tensor<f32>
+  %2 = "onnx.Div"(%0, %1) : (tensor<*xf32>, tensor<f32>) -> tensor<*xf32>
+  "func.return"(%2) : (tensor<*xf32>) -> ()
+
+  // CHECK-LABEL: test_reducesum_div_epilogue
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<3x2xf32>
+  // CHECK: arith.addf
+  // CHECK: [[LOAD:%.+]] = krnl.load [[RES]]
+  // CHECK: [[DIV:%.+]] = arith.divf [[LOAD]], {{.*}} : f32
+  // CHECK: krnl.store [[DIV]], [[RES]]
+  // CHECK-NOT: memref.alloc
+  // CHECK: return [[RES]] : memref<3x2xf32>
+}
+
+// -----
+
+// With the tree-reduction schedule the fused epilogue is applied to the
+// final value right before the single write-back of each output element.
+func.func private @test_reducesum_sqrt_epilogue_tree(%arg0 : tensor<3x64xf32>) -> tensor<*xf32> {
+  %0 = "onnx.ReduceSumV11"(%arg0) {axes=[1], keepdims = 0 : si64} : (tensor<3x64xf32>)-> tensor<*xf32>
+  %1 = "onnx.Sqrt"(%0) : (tensor<*xf32>) -> tensor<*xf32>
+  "func.return"(%1) : (tensor<*xf32>) -> ()
+
+  // CHECK-LABEL: test_reducesum_sqrt_epilogue_tree
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<3xf32>
+  // CHECK: [[PARTIALS:%.+]] = memref.alloca() {{.*}}: memref<8xf32>
+  // CHECK: [[SQRT:%.+]] = math.sqrt
+  // CHECK: krnl.store [[SQRT]], [[RES]][%arg1] : memref<3xf32>
+  // CHECK-NOT: memref.alloc
+  // CHECK: return [[RES]] : memref<3xf32>
+}
+
+// -----
+
 func.func private @test_reducesum1(%arg0: tensor<3x2x2xf32>, %arg1: tensor<?xi64>) -> tensor<3x1x2xf32> {
   %0 = "onnx.ReduceSum"(%arg0, %arg1) {keepdims = 1 : si64, noop_with_empty_axes = 1 : si64} : (tensor<3x2x2xf32>, tensor<?xi64>) -> tensor<3x1x2xf32>
   return %0 : tensor<3x1x2xf32>
@@ -1449,15 +1541,16 @@ func.func private @test_batchnorm_testmode_Nd(%arg0: tensor<1x2x1x3xf32>, %arg1:
   // CHECK:   [[BIAS:%.+]] = krnl.load %arg2[%arg5] : memref<2xf32>
   // CHECK:   [[MEAN:%.+]] = krnl.load %arg3[%arg5] : memref<2xf32>
   // CHECK:   [[VARIANCE:%.+]] = krnl.load %arg4[%arg5] : memref<2xf32>
+  // CHECK:   [[ADJUSTED_VARIANCE:%.+]] = arith.addf [[VARIANCE]], [[EPSILON]] : f32
+  // CHECK:   [[DIVISOR:%.+]] = math.sqrt [[ADJUSTED_VARIANCE]] : f32
+  // CHECK:   [[A:%.+]] = arith.divf [[SCALE]], [[DIVISOR]] : f32
+  // CHECK:   [[MEAN_A:%.+]] = arith.mulf [[MEAN]], [[A]] : f32
+  // CHECK:   [[B:%.+]] = arith.subf [[BIAS]], [[MEAN_A]] : f32
   // CHECK:   krnl.iterate([[DEF_LOOPS]]#0, [[DEF_LOOPS]]#2, [[DEF_LOOPS]]#3) with ([[DEF_LOOPS]]#0 -> %arg6 = 0 to 1, [[DEF_LOOPS]]#2 -> %arg7 = 0 to 1, [[DEF_LOOPS]]#3 -> %arg8 = 0 to 3){
   // CHECK:     [[LOADED_VAL:%.+]] = krnl.load %arg0[%arg6, %arg5, %arg7, %arg8] : memref<1x2x1x3xf32>
-  // CHECK:     [[DIVIDEND:%.+]] = arith.subf [[LOADED_VAL]], [[MEAN]] : f32
-  // CHECK:     [[ADJUSTED_VARIANCE:%.+]] = arith.addf [[VARIANCE]], [[EPSILON]] : f32
-  // CHECK:     [[DIVISOR:%.+]] = math.sqrt [[ADJUSTED_VARIANCE]] : f32
-  // CHECK:     [[NORM:%.+]] = arith.divf [[DIVIDEND]], [[DIVISOR]] : f32
-  // CHECK:     [[SCALE_NORM:%.+]] = arith.mulf [[SCALE]], [[NORM]] : f32
-  // CHECK:     [[SHIFT_SCALE_NORM:%.+]] = arith.addf [[SCALE_NORM]], [[BIAS]] : f32
-  // CHECK:     krnl.store [[SHIFT_SCALE_NORM]], [[RES]][%arg6, %arg5, %arg7, %arg8] : memref<1x2x1x3xf32>
+  // CHECK:     [[X_A:%.+]] = arith.mulf [[LOADED_VAL]], [[A]] : f32
+  // CHECK:     [[RES_VAL:%.+]] = arith.addf [[X_A]], [[B]] : f32
+  // CHECK:     krnl.store [[RES_VAL]], [[RES]][%arg6, %arg5, %arg7, %arg8] : memref<1x2x1x3xf32>
   // CHECK:   }
   // CHECK: }
   // CHECK: return [[RES]] : memref<1x2x1x3xf32>
@@ -1465,6 +1558,44 @@ func.func private @test_batchnorm_testmode_Nd(%arg0: tensor<1x2x1x3xf32>, %arg1:
 
 // -----
 
+// Static contiguous shape whose collapsed spatial size is a multiple of the
+// vector length: the spatial dimensions are flattened and the fused
+// multiply-add loop is vectorized with the per-channel multiplier and shift
+// broadcast once per channel.
+func.func private @test_batchnorm_testmode_vectorized(%arg0: tensor<2x4x8x8xf32>, %arg1: tensor<4xf32>, %arg2: tensor<4xf32>, %arg3: tensor<4xf32>, %arg4: tensor<4xf32>) -> tensor<2x4x8x8xf32> {
+  %0 = "onnx.BatchNormalizationInferenceMode"(%arg0, %arg1, %arg2, %arg3, %arg4) : (tensor<2x4x8x8xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>) -> tensor<2x4x8x8xf32>
+  return %0 : tensor<2x4x8x8xf32>
+
+  // CHECK-LABEL: test_batchnorm_testmode_vectorized
+  // CHECK-DAG: [[RES:%.+]] = memref.alloc() {{.*}}: memref<2x4x8x8xf32>
+  // CHECK-DAG: [[FLAT_X:%.+]] = memref.reinterpret_cast %arg0 to offset: [0], sizes: [2, 4, 64], strides: [256, 64, 1] : memref<2x4x8x8xf32> to memref<2x4x64xf32>
+  // CHECK-DAG: [[FLAT_RES:%.+]] = memref.reinterpret_cast [[RES]] to offset: [0], sizes: [2, 4, 64], strides: [256, 64, 1] : memref<2x4x8x8xf32> to memref<2x4x64xf32>
+  // CHECK: [[C_LOOP:%.+]] = krnl.define_loops 1
+  // CHECK: krnl.iterate([[C_LOOP]]) with ([[C_LOOP]] -> [[C_IV:%.+]] = 0 to 4){
+  // CHECK:   [[SCALE:%.+]] = krnl.load %arg1[[[C_IV]]] : memref<4xf32>
+  // CHECK:   [[BIAS:%.+]] = krnl.load %arg2[[[C_IV]]] : memref<4xf32>
+  // CHECK:   [[MEAN:%.+]] = krnl.load %arg3[[[C_IV]]] : memref<4xf32>
+  // CHECK:   [[VARIANCE:%.+]] = krnl.load %arg4[[[C_IV]]] : memref<4xf32>
+  // CHECK:   [[ADJUSTED_VARIANCE:%.+]] = arith.addf [[VARIANCE]], {{.*}} : f32
+  // CHECK:   [[DIVISOR:%.+]] = math.sqrt [[ADJUSTED_VARIANCE]] : f32
+  // CHECK:   [[A:%.+]] = arith.divf [[SCALE]], [[DIVISOR]] : f32
+  // CHECK:   [[MEAN_A:%.+]] = arith.mulf [[MEAN]], [[A]] : f32
+  // CHECK:   [[B:%.+]] = arith.subf [[BIAS]], [[MEAN_A]] : f32
+  // CHECK-DAG:   [[A_VEC:%.+]] = vector.broadcast [[A]] : f32 to vector<4xf32>
+  // CHECK-DAG:   [[B_VEC:%.+]] = vector.broadcast [[B]] : f32 to vector<4xf32>
+  // CHECK:   [[NS_LOOPS:%.+]]:2 = krnl.define_loops 2
+  // CHECK:   krnl.block [[NS_LOOPS]]#1 4 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+  // CHECK:   krnl.iterate
+  // CHECK:     [[X_VEC:%.+]] = vector.load [[FLAT_X]]{{.*}} : memref<2x4x64xf32>, vector<4xf32>
+  // CHECK:     [[FMA:%.+]] = vector.fma [[X_VEC]], [[A_VEC]], [[B_VEC]] : vector<4xf32>
+  // CHECK:     vector.store [[FMA]], [[FLAT_RES]]{{.*}} : memref<2x4x64xf32>, vector<4xf32>
+  // CHECK:   }
+  // CHECK: }
+  // CHECK: return [[RES]] : memref<2x4x8x8xf32>
+}
+
+// -----
+
 func.func private @test_batchnorm_testmode_1d(%arg0: tensor<10xf32>, %arg1: tensor<1xf32>, %arg2: tensor<1xf32>, %arg3: tensor<1xf32>, %arg4: tensor<1xf32>) -> tensor<10xf32> {
   %0 = "onnx.BatchNormalizationInferenceMode"(%arg0, %arg1, %arg2, %arg3, %arg4) : (tensor<10xf32>, tensor<1xf32>, tensor<1xf32>, tensor<1xf32>, tensor<1xf32>) -> tensor<10xf32>
   return %0 : tensor<10xf32>
@@ -1478,15 +1609,16 @@ func.func private @test_batchnorm_testmode_1d(%arg0: tensor<10xf32>, %arg1: tens
   // CHECK: [[BIAS:%.+]] = krnl.load %arg2[%[[ZERO_INDEX]]] : memref<1xf32>
   // CHECK: [[MEAN:%.+]] = krnl.load %arg3[%[[ZERO_INDEX]]] : memref<1xf32>
   // CHECK: [[VARIANCE:%.+]] = krnl.load %arg4[%[[ZERO_INDEX]]] : memref<1xf32>
+  // CHECK: [[ADJUSTED_VARIANCE:%.+]] = arith.addf [[VARIANCE]], [[EPSILON]] : f32
+  // CHECK: [[DIVISOR:%.+]] = math.sqrt [[ADJUSTED_VARIANCE]] : f32
+  // CHECK: [[A:%.+]] = arith.divf [[SCALE]], [[DIVISOR]] : f32
+  // CHECK: [[MEAN_A:%.+]] = arith.mulf [[MEAN]], [[A]] : f32
+  // CHECK: [[B:%.+]] = arith.subf [[BIAS]], [[MEAN_A]] : f32
   // CHECK: krnl.iterate([[DEF_LOOPS]]) with ([[DEF_LOOPS]] -> %arg5 = 0 to 10){
   // CHECK:   [[LOADED_VAL:%.+]] = krnl.load %arg0[%arg5] : memref<10xf32>
-  // CHECK:   [[DIVIDEND:%.+]] = arith.subf [[LOADED_VAL]], [[MEAN]] : f32
-  // CHECK:   [[ADJUSTED_VARIANCE:%.+]] = arith.addf [[VARIANCE]], [[EPSILON]] : f32
-  // CHECK:   [[DIVISOR:%.+]] = math.sqrt [[ADJUSTED_VARIANCE]] : f32
-  // CHECK:   [[NORM:%.+]] = arith.divf [[DIVIDEND]], [[DIVISOR]] : f32
-  // CHECK:   [[SCALE_NORM:%.+]] = arith.mulf [[SCALE]], [[NORM]] : f32
-  // CHECK:   [[SHIFT_SCALE_NORM:%.+]] = arith.addf [[SCALE_NORM]], [[BIAS]] : f32
-  // CHECK:   krnl.store [[SHIFT_SCALE_NORM]], [[RES]][%arg5] : memref<10xf32>
+  // CHECK:   [[X_A:%.+]] = arith.mulf [[LOADED_VAL]], [[A]] : f32
+  // CHECK:   [[RES_VAL:%.+]] = arith.addf [[X_A]], [[B]] : f32
+  // CHECK:   krnl.store [[RES_VAL]], [[RES]][%arg5] : memref<10xf32>
   // CHECK: }
   // CHECK: return [[RES]] : memref<10xf32>
 }
@@ -1506,15 +1638,16 @@ func.func private @test_batchnorm_testmode_2d(%arg0: tensor<10x3xf32>, %arg1: te
   // CHECK:   [[BIAS:%.+]] = krnl.load %arg2[%arg5] : memref<3xf32>
   // CHECK:   [[MEAN:%.+]] = krnl.load %arg3[%arg5] : memref<3xf32>
   // CHECK:   [[VARIANCE:%.+]] = krnl.load %arg4[%arg5] : memref<3xf32>
+  // CHECK:   [[ADJUSTED_VARIANCE:%.+]] = arith.addf [[VARIANCE]], [[EPSILON]] : f32
+  // CHECK:   [[DIVISOR:%.+]] = math.sqrt [[ADJUSTED_VARIANCE]] : f32
+  // CHECK:   [[A:%.+]] = arith.divf [[SCALE]], [[DIVISOR]] : f32
+  // CHECK:   [[MEAN_A:%.+]] = arith.mulf [[MEAN]], [[A]] : f32
+  // CHECK:   [[B:%.+]] = arith.subf [[BIAS]], [[MEAN_A]] : f32
   // CHECK:   krnl.iterate([[DEF_LOOPS]]#0) with ([[DEF_LOOPS]]#0 -> %arg6 = 0 to 10){
   // CHECK:     [[LOADED_VAL:%.+]] = krnl.load %arg0[%arg6, %arg5] : memref<10x3xf32>
-  // CHECK:     [[DIVIDEND:%.+]] = arith.subf [[LOADED_VAL]], [[MEAN]] : f32
-  // CHECK:     [[ADJUSTED_VARIANCE:%.+]] = arith.addf [[VARIANCE]], [[EPSILON]] : f32
-  // CHECK:     [[DIVISOR:%.+]] = math.sqrt [[ADJUSTED_VARIANCE]] : f32
-  // CHECK:     [[NORM:%.+]] = arith.divf [[DIVIDEND]], [[DIVISOR]] : f32
-  // CHECK:     [[SCALE_NORM:%.+]] = arith.mulf [[SCALE]], [[NORM]] : f32
-  // CHECK:     [[SHIFT_SCALE_NORM:%.+]] = arith.addf [[SCALE_NORM]], [[BIAS]] : f32
-  // CHECK:     krnl.store [[SHIFT_SCALE_NORM]], [[RES]][%arg6, %arg5] : memref<10x3xf32>
+  // CHECK:     [[X_A:%.+]] = arith.mulf [[LOADED_VAL]], [[A]] : f32
+  // CHECK:     [[RES_VAL:%.+]] = arith.addf [[X_A]], [[B]] : f32
+  // CHECK:     krnl.store [[RES_VAL]], [[RES]][%arg6, %arg5] : memref<10x3xf32>
   // CHECK:   }
   // CHECK: }
   // CHECK: return [[RES]] : memref<10x3xf32>
@@ -1522,6 +1655,65 @@ func.func private @test_batchnorm_testmode_2d(%arg0: tensor<10x3xf32>, %arg1: te
 
 // -----
 
+// Single-pass Welford statistics followed by a fused scale-shift loop.
+func.func private @test_layer_norm(%arg0: tensor<2x4x8xf32>, %arg1: tensor<8xf32>, %arg2: tensor<8xf32>) -> tensor<2x4x8xf32> {
+  %Y, %Mean, %ISD = "onnx.LayerNormalization"(%arg0, %arg1, %arg2) {axis = -1 : si64, epsilon = 9.99999974E-6 : f32, stash_type = 1 : si64} : (tensor<2x4x8xf32>, tensor<8xf32>, tensor<8xf32>) -> (tensor<2x4x8xf32>, none, none)
+  return %Y : tensor<2x4x8xf32>
+
+  // CHECK-LABEL: test_layer_norm
+  // CHECK-DAG: [[RES:%.+]] = memref.alloc() {{.*}}: memref<2x4x8xf32>
+  // CHECK-DAG: [[COUNT:%.+]] = memref.alloca() : memref<f32>
+  // CHECK-DAG: [[MEAN:%.+]] = memref.alloca() : memref<f32>
+  // CHECK-DAG: [[M2:%.+]] = memref.alloca() : memref<f32>
+  // CHECK: [[OUTER_LOOPS:%.+]]:2 = krnl.define_loops 2
+  // CHECK: krnl.iterate([[OUTER_LOOPS]]#0, [[OUTER_LOOPS]]#1) with ([[OUTER_LOOPS]]#0 -> [[N:%.+]] = 0 to 2, [[OUTER_LOOPS]]#1 -> [[M:%.+]] = 0 to 4){
+  // CHECK: [[STATS_LOOP:%.+]] = krnl.define_loops 1
+  // CHECK: krnl.iterate([[STATS_LOOP]]) with ([[STATS_LOOP]] -> [[K:%.+]] = 0 to 8){
+  // CHECK: krnl.load %arg0
+  // CHECK: arith.divf
+  // CHECK: }
+  // CHECK: math.sqrt
+  // CHECK: [[NORM_LOOP:%.+]] = krnl.define_loops 1
+  // CHECK: krnl.iterate([[NORM_LOOP]]) with ([[NORM_LOOP]] -> [[L:%.+]] = 0 to 8){
+  // CHECK: krnl.load %arg1
+  // CHECK: krnl.load %arg2
+  // CHECK: krnl.store {{.*}}, [[RES]]
+  // CHECK: }
+  // CHECK: }
+  // CHECK: return [[RES]] : memref<2x4x8xf32>
+}
+
+// -----
+
+// The erf-based GELU chain collapses into one loop nest.
+func.func private @test_gelu_fused(%arg0 : tensor<2x8xf32>) -> tensor<2x8xf32> {
+  %sqrt2 = onnx.Constant dense<1.41421354> : tensor<f32>
+  %one = onnx.Constant dense<1.000000e+00> : tensor<f32>
+  %half = onnx.Constant dense<5.000000e-01> : tensor<f32>
+  %0 = "onnx.Div"(%arg0, %sqrt2) : (tensor<2x8xf32>, tensor<f32>) -> tensor<2x8xf32>
+  %1 = "onnx.Erf"(%0) : (tensor<2x8xf32>) -> tensor<2x8xf32>
+  %2 = "onnx.Add"(%1, %one) : (tensor<2x8xf32>, tensor<f32>) -> tensor<2x8xf32>
+  %3 = "onnx.Mul"(%arg0, %2) : (tensor<2x8xf32>, tensor<2x8xf32>) -> tensor<2x8xf32>
+  %4 = "onnx.Mul"(%3, %half) : (tensor<2x8xf32>, tensor<f32>) -> tensor<2x8xf32>
+  return %4 : tensor<2x8xf32>
+
+  // CHECK-LABEL: test_gelu_fused
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<2x8xf32>
+  // CHECK: [[LOOPS:%.+]]:2 = krnl.define_loops 2
+  // CHECK: krnl.iterate([[LOOPS]]#0, [[LOOPS]]#1) with ([[LOOPS]]#0 -> [[I:%.+]] = 0 to 2, [[LOOPS]]#1 -> [[J:%.+]] = 0 to 8){
+  // CHECK: [[X:%.+]] = krnl.load %arg0
+  // CHECK: [[SCALED:%.+]] = arith.divf [[X]], {{.*}} : f32
+  // CHECK: [[ERF:%.+]] = math.erf [[SCALED]] : f32
+  // CHECK: arith.addf [[ERF]], {{.*}} : f32
+  // CHECK: arith.mulf
+  // CHECK: krnl.store {{.*}}, [[RES]]
+  // CHECK: }
+  // CHECK-NOT: krnl.iterate
+  // CHECK: return [[RES]] : memref<2x8xf32>
+}
+
+// -----
+
 func.func private @test_abs_float(%arg0 : tensor<?x10xf32>) -> tensor<*xf32> {
   %0 = "onnx.Abs"(%arg0) : (tensor<?x10xf32>) -> tensor<*xf32>
   "func.return"(%0) : (tensor<*xf32>) -> ()
@@ -1594,24 +1786,26 @@ func.func private @test_constant_dense_2d_value(%arg0: tensor<1xf32>) -> tensor<
 
 // -----
 
+// Padded pooling keeps the general computation: the window is clipped over
+// the border edges with affine min/max maps.
 func.func private @test_pool_general_computation(%arg0 : tensor<1x3x32x32xf32>) -> tensor<*xf32> {
-  %0 = "onnx.AveragePool"(%arg0) {auto_pad = "NOTSET", kernel_shape = [2, 2]} : (tensor<1x3x32x32xf32>) -> tensor<*xf32>
+  %0 = "onnx.AveragePool"(%arg0) {auto_pad = "NOTSET", kernel_shape = [2, 2], pads = [1, 1, 1, 1]} : (tensor<1x3x32x32xf32>) -> tensor<*xf32>
   "func.return"(%0) : (tensor<*xf32>) -> ()
 
-  // CHECK-DAG: #{{.*}} = affine_map<(d0) -> (0, d0)>
-  // CHECK-DAG: #{{.*}} = affine_map<(d0) -> (32, d0 + 2)>
-  // CHECK-DAG: #{{.*}} = affine_map<(d0, d1) -> (0, d1)>
-  // CHECK-DAG: #{{.*}} = affine_map<(d0, d1) -> (32, d1 + 2)>
+  // CHECK-DAG: #{{.*}} = affine_map<(d0) -> (0, d0 - 1)>
+  // CHECK-DAG: #{{.*}} = affine_map<(d0) -> (32, d0 + 1)>
+  // CHECK-DAG: #{{.*}} = affine_map<(d0, d1) -> (0, d1 - 1)>
+  // CHECK-DAG: #{{.*}} = affine_map<(d0, d1) -> (32, d1 + 1)>
   // CHECK-DAG: #[[BOUND:.+]] = affine_map<(d0)[s0, s1, s2, s3, s4] -> (s0 - ((s2 ceildiv s4) * s4 - s2), -(d0 * s3 - s2) + s0, d0 * s3 + (s1 - 1) * s4 - s2 - ((s2 ceildiv s4) * s4 - s2) + 1, d0 * s3 + (s1 - 1) * s4 - s2 - (d0 * s3 - s2) + 1)>
 
   // CHECK-LABEL: @test_pool_general_computation
 
-  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<1x3x31x31xf32>
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<1x3x33x33xf32>
   // CHECK: [[IDENTITY:%.+]] = arith.constant 0.000000e+00 : f32
 
   // CHECK: [[REDUCTION_VAL:%.+]] = memref.alloca() : memref<f32>
   // CHECK: [[OUTPUT_LOOPS:%.+]]:4 = krnl.define_loops 4
-  // CHECK: krnl.iterate([[OUTPUT_LOOPS]]#0, [[OUTPUT_LOOPS]]#1, [[OUTPUT_LOOPS]]#2, [[OUTPUT_LOOPS]]#3) with ([[OUTPUT_LOOPS]]#0 -> %arg1 = 0 to 1, [[OUTPUT_LOOPS]]#1 -> %arg2 = 0 to 3, [[OUTPUT_LOOPS]]#2 -> %arg3 = 0 to 31, [[OUTPUT_LOOPS]]#3 -> %arg4 = 0 to 31){
+  // CHECK: krnl.iterate([[OUTPUT_LOOPS]]#0, [[OUTPUT_LOOPS]]#1, [[OUTPUT_LOOPS]]#2, [[OUTPUT_LOOPS]]#3) with ([[OUTPUT_LOOPS]]#0 -> %arg1 = 0 to 1, [[OUTPUT_LOOPS]]#1 -> %arg2 = 0 to 3, [[OUTPUT_LOOPS]]#2 -> %arg3 = 0 to 33, [[OUTPUT_LOOPS]]#3 -> %arg4 = 0 to 33){
   // CHECK:   [[IV:%.+]]:4 = krnl.get_induction_var_value([[OUTPUT_LOOPS]]#0, [[OUTPUT_LOOPS]]#1, [[OUTPUT_LOOPS]]#2, [[OUTPUT_LOOPS]]#3) : (!krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index, index)
 
   // CHECK:   krnl.store [[IDENTITY]], [[REDUCTION_VAL]][] : memref<f32>
@@ -1624,7 +1818,7 @@ func.func private @test_pool_general_computation(%arg0 : tensor<1x3x32x32xf32>)
   // CHECK:   }
 
   // CHECK:   [[LOAD_REDUCTION:%.+]] = krnl.load [[REDUCTION_VAL]][] : memref<f32>
-  // CHECK:   krnl.store [[LOAD_REDUCTION]], [[RES]][[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3] : memref<1x3x31x31xf32>
+  // CHECK:   krnl.store [[LOAD_REDUCTION]], [[RES]][[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3] : memref<1x3x33x33xf32>
   // CHECK: }
 }
 
@@ -1660,6 +1854,8 @@ func.func private @test_averagepool_pooling_operation(%arg0 : tensor<1x3x32x32xf
   %0 = "onnx.AveragePool"(%arg0) {auto_pad = "NOTSET", kernel_shape = [2, 2]} : (tensor<1x3x32x32xf32>) -> tensor<*xf32>
   "func.return"(%0) : (tensor<*xf32>) -> ()
 
+  // Without padding, every window is a full kernel window: the pooling loops
+  // have constant bounds and the average divides by the constant window size.
   // CHECK-LABEL: @test_averagepool_pooling_operation
   // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<1x3x31x31xf32>
 
@@ -1671,7 +1867,7 @@ func.func private @test_averagepool_pooling_operation(%arg0 : tensor<1x3x32x32xf
   // CHECK:   krnl.store {{.*}}, [[REDUCTION_VAL]][] : memref<f32>
 
   // CHECK:   [[POOL_LOOPS:%.+]]:2 = krnl.define_loops 2
-  // CHECK:   krnl.iterate([[POOL_LOOPS]]#0, [[POOL_LOOPS]]#1) with ([[POOL_LOOPS]]#0 -> %arg5 = 0 to min #{{.*}}([[IV]]#2)[{{.*}}, {{.*}}, {{.*}}, {{.*}}, {{.*}}], [[POOL_LOOPS]]#1 -> %arg6 = 0 to min #{{.*}}([[IV]]#3)[{{.*}}, {{.*}}, {{.*}}, {{.*}}, {{.*}}]){
+  // CHECK:   krnl.iterate([[POOL_LOOPS]]#0, [[POOL_LOOPS]]#1) with ([[POOL_LOOPS]]#0 -> %arg5 = 0 to 2, [[POOL_LOOPS]]#1 -> %arg6 = 0 to 2){
 
   // CHECK:     [[INPUT_LOAD:%.+]] = krnl.load %arg0[[[IV]]#0, [[IV]]#1, {{.*}}, {{.*}}] : memref<1x3x32x32xf32>
   // CHECK:     [[OUTPUT_LOAD:%.+]] = krnl.load [[REDUCTION_VAL]][] : memref<f32>
@@ -1679,10 +1875,8 @@ func.func private @test_averagepool_pooling_operation(%arg0 : tensor<1x3x32x32xf
   // CHECK:     krnl.store [[SUM]], [[REDUCTION_VAL]][] : memref<f32>
   // CHECK:   }
   // CHECK:   [[LOAD_REDUCTION:%.+]] = krnl.load [[REDUCTION_VAL]][] : memref<f32>
-  // CHECK:   krnl.store [[LOAD_REDUCTION]], [[RES]][[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3] : memref<1x3x31x31xf32>
-
-  // CHECK:   [[NUMERATOR:%.+]] = krnl.load [[RES]][[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3] : memref<1x3x31x31xf32>
-  // CHECK:   [[AVERAGE:%.+]] = arith.divf [[NUMERATOR]], {{.*}} : f32
+  // CHECK:   [[DENOMINATOR:%.+]] = arith.constant 4.000000e+00 : f32
+  // CHECK:   [[AVERAGE:%.+]] = arith.divf [[LOAD_REDUCTION]], [[DENOMINATOR]] : f32
   // CHECK:   krnl.store [[AVERAGE]], [[RES]][[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3] : memref<1x3x31x31xf32>
   // CHECK: }
 }
@@ -1693,101 +1887,93 @@ func.func private @test_maxpool_pooling_operation(%arg0 : tensor<1x3x32x32xf32>)
   %0 = "onnx.MaxPoolSingleOut"(%arg0) {auto_pad = "NOTSET", kernel_shape = [2, 2]} : (tensor<1x3x32x32xf32>) -> tensor<*xf32>
   "func.return"(%0) : (tensor<*xf32>) -> ()
 
-// mlir2FileCheck.py
-// CHECK-DAG:   [[MAP_0_:#.+]] = affine_map<(d0) -> (d0 + 1)>
-// CHECK-DAG:   [[MAP_1_:#.+]] = affine_map<(d0) -> (d0 + 2)>
-// CHECK-DAG:   [[MAP_2_:#.+]] = affine_map<(d0) -> (0, d0)>
-// CHECK-DAG:   [[MAP_3_:#.+]] = affine_map<(d0) -> (32, d0 + 2)>
-// CHECK-DAG:   [[MAP_4_:#.+]] = affine_map<(d0, d1) -> (d1 + 1)>
-// CHECK-DAG:   [[MAP_5_:#.+]] = affine_map<(d0, d1) -> (d1 + 2)>
-// CHECK-DAG:   [[MAP_6_:#.+]] = affine_map<(d0, d1) -> (0, d1)>
-// CHECK-DAG:   [[MAP_7_:#.+]] = affine_map<(d0, d1) -> (32, d1 + 2)>
-// CHECK-DAG:   [[MAP_8_:#.+]] = affine_map<(d0)[s0, s1, s2, s3, s4] -> (s0 - ((s2 ceildiv s4) * s4 - s2), -(d0 * s3 - s2) + s0, d0 * s3 + (s1 - 1) * s4 - s2 - ((s2 ceildiv s4) * s4 - s2) + 1, d0 * s3 + (s1 - 1) * s4 - s2 - (d0 * s3 - s2) + 1)>
-// CHECK-LABEL:  func.func private @test_maxpool_pooling_operation
-// CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<1x3x32x32xf32>) -> memref<1x3x31x31xf32> {
-// CHECK-DAG:       [[CST_2_:%.+]] = arith.constant 2 : index
-// CHECK-DAG:       [[CST_2_1_:%.+]] = arith.constant 2 : index
-// CHECK-DAG:       [[CST_0_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[CST_0_1_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[CST_0_2_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[CST_0_3_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[CST_1_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_3_:%.+]] = arith.constant 3 : index
-// CHECK-DAG:       [[CST_0_4_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[CST_1_1_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_32_:%.+]] = arith.constant 32 : index
-// CHECK-DAG:       [[CST_1_2_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_1_3_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_1_4_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_2_2_:%.+]] = arith.constant 2 : index
-// CHECK-DAG:       [[CST_30_:%.+]] = arith.constant 30 : index
-// CHECK-DAG:       [[CST_31_:%.+]] = arith.constant 31 : index
-// CHECK-DAG:       [[CST_32_1_:%.+]] = arith.constant 32 : index
-// CHECK-DAG:       [[CST_1_5_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_1_6_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_1_7_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_2_3_:%.+]] = arith.constant 2 : index
-// CHECK-DAG:       [[CST_30_1_:%.+]] = arith.constant 30 : index
-// CHECK-DAG:       [[CST_31_1_:%.+]] = arith.constant 31 : index
-// CHECK-DAG:       [[RES_:%.+]] = memref.alloc() {{.*}}: memref<1x3x31x31xf32>
-// CHECK-DAG:       [[CST_0_5_:%.+]] = arith.constant 0xFF800000 : f32
-// CHECK-DAG:       [[RES_1_:%.+]] = memref.alloca() : memref<f32>
-// CHECK-DAG:       [[LOOP_0_:%.+]]:4 = krnl.define_loops 4
-// CHECK-DAG:       [[CST_0_6_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[CST_1_8_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_3_1_:%.+]] = arith.constant 3 : index
-// CHECK-DAG:       [[CST_31_2_:%.+]] = arith.constant 31 : index
-// CHECK-DAG:       [[CST_31_3_:%.+]] = arith.constant 31 : index
-// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 1, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 3, [[LOOP_0_]]#2 -> [[I_2_:%.+]] = 0 to 31, [[LOOP_0_]]#3 -> [[I_3_:%.+]] = 0 to 31){
-// CHECK:             [[VAR_1_:%.+]]:4 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) : (!krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index, index)
-// CHECK:             krnl.store [[CST_0_5_]], [[RES_1_]][] : memref<f32>
-// CHECK-DAG:         [[CST_32_2_:%.+]] = arith.constant 32 : index
-// CHECK-DAG:         [[CST_2_4_:%.+]] = arith.constant 2 : index
-// CHECK-DAG:         [[CST_0_7_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:         [[CST_1_9_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[CST_1_10_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[CST_32_3_:%.+]] = arith.constant 32 : index
-// CHECK-DAG:         [[CST_2_5_:%.+]] = arith.constant 2 : index
-// CHECK-DAG:         [[CST_0_8_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:         [[CST_1_11_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[CST_1_12_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[CST_1_13_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[CST_1_14_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[VAR_2_:%.+]] = affine.apply [[MAP_0_]]([[VAR_1_]]#2)
-// CHECK-DAG:         [[CST_1_15_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[VAR_3_:%.+]] = affine.apply [[MAP_1_]]([[VAR_1_]]#2)
-// CHECK-DAG:         [[VAR_4_:%.+]] = affine.max [[MAP_2_]]([[VAR_1_]]#2)
-// CHECK-DAG:         [[VAR_5_:%.+]] = affine.min [[MAP_3_]]([[VAR_1_]]#2)
-// CHECK-DAG:         [[CST_0_9_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:         [[VAR_6_:%.+]] = affine.min [[MAP_2_]]([[VAR_1_]]#2)
-// CHECK-DAG:         [[CST_1_16_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[CST_1_17_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[VAR_7_:%.+]] = affine.apply [[MAP_4_]]([[VAR_1_]]#2, [[VAR_1_]]#3)
-// CHECK-DAG:         [[CST_1_18_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:         [[VAR_8_:%.+]] = affine.apply [[MAP_5_]]([[VAR_1_]]#2, [[VAR_1_]]#3)
-// CHECK-DAG:         [[VAR_9_:%.+]] = affine.max [[MAP_6_]]([[VAR_1_]]#2, [[VAR_1_]]#3)
-// CHECK-DAG:         [[VAR_10_:%.+]] = affine.min [[MAP_7_]]([[VAR_1_]]#2, [[VAR_1_]]#3)
-// CHECK-DAG:         [[CST_0_10_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:         [[VAR_11_:%.+]] = affine.min [[MAP_6_]]([[VAR_1_]]#2, [[VAR_1_]]#3)
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:         [[VAR_12_:%.+]] = arith.subi [[VAR_5_]], [[VAR_4_]] : index
-// CHECK-DAG:         [[VAR_13_:%.+]] = arith.subi [[VAR_10_]], [[VAR_9_]] : index
-// CHECK-DAG:         [[LOOP_1_:%.+]]:2 = krnl.define_loops 2
-// CHECK:             krnl.iterate([[LOOP_1_]]#0, [[LOOP_1_]]#1) with ([[LOOP_1_]]#0 -> [[I_4_:%.+]] = 0 to min [[MAP_8_]]([[VAR_1_]]#2){{.}}[[CST_32_2_]], [[CST_2_4_]], [[CST_0_7_]], [[CST_1_9_]], [[CST_1_10_]]{{.}}, [[LOOP_1_]]#1 -> [[I_5_:%.+]] = 0 to min [[MAP_8_]]([[VAR_1_]]#3){{.}}[[CST_32_3_]], [[CST_2_5_]], [[CST_0_8_]], [[CST_1_11_]], [[CST_1_12_]]{{.}}){
-// CHECK-DAG:           [[VAR_16_:%.+]] = arith.addi [[I_4_]], [[VAR_4_]] : index
-// CHECK-DAG:           [[VAR_17_:%.+]] = arith.addi [[I_5_]], [[VAR_9_]] : index
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[LOAD_PARAM_0_MEM_:%.+]] = krnl.load [[PARAM_0_]]{{.}}[[VAR_1_]]#0, [[VAR_1_]]#1, [[VAR_1_]]6, [[VAR_1_]]7] : memref<1x3x32x32xf32>
-// CHECK-DAG:           [[LOAD_RES_1_MEM_:%.+]] = krnl.load [[RES_1_]][] : memref<f32>
-// CHECK:               [[VAR_20_:%.+]] = arith.cmpf ogt, [[LOAD_RES_1_MEM_]], [[LOAD_PARAM_0_MEM_]] : f32
-// CHECK:               [[VAR_21_:%.+]] = arith.select [[VAR_20_]], [[LOAD_RES_1_MEM_]], [[LOAD_PARAM_0_MEM_]] : f32
-// CHECK:               krnl.store [[VAR_21_]], [[RES_1_]][] : memref<f32>
-// CHECK:             }
-// CHECK:             [[LOAD_RES_1_MEM_1_:%.+]] = krnl.load [[RES_1_]][] : memref<f32>
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_]], [[RES_]]{{.}}[[VAR_1_]]#0, [[VAR_1_]]#1, [[VAR_1_]]#2, [[VAR_1_]]#3] : memref<1x3x31x31xf32>
-// CHECK:           }
-// CHECK:           return [[RES_]] : memref<1x3x31x31xf32>
-// CHECK:         }
+  // Without padding, every window is a full kernel window: the pooling loops
+  // have constant bounds.
+  // CHECK-LABEL: @test_maxpool_pooling_operation
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<1x3x31x31xf32>
+  // CHECK: [[IDENTITY:%.+]] = arith.constant 0xFF800000 : f32
+
+  // CHECK: [[REDUCTION_VAL:%.+]] = memref.alloca() : memref<f32>
+  // CHECK: [[OUTPUT_LOOPS:%.+]]:4 = krnl.define_loops 4
+  // CHECK: krnl.iterate([[OUTPUT_LOOPS]]#0, [[OUTPUT_LOOPS]]#1, [[OUTPUT_LOOPS]]#2, [[OUTPUT_LOOPS]]#3) with ([[OUTPUT_LOOPS]]#0 -> %arg1 = 0 to 1, [[OUTPUT_LOOPS]]#1 -> %arg2 = 0 to 3, [[OUTPUT_LOOPS]]#2 -> %arg3 = 0 to 31, [[OUTPUT_LOOPS]]#3 -> %arg4 = 0 to 31){
+  // CHECK:   [[IV:%.+]]:4 = krnl.get_induction_var_value([[OUTPUT_LOOPS]]#0, [[OUTPUT_LOOPS]]#1, [[OUTPUT_LOOPS]]#2, [[OUTPUT_LOOPS]]#3) : (!krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index, index)
+
+  // CHECK:   krnl.store [[IDENTITY]], [[REDUCTION_VAL]][] : memref<f32>
+
+  // CHECK:   [[POOL_LOOPS:%.+]]:2 = krnl.define_loops 2
+  // CHECK:   krnl.iterate([[POOL_LOOPS]]#0, [[POOL_LOOPS]]#1) with ([[POOL_LOOPS]]#0 -> %arg5 = 0 to 2, [[POOL_LOOPS]]#1 -> %arg6 = 0 to 2){
+  // CHECK:     [[INPUT_LOAD:%.+]] = krnl.load %arg0[[[IV]]#0, [[IV]]#1, {{.*}}, {{.*}}] : memref<1x3x32x32xf32>
+  // CHECK:     [[ACC_LOAD:%.+]] = krnl.load [[REDUCTION_VAL]][] : memref<f32>
+  // CHECK:     [[GREATER:%.+]] = arith.cmpf ogt, [[ACC_LOAD]], [[INPUT_LOAD]] : f32
+  // CHECK:     [[MAX:%.+]] = arith.select [[GREATER]], [[ACC_LOAD]], [[INPUT_LOAD]] : f32
+  // CHECK:     krnl.store [[MAX]], [[REDUCTION_VAL]][] : memref<f32>
+  // CHECK:   }
+  // CHECK:   [[LOAD_REDUCTION:%.+]] = krnl.load [[REDUCTION_VAL]][] : memref<f32>
+  // CHECK:   krnl.store [[LOAD_REDUCTION]], [[RES]][[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3] : memref<1x3x31x31xf32>
+  // CHECK: }
+  // CHECK: return [[RES]] : memref<1x3x31x31xf32>
+}
+
+// -----
+
+// A kernel row that is a multiple of the machine vector length is accumulated
+// with vector operations and folded with a single horizontal reduction per
+// output pixel.
+func.func private @test_maxpool_full_window_simd(%arg0 : tensor<1x3x32x32xf32>) -> tensor<*xf32> {
+  %0 = "onnx.MaxPoolSingleOut"(%arg0) {auto_pad = "NOTSET", kernel_shape = [4, 4], strides = [4, 4]} : (tensor<1x3x32x32xf32>) -> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+
+  // CHECK-LABEL: @test_maxpool_full_window_simd
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<1x3x8x8xf32>
+  // CHECK: [[IDENTITY:%.+]] = arith.constant 0xFF800000 : f32
+  // CHECK: [[REDUCTION_VAL:%.+]] = memref.alloca() : memref<4xf32>
+  // CHECK: [[OUTPUT_LOOPS:%.+]]:4 = krnl.define_loops 4
+  // CHECK: krnl.iterate([[OUTPUT_LOOPS]]#0, [[OUTPUT_LOOPS]]#1, [[OUTPUT_LOOPS]]#2, [[OUTPUT_LOOPS]]#3) with ([[OUTPUT_LOOPS]]#0 -> %arg1 = 0 to 1, [[OUTPUT_LOOPS]]#1 -> %arg2 = 0 to 3, [[OUTPUT_LOOPS]]#2 -> %arg3 = 0 to 8, [[OUTPUT_LOOPS]]#3 -> %arg4 = 0 to 8){
+  // CHECK:   [[INIT:%.+]] = vector.broadcast [[IDENTITY]] : f32 to vector<4xf32>
+  // CHECK:   vector.store [[INIT]], [[REDUCTION_VAL]][{{.*}}] : memref<4xf32>, vector<4xf32>
+  // CHECK:   [[POOL_LOOPS:%.+]]:2 = krnl.define_loops 2
+  // CHECK:   krnl.block [[POOL_LOOPS]]#1 4 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+  // CHECK:   krnl.iterate([[POOL_LOOPS]]#0, {{.*}}) with ([[POOL_LOOPS]]#0 -> %arg5 = 0 to 4, [[POOL_LOOPS]]#1 -> %arg6 = 0 to 4){
+  // CHECK:     [[INPUT_LOAD:%.+]] = vector.load %arg0[{{.*}}] : memref<1x3x32x32xf32>, vector<4xf32>
+  // CHECK:     [[ACC_LOAD:%.+]] = vector.load [[REDUCTION_VAL]][{{.*}}] : memref<4xf32>, vector<4xf32>
+  // CHECK:     [[GREATER:%.+]] = arith.cmpf ogt, [[ACC_LOAD]], [[INPUT_LOAD]] : vector<4xf32>
+  // CHECK:     [[MAX:%.+]] = arith.select [[GREATER]], [[ACC_LOAD]], [[INPUT_LOAD]] : vector<4xi1>, vector<4xf32>
+  // CHECK:     vector.store [[MAX]], [[REDUCTION_VAL]][{{.*}}] : memref<4xf32>, vector<4xf32>
+  // CHECK:   }
+  // CHECK:   [[ACC:%.+]] = vector.load [[REDUCTION_VAL]][{{.*}}] : memref<4xf32>, vector<4xf32>
+  // CHECK:   [[REDUCED:%.+]] = vector.reduction <maxf>, [[ACC]] : vector<4xf32> into f32
+  // CHECK:   krnl.store [[REDUCED]], [[RES]][[[IV:%.+]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3] : memref<1x3x8x8xf32>
+  // CHECK: }
+  // CHECK: return [[RES]] : memref<1x3x8x8xf32>
+}
+
+// -----
+
+func.func private @test_averagepool_full_window_simd(%arg0 : tensor<1x3x32x32xf32>) -> tensor<*xf32> {
+  %0 = "onnx.AveragePool"(%arg0) {auto_pad = "NOTSET", kernel_shape = [4, 4], strides = [4, 4]} : (tensor<1x3x32x32xf32>) -> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+
+  // CHECK-LABEL: @test_averagepool_full_window_simd
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<1x3x8x8xf32>
+  // CHECK: [[IDENTITY:%.+]] = arith.constant 0.000000e+00 : f32
+  // CHECK: [[REDUCTION_VAL:%.+]] = memref.alloca() : memref<4xf32>
+  // CHECK: krnl.iterate
+  // CHECK:   [[INIT:%.+]] = vector.broadcast [[IDENTITY]] : f32 to vector<4xf32>
+  // CHECK:   vector.store [[INIT]], [[REDUCTION_VAL]][{{.*}}] : memref<4xf32>, vector<4xf32>
+  // CHECK:   krnl.block
+  // CHECK:   krnl.iterate
+  // CHECK:     [[INPUT_LOAD:%.+]] = vector.load %arg0[{{.*}}] : memref<1x3x32x32xf32>, vector<4xf32>
+  // CHECK:     [[ACC_LOAD:%.+]] = vector.load [[REDUCTION_VAL]][{{.*}}] : memref<4xf32>, vector<4xf32>
+  // CHECK:     [[SUM:%.+]] = arith.addf [[ACC_LOAD]], [[INPUT_LOAD]] : vector<4xf32>
+  // CHECK:     vector.store [[SUM]], [[REDUCTION_VAL]][{{.*}}] : memref<4xf32>, vector<4xf32>
+  // CHECK:   }
+  // CHECK:   [[ACC:%.+]] = vector.load [[REDUCTION_VAL]][{{.*}}] : memref<4xf32>, vector<4xf32>
+  // CHECK:   [[REDUCED:%.+]] = vector.reduction <add>, [[ACC]] : vector<4xf32> into f32
+  // CHECK:   [[DENOMINATOR:%.+]] = arith.constant 1.600000e+01 : f32
+  // CHECK:   [[AVERAGE:%.+]] = arith.divf [[REDUCED]], [[DENOMINATOR]] : f32
+  // CHECK:   krnl.store [[AVERAGE]], [[RES]][{{.*}}] : memref<1x3x8x8xf32>
+  // CHECK: }
+  // CHECK: return [[RES]] : memref<1x3x8x8xf32>
 }
 
 // -----
@@ -2283,22 +2469,11 @@ func.func private @test_constant_of_shape_static_dims() -> tensor<*xf32> {
 func.func private @test_flatten0(%arg0 : tensor<2x3x4xf32>) -> tensor<*xf32> {
   %1 = "onnx.Flatten"(%arg0) {axis = 0 : si64} : (tensor<2x3x4xf32>) -> tensor<*xf32>
   "func.return"(%1) : (tensor<*xf32>) -> ()
-  // CHECK: [[MAP_FIRST:#.+]] = affine_map<() -> (0)>
-  // CHECK: [[MAP_SECOND:#.+]] = affine_map<(d0, d1, d2)[s0, s1, s2] -> (d2 + d1 * s2 + d0 * (s1 * s2))>
-  // CHECK-LABEL test_flatten0
-  // CHECK:  [[ALLOC:%.+]] = memref.alloc() {{.*}}: memref<1x24xf32>
-  // CHECK:  [[LOOP:%.+]]:3 = krnl.define_loops 3
-  // CHECK:  krnl.iterate([[LOOP]]#0, [[LOOP]]#1, [[LOOP]]#2) with ([[LOOP]]#0 -> [[LOOPARG1:%.+]] = 0 to 2, [[LOOP]]#1 -> [[LOOPARG2:%.+]] = 0 to 3, [[LOOP]]#2 -> [[LOOPARG3:%.+]] = 0 to 4){
-  // CHECK:    [[LOAD:%.+]] = krnl.load %arg0{{\[}}[[LOOPARG1]], [[LOOPARG2]], [[LOOPARG3]]{{\]}} : memref<2x3x4xf32>
-  // CHECK:    [[FIRSTDIM:%.+]] = affine.apply [[MAP_FIRST]]()
-  // CHECK:    [[C0:%.+]] = arith.constant 0 : index
-  // CHECK:    [[R4:%.+]] = arith.constant 2 : index
-  // CHECK:    [[C1:%.+]] = arith.constant 1 : index
-  // CHECK:    [[R5:%.+]] = arith.constant 3 : index
-  // CHECK:    [[C2:%.+]] = arith.constant 2 : index
-  // CHECK:    [[R6:%.+]] = arith.constant 4 : index
-  // CHECK:    [[SECONDDIM:%.+]] = affine.apply [[MAP_SECOND]]([[LOOPARG1]], [[LOOPARG2]], [[LOOPARG3]]){{\[}}[[R4]], [[R5]], [[R6]]{{\]}}
-  // CHECK:    krnl.store [[LOAD]], [[ALLOC]]{{\[}}[[FIRSTDIM]], [[SECONDDIM]]{{\]}} : memref<1x24xf32>
+  // Contiguous input: Flatten is a zero-copy view, like Reshape.
+  // CHECK-LABEL: test_flatten0
+  // CHECK: [[VIEW:%.+]] = memref.reinterpret_cast %arg0 to offset: [0], sizes: [1, 24], strides: [24, 1] : memref<2x3x4xf32> to memref<1x24xf32>
+  // CHECK-NOT: krnl.iterate
+  // CHECK: return [[VIEW]] : memref<1x24xf32>
 }
 
 // -----
@@ -2308,36 +2483,17 @@ func.func private @test_flatten1(%arg0 : tensor<2x?x4xf32>) -> tensor<*xf32> {
   %1 = "onnx.Flatten"(%arg0) {axis = 2 : si64} : (tensor<2x?x4xf32>) -> tensor<*xf32>
   "func.return"(%1) : (tensor<*xf32>) -> ()
 
-// mlir2FileCheck.py
-// CHECK-DAG:   [[MAP_0_:#.+]] = affine_map<(d0, d1)[s0, s1] -> (d1 + d0 * s1)>
-// CHECK-DAG:   [[MAP_1_:#.+]] = affine_map<(d0)[s0] -> (d0)>
+// The dynamic leading size is computed from memref.dim, but the data itself
+// is reused through a view.
+// CHECK-DAG:   [[MAP_0_:#.+]] = affine_map<(d0) -> (d0 * 2)>
 // CHECK-LABEL:  func.func private @test_flatten1
 // CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<2x?x4xf32>) -> memref<?x4xf32> {
-// CHECK-DAG:       [[CST_1_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_0_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[CST_2_:%.+]] = arith.constant 2 : index
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:       [[VAR_0_:%.+]] = arith.muli [[CST_1_]], [[CST_2_]] : index
-// CHECK-DAG:       [[CST_1_1_:%.+]] = arith.constant 1 : index
-// CHECK:           [[VAR_dim_:%.+]] = memref.dim [[PARAM_0_]], [[CST_1_1_]] : memref<2x?x4xf32>
-// CHECK:           [[VAR_1_:%.+]] = arith.muli [[VAR_0_]], [[VAR_dim_]] : index
-// CHECK-DAG:       [[RES_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<?x4xf32>
-// CHECK-DAG:       [[LOOP_0_:%.+]]:3 = krnl.define_loops 3
-// CHECK-DAG:       [[CST_1_2_:%.+]] = arith.constant 1 : index
-// CHECK:           [[VAR_dim_2_:%.+]] = memref.dim [[PARAM_0_]], [[CST_1_2_]] : memref<2x?x4xf32>
-// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 2, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to [[VAR_dim_2_]], [[LOOP_0_]]#2 -> [[I_2_:%.+]] = 0 to 4){
-// CHECK-DAG:         [[LOAD_PARAM_0_MEM_:%.+]] = krnl.load [[PARAM_0_]]{{.}}[[I_0_]], [[I_1_]], [[I_2_]]{{.}} : memref<2x?x4xf32>
-// CHECK-DAG:         [[CST_0_1_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:         [[CST_2_1_:%.+]] = arith.constant 2 : index
-// CHECK-DAG:         [[CST_1_3_:%.+]] = arith.constant 1 : index
-// CHECK:             [[VAR_dim_6_:%.+]] = memref.dim [[PARAM_0_]], [[CST_1_3_]] : memref<2x?x4xf32>
-// CHECK-DAG:         [[VAR_4_:%.+]] = affine.apply [[MAP_0_]]([[I_0_]], [[I_1_]]){{.}}[[CST_2_1_]], [[VAR_dim_6_]]{{.}}
-// CHECK-DAG:         [[CST_2_2_:%.+]] = arith.constant 2 : index
-// CHECK-DAG:         [[CST_4_:%.+]] = arith.constant 4 : index
-// CHECK:             [[VAR_5_:%.+]] = affine.apply [[MAP_1_]]([[I_2_]]){{.}}[[CST_4_]]{{.}}
-// CHECK:             krnl.store [[LOAD_PARAM_0_MEM_]], [[RES_]]{{.}}[[VAR_4_]], [[VAR_5_]]{{.}} : memref<?x4xf32>
-// CHECK:           }
-// CHECK:           return [[RES_]] : memref<?x4xf32>
+// CHECK:           [[CST_1_:%.+]] = arith.constant 1 : index
+// CHECK:           [[VAR_dim_:%.+]] = memref.dim [[PARAM_0_]], [[CST_1_]] : memref<2x?x4xf32>
+// CHECK:           [[VAR_0_:%.+]] = affine.apply [[MAP_0_]]([[VAR_dim_]])
+// CHECK:           [[VIEW_:%.+]] = memref.reinterpret_cast [[PARAM_0_]] to offset: [0], sizes: {{.}}[[VAR_0_]], 4], strides: [4, 1] : memref<2x?x4xf32> to memref<?x4xf32>
+// CHECK-NOT:       krnl.iterate
+// CHECK:           return [[VIEW_]] : memref<?x4xf32>
 // CHECK:         }
 }
 
@@ -2700,14 +2856,8 @@ func.func private @test_loop_simple_main_graph(%arg0: tensor<i64>, %arg1: tensor
 // CHECK-LABEL:  func private @test_loop_simple_main_graph
 // CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<i64>, [[PARAM_1_:%.+]]: memref<i1>, [[PARAM_2_:%.+]]: memref<1xi64>) -> memref<1xi64> {
 // CHECK-DAG:       [[RES_:%.+]] = memref.alloc() {{.*}}: memref<1xi64>
-// CHECK-DAG:       [[LOOP_0_:%.+]] = krnl.define_loops 1
-// CHECK-DAG:       [[VAR_c0_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[VAR_c1_:%.+]] = arith.constant 1 : index
-// CHECK:           krnl.iterate([[LOOP_0_]]) with ([[LOOP_0_]] -> [[I_0_:%.+]] = 0 to 1){
-// CHECK:             [[VAR_7_:%.+]] = krnl.get_induction_var_value([[LOOP_0_]]) : (!krnl.loop) -> index
-// CHECK:             [[LOAD_PARAM_2_MEM_:%.+]] = krnl.load [[PARAM_2_]]{{.}}[[VAR_7_]]{{.}} : memref<1xi64>
-// CHECK:             krnl.store [[LOAD_PARAM_2_MEM_]], [[RES_]]{{.}}[[VAR_7_]]{{.}} : memref<1xi64>
-// CHECK:           }
+// CHECK-DAG:       [[VAR_c8_i64_:%.+]] = arith.constant 8 : i64
+// CHECK:           "krnl.memcpy"([[RES_]], [[PARAM_2_]], [[VAR_c8_i64_]]) : (memref<1xi64>, memref<1xi64>, i64) -> ()
 // CHECK-DAG:       [[RES_1_:%.+]] = memref.alloc() : memref<i1>
 // CHECK-DAG:       [[LOAD_PARAM_1_MEM_:%.+]] = krnl.load [[PARAM_1_]][] : memref<i1>
 // CHECK:           krnl.store [[LOAD_PARAM_1_MEM_]], [[RES_1_]][] : memref<i1>
@@ -2742,16 +2892,9 @@ func.func private @test_loop_simple_main_graph(%arg0: tensor<i64>, %arg1: tensor
 // CHECK-DAG:             [[VAR_14_:%.+]] = builtin.unrealized_conversion_cast [[PARAM_1_]] : memref<i1> to memref<i1>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:             [[VAR_15_:%.+]] = builtin.unrealized_conversion_cast [[VAR_13_]] : tensor<1xi64> to memref<1xi64>
-// CHECK-DAG:             [[LOAD_VAR_14_MEM_:%.+]] = krnl.load [[VAR_14_]][] : memref<i1>
-// CHECK:                 krnl.store [[LOAD_VAR_14_MEM_]], [[RES_1_]][] : memref<i1>
-// CHECK-DAG:             [[LOOP_3_:%.+]] = krnl.define_loops 1
-// CHECK-DAG:             [[VAR_c0_5_:%.+]] = arith.constant 0 : index
-// CHECK-DAG:             [[VAR_c1_6_:%.+]] = arith.constant 1 : index
-// CHECK:                 krnl.iterate([[LOOP_3_]]) with ([[LOOP_3_]] -> [[I_3_:%.+]] = 0 to 1){
-// CHECK:                   [[VAR_18_1_:%.+]] = krnl.get_induction_var_value([[LOOP_3_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_MEM_1_:%.+]] = krnl.load [[VAR_15_]]{{.}}[[VAR_18_1_]]{{.}} : memref<1xi64>
-// CHECK:                   krnl.store [[LOAD_RES_MEM_1_]], [[RES_]]{{.}}[[VAR_18_1_]]{{.}} : memref<1xi64>
-// CHECK:                 }
+// CHECK-DAG:             [[VAR_c8_i64_1_:%.+]] = arith.constant 8 : i64
+// CHECK-NOT:             krnl.store {{.*}}, [[RES_1_]][] : memref<i1>
+// CHECK:                 "krnl.memcpy"([[RES_]], [[VAR_15_]], [[VAR_c8_i64_1_]]) : (memref<1xi64>, memref<1xi64>, i64) -> ()
 // CHECK:               }) : () -> ()
 // CHECK:             }
 // CHECK:           }
@@ -2825,8 +2968,7 @@ func.func @test_loop(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<?xf32>
 // CHECK-DAG:             [[VAR_14_:%.+]] = builtin.unrealized_conversion_cast [[PARAM_1_]] : memref<i1> to memref<i1>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:             [[VAR_15_:%.+]] = builtin.unrealized_conversion_cast [[VAR_13_]] : tensor<?xf32> to memref<?xf32>
-// CHECK-DAG:             [[LOAD_VAR_14_MEM_:%.+]] = krnl.load [[VAR_14_]][] : memref<i1>
-// CHECK:                 krnl.store [[LOAD_VAR_14_MEM_]], [[RES_1_]][] : memref<i1>
+// CHECK-NOT:             krnl.store {{.*}}, [[RES_1_]][] : memref<i1>
 // CHECK:                 "krnl.seqstore"([[VAR_15_]], [[RES_]], [[VAR_8_]]) : (memref<?xf32>, memref<?xmemref<?xf32>>, index) -> ()
 // CHECK:               }) : () -> ()
 // CHECK:             }
@@ -2859,6 +3001,32 @@ func.func @test_loop(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<?xf32>
 
 // -----
 
+// COM: Check that a loop-carried dependence returned unchanged by the loop
+// COM: body is not copied onto itself every iteration: the only copy of the
+// COM: state is the single memcpy of the initial value before the loop.
+func.func @test_loop_passthrough(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<128x256xf32>) -> tensor<128x256xf32> {
+  %0 = "onnx.Loop"(%arg0, %arg1, %arg2) ({
+    ^bb0(%body_arg0: tensor<i64>, %body_arg1: tensor<i1>, %body_arg2: tensor<128x256xf32>):
+    onnx.Return %body_arg1, %body_arg2 : tensor<i1>, tensor<128x256xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<128x256xf32>) -> tensor<128x256xf32>
+  return %0 : tensor<128x256xf32>
+// CHECK-LABEL:  func @test_loop_passthrough
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<i64>, [[PARAM_1_:%.+]]: memref<i1>, [[PARAM_2_:%.+]]: memref<128x256xf32>) -> memref<128x256xf32> {
+// CHECK-DAG:       [[RES_:%.+]] = memref.alloc() {{.*}}: memref<128x256xf32>
+// CHECK-DAG:       [[VAR_c131072_i64_:%.+]] = arith.constant 131072 : i64
+// CHECK:           "krnl.memcpy"([[RES_]], [[PARAM_2_]], [[VAR_c131072_i64_]]) : (memref<128x256xf32>, memref<128x256xf32>, i64) -> ()
+// CHECK:           krnl.iterate
+// CHECK:             scf.if
+// CHECK:               "krnl.region"() ({
+// CHECK-NOT:             krnl.memcpy
+// CHECK-NOT:             krnl.store {{.*}} : memref<128x256xf32>
+// CHECK:               }) : () -> ()
+// CHECK:           return [[RES_]] : memref<128x256xf32>
+// CHECK:         }
+}
+
+// -----
+
 func.func @test_resize1(%arg0 : tensor<3x4xf32>) -> tensor<*xf32> {
   %cst = "onnx.NoValue"() {value} : () -> none
   %0 = onnx.Constant dense<[0.000000e+00, 0.000000e+00, 1.000000e+00, 1.000000e+00]> : tensor<4xf32>
@@ -2997,11 +3165,7 @@ func.func @test_gather_nd_1(%arg0 : tensor<2x2xf32>, %arg1 : tensor<2x2xi64>) ->
 // CHECK-SAME:   ([[PARAM_0:%.+]]: memref<2x2xf32>, [[PARAM_1:%.+]]: memref<2x2xi64>) -> memref<2xf32> {
 // CHECK:           [[RESHAPED_INDICES:%.+]] = memref.reinterpret_cast %arg1 to offset: [0], sizes: [1, 2, 2], strides: [4, 2, 1] : memref<2x2xi64> to memref<1x2x2xi64>
 // CHECK:           [[RESHAPED_DATA:%.+]] = memref.reinterpret_cast %arg0 to offset: [0], sizes: [1, 2, 2], strides: [4, 2, 1] : memref<2x2xf32> to memref<1x2x2xf32>
-// CHECK-DAG:       [[RES_BUFFER:%.+]] = memref.alloc() : memref<2xf32>
-// CHECK-DAG:       [[RES_BUFFER_INDEX:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[CST_0_0:%.+]] = arith.constant 0 : index
-// CHECK-DAG:       [[CST_1_0:%.+]] = arith.constant 1 : index
-// CHECK:           krnl.store [[CST_0_0]], [[RES_BUFFER_INDEX]][] : memref<index>
+// CHECK:           [[RES_BUFFER:%.+]] = memref.alloc() : memref<2xf32>
 // CHECK:           [[LOOP:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP]]#0, [[LOOP]]#1) with ([[LOOP]]#0 -> [[I_0:%.+]] = 0 to 1, [[LOOP]]#1 -> [[I_1:%.+]] = 0 to 2){
 // CHECK-DAG:         [[IV:%.+]]:2 = krnl.get_induction_var_value([[LOOP]]#0, [[LOOP]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
@@ -3012,10 +3176,8 @@ func.func @test_gather_nd_1(%arg0 : tensor<2x2xf32>, %arg1 : tensor<2x2xi64>) ->
 // CHECK:             [[LOAD_INDEX_2:%.+]] = krnl.load [[RESHAPED_INDICES]][[[IV]]#0, [[IV]]#1, [[CST_1_1]]] : memref<1x2x2xi64>
 // CHECK:             [[INDEX_2:%.+]] = arith.index_cast [[LOAD_INDEX_2]] : i64 to index
 // CHECK-DAG:         [[DATA_VAL:%.+]] = krnl.load [[RESHAPED_DATA]][[[IV]]#0, [[INDEX_1]], [[INDEX_2]]] : memref<1x2x2xf32>
-// CHECK-DAG:         [[RES_BUFFER_INDEX_VAL:%.+]] = krnl.load [[RES_BUFFER_INDEX]][] : memref<index>
-// CHECK:             krnl.store [[DATA_VAL]], [[RES_BUFFER]][[[RES_BUFFER_INDEX_VAL]]] : memref<2xf32>
-// CHECK:             [[PLUS_ONE:%.+]] = arith.addi [[RES_BUFFER_INDEX_VAL]], [[CST_1_0]] : index
-// CHECK:             krnl.store [[PLUS_ONE]], [[RES_BUFFER_INDEX]][] : memref<index>
+// CHECK-DAG:         [[FLAT_POS:%.+]] = affine.apply {{#map.*}}([[IV]]#0, [[IV]]#1)
+// CHECK:             krnl.store [[DATA_VAL]], [[RES_BUFFER]][[[FLAT_POS]]] : memref<2xf32>
 // CHECK:           }
 // CHECK:          [[RES:%.+]] = memref.reinterpret_cast [[RES_BUFFER]] to offset: [0], sizes: [2], strides: [1] : memref<2xf32> to memref<2xf32>
 // CHECK:           return [[RES]] : memref<2xf32>
@@ -3032,10 +3194,6 @@ func.func @test_gather_nd_2(%arg0 : tensor<2x2x2xf32>, %arg1 : tensor<2x1x2xi64>
 // CHECK-DAG:       [[RESHAPED_INDICES:%.+]] = memref.reinterpret_cast [[PARAM_1]] to offset: [0], sizes: [1, 2, 2], strides: [4, 2, 1] : memref<2x1x2xi64> to memref<1x2x2xi64>
 // CHECK-DAG:       [[RESHAPED_DATA:%.+]] = memref.reinterpret_cast [[PARAM_0]] to offset: [0], sizes: [1, 2, 2, 2], strides: [8, 4, 2, 1] : memref<2x2x2xf32> to memref<1x2x2x2xf32>
 // CHECK-DAG:       [[RES_BUFFER:%.+]] = memref.alloc() : memref<4xf32>
-// CHECK:           [[CST_0_0:%.+]] = arith.constant 0 : index
-// CHECK:           [[CST_1_0:%.+]] = arith.constant 1 : index
-// CHECK:           [[RES_INDEX_BUFFER:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_0]], [[RES_INDEX_BUFFER]][] : memref<index>
 // CHECK:           [[LOOP_0:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_0]]#0, [[LOOP_0]]#1) with ([[LOOP_0]]#0 -> [[I_0_:%.+]] = 0 to 1, [[LOOP_0]]#1 -> [[I_1_:%.+]] = 0 to 2){
 // CHECK-DAG:         [[IV:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0]]#0, [[LOOP_0]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
@@ -3048,16 +3206,12 @@ func.func @test_gather_nd_2(%arg0 : tensor<2x2x2xf32>, %arg1 : tensor<2x1x2xi64>
 // CHECK-DAG:         [[CST_0_2:%.+]] = arith.constant 0 : index
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:         [[DATA_1:%.+]] = krnl.load [[RESHAPED_DATA]]{{.}}[[IV]]#0, [[INDEX_1]], [[INDEX_2]], [[CST_0_2]]{{.}} : memref<1x2x2x2xf32>
-// CHECK-DAG:         [[RES_INDEX_1:%.+]] = krnl.load [[RES_INDEX_BUFFER]][] : memref<index>
-// CHECK:             krnl.store [[DATA_1]], [[RES_BUFFER]]{{.}}[[RES_INDEX_1]]{{.}} : memref<4xf32>
-// CHECK:             [[PLUS_ONE:%.+]] = arith.addi [[RES_INDEX_1]], [[CST_1_0]] : index
-// CHECK:             krnl.store [[PLUS_ONE]], [[RES_INDEX_BUFFER]][] : memref<index>
+// CHECK-DAG:         [[FLAT_POS_1:%.+]] = affine.apply {{#map.*}}([[IV]]#0, [[IV]]#1)
+// CHECK:             krnl.store [[DATA_1]], [[RES_BUFFER]]{{.}}[[FLAT_POS_1]]{{.}} : memref<4xf32>
 // CHECK:             [[CST_1_2:%.+]] = arith.constant 1 : index
 // CHECK-DAG:         [[DATA_2:%.+]] = krnl.load [[RESHAPED_DATA]]{{.}}[[IV]]#0, [[INDEX_1]], [[INDEX_2]], [[CST_1_2]]{{.}} : memref<1x2x2x2xf32>
-// CHECK-DAG:         [[RES_INDEX_2:%.+]] = krnl.load [[RES_INDEX_BUFFER]][] : memref<index>
-// CHECK:             krnl.store [[DATA_2]], [[RES_BUFFER]]{{.}}[[RES_INDEX_2]]{{.}} : memref<4xf32>
-// CHECK:             [[PLUS_ONE_1:%.+]] = arith.addi [[RES_INDEX_2]], [[CST_1_0]] : index
-// CHECK:             krnl.store [[PLUS_ONE_1]], [[RES_INDEX_BUFFER]][] : memref<index>
+// CHECK-DAG:         [[FLAT_POS_2:%.+]] = affine.apply {{#map.*}}([[IV]]#0, [[IV]]#1)
+// CHECK:             krnl.store [[DATA_2]], [[RES_BUFFER]]{{.}}[[FLAT_POS_2]]{{.}} : memref<4xf32>
 // CHECK:           }
 // CHECK:           [[RES:%.+]] = memref.reinterpret_cast [[RES_BUFFER]] to offset: [0], sizes: [2, 1, 2], strides: [2, 2, 1] : memref<4xf32> to memref<2x1x2xf32>
 // CHECK:           return [[RES]] : memref<2x1x2xf32>
@@ -3097,6 +3251,34 @@ func.func @test_reversesequence_1(%arg0: tensor<10x?xf32>, %arg1: tensor<10xi64>
 
 // -----
 
+// With feature dimensions after the batch and time axes, the sequence length
+// load and the reversed-index select are computed once per (time, batch)
+// pair and the feature block is copied by a select-free inner loop.
+func.func @test_reversesequence_blocked(%arg0: tensor<4x2x8xf32>, %arg1: tensor<2xi64>) -> tensor<*xf32> {
+  %0 = "onnx.ReverseSequence"(%arg0, %arg1) {batch_axis = 1 : si64, time_axis = 0 : si64} : (tensor<4x2x8xf32>, tensor<2xi64>) -> tensor<*xf32>
+  return %0 : tensor<*xf32>
+
+// CHECK-LABEL:  func.func @test_reversesequence_blocked
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<4x2x8xf32>, [[PARAM_1_:%.+]]: memref<2xi64>) -> memref<4x2x8xf32> {
+// CHECK:           [[RES_:%.+]] = memref.alloc() {{.*}}: memref<4x2x8xf32>
+// CHECK:           [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 4, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 2){
+// CHECK:             [[IV_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
+// CHECK:             [[LENS_:%.+]] = krnl.load [[PARAM_1_]]{{.}}[[IV_]]#1] : memref<2xi64>
+// CHECK:             [[INDEX_:%.+]] = arith.select
+// CHECK:             [[LOOP_1_:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[LOOP_1_]]) with ([[LOOP_1_]] -> [[I_2_:%.+]] = 0 to 8){
+// CHECK-NOT:           arith.select
+// CHECK:               [[LOAD_:%.+]] = krnl.load [[PARAM_0_]]
+// CHECK:               krnl.store [[LOAD_]], [[RES_]]
+// CHECK:             }
+// CHECK:           }
+// CHECK:           return [[RES_]] : memref<4x2x8xf32>
+// CHECK:         }
+}
+
+// -----
+
 func.func @test_random_normal1() -> tensor<*xf32> {
   %0 = "onnx.RandomNormal"() {shape = [3, 4, 5], dtype = 1 : si64, mean = 0.0 :f32, scale = 1.0 : f32, seed = 2.0 : f32} : () -> tensor<*xf32>
   "func.return"(%0) : (tensor<*xf32>) -> ()
@@ -3280,15 +3462,16 @@ func.func @test_scatter_nd1(%arg0: tensor<4x4x4xf32>, %arg1: tensor<2x1xi64>, %a
 // CHECK-DAG:       [[CST_256:%.+]] = arith.constant 256 : i64
 // CHECK:           "krnl.memcpy"([[RES]], %arg0, [[CST_256]]) : (memref<4x4x4xf32>, memref<4x4x4xf32>, i64) -> ()
 // CHECK:           [[LOOP_0:%.+]]:3 = krnl.define_loops 3
-// CHECK:           krnl.iterate([[LOOP_0]]#0, [[LOOP_0]]#1, [[LOOP_0]]#2) with
+// CHECK:           [[BLOCKED:%.+]]:2 = krnl.block [[LOOP_0]]#2 4 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+// CHECK:           krnl.iterate([[LOOP_0]]#0, [[LOOP_0]]#1, [[BLOCKED]]#0) with
 // CHECK-SAME:      ([[LOOP_0]]#0 -> [[I_0:%.+]] = 0 to 2, [[LOOP_0]]#1 -> [[I_1:%.+]] = 0 to 4, [[LOOP_0]]#2 -> [[I_2:%.+]] = 0 to 4){
-// CHECK-DAG:         [[IV:%.+]]:3 = krnl.get_induction_var_value([[LOOP_0]]#0, [[LOOP_0]]#1, [[LOOP_0]]#2) : (!krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index)
+// CHECK-DAG:         [[IV:%.+]]:3 = krnl.get_induction_var_value([[LOOP_0]]#0, [[LOOP_0]]#1, [[BLOCKED]]#0) : (!krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index)
 // CHECK-DAG:         [[CST_0:%.+]] = arith.constant 0 : index
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:         [[INDEX:%.+]] = krnl.load [[PARAM_1]]{{.}}[[IV]]#0, [[CST_0]]{{.}} : memref<2x1xi64>
-// CHECK-DAG:         [[UPDATE:%.+]] = krnl.load [[PARAM_2]]{{.}}[[IV]]#0, [[IV]]#1, [[IV]]#2{{.}} : memref<2x4x4xf32>
+// CHECK-DAG:         [[UPDATE_VEC:%.+]] = vector.load [[PARAM_2]]{{.}}[[IV]]#0, [[IV]]#1, [[IV]]#2{{.}} : memref<2x4x4xf32>, vector<4xf32>
 // CHECK-DAG:         [[CAST_INDEX:%.+]] = arith.index_cast [[INDEX]] : i64 to index
-// CHECK:             krnl.store [[UPDATE]], [[RES]]{{.}}[[CAST_INDEX]], [[IV]]#1, [[IV]]#2{{.}} : memref<4x4x4xf32>
+// CHECK:             vector.store [[UPDATE_VEC]], [[RES]]{{.}}[[CAST_INDEX]], [[IV]]#1, [[IV]]#2{{.}} : memref<4x4x4xf32>, vector<4xf32>
 // CHECK-NEXT:      }
 // CHECK:           return [[RES]] : memref<4x4x4xf32>
 }
@@ -3386,3 +3569,39 @@ func.func @test_isnan(%arg0 : tensor<2x3x4xf32>) -> tensor<*xi1> {
   // CHECK: {{.*}}store [[ERF]], [[ALLOC]][[[IV]]#0, [[IV]]#1, [[IV]]#2] : memref<2x3x4xi1>
   // CHECK: return [[ALLOC]] : memref<2x3x4xi1>
 }
+
+// -----
+
+//===----------------------------------------------------------------------===//
+/// Test lowering of a Gemm carrying an activation recorded by the fusion
+/// pass. The tiled path (alpha == 1) applies it in place after the matmul.
+//===----------------------------------------------------------------------===//
+func.func private @test_gemm_fused_relu(%arg0 : tensor<4x8xf32>, %arg1 : tensor<8x16xf32>, %arg2 : tensor<16xf32>) -> tensor<*xf32> {
+  %0 = "onnx.Gemm"(%arg0, %arg1, %arg2) {fused_activation = "Relu"} : (tensor<4x8xf32>, tensor<8x16xf32>, tensor<16xf32>) -> tensor<*xf32>
+  return %0 : tensor<*xf32>
+
+  // CHECK-LABEL: test_gemm_fused_relu
+  // CHECK: krnl.matmul
+  // CHECK: [[RES:%.+]] = krnl.load
+  // CHECK: [[GEZERO:%.+]] = arith.cmpf oge, [[RES]], [[ZERO:%.+]] : f32
+  // CHECK: [[ACT:%.+]] = arith.select [[GEZERO]], [[RES]], [[ZERO]] : f32
+  // CHECK: krnl.store [[ACT]],
+}
+
+// -----
+
+//===----------------------------------------------------------------------===//
+/// Test lowering of a Gemm carrying Clip bounds recorded by the fusion pass:
+/// the clamp runs on the loaded tile value before the store-back.
+//===----------------------------------------------------------------------===//
+func.func private @test_gemm_fused_clip(%arg0 : tensor<4x8xf32>, %arg1 : tensor<8x16xf32>, %arg2 : tensor<16xf32>) -> tensor<*xf32> {
+  %0 = "onnx.Gemm"(%arg0, %arg1, %arg2) {fused_activation = "Clip", fused_activation_max = 6.000000e+00 : f32, fused_activation_min = 0.000000e+00 : f32} : (tensor<4x8xf32>, tensor<8x16xf32>, tensor<16xf32>) -> tensor<*xf32>
+  return %0 : tensor<*xf32>
+
+  // CHECK-LABEL: test_gemm_fused_clip
+  // CHECK: krnl.matmul
+  // CHECK: [[RES:%.+]] = krnl.load
+  // CHECK: [[LO:%.+]] = arith.maxf {{.*}} : f32
+  // CHECK: [[HI:%.+]] = arith.minf [[LO]], {{.*}} : f32
+  // CHECK: krnl.store [[HI]],
+}
@@ -0,0 +1,56 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl %s -split-input-file | FileCheck %s
+
+// An annotated accumulation type overrides the f16 default (f32) in the
+// tree-reduction schedule: the partial accumulators are kept in f64, the
+// loads widen, and only the final result is truncated back to f16.
+func.func private @test_reduce_tree_accum_f64(%arg0 : tensor<3x64xf16>) -> tensor<*xf16> {
+  %0 ="onnx.ReduceSumV11"(%arg0) {accum_type = "f64", axes = [1], keepdims = 0 : si64} : (tensor<3x64xf16>)-> tensor<*xf16>
+  "func.return"(%0) : (tensor<*xf16>) -> ()
+
+  // CHECK-LABEL: test_reduce_tree_accum_f64
+  // CHECK: [[RES:%.+]] = memref.alloc() {{.*}}: memref<3xf16>
+  // CHECK: [[PARTIALS:%.+]] = memref.alloca() {{.*}}: memref<8xf64>
+  // CHECK: krnl.load %arg0[{{.*}}] : memref<3x64xf16>
+  // CHECK: arith.extf {{.*}} : f16 to f64
+  // CHECK: arith.addf {{.*}} : f64
+  // CHECK: krnl.store {{.*}}, [[PARTIALS]][{{.*}}] : memref<8xf64>
+  // CHECK: arith.truncf {{.*}} : f64 to f16
+  // CHECK: krnl.store {{.*}}, [[RES]][{{.*}}] : memref<3xf16>
+  // CHECK: return [[RES]] : memref<3xf16>
+}
+
+// -----
+
+// On the in-place schedule (non-innermost axis), an annotated accumulation
+// type routes the sums through a separate wide buffer; a final loop
+// truncates it back into the f32 result.
+func.func private @test_reduce_inplace_accum_f64(%arg0 : tensor<3x2x2xf32>) -> tensor<*xf32> {
+  %0 ="onnx.ReduceSumV11"(%arg0) {accum_type = "f64", axes = [1], keepdims = 0 : si64} : (tensor<3x2x2xf32>)-> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+
+  // CHECK-LABEL: test_reduce_inplace_accum_f64
+  // CHECK-DAG: [[RES:%.+]] = memref.alloc() {{.*}}: memref<3x2xf32>
+  // CHECK-DAG: [[WIDE:%.+]] = memref.alloc() {{.*}}: memref<3x2xf64>
+  // CHECK: krnl.store {{.*}}, [[WIDE]][{{.*}}] : memref<3x2xf64>
+  // CHECK: krnl.load %arg0[{{.*}}] : memref<3x2x2xf32>
+  // CHECK: arith.extf {{.*}} : f32 to f64
+  // CHECK: arith.addf {{.*}} : f64
+  // CHECK: krnl.store {{.*}}, [[WIDE]][{{.*}}] : memref<3x2xf64>
+  // CHECK: krnl.load [[WIDE]][{{.*}}] : memref<3x2xf64>
+  // CHECK: arith.truncf {{.*}} : f64 to f32
+  // CHECK: krnl.store {{.*}}, [[RES]][{{.*}}] : memref<3x2xf32>
+  // CHECK: return [[RES]] : memref<3x2xf32>
+}
+
+// -----
+
+// The annotation rides along from the ONNX matmul onto the krnl.matmul, where
+// the register-tile lowering picks the accumulator type.
+func.func private @test_matmul_accum_f64(%arg0 : tensor<16x32xf32>, %arg1 : tensor<32x64xf32>) -> tensor<*xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) {accum_type = "f64"} : (tensor<16x32xf32>, tensor<32x64xf32>) -> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+
+  // CHECK-LABEL: test_matmul_accum_f64
+  // CHECK: krnl.matmul
+  // CHECK-SAME: accum_type = "f64"
+}
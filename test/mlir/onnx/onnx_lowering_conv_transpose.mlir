@@ -0,0 +1,60 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl %s -split-input-file | FileCheck %s
+
+// Stride-2 upsampling with a 2x2 kernel: every residue class of the output
+// owns exactly one kernel tap, so each output element is a single
+// multiply-add with no divisibility or bounds tests; the four class loop
+// nests each contain one multiplication.
+func.func @test_conv_transpose_stride2(%arg0: tensor<1x64x36x48xf32>, %arg1: tensor<64x32x2x2xf32>) -> tensor<1x32x72x96xf32> {
+  %bias = "onnx.NoValue"() {value} : () -> none
+  %0 = "onnx.ConvTranspose"(%arg0, %arg1, %bias) {auto_pad = "NOTSET", group = 1 : si64, kernel_shape = [2, 2], pads = [0, 0, 0, 0], strides = [2, 2]} : (tensor<1x64x36x48xf32>, tensor<64x32x2x2xf32>, none) -> tensor<1x32x72x96xf32>
+  return %0 : tensor<1x32x72x96xf32>
+
+  // CHECK-LABEL: func @test_conv_transpose_stride2
+  // CHECK:       memref.alloc() {{.*}}: memref<1x32x72x96xf32>
+  // CHECK:       memref.alloca() : memref<f32>
+  // No runtime stride-divisibility tests and no bounds checks remain.
+  // CHECK-NOT:   arith.remsi
+  // CHECK-NOT:   arith.select
+  // One multiplication per residue class (kernel taps: 4 / (2*2) = 1 each).
+  // CHECK-COUNT-4: arith.mulf
+  // CHECK-NOT:   arith.mulf
+}
+
+// -----
+
+// Stride-2 deconvolution with a 3x3 kernel and pads = 1: each residue class
+// visits only the one or two congruent taps out of the nine, and only the
+// boundary taps carry a clamped load with a select against zero.
+func.func @test_conv_transpose_stride2_k3(%arg0: tensor<1x16x32x32xf32>, %arg1: tensor<16x8x3x3xf32>, %arg2: tensor<8xf32>) -> tensor<1x8x64x64xf32> {
+  %0 = "onnx.ConvTranspose"(%arg0, %arg1, %arg2) {auto_pad = "NOTSET", group = 1 : si64, kernel_shape = [3, 3], pads = [1, 1, 1, 1], strides = [2, 2]} : (tensor<1x16x32x32xf32>, tensor<16x8x3x3xf32>, tensor<8xf32>) -> tensor<1x8x64x64xf32>
+  return %0 : tensor<1x8x64x64xf32>
+
+  // CHECK-LABEL: func @test_conv_transpose_stride2_k3
+  // CHECK:       memref.alloc() {{.*}}: memref<1x8x64x64xf32>
+  // CHECK-NOT:   arith.remsi
+  // Boundary taps read through a clamped subscript and a select.
+  // CHECK:       arith.select {{.*}} : f32
+  // The bias is added once per output element, after the reduction.
+  // CHECK:       [[RED:%.+]] = krnl.load {{.*}} : memref<f32>
+  // CHECK:       arith.addf [[RED]], {{.*}} : f32
+  // CHECK:       krnl.store
+}
+
+// -----
+
+// Grouped transposed convolution: the weight carries the per-group output
+// channels in its second dimension and the lowering splits channels over
+// the group loop.
+func.func @test_conv_transpose_group(%arg0: tensor<1x64x36x48xf32>, %arg1: tensor<64x1x2x2xf32>) -> tensor<1x64x72x96xf32> {
+  %bias = "onnx.NoValue"() {value} : () -> none
+  %0 = "onnx.ConvTranspose"(%arg0, %arg1, %bias) {auto_pad = "NOTSET", group = 64 : si64, kernel_shape = [2, 2], pads = [0, 0, 0, 0], strides = [2, 2]} : (tensor<1x64x36x48xf32>, tensor<64x1x2x2xf32>, none) -> tensor<1x64x72x96xf32>
+  return %0 : tensor<1x64x72x96xf32>
+
+  // CHECK-LABEL: func @test_conv_transpose_group
+  // CHECK:       memref.alloc() {{.*}}: memref<1x64x72x96xf32>
+  // CHECK-NOT:   arith.remsi
+  // CHECK-NOT:   arith.select
+  // CHECK:       krnl.iterate
+  // CHECK:       arith.mulf
+  // CHECK:       krnl.store
+}
@@ -0,0 +1,64 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl='enable-fast-conv' %s -split-input-file | FileCheck %s
+
+// Fully static 2-D convolution: lowered through im2col plus the tiled
+// krnl.matmul kernel instead of the direct loop nest.
+func.func @test_conv_im2col_gemm(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<8x3x3x3xf32>) -> tensor<1x8x30x30xf32> {
+  %bias = "onnx.NoValue"() {value} : () -> none
+  %0 = "onnx.Conv"(%arg0, %arg1, %bias) {auto_pad = "NOTSET", group = 1 : si64} : (tensor<1x3x32x32xf32>, tensor<8x3x3x3xf32>, none) -> tensor<1x8x30x30xf32>
+  return %0 : tensor<1x8x30x30xf32>
+
+  // CHECK-LABEL: func @test_conv_im2col_gemm
+  // CHECK-DAG:   [[COL:%.+]] = memref.alloc() {{.*}}: memref<27x900xf32>
+  // CHECK-DAG:   [[FILTER:%.+]] = memref.alloc() {{.*}}: memref<8x27xf32>
+  // CHECK-DAG:   [[GEMM:%.+]] = memref.alloc() {{.*}}: memref<8x900xf32>
+  // Filter packing and im2col fill.
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.store {{.*}}, [[FILTER]]
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.store {{.*}}, [[COL]]
+  // Tiled GEMM.
+  // CHECK:       krnl.memset [[GEMM]],
+  // CHECK:       krnl.matmul [[FILTER]]{{.*}}, [[COL]]{{.*}}, [[GEMM]]
+  // Scatter back into NCHW layout.
+  // CHECK:       [[RES:%.+]] = krnl.load [[GEMM]]
+  // CHECK:       krnl.store [[RES]],
+}
+
+// -----
+
+// A dynamic batch dimension disables the im2col path; the direct loop nest
+// with its scalar reduction is emitted instead.
+func.func @test_conv_dynamic_fallback(%arg0: tensor<?x3x32x32xf32>, %arg1: tensor<8x3x3x3xf32>) -> tensor<?x8x30x30xf32> {
+  %bias = "onnx.NoValue"() {value} : () -> none
+  %0 = "onnx.Conv"(%arg0, %arg1, %bias) {auto_pad = "NOTSET", group = 1 : si64} : (tensor<?x3x32x32xf32>, tensor<8x3x3x3xf32>, none) -> tensor<?x8x30x30xf32>
+  return %0 : tensor<?x8x30x30xf32>
+
+  // CHECK-LABEL: func @test_conv_dynamic_fallback
+  // CHECK-NOT:   krnl.matmul
+  // CHECK:       memref.alloca() : memref<f32>
+  // CHECK:       krnl.iterate
+}
+
+// -----
+
+// Depthwise convolution (group == channels): lowered through the dedicated
+// depthwise kernel. The padded input window is staged into a zero-padded
+// scratch buffer and the 3x3 reduction runs as straight-line vector code
+// along the output width.
+func.func @test_conv_depthwise(%arg0: tensor<1x8x32x32xf32>, %arg1: tensor<8x1x3x3xf32>) -> tensor<1x8x32x32xf32> {
+  %bias = "onnx.NoValue"() {value} : () -> none
+  %0 = "onnx.Conv"(%arg0, %arg1, %bias) {auto_pad = "NOTSET", group = 8 : si64, pads = [1, 1, 1, 1]} : (tensor<1x8x32x32xf32>, tensor<8x1x3x3xf32>, none) -> tensor<1x8x32x32xf32>
+  return %0 : tensor<1x8x32x32xf32>
+
+  // CHECK-LABEL: func @test_conv_depthwise
+  // CHECK-NOT:   krnl.matmul
+  // CHECK:       [[PAD_BUFF:%.+]] = memref.alloc() {{.*}}: memref<34x34xf32>
+  // Staging of the zero-padded input window.
+  // CHECK:       arith.select {{.*}} : f32
+  // CHECK:       krnl.store {{.*}}, [[PAD_BUFF]]
+  // Straight-line vectorized 3x3 reduction.
+  // CHECK:       vector.load [[PAD_BUFF]]{{.*}} : memref<34x34xf32>, vector<4xf32>
+  // CHECK:       vector.fma {{.*}} : vector<4xf32>
+  // CHECK:       vector.store {{.*}} : memref<1x8x32x32xf32>, vector<4xf32>
+  // CHECK-NOT:   krnl.matmul
+}
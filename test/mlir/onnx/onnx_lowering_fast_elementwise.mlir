@@ -0,0 +1,164 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl='enable-fast-elementwise' %s -split-input-file | FileCheck %s
+
+// Static shapes with no broadcast: the buffers are linearized and the whole
+// iteration space becomes one flat vectorized loop, and the Relu consumer is
+// folded into the same loop as the Add, so a single buffer is allocated and
+// memory is traversed once.
+func.func @test_add_relu_fused_simd(%arg0: tensor<4x8xf32>, %arg1: tensor<4x8xf32>) -> tensor<4x8xf32> {
+  %0 = "onnx.Add"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  %1 = "onnx.Relu"(%0) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  return %1 : tensor<4x8xf32>
+
+  // CHECK-LABEL: func @test_add_relu_fused_simd
+  // CHECK:       [[RES:%.+]] = memref.alloc() {{.*}}: memref<4x8xf32>
+  // CHECK-NOT:   memref.alloc
+  // CHECK-DAG:   [[FLAT_LHS:%.+]] = memref.reinterpret_cast %arg0 to offset: [0], sizes: [32], strides: [1] : memref<4x8xf32> to memref<32xf32>
+  // CHECK-DAG:   [[FLAT_RHS:%.+]] = memref.reinterpret_cast %arg1 to offset: [0], sizes: [32], strides: [1] : memref<4x8xf32> to memref<32xf32>
+  // CHECK-DAG:   [[FLAT_RES:%.+]] = memref.reinterpret_cast [[RES]] to offset: [0], sizes: [32], strides: [1] : memref<4x8xf32> to memref<32xf32>
+  // CHECK:       [[DEF_LOOPS:%.+]] = krnl.define_loops 1
+  // CHECK:       krnl.block [[DEF_LOOPS]]
+  // CHECK:       krnl.iterate
+  // CHECK:       [[LHS:%.+]] = vector.load [[FLAT_LHS]]
+  // CHECK:       [[RHS:%.+]] = vector.load [[FLAT_RHS]]
+  // CHECK:       [[SUM:%.+]] = arith.addf [[LHS]], [[RHS]] : vector<{{[0-9]+}}xf32>
+  // CHECK:       arith.cmpf ogt, [[SUM]],
+  // CHECK:       [[FUSED:%.+]] = arith.select
+  // CHECK:       vector.store [[FUSED]], [[FLAT_RES]]
+  // CHECK-NOT:   krnl.iterate
+  // CHECK:       return [[RES]] : memref<4x8xf32>
+}
+
+// -----
+
+// An innermost dimension smaller than the vector length no longer blocks
+// vectorization: the collapsed flat loop only needs the total number of
+// elements to be a multiple of the vector length.
+func.func @test_collapse_short_innermost_simd(%arg0: tensor<32x2xf32>, %arg1: tensor<32x2xf32>) -> tensor<32x2xf32> {
+  %0 = "onnx.Add"(%arg0, %arg1) : (tensor<32x2xf32>, tensor<32x2xf32>) -> tensor<32x2xf32>
+  return %0 : tensor<32x2xf32>
+
+  // CHECK-LABEL: func @test_collapse_short_innermost_simd
+  // CHECK:       [[RES:%.+]] = memref.alloc() {{.*}}: memref<32x2xf32>
+  // CHECK:       memref.reinterpret_cast %arg0 to offset: [0], sizes: [64], strides: [1] : memref<32x2xf32> to memref<64xf32>
+  // CHECK:       [[DEF_LOOPS:%.+]] = krnl.define_loops 1
+  // CHECK:       krnl.block [[DEF_LOOPS]]
+  // CHECK:       krnl.iterate
+  // CHECK:       vector.load
+  // CHECK:       arith.addf {{.*}} : vector<{{[0-9]+}}xf32>
+  // CHECK:       vector.store
+  // CHECK-NOT:   krnl.store
+  // CHECK:       return [[RES]] : memref<32x2xf32>
+}
+
+// -----
+
+// Broadcasting disables the SIMD path but fusion still applies: Sqrt is
+// computed in the Mul loop and no loop nest is emitted for it.
+func.func @test_mul_broadcast_sqrt_fused(%arg0: tensor<4x8xf32>, %arg1: tensor<8xf32>) -> tensor<4x8xf32> {
+  %0 = "onnx.Mul"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8xf32>) -> tensor<4x8xf32>
+  %1 = "onnx.Sqrt"(%0) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  return %1 : tensor<4x8xf32>
+
+  // CHECK-LABEL: func @test_mul_broadcast_sqrt_fused
+  // CHECK:       [[RES:%.+]] = memref.alloc() {{.*}}: memref<4x8xf32>
+  // CHECK-NOT:   memref.alloc
+  // CHECK:       krnl.iterate
+  // CHECK:       [[PROD:%.+]] = arith.mulf
+  // CHECK:       [[FUSED:%.+]] = math.sqrt [[PROD]] : f32
+  // CHECK:       krnl.store [[FUSED]], [[RES]]
+  // CHECK-NOT:   krnl.iterate
+  // CHECK:       return [[RES]] : memref<4x8xf32>
+}
+
+// -----
+
+// A comparison feeding only the condition of a Where is fused with it into a
+// single vectorized compare+select loop: no i1 buffer is materialized for the
+// mask, the compare produces a vector mask and the select consumes it
+// directly.
+func.func @test_less_where_fused_simd(%arg0: tensor<4x8xf32>, %arg1: tensor<4x8xf32>, %arg2: tensor<4x8xf32>) -> tensor<4x8xf32> {
+  %0 = "onnx.Less"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xi1>
+  %1 = "onnx.Where"(%0, %arg2, %arg0) : (tensor<4x8xi1>, tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  return %1 : tensor<4x8xf32>
+
+  // CHECK-LABEL: func @test_less_where_fused_simd
+  // CHECK:       [[RES:%.+]] = memref.alloc() {{.*}}: memref<4x8xf32>
+  // CHECK-NOT:   memref.alloc
+  // CHECK:       [[DEF_LOOPS:%.+]] = krnl.define_loops 1
+  // CHECK:       krnl.block [[DEF_LOOPS]]
+  // CHECK:       krnl.iterate
+  // CHECK:       vector.load
+  // CHECK:       [[MASK:%.+]] = arith.cmpf olt, {{.*}} : vector<[[VL:[0-9]+]]xf32>
+  // CHECK:       [[SEL:%.+]] = arith.select [[MASK]], {{.*}} : vector<[[VL]]xi1>, vector<[[VL]]xf32>
+  // CHECK:       vector.store [[SEL]],
+  // CHECK-NOT:   krnl.iterate
+  // CHECK:       return [[RES]] : memref<4x8xf32>
+}
+
+// -----
+
+// Broadcast in a branch value keeps the comparison and the Where separate:
+// the mask goes through its own i1 buffer.
+func.func @test_less_where_broadcast_not_fused(%arg0: tensor<4x8xf32>, %arg1: tensor<4x8xf32>, %arg2: tensor<f32>) -> tensor<4x8xf32> {
+  %0 = "onnx.Less"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xi1>
+  %1 = "onnx.Where"(%0, %arg2, %arg0) : (tensor<4x8xi1>, tensor<f32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  return %1 : tensor<4x8xf32>
+
+  // CHECK-LABEL: func @test_less_where_broadcast_not_fused
+  // CHECK:       memref.alloc() {{.*}}: memref<4x8xi1>
+  // CHECK:       memref.alloc() {{.*}}: memref<4x8xf32>
+}
+
+// -----
+
+// Casts convert whole vectors at a time: the f32 blocks are loaded, truncated
+// with one arith.truncf per block, and stored as f16.
+func.func @test_cast_f32_f16_simd(%arg0: tensor<4x8xf32>) -> tensor<4x8xf16> {
+  %0 = "onnx.Cast"(%arg0) {to = f16} : (tensor<4x8xf32>) -> tensor<4x8xf16>
+  return %0 : tensor<4x8xf16>
+
+  // CHECK-LABEL: func @test_cast_f32_f16_simd
+  // CHECK:       [[RES:%.+]] = memref.alloc() {{.*}}: memref<4x8xf16>
+  // CHECK:       memref.reinterpret_cast %arg0 to offset: [0], sizes: [32], strides: [1] : memref<4x8xf32> to memref<32xf32>
+  // CHECK:       [[DEF_LOOPS:%.+]] = krnl.define_loops 1
+  // CHECK:       krnl.block [[DEF_LOOPS]]
+  // CHECK:       krnl.iterate
+  // CHECK:       [[X:%.+]] = vector.load {{.*}} : memref<32xf32>, vector<[[VL:[0-9]+]]xf32>
+  // CHECK:       [[CAST:%.+]] = arith.truncf [[X]] : vector<[[VL]]xf32> to vector<[[VL]]xf16>
+  // CHECK:       vector.store [[CAST]],
+  // CHECK-NOT:   krnl.iterate
+  // CHECK:       return [[RES]] : memref<4x8xf16>
+}
+
+// -----
+
+// Quantizing casts to integer element types vectorize as well.
+func.func @test_cast_f32_i8_simd(%arg0: tensor<4x8xf32>) -> tensor<4x8xi8> {
+  %0 = "onnx.Cast"(%arg0) {to = i8} : (tensor<4x8xf32>) -> tensor<4x8xi8>
+  return %0 : tensor<4x8xi8>
+
+  // CHECK-LABEL: func @test_cast_f32_i8_simd
+  // CHECK:       [[RES:%.+]] = memref.alloc() {{.*}}: memref<4x8xi8>
+  // CHECK:       krnl.block
+  // CHECK:       krnl.iterate
+  // CHECK:       [[X:%.+]] = vector.load {{.*}} : memref<32xf32>, vector<[[VL:[0-9]+]]xf32>
+  // CHECK:       [[CAST:%.+]] = arith.fptosi [[X]] : vector<[[VL]]xf32> to vector<[[VL]]xi8>
+  // CHECK:       vector.store [[CAST]],
+  // CHECK-NOT:   krnl.iterate
+  // CHECK:       return [[RES]] : memref<4x8xi8>
+}
+
+// -----
+
+// A result with more than one consumer must not be fused.
+func.func @test_no_fusion_multiple_uses(%arg0: tensor<4x8xf32>, %arg1: tensor<4x8xf32>) -> (tensor<4x8xf32>, tensor<4x8xf32>) {
+  %0 = "onnx.Add"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  %1 = "onnx.Relu"(%0) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  return %0, %1 : tensor<4x8xf32>, tensor<4x8xf32>
+
+  // CHECK-LABEL: func @test_no_fusion_multiple_uses
+  // CHECK:       memref.alloc
+  // CHECK:       memref.alloc
+  // CHECK:       krnl.iterate
+  // CHECK:       krnl.iterate
+}
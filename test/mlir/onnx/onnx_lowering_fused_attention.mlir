@@ -0,0 +1,50 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl='enable-fused-attention' --canonicalize %s -split-input-file | FileCheck %s
+
+// Static-shape attention subgraph with a scalar Div scaling: the whole
+// MatMul-Div-Softmax-MatMul chain is fused into one online-softmax kernel.
+// The 128x128 score matrix is never allocated.
+func.func @test_fused_attention(%arg0: tensor<2x8x128x64xf32>, %arg1: tensor<2x8x64x128xf32>, %arg2: tensor<2x8x128x64xf32>) -> tensor<2x8x128x64xf32> {
+  %scale = onnx.Constant dense<8.000000e+00> : tensor<f32>
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<2x8x128x64xf32>, tensor<2x8x64x128xf32>) -> tensor<2x8x128x128xf32>
+  %1 = "onnx.Div"(%0, %scale) : (tensor<2x8x128x128xf32>, tensor<f32>) -> tensor<2x8x128x128xf32>
+  %2 = "onnx.Softmax"(%1) {axis = -1 : si64} : (tensor<2x8x128x128xf32>) -> tensor<2x8x128x128xf32>
+  %3 = "onnx.MatMul"(%2, %arg2) : (tensor<2x8x128x128xf32>, tensor<2x8x128x64xf32>) -> tensor<2x8x128x64xf32>
+  return %3 : tensor<2x8x128x64xf32>
+
+// CHECK-LABEL:  func.func @test_fused_attention
+// CHECK-NOT:       memref<2x8x128x128xf32>
+// CHECK:           [[RES_:%.+]] = memref.alloc() {{.*}}: memref<2x8x128x64xf32>
+// CHECK:           math.exp
+// CHECK-NOT:       memref<2x8x128x128xf32>
+// CHECK:           return [[RES_]] : memref<2x8x128x64xf32>
+}
+
+// -----
+
+// Unscaled rank-3 attention is fused as well.
+func.func @test_fused_attention_no_scale(%arg0: tensor<16x512x64xf32>, %arg1: tensor<16x64x512xf32>, %arg2: tensor<16x512x64xf32>) -> tensor<16x512x64xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<16x512x64xf32>, tensor<16x64x512xf32>) -> tensor<16x512x512xf32>
+  %1 = "onnx.Softmax"(%0) {axis = -1 : si64} : (tensor<16x512x512xf32>) -> tensor<16x512x512xf32>
+  %2 = "onnx.MatMul"(%1, %arg2) : (tensor<16x512x512xf32>, tensor<16x512x64xf32>) -> tensor<16x512x64xf32>
+  return %2 : tensor<16x512x64xf32>
+
+// CHECK-LABEL:  func.func @test_fused_attention_no_scale
+// CHECK-NOT:       memref<16x512x512xf32>
+// CHECK:           math.exp
+// CHECK-NOT:       memref<16x512x512xf32>
+// CHECK:           return {{.*}} : memref<16x512x64xf32>
+}
+
+// -----
+
+// A softmax over a non-final axis cannot be fused; the ops lower one by one
+// and the score matrix is materialized as usual.
+func.func @test_attention_not_fused(%arg0: tensor<16x512x64xf32>, %arg1: tensor<16x64x512xf32>, %arg2: tensor<16x512x64xf32>) -> tensor<16x512x64xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<16x512x64xf32>, tensor<16x64x512xf32>) -> tensor<16x512x512xf32>
+  %1 = "onnx.Softmax"(%0) {axis = 1 : si64} : (tensor<16x512x512xf32>) -> tensor<16x512x512xf32>
+  %2 = "onnx.MatMul"(%1, %arg2) : (tensor<16x512x512xf32>, tensor<16x512x64xf32>) -> tensor<16x512x64xf32>
+  return %2 : tensor<16x512x64xf32>
+
+// CHECK-LABEL:  func.func @test_attention_not_fused
+// CHECK:           memref.alloc() {{.*}}: memref<16x512x512xf32>
+}
@@ -30,11 +30,10 @@ func.func private @test_gru_forward_mode(%arg0: tensor<7x2x3xf32>, %arg1: tensor
 // CHECK-DAG:       [[VAR_7_:%.+]] = "onnx.SqueezeV11"([[VAR_1_]]) {axes = [0]} : (tensor<1x12x4xf32>) -> tensor<12x4xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:       [[VAR_8_:%.+]] = "onnx.Transpose"([[VAR_6_]]) {perm = [1, 0]} : (tensor<12x3xf32>) -> tensor<3x12xf32>
-// CHECK-DAG:       [[VAR_9_:%.+]]:3 = "onnx.SplitV11"([[VAR_7_]]) {axis = 0 : si64} : (tensor<12x4xf32>) -> (tensor<4x4xf32>, tensor<4x4xf32>, tensor<4x4xf32>)
+// CHECK-DAG:       [[VAR_9_:%.+]]:2 = "onnx.SplitV11"([[VAR_7_]]) {axis = 0 : si64, split = [8, 4]} : (tensor<12x4xf32>) -> (tensor<8x4xf32>, tensor<4x4xf32>)
 // CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:       [[VAR_10_:%.+]] = "onnx.Transpose"([[VAR_9_]]#0) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_11_:%.+]] = "onnx.Transpose"([[VAR_9_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_12_:%.+]] = "onnx.Transpose"([[VAR_9_]]#2) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
+// CHECK-DAG:       [[VAR_10_:%.+]] = "onnx.Transpose"([[VAR_9_]]#0) {perm = [1, 0]} : (tensor<8x4xf32>) -> tensor<4x8xf32>
+// CHECK-DAG:       [[VAR_12_:%.+]] = "onnx.Transpose"([[VAR_9_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
 // CHECK-DAG:       [[VAR_13_:%.+]] = "onnx.SqueezeV11"([[VAR_0_]]) {axes = [0]} : (tensor<1x24xf32>) -> tensor<24xf32>
 // CHECK:           [[VAR_14_:%.+]]:6 = "onnx.SplitV11"([[VAR_13_]]) {axis = 0 : si64} : (tensor<24xf32>) -> (tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>)
 // CHECK-DAG:       [[VAR_15_:%.+]] = builtin.unrealized_conversion_cast [[VAR_14_]]#0 : tensor<4xf32> to memref<4xf32>
@@ -57,11 +56,8 @@ func.func private @test_gru_forward_mode(%arg0: tensor<7x2x3xf32>, %arg1: tensor
 // CHECK:             [[VAR_26_:%.+]] = "onnx.MatMul"([[VAR_25_]], [[VAR_8_]]) : (tensor<2x3xf32>, tensor<3x12xf32>) -> tensor<2x12xf32>
 // CHECK-DAG:         [[VAR_27_:%.+]] = builtin.unrealized_conversion_cast [[VAR_26_]] : tensor<2x12xf32> to memref<2x12xf32>
 // CHECK-DAG:         [[VAR_28_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_29_:%.+]] = "onnx.MatMul"([[VAR_28_]], [[VAR_10_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_30_:%.+]] = builtin.unrealized_conversion_cast [[VAR_29_]] : tensor<2x4xf32> to memref<2x4xf32>
-// CHECK-DAG:         [[VAR_31_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_32_:%.+]] = "onnx.MatMul"([[VAR_31_]], [[VAR_11_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_33_:%.+]] = builtin.unrealized_conversion_cast [[VAR_32_]] : tensor<2x4xf32> to memref<2x4xf32>
+// CHECK:             [[VAR_29_:%.+]] = "onnx.MatMul"([[VAR_28_]], [[VAR_10_]]) : (tensor<2x4xf32>, tensor<4x8xf32>) -> tensor<2x8xf32>
+// CHECK-DAG:         [[VAR_30_:%.+]] = builtin.unrealized_conversion_cast [[VAR_29_]] : tensor<2x8xf32> to memref<2x8xf32>
 // CHECK-DAG:         [[RES_3_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[RES_4_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
@@ -71,7 +67,8 @@ func.func private @test_gru_forward_mode(%arg0: tensor<7x2x3xf32>, %arg1: tensor
 // CHECK-DAG:           [[VAR_43_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_41_1_]]#1]
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_27_MEM_:%.+]] = krnl.load [[VAR_27_]]{{.}}[[VAR_41_1_]]#0, [[VAR_43_]]{{.}} : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_33_MEM_:%.+]] = krnl.load [[VAR_33_]]{{.}}[[VAR_41_1_]]#0, [[VAR_41_1_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[VAR_44_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_41_1_]]#1]
+// CHECK-DAG:           [[LOAD_VAR_33_MEM_:%.+]] = krnl.load [[VAR_30_]]{{.}}[[VAR_41_1_]]#0, [[VAR_44_]]{{.}} : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[VAR_46_:%.+]] = arith.addf [[LOAD_VAR_27_MEM_]], [[LOAD_VAR_33_MEM_]] : f32
 // CHECK-DAG:           [[LOAD_VAR_16_MEM_:%.+]] = krnl.load [[VAR_16_]]{{.}}[[VAR_41_1_]]#1] : memref<4xf32>
@@ -94,7 +91,7 @@ func.func private @test_gru_forward_mode(%arg0: tensor<7x2x3xf32>, %arg1: tensor
 // CHECK:               [[VAR_41_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK-DAG:           [[LOAD_PARAM_0_MEM_1_:%.+]] = krnl.load [[RES_1_]]{{.}}[[VAR_41_]]#0, [[VAR_41_]]#1] : memref<2x4xf32>
 // CHECK-DAG:           [[LOAD_VAR_27_MEM_1_:%.+]] = krnl.load [[VAR_27_]]{{.}}[[VAR_41_2_]]#0, [[VAR_41_2_]]#1] : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_27_MEM_2_:%.+]] = krnl.load [[VAR_30_]]{{.}}[[VAR_41_2_]]#0, [[VAR_41_2_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[LOAD_VAR_27_MEM_2_:%.+]] = krnl.load [[VAR_30_]]{{.}}[[VAR_41_2_]]#0, [[VAR_41_2_]]#1] : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_33_MEM_1_:%.+]] = arith.addf [[LOAD_VAR_27_MEM_1_]], [[LOAD_VAR_27_MEM_2_]] : f32
 // CHECK-DAG:           [[VAR_46_1_:%.+]] = krnl.load [[VAR_15_]]{{.}}[[VAR_41_2_]]#1] : memref<4xf32>
@@ -272,23 +269,19 @@ func.func private @test_gru_forward_mode_constant_weight_and_bias(%arg0: tensor<
 // CHECK:             krnl.store [[LOAD_PARAM_1_MEM_]], [[RES_1_]]{{.}}[[VAR_20_]]#0, [[VAR_20_]]#1] : memref<2x4xf32>
 // CHECK:           }
 // CHECK-DAG:       [[VAR_3_:%.+]] = "krnl.global"() {name = "constant_5", shape = [3, 12], value = dense<1.000000e+00> : tensor<3x12xf32>} : () -> memref<3x12xf32>
-// CHECK-DAG:       [[VAR_4_:%.+]] = "krnl.global"() {name = "constant_6", shape = [4, 4], value = dense<2.000000e+00> : tensor<4x4xf32>} : () -> memref<4x4xf32>
-// CHECK-DAG:       [[VAR_5_:%.+]] = "krnl.global"() {name = "constant_7", shape = [4, 4], value = dense<2.000000e+00> : tensor<4x4xf32>} : () -> memref<4x4xf32>
-// CHECK-DAG:       [[VAR_6_:%.+]] = "krnl.global"() {name = "constant_8", shape = [4, 4], value = dense<2.000000e+00> : tensor<4x4xf32>} : () -> memref<4x4xf32>
-// CHECK:           [[VAR_7_:%.+]] = builtin.unrealized_conversion_cast [[VAR_4_]] : memref<4x4xf32> to tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_8_:%.+]] = "onnx.Transpose"([[VAR_7_]]) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_9_:%.+]] = builtin.unrealized_conversion_cast [[VAR_5_]] : memref<4x4xf32> to tensor<4x4xf32>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:       [[VAR_10_:%.+]] = "onnx.Transpose"([[VAR_9_]]) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_11_:%.+]] = builtin.unrealized_conversion_cast [[VAR_6_]] : memref<4x4xf32> to tensor<4x4xf32>
+// CHECK-DAG:       [[VAR_4_:%.+]] = "krnl.global"() {name = "constant_{{[0-9]+}}", shape = [8, 4], value = dense<2.000000e+00> : tensor<8x4xf32>} : () -> memref<8x4xf32>
+// CHECK-DAG:       [[VAR_5_:%.+]] = "krnl.global"() {name = "constant_{{[0-9]+}}", shape = [4, 4], value = dense<2.000000e+00> : tensor<4x4xf32>} : () -> memref<4x4xf32>
+// CHECK:           [[VAR_7_:%.+]] = builtin.unrealized_conversion_cast [[VAR_4_]] : memref<8x4xf32> to tensor<8x4xf32>
+// CHECK-DAG:       [[VAR_8_:%.+]] = "onnx.Transpose"([[VAR_7_]]) {perm = [1, 0]} : (tensor<8x4xf32>) -> tensor<4x8xf32>
+// CHECK-DAG:       [[VAR_11_:%.+]] = builtin.unrealized_conversion_cast [[VAR_5_]] : memref<4x4xf32> to tensor<4x4xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:       [[VAR_12_:%.+]] = "onnx.Transpose"([[VAR_11_]]) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_13_:%.+]] = "krnl.global"() {name = "constant_10", shape = [4], value = dense<[1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00]> : tensor<4xf32>} : () -> memref<4xf32>
-// CHECK-DAG:       [[VAR_14_:%.+]] = "krnl.global"() {name = "constant_11", shape = [4], value = dense<[5.000000e+00, 6.000000e+00, 7.000000e+00, 8.000000e+00]> : tensor<4xf32>} : () -> memref<4xf32>
-// CHECK-DAG:       [[VAR_15_:%.+]] = "krnl.global"() {name = "constant_12", shape = [4], value = dense<[9.000000e+00, 1.000000e+01, 1.100000e+01, 1.200000e+01]> : tensor<4xf32>} : () -> memref<4xf32>
-// CHECK-DAG:       [[VAR_16_:%.+]] = "krnl.global"() {name = "constant_13", shape = [4], value = dense<[1.300000e+01, 1.400000e+01, 1.500000e+01, 1.600000e+01]> : tensor<4xf32>} : () -> memref<4xf32>
-// CHECK-DAG:       [[VAR_17_:%.+]] = "krnl.global"() {name = "constant_14", shape = [4], value = dense<[1.700000e+01, 1.800000e+01, 1.900000e+01, 2.000000e+01]> : tensor<4xf32>} : () -> memref<4xf32>
-// CHECK-DAG:       [[VAR_18_:%.+]] = "krnl.global"() {name = "constant_15", shape = [4], value = dense<[2.100000e+01, 2.200000e+01, 2.300000e+01, 2.400000e+01]> : tensor<4xf32>} : () -> memref<4xf32>
+// CHECK-DAG:       [[VAR_13_:%.+]] = "krnl.global"() {name = "constant_{{[0-9]+}}", shape = [4], value = dense<[1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00]> : tensor<4xf32>} : () -> memref<4xf32>
+// CHECK-DAG:       [[VAR_14_:%.+]] = "krnl.global"() {name = "constant_{{[0-9]+}}", shape = [4], value = dense<[5.000000e+00, 6.000000e+00, 7.000000e+00, 8.000000e+00]> : tensor<4xf32>} : () -> memref<4xf32>
+// CHECK-DAG:       [[VAR_15_:%.+]] = "krnl.global"() {name = "constant_{{[0-9]+}}", shape = [4], value = dense<[9.000000e+00, 1.000000e+01, 1.100000e+01, 1.200000e+01]> : tensor<4xf32>} : () -> memref<4xf32>
+// CHECK-DAG:       [[VAR_16_:%.+]] = "krnl.global"() {name = "constant_{{[0-9]+}}", shape = [4], value = dense<[1.300000e+01, 1.400000e+01, 1.500000e+01, 1.600000e+01]> : tensor<4xf32>} : () -> memref<4xf32>
+// CHECK-DAG:       [[VAR_17_:%.+]] = "krnl.global"() {name = "constant_{{[0-9]+}}", shape = [4], value = dense<[1.700000e+01, 1.800000e+01, 1.900000e+01, 2.000000e+01]> : tensor<4xf32>} : () -> memref<4xf32>
+// CHECK-DAG:       [[VAR_18_:%.+]] = "krnl.global"() {name = "constant_{{[0-9]+}}", shape = [4], value = dense<[2.100000e+01, 2.200000e+01, 2.300000e+01, 2.400000e+01]> : tensor<4xf32>} : () -> memref<4xf32>
 // CHECK-DAG:       [[LOOP_1_:%.+]] = krnl.define_loops 1
 // CHECK:           krnl.iterate([[LOOP_1_]]) with ([[LOOP_1_]] -> [[I_2_:%.+]] = 0 to 7){
 // CHECK-DAG:         [[VAR_20_1_:%.+]] = krnl.get_induction_var_value([[LOOP_1_]]) : (!krnl.loop) -> index
@@ -304,11 +297,8 @@ func.func private @test_gru_forward_mode_constant_weight_and_bias(%arg0: tensor<
 // CHECK:             [[VAR_25_:%.+]] = "onnx.MatMul"([[VAR_23_]], [[VAR_24_]]) : (tensor<2x3xf32>, tensor<3x12xf32>) -> tensor<2x12xf32>
 // CHECK-DAG:         [[VAR_26_:%.+]] = builtin.unrealized_conversion_cast [[VAR_25_]] : tensor<2x12xf32> to memref<2x12xf32>
 // CHECK-DAG:         [[VAR_27_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_28_:%.+]] = "onnx.MatMul"([[VAR_27_]], [[VAR_8_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_29_:%.+]] = builtin.unrealized_conversion_cast [[VAR_28_]] : tensor<2x4xf32> to memref<2x4xf32>
-// CHECK-DAG:         [[VAR_30_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_31_:%.+]] = "onnx.MatMul"([[VAR_30_]], [[VAR_10_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_32_:%.+]] = builtin.unrealized_conversion_cast [[VAR_31_]] : tensor<2x4xf32> to memref<2x4xf32>
+// CHECK:             [[VAR_28_:%.+]] = "onnx.MatMul"([[VAR_27_]], [[VAR_8_]]) : (tensor<2x4xf32>, tensor<4x8xf32>) -> tensor<2x8xf32>
+// CHECK-DAG:         [[VAR_29_:%.+]] = builtin.unrealized_conversion_cast [[VAR_28_]] : tensor<2x8xf32> to memref<2x8xf32>
 // CHECK-DAG:         [[RES_3_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[RES_4_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
@@ -318,7 +308,8 @@ func.func private @test_gru_forward_mode_constant_weight_and_bias(%arg0: tensor<
 // CHECK-DAG:           [[VAR_42_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_40_1_]]#1]
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_26_MEM_:%.+]] = krnl.load [[VAR_26_]]{{.}}[[VAR_40_1_]]#0, [[VAR_42_]]{{.}} : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_32_MEM_:%.+]] = krnl.load [[VAR_32_]]{{.}}[[VAR_40_1_]]#0, [[VAR_40_1_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[VAR_44_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_40_1_]]#1]
+// CHECK-DAG:           [[LOAD_VAR_32_MEM_:%.+]] = krnl.load [[VAR_29_]]{{.}}[[VAR_40_1_]]#0, [[VAR_44_]]{{.}} : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[VAR_45_:%.+]] = arith.addf [[LOAD_VAR_26_MEM_]], [[LOAD_VAR_32_MEM_]] : f32
 // CHECK-DAG:           [[LOAD_VAR_14_MEM_:%.+]] = krnl.load [[VAR_14_]]{{.}}[[VAR_40_1_]]#1] : memref<4xf32>
@@ -341,7 +332,7 @@ func.func private @test_gru_forward_mode_constant_weight_and_bias(%arg0: tensor<
 // CHECK:               [[VAR_40_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK-DAG:           [[LOAD_PARAM_0_MEM_1_:%.+]] = krnl.load [[RES_1_]]{{.}}[[VAR_40_2_]]#0, [[VAR_40_2_]]#1] : memref<2x4xf32>
 // CHECK-DAG:           [[LOAD_VAR_26_MEM_1_:%.+]] = krnl.load [[VAR_26_]]{{.}}[[VAR_40_2_]]#0, [[VAR_40_2_]]#1] : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_26_MEM_2_:%.+]] = krnl.load [[VAR_29_]]{{.}}[[VAR_40_2_]]#0, [[VAR_40_2_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[LOAD_VAR_26_MEM_2_:%.+]] = krnl.load [[VAR_29_]]{{.}}[[VAR_40_2_]]#0, [[VAR_40_2_]]#1] : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_32_MEM_1_:%.+]] = arith.addf [[LOAD_VAR_26_MEM_1_]], [[LOAD_VAR_26_MEM_2_]] : f32
 // CHECK-DAG:           [[VAR_45_1_:%.+]] = krnl.load [[VAR_13_]]{{.}}[[VAR_40_2_]]#1] : memref<4xf32>
@@ -409,11 +400,10 @@ func.func private @test_gru_reverse_mode(%arg0: tensor<7x2x3xf32>, %arg1: tensor
 // CHECK-DAG:       [[VAR_7_:%.+]] = "onnx.SqueezeV11"([[VAR_1_]]) {axes = [0]} : (tensor<1x12x4xf32>) -> tensor<12x4xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:       [[VAR_8_:%.+]] = "onnx.Transpose"([[VAR_6_]]) {perm = [1, 0]} : (tensor<12x3xf32>) -> tensor<3x12xf32>
-// CHECK-DAG:       [[VAR_9_:%.+]]:3 = "onnx.SplitV11"([[VAR_7_]]) {axis = 0 : si64} : (tensor<12x4xf32>) -> (tensor<4x4xf32>, tensor<4x4xf32>, tensor<4x4xf32>)
+// CHECK-DAG:       [[VAR_9_:%.+]]:2 = "onnx.SplitV11"([[VAR_7_]]) {axis = 0 : si64, split = [8, 4]} : (tensor<12x4xf32>) -> (tensor<8x4xf32>, tensor<4x4xf32>)
 // CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:       [[VAR_10_:%.+]] = "onnx.Transpose"([[VAR_9_]]#0) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_11_:%.+]] = "onnx.Transpose"([[VAR_9_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_12_:%.+]] = "onnx.Transpose"([[VAR_9_]]#2) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
+// CHECK-DAG:       [[VAR_10_:%.+]] = "onnx.Transpose"([[VAR_9_]]#0) {perm = [1, 0]} : (tensor<8x4xf32>) -> tensor<4x8xf32>
+// CHECK-DAG:       [[VAR_12_:%.+]] = "onnx.Transpose"([[VAR_9_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
 // CHECK-DAG:       [[VAR_13_:%.+]] = "onnx.SqueezeV11"([[VAR_0_]]) {axes = [0]} : (tensor<1x24xf32>) -> tensor<24xf32>
 // CHECK:           [[VAR_14_:%.+]]:6 = "onnx.SplitV11"([[VAR_13_]]) {axis = 0 : si64} : (tensor<24xf32>) -> (tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>)
 // CHECK-DAG:       [[VAR_15_:%.+]] = builtin.unrealized_conversion_cast [[VAR_14_]]#0 : tensor<4xf32> to memref<4xf32>
@@ -437,11 +427,8 @@ func.func private @test_gru_reverse_mode(%arg0: tensor<7x2x3xf32>, %arg1: tensor
 // CHECK:             [[VAR_27_:%.+]] = "onnx.MatMul"([[VAR_26_]], [[VAR_8_]]) : (tensor<2x3xf32>, tensor<3x12xf32>) -> tensor<2x12xf32>
 // CHECK-DAG:         [[VAR_28_:%.+]] = builtin.unrealized_conversion_cast [[VAR_27_]] : tensor<2x12xf32> to memref<2x12xf32>
 // CHECK-DAG:         [[VAR_29_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_30_:%.+]] = "onnx.MatMul"([[VAR_29_]], [[VAR_10_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_31_:%.+]] = builtin.unrealized_conversion_cast [[VAR_30_]] : tensor<2x4xf32> to memref<2x4xf32>
-// CHECK-DAG:         [[VAR_32_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_33_:%.+]] = "onnx.MatMul"([[VAR_32_]], [[VAR_11_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_34_:%.+]] = builtin.unrealized_conversion_cast [[VAR_33_]] : tensor<2x4xf32> to memref<2x4xf32>
+// CHECK:             [[VAR_30_:%.+]] = "onnx.MatMul"([[VAR_29_]], [[VAR_10_]]) : (tensor<2x4xf32>, tensor<4x8xf32>) -> tensor<2x8xf32>
+// CHECK-DAG:         [[VAR_31_:%.+]] = builtin.unrealized_conversion_cast [[VAR_30_]] : tensor<2x8xf32> to memref<2x8xf32>
 // CHECK-DAG:         [[RES_3_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[RES_4_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
@@ -451,7 +438,8 @@ func.func private @test_gru_reverse_mode(%arg0: tensor<7x2x3xf32>, %arg1: tensor
 // CHECK-DAG:           [[VAR_44_:%.+]] = affine.apply [[MAP_1_]](){{.}}[[VAR_42_1_]]#1]
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_28_MEM_:%.+]] = krnl.load [[VAR_28_]]{{.}}[[VAR_42_1_]]#0, [[VAR_44_]]{{.}} : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_34_MEM_:%.+]] = krnl.load [[VAR_34_]]{{.}}[[VAR_42_1_]]#0, [[VAR_42_1_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[VAR_45_:%.+]] = affine.apply [[MAP_1_]](){{.}}[[VAR_42_1_]]#1]
+// CHECK-DAG:           [[LOAD_VAR_34_MEM_:%.+]] = krnl.load [[VAR_31_]]{{.}}[[VAR_42_1_]]#0, [[VAR_45_]]{{.}} : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[VAR_47_:%.+]] = arith.addf [[LOAD_VAR_28_MEM_]], [[LOAD_VAR_34_MEM_]] : f32
 // CHECK-DAG:           [[LOAD_VAR_16_MEM_:%.+]] = krnl.load [[VAR_16_]]{{.}}[[VAR_42_1_]]#1] : memref<4xf32>
@@ -474,7 +462,7 @@ func.func private @test_gru_reverse_mode(%arg0: tensor<7x2x3xf32>, %arg1: tensor
 // CHECK:               [[VAR_42_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK-DAG:           [[LOAD_PARAM_0_MEM_1_:%.+]] = krnl.load [[RES_1_]]{{.}}[[VAR_42_1_]]#0, [[VAR_42_1_]]#1] : memref<2x4xf32>
 // CHECK-DAG:           [[LOAD_VAR_28_MEM_1_:%.+]] = krnl.load [[VAR_28_]]{{.}}[[VAR_42_2_]]#0, [[VAR_42_2_]]#1] : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_28_MEM_2_:%.+]] = krnl.load [[VAR_31_]]{{.}}[[VAR_42_2_]]#0, [[VAR_42_2_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[LOAD_VAR_28_MEM_2_:%.+]] = krnl.load [[VAR_31_]]{{.}}[[VAR_42_2_]]#0, [[VAR_42_2_]]#1] : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_34_MEM_1_:%.+]] = arith.addf [[LOAD_VAR_28_MEM_1_]], [[LOAD_VAR_28_MEM_2_]] : f32
 // CHECK-DAG:           [[VAR_47_1_:%.+]] = krnl.load [[VAR_15_]]{{.}}[[VAR_42_2_]]#1] : memref<4xf32>
@@ -549,16 +537,14 @@ func.func private @test_gru_bidirectional_mode(%arg0: tensor<7x2x3xf32>, %arg1:
 // CHECK-DAG:       [[VAR_11_:%.+]] = "onnx.SqueezeV11"([[VAR_10_]]#0) {axes = [0]} : (tensor<1x12x4xf32>) -> tensor<12x4xf32>
 // CHECK-DAG:       [[VAR_12_:%.+]] = "onnx.SqueezeV11"([[VAR_10_]]#1) {axes = [0]} : (tensor<1x12x4xf32>) -> tensor<12x4xf32>
 // CHECK-DAG:       [[VAR_13_:%.+]] = "onnx.Transpose"([[VAR_8_]]) {perm = [1, 0]} : (tensor<12x3xf32>) -> tensor<3x12xf32>
-// CHECK:           [[VAR_14_:%.+]]:3 = "onnx.SplitV11"([[VAR_11_]]) {axis = 0 : si64} : (tensor<12x4xf32>) -> (tensor<4x4xf32>, tensor<4x4xf32>, tensor<4x4xf32>)
-// CHECK-DAG:       [[VAR_15_:%.+]] = "onnx.Transpose"([[VAR_14_]]#0) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_16_:%.+]] = "onnx.Transpose"([[VAR_14_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_17_:%.+]] = "onnx.Transpose"([[VAR_14_]]#2) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
+// CHECK:           [[VAR_14_:%.+]]:2 = "onnx.SplitV11"([[VAR_11_]]) {axis = 0 : si64, split = [8, 4]} : (tensor<12x4xf32>) -> (tensor<8x4xf32>, tensor<4x4xf32>)
+// CHECK-DAG:       [[VAR_15_:%.+]] = "onnx.Transpose"([[VAR_14_]]#0) {perm = [1, 0]} : (tensor<8x4xf32>) -> tensor<4x8xf32>
+// CHECK-DAG:       [[VAR_17_:%.+]] = "onnx.Transpose"([[VAR_14_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
 // CHECK-DAG:       [[VAR_18_:%.+]] = "onnx.Transpose"([[VAR_9_]]) {perm = [1, 0]} : (tensor<12x3xf32>) -> tensor<3x12xf32>
-// CHECK-DAG:       [[VAR_19_:%.+]]:3 = "onnx.SplitV11"([[VAR_12_]]) {axis = 0 : si64} : (tensor<12x4xf32>) -> (tensor<4x4xf32>, tensor<4x4xf32>, tensor<4x4xf32>)
+// CHECK-DAG:       [[VAR_19_:%.+]]:2 = "onnx.SplitV11"([[VAR_12_]]) {axis = 0 : si64, split = [8, 4]} : (tensor<12x4xf32>) -> (tensor<8x4xf32>, tensor<4x4xf32>)
 // CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:       [[VAR_20_:%.+]] = "onnx.Transpose"([[VAR_19_]]#0) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_21_:%.+]] = "onnx.Transpose"([[VAR_19_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_22_:%.+]] = "onnx.Transpose"([[VAR_19_]]#2) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
+// CHECK-DAG:       [[VAR_20_:%.+]] = "onnx.Transpose"([[VAR_19_]]#0) {perm = [1, 0]} : (tensor<8x4xf32>) -> tensor<4x8xf32>
+// CHECK-DAG:       [[VAR_22_:%.+]] = "onnx.Transpose"([[VAR_19_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
 // CHECK-DAG:       [[VAR_23_:%.+]]:2 = "onnx.SplitV11"([[VAR_0_]]) {axis = 0 : si64} : (tensor<2x24xf32>) -> (tensor<1x24xf32>, tensor<1x24xf32>)
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:       [[VAR_24_:%.+]] = "onnx.SqueezeV11"([[VAR_23_]]#0) {axes = [0]} : (tensor<1x24xf32>) -> tensor<24xf32>
@@ -592,11 +578,8 @@ func.func private @test_gru_bidirectional_mode(%arg0: tensor<7x2x3xf32>, %arg1:
 // CHECK:             [[VAR_47_:%.+]] = "onnx.MatMul"([[VAR_46_]], [[VAR_13_]]) : (tensor<2x3xf32>, tensor<3x12xf32>) -> tensor<2x12xf32>
 // CHECK-DAG:         [[VAR_48_:%.+]] = builtin.unrealized_conversion_cast [[VAR_47_]] : tensor<2x12xf32> to memref<2x12xf32>
 // CHECK-DAG:         [[VAR_49_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_50_:%.+]] = "onnx.MatMul"([[VAR_49_]], [[VAR_15_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_51_:%.+]] = builtin.unrealized_conversion_cast [[VAR_50_]] : tensor<2x4xf32> to memref<2x4xf32>
-// CHECK-DAG:         [[VAR_52_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_53_:%.+]] = "onnx.MatMul"([[VAR_52_]], [[VAR_16_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_54_:%.+]] = builtin.unrealized_conversion_cast [[VAR_53_]] : tensor<2x4xf32> to memref<2x4xf32>
+// CHECK:             [[VAR_50_:%.+]] = "onnx.MatMul"([[VAR_49_]], [[VAR_15_]]) : (tensor<2x4xf32>, tensor<4x8xf32>) -> tensor<2x8xf32>
+// CHECK-DAG:         [[VAR_51_:%.+]] = builtin.unrealized_conversion_cast [[VAR_50_]] : tensor<2x8xf32> to memref<2x8xf32>
 // CHECK-DAG:         [[RES_4_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[RES_5_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
@@ -606,7 +589,8 @@ func.func private @test_gru_bidirectional_mode(%arg0: tensor<7x2x3xf32>, %arg1:
 // CHECK-DAG:           [[VAR_64_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_62_1_]]#1]
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_48_MEM_:%.+]] = krnl.load [[VAR_48_]]{{.}}[[VAR_62_1_]]#0, [[VAR_64_]]{{.}} : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_54_MEM_:%.+]] = krnl.load [[VAR_54_]]{{.}}[[VAR_62_1_]]#0, [[VAR_62_1_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[VAR_65_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_62_1_]]#1]
+// CHECK-DAG:           [[LOAD_VAR_54_MEM_:%.+]] = krnl.load [[VAR_51_]]{{.}}[[VAR_62_1_]]#0, [[VAR_65_]]{{.}} : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[VAR_67_:%.+]] = arith.addf [[LOAD_VAR_48_MEM_]], [[LOAD_VAR_54_MEM_]] : f32
 // CHECK-DAG:           [[LOAD_VAR_28_MEM_:%.+]] = krnl.load [[VAR_28_]]{{.}}[[VAR_62_1_]]#1] : memref<4xf32>
@@ -629,7 +613,7 @@ func.func private @test_gru_bidirectional_mode(%arg0: tensor<7x2x3xf32>, %arg1:
 // CHECK:               [[VAR_62_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK-DAG:           [[LOAD_PARAM_0_MEM_1_:%.+]] = krnl.load [[RES_1_]]{{.}}[[VAR_62_2_]]#0, [[VAR_62_2_]]#1] : memref<2x4xf32>
 // CHECK-DAG:           [[LOAD_VAR_48_MEM_1_:%.+]] = krnl.load [[VAR_48_]]{{.}}[[VAR_62_2_]]#0, [[VAR_62_2_]]#1] : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_48_MEM_2_:%.+]] = krnl.load [[VAR_51_]]{{.}}[[VAR_62_2_]]#0, [[VAR_62_2_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[LOAD_VAR_48_MEM_2_:%.+]] = krnl.load [[VAR_51_]]{{.}}[[VAR_62_2_]]#0, [[VAR_62_2_]]#1] : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_54_MEM_1_:%.+]] = arith.addf [[LOAD_VAR_48_MEM_1_]], [[LOAD_VAR_48_MEM_2_]] : f32
 // CHECK-DAG:           [[VAR_67_1_:%.+]] = krnl.load [[VAR_27_]]{{.}}[[VAR_62_2_]]#1] : memref<4xf32>
@@ -674,11 +658,8 @@ func.func private @test_gru_bidirectional_mode(%arg0: tensor<7x2x3xf32>, %arg1:
 // CHECK:             [[VAR_48_1_:%.+]] = "onnx.MatMul"([[VAR_47_1_]], [[VAR_18_]]) : (tensor<2x3xf32>, tensor<3x12xf32>) -> tensor<2x12xf32>
 // CHECK-DAG:         [[VAR_49_1_:%.+]] = builtin.unrealized_conversion_cast [[VAR_48_1_]] : tensor<2x12xf32> to memref<2x12xf32>
 // CHECK-DAG:         [[VAR_50_1_:%.+]] = builtin.unrealized_conversion_cast [[RES_2_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_51_1_:%.+]] = "onnx.MatMul"([[VAR_50_1_]], [[VAR_20_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[VAR_52_1_:%.+]] = builtin.unrealized_conversion_cast [[VAR_51_1_]] : tensor<2x4xf32> to memref<2x4xf32>
-// CHECK-DAG:         [[VAR_53_1_:%.+]] = builtin.unrealized_conversion_cast [[RES_2_]] : memref<2x4xf32> to tensor<2x4xf32>
-// CHECK:             [[VAR_54_1_:%.+]] = "onnx.MatMul"([[VAR_53_1_]], [[VAR_21_]]) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
-// CHECK-DAG:         [[RES_4_:%.+]] = builtin.unrealized_conversion_cast [[VAR_54_1_]] : tensor<2x4xf32> to memref<2x4xf32>
+// CHECK:             [[VAR_51_1_:%.+]] = "onnx.MatMul"([[VAR_50_1_]], [[VAR_20_]]) : (tensor<2x4xf32>, tensor<4x8xf32>) -> tensor<2x8xf32>
+// CHECK-DAG:         [[VAR_52_1_:%.+]] = builtin.unrealized_conversion_cast [[VAR_51_1_]] : tensor<2x8xf32> to memref<2x8xf32>
 // CHECK-DAG:         [[RES_7_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<2x4xf32>
 // CHECK-DAG:         [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
@@ -688,7 +669,8 @@ func.func private @test_gru_bidirectional_mode(%arg0: tensor<7x2x3xf32>, %arg1:
 // CHECK-DAG:           [[LOAD_VAR_48_MEM_2_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[LOAD_PARAM_0_MEM_1_1_]]#1]
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_54_MEM_1_:%.+]] = krnl.load [[VAR_49_1_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_]]#0, [[LOAD_VAR_48_MEM_2_]]{{.}} : memref<2x12xf32>
-// CHECK-DAG:           [[VAR_67_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_]]#0, [[LOAD_PARAM_0_MEM_1_1_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[VAR_67_2_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[LOAD_PARAM_0_MEM_1_1_]]#1]
+// CHECK-DAG:           [[VAR_67_1_:%.+]] = krnl.load [[VAR_52_1_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_]]#0, [[VAR_67_2_]]{{.}} : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_28_MEM_1_:%.+]] = arith.addf [[LOAD_VAR_54_MEM_1_]], [[VAR_67_1_]] : f32
 // CHECK-DAG:           [[LOAD_VAR_31_MEM_1_:%.+]] = krnl.load [[VAR_35_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_]]#1] : memref<4xf32>
@@ -711,7 +693,7 @@ func.func private @test_gru_bidirectional_mode(%arg0: tensor<7x2x3xf32>, %arg1:
 // CHECK:               [[LOAD_PARAM_0_MEM_1_1_1_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_8_]]#0, [[LOOP_8_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK-DAG:           [[LOAD_PARAM_0_MEM_2_1_:%.+]] = krnl.load [[RES_2_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_1_]]#0, [[LOAD_PARAM_0_MEM_1_1_1_]]#1] : memref<2x4xf32>
 // CHECK-DAG:           [[LOAD_VAR_48_MEM_2_1_:%.+]] = krnl.load [[VAR_49_1_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_1_]]#0, [[LOAD_PARAM_0_MEM_1_1_1_]]#1] : memref<2x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_54_MEM_1_1_:%.+]] = krnl.load [[VAR_52_1_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_1_]]#0, [[LOAD_PARAM_0_MEM_1_1_1_]]#1] : memref<2x4xf32>
+// CHECK-DAG:           [[LOAD_VAR_54_MEM_1_1_:%.+]] = krnl.load [[VAR_52_1_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_1_]]#0, [[LOAD_PARAM_0_MEM_1_1_1_]]#1] : memref<2x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[VAR_67_2_:%.+]] = arith.addf [[LOAD_VAR_48_MEM_2_1_]], [[LOAD_VAR_54_MEM_1_1_]] : f32
 // CHECK-DAG:           [[LOAD_VAR_28_MEM_1_1_:%.+]] = krnl.load [[VAR_34_]]{{.}}[[LOAD_PARAM_0_MEM_1_1_1_]]#1] : memref<4xf32>
@@ -789,11 +771,10 @@ func.func private @test_gru_unknown_dims(%arg0: tensor<?x?x?xf32>, %arg1: tensor
 // CHECK-DAG:       [[VAR_9_:%.+]] = "onnx.SqueezeV11"([[VAR_1_]]) {axes = [0]} : (tensor<1x12x4xf32>) -> tensor<12x4xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:       [[VAR_10_:%.+]] = "onnx.Transpose"([[VAR_8_]]) {perm = [1, 0]} : (tensor<12x?xf32>) -> tensor<?x12xf32>
-// CHECK-DAG:       [[VAR_11_:%.+]]:3 = "onnx.SplitV11"([[VAR_9_]]) {axis = 0 : si64} : (tensor<12x4xf32>) -> (tensor<4x4xf32>, tensor<4x4xf32>, tensor<4x4xf32>)
+// CHECK-DAG:       [[VAR_11_:%.+]]:2 = "onnx.SplitV11"([[VAR_9_]]) {axis = 0 : si64, split = [8, 4]} : (tensor<12x4xf32>) -> (tensor<8x4xf32>, tensor<4x4xf32>)
 // CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:       [[VAR_12_:%.+]] = "onnx.Transpose"([[VAR_11_]]#0) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_13_:%.+]] = "onnx.Transpose"([[VAR_11_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
-// CHECK-DAG:       [[VAR_14_:%.+]] = "onnx.Transpose"([[VAR_11_]]#2) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
+// CHECK-DAG:       [[VAR_12_:%.+]] = "onnx.Transpose"([[VAR_11_]]#0) {perm = [1, 0]} : (tensor<8x4xf32>) -> tensor<4x8xf32>
+// CHECK-DAG:       [[VAR_14_:%.+]] = "onnx.Transpose"([[VAR_11_]]#1) {perm = [1, 0]} : (tensor<4x4xf32>) -> tensor<4x4xf32>
 // CHECK-DAG:       [[VAR_15_:%.+]] = "onnx.SqueezeV11"([[VAR_0_]]) {axes = [0]} : (tensor<1x24xf32>) -> tensor<24xf32>
 // CHECK:           [[VAR_16_:%.+]]:6 = "onnx.SplitV11"([[VAR_15_]]) {axis = 0 : si64} : (tensor<24xf32>) -> (tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>, tensor<4xf32>)
 // CHECK-DAG:       [[VAR_17_:%.+]] = builtin.unrealized_conversion_cast [[VAR_16_]]#0 : tensor<4xf32> to memref<4xf32>
@@ -820,11 +801,8 @@ func.func private @test_gru_unknown_dims(%arg0: tensor<?x?x?xf32>, %arg1: tensor
 // CHECK:             [[VAR_33_:%.+]] = "onnx.MatMul"([[VAR_32_]], [[VAR_10_]]) : (tensor<?x?xf32>, tensor<?x12xf32>) -> tensor<?x12xf32>
 // CHECK-DAG:         [[VAR_34_:%.+]] = builtin.unrealized_conversion_cast [[VAR_33_]] : tensor<?x12xf32> to memref<?x12xf32>
 // CHECK-DAG:         [[VAR_35_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<?x4xf32> to tensor<?x4xf32>
-// CHECK:             [[VAR_36_:%.+]] = "onnx.MatMul"([[VAR_35_]], [[VAR_12_]]) : (tensor<?x4xf32>, tensor<4x4xf32>) -> tensor<?x4xf32>
-// CHECK-DAG:         [[VAR_37_:%.+]] = builtin.unrealized_conversion_cast [[VAR_36_]] : tensor<?x4xf32> to memref<?x4xf32>
-// CHECK-DAG:         [[VAR_38_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<?x4xf32> to tensor<?x4xf32>
-// CHECK:             [[VAR_39_:%.+]] = "onnx.MatMul"([[VAR_38_]], [[VAR_13_]]) : (tensor<?x4xf32>, tensor<4x4xf32>) -> tensor<?x4xf32>
-// CHECK-DAG:         [[VAR_40_:%.+]] = builtin.unrealized_conversion_cast [[VAR_39_]] : tensor<?x4xf32> to memref<?x4xf32>
+// CHECK:             [[VAR_36_:%.+]] = "onnx.MatMul"([[VAR_35_]], [[VAR_12_]]) : (tensor<?x4xf32>, tensor<4x8xf32>) -> tensor<?x8xf32>
+// CHECK-DAG:         [[VAR_37_:%.+]] = builtin.unrealized_conversion_cast [[VAR_36_]] : tensor<?x8xf32> to memref<?x8xf32>
 // CHECK-DAG:         [[RES_3_:%.+]] = memref.alloc([[VAR_5_]]) {{.*}}: memref<?x4xf32>
 // CHECK-DAG:         [[RES_4_:%.+]] = memref.alloc([[VAR_5_]]) {{.*}}: memref<?x4xf32>
 // CHECK-DAG:         [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
@@ -834,7 +812,8 @@ func.func private @test_gru_unknown_dims(%arg0: tensor<?x?x?xf32>, %arg1: tensor
 // CHECK-DAG:           [[VAR_50_:%.+]] = affine.apply [[MAP_1_]](){{.}}[[VAR_48_1_]]#1]
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_34_MEM_:%.+]] = krnl.load [[VAR_34_]]{{.}}[[VAR_48_1_]]#0, [[VAR_50_]]{{.}} : memref<?x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_40_MEM_:%.+]] = krnl.load [[VAR_40_]]{{.}}[[VAR_48_1_]]#0, [[VAR_48_1_]]#1] : memref<?x4xf32>
+// CHECK-DAG:           [[VAR_51_:%.+]] = affine.apply [[MAP_1_]](){{.}}[[VAR_48_1_]]#1]
+// CHECK-DAG:           [[LOAD_VAR_40_MEM_:%.+]] = krnl.load [[VAR_37_]]{{.}}[[VAR_48_1_]]#0, [[VAR_51_]]{{.}} : memref<?x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[VAR_53_:%.+]] = arith.addf [[LOAD_VAR_34_MEM_]], [[LOAD_VAR_40_MEM_]] : f32
 // CHECK-DAG:           [[LOAD_VAR_18_MEM_:%.+]] = krnl.load [[VAR_18_]]{{.}}[[VAR_48_1_]]#1] : memref<4xf32>
@@ -857,7 +836,7 @@ func.func private @test_gru_unknown_dims(%arg0: tensor<?x?x?xf32>, %arg1: tensor
 // CHECK:               [[VAR_48_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK-DAG:           [[LOAD_PARAM_0_MEM_1_:%.+]] = krnl.load [[RES_1_]]{{.}}[[VAR_48_2_]]#0, [[VAR_48_2_]]#1] : memref<?x4xf32>
 // CHECK-DAG:           [[LOAD_VAR_34_MEM_1_:%.+]] = krnl.load [[VAR_34_]]{{.}}[[VAR_48_2_]]#0, [[VAR_48_2_]]#1] : memref<?x12xf32>
-// CHECK-DAG:           [[LOAD_VAR_34_MEM_2_:%.+]] = krnl.load [[VAR_37_]]{{.}}[[VAR_48_2_]]#0, [[VAR_48_2_]]#1] : memref<?x4xf32>
+// CHECK-DAG:           [[LOAD_VAR_34_MEM_2_:%.+]] = krnl.load [[VAR_37_]]{{.}}[[VAR_48_2_]]#0, [[VAR_48_2_]]#1] : memref<?x8xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_40_MEM_1_:%.+]] = arith.addf [[LOAD_VAR_34_MEM_1_]], [[LOAD_VAR_34_MEM_2_]] : f32
 // CHECK-DAG:           [[VAR_53_1_:%.+]] = krnl.load [[VAR_17_]]{{.}}[[VAR_48_2_]]#1] : memref<4xf32>
@@ -924,11 +903,10 @@ func.func @gru_default_backend(%arg0: tensor<1x3x2xf32>, %arg1: tensor<1x15x2xf3
 // CHECK-DAG:       [[VAR_6_:%.+]] = "onnx.SqueezeV11"([[VAR_0_]]) {axes = [0]} : (tensor<1x15x5xf32>) -> tensor<15x5xf32>
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:       [[VAR_7_:%.+]] = "onnx.Transpose"([[VAR_5_]]) {perm = [1, 0]} : (tensor<15x2xf32>) -> tensor<2x15xf32>
-// CHECK-DAG:       [[VAR_8_:%.+]]:3 = "onnx.SplitV11"([[VAR_6_]]) {axis = 0 : si64} : (tensor<15x5xf32>) -> (tensor<5x5xf32>, tensor<5x5xf32>, tensor<5x5xf32>)
+// CHECK-DAG:       [[VAR_8_:%.+]]:2 = "onnx.SplitV11"([[VAR_6_]]) {axis = 0 : si64, split = [10, 5]} : (tensor<15x5xf32>) -> (tensor<10x5xf32>, tensor<5x5xf32>)
 // CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:       [[VAR_9_:%.+]] = "onnx.Transpose"([[VAR_8_]]#0) {perm = [1, 0]} : (tensor<5x5xf32>) -> tensor<5x5xf32>
-// CHECK-DAG:       [[VAR_10_:%.+]] = "onnx.Transpose"([[VAR_8_]]#1) {perm = [1, 0]} : (tensor<5x5xf32>) -> tensor<5x5xf32>
-// CHECK-DAG:       [[VAR_11_:%.+]] = "onnx.Transpose"([[VAR_8_]]#2) {perm = [1, 0]} : (tensor<5x5xf32>) -> tensor<5x5xf32>
+// CHECK-DAG:       [[VAR_9_:%.+]] = "onnx.Transpose"([[VAR_8_]]#0) {perm = [1, 0]} : (tensor<10x5xf32>) -> tensor<5x10xf32>
+// CHECK-DAG:       [[VAR_11_:%.+]] = "onnx.Transpose"([[VAR_8_]]#1) {perm = [1, 0]} : (tensor<5x5xf32>) -> tensor<5x5xf32>
 // CHECK-DAG:       [[LOOP_1_:%.+]] = krnl.define_loops 1
 // CHECK:           krnl.iterate([[LOOP_1_]]) with ([[LOOP_1_]] -> [[I_2_:%.+]] = 0 to 1){
 // CHECK-DAG:         [[VAR_13_1_:%.+]] = krnl.get_induction_var_value([[LOOP_1_]]) : (!krnl.loop) -> index
@@ -943,11 +921,8 @@ func.func @gru_default_backend(%arg0: tensor<1x3x2xf32>, %arg1: tensor<1x15x2xf3
 // CHECK:             [[VAR_17_:%.+]] = "onnx.MatMul"([[VAR_16_]], [[VAR_7_]]) : (tensor<3x2xf32>, tensor<2x15xf32>) -> tensor<3x15xf32>
 // CHECK-DAG:         [[VAR_18_:%.+]] = builtin.unrealized_conversion_cast [[VAR_17_]] : tensor<3x15xf32> to memref<3x15xf32>
 // CHECK-DAG:         [[VAR_19_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<3x5xf32> to tensor<3x5xf32>
-// CHECK:             [[VAR_20_:%.+]] = "onnx.MatMul"([[VAR_19_]], [[VAR_9_]]) : (tensor<3x5xf32>, tensor<5x5xf32>) -> tensor<3x5xf32>
-// CHECK-DAG:         [[VAR_21_:%.+]] = builtin.unrealized_conversion_cast [[VAR_20_]] : tensor<3x5xf32> to memref<3x5xf32>
-// CHECK-DAG:         [[VAR_22_:%.+]] = builtin.unrealized_conversion_cast [[RES_1_]] : memref<3x5xf32> to tensor<3x5xf32>
-// CHECK:             [[VAR_23_:%.+]] = "onnx.MatMul"([[VAR_22_]], [[VAR_10_]]) : (tensor<3x5xf32>, tensor<5x5xf32>) -> tensor<3x5xf32>
-// CHECK-DAG:         [[VAR_24_:%.+]] = builtin.unrealized_conversion_cast [[VAR_23_]] : tensor<3x5xf32> to memref<3x5xf32>
+// CHECK:             [[VAR_20_:%.+]] = "onnx.MatMul"([[VAR_19_]], [[VAR_9_]]) : (tensor<3x5xf32>, tensor<5x10xf32>) -> tensor<3x10xf32>
+// CHECK-DAG:         [[VAR_21_:%.+]] = builtin.unrealized_conversion_cast [[VAR_20_]] : tensor<3x10xf32> to memref<3x10xf32>
 // CHECK-DAG:         [[RES_3_:%.+]] = memref.alloc() {{.*}}: memref<3x5xf32>
 // CHECK-DAG:         [[RES_4_:%.+]] = memref.alloc() {{.*}}: memref<3x5xf32>
 // CHECK-DAG:         [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
@@ -957,7 +932,8 @@ func.func @gru_default_backend(%arg0: tensor<1x3x2xf32>, %arg1: tensor<1x15x2xf3
 // CHECK-DAG:           [[VAR_34_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_32_1_]]#1]
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:           [[LOAD_VAR_18_MEM_:%.+]] = krnl.load [[VAR_18_]]{{.}}[[VAR_32_1_]]#0, [[VAR_34_]]{{.}} : memref<3x15xf32>
-// CHECK-DAG:           [[LOAD_VAR_24_MEM_:%.+]] = krnl.load [[VAR_24_]]{{.}}[[VAR_32_1_]]#0, [[VAR_32_1_]]#1] : memref<3x5xf32>
+// CHECK-DAG:           [[VAR_35_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_32_1_]]#1]
+// CHECK-DAG:           [[LOAD_VAR_24_MEM_:%.+]] = krnl.load [[VAR_21_]]{{.}}[[VAR_32_1_]]#0, [[VAR_35_]]{{.}} : memref<3x10xf32>
 // CHECK:               [[VAR_37_:%.+]] = arith.addf [[LOAD_VAR_18_MEM_]], [[LOAD_VAR_24_MEM_]] : f32
 // CHECK:               [[VAR_38_:%.+]] = arith.subf [[VAR_cst_0_]], [[VAR_37_]] : f32
 // CHECK:               [[VAR_39_:%.+]] = math.exp [[VAR_38_]] : f32
@@ -975,7 +951,7 @@ func.func @gru_default_backend(%arg0: tensor<1x3x2xf32>, %arg1: tensor<1x15x2xf3
 // CHECK:               [[VAR_32_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK-DAG:           [[LOAD_PARAM_0_MEM_1_:%.+]] = krnl.load [[RES_1_]]{{.}}[[VAR_32_1_]]#0, [[VAR_32_1_]]#1] : memref<3x5xf32>
 // CHECK-DAG:           [[LOAD_VAR_18_MEM_1_:%.+]] = krnl.load [[VAR_18_]]{{.}}[[VAR_32_2_]]#0, [[VAR_32_2_]]#1] : memref<3x15xf32>
-// CHECK-DAG:           [[LOAD_VAR_18_MEM_2_:%.+]] = krnl.load [[VAR_21_]]{{.}}[[VAR_32_2_]]#0, [[VAR_32_2_]]#1] : memref<3x5xf32>
+// CHECK-DAG:           [[LOAD_VAR_18_MEM_2_:%.+]] = krnl.load [[VAR_21_]]{{.}}[[VAR_32_2_]]#0, [[VAR_32_2_]]#1] : memref<3x10xf32>
 // CHECK:               [[LOAD_VAR_24_MEM_1_:%.+]] = arith.addf [[LOAD_VAR_18_MEM_1_]], [[LOAD_VAR_18_MEM_2_]] : f32
 // CHECK:               [[VAR_37_1_:%.+]] = arith.subf [[VAR_cst_0_]], [[LOAD_VAR_24_MEM_1_]] : f32
 // CHECK:               [[VAR_38_1_:%.+]] = math.exp [[VAR_37_1_]] : f32
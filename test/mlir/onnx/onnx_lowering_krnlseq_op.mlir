@@ -62,3 +62,45 @@ func.func @test_seqdealloc(%arg1: memref<?xmemref<?x3xf32>>, %arg2: index) -> in
 // CHECK:           return [[PARAM_1_]] : index
 // CHECK:         }
 }
+
+// -----
+func.func @test_seqalloc_dynamic(%arg0: index) -> memref<?xmemref<?x3xf32>>  {
+    %0 = "krnl.seqalloc"(%arg0) : (index) -> memref<?xmemref<?x3xf32>>
+    return %0 : memref<?xmemref<?x3xf32>>
+// CHECK-LABEL:  func.func @test_seqalloc_dynamic
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: index) -> memref<?xmemref<?x3xf32>> {
+// CHECK:           math.ctlz
+// CHECK:           arith.shli
+// CHECK:           [[VAR_CAP_:%.+]] = arith.maxsi
+// CHECK:           [[VAR_CAP_IDX_:%.+]] = arith.index_cast [[VAR_CAP_]] : i64 to index
+// CHECK:           [[RES_:%.+]] = memref.alloc([[VAR_CAP_IDX_]]) : memref<?xmemref<?x3xf32>>
+// CHECK:           [[VAR_SEQ_:%.+]] = memref.reinterpret_cast [[RES_]] to offset: [0], sizes: {{.}}[[PARAM_0_]]{{.}}, strides: [1] : memref<?xmemref<?x3xf32>> to memref<?xmemref<?x3xf32>>
+// CHECK:           return [[VAR_SEQ_]] : memref<?xmemref<?x3xf32>>
+}
+
+// -----
+func.func @test_seqappend(%arg0: memref<?x3xf32>, %arg1: memref<?xmemref<?x3xf32>>) -> memref<?xmemref<?x3xf32>>  {
+    %0 = "krnl.seqappend"(%arg0, %arg1) : (memref<?x3xf32>, memref<?xmemref<?x3xf32>>) -> memref<?xmemref<?x3xf32>>
+    return %0 : memref<?xmemref<?x3xf32>>
+// CHECK-LABEL:  func.func @test_seqappend
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<?x3xf32>, [[PARAM_1_:%.+]]: memref<?xmemref<?x3xf32>>) -> memref<?xmemref<?x3xf32>> {
+// CHECK:           [[VAR_LEN_:%.+]] = memref.dim [[PARAM_1_]], {{.*}} : memref<?xmemref<?x3xf32>>
+// CHECK:           math.ctlz
+// CHECK:           [[VAR_SEQ_:%.+]] = scf.if {{.*}} -> (memref<?xmemref<?x3xf32>>) {
+// CHECK:             [[VAR_EXT_:%.+]] = memref.reinterpret_cast [[PARAM_1_]] to offset: [0], sizes: {{.*}}, strides: [1] : memref<?xmemref<?x3xf32>> to memref<?xmemref<?x3xf32>>
+// CHECK:             scf.yield [[VAR_EXT_]] : memref<?xmemref<?x3xf32>>
+// CHECK:           } else {
+// CHECK:             [[VAR_BUF_:%.+]] = memref.alloc({{.*}}) : memref<?xmemref<?x3xf32>>
+// CHECK:             [[VAR_NEW_:%.+]] = memref.reinterpret_cast [[VAR_BUF_]]
+// CHECK:             scf.for [[I_0_:%.+]] = {{.*}} to [[VAR_LEN_]]
+// CHECK:               [[VAR_ELT_:%.+]] = memref.load [[PARAM_1_]]{{.}}[[I_0_]]{{.}} : memref<?xmemref<?x3xf32>>
+// CHECK:               memref.store [[VAR_ELT_]], [[VAR_NEW_]]{{.}}[[I_0_]]{{.}} : memref<?xmemref<?x3xf32>>
+// CHECK:             }
+// CHECK:             memref.dealloc [[PARAM_1_]] : memref<?xmemref<?x3xf32>>
+// CHECK:             scf.yield [[VAR_NEW_]] : memref<?xmemref<?x3xf32>>
+// CHECK:           }
+// CHECK:           memref.alloc
+// CHECK:           memref.copy [[PARAM_0_]],
+// CHECK:           memref.store {{.*}}, [[VAR_SEQ_]]{{.}}[[VAR_LEN_]]{{.}} : memref<?xmemref<?x3xf32>>
+// CHECK:           return [[VAR_SEQ_]] : memref<?xmemref<?x3xf32>>
+}
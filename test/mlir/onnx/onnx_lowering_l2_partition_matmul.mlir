@@ -0,0 +1,33 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl='enable-parallel l2-resident-cores=4' %s -split-input-file | FileCheck %s
+
+// Small product partitioned across 4 cores: each core computes a 64-column
+// slice of the output, and its 512x64 panel of B (128KB) fits in half the
+// L2 cache, so the panel stays resident for the whole product. Slices write
+// disjoint columns of the result, so there is no partial buffer or epilogue.
+func.func @test_matmul_l2_partition(%arg0: tensor<256x512xf32>, %arg1: tensor<512x256xf32>) -> tensor<256x256xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<256x512xf32>, tensor<512x256xf32>) -> tensor<256x256xf32>
+  return %0 : tensor<256x256xf32>
+
+  // CHECK-LABEL: func @test_matmul_l2_partition
+  // CHECK:       [[RES:%.+]] = memref.alloc() {{.*}} : memref<256x256xf32>
+  // CHECK:       krnl.memset [[RES]], %{{.*}} : memref<256x256xf32>
+  // CHECK:       [[SLICE_LOOP:%.+]] = krnl.define_loops 1
+  // CHECK:       krnl.parallel([[SLICE_LOOP]]) : !krnl.loop
+  // CHECK:       krnl.iterate([[SLICE_LOOP]]) with ([[SLICE_LOOP]] -> [[SLICE:%.+]] = 0 to 4){
+  // CHECK:         krnl.matmul %arg0{{\[}}%{{.*}}, %{{.*}}{{\]}}, %arg1{{\[}}%{{.*}}, %{{.*}}{{\]}}, [[RES]]{{\[}}%{{.*}}, %{{.*}}{{\]}}
+  // CHECK-NOT:   krnl.iterate
+}
+
+// -----
+
+// The per-core panel of B would be 2MB, far beyond half the L2: the
+// partitioned schedule must not trigger and the product falls through to
+// the sequential cache-tiled kernel.
+func.func @test_matmul_no_l2_partition(%arg0: tensor<256x2048xf32>, %arg1: tensor<2048x2048xf32>) -> tensor<256x2048xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<256x2048xf32>, tensor<2048x2048xf32>) -> tensor<256x2048xf32>
+  return %0 : tensor<256x2048xf32>
+
+  // CHECK-LABEL: func @test_matmul_no_l2_partition
+  // CHECK-NOT:   krnl.parallel
+  // CHECK:       krnl.matmul
+}
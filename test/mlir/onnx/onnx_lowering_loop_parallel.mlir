@@ -0,0 +1,35 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl='enable-parallel' %s -split-input-file | FileCheck %s
+
+// COM: A loop whose carried dependence is forwarded unchanged has independent
+// COM: iterations: each one only reads the carried state and writes its own
+// COM: scan output slice, so the iteration loop is marked parallel.
+func.func private @test_loop_parallel_iterations(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<1xf32>) -> (tensor<1xf32>, tensor<10x1xf32>) {
+  %0:2 = "onnx.Loop"(%arg0, %arg1, %arg2) ({
+  ^bb0(%body_arg0: tensor<i64>, %body_arg1: tensor<i1>, %body_arg2: tensor<1xf32>):
+    %1 = "onnx.Add"(%body_arg2, %body_arg2) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+    onnx.Return %body_arg1, %body_arg2, %1 : tensor<i1>, tensor<1xf32>, tensor<1xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> (tensor<1xf32>, tensor<10x1xf32>)
+  return %0#0, %0#1 : tensor<1xf32>, tensor<10x1xf32>
+
+// CHECK-LABEL:  func private @test_loop_parallel_iterations
+// CHECK:           [[LOOP_0_:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.parallel([[LOOP_0_]]) : !krnl.loop
+// CHECK:           krnl.iterate([[LOOP_0_]])
+}
+
+// -----
+
+// COM: An accumulator carried from one iteration to the next serializes the
+// COM: loop: iteration i reads what iteration i-1 wrote, so no parallel mark.
+func.func private @test_loop_serial_accumulator(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<1xi64>) -> tensor<1xi64> {
+  %0 = "onnx.Loop"(%arg0, %arg1, %arg2) ({
+  ^bb0(%body_arg0: tensor<i64>, %body_arg1: tensor<i1>, %body_arg2: tensor<1xi64>):
+    %1 = "onnx.Add"(%body_arg2, %body_arg0) : (tensor<1xi64>, tensor<i64>) -> tensor<1xi64>
+    onnx.Return %body_arg1, %1 : tensor<i1>, tensor<1xi64>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xi64>) -> tensor<1xi64>
+  return %0 : tensor<1xi64>
+
+// CHECK-LABEL:  func private @test_loop_serial_accumulator
+// CHECK-NOT:       krnl.parallel
+// CHECK:           return
+}
@@ -64,114 +64,109 @@ func.func @test_nonmaxsuppression_center_point_box_format(%arg0: tensor<1x6x4xf3
 // CHECK:           "krnl.call"([[RES_3_]], [[SCORES_]], [[CST_2_]], [[CST_0_]]) {funcName = "omTensorSort"} : (memref<1x1x6xindex>, memref<1x1x6xf32>, i64, i64) -> ()
 // CHECK:           [[RES_4_:%.+]] = memref.alloc([[LOAD_RES_MEM_1_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_4_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_5_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_5_]][] : memref<index>
-// CHECK-DAG:       [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_3_]]#0, [[LOOP_3_]]#1) with ([[LOOP_3_]]#0 -> [[I_6_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]], [[LOOP_3_]]#1 -> [[I_7_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
 // CHECK:             [[VAR_14_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_3_]]#0, [[LOOP_3_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK:             [[RES_7_:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
-// CHECK:             krnl.memset [[RES_7_]], [[VAR_false_]] : memref<6xi1>
-// CHECK:             [[LOOP_4_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_4_]]) with ([[LOOP_4_]] -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_:%.+]] = krnl.get_induction_var_value([[LOOP_4_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_14_2_]]#0, [[VAR_14_2_]]#1, [[LOAD_RES_1_MEM_1_]]{{.}} : memref<1x1x6xindex>
-// CHECK:               [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_14_2_]]#0, [[VAR_14_2_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<1x1x6xf32>
-// CHECK-DAG:           [[VAR_19_1_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_1_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_21_1_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_2_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_7_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<6xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_23_1_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_24_1_:%.+]] = arith.andi [[VAR_19_1_]], [[VAR_21_1_]] : i1
-// CHECK:               [[VAR_25_:%.+]] = arith.andi [[VAR_24_1_]], [[VAR_23_1_]] : i1
-// CHECK:               scf.if [[VAR_25_]] {
-// CHECK-DAG:             [[LOAD_BOXES_MEM_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_BOXES_MEM_1_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_BOXES_MEM_2_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_BOXES_MEM_3_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_5_MEM_:%.+]] = krnl.load [[RES_5_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_14_2_]]#0, [[RES_4_]]{{.}}[[LOAD_RES_5_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_14_2_]]#1, [[RES_4_]]{{.}}[[LOAD_RES_5_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_4_]]{{.}}[[LOAD_RES_5_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_31_:%.+]] = arith.addi [[LOAD_SCORES_MEM_2_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_31_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[VAR_32_:%.+]] = arith.addi [[LOAD_RES_5_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_32_]], [[RES_5_]][] : memref<index>
-// CHECK:                 [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:                   [[VAR_34_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_7_MEM_:%.+]] = krnl.load [[RES_7_]]{{.}}[[VAR_34_]]{{.}} : memref<6xi1>
-// CHECK:                   [[VAR_36_:%.+]] = arith.cmpi eq, [[LOAD_RES_7_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_36_]] {
-// CHECK-DAG:                 [[LOAD_BOXES_MEM_4_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[VAR_34_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_BOXES_MEM_5_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[VAR_34_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_BOXES_MEM_6_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[VAR_34_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_BOXES_MEM_7_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[VAR_34_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[VAR_41_:%.+]] = arith.divf [[LOAD_BOXES_MEM_2_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_42_:%.+]] = arith.subf [[LOAD_BOXES_MEM_]], [[VAR_41_]] : f32
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.divf [[LOAD_BOXES_MEM_2_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.addf [[LOAD_BOXES_MEM_]], [[VAR_43_]] : f32
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.divf [[LOAD_BOXES_MEM_3_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_BOXES_MEM_1_]], [[VAR_45_]] : f32
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.divf [[LOAD_BOXES_MEM_3_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.addf [[LOAD_BOXES_MEM_1_]], [[VAR_47_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.divf [[LOAD_BOXES_MEM_7_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.subf [[LOAD_BOXES_MEM_5_]], [[VAR_49_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.divf [[LOAD_BOXES_MEM_7_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.addf [[LOAD_BOXES_MEM_5_]], [[VAR_51_]] : f32
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.divf [[LOAD_BOXES_MEM_6_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.subf [[LOAD_BOXES_MEM_4_]], [[VAR_53_]] : f32
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.divf [[LOAD_BOXES_MEM_6_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.addf [[LOAD_BOXES_MEM_4_]], [[VAR_55_]] : f32
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.mulf [[LOAD_BOXES_MEM_3_]], [[LOAD_BOXES_MEM_2_]] : f32
-// CHECK-DAG:                 [[VAR_58_:%.+]] = arith.mulf [[LOAD_BOXES_MEM_7_]], [[LOAD_BOXES_MEM_6_]] : f32
-// CHECK-DAG:                 [[VAR_59_:%.+]] = arith.maxf [[VAR_42_]], [[VAR_54_]] : f32
-// CHECK-DAG:                 [[VAR_60_:%.+]] = arith.maxf [[VAR_46_]], [[VAR_50_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_61_:%.+]] = arith.minf [[VAR_44_]], [[VAR_56_]] : f32
-// CHECK-DAG:                 [[VAR_62_:%.+]] = arith.minf [[VAR_48_]], [[VAR_52_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_63_:%.+]] = arith.subf [[VAR_61_]], [[VAR_59_]] : f32
-// CHECK-DAG:                 [[VAR_64_:%.+]] = arith.subf [[VAR_62_]], [[VAR_60_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_65_:%.+]] = arith.maxf [[VAR_63_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_66_:%.+]] = arith.maxf [[VAR_64_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_67_:%.+]] = arith.mulf [[VAR_65_]], [[VAR_66_]] : f32
-// CHECK-DAG:                 [[VAR_68_:%.+]] = arith.addf [[VAR_57_]], [[VAR_58_]] : f32
-// CHECK:                     [[VAR_69_:%.+]] = arith.subf [[VAR_68_]], [[VAR_67_]] : f32
-// CHECK:                     [[VAR_70_:%.+]] = arith.addf [[VAR_69_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_71_:%.+]] = arith.divf [[VAR_67_]], [[VAR_70_]] : f32
-// CHECK:                     [[VAR_72_:%.+]] = arith.cmpf oge, [[VAR_71_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_72_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_7_]]{{.}}[[VAR_34_]]{{.}} : memref<6xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<6xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<6xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_14_2_]]#0, [[VAR_14_2_]]#1, [[F_IV]]{{.}} : memref<1x1x6xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_14_2_]]#0, [[VAR_14_2_]]#1, [[CAND_BI]]{{.}} : memref<1x1x6xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<6xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<6xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<6xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_14_2_]]#0, [[RES_4_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_14_2_]]#1, [[RES_4_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_4_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<6xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_14_2_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_5_MEM_1_:%.+]] = krnl.load [[RES_5_]][] : memref<index>
-// CHECK-DAG:       [[RES_8_:%.+]] = memref.alloc([[LOAD_RES_5_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_6_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_6_]]#0, [[LOOP_6_]]#1) with ([[LOOP_6_]]#0 -> [[I_10_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_5_MEM_1_]], [[LOOP_6_]]#1 -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_14_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_6_]]#0, [[LOOP_6_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_14_3_]]#0, [[VAR_14_3_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_4_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_8_]]{{.}}[[VAR_14_3_]]#0, [[VAR_14_3_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_4_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
+// CHECK:           }
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_4_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
 // CHECK:           }
-// CHECK:           return [[RES_8_]] : memref<?x3xi64>
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
 }
 
@@ -259,95 +254,109 @@ func.func @test_nonmaxsuppression_flipped_coordinates(%arg0: tensor<1x6x4xf32>,
 // CHECK:           }
 // CHECK:           [[RES_5_:%.+]] = memref.alloc([[LOAD_RES_MEM_1_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_5_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_7_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_4_]]#0, [[LOOP_4_]]#1) with ([[LOOP_4_]]#0 -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]], [[LOOP_4_]]#1 -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
 // CHECK:             [[VAR_15_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_7_]][] : memref<index>
-// CHECK:             [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
-// CHECK:             krnl.memset [[RES_8_]], [[VAR_false_]] : memref<6xi1>
-// CHECK:             [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_10_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_1_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_1_MEM_1_1_]]{{.}} : memref<1x1x6xindex>
-// CHECK:               [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<1x1x6xf32>
-// CHECK-DAG:           [[VAR_20_2_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_2_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[RES_7_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_22_2_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_1_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_8_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<6xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_24_2_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_25_2_:%.+]] = arith.andi [[VAR_20_2_]], [[VAR_22_2_]] : i1
-// CHECK:               [[VAR_26_:%.+]] = arith.andi [[VAR_25_2_]], [[VAR_24_2_]] : i1
-// CHECK:               scf.if [[VAR_26_]] {
-// CHECK-DAG:             [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_6_MEM_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_32_:%.+]] = arith.addi [[LOAD_SCORES_MEM_1_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_32_]], [[RES_7_]][] : memref<index>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_RES_6_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[LOOP_6_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_6_]]) with ([[LOOP_6_]] -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:                   [[VAR_35_:%.+]] = krnl.get_induction_var_value([[LOOP_6_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_8_MEM_:%.+]] = krnl.load [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<6xi1>
-// CHECK:                   [[VAR_37_:%.+]] = arith.cmpi eq, [[LOAD_RES_8_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_37_]] {
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_5_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_6_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_7_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[VAR_42_:%.+]] = arith.subf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_]] : f32
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.subf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_1_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.mulf [[VAR_42_]], [[VAR_43_]] : f32
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.subf [[LOAD_RES_4_MEM_6_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_RES_4_MEM_7_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.mulf [[VAR_45_]], [[VAR_46_]] : f32
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_1_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.minf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_7_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.minf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_6_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.subf [[VAR_50_]], [[VAR_48_]] : f32
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.subf [[VAR_51_]], [[VAR_49_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.maxf [[VAR_52_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.maxf [[VAR_53_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.mulf [[VAR_54_]], [[VAR_55_]] : f32
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.addf [[VAR_44_]], [[VAR_47_]] : f32
-// CHECK:                     [[VAR_58_:%.+]] = arith.subf [[VAR_57_]], [[VAR_56_]] : f32
-// CHECK:                     [[VAR_59_:%.+]] = arith.addf [[VAR_58_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_60_:%.+]] = arith.divf [[VAR_56_]], [[VAR_59_]] : f32
-// CHECK:                     [[VAR_61_:%.+]] = arith.cmpf oge, [[VAR_60_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_61_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<6xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<6xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<6xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[F_IV]]{{.}} : memref<1x1x6xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[CAND_BI]]{{.}} : memref<1x1x6xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<6xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<6xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<6xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<6xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_6_MEM_1_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_9_:%.+]] = memref.alloc([[LOAD_RES_6_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_7_]]#0, [[LOOP_7_]]#1) with ([[LOOP_7_]]#0 -> [[I_12_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_6_MEM_1_]], [[LOOP_7_]]#1 -> [[I_13_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_15_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_7_]]#0, [[LOOP_7_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_5_:%.+]] = krnl.load [[RES_5_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_5_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_9_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
+// CHECK:           }
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
 // CHECK:           }
-// CHECK:           return [[RES_9_]] : memref<?x3xi64>
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
 }
 
@@ -435,95 +444,109 @@ func.func @test_nonmaxsuppression_identical_boxes(%arg0: tensor<1x10x4xf32>, %ar
 // CHECK:           }
 // CHECK:           [[RES_5_:%.+]] = memref.alloc([[LOAD_RES_MEM_1_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_5_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_7_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_4_]]#0, [[LOOP_4_]]#1) with ([[LOOP_4_]]#0 -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]], [[LOOP_4_]]#1 -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
 // CHECK:             [[VAR_15_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_7_]][] : memref<index>
-// CHECK:             [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<10xi1>
-// CHECK:             krnl.memset [[RES_8_]], [[VAR_false_]] : memref<10xi1>
-// CHECK:             [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_10_:%.+]] = [[CST_0_1_]] to [[CST_10_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_1_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_1_MEM_1_1_]]{{.}} : memref<1x1x10xindex>
-// CHECK:               [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<1x1x10xf32>
-// CHECK-DAG:           [[VAR_20_2_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_2_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[RES_7_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_22_2_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_1_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_8_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<10xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_24_2_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_25_2_:%.+]] = arith.andi [[VAR_20_2_]], [[VAR_22_2_]] : i1
-// CHECK:               [[VAR_26_:%.+]] = arith.andi [[VAR_25_2_]], [[VAR_24_2_]] : i1
-// CHECK:               scf.if [[VAR_26_]] {
-// CHECK-DAG:             [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<1x10x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<1x10x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<1x10x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<1x10x4xf32>
-// CHECK-DAG:             [[LOAD_RES_6_MEM_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_32_:%.+]] = arith.addi [[LOAD_SCORES_MEM_1_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_32_]], [[RES_7_]][] : memref<index>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_RES_6_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[LOOP_6_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_6_]]) with ([[LOOP_6_]] -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_10_]]){
-// CHECK:                   [[VAR_35_:%.+]] = krnl.get_induction_var_value([[LOOP_6_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_8_MEM_:%.+]] = krnl.load [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<10xi1>
-// CHECK:                   [[VAR_37_:%.+]] = arith.cmpi eq, [[LOAD_RES_8_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_37_]] {
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_0_1_]]{{.}} : memref<1x10x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_5_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_1_1_]]{{.}} : memref<1x10x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_6_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_2_1_]]{{.}} : memref<1x10x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_7_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_3_]]{{.}} : memref<1x10x4xf32>
-// CHECK-DAG:                 [[VAR_42_:%.+]] = arith.subf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_]] : f32
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.subf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_1_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.mulf [[VAR_42_]], [[VAR_43_]] : f32
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.subf [[LOAD_RES_4_MEM_6_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_RES_4_MEM_7_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.mulf [[VAR_45_]], [[VAR_46_]] : f32
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_1_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.minf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_7_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.minf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_6_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.subf [[VAR_50_]], [[VAR_48_]] : f32
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.subf [[VAR_51_]], [[VAR_49_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.maxf [[VAR_52_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.maxf [[VAR_53_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.mulf [[VAR_54_]], [[VAR_55_]] : f32
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.addf [[VAR_44_]], [[VAR_47_]] : f32
-// CHECK:                     [[VAR_58_:%.+]] = arith.subf [[VAR_57_]], [[VAR_56_]] : f32
-// CHECK:                     [[VAR_59_:%.+]] = arith.addf [[VAR_58_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_60_:%.+]] = arith.divf [[VAR_56_]], [[VAR_59_]] : f32
-// CHECK:                     [[VAR_61_:%.+]] = arith.cmpf oge, [[VAR_60_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_61_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<10xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<10xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<10xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<10xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_10_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[F_IV]]{{.}} : memref<1x1x10xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[CAND_BI]]{{.}} : memref<1x1x10xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<10xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<10xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<10xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<1x10x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<1x10x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<1x10x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<1x10x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<10xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<10xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<1x10x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<1x10x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<1x10x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<1x10x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<10xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_6_MEM_1_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_9_:%.+]] = memref.alloc([[LOAD_RES_6_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_7_]]#0, [[LOOP_7_]]#1) with ([[LOOP_7_]]#0 -> [[I_12_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_6_MEM_1_]], [[LOOP_7_]]#1 -> [[I_13_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_15_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_7_]]#0, [[LOOP_7_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_5_:%.+]] = krnl.load [[RES_5_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_5_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_9_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
+// CHECK:           }
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
 // CHECK:           }
-// CHECK:           return [[RES_9_]] : memref<?x3xi64>
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
 }
 
@@ -611,95 +634,109 @@ func.func @test_nonmaxsuppression_limit_output_size(%arg0: tensor<1x6x4xf32>, %a
 // CHECK:           }
 // CHECK:           [[RES_5_:%.+]] = memref.alloc([[LOAD_RES_MEM_1_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_5_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_7_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_4_]]#0, [[LOOP_4_]]#1) with ([[LOOP_4_]]#0 -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]], [[LOOP_4_]]#1 -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
 // CHECK:             [[VAR_15_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_7_]][] : memref<index>
-// CHECK:             [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
-// CHECK:             krnl.memset [[RES_8_]], [[VAR_false_]] : memref<6xi1>
-// CHECK:             [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_10_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_1_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_1_MEM_1_1_]]{{.}} : memref<1x1x6xindex>
-// CHECK:               [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<1x1x6xf32>
-// CHECK-DAG:           [[VAR_20_2_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_2_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[RES_7_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_22_2_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_1_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_8_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<6xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_24_2_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_25_2_:%.+]] = arith.andi [[VAR_20_2_]], [[VAR_22_2_]] : i1
-// CHECK:               [[VAR_26_:%.+]] = arith.andi [[VAR_25_2_]], [[VAR_24_2_]] : i1
-// CHECK:               scf.if [[VAR_26_]] {
-// CHECK-DAG:             [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_6_MEM_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_32_:%.+]] = arith.addi [[LOAD_SCORES_MEM_1_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_32_]], [[RES_7_]][] : memref<index>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_RES_6_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[LOOP_6_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_6_]]) with ([[LOOP_6_]] -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:                   [[VAR_35_:%.+]] = krnl.get_induction_var_value([[LOOP_6_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_8_MEM_:%.+]] = krnl.load [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<6xi1>
-// CHECK:                   [[VAR_37_:%.+]] = arith.cmpi eq, [[LOAD_RES_8_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_37_]] {
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_5_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_6_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_7_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[VAR_42_:%.+]] = arith.subf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_]] : f32
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.subf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_1_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.mulf [[VAR_42_]], [[VAR_43_]] : f32
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.subf [[LOAD_RES_4_MEM_6_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_RES_4_MEM_7_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.mulf [[VAR_45_]], [[VAR_46_]] : f32
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_1_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.minf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_7_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.minf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_6_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.subf [[VAR_50_]], [[VAR_48_]] : f32
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.subf [[VAR_51_]], [[VAR_49_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.maxf [[VAR_52_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.maxf [[VAR_53_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.mulf [[VAR_54_]], [[VAR_55_]] : f32
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.addf [[VAR_44_]], [[VAR_47_]] : f32
-// CHECK:                     [[VAR_58_:%.+]] = arith.subf [[VAR_57_]], [[VAR_56_]] : f32
-// CHECK:                     [[VAR_59_:%.+]] = arith.addf [[VAR_58_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_60_:%.+]] = arith.divf [[VAR_56_]], [[VAR_59_]] : f32
-// CHECK:                     [[VAR_61_:%.+]] = arith.cmpf oge, [[VAR_60_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_61_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<6xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<6xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<6xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[F_IV]]{{.}} : memref<1x1x6xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[CAND_BI]]{{.}} : memref<1x1x6xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<6xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<6xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<6xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<6xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_6_MEM_1_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_9_:%.+]] = memref.alloc([[LOAD_RES_6_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_7_]]#0, [[LOOP_7_]]#1) with ([[LOOP_7_]]#0 -> [[I_12_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_6_MEM_1_]], [[LOOP_7_]]#1 -> [[I_13_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_15_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_7_]]#0, [[LOOP_7_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_5_:%.+]] = krnl.load [[RES_5_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_5_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_9_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
 // CHECK:           }
-// CHECK:           return [[RES_9_]] : memref<?x3xi64>
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
+// CHECK:           }
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
 }
 
@@ -786,95 +823,109 @@ func.func @test_nonmaxsuppression_single_box(%arg0: tensor<1x1x4xf32>, %arg1: te
 // CHECK:           }
 // CHECK:           [[RES_5_:%.+]] = memref.alloc([[LOAD_RES_MEM_1_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_5_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_7_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_4_]]#0, [[LOOP_4_]]#1) with ([[LOOP_4_]]#0 -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]], [[LOOP_4_]]#1 -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
 // CHECK:             [[VAR_15_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_7_]][] : memref<index>
-// CHECK:             [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<1xi1>
-// CHECK:             krnl.memset [[RES_8_]], [[VAR_false_]] : memref<1xi1>
-// CHECK:             [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_10_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_1_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_1_MEM_1_1_]]{{.}} : memref<1x1x1xindex>
-// CHECK:               [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<1x1x1xf32>
-// CHECK-DAG:           [[VAR_20_2_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_2_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[RES_7_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_22_2_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_1_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_8_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<1xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_24_2_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_25_2_:%.+]] = arith.andi [[VAR_20_2_]], [[VAR_22_2_]] : i1
-// CHECK:               [[VAR_26_:%.+]] = arith.andi [[VAR_25_2_]], [[VAR_24_2_]] : i1
-// CHECK:               scf.if [[VAR_26_]] {
-// CHECK-DAG:             [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<1x1x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<1x1x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<1x1x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<1x1x4xf32>
-// CHECK-DAG:             [[LOAD_RES_6_MEM_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_32_:%.+]] = arith.addi [[LOAD_SCORES_MEM_1_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_32_]], [[RES_7_]][] : memref<index>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_RES_6_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[LOOP_6_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_6_]]) with ([[LOOP_6_]] -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
-// CHECK:                   [[VAR_35_:%.+]] = krnl.get_induction_var_value([[LOOP_6_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_8_MEM_:%.+]] = krnl.load [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<1xi1>
-// CHECK:                   [[VAR_37_:%.+]] = arith.cmpi eq, [[LOAD_RES_8_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_37_]] {
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_0_1_]]{{.}} : memref<1x1x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_5_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_1_1_]]{{.}} : memref<1x1x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_6_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_2_1_]]{{.}} : memref<1x1x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_7_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_3_]]{{.}} : memref<1x1x4xf32>
-// CHECK-DAG:                 [[VAR_42_:%.+]] = arith.subf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_]] : f32
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.subf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_1_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.mulf [[VAR_42_]], [[VAR_43_]] : f32
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.subf [[LOAD_RES_4_MEM_6_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_RES_4_MEM_7_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.mulf [[VAR_45_]], [[VAR_46_]] : f32
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_1_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.minf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_7_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.minf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_6_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.subf [[VAR_50_]], [[VAR_48_]] : f32
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.subf [[VAR_51_]], [[VAR_49_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.maxf [[VAR_52_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.maxf [[VAR_53_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.mulf [[VAR_54_]], [[VAR_55_]] : f32
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.addf [[VAR_44_]], [[VAR_47_]] : f32
-// CHECK:                     [[VAR_58_:%.+]] = arith.subf [[VAR_57_]], [[VAR_56_]] : f32
-// CHECK:                     [[VAR_59_:%.+]] = arith.addf [[VAR_58_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_60_:%.+]] = arith.divf [[VAR_56_]], [[VAR_59_]] : f32
-// CHECK:                     [[VAR_61_:%.+]] = arith.cmpf oge, [[VAR_60_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_61_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<1xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<1xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<1xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<1xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[F_IV]]{{.}} : memref<1x1x1xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[CAND_BI]]{{.}} : memref<1x1x1xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<1xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<1xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<1xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<1x1x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<1x1x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<1x1x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<1x1x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<1xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<1xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<1x1x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<1x1x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<1x1x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<1x1x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<1xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_6_MEM_1_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_9_:%.+]] = memref.alloc([[LOAD_RES_6_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_7_]]#0, [[LOOP_7_]]#1) with ([[LOOP_7_]]#0 -> [[I_12_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_6_MEM_1_]], [[LOOP_7_]]#1 -> [[I_13_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_15_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_7_]]#0, [[LOOP_7_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_5_:%.+]] = krnl.load [[RES_5_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_5_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_9_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
+// CHECK:           }
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
 // CHECK:           }
-// CHECK:           return [[RES_9_]] : memref<?x3xi64>
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
 }
 
@@ -962,95 +1013,109 @@ func.func @test_nonmaxsuppression_suppress_by_IOU(%arg0: tensor<1x6x4xf32>, %arg
 // CHECK:           }
 // CHECK:           [[RES_5_:%.+]] = memref.alloc([[LOAD_RES_MEM_1_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_5_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_7_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_4_]]#0, [[LOOP_4_]]#1) with ([[LOOP_4_]]#0 -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]], [[LOOP_4_]]#1 -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
 // CHECK:             [[VAR_15_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_7_]][] : memref<index>
-// CHECK:             [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
-// CHECK:             krnl.memset [[RES_8_]], [[VAR_false_]] : memref<6xi1>
-// CHECK:             [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_10_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_1_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_1_MEM_1_1_]]{{.}} : memref<1x1x6xindex>
-// CHECK:               [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<1x1x6xf32>
-// CHECK-DAG:           [[VAR_20_2_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_2_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[RES_7_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_22_2_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_1_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_8_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<6xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_24_2_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_25_2_:%.+]] = arith.andi [[VAR_20_2_]], [[VAR_22_2_]] : i1
-// CHECK:               [[VAR_26_:%.+]] = arith.andi [[VAR_25_2_]], [[VAR_24_2_]] : i1
-// CHECK:               scf.if [[VAR_26_]] {
-// CHECK-DAG:             [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_6_MEM_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_32_:%.+]] = arith.addi [[LOAD_SCORES_MEM_1_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_32_]], [[RES_7_]][] : memref<index>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_RES_6_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[LOOP_6_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_6_]]) with ([[LOOP_6_]] -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:                   [[VAR_35_:%.+]] = krnl.get_induction_var_value([[LOOP_6_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_8_MEM_:%.+]] = krnl.load [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<6xi1>
-// CHECK:                   [[VAR_37_:%.+]] = arith.cmpi eq, [[LOAD_RES_8_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_37_]] {
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_5_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_6_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_7_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[VAR_42_:%.+]] = arith.subf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_]] : f32
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.subf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_1_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.mulf [[VAR_42_]], [[VAR_43_]] : f32
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.subf [[LOAD_RES_4_MEM_6_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_RES_4_MEM_7_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.mulf [[VAR_45_]], [[VAR_46_]] : f32
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_1_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.minf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_7_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.minf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_6_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.subf [[VAR_50_]], [[VAR_48_]] : f32
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.subf [[VAR_51_]], [[VAR_49_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.maxf [[VAR_52_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.maxf [[VAR_53_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.mulf [[VAR_54_]], [[VAR_55_]] : f32
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.addf [[VAR_44_]], [[VAR_47_]] : f32
-// CHECK:                     [[VAR_58_:%.+]] = arith.subf [[VAR_57_]], [[VAR_56_]] : f32
-// CHECK:                     [[VAR_59_:%.+]] = arith.addf [[VAR_58_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_60_:%.+]] = arith.divf [[VAR_56_]], [[VAR_59_]] : f32
-// CHECK:                     [[VAR_61_:%.+]] = arith.cmpf oge, [[VAR_60_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_61_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<6xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<6xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<6xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[F_IV]]{{.}} : memref<1x1x6xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[CAND_BI]]{{.}} : memref<1x1x6xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<6xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<6xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<6xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<6xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_6_MEM_1_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_9_:%.+]] = memref.alloc([[LOAD_RES_6_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_7_]]#0, [[LOOP_7_]]#1) with ([[LOOP_7_]]#0 -> [[I_12_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_6_MEM_1_]], [[LOOP_7_]]#1 -> [[I_13_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_15_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_7_]]#0, [[LOOP_7_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_5_:%.+]] = krnl.load [[RES_5_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_5_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_9_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
 // CHECK:           }
-// CHECK:           return [[RES_9_]] : memref<?x3xi64>
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
+// CHECK:           }
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
 }
 
@@ -1138,104 +1203,110 @@ func.func @test_nonmaxsuppression_suppress_by_IOU_and_scores(%arg0: tensor<1x6x4
 // CHECK:           }
 // CHECK:           [[RES_5_:%.+]] = memref.alloc([[LOAD_RES_MEM_1_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_5_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_7_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_4_]]#0, [[LOOP_4_]]#1) with ([[LOOP_4_]]#0 -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]], [[LOOP_4_]]#1 -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
 // CHECK:             [[VAR_15_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_7_]][] : memref<index>
-// CHECK:             [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
-// CHECK:             krnl.memset [[RES_8_]], [[VAR_false_]] : memref<6xi1>
-// CHECK:             [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_10_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_1_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_1_MEM_1_1_]]{{.}} : memref<1x1x6xindex>
-// CHECK:               [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<1x1x6xf32>
-// CHECK-DAG:           [[VAR_20_2_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_2_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[RES_7_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_22_2_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_1_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_8_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<6xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_24_2_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_25_2_:%.+]] = arith.andi [[VAR_20_2_]], [[VAR_22_2_]] : i1
-// CHECK:               [[VAR_26_:%.+]] = arith.andi [[VAR_25_2_]], [[VAR_24_2_]] : i1
-// CHECK:               scf.if [[VAR_26_]] {
-// CHECK-DAG:             [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_6_MEM_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_32_:%.+]] = arith.addi [[LOAD_SCORES_MEM_1_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_32_]], [[RES_7_]][] : memref<index>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_RES_6_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[LOOP_6_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_6_]]) with ([[LOOP_6_]] -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:                   [[VAR_35_:%.+]] = krnl.get_induction_var_value([[LOOP_6_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_8_MEM_:%.+]] = krnl.load [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<6xi1>
-// CHECK:                   [[VAR_37_:%.+]] = arith.cmpi eq, [[LOAD_RES_8_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_37_]] {
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_5_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_6_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_7_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[VAR_35_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[VAR_42_:%.+]] = arith.subf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_]] : f32
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.subf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_1_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.mulf [[VAR_42_]], [[VAR_43_]] : f32
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.subf [[LOAD_RES_4_MEM_6_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_RES_4_MEM_7_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.mulf [[VAR_45_]], [[VAR_46_]] : f32
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_1_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.minf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_7_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.minf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_6_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.subf [[VAR_50_]], [[VAR_48_]] : f32
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.subf [[VAR_51_]], [[VAR_49_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.maxf [[VAR_52_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.maxf [[VAR_53_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.mulf [[VAR_54_]], [[VAR_55_]] : f32
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.addf [[VAR_44_]], [[VAR_47_]] : f32
-// CHECK:                     [[VAR_58_:%.+]] = arith.subf [[VAR_57_]], [[VAR_56_]] : f32
-// CHECK:                     [[VAR_59_:%.+]] = arith.addf [[VAR_58_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_60_:%.+]] = arith.divf [[VAR_56_]], [[VAR_59_]] : f32
-// CHECK:                     [[VAR_61_:%.+]] = arith.cmpf oge, [[VAR_60_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_61_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_8_]]{{.}}[[VAR_35_]]{{.}} : memref<6xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<6xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<6xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[F_IV]]{{.}} : memref<1x1x6xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_15_3_]]#0, [[VAR_15_3_]]#1, [[CAND_BI]]{{.}} : memref<1x1x6xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<6xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<6xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<6xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_15_3_]]#0, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_15_3_]]#1, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<6xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_15_3_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_6_MEM_1_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_9_:%.+]] = memref.alloc([[LOAD_RES_6_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_7_]]#0, [[LOOP_7_]]#1) with ([[LOOP_7_]]#0 -> [[I_12_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_6_MEM_1_]], [[LOOP_7_]]#1 -> [[I_13_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_15_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_7_]]#0, [[LOOP_7_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_5_:%.+]] = krnl.load [[RES_5_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_5_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_9_]]{{.}}[[VAR_15_4_]]#0, [[VAR_15_4_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
 // CHECK:           }
-// CHECK:           return [[RES_9_]] : memref<?x3xi64>
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[LOAD_RES_MEM_1_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
+// CHECK:           }
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
-}
-
-// -----
-
-func.func @test_nonmaxsuppression_two_batches(%arg0: tensor<2x6x4xf32>, %arg1: tensor<2x1x6xf32>, %arg2: tensor<1xi64>, %arg3: tensor<1xf32>, %arg4: tensor<1xf32>) -> tensor<?x3xi64> attributes {input_names = ["boxes", "scores", "max_output_boxes_per_class", "iou_threshold", "score_threshold"], output_names = ["selected_indices"]} {
-  %0 = "onnx.NonMaxSuppression"(%arg0, %arg1, %arg2, %arg3, %arg4) : (tensor<2x6x4xf32>, tensor<2x1x6xf32>, tensor<1xi64>, tensor<1xf32>, tensor<1xf32>) -> tensor<?x3xi64>
-  return %0 : tensor<?x3xi64>
-
 // CHECK-DAG:   [[MAP_0_:#.+]] = affine_map<()[s0] -> (s0 * 2)>
 // CHECK-LABEL:  func @test_nonmaxsuppression_two_batches
 // CHECK-SAME:   ([[BOXES_:%.+]]: memref<2x6x4xf32>, [[SCORES_:%.+]]: memref<2x1x6xf32>, [[MAX_OUTPUT_BOXES_PER_CLASS_:%.+]]: memref<1xi64>, [[IOU_THRESHOLD_:%.+]]: memref<1xf32>, [[SCORE_THRESHOLD_:%.+]]: memref<1xf32>) -> memref<?x3xi64> attributes {input_names = ["boxes", "scores", "max_output_boxes_per_class", "iou_threshold", "score_threshold"], output_names = ["selected_indices"]} {
@@ -1316,104 +1387,110 @@ func.func @test_nonmaxsuppression_two_batches(%arg0: tensor<2x6x4xf32>, %arg1: t
 // CHECK:           [[VAR_12_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[LOAD_RES_MEM_1_]]{{.}}
 // CHECK:           [[RES_5_:%.+]] = memref.alloc([[VAR_12_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_5_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_7_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_4_]]#0, [[LOOP_4_]]#1) with ([[LOOP_4_]]#0 -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_2_1_]], [[LOOP_4_]]#1 -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]]){
 // CHECK:             [[VAR_16_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_7_]][] : memref<index>
-// CHECK:             [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
-// CHECK:             krnl.memset [[RES_8_]], [[VAR_false_]] : memref<6xi1>
-// CHECK:             [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_10_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_1_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1, [[LOAD_RES_1_MEM_1_1_]]{{.}} : memref<2x1x6xindex>
-// CHECK:               [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<2x1x6xf32>
-// CHECK-DAG:           [[VAR_21_2_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_2_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[RES_7_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_23_2_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_1_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_8_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<6xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_25_2_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_26_2_:%.+]] = arith.andi [[VAR_21_2_]], [[VAR_23_2_]] : i1
-// CHECK:               [[VAR_27_:%.+]] = arith.andi [[VAR_26_2_]], [[VAR_25_2_]] : i1
-// CHECK:               scf.if [[VAR_27_]] {
-// CHECK-DAG:             [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<2x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<2x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<2x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<2x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_6_MEM_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_16_3_]]#0, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_16_3_]]#1, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_SCORES_MEM_1_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_7_]][] : memref<index>
-// CHECK:                 [[VAR_34_:%.+]] = arith.addi [[LOAD_RES_6_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_34_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[LOOP_6_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_6_]]) with ([[LOOP_6_]] -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:                   [[VAR_36_:%.+]] = krnl.get_induction_var_value([[LOOP_6_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_8_MEM_:%.+]] = krnl.load [[RES_8_]]{{.}}[[VAR_36_]]{{.}} : memref<6xi1>
-// CHECK:                   [[VAR_38_:%.+]] = arith.cmpi eq, [[LOAD_RES_8_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_38_]] {
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_36_]], [[CST_0_1_]]{{.}} : memref<2x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_5_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_36_]], [[CST_1_1_]]{{.}} : memref<2x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_6_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_36_]], [[CST_2_1_]]{{.}} : memref<2x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_7_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_36_]], [[CST_3_]]{{.}} : memref<2x6x4xf32>
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.subf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_]] : f32
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.subf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_1_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.mulf [[VAR_43_]], [[VAR_44_]] : f32
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_RES_4_MEM_6_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.subf [[LOAD_RES_4_MEM_7_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.mulf [[VAR_46_]], [[VAR_47_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_1_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.minf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_7_]] : f32
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.minf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_6_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.subf [[VAR_51_]], [[VAR_49_]] : f32
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.subf [[VAR_52_]], [[VAR_50_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.maxf [[VAR_53_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.maxf [[VAR_54_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.mulf [[VAR_55_]], [[VAR_56_]] : f32
-// CHECK-DAG:                 [[VAR_58_:%.+]] = arith.addf [[VAR_45_]], [[VAR_48_]] : f32
-// CHECK:                     [[VAR_59_:%.+]] = arith.subf [[VAR_58_]], [[VAR_57_]] : f32
-// CHECK:                     [[VAR_60_:%.+]] = arith.addf [[VAR_59_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_61_:%.+]] = arith.divf [[VAR_57_]], [[VAR_60_]] : f32
-// CHECK:                     [[VAR_62_:%.+]] = arith.cmpf oge, [[VAR_61_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_62_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_8_]]{{.}}[[VAR_36_]]{{.}} : memref<6xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<6xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<6xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1, [[F_IV]]{{.}} : memref<2x1x6xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1, [[CAND_BI]]{{.}} : memref<2x1x6xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<6xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<6xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<6xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<2x6x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<2x6x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<2x6x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<2x6x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_16_3_]]#0, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_16_3_]]#1, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<6xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<2x6x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<2x6x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<2x6x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<2x6x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_6_MEM_1_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_9_:%.+]] = memref.alloc([[LOAD_RES_6_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_7_]]#0, [[LOOP_7_]]#1) with ([[LOOP_7_]]#0 -> [[I_12_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_6_MEM_1_]], [[LOOP_7_]]#1 -> [[I_13_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_16_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_7_]]#0, [[LOOP_7_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_5_:%.+]] = krnl.load [[RES_5_]]{{.}}[[VAR_16_4_]]#0, [[VAR_16_4_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_5_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_9_]]{{.}}[[VAR_16_4_]]#0, [[VAR_16_4_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[VAR_12_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
+// CHECK:           }
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[VAR_12_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
 // CHECK:           }
-// CHECK:           return [[RES_9_]] : memref<?x3xi64>
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
-}
-
-// -----
-
-func.func @test_nonmaxsuppression_two_classes(%arg0: tensor<1x6x4xf32>, %arg1: tensor<1x2x6xf32>, %arg2: tensor<1xi64>, %arg3: tensor<1xf32>, %arg4: tensor<1xf32>) -> tensor<?x3xi64> attributes {input_names = ["boxes", "scores", "max_output_boxes_per_class", "iou_threshold", "score_threshold"], output_names = ["selected_indices"]} {
-  %0 = "onnx.NonMaxSuppression"(%arg0, %arg1, %arg2, %arg3, %arg4) : (tensor<1x6x4xf32>, tensor<1x2x6xf32>, tensor<1xi64>, tensor<1xf32>, tensor<1xf32>) -> tensor<?x3xi64>
-  return %0 : tensor<?x3xi64>
-
 // CHECK-DAG:   [[MAP_0_:#.+]] = affine_map<()[s0] -> (s0 * 2)>
 // CHECK-LABEL:  func.func @test_nonmaxsuppression_two_classes
 // CHECK-SAME:   ([[BOXES_:%.+]]: memref<1x6x4xf32>, [[SCORES_:%.+]]: memref<1x2x6xf32>, [[MAX_OUTPUT_BOXES_PER_CLASS_:%.+]]: memref<1xi64>, [[IOU_THRESHOLD_:%.+]]: memref<1xf32>, [[SCORE_THRESHOLD_:%.+]]: memref<1xf32>) -> memref<?x3xi64> attributes {input_names = ["boxes", "scores", "max_output_boxes_per_class", "iou_threshold", "score_threshold"], output_names = ["selected_indices"]} {
@@ -1494,104 +1571,110 @@ func.func @test_nonmaxsuppression_two_classes(%arg0: tensor<1x6x4xf32>, %arg1: t
 // CHECK:           [[VAR_12_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[LOAD_RES_MEM_1_]]{{.}}
 // CHECK:           [[RES_5_:%.+]] = memref.alloc([[VAR_12_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_5_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_7_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_4_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_4_]]#0, [[LOOP_4_]]#1) with ([[LOOP_4_]]#0 -> [[I_8_:%.+]] = [[CST_0_1_]] to [[CST_1_1_]], [[LOOP_4_]]#1 -> [[I_9_:%.+]] = [[CST_0_1_]] to [[CST_2_1_]]){
 // CHECK:             [[VAR_16_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_4_]]#0, [[LOOP_4_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_7_]][] : memref<index>
-// CHECK:             [[RES_8_:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
-// CHECK:             krnl.memset [[RES_8_]], [[VAR_false_]] : memref<6xi1>
-// CHECK:             [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_10_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_1_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1, [[LOAD_RES_1_MEM_1_1_]]{{.}} : memref<1x2x6xindex>
-// CHECK:               [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<1x2x6xf32>
-// CHECK-DAG:           [[VAR_21_2_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_2_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[RES_7_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_23_2_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_1_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_8_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<6xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_25_2_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_26_2_:%.+]] = arith.andi [[VAR_21_2_]], [[VAR_23_2_]] : i1
-// CHECK:               [[VAR_27_:%.+]] = arith.andi [[VAR_26_2_]], [[VAR_25_2_]] : i1
-// CHECK:               scf.if [[VAR_27_]] {
-// CHECK-DAG:             [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_4_MEM_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:             [[LOAD_RES_6_MEM_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_16_3_]]#0, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_16_3_]]#1, [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_5_]]{{.}}[[LOAD_RES_6_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_SCORES_MEM_1_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_7_]][] : memref<index>
-// CHECK:                 [[VAR_34_:%.+]] = arith.addi [[LOAD_RES_6_MEM_]], [[CST_1_1_]] : index
-// CHECK:                 krnl.store [[VAR_34_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[LOOP_6_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_6_]]) with ([[LOOP_6_]] -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
-// CHECK:                   [[VAR_36_:%.+]] = krnl.get_induction_var_value([[LOOP_6_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_8_MEM_:%.+]] = krnl.load [[RES_8_]]{{.}}[[VAR_36_]]{{.}} : memref<6xi1>
-// CHECK:                   [[VAR_38_:%.+]] = arith.cmpi eq, [[LOAD_RES_8_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_38_]] {
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_36_]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_5_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_36_]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_6_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_36_]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[LOAD_RES_4_MEM_7_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_36_]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.subf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_]] : f32
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.subf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_1_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.mulf [[VAR_43_]], [[VAR_44_]] : f32
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.subf [[LOAD_RES_4_MEM_6_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.subf [[LOAD_RES_4_MEM_7_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.mulf [[VAR_46_]], [[VAR_47_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_1_]], [[LOAD_RES_4_MEM_5_]] : f32
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.maxf [[LOAD_RES_4_MEM_]], [[LOAD_RES_4_MEM_4_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.minf [[LOAD_RES_4_MEM_3_]], [[LOAD_RES_4_MEM_7_]] : f32
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.minf [[LOAD_RES_4_MEM_2_]], [[LOAD_RES_4_MEM_6_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.subf [[VAR_51_]], [[VAR_49_]] : f32
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.subf [[VAR_52_]], [[VAR_50_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.maxf [[VAR_53_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.maxf [[VAR_54_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.mulf [[VAR_55_]], [[VAR_56_]] : f32
-// CHECK-DAG:                 [[VAR_58_:%.+]] = arith.addf [[VAR_45_]], [[VAR_48_]] : f32
-// CHECK:                     [[VAR_59_:%.+]] = arith.subf [[VAR_58_]], [[VAR_57_]] : f32
-// CHECK:                     [[VAR_60_:%.+]] = arith.addf [[VAR_59_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_61_:%.+]] = arith.divf [[VAR_57_]], [[VAR_60_]] : f32
-// CHECK:                     [[VAR_62_:%.+]] = arith.cmpf oge, [[VAR_61_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_62_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_8_]]{{.}}[[VAR_36_]]{{.}} : memref<6xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc() {{.*}}: memref<6xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<6xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc() {{.*}}: memref<6xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[CST_6_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1, [[F_IV]]{{.}} : memref<1x2x6xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1, [[CAND_BI]]{{.}} : memref<1x2x6xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<6xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<6xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<6xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[SELECTED_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_16_3_]]#0, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_16_3_]]#1, [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_5_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<6xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[OTHER_BI]], [[CST_1_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<1x6x4xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<6xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_6_MEM_1_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-DAG:       [[RES_9_:%.+]] = memref.alloc([[LOAD_RES_6_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_7_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_7_]]#0, [[LOOP_7_]]#1) with ([[LOOP_7_]]#0 -> [[I_12_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_6_MEM_1_]], [[LOOP_7_]]#1 -> [[I_13_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_16_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_7_]]#0, [[LOOP_7_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_5_:%.+]] = krnl.load [[RES_5_]]{{.}}[[VAR_16_4_]]#0, [[VAR_16_4_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_5_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_9_]]{{.}}[[VAR_16_4_]]#0, [[VAR_16_4_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[VAR_12_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
 // CHECK:           }
-// CHECK:           return [[RES_9_]] : memref<?x3xi64>
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[VAR_12_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_1_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_5_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
+// CHECK:           }
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
-}
-
-// -----
-
-func.func @test_nonmaxsuppression_unknown_dims(%arg0: tensor<?x?x?xf32>, %arg1: tensor<?x?x?xf32>, %arg2: tensor<1xi64>, %arg3: tensor<1xf32>, %arg4: tensor<1xf32>) -> tensor<*xi64> {
-  %0 = "onnx.NonMaxSuppression"(%arg0, %arg1, %arg2, %arg3, %arg4) {center_point_box = 1 : si64} : (tensor<?x?x?xf32>, tensor<?x?x?xf32>, tensor<1xi64>, tensor<1xf32>, tensor<1xf32>) -> tensor<*xi64>
-  return %0 : tensor<*xi64>
-
 // CHECK-DAG:   [[MAP_0_:#.+]] = affine_map<(d0, d1, d2) -> (d0, d1, d2)>
 // CHECK-DAG:   [[MAP_1_:#.+]] = affine_map<(d0) -> (d0)>
 // CHECK-DAG:   [[MAP_2_:#.+]] = affine_map<(d0, d1) -> (d0, d1)>
@@ -1668,113 +1751,108 @@ func.func @test_nonmaxsuppression_unknown_dims(%arg0: tensor<?x?x?xf32>, %arg1:
 // CHECK:           [[VAR_12_:%.+]] = arith.muli [[VAR_11_]], [[LOAD_RES_MEM_1_]] : index
 // CHECK:           [[RES_4_:%.+]] = memref.alloc([[VAR_12_]]) {{.*}}: memref<?x3xindex>
 // CHECK:           krnl.memset [[RES_4_]], [[CST_minus_1_]] : memref<?x3xindex>
-// CHECK:           [[RES_5_:%.+]] = memref.alloca() : memref<index>
-// CHECK:           krnl.store [[CST_0_1_]], [[RES_5_]][] : memref<index>
-// CHECK-DAG:       [[RES_6_:%.+]] = memref.alloca() : memref<index>
-// CHECK-DAG:       [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
 // CHECK:           krnl.iterate([[LOOP_3_]]#0, [[LOOP_3_]]#1) with ([[LOOP_3_]]#0 -> [[I_6_:%.+]] = [[CST_0_1_]] to [[VAR_dim_]], [[LOOP_3_]]#1 -> [[I_7_:%.+]] = [[CST_0_1_]] to [[VAR_dim_]]_2){
 // CHECK:             [[VAR_16_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_3_]]#0, [[LOOP_3_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[CST_0_1_]], [[RES_6_]][] : memref<index>
-// CHECK:             [[RES_7_:%.+]] = memref.alloc([[VAR_dim_3_]]) {{.*}}: memref<?xi1>
-// CHECK:             krnl.memset [[RES_7_]], [[VAR_false_]] : memref<?xi1>
-// CHECK:             [[LOOP_4_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_4_]]) with ([[LOOP_4_]] -> [[I_8_:%.+]] = [[CST_0_1_]] to [[VAR_dim_3_]]){
-// CHECK:               [[LOAD_RES_1_MEM_1_:%.+]] = krnl.get_induction_var_value([[LOOP_4_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_16_2_]]#0, [[VAR_16_2_]]#1, [[LOAD_RES_1_MEM_1_]]{{.}} : memref<?x?x?xindex>
-// CHECK:               [[LOAD_SCORES_MEM_1_:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_16_2_]]#0, [[VAR_16_2_]]#1, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:           [[VAR_21_1_:%.+]] = arith.cmpf ogt, [[LOAD_SCORES_MEM_1_]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
-// CHECK-DAG:           [[LOAD_SCORES_MEM_2_:%.+]] = krnl.load [[RES_6_]][] : memref<index>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_23_1_:%.+]] = arith.cmpi slt, [[LOAD_SCORES_MEM_2_]], [[LOAD_RES_MEM_1_]] : index
-// CHECK-DAG:           [[LOAD_RES_1_MEM_2_:%.+]] = krnl.load [[RES_7_]]{{.}}[[LOAD_RES_2_MEM_2_]]{{.}} : memref<?xi1>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[VAR_25_1_:%.+]] = arith.cmpi eq, [[LOAD_RES_1_MEM_2_]], [[VAR_false_]] : i1
-// CHECK-DAG:           [[VAR_26_1_:%.+]] = arith.andi [[VAR_21_1_]], [[VAR_23_1_]] : i1
-// CHECK:               [[VAR_27_:%.+]] = arith.andi [[VAR_26_1_]], [[VAR_25_1_]] : i1
-// CHECK:               scf.if [[VAR_27_]] {
-// CHECK-DAG:             [[LOAD_BOXES_MEM_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_0_1_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:             [[LOAD_BOXES_MEM_1_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_1_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:             [[LOAD_BOXES_MEM_2_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_2_1_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:             [[LOAD_BOXES_MEM_3_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[LOAD_RES_2_MEM_2_]], [[CST_3_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:             [[LOAD_RES_5_MEM_:%.+]] = krnl.load [[RES_5_]][] : memref<index>
-// CHECK:                 krnl.store [[VAR_16_2_]]#0, [[RES_4_]]{{.}}[[LOAD_RES_5_MEM_]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[VAR_16_2_]]#1, [[RES_4_]]{{.}}[[LOAD_RES_5_MEM_]], [[CST_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 krnl.store [[LOAD_RES_2_MEM_2_]], [[RES_4_]]{{.}}[[LOAD_RES_5_MEM_]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
-// CHECK:                 [[VAR_33_:%.+]] = arith.addi [[LOAD_SCORES_MEM_2_]], [[CST_1_]] : index
-// CHECK:                 krnl.store [[VAR_33_]], [[RES_6_]][] : memref<index>
-// CHECK:                 [[VAR_34_:%.+]] = arith.addi [[LOAD_RES_5_MEM_]], [[CST_1_]] : index
-// CHECK:                 krnl.store [[VAR_34_]], [[RES_5_]][] : memref<index>
-// CHECK:                 [[LOOP_5_:%.+]] = krnl.define_loops 1
-// CHECK:                 krnl.iterate([[LOOP_5_]]) with ([[LOOP_5_]] -> [[I_9_:%.+]] = [[CST_0_1_]] to [[VAR_dim_3_]]){
-// CHECK:                   [[VAR_36_:%.+]] = krnl.get_induction_var_value([[LOOP_5_]]) : (!krnl.loop) -> index
-// CHECK:                   [[LOAD_RES_7_MEM_:%.+]] = krnl.load [[RES_7_]]{{.}}[[VAR_36_]]{{.}} : memref<?xi1>
-// CHECK:                   [[VAR_38_:%.+]] = arith.cmpi eq, [[LOAD_RES_7_MEM_]], [[VAR_false_]] : i1
-// CHECK:                   scf.if [[VAR_38_]] {
-// CHECK-DAG:                 [[LOAD_BOXES_MEM_4_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[VAR_36_]], [[CST_0_1_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:                 [[LOAD_BOXES_MEM_5_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[VAR_36_]], [[CST_1_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:                 [[LOAD_BOXES_MEM_6_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[VAR_36_]], [[CST_2_1_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:                 [[LOAD_BOXES_MEM_7_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[VAR_36_]], [[CST_3_]]{{.}} : memref<?x?x?xf32>
-// CHECK-DAG:                 [[VAR_43_:%.+]] = arith.divf [[LOAD_BOXES_MEM_2_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_44_:%.+]] = arith.subf [[LOAD_BOXES_MEM_]], [[VAR_43_]] : f32
-// CHECK-DAG:                 [[VAR_45_:%.+]] = arith.divf [[LOAD_BOXES_MEM_2_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_46_:%.+]] = arith.addf [[LOAD_BOXES_MEM_]], [[VAR_45_]] : f32
-// CHECK-DAG:                 [[VAR_47_:%.+]] = arith.divf [[LOAD_BOXES_MEM_3_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_48_:%.+]] = arith.subf [[LOAD_BOXES_MEM_1_]], [[VAR_47_]] : f32
-// CHECK-DAG:                 [[VAR_49_:%.+]] = arith.divf [[LOAD_BOXES_MEM_3_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_50_:%.+]] = arith.addf [[LOAD_BOXES_MEM_1_]], [[VAR_49_]] : f32
-// CHECK-DAG:                 [[VAR_51_:%.+]] = arith.divf [[LOAD_BOXES_MEM_7_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_52_:%.+]] = arith.subf [[LOAD_BOXES_MEM_5_]], [[VAR_51_]] : f32
-// CHECK-DAG:                 [[VAR_53_:%.+]] = arith.divf [[LOAD_BOXES_MEM_7_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_54_:%.+]] = arith.addf [[LOAD_BOXES_MEM_5_]], [[VAR_53_]] : f32
-// CHECK-DAG:                 [[VAR_55_:%.+]] = arith.divf [[LOAD_BOXES_MEM_6_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_56_:%.+]] = arith.subf [[LOAD_BOXES_MEM_4_]], [[VAR_55_]] : f32
-// CHECK-DAG:                 [[VAR_57_:%.+]] = arith.divf [[LOAD_BOXES_MEM_6_]], [[CST_2_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_58_:%.+]] = arith.addf [[LOAD_BOXES_MEM_4_]], [[VAR_57_]] : f32
-// CHECK-DAG:                 [[VAR_59_:%.+]] = arith.mulf [[LOAD_BOXES_MEM_3_]], [[LOAD_BOXES_MEM_2_]] : f32
-// CHECK-DAG:                 [[VAR_60_:%.+]] = arith.mulf [[LOAD_BOXES_MEM_7_]], [[LOAD_BOXES_MEM_6_]] : f32
-// CHECK-DAG:                 [[VAR_61_:%.+]] = arith.maxf [[VAR_44_]], [[VAR_56_]] : f32
-// CHECK-DAG:                 [[VAR_62_:%.+]] = arith.maxf [[VAR_48_]], [[VAR_52_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_63_:%.+]] = arith.minf [[VAR_46_]], [[VAR_58_]] : f32
-// CHECK-DAG:                 [[VAR_64_:%.+]] = arith.minf [[VAR_50_]], [[VAR_54_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_65_:%.+]] = arith.subf [[VAR_63_]], [[VAR_61_]] : f32
-// CHECK-DAG:                 [[VAR_66_:%.+]] = arith.subf [[VAR_64_]], [[VAR_62_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_67_:%.+]] = arith.maxf [[VAR_65_]], [[CST_0_dot_000000_]] : f32
-// CHECK-DAG:                 [[VAR_68_:%.+]] = arith.maxf [[VAR_66_]], [[CST_0_dot_000000_]] : f32
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:                 [[VAR_69_:%.+]] = arith.mulf [[VAR_67_]], [[VAR_68_]] : f32
-// CHECK-DAG:                 [[VAR_70_:%.+]] = arith.addf [[VAR_59_]], [[VAR_60_]] : f32
-// CHECK:                     [[VAR_71_:%.+]] = arith.subf [[VAR_70_]], [[VAR_69_]] : f32
-// CHECK:                     [[VAR_72_:%.+]] = arith.addf [[VAR_71_]], [[CST_9_dot_99999993_]] : f32
-// CHECK:                     [[VAR_73_:%.+]] = arith.divf [[VAR_69_]], [[VAR_72_]] : f32
-// CHECK:                     [[VAR_74_:%.+]] = arith.cmpf oge, [[VAR_73_]], [[LOAD_IOU_THRESHOLD_MEM_]] : f32
-// CHECK:                     scf.if [[VAR_74_]] {
-// CHECK:                       krnl.store [[VAR_true_]], [[RES_7_]]{{.}}[[VAR_36_]]{{.}} : memref<?xi1>
+// CHECK:             [[EMOPC:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[EMOPC]][] : memref<index>
+// CHECK:             [[REMOVED:%.+]] = memref.alloc([[VAR_dim_3_]]) {{.*}}: memref<?xi1>
+// CHECK:             krnl.memset [[REMOVED]], [[VAR_false_]] : memref<?xi1>
+// CHECK:             [[CAND:%.+]] = memref.alloc([[VAR_dim_3_]]) {{.*}}: memref<?xindex>
+// CHECK:             [[NUM_CAND:%.+]] = memref.alloca() : memref<index>
+// CHECK:             krnl.store [[CST_0_1_]], [[NUM_CAND]][] : memref<index>
+// CHECK:             [[F_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[F_LOOP]]) with ([[F_LOOP]] -> [[I_F:%.+]] = [[CST_0_1_]] to [[VAR_dim_3_]]){
+// CHECK:               [[F_IV:%.+]] = krnl.get_induction_var_value([[F_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[CAND_BI:%.+]] = krnl.load [[RES_3_]]{{.}}[[VAR_16_2_]]#0, [[VAR_16_2_]]#1, [[F_IV]]{{.}} : memref<?x?x?xindex>
+// CHECK:               [[CAND_SCORE:%.+]] = krnl.load [[SCORES_]]{{.}}[[VAR_16_2_]]#0, [[VAR_16_2_]]#1, [[CAND_BI]]{{.}} : memref<?x?x?xf32>
+// CHECK:               [[CHECK_SCORE:%.+]] = arith.cmpf ogt, [[CAND_SCORE]], [[LOAD_SCORE_THRESHOLD_MEM_]] : f32
+// CHECK:               scf.if [[CHECK_SCORE]] {
+// CHECK:                 [[NC_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:                 krnl.store [[CAND_BI]], [[CAND]]{{.}}[[NC_VAL]]{{.}} : memref<?xindex>
+// CHECK:                 [[NC_NEXT:%.+]] = arith.addi [[NC_VAL]], [[CST_1_]] : index
+// CHECK:                 krnl.store [[NC_NEXT]], [[NUM_CAND]][] : memref<index>
+// CHECK:               }
+// CHECK:             }
+// CHECK:             [[NUM_CAND_VAL:%.+]] = krnl.load [[NUM_CAND]][] : memref<index>
+// CHECK:             [[OUT_BASE:%.+]] = arith.muli {{.*}}, [[LOAD_RES_MEM_1_]] : index
+// CHECK:             [[S_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[S_LOOP]]) with ([[S_LOOP]] -> [[I_S:%.+]] = [[CST_0_1_]] to [[NUM_CAND_VAL]]){
+// CHECK:               [[S_IV:%.+]] = krnl.get_induction_var_value([[S_LOOP]]) : (!krnl.loop) -> index
+// CHECK:               [[EMOPC_VAL:%.+]] = krnl.load [[EMOPC]][] : memref<index>
+// CHECK:               [[CHECK_MOPC:%.+]] = arith.cmpi slt, [[EMOPC_VAL]], [[LOAD_RES_MEM_1_]] : index
+// CHECK:               [[S_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[S_IV]]{{.}} : memref<?xi1>
+// CHECK:               [[S_NOT_REMOVED:%.+]] = arith.cmpi eq, [[S_REMOVED]], [[VAR_false_]] : i1
+// CHECK:               [[CAN_SELECT:%.+]] = arith.andi [[CHECK_MOPC]], [[S_NOT_REMOVED]] : i1
+// CHECK:               scf.if [[CAN_SELECT]] {
+// CHECK:                 [[SELECTED_BI:%.+]] = krnl.load [[CAND]]{{.}}[[S_IV]]{{.}} : memref<?xindex>
+// CHECK:                 [[SEL_BOX_0_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[SELECTED_BI]], [[CST_0_1_]]{{.}} : memref<?x?x?xf32>
+// CHECK:                 [[SEL_BOX_1_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[SELECTED_BI]], [[CST_1_]]{{.}} : memref<?x?x?xf32>
+// CHECK:                 [[SEL_BOX_2_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[SELECTED_BI]], [[CST_2_1_]]{{.}} : memref<?x?x?xf32>
+// CHECK:                 [[SEL_BOX_3_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[SELECTED_BI]], [[CST_3_]]{{.}} : memref<?x?x?xf32>
+// CHECK:                 [[OUT_IDX:%.+]] = arith.addi [[OUT_BASE]], [[EMOPC_VAL]] : index
+// CHECK:                 krnl.store [[VAR_16_2_]]#0, [[RES_4_]]{{.}}[[OUT_IDX]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[VAR_16_2_]]#1, [[RES_4_]]{{.}}[[OUT_IDX]], [[CST_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 krnl.store [[SELECTED_BI]], [[RES_4_]]{{.}}[[OUT_IDX]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:                 [[EMOPC_NEXT:%.+]] = arith.addi [[EMOPC_VAL]], [[CST_1_]] : index
+// CHECK:                 krnl.store [[EMOPC_NEXT]], [[EMOPC]][] : memref<index>
+// CHECK:                 [[S_NEXT:%.+]] = arith.addi [[S_IV]], [[CST_1_]] : index
+// CHECK:                 [[O_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:                 krnl.iterate([[O_LOOP]]) with ([[O_LOOP]] -> [[I_O:%.+]] = [[S_NEXT]] to [[NUM_CAND_VAL]]){
+// CHECK:                   [[O_IV:%.+]] = krnl.get_induction_var_value([[O_LOOP]]) : (!krnl.loop) -> index
+// CHECK:                   [[O_REMOVED:%.+]] = krnl.load [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<?xi1>
+// CHECK:                   [[O_NOT_REMOVED:%.+]] = arith.cmpi eq, [[O_REMOVED]], [[VAR_false_]] : i1
+// CHECK:                   scf.if [[O_NOT_REMOVED]] {
+// CHECK:                     [[OTHER_BI:%.+]] = krnl.load [[CAND]]{{.}}[[O_IV]]{{.}} : memref<?xindex>
+// CHECK:                     [[OTH_BOX_0_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[OTHER_BI]], [[CST_0_1_]]{{.}} : memref<?x?x?xf32>
+// CHECK:                     [[OTH_BOX_1_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[OTHER_BI]], [[CST_1_]]{{.}} : memref<?x?x?xf32>
+// CHECK:                     [[OTH_BOX_2_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[OTHER_BI]], [[CST_2_1_]]{{.}} : memref<?x?x?xf32>
+// CHECK:                     [[OTH_BOX_3_:%.+]] = krnl.load [[BOXES_]]{{.}}[[VAR_16_2_]]#0, [[OTHER_BI]], [[CST_3_]]{{.}} : memref<?x?x?xf32>
+// CHECK:                     [[CHECK_IOU:%.+]] = arith.cmpf oge, {{.*}}, [[LOAD_IOU_THRESHOLD_MEM_]] : f32
+// CHECK:                     scf.if [[CHECK_IOU]] {
+// CHECK:                       krnl.store [[VAR_true_]], [[REMOVED]]{{.}}[[O_IV]]{{.}} : memref<?xi1>
 // CHECK:                     }
 // CHECK:                   }
 // CHECK:                 }
 // CHECK:               }
 // CHECK:             }
 // CHECK:           }
-// CHECK:           [[LOAD_RES_5_MEM_1_:%.+]] = krnl.load [[RES_5_]][] : memref<index>
-// CHECK-DAG:       [[RES_8_:%.+]] = memref.alloc([[LOAD_RES_5_MEM_1_]]) {{.*}}: memref<?x3xi64>
-// CHECK-DAG:       [[LOOP_6_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_6_]]#0, [[LOOP_6_]]#1) with ([[LOOP_6_]]#0 -> [[I_10_:%.+]] = [[CST_0_1_]] to [[LOAD_RES_5_MEM_1_]], [[LOOP_6_]]#1 -> [[I_11_:%.+]] = [[CST_0_1_]] to [[CST_3_]]){
-// CHECK:             [[VAR_16_3_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_6_]]#0, [[LOOP_6_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOOP_4_:%.+]] = krnl.load [[RES_4_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1] : memref<?x3xindex>
-// CHECK:             [[LOAD_RES_1_MEM_1_1_:%.+]] = arith.index_cast [[LOOP_4_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_1_MEM_1_1_]], [[RES_8_]]{{.}}[[VAR_16_3_]]#0, [[VAR_16_3_]]#1] : memref<?x3xi64>
+// CHECK:           [[COUNT:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[COUNT]][] : memref<index>
+// CHECK:           [[COUNT_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[COUNT_LOOP]]) with ([[COUNT_LOOP]] -> [[I_N:%.+]] = [[CST_0_1_]] to [[VAR_12_]]){
+// CHECK:             [[N_IV:%.+]] = krnl.get_induction_var_value([[COUNT_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[N_B:%.+]] = krnl.load [[RES_4_]]{{.}}[[N_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[N_FILLED:%.+]] = arith.cmpi ne, [[N_B]], [[CST_minus_1_]] : index
+// CHECK:             [[COUNT_VAL:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:             [[COUNT_INC:%.+]] = arith.addi [[COUNT_VAL]], [[CST_1_]] : index
+// CHECK:             [[NEW_COUNT:%.+]] = arith.select [[N_FILLED]], [[COUNT_INC]], [[COUNT_VAL]] : index
+// CHECK:             krnl.store [[NEW_COUNT]], [[COUNT]][] : memref<index>
+// CHECK:           }
+// CHECK:           [[EFFECTIVE_NSI:%.+]] = krnl.load [[COUNT]][] : memref<index>
+// CHECK:           [[RES_FINAL:%.+]] = memref.alloc([[EFFECTIVE_NSI]]) {{.*}}: memref<?x3xi64>
+// CHECK:           [[OUT_POS:%.+]] = memref.alloca() : memref<index>
+// CHECK:           krnl.store [[CST_0_1_]], [[OUT_POS]][] : memref<index>
+// CHECK:           [[PACK_LOOP:%.+]] = krnl.define_loops 1
+// CHECK:           krnl.iterate([[PACK_LOOP]]) with ([[PACK_LOOP]] -> [[I_P:%.+]] = [[CST_0_1_]] to [[VAR_12_]]){
+// CHECK:             [[P_IV:%.+]] = krnl.get_induction_var_value([[PACK_LOOP]]) : (!krnl.loop) -> index
+// CHECK:             [[P_B:%.+]] = krnl.load [[RES_4_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:             [[P_FILLED:%.+]] = arith.cmpi ne, [[P_B]], [[CST_minus_1_]] : index
+// CHECK:             scf.if [[P_FILLED]] {
+// CHECK:               [[P_OUT:%.+]] = krnl.load [[OUT_POS]][] : memref<index>
+// CHECK:               [[P_V0_:%.+]] = krnl.load [[RES_4_]]{{.}}[[P_IV]], [[CST_0_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C0_:%.+]] = arith.index_cast [[P_V0_]] : index to i64
+// CHECK:               krnl.store [[P_C0_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_0_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V1_:%.+]] = krnl.load [[RES_4_]]{{.}}[[P_IV]], [[CST_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C1_:%.+]] = arith.index_cast [[P_V1_]] : index to i64
+// CHECK:               krnl.store [[P_C1_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_V2_:%.+]] = krnl.load [[RES_4_]]{{.}}[[P_IV]], [[CST_2_1_]]{{.}} : memref<?x3xindex>
+// CHECK:               [[P_C2_:%.+]] = arith.index_cast [[P_V2_]] : index to i64
+// CHECK:               krnl.store [[P_C2_]], [[RES_FINAL]]{{.}}[[P_OUT]], [[CST_2_1_]]{{.}} : memref<?x3xi64>
+// CHECK:               [[P_NEXT:%.+]] = arith.addi [[P_OUT]], [[CST_1_]] : index
+// CHECK:               krnl.store [[P_NEXT]], [[OUT_POS]][] : memref<index>
+// CHECK:             }
 // CHECK:           }
-// CHECK:           return [[RES_8_]] : memref<?x3xi64>
+// CHECK:           return [[RES_FINAL]] : memref<?x3xi64>
 // CHECK:         }
 }
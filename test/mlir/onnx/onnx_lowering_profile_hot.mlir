@@ -0,0 +1,20 @@
+// RUN: onnx-mlir-opt --shape-inference --convert-onnx-to-krnl %s -split-input-file | FileCheck %s
+
+// Without -O3 the static heuristics leave matmuls untiled, but an op marked
+// hot by the profile annotation pass still takes the tiled path.
+func.func @test_profile_hot_matmul(%arg0: tensor<16x32xf32>, %arg1: tensor<32x64xf32>) -> tensor<16x64xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) {profile_hot} : (tensor<16x32xf32>, tensor<32x64xf32>) -> tensor<16x64xf32>
+  return %0 : tensor<16x64xf32>
+}
+// CHECK-LABEL: func.func @test_profile_hot_matmul
+// CHECK:         krnl.matmul
+
+// -----
+
+// A matmul without the annotation keeps the generic loop nest.
+func.func @test_cold_matmul(%arg0: tensor<16x32xf32>, %arg1: tensor<32x64xf32>) -> tensor<16x64xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<16x32xf32>, tensor<32x64xf32>) -> tensor<16x64xf32>
+  return %0 : tensor<16x64xf32>
+}
+// CHECK-LABEL: func.func @test_cold_matmul
+// CHECK-NOT:     krnl.matmul
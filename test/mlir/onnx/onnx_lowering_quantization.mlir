@@ -0,0 +1,98 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl %s -split-input-file | FileCheck %s
+
+// DynamicQuantizeLinear: a min/max range pass over the input, scalar scale
+// and zero-point computations, then an elementwise quantization pass.
+func.func @test_dynamic_quantize_linear(%arg0: tensor<?x2xf32>) -> (tensor<?x2xui8>, tensor<f32>, tensor<ui8>) {
+  %y, %y_scale, %y_zero_point = "onnx.DynamicQuantizeLinear"(%arg0) : (tensor<?x2xf32>) -> (tensor<?x2xui8>, tensor<f32>, tensor<ui8>)
+  return %y, %y_scale, %y_zero_point : tensor<?x2xui8>, tensor<f32>, tensor<ui8>
+
+  // CHECK-LABEL: func.func @test_dynamic_quantize_linear
+  // CHECK-SAME:  ([[PARAM_0_:%.+]]: memref<?x2xf32>) -> (memref<?x2xui8>, memref<f32>, memref<ui8>)
+  // CHECK-DAG:   [[Y_:%.+]] = memref.alloc([[VAR_dim_:%.+]]) {{.*}}: memref<?x2xui8>
+  // CHECK-DAG:   [[SCALE_MEM_:%.+]] = memref.alloc() {{.*}}: memref<f32>
+  // CHECK-DAG:   [[ZP_MEM_:%.+]] = memref.alloc() {{.*}}: memref<ui8>
+  // Range pass keeps a running min and max, both seeded with zero.
+  // CHECK:       krnl.iterate
+  // CHECK:       arith.minf
+  // CHECK:       arith.maxf
+  // y_scale = (max - min) / 255.
+  // CHECK:       [[RANGE_:%.+]] = arith.subf
+  // CHECK:       [[SCALE_:%.+]] = arith.divf [[RANGE_]], %{{.*}} : f32
+  // CHECK:       krnl.store [[SCALE_]], [[SCALE_MEM_]][] : memref<f32>
+  // Quantization pass rounds, shifts by the zero point, and saturates.
+  // CHECK:       krnl.iterate
+  // CHECK:       arith.divf
+  // CHECK:       math.floor
+  // CHECK:       arith.addi
+  // CHECK:       arith.minsi
+  // CHECK:       krnl.store {{.*}}, [[Y_]]{{.}}%{{.*}}, %{{.*}}{{.}} : memref<?x2xui8>
+  // CHECK:       return [[Y_]], [[SCALE_MEM_]], [[ZP_MEM_]]
+}
+
+// -----
+
+// QLinearMatMul 2-D: cache-blocked int8 matmul accumulating into an i32
+// buffer, with a separate requantization epilogue.
+func.func @test_qlinear_matmul(%arg0: tensor<16x32xui8>, %arg1: tensor<f32>, %arg2: tensor<ui8>, %arg3: tensor<32x64xui8>, %arg4: tensor<f32>, %arg5: tensor<ui8>, %arg6: tensor<f32>, %arg7: tensor<ui8>) -> tensor<16x64xui8> {
+  %0 = "onnx.QLinearMatMul"(%arg0, %arg1, %arg2, %arg3, %arg4, %arg5, %arg6, %arg7) : (tensor<16x32xui8>, tensor<f32>, tensor<ui8>, tensor<32x64xui8>, tensor<f32>, tensor<ui8>, tensor<f32>, tensor<ui8>) -> tensor<16x64xui8>
+  return %0 : tensor<16x64xui8>
+
+  // CHECK-LABEL: func.func @test_qlinear_matmul
+  // CHECK-DAG:   [[RES_:%.+]] = memref.alloc() {{.*}}: memref<16x64xui8>
+  // Combined scale a_scale * b_scale / y_scale.
+  // CHECK:       arith.mulf
+  // CHECK:       arith.divf
+  // i32 accumulation buffer, zero initialized.
+  // CHECK:       [[ACC_:%.+]] = memref.alloc() {{.*}}: memref<16x64xi32>
+  // CHECK:       krnl.memset [[ACC_]], %{{.*}} : memref<16x64xi32>
+  // Blocked schedule over j and k.
+  // CHECK:       krnl.block
+  // CHECK:       krnl.block
+  // CHECK:       krnl.permute
+  // Widened products accumulate in i32.
+  // CHECK:       krnl.iterate
+  // CHECK:       arith.subi
+  // CHECK:       arith.subi
+  // CHECK:       arith.muli
+  // CHECK:       arith.addi
+  // Requantization epilogue back into the quantized output.
+  // CHECK:       krnl.iterate
+  // CHECK:       arith.sitofp
+  // CHECK:       arith.mulf
+  // CHECK:       math.floor
+  // CHECK:       arith.maxsi
+  // CHECK:       arith.minsi
+  // CHECK:       krnl.store {{.*}}, [[RES_]]{{.}}%{{.*}}, %{{.*}}{{.}} : memref<16x64xui8>
+  // CHECK:       return [[RES_]] : memref<16x64xui8>
+}
+
+// -----
+
+// QLinearConv: int8 convolution with i32 accumulation, i32 bias added to the
+// accumulator, and per-element requantization.
+func.func @test_qlinear_conv(%arg0: tensor<1x2x8x8xui8>, %arg1: tensor<f32>, %arg2: tensor<ui8>, %arg3: tensor<4x2x3x3xui8>, %arg4: tensor<f32>, %arg5: tensor<ui8>, %arg6: tensor<f32>, %arg7: tensor<ui8>, %arg8: tensor<4xi32>) -> tensor<1x4x6x6xui8> {
+  %0 = "onnx.QLinearConv"(%arg0, %arg1, %arg2, %arg3, %arg4, %arg5, %arg6, %arg7, %arg8) {auto_pad = "NOTSET", group = 1 : si64} : (tensor<1x2x8x8xui8>, tensor<f32>, tensor<ui8>, tensor<4x2x3x3xui8>, tensor<f32>, tensor<ui8>, tensor<f32>, tensor<ui8>, tensor<4xi32>) -> tensor<1x4x6x6xui8>
+  return %0 : tensor<1x4x6x6xui8>
+
+  // CHECK-LABEL: func.func @test_qlinear_conv
+  // CHECK-DAG:   [[RES_:%.+]] = memref.alloc() {{.*}}: memref<1x4x6x6xui8>
+  // CHECK-DAG:   [[ACC_CELL_:%.+]] = memref.alloca() : memref<i32>
+  // Outer loops over batch, group, and channel out.
+  // CHECK:       krnl.iterate
+  // Reduction over channel in and the kernel window accumulates in i32.
+  // CHECK:       krnl.iterate
+  // CHECK:       arith.subi
+  // CHECK:       arith.subi
+  // CHECK:       arith.muli
+  // CHECK:       arith.addi
+  // Bias joins the i32 accumulator before requantization.
+  // CHECK:       krnl.load %arg8{{.}}%{{.*}}{{.}} : memref<4xi32>
+  // CHECK:       arith.addi
+  // CHECK:       arith.sitofp
+  // CHECK:       arith.mulf
+  // CHECK:       math.floor
+  // CHECK:       arith.maxsi
+  // CHECK:       arith.minsi
+  // CHECK:       krnl.store {{.*}} : memref<1x4x6x6xui8>
+  // CHECK:       return [[RES_]] : memref<1x4x6x6xui8>
+}
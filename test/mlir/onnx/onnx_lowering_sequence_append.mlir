@@ -0,0 +1,41 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl %s -split-input-file | FileCheck %s
+
+/// Inserting at the end of a sequence that dies at the insert grows the
+/// sequence in place with krnl.seqappend instead of allocating a new
+/// sequence and deep-copying every element.
+func.func @test_sequence_append(%arg0: !onnx.Seq<tensor<?x4x5xf32>>, %arg1: tensor<?x4x5xf32>) -> !onnx.Seq<tensor<?x4x5xf32>> {
+  %0 = onnx.Constant {value = dense<0> : tensor<1xi64>} : tensor<i64>
+  %1 = "onnx.NoValue"() {value} : () -> none
+  %2 = "onnx.SequenceErase"(%arg0, %0) : (!onnx.Seq<tensor<?x4x5xf32>>, tensor<i64>) -> !onnx.Seq<tensor<?x4x5xf32>>
+  %3 = "onnx.SequenceInsert"(%2, %arg1, %1) : (!onnx.Seq<tensor<?x4x5xf32>>, tensor<?x4x5xf32>, none) -> !onnx.Seq<tensor<?x4x5xf32>>
+  return %3 : !onnx.Seq<tensor<?x4x5xf32>>
+}
+// CHECK-LABEL:  func.func @test_sequence_append
+// CHECK:           [[SEQ_:%.+]] = "krnl.seqalloc"({{.*}}) : (index) -> memref<?xmemref<?x4x5xf32>>
+// CHECK:           [[OUT_:%.+]] = "krnl.seqappend"(%arg1, [[SEQ_]]) : (memref<?x4x5xf32>, memref<?xmemref<?x4x5xf32>>) -> memref<?xmemref<?x4x5xf32>>
+// CHECK:           return [[OUT_]] : memref<?xmemref<?x4x5xf32>>
+
+// -----
+
+/// Inserting at an explicit position cannot reuse the input storage and
+/// keeps the copying lowering.
+func.func @test_sequence_insert_at_position(%arg0: !onnx.Seq<tensor<?x4x5xf32>>, %arg1: tensor<?x4x5xf32>) -> !onnx.Seq<tensor<?x4x5xf32>> {
+  %0 = onnx.Constant {value = dense<0> : tensor<1xi64>} : tensor<i64>
+  %2 = "onnx.SequenceErase"(%arg0, %0) : (!onnx.Seq<tensor<?x4x5xf32>>, tensor<i64>) -> !onnx.Seq<tensor<?x4x5xf32>>
+  %3 = "onnx.SequenceInsert"(%2, %arg1, %0) : (!onnx.Seq<tensor<?x4x5xf32>>, tensor<?x4x5xf32>, tensor<i64>) -> !onnx.Seq<tensor<?x4x5xf32>>
+  return %3 : !onnx.Seq<tensor<?x4x5xf32>>
+}
+// CHECK-LABEL:  func.func @test_sequence_insert_at_position
+// CHECK-NOT:       krnl.seqappend
+
+// -----
+
+/// A sequence coming straight from a block argument has unknown storage
+/// provenance and must not be grown in place.
+func.func @test_sequence_append_to_argument(%arg0: !onnx.Seq<tensor<?x4x5xf32>>, %arg1: tensor<?x4x5xf32>) -> !onnx.Seq<tensor<?x4x5xf32>> {
+  %0 = "onnx.NoValue"() {value} : () -> none
+  %1 = "onnx.SequenceInsert"(%arg0, %arg1, %0) : (!onnx.Seq<tensor<?x4x5xf32>>, tensor<?x4x5xf32>, none) -> !onnx.Seq<tensor<?x4x5xf32>>
+  return %1 : !onnx.Seq<tensor<?x4x5xf32>>
+}
+// CHECK-LABEL:  func.func @test_sequence_append_to_argument
+// CHECK-NOT:       krnl.seqappend
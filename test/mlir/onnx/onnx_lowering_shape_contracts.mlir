@@ -0,0 +1,45 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl %s -split-input-file | FileCheck %s
+
+// Shape contracts are recorded by the importer as onnx.dim_ub / onnx.dim_mult
+// argument attributes (--shapeContracts). The contract here promises that the
+// dynamic J dimension is a multiple of 32, hence of the 16-wide register tile,
+// so the cache-blocked matmul schedule can simdize directly into C instead of
+// buffering it into a 32x64 tile.
+func.func @test_matmul_contract_multiple(%arg0: tensor<?x512xf32>, %arg1: tensor<512x?xf32> {onnx.dim_mult = [1, 32], onnx.dim_ub = [-1, -1]}) -> tensor<?x?xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<?x512xf32>, tensor<512x?xf32>) -> tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+
+  // CHECK-LABEL: func @test_matmul_contract_multiple
+  // CHECK-NOT:   memref.alloc() {{.*}}: memref<32x64xf32>
+  // CHECK:       krnl.copy_to_tile_buffer
+  // CHECK:       krnl.matmul
+  // CHECK-NOT:   krnl.copy_from_tile_buffer
+}
+
+// -----
+
+// Without a contract, the same dynamic-J matmul must buffer C into a tile
+// with SIMD-friendly static bounds.
+func.func @test_matmul_no_contract(%arg0: tensor<?x512xf32>, %arg1: tensor<512x?xf32>) -> tensor<?x?xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<?x512xf32>, tensor<512x?xf32>) -> tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+
+  // CHECK-LABEL: func @test_matmul_no_contract
+  // CHECK:       memref.alloc() {{.*}}: memref<32x64xf32>
+  // CHECK:       krnl.matmul
+  // CHECK:       krnl.copy_from_tile_buffer
+}
+
+// -----
+
+// The contract bounds the dynamic batch dimension I by 16, below the 32-row
+// cache tile, so cache blocking is not profitable: the register-tiled
+// schedule runs without any packed tile buffers.
+func.func @test_matmul_contract_upper_bound(%arg0: tensor<?x512xf32> {onnx.dim_mult = [1, 1], onnx.dim_ub = [16, -1]}, %arg1: tensor<512x64xf32>) -> tensor<?x64xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<?x512xf32>, tensor<512x64xf32>) -> tensor<?x64xf32>
+  return %0 : tensor<?x64xf32>
+
+  // CHECK-LABEL: func @test_matmul_contract_upper_bound
+  // CHECK-NOT:   krnl.copy_to_tile_buffer
+  // CHECK:       krnl.matmul
+}
@@ -0,0 +1,44 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl='sparse-weight-density=0.5' %s -split-input-file | FileCheck %s
+
+// Constant B with 4 nonzeros out of 16 (density 0.25, below the 0.5
+// threshold): B is stored as CSR constants and multiplied with the
+// sparse-dense kernel instead of krnl.matmul.
+func.func @test_sparse_matmul(%arg0: tensor<2x4xf32>) -> tensor<2x4xf32> {
+  %0 = onnx.Constant dense<[[1.0, 0.0, 0.0, 0.0], [0.0, 0.0, 2.0, 0.0], [0.0, 0.0, 0.0, 0.0], [3.0, 0.0, 0.0, 4.0]]> : tensor<4x4xf32>
+  %1 = "onnx.MatMul"(%arg0, %0) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
+  return %1 : tensor<2x4xf32>
+
+  // CHECK-LABEL: func @test_sparse_matmul
+  // CHECK-DAG:   [[VALUES:%.+]] = "krnl.global"() {name = "sparse_matmul_values{{.*}}", shape = [4], value = dense<[1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00]> : tensor<4xf32>} : () -> memref<4xf32>
+  // CHECK-DAG:   [[COLIDX:%.+]] = "krnl.global"() {name = "sparse_matmul_colidx{{.*}}", shape = [4], value = dense<[0, 2, 0, 3]> : tensor<4xi64>} : () -> memref<4xi64>
+  // CHECK-DAG:   [[ROWPTR:%.+]] = "krnl.global"() {name = "sparse_matmul_rowptr{{.*}}", shape = [5], value = dense<[0, 1, 2, 2, 4]> : tensor<5xi64>} : () -> memref<5xi64>
+  // CHECK:       krnl.memset [[RES:%.+]], %{{.*}} : memref<2x4xf32>
+  // CHECK:       [[LOOP:%.+]]:2 = krnl.define_loops 2
+  // CHECK:       krnl.iterate([[LOOP]]#0, [[LOOP]]#1) with ([[LOOP]]#0 -> [[I:%.+]] = 0 to 2, [[LOOP]]#1 -> [[K:%.+]] = 0 to 4){
+  // CHECK:         [[A:%.+]] = krnl.load %arg0{{\[}}[[I]], [[K]]{{\]}} : memref<2x4xf32>
+  // CHECK:         krnl.load [[ROWPTR]]{{\[}}[[K]]{{\]}} : memref<5xi64>
+  // CHECK:         krnl.load [[ROWPTR]]{{\[}}%{{.*}}{{\]}} : memref<5xi64>
+  // CHECK:         [[PLOOP:%.+]] = krnl.define_loops 1
+  // CHECK:         krnl.iterate([[PLOOP]]) with ([[PLOOP]] -> [[P:%.+]] = %{{.*}} to %{{.*}}){
+  // CHECK:           krnl.load [[COLIDX]]{{\[}}[[P]]{{\]}} : memref<4xi64>
+  // CHECK:           [[B:%.+]] = krnl.load [[VALUES]]{{\[}}[[P]]{{\]}} : memref<4xf32>
+  // CHECK:           [[C:%.+]] = krnl.load [[RES]]{{\[}}[[I]], [[J:%.+]]{{\]}} : memref<2x4xf32>
+  // CHECK:           [[MUL:%.+]] = arith.mulf [[A]], [[B]] : f32
+  // CHECK:           [[ADD:%.+]] = arith.addf [[C]], [[MUL]] : f32
+  // CHECK:           krnl.store [[ADD]], [[RES]]{{\[}}[[I]], [[J]]{{\]}} : memref<2x4xf32>
+  // CHECK-NOT:   krnl.matmul
+}
+
+// -----
+
+// Dense constant B (density 1.0, above the threshold): the sparse path must
+// not trigger and the regular krnl.matmul kernel is used.
+func.func @test_sparse_matmul_dense_weight(%arg0: tensor<2x4xf32>) -> tensor<2x4xf32> {
+  %0 = onnx.Constant dense<1.0> : tensor<4x4xf32>
+  %1 = "onnx.MatMul"(%arg0, %0) : (tensor<2x4xf32>, tensor<4x4xf32>) -> tensor<2x4xf32>
+  return %1 : tensor<2x4xf32>
+
+  // CHECK-LABEL: func @test_sparse_matmul_dense_weight
+  // CHECK-NOT:   "krnl.global"() {name = "sparse_matmul_values
+  // CHECK:       krnl.matmul
+}
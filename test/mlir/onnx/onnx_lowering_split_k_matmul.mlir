@@ -0,0 +1,38 @@
+// RUN: onnx-mlir-opt -O3 --shape-inference --convert-onnx-to-krnl='enable-parallel' %s -split-input-file | FileCheck %s
+
+// Tall-skinny product (I = 4, K = 4096): too little I/J parallelism, so the
+// reduction dimension is split into 8 chunks. Each chunk accumulates into its
+// own slab of the partial buffer under a parallel loop, and a sequential
+// epilogue sums the slabs into the result.
+func.func @test_matmul_split_k(%arg0: tensor<4x4096xf32>, %arg1: tensor<4096x64xf32>) -> tensor<4x64xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<4x4096xf32>, tensor<4096x64xf32>) -> tensor<4x64xf32>
+  return %0 : tensor<4x64xf32>
+
+  // CHECK-LABEL: func @test_matmul_split_k
+  // CHECK:       [[PARTIALS:%.+]] = memref.alloc() {{.*}} : memref<8x4x64xf32>
+  // CHECK:       krnl.memset [[PARTIALS]], %{{.*}} : memref<8x4x64xf32>
+  // CHECK:       [[CHUNK_LOOP:%.+]] = krnl.define_loops 1
+  // CHECK:       krnl.parallel([[CHUNK_LOOP]]) : !krnl.loop
+  // CHECK:       krnl.iterate([[CHUNK_LOOP]]) with ([[CHUNK_LOOP]] -> [[CHUNK:%.+]] = 0 to 8){
+  // CHECK:         krnl.matmul %arg0{{\[}}%{{.*}}, %{{.*}}{{\]}}, %arg1{{\[}}%{{.*}}, %{{.*}}{{\]}}, [[PARTIALS]]{{\[}}[[CHUNK]], %{{.*}}, %{{.*}}{{\]}}
+  // CHECK:       krnl.memset [[RES:%.+]], %{{.*}} : memref<4x64xf32>
+  // CHECK:       [[RED_LOOP:%.+]]:3 = krnl.define_loops 3
+  // CHECK:       krnl.iterate([[RED_LOOP]]#0, [[RED_LOOP]]#1, [[RED_LOOP]]#2) with ([[RED_LOOP]]#0 -> [[C:%.+]] = 0 to 8, [[RED_LOOP]]#1 -> [[I:%.+]] = 0 to 4, [[RED_LOOP]]#2 -> [[J:%.+]] = 0 to 64){
+  // CHECK:         [[PARTIAL:%.+]] = krnl.load [[PARTIALS]]{{\[}}[[C]], [[I]], [[J]]{{\]}} : memref<8x4x64xf32>
+  // CHECK:         [[ACC:%.+]] = krnl.load [[RES]]{{\[}}[[I]], [[J]]{{\]}} : memref<4x64xf32>
+  // CHECK:         [[SUM:%.+]] = arith.addf [[ACC]], [[PARTIAL]] : f32
+  // CHECK:         krnl.store [[SUM]], [[RES]]{{\[}}[[I]], [[J]]{{\]}} : memref<4x64xf32>
+}
+
+// -----
+
+// I is large enough for regular I/J parallelism: the split-K schedule must
+// not trigger and the sequential register-tiled kernel is used.
+func.func @test_matmul_no_split_k(%arg0: tensor<256x4096xf32>, %arg1: tensor<4096x64xf32>) -> tensor<256x64xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<256x4096xf32>, tensor<4096x64xf32>) -> tensor<256x64xf32>
+  return %0 : tensor<256x64xf32>
+
+  // CHECK-LABEL: func @test_matmul_no_split_k
+  // CHECK-NOT:   krnl.parallel
+  // CHECK:       krnl.matmul
+}
@@ -578,6 +578,24 @@ func.func @test_gemm(%arg0 : tensor<5x10xf32>, %arg1 : tensor<5x10xf32>, %arg2:
 
 // -----
 
+// GEMM with a constant transposed B: the weight is packed untransposed into
+// the tile layout at compile time, with zero padding in the partial K tile,
+// and both the runtime copy and the runtime transpose of B disappear.
+func.func @test_gemm_const_b(%arg0 : tensor<5x10xf32>, %arg2: tensor<128xf32>) -> tensor<*xf32> {
+  %0 = onnx.Constant dense<0.0> : tensor<128x10xf32>
+  %1 ="onnx.Gemm"(%arg0, %0, %arg2) {alpha = 1.0 : f32, beta = 1.0 : f32, transA = 0 : si64, transB = 1 : si64} : (tensor<5x10xf32>, tensor<128x10xf32>, tensor<128xf32>) -> tensor<*xf32>
+  "func.return"(%1) : (tensor<*xf32>) -> ()
+
+// CHECK-LABEL:  func @test_gemm_const_b
+// CHECK-NOT:       memref.alloc() {{.*}}: memref<256x64xf32>
+// CHECK:           [[PACKED_B_:%.+]] = "krnl.global"() {name = "prepacked_weight{{.*}}", shape = [1, 2, 256, 64], value = dense<0.000000e+00> : tensor<1x2x256x64xf32>} : () -> memref<1x2x256x64xf32>
+// CHECK:           krnl.copy_to_tile_buffer {{.*}} : memref<32x256xf32>, memref<5x10xf32>
+// CHECK:           krnl.matmul {{.*}}[[PACKED_B_]]{{.*}} : memref<32x256xf32>, memref<1x2x256x64xf32>, memref<5x128xf32>
+// CHECK-NOT:       krnl.copy_to_tile_buffer
+}
+
+// -----
+
 // Gemm with all dimensions dynamic
 func.func @test_gemm_all_dyn(%arg0 : tensor<?x?xf32>, %arg1 : tensor<?x?xf32>, %arg2: tensor<?xf32>) -> tensor<*xf32> {
   %0 ="onnx.Gemm"(%arg0, %arg1, %arg2) {alpha = 1.0 : f32, beta = 5.0 : f32, transA = 1 : si64, transB = 0 : si64} : (tensor<?x?xf32>, tensor<?x?xf32>, tensor<?xf32>) -> tensor<*xf32>
@@ -737,6 +755,33 @@ func.func @test_gather_axis1(%arg0 : tensor<3x3xf32>) -> tensor<3x1x2xf32> {
 
 // -----
 
+// Test gather along axis 0 with an embedding-style data tensor whose rows are
+// a whole number of vectors long; the rows are copied with wide vector
+// loads/stores instead of scalar element moves.
+func.func @test_gather_axis0_simd(%arg0 : tensor<3x8xf32>) -> tensor<2x8xf32> {
+  %indices = onnx.Constant dense<[0, 2]> : tensor<2xi64>
+  %0 = "onnx.Gather"(%arg0, %indices) {axis = 0 : si64} : (tensor<3x8xf32>, tensor<2xi64>) -> tensor<2x8xf32>
+  "func.return"(%0) : (tensor<2x8xf32>) -> ()
+
+// CHECK-LABEL:  func @test_gather_axis0_simd
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<3x8xf32>) -> memref<2x8xf32> {
+// CHECK-DAG:       [[RES_:%.+]] = memref.alloc() {{.*}}: memref<2x8xf32>
+// CHECK-DAG:       [[VAR_1_:%.+]] = "krnl.global"() {name = {{.*}}, shape = [2], value = dense<[0, 2]> : tensor<2xi64>} : () -> memref<2xi64>
+// CHECK-DAG:       [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[BLOCK_TILE__0_:%.+]], [[BLOCK_IN__0_:%.+]] = krnl.block [[LOOP_0_]]#1 4 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[BLOCK_TILE__0_]]) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 2, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 8){
+// CHECK:             [[IV:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[BLOCK_TILE__0_]]) : (!krnl.loop, !krnl.loop) -> (index, index)
+// CHECK:             [[LOAD_VAR_1_MEM_:%.+]] = krnl.load [[VAR_1_]]{{.}}[[IV]]#0] : memref<2xi64>
+// CHECK:             [[VAR_4_:%.+]] = arith.index_cast [[LOAD_VAR_1_MEM_]] : i64 to index
+// CHECK:             [[LOAD_PARAM_0_MEM_:%.+]] = vector.load [[PARAM_0_]]{{.}}[[VAR_4_]], [[IV]]#1] : memref<3x8xf32>, vector<4xf32>
+// CHECK:             vector.store [[LOAD_PARAM_0_MEM_]], [[RES_]]{{.}}[[IV]]#0, [[IV]]#1] : memref<2x8xf32>, vector<4xf32>
+// CHECK:           }
+// CHECK:           return [[RES_]] : memref<2x8xf32>
+// CHECK:         }
+}
+
+// -----
+
 // COM: Test GatherElements along axis 0. Positive indices, so no select.
 func.func @test_gather_elements_axis0(%arg0 : tensor<3x3xf32>) -> tensor<2x3xf32> {
   %indices = onnx.Constant dense<[[1, 2, 0], [2, 0, 0]]> : tensor<2x3xi64>
@@ -790,6 +835,31 @@ func.func @test_gather_elements_axis0neg(%arg0 : tensor<3x2xf32>) -> tensor<2x2x
 
 // -----
 
+// COM: GatherElements whose indices are an Expand of a tensor with extent 1
+// COM: in the dimensions after the axis (beam-search KV-cache reordering):
+// COM: the index load and its normalization are hoisted out of the inner
+// COM: dimensions and the inner loop becomes a block copy.
+func.func @test_gather_elements_blocked(%arg0 : tensor<2x3x4xf32>, %arg1 : tensor<2x3x1xi64>) -> tensor<2x3x4xf32> {
+  %shape = onnx.Constant dense<[2, 3, 4]> : tensor<3xi64>
+  %indices = "onnx.Expand"(%arg1, %shape) : (tensor<2x3x1xi64>, tensor<3xi64>) -> tensor<2x3x4xi64>
+  %0 = "onnx.GatherElements"(%arg0, %indices) {axis = 1 : si64} : (tensor<2x3x4xf32>, tensor<2x3x4xi64>) -> tensor<2x3x4xf32>
+  "func.return"(%0) : (tensor<2x3x4xf32>) -> ()
+
+// CHECK-LABEL:  func @test_gather_elements_blocked
+// CHECK:           [[LOOP_0:%.+]]:2 = krnl.define_loops 2
+// CHECK:           krnl.iterate([[LOOP_0]]#0, [[LOOP_0]]#1) with ([[LOOP_0]]#0 -> [[I_0:%.+]] = 0 to 2, [[LOOP_0]]#1 -> [[I_1:%.+]] = 0 to 3){
+// CHECK:             [[INDEX:%.+]] = krnl.load {{.*}} : memref<2x3x4xi64>
+// CHECK:             arith.select
+// CHECK:             [[LOOP_1:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[LOOP_1]]) with ([[LOOP_1]] -> [[I_2:%.+]] = 0 to 4){
+// CHECK:               [[DATA_VAL:%.+]] = krnl.load {{.*}} : memref<2x3x4xf32>
+// CHECK:               krnl.store [[DATA_VAL]], {{.*}} : memref<2x3x4xf32>
+// CHECK:             }
+// CHECK:           }
+}
+
+// -----
+
 // COM: Test GatherElements along axis 1. Positive indices, so no select.
 func.func @test_gather_elements_axis1(%arg0 : tensor<3x2xf32>) -> tensor<2x2xf32> {
   %indices = onnx.Constant dense<[[0, 0], [1, 0]]> : tensor<2x2xi64>
@@ -1301,6 +1371,63 @@ func.func private @test_matmul1(%arg0 : tensor<16x16xf32>, %arg1 : tensor<16x16x
 // CHECK:         }
 }
 
+// -----
+// COM: 2D matmul large enough for the cache-blocked schedule with packed
+// COM: A and B tiles; J is a multiple of the register tile so the result is
+// COM: not buffered.
+func.func private @test_matmul1_tiled(%arg0 : tensor<64x256xf32>, %arg1 : tensor<256x128xf32>) -> tensor<*xf32> {
+  %0 ="onnx.MatMul"(%arg0, %arg1) : (tensor<64x256xf32>, tensor<256x128xf32>) -> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+// CHECK-LABEL:  func private @test_matmul1_tiled
+// CHECK-SAME:   ([[A_:%.+]]: memref<64x256xf32>, [[B_:%.+]]: memref<256x128xf32>) -> memref<64x128xf32> {
+// CHECK-DAG:       [[RES_:%.+]] = memref.alloc() {{.*}}: memref<64x128xf32>
+// CHECK-DAG:       [[A_BUFF_:%.+]] = memref.alloc() {{.*}}: memref<32x256xf32>
+// CHECK-DAG:       [[B_BUFF_:%.+]] = memref.alloc() {{.*}}: memref<256x64xf32>
+// CHECK:           krnl.memset [[RES_]], {{.*}} : memref<64x128xf32>
+// CHECK:           krnl.copy_to_tile_buffer [[B_BUFF_]], [[B_]]
+// CHECK:           krnl.copy_to_tile_buffer [[A_BUFF_]], [[A_]]
+// CHECK:           krnl.matmul [[A_BUFF_]]{{.*}}, [[B_BUFF_]]{{.*}}, [[RES_]]
+// CHECK:           return [[RES_]] : memref<64x128xf32>
+// CHECK:         }
+}
+
+// -----
+// COM: A constant B is packed into the tile layout at compile time: the
+// COM: packed krnl.global replaces the B buffer and its runtime copy.
+
+func.func private @test_matmul1_tiled_const_b(%arg0 : tensor<64x256xf32>) -> tensor<*xf32> {
+  %0 = onnx.Constant dense<1.0> : tensor<256x128xf32>
+  %1 ="onnx.MatMul"(%arg0, %0) : (tensor<64x256xf32>, tensor<256x128xf32>) -> tensor<*xf32>
+  "func.return"(%1) : (tensor<*xf32>) -> ()
+// CHECK-LABEL:  func private @test_matmul1_tiled_const_b
+// CHECK-SAME:   ([[A_:%.+]]: memref<64x256xf32>) -> memref<64x128xf32> {
+// CHECK-NOT:       memref.alloc() {{.*}}: memref<256x64xf32>
+// CHECK:           [[PACKED_B_:%.+]] = "krnl.global"() {name = "prepacked_weight{{.*}}", shape = [1, 2, 256, 64], value = dense<1.000000e+00> : tensor<1x2x256x64xf32>} : () -> memref<1x2x256x64xf32>
+// CHECK:           krnl.copy_to_tile_buffer [[A_BUFF_:%.+]], [[A_]]
+// CHECK:           krnl.matmul [[A_BUFF_]]{{.*}}, [[PACKED_B_]]{{.*}} : memref<32x256xf32>, memref<1x2x256x64xf32>, memref<64x128xf32>
+// CHECK-NOT:       krnl.copy_to_tile_buffer
+// CHECK:           return {{.*}} : memref<64x128xf32>
+// CHECK:         }
+}
+
+// -----
+// COM: Dynamic 2D matmul takes the cache-blocked schedule and must also
+// COM: buffer the result, as the simdized J dimension is unknown.
+func.func private @test_matmul1_tiled_dyn(%arg0 : tensor<?x?xf32>, %arg1 : tensor<?x?xf32>) -> tensor<*xf32> {
+  %0 ="onnx.MatMul"(%arg0, %arg1) : (tensor<?x?xf32>, tensor<?x?xf32>) -> tensor<*xf32>
+  "func.return"(%0) : (tensor<*xf32>) -> ()
+// CHECK-LABEL:  func private @test_matmul1_tiled_dyn
+// CHECK-DAG:       [[A_BUFF_:%.+]] = memref.alloc() {{.*}}: memref<32x256xf32>
+// CHECK-DAG:       [[B_BUFF_:%.+]] = memref.alloc() {{.*}}: memref<256x64xf32>
+// CHECK-DAG:       [[C_BUFF_:%.+]] = memref.alloc() {{.*}}: memref<32x64xf32>
+// CHECK:           krnl.copy_to_tile_buffer [[C_BUFF_]],
+// CHECK:           krnl.copy_to_tile_buffer [[A_BUFF_]],
+// CHECK:           krnl.copy_to_tile_buffer [[B_BUFF_]],
+// CHECK:           krnl.matmul [[A_BUFF_]]{{.*}}, [[B_BUFF_]]{{.*}}, [[C_BUFF_]]
+// CHECK:           krnl.copy_from_tile_buffer [[C_BUFF_]],
+// CHECK:         }
+}
+
 // -----
 // 2-D x N-D
 func.func private @test_matmul2(%arg0 : tensor<10x5xf32>, %arg1 : tensor<2x3x5x10xf32>) -> tensor<*xf32> {
@@ -1512,56 +1639,37 @@ func.func private @test_pool_unknown_dimensions(%arg0 : tensor<1x3x?x32xf32>) ->
   %0 = "onnx.AveragePool"(%arg0) {auto_pad = "NOTSET", kernel_shape = [2, 2]} : (tensor<1x3x?x32xf32>) -> tensor<*xf32>
   "func.return"(%0) : (tensor<*xf32>) -> ()
 
+// A dynamic spatial dimension does not block the full-window fast path: only
+// the kernel dims and pads must be known at compile time, so the pooling
+// loops still have constant bounds and the average divides by the constant
+// window size.
 // CHECK-DAG: [[MAP_0_:#.+]] = affine_map<()[s0] -> (s0 - 1)>
 // CHECK-DAG: [[MAP_1_:#.+]] = affine_map<(d0) -> (d0)>
-// CHECK-DAG: [[MAP_2_:#.+]] = affine_map<(d0) -> (0, d0)>
-// CHECK-DAG: [[MAP_3_:#.+]] = affine_map<(d0)[s0] -> (s0, d0 + 2)>
-// CHECK-DAG: [[MAP_4_:#.+]] = affine_map<(d0) -> (32, d0 + 2)>
-// CHECK-DAG: [[MAP_5_:#.+]] = affine_map<(d0)[s0, s1, s2, s3, s4] -> (s0 - ((s2 ceildiv s4) * s4 - s2), -(d0 * s3 - s2) + s0, d0 * s3 + (s1 - 1) * s4 - s2 - ((s2 ceildiv s4) * s4 - s2) + 1, d0 * s3 + (s1 - 1) * s4 - s2 - (d0 * s3 - s2) + 1)>
 // CHECK-LABEL:  func private @test_pool_unknown_dimensions
 // CHECK-SAME:   ([[PARAM_0_:%.+]]: memref<1x3x?x32xf32>) -> memref<1x3x?x31xf32> {
-// CHECK-DAG:       [[CST_32_:%.+]] = arith.constant 32 : index
-// CHECK-DAG:       [[CST_1_:%.+]] = arith.constant 1 : index
-// CHECK-DAG:       [[CST_0_:%.+]] = arith.constant 0 : index
+// CHECK-DAG:       [[CST_4_dot_000000_:%.+]] = arith.constant 4.000000e+00 : f32
 // CHECK-DAG:       [[CST_0_dot_000000_:%.+]] = arith.constant 0.000000e+00 : f32
 // CHECK-DAG:       [[CST_2_:%.+]] = arith.constant 2 : index
 // CHECK:           [[VAR_0_:%.+]] = memref.dim [[PARAM_0_]], [[CST_2_]] : memref<1x3x?x32xf32>
 // CHECK:           [[VAR_1_:%.+]] = affine.apply [[MAP_0_]](){{.}}[[VAR_0_]]{{.}}
-// CHECK-DAG:       [[VAR_2_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<1x3x?x31xf32>
-// CHECK-DAG:       [[VAR_4_:%.+]] = memref.alloca() : memref<f32>
+// CHECK-DAG:       [[RES_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<1x3x?x31xf32>
+// CHECK-DAG:       [[RES_1_:%.+]] = memref.alloca() : memref<f32>
 // CHECK-DAG:       [[LOOP_0_:%.+]]:4 = krnl.define_loops 4
 // CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 1, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 3, [[LOOP_0_]]#2 -> [[I_2_:%.+]] = 0 to [[MAP_1_]]([[VAR_1_]]), [[LOOP_0_]]#3 -> [[I_3_:%.+]] = 0 to 31){
 // CHECK:             [[IV:%.+]]:4 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) : (!krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index, index)
-// CHECK:             krnl.store [[CST_0_dot_000000_]], [[VAR_4_]][] : memref<f32>
-// CHECK-DAG:         [[VAR_5_:%.+]] = memref.dim [[PARAM_0_]], [[CST_2_]] : memref<1x3x?x32xf32>
-// CHECK-DAG:         [[VAR_6_:%.+]] = affine.max [[MAP_2_]]([[IV]]#2)
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:         [[VAR_7_:%.+]] = affine.min [[MAP_3_]]([[IV]]#2){{.}}[[VAR_5_]]{{.}}
-// CHECK-DAG:         [[VAR_8_:%.+]] = affine.max [[MAP_2_]]([[IV]]#3)
-// CHECK-DAG:         [[VAR_9_:%.+]] = affine.min [[MAP_4_]]([[IV]]#3)
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:         [[VAR_10_:%.+]] = arith.subi [[VAR_7_]], [[VAR_6_]] : index
-// CHECK-DAG:         [[VAR_11_:%.+]] = arith.subi [[VAR_9_]], [[VAR_8_]] : index
-// CHECK-DAG:         [[LOOP_1_:%.+]]:2 = krnl.define_loops 2
-// CHECK:             krnl.iterate([[LOOP_1_]]#0, [[LOOP_1_]]#1) with ([[LOOP_1_]]#0 -> [[I_4_:%.+]] = 0 to min [[MAP_5_]]([[IV]]#2){{.}}[[VAR_5_]], [[CST_2_]], [[CST_0_]], [[CST_1_]], [[CST_1_]]{{.}}, [[LOOP_1_]]#1 -> [[I_5_:%.+]] = 0 to min [[MAP_5_]]([[IV]]#3){{.}}[[CST_32_]], [[CST_2_]], [[CST_0_]], [[CST_1_]], [[CST_1_]]{{.}}){
-// CHECK-DAG:           [[VAR_19_:%.+]] = arith.addi [[I_4_]], [[VAR_6_]] : index
-// CHECK-DAG:           [[VAR_20_:%.+]] = arith.addi [[I_5_]], [[VAR_8_]] : index
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:           [[LOAD_PARAM_0_MEM_:%.+]] = krnl.load [[PARAM_0_]]{{.}}[[IV]]#0, [[IV]]#1, [[VAR_19_]], [[VAR_20_]]{{.}} : memref<1x3x?x32xf32>
-// CHECK-DAG:           [[LOAD_VAR_4_MEM_:%.+]] = krnl.load [[VAR_4_]][] : memref<f32>
-// CHECK:               [[VAR_23_:%.+]] = arith.addf [[LOAD_VAR_4_MEM_]], [[LOAD_PARAM_0_MEM_]] : f32
-// CHECK:               krnl.store [[VAR_23_]], [[VAR_4_]][] : memref<f32>
+// CHECK:             krnl.store [[CST_0_dot_000000_]], [[RES_1_]][] : memref<f32>
+// CHECK:             [[LOOP_1_:%.+]]:2 = krnl.define_loops 2
+// CHECK:             krnl.iterate([[LOOP_1_]]#0, [[LOOP_1_]]#1) with ([[LOOP_1_]]#0 -> [[I_4_:%.+]] = 0 to 2, [[LOOP_1_]]#1 -> [[I_5_:%.+]] = 0 to 2){
+// CHECK:               [[LOAD_PARAM_0_MEM_:%.+]] = krnl.load [[PARAM_0_]]{{.}}[[IV]]#0, [[IV]]#1, {{.*}}, {{.*}}] : memref<1x3x?x32xf32>
+// CHECK:               [[LOAD_RES_1_MEM_:%.+]] = krnl.load [[RES_1_]][] : memref<f32>
+// CHECK:               [[VAR_SUM_:%.+]] = arith.addf [[LOAD_RES_1_MEM_]], [[LOAD_PARAM_0_MEM_]] : f32
+// CHECK:               krnl.store [[VAR_SUM_]], [[RES_1_]][] : memref<f32>
 // CHECK:             }
-// CHECK:             [[LOAD_VAR_4_MEM_1_:%.+]] = krnl.load [[VAR_4_]][] : memref<f32>
-// CHECK:             krnl.store [[LOAD_VAR_4_MEM_1_]], [[VAR_2_]]{{.}}[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3{{.}} : memref<1x3x?x31xf32>
-// CHECK-DAG:         [[LOAD_VAR_2_MEM_:%.+]] = krnl.load [[VAR_2_]]{{.}}[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3{{.}} : memref<1x3x?x31xf32>
-// CHECK-DAG:         [[VAR_15_:%.+]] = arith.muli [[VAR_10_]], [[VAR_11_]] : index
-// CHECK:             [[VAR_16_:%.+]] = arith.index_cast [[VAR_15_]] : index to i64
-// CHECK:             [[VAR_17_:%.+]] = arith.sitofp [[VAR_16_]] : i64 to f32
-// CHECK:             [[VAR_18_:%.+]] = arith.divf [[LOAD_VAR_2_MEM_]], [[VAR_17_]] : f32
-// CHECK:             krnl.store [[VAR_18_]], [[VAR_2_]]{{.}}[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3{{.}} : memref<1x3x?x31xf32>
+// CHECK:             [[LOAD_RES_1_MEM_1_:%.+]] = krnl.load [[RES_1_]][] : memref<f32>
+// CHECK:             [[VAR_AVG_:%.+]] = arith.divf [[LOAD_RES_1_MEM_1_]], [[CST_4_dot_000000_]] : f32
+// CHECK:             krnl.store [[VAR_AVG_]], [[RES_]]{{.}}[[IV]]#0, [[IV]]#1, [[IV]]#2, [[IV]]#3{{.}} : memref<1x3x?x31xf32>
 // CHECK:           }
-// CHECK:           return [[VAR_2_]] : memref<1x3x?x31xf32>
+// CHECK:           return [[RES_]] : memref<1x3x?x31xf32>
 // CHECK:         }
 }
 
@@ -1919,29 +2027,27 @@ func.func private @test_softmax_v11(%arg0 : tensor<10x20x30xf32>) -> tensor<*xf3
 // CHECK-DAG:           [[VAR_10_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_1_]]#0, [[LOOP_1_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK-DAG:           [[LOAD_VAR_0_MEM_:%.+]] = krnl.load [[VAR_0_]][] : memref<f32>
 // CHECK:               [[LOAD_arg0_MEM_:%.+]] = krnl.load [[arg0_]]{{.}}[[VAR_4_]], [[VAR_10_]]#0, [[VAR_10_]]#1] : memref<10x20x30xf32>
-// CHECK:               [[VAR_13_:%.+]] = arith.cmpf ogt, [[LOAD_VAR_0_MEM_]], [[LOAD_arg0_MEM_]] : f32
-// CHECK:               [[VAR_14_:%.+]] = arith.select [[VAR_13_]], [[LOAD_VAR_0_MEM_]], [[LOAD_arg0_MEM_]] : f32
-// CHECK:               krnl.store [[VAR_14_]], [[VAR_0_]][] : memref<f32>
+// CHECK:               [[VAR_13_:%.+]] = arith.maxf [[LOAD_VAR_0_MEM_]], [[LOAD_arg0_MEM_]] : f32
+// CHECK:               [[VAR_14_:%.+]] = arith.subf [[LOAD_VAR_0_MEM_]], [[VAR_13_]] : f32
+// CHECK:               [[VAR_15_:%.+]] = math.exp [[VAR_14_]] : f32
+// CHECK:               [[VAR_16_:%.+]] = arith.subf [[LOAD_arg0_MEM_]], [[VAR_13_]] : f32
+// CHECK:               [[VAR_17_:%.+]] = math.exp [[VAR_16_]] : f32
+// CHECK:               [[LOAD_VAR_1_MEM_:%.+]] = krnl.load [[VAR_1_]][] : memref<f32>
+// CHECK:               [[VAR_19_:%.+]] = arith.mulf [[LOAD_VAR_1_MEM_]], [[VAR_15_]] : f32
+// CHECK:               [[VAR_20_:%.+]] = arith.addf [[VAR_19_]], [[VAR_17_]] : f32
+// CHECK:               krnl.store [[VAR_13_]], [[VAR_0_]][] : memref<f32>
+// CHECK:               krnl.store [[VAR_20_]], [[VAR_1_]][] : memref<f32>
 // CHECK:             }
 // CHECK-DAG:         [[LOAD_VAR_0_MEM_1_:%.+]] = krnl.load [[VAR_0_]][] : memref<f32>
+// CHECK-DAG:         [[LOAD_VAR_1_MEM_1_:%.+]] = krnl.load [[VAR_1_]][] : memref<f32>
 // CHECK-DAG:         [[LOOP_2_:%.+]]:2 = krnl.define_loops 2
 // CHECK:             krnl.iterate([[LOOP_2_]]#0, [[LOOP_2_]]#1) with ([[LOOP_2_]]#0 -> [[I_3_:%.+]] = 0 to 20, [[LOOP_2_]]#1 -> [[I_4_:%.+]] = 0 to 30){
-// CHECK-DAG:           [[VAR_10_1_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_2_]]#0, [[LOOP_2_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK-DAG:           [[LOAD_VAR_0_MEM_2_:%.+]] = krnl.load [[VAR_1_]][] : memref<f32>
+// CHECK:               [[VAR_10_1_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_2_]]#0, [[LOOP_2_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
 // CHECK:               [[LOAD_arg0_MEM_1_:%.+]] = krnl.load [[arg0_]]{{.}}[[VAR_4_]], [[VAR_10_1_]]#0, [[VAR_10_1_]]#1] : memref<10x20x30xf32>
 // CHECK:               [[VAR_13_1_:%.+]] = arith.subf [[LOAD_arg0_MEM_1_]], [[LOAD_VAR_0_MEM_1_]] : f32
 // CHECK:               [[VAR_14_1_:%.+]] = math.exp [[VAR_13_1_]] : f32
-// CHECK:               [[VAR_15_:%.+]] = arith.addf [[LOAD_VAR_0_MEM_2_]], [[VAR_14_1_]] : f32
-// CHECK:               krnl.store [[VAR_15_]], [[VAR_1_]][] : memref<f32>
-// CHECK:               krnl.store [[VAR_14_1_]], [[VAR_2_]]{{.}}[[VAR_4_]], [[VAR_10_1_]]#0, [[VAR_10_1_]]#1] : memref<10x20x30xf32>
-// CHECK:             }
-// CHECK-DAG:         [[LOAD_VAR_1_MEM_:%.+]] = krnl.load [[VAR_1_]][] : memref<f32>
-// CHECK-DAG:         [[LOOP_3_:%.+]]:2 = krnl.define_loops 2
-// CHECK:             krnl.iterate([[LOOP_3_]]#0, [[LOOP_3_]]#1) with ([[LOOP_3_]]#0 -> [[I_5_:%.+]] = 0 to 20, [[LOOP_3_]]#1 -> [[I_6_:%.+]] = 0 to 30){
-// CHECK:               [[VAR_10_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_3_]]#0, [[LOOP_3_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:               [[LOAD_VAR_0_MEM_2_:%.+]] = krnl.load [[VAR_2_]]{{.}}[[VAR_4_]], [[VAR_10_2_]]#0, [[VAR_10_2_]]#1] : memref<10x20x30xf32>
-// CHECK:               [[LOAD_arg0_MEM_1_:%.+]] = arith.divf [[LOAD_VAR_0_MEM_2_]], [[LOAD_VAR_1_MEM_]] : f32
-// CHECK:               krnl.store [[LOAD_arg0_MEM_1_]], [[VAR_2_]]{{.}}[[VAR_4_]], [[VAR_10_2_]]#0, [[VAR_10_2_]]#1] : memref<10x20x30xf32>
+// CHECK:               [[VAR_15_1_:%.+]] = arith.divf [[VAR_14_1_]], [[LOAD_VAR_1_MEM_1_]] : f32
+// CHECK:               krnl.store [[VAR_15_1_]], [[VAR_2_]]{{.}}[[VAR_4_]], [[VAR_10_1_]]#0, [[VAR_10_1_]]#1] : memref<10x20x30xf32>
 // CHECK:             }
 // CHECK:           }
 // CHECK:           return [[VAR_2_]] : memref<10x20x30xf32>
@@ -1972,29 +2078,27 @@ func.func private @test_softmax_v13(%arg0 : tensor<10x20x30xf32>) -> tensor<*xf3
 // CHECK-DAG:           [[VAR_10_:%.+]] = krnl.get_induction_var_value([[LOOP_1_]]) : (!krnl.loop) -> index
 // CHECK-DAG:           [[LOAD_VAR_0_MEM_:%.+]] = krnl.load [[VAR_0_]][] : memref<f32>
 // CHECK:               [[LOAD_arg0_MEM_:%.+]] = krnl.load [[arg0_]]{{.}}[[VAR_4_]]#0, [[VAR_10_]], [[VAR_4_]]#1] : memref<10x20x30xf32>
-// CHECK:               [[VAR_13_:%.+]] = arith.cmpf ogt, [[LOAD_VAR_0_MEM_]], [[LOAD_arg0_MEM_]] : f32
-// CHECK:               [[VAR_14_:%.+]] = arith.select [[VAR_13_]], [[LOAD_VAR_0_MEM_]], [[LOAD_arg0_MEM_]] : f32
-// CHECK:               krnl.store [[VAR_14_]], [[VAR_0_]][] : memref<f32>
+// CHECK:               [[VAR_13_:%.+]] = arith.maxf [[LOAD_VAR_0_MEM_]], [[LOAD_arg0_MEM_]] : f32
+// CHECK:               [[VAR_14_:%.+]] = arith.subf [[LOAD_VAR_0_MEM_]], [[VAR_13_]] : f32
+// CHECK:               [[VAR_15_:%.+]] = math.exp [[VAR_14_]] : f32
+// CHECK:               [[VAR_16_:%.+]] = arith.subf [[LOAD_arg0_MEM_]], [[VAR_13_]] : f32
+// CHECK:               [[VAR_17_:%.+]] = math.exp [[VAR_16_]] : f32
+// CHECK:               [[LOAD_VAR_1_MEM_:%.+]] = krnl.load [[VAR_1_]][] : memref<f32>
+// CHECK:               [[VAR_19_:%.+]] = arith.mulf [[LOAD_VAR_1_MEM_]], [[VAR_15_]] : f32
+// CHECK:               [[VAR_20_:%.+]] = arith.addf [[VAR_19_]], [[VAR_17_]] : f32
+// CHECK:               krnl.store [[VAR_13_]], [[VAR_0_]][] : memref<f32>
+// CHECK:               krnl.store [[VAR_20_]], [[VAR_1_]][] : memref<f32>
 // CHECK:             }
 // CHECK-DAG:         [[LOAD_VAR_0_MEM_1_:%.+]] = krnl.load [[VAR_0_]][] : memref<f32>
+// CHECK-DAG:         [[LOAD_VAR_1_MEM_1_:%.+]] = krnl.load [[VAR_1_]][] : memref<f32>
 // CHECK-DAG:         [[LOOP_2_:%.+]] = krnl.define_loops 1
 // CHECK:             krnl.iterate([[LOOP_2_]]) with ([[LOOP_2_]] -> [[I_3_:%.+]] = 0 to 20){
-// CHECK-DAG:           [[VAR_10_1_:%.+]] = krnl.get_induction_var_value([[LOOP_2_]]) : (!krnl.loop) -> index
-// CHECK-DAG:           [[LOAD_VAR_0_MEM_2_:%.+]] = krnl.load [[VAR_1_]][] : memref<f32>
+// CHECK:               [[VAR_10_1_:%.+]] = krnl.get_induction_var_value([[LOOP_2_]]) : (!krnl.loop) -> index
 // CHECK:               [[LOAD_arg0_MEM_1_:%.+]] = krnl.load [[arg0_]]{{.}}[[VAR_4_]]#0, [[VAR_10_1_]], [[VAR_4_]]#1] : memref<10x20x30xf32>
 // CHECK:               [[VAR_13_1_:%.+]] = arith.subf [[LOAD_arg0_MEM_1_]], [[LOAD_VAR_0_MEM_1_]] : f32
 // CHECK:               [[VAR_14_1_:%.+]] = math.exp [[VAR_13_1_]] : f32
-// CHECK:               [[VAR_15_:%.+]] = arith.addf [[LOAD_VAR_0_MEM_2_]], [[VAR_14_1_]] : f32
-// CHECK:               krnl.store [[VAR_15_]], [[VAR_1_]][] : memref<f32>
-// CHECK:               krnl.store [[VAR_14_1_]], [[VAR_2_]]{{.}}[[VAR_4_]]#0, [[VAR_10_1_]], [[VAR_4_]]#1] : memref<10x20x30xf32>
-// CHECK:             }
-// CHECK-DAG:         [[LOAD_VAR_1_MEM_:%.+]] = krnl.load [[VAR_1_]][] : memref<f32>
-// CHECK-DAG:         [[LOOP_3_:%.+]] = krnl.define_loops 1
-// CHECK:             krnl.iterate([[LOOP_3_]]) with ([[LOOP_3_]] -> [[I_4_:%.+]] = 0 to 20){
-// CHECK:               [[VAR_10_2_:%.+]] = krnl.get_induction_var_value([[LOOP_3_]]) : (!krnl.loop) -> index
-// CHECK:               [[LOAD_VAR_0_MEM_2_:%.+]] = krnl.load [[VAR_2_]]{{.}}[[VAR_4_]]#0, [[VAR_10_2_]], [[VAR_4_]]#1] : memref<10x20x30xf32>
-// CHECK:               [[LOAD_arg0_MEM_1_:%.+]] = arith.divf [[LOAD_VAR_0_MEM_2_]], [[LOAD_VAR_1_MEM_]] : f32
-// CHECK:               krnl.store [[LOAD_arg0_MEM_1_]], [[VAR_2_]]{{.}}[[VAR_4_]]#0, [[VAR_10_2_]], [[VAR_4_]]#1] : memref<10x20x30xf32>
+// CHECK:               [[VAR_15_1_:%.+]] = arith.divf [[VAR_14_1_]], [[LOAD_VAR_1_MEM_1_]] : f32
+// CHECK:               krnl.store [[VAR_15_1_]], [[VAR_2_]]{{.}}[[VAR_4_]]#0, [[VAR_10_1_]], [[VAR_4_]]#1] : memref<10x20x30xf32>
 // CHECK:             }
 // CHECK:           }
 // CHECK:           return [[VAR_2_]] : memref<10x20x30xf32>
@@ -2527,21 +2631,71 @@ func.func @test_expand_with_arith_constant(%arg0 : tensor<2x1x6x1xf32>) -> tenso
   %1 = "onnx.Expand"(%arg0, %0) : (tensor<2x1x6x1xf32>, tensor<3xi64>) -> tensor<*xf32>
   "func.return"(%1) : (tensor<*xf32>) -> ()
 
-// mlir2FileCheck.py -a'["input", "shape"]'
+// The innermost expanded dimension (extent 5) becomes the innermost loop,
+// so each input element is loaded once and stored to its five replicas.
 // CHECK-LABEL:  func @test_expand_with_arith_constant
 // CHECK-SAME:   ([[INPUT_:%.+]]: memref<2x1x6x1xf32>) -> memref<2x7x6x5xf32> {
 // CHECK-DAG:       [[CST_0_:%.+]] = arith.constant 0 : index
 // CHECK-DAG:       [[RES_:%.+]] = memref.alloc() {{.*}}: memref<2x7x6x5xf32>
-// CHECK-DAG:       [[LOOP_0_:%.+]]:4 = krnl.define_loops 4
-// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) with ([[LOOP_0_]]#0 -> [[SHAPE_:%.+]] = 0 to 2, [[LOOP_0_]]#1 -> [[I_0_:%.+]] = 0 to 7, [[LOOP_0_]]#2 -> [[I_1_:%.+]] = 0 to 6, [[LOOP_0_]]#3 -> [[I_2_:%.+]] = 0 to 5){
-// CHECK:             [[VAR_2_:%.+]]:4 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2, [[LOOP_0_]]#3) : (!krnl.loop, !krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index, index)
+// CHECK-DAG:       [[LOOP_0_:%.+]]:3 = krnl.define_loops 3
+// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 2, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 7, [[LOOP_0_]]#2 -> [[I_2_:%.+]] = 0 to 6){
+// CHECK:             [[VAR_2_:%.+]]:3 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1, [[LOOP_0_]]#2) : (!krnl.loop, !krnl.loop, !krnl.loop) -> (index, index, index)
 // CHECK:             [[LOAD_INPUT_MEM_:%.+]] = krnl.load [[INPUT_]]{{.}}[[VAR_2_]]#0, [[CST_0_]], [[VAR_2_]]#2, [[CST_0_]]{{.}} : memref<2x1x6x1xf32>
-// CHECK:             krnl.store [[LOAD_INPUT_MEM_]], [[RES_]]{{.}}[[VAR_2_]]#0, [[VAR_2_]]#1, [[VAR_2_]]#2, [[VAR_2_]]#3] : memref<2x7x6x5xf32>
+// CHECK:             [[LOOP_1_:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[LOOP_1_]]) with ([[LOOP_1_]] -> [[I_3_:%.+]] = 0 to 5){
+// CHECK:               [[VAR_4_:%.+]] = krnl.get_induction_var_value([[LOOP_1_]]) : (!krnl.loop) -> index
+// CHECK:               krnl.store [[LOAD_INPUT_MEM_]], [[RES_]]{{.}}[[VAR_2_]]#0, [[VAR_2_]]#1, [[VAR_2_]]#2, [[VAR_4_]]{{.}} : memref<2x7x6x5xf32>
+// CHECK:             }
 // CHECK:           }
 // CHECK:           return [[RES_]] : memref<2x7x6x5xf32>
 // CHECK:         }
 }
 
+// -----
+
+func.func @test_expand_block_copy(%arg0 : tensor<1x64x32xf32>) -> tensor<*xf32> {
+  %0 = onnx.Constant dense<[8, 64, 32]> : tensor<3xi64>
+  %1 = "onnx.Expand"(%arg0, %0) : (tensor<1x64x32xf32>, tensor<3xi64>) -> tensor<*xf32>
+  "func.return"(%1) : (tensor<*xf32>) -> ()
+
+// The trailing 64x32 block matches the input, so it is replicated along the
+// leading dimension with one wide load per vector and eight wide stores.
+// CHECK-LABEL:  func @test_expand_block_copy
+// CHECK-SAME:   ([[INPUT_:%.+]]: memref<1x64x32xf32>) -> memref<8x64x32xf32> {
+// CHECK-DAG:       [[CST_0_:%.+]] = arith.constant 0 : index
+// CHECK-DAG:       [[RES_:%.+]] = memref.alloc() {{.*}}: memref<8x64x32xf32>
+// CHECK:           [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           [[BLOCK_TILE_:%.+]], [[BLOCK_IN_:%.+]] = krnl.block [[LOOP_0_]]#1 4 : (!krnl.loop) -> (!krnl.loop, !krnl.loop)
+// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[BLOCK_TILE_]]) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 64, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 32){
+// CHECK:             [[VAR_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[BLOCK_TILE_]]) : (!krnl.loop, !krnl.loop) -> (index, index)
+// CHECK:             [[LOAD_INPUT_MEM_:%.+]] = vector.load [[INPUT_]]{{.}}[[CST_0_]], [[VAR_2_]]#0, [[VAR_2_]]#1] : memref<1x64x32xf32>, vector<4xf32>
+// CHECK:             [[LOOP_1_:%.+]] = krnl.define_loops 1
+// CHECK:             krnl.iterate([[LOOP_1_]]) with ([[LOOP_1_]] -> [[I_2_:%.+]] = 0 to 8){
+// CHECK:               [[VAR_4_:%.+]] = krnl.get_induction_var_value([[LOOP_1_]]) : (!krnl.loop) -> index
+// CHECK:               vector.store [[LOAD_INPUT_MEM_]], [[RES_]]{{.}}[[VAR_4_]], [[VAR_2_]]#0, [[VAR_2_]]#1] : memref<8x64x32xf32>, vector<4xf32>
+// CHECK:             }
+// CHECK:           }
+// CHECK:           return [[RES_]] : memref<8x64x32xf32>
+// CHECK:         }
+}
+
+// -----
+
+func.func @test_expand_noop(%arg0 : tensor<2x3x4xf32>) -> tensor<*xf32> {
+  %0 = onnx.Constant dense<[2, 3, 4]> : tensor<3xi64>
+  %1 = "onnx.Expand"(%arg0, %0) : (tensor<2x3x4xf32>, tensor<3xi64>) -> tensor<*xf32>
+  "func.return"(%1) : (tensor<*xf32>) -> ()
+
+// An expand that adds no extent collapses into a single copy.
+// CHECK-LABEL:  func @test_expand_noop
+// CHECK-SAME:   ([[INPUT_:%.+]]: memref<2x3x4xf32>) -> memref<2x3x4xf32> {
+// CHECK:           [[RES_:%.+]] = memref.alloc() {{.*}}: memref<2x3x4xf32>
+// CHECK:           "krnl.memcpy"([[RES_]], [[INPUT_]], %{{.*}}) : (memref<2x3x4xf32>, memref<2x3x4xf32>, i64) -> ()
+// CHECK-NOT:       krnl.iterate
+// CHECK:           return [[RES_]] : memref<2x3x4xf32>
+// CHECK:         }
+}
+
 // -----
 
   func.func @expand_dyn(%arg0: tensor<?x?xf32>, %arg1: tensor<2xi64>) -> tensor<?x?xf32>  {
@@ -3579,28 +3733,24 @@ func.func @top_k(%arg0: tensor<3x4xf32>, %arg1: tensor<1xi64>) -> (tensor<*xf32>
 // mlir2FileCheck.py -a'["X", "K"]'
 // CHECK-LABEL:  func @top_k
 // CHECK-SAME:   ([[X_:%.+]]: memref<3x4xf32>, [[K_:%.+]]: memref<1xi64>) -> (memref<3x?xf32>, memref<3x?xi64>) {
-// CHECK:           [[VAR_c0_i64_:%.+]] = arith.constant 0 : i64
-// CHECK:           [[VAR_c1_i64_:%.+]] = arith.constant 1 : i64
-// CHECK:           [[VAR_c0_:%.+]] = arith.constant 0 : index
+// CHECK-DAG:       [[VAR_c0_i64_:%.+]] = arith.constant 0 : i64
+// CHECK-DAG:       [[VAR_c1_i64_:%.+]] = arith.constant 1 : i64
+// CHECK-DAG:       [[VAR_c0_:%.+]] = arith.constant 0 : index
 // CHECK:           [[LOAD_K_MEM_:%.+]] = krnl.load [[K_]]{{.}}[[VAR_c0_]]{{.}} : memref<1xi64>
 // CHECK:           [[VAR_1_:%.+]] = arith.index_cast [[LOAD_K_MEM_]] : i64 to index
 // CHECK-DAG:       [[RES_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<3x?xf32>
 // CHECK-DAG:       [[RES_1_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<3x?xi64>
-// CHECK-DAG:       [[RES_2_:%.+]] = memref.alloc() {{.*}}: memref<3x4xindex>
-// CHECK-DAG:       [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 3, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 4){
-// CHECK:             [[VAR_8_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[VAR_8_]]#1, [[RES_2_]]{{.}}[[VAR_8_]]#0, [[VAR_8_]]#1] : memref<3x4xindex>
-// CHECK:           }
-// CHECK:           "krnl.call"([[RES_2_]], [[X_]], [[VAR_c1_i64_]], [[VAR_c0_i64_]]) {funcName = "omTensorSort"} : (memref<3x4xindex>, memref<3x4xf32>, i64, i64) -> ()
-// CHECK:           [[LOOP_1_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_1_]]#0, [[LOOP_1_]]#1) with ([[LOOP_1_]]#0 -> [[I_5_:%.+]] = 0 to 3, [[LOOP_1_]]#1 -> [[I_6_:%.+]] = 0 to [[VAR_1_]]){
-// CHECK:             [[VAR_8_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_1_]]#0, [[LOOP_1_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_2_]]{{.}}[[VAR_8_2_]]#0, [[VAR_8_2_]]#1] : memref<3x4xindex>
-// CHECK:             [[LOAD_X_MEM_2_:%.+]] = krnl.load [[X_]]{{.}}[[VAR_8_2_]]#0, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<3x4xf32>
-// CHECK:             krnl.store [[LOAD_X_MEM_2_]], [[RES_]]{{.}}[[VAR_8_2_]]#0, [[VAR_8_2_]]#1] : memref<3x?xf32>
-// CHECK:             [[LOAD_RES_2_MEM_3_:%.+]] = arith.index_cast [[LOAD_RES_2_MEM_2_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_2_MEM_3_]], [[RES_1_]]{{.}}[[VAR_8_2_]]#0, [[VAR_8_2_]]#1] : memref<3x?xi64>
+// CHECK-DAG:       [[RES_2_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<3x?xindex>
+// CHECK:           [[LOAD_K_MEM_1_:%.+]] = krnl.load [[K_]]{{.}}[[VAR_c0_]]{{.}} : memref<1xi64>
+// CHECK:           "krnl.call"([[RES_2_]], [[X_]], [[VAR_c1_i64_]], [[VAR_c0_i64_]], [[LOAD_K_MEM_1_]]) {funcName = "omTensorTopK"} : (memref<3x?xindex>, memref<3x4xf32>, i64, i64, i64) -> ()
+// CHECK:           [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 3, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to [[VAR_1_]]){
+// CHECK:             [[VAR_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
+// CHECK:             [[LOAD_RES_2_MEM_:%.+]] = krnl.load [[RES_2_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<3x?xindex>
+// CHECK:             [[LOAD_X_MEM_:%.+]] = krnl.load [[X_]]{{.}}[[VAR_4_]]#0, [[LOAD_RES_2_MEM_]]{{.}} : memref<3x4xf32>
+// CHECK:             krnl.store [[LOAD_X_MEM_]], [[RES_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<3x?xf32>
+// CHECK:             [[VAR_7_:%.+]] = arith.index_cast [[LOAD_RES_2_MEM_]] : index to i64
+// CHECK:             krnl.store [[VAR_7_]], [[RES_1_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<3x?xi64>
 // CHECK:           }
 // CHECK:           return [[RES_]], [[RES_1_]] : memref<3x?xf32>, memref<3x?xi64>
 // CHECK:         }
@@ -3615,27 +3765,23 @@ func.func @top_k_smallest(%arg0: tensor<3x4xf32>, %arg1: tensor<1xi64>) -> (tens
 // mlir2FileCheck.py -a'["X", "K"]'
 // CHECK-LABEL:  func @top_k_smallest
 // CHECK-SAME:   ([[X_:%.+]]: memref<3x4xf32>, [[K_:%.+]]: memref<1xi64>) -> (memref<3x?xf32>, memref<3x?xi64>) {
-// CHECK:           [[VAR_c1_i64_:%.+]] = arith.constant 1 : i64
-// CHECK:           [[VAR_c0_:%.+]] = arith.constant 0 : index
+// CHECK-DAG:       [[VAR_c1_i64_:%.+]] = arith.constant 1 : i64
+// CHECK-DAG:       [[VAR_c0_:%.+]] = arith.constant 0 : index
 // CHECK:           [[LOAD_K_MEM_:%.+]] = krnl.load [[K_]]{{.}}[[VAR_c0_]]{{.}} : memref<1xi64>
 // CHECK:           [[VAR_1_:%.+]] = arith.index_cast [[LOAD_K_MEM_]] : i64 to index
 // CHECK-DAG:       [[RES_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<3x?xf32>
 // CHECK-DAG:       [[RES_1_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<3x?xi64>
-// CHECK-DAG:       [[RES_2_:%.+]] = memref.alloc() {{.*}}: memref<3x4xindex>
-// CHECK-DAG:       [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 3, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to 4){
-// CHECK:             [[VAR_8_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[VAR_8_]]#1, [[RES_2_]]{{.}}[[VAR_8_]]#0, [[VAR_8_]]#1] : memref<3x4xindex>
-// CHECK:           }
-// CHECK:           "krnl.call"([[RES_2_]], [[X_]], [[VAR_c1_i64_]], [[VAR_c1_i64_]]) {funcName = "omTensorSort"} : (memref<3x4xindex>, memref<3x4xf32>, i64, i64) -> ()
-// CHECK:           [[LOOP_1_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_1_]]#0, [[LOOP_1_]]#1) with ([[LOOP_1_]]#0 -> [[I_5_:%.+]] = 0 to 3, [[LOOP_1_]]#1 -> [[I_6_:%.+]] = 0 to [[VAR_1_]]){
-// CHECK:             [[VAR_8_2_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_1_]]#0, [[LOOP_1_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOAD_RES_2_MEM_2_:%.+]] = krnl.load [[RES_2_]]{{.}}[[VAR_8_2_]]#0, [[VAR_8_2_]]#1] : memref<3x4xindex>
-// CHECK:             [[LOAD_X_MEM_2_:%.+]] = krnl.load [[X_]]{{.}}[[VAR_8_2_]]#0, [[LOAD_RES_2_MEM_2_]]{{.}} : memref<3x4xf32>
-// CHECK:             krnl.store [[LOAD_X_MEM_2_]], [[RES_]]{{.}}[[VAR_8_2_]]#0, [[VAR_8_2_]]#1] : memref<3x?xf32>
-// CHECK:             [[LOAD_RES_2_MEM_3_:%.+]] = arith.index_cast [[LOAD_RES_2_MEM_2_]] : index to i64
-// CHECK:             krnl.store [[LOAD_RES_2_MEM_3_]], [[RES_1_]]{{.}}[[VAR_8_2_]]#0, [[VAR_8_2_]]#1] : memref<3x?xi64>
+// CHECK-DAG:       [[RES_2_:%.+]] = memref.alloc([[VAR_1_]]) {{.*}}: memref<3x?xindex>
+// CHECK:           [[LOAD_K_MEM_1_:%.+]] = krnl.load [[K_]]{{.}}[[VAR_c0_]]{{.}} : memref<1xi64>
+// CHECK:           "krnl.call"([[RES_2_]], [[X_]], [[VAR_c1_i64_]], [[VAR_c1_i64_]], [[LOAD_K_MEM_1_]]) {funcName = "omTensorTopK"} : (memref<3x?xindex>, memref<3x4xf32>, i64, i64, i64) -> ()
+// CHECK:           [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to 3, [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to [[VAR_1_]]){
+// CHECK:             [[VAR_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
+// CHECK:             [[LOAD_RES_2_MEM_:%.+]] = krnl.load [[RES_2_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<3x?xindex>
+// CHECK:             [[LOAD_X_MEM_:%.+]] = krnl.load [[X_]]{{.}}[[VAR_4_]]#0, [[LOAD_RES_2_MEM_]]{{.}} : memref<3x4xf32>
+// CHECK:             krnl.store [[LOAD_X_MEM_]], [[RES_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<3x?xf32>
+// CHECK:             [[VAR_7_:%.+]] = arith.index_cast [[LOAD_RES_2_MEM_]] : index to i64
+// CHECK:             krnl.store [[VAR_7_]], [[RES_1_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<3x?xi64>
 // CHECK:           }
 // CHECK:           return [[RES_]], [[RES_1_]] : memref<3x?xf32>, memref<3x?xi64>
 // CHECK:         }
@@ -3648,15 +3794,12 @@ func.func @top_k_unknown_dims(%arg0: tensor<?x?xf32>, %arg1: tensor<1xi64>) -> (
   return %Values, %Indices : tensor<*xf32>, tensor<*xi64>
 
 // mlir2FileCheck.py -a'["X", "K"]'
-// CHECK-DAG:   [[MAP_0_:#.+]] = affine_map<(d0, d1) -> (d0, d1)>
-// CHECK-DAG:   [[MAP_1_:#.+]] = affine_map<(d0) -> (d0)>
-// CHECK-DAG:   [[MAP_2_:#.+]] = affine_map<(d0, d1) -> (d1)>
-// CHECK-DAG:   [[MAP_3_:#.+]] = affine_map<(d0)[s0] -> (s0)>
+// CHECK-DAG:   [[MAP_0_:#.+]] = affine_map<(d0) -> (d0)>
+// CHECK-DAG:   [[MAP_1_:#.+]] = affine_map<(d0)[s0] -> (s0)>
 // CHECK-LABEL:  func.func @top_k_unknown_dims
 // CHECK-SAME:   ([[X_:%.+]]: memref<?x?xf32>, [[K_:%.+]]: memref<1xi64>) -> (memref<?x?xf32>, memref<?x?xi64>) {
 // CHECK-DAG:       [[CST_0_:%.+]] = arith.constant 0 : i64
 // CHECK-DAG:       [[CST_1_:%.+]] = arith.constant 1 : i64
-// CHECK-DAG:       [[CST_1_1_:%.+]] = arith.constant 1 : index
 // CHECK-DAG:       [[CST_0_1_:%.+]] = arith.constant 0 : index
 // CHECK:           [[LOAD_K_MEM_:%.+]] = krnl.load [[K_]]{{.}}[[CST_0_1_]]{{.}} : memref<1xi64>
 // CHECK-DAG:       [[VAR_1_:%.+]] = arith.index_cast [[LOAD_K_MEM_]] : i64 to index
@@ -3664,26 +3807,19 @@ func.func @top_k_unknown_dims(%arg0: tensor<?x?xf32>, %arg1: tensor<1xi64>) -> (
 // CHECK-NOT: separator of consecutive DAGs
 // CHECK-DAG:       [[RES_:%.+]] = memref.alloc([[VAR_dim_]], [[VAR_1_]]) {{.*}}: memref<?x?xf32>
 // CHECK-DAG:       [[RES_1_:%.+]] = memref.alloc([[VAR_dim_]], [[VAR_1_]]) {{.*}}: memref<?x?xi64>
-// CHECK-DAG:       [[VAR_dim_1_:%.+]] = memref.dim [[X_]], [[CST_0_1_]] : memref<?x?xf32>
-// CHECK-DAG:       [[VAR_dim_2_:%.+]] = memref.dim [[X_]], [[CST_1_1_]] : memref<?x?xf32>
-// CHECK-NOT: separator of consecutive DAGs
-// CHECK-DAG:       [[RES_2_:%.+]] = memref.alloc([[VAR_dim_1_]], [[VAR_dim_2_]]) {{.*}}: memref<?x?xindex>
-// CHECK-DAG:       [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to [[MAP_1_]]([[VAR_dim_1_]]), [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to [[MAP_2_]]([[VAR_dim_1_]], [[VAR_dim_2_]])){
+// CHECK-DAG:       [[RES_2_:%.+]] = memref.alloc([[VAR_dim_]], [[VAR_1_]]) {{.*}}: memref<?x?xindex>
+// CHECK:           [[LOAD_K_MEM_1_:%.+]] = krnl.load [[K_]]{{.}}[[CST_0_1_]]{{.}} : memref<1xi64>
+// CHECK:           "krnl.call"([[RES_2_]], [[X_]], [[CST_1_]], [[CST_0_]], [[LOAD_K_MEM_1_]]) {funcName = "omTensorTopK"} : (memref<?x?xindex>, memref<?x?xf32>, i64, i64, i64) -> ()
+// CHECK:           [[LOOP_0_:%.+]]:2 = krnl.define_loops 2
+// CHECK:           krnl.iterate([[LOOP_0_]]#0, [[LOOP_0_]]#1) with ([[LOOP_0_]]#0 -> [[I_0_:%.+]] = 0 to [[MAP_0_]]([[VAR_dim_]]), [[LOOP_0_]]#1 -> [[I_1_:%.+]] = 0 to [[MAP_1_]]([[VAR_dim_]]){{.}}[[VAR_1_]]{{.}}){
 // CHECK:             [[VAR_4_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_0_]]#0, [[LOOP_0_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             krnl.store [[VAR_4_]]#1, [[RES_2_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<?x?xindex>
-// CHECK:           }
-// CHECK:           "krnl.call"([[RES_2_]], [[X_]], [[CST_1_]], [[CST_0_]]) {funcName = "omTensorSort"} : (memref<?x?xindex>, memref<?x?xf32>, i64, i64) -> ()
-// CHECK:           [[LOOP_1_:%.+]]:2 = krnl.define_loops 2
-// CHECK:           krnl.iterate([[LOOP_1_]]#0, [[LOOP_1_]]#1) with ([[LOOP_1_]]#0 -> [[I_2_:%.+]] = 0 to [[MAP_1_]]([[VAR_dim_]]), [[LOOP_1_]]#1 -> [[I_3_:%.+]] = 0 to [[MAP_3_]]([[VAR_dim_]]){{.}}[[VAR_1_]]{{.}}){
-// CHECK:             [[VAR_4_1_:%.+]]:2 = krnl.get_induction_var_value([[LOOP_1_]]#0, [[LOOP_1_]]#1) : (!krnl.loop, !krnl.loop) -> (index, index)
-// CHECK:             [[LOAD_RES_2_MEM_:%.+]] = krnl.load [[RES_2_]]{{.}}[[VAR_4_1_]]#0, [[VAR_4_1_]]#1] : memref<?x?xindex>
-// CHECK:             [[LOAD_X_MEM_:%.+]] = krnl.load [[X_]]{{.}}[[VAR_4_1_]]#0, [[LOAD_RES_2_MEM_]]{{.}} : memref<?x?xf32>
-// CHECK:             krnl.store [[LOAD_X_MEM_]], [[RES_]]{{.}}[[VAR_4_1_]]#0, [[VAR_4_1_]]#1] : memref<?x?xf32>
+// CHECK:             [[LOAD_RES_2_MEM_:%.+]] = krnl.load [[RES_2_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<?x?xindex>
+// CHECK:             [[LOAD_X_MEM_:%.+]] = krnl.load [[X_]]{{.}}[[VAR_4_]]#0, [[LOAD_RES_2_MEM_]]{{.}} : memref<?x?xf32>
+// CHECK:             krnl.store [[LOAD_X_MEM_]], [[RES_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<?x?xf32>
 // CHECK:             [[VAR_7_:%.+]] = arith.index_cast [[LOAD_RES_2_MEM_]] : index to i64
-// CHECK:             krnl.store [[VAR_7_]], [[RES_1_]]{{.}}[[VAR_4_1_]]#0, [[VAR_4_1_]]#1] : memref<?x?xi64>
+// CHECK:             krnl.store [[VAR_7_]], [[RES_1_]]{{.}}[[VAR_4_]]#0, [[VAR_4_]]#1] : memref<?x?xi64>
 // CHECK:           }
-// CHECK:           return [[RES_]], [[RES_]]_0 : memref<?x?xf32>, memref<?x?xi64>
+// CHECK:           return [[RES_]], [[RES_1_]] : memref<?x?xf32>, memref<?x?xi64>
 // CHECK:         }
 }
 
@@ -3732,8 +3868,7 @@ func.func @test_loop_tiny_yolo() -> tensor<?xi32> {
 // CHECK:               [[LOAD_VAR_16_MEM_:%.+]] = krnl.load [[VAR_16_]][] : memref<i32>
 // CHECK:               [[VAR_20_:%.+]] = arith.addi [[LOAD_RES_MEM_]], [[LOAD_VAR_16_MEM_]] : i32
 // CHECK:               krnl.store [[VAR_20_]], [[RES_4_]][] : memref<i32>
-// CHECK:               [[LOAD_VAR_1_MEM_1_:%.+]] = krnl.load [[VAR_1_]][] : memref<i1>
-// CHECK:               krnl.store [[LOAD_VAR_1_MEM_1_]], [[RES_2_]][] : memref<i1>
+// CHECK-NOT:           krnl.store {{.*}}, [[RES_2_]][] : memref<i1>
 // CHECK:               [[LOAD_RES_MEM_1_:%.+]] = krnl.load [[RES_]][] : memref<i32>
 // CHECK:               krnl.store [[LOAD_RES_MEM_1_]], [[RES_1_]]{{.}}[[I_0_]]{{.}} : memref<?xi32>
 // CHECK:               [[LOAD_RES_4_MEM_:%.+]] = krnl.load [[RES_4_]][] : memref<i32>
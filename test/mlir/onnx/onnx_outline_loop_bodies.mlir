@@ -0,0 +1,94 @@
+// RUN: onnx-mlir-opt --onnx-outline-loop-bodies %s -split-input-file | FileCheck %s
+
+/// Two structurally identical loop bodies share one outlined function. The
+/// pass-through break condition stays a block-argument return so the Loop
+/// lowering still sees a loop-invariant condition.
+func.func @test_outline_identical_loops(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<1xf32>) -> tensor<1xf32> {
+  %0 = "onnx.Loop"(%arg0, %arg1, %arg2) ({
+  ^bb0(%b0: tensor<i64>, %b1: tensor<i1>, %b2: tensor<1xf32>):
+    %2 = "onnx.Add"(%b2, %b2) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+    onnx.Return %b1, %2 : tensor<i1>, tensor<1xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+  %1 = "onnx.Loop"(%arg0, %arg1, %0) ({
+  ^bb0(%b0: tensor<i64>, %b1: tensor<i1>, %b2: tensor<1xf32>):
+    %2 = "onnx.Add"(%b2, %b2) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+    onnx.Return %b1, %2 : tensor<i1>, tensor<1xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+  return %1 : tensor<1xf32>
+}
+// CHECK-LABEL:  func.func @test_outline_identical_loops
+// CHECK:           "onnx.Loop"
+// CHECK:           ^bb0([[B0_:%.+]]: tensor<i64>, [[B1_:%.+]]: tensor<i1>, [[B2_:%.+]]: tensor<1xf32>):
+// CHECK-NEXT:        [[VAR_2_:%.+]] = call @outlined_loop_body_0([[B0_]], [[B1_]], [[B2_]]) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+// CHECK-NEXT:        onnx.Return [[B1_]], [[VAR_2_]] : tensor<i1>, tensor<1xf32>
+// CHECK:           "onnx.Loop"
+// CHECK:           ^bb0([[C0_:%.+]]: tensor<i64>, [[C1_:%.+]]: tensor<i1>, [[C2_:%.+]]: tensor<1xf32>):
+// CHECK-NEXT:        [[VAR_3_:%.+]] = call @outlined_loop_body_0([[C0_]], [[C1_]], [[C2_]]) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+// CHECK-NEXT:        onnx.Return [[C1_]], [[VAR_3_]] : tensor<i1>, tensor<1xf32>
+// CHECK:         func.func private @outlined_loop_body_0([[A0_:%.+]]: tensor<i64>, [[A1_:%.+]]: tensor<i1>, [[A2_:%.+]]: tensor<1xf32>) -> tensor<1xf32>
+// CHECK:           [[ADD_:%.+]] = "onnx.Add"([[A2_]], [[A2_]]) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+// CHECK:           return [[ADD_]] : tensor<1xf32>
+
+// -----
+
+/// Values the bodies use from the enclosing function become trailing
+/// arguments of the shared function.
+func.func @test_outline_loops_with_capture(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<1xf32>) -> tensor<1xf32> {
+  %0 = "onnx.Loop"(%arg0, %arg1, %arg2) ({
+  ^bb0(%b0: tensor<i64>, %b1: tensor<i1>, %b2: tensor<1xf32>):
+    %2 = "onnx.Add"(%b2, %arg2) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+    onnx.Return %b1, %2 : tensor<i1>, tensor<1xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+  %1 = "onnx.Loop"(%arg0, %arg1, %0) ({
+  ^bb0(%b0: tensor<i64>, %b1: tensor<i1>, %b2: tensor<1xf32>):
+    %2 = "onnx.Add"(%b2, %arg2) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+    onnx.Return %b1, %2 : tensor<i1>, tensor<1xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+  return %1 : tensor<1xf32>
+}
+// CHECK-LABEL:  func.func @test_outline_loops_with_capture
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<i64>, [[PARAM_1_:%.+]]: tensor<i1>, [[PARAM_2_:%.+]]: tensor<1xf32>) -> tensor<1xf32> {
+// CHECK:           ^bb0([[B0_:%.+]]: tensor<i64>, [[B1_:%.+]]: tensor<i1>, [[B2_:%.+]]: tensor<1xf32>):
+// CHECK-NEXT:        [[VAR_2_:%.+]] = call @outlined_loop_body_0([[B0_]], [[B1_]], [[B2_]], [[PARAM_2_]]) : (tensor<i64>, tensor<i1>, tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+// CHECK:         func.func private @outlined_loop_body_0([[A0_:%.+]]: tensor<i64>, [[A1_:%.+]]: tensor<i1>, [[A2_:%.+]]: tensor<1xf32>, [[A3_:%.+]]: tensor<1xf32>) -> tensor<1xf32>
+// CHECK:           [[ADD_:%.+]] = "onnx.Add"([[A2_]], [[A3_]]) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+// CHECK:           return [[ADD_]] : tensor<1xf32>
+
+// -----
+
+/// A body that appears only once stays inline: a shared function would add
+/// call overhead without removing any duplication.
+func.func @test_no_outline_unique_body(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<1xf32>) -> tensor<1xf32> {
+  %0 = "onnx.Loop"(%arg0, %arg1, %arg2) ({
+  ^bb0(%b0: tensor<i64>, %b1: tensor<i1>, %b2: tensor<1xf32>):
+    %1 = "onnx.Add"(%b2, %b2) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+    onnx.Return %b1, %1 : tensor<i1>, tensor<1xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+  return %0 : tensor<1xf32>
+}
+// CHECK-LABEL:  func.func @test_no_outline_unique_body
+// CHECK:           "onnx.Add"
+// CHECK-NOT:       call
+// CHECK-NOT:       func.func private
+
+// -----
+
+/// Bodies that differ in structure must not be unified.
+func.func @test_no_outline_different_bodies(%arg0: tensor<i64>, %arg1: tensor<i1>, %arg2: tensor<1xf32>) -> tensor<1xf32> {
+  %0 = "onnx.Loop"(%arg0, %arg1, %arg2) ({
+  ^bb0(%b0: tensor<i64>, %b1: tensor<i1>, %b2: tensor<1xf32>):
+    %2 = "onnx.Add"(%b2, %b2) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+    onnx.Return %b1, %2 : tensor<i1>, tensor<1xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+  %1 = "onnx.Loop"(%arg0, %arg1, %0) ({
+  ^bb0(%b0: tensor<i64>, %b1: tensor<i1>, %b2: tensor<1xf32>):
+    %2 = "onnx.Mul"(%b2, %b2) : (tensor<1xf32>, tensor<1xf32>) -> tensor<1xf32>
+    onnx.Return %b1, %2 : tensor<i1>, tensor<1xf32>
+  }) : (tensor<i64>, tensor<i1>, tensor<1xf32>) -> tensor<1xf32>
+  return %1 : tensor<1xf32>
+}
+// CHECK-LABEL:  func.func @test_no_outline_different_bodies
+// CHECK:           "onnx.Add"
+// CHECK:           "onnx.Mul"
+// CHECK-NOT:       call
+// CHECK-NOT:       func.func private
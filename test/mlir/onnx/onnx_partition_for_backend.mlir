@@ -0,0 +1,68 @@
+// RUN: onnx-mlir-opt --onnx-partition-for-backend %s -split-input-file | FileCheck %s
+// RUN: onnx-mlir-opt --onnx-partition-for-backend='target-backend=tosa min-ops=2' %s -split-input-file | FileCheck --check-prefix=TOSA %s
+
+/// A maximal run of MHLO-convertible operations is outlined into a private
+/// function tagged with the backend attribute; the unsupported operation
+/// stays inline on the default CPU path.
+func.func @test_partition_mixed(%arg0: tensor<4x8xf32>, %arg1: tensor<8x8xf32>) -> tensor<4x8xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8x8xf32>) -> tensor<4x8xf32>
+  %1 = "onnx.Add"(%0, %arg0) : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  %2 = "onnx.Relu"(%1) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  %3 = "onnx.Softmax"(%2) {axis = 1 : si64} : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  %4 = "onnx.Erf"(%3) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  return %4 : tensor<4x8xf32>
+}
+// CHECK-LABEL:  func.func @test_partition_mixed
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<4x8xf32>, [[PARAM_1_:%.+]]: tensor<8x8xf32>) -> tensor<4x8xf32> {
+// CHECK-NEXT:      [[VAR_0_:%.+]] = call @test_partition_mixed_mhlo_0([[PARAM_0_]], [[PARAM_1_]]) : (tensor<4x8xf32>, tensor<8x8xf32>) -> tensor<4x8xf32>
+// CHECK-NEXT:      [[VAR_1_:%.+]] = "onnx.Erf"([[VAR_0_]]) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+// CHECK-NEXT:      return [[VAR_1_]] : tensor<4x8xf32>
+// CHECK:        func.func private @test_partition_mixed_mhlo_0
+// CHECK-SAME:   ([[A0_:%.+]]: tensor<4x8xf32>, [[A1_:%.+]]: tensor<8x8xf32>) -> tensor<4x8xf32> attributes {backend = "mhlo"} {
+// CHECK-NEXT:      [[MM_:%.+]] = "onnx.MatMul"([[A0_]], [[A1_]]) : (tensor<4x8xf32>, tensor<8x8xf32>) -> tensor<4x8xf32>
+// CHECK-NEXT:      [[ADD_:%.+]] = "onnx.Add"([[MM_]], [[A0_]]) : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+// CHECK-NEXT:      [[RELU_:%.+]] = "onnx.Relu"([[ADD_]]) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+// CHECK-NEXT:      [[SM_:%.+]] = "onnx.Softmax"([[RELU_]]) {axis = 1 : si64} : (tensor<4x8xf32>) -> tensor<4x8xf32>
+// CHECK-NEXT:      return [[SM_]] : tensor<4x8xf32>
+
+// -----
+
+/// Constants are carried along but do not count toward the minimum subgraph
+/// size: two compute operations are below the default threshold, so the run
+/// stays inline.
+func.func @test_partition_too_small(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  %0 = onnx.Constant dense<1.0> : tensor<4xf32>
+  %1 = "onnx.Add"(%arg0, %0) : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+  %2 = "onnx.Relu"(%1) : (tensor<4xf32>) -> tensor<4xf32>
+  %3 = "onnx.Erf"(%2) : (tensor<4xf32>) -> tensor<4xf32>
+  return %3 : tensor<4xf32>
+}
+// CHECK-LABEL:  func.func @test_partition_too_small
+// CHECK-NOT:       call
+// CHECK:           "onnx.Add"
+// CHECK:           "onnx.Relu"
+// CHECK:           "onnx.Erf"
+
+// -----
+
+/// Partitioning for the TOSA backend uses its own supported-operation list.
+func.func @test_partition_tosa(%arg0: tensor<4xf32>, %arg1: tensor<4xf32>) -> tensor<4xf32> {
+  %0 = "onnx.Add"(%arg0, %arg1) : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+  %1 = "onnx.Sub"(%0, %arg1) : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+  %2 = "onnx.Erf"(%1) : (tensor<4xf32>) -> tensor<4xf32>
+  return %2 : tensor<4xf32>
+}
+// With the default mhlo backend and threshold the two-operation run is too
+// small and stays inline.
+// CHECK-LABEL:  func.func @test_partition_tosa
+// CHECK-NOT:       call
+// CHECK:           "onnx.Sub"
+
+// TOSA-LABEL:   func.func @test_partition_tosa
+// TOSA-SAME:    ([[PARAM_0_:%.+]]: tensor<4xf32>, [[PARAM_1_:%.+]]: tensor<4xf32>) -> tensor<4xf32> {
+// TOSA-NEXT:       [[VAR_0_:%.+]] = call @test_partition_tosa_tosa_0([[PARAM_0_]], [[PARAM_1_]]) : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+// TOSA-NEXT:       [[VAR_1_:%.+]] = "onnx.Erf"([[VAR_0_]]) : (tensor<4xf32>) -> tensor<4xf32>
+// TOSA:         func.func private @test_partition_tosa_tosa_0
+// TOSA-SAME:    attributes {backend = "tosa"}
+// TOSA:           "onnx.Add"
+// TOSA:           "onnx.Sub"
@@ -0,0 +1,22 @@
+// RUN: echo "onnx.MatMul mm1 900" > %t.profile
+// RUN: echo "onnx.Add add1 40" >> %t.profile
+// RUN: echo "onnx.Relu NOTSET 30" >> %t.profile
+// RUN: onnx-mlir-opt --profile-annotation="profile-file=%t.profile" %s | FileCheck %s
+
+// The matmul dominates the measured time and is marked hot; the add and the
+// relu only get their measured times. The relu has no onnx_node_name and is
+// matched by op name. Attributes print alphabetically, so the adjacency of
+// onnx_node_name and profile_time proves the absence of profile_hot.
+func.func @test_profile_annotation(%arg0: tensor<16x32xf32>, %arg1: tensor<32x64xf32>, %arg2: tensor<16x64xf32>) -> tensor<16x64xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) {onnx_node_name = "mm1"} : (tensor<16x32xf32>, tensor<32x64xf32>) -> tensor<16x64xf32>
+  %1 = "onnx.Add"(%0, %arg2) {onnx_node_name = "add1"} : (tensor<16x64xf32>, tensor<16x64xf32>) -> tensor<16x64xf32>
+  %2 = "onnx.Relu"(%1) : (tensor<16x64xf32>) -> tensor<16x64xf32>
+  return %2 : tensor<16x64xf32>
+}
+// CHECK-LABEL: func.func @test_profile_annotation
+// CHECK:         "onnx.MatMul"
+// CHECK-SAME:      onnx_node_name = "mm1", profile_hot, profile_time = 9.000000e+02
+// CHECK:         "onnx.Add"
+// CHECK-SAME:      onnx_node_name = "add1", profile_time = 4.000000e+01
+// CHECK:         "onnx.Relu"
+// CHECK-SAME:      {profile_time = 3.000000e+01
@@ -0,0 +1,65 @@
+// RUN: onnx-mlir-opt --recompose-onnx %s -split-input-file | FileCheck %s
+
+// -----
+
+// Recognize the LayerNormalization chain with a trailing bias Add.
+func.func @test_layer_norm_with_bias(%arg0: tensor<2x4x8xf32>, %arg1: tensor<8xf32>, %arg2: tensor<8xf32>) -> tensor<2x4x8xf32> {
+  %eps = onnx.Constant dense<9.99999974E-6> : tensor<f32>
+  %mean = "onnx.ReduceMean"(%arg0) {axes = [-1], keepdims = 1 : si64} : (tensor<2x4x8xf32>) -> tensor<2x4x1xf32>
+  %d = "onnx.Sub"(%arg0, %mean) : (tensor<2x4x8xf32>, tensor<2x4x1xf32>) -> tensor<2x4x8xf32>
+  %dd = "onnx.Mul"(%d, %d) : (tensor<2x4x8xf32>, tensor<2x4x8xf32>) -> tensor<2x4x8xf32>
+  %var = "onnx.ReduceMean"(%dd) {axes = [-1], keepdims = 1 : si64} : (tensor<2x4x8xf32>) -> tensor<2x4x1xf32>
+  %vareps = "onnx.Add"(%var, %eps) : (tensor<2x4x1xf32>, tensor<f32>) -> tensor<2x4x1xf32>
+  %stddev = "onnx.Sqrt"(%vareps) : (tensor<2x4x1xf32>) -> tensor<2x4x1xf32>
+  %norm = "onnx.Div"(%d, %stddev) : (tensor<2x4x8xf32>, tensor<2x4x1xf32>) -> tensor<2x4x8xf32>
+  %scaled = "onnx.Mul"(%norm, %arg1) : (tensor<2x4x8xf32>, tensor<8xf32>) -> tensor<2x4x8xf32>
+  %y = "onnx.Add"(%scaled, %arg2) : (tensor<2x4x8xf32>, tensor<8xf32>) -> tensor<2x4x8xf32>
+  return %y : tensor<2x4x8xf32>
+
+  // CHECK-LABEL: func @test_layer_norm_with_bias
+  // CHECK: [[Y:%.+]], [[MEAN:%.+]], [[ISD:%.+]] = "onnx.LayerNormalization"(%arg0, %arg1, %arg2) {axis = 2 : si64, epsilon = 9.99999974E-6 : f32, stash_type = 1 : si64} : (tensor<2x4x8xf32>, tensor<8xf32>, tensor<8xf32>) -> (tensor<2x4x8xf32>, none, none)
+  // CHECK-NOT: "onnx.ReduceMean"
+  // CHECK: return [[Y]] : tensor<2x4x8xf32>
+}
+
+// -----
+
+// Recognize the LayerNormalization chain without a bias.
+func.func @test_layer_norm_no_bias(%arg0: tensor<2x4x8xf32>, %arg1: tensor<8xf32>) -> tensor<2x4x8xf32> {
+  %eps = onnx.Constant dense<9.99999974E-6> : tensor<f32>
+  %mean = "onnx.ReduceMean"(%arg0) {axes = [-1], keepdims = 1 : si64} : (tensor<2x4x8xf32>) -> tensor<2x4x1xf32>
+  %d = "onnx.Sub"(%arg0, %mean) : (tensor<2x4x8xf32>, tensor<2x4x1xf32>) -> tensor<2x4x8xf32>
+  %dd = "onnx.Mul"(%d, %d) : (tensor<2x4x8xf32>, tensor<2x4x8xf32>) -> tensor<2x4x8xf32>
+  %var = "onnx.ReduceMean"(%dd) {axes = [-1], keepdims = 1 : si64} : (tensor<2x4x8xf32>) -> tensor<2x4x1xf32>
+  %vareps = "onnx.Add"(%var, %eps) : (tensor<2x4x1xf32>, tensor<f32>) -> tensor<2x4x1xf32>
+  %stddev = "onnx.Sqrt"(%vareps) : (tensor<2x4x1xf32>) -> tensor<2x4x1xf32>
+  %norm = "onnx.Div"(%d, %stddev) : (tensor<2x4x8xf32>, tensor<2x4x1xf32>) -> tensor<2x4x8xf32>
+  %y = "onnx.Mul"(%norm, %arg1) : (tensor<2x4x8xf32>, tensor<8xf32>) -> tensor<2x4x8xf32>
+  return %y : tensor<2x4x8xf32>
+
+  // CHECK-LABEL: func @test_layer_norm_no_bias
+  // CHECK: [[NONE:%.+]] = "onnx.NoValue"() {value} : () -> none
+  // CHECK: [[Y:%.+]], [[MEAN:%.+]], [[ISD:%.+]] = "onnx.LayerNormalization"(%arg0, %arg1, [[NONE]]) {axis = 2 : si64, epsilon = 9.99999974E-6 : f32, stash_type = 1 : si64} : (tensor<2x4x8xf32>, tensor<8xf32>, none) -> (tensor<2x4x8xf32>, none, none)
+  // CHECK-NOT: "onnx.ReduceMean"
+  // CHECK: return [[Y]] : tensor<2x4x8xf32>
+}
+
+// -----
+
+// Do not recompose when the two reductions use different axes.
+func.func @test_layer_norm_mismatched_axes(%arg0: tensor<2x4x8xf32>, %arg1: tensor<8xf32>) -> tensor<2x4x8xf32> {
+  %eps = onnx.Constant dense<9.99999974E-6> : tensor<f32>
+  %mean = "onnx.ReduceMean"(%arg0) {axes = [1], keepdims = 1 : si64} : (tensor<2x4x8xf32>) -> tensor<2x1x8xf32>
+  %d = "onnx.Sub"(%arg0, %mean) : (tensor<2x4x8xf32>, tensor<2x1x8xf32>) -> tensor<2x4x8xf32>
+  %dd = "onnx.Mul"(%d, %d) : (tensor<2x4x8xf32>, tensor<2x4x8xf32>) -> tensor<2x4x8xf32>
+  %var = "onnx.ReduceMean"(%dd) {axes = [-1], keepdims = 1 : si64} : (tensor<2x4x8xf32>) -> tensor<2x4x1xf32>
+  %vareps = "onnx.Add"(%var, %eps) : (tensor<2x4x1xf32>, tensor<f32>) -> tensor<2x4x1xf32>
+  %stddev = "onnx.Sqrt"(%vareps) : (tensor<2x4x1xf32>) -> tensor<2x4x1xf32>
+  %norm = "onnx.Div"(%d, %stddev) : (tensor<2x4x8xf32>, tensor<2x4x1xf32>) -> tensor<2x4x8xf32>
+  %y = "onnx.Mul"(%norm, %arg1) : (tensor<2x4x8xf32>, tensor<8xf32>) -> tensor<2x4x8xf32>
+  return %y : tensor<2x4x8xf32>
+
+  // CHECK-LABEL: func @test_layer_norm_mismatched_axes
+  // CHECK-NOT: "onnx.LayerNormalization"
+  // CHECK: return {{.*}} : tensor<2x4x8xf32>
+}
@@ -0,0 +1,60 @@
+// RUN: onnx-mlir-opt --shard-tensor-parallel='num-ranks=2 rank=1' %s -split-input-file | FileCheck %s
+
+// A MatMul with a 2-D constant weight is column-sharded: rank 1 computes the
+// second half of the output columns and the all-gather rebuilds the full
+// output.
+func.func @shard_matmul(%arg0: tensor<4x8xf32>) -> tensor<4x16xf32> {
+  %0 = onnx.Constant dense<1.0> : tensor<8x16xf32>
+  %1 = "onnx.MatMul"(%arg0, %0) : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+  return %1 : tensor<4x16xf32>
+
+// CHECK-LABEL:  func.func @shard_matmul
+// CHECK:           [[WEIGHT_:%.+]] = onnx.Constant dense<1.000000e+00> : tensor<8x16xf32>
+// CHECK:           [[SHARD_:%.+]] = "onnx.Slice"([[WEIGHT_]], {{.*}}) : (tensor<8x16xf32>, tensor<1xi64>, tensor<1xi64>, tensor<1xi64>, tensor<1xi64>) -> tensor<8x8xf32>
+// CHECK:           [[LOCAL_:%.+]] = "onnx.MatMul"(%arg0, [[SHARD_]]) : (tensor<4x8xf32>, tensor<8x8xf32>) -> tensor<4x8xf32>
+// CHECK:           [[FULL_:%.+]] = "onnx.Custom"([[LOCAL_]]) {axis = 1 : i64, function_name = "omTensorParallelAllGather", numRanks = 2 : i64, rank = 1 : i64} : (tensor<4x8xf32>) -> tensor<4x16xf32>
+// CHECK:           return [[FULL_]] : tensor<4x16xf32>
+}
+
+// -----
+
+// A Gemm is sharded along N together with its 1-D bias; transB selects the
+// weight rows instead of the columns.
+func.func @shard_gemm_transB(%arg0: tensor<4x8xf32>) -> tensor<4x16xf32> {
+  %0 = onnx.Constant dense<1.0> : tensor<16x8xf32>
+  %1 = onnx.Constant dense<0.5> : tensor<16xf32>
+  %2 = "onnx.Gemm"(%arg0, %0, %1) {transB = 1 : si64} : (tensor<4x8xf32>, tensor<16x8xf32>, tensor<16xf32>) -> tensor<4x16xf32>
+  return %2 : tensor<4x16xf32>
+
+// CHECK-LABEL:  func.func @shard_gemm_transB
+// CHECK:           "onnx.Slice"({{.*}}) : (tensor<16x8xf32>, tensor<1xi64>, tensor<1xi64>, tensor<1xi64>, tensor<1xi64>) -> tensor<8x8xf32>
+// CHECK:           "onnx.Slice"({{.*}}) : (tensor<16xf32>, tensor<1xi64>, tensor<1xi64>, tensor<1xi64>, tensor<1xi64>) -> tensor<8xf32>
+// CHECK:           [[LOCAL_:%.+]] = "onnx.Gemm"(%arg0, {{.*}}, {{.*}}) {transB = 1 : si64} : (tensor<4x8xf32>, tensor<8x8xf32>, tensor<8xf32>) -> tensor<4x8xf32>
+// CHECK:           [[FULL_:%.+]] = "onnx.Custom"([[LOCAL_]]) {axis = 1 : i64, function_name = "omTensorParallelAllGather", numRanks = 2 : i64, rank = 1 : i64} : (tensor<4x8xf32>) -> tensor<4x16xf32>
+// CHECK:           return [[FULL_]] : tensor<4x16xf32>
+}
+
+// -----
+
+// A weight whose columns do not divide evenly across the ranks is left alone.
+func.func @no_shard_odd_columns(%arg0: tensor<4x8xf32>) -> tensor<4x15xf32> {
+  %0 = onnx.Constant dense<1.0> : tensor<8x15xf32>
+  %1 = "onnx.MatMul"(%arg0, %0) : (tensor<4x8xf32>, tensor<8x15xf32>) -> tensor<4x15xf32>
+  return %1 : tensor<4x15xf32>
+
+// CHECK-LABEL:  func.func @no_shard_odd_columns
+// CHECK-NOT:       "onnx.Custom"
+// CHECK:           "onnx.MatMul"
+}
+
+// -----
+
+// A non-constant weight cannot be sharded at compile time.
+func.func @no_shard_dynamic_weight(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>) -> tensor<4x16xf32> {
+  %0 = "onnx.MatMul"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+  return %0 : tensor<4x16xf32>
+
+// CHECK-LABEL:  func.func @no_shard_dynamic_weight
+// CHECK-NOT:       "onnx.Custom"
+// CHECK:           "onnx.MatMul"
+}
@@ -0,0 +1,80 @@
+// RUN: onnx-mlir-opt --onnx-share-entry-functions %s -split-input-file | FileCheck %s
+
+// COM: Two entry points exporting the same graph under different names and
+// COM: node names share one body; the second becomes a wrapper calling the
+// COM: first, keeping its exported name and signature.
+module {
+  func.func @run_a(%arg0: tensor<3x2xf32>) -> tensor<3x2xf32> {
+    %0 = "onnx.Constant"() {value = dense<[[1.0, 2.0], [3.0, 4.0], [5.0, 6.0]]> : tensor<3x2xf32>} : () -> tensor<3x2xf32>
+    %1 = "onnx.Add"(%arg0, %0) {onnx_node_name = "a/add"} : (tensor<3x2xf32>, tensor<3x2xf32>) -> tensor<3x2xf32>
+    %2 = "onnx.Relu"(%1) {onnx_node_name = "a/relu"} : (tensor<3x2xf32>) -> tensor<3x2xf32>
+    return %2 : tensor<3x2xf32>
+  }
+  func.func @run_b(%arg0: tensor<3x2xf32>) -> tensor<3x2xf32> {
+    %0 = "onnx.Constant"() {value = dense<[[1.0, 2.0], [3.0, 4.0], [5.0, 6.0]]> : tensor<3x2xf32>} : () -> tensor<3x2xf32>
+    %1 = "onnx.Add"(%arg0, %0) {onnx_node_name = "b/add"} : (tensor<3x2xf32>, tensor<3x2xf32>) -> tensor<3x2xf32>
+    %2 = "onnx.Relu"(%1) {onnx_node_name = "b/relu"} : (tensor<3x2xf32>) -> tensor<3x2xf32>
+    return %2 : tensor<3x2xf32>
+  }
+  "onnx.EntryPoint"() {func = @run_a} : () -> ()
+  "onnx.EntryPoint"() {func = @run_b} : () -> ()
+
+  // CHECK-LABEL: func.func @run_a
+  // CHECK:         "onnx.Add"
+  // CHECK:         "onnx.Relu"
+  // CHECK:         return
+
+  // CHECK-LABEL: func.func @run_b
+  // CHECK-SAME:    ([[ARG0:%.+]]: tensor<3x2xf32>) -> tensor<3x2xf32>
+  // CHECK-NEXT:    [[CALL:%.+]] = call @run_a([[ARG0]]) : (tensor<3x2xf32>) -> tensor<3x2xf32>
+  // CHECK-NEXT:    return [[CALL]] : tensor<3x2xf32>
+
+  // CHECK: "onnx.EntryPoint"() {func = @run_a}
+  // CHECK: "onnx.EntryPoint"() {func = @run_b}
+}
+
+// -----
+
+// COM: Entry points whose graphs differ in a semantic attribute keep their
+// COM: own bodies.
+module {
+  func.func @reduce_rows(%arg0: tensor<3x4xf32>) -> tensor<3xf32> {
+    %0 = "onnx.ReduceSumV11"(%arg0) {axes = [1], keepdims = 0 : si64} : (tensor<3x4xf32>) -> tensor<3xf32>
+    return %0 : tensor<3xf32>
+  }
+  func.func @reduce_cols(%arg0: tensor<3x4xf32>) -> tensor<4xf32> {
+    %0 = "onnx.ReduceSumV11"(%arg0) {axes = [0], keepdims = 0 : si64} : (tensor<3x4xf32>) -> tensor<4xf32>
+    return %0 : tensor<4xf32>
+  }
+  "onnx.EntryPoint"() {func = @reduce_rows} : () -> ()
+  "onnx.EntryPoint"() {func = @reduce_cols} : () -> ()
+
+  // CHECK-LABEL: func.func @reduce_rows
+  // CHECK:         "onnx.ReduceSumV11"
+  // CHECK-LABEL: func.func @reduce_cols
+  // CHECK:         "onnx.ReduceSumV11"
+  // CHECK-NOT:     call
+}
+
+// -----
+
+// COM: Bodies that agree operation by operation but differ in signature (a
+// COM: different static batch size) are not merged.
+module {
+  func.func @batch_one(%arg0: tensor<1x4xf32>) -> tensor<1x4xf32> {
+    %0 = "onnx.Relu"(%arg0) : (tensor<1x4xf32>) -> tensor<1x4xf32>
+    return %0 : tensor<1x4xf32>
+  }
+  func.func @batch_eight(%arg0: tensor<8x4xf32>) -> tensor<8x4xf32> {
+    %0 = "onnx.Relu"(%arg0) : (tensor<8x4xf32>) -> tensor<8x4xf32>
+    return %0 : tensor<8x4xf32>
+  }
+  "onnx.EntryPoint"() {func = @batch_one} : () -> ()
+  "onnx.EntryPoint"() {func = @batch_eight} : () -> ()
+
+  // CHECK-LABEL: func.func @batch_one
+  // CHECK:         "onnx.Relu"
+  // CHECK-LABEL: func.func @batch_eight
+  // CHECK:         "onnx.Relu"
+  // CHECK-NOT:     call
+}
@@ -183,3 +183,23 @@ func.func @test_update_constantofshape_output_shape(%arg0: tensor<?x256xi64>, %a
 // CHECK:           return [[VAR_4_]] : tensor<?x1x256xi64>
 // CHECK:         }
 }
+
+// -----
+
+// Dims queried on intermediate results are anchored at the function inputs
+// and then deduplicated.
+func.func @test_dim_to_input_dim(%arg0: tensor<?x256xf32>) -> (tensor<2xi64>, tensor<?x256xf32>) {
+  %0 = "onnx.Relu"(%arg0) : (tensor<?x256xf32>) -> tensor<?x256xf32>
+  %1 = "onnx.Dim"(%0) {axis = 0 : si64} : (tensor<?x256xf32>) -> tensor<1xi64>
+  %2 = "onnx.Dim"(%arg0) {axis = 0 : si64} : (tensor<?x256xf32>) -> tensor<1xi64>
+  %3 = "onnx.Concat"(%1, %2) {axis = 0 : si64} : (tensor<1xi64>, tensor<1xi64>) -> tensor<2xi64>
+  return %3, %0 : tensor<2xi64>, tensor<?x256xf32>
+
+// CHECK-LABEL:  func.func @test_dim_to_input_dim
+// CHECK-SAME:   ([[PARAM_0_:%.+]]: tensor<?x256xf32>) -> (tensor<2xi64>, tensor<?x256xf32>) {
+// CHECK-DAG:       [[VAR_0_:%.+]] = "onnx.Relu"([[PARAM_0_]]) : (tensor<?x256xf32>) -> tensor<?x256xf32>
+// CHECK-DAG:       [[VAR_1_:%.+]] = "onnx.Dim"([[PARAM_0_]]) {axis = 0 : si64} : (tensor<?x256xf32>) -> tensor<1xi64>
+// CHECK:           [[VAR_2_:%.+]] = "onnx.Concat"([[VAR_1_]], [[VAR_1_]]) {axis = 0 : si64} : (tensor<1xi64>, tensor<1xi64>) -> tensor<2xi64>
+// CHECK:           return [[VAR_2_]], [[VAR_0_]] : tensor<2xi64>, tensor<?x256xf32>
+// CHECK:         }
+}
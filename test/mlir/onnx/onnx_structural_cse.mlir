@@ -0,0 +1,32 @@
+// RUN: onnx-mlir-opt --onnx-structural-cse %s -split-input-file | FileCheck %s
+
+// COM: Duplicated subgraphs whose operations differ only in onnx_node_name
+// COM: collapse into one copy; deduplicating the constants makes the two
+// COM: Add operations equivalent in turn.
+func.func @test_dedup_towers(%arg0: tensor<3x2xf32>) -> (tensor<3x2xf32>, tensor<3x2xf32>) {
+  %0 = "onnx.Constant"() {value = dense<[[1.0, 2.0], [3.0, 4.0], [5.0, 6.0]]> : tensor<3x2xf32>} : () -> tensor<3x2xf32>
+  %1 = "onnx.Add"(%arg0, %0) {onnx_node_name = "tower_a/add"} : (tensor<3x2xf32>, tensor<3x2xf32>) -> tensor<3x2xf32>
+  %2 = "onnx.Constant"() {value = dense<[[1.0, 2.0], [3.0, 4.0], [5.0, 6.0]]> : tensor<3x2xf32>} : () -> tensor<3x2xf32>
+  %3 = "onnx.Add"(%arg0, %2) {onnx_node_name = "tower_b/add"} : (tensor<3x2xf32>, tensor<3x2xf32>) -> tensor<3x2xf32>
+  %4 = "onnx.Relu"(%1) : (tensor<3x2xf32>) -> tensor<3x2xf32>
+  %5 = "onnx.Sigmoid"(%3) : (tensor<3x2xf32>) -> tensor<3x2xf32>
+  return %4, %5 : tensor<3x2xf32>, tensor<3x2xf32>
+  // CHECK-LABEL: test_dedup_towers
+  // CHECK-COUNT-1: "onnx.Constant"
+  // CHECK-NOT: "onnx.Constant"
+  // CHECK-COUNT-1: "onnx.Add"
+  // CHECK-NOT: "onnx.Add"
+  // CHECK: "onnx.Relu"
+  // CHECK: "onnx.Sigmoid"
+}
+
+// -----
+
+// COM: Operations with different semantic attributes are not deduplicated.
+func.func @test_keep_different_attrs(%arg0: tensor<3x4xf32>) -> (tensor<3xf32>, tensor<4xf32>) {
+  %0 = "onnx.ReduceSumV11"(%arg0) {axes = [1], keepdims = 0 : si64} : (tensor<3x4xf32>) -> tensor<3xf32>
+  %1 = "onnx.ReduceSumV11"(%arg0) {axes = [0], keepdims = 0 : si64} : (tensor<3x4xf32>) -> tensor<4xf32>
+  return %0, %1 : tensor<3xf32>, tensor<4xf32>
+  // CHECK-LABEL: test_keep_different_attrs
+  // CHECK-COUNT-2: "onnx.ReduceSumV11"
+}
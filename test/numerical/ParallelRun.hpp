@@ -0,0 +1,96 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//====-- ParallelRun.hpp - worker pool for numerical test variants -==========//
+//
+// Copyright 2022 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file contains a small worker pool used by the numerical test drivers to
+// compile and verify independent test configurations concurrently. Each worker
+// is handed its own shared-library base name so that concurrent compilations
+// do not overwrite each other's output; the in-process compiler API itself is
+// safe to call from several threads.
+//
+// The pool is opt-in: set TEST_PARALLEL=<workers> in the environment (or pass
+// a worker count directly) to enable it. Without it, tasks run serially with
+// the unmodified base name, preserving the historical behavior.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "llvm/Support/FileSystem.h"
+
+#include "src/Compiler/CompilerUtils.hpp"
+
+namespace onnx_mlir {
+namespace test {
+
+// A test configuration to run; receives the shared-library base name the task
+// must compile into and returns whether the configuration passed.
+using ParallelTestTask = std::function<bool(const std::string &)>;
+
+// Read the worker count from the given environment variable. Returns 1 (run
+// serially) when the variable is absent or not a positive integer; "max" asks
+// for one worker per hardware thread.
+inline int getParallelWorkersFromEnv(const std::string &envVar) {
+  const char *envVal = std::getenv(envVar.c_str());
+  if (!envVal)
+    return 1;
+  if (std::string(envVal) == "max")
+    return std::max(1u, std::thread::hardware_concurrency());
+  int workers = atoi(envVal);
+  return (workers > 0) ? workers : 1;
+}
+
+// Run the given tasks, using up to 'workers' threads. Each worker compiles
+// into '<sharedLibBaseName>_w<id>' and removes that library when done; with
+// one worker the tasks run serially on the caller's thread with the
+// unmodified base name. Remaining tasks are skipped once a task fails.
+// Returns true when every task succeeded.
+inline bool runTasks(const std::vector<ParallelTestTask> &tasks,
+    const std::string &sharedLibBaseName, int workers) {
+  if (workers <= 1) {
+    for (const ParallelTestTask &task : tasks)
+      if (!task(sharedLibBaseName))
+        return false;
+    return true;
+  }
+
+  if (workers > (int)tasks.size())
+    workers = tasks.size();
+  std::atomic<size_t> nextTask(0);
+  std::atomic<bool> hasFailed(false);
+  std::vector<std::thread> pool;
+  for (int w = 0; w < workers; ++w) {
+    pool.emplace_back([&, w]() {
+      const std::string libBase =
+          sharedLibBaseName + "_w" + std::to_string(w);
+      while (!hasFailed) {
+        size_t taskIndex = nextTask++;
+        if (taskIndex >= tasks.size())
+          break;
+        if (!tasks[taskIndex](libBase))
+          hasFailed = true;
+      }
+      llvm::sys::fs::remove(
+          onnx_mlir::getTargetFilename(libBase, onnx_mlir::EmitLib));
+    });
+  }
+  for (std::thread &worker : pool)
+    worker.join();
+  return !hasFailed;
+}
+
+} // namespace test
+} // namespace onnx_mlir
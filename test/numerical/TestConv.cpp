@@ -17,6 +17,8 @@
 // warnings.
 #include "Common.hpp"
 
+#include "ParallelRun.hpp"
+
 using namespace mlir;
 
 static const llvm::StringRef SHARED_LIB_BASE("./TestConv_main_graph");
@@ -31,11 +33,13 @@ namespace test {
 // Returns whether onnx-mlir compiled convolution is producing the same results
 // as a naive implementation of convolution for a specific set of convolution
 // parameters/configuration. Stride and dilation are square (same along H and
-// W).
-bool isOMConvTheSameAsNaiveImplFor(const int N, const int CIn, const int COut,
-    const int H, const int W, const int kH, const int kW, int pHBegin,
-    int pHEnd, int pWBegin, int pWEnd, const ConvAutoPad autoPad) {
-  static int testNum = 0;
+// W). The shared-library base name is per caller so that configurations may
+// be compiled concurrently.
+bool isOMConvTheSameAsNaiveImplFor(const std::string &libBase, const int N,
+    const int CIn, const int COut, const int H, const int W, const int kH,
+    const int kW, int pHBegin, int pHEnd, int pWBegin, int pWEnd,
+    const ConvAutoPad autoPad) {
+  static std::atomic<int> testNum(0);
   printf("attempt %d with N %d, Cin %d, Cout %d, H %d, W %d, kH %d, kW %d, "
          "pHBegin %d, pHEnd %d, pWBegin %d, pWEnd %d, autopad %s, isDynamic "
          "%d, stride %d, dilation %d\n",
@@ -43,8 +47,8 @@ bool isOMConvTheSameAsNaiveImplFor(const int N, const int CIn, const int COut,
       Conv2DLibBuilder::getAutoPadName(autoPad).c_str(), isDynamic, stride,
       dilation);
 
-  Conv2DLibBuilder conv(SHARED_LIB_BASE.str(), N, CIn, COut, H, W, kH, kW,
-      autoPad, pHBegin, pHEnd, pWBegin, pWEnd, stride, dilation, isDynamic);
+  Conv2DLibBuilder conv(libBase, N, CIn, COut, H, W, kH, kW, autoPad, pHBegin,
+      pHEnd, pWBegin, pWEnd, stride, dilation, isDynamic);
   return conv.build() && conv.compileAndLoad() &&
          conv.checkInstructionFromEnv("TEST_INSTRUCTION") &&
          conv.prepareInputsFromEnv("TEST_DATARANGE") && conv.run() &&
@@ -91,81 +95,56 @@ int main(int argc, char *argv[]) {
     paddingType = "notset";
   }
 
+  // Worker count for the parallel harness; 1 (the default) runs serially.
+  const int workers = getParallelWorkersFromEnv("TEST_PARALLEL");
+  if (workers > 1)
+    printf("Running fixed configurations on %d workers.\n", workers);
+
   printf("\nTest cases seen in backend benchmarks.\n");
   // Set global settings.
   stride = dilation = 1;
   isDynamic = 0;
-  // Some 1x1 conv in inception.
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 64, 64, 55, 55, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_inception_v1_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 192, 64, 27, 27, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_inception_v1_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 512, 144, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_inception_v1_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 832, 128, 6, 6, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_inception_v1_cpu");
-  // All 1x1 conv in squeezenet.
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 64, 16, 55, 55, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 16, 64, 55, 55, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 128, 16, 55, 55, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 16, 64, 55, 55, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 128, 32, 27, 27, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 32, 128, 27, 27, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 256, 32, 27, 27, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 32, 128, 27, 27, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 256, 48, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 48, 192, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 384, 48, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 48, 192, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 384, 64, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 64, 256, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 512, 64, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 64, 256, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             1, 512, 1000, 13, 13, 1, 1, 0, 0, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_squeezenet_cpu");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             3, 64, 64, 55, 55, 3, 3, 1, 1, 0, 0, ConvAutoPad::NOTSET) &&
-         "failed test from test_cpuconvpadding1");
-  assert(isOMConvTheSameAsNaiveImplFor(
-             3, 64, 64, 55, 55, 3, 3, 1, 1, 2, 2, ConvAutoPad::NOTSET) &&
-         "failed test from test_cpuconvpadding2");
+  // The fixed configurations are independent of each other, so they can be
+  // compiled and verified concurrently.
+  std::vector<ParallelTestTask> benchmarkTasks;
+  auto addBenchmark = [&](int N, int CIn, int COut, int H, int W, int kH,
+                          int kW, int pHBegin, int pHEnd, int pWBegin,
+                          int pWEnd) {
+    benchmarkTasks.emplace_back([=](const std::string &libBase) {
+      return isOMConvTheSameAsNaiveImplFor(libBase, N, CIn, COut, H, W, kH, kW,
+          pHBegin, pHEnd, pWBegin, pWEnd, ConvAutoPad::NOTSET);
+    });
+  };
+  // Some 1x1 conv in inception (test_inception_v1_cpu).
+  addBenchmark(1, 64, 64, 55, 55, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 192, 64, 27, 27, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 512, 144, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 832, 128, 6, 6, 1, 1, 0, 0, 0, 0);
+  // All 1x1 conv in squeezenet (test_squeezenet_cpu).
+  addBenchmark(1, 64, 16, 55, 55, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 16, 64, 55, 55, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 128, 16, 55, 55, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 16, 64, 55, 55, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 128, 32, 27, 27, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 32, 128, 27, 27, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 256, 32, 27, 27, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 32, 128, 27, 27, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 256, 48, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 48, 192, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 384, 48, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 48, 192, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 384, 64, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 64, 256, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 512, 64, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 64, 256, 13, 13, 1, 1, 0, 0, 0, 0);
+  addBenchmark(1, 512, 1000, 13, 13, 1, 1, 0, 0, 0, 0);
+  // test_cpuconvpadding1 / test_cpuconvpadding2.
+  addBenchmark(3, 64, 64, 55, 55, 3, 3, 1, 1, 0, 0);
+  addBenchmark(3, 64, 64, 55, 55, 3, 3, 1, 1, 2, 2);
+  if (!runTasks(benchmarkTasks, SHARED_LIB_BASE.str(), workers)) {
+    printf("failed test cases seen in backend benchmarks\n");
+    return 1;
+  }
 
   // Had To Explicitly Iterate Over Dynamic as otherwise the random algorithm
   // never got to testing the dynamic cases.
@@ -196,8 +175,8 @@ int main(int argc, char *argv[]) {
       const int kW = *rc::gen::inRange(1, 6);
       // Make sure we have at least 1 output per dimension.
       RC_PRE((H / stride >= kH * dilation) && (W / stride > kW * dilation));
-      RC_ASSERT(isOMConvTheSameAsNaiveImplFor(
-          N, CIn, COut, H, W, kH, kW, 0, 0, 0, 0, autoPad));
+      RC_ASSERT(isOMConvTheSameAsNaiveImplFor(SHARED_LIB_BASE.str(), N, CIn,
+          COut, H, W, kH, kW, 0, 0, 0, 0, autoPad));
     });
     if (!success)
       return 1;
@@ -251,8 +230,9 @@ int main(int argc, char *argv[]) {
               // Make sure we have at least 1 output per dimension.
               RC_PRE((H / stride >= kH * dilation) &&
                      (W / stride > kW * dilation));
-              RC_ASSERT(isOMConvTheSameAsNaiveImplFor(N, CIn, COut, H, W, kH,
-                  kW, pHBegin, pHEnd, pWBegin, pWEnd, ConvAutoPad::NOTSET));
+              RC_ASSERT(isOMConvTheSameAsNaiveImplFor(SHARED_LIB_BASE.str(), N,
+                  CIn, COut, H, W, kH, kW, pHBegin, pHEnd, pWBegin, pWEnd,
+                  ConvAutoPad::NOTSET));
             });
         if (!success)
           return 1;
@@ -264,12 +244,19 @@ int main(int argc, char *argv[]) {
       printf("\nExhaustive test cases with unit stride and dilation, and %s.\n",
           (isDynamic ? "dynamic" : "static"));
       stride = dilation = 1;
+      std::vector<ParallelTestTask> exhaustiveTasks;
       for (int pHBegin = 0; pHBegin < 3; pHBegin++)
         for (int pHEnd = 0; pHEnd < 3; pHEnd++)
           for (int pWBegin = 0; pWBegin < 3; pWBegin++)
             for (int pWEnd = 0; pWEnd < 3; pWEnd++)
-              assert(isOMConvTheSameAsNaiveImplFor(2, 2, 4, 5, 5, 3, 3, pHBegin,
-                  pHEnd, pWBegin, pWEnd, ConvAutoPad::NOTSET));
+              exhaustiveTasks.emplace_back([=](const std::string &libBase) {
+                return isOMConvTheSameAsNaiveImplFor(libBase, 2, 2, 4, 5, 5, 3,
+                    3, pHBegin, pHEnd, pWBegin, pWEnd, ConvAutoPad::NOTSET);
+              });
+      if (!runTasks(exhaustiveTasks, SHARED_LIB_BASE.str(), workers)) {
+        printf("failed exhaustive test cases\n");
+        return 1;
+      }
     }
 
   } // End loop over static / dynamic
@@ -16,6 +16,8 @@
 // warnings.
 #include "Common.hpp"
 
+#include "ParallelRun.hpp"
+
 static const llvm::StringRef SHARED_LIB_BASE("./TestMatmul2D_main_graph");
 
 using namespace mlir;
@@ -27,10 +29,10 @@ namespace test {
 // as a naive implementation of Matmul for a specific set of Matmul
 // parameters/configuration. Matmul: A[IxK] * B[KxJ] = C[IxJ]
 static bool isOMMatmulTheSameAsNaiveImplFor(
-    const int I, const int J, const int K) {
-  static int testNum = 0;
+    const std::string &libBase, const int I, const int J, const int K) {
+  static std::atomic<int> testNum(0);
   printf("attempt %d with i %d, j %d, k %d\n", ++testNum, I, J, K);
-  MatMul2DLibBuilder matmul(SHARED_LIB_BASE.str(), I, J, K);
+  MatMul2DLibBuilder matmul(libBase, I, J, K);
   return matmul.build() && matmul.compileAndLoad() &&
          matmul.checkInstructionFromEnv("TEST_INSTRUCTION") &&
          matmul.prepareInputsFromEnv("TEST_DATARANGE") && matmul.run() &&
@@ -59,7 +61,7 @@ int main(int argc, char *argv[]) {
         const int I = *rc::gen::inRange(4, 50);
         const int K = *rc::gen::inRange(4, 14);
 
-        RC_ASSERT(isOMMatmulTheSameAsNaiveImplFor(I, 1, K));
+        RC_ASSERT(isOMMatmulTheSameAsNaiveImplFor(SHARED_LIB_BASE.str(), I, 1, K));
       });
   if (!success)
     return 1;
@@ -70,16 +72,26 @@ int main(int argc, char *argv[]) {
     const int J = *rc::gen::inRange(1, 50);
     const int K = *rc::gen::inRange(1, 50);
 
-    RC_ASSERT(isOMMatmulTheSameAsNaiveImplFor(I, J, K));
+    RC_ASSERT(isOMMatmulTheSameAsNaiveImplFor(SHARED_LIB_BASE.str(), I, J, K));
   });
   if (!success)
     return 1;
 
   printf("\n\nExhaustive test case generation.\n");
+  // The exhaustive configurations are independent of each other; compile and
+  // verify them on a worker pool when TEST_PARALLEL is set.
+  std::vector<ParallelTestTask> exhaustiveTasks;
   for (int I = 1; I < 9; I++)
     for (int J = 1; J < 9; J++)
       for (int K = 1; K < 9; K++)
-        assert(isOMMatmulTheSameAsNaiveImplFor(I, J, K));
+        exhaustiveTasks.emplace_back([=](const std::string &libBase) {
+          return isOMMatmulTheSameAsNaiveImplFor(libBase, I, J, K);
+        });
+  if (!runTasks(exhaustiveTasks, SHARED_LIB_BASE.str(),
+          getParallelWorkersFromEnv("TEST_PARALLEL"))) {
+    printf("failed exhaustive test cases\n");
+    return 1;
+  }
 
   return 0;
 }
@@ -56,7 +56,8 @@ ArgOptions = []
 # Add compatible ops here; used when script is run with '--runall'
 OpsWithPerformanceBenchmarks = [
     'Gemm',
-    'Conv'
+    'Conv',
+    'Models'
 ]
 
 # List of argument flags to allow
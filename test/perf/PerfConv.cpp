@@ -39,10 +39,14 @@ static void BM_Conv2D_C16_K1(benchmark::State &state) {
       onnx_mlir::test::ConvAutoPad::VALID, P, P, P, P, S, D, false);
   assert(model.build() && model.compileAndLoad(opts) && model.prepareInputs() &&
          "failed conv");
+  perf_startHWCounters();
   for (auto _ : state)
     model.run();
-  // FLOPS assume D=1, S=1.
-  perf_recordFlops(state, 2.0 * N * C * C * H * W * K * K);
+  perf_stopHWCounters(state);
+  // FLOPS assume D=1, S=1; bytes read the input and the weights once and
+  // write an output of roughly the input size (f32).
+  perf_recordRoofline(state, 2.0 * N * C * C * H * W * K * K,
+      4.0 * (2.0 * N * C * H * W + C * C * K * K));
 }
 BENCHMARK(BM_Conv2D_C16_K1)
     ->ArgsProduct({{1, 16, 64}, {16, 64, 256}})
@@ -61,10 +65,14 @@ static void BM_Conv2D_C16_K3(benchmark::State &state) {
       onnx_mlir::test::ConvAutoPad::VALID, P, P, P, P, S, D, false);
   assert(model.build() && model.compileAndLoad(opts) && model.prepareInputs() &&
          "failed conv");
+  perf_startHWCounters();
   for (auto _ : state)
     model.run();
-  // FLOPS assume D=1, S=1.
-  perf_recordFlops(state, 2.0 * N * C * C * H * W * K * K);
+  perf_stopHWCounters(state);
+  // FLOPS assume D=1, S=1; bytes read the input and the weights once and
+  // write an output of roughly the input size (f32).
+  perf_recordRoofline(state, 2.0 * N * C * C * H * W * K * K,
+      4.0 * (2.0 * N * C * H * W + C * C * K * K));
 }
 BENCHMARK(BM_Conv2D_C16_K3)
     ->ArgsProduct({{1, 16, 64}, {16, 64, 256}})
@@ -31,10 +31,14 @@ static void BM_MatrixVectorProduct(benchmark::State &state) {
   onnx_mlir::test::MatMul2DLibBuilder model(modelName, I, J, K);
   assert(model.build() && model.compileAndLoad() && model.prepareInputs() &&
          "failed matmul");
+  perf_startHWCounters();
   for (auto _ : state)
     model.run();
+  perf_stopHWCounters(state);
   state.SetComplexityN(I);
-  perf_recordFlops(state, 2.0 * I * J * K);
+  // Bytes: read A and B once, write the result once (f32).
+  perf_recordRoofline(
+      state, 2.0 * I * J * K, 4.0 * (I * K + K * J + I * J));
 }
 BENCHMARK(BM_MatrixVectorProduct)
     ->RangeMultiplier(2)
@@ -49,10 +53,14 @@ static void BM_MatmulSquare(benchmark::State &state) {
   onnx_mlir::test::MatMul2DLibBuilder model(modelName, I, J, K);
   assert(model.build() && model.compileAndLoad() && model.prepareInputs() &&
          "failed matmul");
+  perf_startHWCounters();
   for (auto _ : state)
     model.run();
+  perf_stopHWCounters(state);
   state.SetComplexityN(I);
-  perf_recordFlops(state, 2.0 * I * J * K);
+  // Bytes: read A and B once, write the result once (f32).
+  perf_recordRoofline(
+      state, 2.0 * I * J * K, 4.0 * (I * K + K * J + I * J));
 }
 BENCHMARK(BM_MatmulSquare)
     ->RangeMultiplier(2)
@@ -69,10 +77,15 @@ static void BM_MatmulSquareBroadcastB4x(benchmark::State &state) {
       /*broadcast B*/ true, /*same static broadcast*/ false, {4}, I, J, K);
   assert(model.build() && model.compileAndLoad() && model.prepareInputs() &&
          "failed matmul");
+  perf_startHWCounters();
   for (auto _ : state)
     model.run();
+  perf_stopHWCounters(state);
   state.SetComplexityN(I);
-  perf_recordFlops(state, /*broadcast 4x*/ 4.0 /*matmul*/ * 2.0 * I * J * K);
+  // Bytes: read the 4 batches of A and the shared B, write the 4 results.
+  perf_recordRoofline(state,
+      /*broadcast 4x*/ 4.0 /*matmul*/ * 2.0 * I * J * K,
+      4.0 * (4.0 * I * K + K * J + 4.0 * I * J));
 }
 BENCHMARK(BM_MatmulSquareBroadcastB4x)
     ->RangeMultiplier(2)
@@ -88,11 +101,15 @@ static void BM_MatMulWithGemmSquare(benchmark::State &state) {
       modelName, I, J, K, false, false, 1, 1.0, 0.0);
   assert(model.build() && model.compileAndLoad() && model.prepareInputs() &&
          "failed gemm");
+  perf_startHWCounters();
   for (auto _ : state)
     model.run();
+  perf_stopHWCounters(state);
   state.SetComplexityN(I);
   // Because alpha is 1, its not counted; beta is zero, sum of B is ignored.
-  perf_recordFlops(state, 1.0 * I * J * (2.0 * K - 1.0));
+  // Bytes: read A and B once, write the result once (f32).
+  perf_recordRoofline(state, 1.0 * I * J * (2.0 * K - 1.0),
+      4.0 * (I * K + K * J + I * J));
 }
 BENCHMARK(BM_MatMulWithGemmSquare)
     ->RangeMultiplier(2)
@@ -108,11 +125,15 @@ static void BM_GemmSquare(benchmark::State &state) {
       modelName, I, J, K, false, false, 1, 1.0, 1.0);
   assert(model.build() && model.compileAndLoad() && model.prepareInputs() &&
          "failed gemm");
+  perf_startHWCounters();
   for (auto _ : state)
     model.run();
+  perf_stopHWCounters(state);
   state.SetComplexityN(I);
   // Because alpha is 1, its not counted; beta is 1, sum of B is counted.
-  perf_recordFlops(state, 1.0 * I * J * (2.0 * K - 1.0) + I * K);
+  // Bytes: read A, B and the bias once, write the result once (f32).
+  perf_recordRoofline(state, 1.0 * I * J * (2.0 * K - 1.0) + I * K,
+      4.0 * (I * K + K * J + 2.0 * I * J));
 }
 BENCHMARK(BM_GemmSquare)
     ->RangeMultiplier(2)
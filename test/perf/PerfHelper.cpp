@@ -12,6 +12,21 @@
 // actions.
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "llvm/Support/CommandLine.h"
 
 #include "test/perf/PerfHelper.hpp"
@@ -26,6 +41,152 @@ void perf_recordFlops(benchmark::State &state, float f) {
       f, benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1000);
 }
 
+// Pass b as the number of bytes one iteration must move and report it as the
+// actual number (BYTES) and as a rate per second (BYTES/s).
+void perf_recordBytes(benchmark::State &state, float b) {
+  state.counters["BYTES/s"] = benchmark::Counter(b,
+      benchmark::Counter::kIsRate | benchmark::Counter::kIsIterationInvariant,
+      benchmark::Counter::OneK::kIs1000);
+  state.counters["BYTES"] = benchmark::Counter(
+      b, benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1000);
+}
+
+// Record the FLOP and bytes-moved models and derive the roofline position.
+void perf_recordRoofline(benchmark::State &state, float f, float b) {
+  perf_recordFlops(state, f);
+  perf_recordBytes(state, b);
+  if (b <= 0.0f)
+    return;
+  double intensity = (double)f / (double)b;
+  state.counters["AI(FLOP/B)"] = intensity;
+  // With the machine peaks given, report the roof this kernel runs under.
+  const char *peakFlopsEnv = getenv("PERF_PEAK_GFLOPS");
+  const char *peakBandwidthEnv = getenv("PERF_PEAK_GBPS");
+  if (!peakFlopsEnv || !peakBandwidthEnv)
+    return;
+  double peakGFlops = atof(peakFlopsEnv);
+  double peakGBps = atof(peakBandwidthEnv);
+  if (peakGFlops <= 0.0 || peakGBps <= 0.0)
+    return;
+  double roofGFlops = std::min(peakGFlops, peakGBps * intensity);
+  state.counters["Roof(GFLOPS)"] = roofGFlops;
+  state.counters["MemBound"] = intensity < peakGFlops / peakGBps ? 1.0 : 0.0;
+}
+
+#ifdef __linux__
+// File descriptors of the sampled events; the first entry is the group
+// leader and is negative when the counters are not available.
+enum PerfHWEvent { CYCLES = 0, INSTRUCTIONS, CACHE_REFS, CACHE_MISSES };
+static const int perf_numHWEvents = 4;
+static int perf_hwFds[perf_numHWEvents] = {-1, -1, -1, -1};
+static const uint64_t perf_hwEventConfigs[perf_numHWEvents] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+
+static void perf_closeHWCounters() {
+  for (int i = 0; i < perf_numHWEvents; ++i) {
+    if (perf_hwFds[i] >= 0)
+      close(perf_hwFds[i]);
+    perf_hwFds[i] = -1;
+  }
+}
+#endif
+
+// Start sampling the hardware counters of the calling thread.
+void perf_startHWCounters() {
+#ifdef __linux__
+  for (int i = 0; i < perf_numHWEvents; ++i) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = perf_hwEventConfigs[i];
+    // The whole group is enabled at once below through the leader.
+    attr.disabled = (i == 0);
+    attr.inherit = 1; // Count the worker threads of the runtime as well.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1,
+        i == 0 ? -1 : perf_hwFds[0], 0);
+    if (fd < 0) {
+      // Not available, e.g. restricted by perf_event_paranoid; skip quietly.
+      perf_closeHWCounters();
+      return;
+    }
+    perf_hwFds[i] = fd;
+  }
+  ioctl(perf_hwFds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(perf_hwFds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+// Stop sampling and report the counts. The sampled window is slightly wider
+// than the timed loop (it includes the loop setup), which is noise once the
+// loop runs for the usual hundreds of milliseconds.
+void perf_stopHWCounters(benchmark::State &state) {
+#ifdef __linux__
+  if (perf_hwFds[0] < 0)
+    return;
+  ioctl(perf_hwFds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  long long counts[perf_numHWEvents] = {0, 0, 0, 0};
+  for (int i = 0; i < perf_numHWEvents; ++i)
+    if (read(perf_hwFds[i], &counts[i], sizeof(counts[i])) !=
+        sizeof(counts[i]))
+      counts[i] = 0;
+  perf_closeHWCounters();
+  state.counters["HW:cycles"] = benchmark::Counter((double)counts[CYCLES],
+      benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1000);
+  if (counts[CYCLES] > 0)
+    state.counters["HW:IPC"] =
+        (double)counts[INSTRUCTIONS] / (double)counts[CYCLES];
+  state.counters["HW:cache-misses"] =
+      benchmark::Counter((double)counts[CACHE_MISSES],
+          benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1000);
+  if (counts[CACHE_REFS] > 0)
+    state.counters["HW:miss%"] =
+        100.0 * (double)counts[CACHE_MISSES] / (double)counts[CACHE_REFS];
+  // Each miss moves one cache line; report the implied memory traffic as a
+  // rate to set against the bytes-moved model and the bandwidth roof.
+  state.counters["HWBytes/s"] =
+      benchmark::Counter((double)counts[CACHE_MISSES] * 64.0,
+          benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+#endif
+}
+
+// Nearest-rank percentile of an already sorted list of latencies.
+static double perf_percentile(
+    const std::vector<double> &sortedLatencies, double pct) {
+  size_t rank = (size_t)(pct / 100.0 * (sortedLatencies.size() - 1) + 0.5);
+  return sortedLatencies[rank];
+}
+
+// Report the p50/p90/p99 latencies (in ms) of the individual inference times
+// collected by the benchmark loop.
+void perf_recordLatencyPercentiles(
+    benchmark::State &state, std::vector<double> &latenciesMs) {
+  if (latenciesMs.empty())
+    return;
+  std::sort(latenciesMs.begin(), latenciesMs.end());
+  state.counters["p50(ms)"] = perf_percentile(latenciesMs, 50.0);
+  state.counters["p90(ms)"] = perf_percentile(latenciesMs, 90.0);
+  state.counters["p99(ms)"] = perf_percentile(latenciesMs, 99.0);
+}
+
+// Report the process peak resident set size (in MB) at the time of the call.
+void perf_recordPeakRSS(benchmark::State &state) {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return;
+#ifdef __APPLE__
+  double peakRSSMB = usage.ru_maxrss / (1024.0 * 1024.0); // Bytes.
+#else
+  double peakRSSMB = usage.ru_maxrss / 1024.0; // Kilobytes.
+#endif
+  state.counters["PeakRSS(MB)"] = peakRSSMB;
+#endif
+}
+
 // Define performance main, with default opt level of 3, and scan PERF_ARGS to
 // override default onnx-mlir compiler options.
 int perf_main(int argc, char **argv) {
@@ -12,12 +12,47 @@
 // actions.
 //===----------------------------------------------------------------------===//
 
+#include <vector>
+
 #include <benchmark/benchmark.h>
 
 // Pass f as a (double) number of FLOP in the measurement and report it as the
 // actual number (FLOP) and as a rate per seconds (FLOPS).
 void perf_recordFlops(benchmark::State &state, float f);
 
+// Pass b as the number of bytes one iteration must move (compulsory reads of
+// the inputs plus writes of the outputs) and report it as the actual number
+// (BYTES) and as a rate per second (BYTES/s).
+void perf_recordBytes(benchmark::State &state, float b);
+
+// Record both the FLOP and bytes-moved models and derive the kernel's
+// roofline position: its arithmetic intensity AI (FLOP/Byte) and, when the
+// machine peaks are given via the PERF_PEAK_GFLOPS and PERF_PEAK_GBPS
+// environment variables, the attainable GFLOPS at that intensity
+// (Roof(GFLOPS)) and whether the kernel sits under the bandwidth roof
+// (MemBound=1) or the compute roof (MemBound=0). Comparing the measured
+// FLOPS against Roof(GFLOPS) tells whether a regression is a scheduling or a
+// bandwidth problem.
+void perf_recordRoofline(benchmark::State &state, float f, float b);
+
+// Sample hardware counters (cycles, instructions, cache references and
+// misses) around the benchmark loop via perf_event on Linux; no-ops
+// elsewhere or when the counters are not accessible (perf_event_paranoid).
+// Call perf_startHWCounters before the loop and perf_stopHWCounters after
+// it; the latter reports the counts, the IPC, the miss ratio, and the memory
+// traffic implied by the misses (HWBytes/s, one cache line per miss).
+void perf_startHWCounters();
+void perf_stopHWCounters(benchmark::State &state);
+
+// Report the p50/p90/p99 latencies (in ms) of the individual inference times
+// collected by the benchmark loop. Used by the end-to-end model benchmarks,
+// where tail latency regressions matter as much as the mean.
+void perf_recordLatencyPercentiles(
+    benchmark::State &state, std::vector<double> &latenciesMs);
+
+// Report the process peak resident set size (in MB) at the time of the call.
+void perf_recordPeakRSS(benchmark::State &state);
+
 // Define performance main, with default opt level of 3, and scan PERF_ARGS to
 // override default onnx-mlir compiler options.
 int perf_main(int argc, char **argv);
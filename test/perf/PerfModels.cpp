@@ -0,0 +1,134 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//==========-- PerfModels.cpp - End-to-end model performance tests -==========//
+//
+// Copyright 2022 The IBM Research Authors.
+//
+// =============================================================================
+//
+// This file contains end-to-end benchmarks for representative full models at
+// production sizes, complementing the per-op microbenchmarks in PerfGemm,
+// PerfConv and PerfRNN. Each benchmark compiles a model from test/modellib,
+// runs it through an ExecutionSession under manual timing, and reports
+//   * the mean latency (ms) next to its p50/p90/p99 percentiles,
+//   * the achieved FLOPS,
+//   * the process peak resident set size (MB).
+// The CSV files written by 'ParseBenchmarks.py --run Models' serve as
+// machine-readable baselines; '--readrun <file> Models <metric>' compares a
+// fresh run against them and gates on --max-relative-slowdown.
+//   * Default opt level is O3, options found in PERF_ARGS override default.
+//
+//===----------------------------------------------------------------------===//
+
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "include/OnnxMlirCompiler.h"
+#include "test/modellib/ModelLib.hpp"
+#include "test/perf/PerfHelper.hpp"
+
+const std::string modelName("./perfmodels");
+const onnx_mlir::CompilerOptionList opts{
+    {onnx_mlir::OptionKind::CompilerOptLevel, "3"}};
+
+// Run the prepared model under manual timing, keeping every inference latency
+// so that the tail percentiles can be reported next to the mean.
+static void runEndToEnd(benchmark::State &state,
+    onnx_mlir::test::ModelLibBuilder &model, double flop) {
+  std::vector<double> latenciesMs;
+  for (auto _ : state) {
+    auto start = std::chrono::high_resolution_clock::now();
+    model.run();
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    state.SetIterationTime(seconds);
+    latenciesMs.push_back(seconds * 1e3);
+  }
+  perf_recordFlops(state, flop);
+  perf_recordLatencyPercentiles(state, latenciesMs);
+  perf_recordPeakRSS(state);
+}
+
+// Inner 3x3 convolution of a ResNet-50 style image classifier, at the
+// batch size given by the benchmark argument.
+static void BM_E2E_ImageClassifierConv(benchmark::State &state) {
+  int N = state.range(0);
+  int C = 64;
+  int H = 56;
+  int W = 56;
+  int K = 3;
+  int P = 0;
+  int S = 1;
+  int D = 1;
+  onnx_mlir::test::Conv2DLibBuilder model(modelName, N, C, C, H, W, K, K,
+      onnx_mlir::test::ConvAutoPad::VALID, P, P, P, P, S, D, false);
+  assert(model.build() && model.compileAndLoad(opts) && model.prepareInputs() &&
+         "failed conv");
+  runEndToEnd(state, model, 2.0 * N * C * C * H * W * K * K);
+}
+BENCHMARK(BM_E2E_ImageClassifierConv)
+    ->Args({1})
+    ->Args({8})
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+
+// Attention projection of a BERT-base style encoder: 512 tokens projected
+// from and to the 768-wide hidden state.
+static void BM_E2E_TransformerProjection(benchmark::State &state) {
+  int I = 512;
+  int J = 768;
+  int K = 768;
+  onnx_mlir::test::MatMul2DLibBuilder model(modelName, I, J, K);
+  assert(model.build() && model.compileAndLoad(opts) && model.prepareInputs() &&
+         "failed matmul");
+  runEndToEnd(state, model, 2.0 * I * J * K);
+}
+BENCHMARK(BM_E2E_TransformerProjection)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+
+// Feed-forward block of the same encoder: 768 hidden units expanded to 3072.
+static void BM_E2E_TransformerFFN(benchmark::State &state) {
+  int I = 512;
+  int J = 3072;
+  int K = 768;
+  onnx_mlir::test::GemmLibBuilder model(
+      modelName, I, J, K, false, false, 1, 1.0, 1.0);
+  assert(model.build() && model.compileAndLoad(opts) && model.prepareInputs() &&
+         "failed gemm");
+  runEndToEnd(state, model, 1.0 * I * J * (2.0 * K - 1.0) + I * K);
+}
+BENCHMARK(BM_E2E_TransformerFFN)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+
+// Speech-recognition style recurrent model: 50 timesteps of a 512-wide LSTM
+// at the batch size given by the benchmark argument.
+static void BM_E2E_SpeechLSTM(benchmark::State &state) {
+  int D = 1;
+  int S = 50;
+  int B = state.range(0);
+  int I = 512;
+  int H = 512;
+  onnx_mlir::test::LSTMLibBuilder model(
+      modelName, D, S, B, I, H, /*isDynamicS=*/false, /*isDynamicB=*/false);
+  assert(model.build() && model.compileAndLoad(opts) && model.prepareInputs() &&
+         "failed lstm");
+  // FLOPS for LSTM: ignore activations, assume static S and B.
+  runEndToEnd(state, model,
+      D * S * (4.0 * B * H * (2.0 * I - 1.0) + 4.0 * B * H * (2.0 * H - 1.0)));
+}
+BENCHMARK(BM_E2E_SpeechLSTM)
+    ->Args({1})
+    ->Args({16})
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+
+// Will set opt at -O3.
+PERF_MAIN()
@@ -67,13 +67,19 @@ static void BM_LSTM(benchmark::State &state) {
       modelName, D, S, B, I, H, /*isDynamicS=*/false, /*isDynamicB=*/false);
   assert(lstm.build() && lstm.compileAndLoad(opts) && lstm.prepareInputs() &&
          "failed lstm");
+  perf_startHWCounters();
   for (auto _ : state)
     lstm.run();
+  perf_stopHWCounters(state);
   // FLOPS for LSTM: ignore activations, assume static S and B.
   // Eight matrix-matrix multiplications are combined into two
   // matrix-matrix multiplications: [B,I]x[I,4*H] and [B,H]x[H,4*H].
-  perf_recordFlops(state,
-      D * S * (4.0 * B * H * (2.0 * I - 1.0) + 4.0 * B * H * (2.0 * H - 1.0)));
+  // Bytes: read the weights, the input and the states once, write the
+  // output once (f32); weights re-read per step raise this in practice.
+  perf_recordRoofline(state,
+      D * S * (4.0 * B * H * (2.0 * I - 1.0) + 4.0 * B * H * (2.0 * H - 1.0)),
+      4.0 * (D * (4.0 * H * I + 4.0 * H * H) + S * B * I + 2.0 * D * B * H +
+                D * S * B * H));
 }
 BENCHMARK(BM_LSTM)->Apply(CommonArgs)->Unit(benchmark::kMillisecond);
 
@@ -89,13 +95,19 @@ static void BM_GRU_LINEAR_BEFORE_RESET(benchmark::State &state) {
       /*isDynamicS=*/false, /*isDynamicB=*/false);
   assert(gru.build() && gru.compileAndLoad(opts) && gru.prepareInputs() &&
          "failed gru");
+  perf_startHWCounters();
   for (auto _ : state)
     gru.run();
+  perf_stopHWCounters(state);
   // FLOPS for GRU: ignore activations, assume static S and B.
   // Six matrix-matrix multiplications are combined into two
   // matrix-matrix multiplications: [B,I]x[I,3*H] and [B,H]x[H,3*H].
-  perf_recordFlops(state,
-      D * S * (3.0 * B * H * (2.0 * I - 1.0) + 3.0 * B * H * (2.0 * H - 1.0)));
+  // Bytes: read the weights, the input and the state once, write the
+  // output once (f32).
+  perf_recordRoofline(state,
+      D * S * (3.0 * B * H * (2.0 * I - 1.0) + 3.0 * B * H * (2.0 * H - 1.0)),
+      4.0 * (D * (3.0 * H * I + 3.0 * H * H) + S * B * I + D * B * H +
+                D * S * B * H));
 }
 BENCHMARK(BM_GRU_LINEAR_BEFORE_RESET)
     ->Apply(CommonArgs)
@@ -113,13 +125,19 @@ static void BM_GRU_LINEAR_AFTER_RESET(benchmark::State &state) {
       /*isDynamicS=*/false, /*isDynamicB=*/false);
   assert(gru.build() && gru.compileAndLoad(opts) && gru.prepareInputs() &&
          "failed gru");
+  perf_startHWCounters();
   for (auto _ : state)
     gru.run();
+  perf_stopHWCounters(state);
   // FLOPS for GRU: ignore activations, assume static S and B.
   // Six matrix-matrix multiplications are combined into two
   // matrix-matrix multiplications: [B,I]x[I,3*H] and [B,H]x[H,3*H].
-  perf_recordFlops(state,
-      D * S * (3.0 * B * H * (2.0 * I - 1.0) + 3.0 * B * H * (2.0 * H - 1.0)));
+  // Bytes: read the weights, the input and the state once, write the
+  // output once (f32).
+  perf_recordRoofline(state,
+      D * S * (3.0 * B * H * (2.0 * I - 1.0) + 3.0 * B * H * (2.0 * H - 1.0)),
+      4.0 * (D * (3.0 * H * I + 3.0 * H * H) + S * B * I + D * B * H +
+                D * S * B * H));
 }
 BENCHMARK(BM_GRU_LINEAR_AFTER_RESET)
     ->Apply(CommonArgs)
@@ -137,12 +155,17 @@ static void BM_RNN(benchmark::State &state) {
       /*isDynamicB=*/false);
   assert(rnn.build() && rnn.compileAndLoad(opts) && rnn.prepareInputs() &&
          "failed rnn");
+  perf_startHWCounters();
   for (auto _ : state)
     rnn.run();
+  perf_stopHWCounters(state);
   // FLOPS for RNN: ignore activations, assume static S and B.
   // Two matrix-matrix multiplications: [B,I]x[I,H] and [B,H]x[H,H].
-  perf_recordFlops(
-      state, D * S * (B * H * (2.0 * I - 1.0) + B * H * (2.0 * H - 1.0)));
+  // Bytes: read the weights, the input and the state once, write the
+  // output once (f32).
+  perf_recordRoofline(state,
+      D * S * (B * H * (2.0 * I - 1.0) + B * H * (2.0 * H - 1.0)),
+      4.0 * (D * (H * I + H * H) + S * B * I + D * B * H + D * S * B * H));
 }
 BENCHMARK(BM_RNN)->Apply(CommonArgs)->Unit(benchmark::kMillisecond);
 
@@ -35,7 +35,74 @@ void testOMTensorCtor() {
   assert(strides_ptr[1] == 1);
 }
 
+void testOMTensorBorrowedCtor() {
+  /* Over-allocate so we can manufacture aligned and misaligned pointers. */
+  static float data[64] __attribute__((aligned(64)));
+  int64_t shape[2] = {2, 2};
+
+  /* Aligned buffer with a matching guarantee wraps with zero copies. */
+  OMTensor *tensor = omTensorCreateBorrowed(data, shape, 2, ONNX_TYPE_FLOAT,
+      /*alignment=*/64);
+  assert(tensor);
+  assert(omTensorGetDataPtr(tensor) == data);
+  assert(!omTensorGetOwning(tensor));
+  omTensorDestroy(tensor);
+
+  /* Alignment 0 promises nothing and always succeeds. */
+  tensor = omTensorCreateBorrowed(data + 1, shape, 2, ONNX_TYPE_FLOAT,
+      /*alignment=*/0);
+  assert(tensor);
+  omTensorDestroy(tensor);
+
+  /* A buffer that does not satisfy the stated alignment is rejected. */
+  tensor = omTensorCreateBorrowed(data + 1, shape, 2, ONNX_TYPE_FLOAT,
+      /*alignment=*/64);
+  assert(!tensor);
+
+  /* A non-power-of-two alignment is rejected. */
+  tensor = omTensorCreateBorrowed(data, shape, 2, ONNX_TYPE_FLOAT,
+      /*alignment=*/48);
+  assert(!tensor);
+}
+
+void testOMTensorListReuse() {
+  float data[4] = {1.f, 1.f};
+  int64_t shape[2] = {2, 2};
+  OMTensor *a = omTensorCreate(data, shape, 2, ONNX_TYPE_FLOAT);
+  OMTensor *b = omTensorCreate(data, shape, 2, ONNX_TYPE_FLOAT);
+  assert(a && b);
+
+  OMTensorList *list = omTensorListCreateEmpty(/*capacity=*/2);
+  assert(list);
+  assert(omTensorListGetCapacity(list) == 2);
+  assert(omTensorListGetSize(list) == 0);
+
+  /* Rebinding replaces the contents without allocating. */
+  OMTensor *oneTensor[1] = {a};
+  assert(omTensorListRebind(list, oneTensor, 1));
+  assert(omTensorListGetSize(list) == 1);
+  assert(omTensorListGetOmtByIndex(list, 0) == a);
+
+  OMTensor *twoTensors[2] = {b, a};
+  assert(omTensorListRebind(list, twoTensors, 2));
+  assert(omTensorListGetSize(list) == 2);
+  assert(omTensorListGetOmtByIndex(list, 0) == b);
+
+  /* More tensors than the preallocated capacity is rejected. */
+  OMTensor *threeTensors[3] = {a, b, a};
+  assert(!omTensorListRebind(list, threeTensors, 3));
+  assert(omTensorListGetSize(list) == 2);
+
+  /* The list borrows its tensors: destroying it leaves them usable. */
+  omTensorListDestroy(list);
+  assert(omTensorGetShape(a)[0] == 2);
+  omTensorDestroy(a);
+  omTensorDestroy(b);
+}
+
 int main() {
   testOMTensorCtor();
+  testOMTensorBorrowedCtor();
+  testOMTensorListReuse();
   return 0;
 }
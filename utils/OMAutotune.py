@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+
+########################## OMAutotune.py #######################################
+#
+# Copyright 2023 The IBM Research Authors.
+#
+################################################################################
+#
+# This script searches the compiler's performance knobs (parallelization,
+# elementwise/conv codegen, SIMD data layout, prefetching, unrolling, the
+# small-tensor allocator) against the measured latency of the compiled model
+# and emits the best configuration as a response file for production
+# compiles (onnx-mlir @model.autotune.args model.onnx).
+#
+# Every candidate configuration is compiled with --EmitLib and measured with
+# the run-onnx-lib harness (see utils/RunONNXLib.cpp) on representative
+# inputs; the median (p50) latency decides. By default the knobs are searched
+# one at a time, greedily keeping a change only when it improves the best
+# median by more than the noise margin; --exhaustive sweeps the full cross
+# product instead. Measurements are persisted in a JSON tuning database keyed
+# by the model content and base flags, the same ingredients as the compiler's
+# artifact cache key, so re-running after adding knobs or models only
+# measures the configurations not seen before.
+#
+# Typical use:
+#   OMAutotune.py mymodel.onnx --base-flags=-O3 \
+#       --input input0.bin,input1.bin --meas 200 \
+#       --db tuning.json --output mymodel.autotune.args
+#
+################################################################################
+
+import argparse
+import hashlib
+import itertools
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+# The search space: one entry per knob, each a list of alternatives where the
+# first is the default (knob off). Unroll factors come from the
+# --unroll-factors option of the krnl-to-affine lowering; the other flags are
+# the codegen switches that are off by default because they do not pay off on
+# every model.
+SEARCH_SPACE = [
+    ("parallel", ["", "--parallel"]),
+    ("fast-elementwise", ["", "--fast-elementwise"]),
+    ("fast-conv", ["", "--fast-conv"]),
+    ("fused-attention", ["", "--fused-attention"]),
+    ("simd-data-layout", ["", "--simd-data-layout"]),
+    ("enable-prefetch", ["", "--enable-prefetch"]),
+    ("unroll-factors", ["", "--unroll-factors=2", "--unroll-factors=4",
+                        "--unroll-factors=8"]),
+    ("small-tensor-allocator", ["", "--small-tensor-allocator"]),
+]
+
+
+def config_flags(config):
+    """The non-empty flags of a configuration, in knob order."""
+    return [flag for flag in config if flag]
+
+
+def config_key(config):
+    """Stable database key for one configuration."""
+    return " ".join(config_flags(config)) or "<default>"
+
+
+def model_key(model, base_flags):
+    """Database key for the model: an MD5 over the model bytes and the base
+    flags, mirroring what the compiler folds into its artifact cache key."""
+    digest = hashlib.md5()
+    with open(model, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            digest.update(chunk)
+    digest.update("\x1f".join(base_flags).encode())
+    return digest.hexdigest()
+
+
+def load_db(path):
+    if path and os.path.exists(path):
+        with open(path) as f:
+            return json.load(f)
+    return {}
+
+
+def save_db(path, db):
+    if not path:
+        return
+    tmp = path + ".tmp"
+    with open(tmp, "w") as f:
+        json.dump(db, f, indent=2, sort_keys=True)
+    os.replace(tmp, path)
+
+
+def compile_model(args, config, workdir):
+    """Compile the model with the given configuration; return the .so path
+    or None when the compile fails (a config may be rejected, e.g. an
+    accelerator-incompatible flag)."""
+    output = os.path.join(workdir, "model")
+    cmd = ([args.onnx_mlir] + args.base_flags + config_flags(config)
+           + ["--EmitLib", args.model, "-o", output])
+    result = subprocess.run(
+        cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        print("  compile failed: %s" % " ".join(cmd), file=sys.stderr)
+        return None
+    return output + ".so"
+
+
+def measure_model(args, library):
+    """Run the harness against the library; return the median latency in
+    microseconds or None when the run fails."""
+    cmd = [args.run_onnx_lib, library, "-m", str(args.meas),
+           "-w", str(args.warmup)]
+    if args.dim:
+        cmd += ["-d", args.dim]
+    if args.input:
+        cmd += ["-i", args.input]
+    if args.threads > 1:
+        cmd += ["-t", str(args.threads)]
+    result = subprocess.run(
+        cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        print("  run failed: %s" % " ".join(cmd), file=sys.stderr)
+        return None
+    # "@percentile, <unit>, p50, <v>, p95, <v>, p99, <v>, sample, <n>"
+    for line in result.stdout.decode().splitlines():
+        if line.startswith("@percentile"):
+            fields = [f.strip() for f in line.split(",")]
+            return float(fields[fields.index("p50") + 1])
+    print("  no measurement in harness output", file=sys.stderr)
+    return None
+
+
+def evaluate(args, config, db_entry):
+    """Measure one configuration, consulting the tuning database first."""
+    key = config_key(config)
+    if key in db_entry:
+        return db_entry[key]
+    with tempfile.TemporaryDirectory(prefix="onnx-mlir-autotune-") as workdir:
+        library = compile_model(args, config, workdir)
+        p50 = measure_model(args, library) if library else None
+    db_entry[key] = p50
+    return p50
+
+
+def search(args, db_entry):
+    """Search the configuration space; return (best config, best p50)."""
+    default = [alternatives[0] for _, alternatives in SEARCH_SPACE]
+    best = list(default)
+    best_p50 = evaluate(args, best, db_entry)
+    if best_p50 is None:
+        sys.exit("error: the default configuration failed to compile or run")
+    print("%-60s %10.1f us" % (config_key(best), best_p50))
+
+    if args.exhaustive:
+        candidates = [list(c) for c in itertools.product(
+            *[alternatives for _, alternatives in SEARCH_SPACE])]
+        candidates.remove(default)
+    else:
+        # Greedy coordinate descent: try the alternatives of one knob at a
+        # time on top of the best configuration so far. Compiles scale with
+        # the sum of the knob arities instead of their product.
+        candidates = []
+        for knob, (_, alternatives) in enumerate(SEARCH_SPACE):
+            for alternative in alternatives[1:]:
+                candidate = list(best)
+                candidate[knob] = alternative
+                candidates.append(candidate)
+
+    for candidate in candidates:
+        if not args.exhaustive:
+            # Rebase the candidate's single changed knob onto the current best.
+            changed = [k for k in range(len(SEARCH_SPACE))
+                       if candidate[k] != default[k]]
+            rebased = list(best)
+            for k in changed:
+                rebased[k] = candidate[k]
+            candidate = rebased
+        p50 = evaluate(args, candidate, db_entry)
+        if p50 is None:
+            continue
+        print("%-60s %10.1f us" % (config_key(candidate), p50))
+        if p50 < best_p50 * (1.0 - args.margin):
+            best, best_p50 = candidate, p50
+    return best, best_p50
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Search compiler knobs against measured model latency.")
+    parser.add_argument("model", help="ONNX model to tune")
+    parser.add_argument("--onnx-mlir", default="onnx-mlir",
+                        help="onnx-mlir binary (default: from PATH)")
+    parser.add_argument("--run-onnx-lib", default="run-onnx-lib",
+                        help="run-onnx-lib harness binary (default: from PATH)")
+    parser.add_argument("--base-flags", default="-O3",
+                        help="flags applied to every compile (default: -O3)")
+    parser.add_argument("--input", default=None,
+                        help="comma-separated raw input files, one per model "
+                             "input, forwarded to the harness")
+    parser.add_argument("--dim", default=None,
+                        help="json array of runtime dimension values, "
+                             "forwarded to the harness")
+    parser.add_argument("--meas", type=int, default=100,
+                        help="measured runs per configuration (default: 100)")
+    parser.add_argument("--warmup", type=int, default=10,
+                        help="warmup runs per configuration (default: 10)")
+    parser.add_argument("--threads", type=int, default=1,
+                        help="concurrent harness sessions (default: 1)")
+    parser.add_argument("--margin", type=float, default=0.01,
+                        help="relative improvement required to adopt a "
+                             "configuration (default: 0.01)")
+    parser.add_argument("--exhaustive", action="store_true",
+                        help="sweep the full cross product of the knobs "
+                             "instead of greedy coordinate descent")
+    parser.add_argument("--db", default=None,
+                        help="JSON tuning database; measured configurations "
+                             "are reused across runs")
+    parser.add_argument("--output", default=None,
+                        help="response file for the best configuration "
+                             "(default: <model>.autotune.args)")
+    args = parser.parse_args()
+    args.base_flags = args.base_flags.split()
+
+    if shutil.which(args.onnx_mlir) is None:
+        sys.exit("error: onnx-mlir binary not found: " + args.onnx_mlir)
+    if shutil.which(args.run_onnx_lib) is None:
+        sys.exit("error: harness binary not found: " + args.run_onnx_lib)
+
+    db = load_db(args.db)
+    db_entry = db.setdefault(model_key(args.model, args.base_flags), {})
+    try:
+        best, best_p50 = search(args, db_entry)
+    finally:
+        save_db(args.db, db)
+
+    output = args.output or args.model + ".autotune.args"
+    with open(output, "w") as f:
+        for flag in args.base_flags + config_flags(best):
+            f.write(flag + "\n")
+    print("best: %s (p50 %.1f us), written to %s"
+          % (config_key(best), best_p50, output))
+    print("compile with: %s @%s --EmitLib %s"
+          % (args.onnx_mlir, output, args.model))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,361 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+
+######################## OMBenchmarkStore.py ###################################
+#
+# Copyright 2023 The IBM Research Authors.
+#
+################################################################################
+#
+# This script keeps the results of the test/perf google-benchmark suite in a
+# shared JSON-lines database and compares runs across machines. Each result
+# record carries the benchmark output together with the model/op, commit,
+# target CPU, compile flags, and host it came from; each host additionally
+# carries a calibration record with its measured peak GFLOPS and memory
+# bandwidth. Comparisons normalize times by the host peaks, so a run from a
+# fast lab machine and one from a slow one land on a common scale and a code
+# regression can be told from a change of benchmark host.
+#
+# Normalization is done twice, once by the compute peak and once by the
+# bandwidth peak, because without knowing where a kernel sits on the roofline
+# either one alone can mask a regression on hosts with different
+# compute-to-bandwidth ratios. A benchmark is only flagged when it slows down
+# under both normalizations; the raw delta is always printed next to the
+# normalized ones.
+#
+# Typical use:
+#   # once per lab machine (and after hardware or BIOS changes):
+#   OMBenchmarkStore.py calibrate --db results.jsonl
+#   # after each benchmark run (ParseBenchmarks.py --run writes the CSV):
+#   OMBenchmarkStore.py ingest PerfGemm_Benchmark_1700000000 \
+#       --db results.jsonl --model Gemm --mcpu z16 --flags="-O3"
+#   # gate a commit against a baseline, wherever either was measured:
+#   OMBenchmarkStore.py compare --db results.jsonl \
+#       --baseline commit=1a2b3c4 --candidate commit=5d6e7f8 \
+#       --max-relative-slowdown 5
+#
+################################################################################
+
+import argparse
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import time
+
+# Time units google-benchmark emits, as factors to nanoseconds.
+TIME_UNITS = {"ns": 1.0, "us": 1.0e3, "ms": 1.0e6, "s": 1.0e9}
+
+# Size of the calibration operands: a matmul of this order for the compute
+# peak, an array of this many doubles copied for the bandwidth peak. Large
+# enough to spill every cache level, small enough to run in seconds.
+CALIBRATE_ORDER = 2048
+CALIBRATE_COPY_ELEMS = 1 << 26
+CALIBRATE_REPS = 5
+
+
+def read_db(path):
+    """All records of the JSON-lines database, oldest first."""
+    records = []
+    if not os.path.exists(path):
+        return records
+    with open(path, "r") as db:
+        for line in db:
+            line = line.strip()
+            if line:
+                records.append(json.loads(line))
+    return records
+
+
+def append_db(path, records):
+    with open(path, "a") as db:
+        for record in records:
+            db.write(json.dumps(record, sort_keys=True) + "\n")
+
+
+def current_commit():
+    """Abbreviated commit of this source tree, or None outside a checkout."""
+    try:
+        out = subprocess.run(
+            ["git", "rev-parse", "--short", "HEAD"],
+            capture_output=True,
+            text=True,
+            cwd=os.path.dirname(os.path.abspath(__file__)),
+        )
+    except OSError:
+        return None
+    return out.stdout.strip() if out.returncode == 0 else None
+
+
+def parse_benchmark_csv(path):
+    """Benchmark rows of a google-benchmark CSV file (--benchmark_out with
+    --benchmark_out_format=csv, as written by ParseBenchmarks.py), with the
+    hardware preamble skipped and times converted to nanoseconds."""
+    lines = open(path, "r").read().splitlines()
+    while lines and not lines[0].startswith("name,"):
+        lines.pop(0)
+    if not lines:
+        raise RuntimeError("no benchmark header in " + path)
+    fields = lines.pop(0).split(",")
+    rows = []
+    for line in lines:
+        if not line.strip():
+            continue
+        row = dict(zip(fields, line.split(",")))
+        unit = TIME_UNITS.get(row.get("time_unit", "ns"), 1.0)
+        entry = {"name": row["name"]}
+        for metric in ("real_time", "cpu_time"):
+            if row.get(metric):
+                entry[metric + "_ns"] = float(row[metric]) * unit
+        if row.get("iterations"):
+            entry["iterations"] = int(row["iterations"])
+        rows.append(entry)
+    return rows
+
+
+def calibrate():
+    """Measured peak GFLOPS and GB/s of this machine. Uses numpy: its matmul
+    runs the vendor BLAS, which is as close to the compute peak as any
+    generated kernel gets, and a large array copy bounds the bandwidth."""
+    try:
+        import numpy as np
+    except ImportError:
+        sys.exit("calibrate requires numpy")
+    n = CALIBRATE_ORDER
+    a = np.random.rand(n, n).astype(np.float32)
+    b = np.random.rand(n, n).astype(np.float32)
+    gflops = 0.0
+    for _ in range(CALIBRATE_REPS):
+        start = time.perf_counter()
+        a @ b
+        elapsed = time.perf_counter() - start
+        gflops = max(gflops, 2.0 * n * n * n / elapsed / 1.0e9)
+    src = np.random.rand(CALIBRATE_COPY_ELEMS)
+    gbps = 0.0
+    for _ in range(CALIBRATE_REPS):
+        start = time.perf_counter()
+        np.copyto(np.empty_like(src), src)
+        elapsed = time.perf_counter() - start
+        # A copy reads and writes every byte once.
+        gbps = max(gbps, 2.0 * src.nbytes / elapsed / 1.0e9)
+    return gflops, gbps
+
+
+def machine_peaks(records, host):
+    """Latest calibration of the given host, or None when it was never
+    calibrated."""
+    peaks = None
+    for record in records:
+        if record.get("kind") == "machine" and record.get("host") == host:
+            peaks = (record["peak_gflops"], record["peak_gbps"])
+    return peaks
+
+
+def parse_selector(selector):
+    """'key=value,key=value' into a dict; keys match result record fields
+    (commit, host, model, mcpu, flags)."""
+    matcher = {}
+    for part in selector.split(","):
+        if "=" not in part:
+            sys.exit("bad selector part '%s' (expected key=value)" % part)
+        key, value = part.split("=", 1)
+        matcher[key.strip()] = value.strip()
+    return matcher
+
+
+def select_results(records, matcher):
+    """Result records matching the selector, as {benchmark name: (median
+    metric values in ns, host)}. Results from several hosts may match; the
+    host seen last wins for normalization, matching the common case of one
+    selector describing one run."""
+    by_name = {}
+    hosts = {}
+    for record in records:
+        if record.get("kind") != "result":
+            continue
+        if any(str(record.get(key)) != value for key, value in matcher.items()):
+            continue
+        by_name.setdefault(record["name"], []).append(record)
+        hosts[record["name"]] = record["host"]
+    selected = {}
+    for name, group in by_name.items():
+        medians = {}
+        for metric in ("real_time_ns", "cpu_time_ns"):
+            values = [r[metric] for r in group if metric in r]
+            if values:
+                medians[metric] = statistics.median(values)
+        selected[name] = (medians, hosts[name])
+    return selected
+
+
+def cmd_calibrate(args):
+    gflops, gbps = calibrate()
+    record = {
+        "kind": "machine",
+        "host": platform.node(),
+        "cpu": platform.processor() or platform.machine(),
+        "peak_gflops": round(gflops, 2),
+        "peak_gbps": round(gbps, 2),
+        "timestamp": int(time.time()),
+    }
+    append_db(args.db, [record])
+    print(
+        "%s: %.1f GFLOPS, %.1f GB/s"
+        % (record["host"], record["peak_gflops"], record["peak_gbps"])
+    )
+
+
+def cmd_ingest(args):
+    host = platform.node()
+    commit = args.commit or current_commit()
+    if not commit:
+        sys.exit("not in a git checkout; pass --commit")
+    if machine_peaks(read_db(args.db), host) is None:
+        print(
+            "warning: host %s has no calibration record; run calibrate "
+            "before comparing across machines" % host,
+            file=sys.stderr,
+        )
+    records = []
+    for path in args.files:
+        for row in parse_benchmark_csv(path):
+            row.update(
+                kind="result",
+                host=host,
+                commit=commit,
+                model=args.model,
+                mcpu=args.mcpu,
+                flags=args.flags,
+                timestamp=int(time.time()),
+            )
+            records.append(row)
+    append_db(args.db, records)
+    print("ingested %d results into %s" % (len(records), args.db))
+
+
+def cmd_compare(args):
+    records = read_db(args.db)
+    baseline = select_results(records, parse_selector(args.baseline))
+    candidate = select_results(records, parse_selector(args.candidate))
+    if not baseline:
+        sys.exit("no results match baseline selector")
+    if not candidate:
+        sys.exit("no results match candidate selector")
+    metric = args.metric + "_ns"
+    regressions = 0
+    compared = 0
+    for name in sorted(baseline):
+        if name not in candidate:
+            continue
+        base_medians, base_host = baseline[name]
+        cand_medians, cand_host = candidate[name]
+        if metric not in base_medians or metric not in cand_medians:
+            continue
+        base_time = base_medians[metric]
+        cand_time = cand_medians[metric]
+        base_peaks = machine_peaks(records, base_host)
+        cand_peaks = machine_peaks(records, cand_host)
+        if base_host != cand_host and (not base_peaks or not cand_peaks):
+            sys.exit(
+                "results for '%s' come from %s and %s but a calibration "
+                "record is missing; run calibrate on both" % (name, base_host, cand_host)
+            )
+        compared += 1
+        raw_pct = (cand_time - base_time) / base_time * 100.0
+        if base_host == cand_host:
+            # Same machine: the raw delta is the normalized delta.
+            normalized = [raw_pct]
+            detail = "%+.1f%%" % raw_pct
+        else:
+            # Scale the candidate time to the baseline host: a kernel bound
+            # by a resource runs inversely proportional to its peak.
+            normalized = []
+            for axis in (0, 1):
+                scaled = cand_time * cand_peaks[axis] / base_peaks[axis]
+                normalized.append((scaled - base_time) / base_time * 100.0)
+            detail = "raw %+.1f%%, compute-normalized %+.1f%%, " "bandwidth-normalized %+.1f%%" % (
+                raw_pct,
+                normalized[0],
+                normalized[1],
+            )
+        flagged = args.max_relative_slowdown is not None and all(
+            pct > args.max_relative_slowdown for pct in normalized
+        )
+        if flagged:
+            regressions += 1
+        print(
+            "%s: %s (%.0f -> %.0f ns)%s"
+            % (name, detail, base_time, cand_time, " [REGRESSION]" if flagged else "")
+        )
+    if compared == 0:
+        sys.exit("baseline and candidate share no benchmark names")
+    if regressions:
+        print("%d benchmark(s) regressed beyond %.1f%%" % (regressions, args.max_relative_slowdown))
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Shared benchmark result store with hardware-normalized "
+        "comparisons for the test/perf suite."
+    )
+    parser.add_argument(
+        "--db",
+        default="results.jsonl",
+        help="JSON-lines result database (default results.jsonl)",
+    )
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    commands.add_parser(
+        "calibrate",
+        help="measure this machine's peak GFLOPS and bandwidth and record them",
+    )
+
+    ingest = commands.add_parser(
+        "ingest", help="add google-benchmark CSV output files to the store"
+    )
+    ingest.add_argument("files", nargs="+", help="benchmark CSV output files")
+    ingest.add_argument("--model", default="", help="model or op the run covers")
+    ingest.add_argument(
+        "--commit", default=None, help="commit measured (default: git HEAD)"
+    )
+    ingest.add_argument("--mcpu", default="", help="target CPU compiled for")
+    ingest.add_argument("--flags", default="", help="compile flags used")
+
+    compare = commands.add_parser(
+        "compare", help="compare two sets of stored results"
+    )
+    compare.add_argument(
+        "--baseline", required=True, help="selector, e.g. commit=1a2b3c4"
+    )
+    compare.add_argument(
+        "--candidate", required=True, help="selector, e.g. commit=5d6e7f8"
+    )
+    compare.add_argument(
+        "--metric",
+        default="cpu_time",
+        choices=["cpu_time", "real_time"],
+        help="metric to compare (default cpu_time)",
+    )
+    compare.add_argument(
+        "--max-relative-slowdown",
+        type=float,
+        default=None,
+        metavar="PCT",
+        help="exit 1 when a benchmark slows down more than PCT percent "
+        "under every normalization",
+    )
+
+    args = parser.parse_args()
+    if args.command == "calibrate":
+        cmd_calibrate(args)
+    elif args.command == "ingest":
+        cmd_ingest(args)
+    elif args.command == "compare":
+        cmd_compare(args)
+
+
+if __name__ == "__main__":
+    main()
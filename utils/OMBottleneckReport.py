@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+
+##################### OMBottleneckReport.py ####################################
+#
+# Copyright 2022 The IBM Research Authors.
+#
+################################################################################
+#
+# This script attributes measured per-op times back to the original ONNX nodes.
+# It joins a binary instrumentation trace (collected by running a model
+# compiled with --instrument-ops and OMINSTRUMENTTRACE=<file>, see
+# OMInstrumentTraceReport.py for the format) with the ONNX-level IR emitted by
+# onnx-mlir (--EmitONNXIR, or the .onnx.mlir file kept by --preserveMLIR).
+# The IR provides, for every node, its onnx_node_name and the static shapes of
+# its operands and results; from those the script estimates the bytes moved
+# and, for the compute-heavy ops, the floating point work. The report ranks
+# nodes by measured time and, when peak machine numbers are supplied, shows
+# how close each node comes to the compute or bandwidth roof.
+#
+# Typical use:
+#   onnx-mlir -O3 --EmitONNXIR mymodel.onnx            # mymodel.onnx.mlir
+#   onnx-mlir -O3 --instrument-stage=Onnx --instrument-ops=onnx.* \
+#       --InstrumentBeforeOp --InstrumentAfterOp --InstrumentReportTime \
+#       mymodel.onnx
+#   OMINSTRUMENTTRACE=trace.bin ./run_mymodel
+#   OMBottleneckReport.py trace.bin mymodel.onnx.mlir \
+#       --tsc-ghz 2.5 --peak-gflops 150 --peak-gbps 50
+#
+################################################################################
+
+import argparse
+import re
+import sys
+
+from OMInstrumentTraceReport import read_trace, aggregate, NAME_LEN
+
+# Bytes per element for the MLIR element types that appear in ONNX models.
+ELEMENT_SIZE = {
+    "f64": 8,
+    "f32": 4,
+    "f16": 2,
+    "bf16": 2,
+    "i64": 8,
+    "ui64": 8,
+    "i32": 4,
+    "ui32": 4,
+    "i16": 2,
+    "ui16": 2,
+    "i8": 1,
+    "ui8": 1,
+    "i1": 1,
+}
+
+# Matches an ONNX operation line in the textual IR, capturing the op name, the
+# attribute dictionary, and the function type.
+OP_RE = re.compile(
+    r'= "onnx\.(\w+)"\(.*?\)\s*(\{.*\})?\s*:\s*\((.*?)\)\s*->\s*(.+?)\s*$'
+)
+NODE_NAME_RE = re.compile(r'onnx_node_name = "([^"]*)"')
+TENSOR_RE = re.compile(r"tensor<([^>]*)>")
+
+
+class Node(object):
+    def __init__(self, op, name, inputs, outputs, attrs=""):
+        self.op = op
+        self.name = name
+        self.inputs = inputs  # [(dims, element type)]
+        self.outputs = outputs
+        self.attrs = attrs  # textual attribute dictionary of the op
+
+
+def parse_tensors(types):
+    """Parses 'tensor<2x3xf32>, tensor<f32>, none' into [(dims, elt)]."""
+    tensors = []
+    for match in TENSOR_RE.finditer(types):
+        parts = match.group(1).split("x")
+        elt = parts[-1]
+        dims = []
+        for dim in parts[:-1]:
+            # Dynamic dims are reported as size 1; the report flags them.
+            dims.append(int(dim) if dim.isdigit() else -1)
+        if elt in ELEMENT_SIZE:
+            tensors.append((dims, elt))
+    return tensors
+
+
+def parse_ir(path):
+    """Returns {onnx_node_name: Node} for the ONNX-level IR file."""
+    nodes = {}
+    with open(path) as f:
+        for line in f:
+            match = OP_RE.search(line)
+            if not match:
+                continue
+            op, attrs, in_types, out_types = match.groups()
+            name_match = NODE_NAME_RE.search(attrs) if attrs else None
+            if not name_match:
+                continue
+            nodes[name_match.group(1)] = Node(op, name_match.group(1),
+                parse_tensors(in_types), parse_tensors(out_types), attrs)
+    return nodes
+
+
+def num_elements(dims):
+    count = 1
+    for dim in dims:
+        count *= max(dim, 1)
+    return count
+
+
+def tensor_bytes(tensors):
+    return sum(
+        num_elements(dims) * ELEMENT_SIZE[elt] for (dims, elt) in tensors
+    )
+
+
+def estimate_flops(node):
+    """Floating point work for the compute-heavy ops, 0 when unknown."""
+    if not node.outputs:
+        return 0
+    out_dims = node.outputs[0][0]
+    if node.op in ("MatMul", "Gemm", "QLinearMatMul"):
+        # 2 * output elements * reduction length.
+        if not node.inputs:
+            return 0
+        a_dims = node.inputs[0][0]
+        k = max(a_dims[-1], 1) if a_dims else 1
+        return 2 * num_elements(out_dims) * k
+    if node.op in ("Conv", "ConvInteger", "QLinearConv"):
+        # 2 * output elements * (Cin/group * kernel volume); the weight
+        # tensor is (Cout, Cin/group, kernel dims...).
+        if len(node.inputs) < 2:
+            return 0
+        w_dims = node.inputs[1][0]
+        if len(w_dims) < 2:
+            return 0
+        return 2 * num_elements(out_dims) * num_elements(w_dims[1:])
+    return 0
+
+
+def signature(node):
+    def fmt(tensors):
+        return ",".join(
+            "x".join(str(d) if d >= 0 else "?" for d in dims) + "x" + elt
+            for (dims, elt) in tensors
+        )
+
+    return fmt(node.inputs) + " -> " + fmt(node.outputs)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Rank ONNX nodes by measured time with shapes, bytes and "
+        "achieved-vs-peak estimates."
+    )
+    parser.add_argument("trace", help="trace file written via OMINSTRUMENTTRACE")
+    parser.add_argument(
+        "ir", help="ONNX-level IR file (--EmitONNXIR or --preserveMLIR output)"
+    )
+    parser.add_argument(
+        "--tsc-ghz",
+        type=float,
+        default=0.0,
+        help="TSC frequency in GHz; when given, times are reported in ms "
+        "(otherwise timestamps are assumed to be nanoseconds)",
+    )
+    parser.add_argument(
+        "--peak-gflops",
+        type=float,
+        default=0.0,
+        help="peak machine GFLOP/s, enables the compute roof column",
+    )
+    parser.add_argument(
+        "--peak-gbps",
+        type=float,
+        default=0.0,
+        help="peak memory bandwidth in GB/s, enables the bandwidth roof column",
+    )
+    parser.add_argument(
+        "--top", type=int, default=0, help="only report the top N nodes"
+    )
+    args = parser.parse_args()
+
+    nodes = parse_ir(args.ir)
+    if not nodes:
+        sys.exit("no named ONNX operations found in " + args.ir)
+
+    threads = read_trace(args.trace)
+    stats, _ = aggregate(threads, True)
+    if not stats:
+        sys.exit("no paired before/after events in trace")
+
+    # The trace stores node names truncated to NAME_LEN - 1 characters; match
+    # a truncated name back to the IR by unique prefix.
+    def resolve(node_name):
+        if node_name in nodes:
+            return nodes[node_name]
+        if len(node_name) == NAME_LEN - 1:
+            candidates = [
+                node for name, node in nodes.items()
+                if name.startswith(node_name)
+            ]
+            if len(candidates) == 1:
+                return candidates[0]
+        return None
+
+    ticks_per_sec = args.tsc_ghz * 1e9 if args.tsc_ghz else 1e9
+    rows = []
+    grand_total = 0
+    for (op, node_name), (count, total, minimum, maximum) in stats.items():
+        node = resolve(node_name)
+        seconds = total / ticks_per_sec
+        grand_total += seconds
+        moved = tensor_bytes(node.inputs + node.outputs) * count if node else 0
+        flops = estimate_flops(node) * count if node else 0
+        rows.append((seconds, count, op, node_name, node, moved, flops))
+    rows.sort(reverse=True, key=lambda row: row[0])
+    if args.top:
+        rows = rows[: args.top]
+
+    header = "{:<28} {:<16} {:>6} {:>10} {:>6} {:>9} {:>9}".format(
+        "node", "op", "count", "time (ms)", "%", "GB", "GFLOP"
+    )
+    if args.peak_gbps:
+        header += " {:>8}".format("% bw")
+    if args.peak_gflops:
+        header += " {:>8}".format("% flops")
+    header += "  signature"
+    print(header)
+    for seconds, count, op, node_name, node, moved, flops in rows:
+        row = "{:<28} {:<16} {:>6} {:>10.3f} {:>5.1f}% {:>9.3f} {:>9.3f}".format(
+            node_name if node_name else "NOTSET",
+            op,
+            count,
+            seconds * 1e3,
+            100.0 * seconds / grand_total if grand_total else 0.0,
+            moved / 1e9,
+            flops / 1e9,
+        )
+        if args.peak_gbps:
+            achieved = moved / seconds / 1e9 if seconds else 0.0
+            row += " {:>7.1f}%".format(100.0 * achieved / args.peak_gbps)
+        if args.peak_gflops:
+            achieved = flops / seconds / 1e9 if seconds else 0.0
+            row += " {:>7.1f}%".format(100.0 * achieved / args.peak_gflops)
+        row += "  " + (signature(node) if node else "<not in IR>")
+        print(row)
+    if any(
+        node and any(d < 0 for dims, _ in node.inputs + node.outputs
+            for d in dims)
+        for _, _, _, _, node, _, _ in rows
+    ):
+        print("('?' marks dynamic dims; their bytes/FLOP use size 1)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+
+################### OMInstrumentTraceReport.py ################################
+#
+# Copyright 2022 The IBM Research Authors.
+#
+################################################################################
+#
+# This script aggregates a binary instrumentation trace written by a model
+# compiled with --instrument-onnx-ops and run with OMINSTRUMENTTRACE=<file>,
+# and prints per-op latency (and memory, when recorded) tables.
+#
+# The trace format is produced by traceDump in src/Runtime/OMInstrument.inc:
+#   8 bytes   magic "OMTRACE" + version byte
+#   u64       event record size in bytes
+# then, per thread:
+#   u64       thread id
+#   u64       total events recorded (events beyond the ring size are dropped,
+#             oldest first)
+#   u64       events stored
+#   events    stored records, oldest to newest:
+#               u64 timestamp (rdtsc ticks on x86, nanoseconds elsewhere)
+#               i64 tag (see InstrumentActions)
+#               u64 vmSize in bytes (0 unless the memory bit is set)
+#               24 bytes op name, NUL padded
+#               24 bytes node name, NUL padded
+#
+################################################################################
+
+import argparse
+import struct
+import sys
+from collections import defaultdict
+
+MAGIC = b"OMTRACE"
+NAME_LEN = 24
+INSTRUMENT_BEFORE_OP = 1 << 0
+INSTRUMENT_AFTER_OP = 1 << 1
+
+
+def decode_name(raw):
+    return raw.split(b"\0", 1)[0].decode("utf-8", errors="replace")
+
+
+def read_trace(path):
+    """Returns {thread_id: (total, [(timestamp, tag, vm, op, node)])}."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < 16 or data[:7] != MAGIC:
+        sys.exit("not an OMInstrument trace file: " + path)
+    version = data[7]
+    if version != 1:
+        sys.exit("unsupported trace version: " + str(version))
+    (event_size,) = struct.unpack_from("<Q", data, 8)
+    offset = 16
+    threads = {}
+    while offset < len(data):
+        thread_id, total, stored = struct.unpack_from("<QQQ", data, offset)
+        offset += 24
+        events = []
+        for _ in range(stored):
+            timestamp, tag, vm = struct.unpack_from("<QqQ", data, offset)
+            op = decode_name(data[offset + 24 : offset + 24 + NAME_LEN])
+            node = decode_name(
+                data[offset + 24 + NAME_LEN : offset + 24 + 2 * NAME_LEN]
+            )
+            events.append((timestamp, tag, vm, op, node))
+            offset += event_size
+        threads[thread_id] = (total, events)
+    return threads
+
+
+def aggregate(threads, by_node):
+    """Pairs before/after events per thread and returns per-key stats."""
+    stats = defaultdict(lambda: [0, 0, 0, 0])  # count, total, minimum, maximum
+    vm_peak = defaultdict(int)
+    for _, (_, events) in threads.items():
+        open_events = {}
+        for timestamp, tag, vm, op, node in events:
+            key = (op, node) if by_node else op
+            if tag & INSTRUMENT_BEFORE_OP:
+                open_events[key] = timestamp
+            elif tag & INSTRUMENT_AFTER_OP and key in open_events:
+                elapsed = timestamp - open_events.pop(key)
+                entry = stats[key]
+                entry[0] += 1
+                entry[1] += elapsed
+                entry[2] = elapsed if entry[0] == 1 else min(entry[2], elapsed)
+                entry[3] = max(entry[3], elapsed)
+            if vm:
+                vm_peak[key] = max(vm_peak[key], vm)
+    return stats, vm_peak
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Aggregate an OMInstrument binary trace into per-op tables."
+    )
+    parser.add_argument("trace", help="trace file written via OMINSTRUMENTTRACE")
+    parser.add_argument(
+        "--by-node",
+        action="store_true",
+        help="report per (op, node name) instead of per op",
+    )
+    parser.add_argument(
+        "--sort",
+        choices=["total", "average", "count"],
+        default="total",
+        help="table sort key (default: total)",
+    )
+    parser.add_argument(
+        "--emit-profile",
+        metavar="FILE",
+        help="also write a profile file ('<op> <node> <total>' per line) "
+        "usable with onnx-mlir --profile-data",
+    )
+    args = parser.parse_args()
+
+    threads = read_trace(args.trace)
+    for thread_id, (total, events) in threads.items():
+        if total > len(events):
+            print(
+                "warning: thread {} dropped {} oldest events".format(
+                    thread_id, total - len(events)
+                ),
+                file=sys.stderr,
+            )
+
+    stats, vm_peak = aggregate(threads, args.by_node)
+    if not stats:
+        sys.exit("no paired before/after events in trace")
+
+    if args.emit_profile:
+        node_stats, _ = aggregate(threads, True)
+        with open(args.emit_profile, "w") as profile:
+            profile.write("# onnx-mlir instrumentation profile\n")
+            for (op, node), (count, total, minimum, maximum) in sorted(
+                node_stats.items(), key=lambda item: item[1][1], reverse=True
+            ):
+                profile.write(
+                    "{} {} {}\n".format(op, node if node else "NOTSET", total)
+                )
+
+    def sort_key(item):
+        count, total, minimum, maximum = item[1]
+        if args.sort == "count":
+            return count
+        if args.sort == "average":
+            return total / count
+        return total
+
+    print(
+        "{:<40} {:>8} {:>14} {:>12} {:>12} {:>12} {:>12}".format(
+            "op", "count", "total", "average", "min", "max", "peak vm"
+        )
+    )
+    print("(times in timestamp units: rdtsc ticks on x86, ns elsewhere)")
+    for key, (count, total, minimum, maximum) in sorted(
+        stats.items(), key=sort_key, reverse=True
+    ):
+        name = "{} ({})".format(*key) if args.by_node else key
+        vm = vm_peak.get(key, 0)
+        print(
+            "{:<40} {:>8} {:>14} {:>12.0f} {:>12} {:>12} {:>12}".format(
+                name, count, total, total / count, minimum, maximum, vm
+            )
+        )
+
+
+if __name__ == "__main__":
+    main()
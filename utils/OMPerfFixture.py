@@ -0,0 +1,367 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+
+######################## OMPerfFixture.py ######################################
+#
+# Copyright 2023 The IBM Research Authors.
+#
+################################################################################
+#
+# This script turns the hottest nodes of a profiled model into a standalone
+# microbenchmark file for the test/perf google-benchmark suite. It joins a
+# binary instrumentation trace (collected with --instrument-ops and
+# OMINSTRUMENTTRACE=<file>) with the ONNX-level IR of the model, ranks the
+# nodes by measured time, and for each of the top nodes whose operation has a
+# test/modellib builder emits a benchmark that rebuilds exactly that operation
+# with the captured input shapes and attributes on synthetic data. The result
+# compiles like any other Perf*.cpp file, so a slow kernel can be reproduced,
+# filed, and bisected without shipping the model or its weights.
+#
+# Hot nodes whose operation has no modellib builder (or whose shapes are
+# dynamic) cannot be reproduced this way; they are listed in a comment at the
+# top of the generated file so the coverage gap is visible.
+#
+# Typical use:
+#   onnx-mlir -O3 --EmitONNXIR mymodel.onnx            # mymodel.onnx.mlir
+#   onnx-mlir -O3 --instrument-stage=Onnx --instrument-ops=onnx.* \
+#       --InstrumentBeforeOp --InstrumentAfterOp --InstrumentReportTime \
+#       mymodel.onnx
+#   OMINSTRUMENTTRACE=trace.bin ./run_mymodel
+#   OMPerfFixture.py trace.bin mymodel.onnx.mlir --top 5 -o PerfMyModel.cpp
+#   # then register it in test/perf/CMakeLists.txt:
+#   #   add_perf_unittest(PerfMyModel PerfMyModel.cpp
+#   #     LINK_LIBS PRIVATE ModelLib PerfLib)
+#
+################################################################################
+
+import argparse
+import re
+import sys
+
+from OMBottleneckReport import parse_ir, signature
+from OMInstrumentTraceReport import read_trace, aggregate, NAME_LEN
+
+
+def attr_scalar(attrs, name, default):
+    """Scalar attribute value ('transA = 1 : si64', 'alpha = 2.0 : f32')."""
+    match = re.search(r"\b%s = ([-+\d.eE]+)" % name, attrs or "")
+    return float(match.group(1)) if match else default
+
+
+def attr_array(attrs, name, default):
+    """Integer array attribute value ('pads = [1, 1, 1, 1]')."""
+    match = re.search(r"\b%s = \[([^\]]*)\]" % name, attrs or "")
+    if not match:
+        return default
+    return [int(v) for v in match.group(1).split(",")]
+
+
+def flops_bytes(flops, tensors):
+    """Arguments for perf_recordRoofline: the FLOP of one run and the bytes of
+    one compulsory pass over the given input/output tensors."""
+    moved = sum(
+        elements(dims) * {"f64": 8, "f32": 4, "f16": 2}.get(elt, 4)
+        for dims, elt in tensors
+    )
+    return "%.1f, %.1f" % (flops, moved)
+
+
+def elements(dims):
+    count = 1
+    for dim in dims:
+        count *= dim
+    return count
+
+
+# Generators, one per supported operation. Each takes the parsed Node and
+# returns (builder expression, roofline arguments), or None when this
+# particular instance cannot be rebuilt (unexpected rank, unsupported
+# attribute combination). All shapes must be static; main filters dynamic
+# nodes before dispatching here.
+
+
+def gen_matmul(node):
+    if len(node.inputs) != 2:
+        return None
+    a, b = node.inputs[0][0], node.inputs[1][0]
+    if len(a) != 2 or len(b) != 2:
+        return None
+    i, k, j = a[0], a[1], b[1]
+    builder = "MatMul2DLibBuilder(modelName, %d, %d, %d)" % (i, j, k)
+    return builder, flops_bytes(2.0 * i * j * k, node.inputs + node.outputs)
+
+
+def gen_gemm(node):
+    if len(node.inputs) < 2:
+        return None
+    a, b = node.inputs[0][0], node.inputs[1][0]
+    if len(a) != 2 or len(b) != 2:
+        return None
+    a_trans = int(attr_scalar(node.attrs, "transA", 0))
+    b_trans = int(attr_scalar(node.attrs, "transB", 0))
+    i, k = (a[1], a[0]) if a_trans else (a[0], a[1])
+    j = b[0] if b_trans else b[1]
+    c_rank = len(node.inputs[2][0]) if len(node.inputs) > 2 else 1
+    alpha = attr_scalar(node.attrs, "alpha", 1.0)
+    beta = attr_scalar(node.attrs, "beta", 1.0)
+    builder = (
+        "GemmLibBuilder(modelName, %d, %d, %d, %d, %d, %d, %.1f, %.1f)"
+        % (i, j, k, a_trans, b_trans, c_rank, alpha, beta)
+    )
+    return builder, flops_bytes(2.0 * i * j * k, node.inputs + node.outputs)
+
+
+def gen_conv(node):
+    if len(node.inputs) < 2:
+        return None
+    x, w = node.inputs[0][0], node.inputs[1][0]
+    # Conv2DLibBuilder covers the common case: 2 spatial dims, group 1,
+    # uniform stride and dilation.
+    if len(x) != 4 or len(w) != 4:
+        return None
+    if int(attr_scalar(node.attrs, "group", 1)) != 1:
+        return None
+    strides = attr_array(node.attrs, "strides", [1, 1])
+    dilations = attr_array(node.attrs, "dilations", [1, 1])
+    if strides[0] != strides[1] or dilations[0] != dilations[1]:
+        return None
+    pads = attr_array(node.attrs, "pads", [0, 0, 0, 0])
+    builder = (
+        "Conv2DLibBuilder(modelName, %d, %d, %d, %d, %d, %d, %d,\n"
+        "      onnx_mlir::test::ConvAutoPad::NOTSET, %d, %d, %d, %d, %d, %d,\n"
+        "      /*isDynamic=*/false)"
+        % (x[0], x[1], w[0], x[2], x[3], w[2], w[3], pads[0], pads[2],
+           pads[1], pads[3], strides[0], dilations[0])
+    )
+    flops = 2.0 * elements(node.outputs[0][0]) * elements(w[1:])
+    return builder, flops_bytes(flops, node.inputs + node.outputs)
+
+
+def gen_leakyrelu(node):
+    if len(node.inputs) != 1:
+        return None
+    n = elements(node.inputs[0][0])
+    alpha = attr_scalar(node.attrs, "alpha", 0.01)
+    builder = "LeakyReluLibBuilder(modelName, %d, %.6f)" % (n, alpha)
+    return builder, flops_bytes(2.0 * n, node.inputs + node.outputs)
+
+
+def rnn_dims(node):
+    """(direction, S, B, I, H) from the X (S x B x I) and R (D x gates*H x H)
+    inputs, None when the layout is not the default time-major one."""
+    if len(node.inputs) < 3:
+        return None
+    if int(attr_scalar(node.attrs, "layout", 0)) != 0:
+        return None
+    x, r = node.inputs[0][0], node.inputs[2][0]
+    if len(x) != 3 or len(r) != 3:
+        return None
+    return r[0], x[0], x[1], x[2], r[2]
+
+
+def gen_lstm(node):
+    dims = rnn_dims(node)
+    if not dims:
+        return None
+    d, s, b, i, h = dims
+    builder = (
+        "LSTMLibBuilder(modelName, %d, %d, %d, %d, %d,\n"
+        "      /*isDynamicS=*/false, /*isDynamicB=*/false)" % (d, s, b, i, h)
+    )
+    flops = 2.0 * d * s * b * 4 * h * (i + h)
+    return builder, flops_bytes(flops, node.inputs + node.outputs)
+
+
+def gen_gru(node):
+    dims = rnn_dims(node)
+    if not dims:
+        return None
+    d, s, b, i, h = dims
+    lbr = int(attr_scalar(node.attrs, "linear_before_reset", 0))
+    builder = (
+        "GRULibBuilder(modelName, %d, %d, %d, %d, %d, %d,\n"
+        "      /*isDynamicS=*/false, /*isDynamicB=*/false)"
+        % (d, s, b, i, h, lbr)
+    )
+    flops = 2.0 * d * s * b * 3 * h * (i + h)
+    return builder, flops_bytes(flops, node.inputs + node.outputs)
+
+
+def gen_rnn(node):
+    dims = rnn_dims(node)
+    if not dims:
+        return None
+    d, s, b, i, h = dims
+    builder = (
+        "RNNLibBuilder(modelName, %d, %d, %d, %d, %d,\n"
+        "      /*isDynamicS=*/false, /*isDynamicB=*/false)" % (d, s, b, i, h)
+    )
+    flops = 2.0 * d * s * b * h * (i + h)
+    return builder, flops_bytes(flops, node.inputs + node.outputs)
+
+
+GENERATORS = {
+    "MatMul": gen_matmul,
+    "Gemm": gen_gemm,
+    "Conv": gen_conv,
+    "LeakyRelu": gen_leakyrelu,
+    "LSTM": gen_lstm,
+    "GRU": gen_gru,
+    "RNN": gen_rnn,
+}
+
+FILE_HEADER = """\
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Microbenchmark fixtures generated by utils/OMPerfFixture.py from an
+// instrumentation trace; each benchmark rebuilds one hot node of the profiled
+// model with its captured input shapes on synthetic data. Register with
+// add_perf_unittest in test/perf/CMakeLists.txt (link ModelLib and PerfLib).
+//
+//   %s
+
+#include <benchmark/benchmark.h>
+
+#include "include/OnnxMlirCompiler.h"
+#include "test/modellib/ModelLib.hpp"
+#include "test/perf/PerfHelper.hpp"
+
+const std::string modelName("%s");
+"""
+
+BENCHMARK_TEMPLATE = """\
+
+// %s "%s": %s, %.1f%% of the measured time.
+static void %s(benchmark::State &state) {
+  onnx_mlir::test::%s model(%s);
+  assert(model.build() && model.compileAndLoad() && model.prepareInputs() &&
+         "failed %s fixture");
+  perf_startHWCounters();
+  for (auto _ : state)
+    model.run();
+  perf_stopHWCounters(state);
+  perf_recordRoofline(state, %s);
+}
+BENCHMARK(%s)->Unit(benchmark::kMillisecond);
+"""
+
+
+def benchmark_name(op, node_name, taken):
+    """A unique C++ identifier for the benchmark of one node."""
+    name = "BM_%s_%s" % (op, re.sub(r"[^A-Za-z0-9]+", "_", node_name or "n"))
+    name = name.strip("_")
+    while name in taken:
+        name += "_"
+    taken.add(name)
+    return name
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate a test/perf benchmark file reproducing the "
+        "hottest nodes of a profiled model."
+    )
+    parser.add_argument("trace", help="trace file written via OMINSTRUMENTTRACE")
+    parser.add_argument(
+        "ir", help="ONNX-level IR file (--EmitONNXIR or --preserveMLIR output)"
+    )
+    parser.add_argument(
+        "--top", type=int, default=5,
+        help="number of hot nodes to turn into benchmarks (default: 5)",
+    )
+    parser.add_argument(
+        "-o", "--output", default=None,
+        help="generated .cpp file (default: stdout)",
+    )
+    args = parser.parse_args()
+
+    nodes = parse_ir(args.ir)
+    if not nodes:
+        sys.exit("no named ONNX operations found in " + args.ir)
+
+    threads = read_trace(args.trace)
+    stats, _ = aggregate(threads, True)
+    if not stats:
+        sys.exit("no paired before/after events in trace")
+
+    def resolve(node_name):
+        if node_name in nodes:
+            return nodes[node_name]
+        if len(node_name) == NAME_LEN - 1:
+            candidates = [
+                node for name, node in nodes.items()
+                if name.startswith(node_name)
+            ]
+            if len(candidates) == 1:
+                return candidates[0]
+        return None
+
+    rows = sorted(
+        (
+            (total, op, node_name, resolve(node_name))
+            for (op, node_name), (_, total, _, _) in stats.items()
+        ),
+        reverse=True,
+        key=lambda row: row[0],
+    )
+    grand_total = sum(row[0] for row in rows) or 1
+
+    fixture_base = "./" + re.sub(
+        r"\W+", "", (args.output or "perffixture").rsplit(".", 1)[0]
+    ).lower()
+    benchmarks, skipped, taken = [], [], set()
+    for total, op, node_name, node in rows[: args.top]:
+        percent = 100.0 * total / grand_total
+        # The trace reports the dialect-qualified name; the IR parser keeps
+        # the bare one.
+        op = node.op if node else op.rpartition(".")[2]
+        generated = None
+        if node and not any(
+            d < 0 for dims, _ in node.inputs + node.outputs for d in dims
+        ):
+            generator = GENERATORS.get(op)
+            generated = generator(node) if generator else None
+        if not generated:
+            why = "no modellib builder for this op" if node else "not in IR"
+            if node and any(
+                d < 0 for dims, _ in node.inputs + node.outputs for d in dims
+            ):
+                why = "dynamic shape"
+            skipped.append(
+                "//   %s \"%s\" (%.1f%%): %s"
+                % (op, node_name, percent, why)
+            )
+            continue
+        builder, roofline = generated
+        # Split the builder expression into class name and arguments.
+        cls, sep, builder_args = builder.partition("(")
+        name = benchmark_name(op, node_name, taken)
+        benchmarks.append(
+            BENCHMARK_TEMPLATE
+            % (op, node_name, signature(node), percent, name, cls,
+               builder_args[:-1], op, roofline, name)
+        )
+
+    if not benchmarks:
+        sys.exit("none of the top %d nodes can be rebuilt; rerun with a "
+                 "larger --top or extend test/modellib" % args.top)
+
+    command = "OMPerfFixture.py " + " ".join(sys.argv[1:])
+    text = FILE_HEADER % (command, fixture_base)
+    if skipped:
+        text += "\n// Hot nodes not reproduced:\n" + "\n".join(skipped) + "\n"
+    text += "".join(benchmarks)
+    text += "\nPERF_MAIN()\n"
+
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+        print("wrote %d benchmark(s) to %s" % (len(benchmarks), args.output))
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == "__main__":
+    main()
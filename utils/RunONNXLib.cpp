@@ -72,24 +72,40 @@ auto printUsage = [](auto &out, const char *name) {
   out << R"""(
     -h | --help
          Print help message.
+    -i file1[,file2...] | --input file1[,file2...]
+         Initialize the inputs with the raw binary content of the
+         given files, one file per input in signature order,
+         instead of leaving the buffers uninitialized. File sizes
+         must match the tensor sizes exactly.
     -n NUM | --iterations NUM
          Number of times to run the tests, default 1.
     -m NUM | --meas NUM
          Measure the kernel execution time NUM times.
     -r | -reuse true|false
          Reuse input data, default on
+    -t NUM | --threads NUM
+         Run NUM concurrent sessions, each with its own inputs and
+         its own iteration count, default 1. Measured times of all
+         sessions are merged before the statistics are printed.
     -v | --verbose
          Print the shape of the inputs and outputs.
+    -w NUM | --warmup NUM
+         Perform NUM unmeasured warmup runs per session before the
+         iterations, default 0.
 
   )""";
 };
 
 #include <algorithm>
 #include <assert.h>
+#include <cmath>
 #include <dlfcn.h>
 #include <getopt.h>
 #include <iostream>
+#include <mutex>
+#include <stdio.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Json reader & LLVM support.
@@ -105,8 +121,10 @@ using namespace std;
 #else
 #include <sys/time.h>
 #endif
-// Data structure to hold measurement times (in microseconds).
+// Data structure to hold measurement times (in microseconds), merged from
+// all sessions. Guarded by timeLogMutex while sessions are running.
 vector<uint64_t> timeLogInMicroSec;
+mutex timeLogMutex;
 
 // Interface definitions
 extern "C" OMTensorList *run_main_graph(OMTensorList *);
@@ -132,7 +150,7 @@ void (*dll_omTensorListDestroy)(OMTensorList *);
 #define OM_TENSOR_CREATE omTensorCreateWithOwnership
 #define OM_TENSOR_LIST_CREATE omTensorListCreateWithOwnership
 #define OM_TENSOR_LIST_DESTROY omTensorListDestroy
-#define OPTIONS "hn:m:vd:r:"
+#define OPTIONS "hi:n:m:vd:r:t:w:"
 #else
 #define RUN_MAIN_GRAPH dll_run_main_graph
 #define OM_INPUT_SIGNATURE dll_omInputSignature
@@ -140,15 +158,18 @@ void (*dll_omTensorListDestroy)(OMTensorList *);
 #define OM_TENSOR_CREATE dll_omTensorCreateWithOwnership
 #define OM_TENSOR_LIST_CREATE dll_omTensorListCreateWithOwnership
 #define OM_TENSOR_LIST_DESTROY dll_omTensorListDestroy
-#define OPTIONS "e:hn:m:vd:r:"
+#define OPTIONS "e:hi:n:m:vd:r:t:w:"
 #endif
 
 // Global variables to record what we should do in this run.
 static int sIterations = 1;
+static int sWarmupIterations = 0;
+static int sThreads = 1;
 static bool verbose = false;
 static bool reuseInput = true;
 static bool measureExecTime = false;
 static vector<int64_t> dimKnownAtRuntime;
+static vector<string> inputFileNames;
 
 void usage(const char *name) {
   printUsage(cout, name);
@@ -198,10 +219,13 @@ void parseArgs(int argc, char **argv) {
       {"dim", required_argument, 0, 'd'},         // dimensions.
       {"entry-point", required_argument, 0, 'e'}, // Entry point.
       {"help", no_argument, 0, 'h'},              // Help.
+      {"input", required_argument, 0, 'i'},       // Input replay files.
       {"iterations", required_argument, 0, 'n'},  // Number of iterations.
       {"meas", required_argument, 0, 'm'},        // Measurement of time.
       {"reuse", required_argument, 0, 'r'},       // cached input.
+      {"threads", required_argument, 0, 't'},     // Concurrent sessions.
       {"verbose", no_argument, 0, 'v'},           // Verbose.
+      {"warmup", required_argument, 0, 'w'},      // Warmup iterations.
       {0, 0, 0, 0}};
 
   while (true) {
@@ -231,6 +255,20 @@ void parseArgs(int argc, char **argv) {
     case 'e':
       entryPointName = optarg;
       break;
+    case 'i': {
+      // Comma-separated list of input replay files, in signature order.
+      inputFileNames.clear();
+      string fileList(optarg);
+      size_t start = 0;
+      while (start <= fileList.size()) {
+        size_t comma = fileList.find(',', start);
+        if (comma == string::npos)
+          comma = fileList.size();
+        inputFileNames.push_back(fileList.substr(start, comma - start));
+        start = comma + 1;
+      }
+      break;
+    }
     case 'n':
       sIterations = atoi(optarg);
       break;
@@ -254,16 +292,26 @@ void parseArgs(int argc, char **argv) {
         usage(argv[0]);
       }
       break;
+    case 't':
+      sThreads = atoi(optarg);
+      break;
     case 'v':
       verbose = true;
       break;
+    case 'w':
+      sWarmupIterations = atoi(optarg);
+      break;
     default:
       usage(argv[0]);
     }
   }
-  // Make sure that iterations are positive.
+  // Make sure that iterations, warmup, and sessions are in range.
   if (sIterations < 1)
     sIterations = 1;
+  if (sWarmupIterations < 0)
+    sWarmupIterations = 0;
+  if (sThreads < 1)
+    sThreads = 1;
 
 // Process the DLL.
 #if LOAD_MODEL_STATICALLY
@@ -305,6 +353,35 @@ void parseArgs(int argc, char **argv) {
  * output).
  * @return pointer to the TensorList just created, or null on error.
  */
+// Fill a freshly allocated input buffer with the raw content of the replay
+// file recorded for input i, when files were given with the -i option. The
+// file size must match the buffer size exactly.
+void replayInputFile(int i, void *data, size_t bytes, bool silent) {
+  if (inputFileNames.empty() || !data)
+    return;
+  const string &name = inputFileNames[i];
+  FILE *file = fopen(name.c_str(), "rb");
+  if (!file) {
+    printf("Error: cannot open input file %s\n", name.c_str());
+    usage("run-onnx-lib");
+  }
+  fseek(file, 0, SEEK_END);
+  long fileSize = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (fileSize != (long)bytes) {
+    printf("Error: input file %s has %ld bytes, tensor needs %ld\n",
+        name.c_str(), fileSize, (long)bytes);
+    fclose(file);
+    usage("run-onnx-lib");
+  }
+  size_t bytesRead = fread(data, 1, bytes, file);
+  assert(bytesRead == bytes && "failed to read input file");
+  (void)bytesRead;
+  fclose(file);
+  if (!silent)
+    printf("  Input %d replayed from %s\n", i, name.c_str());
+}
+
 OMTensorList *omTensorListCreateFromInputSignature(
     void **dataPtrList, bool dataAlloc, bool trace, bool silent) {
   string entryPointName("run_main_graph");
@@ -326,6 +403,11 @@ OMTensorList *omTensorListCreateFromInputSignature(
   // Allocate array of inputs.
   int inputNum = JSONArray->size();
   assert(inputNum >= 0 && inputNum < 100 && "out of bound number of inputs");
+  if (!inputFileNames.empty() && (int)inputFileNames.size() != inputNum) {
+    printf("Error: %d replay files provided for %d model inputs\n",
+        (int)inputFileNames.size(), inputNum);
+    usage("run-onnx-lib");
+  }
   OMTensor **inputTensors = nullptr;
   if (inputNum > 0)
     inputTensors = (OMTensor **)malloc(inputNum * sizeof(OMTensor *));
@@ -372,6 +454,7 @@ OMTensorList *omTensorListCreateFromInputSignature(
       } else if (dataAlloc) {
         data = (float *)malloc(size * sizeof(float));
         assert(data && "failed to allocate data");
+        replayInputFile(i, data, size * sizeof(float), silent);
       }
       tensor = OM_TENSOR_CREATE(data, shape, rank, ONNX_TYPE_FLOAT, true);
     } else if (type.equals("double") || type.equals("f64") ||
@@ -383,6 +466,7 @@ OMTensorList *omTensorListCreateFromInputSignature(
       } else if (dataAlloc) {
         data = (double *)malloc(size * sizeof(double));
         assert(data && "failed to allocate data");
+        replayInputFile(i, data, size * sizeof(double), silent);
       }
       tensor = OM_TENSOR_CREATE(data, shape, rank, ONNX_TYPE_DOUBLE, true);
     }
@@ -400,35 +484,14 @@ OMTensorList *omTensorListCreateFromInputSignature(
   return OM_TENSOR_LIST_CREATE(inputTensors, inputNum, true);
 }
 
-// Data structures for timing info.
-#ifdef _WIN32
-#else
-struct timeval startTime, stopTime, result;
-#endif
-
-// Process start time.
-#ifdef _WIN32
-inline void processStartTime() {}
-#else
-inline void processStartTime() {
-  if (!measureExecTime)
-    return;
-  gettimeofday(&startTime, NULL);
-}
-#endif
-
-// Process stop time, store result in log.
+// Current time in microseconds, local to the calling thread.
 #ifdef _WIN32
-inline void processStopTime() {}
+inline uint64_t nowInMicroSec() { return 0; }
 #else
-inline void processStopTime() {
-  if (!measureExecTime)
-    return;
-  gettimeofday(&stopTime, NULL);
-  timersub(&stopTime, &startTime, &result);
-  uint64_t time =
-      (uint64_t)result.tv_sec * 1000000ull + (uint64_t)result.tv_usec;
-  timeLogInMicroSec.emplace_back(time);
+inline uint64_t nowInMicroSec() {
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return (uint64_t)t.tv_sec * 1000000ull + (uint64_t)t.tv_usec;
 }
 #endif
 
@@ -444,6 +507,22 @@ void printTime(double avg, double std, double factor, string unit) {
       (double)timeLogInMicroSec[s - 1] / factor, s);
 }
 
+// Return the given percentile from the sorted time log (nearest rank).
+double percentileInMicroSec(double p) {
+  int s = timeLogInMicroSec.size();
+  int idx = (int)ceil(p / 100.0 * s) - 1;
+  idx = std::max(0, std::min(idx, s - 1));
+  return (double)timeLogInMicroSec[idx];
+}
+
+// Print latency percentiles over all measured runs.
+void printPercentiles(double factor, string unit) {
+  printf("@percentile, %s, p50, %.1f, p95, %.1f, p99, %.1f, sample, %d\n",
+      unit.c_str(), percentileInMicroSec(50.0) / factor,
+      percentileInMicroSec(95.0) / factor, percentileInMicroSec(99.0) / factor,
+      (int)timeLogInMicroSec.size());
+}
+
 void displayTime() {
   int s = timeLogInMicroSec.size();
   if (s == 0)
@@ -459,32 +538,43 @@ void displayTime() {
            ((double)timeLogInMicroSec[i] - avg);
   std = sqrt(std / s);
   printTime(avg, std, 1, "micro-second");
+  printPercentiles(1, "micro-second");
   if (avg >= 1e3) {
     printTime(avg, std, 1e3, "milli-second");
+    printPercentiles(1e3, "milli-second");
   }
   if (avg >= 1e6) {
     printTime(avg, std, 1e6, "second");
+    printPercentiles(1e6, "second");
   }
 }
 
-// Perform generation of input, run, measure time,...
-int main(int argc, char **argv) {
-  // Init args.
-  parseArgs(argc, argv);
-  // Init inputs.
-  OMTensorList *tensorListIn =
-      omTensorListCreateFromInputSignature(nullptr, true, verbose, false);
+// Run the warmup and measured iterations of one session. Every session owns
+// its inputs so concurrent sessions never share tensor storage; the measured
+// times are merged into the global log when the session finishes.
+void runSession(int session) {
+  bool primary = (session == 0);
+  OMTensorList *tensorListIn = omTensorListCreateFromInputSignature(
+      nullptr, true, verbose && primary, !primary);
   assert(tensorListIn && "failed to scan signature");
-  // Call the compiled onnx model function.
-  cout << "Start computing " << sIterations << " iterations" << endl;
+  // Warmup runs are never measured.
+  for (int i = 0; i < sWarmupIterations; ++i) {
+    OMTensorList *tensorListOut = RUN_MAIN_GRAPH(tensorListIn);
+    if (tensorListOut)
+      OM_TENSOR_LIST_DESTROY(tensorListOut);
+  }
+  // Measured runs; keep the log local to stay off the other sessions' path.
+  vector<uint64_t> localTimeLog;
+  localTimeLog.reserve(sIterations);
   for (int i = 0; i < sIterations; ++i) {
     OMTensorList *tensorListOut = nullptr;
-    processStartTime();
+    uint64_t start = measureExecTime ? nowInMicroSec() : 0;
     tensorListOut = RUN_MAIN_GRAPH(tensorListIn);
-    processStopTime();
+    if (measureExecTime)
+      localTimeLog.emplace_back(nowInMicroSec() - start);
     if (tensorListOut)
       OM_TENSOR_LIST_DESTROY(tensorListOut);
-    if (i > 0 && i % 10 == 0)
+    if (primary && sThreads == 1 && i > 0 && i % 10 == 0)
       cout << "  computed " << i << " iterations" << endl;
     if (!reuseInput) {
       OM_TENSOR_LIST_DESTROY(tensorListIn);
@@ -492,10 +582,35 @@ int main(int argc, char **argv) {
           omTensorListCreateFromInputSignature(nullptr, true, false, true);
     }
   }
+  OM_TENSOR_LIST_DESTROY(tensorListIn);
+  if (!localTimeLog.empty()) {
+    lock_guard<mutex> lock(timeLogMutex);
+    timeLogInMicroSec.insert(
+        timeLogInMicroSec.end(), localTimeLog.begin(), localTimeLog.end());
+  }
+}
+
+// Perform generation of input, run, measure time,...
+int main(int argc, char **argv) {
+  // Init args.
+  parseArgs(argc, argv);
+  // Call the compiled onnx model function.
+  cout << "Start computing " << sIterations << " iterations";
+  if (sWarmupIterations > 0)
+    cout << " after " << sWarmupIterations << " warmup runs";
+  if (sThreads > 1)
+    cout << " in each of " << sThreads << " concurrent sessions";
+  cout << endl;
+  if (sThreads == 1) {
+    runSession(0);
+  } else {
+    vector<thread> sessions;
+    for (int t = 0; t < sThreads; ++t)
+      sessions.emplace_back(runSession, t);
+    for (auto &session : sessions)
+      session.join();
+  }
   cout << "Finish computing " << sIterations << " iterations" << endl;
   displayTime();
-
-  // Cleanup.
-  OM_TENSOR_LIST_DESTROY(tensorListIn);
   return 0;
 }
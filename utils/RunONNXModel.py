@@ -12,9 +12,11 @@
 ################################################################################
 
 import os
+import re
 import sys
 import argparse
 import onnx
+import random
 import time
 import signal
 import subprocess
@@ -78,6 +80,22 @@ parser.add_argument('--verify',
 parser.add_argument('--verify-all-ops',
                     action='store_true',
                     help="Verify all operation outputs when using onnxruntime.")
+parser.add_argument('--verify-sample',
+                    type=int,
+                    default=0,
+                    metavar='N',
+                    help="Verify a random sample of N nodes: the compiled"
+                    " model records the sampled nodes' inputs and outputs,"
+                    " and only those nodes are replayed through the onnx"
+                    " reference interpreter and compared. Catches most"
+                    " miscompilations at a fraction of the cost of"
+                    " --verify-all-ops on big models. Requires an .onnx"
+                    " input model")
+parser.add_argument('--verify-sample-seed',
+                    type=int,
+                    default=42,
+                    help="Seed for the node sample drawn by --verify-sample,"
+                    " so a failing sample can be reproduced (default: 42)")
 parser.add_argument('--rtol',
                     type=str,
                     default="0.05",
@@ -86,6 +104,42 @@ parser.add_argument('--atol',
                     type=str,
                     default="0.01",
                     help="Absolute tolerance for verification")
+parser.add_argument('--bench',
+                    action='store_true',
+                    help="Benchmark the model: warmup runs followed by timed"
+                    " runs, reporting latency statistics. When the model was"
+                    " compiled with instrumentation (e.g. --compile-args="
+                    "\"--instrument-ops=onnx.* --InstrumentBeforeOp"
+                    " --InstrumentAfterOp --InstrumentReportTime\"), a per-op"
+                    " time table is reported as well")
+parser.add_argument('--bench-warmup',
+                    type=int,
+                    default=3,
+                    help="Number of warmup runs before timing (default: 3)")
+parser.add_argument('--bench-runs',
+                    type=int,
+                    default=20,
+                    help="Number of timed runs (default: 20)")
+parser.add_argument('--bench-save',
+                    metavar='PATH',
+                    type=str,
+                    help="File path to save the benchmark results as JSON,"
+                    " for later comparison with --bench-diff")
+parser.add_argument('--bench-flame',
+                    metavar='PATH',
+                    type=str,
+                    help="File path to save per-op times as folded stacks"
+                    " ('model;op;node usec' per line) for flamegraph.pl")
+parser.add_argument('--bench-diff',
+                    metavar='REPORT',
+                    nargs=2,
+                    help="Compare two benchmark reports saved with"
+                    " --bench-save, op by op. No model is compiled or run")
+parser.add_argument('--bench-diff-threshold',
+                    type=float,
+                    default=5.0,
+                    help="Percentage change above which --bench-diff flags an"
+                    " op as a regression/improvement (default: 5.0)")
 
 lib_group = parser.add_mutually_exclusive_group()
 lib_group.add_argument('--save-so',
@@ -203,6 +257,110 @@ def extend_model_output(model, intermediate_outputs):
     return model
 
 
+def sample_verification_nodes(model, count, seed):
+    """Draw a reproducible sample of nodes that the reference interpreter can
+    replay in isolation: nodes without subgraph attributes whose inputs and
+    outputs are all named tensors with a known value info (or initializers).
+    Returns at most `count` nodes."""
+    inferred = onnx.shape_inference.infer_shapes(model)
+    known = {
+        vi.name
+        for vi in list(inferred.graph.value_info) +
+        list(inferred.graph.input) + list(inferred.graph.output)
+    }
+    initializers = {init.name for init in inferred.graph.initializer}
+    eligible = []
+    for node in inferred.graph.node:
+        # Nodes carrying subgraphs (If, Loop, Scan) cannot be replayed
+        # without also replaying their bodies; skip them.
+        if any(
+                attr.HasField('g') or len(attr.graphs) > 0
+                for attr in node.attribute):
+            continue
+        if not node.output or '' in node.input or '' in node.output:
+            continue
+        names = list(node.input) + list(node.output)
+        if any(n not in known and n not in initializers for n in names):
+            continue
+        eligible.append(node)
+    if count >= len(eligible):
+        return eligible
+    return random.Random(seed).sample(eligible, count)
+
+
+def recorded_tensor_names(model, nodes):
+    """The tensors the compiled model must record to replay `nodes`: their
+    inputs and outputs, except initializers, which are taken from the model
+    itself."""
+    initializers = {init.name for init in model.graph.initializer}
+    names = []
+    for node in nodes:
+        for name in list(node.input) + list(node.output):
+            if name and name not in initializers:
+                names.append(name)
+    return list(OrderedDict.fromkeys(names))
+
+
+def verify_sampled_nodes(model, nodes, tensors):
+    """Replay each node in `nodes` through the onnx reference interpreter on
+    the inputs recorded from the compiled run in `tensors` and compare the
+    recorded outputs against the interpreter's. Feeding each node its
+    recorded inputs keeps upstream rounding differences from accumulating, so
+    a mismatch points at the node itself."""
+    from onnx.reference import ReferenceEvaluator
+
+    inferred = onnx.shape_inference.infer_shapes(model)
+    value_infos = {
+        vi.name: vi
+        for vi in list(inferred.graph.value_info) +
+        list(inferred.graph.input) + list(inferred.graph.output)
+    }
+    initializers = {init.name: init for init in inferred.graph.initializer}
+
+    print("Verifying {} sampled nodes".format(len(nodes)),
+          "using atol={}, rtol={} ...".format(args.atol, args.rtol))
+    num_failed = 0
+    for node in nodes:
+        name = node.name if node.name else node.output[0]
+        # Wrap the node into a standalone model: constant inputs come along
+        # as initializers, everything else becomes a graph input.
+        node_inits = [
+            initializers[n] for n in node.input if n in initializers
+        ]
+        graph_inputs = [
+            value_infos[n] for n in node.input if n not in initializers
+        ]
+        graph_outputs = [value_infos[n] for n in node.output]
+        graph = onnx.helper.make_graph([node], 'sampled_node', graph_inputs,
+                                       graph_outputs, initializer=node_inits)
+        node_model = onnx.helper.make_model(
+            graph, opset_imports=model.opset_import)
+        feeds = {
+            n: tensors[n] for n in node.input if n not in initializers
+        }
+        ref_outs = ReferenceEvaluator(node_model).run(None, feeds)
+        for out_name, ref_out in zip(node.output, ref_outs):
+            actual = tensors[out_name]
+            diff = float(args.atol) + float(args.rtol) * np.abs(
+                ref_out.astype(np.float64, copy=False))
+            mismatched = np.count_nonzero(
+                np.abs(actual.astype(np.float64, copy=False) -
+                       ref_out.astype(np.float64, copy=False)) > diff)
+            if mismatched == 0:
+                print("  {} ({}) {}: correct.".format(
+                    name, node.op_type, out_name))
+            else:
+                num_failed += 1
+                print("  {} ({}) {}: mismatched elements {}/{}.".format(
+                    name, node.op_type, out_name, mismatched, actual.size))
+    if num_failed > 0:
+        raise AssertionError(
+            "{}/{} sampled node outputs mismatched; rerun with"
+            " --verify-sample-seed={} to reproduce the sample.".format(
+                num_failed, len(nodes), args.verify_sample_seed))
+    print("  all sampled nodes correct.\n")
+
+
 def get_names_in_signature(signature):
     names = []
     # Load the input signature.
@@ -307,12 +465,217 @@ def warning(msg):
     print("Warning:", msg)
 
 
+# Instrument report lines printed by the runtime, e.g.
+#   #  1) T0 after  onnx.Conv Time elapsed: 0.000123 accumulated: 0.000456 (conv1)
+INSTRUMENT_LINE_RE = re.compile(
+    r'^#\s*\d+\)\s+T\d+\s+(before|after)\s+(\S+)'
+    r'(?:\s+Time elapsed:\s+(\d+\.\d+)\s+accumulated:\s+\d+\.\d+)?'
+    r'(?:.*\((\S+)\))?\s*$')
+
+
+def redirect_stdout_fd(target_file):
+    """Redirect the C-level stdout (fd 1) to target_file, so instrument
+    report lines printed by the runtime during sess.run are captured instead
+    of interleaving with the script's output. Returns the saved fd to pass
+    to restore_stdout_fd."""
+    sys.stdout.flush()
+    saved_fd = os.dup(1)
+    os.dup2(target_file.fileno(), 1)
+    return saved_fd
+
+
+def restore_stdout_fd(saved_fd):
+    sys.stdout.flush()
+    os.dup2(saved_fd, 1)
+    os.close(saved_fd)
+
+
+def parse_instrument_output(text):
+    """Aggregate per-op times from captured instrument report lines.
+    Returns {(op, node): [count, total_seconds]}. The elapsed time on an
+    'after' line is the time since the previous instrument point on the same
+    thread, i.e. the op's own time when ops are instrumented before+after."""
+    per_op = {}
+    for line in text.splitlines():
+        match = INSTRUMENT_LINE_RE.match(line)
+        if not match or match.group(1) != 'after' or not match.group(3):
+            continue
+        key = (match.group(2), match.group(4) or 'NOTSET')
+        entry = per_op.setdefault(key, [0, 0.0])
+        entry[0] += 1
+        entry[1] += float(match.group(3))
+    return per_op
+
+
+def print_latency_stats(times):
+    sorted_times = sorted(times)
+
+    def percentile(p):
+        return sorted_times[min(len(sorted_times) - 1,
+                                int(len(sorted_times) * p))]
+
+    mean = sum(times) / len(times)
+    print("Latency over {} runs (seconds):".format(len(times)))
+    print("  min {:.6f}  mean {:.6f}  median {:.6f}"
+          "  p90 {:.6f}  max {:.6f}\n".format(sorted_times[0], mean,
+                                              percentile(0.5),
+                                              percentile(0.9),
+                                              sorted_times[-1]))
+    return mean
+
+
+def print_per_op_table(per_op, num_runs):
+    print("Per-op times averaged over {} runs (seconds):".format(num_runs))
+    print("  {:<32} {:>10} {:>12} {:>12}".format("op (node)", "count",
+                                                 "total", "average"))
+    for (op, node), (count, total) in sorted(per_op.items(),
+                                             key=lambda item: item[1][1],
+                                             reverse=True):
+        name = op if node == 'NOTSET' else "{} ({})".format(op, node)
+        print("  {:<32} {:>10.1f} {:>12.6f} {:>12.6f}".format(
+            name, count / num_runs, total / num_runs, total / count))
+    print("")
+
+
+def write_flamegraph(per_op, path):
+    # Folded stack format consumed by flamegraph.pl; counts are microseconds.
+    with open(path, 'w') as f:
+        for (op, node), (count, total) in per_op.items():
+            stack = "model;" + op
+            if node != 'NOTSET':
+                stack += ";" + node
+            f.write("{} {}\n".format(stack, int(total * 1e6)))
+    print("Folded stacks saved to {},".format(path),
+          "render with flamegraph.pl\n")
+
+
+def save_bench_report(path, times, per_op):
+    report = {
+        'model': args.model,
+        'compile_args': args.compile_args,
+        'warmup': args.bench_warmup,
+        'runs': args.bench_runs,
+        'times_seconds': times,
+        'per_op': [{
+            'op': op,
+            'node': node,
+            'count': count,
+            'total_seconds': total
+        } for (op, node), (count, total) in per_op.items()],
+    }
+    with open(path, 'w') as f:
+        json.dump(report, f, indent=2)
+    print("Benchmark report saved to {}\n".format(path))
+
+
+def bench_diff(path_a, path_b, threshold):
+    """Compare two benchmark reports saved with --bench-save op by op."""
+    with open(path_a) as f:
+        report_a = json.load(f)
+    with open(path_b) as f:
+        report_b = json.load(f)
+
+    mean_a = sum(report_a['times_seconds']) / len(report_a['times_seconds'])
+    mean_b = sum(report_b['times_seconds']) / len(report_b['times_seconds'])
+    print("Mean latency: {:.6f}s (A: {})".format(mean_a, path_a))
+    print("              {:.6f}s (B: {})".format(mean_b, path_b))
+    if mean_a > 0:
+        print("              {:+.1f}%\n".format(
+            (mean_b - mean_a) / mean_a * 100))
+
+    def per_op_totals(report):
+        return {(entry['op'], entry['node']): entry['total_seconds']
+                for entry in report['per_op']}
+
+    totals_a = per_op_totals(report_a)
+    totals_b = per_op_totals(report_b)
+    if not totals_a and not totals_b:
+        print("No per-op times in the reports; compile the models with"
+              " instrumentation to diff op by op.")
+        return
+
+    print("Per-op total times (seconds), sorted by absolute change:")
+    print("  {:<32} {:>12} {:>12} {:>12} {:>8}".format(
+        "op (node)", "A", "B", "delta", "%"))
+    rows = []
+    for key in set(totals_a) | set(totals_b):
+        a = totals_a.get(key, 0.0)
+        b = totals_b.get(key, 0.0)
+        rows.append((abs(b - a), key, a, b))
+    num_flagged = 0
+    for _, (op, node), a, b in sorted(rows, reverse=True):
+        name = op if node == 'NOTSET' else "{} ({})".format(op, node)
+        pct = (b - a) / a * 100 if a > 0 else float('inf')
+        flag = ""
+        if abs(pct) >= threshold:
+            flag = " <<< regression" if b > a else " <<< improvement"
+            num_flagged += 1
+        print("  {:<32} {:>12.6f} {:>12.6f} {:>+12.6f} {:>+8.1f}{}".format(
+            name, a, b, b - a, pct, flag))
+    print("\n{} op(s) changed by {}% or more.".format(num_flagged, threshold))
+
+
+def run_benchmark(sess, inputs):
+    print("Benchmarking: {} warmup runs, then {} timed runs ...".format(
+        args.bench_warmup, args.bench_runs))
+
+    # Warmup. Instrument output, if any, is discarded.
+    with open(os.devnull, 'w') as devnull:
+        saved_fd = redirect_stdout_fd(devnull)
+        try:
+            for _ in range(args.bench_warmup):
+                sess.run(inputs)
+        finally:
+            restore_stdout_fd(saved_fd)
+
+    # Timed runs. Capture the instrument report so per-op times can be
+    # aggregated; an uninstrumented model prints nothing and only the
+    # end-to-end latency is reported.
+    times = []
+    with tempfile.TemporaryFile(mode='w+') as capture:
+        saved_fd = redirect_stdout_fd(capture)
+        try:
+            for _ in range(args.bench_runs):
+                start = time.perf_counter()
+                sess.run(inputs)
+                end = time.perf_counter()
+                times.append(end - start)
+        finally:
+            restore_stdout_fd(saved_fd)
+        capture.seek(0)
+        per_op = parse_instrument_output(capture.read())
+
+    print_latency_stats(times)
+    if per_op:
+        print_per_op_table(per_op, args.bench_runs)
+    if args.bench_flame:
+        if per_op:
+            write_flamegraph(per_op, args.bench_flame)
+        else:
+            warning("--bench-flame needs an instrumented model; no per-op"
+                    " times were collected")
+    if args.bench_save:
+        save_bench_report(args.bench_save, times, per_op)
+
+
 def main():
+    # Diff two saved benchmark reports; nothing is compiled or run.
+    if args.bench_diff:
+        bench_diff(args.bench_diff[0], args.bench_diff[1],
+                   args.bench_diff_threshold)
+        return
+
     if not(args.model or args.load_so):
         print("error: no input model, use argument --model and/or --load-so.")
         print(parser.format_usage())
         exit(1)
 
+    if args.verify_sample > 0 and (args.load_so or not args.model
+                                   or not args.model.endswith('.onnx')):
+        print("error: --verify-sample needs to recompile an .onnx model so"
+              " the sampled tensors can be recorded.")
+        exit(1)
+
     # Get shape information if given.
     # args.shape_info in the form of 'input_index:d1xd2, input_index:d1xd2'
     input_shapes = {}
@@ -325,6 +688,7 @@ def main():
             input_shapes[int(input_index)] = dims
 
     # Load the onnx model.
+    sampled_nodes = []
     if args.model and args.model.endswith('.onnx'):
         model = onnx.load(args.model)
         # Get names of all intermediate tensors and modify model such that each of
@@ -344,6 +708,20 @@ def main():
             if (args.save_onnx):
                 print("Saving modified onnx model to ", args.save_onnx, "\n")
                 onnx.save(model, args.save_onnx)
+        elif (args.verify_sample > 0):
+            # Record only the inputs and outputs of a sample of nodes; the
+            # sampled nodes are later replayed through the reference
+            # interpreter and compared.
+            print("Sampling {} nodes for verification ...\n".format(
+                args.verify_sample))
+            sampled_nodes = sample_verification_nodes(model,
+                                                      args.verify_sample,
+                                                      args.verify_sample_seed)
+            if sampled_nodes:
+                output_names = recorded_tensor_names(model, sampled_nodes)
+                model = extend_model_output(model, output_names)
+            else:
+                warning("no nodes are eligible for sampled verification")
 
     # Compile, run, and verify.
     with tempfile.TemporaryDirectory() as temp_dir:
@@ -434,6 +812,11 @@ def main():
                     ordinal(i + 1), input_names[i],
                     'x'.join([str(i) for i in inp.shape]), inp.dtype, inp))
 
+        # Benchmark instead of the single verification run if requested.
+        if args.bench:
+            run_benchmark(sess, inputs)
+            return
+
         # Running inference.
         print("Running inference ...")
         start = time.perf_counter()
@@ -466,6 +849,13 @@ def main():
                 with open(tensor_path, 'wb') as f:
                     f.write(tensor.SerializeToString())
 
+        # Replay the sampled nodes through the reference interpreter and
+        # compare against the recorded tensors.
+        if sampled_nodes:
+            verify_sampled_nodes(model, sampled_nodes,
+                                 dict(zip(output_names, outs)))
+            return
+
         # Verify the output if required.
         if (args.verify):
             ref_outs = []
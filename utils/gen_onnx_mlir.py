@@ -320,11 +320,14 @@ OpsWithCanonicalizer = [
     'Less',
     'Loop',
     'LSTM',
+    'MatMul',
     'Mul',
+    'Pad',
     'Reshape',
     'RNN',
     'Shape',
     'Size',
+    'Slice',
     'SoftmaxV11',
     'SpaceToDepth',
     'Squeeze',